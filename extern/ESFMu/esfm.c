@@ -1740,7 +1740,7 @@ ESFM_slot_generate_emu(esfm_slot *slot)
 
 /* ------------------------------------------------------------------------- */
 static void
-ESFM_process_feedback(esfm_chip *chip)
+ESFM_process_feedback(esfm_chip *chip, const bool *idle)
 {
 	int channel_idx;
 
@@ -1758,6 +1758,11 @@ ESFM_process_feedback(esfm_chip *chip)
 		uint32_t phase, phase_acc;
 		uint10 eg_output;
 
+		if (idle[channel_idx])
+		{
+			continue;
+		}
+
 		if (slot->mod_in_level && (chip->native_mode || (slot->in.mod_input == &slot->in.feedback_buf)))
 		{
 			if (chip->native_mode)
@@ -2023,6 +2028,56 @@ ESFM_process_channel(esfm_channel *channel)
 	// TODO: verify this behavior on real hardware
 }
 
+/*
+ * A slot is idle once it has fully released with its key off: its envelope
+ * state no longer changes and it can only output silence. Only its phase
+ * (and the shared noise generator) still needs to advance.
+ */
+/* ------------------------------------------------------------------------- */
+static bool
+ESFM_slot_is_idle(esfm_slot *slot)
+{
+	return slot->in.eg_state == EG_RELEASE
+		&& slot->in.eg_position == 0x1ff
+		&& !*slot->in.key_on
+		&& !slot->in.key_on_gate
+		&& !slot->in.eg_delay_run
+		&& !slot->in.phase_reset
+		&& !(slot->in.eg_delay_transitioned_10 && !slot->in.eg_delay_transitioned_10_gate)
+		&& !(slot->in.eg_delay_transitioned_01 && !slot->in.eg_delay_transitioned_01_gate)
+		&& slot->in.output == 0
+		&& slot->in.feedback_buf == 0
+		&& slot->in.fb_out0 == 0
+		&& slot->in.fb_out1 == 0;
+}
+
+/* ------------------------------------------------------------------------- */
+static bool
+ESFM_channel_is_idle(esfm_channel *channel)
+{
+	int slot_idx;
+	for (slot_idx = 0; slot_idx < 4; slot_idx++)
+	{
+		if (!ESFM_slot_is_idle(&channel->slots[slot_idx]))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/* ------------------------------------------------------------------------- */
+static void
+ESFM_process_channel_idle(esfm_channel *channel)
+{
+	int slot_idx;
+	channel->output[0] = channel->output[1] = 0;
+	for (slot_idx = 0; slot_idx < 4; slot_idx++)
+	{
+		ESFM_phase_generate(&channel->slots[slot_idx]);
+	}
+}
+
 /* ------------------------------------------------------------------------- */
 static void
 ESFM_process_channel_emu(esfm_channel *channel)
@@ -2211,12 +2266,19 @@ void
 ESFM_generate(esfm_chip *chip, int16_t *buf)
 {
 	int channel_idx;
+	bool idle[18];
 
 	chip->output_accm[0] = chip->output_accm[1] = 0;
 	for (channel_idx = 0; channel_idx < 18; channel_idx++)
 	{
 		esfm_channel *channel = &chip->channels[channel_idx];
-		if (chip->native_mode)
+		// idle channels are only skipped in native mode, where key on is per channel
+		idle[channel_idx] = chip->native_mode && ESFM_channel_is_idle(channel);
+		if (idle[channel_idx])
+		{
+			ESFM_process_channel_idle(channel);
+		}
+		else if (chip->native_mode)
 		{
 			ESFM_process_channel(channel);
 		}
@@ -2225,10 +2287,14 @@ ESFM_generate(esfm_chip *chip, int16_t *buf)
 			ESFM_process_channel_emu(channel);
 		}
 	}
-	ESFM_process_feedback(chip);
+	ESFM_process_feedback(chip, idle);
 	for (channel_idx = 0; channel_idx < 18; channel_idx++)
 	{
 		esfm_channel *channel = &chip->channels[channel_idx];
+		if (idle[channel_idx])
+		{
+			continue;
+		}
 		if (chip->native_mode)
 		{
 			ESFM_slot_generate(&channel->slots[0]);
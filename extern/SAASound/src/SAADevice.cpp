@@ -15,6 +15,7 @@
 #include "SAASound.h"
 #include "SAAImpl.h"
 #include "defns.h"
+#include <limits.h>
 
 
 //////////////////////////////////////////////////////////////////////
@@ -344,6 +345,36 @@ void CSAADevice::_TickAndOutputStereo(unsigned int& left_mixed, unsigned int& ri
 	right_mixed = accum_right;
 }
 
+// (tildearrow) the output only changes when one of the frequency or noise
+// generators changes level (envelopes are clocked by frequency generators
+// 1 and 4, or by writes). this returns the number of whole samples from now
+// on in which that doesn't happen. all of them produce the same output.
+unsigned int CSAADevice::_SamplesUntilChange(unsigned int nMax) const
+{
+	unsigned int nTicks = UINT_MAX;
+	for (int i = 0; i < 6; i++)
+	{
+		unsigned int t = Osc[i]->TicksUntilEdge();
+		if (t < nTicks) nTicks = t;
+	}
+	for (int i = 0; i < 2; i++)
+	{
+		unsigned int t = Noise[i]->TicksUntilEdge();
+		if (t < nTicks) nTicks = t;
+	}
+	unsigned int nSamples = (nTicks - 1) >> m_nOversample;
+	return (nSamples < nMax) ? nSamples : nMax;
+}
+
+void CSAADevice::_SkipSamples(unsigned int nSamples)
+{
+	unsigned int nTicks = nSamples << m_nOversample;
+	for (int i = 0; i < 6; i++)
+		Osc[i]->Skip(nTicks);
+	for (int i = 0; i < 2; i++)
+		Noise[i]->Skip(nTicks);
+}
+
 void CSAADevice::_TickAndOutputSeparate(unsigned int& left_mixed, unsigned int& right_mixed,
 	unsigned int& left0, unsigned int& right0,
 	unsigned int& left1, unsigned int& right1,
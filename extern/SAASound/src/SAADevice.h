@@ -54,6 +54,8 @@ public:
 	void _SetSampleRate(unsigned int nSampleRate);
 	void _SetOversample(unsigned int nOversample);
 	void _TickAndOutputStereo(unsigned int& left_mixed, unsigned int& right_mixed, DivDispatchOscBuffer** oscBuf, unsigned int where);
+	unsigned int _SamplesUntilChange(unsigned int nMax) const;
+	void _SkipSamples(unsigned int nSamples);
 	void _TickAndOutputSeparate(unsigned int& left_mixed, unsigned int& right_mixed,
 		unsigned int& left0, unsigned int& right0,
 		unsigned int& left1, unsigned int& right1,
@@ -11,6 +11,7 @@
 #include "SAAEnv.h"
 #include "SAAFreq.h"
 #include "defns.h"
+#include <limits.h>
 
 const int INITIAL_LEVEL = 1;
 
@@ -238,6 +239,32 @@ int CSAAFreq::Tick(void)
 	return m_nLevel;
 }
 
+unsigned int CSAAFreq::TicksUntilEdge(void) const
+{
+	// (tildearrow) number of calls to Tick() until (and including) the one
+	// which changes the level
+	if (m_bSync || m_nAdd == 0)
+		return UINT_MAX;
+
+	uint64_t nNeed = uint64_t(m_nCounterLimit_low - m_nCounter_low) * (m_nSampleRate<<12) - m_nCounter;
+	uint64_t nTicks = (nNeed + m_nAdd - 1) / m_nAdd;
+	if (nTicks > UINT_MAX)
+		return UINT_MAX;
+	return (unsigned int)nTicks;
+}
+
+void CSAAFreq::Skip(unsigned int nTicks)
+{
+	// (tildearrow) same as calling Tick() nTicks times, as long as it is less
+	// than TicksUntilEdge()
+	if (m_bSync)
+		return;
+
+	m_nCounter += m_nAdd * nTicks;
+	m_nCounter_low += (unsigned int)(m_nCounter / (m_nSampleRate<<12));
+	m_nCounter %= (m_nSampleRate<<12);
+}
+
 void CSAAFreq::SetAdd(void)
 {
 	// nOctave between 0 and 7; nOffset between 0 and 255
@@ -58,6 +58,9 @@ public:
 	void Sync(bool bSync);
 	int Tick(void);
 	int Level(void) const;
+	// (tildearrow) for event-driven rendering
+	unsigned int TicksUntilEdge(void) const;
+	void Skip(unsigned int nTicks);
 
 };
 
@@ -398,6 +398,28 @@ void CSAASoundInternal::GenerateMany(BYTE* pBuffer, unsigned int nSamples, DivDi
 #endif
 }
 
+void CSAASoundInternal::GenerateOne(short& left, short& right, DivDispatchOscBuffer** oscBuf, unsigned int where)
+{
+	unsigned int left_mixed, right_mixed;
+	m_chip._TickAndOutputStereo(left_mixed, right_mixed, oscBuf, where);
+
+	// same as scale_for_output() without the high-pass filter
+	double float_left = (double)left_mixed * DEFAULT_UNBOOSTED_MULTIPLIER * DEFAULT_BOOST / double(1 << m_nOversample);
+	double float_right = (double)right_mixed * DEFAULT_UNBOOSTED_MULTIPLIER * DEFAULT_BOOST / double(1 << m_nOversample);
+	left = (short)(float_left > 32767 ? 32767 : float_left < -32768 ? -32768 : float_left);
+	right = (short)(float_right > 32767 ? 32767 : float_right < -32768 ? -32768 : float_right);
+}
+
+unsigned int CSAASoundInternal::SamplesUntilChange(unsigned int nMax)
+{
+	return m_chip._SamplesUntilChange(nMax);
+}
+
+void CSAASoundInternal::SkipSamples(unsigned int nSamples)
+{
+	m_chip._SkipSamples(nSamples);
+}
+
 ///////////////////////////////////////////////////////
 
 LPCSAASOUND SAAAPI CreateCSAASound(void)
@@ -70,6 +70,9 @@ public:
 	static unsigned short GetBytesPerSample(SAAPARAM uParam);
 
 	void GenerateMany(BYTE * pBuffer, unsigned int nSamples, DivDispatchOscBuffer** oscBuf);
+	void GenerateOne(short& left, short& right, DivDispatchOscBuffer** oscBuf, unsigned int where);
+	unsigned int SamplesUntilChange(unsigned int nMax);
+	void SkipSamples(unsigned int nSamples);
 
 };
 
@@ -15,6 +15,7 @@
 #include "types.h"
 #include "SAANoise.h"
 #include "defns.h"
+#include <limits.h>
 
 
 //////////////////////////////////////////////////////////////////////
@@ -123,6 +124,32 @@ void CSAANoise::Tick(void)
 	}
 }
 
+unsigned int CSAANoise::TicksUntilEdge(void) const
+{
+	// (tildearrow) in mode 3 the level only changes when triggered by
+	// frequency generator 0 or 3
+	if (m_bSync || m_nSourceMode == 3 || m_nAdd == 0)
+		return UINT_MAX;
+
+	uint64_t nNeed = uint64_t(m_nCounterLimit_low - m_nCounter_low) * (m_nSampleRate<<12) - m_nCounter;
+	uint64_t nTicks = (nNeed + m_nAdd - 1) / m_nAdd;
+	if (nTicks > UINT_MAX)
+		return UINT_MAX;
+	return (unsigned int)nTicks;
+}
+
+void CSAANoise::Skip(unsigned int nTicks)
+{
+	// (tildearrow) same as calling Tick() nTicks times, as long as it is less
+	// than TicksUntilEdge()
+	if (m_bSync || m_nSourceMode == 3)
+		return;
+
+	uint64_t nCounter = m_nCounter + m_nAdd * nTicks;
+	m_nCounter_low += (unsigned int)(nCounter / (m_nSampleRate<<12));
+	m_nCounter = (unsigned int)(nCounter % (m_nSampleRate<<12));
+}
+
 void CSAANoise::Sync(bool bSync)
 {
 	if (bSync)
@@ -40,6 +40,9 @@ public:
 
 	void Tick(void);
 	int Level(void) const;
+	// (tildearrow) for event-driven rendering
+	unsigned int TicksUntilEdge(void) const;
+	void Skip(unsigned int nTicks);
 	void Sync(bool bSync);
 
 };
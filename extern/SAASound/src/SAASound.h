@@ -82,6 +82,10 @@ public:
 	static unsigned short GetBytesPerSample (SAAPARAM uParam);
 
 	virtual void GenerateMany (BYTE * pBuffer, unsigned int nSamples, DivDispatchOscBuffer** oscBuf) = 0;
+	// (tildearrow) for event-driven rendering (no high-pass filter)
+	virtual void GenerateOne (short& left, short& right, DivDispatchOscBuffer** oscBuf, unsigned int where) = 0;
+	virtual unsigned int SamplesUntilChange (unsigned int nMax) = 0;
+	virtual void SkipSamples (unsigned int nSamples) = 0;
 
 	virtual void SetClockRate(unsigned int nClockRate) = 0;
 	virtual void SetSampleRate(unsigned int nSampleRate) = 0;
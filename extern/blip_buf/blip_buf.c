@@ -68,6 +68,8 @@ struct blip_t
 	int size;
 	int integrator;
         unsigned char hipass;
+	/* (tildearrow) number of deltas added since the last blip_take_deltas() */
+	unsigned int deltas;
 };
 
 typedef int buf_t;
@@ -121,6 +123,7 @@ blip_t* blip_new( int size )
 		m->factor = time_unit / blip_max_ratio;
 		m->size   = size;
                 m->hipass = 1;
+		m->deltas = 0;
 		blip_clear( m );
 		check_assumptions();
 	}
@@ -137,6 +140,34 @@ void blip_delete( blip_t* m )
 	}
 }
 
+blip_t* blip_clone( const blip_t* src )
+{
+	blip_t* m = blip_new( src->size );
+	if ( m )
+		blip_copy( m, src );
+	return m;
+}
+
+int blip_copy( blip_t* dest, const blip_t* src )
+{
+	int used, destUsed;
+	unsigned int deltas;
+	if ( dest->size != src->size )
+		return -1;
+	
+	/* only the samples which haven't been read and the ones past them can be
+	non-zero, so there's no need to copy the whole buffer */
+	used     = src->avail + buf_extra;
+	destUsed = dest->avail + buf_extra;
+	/* (tildearrow) the delta count belongs to the buffer */
+	deltas   = dest->deltas;
+	memcpy( dest, src, sizeof *dest + used * sizeof (buf_t) );
+	dest->deltas = deltas;
+	if ( destUsed > used )
+		memset( SAMPLES( dest ) + used, 0, (destUsed - used) * sizeof (buf_t) );
+	return 0;
+}
+
 void blip_set_dc( blip_t* m, unsigned char enable ) {
   m->hipass=enable;
 }
@@ -316,6 +347,8 @@ void blip_add_delta_slow( blip_t* m, unsigned time, int delta )
 	/* Fails if buffer size was exceeded */
 	assert( out <= &SAMPLES( m ) [m->size + end_frame_extra] );
 	
+	m->deltas++;
+	
 	out [0] += in[0]*delta + in[half_width+0]*delta2;
 	out [1] += in[1]*delta + in[half_width+1]*delta2;
 	out [2] += in[2]*delta + in[half_width+2]*delta2;
@@ -347,9 +380,98 @@ void blip_add_delta_fast( blip_t* m, unsigned time, int delta )
 	/* Fails if buffer size was exceeded */
 	assert( out <= &SAMPLES( m ) [m->size + end_frame_extra] );
 	
+	m->deltas++;
+	
 	out [7] += delta * delta_unit - delta2;
 	out [8] += delta2;
 }
 
 /* (tildearrow) ability to change blip_add_delta at runtime */
-void (*blip_add_delta)( blip_t*, unsigned int, int )=blip_add_delta_slow;
\ No newline at end of file
+void (*blip_add_delta)( blip_t*, unsigned int, int )=blip_add_delta_slow;
+
+/* (tildearrow) batch version of blip_add_delta. the kernel is applied inline
+and runs of unchanged samples are skipped four at a time. */
+void blip_add_deltas( blip_t* m, short const in [], unsigned count, int* last, int* prev )
+{
+	int cur = *last;
+	int p = *prev;
+	int const fast = (blip_add_delta == blip_add_delta_fast);
+	fixed_t const factor = m->factor;
+	fixed_t const offset = m->offset;
+	buf_t* const base = SAMPLES( m ) + m->avail;
+	unsigned i = 0;
+	
+	while ( i < count )
+	{
+		/* skip unchanged samples */
+		if ( cur >= SHRT_MIN && cur <= SHRT_MAX )
+		{
+			unsigned long long pattern = (unsigned short) cur;
+			pattern |= pattern << 16;
+			pattern |= pattern << 32;
+			while ( i + 4 <= count )
+			{
+				unsigned long long word;
+				memcpy( &word, &in [i], sizeof word );
+				if ( word != pattern )
+					break;
+				i += 4;
+			}
+		}
+		for ( ; i < count; i++ )
+		{
+			if ( in [i] != cur )
+				break;
+		}
+		if ( i >= count )
+			break;
+		
+		cur = in [i];
+		{
+			int delta = cur - p;
+			unsigned fixed = (unsigned) ((i * factor + offset) >> pre_shift);
+			buf_t* out = base + (fixed >> frac_bits);
+			
+			/* Fails if buffer size was exceeded */
+			assert( out <= &SAMPLES( m ) [m->size + end_frame_extra] );
+			
+			if ( fast )
+			{
+				int interp = fixed >> (frac_bits - delta_bits) & (delta_unit - 1);
+				int delta2 = delta * interp;
+				out [7] += delta * delta_unit - delta2;
+				out [8] += delta2;
+			}
+			else
+			{
+				int const phase_shift = frac_bits - phase_bits;
+				int phase = fixed >> phase_shift & (phase_count - 1);
+				short const* fwd = bl_step [phase];
+				short const* rev = bl_step [phase_count - phase];
+				int interp = fixed >> (phase_shift - delta_bits) & (delta_unit - 1);
+				int delta2 = (delta * interp) >> delta_bits;
+				int k;
+				delta -= delta2;
+				
+				for ( k = 0; k < half_width; k++ )
+					out [k] += fwd [k]*delta + fwd [half_width+k]*delta2;
+				for ( k = 0; k < half_width; k++ )
+					out [half_width+k] += rev [half_width-1-k]*delta + rev [-1-k]*delta2;
+			}
+		}
+		p = cur;
+		i++;
+		m->deltas++;
+	}
+	
+	*last = cur;
+	*prev = p;
+}
+
+/* (tildearrow) */
+unsigned int blip_take_deltas( blip_t* m )
+{
+	unsigned int ret = m->deltas;
+	m->deltas = 0;
+	return ret;
+}
\ No newline at end of file
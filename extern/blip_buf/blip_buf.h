@@ -44,6 +44,16 @@ void blip_add_delta_slow( blip_t*, unsigned int clock_time, int delta );
 /** Same as blip_add_delta(), but uses faster, lower-quality synthesis. */
 void blip_add_delta_fast( blip_t*, unsigned int clock_time, int delta );
 
+/** (tildearrow) Adds a delta for every sample in 'in' (starting at clock time 0)
+which differs from the one before it. '*last' is the sample before in[0] and
+'*prev' is the level which the next delta is relative to. Both are updated
+afterwards. Uses the synthesis selected by blip_add_delta. */
+void blip_add_deltas( blip_t*, short const in [], unsigned int count, int* last, int* prev );
+
+/** (tildearrow) Returns the number of deltas added since the last call, and
+resets it. Used by the profiler. */
+unsigned int blip_take_deltas( blip_t* );
+
 /** Length of time frame, in clocks, needed to make sample_count additional
 samples available. */
 int blip_clocks_needed( const blip_t*, int sample_count );
@@ -70,6 +80,15 @@ int blip_read_samples( blip_t*, short out [], int count, int stereo );
 /** Frees buffer. No effect if NULL is passed. */
 void blip_delete( blip_t* );
 
+/** (tildearrow) Creates a new buffer with the same size and contents as 'src'.
+Returns NULL if out of memory. */
+blip_t* blip_clone( const blip_t* src );
+
+/** (tildearrow) Copies the contents (including rates and buffered samples) of
+'src' into 'dest', which must have been created with the same size. Returns 0 on
+success, or -1 if the sizes differ. */
+int blip_copy( blip_t* dest, const blip_t* src );
+
 
 /* Deprecated */
 typedef blip_t blip_buffer_t;
@@ -12,11 +12,17 @@
 #include <algorithm>
 #include <math.h>
 #include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <SDL.h>
 
+struct SWPaintPool;
+
 struct ImGui_ImplSW_Data
 {
     SDL_Window*  Window;
+    SWPaintPool* Pool;
 
     ImGui_ImplSW_Data() { memset((void*)this, 0, sizeof(*this)); }
 };
@@ -31,6 +37,10 @@ struct PaintTarget
   uint32_t *pixels;
   int width;
   int height;
+  // rows which may be painted (the frame is split into horizontal bands,
+  // each painted by its own thread)
+  int min_y;
+  int max_y;
 };
 
 // ----------------------------------------------------------------------------
@@ -221,6 +231,11 @@ static void paint_uniform_rectangle(const PaintTarget &target,
   max_x_i = std::min(max_x_i, target.width);
   max_y_i = std::min(max_y_i, target.height);
 
+  // Clamp to band:
+  min_y_i = std::max(min_y_i, target.min_y);
+  max_y_i = std::min(max_y_i, target.max_y);
+  if (min_x_i >= max_x_i || min_y_i >= max_y_i) return;
+
   if (color.a==255) {
     // fast path if alpha blending is not necessary
     for (int y = min_y_i; y < max_y_i; ++y) {
@@ -317,6 +332,12 @@ static void paint_uniform_textured_rectangle(const PaintTarget &target,
   const ColorInt colorRef = ColorInt::bgra(min_v.col);
 
   for (int y = min_y_i; y < max_y_i; ++y) {
+    // rows outside the band still advance the texture position
+    if (y >= target.max_y) break;
+    if (y < target.min_y) {
+      if (deltaY != 0 && currentY < (texture.height - 1)*texture.width) { currentY += texture.width; }
+      continue;
+    }
     currentX = startX;
     uint32_t* target_pixel = &target.pixels[y * target.width - 1 + min_x_i];
     for (int x = min_x_i; x < max_x_i; ++x) {
@@ -456,6 +477,12 @@ static void paint_triangle(const PaintTarget &target,
   uint32_t last_output = blend(*lastColorRef, colorRef);
 
   for (int y = min_y_i; y < max_y_i; ++y) {
+    // rows outside the band still advance the interpolation
+    if (y >= target.max_y) break;
+    if (y < target.min_y) {
+      bary_current_row += bary_dy;
+      continue;
+    }
     auto bary = bary_current_row;
 
     bool has_been_inside_this_row = false;
@@ -624,24 +651,133 @@ static void paint_draw_list(const PaintTarget &target, const ImDrawList *cmd_lis
     const ImDrawCmd &pcmd = cmd_list->CmdBuffer[cmd_i];
     if (pcmd.UserCallback) {
       pcmd.UserCallback(cmd_list, &pcmd);
-    } else {
+    } else if (pcmd.ClipRect.w > target.min_y && pcmd.ClipRect.y < target.max_y) {
       paint_draw_cmd(target, vertices, idx_buffer, pcmd, white_uv);
     }
     idx_buffer += pcmd.ElemCount;
   }
   }
 
-static void paint_imgui(uint32_t *pixels, ImDrawData *drawData, int fb_width, int fb_height)
+static void paint_band(uint32_t *pixels, ImDrawData *drawData, int fb_width, int fb_height, int band, int bands)
 {
-  if (fb_width <= 0 || fb_height <= 0) return;
-
-  PaintTarget target{ pixels, fb_width, fb_height };
+  PaintTarget target{ pixels, fb_width, fb_height, (int)((int64_t)fb_height*band/bands), (int)((int64_t)fb_height*(band+1)/bands) };
 
   for (int i = 0; i < drawData->CmdListsCount; ++i) {
     paint_draw_list(target, drawData->CmdLists[i]);
   }
 }
 
+// ----------------------------------------------------------------------------
+// Threads which paint the bands other than the first one.
+
+// minimum height of a band
+#define SW_MIN_BAND_HEIGHT 32
+// maximum number of bands
+#define SW_MAX_BANDS 8
+
+struct SWPaintPool
+{
+  std::vector<std::thread> threads;
+  std::mutex lock;
+  std::condition_variable start, done;
+  unsigned int generation;
+  int pending;
+  bool quit;
+
+  // current frame
+  uint32_t *pixels;
+  ImDrawData *drawData;
+  int width, height, bands;
+
+  SWPaintPool():
+    generation(0),
+    pending(0),
+    quit(false),
+    pixels(NULL),
+    drawData(NULL),
+    width(0),
+    height(0),
+    bands(1) {}
+};
+
+static void paint_worker(SWPaintPool *pool, int band)
+{
+  unsigned int seen = 0;
+  std::unique_lock<std::mutex> l(pool->lock);
+  while (true) {
+    pool->start.wait(l, [&]() { return pool->quit || pool->generation != seen; });
+    if (pool->quit) return;
+    seen = pool->generation;
+    if (band >= pool->bands) continue;
+
+    l.unlock();
+    paint_band(pool->pixels, pool->drawData, pool->width, pool->height, band, pool->bands);
+    l.lock();
+
+    if (--pool->pending == 0) pool->done.notify_one();
+  }
+}
+
+static SWPaintPool* paint_pool_create()
+{
+  int threads = std::min((int)std::thread::hardware_concurrency(), SW_MAX_BANDS);
+  SWPaintPool *pool = new SWPaintPool;
+  for (int i = 1; i < threads; i++) {
+    pool->threads.push_back(std::thread(paint_worker, pool, i));
+  }
+  return pool;
+}
+
+static void paint_pool_destroy(SWPaintPool *pool)
+{
+  {
+    std::unique_lock<std::mutex> l(pool->lock);
+    pool->quit = true;
+    pool->start.notify_all();
+  }
+  for (std::thread& i: pool->threads) {
+    i.join();
+  }
+  delete pool;
+}
+
+static void paint_imgui(SWPaintPool *pool, uint32_t *pixels, ImDrawData *drawData, int fb_width, int fb_height)
+{
+  if (fb_width <= 0 || fb_height <= 0) return;
+
+  int bands = 1;
+  if (pool != NULL) {
+    bands = std::min((int)pool->threads.size() + 1, fb_height / SW_MIN_BAND_HEIGHT);
+    // user callbacks must be called once
+    for (int i = 0; i < drawData->CmdListsCount; ++i) {
+      for (const ImDrawCmd& j: drawData->CmdLists[i]->CmdBuffer) {
+        if (j.UserCallback) bands = 1;
+      }
+    }
+  }
+  if (bands <= 1) {
+    paint_band(pixels, drawData, fb_width, fb_height, 0, 1);
+    return;
+  }
+
+  {
+    std::unique_lock<std::mutex> l(pool->lock);
+    pool->pixels = pixels;
+    pool->drawData = drawData;
+    pool->width = fb_width;
+    pool->height = fb_height;
+    pool->bands = bands;
+    pool->pending = bands - 1;
+    pool->generation++;
+    pool->start.notify_all();
+  }
+
+  paint_band(pixels, drawData, fb_width, fb_height, 0, bands);
+
+  std::unique_lock<std::mutex> l(pool->lock);
+  pool->done.wait(l, [&]() { return pool->pending == 0; });
+}
+
 /// NEW STUFF
 
 bool ImGui_ImplSW_Init(SDL_Window* win) {
@@ -655,6 +791,7 @@ bool ImGui_ImplSW_Init(SDL_Window* win) {
 
   ImGui_ImplSW_Data* bd = IM_NEW(ImGui_ImplSW_Data)();
   bd->Window = win;
+  bd->Pool = paint_pool_create();
   io.BackendRendererUserData = (void*)bd;
   io.BackendRendererName = "imgui_sw";
   io.BackendFlags |= ImGuiBackendFlags_RendererHasTextures;
@@ -670,6 +807,10 @@ void ImGui_ImplSW_Shutdown() {
   ImGuiIO& io = ImGui::GetIO();
 
   ImGui_ImplSW_DestroyDeviceObjects();
+  if (bd->Pool != NULL) {
+    paint_pool_destroy(bd->Pool);
+    bd->Pool = NULL;
+  }
   io.BackendRendererName = nullptr;
   io.BackendRendererUserData = nullptr;
   io.BackendFlags &= ~ImGuiBackendFlags_RendererHasTextures;
@@ -702,7 +843,7 @@ void ImGui_ImplSW_RenderDrawData(ImDrawData* draw_data) {
   if (mustLock) {
     if (SDL_LockSurface(surf)!=0) return;
   }
-  paint_imgui((uint32_t*)surf->pixels,draw_data,surf->w,surf->h);
+  paint_imgui(bd->Pool,(uint32_t*)surf->pixels,draw_data,surf->w,surf->h);
   // 0xAARRGGBB
   if (mustLock) {
     SDL_UnlockSurface(surf);
@@ -26,6 +26,15 @@ namespace vgsound_emu
 
 			virtual u8 read_byte(u32 address) { return 0; }
 
+			// (tildearrow) direct access to contiguous memory.
+			// returns a pointer to the byte at address and sets len to the number of
+			// bytes which may be read from there, or returns NULL if not possible.
+			virtual const u8 *get_byte_span(u32 address, u32 &len)
+			{
+				len = 0;
+				return nullptr;
+			}
+
 			virtual u16 read_word(u32 address) { return 0; }
 
 			virtual u32 read_dword(u32 address) { return 0; }
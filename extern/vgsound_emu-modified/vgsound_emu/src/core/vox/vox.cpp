@@ -8,6 +8,47 @@
 
 #include "vox.hpp"
 
+const s8 vox_core::m_index_table[8]  = {-1, -1, -1, -1, 2, 4, 6, 8};
+const s32 vox_core::m_step_table[49] = {
+  16,  17,	19,	 21,  23,  25,	28,	 31,  34,  37,	41,	  45,	50,	  55,	60,	 66,  73,
+  80,  88,	97,	 107, 118, 130, 143, 157, 173, 190, 209,  230,	253,  279,	307, 337, 371,
+  408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552};
+
+vox_core::decode_table_t::decode_table_t()
+{
+	for (int index = 0; index < 49; index++)
+	{
+		const s16 ss = m_step_table[index];  // ss(n)
+		for (int nibble = 0; nibble < 16; nibble++)
+		{
+			// d(n) = (ss(n) * B2) + ((ss(n) / 2) * B1) + ((ss(n) / 4) * B0)
+			// + (ss(n) / 8)
+			s16 d = ss >> 3;
+			if (bitfield(nibble, 2))
+			{
+				d += ss;
+			}
+			if (bitfield(nibble, 1))
+			{
+				d += (ss >> 1);
+			}
+			if (bitfield(nibble, 0))
+			{
+				d += (ss >> 2);
+			}
+
+			// if (B3 = 1) then d(n) = d(n) * (-1)
+			m_diff[index][nibble] = bitfield(nibble, 3) ? -d : d;
+		}
+		for (int delta = 0; delta < 8; delta++)
+		{
+			m_next_index[index][delta] = clamp(index + m_index_table[delta], 0, 48);
+		}
+	}
+}
+
+const vox_core::decode_table_t vox_core::m_decode_table;
+
 // reset decoder
 void vox_core::vox_decoder_t::decoder_state_t::reset()
 {
@@ -25,34 +66,8 @@ void vox_core::vox_decoder_t::decoder_state_t::copy_state(decoder_state_t &src)
 // decode single nibble
 void vox_core::vox_decoder_t::decoder_state_t::decode(u8 nibble)
 {
-	const u8 delta = bitfield(nibble, 0, 3);
-	const s16 ss   = m_vox.m_step_table[m_index];  // ss(n)
-
-	// d(n) = (ss(n) * B2) + ((ss(n) / 2) * B1) + ((ss(n) / 4) * B0)
-	// + (ss(n) / 8)
-	s16 d = ss >> 3;
-	if (bitfield(delta, 2))
-	{
-		d += ss;
-	}
-	if (bitfield(delta, 1))
-	{
-		d += (ss >> 1);
-	}
-	if (bitfield(delta, 0))
-	{
-		d += (ss >> 2);
-	}
-
-	// if (B3 = 1) then d(n) = d(n) * (-1) X(n) = X(n-1) * d(n)
-	if (bitfield(nibble, 3))
-	{
-		m_step -= d;
-	}
-	else
-	{
-		m_step += d;
-	}
+	// X(n) = X(n-1) + d(n)
+	m_step += m_decode_table.m_diff[m_index][bitfield(nibble, 0, 4)];
 
 	if (m_wraparound)  // wraparound (MSM5205)
 	{
@@ -71,5 +86,5 @@ void vox_core::vox_decoder_t::decoder_state_t::decode(u8 nibble)
 	}
 
 	// adjust step index
-	m_index = clamp(m_index + m_vox.m_index_table[delta], 0, 48);
+	m_index = m_decode_table.m_next_index[m_index][bitfield(nibble, 0, 3)];
 }
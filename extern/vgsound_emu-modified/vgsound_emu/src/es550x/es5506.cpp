@@ -239,6 +239,16 @@ void es5506_core::host_w(u8 address, u8 data)
 			write(m_ha, m_hd);
 }
 
+void es5506_core::host_w32(u8 address, u32 data)
+{
+	m_ha = (bitfield(address, 0, 4) << 2) | 3;
+	m_hd = bitfield(data, 0, 8);
+	regs_w(m_page, bitfield(address, 0, 4), data);
+
+	// Reset latch
+	m_write_latch = 0;
+}
+
 u8 es5506_core::read(u8 address, bool cpu_access)
 {
 	const u8 byte  = bitfield(address, 0, 2);  // byte select
@@ -298,6 +298,8 @@ class es5506_core : public es550x_shared_core
 		// host interface
 		u8 host_r(u8 address);
 		void host_w(u8 address, u8 data);
+		// write a whole 32 bit register (same as 4 host_w() calls)
+		void host_w32(u8 address, u32 data);
 
 		// internal state
 		virtual void reset() override;
@@ -73,6 +73,13 @@ class n163_core : public vgsound_emu_core
 		void data_w(u8 data, bool cpu_access = false);
 		u8 data_r(bool cpu_access = false);
 
+		// direct RAM write, bypassing the address latch
+		inline void ram_w(u8 addr, u8 data, u8 mask = 0xff)
+		{
+			u8 &ram = m_ram[addr & 0x7f];
+			ram		= (ram & ~mask) | (data & mask);
+		}
+
 		inline void set_disable(bool disable) { m_disable = disable; }
 
 		// internal state
@@ -63,6 +63,131 @@ void x1_010_core::voice_t::tick()
 	}
 }
 
+void x1_010_core::tick_block(s32 *out_l, s32 *out_r, s32 **voice_out, u32 len)
+{
+	if (len == 0)
+	{
+		return;
+	}
+	std::fill_n(out_l, len, 0);
+	std::fill_n(out_r, len, 0);
+	// register writes only happen between blocks, so voices don't depend on
+	// each other within one
+	for (int i = 0; i < 16; i++)
+	{
+		m_voice[i].tick_block(out_l, out_r, voice_out[i], len);
+	}
+	m_out[0] = out_l[len - 1];
+	m_out[1] = out_r[len - 1];
+}
+
+void x1_010_core::voice_t::tick_block(s32 *out_l, s32 *out_r, s32 *voice_out, u32 len)
+{
+	u32 pos = 0;
+	while (pos < len)
+	{
+		if (!m_flag.keyon())
+		{
+			// silent for the rest of the block
+			m_out[0] = m_out[1] = 0;
+			std::fill_n(voice_out + pos, len - pos, 0);
+			return;
+		}
+		if (m_flag.wavetable())
+		{
+			// the envelope and wave are in internal RAM. nothing to gain here
+			tick();
+			out_l[pos] += m_out[0];
+			out_r[pos] += m_out[1];
+			voice_out[pos] = m_out[0] + m_out[1];
+			pos++;
+		}
+		else
+		{
+			const u32 count = tick_pcm_span(out_l + pos, out_r + pos, voice_out + pos, len - pos);
+			if (count == 0)
+			{
+				// sample memory isn't directly accessible
+				tick();
+				out_l[pos] += m_out[0];
+				out_r[pos] += m_out[1];
+				voice_out[pos] = m_out[0] + m_out[1];
+				pos++;
+			}
+			else
+			{
+				pos += count;
+			}
+		}
+	}
+}
+
+// render PCM until the end of the sample, the end of the block or the end of
+// a contiguous memory span (e.g. a bank), whichever comes first.
+// returns the number of samples rendered.
+u32 x1_010_core::voice_t::tick_pcm_span(s32 *out_l, s32 *out_r, s32 *voice_out, u32 len)
+{
+	const u32 step	= u32(bitfield(m_freq, 0, 8)) << (1 - m_flag.div());
+	const u32 limit = u32(0xff ^ m_end_envshape);
+
+	// key off happens after the sample which crosses the end address
+	u32 count = len;
+	if ((m_acc >> 17) > limit)
+	{
+		count = 1;
+	}
+	else if (step > 0)
+	{
+		const u32 end_acc	= (limit + 1) << 17;
+		const u32 until_end = (end_acc - m_acc + step - 1) / step;
+		if (until_end < count)
+		{
+			count = until_end;
+		}
+	}
+
+	const u32 addr = bitfield(m_acc, 5, 20);
+	u32 span_len   = 0;
+	const u8 *span = m_host.m_intf.get_byte_span(addr, span_len);
+	if (span == nullptr || span_len == 0)
+	{
+		return 0;
+	}
+	if (step > 0)
+	{
+		const u32 until_span = (((addr + span_len) << 5) - m_acc + step - 1) / step;
+		if (until_span < count)
+		{
+			count = until_span;
+		}
+	}
+
+	m_vol_out[0]	 = bitfield(m_vol_wave, 4, 4);
+	m_vol_out[1]	 = bitfield(m_vol_wave, 0, 4);
+	const s32 vol_l = m_vol_out[0];
+	const s32 vol_r = m_vol_out[1];
+	u32 acc			 = m_acc;
+	for (u32 i = 0; i < count; i++)
+	{
+		const s32 data = s8(span[(acc >> 5) - addr]);
+		const s32 l	   = data * vol_l;
+		const s32 r	   = data * vol_r;
+		out_l[i] += l;
+		out_r[i] += r;
+		voice_out[i] = l + r;
+		acc += step;
+	}
+	m_data	 = s8(span[((acc - step) >> 5) - addr]);
+	m_acc	 = acc;
+	m_out[0] = m_data * vol_l;
+	m_out[1] = m_data * vol_r;
+	if ((m_acc >> 17) > limit)
+	{
+		m_flag.set_keyon(false);
+	}
+	return count;
+}
+
 u8 x1_010_core::ram_r(u16 offset)
 {
 	if (offset & 0x1000)
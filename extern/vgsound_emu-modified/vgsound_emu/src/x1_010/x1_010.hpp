@@ -95,6 +95,7 @@ class x1_010_core : public vgsound_emu_core
 				// internal state
 				void reset();
 				void tick();
+				void tick_block(s32 *out_l, s32 *out_r, s32 *voice_out, u32 len);
 
 				// register accessor
 				u8 reg_r(u8 offset);
@@ -104,6 +105,8 @@ class x1_010_core : public vgsound_emu_core
 				inline s32 out(u8 ch) { return m_out[ch & 1]; }
 
 			private:
+				u32 tick_pcm_span(s32 *out_l, s32 *out_r, s32 *voice_out, u32 len);
+
 				// host flag
 				x1_010_core &m_host;
 				// registers
@@ -160,6 +163,9 @@ class x1_010_core : public vgsound_emu_core
 		// internal state
 		void reset();
 		void tick();
+		// (tildearrow) render len samples at once, voice by voice.
+		// voice_out receives the output of each voice (left + right).
+		void tick_block(s32 *out_l, s32 *out_r, s32 **voice_out, u32 len);
 
 		// for preview only
 		inline s32 voice_out(u8 voice, u8 ch)
@@ -0,0 +1,266 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2026 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include <dlfcn.h>
+#include "../ta-log.h"
+#include "aaudio.h"
+
+struct TAAudioAAudioLib {
+  void* handle;
+  aaudio_result_t (*createStreamBuilder)(AAudioStreamBuilder**);
+  void (*builderSetSampleRate)(AAudioStreamBuilder*,int32_t);
+  void (*builderSetChannelCount)(AAudioStreamBuilder*,int32_t);
+  void (*builderSetFormat)(AAudioStreamBuilder*,aaudio_format_t);
+  void (*builderSetSharingMode)(AAudioStreamBuilder*,aaudio_sharing_mode_t);
+  void (*builderSetPerformanceMode)(AAudioStreamBuilder*,aaudio_performance_mode_t);
+  void (*builderSetBufferCapacityInFrames)(AAudioStreamBuilder*,int32_t);
+  void (*builderSetDataCallback)(AAudioStreamBuilder*,AAudioStream_dataCallback,void*);
+  void (*builderSetErrorCallback)(AAudioStreamBuilder*,AAudioStream_errorCallback,void*);
+  aaudio_result_t (*builderOpenStream)(AAudioStreamBuilder*,AAudioStream**);
+  aaudio_result_t (*builderDelete)(AAudioStreamBuilder*);
+  aaudio_result_t (*streamRequestStart)(AAudioStream*);
+  aaudio_result_t (*streamRequestStop)(AAudioStream*);
+  aaudio_result_t (*streamClose)(AAudioStream*);
+  int32_t (*streamGetSampleRate)(AAudioStream*);
+  int32_t (*streamGetChannelCount)(AAudioStream*);
+  aaudio_sharing_mode_t (*streamGetSharingMode)(AAudioStream*);
+  aaudio_performance_mode_t (*streamGetPerformanceMode)(AAudioStream*);
+  int32_t (*streamGetFramesPerBurst)(AAudioStream*);
+  int32_t (*streamGetBufferCapacityInFrames)(AAudioStream*);
+  aaudio_result_t (*streamSetBufferSizeInFrames)(AAudioStream*,int32_t);
+  int32_t (*streamGetXRunCount)(AAudioStream*);
+  const char* (*convertResultToText)(aaudio_result_t);
+};
+
+static TAAudioAAudioLib aaudioLib;
+static bool aaudioLibTried=false;
+static bool aaudioLibLoaded=false;
+
+#define LOAD_FUNC(x,name) \
+  aaudioLib.x=(decltype(aaudioLib.x))dlsym(aaudioLib.handle,name); \
+  if (aaudioLib.x==NULL) { \
+    logW("AAudio: %s not found!",name); \
+    return false; \
+  }
+
+static bool loadAAudio() {
+  if (aaudioLibTried) return aaudioLibLoaded;
+  aaudioLibTried=true;
+
+  memset(&aaudioLib,0,sizeof(aaudioLib));
+  aaudioLib.handle=dlopen("libaaudio.so",RTLD_NOW);
+  if (aaudioLib.handle==NULL) {
+    logW("AAudio is not available (Android 8.0 or later is required).");
+    return false;
+  }
+
+  LOAD_FUNC(createStreamBuilder,"AAudio_createStreamBuilder");
+  LOAD_FUNC(builderSetSampleRate,"AAudioStreamBuilder_setSampleRate");
+  LOAD_FUNC(builderSetChannelCount,"AAudioStreamBuilder_setChannelCount");
+  LOAD_FUNC(builderSetFormat,"AAudioStreamBuilder_setFormat");
+  LOAD_FUNC(builderSetSharingMode,"AAudioStreamBuilder_setSharingMode");
+  LOAD_FUNC(builderSetPerformanceMode,"AAudioStreamBuilder_setPerformanceMode");
+  LOAD_FUNC(builderSetBufferCapacityInFrames,"AAudioStreamBuilder_setBufferCapacityInFrames");
+  LOAD_FUNC(builderSetDataCallback,"AAudioStreamBuilder_setDataCallback");
+  LOAD_FUNC(builderSetErrorCallback,"AAudioStreamBuilder_setErrorCallback");
+  LOAD_FUNC(builderOpenStream,"AAudioStreamBuilder_openStream");
+  LOAD_FUNC(builderDelete,"AAudioStreamBuilder_delete");
+  LOAD_FUNC(streamRequestStart,"AAudioStream_requestStart");
+  LOAD_FUNC(streamRequestStop,"AAudioStream_requestStop");
+  LOAD_FUNC(streamClose,"AAudioStream_close");
+  LOAD_FUNC(streamGetSampleRate,"AAudioStream_getSampleRate");
+  LOAD_FUNC(streamGetChannelCount,"AAudioStream_getChannelCount");
+  LOAD_FUNC(streamGetSharingMode,"AAudioStream_getSharingMode");
+  LOAD_FUNC(streamGetPerformanceMode,"AAudioStream_getPerformanceMode");
+  LOAD_FUNC(streamGetFramesPerBurst,"AAudioStream_getFramesPerBurst");
+  LOAD_FUNC(streamGetBufferCapacityInFrames,"AAudioStream_getBufferCapacityInFrames");
+  LOAD_FUNC(streamSetBufferSizeInFrames,"AAudioStream_setBufferSizeInFrames");
+  LOAD_FUNC(streamGetXRunCount,"AAudioStream_getXRunCount");
+  LOAD_FUNC(convertResultToText,"AAudio_convertResultToText");
+
+  aaudioLibLoaded=true;
+  return true;
+}
+
+aaudio_data_callback_result_t taAAudioProcess(AAudioStream* stream, void* inst, void* buf, int32_t nframes) {
+  TAAudioAAudio* in=(TAAudioAAudio*)inst;
+  return in->onProcess((float*)buf,nframes);
+}
+
+void taAAudioError(AAudioStream* stream, void* inst, aaudio_result_t error) {
+  TAAudioAAudio* in=(TAAudioAAudio*)inst;
+  in->onError(error);
+}
+
+aaudio_data_callback_result_t TAAudioAAudio::onProcess(float* buf, int32_t nframes) {
+  // the callback may ask for more than a burst
+  for (int32_t pos=0; pos<nframes; pos+=burst) {
+    int32_t len=MIN(burst,nframes-pos);
+    if (audioProcCallback!=NULL) {
+      if (midiIn!=NULL) midiIn->gather();
+      audioProcCallback(audioProcCallbackUser,inBufs,outBufs,desc.inChans,desc.outChans,len);
+    } else {
+      for (int i=0; i<desc.outChans; i++) {
+        memset(outBufs[i],0,len*sizeof(float));
+      }
+    }
+    float* dest=buf+pos*desc.outChans;
+    for (int32_t j=0; j<len; j++) {
+      for (int i=0; i<desc.outChans; i++) {
+        *dest++=outBufs[i][j];
+      }
+    }
+  }
+
+  // start with the smallest buffer and grow it by a burst after every underrun.
+  // this is what gives us the lowest latency a device can handle.
+  int32_t xRuns=aaudioLib.streamGetXRunCount(stream);
+  if (xRuns>lastXRuns) {
+    lastXRuns=xRuns;
+    if (bufSize<bufMax) {
+      bufSize=MIN(bufSize+burst,bufMax);
+      aaudioLib.streamSetBufferSizeInFrames(stream,bufSize);
+    }
+  }
+
+  return AAUDIO_CALLBACK_RESULT_CONTINUE;
+}
+
+void TAAudioAAudio::onError(aaudio_result_t error) {
+  // the stream can't be reopened from here. let the engine do it.
+  logW("AAudio: stream error (%s)",aaudioLib.convertResultToText(error));
+  deviceStatus=TA_AUDIO_DEVICE_RESET;
+}
+
+bool TAAudioAAudio::isAvailable() {
+  return loadAAudio();
+}
+
+void* TAAudioAAudio::getContext() {
+  return (void*)stream;
+}
+
+bool TAAudioAAudio::quit() {
+  if (!initialized) return false;
+
+  setRun(false);
+
+  if (stream!=NULL) {
+    aaudioLib.streamClose(stream);
+    stream=NULL;
+  }
+
+  for (int i=0; i<desc.outChans; i++) {
+    delete[] outBufs[i];
+  }
+
+  delete[] outBufs;
+  outBufs=NULL;
+
+  initialized=false;
+  return true;
+}
+
+bool TAAudioAAudio::setRun(bool run) {
+  if (!initialized) return false;
+
+  if (running!=run) {
+    aaudio_result_t result=run?aaudioLib.streamRequestStart(stream):aaudioLib.streamRequestStop(stream);
+    if (result!=AAUDIO_OK) {
+      logE("AAudio: could not %s stream! (%s)",run?"start":"stop",aaudioLib.convertResultToText(result));
+      return running;
+    }
+    running=run;
+  }
+
+  return running;
+}
+
+std::vector<String> TAAudioAAudio::listAudioDevices() {
+  // devices can only be listed through the Java API (AudioManager)
+  std::vector<String> ret;
+  return ret;
+}
+
+bool TAAudioAAudio::init(TAAudioDesc& request, TAAudioDesc& response) {
+  if (initialized) {
+    logE("audio already initialized");
+    return false;
+  }
+  if (!loadAAudio()) return false;
+
+  desc=request;
+  desc.outFormat=TA_AUDIO_FORMAT_F32;
+  desc.inChans=0;
+
+  AAudioStreamBuilder* builder=NULL;
+  aaudio_result_t result=aaudioLib.createStreamBuilder(&builder);
+  if (result!=AAUDIO_OK) {
+    logE("AAudio: could not create stream builder! (%s)",aaudioLib.convertResultToText(result));
+    return false;
+  }
+
+  aaudioLib.builderSetSampleRate(builder,desc.rate);
+  aaudioLib.builderSetChannelCount(builder,desc.outChans);
+  aaudioLib.builderSetFormat(builder,AAUDIO_FORMAT_PCM_FLOAT);
+  // falls back to shared mode if the device can't do exclusive
+  aaudioLib.builderSetSharingMode(builder,desc.wasapiEx?AAUDIO_SHARING_MODE_EXCLUSIVE:AAUDIO_SHARING_MODE_SHARED);
+  aaudioLib.builderSetPerformanceMode(builder,AAUDIO_PERFORMANCE_MODE_LOW_LATENCY);
+  // the configured buffer size is the most latency we accept after underruns
+  aaudioLib.builderSetBufferCapacityInFrames(builder,desc.bufsize*MAX(desc.fragments,1));
+  aaudioLib.builderSetDataCallback(builder,taAAudioProcess,this);
+  aaudioLib.builderSetErrorCallback(builder,taAAudioError,this);
+
+  logV("opening AAudio stream...");
+  result=aaudioLib.builderOpenStream(builder,&stream);
+  aaudioLib.builderDelete(builder);
+  if (result!=AAUDIO_OK) {
+    logE("AAudio: could not open stream! (%s)",aaudioLib.convertResultToText(result));
+    stream=NULL;
+    return false;
+  }
+
+  desc.rate=aaudioLib.streamGetSampleRate(stream);
+  desc.outChans=aaudioLib.streamGetChannelCount(stream);
+  burst=MAX(aaudioLib.streamGetFramesPerBurst(stream),1);
+  bufMax=MAX(aaudioLib.streamGetBufferCapacityInFrames(stream),burst);
+  bufSize=MIN(burst*2,bufMax);
+  lastXRuns=0;
+  aaudioLib.streamSetBufferSizeInFrames(stream,bufSize);
+  desc.bufsize=burst;
+
+  logI("AAudio: %s mode, %s, burst of %d (buffer up to %d)",
+    (aaudioLib.streamGetSharingMode(stream)==AAUDIO_SHARING_MODE_EXCLUSIVE)?"exclusive":"shared",
+    (aaudioLib.streamGetPerformanceMode(stream)==AAUDIO_PERFORMANCE_MODE_LOW_LATENCY)?"low latency":"normal latency",
+    burst,
+    bufMax
+  );
+
+  if (desc.outChans>0) {
+    outBufs=new float*[desc.outChans];
+    for (int i=0; i<desc.outChans; i++) {
+      outBufs[i]=new float[burst];
+    }
+  }
+
+  response=desc;
+  initialized=true;
+  return true;
+}
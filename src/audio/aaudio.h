@@ -0,0 +1,57 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2026 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "taAudio.h"
+#include <aaudio/AAudio.h>
+
+// AAudio is only present on Android 8.0 and later, so libaaudio.so is
+// loaded at run-time and its functions are looked up by name.
+struct TAAudioAAudioLib;
+
+class TAAudioAAudio: public TAAudio {
+  TAAudioAAudioLib* lib;
+  AAudioStream* stream;
+  // frames per burst (the size of a callback)
+  int32_t burst;
+  // buffer size. raised by a burst after an underrun, up to bufMax.
+  int32_t bufSize, bufMax;
+  int32_t lastXRuns;
+
+  public:
+    aaudio_data_callback_result_t onProcess(float* buf, int32_t nframes);
+    void onError(aaudio_result_t error);
+
+    /**
+     * check whether AAudio is available on this device.
+     */
+    static bool isAvailable();
+
+    void* getContext();
+    bool quit();
+    bool setRun(bool run);
+    std::vector<String> listAudioDevices();
+    bool init(TAAudioDesc& request, TAAudioDesc& response);
+    TAAudioAAudio():
+      lib(NULL),
+      stream(NULL),
+      burst(0),
+      bufSize(0),
+      bufMax(0),
+      lastXRuns(0) {}
+};
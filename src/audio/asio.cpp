@@ -20,6 +20,7 @@
 #include <string.h>
 #include "asio.h"
 #include "../ta-log.h"
+#include "../engine/mixKernel.h"
 
 static TAAudioASIO* callbackInstance=NULL;
 extern AsioDrivers* asioDrivers;
@@ -91,52 +92,37 @@ void TAAudioASIO::onProcess(int index) {
     int ch=chanInfo[i].channel;
     if (ch>=desc.outChans) continue;
     float* srcBuf=outBufs[ch];
+    void* destBuf=bufInfo[i].buffers[index];
 
     switch (chanInfo[i].type) {
       // little-endian
-      case ASIOSTInt16LSB: {
-        short* buf=(short*)bufInfo[i].buffers[index];
-        for (unsigned int j=0; j<desc.bufsize; j++) {
-          buf[j]=CLAMP(srcBuf[j],-1.0,1.0)*32767.0f;
-        }
+      case ASIOSTInt16LSB:
+        DivMixKernel::toS16((short*)destBuf,srcBuf,desc.bufsize);
         break;
-      }
-      case ASIOSTInt24LSB: {
-        unsigned char* buf=(unsigned char*)bufInfo[i].buffers[index];
-        for (unsigned int j=0; j<desc.bufsize; j++) {
-          int val=CLAMP(srcBuf[j],-1.0,1.0)*8388608.0f;
-          if (val<-8388608) val=-8388608;
-          if (val>8388607) val=-8388607;
-          *(buf++)=(val)&0xff;
-          *(buf++)=(val>>8)&0xff;
-          *(buf++)=(val>>16)&0xff;
-        }
+      case ASIOSTInt24LSB:
+        DivMixKernel::toS24((unsigned char*)destBuf,srcBuf,false,desc.bufsize);
         break;
-      }
       case ASIOSTInt32LSB:
+        DivMixKernel::toS32((int*)destBuf,srcBuf,32,desc.bufsize);
+        break;
+      // the following ones are right-aligned
       case ASIOSTInt32LSB16:
+        DivMixKernel::toS32((int*)destBuf,srcBuf,16,desc.bufsize);
+        break;
       case ASIOSTInt32LSB18:
+        DivMixKernel::toS32((int*)destBuf,srcBuf,18,desc.bufsize);
+        break;
       case ASIOSTInt32LSB20:
-      case ASIOSTInt32LSB24: {
-        int* buf=(int*)bufInfo[i].buffers[index];
-        for (unsigned int j=0; j<desc.bufsize; j++) {
-          int val=CLAMP(srcBuf[j],-1.0,1.0)*8388608.0f;
-          if (val<-8388608) val=-8388608;
-          if (val>8388607) val=-8388607;
-          val<<=8;
-          buf[j]=val;
-        }
+        DivMixKernel::toS32((int*)destBuf,srcBuf,20,desc.bufsize);
         break;
-      }
-      case ASIOSTFloat32LSB: {
-        float* buf=(float*)bufInfo[i].buffers[index];
-        for (unsigned int j=0; j<desc.bufsize; j++) {
-          buf[j]=srcBuf[j];
-        }
+      case ASIOSTInt32LSB24:
+        DivMixKernel::toS32((int*)destBuf,srcBuf,24,desc.bufsize);
+        break;
+      case ASIOSTFloat32LSB:
+        memcpy(destBuf,srcBuf,desc.bufsize*sizeof(float));
         break;
-      }
       case ASIOSTFloat64LSB: {
-        double* buf=(double*)bufInfo[i].buffers[index];
+        double* buf=(double*)destBuf;
         for (unsigned int j=0; j<desc.bufsize; j++) {
           buf[j]=srcBuf[j];
         }
@@ -144,53 +130,39 @@ void TAAudioASIO::onProcess(int index) {
       }
 
       // big-endian
-      case ASIOSTInt16MSB: {
-        unsigned short* buf=(unsigned short*)bufInfo[i].buffers[index];
-        for (unsigned int j=0; j<desc.bufsize; j++) {
-          unsigned short val=(unsigned short)((short)(CLAMP(srcBuf[j],-1.0,1.0)*32767.0f));
-          buf[j]=(val>>8)|(val<<8);
-        }
+      case ASIOSTInt16MSB:
+        DivMixKernel::toS16((short*)destBuf,srcBuf,desc.bufsize);
+        DivMixKernel::swap16((unsigned short*)destBuf,desc.bufsize);
         break;
-      }
-      case ASIOSTInt24MSB: {
-        unsigned char* buf=(unsigned char*)bufInfo[i].buffers[index];
-        for (unsigned int j=0; j<desc.bufsize; j++) {
-          int val=CLAMP(srcBuf[j],-1.0,1.0)*8388608.0f;
-          if (val<-8388608) val=-8388608;
-          if (val>8388607) val=-8388607;
-          *(buf++)=(val>>16)&0xff;
-          *(buf++)=(val>>8)&0xff;
-          *(buf++)=(val)&0xff;
-        }
+      case ASIOSTInt24MSB:
+        DivMixKernel::toS24((unsigned char*)destBuf,srcBuf,true,desc.bufsize);
         break;
-      }
       case ASIOSTInt32MSB:
+        DivMixKernel::toS32((int*)destBuf,srcBuf,32,desc.bufsize);
+        DivMixKernel::swap32((unsigned int*)destBuf,desc.bufsize);
+        break;
       case ASIOSTInt32MSB16:
+        DivMixKernel::toS32((int*)destBuf,srcBuf,16,desc.bufsize);
+        DivMixKernel::swap32((unsigned int*)destBuf,desc.bufsize);
+        break;
       case ASIOSTInt32MSB18:
+        DivMixKernel::toS32((int*)destBuf,srcBuf,18,desc.bufsize);
+        DivMixKernel::swap32((unsigned int*)destBuf,desc.bufsize);
+        break;
       case ASIOSTInt32MSB20:
-      case ASIOSTInt32MSB24: {
-        unsigned int* buf=(unsigned int*)bufInfo[i].buffers[index];
-        for (unsigned int j=0; j<desc.bufsize; j++) {
-          int val=CLAMP(srcBuf[j],-1.0,1.0)*8388608.0f;
-          if (val<-8388608) val=-8388608;
-          if (val>8388607) val=-8388607;
-          val<<=8;
-          unsigned char* uVal=(unsigned char*)&val;
-          buf[j]=(uVal[0]<<24)|(uVal[1]<<16)|(uVal[2]<<8)|(uVal[3]);
-        }
+        DivMixKernel::toS32((int*)destBuf,srcBuf,20,desc.bufsize);
+        DivMixKernel::swap32((unsigned int*)destBuf,desc.bufsize);
         break;
-      }
-      case ASIOSTFloat32MSB: {
-        unsigned int* buf=(unsigned int*)bufInfo[i].buffers[index];
-        for (unsigned int j=0; j<desc.bufsize; j++) {
-          float val=srcBuf[j];
-          unsigned char* uVal=(unsigned char*)&val;
-          buf[j]=(uVal[0]<<24)|(uVal[1]<<16)|(uVal[2]<<8)|(uVal[3]);
-        }
+      case ASIOSTInt32MSB24:
+        DivMixKernel::toS32((int*)destBuf,srcBuf,24,desc.bufsize);
+        DivMixKernel::swap32((unsigned int*)destBuf,desc.bufsize);
+        break;
+      case ASIOSTFloat32MSB:
+        memcpy(destBuf,srcBuf,desc.bufsize*sizeof(float));
+        DivMixKernel::swap32((unsigned int*)destBuf,desc.bufsize);
         break;
-      }
       case ASIOSTFloat64MSB: {
-        unsigned char* buf=(unsigned char*)bufInfo[i].buffers[index];
+        unsigned char* buf=(unsigned char*)destBuf;
         for (unsigned int j=0; j<desc.bufsize; j++) {
           double val=srcBuf[j];
           unsigned char* uVal=(unsigned char*)&val;
@@ -52,27 +52,20 @@ void TAAudioJACK::onBufferSize(jack_nframes_t bufsize) {
 }
 
 void TAAudioJACK::onProcess(jack_nframes_t nframes) {
+  // the callback reads and writes the port buffers directly
   for (int i=0; i<desc.inChans; i++) {
     iInBufs[i]=(float*)jack_port_get_buffer(ai[i],nframes);
-    if (nframes>desc.bufsize) {
-      delete[] inBufs[i];
-      inBufs[i]=new float[nframes];
-    }
-    memcpy(iInBufs[i],inBufs[i],nframes*sizeof(float));
   }
-  for (int i=0; i<desc.outChans; i++) {
-    if (nframes>desc.bufsize) {
-      delete[] outBufs[i];
-      outBufs[i]=new float[nframes];
-    }
+  for (int i=0; i<totalOutChans; i++) {
+    iOutBufs[i]=(float*)jack_port_get_buffer(ao[i],nframes);
   }
   if (audioProcCallback!=NULL) {
     if (midiIn!=NULL) midiIn->gather();
-    audioProcCallback(audioProcCallbackUser,inBufs,outBufs,desc.inChans,desc.outChans,nframes);
-  }
-  for (int i=0; i<desc.outChans; i++) {
-    iOutBufs[i]=(float*)jack_port_get_buffer(ao[i],nframes);
-    memcpy(iOutBufs[i],outBufs[i],nframes*sizeof(float));
+    audioProcCallback(audioProcCallbackUser,iInBufs,iOutBufs,desc.inChans,totalOutChans,nframes);
+  } else {
+    for (int i=0; i<totalOutChans; i++) {
+      memset(iOutBufs[i],0,nframes*sizeof(float));
+    }
   }
   if (nframes!=desc.bufsize) {
     desc.bufsize=nframes;
@@ -97,20 +90,20 @@ bool TAAudioJACK::quit() {
   for (int i=0; i<desc.inChans; i++) {
     jack_port_unregister(ac,ai[i]);
     ai[i]=NULL;
-    delete[] inBufs[i];
   }
-  for (int i=0; i<desc.outChans; i++) {
+  for (int i=0; i<totalOutChans; i++) {
     jack_port_unregister(ac,ao[i]);
     ao[i]=NULL;
-    delete[] outBufs[i];
   }
 
   if (iInBufs!=NULL) delete[] iInBufs;
   if (iOutBufs!=NULL) delete[] iOutBufs;
-  delete[] inBufs;
-  delete[] outBufs;
-  delete[] ai;
-  delete[] ao;
+  iInBufs=NULL;
+  iOutBufs=NULL;
+  if (ai!=NULL) delete[] ai;
+  if (ao!=NULL) delete[] ao;
+  ai=NULL;
+  ao=NULL;
   
   jack_client_close(ac);
   ac=NULL;
@@ -234,7 +227,6 @@ bool TAAudioJACK::init(TAAudioDesc& request, TAAudioDesc& response) {
   desc.rate=sampleRate;
 
   if (desc.inChans>0) {
-    inBufs=new float*[desc.inChans];
     iInBufs=new float*[desc.inChans];
     ai=new jack_port_t*[desc.inChans];
     for (int i=0; i<desc.inChans; i++) {
@@ -243,22 +235,45 @@ bool TAAudioJACK::init(TAAudioDesc& request, TAAudioDesc& response) {
         desc.inChans=i;
         break;
       }
-      inBufs[i]=new float[count];
     }
   }
+  totalOutChans=0;
   if (desc.outChans>0) {
-    outBufs=new float*[desc.outChans];
-    iOutBufs=new float*[desc.outChans];
-    ao=new jack_port_t*[desc.outChans];
+    // main outputs, followed by one set of outputs per chip
+    int maxChans=desc.outChans*(1+desc.auxOutSets);
+    iOutBufs=new float*[maxChans];
+    ao=new jack_port_t*[maxChans];
     for (int i=0; i<desc.outChans; i++) {
       ao[i]=jack_port_register(ac,(String("out")+std::to_string(i)).c_str(),JACK_DEFAULT_AUDIO_TYPE,JackPortIsOutput,0);
       if (ao[i]==NULL) {
         desc.outChans=i;
         break;
       }
-      outBufs[i]=new float[count];
+      totalOutChans++;
+    }
+    for (int i=0; i<desc.auxOutSets; i++) {
+      bool failed=false;
+      for (int j=0; j<desc.outChans; j++) {
+        ao[totalOutChans+j]=jack_port_register(ac,(String("chip")+std::to_string(i+1)+String("_out")+std::to_string(j)).c_str(),JACK_DEFAULT_AUDIO_TYPE,JackPortIsOutput,0);
+        if (ao[totalOutChans+j]==NULL) {
+          // drop the incomplete set
+          for (int k=0; k<j; k++) {
+            jack_port_unregister(ac,ao[totalOutChans+k]);
+            ao[totalOutChans+k]=NULL;
+          }
+          failed=true;
+          break;
+        }
+      }
+      if (failed) {
+        logW("could only register %d chip output sets.",i);
+        desc.auxOutSets=i;
+        break;
+      }
+      totalOutChans+=desc.outChans;
     }
   }
+  if (totalOutChans==0) desc.auxOutSets=0;
 
   response=desc;
   initialized=true;
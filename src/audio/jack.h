@@ -27,6 +27,8 @@ class TAAudioJACK: public TAAudio {
 
   float** iInBufs;
   float** iOutBufs;
+  // main outputs and chip outputs
+  int totalOutChans;
 
   String printStatus(jack_status_t status);
 
@@ -45,5 +47,6 @@ class TAAudioJACK: public TAAudio {
       ai(NULL),
       ao(NULL),
       iInBufs(NULL),
-      iOutBufs(NULL) {}
+      iOutBufs(NULL),
+      totalOutChans(0) {}
 };
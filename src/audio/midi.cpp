@@ -18,6 +18,8 @@
  */
 
 #include "taAudio.h"
+#include "../ta-log.h"
+#include <chrono>
 #ifdef HAVE_RTMIDI
 #include "rtmidi.h"
 #endif
@@ -43,6 +45,7 @@ bool TAAudio::initMidi(bool jack) {
     midiIn=NULL;
     return false;
   }
+  midiOut->startThread();
   return true;
 #endif
 }
@@ -54,8 +57,69 @@ void TAAudio::quitMidi() {
     midiIn=NULL;
   }
   if (midiOut!=NULL) {
+    midiOut->stopThread();
     midiOut->quit();
     delete midiOut;
     midiOut=NULL;
   }
-}
\ No newline at end of file
+}
+static double _midiNow() {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void TAMidiOut::runOutThread() {
+  std::unique_lock<std::mutex> lock(queueLock);
+  while (!outThreadQuit) {
+    if (queue.empty()) {
+      queueCond.wait(lock);
+      continue;
+    }
+    TAMidiMessage msg=queue.front();
+    if (msg.time>0.0) {
+      double wait=msg.time-_midiNow();
+      if (wait>0.0) {
+        queueCond.wait_for(lock,std::chrono::duration<double>(wait));
+        continue;
+      }
+    }
+    queue.pop();
+    lock.unlock();
+    send(msg);
+    lock.lock();
+  }
+}
+
+bool TAMidiOut::sendAt(const TAMidiMessage& what) {
+  if (outThread==NULL) return send(what);
+  bool ret;
+  {
+    std::lock_guard<std::mutex> lock(queueLock);
+    ret=queue.push(what);
+  }
+  if (!ret) logW("MIDI output queue full!");
+  queueCond.notify_one();
+  return ret;
+}
+
+void TAMidiOut::startThread() {
+  if (outThread!=NULL) return;
+  outThreadQuit=false;
+  outThread=new std::thread(&TAMidiOut::runOutThread,this);
+}
+
+void TAMidiOut::stopThread() {
+  if (outThread==NULL) return;
+  {
+    std::lock_guard<std::mutex> lock(queueLock);
+    outThreadQuit=true;
+  }
+  queueCond.notify_one();
+  outThread->join();
+  delete outThread;
+  outThread=NULL;
+  // anything left is sent right away
+  while (!queue.empty()) {
+    send(queue.front());
+    queue.pop();
+  }
+}
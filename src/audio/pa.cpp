@@ -219,6 +219,7 @@ bool TAAudioPA::init(TAAudioDesc& request, TAAudioDesc& response) {
   outParams.sampleFormat=paFloat32;
   outParams.suggestedLatency=(double)(desc.bufsize*desc.fragments)/desc.rate;
   outParams.hostApiSpecificStreamInfo=NULL;
+  unsigned long framesPerBuffer=paFramesPerBufferUnspecified;
 
   if (driverInfo!=NULL) {
 #ifdef _WIN32
@@ -235,7 +236,11 @@ bool TAAudioPA::init(TAAudioDesc& request, TAAudioDesc& response) {
       wasapiInfo->streamOption=eStreamOptionRaw;
 
       if (desc.wasapiEx) {
+        // event-driven exclusive mode. the device double-buffers on its own, so
+        // a single buffer is enough and the latency is that of a buffer.
         wasapiInfo->flags|=paWinWasapiExclusive;
+        outParams.suggestedLatency=(double)desc.bufsize/desc.rate;
+        framesPerBuffer=desc.bufsize;
       }
 
       outParams.hostApiSpecificStreamInfo=wasapiInfo;
@@ -249,7 +254,7 @@ bool TAAudioPA::init(TAAudioDesc& request, TAAudioDesc& response) {
     NULL,
     &outParams,
     desc.rate,
-    0,
+    framesPerBuffer,
     paClipOff|paDitherOff,
     taPAProcess,
     this
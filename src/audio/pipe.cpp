@@ -19,16 +19,59 @@
 
 #include <string.h>
 #include "../ta-log.h"
+#include "../engine/mixKernel.h"
 #include "pipe.h"
 
+// how much converted audio may wait for the consumer (in seconds)
+#define PIPE_RING_SECONDS 2
+
 void taPipeThread(void* inst) {
   TAAudioPipe* in=(TAAudioPipe*)inst;
   in->runThread();
 }
 
+void taPipeWriter(void* inst) {
+  TAAudioPipe* in=(TAAudioPipe*)inst;
+  in->runWriter();
+}
+
 void TAAudioPipe::runThread() {
   while (running) {
-    onProcess((unsigned char*)sbuf,desc.bufsize);
+    onProcess(sbuf,desc.bufsize);
+  }
+}
+
+void TAAudioPipe::runWriter() {
+  size_t mask=ringLen-1;
+  while (true) {
+    size_t readPos=ringReadPos.load(std::memory_order_relaxed);
+    size_t avail=ringWritePos.load(std::memory_order_acquire)-readPos;
+    if (avail==0) {
+      // flush once we've caught up, rather than after every buffer
+      if (!writeFailed) fflush(stdout);
+      std::unique_lock<std::mutex> unique(ringLock);
+      while (ringWritePos.load(std::memory_order_acquire)==readPos && !writerQuit) {
+        ringCond.wait(unique);
+      }
+      if (ringWritePos.load(std::memory_order_acquire)==readPos) break;
+      continue;
+    }
+
+    // write as much as possible at once
+    size_t start=readPos&mask;
+    size_t len=MIN(avail,ringLen-start);
+    if (!writeFailed) {
+      if (fwrite(ring+start,1,len,stdout)!=len) {
+        logE("could not write audio to stdout!");
+        writeFailed=true;
+      }
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(ringLock);
+      ringReadPos.store(readPos+len,std::memory_order_release);
+    }
+    ringCond.notify_all();
   }
 }
 
@@ -37,20 +80,56 @@ void TAAudioPipe::onProcess(unsigned char* buf, int nframes) {
     if (midiIn!=NULL) midiIn->gather();
     audioProcCallback(audioProcCallbackUser,inBufs,outBufs,desc.inChans,desc.outChans,desc.bufsize);
   }
-  short* sb=(short*)buf;
 
-  if (sb==NULL) return;
+  if (buf==NULL) return;
 
-  for (size_t j=0; j<desc.bufsize; j++) {
-    for (size_t i=0; i<desc.outChans; i++) {
-      if (outBufs[i][j]<-1.0) outBufs[i][j]=-1.0;
-      if (outBufs[i][j]>1.0) outBufs[i][j]=1.0;
-      sb[j*desc.outChans+i]=outBufs[i][j]*32767.0;
+  // interleave
+  size_t total=nframes*desc.outChans;
+  for (size_t i=0; i<desc.outChans; i++) {
+    float* src=outBufs[i];
+    float* dest=&fbuf[i];
+    for (int j=0; j<nframes; j++) {
+      *dest=src[j];
+      dest+=desc.outChans;
     }
   }
 
-  fwrite(sb,2,desc.bufsize*desc.outChans,stdout);
-  fflush(stdout);
+  // convert
+  const unsigned char* out=buf;
+  switch (desc.outFormat) {
+    case TA_AUDIO_FORMAT_S16:
+      DivMixKernel::toS16((short*)buf,fbuf,total);
+      break;
+    case TA_AUDIO_FORMAT_S24:
+      DivMixKernel::toS24(buf,fbuf,false,total);
+      break;
+    default:
+      out=(const unsigned char*)fbuf;
+      break;
+  }
+  size_t len=nframes*frameSize;
+
+  // wait for the consumer to make room.
+  // this is what paces rendering - there is no clock involved.
+  {
+    std::unique_lock<std::mutex> unique(ringLock);
+    while (running && ringLen-(ringWritePos.load(std::memory_order_relaxed)-ringReadPos.load(std::memory_order_acquire))<len) {
+      ringCond.wait(unique);
+    }
+  }
+  if (!running) return;
+
+  size_t writePos=ringWritePos.load(std::memory_order_relaxed);
+  size_t start=writePos&(ringLen-1);
+  size_t firstLen=MIN(len,ringLen-start);
+  memcpy(ring+start,out,firstLen);
+  if (firstLen<len) memcpy(ring,out+firstLen,len-firstLen);
+
+  {
+    std::lock_guard<std::mutex> lock(ringLock);
+    ringWritePos.store(writePos+len,std::memory_order_release);
+  }
+  ringCond.notify_all();
 }
 
 void* TAAudioPipe::getContext() {
@@ -60,14 +139,7 @@ void* TAAudioPipe::getContext() {
 bool TAAudioPipe::quit() {
   if (!initialized) return false;
 
-  if (running) {
-    running=false;
-    if (outThread) {
-      outThread->join();
-      delete outThread;
-      outThread=NULL;
-    }
-  }
+  setRun(false);
 
   for (int i=0; i<desc.outChans; i++) {
     delete[] outBufs[i];
@@ -75,10 +147,18 @@ bool TAAudioPipe::quit() {
 
   delete[] outBufs;
 
+  if (fbuf) {
+    delete[] fbuf;
+    fbuf=NULL;
+  }
   if (sbuf) {
     delete[] sbuf;
     sbuf=NULL;
   }
+  if (ring) {
+    delete[] ring;
+    ring=NULL;
+  }
   
   initialized=false;
   return true;
@@ -90,11 +170,29 @@ bool TAAudioPipe::setRun(bool run) {
   if (running!=run) {
     running=run;
     if (running) {
+      writerQuit=false;
+      writeThread=new std::thread(taPipeWriter,this);
       outThread=new std::thread(taPipeThread,this);
-    } else if (outThread) {
-      outThread->join();
-      delete outThread;
-      outThread=NULL;
+    } else {
+      // wake the render thread up if it's waiting for the consumer
+      ringLock.lock();
+      ringLock.unlock();
+      ringCond.notify_all();
+      if (outThread) {
+        outThread->join();
+        delete outThread;
+        outThread=NULL;
+      }
+      // let the writer finish
+      ringLock.lock();
+      writerQuit=true;
+      ringLock.unlock();
+      ringCond.notify_all();
+      if (writeThread) {
+        writeThread->join();
+        delete writeThread;
+        writeThread=NULL;
+      }
     }
   }
 
@@ -116,8 +214,19 @@ bool TAAudioPipe::init(TAAudioDesc& request, TAAudioDesc& response) {
   }
 
   desc=request;
-  desc.outFormat=TA_AUDIO_FORMAT_F32;
-  response=desc;
+  switch (desc.outFormat) {
+    case TA_AUDIO_FORMAT_F32:
+      frameSize=4;
+      break;
+    case TA_AUDIO_FORMAT_S24:
+      frameSize=3;
+      break;
+    default:
+      desc.outFormat=TA_AUDIO_FORMAT_S16;
+      frameSize=2;
+      break;
+  }
+  frameSize*=desc.outChans;
 
   logV("opening stdout for audio...");
 
@@ -126,8 +235,17 @@ bool TAAudioPipe::init(TAAudioDesc& request, TAAudioDesc& response) {
     for (int i=0; i<desc.outChans; i++) {
       outBufs[i]=new float[desc.bufsize];
     }
-      
-    sbuf=new short[desc.bufsize*desc.outChans];
+
+    fbuf=new float[desc.bufsize*desc.outChans];
+    sbuf=new unsigned char[desc.bufsize*frameSize];
+
+    size_t ringMin=MAX((size_t)(desc.rate*PIPE_RING_SECONDS)*frameSize,(size_t)desc.bufsize*frameSize*4);
+    ringLen=1;
+    while (ringLen<ringMin) ringLen<<=1;
+    ring=new unsigned char[ringLen];
+    ringReadPos=0;
+    ringWritePos=0;
+    writeFailed=false;
   } else {
     sbuf=NULL;
   }
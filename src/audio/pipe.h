@@ -19,13 +19,30 @@
 
 #include "taAudio.h"
 #include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 
 class TAAudioPipe: public TAAudio {
   std::thread* outThread;
-  short* sbuf;
+  std::thread* writeThread;
+  // interleaved float samples, and the converted ones
+  float* fbuf;
+  unsigned char* sbuf;
+  size_t frameSize;
+
+  // converted audio waiting to be written to stdout
+  unsigned char* ring;
+  size_t ringLen;
+  std::atomic<size_t> ringReadPos, ringWritePos;
+  std::mutex ringLock;
+  std::condition_variable ringCond;
+  std::atomic<bool> writerQuit;
+  bool writeFailed;
 
   public:
     void runThread();
+    void runWriter();
     void onProcess(unsigned char* buf, int nframes);
 
     void* getContext();
@@ -34,5 +51,15 @@ class TAAudioPipe: public TAAudio {
     std::vector<String> listAudioDevices();
     bool init(TAAudioDesc& request, TAAudioDesc& response);
     TAAudioPipe():
-      sbuf(NULL) {}
+      outThread(NULL),
+      writeThread(NULL),
+      fbuf(NULL),
+      sbuf(NULL),
+      frameSize(0),
+      ring(NULL),
+      ringLen(0),
+      ringReadPos(0),
+      ringWritePos(0),
+      writerQuit(false),
+      writeFailed(false) {}
 };
@@ -20,6 +20,10 @@
 #include "rtmidi.h"
 #include "../ta-log.h"
 #include "taAudio.h"
+#include <chrono>
+
+// resynchronize the message clock if a message appears to be this late (in seconds)
+#define MIDI_CLOCK_RESYNC 0.25
 
 String sanitizePortName(const String& name) {
 #if defined(_WIN32)
@@ -46,14 +50,25 @@ String sanitizePortName(const String& name) {
 bool TAMidiInRtMidi::gather() {
   std::vector<unsigned char> msg;
   if (port==NULL) return false;
+  double now=std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
   try {
     while (true) {
       TAMidiMessage m;
       double t=port->getMessage(&msg);
       if (msg.empty()) break;
 
+      // RtMidi only gives us the time since the previous message.
+      // the offset to the steady clock is estimated from the earliest time
+      // at which a message could have been gathered.
+      msgClock+=t;
+      double offset=now-msgClock;
+      if (!clockValid || offset<clockOffset || offset-clockOffset>MIDI_CLOCK_RESYNC) {
+        clockOffset=offset;
+        clockValid=true;
+      }
+
       // parse message
-      m.time=t;
+      m.time=MIN(msgClock+clockOffset,now);
       m.type=msg[0];
       if (m.type!=TA_MIDI_SYSEX && msg.size()>1) {
         memcpy(m.data,msg.data()+1,MIN(msg.size()-1,7));
@@ -109,6 +124,8 @@ bool TAMidiInRtMidi::openDevice(String name) {
         logD("opening port %d...",i);
         port->openPort(i);
         portOpen=true;
+        msgClock=0.0;
+        clockValid=false;
         break;
       }
     }
@@ -23,6 +23,9 @@
 class TAMidiInRtMidi: public TAMidiIn {
   RtMidiIn* port;
   bool isOpen;
+  // sum of delta times, and its offset to the steady clock
+  double msgClock, clockOffset;
+  bool clockValid;
   public:
     bool gather();
     bool isDeviceOpen();
@@ -33,7 +36,10 @@ class TAMidiInRtMidi: public TAMidiIn {
     bool init();
     TAMidiInRtMidi():
       port(NULL),
-      isOpen(false) {}
+      isOpen(false),
+      msgClock(0.0),
+      clockOffset(0.0),
+      clockValid(false) {}
 };
 
 class TAMidiOutRtMidi: public TAMidiOut {
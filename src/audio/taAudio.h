@@ -21,6 +21,8 @@
 #define _TAAUDIO_H
 #include "../ta-utils.h"
 #include <memory>
+#include <thread>
+#include <condition_variable>
 #include "../fixedQueue.h"
 #include "../pch.h"
 
@@ -62,7 +64,9 @@ enum TAAudioFormat {
   TA_AUDIO_FORMAT_U16BE,
   TA_AUDIO_FORMAT_S16BE,
   TA_AUDIO_FORMAT_U32BE,
-  TA_AUDIO_FORMAT_S32BE
+  TA_AUDIO_FORMAT_S32BE,
+  // packed, little-endian
+  TA_AUDIO_FORMAT_S24
 };
 
 struct TAAudioDesc {
@@ -70,8 +74,12 @@ struct TAAudioDesc {
   double rate;
   unsigned int bufsize, fragments;
   unsigned char inChans, outChans;
+  // number of additional output sets (each with outChans outputs) which
+  // follow the main ones, used for per-chip outputs. JACK only.
+  unsigned char auxOutSets;
   TAAudioFormat outFormat;
 
+  // exclusive mode (WASAPI through PortAudio, or AAudio)
   bool wasapiEx;
 
   TAAudioDesc():
@@ -80,6 +88,7 @@ struct TAAudioDesc {
     fragments(0),
     inChans(0),
     outChans(0),
+    auxOutSets(0),
     outFormat(TA_AUDIO_FORMAT_F32),
     wasapiEx(false) {}
 };
@@ -108,6 +117,7 @@ enum TAMidiMessageTypes {
 };
 
 struct TAMidiMessage {
+  // arrival time in seconds (on std::chrono::steady_clock), or 0 if unknown
   double time;
   unsigned char type;
   unsigned char data[7];
@@ -153,16 +163,32 @@ class TAMidiIn {
 };
 
 class TAMidiOut {
+  // messages waiting for the output thread
   FixedQueue<TAMidiMessage,8192> queue;
+  std::thread* outThread;
+  std::mutex queueLock;
+  std::condition_variable queueCond;
+  bool outThreadQuit;
+  void runOutThread();
   public:
+    // send a message to the device right away.
     virtual bool send(const TAMidiMessage& what);
+    // queue a message, to be sent by the output thread at what.time (in seconds on
+    // std::chrono::steady_clock), or as soon as possible if it is 0.
+    // messages are sent in the order they were queued.
+    // sends right away if the output thread is not running.
+    bool sendAt(const TAMidiMessage& what);
+    void startThread();
+    void stopThread();
     virtual bool isDeviceOpen();
     virtual bool openDevice(String name);
     virtual bool closeDevice();
     virtual std::vector<String> listDevices();
     virtual bool init();
     virtual bool quit();
-    TAMidiOut() {
+    TAMidiOut():
+      outThread(NULL),
+      outThreadQuit(false) {
     }
     virtual ~TAMidiOut();
 };
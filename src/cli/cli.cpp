@@ -19,6 +19,8 @@
 
 #include "cli.h"
 #include "../ta-log.h"
+#include "../fileutils.h"
+#include <chrono>
 
 bool cliQuit=false;
 
@@ -40,7 +42,104 @@ void FurnaceCLI::bindEngine(DivEngine* eng) {
   e=eng;
 }
 
+void FurnaceCLI::setPlaylist(const std::vector<String>& files, int loops, int fadeMs) {
+  playlist=files;
+  playlistLoops=loops;
+  playlistFadeMs=fadeMs;
+}
+
+bool FurnaceCLI::preparePlaylistEntry(const String& path) {
+  FILE* f=ps_fopen(path.c_str(),"rb");
+  if (f==NULL) {
+    logE("%s: couldn't open file! (%s)",path.c_str(),strerror(errno));
+    return false;
+  }
+  if (fseek(f,0,SEEK_END)<0) {
+    logE("%s: couldn't get file size!",path.c_str());
+    fclose(f);
+    return false;
+  }
+  ssize_t len=ftell(f);
+  if (len<1 || fseek(f,0,SEEK_SET)<0) {
+    logE("%s: empty or unreadable file!",path.c_str());
+    fclose(f);
+    return false;
+  }
+  unsigned char* data=new unsigned char[len];
+  if (fread(data,1,(size_t)len,f)!=(size_t)len) {
+    logE("%s: couldn't read file!",path.c_str());
+    fclose(f);
+    delete[] data;
+    return false;
+  }
+  fclose(f);
+
+  // load, initialize and render samples now, while the current song plays
+  DivEngine* worker=new DivEngine;
+  if (!worker->initRenderWorker(e,data,len)) {
+    logE("%s: couldn't open file! (%s)",path.c_str(),worker->getLastError().c_str());
+    worker->quit(false);
+    delete worker;
+    return false;
+  }
+  worker->play();
+  if (!e->queuePlaylistNext(worker)) {
+    worker->quit(false);
+    delete worker;
+    return false;
+  }
+  logI("playlist: queued %s",path.c_str());
+  return true;
+}
+
+void FurnaceCLI::runPlaylist() {
+  size_t index=1;
+  size_t failed=0;
+  DivEngine* shown=e;
+  while (!cliQuit) {
+    DivEngine* done=e->takePlaylistDone();
+    if (done!=NULL) {
+      std::lock_guard<std::mutex> guard(playlistDoneLock);
+      done->quit(false);
+      delete done;
+    }
+
+    DivEngine* cur=e->getPlaylistCurrent();
+    if (cur!=shown) {
+      // only the song being heard may print its status
+      shown->setConsoleMode(true,false);
+      cur->setConsoleMode(true,!disableStatus);
+      shown=cur;
+      logI("playlist: now playing %s",cur->song.name.empty()?"(untitled)":cur->song.name.c_str());
+    }
+
+    if (!e->isPlaylistNextQueued() && failed<playlist.size()) {
+      if (preparePlaylistEntry(playlist[index])) {
+        failed=0;
+      } else {
+        failed++;
+        if (failed>=playlist.size()) logE("playlist: no song could be opened. staying on the current one.");
+      }
+      // start over after the last song
+      if (++index>=playlist.size()) index=0;
+      continue;
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+}
+
 bool FurnaceCLI::loop() {
+  if (playlist.size()>1) {
+    e->setPlaylistMode(true,playlistLoops,playlistFadeMs);
+    try {
+      playlistThread=new std::thread(&FurnaceCLI::runPlaylist,this);
+    } catch (std::system_error& err) {
+      logE("could not start playlist thread! %s",err.what());
+      playlistThread=NULL;
+    }
+  }
+
   if (disableControls) {
     while (!cliQuit) {
 #ifdef _WIN32
@@ -63,16 +162,19 @@ bool FurnaceCLI::loop() {
     unsigned char c;
     if (read(STDIN_FILENO,&c,1)<=0) continue;
 #endif
+    // a finished song may not be deleted while it is being controlled
+    std::lock_guard<std::mutex> guard(playlistDoneLock);
+    DivEngine* cur=e->getPlaylistCurrent();
     if (escape) {
       if (escapeSecondStage) {
         switch (c) {
           case 'C': // right
-            e->setOrder(e->getOrder()+1);
+            cur->setOrder(cur->getOrder()+1);
             escape=false;
             escapeSecondStage=false;
             break;
           case 'D': // left
-            e->setOrder(e->getOrder()-1);
+            cur->setOrder(cur->getOrder()-1);
             escape=false;
             escapeSecondStage=false;
             break;
@@ -97,16 +199,16 @@ bool FurnaceCLI::loop() {
           escape=true;
           break;
         case 'h': // left
-          e->setOrder(e->getOrder()-1);
+          cur->setOrder(cur->getOrder()-1);
           break;
         case 'l': // right
-          e->setOrder(e->getOrder()+1);
+          cur->setOrder(cur->getOrder()+1);
           break;
         case ' ':
-          if (e->isHalted()) {
-            e->resume();
+          if (cur->isHalted()) {
+            cur->resume();
           } else {
-            e->halt();
+            cur->halt();
           }
           break;
       }
@@ -117,6 +219,12 @@ bool FurnaceCLI::loop() {
 }
 
 bool FurnaceCLI::finish() {
+  if (playlistThread!=NULL) {
+    playlistThread->join();
+    delete playlistThread;
+    playlistThread=NULL;
+  }
+  e->setPlaylistMode(false);
   if (disableControls) return true;
 #ifdef _WIN32
 #else
@@ -168,5 +276,8 @@ bool FurnaceCLI::init() {
 }
 
 FurnaceCLI::FurnaceCLI():
-  e(NULL) {
+  e(NULL),
+  playlistLoops(1),
+  playlistFadeMs(0),
+  playlistThread(NULL) {
 }
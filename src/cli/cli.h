@@ -22,6 +22,8 @@
 
 
 #include "../engine/engine.h"
+#include <thread>
+#include <mutex>
 
 #include <stdio.h>
 #ifdef _WIN32
@@ -38,6 +40,15 @@ class FurnaceCLI {
   bool disableStatus;
   bool disableControls;
 
+  // playlist mode. the first song is loaded by the caller.
+  std::vector<String> playlist;
+  int playlistLoops, playlistFadeMs;
+  std::thread* playlistThread;
+  std::mutex playlistDoneLock;
+  void runPlaylist();
+  // load a playlist entry into a new render worker and queue it.
+  bool preparePlaylistEntry(const String& path);
+
 #ifdef _WIN32
   HANDLE winin;
   HANDLE winout;
@@ -51,6 +62,13 @@ class FurnaceCLI {
     void noStatus();
     void noControls();
     void bindEngine(DivEngine* eng);
+    /**
+     * play a list of songs without gaps between them.
+     * @param files the songs. the first one must be loaded already.
+     * @param loops how many times each song is played.
+     * @param fadeMs crossfade length in milliseconds.
+     */
+    void setPlaylist(const std::vector<String>& files, int loops, int fadeMs);
     bool loop();
     bool finish();
     bool init();
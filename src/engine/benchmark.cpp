@@ -0,0 +1,595 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2026 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// playback, per-chip and file benchmarks.
+// for the per-chip benchmark, every system is run alone with a synthetic
+// song (all channels playing notes with vibrato, using a looped sample
+// where possible), once per emulation core.
+
+#include "engine.h"
+#include "counters.h"
+#include "rtCheck.h"
+#include "../ta-log.h"
+#include "../fileutils.h"
+#include <chrono>
+#include <float.h>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#define BENCH_BUFSIZE 2048
+#define BENCH_ROWS 64
+#define BENCH_SAMPLE_LEN 4096
+#define BENCH_FILE_ITERATIONS 20
+
+struct DivBenchCores {
+  // render core setting, or NULL if the chip only has one core
+  const char* key;
+  int count;
+  const char* names[3];
+};
+
+static const DivBenchCores benchCoresNone={NULL,1,{"default",NULL,NULL}};
+static const DivBenchCores benchCoresOPN2={"ym2612CoreRender",3,{"Nuked-OPN2","ymfm","YMF276-LLE"}};
+static const DivBenchCores benchCoresOPM={"arcadeCoreRender",2,{"ymfm","Nuked-OPM",NULL}};
+static const DivBenchCores benchCoresSN={"snCoreRender",2,{"MAME","Nuked-PSG Mod",NULL}};
+static const DivBenchCores benchCoresNES={"nesCoreRender",2,{"puNES","NSFplay",NULL}};
+static const DivBenchCores benchCoresFDS={"fdsCoreRender",2,{"puNES","NSFplay",NULL}};
+static const DivBenchCores benchCoresC64={"c64CoreRender",3,{"reSID","reSIDfp","dSID"}};
+static const DivBenchCores benchCoresPOKEY={"pokeyCoreRender",2,{"mzpokeysnd","ASAP",NULL}};
+static const DivBenchCores benchCoresOPN={"opn1CoreRender",3,{"ymfm","Nuked-OPN2+ymfm","YM2608-LLE"}};
+static const DivBenchCores benchCoresOPNA={"opnaCoreRender",3,{"ymfm","Nuked-OPN2+ymfm","YM2608-LLE"}};
+static const DivBenchCores benchCoresOPNB={"opnbCoreRender",3,{"ymfm","Nuked-OPN2+ymfm","YM2608-LLE"}};
+static const DivBenchCores benchCoresOPL2={"opl2CoreRender",3,{"Nuked-OPL3","ymfm","YM3812-LLE"}};
+static const DivBenchCores benchCoresOPL3={"opl3CoreRender",3,{"Nuked-OPL3","ymfm","YMF262-LLE"}};
+static const DivBenchCores benchCoresOPL4={"opl4CoreRender",2,{"Nuked-OPL3+openMSX","ymfm",NULL}};
+static const DivBenchCores benchCoresESFM={"esfmCoreRender",2,{"ESFMu","ESFMu (fast)",NULL}};
+static const DivBenchCores benchCoresOPLL={"opllCoreRender",2,{"Nuked-OPLL","emu2413",NULL}};
+static const DivBenchCores benchCoresAY={"ayCoreRender",2,{"MAME","AtomicSSG",NULL}};
+static const DivBenchCores benchCoresSwan={"swanCoreRender",2,{"asiekierka","Mednafen",NULL}};
+
+// this must follow DivDispatchContainer::init()
+static const DivBenchCores& getBenchCores(DivSystem sys) {
+  switch (sys) {
+    case DIV_SYSTEM_YM2612:
+    case DIV_SYSTEM_YM2612_EXT:
+    case DIV_SYSTEM_YM2612_CSM:
+    case DIV_SYSTEM_YM2612_DUALPCM:
+    case DIV_SYSTEM_YM2612_DUALPCM_EXT:
+      return benchCoresOPN2;
+    case DIV_SYSTEM_YM2151:
+      return benchCoresOPM;
+    case DIV_SYSTEM_SMS:
+      return benchCoresSN;
+    case DIV_SYSTEM_NES:
+    case DIV_SYSTEM_5E01:
+      return benchCoresNES;
+    case DIV_SYSTEM_FDS:
+      return benchCoresFDS;
+    case DIV_SYSTEM_C64_6581:
+    case DIV_SYSTEM_C64_8580:
+    case DIV_SYSTEM_C64_PCM:
+      return benchCoresC64;
+    case DIV_SYSTEM_POKEY:
+      return benchCoresPOKEY;
+    case DIV_SYSTEM_YM2203:
+    case DIV_SYSTEM_YM2203_EXT:
+    case DIV_SYSTEM_YM2203_CSM:
+      return benchCoresOPN;
+    case DIV_SYSTEM_YM2608:
+    case DIV_SYSTEM_YM2608_EXT:
+    case DIV_SYSTEM_YM2608_CSM:
+      return benchCoresOPNA;
+    case DIV_SYSTEM_YM2610_FULL:
+    case DIV_SYSTEM_YM2610_FULL_EXT:
+    case DIV_SYSTEM_YM2610_CSM:
+    case DIV_SYSTEM_YM2610B:
+    case DIV_SYSTEM_YM2610B_EXT:
+    case DIV_SYSTEM_YM2610B_CSM:
+      return benchCoresOPNB;
+    case DIV_SYSTEM_OPL:
+    case DIV_SYSTEM_OPL_DRUMS:
+    case DIV_SYSTEM_OPL2:
+    case DIV_SYSTEM_OPL2_DRUMS:
+    case DIV_SYSTEM_Y8950:
+    case DIV_SYSTEM_Y8950_DRUMS:
+      return benchCoresOPL2;
+    case DIV_SYSTEM_OPL3:
+    case DIV_SYSTEM_OPL3_DRUMS:
+      return benchCoresOPL3;
+    case DIV_SYSTEM_OPL4:
+    case DIV_SYSTEM_OPL4_DRUMS:
+      return benchCoresOPL4;
+    case DIV_SYSTEM_ESFM:
+      return benchCoresESFM;
+    case DIV_SYSTEM_OPLL:
+    case DIV_SYSTEM_OPLL_DRUMS:
+    case DIV_SYSTEM_VRC7:
+      return benchCoresOPLL;
+    case DIV_SYSTEM_AY8910:
+      return benchCoresAY;
+    case DIV_SYSTEM_SWAN:
+      return benchCoresSwan;
+    default:
+      break;
+  }
+  return benchCoresNone;
+}
+
+// quote a CSV field if needed
+static String benchCSV(const char* s) {
+  String ret=s;
+  if (ret.find_first_of(",\"")==String::npos) return ret;
+  ret="\"";
+  for (const char* i=s; *i; i++) {
+    if (*i=='"') ret+='"';
+    ret+=*i;
+  }
+  ret+='"';
+  return ret;
+}
+
+static String benchJSON(const char* s) {
+  String ret="\"";
+  for (const char* i=s; *i; i++) {
+    if (*i=='"' || *i=='\\') ret+='\\';
+    ret+=*i;
+  }
+  ret+='"';
+  return ret;
+}
+
+void DivEngine::setUpChipBenchmark(DivSystem sys) {
+  quitDispatch();
+  song.unload();
+  song=DivSong();
+  changeSong(0);
+  song.system[0]=sys;
+  song.system[1]=DIV_SYSTEM_NULL;
+  song.systemLen=1;
+  song.systemName=getSystemName(sys);
+  song.initDefaultSystemChans();
+  song.recalcChans();
+  initDispatch(true);
+
+  // a looped sawtooth for sample-based chips
+  int sampleIndex=addSample();
+  if (sampleIndex>=0) {
+    DivSample* s=song.sample[sampleIndex];
+    s->init(BENCH_SAMPLE_LEN);
+    for (int i=0; i<BENCH_SAMPLE_LEN; i++) {
+      s->data16[i]=((i*64)&0xffff)-0x8000;
+    }
+    s->loop=true;
+    s->loopStart=0;
+    s->loopEnd=BENCH_SAMPLE_LEN;
+    renderSamples();
+  }
+
+  // one instrument per instrument type
+  int insOfType[DIV_INS_MAX];
+  for (int i=0; i<DIV_INS_MAX; i++) {
+    insOfType[i]=-1;
+  }
+  curSubSong->patLen=BENCH_ROWS;
+  curSubSong->ordersLen=1;
+  for (int i=0; i<song.chans; i++) {
+    DivInstrumentType t=getPreferInsType(i);
+    if (t>=DIV_INS_MAX) t=DIV_INS_STD;
+    if (insOfType[t]<0) insOfType[t]=addInstrument(i);
+
+    curSubSong->orders.ord[i][0]=0;
+    DivPattern* p=curSubSong->pat[i].getPattern(0,true);
+    for (int j=0; j<BENCH_ROWS; j+=8) {
+      // C-3 to B-4, different on each channel
+      p->newData[j][DIV_PAT_NOTE]=96+((i*5+j/8*7)%24);
+      p->newData[j][DIV_PAT_INS]=insOfType[t];
+    }
+    // vibrato
+    p->newData[0][DIV_PAT_FX(0)]=0x04;
+    p->newData[0][DIV_PAT_FXVAL(0)]=0x48;
+  }
+  reset();
+}
+
+void DivEngine::benchmarkChips(bool json, double seconds) {
+  float* outBuf[DIV_MAX_OUTPUTS];
+  for (int i=0; i<DIV_MAX_OUTPUTS; i++) {
+    outBuf[i]=new float[BENCH_BUFSIZE];
+  }
+  DivConfig prevConf=conf;
+  size_t frames=(size_t)(seconds*got.rate);
+  bool first=true;
+
+  if (json) {
+    printf("[\n");
+  } else {
+    printf("system,core,channels,frames,seconds,samples_per_second,ns_per_sample,acquire_ns_per_sample\n");
+  }
+
+  for (int i=0; i<DIV_MAX_CHIP_DEFS; i++) {
+    const DivSysDef* def=sysDefs[i];
+    if (def==NULL) continue;
+    if (def->isCompound) continue;
+    DivSystem sys=(DivSystem)i;
+    const DivBenchCores& cores=getBenchCores(sys);
+
+    for (int core=0; core<cores.count; core++) {
+      if (cores.key!=NULL) conf.set(cores.key,core);
+      setUpChipBenchmark(sys);
+
+      curOrder=0;
+      prevOrder=0;
+      remainingLoops=-1;
+      playSub(false);
+      resetProfile();
+
+      size_t done=0;
+      std::chrono::high_resolution_clock::time_point timeStart=std::chrono::high_resolution_clock::now();
+      while (done<frames) {
+        size_t chunk=MIN(frames-done,(size_t)BENCH_BUFSIZE);
+        nextBuf(NULL,outBuf,0,got.outChans,chunk);
+        done+=chunk;
+      }
+      std::chrono::high_resolution_clock::time_point timeEnd=std::chrono::high_resolution_clock::now();
+      playing=false;
+
+      double t=(double)(std::chrono::duration_cast<std::chrono::nanoseconds>(timeEnd-timeStart).count())/1000000000.0;
+      double nsPerSample=(done>0)?(t*1000000000.0/(double)done):0.0;
+      double acquireNsPerSample=(done>0)?((double)profChipTotal[0][DIV_DISPATCH_PROFILE_ACQUIRE]/(double)done):0.0;
+      double samplesPerSecond=(t>0.0)?((double)done/t):0.0;
+
+      if (json) {
+        printf(
+          "%s  {\"system\": %s, \"core\": %s, \"channels\": %d, \"frames\": %zu, \"seconds\": %f, \"samples_per_second\": %f, \"ns_per_sample\": %f, \"acquire_ns_per_sample\": %f}",
+          first?"":",\n",
+          benchJSON(def->name).c_str(),
+          benchJSON(cores.names[core]).c_str(),
+          song.chans,
+          done,
+          t,
+          samplesPerSecond,
+          nsPerSample,
+          acquireNsPerSample
+        );
+      } else {
+        printf(
+          "%s,%s,%d,%zu,%f,%f,%f,%f\n",
+          benchCSV(def->name).c_str(),
+          benchCSV(cores.names[core]).c_str(),
+          song.chans,
+          done,
+          t,
+          samplesPerSecond,
+          nsPerSample,
+          acquireNsPerSample
+        );
+      }
+      fflush(stdout);
+      first=false;
+    }
+  }
+
+  if (json) {
+    printf("\n]\n");
+  }
+
+  conf=prevConf;
+  for (int i=0; i<DIV_MAX_OUTPUTS; i++) {
+    delete[] outBuf[i];
+  }
+}
+
+// peak resident set size in bytes, or -1 if not available
+static long long getPeakRSS() {
+#ifdef _WIN32
+  return -1;
+#else
+  struct rusage ru;
+  if (getrusage(RUSAGE_SELF,&ru)!=0) return -1;
+#ifdef __APPLE__
+  return (long long)ru.ru_maxrss;
+#else
+  return (long long)ru.ru_maxrss*1024;
+#endif
+#endif
+}
+
+// CPU time used by this process in seconds, or -1 if not available
+static double getCPUTime() {
+#ifdef _WIN32
+  return -1.0;
+#else
+  struct rusage ru;
+  if (getrusage(RUSAGE_SELF,&ru)!=0) return -1.0;
+  return (double)(ru.ru_utime.tv_sec+ru.ru_stime.tv_sec)+(double)(ru.ru_utime.tv_usec+ru.ru_stime.tv_usec)/1000000.0;
+#endif
+}
+
+double DivEngine::benchmarkPlayback(bool json) {
+  float* outBuf[2];
+  outBuf[0]=new float[BENCH_BUFSIZE];
+  outBuf[1]=new float[BENCH_BUFSIZE];
+  size_t frames=0;
+
+  curOrder=0;
+  prevOrder=0;
+  remainingLoops=1;
+  playSub(false);
+  resetProfile();
+  DivCounters countersBegin, counters;
+  divCountersRead(countersBegin);
+
+  double cpuStart=getCPUTime();
+  std::chrono::high_resolution_clock::time_point timeStart=std::chrono::high_resolution_clock::now();
+
+  // benchmark
+  while (playing) {
+    nextBuf(NULL,outBuf,0,2,BENCH_BUFSIZE);
+    frames+=totalProcessed;
+  }
+
+  std::chrono::high_resolution_clock::time_point timeEnd=std::chrono::high_resolution_clock::now();
+  double cpuEnd=getCPUTime();
+
+  delete[] outBuf[0];
+  delete[] outBuf[1];
+
+  double t=(double)(std::chrono::duration_cast<std::chrono::microseconds>(timeEnd-timeStart).count())/1000000.0;
+
+  divCountersRead(counters);
+  for (int i=0; i<DIV_COUNTER_MAX; i++) {
+    counters.count[i]-=countersBegin.count[i];
+  }
+  for (int i=0; i<DIV_CMD_MAX; i++) {
+    counters.cmds[i]-=countersBegin.cmds[i];
+  }
+  // song time, for rates
+  double songSeconds=(double)frames/MAX(1.0,(double)got.rate);
+
+  if (json) {
+    // times in ms, like the breakdown below
+    printf("{\n");
+    printf("  \"song\": %s,\n",benchJSON(song.name.c_str()).c_str());
+    printf("  \"rate\": %d,\n",(int)got.rate);
+    printf("  \"frames\": %zu,\n",frames);
+    printf("  \"buffers\": %llu,\n",profBuffers);
+    printf("  \"wall_seconds\": %f,\n",t);
+    if (cpuStart>=0.0 && cpuEnd>=0.0) {
+      printf("  \"cpu_seconds\": %f,\n",cpuEnd-cpuStart);
+    } else {
+      printf("  \"cpu_seconds\": null,\n");
+    }
+    printf("  \"stages\": {");
+    for (int i=0; i<DIV_PROFILE_MAX; i++) {
+      printf("%s%s: %f",(i>0)?", ":"",benchJSON(getProfileStageName(i)).c_str(),(double)profTotal[i]/1000000.0);
+    }
+    printf("},\n");
+    printf("  \"counters\": {");
+    for (int i=0; i<DIV_COUNTER_MAX; i++) {
+      printf("%s%s: %llu",(i>0)?", ":"",benchJSON(divCounterName(i)).c_str(),counters.count[i]);
+    }
+    printf("},\n");
+    // only the commands which were used
+    bool firstCmd=true;
+    printf("  \"commands\": {");
+    for (int i=0; i<DIV_CMD_MAX; i++) {
+      if (counters.cmds[i]==0) continue;
+      printf("%s%s: %llu",firstCmd?"":", ",benchJSON(cmdName[i]).c_str(),counters.cmds[i]);
+      firstCmd=false;
+    }
+    printf("},\n");
+    printf("  \"chips\": [");
+    for (int i=0; i<song.systemLen; i++) {
+      printf("%s\n    {\"system\": %s",(i>0)?",":"",benchJSON(getSystemName(song.system[i])).c_str());
+      for (int j=0; j<DIV_DISPATCH_PROFILE_MAX; j++) {
+        printf(", %s: %f",benchJSON(getDispatchProfileStageName(j)).c_str(),(double)profChipTotal[i][j]/1000000.0);
+      }
+      printf(", \"register writes\": %llu, \"blip deltas\": %llu",profChipWrites[i],profChipDeltas[i]);
+      printf("}");
+    }
+    printf("\n  ]\n}\n");
+    fflush(stdout);
+    return t;
+  }
+
+  printf("[RESULT] %fs\n",t);
+  if (cpuStart>=0.0 && cpuEnd>=0.0) {
+    printf("[RESULT] CPU time: %fs\n",cpuEnd-cpuStart);
+  }
+
+  // print a breakdown
+  double profSum=MAX(1.0,(double)profTotal[DIV_PROFILE_TOTAL]);
+  printf("\n%-24s %12s %8s\n","stage","time (ms)","share");
+  for (int i=0; i<DIV_PROFILE_MAX; i++) {
+    printf("%-24s %12.3f %7.2f%%\n",getProfileStageName(i),(double)profTotal[i]/1000000.0,100.0*(double)profTotal[i]/profSum);
+  }
+  printf("\n%-3s %-24s","#","chip");
+  for (int j=0; j<DIV_DISPATCH_PROFILE_MAX; j++) {
+    printf(" %12s",getDispatchProfileStageName(j));
+  }
+  printf(" %8s\n","share");
+  for (int i=0; i<song.systemLen; i++) {
+    unsigned long long chipSum=0;
+    printf("%-3d %-24s",i+1,getSystemName(song.system[i]));
+    for (int j=0; j<DIV_DISPATCH_PROFILE_MAX; j++) {
+      printf(" %12.3f",(double)profChipTotal[i][j]/1000000.0);
+      chipSum+=profChipTotal[i][j];
+    }
+    printf(" %7.2f%%\n",100.0*(double)chipSum/profSum);
+  }
+  printf("(%llu buffers, times in ms)\n",profBuffers);
+
+  printf("\n%-24s %14s %14s\n","counter","total","per second");
+  for (int i=0; i<DIV_COUNTER_MAX; i++) {
+    printf("%-24s %14llu %14.0f\n",divCounterName(i),counters.count[i],(double)counters.count[i]/MAX(0.001,songSeconds));
+  }
+  printf("(per second of song)\n");
+  return t;
+}
+
+// run a task BENCH_FILE_ITERATIONS times and print the results.
+// the task returns false on error.
+template<typename T> static double runFileBenchmark(const char* name, T task) {
+  double t[BENCH_FILE_ITERATIONS];
+#ifdef DIV_RT_CHECK
+  unsigned long long allocs=0;
+  unsigned long long allocBytes=0;
+#endif
+
+  for (int i=0; i<BENCH_FILE_ITERATIONS; i++) {
+#ifdef DIV_RT_CHECK
+    unsigned long long countBefore, bytesBefore, countAfter, bytesAfter;
+    divAllocStats(countBefore,bytesBefore);
+#endif
+    std::chrono::high_resolution_clock::time_point timeStart=std::chrono::high_resolution_clock::now();
+    bool ok=task();
+    std::chrono::high_resolution_clock::time_point timeEnd=std::chrono::high_resolution_clock::now();
+#ifdef DIV_RT_CHECK
+    divAllocStats(countAfter,bytesAfter);
+    allocs+=countAfter-countBefore;
+    allocBytes+=bytesAfter-bytesBefore;
+#endif
+    if (!ok) {
+      logE("%s benchmark failed!",name);
+      return -1.0;
+    }
+    t[i]=(double)(std::chrono::duration_cast<std::chrono::microseconds>(timeEnd-timeStart).count())/1000000.0;
+    printf("[#%d] %fs\n",i+1,t[i]);
+  }
+
+  double tMin=DBL_MAX;
+  double tMax=0.0;
+  double tAvg=0.0;
+  for (int i=0; i<BENCH_FILE_ITERATIONS; i++) {
+    if (t[i]<tMin) tMin=t[i];
+    if (t[i]>tMax) tMax=t[i];
+    tAvg+=t[i];
+  }
+  tAvg/=BENCH_FILE_ITERATIONS;
+
+  printf("[RESULT] %s: min %fs max %fs average %fs\n",name,tMin,tMax,tAvg);
+  long long peakRSS=getPeakRSS();
+  if (peakRSS>=0) {
+    printf("[RESULT] peak RSS: %lld KB\n",peakRSS/1024);
+  } else {
+    printf("[RESULT] peak RSS: not available\n");
+  }
+#ifdef DIV_RT_CHECK
+  printf("[RESULT] allocations per iteration: %llu (%llu bytes)\n",allocs/BENCH_FILE_ITERATIONS,allocBytes/BENCH_FILE_ITERATIONS);
+#else
+  printf("[RESULT] allocations per iteration: not available (build with WITH_RT_CHECK)\n");
+#endif
+  return tAvg;
+}
+
+// discards the output of a save/export function
+static bool finishBenchWriter(SafeWriter* w) {
+  if (w==NULL) return false;
+  w->finish();
+  delete w;
+  return true;
+}
+
+double DivEngine::benchmarkLoad(const char* path) {
+  FILE* f=ps_fopen(path,"rb");
+  if (f==NULL) {
+    logE("could not open file!");
+    return -1.0;
+  }
+  std::vector<unsigned char> data;
+  unsigned char buf[4096];
+  size_t got;
+  while ((got=fread(buf,1,4096,f))>0) {
+    data.insert(data.end(),buf,buf+got);
+  }
+  fclose(f);
+  if (data.empty()) {
+    logE("that file is empty!");
+    return -1.0;
+  }
+
+  return runFileBenchmark("load",[this,&data,path]() -> bool {
+    // load() takes ownership of its buffer
+    unsigned char* copy=new unsigned char[data.size()];
+    memcpy(copy,data.data(),data.size());
+    return load(copy,data.size(),path);
+  });
+}
+
+double DivEngine::benchmarkSave() {
+  return runFileBenchmark("save",[this]() -> bool {
+    return finishBenchWriter(saveFur());
+  });
+}
+
+double DivEngine::benchmarkVGM() {
+  return runFileBenchmark("VGM export",[this]() -> bool {
+    return finishBenchWriter(saveVGM());
+  });
+}
+
+double DivEngine::benchmarkCommand() {
+  return runFileBenchmark("command stream export",[this]() -> bool {
+    return finishBenchWriter(saveCommand());
+  });
+}
+
+double DivEngine::benchmarkCommandPlayer(double seconds) {
+  SafeWriter* w=saveCommand();
+  if (w==NULL) {
+    logE("could not export command stream!");
+    return -1.0;
+  }
+  // playStream() takes ownership of the buffer
+  size_t len=w->size();
+  if (!playStream(w->getFinalBuf(),len)) {
+    delete w;
+    return -1.0;
+  }
+  w->disown();
+  delete w;
+
+  // tick the player directly, without rendering audio
+  unsigned long long ticks=0;
+  std::chrono::high_resolution_clock::time_point timeStart=std::chrono::high_resolution_clock::now();
+  std::chrono::high_resolution_clock::time_point timeEnd=timeStart;
+  double t=0.0;
+  while (t<seconds) {
+    for (int i=0; i<256; i++) {
+      cmdStreamInt->tick();
+    }
+    ticks+=256;
+    timeEnd=std::chrono::high_resolution_clock::now();
+    t=(double)(std::chrono::duration_cast<std::chrono::microseconds>(timeEnd-timeStart).count())/1000000.0;
+  }
+  unsigned long long ops=cmdStreamInt->getOpCount();
+  killStream();
+
+  printf("[RESULT] stream size: %zu bytes\n",len);
+  printf("[RESULT] %llu ticks, %llu commands in %fs\n",ticks,ops,t);
+  printf("[RESULT] %f ticks/s, %f commands/s\n",(double)ticks/t,(double)ops/t);
+  return t;
+}
+
+double DivEngine::benchmarkText() {
+  return runFileBenchmark("text export",[this]() -> bool {
+    return finishBenchWriter(saveText(false));
+  });
+}
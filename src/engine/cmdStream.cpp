@@ -48,6 +48,7 @@ size_t DivCSPlayer::getDataLen() {
 }
 
 DivCSChannelState* DivCSPlayer::getChanState(int ch) {
+  if (ch<0 || ch>=(int)chan.size()) return NULL;
   return &chan[ch];
 }
 
@@ -75,6 +76,14 @@ unsigned int DivCSPlayer::getCurTick() {
   return curTick;
 }
 
+unsigned long long DivCSPlayer::getOpCount() {
+  return opCount;
+}
+
+void DivCSPlayer::setTracing(bool enable) {
+  tracing=enable;
+}
+
 void DivCSPlayer::cleanup() {
   delete[] b;
   b=NULL;
@@ -84,11 +93,385 @@ void DivCSPlayer::cleanup() {
     delete[] bAccessTS;
     bAccessTS=NULL;
   }
+
+  if (ops) {
+    delete[] ops;
+    ops=NULL;
+  }
+}
+
+bool DivCSPlayer::decodeOp(unsigned int pos, DivCSOp& o) {
+  if (!stream.seek(pos,SEEK_SET)) return false;
+
+  o.cmd=0;
+  o.arg0=0;
+  o.arg1=0;
+
+  try {
+    unsigned char next=stream.readC();
+    o.op=next;
+
+    if (next<0xb3) { // note
+      o.arg0=(int)next-60;
+    } else if (next>=0xf0) { // preset delay
+      o.arg0=fastDelays[next&15];
+    } else switch (next) {
+      case 0xb8:
+        o.cmd=DIV_CMD_INSTRUMENT;
+        break;
+      case 0xc0:
+        o.cmd=DIV_CMD_PRE_PORTA;
+        break;
+      case 0xc1: // arp time
+      case 0xc2: // vibrato
+      case 0xc3: // vibrato range
+      case 0xc4: // vibrato shape
+      case 0xc6: // arpeggio
+      case 0xc7: // volume
+      case 0xcc: // tremolo
+      case 0xcd: // panbrello
+      case 0xdd: // wait
+        o.arg0=(unsigned char)stream.readC();
+        break;
+      case 0xc5: // pitch
+      case 0xce: // pan slide
+        o.arg0=(signed char)stream.readC();
+        break;
+      case 0xc8: // vol slide
+        o.arg0=(short)(bigEndian?stream.readS_BE():stream.readS());
+        break;
+      case 0xc9: // porta
+        o.arg0=(int)((unsigned char)stream.readC())-60;
+        o.arg1=(unsigned char)stream.readC();
+        break;
+      case 0xca: // legato
+        o.arg0=(unsigned char)stream.readC();
+        if (o.arg0==0xff) {
+          o.arg0=DIV_NOTE_NULL;
+        } else {
+          o.arg0-=60;
+        }
+        break;
+      case 0xcb: // vol slide target
+        o.arg0=(short)(bigEndian?stream.readS_BE():stream.readS());
+        o.arg1=(short)(bigEndian?stream.readS_BE():stream.readS());
+        break;
+      case 0xcf: // panning
+        o.arg0=(unsigned char)stream.readC();
+        o.arg1=(unsigned char)stream.readC();
+        break;
+      case 0xe0: case 0xe1: case 0xe2: case 0xe3: case 0xe4: case 0xe5:
+        o.arg0=fastIns[next-0xe0];
+        break;
+      case 0xe6: case 0xe7: case 0xe8: case 0xe9: case 0xea: case 0xeb:
+        o.arg0=fastVols[next-0xe6]<<8;
+        break;
+      case 0xec: case 0xed: case 0xee: case 0xef:
+        o.cmd=fastCmds[next&3];
+        break;
+      case 0xd0: // placeholder
+        stream.readC();
+        stream.readC();
+        stream.readC();
+        break;
+      case 0xd7:
+        o.cmd=(unsigned char)stream.readC();
+        break;
+      case 0xd8: // call
+        o.arg0=bigEndian?((unsigned short)stream.readS_BE()):((unsigned short)stream.readS());
+        break;
+      case 0xd5: // call (long)
+      case 0xda: // jump
+        o.arg0=bigEndian?stream.readI_BE():stream.readI();
+        break;
+      case 0xdb: // rate
+        stream.readI();
+        break;
+      case 0xdc: // wait (short)
+        o.arg0=(unsigned short)(bigEndian?stream.readS_BE():stream.readS());
+        break;
+    }
+
+    if (o.cmd) {
+      switch (o.cmd) {
+        case DIV_CMD_INSTRUMENT:
+          o.arg0=(unsigned char)stream.readC();
+          break;
+        case DIV_CMD_PRE_PORTA:
+          o.arg0=(unsigned char)stream.readC();
+          o.arg1=(o.arg0&0x40)?1:0;
+          o.arg0=(o.arg0&0x80)?1:0;
+          break;
+        // ONE BYTE COMMANDS
+        case DIV_CMD_SAMPLE_MODE:
+        case DIV_CMD_SAMPLE_FREQ:
+        case DIV_CMD_SAMPLE_BANK:
+        case DIV_CMD_SAMPLE_DIR:
+        case DIV_CMD_FM_HARD_RESET:
+        case DIV_CMD_FM_LFO:
+        case DIV_CMD_FM_LFO_WAVE:
+        case DIV_CMD_FM_LFO2:
+        case DIV_CMD_FM_LFO2_WAVE:
+        case DIV_CMD_FM_FB:
+        case DIV_CMD_FM_EXTCH:
+        case DIV_CMD_FM_AM_DEPTH:
+        case DIV_CMD_FM_PM_DEPTH:
+        case DIV_CMD_STD_NOISE_FREQ:
+        case DIV_CMD_STD_NOISE_MODE:
+        case DIV_CMD_WAVE:
+        case DIV_CMD_GB_SWEEP_TIME:
+        case DIV_CMD_GB_SWEEP_DIR:
+        case DIV_CMD_PCE_LFO_MODE:
+        case DIV_CMD_PCE_LFO_SPEED:
+        case DIV_CMD_NES_DMC:
+        case DIV_CMD_C64_CUTOFF:
+        case DIV_CMD_C64_RESONANCE:
+        case DIV_CMD_C64_FILTER_MODE:
+        case DIV_CMD_C64_RESET_TIME:
+        case DIV_CMD_C64_RESET_MASK:
+        case DIV_CMD_C64_FILTER_RESET:
+        case DIV_CMD_C64_DUTY_RESET:
+        case DIV_CMD_C64_EXTENDED:
+        case DIV_CMD_AY_ENVELOPE_SET:
+        case DIV_CMD_AY_ENVELOPE_LOW:
+        case DIV_CMD_AY_ENVELOPE_HIGH:
+        case DIV_CMD_AY_ENVELOPE_SLIDE:
+        case DIV_CMD_AY_NOISE_MASK_AND:
+        case DIV_CMD_AY_NOISE_MASK_OR:
+        case DIV_CMD_AY_AUTO_ENVELOPE:
+        case DIV_CMD_FDS_MOD_DEPTH:
+        case DIV_CMD_FDS_MOD_HIGH:
+        case DIV_CMD_FDS_MOD_LOW:
+        case DIV_CMD_FDS_MOD_POS:
+        case DIV_CMD_FDS_MOD_WAVE:
+        case DIV_CMD_SAA_ENVELOPE:
+        case DIV_CMD_AMIGA_FILTER:
+        case DIV_CMD_AMIGA_AM:
+        case DIV_CMD_AMIGA_PM:
+        case DIV_CMD_MACRO_OFF:
+        case DIV_CMD_MACRO_ON:
+        case DIV_CMD_MACRO_RESTART:
+        case DIV_CMD_QSOUND_ECHO_FEEDBACK:
+        case DIV_CMD_QSOUND_ECHO_LEVEL:
+        case DIV_CMD_QSOUND_SURROUND:
+        case DIV_CMD_X1_010_ENVELOPE_SHAPE:
+        case DIV_CMD_X1_010_ENVELOPE_ENABLE:
+        case DIV_CMD_X1_010_ENVELOPE_MODE:
+        case DIV_CMD_X1_010_ENVELOPE_PERIOD:
+        case DIV_CMD_X1_010_ENVELOPE_SLIDE:
+        case DIV_CMD_X1_010_AUTO_ENVELOPE:
+        case DIV_CMD_X1_010_SAMPLE_BANK_SLOT:
+        case DIV_CMD_WS_SWEEP_TIME:
+        case DIV_CMD_WS_SWEEP_AMOUNT:
+        case DIV_CMD_N163_WAVE_UNUSED1:
+        case DIV_CMD_N163_WAVE_UNUSED2:
+        case DIV_CMD_N163_WAVE_LOADPOS:
+        case DIV_CMD_N163_WAVE_LOADLEN:
+        case DIV_CMD_N163_WAVE_UNUSED3:
+        case DIV_CMD_N163_CHANNEL_LIMIT:
+        case DIV_CMD_N163_GLOBAL_WAVE_LOAD:
+        case DIV_CMD_N163_GLOBAL_WAVE_LOADPOS:
+        case DIV_CMD_N163_UNUSED4:
+        case DIV_CMD_N163_UNUSED5:
+        case DIV_CMD_SU_SYNC_PERIOD_LOW:
+        case DIV_CMD_SU_SYNC_PERIOD_HIGH:
+        case DIV_CMD_ADPCMA_GLOBAL_VOLUME:
+        case DIV_CMD_SNES_ECHO:
+        case DIV_CMD_SNES_PITCH_MOD:
+        case DIV_CMD_SNES_INVERT:
+        case DIV_CMD_SNES_GAIN_MODE:
+        case DIV_CMD_SNES_GAIN:
+        case DIV_CMD_SNES_ECHO_ENABLE:
+        case DIV_CMD_SNES_ECHO_DELAY:
+        case DIV_CMD_SNES_ECHO_VOL_LEFT:
+        case DIV_CMD_SNES_ECHO_VOL_RIGHT:
+        case DIV_CMD_SNES_ECHO_FEEDBACK:
+        case DIV_CMD_NES_ENV_MODE:
+        case DIV_CMD_NES_LENGTH:
+        case DIV_CMD_NES_COUNT_MODE:
+        case DIV_CMD_FM_AM2_DEPTH:
+        case DIV_CMD_FM_PM2_DEPTH:
+        case DIV_CMD_ES5506_ENVELOPE_LVRAMP:
+        case DIV_CMD_ES5506_ENVELOPE_RVRAMP:
+        case DIV_CMD_ES5506_PAUSE:
+        case DIV_CMD_ES5506_FILTER_MODE:
+        case DIV_CMD_SNES_GLOBAL_VOL_LEFT:
+        case DIV_CMD_SNES_GLOBAL_VOL_RIGHT:
+        case DIV_CMD_NES_LINEAR_LENGTH:
+        case DIV_CMD_EXTERNAL:
+        case DIV_CMD_C64_AD:
+        case DIV_CMD_C64_SR:
+        case DIV_CMD_DAVE_HIGH_PASS:
+        case DIV_CMD_DAVE_RING_MOD:
+        case DIV_CMD_DAVE_SWAP_COUNTERS:
+        case DIV_CMD_DAVE_LOW_PASS:
+        case DIV_CMD_DAVE_CLOCK_DIV:
+        case DIV_CMD_MINMOD_ECHO:
+        case DIV_CMD_FDS_MOD_AUTO:
+        case DIV_CMD_FM_OPMASK:
+        case DIV_CMD_MULTIPCM_MIX_FM:
+        case DIV_CMD_MULTIPCM_MIX_PCM:
+        case DIV_CMD_MULTIPCM_LFO:
+        case DIV_CMD_MULTIPCM_VIB:
+        case DIV_CMD_MULTIPCM_AM:
+        case DIV_CMD_MULTIPCM_AR:
+        case DIV_CMD_MULTIPCM_D1R:
+        case DIV_CMD_MULTIPCM_DL:
+        case DIV_CMD_MULTIPCM_D2R:
+        case DIV_CMD_MULTIPCM_RC:
+        case DIV_CMD_MULTIPCM_RR:
+        case DIV_CMD_MULTIPCM_DAMP:
+        case DIV_CMD_MULTIPCM_PSEUDO_REVERB:
+        case DIV_CMD_MULTIPCM_LFO_RESET:
+        case DIV_CMD_MULTIPCM_LEVEL_DIRECT:
+        case DIV_CMD_SID3_SPECIAL_WAVE:
+        case DIV_CMD_SID3_RING_MOD_SRC:
+        case DIV_CMD_SID3_HARD_SYNC_SRC:
+        case DIV_CMD_SID3_PHASE_MOD_SRC:
+        case DIV_CMD_SID3_WAVE_MIX:
+        case DIV_CMD_SID3_1_BIT_NOISE:
+        case DIV_CMD_SID3_CHANNEL_INVERSION:
+        case DIV_CMD_SID3_FILTER_CONNECTION:
+        case DIV_CMD_SID3_FILTER_MATRIX:
+        case DIV_CMD_SID3_FILTER_ENABLE:
+        case DIV_CMD_SID3_PHASE_RESET:
+        case DIV_CMD_SID3_NOISE_PHASE_RESET:
+        case DIV_CMD_SID3_ENVELOPE_RESET:
+        case DIV_CMD_SID3_CUTOFF_SCALING:
+        case DIV_CMD_SID3_RESONANCE_SCALING:
+        case DIV_CMD_WS_GLOBAL_SPEAKER_VOLUME:
+        case DIV_CMD_FM_ALG:
+        case DIV_CMD_FM_FMS:
+        case DIV_CMD_FM_AMS:
+        case DIV_CMD_FM_FMS2:
+        case DIV_CMD_FM_AMS2:
+          o.arg0=(unsigned char)stream.readC();
+          break;
+        // TWO BYTE COMMANDS
+        case DIV_CMD_FM_TL:
+        case DIV_CMD_FM_AM:
+        case DIV_CMD_FM_AR:
+        case DIV_CMD_FM_DR:
+        case DIV_CMD_FM_SL:
+        case DIV_CMD_FM_D2R:
+        case DIV_CMD_FM_RR:
+        case DIV_CMD_FM_DT:
+        case DIV_CMD_FM_DT2:
+        case DIV_CMD_FM_RS:
+        case DIV_CMD_FM_KSR:
+        case DIV_CMD_FM_VIB:
+        case DIV_CMD_FM_SUS:
+        case DIV_CMD_FM_WS:
+        case DIV_CMD_FM_SSG:
+        case DIV_CMD_FM_REV:
+        case DIV_CMD_FM_EG_SHIFT:
+        case DIV_CMD_FM_MULT:
+        case DIV_CMD_FM_FINE:
+        case DIV_CMD_AY_IO_WRITE:
+        case DIV_CMD_AY_AUTO_PWM:
+        case DIV_CMD_SURROUND_PANNING:
+        case DIV_CMD_SU_SWEEP_PERIOD_LOW:
+        case DIV_CMD_SU_SWEEP_PERIOD_HIGH:
+        case DIV_CMD_SU_SWEEP_BOUND:
+        case DIV_CMD_SU_SWEEP_ENABLE:
+        case DIV_CMD_SNES_ECHO_FIR:
+        case DIV_CMD_ES5506_FILTER_K1_SLIDE:
+        case DIV_CMD_ES5506_FILTER_K2_SLIDE:
+        case DIV_CMD_ES5506_ENVELOPE_K1RAMP:
+        case DIV_CMD_ES5506_ENVELOPE_K2RAMP:
+        case DIV_CMD_ESFM_OP_PANNING:
+        case DIV_CMD_ESFM_OUTLVL:
+        case DIV_CMD_ESFM_MODIN:
+        case DIV_CMD_ESFM_ENV_DELAY:
+        case DIV_CMD_POWERNOISE_COUNTER_LOAD:
+        case DIV_CMD_POWERNOISE_IO_WRITE:
+        case DIV_CMD_BIFURCATOR_STATE_LOAD:
+        case DIV_CMD_BIFURCATOR_PARAMETER:
+        case DIV_CMD_SID3_LFSR_FEEDBACK_BITS:
+        case DIV_CMD_SID3_FILTER_DISTORTION:
+        case DIV_CMD_SID3_FILTER_OUTPUT_VOLUME:
+        case DIV_CMD_C64_PW_SLIDE:
+        case DIV_CMD_C64_CUTOFF_SLIDE:
+        case DIV_CMD_N163_WAVE_POSITION:
+        case DIV_CMD_N163_WAVE_LENGTH:
+          o.arg0=(unsigned char)stream.readC();
+          o.arg1=(unsigned char)stream.readC();
+          break;
+        // ONE SHORT COMMANDS
+        case DIV_CMD_C64_FINE_DUTY:
+        case DIV_CMD_C64_FINE_CUTOFF:
+        case DIV_CMD_LYNX_LFSR_LOAD:
+        case DIV_CMD_QSOUND_ECHO_DELAY:
+        case DIV_CMD_ES5506_ENVELOPE_COUNT:
+          o.arg0=(unsigned short)(bigEndian?stream.readS_BE():stream.readS());
+          break;
+        // TWO SHORT COMMANDS
+        case DIV_CMD_ES5506_FILTER_K1:
+        case DIV_CMD_ES5506_FILTER_K2:
+          o.arg0=(unsigned short)(bigEndian?stream.readS_BE():stream.readS());
+          o.arg1=(unsigned short)(bigEndian?stream.readS_BE():stream.readS());
+          break;
+        case DIV_CMD_FM_FIXFREQ:
+          o.arg0=(unsigned short)(bigEndian?stream.readS_BE():stream.readS());
+          o.arg1=o.arg0&0x7ff;
+          o.arg0>>=12;
+          break;
+        case DIV_CMD_NES_SWEEP:
+          o.arg0=(unsigned char)stream.readC();
+          o.arg1=o.arg0&0x77;
+          o.arg0=(o.arg0&8)?1:0;
+          break;
+        case DIV_CMD_SAMPLE_POS:
+          o.arg0=(unsigned int)(bigEndian?stream.readI_BE():stream.readI());
+          break;
+      }
+    }
+  } catch (EndOfFileException& ex) {
+    return false;
+  }
+
+  o.len=stream.tell()-pos;
+  return true;
+}
+
+void DivCSPlayer::decodeAll() {
+  // follow the code from every channel's start position, so that data
+  // which is never executed does not get decoded.
+  std::vector<unsigned int> pending;
+  for (size_t i=0; i<chan.size(); i++) {
+    if (chan[i].readPos!=0) pending.push_back(chan[i].readPos);
+  }
+  while (!pending.empty()) {
+    unsigned int pos=pending.back();
+    pending.pop_back();
+    if (pos==0 || pos>=bLen) continue;
+    if (ops[pos].len) continue;
+    if (!decodeOp(pos,ops[pos])) continue;
+
+    DivCSOp& o=ops[pos];
+    switch (o.op) {
+      case 0xd8: case 0xd5: // call
+        pending.push_back(o.arg0);
+        pending.push_back(pos+o.len);
+        break;
+      case 0xda: // jump
+        pending.push_back(o.arg0);
+        break;
+      case 0xd4: case 0xd9: case 0xdf: // callsym, ret, stop
+        break;
+      case 0xb3: case 0xb9: case 0xba: case 0xbb: case 0xbc: case 0xbd: case 0xbe: case 0xbf:
+      case 0xd2: case 0xd3: // illegal
+        break;
+      default:
+        pending.push_back(pos+o.len);
+        break;
+    }
+  }
 }
 
 bool DivCSPlayer::tick() {
   bool ticked=false;
-  for (int i=0; i<e->getTotalChannelCount(); i++) {
+  for (int i=0; i<(int)chan.size(); i++) {
     bool sendVolume=false;
     bool sendPitch=false;
     if (chan[i].readPos==0) continue;
@@ -97,31 +480,45 @@ bool DivCSPlayer::tick() {
 
     chan[i].waitTicks--;
     while (chan[i].waitTicks<=0) {
-      if (!stream.seek(chan[i].readPos,SEEK_SET)) {
-        logE("%d: access violation! $%x",i,chan[i].readPos);
+      unsigned int pos=chan[i].readPos;
+      if (pos>=bLen) {
+        logE("%d: access violation! $%x",i,pos);
         chan[i].readPos=0;
         break;
       }
+      DivCSOp& o=ops[pos];
+      if (!o.len) {
+        // not reached by decodeAll()
+        if (!decodeOp(pos,o)) {
+          o.len=0;
+          logE("%d: access violation! $%x",i,pos);
+          chan[i].readPos=0;
+          break;
+        }
+      }
+      opCount++;
 
-      unsigned int accessTSBegin=stream.tell();
-
-      chan[i].trace[chan[i].tracePos++]=chan[i].readPos;
-      if (chan[i].tracePos>=DIV_MAX_CSTRACE) {
-        chan[i].tracePos=0;
+      if (tracing) {
+        chan[i].trace[chan[i].tracePos++]=pos;
+        if (chan[i].tracePos>=DIV_MAX_CSTRACE) {
+          chan[i].tracePos=0;
+        }
+        for (unsigned int j=pos; j<pos+o.len && j<bLen; j++) {
+          bAccessTS[j]=curTick;
+        }
       }
 
-      unsigned char next=stream.readC();
-      unsigned char command=0;
-      bool mustTell=true;
+      unsigned char next=o.op;
+      chan[i].readPos=pos+o.len;
 
       if (next<0xb3) { // note
-        e->dispatchCmd(DivCommand(DIV_CMD_NOTE_ON,i,(int)next-60));
-        chan[i].note=(int)next-60;
+        e->dispatchCmd(DivCommand(DIV_CMD_NOTE_ON,i,o.arg0));
+        chan[i].note=o.arg0;
         chan[i].vibratoPos=0;
       } else if (next>=0xf0) { // preset delay
-        chan[i].waitTicks=fastDelays[next&15];
+        chan[i].waitTicks=o.arg0;
         chan[i].lastWaitLen=chan[i].waitTicks;
-        bAccessTS[fastDelaysOff+(next&15)]=curTick;
+        if (tracing) bAccessTS[fastDelaysOff+(next&15)]=curTick;
       } else switch (next) {
         case 0xb4: // note on null
           e->dispatchCmd(DivCommand(DIV_CMD_NOTE_ON,i,DIV_NOTE_NULL));
@@ -136,70 +533,53 @@ bool DivCSPlayer::tick() {
         case 0xb7: // env release
           e->dispatchCmd(DivCommand(DIV_CMD_ENV_RELEASE,i));
           break;
-        case 0xb8:
-          command=DIV_CMD_INSTRUMENT;
-          break;
-        case 0xc0:
-          command=DIV_CMD_PRE_PORTA;
+        case 0xb8: case 0xc0: case 0xd7:
           break;
         case 0xc1: // arp time
-          arpSpeed=(unsigned char)stream.readC();
+          arpSpeed=o.arg0;
           break;
-        case 0xc2: { // vibrato
-          unsigned char param=stream.readC();
-          chan[i].vibratoDepth=param&15;
-          chan[i].vibratoRate=param>>4;
+        case 0xc2: // vibrato
+          chan[i].vibratoDepth=o.arg0&15;
+          chan[i].vibratoRate=o.arg0>>4;
           sendPitch=true;
           break;
-        }
         case 0xc3: // vibrato range
-          chan[i].vibratoRange=(unsigned char)stream.readC();
+          chan[i].vibratoRange=o.arg0;
           break;
         case 0xc4: // vibrato shape
-          chan[i].vibratoShape=(unsigned char)stream.readC();
+          chan[i].vibratoShape=o.arg0;
           break;
         case 0xc5: // pitch
-          chan[i].pitch=(signed char)stream.readC();
+          chan[i].pitch=o.arg0;
           sendPitch=true;
           break;
         case 0xc6: // arpeggio
-          chan[i].arp=(unsigned char)stream.readC();
+          chan[i].arp=o.arg0;
           break;
         case 0xc7: // volume
-          chan[i].volume=((unsigned char)stream.readC())<<8;
+          chan[i].volume=o.arg0<<8;
           sendVolume=true;
           break;
         case 0xc8: // vol slide
-          chan[i].volSpeed=(short)(bigEndian?stream.readS_BE():stream.readS());
+          chan[i].volSpeed=o.arg0;
           chan[i].volSpeedTarget=-1;
           chan[i].tremoloDepth=0;
           break;
         case 0xc9: // porta
-          chan[i].portaTarget=(int)((unsigned char)stream.readC())-60;
-          chan[i].portaSpeed=(unsigned char)stream.readC();
+          chan[i].portaTarget=o.arg0;
+          chan[i].portaSpeed=o.arg1;
           break;
-        case 0xca: { // legato
-          int arg0=(unsigned char)stream.readC();
-          if (arg0==0xff) {
-            arg0=DIV_NOTE_NULL;
-          } else {
-            arg0-=60;
-          }
-          chan[i].note=arg0;
+        case 0xca: // legato
+          chan[i].note=o.arg0;
           e->dispatchCmd(DivCommand(DIV_CMD_LEGATO,i,chan[i].note));
           break;
-        }
-        case 0xcb: { // vol slide target
-          int arg0=(short)(bigEndian?stream.readS_BE():stream.readS());
-          int arg1=(short)(bigEndian?stream.readS_BE():stream.readS());
-          chan[i].volSpeed=arg0;
-          chan[i].volSpeedTarget=arg0==0 ? -1 : arg1;
+        case 0xcb: // vol slide target
+          chan[i].volSpeed=o.arg0;
+          chan[i].volSpeedTarget=o.arg0==0 ? -1 : o.arg1;
           break;
-        }
-        case 0xcc: { // tremolo
-          unsigned char param=stream.readC();
-          chan[i].tremoloDepth=param&15;
-          chan[i].tremoloRate=param>>4;
+        case 0xcc: // tremolo
+          chan[i].tremoloDepth=o.arg0&15;
+          chan[i].tremoloRate=o.arg0>>4;
           if (chan[i].tremoloDepth==0) {
             chan[i].tremoloPos=0;
           }
@@ -207,20 +587,17 @@ bool DivCSPlayer::tick() {
           chan[i].volSpeedTarget=-1;
           sendVolume=true;
           break;
-        }
-        case 0xcd: { // panbrello
-          unsigned char param=stream.readC();
-          chan[i].panbrelloDepth=param&15;
-          chan[i].panbrelloRate=param>>4;
+        case 0xcd: // panbrello
+          chan[i].panbrelloDepth=o.arg0&15;
+          chan[i].panbrelloRate=o.arg0>>4;
           if (chan[i].panbrelloDepth==0) {
             chan[i].panbrelloPos=0;
           } else {
             chan[i].panSpeed=0;
           }
           break;
-        }
         case 0xce: // pan slide
-          chan[i].panSpeed=stream.readC();
+          chan[i].panSpeed=o.arg0;
           if (chan[i].panSpeed) {
             // panbrello and slides are incompatible
             chan[i].panbrelloDepth=0;
@@ -228,29 +605,24 @@ bool DivCSPlayer::tick() {
             chan[i].panbrelloPos=0;
           }
           break;
-        case 0xcf: { // panning
-          chan[i].panL=(unsigned char)stream.readC();
-          chan[i].panR=(unsigned char)stream.readC();
+        case 0xcf: // panning
+          chan[i].panL=o.arg0;
+          chan[i].panR=o.arg1;
           e->dispatchCmd(DivCommand(DIV_CMD_PANNING,i,chan[i].panL,chan[i].panR));
           break;
-        }
         case 0xe0: case 0xe1: case 0xe2: case 0xe3: case 0xe4: case 0xe5:
-          e->dispatchCmd(DivCommand(DIV_CMD_INSTRUMENT,i,fastIns[next-0xe0]));
-          bAccessTS[fastInsOff+(next-0xe0)]=curTick;
+          e->dispatchCmd(DivCommand(DIV_CMD_INSTRUMENT,i,o.arg0));
+          if (tracing) bAccessTS[fastInsOff+(next-0xe0)]=curTick;
           break;
         case 0xe6: case 0xe7: case 0xe8: case 0xe9: case 0xea: case 0xeb:
-          chan[i].volume=fastVols[next-0xe6]<<8;
-          bAccessTS[fastVolsOff+(next-0xe6)]=curTick;
+          chan[i].volume=o.arg0;
+          if (tracing) bAccessTS[fastVolsOff+(next-0xe6)]=curTick;
           sendVolume=true;
           break;
         case 0xec: case 0xed: case 0xee: case 0xef:
-          command=fastCmds[next&3];
-          bAccessTS[fastCmdsOff+(next&3)]=curTick;
+          if (tracing) bAccessTS[fastCmdsOff+(next&3)]=curTick;
           break;
         case 0xd0: // placeholder
-          stream.readC();
-          stream.readC();
-          stream.readC();
           break;
         case 0xd1: // nop
           break;
@@ -259,34 +631,22 @@ bool DivCSPlayer::tick() {
           chan[i].waitTicks=1;
           chan[i].lastWaitLen=chan[i].waitTicks;
           break;
-        case 0xd7:
-          command=stream.readC();
-          break;
-        case 0xd8: {
-          unsigned int callAddr=bigEndian?((unsigned short)stream.readS_BE()):((unsigned short)stream.readS());
-          chan[i].readPos=stream.tell();
-          if (!chan[i].doCall(callAddr)) {
+        case 0xd8:
+          if (!chan[i].doCall(o.arg0)) {
             logE("%d: (call) stack error!",i);
             chan[i].readPos=0;
           }
-          mustTell=false;
           break;
-        }
-        case 0xd5: {
-          unsigned int callAddr=bigEndian?stream.readI_BE():stream.readI();
-          chan[i].readPos=stream.tell();
-          if (!chan[i].doCall(callAddr)) {
+        case 0xd5:
+          if (!chan[i].doCall(o.arg0)) {
             logE("%d: (calli) stack error!",i);
             chan[i].readPos=0;
           }
-          mustTell=false;
           break;
-        }
-        case 0xd4: {
+        case 0xd4:
           logE("%d: (callsym) not supported here!",i);
           chan[i].readPos=0;
           break;
-        }
         case 0xd9:
           if (!chan[i].callStackPos) {
             logE("%d: (ret) stack error!",i);
@@ -294,22 +654,16 @@ bool DivCSPlayer::tick() {
             break;
           }
           chan[i].readPos=chan[i].callStack[--chan[i].callStackPos];
-          mustTell=false;
           break;
         case 0xda:
-          chan[i].readPos=bigEndian?stream.readI_BE():stream.readI();
-          mustTell=false;
+          chan[i].readPos=o.arg0;
           break;
         case 0xdb:
           logE("TODO: RATE");
-          stream.readI();
           break;
         case 0xdc:
-          chan[i].waitTicks=(unsigned short)(bigEndian?stream.readS_BE():stream.readS());
-          chan[i].lastWaitLen=chan[i].waitTicks;
-          break;
         case 0xdd:
-          chan[i].waitTicks=(unsigned char)stream.readC();
+          chan[i].waitTicks=o.arg0;
           chan[i].lastWaitLen=chan[i].waitTicks;
           break;
         case 0xde:
@@ -318,264 +672,19 @@ bool DivCSPlayer::tick() {
           break;
         case 0xdf:
           chan[i].readPos=0;
-          mustTell=false;
-          logI("%d: stop",i,chan[i].readPos);
+          logI("%d: stop",i);
           break;
         default:
-          logE("%d: illegal instruction $%.2x! $%.x",i,next,chan[i].readPos);
+          logE("%d: illegal instruction $%.2x! $%.x",i,next,pos);
           chan[i].readPos=0;
           break;
       }
 
       if (chan[i].readPos==0) break;
 
-      if (command) {
-        int arg0=0;
-        int arg1=0;
-        switch (command) {
-          case DIV_CMD_INSTRUMENT:
-            arg0=(unsigned char)stream.readC();
-            break;
-          case DIV_CMD_PRE_PORTA:
-            arg0=(unsigned char)stream.readC();
-            arg1=(arg0&0x40)?1:0;
-            arg0=(arg0&0x80)?1:0;
-            break;
-          // ONE BYTE COMMANDS
-          case DIV_CMD_SAMPLE_MODE:
-          case DIV_CMD_SAMPLE_FREQ:
-          case DIV_CMD_SAMPLE_BANK:
-          case DIV_CMD_SAMPLE_DIR:
-          case DIV_CMD_FM_HARD_RESET:
-          case DIV_CMD_FM_LFO:
-          case DIV_CMD_FM_LFO_WAVE:
-          case DIV_CMD_FM_LFO2:
-          case DIV_CMD_FM_LFO2_WAVE:
-          case DIV_CMD_FM_FB:
-          case DIV_CMD_FM_EXTCH:
-          case DIV_CMD_FM_AM_DEPTH:
-          case DIV_CMD_FM_PM_DEPTH:
-          case DIV_CMD_STD_NOISE_FREQ:
-          case DIV_CMD_STD_NOISE_MODE:
-          case DIV_CMD_WAVE:
-          case DIV_CMD_GB_SWEEP_TIME:
-          case DIV_CMD_GB_SWEEP_DIR:
-          case DIV_CMD_PCE_LFO_MODE:
-          case DIV_CMD_PCE_LFO_SPEED:
-          case DIV_CMD_NES_DMC:
-          case DIV_CMD_C64_CUTOFF:
-          case DIV_CMD_C64_RESONANCE:
-          case DIV_CMD_C64_FILTER_MODE:
-          case DIV_CMD_C64_RESET_TIME:
-          case DIV_CMD_C64_RESET_MASK:
-          case DIV_CMD_C64_FILTER_RESET:
-          case DIV_CMD_C64_DUTY_RESET:
-          case DIV_CMD_C64_EXTENDED:
-          case DIV_CMD_AY_ENVELOPE_SET:
-          case DIV_CMD_AY_ENVELOPE_LOW:
-          case DIV_CMD_AY_ENVELOPE_HIGH:
-          case DIV_CMD_AY_ENVELOPE_SLIDE:
-          case DIV_CMD_AY_NOISE_MASK_AND:
-          case DIV_CMD_AY_NOISE_MASK_OR:
-          case DIV_CMD_AY_AUTO_ENVELOPE:
-          case DIV_CMD_FDS_MOD_DEPTH:
-          case DIV_CMD_FDS_MOD_HIGH:
-          case DIV_CMD_FDS_MOD_LOW:
-          case DIV_CMD_FDS_MOD_POS:
-          case DIV_CMD_FDS_MOD_WAVE:
-          case DIV_CMD_SAA_ENVELOPE:
-          case DIV_CMD_AMIGA_FILTER:
-          case DIV_CMD_AMIGA_AM:
-          case DIV_CMD_AMIGA_PM:
-          case DIV_CMD_MACRO_OFF:
-          case DIV_CMD_MACRO_ON:
-          case DIV_CMD_MACRO_RESTART:
-          case DIV_CMD_QSOUND_ECHO_FEEDBACK:
-          case DIV_CMD_QSOUND_ECHO_LEVEL:
-          case DIV_CMD_QSOUND_SURROUND:
-          case DIV_CMD_X1_010_ENVELOPE_SHAPE:
-          case DIV_CMD_X1_010_ENVELOPE_ENABLE:
-          case DIV_CMD_X1_010_ENVELOPE_MODE:
-          case DIV_CMD_X1_010_ENVELOPE_PERIOD:
-          case DIV_CMD_X1_010_ENVELOPE_SLIDE:
-          case DIV_CMD_X1_010_AUTO_ENVELOPE:
-          case DIV_CMD_X1_010_SAMPLE_BANK_SLOT:
-          case DIV_CMD_WS_SWEEP_TIME:
-          case DIV_CMD_WS_SWEEP_AMOUNT:
-          case DIV_CMD_N163_WAVE_UNUSED1:
-          case DIV_CMD_N163_WAVE_UNUSED2:
-          case DIV_CMD_N163_WAVE_LOADPOS:
-          case DIV_CMD_N163_WAVE_LOADLEN:
-          case DIV_CMD_N163_WAVE_UNUSED3:
-          case DIV_CMD_N163_CHANNEL_LIMIT:
-          case DIV_CMD_N163_GLOBAL_WAVE_LOAD:
-          case DIV_CMD_N163_GLOBAL_WAVE_LOADPOS:
-          case DIV_CMD_N163_UNUSED4:
-          case DIV_CMD_N163_UNUSED5:
-          case DIV_CMD_SU_SYNC_PERIOD_LOW:
-          case DIV_CMD_SU_SYNC_PERIOD_HIGH:
-          case DIV_CMD_ADPCMA_GLOBAL_VOLUME:
-          case DIV_CMD_SNES_ECHO:
-          case DIV_CMD_SNES_PITCH_MOD:
-          case DIV_CMD_SNES_INVERT:
-          case DIV_CMD_SNES_GAIN_MODE:
-          case DIV_CMD_SNES_GAIN:
-          case DIV_CMD_SNES_ECHO_ENABLE:
-          case DIV_CMD_SNES_ECHO_DELAY:
-          case DIV_CMD_SNES_ECHO_VOL_LEFT:
-          case DIV_CMD_SNES_ECHO_VOL_RIGHT:
-          case DIV_CMD_SNES_ECHO_FEEDBACK:
-          case DIV_CMD_NES_ENV_MODE:
-          case DIV_CMD_NES_LENGTH:
-          case DIV_CMD_NES_COUNT_MODE:
-          case DIV_CMD_FM_AM2_DEPTH:
-          case DIV_CMD_FM_PM2_DEPTH:
-          case DIV_CMD_ES5506_ENVELOPE_LVRAMP:
-          case DIV_CMD_ES5506_ENVELOPE_RVRAMP:
-          case DIV_CMD_ES5506_PAUSE:
-          case DIV_CMD_ES5506_FILTER_MODE:
-          case DIV_CMD_SNES_GLOBAL_VOL_LEFT:
-          case DIV_CMD_SNES_GLOBAL_VOL_RIGHT:
-          case DIV_CMD_NES_LINEAR_LENGTH:
-          case DIV_CMD_EXTERNAL:
-          case DIV_CMD_C64_AD:
-          case DIV_CMD_C64_SR:
-          case DIV_CMD_DAVE_HIGH_PASS:
-          case DIV_CMD_DAVE_RING_MOD:
-          case DIV_CMD_DAVE_SWAP_COUNTERS:
-          case DIV_CMD_DAVE_LOW_PASS:
-          case DIV_CMD_DAVE_CLOCK_DIV:
-          case DIV_CMD_MINMOD_ECHO:
-          case DIV_CMD_FDS_MOD_AUTO:
-          case DIV_CMD_FM_OPMASK:
-          case DIV_CMD_MULTIPCM_MIX_FM:
-          case DIV_CMD_MULTIPCM_MIX_PCM:
-          case DIV_CMD_MULTIPCM_LFO:
-          case DIV_CMD_MULTIPCM_VIB:
-          case DIV_CMD_MULTIPCM_AM:
-          case DIV_CMD_MULTIPCM_AR:
-          case DIV_CMD_MULTIPCM_D1R:
-          case DIV_CMD_MULTIPCM_DL:
-          case DIV_CMD_MULTIPCM_D2R:
-          case DIV_CMD_MULTIPCM_RC:
-          case DIV_CMD_MULTIPCM_RR:
-          case DIV_CMD_MULTIPCM_DAMP:
-          case DIV_CMD_MULTIPCM_PSEUDO_REVERB:
-          case DIV_CMD_MULTIPCM_LFO_RESET:
-          case DIV_CMD_MULTIPCM_LEVEL_DIRECT:
-          case DIV_CMD_SID3_SPECIAL_WAVE:
-          case DIV_CMD_SID3_RING_MOD_SRC:
-          case DIV_CMD_SID3_HARD_SYNC_SRC:
-          case DIV_CMD_SID3_PHASE_MOD_SRC:
-          case DIV_CMD_SID3_WAVE_MIX:
-          case DIV_CMD_SID3_1_BIT_NOISE:
-          case DIV_CMD_SID3_CHANNEL_INVERSION:
-          case DIV_CMD_SID3_FILTER_CONNECTION:
-          case DIV_CMD_SID3_FILTER_MATRIX:
-          case DIV_CMD_SID3_FILTER_ENABLE:
-          case DIV_CMD_SID3_PHASE_RESET:
-          case DIV_CMD_SID3_NOISE_PHASE_RESET:
-          case DIV_CMD_SID3_ENVELOPE_RESET:
-          case DIV_CMD_SID3_CUTOFF_SCALING:
-          case DIV_CMD_SID3_RESONANCE_SCALING:
-          case DIV_CMD_WS_GLOBAL_SPEAKER_VOLUME:
-          case DIV_CMD_FM_ALG:
-          case DIV_CMD_FM_FMS:
-          case DIV_CMD_FM_AMS:
-          case DIV_CMD_FM_FMS2:
-          case DIV_CMD_FM_AMS2:
-            arg0=(unsigned char)stream.readC();
-            break;
-          // TWO BYTE COMMANDS
-          case DIV_CMD_FM_TL:
-          case DIV_CMD_FM_AM:
-          case DIV_CMD_FM_AR:
-          case DIV_CMD_FM_DR:
-          case DIV_CMD_FM_SL:
-          case DIV_CMD_FM_D2R:
-          case DIV_CMD_FM_RR:
-          case DIV_CMD_FM_DT:
-          case DIV_CMD_FM_DT2:
-          case DIV_CMD_FM_RS:
-          case DIV_CMD_FM_KSR:
-          case DIV_CMD_FM_VIB:
-          case DIV_CMD_FM_SUS:
-          case DIV_CMD_FM_WS:
-          case DIV_CMD_FM_SSG:
-          case DIV_CMD_FM_REV:
-          case DIV_CMD_FM_EG_SHIFT:
-          case DIV_CMD_FM_MULT:
-          case DIV_CMD_FM_FINE:
-          case DIV_CMD_AY_IO_WRITE:
-          case DIV_CMD_AY_AUTO_PWM:
-          case DIV_CMD_SURROUND_PANNING:
-          case DIV_CMD_SU_SWEEP_PERIOD_LOW:
-          case DIV_CMD_SU_SWEEP_PERIOD_HIGH:
-          case DIV_CMD_SU_SWEEP_BOUND:
-          case DIV_CMD_SU_SWEEP_ENABLE:
-          case DIV_CMD_SNES_ECHO_FIR:
-          case DIV_CMD_ES5506_FILTER_K1_SLIDE:
-          case DIV_CMD_ES5506_FILTER_K2_SLIDE:
-          case DIV_CMD_ES5506_ENVELOPE_K1RAMP:
-          case DIV_CMD_ES5506_ENVELOPE_K2RAMP:
-          case DIV_CMD_ESFM_OP_PANNING:
-          case DIV_CMD_ESFM_OUTLVL:
-          case DIV_CMD_ESFM_MODIN:
-          case DIV_CMD_ESFM_ENV_DELAY:
-          case DIV_CMD_POWERNOISE_COUNTER_LOAD:
-          case DIV_CMD_POWERNOISE_IO_WRITE:
-          case DIV_CMD_BIFURCATOR_STATE_LOAD:
-          case DIV_CMD_BIFURCATOR_PARAMETER:
-          case DIV_CMD_SID3_LFSR_FEEDBACK_BITS:
-          case DIV_CMD_SID3_FILTER_DISTORTION:
-          case DIV_CMD_SID3_FILTER_OUTPUT_VOLUME:
-          case DIV_CMD_C64_PW_SLIDE:
-          case DIV_CMD_C64_CUTOFF_SLIDE:
-          case DIV_CMD_N163_WAVE_POSITION:
-          case DIV_CMD_N163_WAVE_LENGTH:
-            arg0=(unsigned char)stream.readC();
-            arg1=(unsigned char)stream.readC();
-            break;
-          // ONE SHORT COMMANDS
-          case DIV_CMD_C64_FINE_DUTY:
-          case DIV_CMD_C64_FINE_CUTOFF:
-          case DIV_CMD_LYNX_LFSR_LOAD:
-          case DIV_CMD_QSOUND_ECHO_DELAY:
-          case DIV_CMD_ES5506_ENVELOPE_COUNT:
-            arg0=(unsigned short)(bigEndian?stream.readS_BE():stream.readS());
-            break;
-          // TWO SHORT COMMANDS
-          case DIV_CMD_ES5506_FILTER_K1:
-          case DIV_CMD_ES5506_FILTER_K2:
-            arg0=(unsigned short)(bigEndian?stream.readS_BE():stream.readS());
-            arg1=(unsigned short)(bigEndian?stream.readS_BE():stream.readS());
-            break;
-          case DIV_CMD_FM_FIXFREQ:
-            arg0=(unsigned short)(bigEndian?stream.readS_BE():stream.readS());
-            arg1=arg0&0x7ff;
-            arg0>>=12;
-            break;
-          case DIV_CMD_NES_SWEEP:
-            arg0=(unsigned char)stream.readC();
-            arg1=arg0&0x77;
-            arg0=(arg0&8)?1:0;
-            break;
-          case DIV_CMD_SAMPLE_POS:
-            arg0=(unsigned int)(bigEndian?stream.readI_BE():stream.readI());
-            break;
-        }
-
-        // dispatch it
-        e->dispatchCmd(DivCommand((DivDispatchCmds)command,i,arg0,arg1));
-      }
-
-      for (unsigned int j=accessTSBegin; j<stream.tell(); j++) {
-        if (j<bLen) {
-          bAccessTS[j]=curTick;
-        }
+      if (o.cmd) {
+        e->dispatchCmd(DivCommand((DivDispatchCmds)o.cmd,i,o.arg0,o.arg1));
       }
-
-      if (mustTell) chan[i].readPos=stream.tell();
     }
 
     if (sendVolume || chan[i].volSpeed!=0 || chan[i].tremoloDepth!=0) {
@@ -720,7 +829,7 @@ bool DivCSPlayer::tick() {
 
   // cycle over access times in order to ensure deltas are always higher than 256
   // (and prevent spurious highlights)
-  for (int i=0; i<16; i++) {
+  for (int i=0; i<16 && tracing; i++) {
     short delta=(((short)(curTick&0xffff))-(short)bAccessTS[deltaCyclePos]);
     if (delta>256) {
       bAccessTS[deltaCyclePos]=curTick-512;
@@ -751,6 +860,9 @@ bool DivCSPlayer::init() {
 
   if (bigEndian) fileChans=(((fileChans&0xff00)>>8)|((fileChans&0xff)<<8));
 
+  chan.clear();
+  chan.resize(e->getTotalChannelCount());
+
   fastDelaysOff=stream.tell();
   stream.read(fastDelays,16);
   fastInsOff=stream.tell();
@@ -762,11 +874,7 @@ bool DivCSPlayer::init() {
 
   if (longPointers) {
     for (unsigned int i=0; i<fileChans; i++) {
-      if (i>=DIV_MAX_CHANS) {
-        stream.readI();
-        continue;
-      }
-      if ((int)i>=e->getTotalChannelCount()) {
+      if (i>=chan.size()) {
         stream.readI();
         continue;
       }
@@ -779,11 +887,7 @@ bool DivCSPlayer::init() {
     }
   } else {
     for (unsigned int i=0; i<fileChans; i++) {
-      if (i>=DIV_MAX_CHANS) {
-        stream.readS();
-        continue;
-      }
-      if ((int)i>=e->getTotalChannelCount()) {
+      if (i>=chan.size()) {
         stream.readS();
         continue;
       }
@@ -798,11 +902,12 @@ bool DivCSPlayer::init() {
   
   // read stack sizes
   for (unsigned int i=0; i<fileChans; i++) {
-    chan[i].callStackSize=stream.readC();
+    unsigned char stackSize=stream.readC();
+    if (i<chan.size()) chan[i].callStackSize=stackSize;
   }
 
   // initialize state
-  for (int i=0; i<e->getTotalChannelCount(); i++) {
+  for (size_t i=0; i<chan.size(); i++) {
     if (e->song.dispatchChanOfChan[i]>=0) {
       chan[i].volMax=(e->getDispatch(e->song.dispatchOfChan[i])->dispatch(DivCommand(DIV_CMD_GET_VOLMAX,e->song.dispatchChanOfChan[i]))<<8)|0xff;
     } else {
@@ -826,6 +931,11 @@ bool DivCSPlayer::init() {
   memset(bAccessTS,0xc0,bLen*sizeof(unsigned short));
   curTick=0;
   deltaCyclePos=0;
+  opCount=0;
+
+  ops=new DivCSOp[bLen];
+  memset(ops,0,bLen*sizeof(DivCSOp));
+  decodeAll();
 
   return true;
 }
@@ -22,6 +22,7 @@
 
 #include "defines.h"
 #include "safeReader.h"
+#include <vector>
 
 #define DIV_MAX_CSTRACE 64
 #define DIV_MAX_CSSTACK 128
@@ -90,13 +91,26 @@ struct DivCSChannelState {
   }
 };
 
+// a decoded instruction.
+// the stream is decoded once on load, indexed by position.
+struct DivCSOp {
+  unsigned char op;
+  // length in bytes, or 0 if this position was not decoded
+  unsigned char len;
+  // command to dispatch after the instruction (if not 0)
+  unsigned short cmd;
+  int arg0, arg1;
+};
+
 class DivCSPlayer {
   DivEngine* e;
   unsigned char* b;
   unsigned short* bAccessTS;
+  DivCSOp* ops;
   size_t bLen;
   SafeReader stream;
-  DivCSChannelState chan[DIV_MAX_CHANS];
+  // one per song channel (sized by init())
+  std::vector<DivCSChannelState> chan;
   unsigned char fastDelays[16];
   unsigned char fastIns[6];
   unsigned char fastVols[6];
@@ -104,11 +118,16 @@ class DivCSPlayer {
   unsigned char arpSpeed;
   unsigned int fileChans;
   unsigned int curTick, fastDelaysOff, fastInsOff, fastVolsOff, fastCmdsOff, deltaCyclePos;
+  unsigned long long opCount;
   bool longPointers;
   bool bigEndian;
+  bool tracing;
 
   short vibTable[64];
   short tremTable[128];
+
+  bool decodeOp(unsigned int pos, DivCSOp& o);
+  void decodeAll();
   public:
     unsigned char* getData();
     unsigned short* getDataAccess();
@@ -120,6 +139,9 @@ class DivCSPlayer {
     unsigned char* getFastVols();
     unsigned char* getFastCmds();
     unsigned int getCurTick();
+    unsigned long long getOpCount();
+    // enable the trace and data access times (used by the debug view).
+    void setTracing(bool enable);
     void cleanup();
     bool tick();
     bool init();
@@ -127,8 +149,11 @@ class DivCSPlayer {
       e(en),
       b(buf),
       bAccessTS(NULL),
+      ops(NULL),
       bLen(len),
-      stream(buf,len) {}
+      stream(buf,len),
+      opCount(0),
+      tracing(false) {}
 };
 
 struct DivCSProgress {
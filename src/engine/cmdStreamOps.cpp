@@ -18,8 +18,11 @@
  */
 
 #include "engine.h"
+#include "workPool.h"
 #include "../ta-log.h"
+#include <algorithm>
 #include <stack>
+#include <thread>
 #include <unordered_map>
 
 int DivCS::getCmdLength(unsigned char ext) {
@@ -903,7 +906,120 @@ struct MatchBenefit {
 
 #define MIN_MATCH_SIZE 32
 
-SafeWriter* findSubBlocks(SafeWriter* stream, std::vector<SafeWriter*>& subBlocks, unsigned char* speedDial, DivCSProgress* progress) {
+// number of match groups tested by a single task
+#define MATCH_GROUPS_PER_TASK 64
+
+// number of tasks pushed before updating progress
+#define MATCH_TASKS_PER_ROUND 256
+
+// the benefit test of a group of matches sharing the same origin.
+// it only reads the stream and the match list, so groups can be tested in parallel.
+struct MatchGroupTest {
+  const std::vector<BlockMatch>* matches;
+  const std::vector<size_t>* origs;
+  unsigned char* buf;
+  unsigned char* speedDial;
+  size_t first, last;
+  std::vector<MatchBenefit>* results;
+  MatchGroupTest(const std::vector<BlockMatch>* m, const std::vector<size_t>* o, unsigned char* b, unsigned char* sd, size_t f, size_t l, std::vector<MatchBenefit>* r):
+    matches(m), origs(o), buf(b), speedDial(sd), first(f), last(l), results(r) {}
+  MatchGroupTest():
+    matches(NULL), origs(NULL), buf(NULL), speedDial(NULL), first(0), last(0), results(NULL) {}
+};
+
+// put the usable matches of length len in out, marking overlapping ones as done.
+// returns the number of matches which don't overlap.
+static size_t filterMatches(const std::vector<BlockMatch>& matches, size_t begin, size_t end, size_t len, unsigned char* buf, std::vector<BlockMatch>& out) {
+  out.clear();
+  for (size_t _k=begin; _k<end; _k++) {
+    const BlockMatch& k=matches[_k];
+    // match length shall be greater than or equal to current length
+    if (len>k.len) continue;
+
+    // check for bad matches, which include:
+    // - match overlapping with itself
+    // - block only consisting of calls
+    // - block containing a ret, jmp or stop
+
+    // 1. self-overlapping
+    if (OVERLAPS(k.orig,k.orig+len,k.block,k.block+len)) continue;
+
+    // 2. only calls and jmp/ret/stop
+    bool metCriteria=true;
+    for (size_t l=k.orig; l<k.orig+len; l+=8) {
+      if (buf[l]==0xd4 || buf[l]==0xd5) {
+        metCriteria=false;
+        break;
+      }
+    }
+    if (!metCriteria) continue;
+
+    // 3. jmp/ret/stop
+    for (size_t l=k.orig; l<k.orig+len; l+=8) {
+      if (buf[l]==0xd9 || buf[l]==0xda || buf[l]==0xdf) {
+        metCriteria=false;
+        break;
+      }
+    }
+    if (!metCriteria) continue;
+
+    // all criteria met
+    out.push_back(k);
+  }
+
+  if (out.empty()) return 0;
+
+  // check for overlapping matches
+  size_t overlapPos=out[0].orig;
+  size_t validCount=0;
+  for (BlockMatch& k: out) {
+    if (OVERLAPS(overlapPos,overlapPos+len,k.block,k.block+len)) {
+      k.done=true;
+    } else {
+      validCount++;
+    }
+    overlapPos=k.block;
+  }
+  return validCount;
+}
+
+static void _testMatchGroups(void* arg) {
+  MatchGroupTest* t=(MatchGroupTest*)arg;
+  const std::vector<BlockMatch>& matches=*t->matches;
+  const std::vector<size_t>& origs=*t->origs;
+  std::vector<BlockMatch> testLenMatches;
+
+  for (size_t i=t->first; i<t->last; i++) {
+    size_t begin=origs[i];
+    size_t end=(i+1<origs.size())?origs[i+1]:matches.size();
+    MatchBenefit best;
+
+    // test all lengths
+    for (size_t len=MIN_MATCH_SIZE; true; len+=8) {
+      size_t validCount=filterMatches(matches,begin,end,len,t->buf,testLenMatches);
+
+      // get out if no further matches (trying with bigger sizes is guaranteed to fail)
+      if (testLenMatches.empty()) {
+        break;
+      }
+
+      // calculate (weighted) benefit
+      const int blockSize=estimateBlockSize(&t->buf[testLenMatches[0].orig],len,t->speedDial);
+      const int gains=((blockSize-3)*validCount)-4;
+      int finalBenefit=gains*2+len*3;
+      if (gains<1) finalBenefit=-1;
+
+      // check whether this set of matches has greater benefit
+      if (finalBenefit>best.benefit) {
+        best=MatchBenefit(begin,finalBenefit,len);
+      }
+    }
+
+    (*t->results)[i]=best;
+  }
+}
+
+SafeWriter* findSubBlocks(SafeWriter* stream, std::vector<SafeWriter*>& subBlocks, unsigned char* speedDial, DivCSProgress* progress, DivWorkPool* pool) {
   unsigned char* buf=stream->getFinalBuf();
   size_t matchSize=MIN_MATCH_SIZE;
   std::vector<BlockMatch> matches;
@@ -921,13 +1037,46 @@ SafeWriter* findSubBlocks(SafeWriter* stream, std::vector<SafeWriter*>& subBlock
   // fast match algorithm
   // search for small matches, and then find bigger ones
   logD("finding possible matches");
+
+  // sort the positions by their contents, so that equal blocks end up next to each other.
+  // positions whose block goes past the end of the stream aren't sorted. they are compared
+  // directly instead (there are at most matchSize/8 of them).
+  size_t fullEnd=(stream->size()>=matchSize)?(stream->size()-matchSize+8):0;
+  std::vector<size_t> sorted;
+  for (size_t i=0; i<fullEnd; i+=8) {
+    sorted.push_back(i);
+  }
+  std::sort(sorted.begin(),sorted.end(),[buf,matchSize](size_t a, size_t b) {
+    int cmp=memcmp(&buf[a],&buf[b],matchSize);
+    if (cmp!=0) return cmp<0;
+    return a<b;
+  });
+
+  // position of each block in the sorted list, and end of its run of equal blocks
+  std::vector<size_t> rank(sorted.size());
+  std::vector<size_t> runEnd(sorted.size());
+  for (size_t i=0; i<sorted.size(); i++) {
+    rank[sorted[i]>>3]=i;
+  }
+  for (size_t i=sorted.size(); i>0; i--) {
+    if (i<sorted.size() && memcmp(&buf[sorted[i-1]],&buf[sorted[i]],matchSize)==0) {
+      runEnd[i-1]=runEnd[i];
+    } else {
+      runEnd[i-1]=i;
+    }
+  }
+
+  // matches are stored in the same order as a full search would (by origin, then by block)
   for (size_t i=0; i<stream->size(); i+=8) {
     if (!(i&2047)) {
       if (progress!=NULL) progress->findCurrent=i;
     }
     bool storedOrig=false;
-    for (size_t j=i+matchSize; j<stream->size(); j+=8) {
-      if (memcmp(&buf[i],&buf[j],matchSize)==0) {
+    if (i<fullEnd) {
+      size_t r=rank[i>>3];
+      for (size_t k=r+1; k<runEnd[r]; k++) {
+        size_t j=sorted[k];
+        if (j<i+matchSize) continue;
         if (!storedOrig) {
           // store index to the first match somewhere else for the sake of speed
           origs.push_back(matches.size());
@@ -937,6 +1086,15 @@ SafeWriter* findSubBlocks(SafeWriter* stream, std::vector<SafeWriter*>& subBlock
         matches.push_back(BlockMatch(i,j,matchSize));
       }
     }
+    for (size_t j=MAX(i+matchSize,fullEnd); j<stream->size(); j+=8) {
+      if (memcmp(&buf[i],&buf[j],matchSize)==0) {
+        if (!storedOrig) {
+          origs.push_back(matches.size());
+          storedOrig=true;
+        }
+        matches.push_back(BlockMatch(i,j,matchSize));
+      }
+    }
   }
 
   logD("%d candidates",(int)matches.size());
@@ -999,95 +1157,39 @@ SafeWriter* findSubBlocks(SafeWriter* stream, std::vector<SafeWriter*>& subBlock
   // - pick largest benefit from list
   // - make sub-blocks!!!
   logD("testing %d match groups for benefit",(int)origs.size());
-  size_t origIndex=0;
-  for (size_t i=0; i<origs.size(); i++) {
-    size_t begin=origs[i];
-    size_t end=(i+1<origs.size())?origs[i+1]:matches.size();
-    size_t minSize=MIN_MATCH_SIZE;
-    std::vector<BlockMatch> testLenMatches;
-
-    if (progress!=NULL) progress->origCurrent=origIndex;
-
-    origIndex++;
-
-    if (!(i&255)) logV("orig %d of %d",(int)i,(int)origs.size());
-
-    // test all lengths
-    for (size_t len=minSize; true; len+=8) {
-      testLenMatches.clear();
-      // filter matches
-      for (size_t _k=begin; _k<end; _k++) {
-        BlockMatch& k=matches[_k];
-        // match length shall be greater than or equal to current length
-        if (len>k.len) continue;
-
-        // check for bad matches, which include:
-        // - match overlapping with itself
-        // - block only consisting of calls
-        // - block containing a ret, jmp or stop
-
-        // 1. self-overlapping
-        if (OVERLAPS(k.orig,k.orig+len,k.block,k.block+len)) continue;
-
-        // 2. only calls and jmp/ret/stop
-        bool metCriteria=true;
-        for (size_t l=k.orig; l<k.orig+len; l+=8) {
-          if (buf[l]==0xd4 || buf[l]==0xd5) {
-            metCriteria=false;
-            break;
-          }
-        }
-        if (!metCriteria) continue;
-
-        // 3. jmp/ret/stop
-        for (size_t l=k.orig; l<k.orig+len; l+=8) {
-          if (buf[l]==0xd9 || buf[l]==0xda || buf[l]==0xdf) {
-            metCriteria=false;
-            break;
-          }
-        }
-        if (!metCriteria) continue;
-
-        // all criteria met
-        testLenMatches.push_back(k);
-      }
-
-      // get out if no further matches (trying with bigger sizes is guaranteed to fail)
-      if (testLenMatches.empty()) {
-        break;
-      }
-
-      // check for overlapping matches
-      size_t overlapPos=testLenMatches[0].orig;
-      size_t validCount=0;
-      for (BlockMatch& k: testLenMatches) {
-        //logV("test %d with %d",(int)overlapPos,(int)k.block);
-        if (OVERLAPS(overlapPos,overlapPos+len,k.block,k.block+len)) {
-          k.done=true;
-          //logW("overlap");
-        } else {
-          validCount++;
-        }
-        overlapPos=k.block;
+  std::vector<MatchBenefit> groupBenefit(origs.size());
+  std::vector<MatchGroupTest> groupTests;
+  for (size_t i=0; i<origs.size(); i+=MATCH_GROUPS_PER_TASK) {
+    groupTests.push_back(MatchGroupTest(&matches,&origs,buf,speedDial,i,MIN(i+MATCH_GROUPS_PER_TASK,origs.size()),&groupBenefit));
+  }
+  for (size_t i=0; i<groupTests.size(); i+=MATCH_TASKS_PER_ROUND) {
+    size_t count=MIN(MATCH_TASKS_PER_ROUND,groupTests.size()-i);
+    if (progress!=NULL) progress->origCurrent=groupTests[i].first;
+    logV("orig %d of %d",(int)groupTests[i].first,(int)origs.size());
+    if (pool!=NULL) {
+      pool->pushBatch(_testMatchGroups,&groupTests[i],count);
+      pool->wait();
+    } else {
+      for (size_t j=i; j<i+count; j++) {
+        _testMatchGroups(&groupTests[j]);
       }
+    }
+  }
 
-
-      // calculate (weighted) benefit
-      const int blockSize=estimateBlockSize(&buf[testLenMatches[0].orig],len,speedDial);
-      const int gains=((blockSize-3)*validCount)-4;
-      int finalBenefit=gains*2+len*3;
-      if (gains<1) finalBenefit=-1;
-
-      // check whether this set of matches has greater benefit
-      if (finalBenefit>bestBenefit.benefit) {
-        //logD("- %x (%d): %d = %d",(int)i,(int)len,(int)testLenMatches.size(),finalBenefit);
-        bestBenefit=MatchBenefit(begin,finalBenefit,len);
-        // copy matches so we don't have to select them later
-        workMatches=testLenMatches;
-      }
+  // pick the group with the largest benefit (the first one in case of a tie)
+  for (MatchBenefit& i: groupBenefit) {
+    if (i.benefit>bestBenefit.benefit) {
+      bestBenefit=i;
     }
   }
 
+  // select the matches of the best group
+  if (bestBenefit.benefit>0) {
+    size_t bestGroup=std::lower_bound(origs.begin(),origs.end(),bestBenefit.index)-origs.begin();
+    size_t end=(bestGroup+1<origs.size())?origs[bestGroup+1]:matches.size();
+    filterMatches(matches,bestBenefit.index,end,bestBenefit.len,buf,workMatches);
+  }
+
   // quit if there isn't benefit
   if (bestBenefit.benefit<1) return stream;
 
@@ -1736,12 +1838,16 @@ SafeWriter* DivEngine::saveCommand(DivCSProgress* progress, DivCSOptions options
     // 6 is the minimum size that can be reliably optimized
     logI("finding sub-blocks");
 
+    // match groups are tested in parallel
+    unsigned int threads=std::thread::hardware_concurrency();
+    DivWorkPool* subBlockPool=new DivWorkPool((threads>1)?(threads-1):0);
+
     bool haveBlocks=false;
     subBlocks.clear();
     // repeat until no more sub-blocks are produced
     do {
       logD("iteration...");
-      globalStream=findSubBlocks(globalStream,subBlocks,sortedCmd,progress);
+      globalStream=findSubBlocks(globalStream,subBlocks,sortedCmd,progress,subBlockPool);
 
       haveBlocks=!subBlocks.empty();
       // insert sub-blocks and resolve symbols
@@ -1785,6 +1891,7 @@ SafeWriter* DivEngine::saveCommand(DivCSProgress* progress, DivCSOptions options
         }
       }
     } while (haveBlocks);
+    delete subBlockPool;
 
     size_t afterSize=globalStream->size();
     logI("(before: %d - after: %d)",(int)beforeSize,(int)afterSize);
@@ -22,10 +22,73 @@
 #include "../baseutils.h"
 #include "../fileutils.h"
 #include <fmt/printf.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
 
 #define REDUNDANCY_NUM_ATTEMPTS 5
 #define CHECK_BUF_SIZE 8192
 
+// these follow std::stoi/stof/stod (leading whitespace and trailing garbage
+// are accepted, while no number or out of range are rejected), but without
+// throwing.
+static bool parseInt(const String& s, int& out) {
+  const char* start=s.c_str();
+  char* end=NULL;
+  errno=0;
+  long ret=strtol(start,&end,10);
+  if (end==start || errno==ERANGE || ret<INT_MIN || ret>INT_MAX) return false;
+  out=(int)ret;
+  return true;
+}
+
+static bool parseFloat(const String& s, float& out) {
+  const char* start=s.c_str();
+  char* end=NULL;
+  errno=0;
+  float ret=strtof(start,&end);
+  if (end==start || errno==ERANGE) return false;
+  out=ret;
+  return true;
+}
+
+static bool parseDouble(const String& s, double& out) {
+  const char* start=s.c_str();
+  char* end=NULL;
+  errno=0;
+  double ret=strtod(start,&end);
+  if (end==start || errno==ERANGE) return false;
+  out=ret;
+  return true;
+}
+
+DivConfigValue::DivConfigValue(const String& s):
+  str(s),
+  doubleVal(0.0),
+  floatVal(0.0f),
+  intVal(0),
+  boolVal(false),
+  hasDouble(false),
+  hasFloat(false),
+  hasInt(false),
+  hasBool(false) {
+  int savedErrno=errno;
+  hasInt=parseInt(str,intVal);
+  hasFloat=parseFloat(str,floatVal);
+  hasDouble=parseDouble(str,doubleVal);
+  errno=savedErrno;
+  if (str=="true") {
+    boolVal=true;
+    hasBool=true;
+  } else if (str=="false") {
+    boolVal=false;
+    hasBool=true;
+  } else if (hasInt) {
+    boolVal=(intVal!=0);
+    hasBool=true;
+  }
+}
+
 bool DivConfig::save(const char* path, bool redundancy) {
   if (redundancy) {
     char oldPath[4096];
@@ -62,7 +125,7 @@ bool DivConfig::save(const char* path, bool redundancy) {
     fputs("!DIV_CONFIG_START!\n",f);
   }
   for (auto& i: conf) {
-    String toWrite=fmt::sprintf("%s=%s\n",i.first,i.second);
+    String toWrite=fmt::sprintf("%s=%s\n",i.first,i.second.str);
     if (fwrite(toWrite.c_str(),1,toWrite.size(),f)!=toWrite.size()) {
       logW("could not write config file! %s",strerror(errno));
       reportError(fmt::sprintf("could not write config file! %s",strerror(errno)));
@@ -83,7 +146,7 @@ bool DivConfig::save(const char* path, bool redundancy) {
 String DivConfig::toString() {
   String ret;
   for (auto& i: conf) {
-    ret+=fmt::sprintf("%s=%s\n",i.first,i.second);
+    ret+=fmt::sprintf("%s=%s\n",i.first,i.second.str);
   }
   return ret;
 }
@@ -93,7 +156,7 @@ String DivConfig::toBase64() {
   return taEncodeBase64(data);
 }
 
-const std::map<String,String>& DivConfig::configMap() {
+const std::map<String,DivConfigValue,std::less<>>& DivConfig::configMap() {
   return conf;
 }
 
@@ -115,7 +178,7 @@ void DivConfig::parseLine(const char* line) {
     }
   }
   if (keyOrValue) {
-    conf[key]=value;
+    conf[key]=DivConfigValue(value);
   }
 }
 
@@ -294,79 +357,53 @@ bool DivConfig::loadFromBase64(const char* buf) {
   return loadFromMemory(data.c_str());
 }
 
-bool DivConfig::getBool(String key, bool fallback) const {
+bool DivConfig::getBool(const String& key, bool fallback) const {
   auto val=conf.find(key);
-  if (val!=conf.cend()) {
-    if (val->second=="true") {
-      return true;
-    } else if (val->second=="false") {
-      return false;
-    } else {
-      try {
-        int ret=std::stoi(val->second);
-        return (ret!=0);
-      } catch (std::out_of_range& e) {
-      } catch (std::invalid_argument& e) {
-      }
-    }
+  if (val!=conf.cend() && val->second.hasBool) {
+    return val->second.boolVal;
   }
   return fallback;
 }
 
-int DivConfig::getInt(String key, int fallback) const {
+int DivConfig::getInt(const String& key, int fallback) const {
   auto val=conf.find(key);
-  if (val!=conf.cend()) {
-    try {
-      int ret=std::stoi(val->second);
-      return ret;
-    } catch (std::out_of_range& e) {
-    } catch (std::invalid_argument& e) {
-    }
+  if (val!=conf.cend() && val->second.hasInt) {
+    return val->second.intVal;
   }
   return fallback;
 }
 
-float DivConfig::getFloat(String key, float fallback) const {
+float DivConfig::getFloat(const String& key, float fallback) const {
   auto val=conf.find(key);
-  if (val!=conf.cend()) {
-    try {
-      float ret=std::stof(val->second);
-      return ret;
-    } catch (std::out_of_range& e) {
-    } catch (std::invalid_argument& e) {
-    }
+  if (val!=conf.cend() && val->second.hasFloat) {
+    return val->second.floatVal;
   }
   return fallback;
 }
 
-double DivConfig::getDouble(String key, double fallback) const {
+double DivConfig::getDouble(const String& key, double fallback) const {
   auto val=conf.find(key);
-  if (val!=conf.cend()) {
-    try {
-      double ret=std::stod(val->second);
-      return ret;
-    } catch (std::out_of_range& e) {
-    } catch (std::invalid_argument& e) {
-    }
+  if (val!=conf.cend() && val->second.hasDouble) {
+    return val->second.doubleVal;
   }
   return fallback;
 }
 
-String DivConfig::getString(String key, String fallback) const {
+String DivConfig::getString(const String& key, String fallback) const {
   auto val=conf.find(key);
   if (val!=conf.cend()) {
-    return val->second;
+    return val->second.str;
   }
   return fallback;
 }
 
-std::vector<int> DivConfig::getIntList(String key, std::initializer_list<int> fallback) const {
+std::vector<int> DivConfig::getIntList(const String& key, std::initializer_list<int> fallback) const {
   String next;
   std::vector<int> ret;
   auto val=conf.find(key);
   if (val!=conf.cend()) {
     try {
-      for (char i: val->second) {
+      for (char i: val->second.str) {
         if (i==',') {
           int num=std::stoi(next);
           ret.push_back(num);
@@ -388,13 +425,13 @@ std::vector<int> DivConfig::getIntList(String key, std::initializer_list<int> fa
   return fallback;
 }
 
-std::vector<String> DivConfig::getStringList(String key, std::initializer_list<String> fallback) const {
+std::vector<String> DivConfig::getStringList(const String& key, std::initializer_list<String> fallback) const {
   String next;
   std::vector<String> ret;
   auto val=conf.find(key);
   if (val!=conf.cend()) {
     try {
-      for (char i: val->second) {
+      for (char i: val->second.str) {
         if (i==',') {
           String result=taDecodeBase64(next);
           ret.push_back(result);
@@ -416,37 +453,33 @@ std::vector<String> DivConfig::getStringList(String key, std::initializer_list<S
   return fallback;
 }
 
-bool DivConfig::has(String key) const {
+bool DivConfig::has(const String& key) const {
   auto val=conf.find(key);
   return (val!=conf.cend());
 }
 
 void DivConfig::set(String key, bool value) {
-  if (value) {
-    conf[key]="true";
-  } else {
-    conf[key]="false";
-  }
+  conf[key]=DivConfigValue(value?"true":"false");
 }
 
 void DivConfig::set(String key, int value) {
-  conf[key]=fmt::sprintf("%d",value);
+  conf[key]=DivConfigValue(fmt::sprintf("%d",value));
 }
 
 void DivConfig::set(String key, float value) {
-  conf[key]=fmt::sprintf("%f",value);
+  conf[key]=DivConfigValue(fmt::sprintf("%f",value));
 }
 
 void DivConfig::set(String key, double value) {
-  conf[key]=fmt::sprintf("%f",value);
+  conf[key]=DivConfigValue(fmt::sprintf("%f",value));
 }
 
 void DivConfig::set(String key, const char* value) {
-  conf[key]=String(value);
+  conf[key]=DivConfigValue(String(value));
 }
 
 void DivConfig::set(String key, String value) {
-  conf[key]=value;
+  conf[key]=DivConfigValue(value);
 }
 
 void DivConfig::set(String key, const std::vector<int>& value) {
@@ -457,7 +490,7 @@ void DivConfig::set(String key, const std::vector<int>& value) {
     val+=fmt::sprintf("%d",i);
     comma=true;
   }
-  conf[key]=val;
+  conf[key]=DivConfigValue(val);
 }
 
 void DivConfig::set(String key, const std::vector<String>& value) {
@@ -468,7 +501,7 @@ void DivConfig::set(String key, const std::vector<String>& value) {
     val+=taEncodeBase64(i);
     comma=true;
   }
-  conf[key]=val;
+  conf[key]=DivConfigValue(val);
 }
 
 bool DivConfig::remove(String key) {
@@ -23,8 +23,31 @@
 #include "../ta-utils.h"
 #include <initializer_list>
 
+// a config value. the string form is what gets saved, while the numeric
+// forms are parsed once when the value is set, so that getInt() and friends
+// don't have to parse the string on every call.
+struct DivConfigValue {
+  String str;
+  double doubleVal;
+  float floatVal;
+  int intVal;
+  bool boolVal;
+  bool hasDouble, hasFloat, hasInt, hasBool;
+
+  DivConfigValue():
+    doubleVal(0.0),
+    floatVal(0.0f),
+    intVal(0),
+    boolVal(false),
+    hasDouble(false),
+    hasFloat(false),
+    hasInt(false),
+    hasBool(false) {}
+  DivConfigValue(const String& s);
+};
+
 class DivConfig {
-  std::map<String,String> conf;
+  std::map<String,DivConfigValue,std::less<>> conf;
   void parseLine(const char* line);
   public:
     // config loading/saving
@@ -36,19 +59,19 @@ class DivConfig {
     bool save(const char* path, bool redundancy=false);
 
     // get the map
-    const std::map<String,String>& configMap();
+    const std::map<String,DivConfigValue,std::less<>>& configMap();
 
     // get a config value
-    bool getBool(String key, bool fallback) const;
-    int getInt(String key, int fallback) const;
-    float getFloat(String key, float fallback) const;
-    double getDouble(String key, double fallback) const;
-    String getString(String key, String fallback) const;
-    std::vector<int> getIntList(String key, std::initializer_list<int> fallback) const;
-    std::vector<String> getStringList(String key, std::initializer_list<String> fallback) const;
+    bool getBool(const String& key, bool fallback) const;
+    int getInt(const String& key, int fallback) const;
+    float getFloat(const String& key, float fallback) const;
+    double getDouble(const String& key, double fallback) const;
+    String getString(const String& key, String fallback) const;
+    std::vector<int> getIntList(const String& key, std::initializer_list<int> fallback) const;
+    std::vector<String> getStringList(const String& key, std::initializer_list<String> fallback) const;
 
     // check for existence
-    bool has(String key) const;
+    bool has(const String& key) const;
 
     // set a config value
     void set(String key, bool value);
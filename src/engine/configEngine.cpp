@@ -133,6 +133,38 @@ int DivEngine::getConfInt(String key, int fallback) {
   return conf.getInt(key,fallback);
 }
 
+// the fastest choice for each playback core setting
+static const std::pair<const char*,int> lightCoreConf[]={
+  {"arcadeCore",0},
+  {"ym2612Core",1},
+  {"snCore",0},
+  {"nesCore",0},
+  {"fdsCore",0},
+  {"c64Core",2},
+  {"dsidQuality",0},
+  {"gbQuality",0},
+  {"opn1Core",0},
+  {"opnaCore",0},
+  {"opnbCore",0},
+  {"opl2Core",1},
+  {"opl3Core",1},
+  {"opl4Core",1},
+  {"esfmCore",1},
+  {"opllCore",1},
+  {"ayCore",0},
+  {"pnQuality",0},
+  {"saaQuality",0}
+};
+
+int DivEngine::getCoreConf(String key, int fallback) {
+  if (lightCores) {
+    for (const std::pair<const char*,int>& i: lightCoreConf) {
+      if (key==i.first) return i.second;
+    }
+  }
+  return conf.getInt(key,fallback);
+}
+
 float DivEngine::getConfFloat(String key, float fallback) {
   return conf.getFloat(key,fallback);
 }
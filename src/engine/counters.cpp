@@ -0,0 +1,75 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2026 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// per-thread counter blocks.
+// blocks are allocated once per thread and never freed, so that the counts of
+// threads which are gone are still part of the total.
+
+#include "counters.h"
+#include <mutex>
+#include <vector>
+
+static std::mutex counterBlocksLock;
+static std::vector<DivCounterBlock*> counterBlocks;
+thread_local DivCounterBlock* divCounterBlock=NULL;
+
+static const char* counterNames[DIV_COUNTER_MAX]={
+  "ticks",
+  "commands",
+  "register writes",
+  "blip deltas",
+  "macro steps",
+  "pattern cells"
+};
+
+DivCounterBlock::DivCounterBlock() {
+  for (int i=0; i<DIV_COUNTER_MAX; i++) {
+    count[i].store(0,std::memory_order_relaxed);
+  }
+  for (int i=0; i<DIV_CMD_MAX; i++) {
+    cmds[i].store(0,std::memory_order_relaxed);
+  }
+}
+
+DivCounterBlock* divCounterBlockNew() {
+  if (divCounterBlock!=NULL) return divCounterBlock;
+  divCounterBlock=new DivCounterBlock;
+  std::lock_guard<std::mutex> lock(counterBlocksLock);
+  counterBlocks.push_back(divCounterBlock);
+  return divCounterBlock;
+}
+
+void divCountersRead(DivCounters& out) {
+  memset(out.count,0,sizeof(out.count));
+  memset(out.cmds,0,sizeof(out.cmds));
+  std::lock_guard<std::mutex> lock(counterBlocksLock);
+  for (DivCounterBlock* b: counterBlocks) {
+    for (int i=0; i<DIV_COUNTER_MAX; i++) {
+      out.count[i]+=b->count[i].load(std::memory_order_relaxed);
+    }
+    for (int i=0; i<DIV_CMD_MAX; i++) {
+      out.cmds[i]+=b->cmds[i].load(std::memory_order_relaxed);
+    }
+  }
+}
+
+const char* divCounterName(int which) {
+  if (which<0 || which>=DIV_COUNTER_MAX) return "???";
+  return counterNames[which];
+}
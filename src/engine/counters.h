@@ -0,0 +1,93 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2026 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _COUNTERS_H
+#define _COUNTERS_H
+
+// event counters (for profiling).
+// unlike the profiler, which tells where time goes, these tell why: how many
+// ticks, commands, register writes and so on the engine goes through.
+// every thread counts into a block of its own without locking or atomic
+// read-modify-write operations. divCountersRead() adds them all together.
+// counters are never reset. take the difference of two reads instead.
+
+#include "dispatch.h"
+
+enum DivCounterType {
+  // nextTick() calls
+  DIV_COUNTER_TICKS=0,
+  // dispatchCmd() calls (see also DivCounters::cmds)
+  DIV_COUNTER_COMMANDS,
+  // register writes (all chips)
+  DIV_COUNTER_REG_WRITES,
+  // blip_buf deltas (all chips)
+  DIV_COUNTER_BLIP_DELTAS,
+  // macro steps
+  DIV_COUNTER_MACRO_STEPS,
+  // pattern cells processed by processRow()
+  DIV_COUNTER_PATTERN_CELLS,
+
+  DIV_COUNTER_MAX
+};
+
+struct DivCounterBlock {
+  // written by the owning thread only
+  std::atomic<unsigned long long> count[DIV_COUNTER_MAX];
+  std::atomic<unsigned long long> cmds[DIV_CMD_MAX];
+  DivCounterBlock();
+};
+
+struct DivCounters {
+  unsigned long long count[DIV_COUNTER_MAX];
+  // commands by type
+  unsigned long long cmds[DIV_CMD_MAX];
+  DivCounters() {
+    memset(count,0,sizeof(count));
+    memset(cmds,0,sizeof(cmds));
+  }
+};
+
+extern thread_local DivCounterBlock* divCounterBlock;
+// allocate the block of the calling thread.
+DivCounterBlock* divCounterBlockNew();
+
+static inline void divCountAdd(std::atomic<unsigned long long>& c, unsigned long long n) {
+  // only one thread writes, so this doesn't need to be a locked add
+  c.store(c.load(std::memory_order_relaxed)+n,std::memory_order_relaxed);
+}
+
+static inline void divCount(DivCounterType which, unsigned long long n=1) {
+  DivCounterBlock* b=divCounterBlock;
+  if (b==NULL) b=divCounterBlockNew();
+  divCountAdd(b->count[which],n);
+}
+
+static inline void divCountCmd(int cmd) {
+  DivCounterBlock* b=divCounterBlock;
+  if (b==NULL) b=divCounterBlockNew();
+  divCountAdd(b->count[DIV_COUNTER_COMMANDS],1);
+  if (cmd>=0 && cmd<DIV_CMD_MAX) divCountAdd(b->cmds[cmd],1);
+}
+
+// add up the counters of every thread.
+void divCountersRead(DivCounters& out);
+// get the name of a counter.
+const char* divCounterName(int which);
+
+#endif
@@ -28,8 +28,9 @@
 
 // in-pattern
 #define DIV_MAX_ROWS 256
-#define DIV_MAX_COLS 32
 #define DIV_MAX_EFFECTS 8
+// note, instrument, volume and effects
+#define DIV_MAX_COLS (3+(DIV_MAX_EFFECTS<<1))
 
 // pattern fields
 #define DIV_PAT_NOTE 0
@@ -22,6 +22,7 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <atomic>
 #include "../pch.h"
 #include "blip_buf.h"
 #include "config.h"
@@ -371,10 +372,11 @@ struct DivPitchTable {
   }
 };
 
-struct DivDelayedCommand {
-  int ticks;
-  DivCommand cmd;
-};
+/**
+ * get 2^(step/1536) using a one-octave lookup table.
+ * used by linear pitch frequency calculation instead of pow().
+ */
+double divPitchRatio(int step);
 
 struct DivRegWrite {
   /**
@@ -440,19 +442,24 @@ constexpr size_t OSCBUF_PREC=(sizeof(size_t)>=8)?16:16;
 constexpr size_t OSCBUF_MASK=(UINTMAX_C(1)<<OSCBUF_PREC)-1;
 
 #define putSampleIKnowWhatIAmDoing(_ob,_pos,_val) \
-  _ob->data[_pos]=_val;
+  if (_ob->data!=NULL) _ob->data[_pos]=_val;
 
 // the actual output of all DivDispatchOscBuffer instanced runs at 65536Hz.
 struct DivDispatchOscBuffer {
   size_t rate;
   size_t rateMul;
   unsigned int needle;
+  // copy of needle for readers, published after each block
+  std::atomic<unsigned int> pubNeedle;
   unsigned short readNeedle;
   //unsigned short lastSample;
   bool follow, mustNotKillNeedle;
-  short data[65536];
+  // allocated by enable(). NULL while nobody is reading this buffer.
+  // writes are skipped in that case, but the needle keeps moving.
+  short* data;
 
   inline void putSample(const size_t pos, const short val) {
+    if (data==NULL) return;
     unsigned short realPos=((needle+pos*rateMul)>>OSCBUF_PREC);
     if (val==-1) {
       data[realPos]=0xfffe;
@@ -472,6 +479,7 @@ struct DivDispatchOscBuffer {
     data[pos]=val;
   }*/
   inline void begin(size_t len) {
+    if (data==NULL) return;
     size_t calc=(len*rateMul);
     unsigned short start=needle>>16;
     unsigned short end=(needle+calc)>>16;
@@ -497,15 +505,40 @@ struct DivDispatchOscBuffer {
     size_t calc=len*rateMul;
     needle+=calc;
     mustNotKillNeedle=needle&0xffff;//(data[needle>>16]!=-1);
+    pubNeedle.store(needle,std::memory_order_release);
     //data[needle>>16]=lastSample;
   }
   void reset() {
-    memset(data,-1,65536*sizeof(short));
+    if (data!=NULL) memset(data,-1,65536*sizeof(short));
     needle=0;
+    pubNeedle.store(0,std::memory_order_release);
     readNeedle=0;
     mustNotKillNeedle=false;
     //lastSample=0;
   }
+  /**
+   * get the needle as of the last finished block.
+   * data behind it has been written completely, so readers on other threads should use this.
+   */
+  inline unsigned int getNeedle() const {
+    return pubNeedle.load(std::memory_order_acquire);
+  }
+  /**
+   * allocate the buffer (if not allocated already).
+   */
+  void enable() {
+    if (data!=NULL) return;
+    data=new short[65536];
+    memset(data,-1,65536*sizeof(short));
+  }
+  /**
+   * free the buffer. putSample() does nothing afterwards.
+   */
+  void disable() {
+    if (data==NULL) return;
+    delete[] data;
+    data=NULL;
+  }
   void setRate(unsigned int r) {
     double rateMulD=65536.0/(double)r;
     rateMulD*=(double)(UINTMAX_C(1)<<OSCBUF_PREC);
@@ -516,11 +549,16 @@ struct DivDispatchOscBuffer {
     rate(65536),
     rateMul(UINTMAX_C(1)<<OSCBUF_PREC),
     needle(0),
+    pubNeedle(0),
     readNeedle(0),
     //lastSample(0),
     follow(true),
-    mustNotKillNeedle(false) {
-    memset(data,-1,65536*sizeof(short));
+    mustNotKillNeedle(false),
+    data(NULL) {}
+  DivDispatchOscBuffer(const DivDispatchOscBuffer&)=delete;
+  DivDispatchOscBuffer& operator=(const DivDispatchOscBuffer&)=delete;
+  ~DivDispatchOscBuffer() {
+    disable();
   }
 };
 
@@ -651,6 +689,71 @@ class DivDispatch {
      * please honor these variables if needed.
      */
     bool skipRegisterWrites, dumpWrites;
+
+    /**
+     * number of register writes since the last call to takeWriteCount().
+     * incremented by the write macros of each dispatch.
+     */
+    unsigned int writeCount;
+
+    /**
+     * per-channel output buffers set by setChanOutputs(), or NULL.
+     * only used by dispatches whose hasChanOutputs() returns true.
+     */
+    short** chanOutBuf;
+
+    /**
+     * allocate zeroed sample memory.
+     * the memory is left untouched, so the system only maps the pages which are
+     * actually written to.
+     * free with freeSampleMem().
+     */
+    static void* allocSampleMem(size_t len);
+
+    /**
+     * free memory allocated with allocSampleMem().
+     */
+    static void freeSampleMem(void* mem);
+
+    /**
+     * clear sample memory, writing only to the blocks which aren't already zero.
+     * use this instead of memset() to keep unused parts of the memory unmapped.
+     */
+    static void clearSampleMem(void* mem, size_t len);
+
+    /**
+     * make a state save by copying the whole dispatch.
+     * for dispatches whose state (including the emulation core) is held by value.
+     * the register write log is not copied.
+     * @param self the dispatch.
+     * @return a copy of it, to be returned by getState().
+     */
+    template<typename T> static T* copyStateOf(const T* self) {
+      T* ret=new T(*self);
+      ((DivDispatch*)ret)->regWrites.clear();
+      ((DivDispatch*)ret)->regWrites.shrink_to_fit();
+      return ret;
+    }
+
+    /**
+     * restore a state save made by copyStateOf().
+     * the register write log and write flags of the dispatch are kept.
+     * @param self the dispatch.
+     * @param state the state.
+     */
+    template<typename T> static void restoreStateOf(T* self, const T* state) {
+      DivDispatch* base=(DivDispatch*)self;
+      std::vector<DivRegWrite> keepWrites;
+      keepWrites.swap(base->regWrites);
+      bool keepSkip=base->skipRegisterWrites;
+      bool keepDump=base->dumpWrites;
+      short** keepChanOut=base->chanOutBuf;
+      *self=*state;
+      base->regWrites.swap(keepWrites);
+      base->skipRegisterWrites=keepSkip;
+      base->dumpWrites=keepDump;
+      base->chanOutBuf=keepChanOut;
+    }
   public:
     /**
      * the rate the samples are provided.
@@ -785,18 +888,37 @@ class DivDispatch {
     virtual int getRegisterPoolDepth();
 
     /**
-     * get this dispatch's state. DO NOT IMPLEMENT YET.
-     * @return a pointer to the dispatch's state. must be deallocated manually!
+     * check whether writing a register with the value it already holds has no effect.
+     * this is used by VGM export to drop redundant writes.
+     * registers with side effects (key on, data ports, latches, envelope restart) must return false.
+     * @param addr the address, as in getRegisterWrites().
+     * @return whether a repeated write may be dropped. the default is false.
+     */
+    virtual bool isRegWriteIdempotent(unsigned int addr);
+
+    /**
+     * get this dispatch's state.
+     * this is used by the seek snapshot cache and render-ahead re-rendering. the state does not include mute status.
+     * only Pong, Pokémon Mini, PET and PV-1000 support state saves so far. both features
+     * do nothing in songs with any other chip.
+     * @return a pointer to a copy of the dispatch's state, or NULL if this dispatch does not support state saves.
+     * must be deallocated using freeState()!
      */
     virtual void* getState();
 
     /**
-     * set this dispatch's state. DO NOT IMPLEMENT YET.
-     * @param state a pointer to a state pertaining to this dispatch,
-     * or NULL if this dispatch does not support state saves.
+     * set this dispatch's state.
+     * the state is copied, so it remains owned by the caller.
+     * @param state a pointer to a state returned by getState() on this dispatch.
      */
     virtual void setState(void* state);
 
+    /**
+     * deallocate a state returned by getState().
+     * @param state the state.
+     */
+    virtual void freeState(void* state);
+
     /**
      * mute a channel.
      * @param ch the channel to mute.
@@ -890,6 +1012,26 @@ class DivDispatch {
      */
     virtual bool hasAcquireDirect();
 
+    /**
+     * check whether acquire() can write the output of every channel on its own
+     * (see setChanOutputs()).
+     * only for chips whose output is the sum of the output of their channels.
+     * currently only PCM DAC and Dummy System can.
+     * @return whether it can.
+     */
+    virtual bool hasChanOutputs();
+
+    /**
+     * set the per-channel output buffers.
+     * when not NULL, acquire() writes the output of channel ch to
+     * bufs[ch*getOutputCount()+output] alongside buf, on the same scale (muted
+     * channels write silence).
+     * @param bufs the buffers (as many as getOutputCount() times the number of
+     * channels, each as long as buf), or NULL to stop writing them.
+     * @return false if the chip can't (hasChanOutputs() is false). the buffers are not used then.
+     */
+    bool setChanOutputs(short** bufs);
+
     /**
      * get minimum chip clock.
      * @return clock in Hz, or 0 if custom clocks are not supported.
@@ -958,6 +1100,12 @@ class DivDispatch {
      */
     std::vector<DivRegWrite>& getRegisterWrites();
 
+    /**
+     * get the number of register writes since the last call, and reset it.
+     * this is used by the profiler.
+     */
+    unsigned int takeWriteCount();
+
     /**
      * poke a register.
      * @param addr address.
@@ -1040,6 +1188,15 @@ class DivDispatch {
      */
     virtual void renderSamples(int sysID);
 
+    /**
+     * copy the sample memory of another instance of the same chip, instead of rendering it.
+     * the engine only calls this when both chips have the same type, flags and samples, so
+     * the result would be identical to renderSamples().
+     * @param other the dispatch to copy from. it is of the same class as this one.
+     * @return whether this is supported. if false, renderSamples() will be called instead.
+     */
+    virtual bool copySamplesFrom(DivDispatch* other);
+
     /**
      * tell this DivDispatch that the tuning and/or pitch linearity has changed, and therefore the pitch table must be regenerated.
      */
@@ -1060,6 +1217,9 @@ class DivDispatch {
      */
     virtual void quit();
 
+    DivDispatch():
+      writeCount(0),
+      chanOutBuf(NULL) {}
     virtual ~DivDispatch();
 };
 
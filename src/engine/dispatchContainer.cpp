@@ -98,6 +98,8 @@
 #include "platform/dummy.h"
 #include "../ta-log.h"
 #include "song.h"
+#include "trace.h"
+#include <math.h>
 
 void DivDispatchContainer::setRates(double gotRate) {
   int outs=dispatch->getOutputCount();
@@ -106,7 +108,14 @@ void DivDispatchContainer::setRates(double gotRate) {
     if (bb[i]==NULL) continue;
     blip_set_rates(bb[i],dispatch->rate,gotRate);
   }
+  for (blip_buffer_t* i: chanBB) {
+    blip_set_rates(i,dispatch->rate,gotRate);
+  }
   rateMemory=gotRate;
+  updateResamplers();
+  // per-channel outputs aren't resampled with DivResampler
+  if (!chanBB.empty() && rs[0]!=NULL) setChanOutputs(0);
+  if (reservedLen>0) reserve(reservedLen);
 }
 
 void DivDispatchContainer::setQuality(bool lowQual, bool dcHiPass) {
@@ -116,6 +125,35 @@ void DivDispatchContainer::setQuality(bool lowQual, bool dcHiPass) {
     if (bb[i]==NULL) continue;
     blip_set_dc(bb[i],dcHiPass);
   }
+  for (blip_buffer_t* i: chanBB) {
+    blip_set_dc(i,dcHiPass);
+  }
+  for (int i=0; i<DIV_MAX_OUTPUTS; i++) {
+    if (rs[i]==NULL) continue;
+    rs[i]->setQuality(lowQual);
+    rs[i]->setHighPass(dcHiPass);
+  }
+}
+
+void DivDispatchContainer::updateResamplers() {
+  if (dispatch==NULL) return;
+  int outs=dispatch->getOutputCount();
+  // chips with acquireDirect() write into the blip buffers themselves
+  bool useRS=(allowResampler && !dispatch->hasAcquireDirect() && rateMemory>0.0 && dispatch->rate>=rateMemory*DIV_RESAMPLER_MIN_RATIO);
+
+  for (int i=0; i<DIV_MAX_OUTPUTS; i++) {
+    if (useRS && i<outs) {
+      if (rs[i]==NULL) {
+        rs[i]=new DivResampler;
+        rs[i]->setQuality(lowQuality);
+        rs[i]->setHighPass(hiPass);
+      }
+      rs[i]->setRates(dispatch->rate,rateMemory);
+    } else if (rs[i]!=NULL) {
+      delete rs[i];
+      rs[i]=NULL;
+    }
+  }
 }
 
 void DivDispatchContainer::grow(size_t size) {
@@ -126,36 +164,66 @@ void DivDispatchContainer::grow(size_t size) {
       bbIn[i]=new short[bbInLen];
     }
   }
+  for (short*& i: chanBBIn) {
+    delete[] i;
+    i=new short[bbInLen];
+  }
+}
+
+int DivDispatchContainer::createMissingBufs() {
+  int outs=dispatch->getOutputCount();
+
+  bool mustClear=false;
+  for (int i=0; i<outs; i++) {
+    if (bb[i]==NULL) {
+      logV("creating buf %d because it doesn't exist",i);
+      bb[i]=blip_new(bbInLen);
+      if (bb[i]==NULL) {
+        logE("not enough memory!");
+        return -1;
+      }
+      blip_set_dc(bb[i],hiPass);
+      blip_set_rates(bb[i],dispatch->rate,rateMemory);
+
+      if (bbIn[i]==NULL) bbIn[i]=new short[bbInLen];
+      if (bbOut[i]==NULL) bbOut[i]=new short[bbInLen];
+      memset(bbIn[i],0,bbInLen*sizeof(short));
+      memset(bbOut[i],0,bbInLen*sizeof(short));
+      mustClear=true;
+    }
+  }
+  if (mustClear) clear();
+  return outs;
+}
+
+void DivDispatchContainer::reserve(size_t outLen) {
+  if (dispatch==NULL) return;
+  reservedLen=outLen;
+  if (createMissingBufs()<0) return;
+
+  // the same estimate as blip_clocks_needed(), plus the margin run() adds
+  if (rateMemory>0.0) {
+    size_t need=(size_t)ceil((double)outLen*dispatch->rate/rateMemory)+512;
+    if (need>bbInLen) {
+      logD("reserving %d samples for dispatch %p bbIn",(int)need,(void*)this);
+      grow(need);
+    }
+  }
+  for (int i=0; i<DIV_MAX_OUTPUTS; i++) {
+    if (rs[i]!=NULL) rs[i]->reserve(outLen);
+  }
+  if (deferred.capacity()<DIV_DEFERRED_RESERVE) deferred.reserve(DIV_DEFERRED_RESERVE);
 }
 
+// create missing buffers if any
 #define CHECK_MISSING_BUFS \
-  int outs=dispatch->getOutputCount(); \
- \
-  /* create missing buffers if any */ \
-  bool mustClear=false; \
-  for (int i=0; i<outs; i++) { \
-    if (bb[i]==NULL) { \
-      logV("creating buf %d because it doesn't exist",i); \
-      bb[i]=blip_new(bbInLen); \
-      if (bb[i]==NULL) { \
-        logE("not enough memory!"); \
-        return; \
-      } \
-      blip_set_dc(bb[i],hiPass); \
-      blip_set_rates(bb[i],dispatch->rate,rateMemory); \
- \
-      if (bbIn[i]==NULL) bbIn[i]=new short[bbInLen]; \
-      if (bbOut[i]==NULL) bbOut[i]=new short[bbInLen]; \
-      memset(bbIn[i],0,bbInLen*sizeof(short)); \
-      memset(bbOut[i],0,bbInLen*sizeof(short)); \
-      mustClear=true; \
-    } \
-  } \
-  if (mustClear) clear(); \
+  int outs=createMissingBufs(); \
+  if (outs<0) return;
 
 void DivDispatchContainer::acquire(size_t count) {
   CHECK_MISSING_BUFS;
 
+  unsigned long long profBegin=divProfileNow();
   if (dispatch->hasAcquireDirect()) {
     dispatch->acquireDirect(bb,count);
   } else {
@@ -172,20 +240,32 @@ void DivDispatchContainer::acquire(size_t count) {
     }
     dispatch->acquire(bbInMapped,count);
   }
+  profTime[DIV_DISPATCH_PROFILE_ACQUIRE]+=divProfileNow()-profBegin;
+  DIV_TRACE_RECORD("acquire",name,profBegin,divProfileNow());
 }
 
 void DivDispatchContainer::flush(size_t offset, size_t count) {
   int outs=dispatch->getOutputCount();
 
   for (int i=0; i<outs; i++) {
+    if (rs[i]!=NULL) {
+      rs[i]->read(bbOut[i]+offset,count);
+      continue;
+    }
     if (bb[i]==NULL) continue;
     blip_read_samples(bb[i],bbOut[i]+offset,count,0);
   }
+  for (size_t i=0; i<chanBB.size(); i++) {
+    blip_read_samples(chanBB[i],chanBBOut[i]+offset,count,0);
+  }
 }
 
 void DivDispatchContainer::fillBuf(size_t runtotal, size_t offset, size_t size) {
   CHECK_MISSING_BUFS;
 
+  unsigned long long profBegin=divProfileNow();
+  unsigned long long profPost=0;
+
   if (!dispatch->hasAcquireDirect()) {
     if (dcOffCompensation && runtotal>0) {
       dcOffCompensation=false;
@@ -193,36 +273,274 @@ void DivDispatchContainer::fillBuf(size_t runtotal, size_t offset, size_t size)
         for (int i=0; i<outs; i++) {
           if (bbIn[i]==NULL) continue;
           prevSample[i]=bbIn[i][0];
+          if (rs[i]!=NULL) rs[i]->setDCLevel(bbIn[i][0]);
+        }
+        for (size_t i=0; i<chanBB.size(); i++) {
+          chanPrevSample[i]=chanBBIn[i][0];
         }
       }
     }
     for (int i=0; i<outs; i++) {
       if (bbIn[i]==NULL) continue;
-      if (bb[i]==NULL) continue;
-      for (size_t j=0; j<runtotal; j++) {
-        if (bbIn[i][j]==temp[i]) continue;
-        temp[i]=bbIn[i][j];
-        blip_add_delta(bb[i],j,temp[i]-prevSample[i]);
-        prevSample[i]=temp[i];
+      if (rs[i]!=NULL) {
+        rs[i]->write(bbIn[i],runtotal);
+        continue;
       }
+      if (bb[i]==NULL) continue;
+      blip_add_deltas(bb[i],bbIn[i],runtotal,&temp[i],&prevSample[i]);
+    }
+    // per-channel outputs don't go through postProcess()
+    for (size_t i=0; i<chanBB.size(); i++) {
+      blip_add_deltas(chanBB[i],chanBBIn[i],runtotal,&chanTemp[i],&chanPrevSample[i]);
+      blip_end_frame(chanBB[i],runtotal);
+      blip_read_samples(chanBB[i],chanBBOut[i]+offset,size,0);
     }
   }
 
   for (int i=0; i<outs; i++) {
     if (bbOut[i]==NULL) continue;
-    if (bb[i]==NULL) continue;
-    blip_end_frame(bb[i],runtotal);
-    blip_read_samples(bb[i],bbOut[i]+offset,size,0);
+    if (rs[i]!=NULL) {
+      rs[i]->read(bbOut[i]+offset,size);
+    } else {
+      if (bb[i]==NULL) continue;
+      blip_end_frame(bb[i],runtotal);
+      blip_read_samples(bb[i],bbOut[i]+offset,size,0);
+    }
+    unsigned long long postBegin=divProfileNow();
     dispatch->postProcess(bbOut[i]+offset,i,size,rateMemory);
+    profPost+=divProfileNow()-postBegin;
+  }
+  profTime[DIV_DISPATCH_PROFILE_POST]+=profPost;
+  profTime[DIV_DISPATCH_PROFILE_RESAMPLE]+=divProfileNow()-profBegin-profPost;
+  DIV_TRACE_RECORD("fillBuf",name,profBegin,divProfileNow());
+}
+
+void DivDispatchContainer::run() {
+  int lastAvail=(rs[0]!=NULL)?(int)rs[0]->samplesAvail():blip_samples_avail(bb[0]);
+  if (lastAvail>0) {
+    if (lastAvail>=cycles) {
+      flush(runPos,cycles);
+      runPos+=cycles;
+      return;
+    } else {
+      flush(runPos,lastAvail);
+      runPos+=lastAvail;
+      cycles-=lastAvail;
+    }
+  }
+  
+  // if the buffer is too small, resize it.
+  // this shouldn't happen on the audio thread (see reserve()).
+  int total=(rs[0]!=NULL)?(int)rs[0]->inputNeeded(cycles):blip_clocks_needed(bb[0],cycles);
+  if (total>(int)bbInLen) {
+    logD("growing dispatch %p bbIn to %d",(void*)this,total+256);
+    grow(total+256);
+  }
+  acquire(total);
+  fillBuf(total,runPos,cycles);
+  // advance run position
+  runPos+=cycles;
+}
+
+// commands whose effect is fully replaced by a later one of the same kind on the same channel.
+static bool cmdIsSuperseded(DivDispatchCmds cmd) {
+  switch (cmd) {
+    case DIV_CMD_VOLUME:
+    case DIV_CMD_PITCH:
+    case DIV_CMD_PANNING:
+      return true;
+    default:
+      break;
+  }
+  return false;
+}
+
+int DivDispatchContainer::sendCmd(const DivCommand& c, bool hold) {
+  if (hasHeldCmd) {
+    if (hold && heldCmd.cmd==c.cmd && heldCmd.chan==c.chan) {
+      heldCmd=c;
+      return 1;
+    }
+    flushHeldCmd();
+  }
+  if (hold && cmdIsSuperseded(c.cmd)) {
+    heldCmd=c;
+    hasHeldCmd=true;
+    return 1;
+  }
+  return dispatch->dispatch(c);
+}
+
+void DivDispatchContainer::flushHeldCmd() {
+  if (!hasHeldCmd) return;
+  hasHeldCmd=false;
+  dispatch->dispatch(heldCmd);
+}
+
+void DivDispatchContainer::defer(unsigned int pos, const DivCommand& c) {
+  if (deferred.size()>deferredPos && cmdIsSuperseded(c.cmd)) {
+    DivDeferredCmd& last=deferred.back();
+    if (!last.isTick && last.pos==pos && last.cmd.cmd==c.cmd && last.cmd.chan==c.chan) {
+      last.cmd=c;
+      return;
+    }
+  }
+  deferred.push_back(DivDeferredCmd(pos,c));
+}
+
+void DivDispatchContainer::deferTick(unsigned int pos, bool sysTick) {
+  deferred.push_back(DivDeferredCmd(pos,sysTick));
+}
+
+void DivDispatchContainer::runDeferred(size_t until) {
+  while (deferredPos<deferred.size()) {
+    DivDeferredCmd& d=deferred[deferredPos];
+    if (d.pos>until) break;
+    // render up to the command's position
+    if (d.pos>runPos) {
+      cycles=d.pos-runPos;
+      run();
+    }
+    if (d.isTick) {
+      dispatch->tick(d.sysTick);
+    } else {
+      dispatch->dispatch(d.cmd);
+    }
+    deferredPos++;
+  }
+  if (deferredPos>=deferred.size()) {
+    // clear() keeps the capacity, so this won't allocate again
+    deferred.clear();
+    deferredPos=0;
+  }
+  if (until>runPos) {
+    cycles=until-runPos;
+    run();
+  }
+}
+
+bool DivDispatchContainer::setChanOutputs(int chanCount) {
+  if (dispatch==NULL) return false;
+  dispatch->setChanOutputs(NULL);
+  for (blip_buffer_t* i: chanBB) {
+    blip_delete(i);
+  }
+  for (short* i: chanBBIn) {
+    delete[] i;
+  }
+  for (short* i: chanBBOut) {
+    delete[] i;
+  }
+  chanBB.clear();
+  chanBBIn.clear();
+  chanBBOut.clear();
+  chanTemp.clear();
+  chanPrevSample.clear();
+  if (chanCount<=0) return true;
+
+  if (!dispatch->hasChanOutputs() || dispatch->hasAcquireDirect() || rs[0]!=NULL) return false;
+  int outs=createMissingBufs();
+  if (outs<0) return false;
+
+  size_t count=chanCount*outs;
+  size_t outLen=MAX(bbInLen,reservedLen);
+  for (size_t i=0; i<count; i++) {
+    blip_buffer_t* b=blip_new(bbInLen);
+    if (b==NULL) {
+      logE("not enough memory!");
+      setChanOutputs(0);
+      return false;
+    }
+    blip_set_dc(b,hiPass);
+    blip_set_rates(b,dispatch->rate,rateMemory);
+    chanBB.push_back(b);
+    chanBBIn.push_back(new short[bbInLen]);
+    chanBBOut.push_back(new short[outLen]);
+    memset(chanBBIn[i],0,bbInLen*sizeof(short));
+    memset(chanBBOut[i],0,outLen*sizeof(short));
   }
+  chanTemp.resize(count,0);
+  chanPrevSample.resize(count,0);
+  if (!dispatch->setChanOutputs(chanBBIn.data())) {
+    setChanOutputs(0);
+    return false;
+  }
+  return true;
+}
+
+bool DivDispatchContainer::saveState(DivDispatchContainerState& state) {
+  if (dispatch==NULL) return false;
+  if (!chanBB.empty() || deferred.size()>deferredPos) return false;
+  for (int i=0; i<DIV_MAX_OUTPUTS; i++) {
+    if (bb[i]!=NULL) {
+      state.bb[i]=blip_clone(bb[i]);
+      if (state.bb[i]==NULL) {
+        freeState(state);
+        return false;
+      }
+    }
+    if (rs[i]!=NULL) state.rs[i]=new DivResampler(*rs[i]);
+    state.temp[i]=temp[i];
+    state.prevSample[i]=prevSample[i];
+  }
+  state.dcOffCompensation=dcOffCompensation;
+  state.heldCmd=heldCmd;
+  state.hasHeldCmd=hasHeldCmd;
+  return true;
+}
+
+void DivDispatchContainer::restoreState(const DivDispatchContainerState& state) {
+  for (int i=0; i<DIV_MAX_OUTPUTS; i++) {
+    if (bb[i]!=NULL && state.bb[i]!=NULL) {
+      blip_copy(bb[i],state.bb[i]);
+    }
+    if (rs[i]!=NULL && state.rs[i]!=NULL) {
+      *rs[i]=*state.rs[i];
+    }
+    temp[i]=state.temp[i];
+    prevSample[i]=state.prevSample[i];
+  }
+  dcOffCompensation=state.dcOffCompensation;
+  heldCmd=state.heldCmd;
+  hasHeldCmd=state.hasHeldCmd;
+}
+
+void DivDispatchContainer::freeState(DivDispatchContainerState& state) {
+  for (int i=0; i<DIV_MAX_OUTPUTS; i++) {
+    if (state.bb[i]!=NULL) {
+      blip_delete(state.bb[i]);
+      state.bb[i]=NULL;
+    }
+    if (state.rs[i]!=NULL) {
+      delete state.rs[i];
+      state.rs[i]=NULL;
+    }
+  }
+}
+
+unsigned int DivDispatchContainer::takeDeltaCount() {
+  unsigned int ret=0;
+  for (int i=0; i<DIV_MAX_OUTPUTS; i++) {
+    if (bb[i]!=NULL) ret+=blip_take_deltas(bb[i]);
+  }
+  for (blip_buffer_t* i: chanBB) {
+    ret+=blip_take_deltas(i);
+  }
+  return ret;
 }
 
 void DivDispatchContainer::clear() {
   for (int i=0; i<DIV_MAX_OUTPUTS; i++) {
     if (bb[i]!=NULL) blip_clear(bb[i]);
+    if (rs[i]!=NULL) rs[i]->clear();
     temp[i]=0;
     prevSample[i]=0;
   }
+  for (size_t i=0; i<chanBB.size(); i++) {
+    blip_clear(chanBB[i]);
+    chanTemp[i]=0;
+    chanPrevSample[i]=0;
+  }
 
   if (dispatch->getDCOffRequired() && hiPass) {
     dcOffCompensation=true;
@@ -233,6 +551,8 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
   // quit if we already initialized
   if (dispatch!=NULL) return;
 
+  name=eng->getSystemName(sys);
+
   // initialize chip
   switch (sys) {
     case DIV_SYSTEM_YMU759:
@@ -244,7 +564,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       if (isRender) {
         ((DivPlatformGenesis*)dispatch)->setYMFM(eng->getConfInt("ym2612CoreRender",0));
       } else {
-        ((DivPlatformGenesis*)dispatch)->setYMFM(eng->getConfInt("ym2612Core",0));
+        ((DivPlatformGenesis*)dispatch)->setYMFM(eng->getCoreConf("ym2612Core",0));
       }
       ((DivPlatformGenesis*)dispatch)->setSoftPCM(false);
       break;
@@ -253,7 +573,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       if (isRender) {
         ((DivPlatformGenesisExt*)dispatch)->setYMFM(eng->getConfInt("ym2612CoreRender",0));
       } else {
-        ((DivPlatformGenesisExt*)dispatch)->setYMFM(eng->getConfInt("ym2612Core",0));
+        ((DivPlatformGenesisExt*)dispatch)->setYMFM(eng->getCoreConf("ym2612Core",0));
       }
       ((DivPlatformGenesisExt*)dispatch)->setSoftPCM(false);
       break;
@@ -262,7 +582,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       if (isRender) {
         ((DivPlatformGenesisExt*)dispatch)->setYMFM(eng->getConfInt("ym2612CoreRender",0));
       } else {
-        ((DivPlatformGenesisExt*)dispatch)->setYMFM(eng->getConfInt("ym2612Core",0));
+        ((DivPlatformGenesisExt*)dispatch)->setYMFM(eng->getCoreConf("ym2612Core",0));
       }
       ((DivPlatformGenesisExt*)dispatch)->setSoftPCM(false);
       ((DivPlatformGenesisExt*)dispatch)->setCSMChannel(6);
@@ -272,7 +592,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       if (isRender) {
         ((DivPlatformGenesis*)dispatch)->setYMFM(eng->getConfInt("ym2612CoreRender",0));
       } else {
-        ((DivPlatformGenesis*)dispatch)->setYMFM(eng->getConfInt("ym2612Core",0));
+        ((DivPlatformGenesis*)dispatch)->setYMFM(eng->getCoreConf("ym2612Core",0));
       }
       ((DivPlatformGenesis*)dispatch)->setSoftPCM(true);
       break;
@@ -281,7 +601,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       if (isRender) {
         ((DivPlatformGenesisExt*)dispatch)->setYMFM(eng->getConfInt("ym2612CoreRender",0));
       } else {
-        ((DivPlatformGenesisExt*)dispatch)->setYMFM(eng->getConfInt("ym2612Core",0));
+        ((DivPlatformGenesisExt*)dispatch)->setYMFM(eng->getCoreConf("ym2612Core",0));
       }
       ((DivPlatformGenesisExt*)dispatch)->setSoftPCM(true);
       break;
@@ -290,7 +610,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       if (isRender) {
         ((DivPlatformSMS*)dispatch)->setNuked(eng->getConfInt("snCoreRender",0));
       } else {
-        ((DivPlatformSMS*)dispatch)->setNuked(eng->getConfInt("snCore",0));
+        ((DivPlatformSMS*)dispatch)->setNuked(eng->getCoreConf("snCore",0));
       }
       break;
     case DIV_SYSTEM_GB:
@@ -298,7 +618,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       if (isRender) {
         ((DivPlatformGB*)dispatch)->setCoreQuality(eng->getConfInt("gbQualityRender",3));
       } else {
-        ((DivPlatformGB*)dispatch)->setCoreQuality(eng->getConfInt("gbQuality",3));
+        ((DivPlatformGB*)dispatch)->setCoreQuality(eng->getCoreConf("gbQuality",3));
       }
       break;
     case DIV_SYSTEM_PCE:
@@ -309,7 +629,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       if (isRender) {
         ((DivPlatformNES*)dispatch)->setNSFPlay(eng->getConfInt("nesCoreRender",0)==1);
       } else {
-        ((DivPlatformNES*)dispatch)->setNSFPlay(eng->getConfInt("nesCore",0)==1);
+        ((DivPlatformNES*)dispatch)->setNSFPlay(eng->getCoreConf("nesCore",0)==1);
       }
       ((DivPlatformNES*)dispatch)->set5E01(false);
       break;
@@ -320,8 +640,8 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
         ((DivPlatformC64*)dispatch)->setCore(eng->getConfInt("c64CoreRender",1));
         ((DivPlatformC64*)dispatch)->setCoreQuality(eng->getConfInt("dsidQualityRender",3));
       } else {
-        ((DivPlatformC64*)dispatch)->setCore(eng->getConfInt("c64Core",0));
-        ((DivPlatformC64*)dispatch)->setCoreQuality(eng->getConfInt("dsidQuality",3));
+        ((DivPlatformC64*)dispatch)->setCore(eng->getCoreConf("c64Core",0));
+        ((DivPlatformC64*)dispatch)->setCoreQuality(eng->getCoreConf("dsidQuality",3));
       }
       ((DivPlatformC64*)dispatch)->setChipModel(true);
       ((DivPlatformC64*)dispatch)->setSoftPCM(sys==DIV_SYSTEM_C64_PCM);
@@ -332,8 +652,8 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
         ((DivPlatformC64*)dispatch)->setCore(eng->getConfInt("c64CoreRender",1));
         ((DivPlatformC64*)dispatch)->setCoreQuality(eng->getConfInt("dsidQualityRender",3));
       } else {
-        ((DivPlatformC64*)dispatch)->setCore(eng->getConfInt("c64Core",0));
-        ((DivPlatformC64*)dispatch)->setCoreQuality(eng->getConfInt("dsidQuality",3));
+        ((DivPlatformC64*)dispatch)->setCore(eng->getCoreConf("c64Core",0));
+        ((DivPlatformC64*)dispatch)->setCoreQuality(eng->getCoreConf("dsidQuality",3));
       }
       ((DivPlatformC64*)dispatch)->setChipModel(false);
       ((DivPlatformC64*)dispatch)->setSoftPCM(false);
@@ -343,7 +663,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       if (isRender) {
         ((DivPlatformArcade*)dispatch)->setYMFM(eng->getConfInt("arcadeCoreRender",1)==0);
       } else {
-        ((DivPlatformArcade*)dispatch)->setYMFM(eng->getConfInt("arcadeCore",0)==0);
+        ((DivPlatformArcade*)dispatch)->setYMFM(eng->getCoreConf("arcadeCore",0)==0);
       }
       break;
     case DIV_SYSTEM_YM2610_FULL:
@@ -351,7 +671,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       if (isRender) {
         ((DivPlatformYM2610*)dispatch)->setCombo(eng->getConfInt("opnbCoreRender",1));
       } else {
-        ((DivPlatformYM2610*)dispatch)->setCombo(eng->getConfInt("opnbCore",1));
+        ((DivPlatformYM2610*)dispatch)->setCombo(eng->getCoreConf("opnbCore",1));
       }
       break;
     case DIV_SYSTEM_YM2610_FULL_EXT:
@@ -359,7 +679,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       if (isRender) {
         ((DivPlatformYM2610Ext*)dispatch)->setCombo(eng->getConfInt("opnbCoreRender",1));
       } else {
-        ((DivPlatformYM2610Ext*)dispatch)->setCombo(eng->getConfInt("opnbCore",1));
+        ((DivPlatformYM2610Ext*)dispatch)->setCombo(eng->getCoreConf("opnbCore",1));
       }
       ((DivPlatformYM2610Ext*)dispatch)->setCSM(0);
       break;
@@ -368,7 +688,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       if (isRender) {
         ((DivPlatformYM2610Ext*)dispatch)->setCombo(eng->getConfInt("opnbCoreRender",1));
       } else {
-        ((DivPlatformYM2610Ext*)dispatch)->setCombo(eng->getConfInt("opnbCore",1));
+        ((DivPlatformYM2610Ext*)dispatch)->setCombo(eng->getCoreConf("opnbCore",1));
       }
       ((DivPlatformYM2610Ext*)dispatch)->setCSM(1);
       break;
@@ -377,7 +697,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       if (isRender) {
         ((DivPlatformYM2610B*)dispatch)->setCombo(eng->getConfInt("opnbCoreRender",1));
       } else {
-        ((DivPlatformYM2610B*)dispatch)->setCombo(eng->getConfInt("opnbCore",1));
+        ((DivPlatformYM2610B*)dispatch)->setCombo(eng->getCoreConf("opnbCore",1));
       }
       break;
     case DIV_SYSTEM_YM2610B_EXT:
@@ -385,7 +705,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       if (isRender) {
         ((DivPlatformYM2610BExt*)dispatch)->setCombo(eng->getConfInt("opnbCoreRender",1));
       } else {
-        ((DivPlatformYM2610BExt*)dispatch)->setCombo(eng->getConfInt("opnbCore",1));
+        ((DivPlatformYM2610BExt*)dispatch)->setCombo(eng->getCoreConf("opnbCore",1));
       }
       ((DivPlatformYM2610BExt*)dispatch)->setCSM(0);
       break;
@@ -394,7 +714,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       if (isRender) {
         ((DivPlatformYM2610BExt*)dispatch)->setCombo(eng->getConfInt("opnbCoreRender",1));
       } else {
-        ((DivPlatformYM2610BExt*)dispatch)->setCombo(eng->getConfInt("opnbCore",1));
+        ((DivPlatformYM2610BExt*)dispatch)->setCombo(eng->getCoreConf("opnbCore",1));
       }
       ((DivPlatformYM2610BExt*)dispatch)->setCSM(1);
       break;
@@ -406,7 +726,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       if (isRender) {
         ((DivPlatformAY8910*)dispatch)->setCore(eng->getConfInt("ayCoreRender",0)==1);
       } else {
-        ((DivPlatformAY8910*)dispatch)->setCore(eng->getConfInt("ayCore",0)==1);
+        ((DivPlatformAY8910*)dispatch)->setCore(eng->getCoreConf("ayCore",0)==1);
       }
       break;
     case DIV_SYSTEM_AY8930:
@@ -417,7 +737,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       if (isRender) {
         ((DivPlatformFDS*)dispatch)->setNSFPlay(eng->getConfInt("fdsCoreRender",1)==1);
       } else {
-        ((DivPlatformFDS*)dispatch)->setNSFPlay(eng->getConfInt("fdsCore",0)==1);
+        ((DivPlatformFDS*)dispatch)->setNSFPlay(eng->getCoreConf("fdsCore",0)==1);
       }
       break;
     case DIV_SYSTEM_TIA:
@@ -428,7 +748,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       if (isRender) {
         ((DivPlatformYM2203*)dispatch)->setCombo(eng->getConfInt("opn1CoreRender",1));
       } else {
-        ((DivPlatformYM2203*)dispatch)->setCombo(eng->getConfInt("opn1Core",1));
+        ((DivPlatformYM2203*)dispatch)->setCombo(eng->getCoreConf("opn1Core",1));
       }
       break;
     case DIV_SYSTEM_YM2203_EXT:
@@ -436,7 +756,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       if (isRender) {
         ((DivPlatformYM2203Ext*)dispatch)->setCombo(eng->getConfInt("opn1CoreRender",1));
       } else {
-        ((DivPlatformYM2203Ext*)dispatch)->setCombo(eng->getConfInt("opn1Core",1));
+        ((DivPlatformYM2203Ext*)dispatch)->setCombo(eng->getCoreConf("opn1Core",1));
       }
       ((DivPlatformYM2203Ext*)dispatch)->setCSM(0);
       break;
@@ -445,7 +765,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       if (isRender) {
         ((DivPlatformYM2203Ext*)dispatch)->setCombo(eng->getConfInt("opn1CoreRender",1));
       } else {
-        ((DivPlatformYM2203Ext*)dispatch)->setCombo(eng->getConfInt("opn1Core",1));
+        ((DivPlatformYM2203Ext*)dispatch)->setCombo(eng->getCoreConf("opn1Core",1));
       }
       ((DivPlatformYM2203Ext*)dispatch)->setCSM(1);
       break;
@@ -454,7 +774,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       if (isRender) {
         ((DivPlatformYM2608*)dispatch)->setCombo(eng->getConfInt("opnaCoreRender",1));
       } else {
-        ((DivPlatformYM2608*)dispatch)->setCombo(eng->getConfInt("opnaCore",1));
+        ((DivPlatformYM2608*)dispatch)->setCombo(eng->getCoreConf("opnaCore",1));
       }
       break;
     case DIV_SYSTEM_YM2608_EXT:
@@ -462,7 +782,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       if (isRender) {
         ((DivPlatformYM2608Ext*)dispatch)->setCombo(eng->getConfInt("opnaCoreRender",1));
       } else {
-        ((DivPlatformYM2608Ext*)dispatch)->setCombo(eng->getConfInt("opnaCore",1));
+        ((DivPlatformYM2608Ext*)dispatch)->setCombo(eng->getCoreConf("opnaCore",1));
       }
       ((DivPlatformYM2608Ext*)dispatch)->setCSM(0);
       break;
@@ -471,7 +791,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       if (isRender) {
         ((DivPlatformYM2608Ext*)dispatch)->setCombo(eng->getConfInt("opnaCoreRender",1));
       } else {
-        ((DivPlatformYM2608Ext*)dispatch)->setCombo(eng->getConfInt("opnaCore",1));
+        ((DivPlatformYM2608Ext*)dispatch)->setCombo(eng->getCoreConf("opnaCore",1));
       }
       ((DivPlatformYM2608Ext*)dispatch)->setCSM(1);
       break;
@@ -482,7 +802,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       if (isRender) {
         ((DivPlatformOPLL*)dispatch)->setCore(eng->getConfInt("opllCoreRender",0));
       } else {
-        ((DivPlatformOPLL*)dispatch)->setCore(eng->getConfInt("opllCore",0));
+        ((DivPlatformOPLL*)dispatch)->setCore(eng->getCoreConf("opllCore",0));
       }
       ((DivPlatformOPLL*)dispatch)->setVRC7(sys==DIV_SYSTEM_VRC7);
       ((DivPlatformOPLL*)dispatch)->setProperDrums(sys==DIV_SYSTEM_OPLL_DRUMS);
@@ -493,7 +813,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       if (isRender) {
         ((DivPlatformOPL*)dispatch)->setCore(eng->getConfInt("opl2CoreRender",0));
       } else {
-        ((DivPlatformOPL*)dispatch)->setCore(eng->getConfInt("opl2Core",0));
+        ((DivPlatformOPL*)dispatch)->setCore(eng->getCoreConf("opl2Core",0));
       }
       break;
     case DIV_SYSTEM_OPL_DRUMS:
@@ -502,7 +822,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       if (isRender) {
         ((DivPlatformOPL*)dispatch)->setCore(eng->getConfInt("opl2CoreRender",0));
       } else {
-        ((DivPlatformOPL*)dispatch)->setCore(eng->getConfInt("opl2Core",0));
+        ((DivPlatformOPL*)dispatch)->setCore(eng->getCoreConf("opl2Core",0));
       }
       break;
     case DIV_SYSTEM_OPL2:
@@ -511,7 +831,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       if (isRender) {
         ((DivPlatformOPL*)dispatch)->setCore(eng->getConfInt("opl2CoreRender",0));
       } else {
-        ((DivPlatformOPL*)dispatch)->setCore(eng->getConfInt("opl2Core",0));
+        ((DivPlatformOPL*)dispatch)->setCore(eng->getCoreConf("opl2Core",0));
       }
       break;
     case DIV_SYSTEM_OPL2_DRUMS:
@@ -520,7 +840,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       if (isRender) {
         ((DivPlatformOPL*)dispatch)->setCore(eng->getConfInt("opl2CoreRender",0));
       } else {
-        ((DivPlatformOPL*)dispatch)->setCore(eng->getConfInt("opl2Core",0));
+        ((DivPlatformOPL*)dispatch)->setCore(eng->getCoreConf("opl2Core",0));
       }
       break;
     case DIV_SYSTEM_OPL3:
@@ -529,7 +849,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       if (isRender) {
         ((DivPlatformOPL*)dispatch)->setCore(eng->getConfInt("opl3CoreRender",0));
       } else {
-        ((DivPlatformOPL*)dispatch)->setCore(eng->getConfInt("opl3Core",0));
+        ((DivPlatformOPL*)dispatch)->setCore(eng->getCoreConf("opl3Core",0));
       }
       break;
     case DIV_SYSTEM_OPL3_DRUMS:
@@ -538,7 +858,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       if (isRender) {
         ((DivPlatformOPL*)dispatch)->setCore(eng->getConfInt("opl3CoreRender",0));
       } else {
-        ((DivPlatformOPL*)dispatch)->setCore(eng->getConfInt("opl3Core",0));
+        ((DivPlatformOPL*)dispatch)->setCore(eng->getCoreConf("opl3Core",0));
       }
       break;
     case DIV_SYSTEM_Y8950:
@@ -547,7 +867,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       if (isRender) {
         ((DivPlatformOPL*)dispatch)->setCore(eng->getConfInt("opl2CoreRender",0));
       } else {
-        ((DivPlatformOPL*)dispatch)->setCore(eng->getConfInt("opl2Core",0));
+        ((DivPlatformOPL*)dispatch)->setCore(eng->getCoreConf("opl2Core",0));
       }
       break;
     case DIV_SYSTEM_Y8950_DRUMS:
@@ -556,7 +876,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       if (isRender) {
         ((DivPlatformOPL*)dispatch)->setCore(eng->getConfInt("opl2CoreRender",0));
       } else {
-        ((DivPlatformOPL*)dispatch)->setCore(eng->getConfInt("opl2Core",0));
+        ((DivPlatformOPL*)dispatch)->setCore(eng->getCoreConf("opl2Core",0));
       }
       break;
     case DIV_SYSTEM_OPZ:
@@ -567,7 +887,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       if (isRender) {
         ((DivPlatformSAA1099*)dispatch)->setCoreQuality(eng->getConfInt("saaQualityRender",3));
       } else {
-        ((DivPlatformSAA1099*)dispatch)->setCoreQuality(eng->getConfInt("saaQuality",3));
+        ((DivPlatformSAA1099*)dispatch)->setCoreQuality(eng->getCoreConf("saaQuality",3));
       }
       break;
     }
@@ -739,7 +1059,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       if (isRender) {
         ((DivPlatformESFM*)dispatch)->setFast(eng->getConfInt("esfmCoreRender",0));
       } else {
-        ((DivPlatformESFM*)dispatch)->setFast(eng->getConfInt("esfmCore",0));
+        ((DivPlatformESFM*)dispatch)->setFast(eng->getCoreConf("esfmCore",0));
       }
       break;
     case DIV_SYSTEM_POWERNOISE:
@@ -747,7 +1067,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       if (isRender) {
         ((DivPlatformPowerNoise*)dispatch)->setCoreQuality(eng->getConfInt("pnQualityRender",3));
       } else {
-        ((DivPlatformPowerNoise*)dispatch)->setCoreQuality(eng->getConfInt("pnQuality",3));
+        ((DivPlatformPowerNoise*)dispatch)->setCoreQuality(eng->getCoreConf("pnQuality",3));
       }
       break;
     case DIV_SYSTEM_DAVE:
@@ -761,7 +1081,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       if (isRender) {
         ((DivPlatformNES*)dispatch)->setNSFPlay(eng->getConfInt("nesCoreRender",0)==1);
       } else {
-        ((DivPlatformNES*)dispatch)->setNSFPlay(eng->getConfInt("nesCore",0)==1);
+        ((DivPlatformNES*)dispatch)->setNSFPlay(eng->getCoreConf("nesCore",0)==1);
       }
       ((DivPlatformNES*)dispatch)->set5E01(true);
       break;
@@ -777,7 +1097,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       if (isRender) {
         ((DivPlatformOPL*)dispatch)->setCore(eng->getConfInt("opl4CoreRender",0));
       } else {
-        ((DivPlatformOPL*)dispatch)->setCore(eng->getConfInt("opl4Core",0));
+        ((DivPlatformOPL*)dispatch)->setCore(eng->getCoreConf("opl4Core",0));
       }
       break;
     case DIV_SYSTEM_OPL4_DRUMS:
@@ -786,7 +1106,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       if (isRender) {
         ((DivPlatformOPL*)dispatch)->setCore(eng->getConfInt("opl4CoreRender",0));
       } else {
-        ((DivPlatformOPL*)dispatch)->setCore(eng->getConfInt("opl4Core",0));
+        ((DivPlatformOPL*)dispatch)->setCore(eng->getCoreConf("opl4Core",0));
       }
       break;
     case DIV_SYSTEM_MULTIPCM:
@@ -801,6 +1121,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       break;
   }
   dispatch->init(eng,chanCount,gotRate,flags);
+  allowResampler=eng->getConfInt("polyphaseResampler",0);
 
   // initialize output buffers
   int outs=dispatch->getOutputCount();
@@ -823,9 +1144,11 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
 
 void DivDispatchContainer::quit() {
   if (dispatch==NULL) return;
+  setChanOutputs(0);
   dispatch->quit();
   delete dispatch;
   dispatch=NULL;
+  hasHeldCmd=false;
 
   for (int i=0; i<DIV_MAX_OUTPUTS; i++) {
     if (bbOut[i]!=NULL) {
@@ -840,6 +1163,11 @@ void DivDispatchContainer::quit() {
       blip_delete(bb[i]);
       bb[i]=NULL;
     }
+    if (rs[i]!=NULL) {
+      delete rs[i];
+      rs[i]=NULL;
+    }
   }
   bbInLen=0;
+  reservedLen=0;
 }
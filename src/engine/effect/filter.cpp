@@ -0,0 +1,220 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2026 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "filter.h"
+#include <fmt/printf.h>
+#include <math.h>
+#include <string.h>
+#include <stdexcept>
+
+#define FILTER_PARAMS 4
+
+static const float filterParamMin[FILTER_PARAMS]={0.0f,10.0f,0.1f,-24.0f};
+static const float filterParamMax[FILTER_PARAMS]={DIV_EFFECT_FILTER_MAX-1,20000.0f,20.0f,24.0f};
+
+void DivEffectFilter::updateCoefs() {
+  // RBJ audio EQ cookbook
+  double freq=params[1];
+  if (freq>rate*0.49) freq=rate*0.49;
+  double w0=2.0*M_PI*freq/rate;
+  double cosW0=cos(w0);
+  double alpha=sin(w0)/(2.0*params[2]);
+  double a=pow(10.0,params[3]/40.0);
+  double sqrtA2Alpha=2.0*sqrt(a)*alpha;
+  double nb0, nb1, nb2, na0, na1, na2;
+
+  switch ((int)params[0]) {
+    case DIV_EFFECT_FILTER_HIGHPASS:
+      nb0=(1.0+cosW0)*0.5;
+      nb1=-(1.0+cosW0);
+      nb2=(1.0+cosW0)*0.5;
+      na0=1.0+alpha;
+      na1=-2.0*cosW0;
+      na2=1.0-alpha;
+      break;
+    case DIV_EFFECT_FILTER_BANDPASS:
+      nb0=alpha;
+      nb1=0.0;
+      nb2=-alpha;
+      na0=1.0+alpha;
+      na1=-2.0*cosW0;
+      na2=1.0-alpha;
+      break;
+    case DIV_EFFECT_FILTER_NOTCH:
+      nb0=1.0;
+      nb1=-2.0*cosW0;
+      nb2=1.0;
+      na0=1.0+alpha;
+      na1=-2.0*cosW0;
+      na2=1.0-alpha;
+      break;
+    case DIV_EFFECT_FILTER_PEAK:
+      nb0=1.0+alpha*a;
+      nb1=-2.0*cosW0;
+      nb2=1.0-alpha*a;
+      na0=1.0+alpha/a;
+      na1=-2.0*cosW0;
+      na2=1.0-alpha/a;
+      break;
+    case DIV_EFFECT_FILTER_LOW_SHELF:
+      nb0=a*((a+1.0)-(a-1.0)*cosW0+sqrtA2Alpha);
+      nb1=2.0*a*((a-1.0)-(a+1.0)*cosW0);
+      nb2=a*((a+1.0)-(a-1.0)*cosW0-sqrtA2Alpha);
+      na0=(a+1.0)+(a-1.0)*cosW0+sqrtA2Alpha;
+      na1=-2.0*((a-1.0)+(a+1.0)*cosW0);
+      na2=(a+1.0)+(a-1.0)*cosW0-sqrtA2Alpha;
+      break;
+    case DIV_EFFECT_FILTER_HIGH_SHELF:
+      nb0=a*((a+1.0)+(a-1.0)*cosW0+sqrtA2Alpha);
+      nb1=-2.0*a*((a-1.0)+(a+1.0)*cosW0);
+      nb2=a*((a+1.0)+(a-1.0)*cosW0-sqrtA2Alpha);
+      na0=(a+1.0)-(a-1.0)*cosW0+sqrtA2Alpha;
+      na1=2.0*((a-1.0)-(a+1.0)*cosW0);
+      na2=(a+1.0)-(a-1.0)*cosW0-sqrtA2Alpha;
+      break;
+    default: // low-pass
+      nb0=(1.0-cosW0)*0.5;
+      nb1=1.0-cosW0;
+      nb2=(1.0-cosW0)*0.5;
+      na0=1.0+alpha;
+      na1=-2.0*cosW0;
+      na2=1.0-alpha;
+      break;
+  }
+
+  b0=nb0/na0;
+  b1=nb1/na0;
+  b2=nb2/na0;
+  a1=na1/na0;
+  a2=na2/na0;
+}
+
+void DivEffectFilter::acquire(float** in, float** out, size_t len) {
+  // both channels are processed in the same loop, so that their recurrences overlap
+  float s1L=z1[0], s2L=z2[0];
+  float s1R=z1[1], s2R=z2[1];
+  const float* inL=in[0];
+  const float* inR=in[1];
+  float* outL=out[0];
+  float* outR=out[1];
+  for (size_t i=0; i<len; i++) {
+    float xL=inL[i];
+    float xR=inR[i];
+    float yL=b0*xL+s1L;
+    float yR=b0*xR+s1R;
+    s1L=b1*xL-a1*yL+s2L;
+    s1R=b1*xR-a1*yR+s2R;
+    s2L=b2*xL-a2*yL;
+    s2R=b2*xR-a2*yR;
+    outL[i]=yL;
+    outR[i]=yR;
+  }
+  // flush denormals
+  if (fabsf(s1L)<1e-20f) s1L=0.0f;
+  if (fabsf(s2L)<1e-20f) s2L=0.0f;
+  if (fabsf(s1R)<1e-20f) s1R=0.0f;
+  if (fabsf(s2R)<1e-20f) s2R=0.0f;
+  z1[0]=s1L; z2[0]=s2L;
+  z1[1]=s1R; z2[1]=s2R;
+}
+
+void DivEffectFilter::reset() {
+  memset(z1,0,2*sizeof(float));
+  memset(z2,0,2*sizeof(float));
+}
+
+int DivEffectFilter::getInputCount() {
+  return 2;
+}
+
+int DivEffectFilter::getOutputCount() {
+  return 2;
+}
+
+void DivEffectFilter::rateChanged(double r) {
+  rate=r;
+  updateCoefs();
+}
+
+String DivEffectFilter::getParam(size_t param) {
+  if (param>=FILTER_PARAMS) throw std::out_of_range("param");
+  return fmt::sprintf("%g",params[param]);
+}
+
+bool DivEffectFilter::setParam(size_t param, String value) {
+  if (param>=FILTER_PARAMS) return false;
+  float val;
+  try {
+    val=std::stof(value);
+  } catch (std::exception& e) {
+    return false;
+  }
+  if (val<filterParamMin[param]) val=filterParamMin[param];
+  if (val>filterParamMax[param]) val=filterParamMax[param];
+  params[param]=val;
+  updateCoefs();
+  return true;
+}
+
+const char* DivEffectFilter::getParams() {
+  return
+    "0:R:Type:filter type:low-pass:high-pass:band-pass:notch:peak:low shelf:high shelf\n"
+    "1:F:Frequency:cutoff or center frequency (Hz):10:20000\n"
+    "2:F:Q:resonance/bandwidth:0.1:20\n"
+    "3:F:Gain:gain of peak and shelf filters (dB):-24:24";
+}
+
+size_t DivEffectFilter::getParamCount() {
+  return FILTER_PARAMS;
+}
+
+bool DivEffectFilter::load(unsigned short version, const unsigned char* data, size_t len) {
+  if (data==NULL || len==0) return true;
+  if (version!=1 || len!=FILTER_PARAMS*sizeof(float)) return false;
+  memcpy(params,data,len);
+  for (int i=0; i<FILTER_PARAMS; i++) {
+    if (!(params[i]>=filterParamMin[i])) params[i]=filterParamMin[i];
+    if (params[i]>filterParamMax[i]) params[i]=filterParamMax[i];
+  }
+  return true;
+}
+
+unsigned char* DivEffectFilter::save(unsigned short* version, size_t* len) {
+  unsigned char* ret=new unsigned char[FILTER_PARAMS*sizeof(float)];
+  memcpy(ret,params,FILTER_PARAMS*sizeof(float));
+  *len=FILTER_PARAMS*sizeof(float);
+  *version=1;
+  return ret;
+}
+
+bool DivEffectFilter::init(DivEngine* p, double r, unsigned short version, const unsigned char* data, size_t len) {
+  parent=p;
+  rate=r;
+  params[0]=DIV_EFFECT_FILTER_LOWPASS;
+  params[1]=1000.0f;
+  params[2]=0.7071f;
+  params[3]=0.0f;
+  reset();
+  if (!load(version,data,len)) return false;
+  updateCoefs();
+  return true;
+}
+
+void DivEffectFilter::quit() {
+}
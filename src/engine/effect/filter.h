@@ -0,0 +1,64 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2026 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _EFFECT_FILTER_H
+#define _EFFECT_FILTER_H
+
+#include "../effect.h"
+
+enum DivEffectFilterType {
+  DIV_EFFECT_FILTER_LOWPASS=0,
+  DIV_EFFECT_FILTER_HIGHPASS,
+  DIV_EFFECT_FILTER_BANDPASS,
+  DIV_EFFECT_FILTER_NOTCH,
+  DIV_EFFECT_FILTER_PEAK,
+  DIV_EFFECT_FILTER_LOW_SHELF,
+  DIV_EFFECT_FILTER_HIGH_SHELF,
+
+  DIV_EFFECT_FILTER_MAX
+};
+
+// stereo biquad filter (one EQ band).
+// chain several of these to build an equalizer.
+class DivEffectFilter: public DivEffect {
+  // type, frequency (Hz), Q and gain (dB, peak/shelf only)
+  float params[4];
+  double rate;
+  // coefficients (normalized by a0)
+  float b0, b1, b2, a1, a2;
+  // transposed direct form II state of each channel
+  float z1[2], z2[2];
+  void updateCoefs();
+  public:
+    void acquire(float** in, float** out, size_t len);
+    void reset();
+    int getInputCount();
+    int getOutputCount();
+    void rateChanged(double rate);
+    String getParam(size_t param);
+    bool setParam(size_t param, String value);
+    const char* getParams();
+    size_t getParamCount();
+    bool load(unsigned short version, const unsigned char* data, size_t len);
+    unsigned char* save(unsigned short* version, size_t* len);
+    bool init(DivEngine* parent, double rate, unsigned short version, const unsigned char* data, size_t len);
+    void quit();
+};
+
+#endif
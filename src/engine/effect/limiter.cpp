@@ -0,0 +1,142 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2026 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "limiter.h"
+#include <fmt/printf.h>
+#include <math.h>
+#include <string.h>
+#include <stdexcept>
+
+#define LIMITER_PARAMS 2
+
+static const float limiterParamMin[LIMITER_PARAMS]={-24.0f,1.0f};
+static const float limiterParamMax[LIMITER_PARAMS]={0.0f,2000.0f};
+
+void DivEffectLimiter::updateCoefs() {
+  threshold=pow(10.0f,params[0]/20.0f);
+  releaseCoef=exp(-1000.0/(params[1]*rate));
+}
+
+void DivEffectLimiter::acquire(float** in, float** out, size_t len) {
+  const float* inL=in[0];
+  const float* inR=in[1];
+  float* outL=out[0];
+  float* outR=out[1];
+  float e=env;
+  for (size_t i=0; i<len; i++) {
+    float peak=MAX(fabsf(inL[i]),fabsf(inR[i]));
+    if (peak>e) {
+      e=peak;
+    } else {
+      e=peak+(e-peak)*releaseCoef;
+    }
+    float gain=(e>threshold)?(threshold/e):1.0f;
+    outL[i]=inL[i]*gain;
+    outR[i]=inR[i]*gain;
+  }
+  if (e<1e-20f) e=0.0f;
+  env=e;
+}
+
+void DivEffectLimiter::reset() {
+  env=0.0f;
+}
+
+int DivEffectLimiter::getInputCount() {
+  return 2;
+}
+
+int DivEffectLimiter::getOutputCount() {
+  return 2;
+}
+
+void DivEffectLimiter::rateChanged(double r) {
+  rate=r;
+  updateCoefs();
+}
+
+String DivEffectLimiter::getParam(size_t param) {
+  if (param>=LIMITER_PARAMS) throw std::out_of_range("param");
+  return fmt::sprintf("%g",params[param]);
+}
+
+bool DivEffectLimiter::setParam(size_t param, String value) {
+  if (param>=LIMITER_PARAMS) return false;
+  float val;
+  try {
+    val=std::stof(value);
+  } catch (std::exception& e) {
+    return false;
+  }
+  if (val<limiterParamMin[param]) val=limiterParamMin[param];
+  if (val>limiterParamMax[param]) val=limiterParamMax[param];
+  params[param]=val;
+  updateCoefs();
+  return true;
+}
+
+const char* DivEffectLimiter::getParams() {
+  return
+    "0:F:Threshold:maximum output level (dB):-24:0\n"
+    "1:F:Release:time to recover from gain reduction (ms):1:2000\n"
+    "TEXTF:0";
+}
+
+size_t DivEffectLimiter::getParamCount() {
+  return LIMITER_PARAMS;
+}
+
+String DivEffectLimiter::getDynamicText(size_t id) {
+  if (id!=0) throw std::out_of_range("param");
+  float reduction=(env>threshold)?(20.0f*log10(threshold/env)):0.0f;
+  return fmt::sprintf("gain reduction: %.1fdB",reduction);
+}
+
+bool DivEffectLimiter::load(unsigned short version, const unsigned char* data, size_t len) {
+  if (data==NULL || len==0) return true;
+  if (version!=1 || len!=LIMITER_PARAMS*sizeof(float)) return false;
+  memcpy(params,data,len);
+  for (int i=0; i<LIMITER_PARAMS; i++) {
+    if (!(params[i]>=limiterParamMin[i])) params[i]=limiterParamMin[i];
+    if (params[i]>limiterParamMax[i]) params[i]=limiterParamMax[i];
+  }
+  return true;
+}
+
+unsigned char* DivEffectLimiter::save(unsigned short* version, size_t* len) {
+  unsigned char* ret=new unsigned char[LIMITER_PARAMS*sizeof(float)];
+  memcpy(ret,params,LIMITER_PARAMS*sizeof(float));
+  *len=LIMITER_PARAMS*sizeof(float);
+  *version=1;
+  return ret;
+}
+
+bool DivEffectLimiter::init(DivEngine* p, double r, unsigned short version, const unsigned char* data, size_t len) {
+  parent=p;
+  rate=r;
+  params[0]=-0.3f;
+  params[1]=50.0f;
+  reset();
+  if (!load(version,data,len)) return false;
+  updateCoefs();
+  return true;
+}
+
+void DivEffectLimiter::quit() {
+}
@@ -0,0 +1,99 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2026 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "volume.h"
+#include <fmt/printf.h>
+#include <math.h>
+#include <string.h>
+#include <stdexcept>
+
+#define VOLUME_MIN -60.0f
+#define VOLUME_MAX 24.0f
+
+void DivEffectVolume::acquire(float** in, float** out, size_t len) {
+  for (int i=0; i<2; i++) {
+    const float* src=in[i];
+    float* dest=out[i];
+    for (size_t j=0; j<len; j++) {
+      dest[j]=src[j]*gain;
+    }
+  }
+}
+
+int DivEffectVolume::getInputCount() {
+  return 2;
+}
+
+int DivEffectVolume::getOutputCount() {
+  return 2;
+}
+
+String DivEffectVolume::getParam(size_t param) {
+  if (param!=0) throw std::out_of_range("param");
+  return fmt::sprintf("%g",gainDB);
+}
+
+bool DivEffectVolume::setParam(size_t param, String value) {
+  if (param!=0) return false;
+  float val;
+  try {
+    val=std::stof(value);
+  } catch (std::exception& e) {
+    return false;
+  }
+  if (val<VOLUME_MIN) val=VOLUME_MIN;
+  if (val>VOLUME_MAX) val=VOLUME_MAX;
+  gainDB=val;
+  gain=pow(10.0f,gainDB/20.0f);
+  return true;
+}
+
+const char* DivEffectVolume::getParams() {
+  return "0:F:Gain:gain (dB):-60:24";
+}
+
+size_t DivEffectVolume::getParamCount() {
+  return 1;
+}
+
+bool DivEffectVolume::load(unsigned short version, const unsigned char* data, size_t len) {
+  if (data==NULL || len==0) return true;
+  if (version!=1 || len!=sizeof(float)) return false;
+  float val;
+  memcpy(&val,data,sizeof(float));
+  return setParam(0,fmt::sprintf("%g",val));
+}
+
+unsigned char* DivEffectVolume::save(unsigned short* version, size_t* len) {
+  unsigned char* ret=new unsigned char[sizeof(float)];
+  memcpy(ret,&gainDB,sizeof(float));
+  *len=sizeof(float);
+  *version=1;
+  return ret;
+}
+
+bool DivEffectVolume::init(DivEngine* p, double rate, unsigned short version, const unsigned char* data, size_t len) {
+  parent=p;
+  gainDB=0.0f;
+  gain=1.0f;
+  return load(version,data,len);
+}
+
+void DivEffectVolume::quit() {
+}
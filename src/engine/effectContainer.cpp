@@ -19,6 +19,9 @@
 
 #include "engine.h"
 #include "effect/dummy.h"
+#include "effect/filter.h"
+#include "effect/limiter.h"
+#include "effect/volume.h"
 
 void DivEffectContainer::preAcquire(size_t count) {
   if (!count) return;
@@ -66,12 +69,42 @@ void DivEffectContainer::acquire(size_t count) {
   effect->acquire(in,out,count);
 }
 
+void DivEffectContainer::reserve(size_t count) {
+  preAcquire(count);
+  int outCount=effect->getOutputCount();
+  if (outLen<count) {
+    for (int i=0; i<outCount; i++) {
+      if (out[i]!=NULL) {
+        delete[] out[i];
+        out[i]=NULL;
+      }
+    }
+    outLen=count;
+  }
+  for (int i=0; i<outCount; i++) {
+    if (out[i]==NULL) {
+      out[i]=new float[outLen];
+    }
+  }
+}
+
 bool DivEffectContainer::init(DivEffectType effectType, DivEngine* eng, double rate, unsigned short version, const unsigned char* data, size_t len) {
   switch (effectType) {
+    case DIV_EFFECT_VOLUME:
+      effect=new DivEffectVolume;
+      break;
+    case DIV_EFFECT_FILTER:
+      effect=new DivEffectFilter;
+      break;
+    case DIV_EFFECT_LIMITER:
+      effect=new DivEffectLimiter;
+      break;
     case DIV_EFFECT_DUMMY:
     default:
       effect=new DivEffectDummy;
   }
+  type=effectType;
+  this->rate=rate;
   return effect->init(eng,rate,version,data,len);
 }
 
@@ -39,14 +39,285 @@
 #ifdef HAVE_ASIO
 #include "../audio/asio.h"
 #endif
+#ifdef HAVE_AAUDIO
+#include "../audio/aaudio.h"
+#endif
 #include "../audio/pipe.h"
+#include "rtCheck.h"
+#include "trace.h"
 #include <math.h>
 #include <float.h>
 #include <fmt/printf.h>
 #include <chrono>
+#include <future>
+#include <algorithm>
+#include <unordered_map>
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
 
 void process(void* u, float** in, float** out, int inChans, int outChans, unsigned int size) {
-  ((DivEngine*)u)->nextBuf(in,out,inChans,outChans,size);
+  ((DivEngine*)u)->processAudio(in,out,inChans,outChans,size);
+}
+
+void DivEngine::processAudio(float** in, float** out, int inChans, int outChans, unsigned int size) {
+  DIV_RT_SECTION;
+  DIV_TRACE_THREAD("audio");
+  if (!renderAheadActive) {
+    if (playlistMode) {
+      playlistBuf(out,outChans,size);
+    } else {
+      nextBuf(in,out,inChans,outChans,size);
+    }
+    mixInsPreview(out,outChans,size);
+    return;
+  }
+  if (!renderAheadRunning) {
+    renderAheadRunning=true;
+    renderAheadCond.notify_one();
+  }
+
+  // hand MIDI input over to the render thread (it was gathered on this one)
+  if (output!=NULL) if (output->midiIn!=NULL) {
+    std::lock_guard<std::mutex> lock(midiInLock);
+    while (!output->midiIn->queue.empty()) {
+      midiInQueue.push(output->midiIn->queue.front());
+      output->midiIn->queue.pop();
+    }
+  }
+
+  // copy what the render thread has produced, and fill the rest with silence
+  size_t readPos=renderAheadReadPos.load(std::memory_order_relaxed);
+  size_t writePos=renderAheadWritePos.load(std::memory_order_acquire);
+  // the render thread may move the write position back (see rollbackRenderAhead())
+  size_t avail=(writePos>readPos)?(writePos-readPos):0;
+  unsigned int count=(avail<size)?avail:size;
+  size_t mask=renderAheadLen-1;
+  for (unsigned int i=0; i<count; i++) {
+    const float* src=&renderAheadBuf[((readPos+i)&mask)*renderAheadChans];
+    for (int j=0; j<outChans; j++) {
+      out[j][i]=(j<renderAheadChans)?src[j]:0.0f;
+    }
+  }
+  if (count<size) {
+    for (int j=0; j<outChans; j++) {
+      memset(&out[j][count],0,(size-count)*sizeof(float));
+    }
+    renderAheadUnderruns++;
+  }
+  renderAheadReadPos.store(readPos+count,std::memory_order_release);
+  renderAheadCond.notify_one();
+
+  // previews don't wait for the render-ahead buffer
+  mixInsPreview(out,outChans,size);
+}
+
+void DivEngine::runRenderAhead() {
+  DIV_TRACE_THREAD("render ahead");
+  std::unique_lock<std::mutex> unique(renderAheadLock);
+  size_t mask=renderAheadLen-1;
+  while (!renderAheadQuit) {
+    size_t writePos=renderAheadWritePos.load(std::memory_order_relaxed);
+    size_t queued=writePos-renderAheadReadPos.load(std::memory_order_acquire);
+    if (!renderAheadRunning || queued+renderAheadBlock>renderAheadTarget) {
+      // the timeout covers notifications which arrive before waiting
+      renderAheadCond.wait_for(unique,std::chrono::milliseconds(1));
+      continue;
+    }
+    unique.unlock();
+
+    if (playlistMode) {
+      playlistBuf(renderAheadTemp,renderAheadChans,renderAheadBlock);
+    } else {
+      if (renderAheadRollbackOn) {
+        if (renderAheadRollbackPending.exchange(false)) {
+          if (rollbackRenderAhead()) writePos=renderAheadWritePos.load(std::memory_order_relaxed);
+        }
+        captureRenderAheadSnapshot(writePos);
+      }
+      nextBuf(NULL,renderAheadTemp,0,renderAheadChans,renderAheadBlock);
+    }
+    for (unsigned int i=0; i<renderAheadBlock; i++) {
+      float* dest=&renderAheadBuf[((writePos+i)&mask)*renderAheadChans];
+      for (int j=0; j<renderAheadChans; j++) {
+        dest[j]=renderAheadTemp[j][i];
+      }
+    }
+    renderAheadWritePos.store(writePos+renderAheadBlock,std::memory_order_release);
+
+    unique.lock();
+  }
+}
+
+void DivEngine::startRenderAhead() {
+  if (renderAheadThread!=NULL) return;
+  if (renderAheadMs<=0 || got.rate<1 || got.bufsize<1 || got.outChans<1) return;
+
+  renderAheadChans=MIN(got.outChans,DIV_MAX_OUTPUTS);
+  renderAheadBlock=got.bufsize;
+  // keep at least two blocks in the buffer
+  renderAheadTarget=MAX((size_t)renderAheadMs*got.rate/1000,(size_t)renderAheadBlock*2);
+  renderAheadLen=1;
+  while (renderAheadLen<renderAheadTarget+renderAheadBlock) renderAheadLen<<=1;
+
+  logI("rendering ahead (%d frames, %d per block).",(int)renderAheadTarget,renderAheadBlock);
+  renderAheadBuf=new float[renderAheadLen*renderAheadChans];
+  memset(renderAheadBuf,0,renderAheadLen*renderAheadChans*sizeof(float));
+  for (int i=0; i<renderAheadChans; i++) {
+    renderAheadTemp[i]=new float[renderAheadBlock];
+  }
+  renderAheadReadPos=0;
+  renderAheadWritePos=0;
+  renderAheadUnderruns=0;
+  renderAheadRollbacks=0;
+  renderAheadRollbackPending=false;
+  renderAheadQuit=false;
+  renderAheadRunning=false;
+  renderAheadThread=new std::thread(&DivEngine::runRenderAhead,this);
+  renderAheadActive=true;
+}
+
+void DivEngine::stopRenderAhead() {
+  if (renderAheadThread==NULL) return;
+
+  renderAheadActive=false;
+  renderAheadLock.lock();
+  renderAheadQuit=true;
+  renderAheadLock.unlock();
+  renderAheadCond.notify_one();
+  renderAheadThread->join();
+  delete renderAheadThread;
+  renderAheadThread=NULL;
+  // only the render thread uses these
+  clearRenderAheadSnapshots();
+  if (renderAheadUnderruns>0) logW("render-ahead buffer underruns: %d",renderAheadUnderruns.load());
+  if (renderAheadRollbacks>0) logD("render-ahead rollbacks: %d",renderAheadRollbacks);
+}
+
+unsigned int DivEngine::getRenderAheadUnderruns() {
+  return renderAheadUnderruns;
+}
+
+void DivEngine::updateGovernor(unsigned int size) {
+  if (!governorEnabled || exporting || got.rate<1) return;
+  // wait until the previous request is carried out
+  if (governorRequest!=DIV_GOVERNOR_NONE) return;
+
+  double len=(double)size/got.rate;
+  double busy=(double)processTime*0.000000001;
+  governorTime+=len;
+  governorBusy+=busy;
+  if (busy>governorPeak*len) governorPeak=busy/len;
+  if (governorTime<DIV_GOVERNOR_WINDOW) return;
+
+  double avg=governorBusy/governorTime;
+  // a render-ahead buffer absorbs peaks, unless it runs dry
+  bool spiky;
+  if (renderAheadActive) {
+    unsigned int underruns=renderAheadUnderruns;
+    spiky=(underruns!=governorUnderruns);
+    governorUnderruns=underruns;
+  } else {
+    spiky=(governorPeak>DIV_GOVERNOR_PEAK_LOAD);
+  }
+  governorTime=0.0;
+  governorBusy=0.0;
+  governorPeak=0.0;
+
+  if (avg>DIV_GOVERNOR_OVER_LOAD) {
+    governorOver++;
+    governorSpiky=0;
+    governorUnder=0;
+  } else if (spiky) {
+    governorOver=0;
+    governorSpiky++;
+    governorUnder=0;
+  } else if (avg<DIV_GOVERNOR_RESTORE_LOAD) {
+    governorOver=0;
+    governorSpiky=0;
+    governorUnder++;
+  } else {
+    governorOver=0;
+    governorSpiky=0;
+    governorUnder=0;
+  }
+
+  int request=DIV_GOVERNOR_NONE;
+  if (governorOver>=DIV_GOVERNOR_OVER_WINDOWS && !lightCores) {
+    request=DIV_GOVERNOR_LIGHT_CORES;
+  } else if (governorSpiky>=DIV_GOVERNOR_OVER_WINDOWS && MAX(renderAheadMs,governorRenderAheadMs)<DIV_GOVERNOR_MAX_RENDER_AHEAD) {
+    request=DIV_GOVERNOR_RENDER_AHEAD;
+  } else if (governorUnder>=governorRestoreWindows && lightCores) {
+    request=DIV_GOVERNOR_RESTORE_CORES;
+  }
+  if (request!=DIV_GOVERNOR_NONE) {
+    governorOver=0;
+    governorSpiky=0;
+    governorUnder=0;
+    governorRequest=request;
+  }
+}
+
+void DivEngine::setLightCores(bool light) {
+  if (lightCores==light) return;
+  // keep playing from the same position
+  bool wasPlaying=isPlaying();
+  int prevCurOrder=curOrder;
+  int prevCurRow=curRow;
+  bool isMutedBefore[DIV_MAX_CHANS];
+  memcpy(isMutedBefore,isMuted,DIV_MAX_CHANS*sizeof(bool));
+
+  lightCores=light;
+  quitDispatch();
+  initDispatch(false);
+  renderSamplesP();
+  for (int i=0; i<song.chans; i++) {
+    if (isMutedBefore[i]) {
+      muteChannel(i,true);
+    }
+  }
+  if (wasPlaying) {
+    curOrder=prevCurOrder;
+    playToRow(prevCurRow);
+  }
+}
+
+DivGovernorAction DivEngine::pollGovernor() {
+  int request=governorRequest;
+  if (request==DIV_GOVERNOR_NONE) return DIV_GOVERNOR_NONE;
+
+  // never touch the cores while exporting
+  if (exporting) {
+    governorRequest=DIV_GOVERNOR_NONE;
+    return DIV_GOVERNOR_NONE;
+  }
+
+  switch (request) {
+    case DIV_GOVERNOR_RENDER_AHEAD: {
+      int curMs=MAX(renderAheadMs,governorRenderAheadMs);
+      governorRenderAheadMs=MIN((curMs<20)?40:(curMs*2),DIV_GOVERNOR_MAX_RENDER_AHEAD);
+      logW("audio load is spiky! rendering %dms ahead.",governorRenderAheadMs);
+      if (!switchMaster(false)) {
+        logE("could not restart audio output!");
+      }
+      break;
+    }
+    case DIV_GOVERNOR_LIGHT_CORES:
+      logW("audio load is too high! switching to faster emulation cores.");
+      setLightCores(true);
+      break;
+    case DIV_GOVERNOR_RESTORE_CORES:
+      logI("audio load is low. switching back to the configured emulation cores.");
+      setLightCores(false);
+      if (governorRestoreWindows<DIV_GOVERNOR_RESTORE_WINDOWS*16) governorRestoreWindows*=2;
+      break;
+  }
+  governorRequest=DIV_GOVERNOR_NONE;
+  return (DivGovernorAction)request;
+}
+
+bool DivEngine::isUsingLightCores() {
+  return lightCores;
 }
 
 const char* DivEngine::getEffectDesc(unsigned char effect, int chan, bool notNull) {
@@ -203,41 +474,194 @@ const char* DivEngine::getEffectDesc(unsigned char effect, int chan, bool notNul
   return notNull?_("Invalid effect"):NULL;
 }
 
-void DivEngine::calcSongTimestamps() {
+void DivEngine::calcSongTimestamps(bool incremental) {
   if (curSubSong!=NULL) {
-    curSubSong->calcTimestamps(song.chans,song.grooves,song.compatFlags.jumpTreatment,song.compatFlags.ignoreJumpAtEnd,song.compatFlags.brokenSpeedSel,song.compatFlags.delayBehavior);
+    tsLock.lock();
+    curSubSong->calcTimestamps(song.chans,song.grooves,song.compatFlags.jumpTreatment,song.compatFlags.ignoreJumpAtEnd,song.compatFlags.brokenSpeedSel,song.compatFlags.delayBehavior,0,incremental);
+    tsLock.unlock();
+  }
+  // a background calculation would overwrite these
+  if (tsThread!=NULL) {
+    tsStale=true;
+    tsPending=false;
+  }
+}
+
+void DivEngine::calcSongTimestampsAsync() {
+  if (curSubSong==NULL) return;
+  // the result is discarded if the sub-song changes in the meantime.
+  // make sure the next calculation of this one starts from the beginning.
+  tsLock.lock();
+  curSubSong->ts.invalidateAll();
+  tsLock.unlock();
+  if (tsThread!=NULL) {
+    tsStale=true;
+    tsPending=true;
+    return;
+  }
+
+  // copy only what calcTimestamps() reads, and only the patterns in the order list
+  DivSubSong* copy=new DivSubSong;
+  copy->speeds=curSubSong->speeds;
+  copy->virtualTempoN=curSubSong->virtualTempoN;
+  copy->virtualTempoD=curSubSong->virtualTempoD;
+  copy->hz=curSubSong->hz;
+  copy->patLen=curSubSong->patLen;
+  copy->ordersLen=curSubSong->ordersLen;
+  copy->orders=curSubSong->orders;
+  for (int i=0; i<song.chans; i++) {
+    copy->pat[i].effectCols=curSubSong->pat[i].effectCols;
+    for (int j=0; j<curSubSong->ordersLen; j++) {
+      int index=curSubSong->orders.ord[i][j];
+      if (curSubSong->pat[i].data[index]==NULL || copy->pat[i].data[index]!=NULL) continue;
+      curSubSong->pat[i].data[index]->copyOn(copy->pat[i].getPattern(index,true));
+    }
+  }
+
+  tsSubSong=copy;
+  tsTarget=curSubSong;
+  tsDone=false;
+  tsStale=false;
+  tsPending=false;
+
+  int chans=song.chans;
+  std::vector<DivGroovePattern> grooves=song.grooves;
+  int jumpTreatment=song.compatFlags.jumpTreatment;
+  int ignoreJumpAtEnd=song.compatFlags.ignoreJumpAtEnd;
+  int brokenSpeedSel=song.compatFlags.brokenSpeedSel;
+  int delayBehavior=song.compatFlags.delayBehavior;
+  tsThread=new std::thread([this,copy,chans,grooves,jumpTreatment,ignoreJumpAtEnd,brokenSpeedSel,delayBehavior]() mutable {
+    copy->calcTimestamps(chans,grooves,jumpTreatment,ignoreJumpAtEnd,brokenSpeedSel,delayBehavior);
+    tsDone=true;
+  });
+}
+
+bool DivEngine::updateSongTimestamps() {
+  if (tsThread==NULL || !tsDone) return false;
+  tsThread->join();
+  delete tsThread;
+  tsThread=NULL;
+
+  bool published=false;
+  if (!tsStale && tsTarget==curSubSong) {
+    // the audio thread reads timestamps
+    BUSY_BEGIN_SOFT;
+    curSubSong->ts.swap(tsSubSong->ts);
+    BUSY_END;
+    published=true;
   }
+  delete tsSubSong;
+  tsSubSong=NULL;
+  tsTarget=NULL;
+
+  if (tsPending) calcSongTimestampsAsync();
+  return published;
 }
 
-#define EXPORT_BUFSIZE 2048
+bool DivEngine::isCalculatingTimestamps() {
+  return tsThread!=NULL;
+}
 
-double DivEngine::benchmarkPlayback() {
-  float* outBuf[2];
-  outBuf[0]=new float[EXPORT_BUFSIZE];
-  outBuf[1]=new float[EXPORT_BUFSIZE];
+struct DivTimestampTask {
+  DivSubSong* sub;
+  DivSong* song;
+};
 
-  curOrder=0;
-  prevOrder=0;
-  remainingLoops=1;
-  playSub(false);
+static void _calcTimestamps(void* arg) {
+  DivTimestampTask* task=(DivTimestampTask*)arg;
+  DivSong& song=*task->song;
+  task->sub->calcTimestamps(song.chans,song.grooves,song.compatFlags.jumpTreatment,song.compatFlags.ignoreJumpAtEnd,song.compatFlags.brokenSpeedSel,song.compatFlags.delayBehavior,0,true);
+}
 
-  std::chrono::high_resolution_clock::time_point timeStart=std::chrono::high_resolution_clock::now();
+void DivEngine::calcAllSongTimestamps() {
+  std::vector<DivTimestampTask> tasks;
+  for (DivSubSong* i: song.subsong) {
+    if (i==curSubSong && tsThread!=NULL) continue;
+    DivTimestampTask t;
+    t.sub=i;
+    t.song=&song;
+    tasks.push_back(t);
+  }
+  if (tasks.empty()) return;
+
+  // sub-songs only read shared song data, and each one has its own timestamps
+  unsigned int threads=std::thread::hardware_concurrency();
+  if (threads>tasks.size()) threads=tasks.size();
+  tsLock.lock();
+  if (threads>1) {
+    DivWorkPool* pool=new DivWorkPool(threads-1);
+    pool->pushBatch(_calcTimestamps,tasks.data(),tasks.size());
+    pool->wait();
+    delete pool;
+  } else {
+    for (DivTimestampTask& i: tasks) {
+      _calcTimestamps(&i);
+    }
+  }
+  tsLock.unlock();
+}
 
-  // benchmark
-  while (playing) {
-    nextBuf(NULL,outBuf,0,2,EXPORT_BUFSIZE);
+void DivEngine::invalidateSubSongTimestamps(int subSong) {
+  if (subSong<0 || subSong>=(int)song.subsong.size()) return;
+  tsLock.lock();
+  song.subsong[subSong]->ts.invalidateAll();
+  tsLock.unlock();
+}
+
+void DivEngine::invalidatePatternTimestamps(int chan, int pat) {
+  if (curSubSong==NULL) return;
+  if (chan<0 || chan>=DIV_MAX_CHANS) return;
+  // unlike snapshots, the earliest order may not be the first one which is played
+  tsLock.lock();
+  for (int i=0; i<curSubSong->ordersLen; i++) {
+    if (curOrders->ord[chan][i]==pat) {
+      curSubSong->ts.invalidate(i);
+    }
   }
+  tsLock.unlock();
+}
 
-  std::chrono::high_resolution_clock::time_point timeEnd=std::chrono::high_resolution_clock::now();
+const char* profileStageNames[DIV_PROFILE_MAX]={
+  "tick",
+  "MIDI",
+  "dispatch",
+  "mix",
+  "osc",
+  "total"
+};
 
-  delete[] outBuf[0];
-  delete[] outBuf[1];
+const char* dispatchProfileStageNames[DIV_DISPATCH_PROFILE_MAX]={
+  "acquire",
+  "resample",
+  "postProcess"
+};
 
-  double t=(double)(std::chrono::duration_cast<std::chrono::microseconds>(timeEnd-timeStart).count())/1000000.0;
-  printf("[RESULT] %fs\n",t);
-  return t;
+const char* DivEngine::getProfileStageName(int stage) {
+  if (stage<0 || stage>=DIV_PROFILE_MAX) return "???";
+  return profileStageNames[stage];
+}
+
+const char* DivEngine::getDispatchProfileStageName(int stage) {
+  if (stage<0 || stage>=DIV_DISPATCH_PROFILE_MAX) return "???";
+  return dispatchProfileStageNames[stage];
+}
+
+void DivEngine::resetProfile() {
+  BUSY_BEGIN;
+  memset(profHistory,0,sizeof(profHistory));
+  memset(profChipHistory,0,sizeof(profChipHistory));
+  memset(profTotal,0,sizeof(profTotal));
+  memset(profChipTotal,0,sizeof(profChipTotal));
+  memset(profChipWrites,0,sizeof(profChipWrites));
+  memset(profChipDeltas,0,sizeof(profChipDeltas));
+  profSamples=0;
+  profBuffers=0;
+  profHistoryPos=0;
+  BUSY_END;
 }
 
+#define EXPORT_BUFSIZE 2048
+
 double DivEngine::benchmarkSeek() {
   double t[20];
   curOrder=curSubSong->ordersLen-1;
@@ -279,24 +703,56 @@ double DivEngine::benchmarkWalk() {
   return t;
 }
 
+// the instrument/wavetable editors call these on every change (as in, while
+// dragging). taking the engine lock here would stall the GUI for up to a
+// buffer each time, so the change is queued and nextBuf() applies it.
 void DivEngine::notifyInsChange(int ins) {
-  BUSY_BEGIN;
-  for (int i=0; i<song.systemLen; i++) {
-    disCont[i].dispatch->notifyInsChange(ins);
+  invalidateSnapshots();
+  pendingNotifyLock.lock();
+  if (std::find(pendingInsChange.begin(),pendingInsChange.end(),ins)==pendingInsChange.end()) {
+    pendingInsChange.push_back(ins);
   }
-  BUSY_END;
+  pendingNotify=true;
+  pendingNotifyLock.unlock();
 }
 
 void DivEngine::notifyWaveChange(int wave) {
-  BUSY_BEGIN;
-  for (int i=0; i<song.systemLen; i++) {
-    disCont[i].dispatch->notifyWaveChange(wave);
+  invalidateSnapshots();
+  wsCache.invalidate(getWave(wave));
+  pendingNotifyLock.lock();
+  if (std::find(pendingWaveChange.begin(),pendingWaveChange.end(),wave)==pendingWaveChange.end()) {
+    pendingWaveChange.push_back(wave);
   }
-  BUSY_END;
+  pendingNotify=true;
+  pendingNotifyLock.unlock();
+}
+
+// must be called with the engine lock held.
+void DivEngine::applyPendingNotify() {
+  if (!pendingNotify.exchange(false)) return;
+  pendingNotifyLock.lock();
+  applyInsChange.swap(pendingInsChange);
+  applyWaveChange.swap(pendingWaveChange);
+  pendingNotifyLock.unlock();
+
+  for (int ins: applyInsChange) {
+    for (int i=0; i<song.systemLen; i++) {
+      disCont[i].dispatch->notifyInsChange(ins);
+    }
+  }
+  for (int wave: applyWaveChange) {
+    for (int i=0; i<song.systemLen; i++) {
+      disCont[i].dispatch->notifyWaveChange(wave);
+    }
+  }
+  applyInsChange.clear();
+  applyWaveChange.clear();
 }
 
 void DivEngine::notifySampleChange(int sample) {
   BUSY_BEGIN;
+  renderAheadEpoch++;
+  invalidateSnapshots();
   for (int i=0; i<song.systemLen; i++) {
     disCont[i].dispatch->notifySampleChange(sample);
   }
@@ -342,8 +798,20 @@ int DivEngine::loadSampleROM(String path, ssize_t expectedSize, unsigned char*&
   if (len!=expectedSize) {
     logE("ROM size mismatch, expected: %d bytes, was: %d bytes", expectedSize, len);
     lastError=fmt::sprintf(_("ROM size mismatch, expected: %d bytes, was: %d"), expectedSize, len);
+    fclose(f);
     return -1;
   }
+#ifndef _WIN32
+  // map the ROM read-only, so that only the parts being used take memory
+  void* mapped=mmap(NULL,(size_t)len,PROT_READ,MAP_PRIVATE,fileno(f),0);
+  if (mapped!=MAP_FAILED) {
+    fclose(f);
+    mappedROMs.push_back(std::pair<unsigned char*,size_t>((unsigned char*)mapped,(size_t)len));
+    ret=(unsigned char*)mapped;
+    return 0;
+  }
+  logW("could not map ROM (%s)! reading it instead.",strerror(errno));
+#endif
   if (fseek(f,0,SEEK_SET)<0) {
     logE("size error: %s",strerror(errno));
     lastError=fmt::sprintf(_("on get size: %s"),strerror(errno));
@@ -373,19 +841,49 @@ unsigned int DivEngine::getSampleFormatMask() {
   return formatMask;
 }
 
-int DivEngine::loadSampleROMs() {
-  if (yrw801ROM!=NULL) {
-    delete[] yrw801ROM;
-    yrw801ROM=NULL;
+size_t DivEngine::trimSamples() {
+  // some chips read 8-bit data regardless of their format mask
+  unsigned int formatMask=getSampleFormatMask()|(1U<<DIV_SAMPLE_DEPTH_8BIT);
+  size_t freed=0;
+  for (DivSample* i: song.sample) {
+    freed+=i->trim(formatMask);
   }
-  if (tg100ROM!=NULL) {
-    delete[] tg100ROM;
-    tg100ROM=NULL;
+  if (freed>0) logD("trimmed %d bytes of sample data",(int)freed);
+  return freed;
+}
+
+int DivEngine::getSampleTwin(int index) {
+  if (index<0 || index>=(int)sampleTwin.size()) return -1;
+  return sampleTwin[index];
+}
+
+size_t DivEngine::getSampleBufferSize() {
+  size_t ret=0;
+  for (DivSample* i: song.sample) {
+    ret+=i->getBufferSize();
   }
-  if (mu5ROM!=NULL) {
-    delete[] mu5ROM;
-    mu5ROM=NULL;
+  return ret;
+}
+
+void DivEngine::freeSampleROM(unsigned char*& rom) {
+  if (rom==NULL) return;
+  for (size_t i=0; i<mappedROMs.size(); i++) {
+    if (mappedROMs[i].first!=rom) continue;
+#ifndef _WIN32
+    munmap(rom,mappedROMs[i].second);
+#endif
+    mappedROMs.erase(mappedROMs.begin()+i);
+    rom=NULL;
+    return;
   }
+  delete[] rom;
+  rom=NULL;
+}
+
+int DivEngine::loadSampleROMs() {
+  freeSampleROM(yrw801ROM);
+  freeSampleROM(tg100ROM);
+  freeSampleROM(mu5ROM);
   int error=0;
   error+=loadSampleROM(getConfString("yrw801Path",""), 0x200000, yrw801ROM);
   error+=loadSampleROM(getConfString("tg100Path",""), 0x200000, tg100ROM);
@@ -399,7 +897,65 @@ void DivEngine::renderSamplesP(int whichSample) {
   BUSY_END;
 }
 
+void DivEngine::renderSamplesBackground() {
+  waitForSamples();
+  samplesLoading=true;
+  // dispatches read rendered sample data without checking, so nothing may
+  // play until rendering is done. the thread holds the lock for that long,
+  // and this function only returns once it has taken it.
+  std::promise<void> locked;
+  std::future<void> lockedFuture=locked.get_future();
+  try {
+    sampleLoadThread=new std::thread([this,&locked]() {
+      DIV_TRACE_THREAD("sample load");
+      logD("rendering samples in the background...");
+      BUSY_BEGIN_SOFT;
+      locked.set_value();
+      renderSamples();
+      BUSY_END;
+      samplesLoading=false;
+      logD("finished rendering samples.");
+    });
+  } catch (std::system_error& e) {
+    logW("could not start sample load thread! %s",e.what());
+    sampleLoadThread=NULL;
+    BUSY_BEGIN;
+    renderSamples();
+    BUSY_END;
+    samplesLoading=false;
+    return;
+  }
+  lockedFuture.wait();
+}
+
+bool DivEngine::areSamplesLoading() {
+  return samplesLoading;
+}
+
+void DivEngine::waitForSamples() {
+  if (sampleLoadThread==NULL) return;
+  sampleLoadThread->join();
+  delete sampleLoadThread;
+  sampleLoadThread=NULL;
+}
+
+struct DivSampleRenderTask {
+  DivSample* sample;
+  unsigned int formatMask;
+  unsigned long long hash;
+  DivSampleRenderTask(DivSample* s, unsigned int m, unsigned long long h):
+    sample(s),
+    formatMask(m),
+    hash(h) {}
+};
+
+static void _renderSample(void* arg) {
+  DivSampleRenderTask* task=(DivSampleRenderTask*)arg;
+  task->sample->render(task->formatMask,false,task->hash);
+}
+
 void DivEngine::renderSamples(int whichSample) {
+  renderAheadEpoch++;
   sPreview.sample=-1;
   sPreview.pos=0;
   sPreview.dir=false;
@@ -416,18 +972,108 @@ void DivEngine::renderSamples(int whichSample) {
 
   // step 1: render samples
   if (whichSample==-1) {
+    // only samples which changed or lack a format are rendered.
+    // these are independent of each other, so spread them across threads.
+    // samples with the same data as another one copy its formats instead.
+    std::vector<DivSampleRenderTask> pending;
+    std::vector<std::pair<DivSampleRenderTask,DivSample*>> copies;
+    std::unordered_map<unsigned long long,DivSample*> firstOfHash;
+    for (int i=0; i<song.sampleLen; i++) {
+      DivSample* s=song.sample[i];
+      unsigned long long hash=s->getRenderHash();
+      auto twin=firstOfHash.find(hash);
+      if ((formatMask&~s->renderedMask)==0 && hash==s->renderHash) {
+        if (twin==firstOfHash.end()) firstOfHash[hash]=s;
+        continue;
+      }
+      if (twin!=firstOfHash.end()) {
+        if (s->isSameData(twin->second)) {
+          copies.push_back(std::pair<DivSampleRenderTask,DivSample*>(DivSampleRenderTask(s,formatMask,hash),twin->second));
+          continue;
+        }
+      } else {
+        firstOfHash[hash]=s;
+      }
+      pending.push_back(DivSampleRenderTask(s,formatMask,hash));
+    }
+    logD("%d of %d samples need to be rendered (%d copied)",(int)pending.size(),song.sampleLen,(int)copies.size());
+
+    unsigned int threads=std::thread::hardware_concurrency();
+    if (threads>pending.size()) threads=pending.size();
+    if (threads>1) {
+      DivWorkPool* pool=new DivWorkPool(threads-1);
+      pool->pushBatch(_renderSample,pending.data(),pending.size());
+      pool->wait();
+      delete pool;
+    } else {
+      // a single sample may render its formats in parallel instead
+      for (DivSampleRenderTask& i: pending) {
+        i.sample->render(i.formatMask,pending.size()==1,i.hash);
+      }
+    }
+    for (std::pair<DivSampleRenderTask,DivSample*>& i: copies) {
+      if (!i.first.sample->copyRenderFrom(i.second,i.first.formatMask,i.first.hash)) {
+        i.first.sample->render(i.first.formatMask,false,i.first.hash);
+      }
+    }
+    // formats left over from chips which are no longer in the song.
+    // 8-bit is kept as some chips read it regardless of their format mask.
     for (int i=0; i<song.sampleLen; i++) {
-      song.sample[i]->render(formatMask);
+      song.sample[i]->trim(formatMask|(1U<<DIV_SAMPLE_DEPTH_8BIT));
     }
   } else if (whichSample>=0 && whichSample<song.sampleLen) {
-    song.sample[whichSample]->render(formatMask);
+    song.sample[whichSample]->render(formatMask,true);
+    song.sample[whichSample]->trim(formatMask|(1U<<DIV_SAMPLE_DEPTH_8BIT));
+  }
+
+  // find samples with the same data (reported in the memory window)
+  sampleTwin.assign(song.sampleLen,-1);
+  if (song.sampleLen>1) {
+    std::unordered_multimap<unsigned long long,int> hashes;
+    for (int i=0; i<song.sampleLen; i++) {
+      DivSample* s=song.sample[i];
+      auto twins=hashes.equal_range(s->renderHash);
+      for (auto j=twins.first; j!=twins.second; j++) {
+        if (s->isSameData(song.sample[j->second])) {
+          sampleTwin[i]=j->second;
+          break;
+        }
+      }
+      if (sampleTwin[i]==-1) hashes.insert(std::pair<unsigned long long,int>(s->renderHash,i));
+    }
   }
 
   // step 2: render samples to dispatch
+  // chips which are identical to a previous one copy its sample memory.
+  String flagStr[DIV_MAX_CHIPS];
   for (int i=0; i<song.systemLen; i++) {
-    if (disCont[i].dispatch!=NULL) {
-      disCont[i].dispatch->renderSamples(i);
+    flagStr[i]=song.systemFlags[i].toString();
+  }
+  for (int i=0; i<song.systemLen; i++) {
+    if (disCont[i].dispatch==NULL) continue;
+    bool copied=false;
+    for (int j=0; j<i; j++) {
+      if (disCont[j].dispatch==NULL) continue;
+      if (song.system[j]!=song.system[i]) continue;
+      if (flagStr[j]!=flagStr[i]) continue;
+      bool sameSamples=true;
+      for (int k=0; k<song.sampleLen && sameSamples; k++) {
+        DivSample* s=song.sample[k];
+        for (int l=0; l<DIV_MAX_SAMPLE_TYPE; l++) {
+          if (s->renderOn[l][i]!=s->renderOn[l][j]) {
+            sameSamples=false;
+            break;
+          }
+        }
+      }
+      if (!sameSamples) continue;
+      if (disCont[i].dispatch->copySamplesFrom(disCont[j].dispatch)) {
+        logV("chip %d: copied sample memory from chip %d",i,j);
+        copied=true;
+      }
+      break;
     }
+    if (!copied) disCont[i].dispatch->renderSamples(i);
   }
 }
 
@@ -721,6 +1367,8 @@ void DivEngine::changeSong(size_t songIndex) {
   curRow=0;
   prevOrder=0;
   prevRow=0;
+  renderAheadEpoch++;
+  invalidateSnapshots();
 }
 
 void DivEngine::copyChannelP(int src, int dest) {
@@ -1003,6 +1651,116 @@ void DivEngine::delUnusedSamples() {
   BUSY_END;
 }
 
+int DivEngine::mergeDuplicateIns() {
+  if (song.ins.size()<2) return 0;
+
+  BUSY_BEGIN;
+  saveLock.lock();
+
+  // compare instruments without their names
+  std::vector<int> same(song.ins.size(),-1);
+  std::unordered_multimap<unsigned long long,int> hashes;
+  std::vector<SafeWriter*> data(song.ins.size(),NULL);
+  for (size_t i=0; i<song.ins.size(); i++) {
+    data[i]=new SafeWriter;
+    data[i]->init();
+    song.ins[i]->putInsData2(data[i],false,NULL,false);
+    unsigned long long hash=0xcbf29ce484222325ULL;
+    unsigned char* buf=data[i]->getFinalBuf();
+    for (size_t j=0; j<data[i]->size(); j++) {
+      hash=(hash^buf[j])*0x100000001b3ULL;
+    }
+    auto twins=hashes.equal_range(hash);
+    for (auto j=twins.first; j!=twins.second; j++) {
+      SafeWriter* other=data[j->second];
+      if (other->size()==data[i]->size() && memcmp(other->getFinalBuf(),buf,other->size())==0) {
+        same[i]=j->second;
+        break;
+      }
+    }
+    if (same[i]==-1) hashes.insert(std::pair<unsigned long long,int>(hash,i));
+  }
+  for (SafeWriter* i: data) {
+    i->finish();
+    delete i;
+  }
+
+  // remap and delete, from the end so that the remaining indices stay valid
+  int merged=0;
+  for (int i=(int)song.ins.size()-1; i>0; i--) {
+    if (same[i]<0) continue;
+    for (int j=0; j<song.chans; j++) {
+      for (size_t k=0; k<song.subsong.size(); k++) {
+        for (int l=0; l<DIV_MAX_PATTERNS; l++) {
+          if (song.subsong[k]->pat[j].data[l]==NULL) continue;
+          for (int m=0; m<song.subsong[k]->patLen; m++) {
+            if (song.subsong[k]->pat[j].data[l]->newData[m][DIV_PAT_INS]==i) {
+              song.subsong[k]->pat[j].data[l]->newData[m][DIV_PAT_INS]=same[i];
+            }
+          }
+        }
+      }
+    }
+    delInstrumentUnsafe(i);
+    merged++;
+  }
+
+  saveLock.unlock();
+  BUSY_END;
+  return merged;
+}
+
+int DivEngine::mergeDuplicateSamples() {
+  if (song.sample.size()<2) return 0;
+
+  BUSY_BEGIN;
+  saveLock.lock();
+
+  std::vector<int> same;
+  findDuplicateSamples(same);
+
+  // remap and delete, from the end so that the remaining indices stay valid
+  int merged=0;
+  for (int i=(int)song.sample.size()-1; i>0; i--) {
+    if (same[i]<0) continue;
+    for (DivInstrument* j: song.ins) {
+      if (j->amiga.initSample==i) j->amiga.initSample=same[i];
+      for (int k=0; k<120; k++) {
+        if (j->amiga.noteMap[k].map==i) j->amiga.noteMap[k].map=same[i];
+      }
+    }
+    delSampleUnsafe(i,false);
+    merged++;
+  }
+  if (merged>0) renderSamples();
+
+  saveLock.unlock();
+  BUSY_END;
+  return merged;
+}
+
+size_t DivEngine::findDuplicateSamples(std::vector<int>& same) {
+  same.assign(song.sample.size(),-1);
+  size_t wasted=0;
+  std::unordered_multimap<unsigned long long,int> hashes;
+  for (size_t i=0; i<song.sample.size(); i++) {
+    DivSample* s=song.sample[i];
+    unsigned long long hash=s->getRenderHash();
+    auto twins=hashes.equal_range(hash);
+    for (auto j=twins.first; j!=twins.second; j++) {
+      DivSample* other=song.sample[j->second];
+      if (other->centerRate!=s->centerRate) continue;
+      if (memcmp(other->renderOn,s->renderOn,sizeof(s->renderOn))!=0) continue;
+      if (!s->isSameData(other)) continue;
+      same[i]=j->second;
+      wasted+=s->getBufferSize();
+      break;
+    }
+    if (same[i]==-1) hashes.insert(std::pair<unsigned long long,int>(hash,i));
+  }
+  return wasted;
+}
+
 bool DivEngine::sysChanCountChange(int firstChan, int before, int after) {
   if (song.chans-before+after>DIV_MAX_CHANS) {
     return false;
@@ -1412,6 +2170,8 @@ void DivEngine::swapSystemUnsafe(int src, int dest, bool preserveOrder) {
         song.subsong[i]->chanCollapse[j]=prevChanCollapse[swappedChannels[j]];
         song.subsong[i]->chanColor[j]=prevChanColor[swappedChannels[j]];
       }
+      // channel order matters to simultaneous jumps
+      song.subsong[i]->ts.invalidateAll();
     }
   }
 
@@ -1537,7 +2297,7 @@ String DivEngine::getPlaybackDebugInfo() {
     "bufferPos: %d\n",
     curOrder,prevOrder,curRow,prevRow,ticks,subticks,totalLoops,lastLoopPos,nextSpeed,divider,cycles,clockDrift,
     midiClockCycles,midiClockDrift,midiTimeCycles,midiTimeDrift,changeOrd,changePos,totalTime.toString(),
-    totalTicksR,curMidiClock,curMidiTime,totalCmds,lastCmds,cmdsPerSecond,
+    totalTicksR,curMidiClock,curMidiTime,(int)totalCmds,lastCmds,cmdsPerSecond,
     (int)extValue,(int)tempoAccum,(int)totalProcessed,(int)bufferPos
   );
 }
@@ -1568,6 +2328,10 @@ DivInstrument* DivEngine::getIns(int index, DivInstrumentType fallbackType) {
   return song.ins[index];
 }
 
+DivWaveSynthCache& DivEngine::getWaveSynthCache() {
+  return wsCache;
+}
+
 DivWavetable* DivEngine::getWave(int index) {
   if (index<0 || index>=song.waveLen) {
     if (song.waveLen>0) {
@@ -1594,7 +2358,7 @@ void DivEngine::setLoops(int loops) {
 }
 
 DivChannelState* DivEngine::getChanState(int ch) {
-  if (ch<0 || ch>=song.chans) return NULL;
+  if (ch<0 || ch>=song.chans || ch>=(int)chan.size()) return NULL;
   return &chan[ch];
 }
 
@@ -1622,6 +2386,119 @@ DivChannelModeHints DivEngine::getChanModeHints(int ch) {
   return disCont[song.dispatchOfChan[ch]].dispatch->getModeHints(song.dispatchChanOfChan[ch]);
 }
 
+void DivEngine::publishVizState() {
+  // only the audio thread writes, so the sequence number can be read relaxed
+  unsigned int seq=vizSeq.load(std::memory_order_relaxed);
+  vizSeq.store(seq+1,std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  vizPub.oscWritePos=oscWritePos;
+  vizPub.oscSize=oscSize;
+  memcpy(vizPub.chipPeak,chipPeak,sizeof(chipPeak));
+
+  vizSeq.store(seq+2,std::memory_order_release);
+}
+
+bool DivEngine::getVizState(DivVizState& out) {
+  for (int i=0; i<DIV_VIZ_READ_TRIES; i++) {
+    unsigned int seq=vizSeq.load(std::memory_order_acquire);
+    if (seq&1) {
+      // being written
+      std::this_thread::yield();
+      continue;
+    }
+    DivVizState copy;
+    memcpy(&copy,&vizPub,sizeof(DivVizState));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (vizSeq.load(std::memory_order_relaxed)!=seq) continue;
+
+    out=copy;
+    out.seq=seq;
+    return true;
+  }
+  return false;
+}
+
+static size_t regPoolBytes(int size, int depth) {
+  if (size<=0) return 0;
+  return (size_t)size*(size_t)MAX(1,depth>>3);
+}
+
+void DivEngine::reserveRegPoolSnapshots() {
+  // called with the engine lock held, so the audio thread isn't publishing
+  for (int i=0; i<song.systemLen; i++) {
+    DivRegPoolSnapshot& snap=regPoolPub[i];
+    snap.size=0;
+    snap.depth=8;
+    if (disCont[i].dispatch==NULL) {
+      snap.data.clear();
+      continue;
+    }
+    snap.data.resize(regPoolBytes(disCont[i].dispatch->getRegisterPoolSize(),disCont[i].dispatch->getRegisterPoolDepth()));
+  }
+  regPoolPubCount=song.systemLen;
+}
+
+void DivEngine::publishRegPools() {
+  // same as publishVizState()
+  unsigned int seq=regPoolSeq.load(std::memory_order_relaxed);
+  regPoolSeq.store(seq+1,std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  for (int i=0; i<regPoolPubCount; i++) {
+    DivRegPoolSnapshot& snap=regPoolPub[i];
+    unsigned char* pool=(disCont[i].dispatch==NULL)?NULL:disCont[i].dispatch->getRegisterPool();
+    if (pool==NULL) {
+      snap.size=0;
+      continue;
+    }
+    int size=disCont[i].dispatch->getRegisterPoolSize();
+    int depth=disCont[i].dispatch->getRegisterPoolDepth();
+    size_t bytes=regPoolBytes(size,depth);
+    // the size may have changed with the chip flags. don't allocate here
+    if (bytes>snap.data.size()) {
+      bytes=snap.data.size();
+      size=bytes/MAX(1,depth>>3);
+    }
+    memcpy(snap.data.data(),pool,bytes);
+    snap.size=size;
+    snap.depth=depth;
+  }
+
+  regPoolSeq.store(seq+2,std::memory_order_release);
+}
+
+bool DivEngine::getRegisterPoolSnapshot(std::vector<DivRegPoolSnapshot>& out, unsigned int* seq) {
+  for (int i=0; i<DIV_VIZ_READ_TRIES; i++) {
+    unsigned int curSeq=regPoolSeq.load(std::memory_order_acquire);
+    if (curSeq==0) return false;
+    if (curSeq&1) {
+      // being written
+      std::this_thread::yield();
+      continue;
+    }
+    int count=regPoolPubCount;
+    if (count<0 || count>DIV_MAX_CHIPS) continue;
+    out.resize(count);
+    for (int j=0; j<count; j++) {
+      const DivRegPoolSnapshot& snap=regPoolPub[j];
+      int size=snap.size;
+      int depth=snap.depth;
+      size_t bytes=MIN(regPoolBytes(size,depth),snap.data.size());
+      out[j].data.resize(bytes);
+      if (bytes>0) memcpy(out[j].data.data(),snap.data.data(),bytes);
+      out[j].size=size;
+      out[j].depth=depth;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (regPoolSeq.load(std::memory_order_relaxed)!=curSeq) continue;
+
+    if (seq!=NULL) *seq=curSeq;
+    return true;
+  }
+  return false;
+}
+
 unsigned char* DivEngine::getRegisterPool(int sys, int& size, int& depth) {
   if (sys<0 || sys>=song.systemLen) return NULL;
   if (disCont[sys].dispatch==NULL) return NULL;
@@ -1642,6 +2519,17 @@ DivSamplePos DivEngine::getSamplePos(int chan) {
   return disCont[song.dispatchOfChan[chan]].dispatch->getSamplePos(song.dispatchChanOfChan[chan]);
 }
 
+void DivEngine::addOscConsumer() {
+  oscConsumers++;
+}
+
+void DivEngine::removeOscConsumer() {
+  if (--oscConsumers<0) {
+    logW("removeOscConsumer() called too many times!");
+    oscConsumers=0;
+  }
+}
+
 DivDispatchOscBuffer* DivEngine::getOscBuffer(int chan) {
   if (chan<0 || chan>=song.chans) return NULL;
   if (song.dispatchChanOfChan[chan]<0) return NULL;
@@ -1687,17 +2575,305 @@ TimeMicros DivEngine::getFilePlayerCue() {
 
 void DivEngine::setFilePlayerCue(TimeMicros cue) {
   filePlayerCue=cue;
+  updateFilePlayerCues();
 }
 
 void DivEngine::syncFilePlayer() {
   if (curFilePlayer==NULL) return;
   curFilePlayer->setPosSeconds(totalTime+filePlayerCue);
+  updateFilePlayerCues();
 }
 
-void DivEngine::playSub(bool preserveDrift, int goalRow) {
-  logV("playSub() called");
-  std::chrono::high_resolution_clock::time_point timeStart=std::chrono::high_resolution_clock::now();
-  for (int i=0; i<song.systemLen; i++) disCont[i].dispatch->setSkipRegisterWrites(false);
+void DivEngine::updateFilePlayerCues() {
+  if (curFilePlayer==NULL) return;
+  if (!curFilePlayer->isLoaded()) return;
+
+  // the song start, the loop start, and the current and next orders
+  DivSongTimestamps& ts=curSubSong->ts;
+  std::vector<TimeMicros> cues;
+  cues.push_back(filePlayerCue);
+  if (ts.isLoopable) cues.push_back(ts.loopStartTime+filePlayerCue);
+  for (int i=curOrder; i<curOrder+2 && i<curSubSong->ordersLen; i++) {
+    TimeMicros t=ts.getTimes(i,0);
+    if (t.seconds<0) continue;
+    cues.push_back(t+filePlayerCue);
+  }
+  curFilePlayer->setCuePoints(cues);
+}
+
+void DivEngine::invalidateSnapshots(int fromOrder) {
+  if (fromOrder<0) fromOrder=0;
+  int prev=snapshotInvalidFrom.load();
+  while (fromOrder<prev && !snapshotInvalidFrom.compare_exchange_weak(prev,fromOrder));
+  requestRenderAheadRollback();
+}
+
+void DivEngine::invalidatePatternSnapshots(int chan, int pat) {
+  if (curSubSong==NULL) return;
+  if (chan<0 || chan>=DIV_MAX_CHANS) return;
+  // the same pattern may be used by many orders. find the first one.
+  for (int i=0; i<curSubSong->ordersLen; i++) {
+    if (curOrders->ord[chan][i]==pat) {
+      invalidateSnapshots(i);
+      return;
+    }
+  }
+}
+
+void DivEngine::applySnapshotInvalidation() {
+  int from=snapshotInvalidFrom.exchange(INT_MAX);
+  if (from==INT_MAX) return;
+  for (auto i=snapshots.lower_bound(from); i!=snapshots.end();) {
+    DivPlaybackSnapshot* snap=i->second;
+    for (int j=0; j<snap->dispCount; j++) {
+      disCont[j].dispatch->freeState(snap->dispState[j]);
+    }
+    delete snap;
+    i=snapshots.erase(i);
+  }
+}
+
+void DivEngine::clearSnapshots() {
+  snapshotInvalidFrom=0;
+  applySnapshotInvalidation();
+}
+
+void DivEngine::fillSnapshot(DivPlaybackSnapshot* snap) {
+  snap->subticks=subticks;
+  snap->ticks=ticks;
+  snap->curRow=curRow;
+  snap->curOrder=curOrder;
+  snap->prevRow=prevRow;
+  snap->prevOrder=prevOrder;
+  snap->totalLoops=totalLoops;
+  snap->lastLoopPos=lastLoopPos;
+  snap->nextSpeed=nextSpeed;
+  snap->prevSpeed=prevSpeed;
+  snap->elapsedBars=elapsedBars;
+  snap->elapsedBeats=elapsedBeats;
+  snap->curSpeed=curSpeed;
+  snap->divider=divider;
+  snap->cycles=cycles;
+  snap->clockDrift=clockDrift;
+  snap->midiClockCycles=midiClockCycles;
+  snap->midiClockDrift=midiClockDrift;
+  snap->midiTimeCycles=midiTimeCycles;
+  snap->midiTimeDrift=midiTimeDrift;
+  snap->stepPlay=stepPlay;
+  snap->changeOrd=changeOrd;
+  snap->changePos=changePos;
+  snap->totalTicksR=totalTicksR;
+  snap->curMidiClock=curMidiClock;
+  snap->curMidiTime=curMidiTime;
+  snap->totalTime=totalTime;
+  snap->totalTimeDrift=totalTimeDrift;
+  snap->curMidiTimePiece=curMidiTimePiece;
+  snap->curMidiTimeCode=curMidiTimeCode;
+  snap->extValue=extValue;
+  snap->pendingMetroTick=pendingMetroTick;
+  snap->arpLen=curSubSong->arpLen;
+  snap->extValuePresent=extValuePresent;
+  snap->endOfSong=endOfSong;
+  snap->shallStop=shallStop;
+  snap->shallStopSched=shallStopSched;
+  snap->firstTick=firstTick;
+  snap->speeds=speeds;
+  snap->virtualTempoN=virtualTempoN;
+  snap->virtualTempoD=virtualTempoD;
+  snap->tempoAccum=tempoAccum;
+  snap->chan.assign(chan.begin(),chan.begin()+MIN((size_t)song.chans,chan.size()));
+  memcpy(snap->walked,walked,8192);
+}
+
+void DivEngine::captureSnapshot() {
+  if (snapshotInterval<=0) return;
+  if (curOrder<=0 || (curOrder%snapshotInterval)!=0) return;
+  if (curSubSong==NULL) return;
+  applySnapshotInvalidation();
+  if (snapshots.find(curOrder)!=snapshots.end()) return;
+
+  // only possible if every dispatch supports state saves
+  void* dispState[DIV_MAX_CHIPS];
+  for (int i=0; i<song.systemLen; i++) {
+    dispState[i]=disCont[i].dispatch->getState();
+    if (dispState[i]==NULL) {
+      for (int j=0; j<i; j++) {
+        disCont[j].dispatch->freeState(dispState[j]);
+      }
+      return;
+    }
+  }
+
+  DivPlaybackSnapshot* snap=new DivPlaybackSnapshot;
+  fillSnapshot(snap);
+  snap->dispCount=song.systemLen;
+  memcpy(snap->dispState,dispState,song.systemLen*sizeof(void*));
+  snapshots[curOrder]=snap;
+
+  // the song may have been edited while we were capturing
+  applySnapshotInvalidation();
+}
+
+void DivEngine::restoreSnapshot(DivPlaybackSnapshot* snap) {
+  subticks=snap->subticks;
+  ticks=snap->ticks;
+  curRow=snap->curRow;
+  curOrder=snap->curOrder;
+  prevRow=snap->prevRow;
+  prevOrder=snap->prevOrder;
+  totalLoops=snap->totalLoops;
+  lastLoopPos=snap->lastLoopPos;
+  nextSpeed=snap->nextSpeed;
+  prevSpeed=snap->prevSpeed;
+  elapsedBars=snap->elapsedBars;
+  elapsedBeats=snap->elapsedBeats;
+  curSpeed=snap->curSpeed;
+  divider=snap->divider;
+  cycles=snap->cycles;
+  clockDrift=snap->clockDrift;
+  midiClockCycles=snap->midiClockCycles;
+  midiClockDrift=snap->midiClockDrift;
+  midiTimeCycles=snap->midiTimeCycles;
+  midiTimeDrift=snap->midiTimeDrift;
+  stepPlay=snap->stepPlay;
+  changeOrd=snap->changeOrd;
+  changePos=snap->changePos;
+  totalTicksR=snap->totalTicksR;
+  curMidiClock=snap->curMidiClock;
+  curMidiTime=snap->curMidiTime;
+  totalTime=snap->totalTime;
+  totalTimeDrift=snap->totalTimeDrift;
+  curMidiTimePiece=snap->curMidiTimePiece;
+  curMidiTimeCode=snap->curMidiTimeCode;
+  extValue=snap->extValue;
+  pendingMetroTick=snap->pendingMetroTick;
+  curSubSong->arpLen=snap->arpLen;
+  extValuePresent=snap->extValuePresent;
+  endOfSong=snap->endOfSong;
+  shallStop=snap->shallStop;
+  shallStopSched=snap->shallStopSched;
+  firstTick=snap->firstTick;
+  speeds=snap->speeds;
+  virtualTempoN=snap->virtualTempoN;
+  virtualTempoD=snap->virtualTempoD;
+  tempoAccum=snap->tempoAccum;
+  for (size_t i=0; i<snap->chan.size() && i<chan.size(); i++) {
+    chan[i]=snap->chan[i];
+  }
+  memcpy(walked,snap->walked,8192);
+  for (int i=0; i<snap->dispCount; i++) {
+    disCont[i].dispatch->setState(snap->dispState[i]);
+  }
+}
+
+bool DivEngine::fastSeek(int goal) {
+  if (curSubSong==NULL) return false;
+  // the MIDI clock has to be sent for every tick
+  if (output) if (output->midiOut!=NULL) {
+    if (output->midiOut->isDeviceOpen()) return false;
+  }
+  // a background calculation would overwrite the checkpoints
+  if (tsThread!=NULL) return false;
+  // this may run in the audio thread, so timestamps are not calculated here.
+  // they are only used if they are up to date and nobody is writing them.
+  if (!tsLock.try_lock()) return false;
+  bool ret=false;
+  if (curSubSong->timestampsUpToDate(song.chans,song.grooves,song.compatFlags.jumpTreatment,song.compatFlags.ignoreJumpAtEnd,song.compatFlags.brokenSpeedSel,song.compatFlags.delayBehavior)) {
+    ret=seekToCheckpoint(goal);
+  }
+  tsLock.unlock();
+  return ret;
+}
+
+bool DivEngine::seekToCheckpoint(int goal) {
+  DivSongTimestamps& ts=curSubSong->ts;
+  // start from the current position (which may come from a seek snapshot)
+  int from=0;
+  if (curOrder>0) {
+    if (curOrder>=DIV_MAX_PATTERNS) return false;
+    from=ts.checkpointOf[curOrder];
+    if (from<0) return false;
+    if (ts.checkpoints[from].row!=curRow) return false;
+  }
+  // the engine stops at the first order at or after the goal
+  int found=-1;
+  for (int i=from; i<(int)ts.checkpoints.size(); i++) {
+    if (ts.checkpoints[i].order>=goal) {
+      found=i;
+      break;
+    }
+  }
+  // not reached before looping (or already there)
+  if (found<0) return false;
+  DivSongTimestamps::Checkpoint& c=ts.checkpoints[found];
+  if (c.order<=curOrder) return false;
+
+  curOrder=c.order;
+  curRow=c.row;
+  prevOrder=c.prevOrder;
+  prevRow=c.prevRow;
+  speeds=c.speeds;
+  virtualTempoN=c.virtualTempoN;
+  virtualTempoD=c.virtualTempoD;
+  nextSpeed=c.nextSpeed;
+  divider=c.divider;
+  ticks=c.ticks;
+  subticks=1;
+  tempoAccum=c.tempoAccum;
+  curSpeed=c.speed;
+  changeOrd=c.changeOrd;
+  changePos=c.changePos;
+  shallStopSched=c.shallStopSched;
+  totalTime=c.totalTime;
+  totalTimeDrift=c.microsOff;
+  totalTicksR=(int)c.totalTicks;
+  memset(walked,0,8192);
+  memcpy(walked,c.walked.data(),MIN(8192,c.walked.size()));
+  for (int i=0; i<song.chans; i++) {
+    chan[i].rowDelay=c.rowDelay[i];
+    chan[i].delayOrder=c.delayOrder[i];
+    chan[i].delayRow=c.delayRow[i];
+  }
+
+  // set the last instrument and volume of every channel.
+  // every row before the checkpoint was played once, and time increases between rows.
+  for (int i=0; i<song.chans; i++) {
+    TimeMicros insTime(-1,0), volTime(-1,0);
+    int ins=-1, vol=-1;
+    for (int j=0; j<curSubSong->ordersLen; j++) {
+      if (ts.orders[j]==NULL) continue;
+      DivPattern* p=curSubSong->pat[i].getPattern(curSubSong->orders.ord[i][j],false);
+      for (int k=0; k<curSubSong->patLen; k++) {
+        TimeMicros t=ts.orders[j][k];
+        if (t.seconds<0 || t>=c.totalTime) continue;
+        if (p->newData[k][DIV_PAT_INS]!=-1 && insTime<t) {
+          insTime=t;
+          ins=p->newData[k][DIV_PAT_INS];
+        }
+        if (p->newData[k][DIV_PAT_VOL]!=-1 && volTime<t) {
+          volTime=t;
+          vol=p->newData[k][DIV_PAT_VOL];
+        }
+      }
+    }
+    if (ins!=-1 && chan[i].lastIns!=ins) {
+      dispatchCmd(DivCommand(DIV_CMD_INSTRUMENT,i,ins));
+      chan[i].lastIns=ins;
+    }
+    if (vol!=-1) {
+      chan[i].volume=vol<<8;
+      dispatchCmd(DivCommand(DIV_CMD_VOLUME,i,chan[i].volume>>8));
+      dispatchCmd(DivCommand(DIV_CMD_HINT_VOLUME,i,chan[i].volume>>8));
+    }
+  }
+  logV("fast seek to order %d (checkpoint %d)",curOrder,found);
+  return true;
+}
+
+void DivEngine::playSub(bool preserveDrift, int goalRow) {
+  logV("playSub() called");
+  std::chrono::high_resolution_clock::time_point timeStart=std::chrono::high_resolution_clock::now();
+  for (int i=0; i<song.systemLen; i++) disCont[i].dispatch->setSkipRegisterWrites(false);
   reset();
   if (preserveDrift && curOrder==0) {
     logV("preserveDrift && curOrder is true");
@@ -1744,6 +2920,22 @@ void DivEngine::playSub(bool preserveDrift, int goalRow) {
   memset(walked,0,8192);
   for (int i=0; i<song.systemLen; i++) disCont[i].dispatch->setSkipRegisterWrites(true);
   logV("goal: %d goalRow: %d",goal,goalRow);
+  // snapshots are only valid if the orders walked before them were all lower.
+  // this way the walk could not have stopped earlier.
+  int maxOrder=0;
+  if (!preserveDrift) {
+    applySnapshotInvalidation();
+    auto snap=snapshots.upper_bound(goal);
+    if (snap!=snapshots.begin()) {
+      --snap;
+      logV("restoring snapshot at order %d",snap->first);
+      restoreSnapshot(snap->second);
+      maxOrder=curOrder;
+    }
+    if (fastSeekOn && curOrder<goal) {
+      if (fastSeek(goal)) maxOrder=curOrder;
+    }
+  }
   while (playing && curOrder<goal) {
     if (nextTick(preserveDrift)) {
       skipping=false;
@@ -1757,6 +2949,10 @@ void DivEngine::playSub(bool preserveDrift, int goalRow) {
     if (!preserveDrift) {
       runMidiClock(cycles);
       runMidiTime(cycles);
+      if (curOrder>maxOrder) {
+        maxOrder=curOrder;
+        captureSnapshot();
+      }
     }
   }
   int oldOrder=curOrder;
@@ -1902,10 +3098,15 @@ int DivEngine::calcFreq(int base, int pitch, int arp, bool arpFixed, bool period
         nbase+=arp<<7;
       }
     }
-    double fbase=(period?(song.tuning*0.0625):song.tuning)*pow(2.0,(float)(nbase+384)/(128.0*12.0));
-    int bf=period?
-           round((clock/fbase)/divider):
-           round(fbase*(divider/clock));
+    double fbase=(period?(song.tuning*0.0625):song.tuning)*divPitchRatio(nbase+384);
+    double bfRaw=period?((clock/fbase)/divider):(fbase*(divider/clock));
+    // the table may differ from pow() in the last bit. if we are close to a
+    // rounding boundary, fall back to pow() so that the result is identical.
+    if (fabs(bfRaw-floor(bfRaw)-0.5)<1e-6) {
+      fbase=(period?(song.tuning*0.0625):song.tuning)*pow(2.0,(float)(nbase+384)/(128.0*12.0));
+      bfRaw=period?((clock/fbase)/divider):(fbase*(divider/clock));
+    }
+    int bf=round(bfRaw);
     if (blockBits>0) {
       if (fixedBlock>0) {
         CONVERT_FNUM_FIXEDBLOCK(bf,blockBits,fixedBlock-1);
@@ -1977,7 +3178,7 @@ bool DivEngine::play() {
   curMidiTimePiece=0;
   if (output) if (!skipping && output->midiOut!=NULL) {
     if (midiOutClock) {
-      output->midiOut->send(TAMidiMessage(TA_MIDI_POSITION,(curMidiClock>>7)&0x7f,curMidiClock&0x7f));
+      sendMidiOut(TAMidiMessage(TA_MIDI_POSITION,(curMidiClock>>7)&0x7f,curMidiClock&0x7f));
     }
     if (midiOutTime) {
       TAMidiMessage msg;
@@ -2040,9 +3241,9 @@ bool DivEngine::play() {
       msgData[3]=0x01;
       msgData[4]=0x01;
       msgData[9]=0xf7;
-      output->midiOut->send(msg);
+      sendMidiOut(msg);
     }
-    output->midiOut->send(TAMidiMessage(TA_MIDI_MACHINE_PLAY,0,0));
+    sendMidiOut(TAMidiMessage(TA_MIDI_MACHINE_PLAY,0,0));
   }
   bool didItPlay=playing;
   if (didItPlay) {
@@ -2108,7 +3309,7 @@ void DivEngine::stop() {
   if (!playing) {
     //Send midi panic
     if (output) if (output->midiOut!=NULL) {
-      output->midiOut->send(TAMidiMessage(TA_MIDI_CONTROL,0x7B,0));
+      sendMidiOut(TAMidiMessage(TA_MIDI_CONTROL,0x7B,0));
       logV("Midi panic sent");
     }
   }
@@ -2127,16 +3328,18 @@ void DivEngine::stop() {
     disCont[i].dispatch->notifyPlaybackStop();
   }
   if (output) if (output->midiOut!=NULL) {
-    output->midiOut->send(TAMidiMessage(TA_MIDI_MACHINE_STOP,0,0));
+    sendMidiOut(TAMidiMessage(TA_MIDI_MACHINE_STOP,0,0));
     for (int i=0; i<song.chans; i++) {
       if (chan[i].curMidiNote>=0) {
-        output->midiOut->send(TAMidiMessage(0x80|(i&15),chan[i].curMidiNote,0));
+        sendMidiOut(TAMidiMessage(0x80|(i&15),chan[i].curMidiNote,0));
       }
     }
   }
 
   if (curFilePlayer && filePlayerSync) {
     curFilePlayer->stop();
+    // playback will most likely resume from here
+    updateFilePlayerCues();
   }
 
   // reset all chan oscs
@@ -2180,17 +3383,20 @@ const char** DivEngine::getRegisterSheet(int sys) {
 }
 
 void DivEngine::reset() {
+  renderAheadEpoch++;
   if (output) if (output->midiOut!=NULL) {
-    output->midiOut->send(TAMidiMessage(TA_MIDI_MACHINE_STOP,0,0));
-    for (int i=0; i<song.chans; i++) {
+    sendMidiOut(TAMidiMessage(TA_MIDI_MACHINE_STOP,0,0));
+    for (size_t i=0; i<chan.size(); i++) {
       if (chan[i].curMidiNote>=0) {
-        output->midiOut->send(TAMidiMessage(0x80|(i&15),chan[i].curMidiNote,0));
+        sendMidiOut(TAMidiMessage(0x80|(i&15),chan[i].curMidiNote,0));
       }
     }
   }
-  for (int i=0; i<DIV_MAX_CHANS; i++) {
+  // the channel count may have changed
+  chan.resize(song.chans);
+  for (int i=0; i<song.chans; i++) {
     chan[i]=DivChannelState();
-    if (i<song.chans && song.dispatchChanOfChan[i]>=0) {
+    if (song.dispatchChanOfChan[i]>=0) {
       chan[i].volMax=(disCont[song.dispatchOfChan[i]].dispatch->dispatch(DivCommand(DIV_CMD_GET_VOLMAX,song.dispatchChanOfChan[i]))<<8)|0xff;
     }
     chan[i].volume=chan[i].volMax;
@@ -2338,27 +3544,22 @@ void DivEngine::noteToSplitNote(short note, short& outNote, short& outOctave) {
 }
 
 void DivEngine::previewSample(int sample, int note, int pStart, int pEnd) {
-  BUSY_BEGIN;
-  previewSampleNoLock(sample,note,pStart,pEnd);
-  BUSY_END;
+  DivLiveInput ev(DIV_LIVE_PREVIEW_SAMPLE,-1,sample,note);
+  ev.pStart=pStart;
+  ev.pEnd=pEnd;
+  pushLiveInput(ev);
 }
 
 void DivEngine::stopSamplePreview() {
-  BUSY_BEGIN;
-  stopSamplePreviewNoLock();
-  BUSY_END;
+  pushLiveInput(DivLiveInput(DIV_LIVE_STOP_SAMPLE));
 }
 
 void DivEngine::previewWave(int wave, int note) {
-  BUSY_BEGIN;
-  previewWaveNoLock(wave,note);
-  BUSY_END;
+  pushLiveInput(DivLiveInput(DIV_LIVE_PREVIEW_WAVE,-1,wave,note));
 }
 
 void DivEngine::stopWavePreview() {
-  BUSY_BEGIN;
-  stopWavePreviewNoLock();
-  BUSY_END;
+  pushLiveInput(DivLiveInput(DIV_LIVE_STOP_WAVE));
 }
 
 void DivEngine::previewSampleNoLock(int sample, int note, int pStart, int pEnd) {
@@ -2460,6 +3661,7 @@ String DivEngine::getConfigPath() {
 }
 
 int DivEngine::getMaxVolumeChan(int ch) {
+  if (ch<0 || ch>=(int)chan.size()) return 0;
   return chan[ch].volMax>>8;
 }
 
@@ -2613,6 +3815,7 @@ void DivEngine::toggleSolo(int chan) {
       }
     }
   }
+  requestRenderAheadRollback();
   BUSY_END;
 }
 
@@ -2622,6 +3825,7 @@ void DivEngine::muteChannel(int chan, bool mute) {
   if (disCont[song.dispatchOfChan[chan]].dispatch!=NULL && song.dispatchChanOfChan[chan]>=0) {
     disCont[song.dispatchOfChan[chan]].dispatch->muteChannel(song.dispatchChanOfChan[chan],isMuted[chan]);
   }
+  requestRenderAheadRollback();
   BUSY_END;
 }
 
@@ -2633,6 +3837,7 @@ void DivEngine::unmuteAll() {
       disCont[song.dispatchOfChan[i]].dispatch->muteChannel(song.dispatchChanOfChan[i],isMuted[i]);
     }
   }
+  requestRenderAheadRollback();
   BUSY_END;
 }
 
@@ -2656,13 +3861,22 @@ void DivEngine::dumpSongInfo() {
   );
 
   printf("SUB-SONGS\n");
+  calcAllSongTimestamps();
   int index=0;
   for (DivSubSong* i: song.subsong) {
+    String length=i->ts.totalTime.toString(-1,TA_TIME_FORMAT_AUTO);
+    String loopInfo="stops";
+    if (i->ts.isLoopable) {
+      loopInfo="loops from "+i->ts.loopStartTime.toString(-1,TA_TIME_FORMAT_AUTO);
+    }
     printf(
       "=== %d: %s\n"
+      "- length: %s (%s)\n"
       "<<<\n%s\n>>>\n",
       index,
       i->name.c_str(),
+      length.c_str(),
+      loopInfo.c_str(),
       i->notes.c_str()
     );
     index++;
@@ -2766,6 +3980,30 @@ int DivEngine::addInstrumentPtr(DivInstrument* which) {
   return song.insLen;
 }
 
+int DivEngine::addInstrumentsPtr(const std::vector<DivInstrument*>& which) {
+  bool full=false;
+  BUSY_BEGIN;
+  saveLock.lock();
+  for (DivInstrument* i: which) {
+    if (song.ins.size()>=256) {
+      delete i;
+      full=true;
+      continue;
+    }
+    song.ins.push_back(i);
+    for (int j=0; j<song.systemLen; j++) {
+      disCont[j].dispatch->notifyInsAddition(j);
+    }
+  }
+  song.insLen=song.ins.size();
+  checkAssetDir(song.insDir,song.ins.size());
+  checkAssetDir(song.waveDir,song.wave.size());
+  checkAssetDir(song.sampleDir,song.sample.size());
+  saveLock.unlock();
+  BUSY_END;
+  return full?-1:song.insLen;
+}
+
 void DivEngine::loadTempIns(DivInstrument* which) {
   BUSY_BEGIN;
   if (tempIns==NULL) {
@@ -2989,6 +4227,7 @@ DivWavetable* DivEngine::waveFromFile(const char* path, bool addRaw) {
 
 void DivEngine::delWaveUnsafe(int index) {
   if (index>=0 && index<(int)song.wave.size()) {
+    wsCache.invalidate(song.wave[index]);
     delete song.wave[index];
     song.wave.erase(song.wave.begin()+index);
     song.waveLen=song.wave.size();
@@ -3561,26 +4800,96 @@ void DivEngine::patchDisconnectAll(unsigned int portSet) {
 
 void DivEngine::noteOn(int chan, int ins, int note, int vol) {
   if (chan<0 || chan>=song.chans) return;
-  BUSY_BEGIN;
-  pendingNotes.push_back(DivNoteEvent(chan,ins,note,vol,true));
-  if (!playing) {
-    reset();
-    freelance=true;
-    playing=true;
-  }
-  BUSY_END;
+  pushLiveInput(DivLiveInput(DIV_LIVE_NOTE_ON,chan,ins,note,vol));
 }
 
 void DivEngine::noteOff(int chan) {
   if (chan<0 || chan>=song.chans) return;
-  BUSY_BEGIN;
-  pendingNotes.push_back(DivNoteEvent(chan,-1,-1,-1,false));
-  if (!playing) {
-    reset();
-    freelance=true;
-    playing=true;
+  pushLiveInput(DivLiveInput(DIV_LIVE_NOTE_OFF,chan));
+}
+
+void DivEngine::queueAutoNoteOn(int baseChan, int ins, int note, int vol, int transpose, std::atomic<bool>* failed) {
+  DivLiveInput ev(DIV_LIVE_AUTO_NOTE_ON,baseChan,ins,note,vol);
+  ev.transpose=transpose;
+  ev.failed=failed;
+  pushLiveInput(ev);
+}
+
+void DivEngine::queueAutoNoteOff(int note) {
+  pushLiveInput(DivLiveInput(DIV_LIVE_AUTO_NOTE_OFF,-1,-1,note));
+}
+
+void DivEngine::pushLiveInput(const DivLiveInput& ev) {
+  liveInputLock.lock();
+  if (!liveInputQueue.push(ev)) {
+    logW("live input queue full!");
+  }
+  liveInputLock.unlock();
+}
+
+// called by nextBuf() with the engine lock held.
+// events are popped one at a time so the GUI is never kept waiting.
+void DivEngine::processLiveInput() {
+  DivLiveInput ev;
+  while (true) {
+    liveInputLock.lock();
+    if (liveInputQueue.empty()) {
+      liveInputLock.unlock();
+      break;
+    }
+    ev=liveInputQueue.front();
+    liveInputQueue.pop();
+    liveInputLock.unlock();
+    // this can't be undone by a render-ahead rollback
+    renderAheadEpoch++;
+
+    switch (ev.type) {
+      case DIV_LIVE_NOTE_ON:
+      case DIV_LIVE_NOTE_OFF:
+        if (ev.chan<0 || ev.chan>=song.chans) break;
+        if (ev.type==DIV_LIVE_NOTE_ON) {
+          pendingNotes.push_back(DivNoteEvent(ev.chan,ev.ins,ev.note,ev.vol,true));
+        } else {
+          pendingNotes.push_back(DivNoteEvent(ev.chan,-1,-1,-1,false));
+        }
+        if (!playing) {
+          reset();
+          freelance=true;
+          playing=true;
+        }
+        break;
+      case DIV_LIVE_AUTO_NOTE_ON:
+        if (ev.chan>=0) setMidiBaseChan(ev.chan);
+        if (!autoNoteOn(-1,ev.ins,ev.note,ev.vol,ev.transpose)) {
+          if (ev.failed!=NULL) *ev.failed=true;
+        }
+        break;
+      case DIV_LIVE_AUTO_NOTE_OFF:
+        autoNoteOff(-1,ev.note);
+        break;
+      case DIV_LIVE_AUTO_NOTE_OFF_ALL:
+        if (!playing) break;
+        for (int i=0; i<song.chans; i++) {
+          if (chan[i].midiNote!=-1) {
+            pendingNotes.push_back(DivNoteEvent(i,-1,-1,-1,false));
+            chan[i].midiNote=-1;
+          }
+        }
+        break;
+      case DIV_LIVE_PREVIEW_SAMPLE:
+        previewSampleNoLock(ev.ins,ev.note,ev.pStart,ev.pEnd);
+        break;
+      case DIV_LIVE_STOP_SAMPLE:
+        stopSamplePreviewNoLock();
+        break;
+      case DIV_LIVE_PREVIEW_WAVE:
+        previewWaveNoLock(ev.ins,ev.note);
+        break;
+      case DIV_LIVE_STOP_WAVE:
+        stopWavePreviewNoLock();
+        break;
+    }
   }
-  BUSY_END;
 }
 
 int DivEngine::getViableChannel(int chan, int off, int ins) {
@@ -3732,15 +5041,7 @@ void DivEngine::autoNoteOff(int ch, int note, int vol) {
 }
 
 void DivEngine::autoNoteOffAll() {
-  if (!playing) {
-    return;
-  }
-  for (int i=0; i<song.chans; i++) {
-    if (chan[i].midiNote!=-1) {
-      pendingNotes.push_back(DivNoteEvent(i,-1,-1,-1,false));
-      chan[i].midiNote=-1;
-    }
-  }
+  pushLiveInput(DivLiveInput(DIV_LIVE_AUTO_NOTE_OFF_ALL));
 }
 
 void DivEngine::setAutoNotePoly(bool poly) {
@@ -3765,6 +5066,13 @@ void DivEngine::setOrder(unsigned char order) {
 
 void DivEngine::updateSysFlags(int system, bool restart, bool render) {
   BUSY_BEGIN_SOFT;
+  renderAheadEpoch++;
+  invalidateSnapshots();
+  // if the chip supports state saves, it is carried over to the new flags
+  void* state=NULL;
+  if (restart && isPlaying() && !render) {
+    state=disCont[system].dispatch->getState();
+  }
   disCont[system].dispatch->setFlags(song.systemFlags[system]);
   disCont[system].setRates(got.rate);
   if (render) renderSamples();
@@ -3777,7 +5085,18 @@ void DivEngine::updateSysFlags(int system, bool restart, bool render) {
   }
 
   if (restart) {
-    if (isPlaying()) {
+    if (state!=NULL) {
+      // restore the chip instead of seeking from the start.
+      // the position and the other chips are left alone.
+      // the state includes the old flags, so they are applied again.
+      disCont[system].dispatch->setState(state);
+      disCont[system].dispatch->freeState(state);
+      disCont[system].dispatch->setFlags(song.systemFlags[system]);
+      disCont[system].setRates(got.rate);
+      disCont[system].dispatch->forceIns();
+    } else if (isPlaying()) {
+      // seek, which replays everything on the (possibly new) core.
+      // this is also needed if sample memory was laid out again.
       playSub(false);
       if (curFilePlayer && filePlayerSync) {
         syncFilePlayer();
@@ -3803,6 +5122,10 @@ void DivEngine::setAudio(DivAudioEngines which) {
   audioEngine=which;
 }
 
+void DivEngine::setPipeFormat(TAAudioFormat which) {
+  pipeFormat=which;
+}
+
 void DivEngine::setView(DivStatusView which) {
   view=which;
 }
@@ -3831,6 +5154,9 @@ void DivEngine::setConsoleMode(bool enable, bool statusOut) {
 
 bool DivEngine::switchMaster(bool full) {
   logI("switching output...");
+  // chips keep their state unless they are re-initialized, so playback carries on
+  // from where it was. only the resamplers have to follow a new rate.
+  double prevRate=(output!=NULL)?got.rate:0.0;
   deinitAudioBackend(true);
   if (full) {
     quitDispatch();
@@ -3841,13 +5167,18 @@ bool DivEngine::switchMaster(bool full) {
     renderPool=NULL;
   }
   if (initAudioBackend()) {
+    bool rateChanged=(full || got.rate!=prevRate);
+    if (rateChanged) {
+      logD("output rate is now %g",got.rate);
+    }
     for (int i=0; i<song.systemLen; i++) {
-      disCont[i].setRates(got.rate);
+      if (rateChanged) disCont[i].setRates(got.rate);
       disCont[i].setQuality(lowQuality,dcHiPass);
     }
     if (curFilePlayer!=NULL) {
       curFilePlayer->setOutputRate(got.rate);
     }
+    reserveBuffers();
     if (!output->setRun(true)) {
       logE("error while activating audio!");
       return false;
@@ -3855,7 +5186,8 @@ bool DivEngine::switchMaster(bool full) {
   } else {
     return false;
   }
-  renderSamples();
+  // sample memory only has to be rebuilt for new chips
+  if (full) renderSamples();
   return true;
 }
 
@@ -3895,7 +5227,7 @@ bool DivEngine::sendMidiMessage(TAMidiMessage& msg) {
   }
   BUSY_BEGIN;
   logD("sending MIDI message...");
-  bool ret=(output->midiOut->send(msg));
+  bool ret=(sendMidiOut(msg));
   BUSY_END;
   return ret;
 }
@@ -3980,9 +5312,30 @@ void DivEngine::rescanMidiDevices() {
   }
 }
 
+struct DivDispatchInitTask {
+  DivDispatchContainer* dc;
+  DivEngine* e;
+  DivSystem sys;
+  int chans;
+  double rate;
+  DivConfig* flags;
+  bool isRender, lowQuality, dcHiPass;
+};
+
+static void _initDispatch(void* arg) {
+  DivDispatchInitTask* task=(DivDispatchInitTask*)arg;
+  task->dc->init(task->sys,task->e,task->chans,task->rate,*task->flags,task->isRender);
+  task->dc->setRates(task->rate);
+  task->dc->setQuality(task->lowQuality,task->dcHiPass);
+}
+
 void DivEngine::initDispatch(bool isRender) {
   BUSY_BEGIN;
   logV("initializing dispatch...");
+  renderAheadEpoch++;
+  // the song may have been replaced
+  wsCache.invalidate();
+  tsStale=true;
   if (isRender) logI("render cores set");
 
   lowQuality=getConfInt("audioQuality",0);
@@ -3994,10 +5347,31 @@ void DivEngine::initDispatch(bool isRender) {
     blip_add_delta=blip_add_delta_slow;
   }
 
+  // chips are independent of each other, so initialize them in parallel.
+  DivDispatchInitTask tasks[DIV_MAX_CHIPS];
   for (int i=0; i<song.systemLen; i++) {
-    disCont[i].init(song.system[i],this,song.systemChans[i],got.rate,song.systemFlags[i],isRender);
-    disCont[i].setRates(got.rate);
-    disCont[i].setQuality(lowQuality,dcHiPass);
+    DivDispatchInitTask& t=tasks[i];
+    t.dc=&disCont[i];
+    t.e=this;
+    t.sys=song.system[i];
+    t.chans=song.systemChans[i];
+    t.rate=got.rate;
+    t.flags=&song.systemFlags[i];
+    t.isRender=isRender;
+    t.lowQuality=lowQuality;
+    t.dcHiPass=dcHiPass;
+  }
+  unsigned int threads=std::thread::hardware_concurrency();
+  if (threads>(unsigned int)song.systemLen) threads=song.systemLen;
+  if (threads>1) {
+    DivWorkPool* pool=new DivWorkPool(threads-1);
+    pool->pushBatch(_initDispatch,tasks,song.systemLen);
+    pool->wait();
+    delete pool;
+  } else {
+    for (int i=0; i<song.systemLen; i++) {
+      _initDispatch(&tasks[i]);
+    }
   }
   if (song.patchbayAuto) {
     saveLock.lock();
@@ -4005,12 +5379,20 @@ void DivEngine::initDispatch(bool isRender) {
     saveLock.unlock();
   }
   song.recalcChans();
+  reserveBuffers();
+  reserveRegPoolSnapshots();
   BUSY_END;
 }
 
 void DivEngine::quitDispatch() {
+  waitForSamples();
   BUSY_BEGIN;
   logV("terminating dispatch...");
+  // snapshots hold dispatch states, so they must go first
+  clearSnapshots();
+  clearRenderAheadSnapshots();
+  renderAheadEpoch++;
+  regPoolPubCount=0;
   for (int i=0; i<song.systemLen; i++) {
     disCont[i].quit();
   }
@@ -4060,12 +5442,14 @@ bool DivEngine::initAudioBackend() {
   // load values
   logI("initializing audio.");
   if (audioEngine==DIV_AUDIO_NULL) {
-    if (getConfString("audioEngine","SDL")=="JACK") {
+    if (getConfString("audioEngine",DIV_AUDIO_ENGINE_DEFAULT)=="JACK") {
       audioEngine=DIV_AUDIO_JACK;
-    } else if (getConfString("audioEngine","SDL")=="PortAudio") {
+    } else if (getConfString("audioEngine",DIV_AUDIO_ENGINE_DEFAULT)=="PortAudio") {
       audioEngine=DIV_AUDIO_PORTAUDIO;
-    } else if (getConfString("audioEngine","SDL")=="ASIO") {
+    } else if (getConfString("audioEngine",DIV_AUDIO_ENGINE_DEFAULT)=="ASIO") {
       audioEngine=DIV_AUDIO_ASIO;
+    } else if (getConfString("audioEngine",DIV_AUDIO_ENGINE_DEFAULT)=="AAudio") {
+      audioEngine=DIV_AUDIO_AAUDIO;
     } else {
       audioEngine=DIV_AUDIO_SDL;
     }
@@ -4095,6 +5479,22 @@ bool DivEngine::initAudioBackend() {
   if (previewVol<0.0f) previewVol=0.0f;
   if (previewVol>1.0f) previewVol=1.0f;
   renderPoolThreads=getConfInt("renderPoolThreads",0);
+  renderPoolPriority=getConfInt("renderPoolPriority",0);
+  if (renderPoolPriority<DIV_WORK_PRIORITY_NORMAL) renderPoolPriority=DIV_WORK_PRIORITY_NORMAL;
+  if (renderPoolPriority>DIV_WORK_PRIORITY_REALTIME) renderPoolPriority=DIV_WORK_PRIORITY_REALTIME;
+  renderPoolPinCores=getConfInt("renderPoolPinCores",DIV_RENDER_POOL_PIN_DEFAULT);
+  renderTickDecoupled=getConfInt("renderTickDecoupled",0);
+  skipIdleChips=getConfInt("skipIdleChips",0);
+  parallelChanTick=getConfInt("parallelChanTick",0);
+  snapshotInterval=getConfInt("seekSnapshotInterval",4);
+  if (snapshotInterval<0) snapshotInterval=0;
+  fastSeekOn=getConfInt("fastSeek",0);
+  renderAheadMs=getConfInt("renderAhead",0);
+  renderAheadRollbackOn=getConfInt("renderAheadRollback",1);
+  if (renderAheadMs<0) renderAheadMs=0;
+  if (renderAheadMs>500) renderAheadMs=500;
+  if (renderAheadMs<governorRenderAheadMs) renderAheadMs=governorRenderAheadMs;
+  governorEnabled=getConfInt("loadGovernor",0);
 
   if (lowLatency) logI("using low latency mode.");
 
@@ -4142,6 +5542,25 @@ bool DivEngine::initAudioBackend() {
 #endif
 #else
       output=new TAAudioASIO;
+#endif
+      break;
+    case DIV_AUDIO_AAUDIO:
+#ifdef HAVE_AAUDIO
+      if (TAAudioAAudio::isAvailable()) {
+        output=new TAAudioAAudio;
+        break;
+      }
+      logE("AAudio is not available on this device!");
+#else
+      logE("Furnace was not compiled with AAudio support!");
+#endif
+      setConf("audioEngine","SDL");
+      saveConf();
+#ifdef HAVE_SDL2
+      output=new TAAudioSDL;
+#else
+      logE("Furnace was not compiled with SDL support either!");
+      output=new TAAudio;
 #endif
       break;
     case DIV_AUDIO_SDL:
@@ -4172,7 +5591,8 @@ bool DivEngine::initAudioBackend() {
   want.fragments=2;
   want.inChans=0;
   want.outChans=getConfInt("audioChans",2);
-  want.outFormat=TA_AUDIO_FORMAT_F32;
+  want.auxOutSets=(audioEngine==DIV_AUDIO_JACK)?MIN(MAX(getConfInt("jackChipOutputs",0),0),DIV_MAX_CHIPS):0;
+  want.outFormat=(audioEngine==DIV_AUDIO_PIPE)?pipeFormat:TA_AUDIO_FORMAT_F32;
   want.wasapiEx=getConfInt("wasapiEx",0);
   want.name="Furnace";
 
@@ -4231,12 +5651,16 @@ bool DivEngine::initAudioBackend() {
     }
   }
 
+  startRenderAhead();
+
   logV("initAudioBackend done");
   return true;
 }
 
 bool DivEngine::deinitAudioBackend(bool dueToSwitchMaster) {
   if (output!=NULL) {
+    // the callback plays silence from now on
+    stopRenderAhead();
     logI("closing audio output.");
     output->quit();
     if (output->midiIn) {
@@ -4254,6 +5678,17 @@ bool DivEngine::deinitAudioBackend(bool dueToSwitchMaster) {
     output->quitMidi();
     delete output;
     output=NULL;
+
+    if (renderAheadBuf!=NULL) {
+      delete[] renderAheadBuf;
+      renderAheadBuf=NULL;
+    }
+    for (int i=0; i<DIV_MAX_OUTPUTS; i++) {
+      if (renderAheadTemp[i]!=NULL) {
+        delete[] renderAheadTemp[i];
+        renderAheadTemp[i]=NULL;
+      }
+    }
     if (dueToSwitchMaster) {
       audioEngine=DIV_AUDIO_NULL;
     }
@@ -4270,17 +5705,33 @@ bool DivEngine::prePreInit() {
   return loadConf();
 }
 
+// system and ROM export definitions are shared by all engines
+static std::mutex defsLock;
+static bool defsRegistered=false;
+
+void DivEngine::registerDefs() {
+  if (systemsRegistered && romExportsRegistered) return;
+  defsLock.lock();
+  if (!defsRegistered) {
+    registerSystems();
+    registerROMExports();
+    defsRegistered=true;
+  }
+  defsLock.unlock();
+  systemsRegistered=true;
+  romExportsRegistered=true;
+}
+
 bool DivEngine::preInit(bool noSafeMode) {
   bool wantSafe=false;
   if (!configLoaded) prePreInit();
 
   logI("Furnace version " DIV_VERSION ".");
 
-  // register systems
-  if (!systemsRegistered) registerSystems();
-
-  // register ROM exports
-  if (!romExportsRegistered) registerROMExports();
+  // register systems and ROM exports
+  startupPhase("register systems");
+  registerDefs();
+  startupPhase("pre-init");
 
   // TODO: re-enable with a better approach
   // see issue #1581
@@ -4326,6 +5777,25 @@ bool DivEngine::preInit(bool noSafeMode) {
   return wantSafe;
 }
 
+void DivEngine::startupPhase(const char* name) {
+  std::chrono::steady_clock::time_point now=std::chrono::steady_clock::now();
+  if (startupPhaseName!=NULL) {
+    startupProfile.push_back(std::pair<const char*,double>(startupPhaseName,std::chrono::duration_cast<std::chrono::microseconds>(now-startupPhaseBegin).count()/1000.0));
+  }
+  startupPhaseName=name;
+  startupPhaseBegin=now;
+}
+
+void DivEngine::dumpStartupProfile() {
+  double total=0.0;
+  logI("startup profile:");
+  for (std::pair<const char*,double>& i: startupProfile) {
+    logI("- %s: %.3fms",i.first,i.second);
+    total+=i.second;
+  }
+  logI("total: %.3fms",total);
+}
+
 void DivEngine::everythingOK() {
   // TODO: re-enable with a better approach
   // see issue #1581
@@ -4335,8 +5805,210 @@ void DivEngine::everythingOK() {
   */
 }
 
+bool DivEngine::initBuffers() {
+  logV("creating blip_buf");
+
+  samp_bb=blip_new(32768);
+  if (samp_bb==NULL) {
+    logE("not enough memory!");
+    return false;
+  }
+  blip_set_dc(samp_bb,0);
+
+  samp_bbOut=new short[32768];
+
+  samp_bbIn=new short[32768];
+  samp_bbInLen=32768;
+
+  metroBuf=new float[8192];
+  metroBufLen=8192;
+
+  logV("setting blip rate of samp_bb (%f)",got.rate);
+  
+  blip_set_rates(samp_bb,44100,got.rate);
+
+  for (int i=0; i<64; i++) {
+    vibTable[i]=127*sin(((double)i/64.0)*(2*M_PI));
+  }
+  for (int i=0; i<128; i++) {
+    tremTable[i]=255*0.5*(1.0-cos(((double)i/128.0)*(2*M_PI)));
+  }
+
+  for (int i=0; i<DIV_MAX_CHANS; i++) {
+    isMuted[i]=0;
+    keyHit[i]=false;
+  }
+
+  return true;
+}
+
+void DivEngine::initRenderPool() {
+  if (renderPool!=NULL) return;
+  unsigned int howManyThreads=song.systemLen;
+  if (howManyThreads<2) howManyThreads=0;
+  if (howManyThreads>renderPoolThreads) howManyThreads=renderPoolThreads;
+  renderPool=new DivWorkPool(howManyThreads,(DivWorkPriority)renderPoolPriority,renderPoolPinCores);
+}
+
+void DivEngine::reserveBuffers() {
+  // the backend may give us a bigger buffer than it asked for
+  unsigned int size=MAX(MAX(got.bufsize,(unsigned int)renderAheadBlock),DIV_RESERVE_BUFSIZE);
+  logV("reserving buffers for %d samples",size);
+
+  if (metroTickLen<size) {
+    if (metroTick!=NULL) delete[] metroTick;
+    metroTick=new unsigned char[size];
+    metroTickLen=size;
+  }
+  if (metroBufLen<size || metroBuf==NULL) {
+    if (metroBuf!=NULL) delete[] metroBuf;
+    metroBuf=new float[size];
+    metroBufLen=size;
+  }
+  if (filePlayerBufLen<size) {
+    for (int i=0; i<DIV_MAX_OUTPUTS; i++) {
+      if (filePlayerBuf[i]!=NULL) delete[] filePlayerBuf[i];
+      filePlayerBuf[i]=new float[size];
+    }
+    filePlayerBufLen=size;
+  }
+  // previews run at up to twice the output rate
+  if (samp_bbIn!=NULL && samp_bbInLen<(size_t)size*2+256) {
+    delete[] samp_bbIn;
+    samp_bbInLen=(size_t)size*2+256;
+    samp_bbIn=new short[samp_bbInLen];
+  }
+
+  for (int i=0; i<song.systemLen; i++) {
+    disCont[i].reserve(size);
+  }
+  chan.resize(song.chans);
+  for (DivEffectContainer& i: effectInst) {
+    i.reserve(size);
+  }
+  initRenderPool();
+}
+
+bool DivEngine::initRenderWorker(DivEngine* parent, unsigned char* data, size_t len) {
+  initRenderWorkerConf(parent);
+  return initRenderWorkerSong(data,len,parent->curSubSongIndex);
+}
+
+void DivEngine::initRenderWorkerConf(DivEngine* parent) {
+  // systems have been registered by the parent already
+  conf=parent->conf;
+  configLoaded=true;
+  systemsRegistered=true;
+  romExportsRegistered=true;
+  consoleMode=true;
+  disableStatusOut=true;
+  want=parent->want;
+  got=parent->got;
+  forceMono=parent->forceMono;
+  clampSamples=parent->clampSamples;
+  lowLatency=parent->lowLatency;
+  renderPoolThreads=0;
+  audioEngine=DIV_AUDIO_DUMMY;
+}
+
+bool DivEngine::initRenderWorkerSong(unsigned char* data, size_t len, int subSong) {
+  if (!load(data,len)) {
+    logE("render worker: could not load song! (%s)",lastError.c_str());
+    return false;
+  }
+  changeSong(subSong);
+
+  loadSampleROMs();
+  if (!initBuffers()) return false;
+
+  initDispatch(true);
+  renderSamples();
+  reset();
+  active=true;
+  return true;
+}
+
+bool DivEngine::initOffline(double rate, int outChans) {
+  registerDefs();
+
+  // use the defaults instead of the configuration
+  configLoaded=true;
+  consoleMode=true;
+  disableStatusOut=true;
+  renderPoolThreads=0;
+  audioEngine=DIV_AUDIO_DUMMY;
+
+  if (outChans<1) outChans=1;
+  if (outChans>DIV_MAX_OUTPUTS) outChans=DIV_MAX_OUTPUTS;
+  want.rate=rate;
+  want.outChans=outChans;
+  want.bufsize=EXPORT_BUFSIZE;
+  got=want;
+
+  if (!initBuffers()) return false;
+
+  initDispatch(true);
+  renderSamples();
+  reset();
+  active=true;
+  return true;
+}
+
+bool DivEngine::loadFromMemory(const unsigned char* data, size_t len, const char* nameHint) {
+  if (data==NULL || len<1) {
+    lastError="no data";
+    return false;
+  }
+  // load() takes ownership of its buffer
+  unsigned char* copy=new unsigned char[len];
+  memcpy(copy,data,len);
+
+  // load() re-initializes the playback cores, so do it here with the render ones
+  bool wasActive=active;
+  if (wasActive) {
+    quitDispatch();
+    active=false;
+  }
+  bool ret=load(copy,len,nameHint);
+  if (wasActive) {
+    initDispatch(true);
+    renderSamples();
+    reset();
+    active=true;
+  }
+  return ret;
+}
+
+void DivEngine::startOffline(int loops) {
+  stop();
+  repeatPattern=false;
+  curOrder=0;
+  prevOrder=0;
+  remainingLoops=MAX(loops,0)+1;
+  playSub(false);
+  freelance=false;
+}
+
+size_t DivEngine::renderOffline(float** out, size_t frames) {
+  float* chunk[DIV_MAX_OUTPUTS];
+  size_t done=0;
+  while (done<frames && playing) {
+    unsigned int size=MIN(frames-done,EXPORT_BUFSIZE);
+    for (int i=0; i<got.outChans; i++) {
+      chunk[i]=out[i]+done;
+    }
+    nextBuf(NULL,chunk,0,got.outChans,size);
+    // once the song ends, the rest of the buffer doesn't count
+    if (totalProcessed>size) totalProcessed=size;
+    done+=totalProcessed;
+  }
+  return done;
+}
+
 bool DivEngine::init() {
+  startupPhase("load sample ROMs");
   loadSampleROMs();
+  startupPhase("init");
 
   // set default system preset
   if (!hasLoadedSomething) {
@@ -4364,47 +6036,20 @@ bool DivEngine::init() {
 
   // init the rest of engine
   bool haveAudio=false;
+  startupPhase("audio backend");
   if (!initAudioBackend()) {
     logE("no audio output available!");
   } else {
     haveAudio=true;
   }
 
-  logV("creating blip_buf");
-
-  samp_bb=blip_new(32768);
-  if (samp_bb==NULL) {
-    logE("not enough memory!");
-    return false;
-  }
-  blip_set_dc(samp_bb,0);
-
-  samp_bbOut=new short[32768];
-
-  samp_bbIn=new short[32768];
-  samp_bbInLen=32768;
-
-  metroBuf=new float[8192];
-  metroBufLen=8192;
-
-  logV("setting blip rate of samp_bb (%f)",got.rate);
-  
-  blip_set_rates(samp_bb,44100,got.rate);
-
-  for (int i=0; i<64; i++) {
-    vibTable[i]=127*sin(((double)i/64.0)*(2*M_PI));
-  }
-  for (int i=0; i<128; i++) {
-    tremTable[i]=255*0.5*(1.0-cos(((double)i/128.0)*(2*M_PI)));
-  }
-
-  for (int i=0; i<DIV_MAX_CHANS; i++) {
-    isMuted[i]=0;
-    keyHit[i]=false;
-  }
+  if (!initBuffers()) return false;
 
+  startupPhase("init dispatch");
   initDispatch();
+  startupPhase("render samples");
   renderSamples();
+  startupPhase("init");
   reset();
   active=true;
 
@@ -4427,9 +6072,78 @@ bool DivEngine::init() {
   return true;
 }
 
+int DivEngine::addMasterEffect(DivEffectType type) {
+  DivEffectContainer fx;
+  if (!fx.init(type,this,got.rate,0,NULL,0)) {
+    logE("could not initialize effect %d!",(int)type);
+    fx.quit();
+    return -1;
+  }
+  fx.reserve(MAX(got.bufsize,DIV_RESERVE_BUFSIZE));
+  BUSY_BEGIN;
+  effectInst.push_back(fx);
+  BUSY_END;
+  return (int)effectInst.size()-1;
+}
+
+void DivEngine::removeMasterEffect(int index) {
+  if (index<0 || index>=(int)effectInst.size()) return;
+  BUSY_BEGIN;
+  effectInst[index].quit();
+  effectInst.erase(effectInst.begin()+index);
+  BUSY_END;
+}
+
+void DivEngine::clearMasterEffects() {
+  BUSY_BEGIN;
+  for (DivEffectContainer& i: effectInst) {
+    i.quit();
+  }
+  effectInst.clear();
+  BUSY_END;
+}
+
+bool DivEngine::setMasterEffectParam(int index, size_t param, String value) {
+  if (index<0 || index>=(int)effectInst.size()) return false;
+  BUSY_BEGIN;
+  bool ret=effectInst[index].effect->setParam(param,value);
+  BUSY_END;
+  return ret;
+}
+
+void DivEngine::setMasterEffectDryWet(int index, float dryWet) {
+  if (index<0 || index>=(int)effectInst.size()) return;
+  BUSY_BEGIN;
+  effectInst[index].dryWet=MIN(1.0f,MAX(0.0f,dryWet));
+  BUSY_END;
+}
+
+DivEffect* DivEngine::getMasterEffect(int index) {
+  if (index<0 || index>=(int)effectInst.size()) return NULL;
+  return effectInst[index].effect;
+}
+
+int DivEngine::getMasterEffectCount() {
+  return (int)effectInst.size();
+}
+
 bool DivEngine::quit(bool saveConfig) {
+  if (tsThread!=NULL) {
+    tsThread->join();
+    delete tsThread;
+    tsThread=NULL;
+    delete tsSubSong;
+    tsSubSong=NULL;
+  }
   deinitAudioBackend();
+  quitInsPreview();
+  setPlaylistMode(false);
+  freePlaylistBuffers();
   quitDispatch();
+  for (DivEffectContainer& i: effectInst) {
+    i.quit();
+  }
+  effectInst.clear();
   if (saveConfig) {
     logI("saving config.");
     saveConf();
@@ -4447,9 +6161,9 @@ bool DivEngine::quit(bool saveConfig) {
     delete curFilePlayer;
     curFilePlayer=NULL;
   }
-  if (yrw801ROM!=NULL) delete[] yrw801ROM;
-  if (tg100ROM!=NULL) delete[] tg100ROM;
-  if (mu5ROM!=NULL) delete[] mu5ROM;
+  freeSampleROM(yrw801ROM);
+  freeSampleROM(tg100ROM);
+  freeSampleROM(mu5ROM);
   song.unload();
   return true;
 }
@@ -30,14 +30,23 @@
 #include "sysDef.h"
 #include "cmdStream.h"
 #include "filePlayer.h"
+#include "waveSynth.h"
 #include "../audio/taAudio.h"
 #include "blip_buf.h"
+#include "resampler.h"
 #include <functional>
 #include <initializer_list>
 #include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <map>
+#include <deque>
 #include "../fixedQueue.h"
 
 class DivWorkPool;
+class DivTextWriter;
 
 #define addWarning(x) \
   if (warnings.empty()) { \
@@ -56,8 +65,8 @@ class DivWorkPool;
 
 #define DIV_UNSTABLE
 
-#define DIV_VERSION "dev244"
-#define DIV_ENGINE_VERSION 244
+#define DIV_VERSION "dev245"
+#define DIV_ENGINE_VERSION 245
 // for imports
 #define DIV_VERSION_MOD 0xff01
 #define DIV_VERSION_FC 0xff02
@@ -79,11 +88,26 @@ enum DivAudioEngines {
   DIV_AUDIO_PORTAUDIO=2,
   DIV_AUDIO_PIPE=3,
   DIV_AUDIO_ASIO=4,
+  DIV_AUDIO_AAUDIO=5,
 
   DIV_AUDIO_NULL=126,
   DIV_AUDIO_DUMMY=127
 };
 
+// on Android, AAudio is used by default (SDL goes through OpenSL ES, which
+// has much higher latency on most devices) and render threads are pinned to
+// the big cores.
+#ifdef HAVE_AAUDIO
+#define DIV_AUDIO_ENGINE_DEFAULT "AAudio"
+#else
+#define DIV_AUDIO_ENGINE_DEFAULT "SDL"
+#endif
+#ifdef IS_MOBILE
+#define DIV_RENDER_POOL_PIN_DEFAULT 1
+#else
+#define DIV_RENDER_POOL_PIN_DEFAULT 0
+#endif
+
 enum DivAudioExportModes {
   DIV_EXPORT_MODE_ONE=0,
   DIV_EXPORT_MODE_MANY_SYS,
@@ -124,6 +148,39 @@ enum DivAudioExportWavFormats {
   DIV_EXPORT_WAV_F32
 };
 
+// an additional file written from the same render (single file mode only)
+struct DivAudioExportTarget {
+  String path;
+  DivAudioExportFormats format;
+  DivAudioExportBitrateModes bitRateMode;
+  DivAudioExportWavFormats wavFormat;
+  int bitRate;
+  float vbrQuality;
+  DivAudioExportTarget():
+    format(DIV_EXPORT_FORMAT_WAV),
+    bitRateMode(DIV_EXPORT_BITRATE_CONSTANT),
+    wavFormat(DIV_EXPORT_WAV_S16),
+    bitRate(128000),
+    vbrQuality(6.0f) {}
+};
+
+// song information which can be read without loading the whole song.
+struct DivSongInfo {
+  int version;
+  String name, author, category, systemName;
+  std::vector<DivSystem> systems;
+  int chans;
+  int subSongs;
+  int insLen, waveLen, sampleLen;
+  DivSongInfo():
+    version(0),
+    chans(0),
+    subSongs(0),
+    insLen(0),
+    waveLen(0),
+    sampleLen(0) {}
+};
+
 struct DivAudioExportOptions {
   DivAudioExportModes mode;
   DivAudioExportFormats format;
@@ -137,6 +194,13 @@ struct DivAudioExportOptions {
   bool channelMask[DIV_MAX_CHANS];
   int bitRate;
   float vbrQuality;
+  // number of threads for per-channel export (0 means one per core)
+  int threads;
+  // files to write in addition to the main one, each with its own encoder
+  std::vector<DivAudioExportTarget> extraTargets;
+  // copy the loop instead of rendering it again once two passes in a row
+  // come out identical (single file mode only)
+  bool reuseLoops;
   DivAudioExportOptions():
     mode(DIV_EXPORT_MODE_ONE),
     format(DIV_EXPORT_FORMAT_WAV),
@@ -149,15 +213,145 @@ struct DivAudioExportOptions {
     orderBegin(-1),
     orderEnd(-1),
     bitRate(128000),
-    vbrQuality(6.0f) {
+    vbrQuality(6.0f),
+    threads(0),
+    reuseLoops(false) {
     for (int i=0; i<DIV_MAX_CHANS; i++) {
       channelMask[i]=true;
     }
   }
 };
 
+struct DivVideoExportOptions {
+  int width, height;
+  int fps;
+  // columns of the channel grid (0 means automatic)
+  int cols;
+  // visible part of each channel in milliseconds
+  float windowSize;
+  // lock the trace to the phase of the waveform
+  bool waveCorr;
+  // number of threads for drawing frames (0 means one per core)
+  int threads;
+  // 0xRRGGBB
+  unsigned int colorBack, colorTrace, colorGrid;
+  // encoder command. raw RGBA frames are written to its standard input.
+  // %w and %h are replaced with the frame size, %r with the frame rate,
+  // %a with the audio file and %o with the output file.
+  String encoder;
+  // audio is rendered to this file first (a temporary file if empty)
+  String audioPath;
+  DivAudioExportOptions audio;
+  DivVideoExportOptions():
+    width(1280),
+    height(720),
+    fps(60),
+    cols(0),
+    windowSize(20.0f),
+    waveCorr(true),
+    threads(0),
+    colorBack(0x000000),
+    colorTrace(0xffffff),
+    colorGrid(0x404040),
+    encoder("ffmpeg -y -loglevel error -f rawvideo -pix_fmt rgba -s %wx%h -r %r -i - -i %a -c:v libx264 -pix_fmt yuv420p -c:a aac -b:a 256k -shortest %o") {}
+};
+
+// hash of the output of every chip during a number of ticks
+struct DivRenderHashSegment {
+  // first tick of the segment, and the order/row at that point
+  int tick, order, row;
+  unsigned long long hash[DIV_MAX_CHIPS];
+};
+
+// result of DivEngine::renderHash()
+struct DivRenderHash {
+  int chips;
+  size_t samples;
+  int ticks;
+  // of the whole song
+  unsigned long long total[DIV_MAX_CHIPS];
+  std::vector<DivRenderHashSegment> segments;
+  DivRenderHash():
+    chips(0),
+    samples(0),
+    ticks(0) {
+    memset(total,0,DIV_MAX_CHIPS*sizeof(unsigned long long));
+  }
+};
+
+// instrument preview voices.
+// notes are rendered every DIV_INS_PREVIEW_NOTE_STEP semitones and pitched to
+// the ones in between.
+#define DIV_INS_PREVIEW_VOICES 8
+#define DIV_INS_PREVIEW_NOTE_STEP 6
+#define DIV_INS_PREVIEW_CACHE 32
+// seconds before and after the note is released
+#define DIV_INS_PREVIEW_HOLD 2.0
+#define DIV_INS_PREVIEW_RELEASE 1.0
+// seconds a voice takes to fade out when released early
+#define DIV_INS_PREVIEW_FADE 0.02
+
+// a pre-rendered note of an instrument (see DivEngine::previewInsCached())
+struct DivInsPreviewBuf {
+  int ins, note;
+  // instrument and song state it was rendered with
+  unsigned long long key;
+  // length before the note is released
+  unsigned int holdLen;
+  // number of voices playing it. it isn't freed while this isn't zero.
+  int users;
+  unsigned int lastUse;
+  std::vector<float> data[2];
+  DivInsPreviewBuf():
+    ins(-1),
+    note(0),
+    key(0),
+    holdLen(0),
+    users(0),
+    lastUse(0) {}
+};
+
+struct DivInsPreviewVoice {
+  DivInsPreviewBuf* buf;
+  int note;
+  // position in buf and increment per output sample
+  double pos, step;
+  // fades out once the note is released
+  float vol;
+  bool released;
+  DivInsPreviewVoice():
+    buf(NULL),
+    note(0),
+    pos(0.0),
+    step(1.0),
+    vol(1.0f),
+    released(false) {}
+};
+
+struct DivInsPreviewJob {
+  int ins, note;
+  unsigned long long key, songKey;
+  // copy of the instrument at the time of the request
+  DivInstrument* copy;
+  // if the song changed, a new worker and a copy of the song (from saveFur()).
+  // these are made by the thread which requested the preview.
+  DivEngine* worker;
+  unsigned char* songData;
+  size_t songLen;
+  int subSong;
+  DivInsPreviewJob(int i, int n, unsigned long long k, unsigned long long sk, DivInstrument* c):
+    ins(i),
+    note(n),
+    key(k),
+    songKey(sk),
+    copy(c),
+    worker(NULL),
+    songData(NULL),
+    songLen(0),
+    subSong(0) {}
+};
+
 struct DivChannelState {
-  std::vector<DivDelayedCommand> delayed;
   int note, oldNote, lastIns, pitch, portaSpeed, portaNote;
   int volume, volSpeed, volSpeedTarget, cut, volCut, legatoDelay, legatoTarget, rowDelay, volMax;
   int delayOrder, delayRow, retrigSpeed, retrigTick;
@@ -268,28 +462,216 @@ struct DivNoteEvent {
     fromMIDI(false) {}
 };
 
+enum DivLiveInputType {
+  DIV_LIVE_NOTE_ON=0,
+  DIV_LIVE_NOTE_OFF,
+  DIV_LIVE_AUTO_NOTE_ON,
+  DIV_LIVE_AUTO_NOTE_OFF,
+  DIV_LIVE_AUTO_NOTE_OFF_ALL,
+  DIV_LIVE_PREVIEW_SAMPLE,
+  DIV_LIVE_STOP_SAMPLE,
+  DIV_LIVE_PREVIEW_WAVE,
+  DIV_LIVE_STOP_WAVE
+};
+
+// note/preview input from the GUI, taken by the audio thread.
+struct DivLiveInput {
+  DivLiveInputType type;
+  int chan, ins, note, vol, transpose;
+  int pStart, pEnd;
+  std::atomic<bool>* failed;
+  DivLiveInput(DivLiveInputType t=DIV_LIVE_NOTE_OFF, int c=-1, int i=-1, int n=-1, int v=-1):
+    type(t),
+    chan(c),
+    ins(i),
+    note(n),
+    vol(v),
+    transpose(0),
+    pStart(-1),
+    pEnd(-1),
+    failed(NULL) {}
+};
+
+// number of deferred commands each dispatch has room for before it allocates.
+#define DIV_DEFERRED_RESERVE 1024
+
+// minimum buffer size reserveBuffers() allocates for.
+#define DIV_RESERVE_BUFSIZE 2048U
+
+// a command (or tick) queued for a dispatch during tick-decoupled rendering.
+struct DivDeferredCmd {
+  unsigned int pos;
+  bool isTick, sysTick;
+  DivCommand cmd;
+  DivDeferredCmd(unsigned int p, const DivCommand& c):
+    pos(p),
+    isTick(false),
+    sysTick(false),
+    cmd(c) {}
+  DivDeferredCmd(unsigned int p, bool sys):
+    pos(p),
+    isTick(true),
+    sysTick(sys),
+    cmd(DIV_CMD_NOTE_OFF,0) {}
+};
+
+// a MIDI input event placed within the buffer being rendered.
+struct DivMidiInEvent {
+  unsigned int pos;
+  TAMidiMessage msg;
+  DivMidiInEvent(unsigned int p, const TAMidiMessage& m):
+    pos(p),
+    msg(m) {}
+  DivMidiInEvent():
+    pos(0) {}
+};
+
+// audio load governor thresholds (load is processing time over buffer length)
+#define DIV_GOVERNOR_WINDOW 1.0
+#define DIV_GOVERNOR_OVER_LOAD 0.85
+#define DIV_GOVERNOR_PEAK_LOAD 1.0
+#define DIV_GOVERNOR_RESTORE_LOAD 0.35
+// consecutive windows over the threshold before acting
+#define DIV_GOVERNOR_OVER_WINDOWS 2
+#define DIV_GOVERNOR_RESTORE_WINDOWS 30
+#define DIV_GOVERNOR_MAX_RENDER_AHEAD 200
+
+// actions taken by the audio load governor.
+enum DivGovernorAction {
+  DIV_GOVERNOR_NONE=0,
+  // the render-ahead buffer was made deeper (processing time is spiky)
+  DIV_GOVERNOR_RENDER_AHEAD,
+  // faster emulation cores are in use (processing time is too high)
+  DIV_GOVERNOR_LIGHT_CORES,
+  // the configured cores are back in use
+  DIV_GOVERNOR_RESTORE_CORES
+};
+
+// stages of nextBuf which are timed by the profiler.
+enum DivProfileStage {
+  DIV_PROFILE_TICK=0,
+  DIV_PROFILE_MIDI,
+  DIV_PROFILE_DISPATCH,
+  DIV_PROFILE_MIX,
+  DIV_PROFILE_OSC,
+  DIV_PROFILE_TOTAL,
+
+  DIV_PROFILE_MAX
+};
+
+// stages of a dispatch's rendering which are timed by the profiler.
+enum DivDispatchProfileStage {
+  DIV_DISPATCH_PROFILE_ACQUIRE=0,
+  DIV_DISPATCH_PROFILE_RESAMPLE,
+  DIV_DISPATCH_PROFILE_POST,
+
+  DIV_DISPATCH_PROFILE_MAX
+};
+
+// number of buffers kept in the profiler history.
+#define DIV_PROFILE_HISTORY 128
+
+// get the current time in nanoseconds (for profiling).
+inline unsigned long long divProfileNow() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// audio state of a dispatch container (its buffers, but not the dispatch).
+// see DivDispatchContainer::saveState().
+struct DivDispatchContainerState {
+  blip_buffer_t* bb[DIV_MAX_OUTPUTS];
+  DivResampler* rs[DIV_MAX_OUTPUTS];
+  int temp[DIV_MAX_OUTPUTS], prevSample[DIV_MAX_OUTPUTS];
+  bool dcOffCompensation;
+  DivCommand heldCmd;
+  bool hasHeldCmd;
+  DivDispatchContainerState():
+    dcOffCompensation(false),
+    heldCmd(DIV_CMD_NOTE_OFF,0),
+    hasHeldCmd(false) {
+    memset(bb,0,DIV_MAX_OUTPUTS*sizeof(blip_buffer_t*));
+    memset(rs,0,DIV_MAX_OUTPUTS*sizeof(DivResampler*));
+    memset(temp,0,DIV_MAX_OUTPUTS*sizeof(int));
+    memset(prevSample,0,DIV_MAX_OUTPUTS*sizeof(int));
+  }
+};
+
 struct DivDispatchContainer {
   DivDispatch* dispatch;
   blip_buffer_t* bb[DIV_MAX_OUTPUTS];
+  // used instead of bb for high-rate chips if enabled
+  DivResampler* rs[DIV_MAX_OUTPUTS];
   size_t bbInLen, runtotal, runLeft, runPos, lastAvail;
+  // largest output buffer size passed to reserve()
+  size_t reservedLen;
   int temp[DIV_MAX_OUTPUTS], prevSample[DIV_MAX_OUTPUTS];
   short* bbInMapped[DIV_MAX_OUTPUTS];
   short* bbIn[DIV_MAX_OUTPUTS];
   short* bbOut[DIV_MAX_OUTPUTS];
-  bool lowQuality, dcOffCompensation, hiPass;
+  bool lowQuality, dcOffCompensation, hiPass, allowResampler;
   double rateMemory;
 
+  // per-channel outputs (see DivDispatch::hasChanOutputs()), indexed by channel*outputs+output.
+  // they go through their own blip buffers, so that they add up to bbOut.
+  std::vector<blip_buffer_t*> chanBB;
+  std::vector<short*> chanBBIn, chanBBOut;
+  std::vector<int> chanTemp, chanPrevSample;
+
   // used in multi-thread
   int cycles;
   unsigned int size;
 
+  // used in tick-decoupled rendering
+  std::vector<DivDeferredCmd> deferred;
+  size_t deferredPos;
+
+  // last command which only sets a value (e.g. volume), held back while a tick is
+  // being processed so that a repeat of it can replace it
+  DivCommand heldCmd;
+  bool hasHeldCmd;
+
+  // time spent in each stage during the current buffer (in nanoseconds)
+  unsigned long long profTime[DIV_DISPATCH_PROFILE_MAX];
+  // system name (for tracing)
+  const char* name;
+
   void setRates(double gotRate);
   void setQuality(bool lowQual, bool dcHiPass);
+  // create or destroy the resamplers depending on the chip and output rates.
+  void updateResamplers();
   void grow(size_t size);
+  // create output buffers for outputs which don't have one. returns the output count, or -1 on error.
+  int createMissingBufs();
+  // allocate everything needed to render up to outLen samples at once, so that run() doesn't have to.
+  void reserve(size_t outLen);
   void acquire(size_t count);
   void flush(size_t offset, size_t count);
   void fillBuf(size_t runtotal, size_t offset, size_t size);
+  // render `cycles` samples at runPos and advance it.
+  void run();
+  // send a command to the dispatch.
+  // if hold is true, commands which only set a value are held back, and a repeat of the
+  // same command on the same channel replaces them.
+  int sendCmd(const DivCommand& c, bool hold);
+  // send the held command, if any.
+  void flushHeldCmd();
+  // queue a command or tick to be applied at the specified buffer position.
+  // a repeated command which only sets a value replaces the previous one.
+  void defer(unsigned int pos, const DivCommand& c);
+  void deferTick(unsigned int pos, bool sysTick);
+  // render up to the specified buffer position, applying queued commands along the way.
+  void runDeferred(size_t until);
+  // render the output of each of the chanCount channels into chanBBOut as well, or stop doing so if chanCount is 0.
+  // returns false if the chip can't (see DivDispatch::hasChanOutputs()) or is resampled with DivResampler.
+  bool setChanOutputs(int chanCount);
+  // save the audio state between two buffers. the state must be freed with freeState().
+  // returns false if it can't be saved (there are per-channel outputs or queued commands).
+  bool saveState(DivDispatchContainerState& state);
+  void restoreState(const DivDispatchContainerState& state);
+  void freeState(DivDispatchContainerState& state);
   void clear();
+  // number of blip_buf deltas (in all outputs) since the last call. used by the profiler.
+  unsigned int takeDeltaCount();
   void init(DivSystem sys, DivEngine* eng, int chanCount, double gotRate, const DivConfig& flags, bool isRender=false);
   void quit();
   DivDispatchContainer():
@@ -299,35 +681,52 @@ struct DivDispatchContainer {
     runLeft(0),
     runPos(0),
     lastAvail(0),
+    reservedLen(0),
     lowQuality(false),
     dcOffCompensation(false),
     hiPass(true),
+    allowResampler(false),
     rateMemory(0.0),
     cycles(0),
-    size(0) {
+    size(0),
+    deferredPos(0),
+    heldCmd(DIV_CMD_NOTE_OFF,0),
+    hasHeldCmd(false),
+    name(NULL) {
     memset(bb,0,DIV_MAX_OUTPUTS*sizeof(blip_buffer_t*));
+    memset(rs,0,DIV_MAX_OUTPUTS*sizeof(DivResampler*));
     memset(temp,0,DIV_MAX_OUTPUTS*sizeof(int));
     memset(prevSample,0,DIV_MAX_OUTPUTS*sizeof(int));
     memset(bbIn,0,DIV_MAX_OUTPUTS*sizeof(short*));
     memset(bbInMapped,0,DIV_MAX_OUTPUTS*sizeof(short*));
     memset(bbOut,0,DIV_MAX_OUTPUTS*sizeof(short*));
+    memset(profTime,0,DIV_DISPATCH_PROFILE_MAX*sizeof(unsigned long long));
   }
 };
 
 struct DivEffectContainer {
   DivEffect* effect;
+  DivEffectType type;
   float* in[DIV_MAX_OUTPUTS];
   float* out[DIV_MAX_OUTPUTS];
   size_t inLen, outLen;
+  // the rate the effect was last told about
+  double rate;
+  float dryWet;
 
   void preAcquire(size_t count);
   void acquire(size_t count);
+  // allocate the input and output buffers, so that preAcquire() and acquire() don't have to.
+  void reserve(size_t count);
   bool init(DivEffectType effectType, DivEngine* eng, double rate, unsigned short version, const unsigned char* data, size_t len);
   void quit();
   DivEffectContainer():
     effect(NULL),
+    type(DIV_EFFECT_NULL),
     inLen(0),
-    outLen(0) {
+    outLen(0),
+    rate(0.0),
+    dryWet(1.0f) {
     memset(in,0,DIV_MAX_OUTPUTS*sizeof(float*));
     memset(out,0,DIV_MAX_OUTPUTS*sizeof(float*));
   }
@@ -335,12 +734,228 @@ struct DivEffectContainer {
 
 extern const char* cmdName[];
 
+// engine and dispatch state right after entering an order while seeking.
+// playSub() restores the nearest one instead of walking from the start.
+struct DivPlaybackSnapshot {
+  int subticks, ticks, curRow, curOrder, prevRow, prevOrder, totalLoops, lastLoopPos, nextSpeed, prevSpeed, elapsedBars, elapsedBeats, curSpeed;
+  double divider;
+  int cycles;
+  double clockDrift;
+  int midiClockCycles;
+  double midiClockDrift;
+  int midiTimeCycles;
+  double midiTimeDrift;
+  int stepPlay;
+  int changeOrd, changePos, totalTicksR, curMidiClock, curMidiTime;
+  TimeMicros totalTime;
+  double totalTimeDrift;
+  int curMidiTimePiece, curMidiTimeCode;
+  unsigned char extValue, pendingMetroTick, arpLen;
+  bool extValuePresent, endOfSong, shallStop, shallStopSched, firstTick;
+  DivGroovePattern speeds;
+  short virtualTempoN, virtualTempoD;
+  short tempoAccum;
+  std::vector<DivChannelState> chan;
+  unsigned char walked[8192];
+  int dispCount;
+  void* dispState[DIV_MAX_CHIPS];
+  DivPlaybackSnapshot():
+    dispCount(0) {
+    memset(dispState,0,DIV_MAX_CHIPS*sizeof(void*));
+  }
+};
+
+// engine state at the start of a block in the render-ahead buffer.
+// used to render the block again after an edit (see DivEngine::rollbackRenderAhead()).
+struct DivRenderAheadSnapshot {
+  // position of the block in the render-ahead buffer
+  size_t pos;
+  // value of renderAheadEpoch when this was taken
+  unsigned int epoch;
+  // includes the dispatch states
+  DivPlaybackSnapshot play;
+  bool playing, freelance;
+  int remainingLoops;
+  float metroFreq, metroPos, metroAmp;
+  DivDispatchContainerState cont[DIV_MAX_CHIPS];
+  DivRenderAheadSnapshot():
+    pos(0),
+    epoch(0),
+    playing(false),
+    freelance(false),
+    remainingLoops(-1),
+    metroFreq(0.0f),
+    metroPos(0.0f),
+    metroAmp(0.0f) {}
+};
+
+// number of attempts at reading a consistent visualization state
+#define DIV_VIZ_READ_TRIES 16
+
+/**
+ * visualization state, published by the audio thread after each buffer.
+ * readers get a consistent copy through getVizState(), without taking the engine lock.
+ */
+struct DivVizState {
+  // even sequence number of this state. it changes after each buffer.
+  unsigned int seq;
+  // position after the last sample written to oscBuf
+  int oscWritePos;
+  // size of the last buffer
+  float oscSize;
+  float chipPeak[DIV_MAX_CHIPS][DIV_MAX_OUTPUTS];
+  DivVizState():
+    seq(0),
+    oscWritePos(0),
+    oscSize(1) {
+    memset(chipPeak,0,DIV_MAX_CHIPS*DIV_MAX_OUTPUTS*sizeof(float));
+  }
+};
+
+/**
+ * copy of the register pool of a chip, published by the audio thread after each buffer.
+ * see getRegisterPoolSnapshot().
+ */
+struct DivRegPoolSnapshot {
+  std::vector<unsigned char> data;
+  // same as getRegisterPoolSize() and getRegisterPoolDepth() of the dispatch
+  int size;
+  int depth;
+  DivRegPoolSnapshot():
+    size(0),
+    depth(8) {}
+};
+
+/**
+ * error and warnings from loading an instrument file.
+ * these are kept apart from the engine's so that files may be parsed in parallel.
+ */
+struct DivInsLoadStatus {
+  String error;
+  String warnings;
+  void warn(const String& what) {
+    if (warnings.empty()) {
+      warnings+=what;
+    } else {
+      warnings+=String("\n")+what;
+    }
+  }
+};
+
+/**
+ * result of loading one file in instrumentsFromFiles().
+ */
+struct DivInstrumentImport {
+  String path;
+  std::vector<DivInstrument*> ins;
+  DivInsLoadStatus status;
+  // number of instruments dropped as duplicates
+  int duplicates;
+  DivInstrumentImport():
+    duplicates(0) {}
+};
+
+/**
+ * sample stream state of a VGM export, indexed by stream ID.
+ * shared by all chips.
+ */
+struct DivVGMStreamState {
+  double loopTimer[DIV_MAX_CHANS];
+  double loopFreq[DIV_MAX_CHANS];
+  int loopSample[DIV_MAX_CHANS];
+  bool sampleDir[DIV_MAX_CHANS];
+  int pendingFreq[DIV_MAX_CHANS];
+  int playingSample[DIV_MAX_CHANS];
+  bool sampleStoppable[DIV_MAX_CHANS];
+  int setPos[DIV_MAX_CHANS];
+  unsigned int* sampleOff8;
+  unsigned int* sampleLen8;
+  // data block of each sample (identical samples may share one)
+  unsigned short* sampleBlock;
+  bool directStream;
+  bool dpcm07;
+  int rateCorrection;
+  DivVGMStreamState():
+    sampleOff8(NULL),
+    sampleLen8(NULL),
+    sampleBlock(NULL),
+    directStream(false),
+    dpcm07(false),
+    rateCorrection(44100) {
+    for (int i=0; i<DIV_MAX_CHANS; i++) {
+      loopTimer[i]=0;
+      loopFreq[i]=0;
+      loopSample[i]=-1;
+      sampleDir[i]=false;
+      pendingFreq[i]=-1;
+      playingSample[i]=-1;
+      sampleStoppable[i]=true;
+      setPos[i]=0;
+    }
+  }
+};
+
+/**
+ * VGM write encoder of a chip.
+ * built once per export after chip slots, streams and banks are assigned.
+ */
+struct DivVGMWriteEncoder {
+  DivSystem sys;
+  bool isSecond;
+  int streamOff;
+  size_t bankOffset;
+  // command bytes and addresses which depend on the chip slot
+  unsigned char baseAddr1, baseAddr2, smsAddr, ggAddr, rf5c68Addr;
+  unsigned short baseAddr2S;
+  // NES chip in the same slot (for DPCM bank switching)
+  DivDispatch* nes;
+  DivVGMStreamState* streams;
+  void init(DivSystem s, bool second, int streamID, size_t bank, DivDispatch* nesDispatch, DivVGMStreamState* state) {
+    sys=s;
+    isSecond=second;
+    streamOff=streamID;
+    bankOffset=bank;
+    baseAddr1=isSecond?0xa0:0x50;
+    baseAddr2=isSecond?0x80:0;
+    baseAddr2S=isSecond?0x8000:0;
+    smsAddr=isSecond?0x30:0x50;
+    ggAddr=isSecond?0x3f:0x4f;
+    rf5c68Addr=isSecond?0xb1:0xb0;
+    nes=nesDispatch;
+    streams=state;
+  }
+  DivVGMWriteEncoder():
+    sys(DIV_SYSTEM_NULL),
+    isSecond(false),
+    streamOff(0),
+    bankOffset(0),
+    baseAddr1(0x50),
+    baseAddr2(0),
+    smsAddr(0x50),
+    ggAddr(0x4f),
+    rf5c68Addr(0xb0),
+    baseAddr2S(0),
+    nes(NULL),
+    streams(NULL) {}
+};
+
 class DivEngine {
   DivDispatchContainer disCont[DIV_MAX_CHIPS];
+  DivWaveSynthCache wsCache;
   TAAudio* output;
   TAAudioDesc want, got;
   String exportPath;
   std::thread* exportThread;
+  // background timestamp calculation (see calcSongTimestampsAsync()).
+  // tsSubSong is a copy of tsTarget which the thread works on.
+  std::thread* tsThread;
+  DivSubSong* tsSubSong;
+  DivSubSong* tsTarget;
+  std::atomic<bool> tsDone;
+  bool tsPending, tsStale;
+  // held while curSubSong->ts is written without isBusy.
+  // fastSeek() (audio thread) skips the checkpoints if it can't take it.
+  std::mutex tsLock;
   bool configLoaded;
   bool active;
   bool lowQuality;
@@ -369,11 +984,18 @@ class DivEngine {
   bool systemsRegistered;
   bool romExportsRegistered;
   bool hasLoadedSomething;
+  // startup profile (see startupPhase())
+  const char* startupPhaseName;
+  std::chrono::steady_clock::time_point startupPhaseBegin;
+  std::vector<std::pair<const char*,double>> startupProfile;
   bool midiOutClock;
   bool midiOutTime;
   bool midiOutProgramChange;
   int midiOutMode;
   int midiOutTimeRate;
+  // while rendering a buffer, MIDI output is timestamped relative to the time it will be heard at
+  bool midiOutTimed;
+  double midiOutBufTime;
   float midiVolExp;
   int softLockCount;
   int subticks, ticks, curRow, curOrder, prevRow, prevOrder, remainingLoops, totalLoops, lastLoopPos, exportLoopCount, curExportChan, nextSpeed, prevSpeed, elapsedBars, elapsedBeats, curSpeed;
@@ -387,7 +1009,9 @@ class DivEngine {
   int midiTimeCycles;
   double midiTimeDrift;
   int stepPlay;
-  int changeOrd, changePos, totalTicksR, curMidiClock, curMidiTime, totalCmds, lastCmds, cmdsPerSecond;
+  int changeOrd, changePos, totalTicksR, curMidiClock, curMidiTime, lastCmds, cmdsPerSecond;
+  // incremented from the render pool when ticking channels in parallel
+  std::atomic<int> totalCmds;
   TimeMicros totalTime;
   double totalTimeDrift;
   int curMidiTimePiece, curMidiTimeCode;
@@ -397,8 +1021,10 @@ class DivEngine {
   short tempoAccum;
   DivStatusView view;
   DivHaltPositions haltOn;
-  DivChannelState chan[DIV_MAX_CHANS];
+  // one per song channel. sized by reserveBuffers() and reset().
+  std::vector<DivChannelState> chan;
   DivAudioEngines audioEngine;
+  TAAudioFormat pipeFormat;
   DivAudioExportModes exportMode;
   DivAudioExportFormats exportFormat;
   DivAudioExportWavFormats wavFormat;
@@ -408,13 +1034,26 @@ class DivEngine {
   int exportOutputs;
   int exportBitRate;
   float exportVBRQuality;
+  int exportThreads;
+  std::vector<DivAudioExportTarget> exportExtraTargets;
+  bool exportReuseLoops;
   bool exportChannelMask[DIV_MAX_CHANS];
   DivConfig conf;
   FixedQueue<DivNoteEvent,8192> pendingNotes;
+  // MIDI input events of the current buffer, in order
+  FixedQueue<DivMidiInEvent,8192> midiInEvents;
+  // MIDI input handed over from the audio callback when rendering ahead
+  FixedQueue<TAMidiMessage,8192> midiInQueue;
+  std::mutex midiInLock;
+  // live input from the GUI. the lock is only held to push or pop an event,
+  // never while rendering.
+  FixedQueue<DivLiveInput,1024> liveInputQueue;
+  std::mutex liveInputLock;
   // bitfield
   unsigned char walked[8192];
   bool isMuted[DIV_MAX_CHANS];
-  std::mutex isBusy, saveLock, playPosLock;
+  std::timed_mutex isBusy;
+  std::mutex saveLock, playPosLock;
   String configPath;
   String configFile;
   String lastError;
@@ -465,6 +1104,7 @@ class DivEngine {
   int samp_temp, samp_prevSample;
   short* samp_bbIn;
   short* samp_bbOut;
+  unsigned int samp_renderLen;
 
   unsigned char* metroTick;
   size_t metroTickLen;
@@ -486,7 +1126,187 @@ class DivEngine {
   size_t totalProcessed;
 
   unsigned int renderPoolThreads;
+  // priority of render threads (DivWorkPriority)
+  int renderPoolPriority;
+  // pin render threads to performance cores
+  bool renderPoolPinCores;
   DivWorkPool* renderPool;
+  bool renderTickDecoupled;
+  // let dispatches stop emulating chips which are silent
+  bool skipIdleChips;
+  bool deferCmds;
+  // hold back repeated commands (set during nextTick())
+  bool holdCmds;
+  // run per-tick channel effects of each dispatch on the render pool
+  bool parallelChanTick;
+
+  // render-ahead mode: a thread renders audio into a ring buffer, and the
+  // audio callback only copies from it.
+  // the positions count frames since the start and only ever increase.
+  int renderAheadMs;
+  std::thread* renderAheadThread;
+  // renders samples in the background after opening a song.
+  std::thread* sampleLoadThread;
+  std::atomic<bool> samplesLoading;
+  // for each sample, the first sample with the same data, or -1. updated by renderSamples().
+  std::vector<int> sampleTwin;
+  std::mutex renderAheadLock;
+  std::condition_variable renderAheadCond;
+  std::atomic<bool> renderAheadQuit;
+  // whether the audio callback reads from the buffer
+  std::atomic<bool> renderAheadActive;
+  // set on the first audio callback. nothing is rendered before that.
+  std::atomic<bool> renderAheadRunning;
+  float* renderAheadBuf;
+  float* renderAheadTemp[DIV_MAX_OUTPUTS];
+  size_t renderAheadLen, renderAheadTarget;
+  unsigned int renderAheadBlock;
+  int renderAheadChans;
+  std::atomic<size_t> renderAheadReadPos, renderAheadWritePos;
+  std::atomic<unsigned int> renderAheadUnderruns;
+  // speculative render-ahead: the state at the start of every queued block is
+  // kept, so that an edit can replace the queued audio instead of being heard
+  // once the whole buffer has played.
+  // like seek snapshots, this needs state saves from every chip.
+  bool renderAheadRollbackOn;
+  std::atomic<bool> renderAheadRollbackPending;
+  // changed by anything the snapshots can't undo (reset, live input, sample
+  // and chip changes). snapshots from another epoch are discarded.
+  std::atomic<unsigned int> renderAheadEpoch;
+  // ordered by position
+  std::deque<DivRenderAheadSnapshot*> renderAheadSnaps;
+  unsigned int renderAheadRollbacks;
+
+  void startRenderAhead();
+  void stopRenderAhead();
+  void runRenderAhead();
+  // store the state at the start of the block at pos, if possible.
+  void captureRenderAheadSnapshot(size_t pos);
+  // go back to the earliest block which the audio callback hasn't reached yet.
+  // returns whether it did.
+  bool rollbackRenderAhead();
+  void freeRenderAheadSnapshot(DivRenderAheadSnapshot* snap);
+  void clearRenderAheadSnapshots();
+
+  // playlist mode (console): songs after the first are played by render
+  // workers, which are prepared on another thread and take over at the end
+  // of the song being heard (see queuePlaylistNext()).
+  std::atomic<bool> playlistMode;
+  int playlistLoops;
+  unsigned int playlistFadeLen, playlistFadePos;
+  // the engine being heard (this one at first)
+  std::atomic<DivEngine*> playlistCur;
+  // the previous song during a crossfade
+  DivEngine* playlistFading;
+  std::atomic<DivEngine*> playlistNext;
+  std::atomic<DivEngine*> playlistDone;
+  std::mutex playlistLock;
+  float* playlistTemp[DIV_MAX_OUTPUTS];
+  unsigned int playlistTempLen;
+  // start of the song, rendered when queued
+  float* playlistPreroll[DIV_MAX_OUTPUTS];
+  unsigned int playlistPrerollLen, playlistPrerollPos;
+  int playlistPrerollChans;
+
+  // render the song of this engine, beginning with the pre-rendered part.
+  // returns the position of a loop within out, or -1.
+  int playlistRender(float** out, int outChans, unsigned int size);
+  // render a buffer in playlist mode (instead of nextBuf()).
+  void playlistBuf(float** out, int outChans, unsigned int size);
+  void freePlaylistBuffers();
+
+  // output hashing (see renderHash()).
+  // ticks are marked as the buffer runs, and the output of each chip is
+  // hashed up to each segment boundary once the buffer is done.
+  struct HashMark {
+    unsigned int pos;
+    int tick, order, row;
+    HashMark(unsigned int p, int t, int o, int r):
+      pos(p),
+      tick(t),
+      order(o),
+      row(r) {}
+  };
+  bool hashEnabled;
+  int hashSegmentTicks, hashTicks;
+  std::vector<HashMark> hashMarks;
+  DivRenderHash* hashResult;
+  DivRenderHashSegment hashSegment;
+
+  // mark a tick at pos in the current buffer
+  void hashTick(unsigned int pos);
+  // hash the first len samples of the chip outputs
+  void hashBuffer(unsigned int len);
+
+  // instrument preview voices (see previewInsCached()).
+  // notes are rendered on another thread by a render worker, and the audio
+  // callback mixes them in without taking the engine lock.
+  std::thread* insPreviewThread;
+  // protects the cache, the jobs and the voices
+  std::mutex insPreviewLock;
+  std::condition_variable insPreviewCond;
+  bool insPreviewQuit;
+  std::vector<DivInsPreviewJob> insPreviewJobs;
+  std::vector<DivInsPreviewBuf*> insPreviewCache;
+  DivInsPreviewVoice insPreviewVoices[DIV_INS_PREVIEW_VOICES];
+  std::atomic<int> insPreviewPlaying;
+  unsigned int insPreviewUse;
+  // only used by the preview thread
+  DivEngine* insPreviewWorker;
+  unsigned long long insPreviewWorkerKey;
+  // song key of the last copy which was sent to the preview thread
+  unsigned long long insPreviewCopyKey;
+  float* insPreviewKernel;
+
+  // hash of what a preview depends on besides the instrument
+  unsigned long long getInsPreviewSongKey();
+  void runInsPreview();
+  DivInsPreviewBuf* renderInsPreview(DivInsPreviewJob& job);
+  // called by the audio callback
+  void mixInsPreview(float** out, int outChans, unsigned int size);
+  void quitInsPreview();
+
+  // seek snapshots, indexed by order.
+  // only taken if every chip supports state saves (see DivDispatch::getState()),
+  // which most don't yet.
+  std::map<int,DivPlaybackSnapshot*> snapshots;
+  // snapshots from this order onwards are stale (INT_MAX if none)
+  std::atomic<int> snapshotInvalidFrom;
+  int snapshotInterval;
+  // seek using the timestamp checkpoints instead of running the engine
+  bool fastSeekOn;
+
+  // instrument/wavetable changes are handed to the dispatches at the start
+  // of the next buffer, so editing doesn't have to wait for a render.
+  std::mutex pendingNotifyLock;
+  std::vector<int> pendingInsChange, pendingWaveChange;
+  std::vector<int> applyInsChange, applyWaveChange;
+  std::atomic<bool> pendingNotify;
+
+  void applyPendingNotify();
+  void pushLiveInput(const DivLiveInput& ev);
+  void processLiveInput();
+
+  // audio load governor.
+  // the audio thread measures load over one-second windows and requests an
+  // action, which pollGovernor() carries out on another thread.
+  bool governorEnabled;
+  // use the fastest cores instead of the configured ones (not during export)
+  std::atomic<bool> lightCores;
+  std::atomic<int> governorRequest;
+  // extra render-ahead depth set by the governor (kept until the program quits)
+  int governorRenderAheadMs;
+  // windows under the restore threshold needed to go back to the configured
+  // cores. doubled every time they are restored, to avoid switching back
+  // and forth.
+  int governorRestoreWindows;
+  // used by the audio thread only
+  double governorTime, governorBusy, governorPeak;
+  int governorOver, governorSpiky, governorUnder;
+  unsigned int governorUnderruns;
+
+  void updateGovernor(unsigned int size);
+  void setLightCores(bool light);
 
   // MIDI stuff
   std::function<int(const TAMidiMessage&)> midiCallback=[](const TAMidiMessage&) -> int {return -3;};
@@ -495,16 +1315,53 @@ class DivEngine {
   void processRow(int i, bool afterDelay);
   void nextOrder();
   void nextRow();
-  void performVGMWrite(SafeWriter* w, DivSystem sys, DivRegWrite& write, int streamOff, double* loopTimer, double* loopFreq, int* loopSample, bool* sampleDir, bool isSecond, int* pendingFreq, int* playingSample, int* setPos, unsigned int* sampleOff8, unsigned int* sampleLen8, size_t bankOffset, bool directStream, bool* sampleStoppable, bool dpcm07, DivDispatch** writeNES, int rateCorrection);
+  void performVGMWrite(SafeWriter* w, const DivVGMWriteEncoder& enc, const DivRegWrite& write);
   // returns true if end of song.
   bool nextTick(bool noAccum=false, bool inhibitLowLat=false);
+  bool nextTickInternal(bool noAccum, bool inhibitLowLat);
+  // dispatch a command whose return value is used (never deferred)
+  int dispatchCmdResult(DivCommand c);
+  int dispatchCmdInternal(DivCommand c, bool wantsResult);
+  void processChanTick(int i);
+  bool canTickInParallel();
+  void tickChansParallel();
+  // render all dispatches up to bufferPos and stop deferring commands
+  void flushDeferredCmds();
   bool perSystemEffect(int ch, unsigned char effect, unsigned char effectVal);
   bool perSystemPostEffect(int ch, unsigned char effect, unsigned char effectVal);
   bool perSystemPreEffect(int ch, unsigned char effect, unsigned char effectVal);
   void reset();
   void playSub(bool preserveDrift, int goalRow=0);
+  // copy the playback state (but not the dispatch states) into a snapshot
+  void fillSnapshot(DivPlaybackSnapshot* snap);
+  // store a seek snapshot of the current order if needed
+  void captureSnapshot();
+  // restore a seek snapshot
+  void restoreSnapshot(DivPlaybackSnapshot* snap);
+  // delete stale seek snapshots
+  void applySnapshotInvalidation();
+  // jump to the first order at or after goal using the timestamp checkpoints.
+  // only flow state, instruments and volumes are restored.
+  // returns false if not possible (the engine has to walk there instead).
+  bool fastSeek(int goal);
+  // the part of fastSeek() which runs with tsLock held.
+  bool seekToCheckpoint(int goal);
+  // delete all seek snapshots
+  void clearSnapshots();
+  // store the profiler measurements of the last buffer
+  void publishProfile(unsigned long long* stages, size_t samples);
+  // allocate or free the oscilloscope buffers of all channels
+  void setOscBuffersEnabled(bool enable);
   void runMidiClock(int totalCycles=1);
   void runMidiTime(int totalCycles=1);
+  // queue a MIDI output message. offset is relative to bufferPos.
+  bool sendMidiOut(TAMidiMessage msg, int offset=0);
+  // place the MIDI input events which arrived during the last buffer within this one
+  void collectMidiIn(unsigned int size);
+  // process MIDI input events up to the specified position in the buffer
+  void processMidiIn(unsigned int pos);
+  // render the sample/wave preview
+  void renderSamplePreview(unsigned int size);
   bool shallSwitchCores();
 
   void testFunction();
@@ -520,21 +1377,23 @@ class DivEngine {
   bool loadTFMv1(unsigned char* file, size_t len);
   bool loadTFMv2(unsigned char* file, size_t len);
 
-  void loadDMP(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath);
-  void loadTFI(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath);
-  void loadVGI(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath);
-  void loadEIF(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath);
-  void loadS3I(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath);
-  void loadSBI(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath);
-  void loadOPLI(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath);
-  void loadOPNI(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath);
-  void loadY12(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath);
-  void loadBNK(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath);
-  void loadGYB(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath);
-  void loadOPM(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath);
-  void loadFF(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath);
-  void loadWOPL(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath);
-  void loadWOPN(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath);
+  void loadDMP(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath, DivInsLoadStatus& status);
+  void loadTFI(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath, DivInsLoadStatus& status);
+  void loadVGI(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath, DivInsLoadStatus& status);
+  void loadEIF(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath, DivInsLoadStatus& status);
+  void loadS3I(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath, DivInsLoadStatus& status);
+  void loadSBI(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath, DivInsLoadStatus& status);
+  void loadOPLI(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath, DivInsLoadStatus& status);
+  void loadOPNI(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath, DivInsLoadStatus& status);
+  void loadY12(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath, DivInsLoadStatus& status);
+  void loadBNK(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath, DivInsLoadStatus& status);
+  void loadGYB(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath, DivInsLoadStatus& status);
+  void loadOPM(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath, DivInsLoadStatus& status);
+  void loadFF(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath, DivInsLoadStatus& status);
+  void loadWOPL(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath, DivInsLoadStatus& status);
+  void loadWOPN(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath, DivInsLoadStatus& status);
+  // parse an instrument file. only touches the song if song isn't NULL.
+  std::vector<DivInstrument*> instrumentFromData(unsigned char* buf, size_t len, const char* path, DivSong* song, bool readInsName, DivInsLoadStatus& status);
  
  //sample banks
   void loadP(SafeReader& reader, std::vector<DivSample*>& ret, String& stripPath);
@@ -547,13 +1406,35 @@ class DivEngine {
 
 
 
+  // sample ROMs which were mapped rather than read (pointer and length)
+  std::vector<std::pair<unsigned char*,size_t>> mappedROMs;
+
   int loadSampleROM(String path, ssize_t expectedSize, unsigned char*& ret);
+  void freeSampleROM(unsigned char*& rom);
 
   bool initAudioBackend();
   bool deinitAudioBackend(bool dueToSwitchMaster=false);
+  // allocate the buffers and tables used for playback
+  bool initBuffers();
+  // create the thread pool used by nextBuf().
+  void initRenderPool();
+  // allocate every buffer nextBuf() needs for the current audio and chip
+  // configuration, so that it never has to on the audio thread.
+  void reserveBuffers();
+  // render one channel (and the channels that belong to it) to a file.
+  // host is the engine which owns the export.
+  bool exportChanStem(int chan, DivEngine* host);
+  // render several channels to a file each in a single pass, using the per-channel outputs
+  // of their chips (see DivDispatchContainer::setChanOutputs(), which must be enabled).
+  // host is the engine which owns the export.
+  bool exportChanStemsOnePass(const std::vector<int>& chans, DivEngine* host);
+  // write the text export of the song to w.
+  void writeSongText(DivTextWriter* w, bool separatePatterns);
 
   void registerSystems();
   void registerROMExports();
+  // register the system and ROM export definitions if no engine has yet.
+  void registerDefs();
   void initSongWithDesc(const char* description, bool inBase64=true, bool oldVol=false);
 
   void exchangeIns(int one, int two);
@@ -585,6 +1466,7 @@ class DivEngine {
   friend class DivExportZSM;
   friend class DivExportiPod;
   friend class DivExportGRUB;
+  friend void _renderSamplePreview(void* e);
 
   public:
     DivSong song;
@@ -600,12 +1482,97 @@ class DivEngine {
     int lastNBIns, lastNBOuts, lastNBSize;
     std::atomic<size_t> processTime;
 
+    // number of users of the per-channel oscilloscope buffers.
+    // oscilloscope buffers are only allocated and written to while this is not zero.
+    std::atomic<int> oscConsumers;
+    bool oscEnabled;
+    // register/unregister a user of the per-channel oscilloscope buffers.
+    void addOscConsumer();
+    void removeOscConsumer();
+
+    // profiler history (in nanoseconds), written after every buffer.
+    // profHistoryPos points to the oldest entry.
+    unsigned int profHistory[DIV_PROFILE_MAX][DIV_PROFILE_HISTORY];
+    unsigned int profChipHistory[DIV_MAX_CHIPS][DIV_DISPATCH_PROFILE_MAX][DIV_PROFILE_HISTORY];
+    std::atomic<unsigned int> profHistoryPos;
+    // profiler totals (in nanoseconds) since the last call to resetProfile().
+    unsigned long long profTotal[DIV_PROFILE_MAX];
+    unsigned long long profChipTotal[DIV_MAX_CHIPS][DIV_DISPATCH_PROFILE_MAX];
+    // register writes and blip_buf deltas of each chip and output samples since the last call to resetProfile().
+    unsigned long long profChipWrites[DIV_MAX_CHIPS];
+    unsigned long long profChipDeltas[DIV_MAX_CHIPS];
+    unsigned long long profSamples;
+    unsigned long long profBuffers;
+
+    // reset the profiler totals and history.
+    void resetProfile();
+    // get the name of a profiler stage.
+    static const char* getProfileStageName(int stage);
+    // get the name of a dispatch profiler stage.
+    static const char* getDispatchProfileStageName(int stage);
+
     float chipPeak[DIV_MAX_CHIPS][DIV_MAX_OUTPUTS];
 
+    // visualization state (see getVizState()).
+    // odd while the audio thread is writing vizPub.
+    std::atomic<unsigned int> vizSeq;
+    DivVizState vizPub;
+    void publishVizState();
+
+    // register pool copies (see getRegisterPoolSnapshot()).
+    // odd while the audio thread is writing regPoolPub. 0 if nothing was published yet.
+    std::atomic<unsigned int> regPoolSeq;
+    DivRegPoolSnapshot regPoolPub[DIV_MAX_CHIPS];
+    int regPoolPubCount;
+    void reserveRegPoolSnapshots();
+    void publishRegPools();
+
     void runExportThread();
+    // set up this engine as a render worker of another, without audio output.
+    // data is a song file (e.g. from saveFur()). takes ownership of data.
+    bool initRenderWorker(DivEngine* parent, unsigned char* data, size_t len);
+    // the two halves of initRenderWorker().
+    // the first one reads the parent, so it must run on the thread which owns it.
+    void initRenderWorkerConf(DivEngine* parent);
+    bool initRenderWorkerSong(unsigned char* data, size_t len, int subSong);
     void nextBuf(float** in, float** out, int inChans, int outChans, unsigned int size);
+    // called by the audio backend. renders or copies from the render-ahead buffer.
+    void processAudio(float** in, float** out, int inChans, int outChans, unsigned int size);
+    /**
+     * enable or disable playlist mode. call after init().
+     * disabling it quits and deletes the render workers which are still queued or playing.
+     * @param loops number of times a song is played before moving to the next one.
+     * @param fadeMs length of the crossfade between songs (0 to cut right at the end).
+     */
+    void setPlaylistMode(bool enable, int loops=1, int fadeMs=0);
+    /**
+     * queue the next song in playlist mode. it starts playing once the current song ends.
+     * the start of the song is rendered on the calling thread.
+     * @param next a render worker of this engine (see initRenderWorker()) which is playing. this engine takes ownership of it.
+     * @return false if another song is still waiting.
+     */
+    bool queuePlaylistNext(DivEngine* next);
+    // whether a queued song is still waiting to be played.
+    bool isPlaylistNextQueued();
+    // get a render worker whose song is over, or NULL. the caller must quit() and delete it.
+    DivEngine* takePlaylistDone();
+    // get the engine whose song is being heard (this one if not in playlist mode).
+    DivEngine* getPlaylistCurrent();
+    // get the number of render-ahead buffer underruns since the audio output started.
+    unsigned int getRenderAheadUnderruns();
+    // carry out what the audio load governor asked for, if anything.
+    // call this regularly from a thread other than the audio one (e.g. the GUI).
+    // returns the action taken.
+    DivGovernorAction pollGovernor();
+    // whether the governor switched to faster cores.
+    bool isUsingLightCores();
+    // get a core selection or quality setting for playback.
+    // returns the fastest option if the governor asked for it.
+    int getCoreConf(String key, int fallback);
     DivInstrument* getIns(int index, DivInstrumentType fallbackType=DIV_INS_FM);
     DivWavetable* getWave(int index);
+    // get the converted wavetable cache (used by DivWaveSynth).
+    DivWaveSynthCache& getWaveSynthCache();
     DivSample* getSample(int index);
     DivDispatch* getDispatch(int index);
     // parse old system setup description
@@ -615,6 +1582,9 @@ class DivEngine {
     void createNewFromDefaults();
     // load a file.
     bool load(unsigned char* f, size_t length, const char* nameHint=NULL);
+    // read the song information of a .fur file without loading it.
+    // only as much of the file as needed is read and decompressed.
+    bool readSongInfo(const char* path, DivSongInfo& info);
 
     // play a binary command stream.
     bool playStream(unsigned char* f, size_t length);
@@ -633,6 +1603,8 @@ class DivEngine {
     void setFilePlayerCue(TimeMicros cue);
     // UNSAFE - sync file player to current playback position.
     void syncFilePlayer();
+    // tell the file player where playback may seek to (from the song's timestamps).
+    void updateFilePlayerCues();
 
     // save as .dmf.
     SafeWriter* saveDMF(unsigned char version);
@@ -641,30 +1613,47 @@ class DivEngine {
     SafeWriter* saveFur(bool notPrimary=false);
     // return a ROM exporter.
     DivROMExport* buildROM(DivROMExportOptions sys);
+    // play the current sub-song once at the given tick rate, recording the
+    // register writes of the specified chips.
+    void recordRegisterTrace(DivRegisterTrace& trace, double rate, const std::vector<int>& chips);
     // dump to VGM.
     // set trailingTicks to:
     // - 0 to add one tick of trailing
     // - x to add x+1 ticks of trailing
     // - -1 to auto-determine trailing
     // - -2 to add a whole loop of trailing
-    SafeWriter* saveVGM(bool* sysToExport=NULL, bool loop=true, int version=0x171, bool patternHints=false, bool directStream=false, int trailingTicks=-1, bool dpcm07=false, int correctedRate=44100);
+    // set packSamples to write identical samples once and to bit-pack stream
+    // sample data where possible (VGM 1.51 and later).
+    SafeWriter* saveVGM(bool* sysToExport=NULL, bool loop=true, int version=0x171, bool patternHints=false, bool directStream=false, int trailingTicks=-1, bool dpcm07=false, int correctedRate=44100, bool dedupeWrites=false, bool packSamples=false);
+    // dump several sub-songs to VGM at once.
+    // each render worker loads its own copy of the song (and renders its samples once),
+    // then exports sub-songs until there are none left.
+    // returns one VGM per sub-song, in the same order (NULL if it could not be exported).
+    // set threads to 0 to use all cores.
+    std::vector<SafeWriter*> saveVGMSubSongs(const std::vector<size_t>& subSongs, int threads=0, bool* sysToExport=NULL, bool loop=true, int version=0x171, bool patternHints=false, bool directStream=false, int trailingTicks=-1, bool dpcm07=false, int correctedRate=44100, bool dedupeWrites=false, bool packSamples=false);
     // dump to TIunA.
     SafeWriter* saveTiuna(const bool* sysToExport, const char* baseLabel, int firstBankSize, int otherBankSize);
     // dump command stream.
     SafeWriter* saveCommand(DivCSProgress* progress=NULL, DivCSOptions options=DivCSOptions());
     // export to text
     SafeWriter* saveText(bool separatePatterns=true);
+    // export to text, writing directly to a file. returns false on write error.
+    bool saveTextFile(FILE* f, bool separatePatterns=true);
     // export to an audio file
     bool saveAudio(const char* path, DivAudioExportOptions options);
     // wait for audio export to finish
     void waitAudioFile();
+    // render an oscilloscope video of every channel (blocks until done).
+    // the audio is rendered first, then the video is rendered again from the
+    // start and piped to the encoder.
+    bool saveVideo(const char* path, DivVideoExportOptions options);
     // stop audio file export
     bool haltAudioFile();
     // return back to playback cores if necessary
     void finishAudioFile();
-    // notify instrument parameter change
+    // notify instrument parameter change (applied on the next buffer)
     void notifyInsChange(int ins);
-    // notify wavetable change
+    // notify wavetable change (applied on the next buffer)
     void notifyWaveChange(int wave);
     // notify sample change
     void notifySampleChange(int sample);
@@ -682,10 +1671,22 @@ class DivEngine {
     static void convertOldFlags(unsigned int oldFlags, DivConfig& newFlags, DivSystem sys);
 
     // benchmark (returns time in seconds)
-    double benchmarkPlayback();
+    // if json is true, the render time, CPU time and profiler totals are output as a JSON object.
+    double benchmarkPlayback(bool json=false);
     double benchmarkSeek();
     double benchmarkWalk();
 
+    // run every system with each of its cores and print the results as CSV or JSON
+    void benchmarkChips(bool json=false, double seconds=5.0);
+    // file benchmarks (return average time in seconds, or -1 on error)
+    double benchmarkLoad(const char* path);
+    double benchmarkSave();
+    double benchmarkVGM();
+    double benchmarkCommand();
+    double benchmarkText();
+    // play the song as a command stream for the specified time without rendering audio, and print commands per second.
+    double benchmarkCommandPlayer(double seconds=5.0);
+
     // returns the minimum VGM version which may carry the specified system, or 0 if none.
     int minVGMVersion(DivSystem which);
 
@@ -739,8 +1740,47 @@ class DivEngine {
     int convertPanSplitToLinearLR(unsigned char left, unsigned char right, int range);
     unsigned int convertPanLinearToSplit(int val, unsigned char bits, int range);
 
-    // calculate all song timestamps
-    void calcSongTimestamps();
+    // calculate all song timestamps.
+    // if incremental is true, only recalculate from the earliest edited order.
+    void calcSongTimestamps(bool incremental=false);
+
+    // calculate all song timestamps in a background thread, on a copy of the current subsong.
+    // if a calculation is running, another one is started after it.
+    // the results are published by updateSongTimestamps().
+    void calcSongTimestampsAsync();
+
+    // publish timestamps calculated in the background, if they are ready.
+    // call this regularly from the thread which calls calcSongTimestampsAsync().
+    // returns whether timestamps were published.
+    bool updateSongTimestamps();
+
+    // whether timestamps are being calculated in the background.
+    bool isCalculatingTimestamps();
+
+    // calculate timestamps of every sub-song at once (in parallel), so that their lengths are known.
+    // sub-songs which were not edited since their last calculation are skipped.
+    // the current sub-song is left alone if it is being calculated in the background.
+    void calcAllSongTimestamps();
+
+    // mark timestamps of a sub-song as stale.
+    // call this after editing a sub-song other than the current one.
+    void invalidateSubSongTimestamps(int subSong);
+
+    // mark timestamps of orders which use a pattern as stale.
+    // call this after editing speed or jump effects, then use calcSongTimestamps(true).
+    void invalidatePatternTimestamps(int chan, int pat);
+
+    // mark seek snapshots from the specified order onwards as stale.
+    // call this after editing the song. safe to call from any thread.
+    void invalidateSnapshots(int fromOrder=0);
+
+    // invalidate seek snapshots affected by an edit to a pattern
+    void invalidatePatternSnapshots(int chan, int pat);
+
+    // re-render the queued part of the render-ahead buffer (if speculative
+    // render-ahead is enabled), so that a change is heard sooner.
+    // safe to call from any thread.
+    void requestRenderAheadRollback();
 
     // play (returns whether successful)
     bool play();
@@ -769,11 +1809,11 @@ class DivEngine {
     // set sample preview volume (1.0 = 100%)
     void setSamplePreviewVol(float vol);
 
-    // trigger sample preview
+    // trigger sample preview (on the next buffer)
     void previewSample(int sample, int note=-1, int pStart=-1, int pEnd=-1);
     void stopSamplePreview();
 
-    // trigger wave preview
+    // trigger wave preview (on the next buffer)
     void previewWave(int wave, int note);
     void stopWavePreview();
 
@@ -945,6 +1985,9 @@ class DivEngine {
     // is exporting
     bool isExporting();
 
+    // whether dispatches may skip emulation of silent chips
+    bool getSkipIdleChips();
+
     // get how many loops is left
     void getLoopsLeft(int& loops);
 
@@ -969,10 +2012,20 @@ class DivEngine {
     // add instrument from pointer
     int addInstrumentPtr(DivInstrument* which);
 
+    // add several instruments at once.
+    // returns the number of instruments afterwards, or -1 if some didn't fit (these are deleted).
+    int addInstrumentsPtr(const std::vector<DivInstrument*>& which);
+
     // get instrument from file
     // if the returned vector is empty then there was an error.
     std::vector<DivInstrument*> instrumentFromFile(const char* path, bool loadAssets=true, bool readInsName=true);
 
+    // get instruments from several files, which are parsed in parallel.
+    // Furnace instruments with assets are parsed in the calling thread.
+    // if dedupe is true, instruments identical to another one (in the batch or in
+    // the song) are dropped. names aren't compared.
+    std::vector<DivInstrumentImport> instrumentsFromFiles(const std::vector<String>& paths, bool loadAssets=true, bool readInsName=true, bool dedupe=true);
+
     // load temporary instrument
     void loadTempIns(DivInstrument* which);
 
@@ -1055,17 +2108,54 @@ class DivEngine {
     // disconnect all in patchbay
     void patchDisconnectAll(unsigned int portSet);
 
-    // play note
+    // master effects (applied in order to the first two outputs after mixing)
+    // add an effect. returns its index, or -1 on error.
+    int addMasterEffect(DivEffectType type);
+    // remove an effect
+    void removeMasterEffect(int index);
+    // remove all effects
+    void clearMasterEffects();
+    // set an effect parameter (see DivEffect::getParams()). returns false on error.
+    bool setMasterEffectParam(int index, size_t param, String value);
+    // set the dry/wet mix of an effect (0.0 to 1.0)
+    void setMasterEffectDryWet(int index, float dryWet);
+    // get an effect, or NULL if the index is out of range
+    DivEffect* getMasterEffect(int index);
+    int getMasterEffectCount();
+
+    // play note (on the next buffer)
     void noteOn(int chan, int ins, int note, int vol=-1);
 
-    // stop note
+    // stop note (on the next buffer)
     void noteOff(int chan);
 
     // returns whether it could
+    // must be called with the engine lock held.
     bool autoNoteOn(int chan, int ins, int note, int vol=-1, int transpose=0);
     void autoNoteOff(int chan, int note, int vol=-1);
+
+    // release all auto notes (on the next buffer)
     void autoNoteOffAll();
 
+    // queue an autoNoteOn/autoNoteOff for the next buffer, without taking the engine lock.
+    // baseChan is passed to setMidiBaseChan() (-1 to keep it).
+    // if failed isn't NULL, it is set to true if the note couldn't be played.
+    void queueAutoNoteOn(int baseChan, int ins, int note, int vol=-1, int transpose=0, std::atomic<bool>* failed=NULL);
+    void queueAutoNoteOff(int note);
+
+    /**
+     * play a pre-rendered note of an instrument without using the song's channels.
+     * if it hasn't been rendered yet, it is rendered in the background.
+     * @param ins the instrument.
+     * @param note the note.
+     * @param transpose added to the note (but not to the one given to stopInsPreview()).
+     * @return whether it is playing. if false, play the note with queueAutoNoteOn() instead.
+     */
+    bool previewInsCached(int ins, int note, int transpose=0);
+
+    // release a note started by previewInsCached().
+    void stopInsPreview(int note);
+
     // set whether autoNoteIn is mono or poly
     void setAutoNotePoly(bool poly);
 
@@ -1076,7 +2166,9 @@ class DivEngine {
     // go to order
     void setOrder(unsigned char order);
 
-    // update system flags
+    // update system flags.
+    // if restart is true and the song is playing, the chip's state is carried over if
+    // it supports state saves. otherwise the engine seeks to the current position.
     void updateSysFlags(int system, bool restart, bool render);
 
     // set Hz
@@ -1097,9 +2189,22 @@ class DivEngine {
     // get channel mode hints
     DivChannelModeHints getChanModeHints(int chan);
 
-    // get register pool
+    // get a consistent copy of the visualization state (oscilloscope write position and chip peaks).
+    // this never takes the engine lock. it retries if the audio thread is publishing a new state,
+    // and returns false (leaving `out` untouched) if it couldn't get a consistent copy.
+    bool getVizState(DivVizState& out);
+
+    // get register pool.
+    // this is the live pool of the dispatch, which the audio thread may be writing to.
     unsigned char* getRegisterPool(int sys, int& size, int& depth);
 
+    // get a consistent copy of the register pools of all chips, as of the end of the last buffer.
+    // like getVizState(), this never takes the engine lock. it returns false if nothing was
+    // published yet or if it couldn't get a consistent copy. if seq is not NULL, it is set to the
+    // sequence number of the copy (it changes after each buffer).
+    // the copies are reallocated when chips are initialized, so don't call this while changing chips.
+    bool getRegisterPoolSnapshot(std::vector<DivRegPoolSnapshot>& out, unsigned int* seq=NULL);
+
     // get macro interpreter
     DivMacroInt* getMacroInt(int chan);
 
@@ -1121,6 +2226,9 @@ class DivEngine {
     // set the audio system.
     void setAudio(DivAudioEngines which);
 
+    // set the sample format of the pipe audio engine.
+    void setPipeFormat(TAAudioFormat which);
+
     // set the view mode.
     void setView(DivStatusView which);
 
@@ -1175,6 +2283,17 @@ class DivEngine {
     // get the sample format mask
     unsigned int getSampleFormatMask();
 
+    // UNSAFE free sample formats which no chip in the song uses - only execute when locked
+    // returns the number of bytes freed. renderSamples() does this automatically.
+    size_t trimSamples();
+
+    // get the size of the data of all formats of all samples
+    size_t getSampleBufferSize();
+
+    // get the first sample with the same data as this one, or -1.
+    // only valid after samples are rendered (see areSamplesLoading()).
+    int getSampleTwin(int index);
+
     // UNSAFE render samples - only execute when locked
     void renderSamples(int whichSample=-1);
 
@@ -1185,6 +2304,16 @@ class DivEngine {
     // >=0: render specific sample
     void renderSamplesP(int whichSample=-1);
 
+    // render all samples in a background thread.
+    // playback may start in the meantime, but samples stay silent until done.
+    void renderSamplesBackground();
+
+    // whether samples are being rendered in the background.
+    bool areSamplesLoading();
+
+    // wait for background sample rendering to finish.
+    void waitForSamples();
+
     // public copy channel
     void copyChannelP(int src, int dest);
 
@@ -1215,6 +2344,18 @@ class DivEngine {
     void delUnusedWaves();
     void delUnusedSamples();
 
+    // merge assets which are identical to a previous one (names are ignored).
+    // references in patterns and instruments are changed to the remaining one.
+    // wavetables are not merged, as effects which refer to them can't be remapped.
+    // returns the number of assets removed.
+    int mergeDuplicateIns();
+    int mergeDuplicateSamples();
+
+    // UNSAFE find samples which are identical to a previous one (including rate and chip presence).
+    // same receives the index of the previous sample, or -1.
+    // returns the size of the data held by the duplicates.
+    size_t findDuplicateSamples(std::vector<int>& same);
+
     // change system
     bool changeSystem(int index, DivSystem which, bool preserveOrder=true);
 
@@ -1306,6 +2447,9 @@ class DivEngine {
     // send command to audio backend
     int audioBackendCommand(TAAudioCommand which);
 
+    // load a synthetic song for benchmarkChips()
+    void setUpChipBenchmark(DivSystem sys);
+
     // init dispatch
     void initDispatch(bool isRender=false);
 
@@ -1321,9 +2465,38 @@ class DivEngine {
     // initialize the engine.
     bool init();
 
+    // initialize the engine for offline rendering (library mode).
+    // the configuration is not loaded, no audio backend is opened and no threads are started.
+    // call this instead of preInit() and init(). several engines may be used at once.
+    bool initOffline(double rate=44100.0, int outChans=2);
+
+    // load a song for offline rendering. unlike load(), data is copied.
+    bool loadFromMemory(const unsigned char* data, size_t len, const char* nameHint=NULL);
+
+    // start rendering the current sub-song from the beginning.
+    // loops is the number of times the song loops before ending (0 plays it once).
+    void startOffline(int loops=0);
+
+    // render up to frames samples into out (one buffer per output channel).
+    // returns the number of frames rendered, which is lower than frames once the song has ended.
+    size_t renderOffline(float** out, size_t frames);
+
+    // render the current sub-song in memory and hash the output of every chip.
+    // segmentTicks splits the hash into segments of that many ticks (0 for the whole song only),
+    // so that the first tick where two renders differ can be found.
+    // buffers are always of the same size, so that renders may be compared.
+    bool renderHash(DivRenderHash& result, int loops=0, int segmentTicks=0);
+
     // confirm that the engine is running (delete safe mode file).
     void everythingOK();
 
+    // end the current startup phase and begin another one (NULL to stop).
+    // the time spent in each phase is kept for dumpStartupProfile().
+    void startupPhase(const char* name);
+
+    // log the time spent in each startup phase.
+    void dumpStartupProfile();
+
     // terminate the engine.
     bool quit(bool saveConfig=true);
 
@@ -1334,6 +2507,12 @@ class DivEngine {
     DivEngine():
       output(NULL),
       exportThread(NULL),
+      tsThread(NULL),
+      tsSubSong(NULL),
+      tsTarget(NULL),
+      tsDone(false),
+      tsPending(false),
+      tsStale(false),
       configLoaded(false),
       active(false),
       lowQuality(false),
@@ -1362,11 +2541,14 @@ class DivEngine {
       systemsRegistered(false),
       romExportsRegistered(false),
       hasLoadedSomething(false),
+      startupPhaseName(NULL),
       midiOutClock(false),
       midiOutTime(false),
       midiOutProgramChange(false),
       midiOutMode(DIV_MIDI_MODE_NOTE),
       midiOutTimeRate(0),
+      midiOutTimed(false),
+      midiOutBufTime(0.0),
       midiVolExp(2.0f), // General MIDI standard
       softLockCount(0),
       subticks(0),
@@ -1400,9 +2582,9 @@ class DivEngine {
       totalTicksR(0),
       curMidiClock(0),
       curMidiTime(0),
-      totalCmds(0),
       lastCmds(0),
       cmdsPerSecond(0),
+      totalCmds(0),
       totalTimeDrift(0.0),
       curMidiTimePiece(0),
       curMidiTimeCode(0),
@@ -1414,6 +2596,7 @@ class DivEngine {
       view(DIV_STATUS_NOTHING),
       haltOn(DIV_HALT_NONE),
       audioEngine(DIV_AUDIO_NULL),
+      pipeFormat(TA_AUDIO_FORMAT_S16),
       exportMode(DIV_EXPORT_MODE_ONE),
       exportFormat(DIV_EXPORT_FORMAT_WAV),
       wavFormat(DIV_EXPORT_WAV_S16),
@@ -1423,6 +2606,8 @@ class DivEngine {
       exportOutputs(2),
       exportBitRate(128000),
       exportVBRQuality(6.0f),
+      exportThreads(0),
+      exportReuseLoops(false),
       cmdStreamInt(NULL),
       midiBaseChan(0),
       midiPoly(true),
@@ -1434,6 +2619,7 @@ class DivEngine {
       samp_prevSample(0),
       samp_bbIn(NULL),
       samp_bbOut(NULL),
+      samp_renderLen(0),
       metroTick(NULL),
       metroTickLen(0),
       metroBuf(NULL),
@@ -1451,7 +2637,73 @@ class DivEngine {
       curFilePlayerTrail(0),
       totalProcessed(0),
       renderPoolThreads(0),
+      renderPoolPriority(0),
+      renderPoolPinCores(false),
       renderPool(NULL),
+      renderTickDecoupled(false),
+      skipIdleChips(false),
+      deferCmds(false),
+      holdCmds(false),
+      parallelChanTick(false),
+      renderAheadMs(0),
+      renderAheadThread(NULL),
+      sampleLoadThread(NULL),
+      samplesLoading(false),
+      renderAheadQuit(false),
+      renderAheadActive(false),
+      renderAheadRunning(false),
+      renderAheadBuf(NULL),
+      renderAheadLen(0),
+      renderAheadTarget(0),
+      renderAheadBlock(0),
+      renderAheadChans(0),
+      renderAheadReadPos(0),
+      renderAheadWritePos(0),
+      renderAheadUnderruns(0),
+      renderAheadRollbackOn(false),
+      renderAheadRollbackPending(false),
+      renderAheadEpoch(0),
+      renderAheadRollbacks(0),
+      playlistMode(false),
+      playlistLoops(1),
+      playlistFadeLen(0),
+      playlistFadePos(0),
+      playlistCur(NULL),
+      playlistFading(NULL),
+      playlistNext(NULL),
+      playlistDone(NULL),
+      playlistTempLen(0),
+      playlistPrerollLen(0),
+      playlistPrerollPos(0),
+      playlistPrerollChans(0),
+      hashEnabled(false),
+      hashSegmentTicks(0),
+      hashTicks(0),
+      hashResult(NULL),
+      insPreviewThread(NULL),
+      insPreviewQuit(false),
+      insPreviewPlaying(0),
+      insPreviewUse(0),
+      insPreviewWorker(NULL),
+      insPreviewWorkerKey(0),
+      insPreviewCopyKey(0),
+      insPreviewKernel(NULL),
+      snapshotInvalidFrom(INT_MAX),
+      snapshotInterval(4),
+      fastSeekOn(false),
+      pendingNotify(false),
+      governorEnabled(false),
+      lightCores(false),
+      governorRequest(DIV_GOVERNOR_NONE),
+      governorRenderAheadMs(0),
+      governorRestoreWindows(DIV_GOVERNOR_RESTORE_WINDOWS),
+      governorTime(0.0),
+      governorBusy(0.0),
+      governorPeak(0.0),
+      governorOver(0),
+      governorSpiky(0),
+      governorUnder(0),
+      governorUnderruns(0),
       curOrders(NULL),
       curPat(NULL),
       tempIns(NULL),
@@ -1463,6 +2715,11 @@ class DivEngine {
       lastNBOuts(0),
       lastNBSize(0),
       processTime(0),
+      oscConsumers(0),
+      oscEnabled(false),
+      profHistoryPos(0),
+      profSamples(0),
+      profBuffers(0),
       yrw801ROM(NULL),
       tg100ROM(NULL),
       mu5ROM(NULL) {
@@ -1471,18 +2728,23 @@ class DivEngine {
       memset(vibTable,0,64*sizeof(short));
       memset(tremTable,0,128*sizeof(short));
       memset(effectSlotMap,-1,4096*sizeof(short));
-      memset(sysDefs,0,DIV_MAX_CHIP_DEFS*sizeof(void*));
-      memset(romExportDefs,0,DIV_ROM_MAX*sizeof(void*));
       memset(walked,0,8192);
       memset(oscBuf,0,DIV_MAX_OUTPUTS*(sizeof(float*)));
+      memset(renderAheadTemp,0,DIV_MAX_OUTPUTS*(sizeof(float*)));
+      memset(playlistTemp,0,DIV_MAX_OUTPUTS*(sizeof(float*)));
+      memset(playlistPreroll,0,DIV_MAX_OUTPUTS*(sizeof(float*)));
       memset(exportChannelMask,1,DIV_MAX_CHANS*sizeof(bool));
       memset(chipPeak,0,DIV_MAX_CHIPS*DIV_MAX_OUTPUTS*sizeof(float));
+      vizSeq=0;
+      regPoolSeq=0;
+      regPoolPubCount=0;
       memset(filePlayerBuf,0,DIV_MAX_OUTPUTS*sizeof(float));
-
-      for (int i=0; i<DIV_MAX_CHIP_DEFS; i++) {
-        sysFileMapFur[i]=DIV_SYSTEM_NULL;
-        sysFileMapDMF[i]=DIV_SYSTEM_NULL;
-      }
+      memset(profHistory,0,sizeof(profHistory));
+      memset(profChipHistory,0,sizeof(profChipHistory));
+      memset(profTotal,0,sizeof(profTotal));
+      memset(profChipTotal,0,sizeof(profChipTotal));
+      memset(profChipWrites,0,sizeof(profChipWrites));
+      memset(profChipDeltas,0,sizeof(profChipDeltas));
 
       changeSong(0);
     }
@@ -25,6 +25,7 @@
 #include "export/zsm.h"
 #include "export/ipod.h"
 #include "export/grub.h"
+#include "export/sgu.h"
 
 DivROMExport* DivEngine::buildROM(DivROMExportOptions sys) {
   DivROMExport* exporter=NULL;
@@ -47,9 +48,89 @@ DivROMExport* DivEngine::buildROM(DivROMExportOptions sys) {
     case DIV_ROM_GRUB:
       exporter=new DivExportGRUB;
       break;
+    case DIV_ROM_SGU:
+      exporter=new DivExportSGU;
+      break;
     default:
       exporter=new DivROMExport;
       break;
   }
   return exporter;
 }
+
+void DivEngine::recordRegisterTrace(DivRegisterTrace& trace, double rate, const std::vector<int>& chips) {
+  trace.ticks.clear();
+  trace.writes.clear();
+  trace.setupWrites=0;
+  trace.stopped=false;
+
+  stop();
+  repeatPattern=false;
+  shallStop=false;
+  setOrder(0);
+
+  synchronizedSoft([&]() {
+    double origRate=got.rate;
+    got.rate=rate;
+
+    // determine loop point
+    calcSongTimestamps();
+    trace.loopOrder=curSubSong->ts.loopStart.order;
+    trace.loopRow=curSubSong->ts.loopStart.row;
+
+    // reset the playback state
+    curOrder=0;
+    freelance=false;
+    playing=false;
+    extValuePresent=false;
+    remainingLoops=-1;
+
+    for (int i: chips) {
+      disCont[i].dispatch->getRegisterWrites().clear();
+      disCont[i].dispatch->toggleRegisterDump(true);
+    }
+
+    auto collectWrites=[&]() -> size_t {
+      size_t count=0;
+      for (int i: chips) {
+        std::vector<DivRegWrite>& writes=disCont[i].dispatch->getRegisterWrites();
+        for (DivRegWrite& j: writes) {
+          trace.writes.push_back(DivRegisterTraceWrite(j.addr,j.val,i));
+        }
+        count+=writes.size();
+        writes.clear();
+      }
+      return count;
+    };
+
+    playSub(false);
+    trace.setupWrites=collectWrites();
+
+    bool done=false;
+    while (!done) {
+      DivRegisterTraceTick tick;
+      tick.order=curOrder;
+      tick.row=curRow;
+      tick.ticks=ticks;
+      tick.firstWrite=trace.writes.size();
+      if (nextTick(false,true) || !playing) {
+        trace.stopped=!playing;
+        done=true;
+      }
+      tick.cycles=cycles;
+      tick.writeCount=collectWrites();
+      trace.ticks.push_back(tick);
+      cmdStream.clear();
+    }
+
+    for (int i: chips) {
+      disCont[i].dispatch->toggleRegisterDump(false);
+    }
+    got.rate=origRate;
+
+    remainingLoops=-1;
+    playing=false;
+    freelance=false;
+    extValuePresent=false;
+  });
+}
@@ -34,6 +34,7 @@ enum DivROMExportOptions {
   DIV_ROM_SAP_R,
   DIV_ROM_IPOD,
   DIV_ROM_GRUB,
+  DIV_ROM_SGU,
 
   DIV_ROM_MAX
 };
@@ -55,11 +56,58 @@ struct DivROMExportProgress {
   float amount;
 };
 
+struct DivRegisterTraceWrite {
+  unsigned int addr, val;
+  int chip;
+
+  DivRegisterTraceWrite(unsigned int a, unsigned int v, int c):
+    addr(a),
+    val(v),
+    chip(c) {}
+};
+
+struct DivRegisterTraceTick {
+  // playback position before this tick
+  int order, row, ticks;
+  // samples (at the trace rate) until the next tick
+  int cycles;
+  size_t firstWrite, writeCount;
+};
+
+/**
+ * a register trace of the current sub-song, recorded by
+ * DivEngine::recordRegisterTrace().
+ * the last tick is the one on which the song ended or looped. its writes are
+ * only a lookahead.
+ */
+struct DivRegisterTrace {
+  std::vector<DivRegisterTraceTick> ticks;
+  std::vector<DivRegisterTraceWrite> writes;
+  // writes issued by playSub() before the first tick
+  size_t setupWrites;
+  int loopOrder, loopRow;
+  // whether the song ended instead of looping
+  bool stopped;
+
+  DivRegisterTrace():
+    setupWrites(0),
+    loopOrder(0),
+    loopRow(0),
+    stopped(false) {}
+};
+
 class DivROMExport {
   protected:
     DivConfig conf;
     std::vector<DivROMExportOutput> output;
+    SafeWriter* songCopy;
     void logAppend(String what);
+    // copy the song for a worker engine. call from go().
+    void copySong(DivEngine* eng);
+    // create a worker engine from the copy, so the export does not block
+    // playback. call from run(). returns eng if the copy is not available.
+    DivEngine* startWorker(DivEngine* eng);
+    void stopWorker(DivEngine* eng, DivEngine* worker);
   public:
     std::vector<String> exportLog;
     std::mutex logLock;
@@ -72,7 +120,9 @@ class DivROMExport {
     virtual bool hasFailed();
     virtual bool isRunning();
     virtual DivROMExportProgress getProgress(int index=0);
-    virtual ~DivROMExport() {}
+    DivROMExport():
+      songCopy(NULL) {}
+    virtual ~DivROMExport();
 };
 
 #define logAppendf(...) logAppend(fmt::sprintf(__VA_ARGS__))
@@ -18,6 +18,7 @@
  */
 
 #include "../export.h"
+#include "../engine.h"
 #include "../../ta-log.h"
 
 bool DivROMExport::go(DivEngine* eng) {
@@ -25,6 +26,51 @@ bool DivROMExport::go(DivEngine* eng) {
   return false;
 }
 
+void DivROMExport::copySong(DivEngine* eng) {
+  if (songCopy!=NULL) {
+    songCopy->finish();
+    delete songCopy;
+  }
+  songCopy=eng->saveFur(true);
+  if (songCopy==NULL) {
+    logW("could not copy song for export! exporting on the playback engine.");
+  }
+}
+
+DivEngine* DivROMExport::startWorker(DivEngine* eng) {
+  if (songCopy==NULL) return eng;
+
+  // the worker takes ownership of the data
+  size_t len=songCopy->size();
+  unsigned char* data=new unsigned char[len];
+  memcpy(data,songCopy->getFinalBuf(),len);
+  songCopy->finish();
+  delete songCopy;
+  songCopy=NULL;
+
+  DivEngine* worker=new DivEngine;
+  if (!worker->initRenderWorker(eng,data,len)) {
+    logW("could not start export worker! exporting on the playback engine.");
+    worker->quit(false);
+    delete worker;
+    return eng;
+  }
+  return worker;
+}
+
+void DivROMExport::stopWorker(DivEngine* eng, DivEngine* worker) {
+  if (worker==eng) return;
+  worker->quit(false);
+  delete worker;
+}
+
+DivROMExport::~DivROMExport() {
+  if (songCopy!=NULL) {
+    songCopy->finish();
+    delete songCopy;
+  }
+}
+
 void DivROMExport::abort() {
 }
 
@@ -25,6 +25,11 @@
 #include <vector>
 
 void DivExportGRUB::run() {
+  // this export reads the register pool, so it walks the song itself
+  // instead of using a register trace.
+  DivEngine* parent=e;
+  e=startWorker(parent);
+
   bool grubExportBin=conf.getBool("exportBin",false);
 
   int BEEPER=-1;
@@ -49,6 +54,8 @@ void DivExportGRUB::run() {
   }
   if (BEEPER<0) {
     logAppendf("ERROR: Could not find PC Speaker/Beeper");
+    stopWorker(parent,e);
+    e=parent;
     failed=true;
     running=false;
     return;
@@ -156,6 +163,8 @@ void DivExportGRUB::run() {
     output.push_back(DivROMExportOutput(grubExportBin?"export.bin":"export.txt",w));
   });
 
+  stopWorker(parent,e);
+  e=parent;
 
   progress[0].amount=1.0f;
   
@@ -172,6 +181,7 @@ bool DivExportGRUB::go(DivEngine* eng) {
   running=true;
   failed=false;
   mustAbort=false;
+  copySong(e);
   exportThread=new std::thread(&DivExportGRUB::run,this);
   return true;
 }
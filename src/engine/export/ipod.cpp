@@ -27,6 +27,11 @@
 #include <vector>
 
 void DivExportiPod::run() {
+  // this export reads the register pool, so it walks the song itself
+  // instead of using a register trace.
+  DivEngine* parent=e;
+  e=startWorker(parent);
+
   int BEEPER=-1;
   int IGNORED=0;
 
@@ -49,6 +54,8 @@ void DivExportiPod::run() {
   }
   if (BEEPER<0) {
     logAppendf("ERROR: Could not find PC Speaker/Beeper");
+    stopWorker(parent,e);
+    e=parent;
     failed=true;
     running=false;
     return;
@@ -146,6 +153,8 @@ void DivExportiPod::run() {
     output.push_back(DivROMExportOutput("export.tone",w));
   });
 
+  stopWorker(parent,e);
+  e=parent;
 
   progress[0].amount=1.0f;
   
@@ -162,6 +171,7 @@ bool DivExportiPod::go(DivEngine* eng) {
   running=true;
   failed=false;
   mustAbort=false;
+  copySong(e);
   exportThread=new std::thread(&DivExportiPod::run,this);
   return true;
 }
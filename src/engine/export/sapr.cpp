@@ -38,6 +38,9 @@ static String ticksToTime(double rate, int ticks) {
 }
 
 void DivExportSAPR::run() {
+  DivEngine* parent=e;
+  e=startWorker(parent);
+
   int sapScanlines=0; // TODO: property!
   int POKEY=-1;
   int IGNORED=0;
@@ -61,6 +64,8 @@ void DivExportSAPR::run() {
   }
   if (POKEY<0) {
     logAppendf("ERROR: Could not find POKEY");
+    stopWorker(parent,e);
+    e=parent;
     failed=true;
     running=false;
     return;
@@ -81,76 +86,36 @@ void DivExportSAPR::run() {
   double sapRate = (palTiming?50:60) * (double)scanlinesPerFrame / (double)sapScanlines;
 
 
-  e->stop();
-  e->repeatPattern=false;
-  e->setOrder(0);
-
   logAppend("playing and logging register writes...");
 
-  e->synchronizedSoft([&]() {
-    double origRate = e->got.rate;
-    e->got.rate=sapRate;
-
-    // Determine loop point.
-    e->calcSongTimestamps();
-    int loopOrder=e->curSubSong->ts.loopStart.order;
-    int loopRow=e->curSubSong->ts.loopStart.row;
-    logAppendf("loop point: %d %d",loopOrder,loopRow);
-    e->warnings="";
-
-    // Reset the playback state.
-    e->curOrder=0;
-    e->freelance=false;
-    e->playing=false;
-    e->extValuePresent=false;
-    e->remainingLoops=-1;
-
-    // Prepare to write song data.
-    e->playSub(false);
-    bool done=false;
-    e->disCont[POKEY].dispatch->toggleRegisterDump(true);
-    std::array<uint8_t, 9> currRegs;
-
-    while (!done) {
-      if (e->nextTick(false,true) || !e->playing) {
-        done=true;
-        for (int i=0; i<e->song.systemLen; i++) {
-          e->disCont[i].dispatch->getRegisterWrites().clear();
-        }
-        break;
-      }
-      // get register dumps
-      std::vector<DivRegWrite>& writes=e->disCont[POKEY].dispatch->getRegisterWrites();
-      if (writes.size() > 0) {
-        logAppendf("saprOps: found %d messages",writes.size());
-        for (DivRegWrite& write: writes)
-          if ((write.addr & 0xF) < 9)
-            currRegs[write.addr & 0xF] = write.val;
-        writes.clear();
+  DivRegisterTrace trace;
+  e->recordRegisterTrace(trace,sapRate,{POKEY});
+  logAppendf("loop point: %d %d",trace.loopOrder,trace.loopRow);
+
+  std::array<uint8_t, 9> currRegs;
+  // the last tick is only a lookahead
+  for (size_t i=0; i+1<trace.ticks.size(); i++) {
+    DivRegisterTraceTick& tick=trace.ticks[i];
+    // get register dumps
+    if (tick.writeCount>0) {
+      logAppendf("saprOps: found %d messages",tick.writeCount);
+      for (size_t j=tick.firstWrite; j<tick.firstWrite+tick.writeCount; j++) {
+        DivRegisterTraceWrite& write=trace.writes[j];
+        if ((write.addr & 0xF) < 9)
+          currRegs[write.addr & 0xF] = write.val;
       }
+    }
 
-      // write wait
+    // write wait
+    tickCount++;
+    int totalWait=tick.cycles;
+    while (totalWait>0) {
+      regs.push_back(currRegs);
+      totalWait--;
       tickCount++;
-      int totalWait=e->cycles;
-      if (totalWait>0 && !done) {
-        while (totalWait) {
-          regs.push_back(currRegs);
-          totalWait--;
-          tickCount++;
-        }
-      }
     }
-    // end of song
-
-    // done - close out.
-    e->got.rate=origRate;
-    e->disCont[POKEY].dispatch->toggleRegisterDump(false);
-
-    e->remainingLoops=-1;
-    e->playing=false;
-    e->freelance=false;
-    e->extValuePresent=false;
-  });
+  }
+  // end of song
 
   logAppend("writing data...");
   progress[0].amount=0.95f;
@@ -175,6 +140,9 @@ void DivExportSAPR::run() {
 
   output.push_back(DivROMExportOutput("export.sap",w));
 
+  stopWorker(parent,e);
+  e=parent;
+
   progress[0].amount=1.0f;
   
   logAppend("finished!");
@@ -190,6 +158,7 @@ bool DivExportSAPR::go(DivEngine* eng) {
   running=true;
   failed=false;
   mustAbort=false;
+  copySong(e);
   exportThread=new std::thread(&DivExportSAPR::run,this);
   return true;
 }
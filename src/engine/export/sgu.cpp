@@ -0,0 +1,350 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2026 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// SGU-1 register stream (.sgs) for X65 hardware playback.
+//
+// header (little endian):
+// - 0x00: "SGUS"
+// - 0x04: version (1)
+// - 0x05: channel count
+// - 0x06: frame rate in Hz (short)
+// - 0x08: loop offset, relative to the start of the stream (-1 if no loop)
+// - 0x0c: length of one pass in frames
+// - 0x10: PCM RAM length
+// - 0x14: stream offset
+// - 0x18: PCM RAM contents, to be loaded at address 0
+//
+// stream commands:
+// - 00-3F xx: write xx to register (cmd) of the selected channel
+// - 40-4F:    select channel (cmd&15)
+// - 80-FE:    end of frame, then wait (cmd&0x7f)+1 frames in total
+// - FF:       end of stream. jump to the loop offset if there is one
+//
+// the player has to reset the chip before playing.
+// writes that would not change a register are left out, except for registers
+// which the chip modifies by itself (frequency, volume, cutoff, PCM position
+// and one-shot flags). the selected channel is forgotten at the loop point.
+
+#include "sgu.h"
+#include "../engine.h"
+#include "../ta-log.h"
+#include "../platform/sound/sgu.h"
+#include <fmt/printf.h>
+
+#define SGU_STREAM_REGS (SGU_REGS_PER_CH*SGU_CHNS)
+
+static bool isVolatileReg(int reg) {
+  if (reg<SGU_OP_PER_CH*SGU_OP_REGS) return false;
+  switch (reg-SGU_OP_PER_CH*SGU_OP_REGS) {
+    case SGU1_CHN_FREQ_L:
+    case SGU1_CHN_FREQ_H:
+    case SGU1_CHN_VOL:
+    case SGU1_CHN_FLAGS1:
+    case SGU1_CHN_CUTOFF_L:
+    case SGU1_CHN_CUTOFF_H:
+    case SGU1_CHN_PCM_POS_L:
+    case SGU1_CHN_PCM_POS_H:
+      return true;
+  }
+  return false;
+}
+
+static bool isKeyReg(int reg) {
+  return reg==SGU_OP_PER_CH*SGU_OP_REGS+SGU1_CHN_FLAGS0;
+}
+
+struct SGUStreamWrite {
+  unsigned short addr;
+  unsigned char val;
+  SGUStreamWrite(unsigned short a, unsigned char v):
+    addr(a),
+    val(v) {}
+};
+
+// frame statistics for the playback routine cost report
+struct SGUStreamStats {
+  // write count histogram buckets: 0, 1-3, 4-7, 8-15, 16-31, 32-63, 64+
+  size_t histogram[7];
+  size_t frames, totalWrites, totalBusWrites, totalBytes;
+  size_t maxWrites, maxBusWrites, maxBytes, maxFrame;
+
+  void addFrame(size_t writes, size_t busWrites, size_t bytes) {
+    int bucket=0;
+    if (writes>0) {
+      bucket=1;
+      for (size_t i=4; i<=writes && bucket<6; i<<=1) bucket++;
+    }
+    histogram[bucket]++;
+    totalWrites+=writes;
+    totalBusWrites+=busWrites;
+    totalBytes+=bytes;
+    if (busWrites>maxBusWrites) {
+      maxBusWrites=busWrites;
+      maxFrame=frames;
+    }
+    if (writes>maxWrites) maxWrites=writes;
+    if (bytes>maxBytes) maxBytes=bytes;
+    frames++;
+  }
+
+  SGUStreamStats():
+    frames(0),
+    totalWrites(0),
+    totalBusWrites(0),
+    totalBytes(0),
+    maxWrites(0),
+    maxBusWrites(0),
+    maxBytes(0),
+    maxFrame(0) {
+    memset(histogram,0,sizeof(histogram));
+  }
+};
+
+void DivExportSGU::run() {
+  DivEngine* parent=e;
+  e=startWorker(parent);
+
+  int rate=conf.getInt("rate",60);
+  bool loop=conf.getBool("loop",true);
+  if (rate<1) rate=1;
+  if (rate>65535) rate=65535;
+
+  int sguIdx=-1;
+  for (int i=0; i<e->song.systemLen; i++) {
+    if (e->song.system[i]==DIV_SYSTEM_SGU && sguIdx<0) {
+      sguIdx=i;
+      logAppendf("SGU-1 detected as chip id %d",i);
+    } else {
+      logAppendf("ignoring chip %d systemID %d",i,(int)e->song.system[i]);
+    }
+  }
+  if (sguIdx<0) {
+    logAppend("ERROR: could not find SGU-1");
+    stopWorker(parent,e);
+    e=parent;
+    failed=true;
+    running=false;
+    return;
+  }
+
+  logAppend("playing and logging register writes...");
+
+  DivRegisterTrace trace;
+  e->recordRegisterTrace(trace,rate,{sguIdx});
+  logAppendf("loop point: %d %d",trace.loopOrder,trace.loopRow);
+  progress[0].amount=0.5f;
+
+  SafeWriter* w=new SafeWriter;
+  w->init();
+
+  // header
+  const unsigned char* pcm=(const unsigned char*)e->getDispatch(sguIdx)->getSampleMem(0);
+  size_t pcmLen=e->getDispatch(sguIdx)->getSampleMemUsage(0);
+  if (pcm==NULL) pcmLen=0;
+  w->write("SGUS",4);
+  w->writeC(1);
+  w->writeC(SGU_CHNS);
+  w->writeS(rate);
+  w->writeI(-1);
+  w->writeI(0);
+  w->writeI(pcmLen);
+  w->writeI(0x18+pcmLen);
+  if (pcmLen>0) w->write(pcm,pcmLen);
+  size_t streamStart=w->tell();
+
+  short shadow[SGU_STREAM_REGS];
+  memset(shadow,-1,sizeof(shadow));
+  std::vector<SGUStreamWrite> frame;
+  std::vector<SGUStreamWrite> chanWrites[SGU_CHNS];
+  bool lastWrite[SGU_STREAM_REGS];
+  SGUStreamStats stats;
+  int curChan=-1;
+  int waitFrames=0;
+  int loopPos=-1;
+  bool loopNow=false;
+  size_t frameWrites=0, frameBusWrites=0, frameStart=w->tell();
+
+  auto flushWait=[&]() {
+    while (waitFrames>0) {
+      int n=MIN(waitFrames,127);
+      w->writeC(0x80|(n-1));
+      stats.addFrame(frameWrites,frameBusWrites,w->tell()-frameStart);
+      for (int i=1; i<n; i++) {
+        stats.addFrame(0,0,0);
+      }
+      frameWrites=0;
+      frameBusWrites=0;
+      frameStart=w->tell();
+      waitFrames-=n;
+    }
+  };
+
+  for (size_t t=0; t<trace.ticks.size(); t++) {
+    DivRegisterTraceTick& tick=trace.ticks[t];
+    // the last tick is a lookahead
+    if (t+1==trace.ticks.size()) break;
+
+    if (loopPos==-1 && loop && !trace.stopped) {
+      if (trace.loopOrder==tick.order && trace.loopRow==tick.row)
+        loopNow=true;
+      if (loopNow) {
+        // with virtual tempo the exact loop point may be skipped.
+        // in that case the following tick is the loop point.
+        if (tick.ticks==1 || !(trace.loopOrder==tick.order && trace.loopRow==tick.row)) {
+          flushWait();
+          loopPos=w->tell()-streamStart;
+          memset(shadow,-1,sizeof(shadow));
+          curChan=-1;
+          loopNow=false;
+        }
+      }
+    }
+
+    // gather this tick's writes (plus the setup writes on the first tick)
+    frame.clear();
+    if (t==0) {
+      for (size_t j=0; j<trace.setupWrites; j++) {
+        DivRegisterTraceWrite& write=trace.writes[j];
+        frame.push_back(SGUStreamWrite(write.addr,write.val));
+      }
+    }
+    for (size_t j=tick.firstWrite; j<tick.firstWrite+tick.writeCount; j++) {
+      DivRegisterTraceWrite& write=trace.writes[j];
+      frame.push_back(SGUStreamWrite(write.addr,write.val));
+    }
+
+    // only the last write to a register in a frame matters, except for the
+    // key register (every write to it may start or stop a note)
+    memset(lastWrite,0,sizeof(lastWrite));
+    for (int i=0; i<SGU_CHNS; i++) {
+      chanWrites[i].clear();
+    }
+    for (size_t i=frame.size(); i>0; i--) {
+      SGUStreamWrite& write=frame[i-1];
+      if (write.addr>=SGU_STREAM_REGS) {
+        logW("SGU stream: write to unknown register %x",write.addr);
+        continue;
+      }
+      int reg=write.addr%SGU_REGS_PER_CH;
+      if (lastWrite[write.addr] && !isKeyReg(reg)) continue;
+      lastWrite[write.addr]=true;
+      chanWrites[write.addr/SGU_REGS_PER_CH].push_back(write);
+    }
+
+    // emit, grouped by channel
+    for (int i=0; i<SGU_CHNS; i++) {
+      for (size_t j=chanWrites[i].size(); j>0; j--) {
+        SGUStreamWrite& write=chanWrites[i][j-1];
+        int reg=write.addr%SGU_REGS_PER_CH;
+        if (shadow[write.addr]==write.val && !isVolatileReg(reg)) continue;
+        shadow[write.addr]=write.val;
+
+        flushWait();
+        if (curChan!=i) {
+          w->writeC(0x40|i);
+          curChan=i;
+          frameBusWrites++;
+        }
+        w->writeC(reg);
+        w->writeC(write.val);
+        frameWrites++;
+        frameBusWrites++;
+      }
+    }
+
+    waitFrames+=tick.cycles;
+  }
+  if (waitFrames<1) waitFrames=1;
+  flushWait();
+  w->writeC(0xff);
+
+  // fill in the header
+  w->seek(8,SEEK_SET);
+  w->writeI(loopPos);
+  w->writeI(stats.frames);
+  w->seek(0,SEEK_END);
+
+  logAppendf("stream size: %d bytes (%d frames, PCM: %d bytes)",(int)(w->size()-streamStart),(int)stats.frames,(int)pcmLen);
+  if (loopPos>=0) {
+    logAppendf("loop offset: %d",loopPos);
+  }
+
+  // playback routine cost report
+  if (stats.frames>0) {
+    logAppendf("register writes per frame: max %d, avg %.2f",(int)stats.maxWrites,(double)stats.totalWrites/(double)stats.frames);
+    logAppendf("bus writes per frame (incl. channel selects): max %d (frame %d), avg %.2f",(int)stats.maxBusWrites,(int)stats.maxFrame,(double)stats.totalBusWrites/(double)stats.frames);
+    logAppendf("stream bytes per frame: max %d, avg %.2f",(int)stats.maxBytes,(double)stats.totalBytes/(double)stats.frames);
+    logAppendf("bus bandwidth: max %d writes/s, avg %.1f writes/s",(int)(stats.maxBusWrites*rate),(double)stats.totalBusWrites*rate/(double)stats.frames);
+    const char* bucketNames[7]={"0","1-3","4-7","8-15","16-31","32-63","64+"};
+    logAppend("writes per frame histogram:");
+    for (int i=0; i<7; i++) {
+      logAppendf("- %5s: %d",bucketNames[i],(int)stats.histogram[i]);
+    }
+  }
+
+  output.push_back(DivROMExportOutput("export.sgs",w));
+
+  stopWorker(parent,e);
+  e=parent;
+
+  progress[0].amount=1.0f;
+
+  logAppend("finished!");
+
+  running=false;
+}
+
+bool DivExportSGU::go(DivEngine* eng) {
+  progress[0].name="Progress";
+  progress[0].amount=0.0f;
+
+  e=eng;
+  running=true;
+  failed=false;
+  mustAbort=false;
+  copySong(e);
+  exportThread=new std::thread(&DivExportSGU::run,this);
+  return true;
+}
+
+void DivExportSGU::wait() {
+  if (exportThread!=NULL) {
+    logV("waiting for export thread...");
+    exportThread->join();
+    delete exportThread;
+  }
+}
+
+void DivExportSGU::abort() {
+  mustAbort=true;
+  wait();
+}
+
+bool DivExportSGU::isRunning() {
+  return running;
+}
+
+bool DivExportSGU::hasFailed() {
+  return failed;
+}
+
+DivROMExportProgress DivExportSGU::getProgress(int index) {
+  if (index<0 || index>1) return progress[1];
+  return progress[index];
+}
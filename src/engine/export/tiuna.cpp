@@ -181,8 +181,10 @@ static void writeCmd(std::vector<TiunaBytes>& cmds, TiunaCmd& cmd, unsigned char
 }
 
 void DivExportTiuna::run() {
+  DivEngine* parent=e;
+  e=startWorker(parent);
+
   int loopOrder, loopOrderRow;
-  int tick=0;
   SafeWriter* w;
   std::map<int,TiunaCmd> allCmds[2];
 
@@ -192,145 +194,120 @@ void DivExportTiuna::run() {
   int otherBankSize=conf.getInt("otherBankSize",4096-48);
   int tiaIdx=conf.getInt("sysToExport",-1);
 
-  e->stop();
-  e->repeatPattern=false;
-  e->shallStop=false;
-  e->setOrder(0);
-  e->synchronizedSoft([&]() {
-    // determine loop point
-    // bool stopped=false;
-    e->calcSongTimestamps();
-    loopOrder=e->curSubSong->ts.loopStart.order;
-    loopOrderRow=e->curSubSong->ts.loopStart.row;
-    logAppendf("loop point: %d %d",loopOrder,loopOrderRow);
-
-    w=new SafeWriter;
-    w->init();
-
-    if (tiaIdx<0 || tiaIdx>=e->song.systemLen) {
-      tiaIdx=-1;
-      for (int i=0; i<e->song.systemLen; i++) {
-        if (e->song.system[i]==DIV_SYSTEM_TIA) {
-          tiaIdx=i;
-          break;
-        }
-      }
-      if (tiaIdx<0) {
-        logAppend("ERROR: selected TIA system not found");
-        failed=true;
-        running=false;
-        return;
+  if (tiaIdx<0 || tiaIdx>=e->song.systemLen) {
+    tiaIdx=-1;
+    for (int i=0; i<e->song.systemLen; i++) {
+      if (e->song.system[i]==DIV_SYSTEM_TIA) {
+        tiaIdx=i;
+        break;
       }
-    } else if (e->song.system[tiaIdx]!=DIV_SYSTEM_TIA) {
-      logAppend("ERROR: selected chip is not a TIA!");
+    }
+    if (tiaIdx<0) {
+      logAppend("ERROR: selected TIA system not found");
+      stopWorker(parent,e);
+      e=parent;
       failed=true;
       running=false;
       return;
     }
+  } else if (e->song.system[tiaIdx]!=DIV_SYSTEM_TIA) {
+    logAppend("ERROR: selected chip is not a TIA!");
+    stopWorker(parent,e);
+    e=parent;
+    failed=true;
+    running=false;
+    return;
+  }
 
-    e->disCont[tiaIdx].dispatch->toggleRegisterDump(true);
+  // write patterns
+  // bool writeLoop=false;
+  logAppend("recording sequence...");
+  DivRegisterTrace trace;
+  e->recordRegisterTrace(trace,e->got.rate,{tiaIdx});
+  loopOrder=trace.loopOrder;
+  loopOrderRow=trace.loopRow;
+  logAppendf("loop point: %d %d",loopOrder,loopOrderRow);
 
-    // write patterns
-    // bool writeLoop=false;
-    logAppend("recording sequence...");
-    bool done=false;
-    e->playSub(false);
-    
-    // int loopTick=-1;
-    TiunaLast last[2];
-    TiunaNew news[2];
-    while (!done) {
-      // TODO implement loop
-      // if (loopTick<0 && loopOrder==curOrder && loopOrderRow==curRow
-      //   && (ticks-((tempoAccum+virtualTempoN)/virtualTempoD))<=0
-      // ) {
-      //   writeLoop=true;
-      //   loopTick=tick;
-      //   // invalidate last register state so it always force an absolute write after loop
-      //   for (int i=0; i<2; i++) {
-      //     last[i]=TiunaLast();
-      //     last[i].pitch=-1;
-      //     last[i].ins=-1;
-      //     last[i].vol=-1;
-      //   }
-      // }
-      if (e->nextTick(false,true) || !e->playing) {
-        // stopped=!playing;
-        done=true;
-        break;
-      }
-      for (int i=0; i<2; i++) {
-        news[i]=TiunaNew();
+  w=new SafeWriter;
+  w->init();
+
+  // int loopTick=-1;
+  TiunaLast last[2];
+  TiunaNew news[2];
+  // the last tick is only a lookahead. setup writes go with the first tick.
+  for (int t=0; t+1<(int)trace.ticks.size(); t++) {
+    DivRegisterTraceTick& tick=trace.ticks[t];
+    // TODO implement loop
+    // if (loopTick<0 && loopOrder==tick.order && loopOrderRow==tick.row
+    //   && tick.ticks<=1
+    // ) {
+    //   writeLoop=true;
+    //   loopTick=t;
+    //   // invalidate last register state so it always force an absolute write after loop
+    //   for (int i=0; i<2; i++) {
+    //     last[i]=TiunaLast();
+    //     last[i].pitch=-1;
+    //     last[i].ins=-1;
+    //     last[i].vol=-1;
+    //   }
+    // }
+    for (int i=0; i<2; i++) {
+      news[i]=TiunaNew();
+    }
+    // get register dumps
+    for (size_t j=(t==0)?0:tick.firstWrite; j<tick.firstWrite+tick.writeCount; j++) {
+      DivRegisterTraceWrite& i=trace.writes[j];
+      switch (i.addr) {
+        case 0xfffe0000:
+        case 0xfffe0001:
+          news[i.addr&1].pitch=i.val;
+          break;
+        case 0xfffe0002:
+          news[0].sync=i.val;
+          break;
+        case 0x15:
+        case 0x16:
+          news[i.addr-0x15].ins=i.val;
+          break;
+        case 0x19:
+        case 0x1a:
+          news[i.addr-0x19].vol=i.val;
+          break;
+        default: break;
       }
-      // get register dumps
-      std::vector<DivRegWrite>& writes=e->disCont[tiaIdx].dispatch->getRegisterWrites();
-      for (const DivRegWrite& i: writes) {
-        switch (i.addr) {
-          case 0xfffe0000:
-          case 0xfffe0001:
-            news[i.addr&1].pitch=i.val;
-            break;
-          case 0xfffe0002:
-            news[0].sync=i.val;
-            break;
-          case 0x15:
-          case 0x16:
-            news[i.addr-0x15].ins=i.val;
-            break;
-          case 0x19:
-          case 0x1a:
-            news[i.addr-0x19].vol=i.val;
-            break;
-          default: break;
+    }
+    // collect changes
+    for (int i=0; i<2; i++) {
+      TiunaCmd cmds;
+      bool hasCmd=false;
+      if (news[i].pitch>=0 && (last[i].forcePitch || news[i].pitch!=last[i].pitch)) {
+        int dt=news[i].pitch-last[i].pitch;
+        if (!last[i].forcePitch && abs(dt)<=16) {
+          if (dt<0) cmds.pitchChange=15-dt;
+          else cmds.pitchChange=dt-1;
         }
+        else cmds.pitchSet=news[i].pitch;
+        last[i].pitch=news[i].pitch;
+        last[i].forcePitch=false;
+        hasCmd=true;
       }
-      writes.clear();
-      // collect changes
-      for (int i=0; i<2; i++) {
-        TiunaCmd cmds;
-        bool hasCmd=false;
-        if (news[i].pitch>=0 && (last[i].forcePitch || news[i].pitch!=last[i].pitch)) {
-          int dt=news[i].pitch-last[i].pitch;
-          if (!last[i].forcePitch && abs(dt)<=16) {
-            if (dt<0) cmds.pitchChange=15-dt;
-            else cmds.pitchChange=dt-1;
-          }
-          else cmds.pitchSet=news[i].pitch;
-          last[i].pitch=news[i].pitch;
-          last[i].forcePitch=false;
-          hasCmd=true;
-        }
-        if (news[i].ins>=0 && news[i].ins!=last[i].ins) {
-          cmds.ins=news[i].ins;
-          last[i].ins=news[i].ins;
-          hasCmd=true;
-        }
-        if (news[i].vol>=0 && news[i].vol!=last[i].vol) {
-          cmds.vol=(news[i].vol-last[i].vol)&0xf;
-          last[i].vol=news[i].vol;
-          hasCmd=true;
-        }
-        if (news[i].sync>=0) {
-          cmds.sync=news[i].sync;
-          hasCmd=true;
-        }
-        if (hasCmd) allCmds[i][tick]=cmds;
+      if (news[i].ins>=0 && news[i].ins!=last[i].ins) {
+        cmds.ins=news[i].ins;
+        last[i].ins=news[i].ins;
+        hasCmd=true;
       }
-      e->cmdStream.clear();
-      tick++;
-    }
-    for (int i=0; i<e->song.systemLen; i++) {
-      e->disCont[i].dispatch->getRegisterWrites().clear();
-      e->disCont[i].dispatch->toggleRegisterDump(false);
+      if (news[i].vol>=0 && news[i].vol!=last[i].vol) {
+        cmds.vol=(news[i].vol-last[i].vol)&0xf;
+        last[i].vol=news[i].vol;
+        hasCmd=true;
+      }
+      if (news[i].sync>=0) {
+        cmds.sync=news[i].sync;
+        hasCmd=true;
+      }
+      if (hasCmd) allCmds[i][t]=cmds;
     }
-
-    e->remainingLoops=-1;
-    e->playing=false;
-    e->freelance=false;
-    e->extValuePresent=false;
-  });
-
-  if (failed) return;
+  }
 
   // render commands
   logAppend("rendering commands...");
@@ -343,6 +320,8 @@ void DivExportTiuna::run() {
     "; Subsong #{}: {}\n\n",
     e->song.name,e->song.author,e->song.category,e->curSubSongIndex+1,e->curSubSong->name
   ));
+  stopWorker(parent,e);
+  e=parent;
   for (int i=0; i<2; i++) {
     TiunaCmd lastCmd;
     int lastTick=0;
@@ -359,7 +338,7 @@ void DivExportTiuna::run() {
       lastTick=kv.first;
       lastCmd=kv.second;
     }
-    writeCmd(renderedCmds,lastCmd,i,lastWait,lastTick,tick);
+    writeCmd(renderedCmds,lastCmd,i,lastWait,lastTick,(int)trace.ticks.size()-1);
     // if (stopped || loopTick<0) w->writeText(".loop\n    db 0\n");
   }
   // compress commands
@@ -626,6 +605,7 @@ bool DivExportTiuna::go(DivEngine* eng) {
   running=true;
   failed=false;
   mustAbort=false;
+  copySong(e);
   exportThread=new std::thread(&DivExportTiuna::run,this);
   return true;
 }
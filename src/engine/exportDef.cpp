@@ -73,6 +73,8 @@ bool DivEngine::isROMExportViable(DivROMExportOptions opt)
 void DivEngine::registerROMExports() {
   logD("registering ROM exports...");
 
+  memset(romExportDefs,0,DIV_ROM_MAX*sizeof(void*));
+
   romExportDefs[DIV_ROM_AMIGA_VALIDATION]=new DivROMExportDef(
     "Amiga Validation", "tildearrow",
     "a test export for ensuring Amiga emulation is accurate. do not use!",
@@ -142,4 +144,15 @@ void DivEngine::registerROMExports() {
     },
     false, DIV_REQPOL_ANY
   );
+
+  romExportDefs[DIV_ROM_SGU]=new DivROMExportDef(
+    "X65 SGU-1 register stream", "Furnace",
+    "compact per-frame register stream for SGU-1 playback on X65 hardware.\n"
+    "the export log reports the per-frame write cost of the song.",
+    "SGU stream files", ".sgs",
+    {
+      DIV_SYSTEM_SGU
+    },
+    false, DIV_REQPOL_ANY
+  );
 }
@@ -29,7 +29,7 @@ bool DivEngine::load(unsigned char* f, size_t slen, const char* nameHint) {
     return false;
   }
 
-  if (!systemsRegistered) registerSystems();
+  registerDefs();
 
   // step 0: get extension of file
   String extS;
@@ -71,11 +71,26 @@ bool DivEngine::load(unsigned char* f, size_t slen, const char* nameHint) {
       throw NotZlibException(0);
     }
 
-    std::vector<InflateBlock*> blocks;
+    // decompress directly into a single buffer, growing it if necessary.
+    // this avoids holding the data twice (once in blocks and once contiguous).
+    size_t bufCap=slen*DIV_INFLATE_RATIO;
+    if (bufCap<DIV_READ_SIZE) bufCap=DIV_READ_SIZE;
+    unsigned char* buf=new unsigned char[bufCap];
+    size_t finalSize=0;
     while (true) {
-      InflateBlock* ib=new InflateBlock(DIV_READ_SIZE);
-      zl.next_out=ib->buf;
-      zl.avail_out=ib->len;
+      if (finalSize>=bufCap) {
+        size_t newCap=bufCap<<1;
+        unsigned char* newBuf=new unsigned char[newCap];
+        memcpy(newBuf,buf,finalSize);
+        delete[] buf;
+        buf=newBuf;
+        bufCap=newCap;
+      }
+      // avail_out is only 32-bit
+      size_t avail=bufCap-finalSize;
+      if (avail>0x40000000) avail=0x40000000;
+      zl.next_out=&buf[finalSize];
+      zl.avail_out=avail;
 
       nextErr=inflate(&zl,Z_SYNC_FLUSH);
       if (nextErr!=Z_OK && nextErr!=Z_STREAM_END) {
@@ -86,14 +101,11 @@ bool DivEngine::load(unsigned char* f, size_t slen, const char* nameHint) {
           logD("zlib inflate: %s",zl.msg);
           lastError=fmt::sprintf("decompression error: %s",zl.msg);
         }
-        for (InflateBlock* i: blocks) delete i;
-        blocks.clear();
-        delete ib;
+        delete[] buf;
         inflateEnd(&zl);
         throw NotZlibException(0);
       }
-      ib->blockSize=ib->len-zl.avail_out;
-      blocks.push_back(ib);
+      finalSize=zl.next_out-buf;
       if (nextErr==Z_STREAM_END) {
         break;
       }
@@ -107,30 +119,17 @@ bool DivEngine::load(unsigned char* f, size_t slen, const char* nameHint) {
         logD("zlib end: %s",zl.msg);
         lastError=fmt::sprintf("decompression finish error: %s",zl.msg);
       }
-      for (InflateBlock* i: blocks) delete i;
-      blocks.clear();
+      delete[] buf;
       throw NotZlibException(0);
     }
 
-    size_t finalSize=0;
-    size_t curSeek=0;
-    for (InflateBlock* i: blocks) {
-      finalSize+=i->blockSize;
-    }
     if (finalSize<1) {
       logD("compressed too small!");
       lastError="file too small";
-      for (InflateBlock* i: blocks) delete i;
-      blocks.clear();
+      delete[] buf;
       throw NotZlibException(0);
     }
-    file=new unsigned char[finalSize];
-    for (InflateBlock* i: blocks) {
-      memcpy(&file[curSeek],i->buf,i->blockSize);
-      curSeek+=i->blockSize;
-      delete i;
-    }
-    blocks.clear();
+    file=buf;
     len=finalSize;
     delete[] f;
   } catch (NotZlibException& e) {
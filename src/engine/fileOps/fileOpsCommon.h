@@ -24,21 +24,9 @@
 #include <fmt/printf.h>
 
 #define DIV_READ_SIZE 131072
-
-struct InflateBlock {
-  unsigned char* buf;
-  size_t len;
-  size_t blockSize;
-  InflateBlock(size_t s) {
-    buf=new unsigned char[s];
-    len=s;
-    blockSize=0;
-  }
-  ~InflateBlock() {
-    delete[] buf;
-    len=0;
-  }
-};
+// initial size of the decompression buffer relative to the compressed size.
+// pages which are never written to don't take up memory, so this may be generous.
+#define DIV_INFLATE_RATIO 4
 
 struct NotZlibException {
   int what;
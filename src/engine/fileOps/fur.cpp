@@ -18,6 +18,9 @@
  */
 
 #include "fileOpsCommon.h"
+#include "../workPool.h"
+#include <thread>
+#include <unordered_set>
 
 short newFormatNotes[180]={
   12, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, // -5
@@ -63,6 +66,337 @@ struct PatToWrite {
     pat(p) {}
 };
 
+enum FurAssetType {
+  FUR_ASSET_INS=0,
+  FUR_ASSET_WAVE,
+  FUR_ASSET_SAMPLE,
+  FUR_ASSET_PAT
+};
+
+// write assets in parallel if there are at least this many
+#define FUR_MIN_PARALLEL_ASSETS 64
+
+// split the asset list in this many chunks per thread (for balancing)
+#define FUR_CHUNKS_PER_THREAD 4
+
+struct FurAssetJob {
+  FurAssetType type;
+  size_t index;
+  // position of the block in its chunk
+  size_t offset;
+  FurAssetJob(FurAssetType t, size_t i):
+    type(t),
+    index(i),
+    offset(0) {}
+};
+
+struct FurAssetChunk {
+  DivSong* song;
+  std::vector<FurAssetJob>* jobs;
+  std::vector<PatToWrite>* pats;
+  size_t first, last;
+  SafeWriter* w;
+  bool deltaSamples;
+  FurAssetChunk():
+    song(NULL),
+    jobs(NULL),
+    pats(NULL),
+    first(0),
+    last(0),
+    w(NULL),
+    deltaSamples(false) {}
+};
+
+enum FurReadResult {
+  FUR_READ_OK=0,
+  FUR_READ_SEEK_ERROR,
+  FUR_READ_DATA_ERROR,
+  FUR_READ_EOF
+};
+
+struct FurAssetRead {
+  FurAssetType type;
+  int index;
+  unsigned int ptr;
+  void* target;
+  DivEngine* engine;
+  short version;
+  // patterns only
+  bool isNewFormat;
+  int chan, patLen, effectCols;
+  size_t endPos;
+  FurReadResult result;
+  FurAssetRead(FurAssetType t, int i, unsigned int p, void* tg, DivEngine* e, short v):
+    type(t),
+    index(i),
+    ptr(p),
+    target(tg),
+    engine(e),
+    version(v),
+    isNewFormat(false),
+    chan(0),
+    patLen(0),
+    effectCols(0),
+    endPos(0),
+    result(FUR_READ_OK) {}
+};
+
+struct FurAssetReadChunk {
+  const unsigned char* file;
+  size_t len;
+  std::vector<FurAssetRead>* jobs;
+  size_t first, last;
+  FurAssetReadChunk():
+    file(NULL),
+    len(0),
+    jobs(NULL),
+    first(0),
+    last(0) {}
+};
+
+static void readPatternData(SafeReader& reader, FurAssetRead& job) {
+  DivPattern* pat=(DivPattern*)job.target;
+  if (job.isNewFormat) {
+    pat->name=reader.readString();
+
+    // read new pattern
+    for (int j=0; j<job.patLen; j++) {
+      unsigned char mask=reader.readC();
+      unsigned short effectMask=0;
+
+      if (mask==0xff) break;
+      if (mask&128) {
+        j+=(mask&127)+1;
+        continue;
+      }
+
+      if (mask&32) {
+        effectMask|=(unsigned char)reader.readC();
+      }
+      if (mask&64) {
+        effectMask|=((unsigned short)reader.readC()&0xff)<<8;
+      }
+      if (mask&8) effectMask|=1;
+      if (mask&16) effectMask|=2;
+
+      if (mask&1) { // note
+        unsigned char note=reader.readC();
+        // TODO: PAT2 format with new off/===/rel values!
+        if (note==180) {
+          pat->newData[j][0]=DIV_NOTE_OFF;
+        } else if (note==181) {
+          pat->newData[j][0]=DIV_NOTE_REL;
+        } else if (note==182) {
+          pat->newData[j][0]=DIV_MACRO_REL;
+        } else if (note<180) {
+          pat->newData[j][DIV_PAT_NOTE]=note;
+        } else {
+          pat->newData[j][0]=-1;
+        }
+      }
+      if (mask&2) { // instrument
+        pat->newData[j][DIV_PAT_INS]=(unsigned char)reader.readC();
+      }
+      if (mask&4) { // volume
+        pat->newData[j][DIV_PAT_VOL]=(unsigned char)reader.readC();
+      }
+      for (unsigned char k=0; k<16; k++) {
+        if (effectMask&(1<<k)) {
+          pat->newData[j][DIV_PAT_FX(0)+k]=(unsigned char)reader.readC();
+        }
+      }
+    }
+  } else {
+    for (int j=0; j<job.patLen; j++) {
+      short note=reader.readS();
+      short octave=reader.readS();
+      if (note==0 && octave!=0) {
+        logD("what? %d:%x:%d note %d octave %d",job.chan,job.ptr,j,note,octave);
+        note=12;
+        octave--;
+      }
+      pat->newData[j][DIV_PAT_NOTE]=job.engine->splitNoteToNote(note,octave);
+
+      pat->newData[j][DIV_PAT_INS]=reader.readS();
+      pat->newData[j][DIV_PAT_VOL]=reader.readS();
+      for (int k=0; k<job.effectCols; k++) {
+        pat->newData[j][DIV_PAT_FX(k)]=reader.readS();
+        pat->newData[j][DIV_PAT_FXVAL(k)]=reader.readS();
+      }
+    }
+
+    if (job.version>=51) {
+      pat->name=reader.readString();
+    }
+  }
+}
+
+// decode a range of asset blocks, each using its own reader.
+static void _readAssetChunk(void* arg) {
+  FurAssetReadChunk* c=(FurAssetReadChunk*)arg;
+  for (size_t i=c->first; i<c->last; i++) {
+    FurAssetRead& job=(*c->jobs)[i];
+    SafeReader reader=SafeReader(c->file,c->len);
+    try {
+      if (!reader.seek(job.ptr,SEEK_SET)) {
+        job.result=FUR_READ_SEEK_ERROR;
+        continue;
+      }
+      DivDataErrors ret=DIV_DATA_SUCCESS;
+      switch (job.type) {
+        case FUR_ASSET_INS:
+          logD("reading instrument %d at %x...",job.index,job.ptr);
+          ret=((DivInstrument*)job.target)->readInsData(reader,job.version);
+          break;
+        case FUR_ASSET_WAVE:
+          logD("reading wavetable %d at %x...",job.index,job.ptr);
+          ret=((DivWavetable*)job.target)->readWaveData(reader,job.version);
+          break;
+        case FUR_ASSET_SAMPLE:
+          ret=((DivSample*)job.target)->readSampleData(reader,job.version);
+          break;
+        case FUR_ASSET_PAT:
+          readPatternData(reader,job);
+          break;
+      }
+      if (ret!=DIV_DATA_SUCCESS) job.result=FUR_READ_DATA_ERROR;
+      job.endPos=reader.tell();
+    } catch (EndOfFileException& e) {
+      job.result=FUR_READ_EOF;
+    }
+  }
+}
+
+static void putPatternData(SafeWriter* w, DivSong& song, const PatToWrite& i) {
+  size_t blockStartSeek, blockEndSeek;
+  DivPattern* pat=song.subsong[i.subsong]->pat[i.chan].getPattern(i.pat,false);
+
+  w->write("PATN",4);
+  blockStartSeek=w->tell();
+  w->writeI(0);
+
+  w->writeC(i.subsong);
+  w->writeC(i.chan);
+  w->writeS(i.pat);
+  w->writeString(pat->name,false);
+
+  unsigned char emptyRows=0;
+
+  for (int j=0; j<song.subsong[i.subsong]->patLen; j++) {
+    unsigned char mask=0;
+    unsigned char finalNote=255;
+    unsigned short effectMask=0;
+
+    if (pat->newData[j][DIV_PAT_NOTE]==DIV_NOTE_OFF) { // note off
+      finalNote=180;
+    } else if (pat->newData[j][DIV_PAT_NOTE]==DIV_NOTE_REL) { // note release
+      finalNote=181;
+    } else if (pat->newData[j][DIV_PAT_NOTE]==DIV_MACRO_REL) { // macro release
+      finalNote=182;
+    } else if (pat->newData[j][DIV_PAT_NOTE]==-1) { // empty
+      finalNote=255;
+    } else {
+      finalNote=pat->newData[j][DIV_PAT_NOTE];
+    }
+
+    if (finalNote!=255) mask|=1; // note
+    if (pat->newData[j][DIV_PAT_INS]!=-1) mask|=2; // instrument
+    if (pat->newData[j][DIV_PAT_VOL]!=-1) mask|=4; // volume
+    for (int k=0; k<song.subsong[i.subsong]->pat[i.chan].effectCols*2; k+=2) {
+      if (k==0) {
+        if (pat->newData[j][DIV_PAT_FX(0)+k]!=-1) mask|=8;
+        if (pat->newData[j][DIV_PAT_FXVAL(0)+k]!=-1) mask|=16;
+      } else if (k<8) {
+        if (pat->newData[j][DIV_PAT_FX(0)+k]!=-1 || pat->newData[j][DIV_PAT_FXVAL(0)+k]!=-1) mask|=32;
+      } else {
+        if (pat->newData[j][DIV_PAT_FX(0)+k]!=-1 || pat->newData[j][DIV_PAT_FXVAL(0)+k]!=-1) mask|=64;
+      }
+
+      if (pat->newData[j][DIV_PAT_FX(0)+k]!=-1) effectMask|=(1<<k);
+      if (pat->newData[j][DIV_PAT_FXVAL(0)+k]!=-1) effectMask|=(2<<k);
+    }
+
+    if (mask==0) {
+      emptyRows++;
+      if (emptyRows>127) {
+        w->writeC(128|(emptyRows-2));
+        emptyRows=0;
+      }
+    } else {
+      if (emptyRows>1) {
+        w->writeC(128|(emptyRows-2));
+        emptyRows=0;
+      } else if (emptyRows) {
+        w->writeC(0);
+        emptyRows=0;
+      }
+
+      w->writeC(mask);
+
+      if (mask&32) w->writeC(effectMask&0xff);
+      if (mask&64) w->writeC((effectMask>>8)&0xff);
+
+      if (mask&1) w->writeC(finalNote);
+      if (mask&2) w->writeC(pat->newData[j][DIV_PAT_INS]);
+      if (mask&4) w->writeC(pat->newData[j][DIV_PAT_VOL]);
+      if (mask&8) w->writeC(pat->newData[j][DIV_PAT_FX(0)]);
+      if (mask&16) w->writeC(pat->newData[j][DIV_PAT_FXVAL(0)]);
+      if (mask&32) {
+        if (effectMask&4) w->writeC(pat->newData[j][DIV_PAT_FX(1)]);
+        if (effectMask&8) w->writeC(pat->newData[j][DIV_PAT_FXVAL(1)]);
+        if (effectMask&16) w->writeC(pat->newData[j][DIV_PAT_FX(2)]);
+        if (effectMask&32) w->writeC(pat->newData[j][DIV_PAT_FXVAL(2)]);
+        if (effectMask&64) w->writeC(pat->newData[j][DIV_PAT_FX(3)]);
+        if (effectMask&128) w->writeC(pat->newData[j][DIV_PAT_FXVAL(3)]);
+      }
+      if (mask&64) {
+        if (effectMask&256) w->writeC(pat->newData[j][DIV_PAT_FX(4)]);
+        if (effectMask&512) w->writeC(pat->newData[j][DIV_PAT_FXVAL(4)]);
+        if (effectMask&1024) w->writeC(pat->newData[j][DIV_PAT_FX(5)]);
+        if (effectMask&2048) w->writeC(pat->newData[j][DIV_PAT_FXVAL(5)]);
+        if (effectMask&4096) w->writeC(pat->newData[j][DIV_PAT_FX(6)]);
+        if (effectMask&8192) w->writeC(pat->newData[j][DIV_PAT_FXVAL(6)]);
+        if (effectMask&16384) w->writeC(pat->newData[j][DIV_PAT_FX(7)]);
+        if (effectMask&32768) w->writeC(pat->newData[j][DIV_PAT_FXVAL(7)]);
+      }
+    }
+  }
+
+  // stop
+  w->writeC(0xff);
+
+  blockEndSeek=w->tell();
+  w->seek(blockStartSeek,SEEK_SET);
+  w->writeI(blockEndSeek-blockStartSeek-4);
+  w->seek(0,SEEK_END);
+}
+
+// write a range of asset blocks to a new writer.
+static void _putAssetChunk(void* arg) {
+  FurAssetChunk* c=(FurAssetChunk*)arg;
+  DivSong& song=*c->song;
+  c->w=new SafeWriter;
+  c->w->init();
+  for (size_t i=c->first; i<c->last; i++) {
+    FurAssetJob& job=(*c->jobs)[i];
+    job.offset=c->w->tell();
+    switch (job.type) {
+      case FUR_ASSET_INS:
+        song.ins[job.index]->putInsData2(c->w,false);
+        break;
+      case FUR_ASSET_WAVE:
+        song.wave[job.index]->putWaveData(c->w);
+        break;
+      case FUR_ASSET_SAMPLE:
+        song.sample[job.index]->putSampleData(c->w,c->deltaSamples);
+        break;
+      case FUR_ASSET_PAT:
+        putPatternData(c->w,song,(*c->pats)[job.index]);
+        break;
+    }
+  }
+}
+
 void DivEngine::convertOldFlags(unsigned int oldFlags, DivConfig& newFlags, DivSystem sys) {
   newFlags.clear();
 
@@ -1853,82 +2187,33 @@ bool DivEngine::loadFur(unsigned char* file, size_t len, int variantID) {
       }
     }
 
-    // read instruments
+    // read instruments, wavetables, samples and patterns.
+    // these blocks are independent of each other, so they are decoded in parallel
+    // (each with its own reader). errors are reported in file order afterwards.
+    std::vector<FurAssetRead> assetReads;
+    assetReads.reserve(ds.insLen+ds.waveLen+ds.sampleLen+patPtr.size());
     ds.ins.reserve(ds.insLen);
     for (int i=0; i<ds.insLen; i++) {
       DivInstrument* ins=new DivInstrument;
-      logD("reading instrument %d at %x...",i,insPtr[i]);
-      if (!reader.seek(insPtr[i],SEEK_SET)) {
-        logE("couldn't seek to instrument %d!",i);
-        lastError=fmt::sprintf("couldn't seek to instrument %d!",i);
-        ds.unload();
-        delete ins;
-        delete[] file;
-        return false;
-      }
-      
-      if (ins->readInsData(reader,ds.version)!=DIV_DATA_SUCCESS) {
-        lastError="invalid instrument header/data!";
-        ds.unload();
-        delete ins;
-        delete[] file;
-        return false;
-      }
-
       ds.ins.push_back(ins);
+      assetReads.push_back(FurAssetRead(FUR_ASSET_INS,i,insPtr[i],ins,this,ds.version));
     }
-
-    // read wavetables
     ds.wave.reserve(ds.waveLen);
     for (int i=0; i<ds.waveLen; i++) {
       DivWavetable* wave=new DivWavetable;
-      logD("reading wavetable %d at %x...",i,wavePtr[i]);
-      if (!reader.seek(wavePtr[i],SEEK_SET)) {
-        logE("couldn't seek to wavetable %d!",i);
-        lastError=fmt::sprintf("couldn't seek to wavetable %d!",i);
-        ds.unload();
-        delete wave;
-        delete[] file;
-        return false;
-      }
-
-      if (wave->readWaveData(reader,ds.version)!=DIV_DATA_SUCCESS) {
-        lastError="invalid wavetable header/data!";
-        ds.unload();
-        delete wave;
-        delete[] file;
-        return false;
-      }
-
       ds.wave.push_back(wave);
+      assetReads.push_back(FurAssetRead(FUR_ASSET_WAVE,i,wavePtr[i],wave,this,ds.version));
     }
-
-    // read samples
     ds.sample.reserve(ds.sampleLen);
     for (int i=0; i<ds.sampleLen; i++) {
       DivSample* sample=new DivSample;
-
-      if (!reader.seek(samplePtr[i],SEEK_SET)) {
-        logE("couldn't seek to sample %d!",i);
-        lastError=fmt::sprintf("couldn't seek to sample %d!",i);
-        ds.unload();
-        delete sample;
-        delete[] file;
-        return false;
-      }
-
-      if (sample->readSampleData(reader,ds.version)!=DIV_DATA_SUCCESS) {
-        lastError="invalid sample header/data!";
-        ds.unload();
-        delete sample;
-        delete[] file;
-        return false;
-      }
-
       ds.sample.push_back(sample);
+      assetReads.push_back(FurAssetRead(FUR_ASSET_SAMPLE,i,samplePtr[i],sample,this,ds.version));
     }
 
-    // read patterns
+    // pattern headers are read here, as they determine where the pattern goes
+    bool duplicatePats=false;
+    std::unordered_set<unsigned int> patsRead;
     for (unsigned int i: patPtr) {
       bool isNewFormat=false;
       if (!reader.seek(i,SEEK_SET)) {
@@ -1953,89 +2238,18 @@ bool DivEngine::loadFur(unsigned char* file, size_t len, int variantID) {
       }
       reader.readI();
 
+      int subs=0;
+      int chan=0;
+      int index=0;
       if (isNewFormat) {
-        int subs=(unsigned char)reader.readC();
-        int chan=(unsigned char)reader.readC();
-        int index=reader.readS();
+        subs=(unsigned char)reader.readC();
+        chan=(unsigned char)reader.readC();
+        index=reader.readS();
 
         logD("- %d, %d, %d (new)",subs,chan,index);
-
-        if (chan<0 || chan>=tchans) {
-          logE("pattern channel out of range!",i);
-          lastError="pattern channel out of range!";
-          ds.unload();
-          delete[] file;
-          return false;
-        }
-        if (index<0 || index>(DIV_MAX_PATTERNS-1)) {
-          logE("pattern index out of range!",i);
-          lastError="pattern index out of range!";
-          ds.unload();
-          delete[] file;
-          return false;
-        }
-        if (subs<0 || subs>=(int)ds.subsong.size()) {
-          logE("pattern subsong out of range!",i);
-          lastError="pattern subsong out of range!";
-          ds.unload();
-          delete[] file;
-          return false;
-        }
-
-        DivPattern* pat=ds.subsong[subs]->pat[chan].getPattern(index,true);
-        pat->name=reader.readString();
-
-        // read new pattern
-        for (int j=0; j<ds.subsong[subs]->patLen; j++) {
-          unsigned char mask=reader.readC();
-          unsigned short effectMask=0;
-
-          if (mask==0xff) break;
-          if (mask&128) {
-            j+=(mask&127)+1;
-            continue;
-          }
-
-          if (mask&32) {
-            effectMask|=(unsigned char)reader.readC();
-          }
-          if (mask&64) {
-            effectMask|=((unsigned short)reader.readC()&0xff)<<8;
-          }
-          if (mask&8) effectMask|=1;
-          if (mask&16) effectMask|=2;
-
-          if (mask&1) { // note
-            unsigned char note=reader.readC();
-            // TODO: PAT2 format with new off/===/rel values!
-            if (note==180) {
-              pat->newData[j][0]=DIV_NOTE_OFF;
-            } else if (note==181) {
-              pat->newData[j][0]=DIV_NOTE_REL;
-            } else if (note==182) {
-              pat->newData[j][0]=DIV_MACRO_REL;
-            } else if (note<180) {
-              pat->newData[j][DIV_PAT_NOTE]=note;
-            } else {
-              pat->newData[j][0]=-1;
-            }
-          }
-          if (mask&2) { // instrument
-            pat->newData[j][DIV_PAT_INS]=(unsigned char)reader.readC();
-          }
-          if (mask&4) { // volume
-            pat->newData[j][DIV_PAT_VOL]=(unsigned char)reader.readC();
-          }
-          for (unsigned char k=0; k<16; k++) {
-            if (effectMask&(1<<k)) {
-              pat->newData[j][DIV_PAT_FX(0)+k]=(unsigned char)reader.readC();
-            }
-          }
-        }
       } else {
-        int chan=reader.readS();
-        int index=reader.readS();
-        int subs=0;
+        chan=reader.readS();
+        index=reader.readS();
         if (ds.version>=95) {
           subs=reader.readS();
         } else {
@@ -2044,52 +2258,112 @@ bool DivEngine::loadFur(unsigned char* file, size_t len, int variantID) {
         reader.readS();
 
         logD("- %d, %d, %d (old)",subs,chan,index);
+      }
 
-        if (chan<0 || chan>=tchans) {
-          logE("pattern channel out of range!",i);
-          lastError="pattern channel out of range!";
-          ds.unload();
-          delete[] file;
-          return false;
-        }
-        if (index<0 || index>(DIV_MAX_PATTERNS-1)) {
-          logE("pattern index out of range!",i);
-          lastError="pattern index out of range!";
-          ds.unload();
-          delete[] file;
-          return false;
-        }
-        if (subs<0 || subs>=(int)ds.subsong.size()) {
-          logE("pattern subsong out of range!",i);
-          lastError="pattern subsong out of range!";
-          ds.unload();
-          delete[] file;
-          return false;
-        }
+      if (chan<0 || chan>=tchans) {
+        logE("pattern channel out of range!",i);
+        lastError="pattern channel out of range!";
+        ds.unload();
+        delete[] file;
+        return false;
+      }
+      if (index<0 || index>(DIV_MAX_PATTERNS-1)) {
+        logE("pattern index out of range!",i);
+        lastError="pattern index out of range!";
+        ds.unload();
+        delete[] file;
+        return false;
+      }
+      if (subs<0 || subs>=(int)ds.subsong.size()) {
+        logE("pattern subsong out of range!",i);
+        lastError="pattern subsong out of range!";
+        ds.unload();
+        delete[] file;
+        return false;
+      }
 
-        DivPattern* pat=ds.subsong[subs]->pat[chan].getPattern(index,true);
-        for (int j=0; j<ds.subsong[subs]->patLen; j++) {
-          short note=reader.readS();
-          short octave=reader.readS();
-          if (note==0 && octave!=0) {
-            logD("what? %d:%d:%d note %d octave %d",chan,i,j,note,octave);
-            note=12;
-            octave--;
-          }
-          pat->newData[j][DIV_PAT_NOTE]=splitNoteToNote(note,octave);
+      // a pattern stored twice must be read in order
+      if (!patsRead.insert((subs<<24)|(chan<<16)|index).second) duplicatePats=true;
+
+      DivPattern* pat=ds.subsong[subs]->pat[chan].getPattern(index,true);
+      FurAssetRead patRead(FUR_ASSET_PAT,index,reader.tell(),pat,this,ds.version);
+      patRead.isNewFormat=isNewFormat;
+      patRead.chan=chan;
+      patRead.patLen=ds.subsong[subs]->patLen;
+      patRead.effectCols=ds.subsong[subs]->pat[chan].effectCols;
+      assetReads.push_back(patRead);
+    }
+
+    unsigned int assetThreads=0;
+    if (assetReads.size()>=FUR_MIN_PARALLEL_ASSETS && !duplicatePats) {
+      assetThreads=std::thread::hardware_concurrency();
+      if (assetThreads>0) assetThreads--;
+    }
+    size_t readChunkCount=MIN(assetReads.size(),(size_t)(assetThreads+1)*FUR_CHUNKS_PER_THREAD);
+    std::vector<FurAssetReadChunk> readChunks(readChunkCount);
+    for (size_t i=0; i<readChunkCount; i++) {
+      FurAssetReadChunk& c=readChunks[i];
+      c.file=file;
+      c.len=len;
+      c.jobs=&assetReads;
+      c.first=(assetReads.size()*i)/readChunkCount;
+      c.last=(assetReads.size()*(i+1))/readChunkCount;
+    }
+    if (assetThreads>0) {
+      DivWorkPool* assetPool=new DivWorkPool(assetThreads);
+      assetPool->pushBatch(_readAssetChunk,readChunks.data(),readChunks.size());
+      assetPool->wait();
+      delete assetPool;
+    } else {
+      for (FurAssetReadChunk& i: readChunks) {
+        _readAssetChunk(&i);
+      }
+    }
 
-          pat->newData[j][DIV_PAT_INS]=reader.readS();
-          pat->newData[j][DIV_PAT_VOL]=reader.readS();
-          for (int k=0; k<ds.subsong[subs]->pat[chan].effectCols; k++) {
-            pat->newData[j][DIV_PAT_FX(k)]=reader.readS();
-            pat->newData[j][DIV_PAT_FXVAL(k)]=reader.readS();
+    for (FurAssetRead& i: assetReads) {
+      if (i.result==FUR_READ_OK) continue;
+      if (i.result==FUR_READ_EOF) {
+        ds.unload();
+        throw EndOfFileException(&reader,reader.size());
+      }
+      switch (i.type) {
+        case FUR_ASSET_INS:
+          if (i.result==FUR_READ_SEEK_ERROR) {
+            logE("couldn't seek to instrument %d!",i.index);
+            lastError=fmt::sprintf("couldn't seek to instrument %d!",i.index);
+          } else {
+            lastError="invalid instrument header/data!";
           }
-        }
-
-        if (ds.version>=51) {
-          pat->name=reader.readString();
-        }
+          break;
+        case FUR_ASSET_WAVE:
+          if (i.result==FUR_READ_SEEK_ERROR) {
+            logE("couldn't seek to wavetable %d!",i.index);
+            lastError=fmt::sprintf("couldn't seek to wavetable %d!",i.index);
+          } else {
+            lastError="invalid wavetable header/data!";
+          }
+          break;
+        case FUR_ASSET_SAMPLE:
+          if (i.result==FUR_READ_SEEK_ERROR) {
+            logE("couldn't seek to sample %d!",i.index);
+            lastError=fmt::sprintf("couldn't seek to sample %d!",i.index);
+          } else {
+            lastError="invalid sample header/data!";
+          }
+          break;
+        case FUR_ASSET_PAT:
+          logE("couldn't seek to pattern in %x!",i.ptr);
+          lastError=fmt::sprintf("couldn't seek to pattern in %x!",i.ptr);
+          break;
       }
+      ds.unload();
+      delete[] file;
+      return false;
+    }
+
+    // the main reader would have ended after the last block
+    if (!assetReads.empty()) {
+      reader.seek(assetReads.back().endPos,SEEK_SET);
     }
 
     if (reader.tell()<reader.size()) {
@@ -2446,10 +2720,18 @@ bool DivEngine::loadFur(unsigned char* file, size_t len, int variantID) {
     BUSY_END;
     if (active) {
       initDispatch();
-      BUSY_BEGIN;
-      renderSamples();
-      reset();
-      BUSY_END;
+      if (!consoleMode && song.sampleLen>0 && getConfInt("backgroundSampleLoad",1)) {
+        // the song may be edited and played while samples are rendered
+        BUSY_BEGIN;
+        reset();
+        BUSY_END;
+        renderSamplesBackground();
+      } else {
+        BUSY_BEGIN;
+        renderSamples();
+        reset();
+        BUSY_END;
+      }
     }
   } catch (EndOfFileException& e) {
     logE("premature end of file!");
@@ -2759,134 +3041,79 @@ SafeWriter* DivEngine::saveFur(bool notPrimary) {
     i.putData(w);
   }
 
-  /// INSTRUMENT
-  insPtr.reserve(song.insLen);
+  /// INSTRUMENT, WAVETABLE, SAMPLE and PATTERN
+  // these blocks don't depend on each other, so they are written to separate writers
+  // in parallel and then appended in order.
+  std::vector<FurAssetJob> assetJobs;
+  assetJobs.reserve(song.insLen+song.waveLen+song.sampleLen+patsToWrite.size());
   for (int i=0; i<song.insLen; i++) {
-    DivInstrument* ins=song.ins[i];
-    insPtr.push_back(w->tell());
-    ins->putInsData2(w,false);
+    assetJobs.push_back(FurAssetJob(FUR_ASSET_INS,i));
   }
-
-  /// WAVETABLE
-  wavePtr.reserve(song.waveLen);
   for (int i=0; i<song.waveLen; i++) {
-    DivWavetable* wave=song.wave[i];
-    wavePtr.push_back(w->tell());
-    wave->putWaveData(w);
+    assetJobs.push_back(FurAssetJob(FUR_ASSET_WAVE,i));
   }
-
-  /// SAMPLE
-  samplePtr.reserve(song.sampleLen);
   for (int i=0; i<song.sampleLen; i++) {
-    DivSample* sample=song.sample[i];
-    samplePtr.push_back(w->tell());
-    sample->putSampleData(w);
+    assetJobs.push_back(FurAssetJob(FUR_ASSET_SAMPLE,i));
+  }
+  for (size_t i=0; i<patsToWrite.size(); i++) {
+    assetJobs.push_back(FurAssetJob(FUR_ASSET_PAT,i));
   }
 
-  /// PATTERN
-  patPtr.reserve(patsToWrite.size());
-  for (PatToWrite& i: patsToWrite) {
-    DivPattern* pat=song.subsong[i.subsong]->pat[i.chan].getPattern(i.pat,false);
-    patPtr.push_back(w->tell());
-
-    w->write("PATN",4);
-    blockStartSeek=w->tell();
-    w->writeI(0);
-
-    w->writeC(i.subsong);
-    w->writeC(i.chan);
-    w->writeS(i.pat);
-    w->writeString(pat->name,false);
-
-    unsigned char emptyRows=0;
-
-    for (int j=0; j<song.subsong[i.subsong]->patLen; j++) {
-      unsigned char mask=0;
-      unsigned char finalNote=255;
-      unsigned short effectMask=0;
-
-      if (pat->newData[j][DIV_PAT_NOTE]==DIV_NOTE_OFF) { // note off
-        finalNote=180;
-      } else if (pat->newData[j][DIV_PAT_NOTE]==DIV_NOTE_REL) { // note release
-        finalNote=181;
-      } else if (pat->newData[j][DIV_PAT_NOTE]==DIV_MACRO_REL) { // macro release
-        finalNote=182;
-      } else if (pat->newData[j][DIV_PAT_NOTE]==-1) { // empty
-        finalNote=255;
-      } else {
-        finalNote=pat->newData[j][DIV_PAT_NOTE];
-      }
-
-      if (finalNote!=255) mask|=1; // note
-      if (pat->newData[j][DIV_PAT_INS]!=-1) mask|=2; // instrument
-      if (pat->newData[j][DIV_PAT_VOL]!=-1) mask|=4; // volume
-      for (int k=0; k<song.subsong[i.subsong]->pat[i.chan].effectCols*2; k+=2) {
-        if (k==0) {
-          if (pat->newData[j][DIV_PAT_FX(0)+k]!=-1) mask|=8;
-          if (pat->newData[j][DIV_PAT_FXVAL(0)+k]!=-1) mask|=16;
-        } else if (k<8) {
-          if (pat->newData[j][DIV_PAT_FX(0)+k]!=-1 || pat->newData[j][DIV_PAT_FXVAL(0)+k]!=-1) mask|=32;
-        } else {
-          if (pat->newData[j][DIV_PAT_FX(0)+k]!=-1 || pat->newData[j][DIV_PAT_FXVAL(0)+k]!=-1) mask|=64;
-        }
-
-        if (pat->newData[j][DIV_PAT_FX(0)+k]!=-1) effectMask|=(1<<k);
-        if (pat->newData[j][DIV_PAT_FXVAL(0)+k]!=-1) effectMask|=(2<<k);
-      }
-
-      if (mask==0) {
-        emptyRows++;
-        if (emptyRows>127) {
-          w->writeC(128|(emptyRows-2));
-          emptyRows=0;
-        }
-      } else {
-        if (emptyRows>1) {
-          w->writeC(128|(emptyRows-2));
-          emptyRows=0;
-        } else if (emptyRows) {
-          w->writeC(0);
-          emptyRows=0;
-        }
-
-        w->writeC(mask);
-
-        if (mask&32) w->writeC(effectMask&0xff);
-        if (mask&64) w->writeC((effectMask>>8)&0xff);
+  unsigned int assetThreads=0;
+  if (assetJobs.size()>=FUR_MIN_PARALLEL_ASSETS) {
+    assetThreads=std::thread::hardware_concurrency();
+    if (assetThreads>0) assetThreads--;
+  }
+  size_t chunkCount=MIN(assetJobs.size(),(size_t)(assetThreads+1)*FUR_CHUNKS_PER_THREAD);
+  std::vector<FurAssetChunk> assetChunks(chunkCount);
+  bool deltaSamples=getConfInt("deltaSamples",0);
+  for (size_t i=0; i<chunkCount; i++) {
+    FurAssetChunk& c=assetChunks[i];
+    c.song=&song;
+    c.deltaSamples=deltaSamples;
+    c.jobs=&assetJobs;
+    c.pats=&patsToWrite;
+    c.first=(assetJobs.size()*i)/chunkCount;
+    c.last=(assetJobs.size()*(i+1))/chunkCount;
+  }
+  if (assetThreads>0) {
+    DivWorkPool* assetPool=new DivWorkPool(assetThreads);
+    assetPool->pushBatch(_putAssetChunk,assetChunks.data(),assetChunks.size());
+    assetPool->wait();
+    delete assetPool;
+  } else {
+    for (FurAssetChunk& i: assetChunks) {
+      _putAssetChunk(&i);
+    }
+  }
 
-        if (mask&1) w->writeC(finalNote);
-        if (mask&2) w->writeC(pat->newData[j][DIV_PAT_INS]);
-        if (mask&4) w->writeC(pat->newData[j][DIV_PAT_VOL]);
-        if (mask&8) w->writeC(pat->newData[j][DIV_PAT_FX(0)]);
-        if (mask&16) w->writeC(pat->newData[j][DIV_PAT_FXVAL(0)]);
-        if (mask&32) {
-          if (effectMask&4) w->writeC(pat->newData[j][DIV_PAT_FX(1)]);
-          if (effectMask&8) w->writeC(pat->newData[j][DIV_PAT_FXVAL(1)]);
-          if (effectMask&16) w->writeC(pat->newData[j][DIV_PAT_FX(2)]);
-          if (effectMask&32) w->writeC(pat->newData[j][DIV_PAT_FXVAL(2)]);
-          if (effectMask&64) w->writeC(pat->newData[j][DIV_PAT_FX(3)]);
-          if (effectMask&128) w->writeC(pat->newData[j][DIV_PAT_FXVAL(3)]);
-        }
-        if (mask&64) {
-          if (effectMask&256) w->writeC(pat->newData[j][DIV_PAT_FX(4)]);
-          if (effectMask&512) w->writeC(pat->newData[j][DIV_PAT_FXVAL(4)]);
-          if (effectMask&1024) w->writeC(pat->newData[j][DIV_PAT_FX(5)]);
-          if (effectMask&2048) w->writeC(pat->newData[j][DIV_PAT_FXVAL(5)]);
-          if (effectMask&4096) w->writeC(pat->newData[j][DIV_PAT_FX(6)]);
-          if (effectMask&8192) w->writeC(pat->newData[j][DIV_PAT_FXVAL(6)]);
-          if (effectMask&16384) w->writeC(pat->newData[j][DIV_PAT_FX(7)]);
-          if (effectMask&32768) w->writeC(pat->newData[j][DIV_PAT_FXVAL(7)]);
-        }
+  insPtr.reserve(song.insLen);
+  wavePtr.reserve(song.waveLen);
+  samplePtr.reserve(song.sampleLen);
+  patPtr.reserve(patsToWrite.size());
+  for (FurAssetChunk& i: assetChunks) {
+    size_t base=w->tell();
+    for (size_t j=i.first; j<i.last; j++) {
+      FurAssetJob& job=assetJobs[j];
+      switch (job.type) {
+        case FUR_ASSET_INS:
+          insPtr.push_back(base+job.offset);
+          break;
+        case FUR_ASSET_WAVE:
+          wavePtr.push_back(base+job.offset);
+          break;
+        case FUR_ASSET_SAMPLE:
+          samplePtr.push_back(base+job.offset);
+          break;
+        case FUR_ASSET_PAT:
+          patPtr.push_back(base+job.offset);
+          break;
       }
     }
-
-    // stop
-    w->writeC(0xff);
-
-    blockEndSeek=w->tell();
-    w->seek(blockStartSeek,SEEK_SET);
-    w->writeI(blockEndSeek-blockStartSeek-4);
-    w->seek(0,SEEK_END);
+    w->write(i.w->getFinalBuf(),i.w->size());
+    i.w->finish();
+    delete i.w;
+    i.w=NULL;
   }
 
   /// POINTERS
@@ -18,11 +18,85 @@
  */
 
 #include "fileOpsCommon.h"
+#include "../workPool.h"
 
 extern "C" {
 #include "../../../extern/itcompress/compression.h"
 }
 
+// compressed samples are decoded in parallel when there are at least this many.
+#define IT_MIN_PARALLEL_SAMPLES 4
+
+// a compressed sample waiting to be decoded.
+struct ITSampleDecode {
+  DivSample* s;
+  const unsigned char* src;
+  size_t srcLen;
+  unsigned char flags, convert, sampleVol;
+  ITSampleDecode(DivSample* _s, const unsigned char* sr, size_t sl, unsigned char f, unsigned char c, unsigned char v):
+    s(_s),
+    src(sr),
+    srcLen(sl),
+    flags(f),
+    convert(c),
+    sampleVol(v) {}
+  ITSampleDecode():
+    s(NULL),
+    src(NULL),
+    srcLen(0),
+    flags(0),
+    convert(0),
+    sampleVol(64) {}
+};
+
+static void scaleSample(DivSample* s, unsigned char sampleVol) {
+  if (s->samples<=0) return;
+  if (sampleVol>64) sampleVol=64;
+  if (sampleVol<64) {
+    // convert to 16-bit
+    if (s->depth==DIV_SAMPLE_DEPTH_8BIT) {
+      s->convert(DIV_SAMPLE_DEPTH_16BIT,0);
+    }
+
+    // then scale
+    for (unsigned int i=0; i<s->samples; i++) {
+      s->data16[i]=(s->data16[i]*sampleVol)>>6;
+    }
+  }
+}
+
+static void _decodeSample(void* data) {
+  ITSampleDecode* d=(ITSampleDecode*)data;
+  DivSample* s=d->s;
+  unsigned int ret=0;
+  if (d->flags&4) {
+    // downmix stereo
+    if (s->depth==DIV_SAMPLE_DEPTH_16BIT) {
+      short* outData=new short[s->samples*2];
+      ret=it_decompress16(outData,s->samples,d->src,d->srcLen,(d->convert&4)?1:0,2);
+      for (unsigned int i=0; i<s->samples; i++) {
+        s->data16[i]=(outData[i<<1]+outData[1+(i<<1)])>>1;
+      }
+      delete[] outData;
+    } else {
+      signed char* outData=new signed char[s->samples*2];
+      ret=it_decompress8(outData,s->samples,d->src,d->srcLen,(d->convert&4)?1:0,2);
+      for (unsigned int i=0; i<s->samples; i++) {
+        s->data8[i]=(outData[i<<1]+outData[1+(i<<1)])>>1;
+      }
+      delete[] outData;
+    }
+  } else {
+    if (s->depth==DIV_SAMPLE_DEPTH_16BIT) {
+      ret=it_decompress16(s->data16,s->samples,d->src,d->srcLen,(d->convert&4)?1:0,1);
+    } else {
+      ret=it_decompress8(s->data8,s->samples,d->src,d->srcLen,(d->convert&4)?1:0,1);
+    }
+  }
+  logV("decompressed %d: got %d",s->samples,ret);
+  scaleSample(s,d->sampleVol);
+}
+
 static const unsigned char volPortaSlide[10]={
   0, 1, 4, 8, 16, 32, 64, 96, 128, 255
 };
@@ -625,6 +699,7 @@ bool DivEngine::loadIT(unsigned char* file, size_t len) {
     }
 
     // read samples
+    std::vector<ITSampleDecode> sampleDecodes;
     for (int i=0; i<ds.sampleLen; i++) {
       DivSample* s=new DivSample;
 
@@ -739,37 +814,9 @@ bool DivEngine::loadIT(unsigned char* file, size_t len) {
       logV("reading sample data (%d)",s->samples);
 
       if (flags&8) { // compressed sample
-        unsigned int ret=0;
-        logV("decompression begin... (%d)",s->samples);
-        if (flags&4) {
-          logW("STEREO!");
-          if (s->depth==DIV_SAMPLE_DEPTH_16BIT) {
-            logV("16-bit");
-            short* outData=new short[s->samples*2];
-            ret=it_decompress16(outData,s->samples,&file[reader.tell()],len-reader.tell(),(convert&4)?1:0,(flags&4)?2:1);
-            for (unsigned int i=0; i<s->samples; i++) {
-              s->data16[i]=(outData[i<<1]+outData[1+(i<<1)])>>1;
-            }
-            delete[] outData;
-          } else {
-            logV("8-bit");
-            signed char* outData=new signed char[s->samples*2];
-            ret=it_decompress8(outData,s->samples,&file[reader.tell()],len-reader.tell(),(convert&4)?1:0,(flags&4)?2:1);
-            for (unsigned int i=0; i<s->samples; i++) {
-              s->data8[i]=(outData[i<<1]+outData[1+(i<<1)])>>1;
-            }
-            delete[] outData;
-          }
-        } else {
-          if (s->depth==DIV_SAMPLE_DEPTH_16BIT) {
-            logV("16-bit");
-            ret=it_decompress16(s->data16,s->samples,&file[reader.tell()],len-reader.tell(),(convert&4)?1:0,(flags&4)?2:1);
-          } else {
-            logV("8-bit");
-            ret=it_decompress8(s->data8,s->samples,&file[reader.tell()],len-reader.tell(),(convert&4)?1:0,(flags&4)?2:1);
-          }
-        }
-        logV("got: %d",ret);
+        // decoded later
+        if (flags&4) logW("STEREO!");
+        sampleDecodes.push_back(ITSampleDecode(s,&file[reader.tell()],len-reader.tell(),flags,convert,sampleVol));
       } else {
         try {
           if (s->depth==DIV_SAMPLE_DEPTH_16BIT) {
@@ -799,13 +846,13 @@ bool DivEngine::loadIT(unsigned char* file, size_t len) {
                 s->data16[i]=(s->data16[i]+r)>>1;
               }
             } else {
-              for (unsigned int i=0; i<s->samples; i++) {
-                if (convert&2) {
-                  s->data16[i]=reader.readS_BE()^((convert&1)?0:0x8000);
-                } else {
-                  s->data16[i]=reader.readS()^((convert&1)?0:0x8000);
+              size_t got=reader.readArray(s->data16,s->samples,(convert&2)?BigEndian:LittleEndian);
+              if (!(convert&1)) {
+                for (size_t i=0; i<got; i++) {
+                  s->data16[i]^=0x8000;
                 }
               }
+              if (got<s->samples) throw EndOfFileException(&reader,reader.size());
             }
           } else {
             if (flags&4) { // downmix stereo
@@ -824,9 +871,13 @@ bool DivEngine::loadIT(unsigned char* file, size_t len) {
                 s->data8[i]=(s->data8[i]+r)>>1;
               }
             } else {
-              for (unsigned int i=0; i<s->samples; i++) {
-                s->data8[i]=reader.readC()^((convert&1)?0:0x80);
+              size_t got=reader.readArray(s->data8,s->samples);
+              if (!(convert&1)) {
+                for (size_t i=0; i<got; i++) {
+                  s->data8[i]^=0x80;
+                }
               }
+              if (got<s->samples) throw EndOfFileException(&reader,reader.size());
             }
           }
         } catch (EndOfFileException& e) {
@@ -835,20 +886,7 @@ bool DivEngine::loadIT(unsigned char* file, size_t len) {
       }
 
       // scale sample if necessary
-      if (s->samples>0) {
-        if (sampleVol>64) sampleVol=64;
-        if (sampleVol<64) {
-          // convert to 16-bit
-          if (s->depth==DIV_SAMPLE_DEPTH_8BIT) {
-            s->convert(DIV_SAMPLE_DEPTH_16BIT,0);
-          }
-
-          // then scale
-          for (unsigned int i=0; i<s->samples; i++) {
-            s->data16[i]=(s->data16[i]*sampleVol)>>6;
-          }
-        }
-      }
+      if (!(flags&8)) scaleSample(s,sampleVol);
 
       // does the song not use instruments?
       // create instrument then
@@ -863,6 +901,27 @@ bool DivEngine::loadIT(unsigned char* file, size_t len) {
       ds.sample.push_back(s);
     }
 
+    // decode compressed samples
+    if (!sampleDecodes.empty()) {
+      unsigned int threads=0;
+      if (sampleDecodes.size()>=IT_MIN_PARALLEL_SAMPLES) {
+        threads=std::thread::hardware_concurrency();
+        if (threads>sampleDecodes.size()) threads=sampleDecodes.size();
+        if (threads>0) threads--;
+      }
+      logV("decompressing %d samples (%d extra threads)...",(int)sampleDecodes.size(),threads);
+      if (threads>0) {
+        DivWorkPool* pool=new DivWorkPool(threads);
+        pool->pushBatch(_decodeSample,sampleDecodes.data(),sampleDecodes.size());
+        pool->wait();
+        delete pool;
+      } else {
+        for (ITSampleDecode& i: sampleDecodes) {
+          _decodeSample(&i);
+        }
+      }
+    }
+
     // scan pattern data for effect use
     int maxChan=0;
     for (int i=0; i<patCount; i++) {
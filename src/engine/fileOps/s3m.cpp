@@ -541,19 +541,21 @@ bool DivEngine::loadS3M(unsigned char* file, size_t len) {
           }
         } else {
           if (s->depth==DIV_SAMPLE_DEPTH_16BIT) {
-            for (unsigned int i=0; i<s->samples; i++) {
-              s->data16[i]=reader.readS();
-              if (!signedSamples) {
+            size_t got=reader.readArray(s->data16,s->samples);
+            if (!signedSamples) {
+              for (size_t i=0; i<got; i++) {
                 s->data16[i]^=0x8000;
               }
             }
+            if (got<s->samples) throw EndOfFileException(&reader,reader.size());
           } else {
-            for (unsigned int i=0; i<s->samples; i++) {
-              s->data8[i]=reader.readC();
-              if (!signedSamples) {
+            size_t got=reader.readArray(s->data8,s->samples);
+            if (!signedSamples) {
+              for (size_t i=0; i<got; i++) {
                 s->data8[i]^=0x80;
               }
             }
+            if (got<s->samples) throw EndOfFileException(&reader,reader.size());
           }
         }
 
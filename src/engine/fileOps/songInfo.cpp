@@ -0,0 +1,277 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2026 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "fileOpsCommon.h"
+#include "../../fileutils.h"
+
+#define SONG_INFO_CHUNK 16384
+
+// reads the beginning of a song file, decompressing it if necessary.
+class DivSongInfoReader {
+  FILE* f;
+  z_stream zl;
+  bool compressed, ended, failed;
+  unsigned char inBuf[SONG_INFO_CHUNK];
+
+  public:
+    std::vector<unsigned char> data;
+
+    bool open(const char* path) {
+      f=ps_fopen(path,"rb");
+      if (f==NULL) return false;
+      unsigned char head[2];
+      if (fread(head,1,2,f)!=2) return false;
+      // zlib header: deflate method and a valid check value
+      compressed=((head[0]&15)==8 && ((head[0]<<8)|head[1])%31==0);
+      if (compressed) {
+        if (inflateInit(&zl)!=Z_OK) {
+          inflateEnd(&zl);
+          compressed=false;
+          return false;
+        }
+        memcpy(inBuf,head,2);
+        zl.next_in=inBuf;
+        zl.avail_in=2;
+      } else {
+        data.push_back(head[0]);
+        data.push_back(head[1]);
+      }
+      return true;
+    }
+
+    // read until at least need bytes are available, or the file ends.
+    // returns false if the file ended or could not be read.
+    bool fill(size_t need) {
+      unsigned char outBuf[SONG_INFO_CHUNK];
+      while (data.size()<need) {
+        if (ended || failed) return false;
+        if (!compressed) {
+          size_t got=fread(outBuf,1,SONG_INFO_CHUNK,f);
+          if (got==0) {
+            ended=true;
+            return false;
+          }
+          data.insert(data.end(),outBuf,outBuf+got);
+          continue;
+        }
+        if (zl.avail_in==0) {
+          size_t got=fread(inBuf,1,SONG_INFO_CHUNK,f);
+          if (got==0) {
+            ended=true;
+            return false;
+          }
+          zl.next_in=inBuf;
+          zl.avail_in=got;
+        }
+        zl.next_out=outBuf;
+        zl.avail_out=SONG_INFO_CHUNK;
+        int result=inflate(&zl,Z_SYNC_FLUSH);
+        if (result!=Z_OK && result!=Z_STREAM_END && result!=Z_BUF_ERROR) {
+          failed=true;
+          return false;
+        }
+        data.insert(data.end(),outBuf,zl.next_out);
+        if (result==Z_STREAM_END) ended=true;
+      }
+      return true;
+    }
+
+    DivSongInfoReader():
+      f(NULL),
+      compressed(false),
+      ended(false),
+      failed(false) {
+      memset(&zl,0,sizeof(z_stream));
+    }
+    ~DivSongInfoReader() {
+      if (compressed) inflateEnd(&zl);
+      if (f!=NULL) fclose(f);
+    }
+};
+
+bool DivEngine::readSongInfo(const char* path, DivSongInfo& info) {
+  DivSongInfoReader file;
+  if (!file.open(path)) {
+    lastError="couldn't open file";
+    return false;
+  }
+
+  // header
+  file.fill(24);
+  if (file.data.size()<24) {
+    lastError="file is too small";
+    return false;
+  }
+  if (memcmp(file.data.data(),DIV_FUR_MAGIC,16)!=0 && memcmp(file.data.data(),DIV_FUR_MAGIC_DS0,16)!=0) {
+    lastError="not a Furnace song";
+    return false;
+  }
+
+  registerDefs();
+
+  // the info block is parsed again with more data until it fits
+  size_t want=24+SONG_INFO_CHUNK;
+  while (true) {
+    bool more=file.fill(want);
+    DivSongInfo result;
+    SafeReader reader=SafeReader(file.data.data(),file.data.size());
+    try {
+      char magic[5];
+      memset(magic,0,5);
+
+      reader.seek(16,SEEK_SET);
+      result.version=reader.readS();
+      reader.readS();
+      int infoSeek=reader.readI();
+      if (!reader.seek(infoSeek,SEEK_SET)) {
+        if (infoSeek>0 && (size_t)infoSeek>=want) {
+          want=(size_t)infoSeek+SONG_INFO_CHUNK;
+          if (more) continue;
+        }
+        lastError="couldn't seek to info header!";
+        return false;
+      }
+      reader.read(magic,4);
+      reader.readI();
+
+      if (result.version>=240) {
+        if (strcmp(magic,"INF2")!=0) {
+          lastError="invalid info header!";
+          return false;
+        }
+        result.name=reader.readString();
+        result.author=reader.readString();
+        result.systemName=reader.readString();
+        result.category=reader.readString();
+        reader.readString();
+        reader.readString();
+        reader.readString();
+        reader.readString();
+        reader.readF();
+        reader.readC();
+        reader.readF();
+        result.chans=(unsigned short)reader.readS();
+        int systemLen=(unsigned short)reader.readS();
+        for (int i=0; i<systemLen; i++) {
+          unsigned short sysID=reader.readS();
+          if (sysID>0xff) {
+            lastError=fmt::sprintf("unrecognized system ID %.4x!",sysID);
+            return false;
+          }
+          result.systems.push_back(systemFromFileFur(sysID));
+          reader.readS();
+          reader.readF();
+          reader.readF();
+          reader.readF();
+        }
+
+        // patchbay
+        unsigned int conns=reader.readI();
+        if (!reader.seek(conns*4,SEEK_CUR)) throw EndOfFileException(&reader,reader.size());
+        reader.readC();
+
+        // elements. only their counts are needed.
+        while (true) {
+          unsigned char elementType=reader.readC();
+          if (elementType==DIV_ELEMENT_END) break;
+          unsigned int numElements=reader.readI();
+          switch (elementType) {
+            case DIV_ELEMENT_SUBSONG:
+              result.subSongs=numElements;
+              break;
+            case DIV_ELEMENT_INSTRUMENT:
+              result.insLen=numElements;
+              break;
+            case DIV_ELEMENT_WAVETABLE:
+              result.waveLen=numElements;
+              break;
+            case DIV_ELEMENT_SAMPLE:
+              result.sampleLen=numElements;
+              break;
+          }
+          if (!reader.seek(numElements*4,SEEK_CUR)) throw EndOfFileException(&reader,reader.size());
+        }
+      } else {
+        if (strcmp(magic,"INFO")!=0) {
+          lastError="invalid info header!";
+          return false;
+        }
+        // timing, lengths and highlights
+        if (!reader.seek(14,SEEK_CUR)) throw EndOfFileException(&reader,reader.size());
+        result.insLen=reader.readS();
+        result.waveLen=reader.readS();
+        result.sampleLen=reader.readS();
+        reader.readI();
+        result.subSongs=1;
+
+        unsigned char sysIDs[DIV_MAX_CHIPS];
+        reader.read(sysIDs,DIV_MAX_CHIPS);
+        for (int i=0; i<DIV_MAX_CHIPS; i++) {
+          if (sysIDs[i]==0) continue;
+          DivSystem sys=systemFromFileFur(sysIDs[i]);
+          // split compound systems like the loader does
+          switch (sys) {
+            case DIV_SYSTEM_GENESIS:
+              result.systems.push_back(DIV_SYSTEM_YM2612);
+              result.systems.push_back(DIV_SYSTEM_SMS);
+              break;
+            case DIV_SYSTEM_GENESIS_EXT:
+              result.systems.push_back(DIV_SYSTEM_YM2612_EXT);
+              result.systems.push_back(DIV_SYSTEM_SMS);
+              break;
+            case DIV_SYSTEM_ARCADE:
+              result.systems.push_back(DIV_SYSTEM_YM2151);
+              result.systems.push_back(DIV_SYSTEM_SEGAPCM);
+              break;
+            case DIV_SYSTEM_SEGAPCM_COMPAT:
+              result.systems.push_back(DIV_SYSTEM_SEGAPCM);
+              break;
+            case DIV_SYSTEM_YM2610_CRAP:
+              result.systems.push_back(DIV_SYSTEM_YM2610_FULL);
+              break;
+            case DIV_SYSTEM_YM2610_CRAP_EXT:
+              result.systems.push_back(DIV_SYSTEM_YM2610_FULL_EXT);
+              break;
+            default:
+              result.systems.push_back(sys);
+              break;
+          }
+        }
+        for (DivSystem i: result.systems) {
+          result.chans+=getChannelCount(i);
+        }
+
+        // volume, panning and flag pointers
+        if (!reader.seek(DIV_MAX_CHIPS*6,SEEK_CUR)) throw EndOfFileException(&reader,reader.size());
+        result.name=reader.readString();
+        result.author=reader.readString();
+      }
+    } catch (EndOfFileException& e) {
+      if (more) {
+        want=file.data.size()*2;
+        continue;
+      }
+      lastError="incomplete file";
+      return false;
+    }
+
+    info=result;
+    return true;
+  }
+}
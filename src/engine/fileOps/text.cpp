@@ -18,6 +18,12 @@
  */
 
 #include "fileOpsCommon.h"
+#include "../workPool.h"
+
+// output is flushed whenever this much text is buffered
+#define TEXT_BUF_SIZE 65536
+// orders formatted in parallel at a time
+#define TEXT_ORDER_BATCH 64
 
 static const char* trueFalse[2]={
   "no", "yes"
@@ -39,7 +45,147 @@ static const char* sampleLoopModes[4]={
   "forward", "backward", "ping-pong", "invalid"
 };
 
-void writeTextMacro(SafeWriter* w, DivInstrumentMacro& m, const char* name, bool& wroteMacroHeader) {
+static const char hexDigits[16]={
+  '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'
+};
+
+// equivalent to %.*X for values which fit in the specified number of digits
+static inline void appendHex(String& s, unsigned int val, int digits) {
+  char buf[8];
+  for (int i=digits-1; i>=0; i--) {
+    buf[i]=hexDigits[val&15];
+    val>>=4;
+  }
+  s.append(buf,digits);
+}
+
+static inline void appendDec(String& s, int val) {
+  if (val>=10) appendDec(s,val/10);
+  s+=(char)('0'+(val%10));
+}
+
+// buffered text output to either a SafeWriter or a file.
+class DivTextWriter {
+  SafeWriter* w;
+  FILE* f;
+  String buf;
+  bool failed;
+
+  public:
+    void writeText(const String& val) {
+      buf+=val;
+      if (buf.size()>=TEXT_BUF_SIZE) flush();
+    }
+    void writeHex(unsigned int val, int digits) {
+      appendHex(buf,val,digits);
+    }
+    bool flush() {
+      if (!buf.empty()) {
+        if (w!=NULL) {
+          w->write(buf.data(),buf.size());
+        } else if (f!=NULL) {
+          if (fwrite(buf.data(),1,buf.size(),f)!=buf.size()) failed=true;
+        }
+        buf.clear();
+      }
+      return !failed;
+    }
+    DivTextWriter(SafeWriter* writer, FILE* file):
+      w(writer),
+      f(file),
+      failed(false) {
+      buf.reserve(TEXT_BUF_SIZE*2);
+    }
+};
+
+struct DivTextOrderTask {
+  DivEngine* e;
+  DivSubSong* s;
+  int order, chans;
+  String out;
+  DivTextOrderTask():
+    e(NULL),
+    s(NULL),
+    order(0),
+    chans(0) {}
+};
+
+// format the patterns of one order.
+static void formatTextOrder(void* arg) {
+  DivTextOrderTask* t=(DivTextOrderTask*)arg;
+  DivSubSong* s=t->s;
+  String& out=t->out;
+  int j=t->order;
+
+  out.clear();
+  out+="----- ORDER ";
+  appendHex(out,j,2);
+  out+="\n";
+
+  for (int k=0; k<s->patLen; k++) {
+    appendHex(out,k,2);
+    out+=' ';
+
+    for (int l=0; l<t->chans; l++) {
+      DivPattern* p=s->pat[l].getPattern(s->orders.ord[l][j],false);
+      short note, octave;
+      t->e->noteToSplitNote(p->newData[k][DIV_PAT_NOTE],note,octave);
+
+      if (note==0 && octave==0) {
+        out+="|... ";
+      } else if (note==100) {
+        out+="|OFF ";
+      } else if (note==101) {
+        out+="|=== ";
+      } else if (note==102) {
+        out+="|REL ";
+      } else if ((octave>9 && octave<250) || note>12) {
+        out+="|??? ";
+      } else {
+        if (octave>=128) octave-=256;
+        if (note>11) {
+          note-=12;
+          octave++;
+        }
+        out+='|';
+        out+=(octave<0)?notesNegative[note]:notes[note];
+        appendDec(out,(octave<0)?(-octave):octave);
+        out+=' ';
+      }
+
+      if (p->newData[k][DIV_PAT_INS]==-1) {
+        out+=".. ";
+      } else {
+        appendHex(out,p->newData[k][DIV_PAT_INS]&0xff,2);
+        out+=' ';
+      }
+
+      if (p->newData[k][DIV_PAT_VOL]==-1) {
+        out+="..";
+      } else {
+        appendHex(out,p->newData[k][DIV_PAT_VOL]&0xff,2);
+      }
+
+      for (int m=0; m<s->pat[l].effectCols; m++) {
+        if (p->newData[k][DIV_PAT_FX(m)]==-1) {
+          out+=" ..";
+        } else {
+          out+=' ';
+          appendHex(out,p->newData[k][DIV_PAT_FX(m)]&0xff,2);
+        }
+        if (p->newData[k][DIV_PAT_FXVAL(m)]==-1) {
+          out+="..";
+        } else {
+          appendHex(out,p->newData[k][DIV_PAT_FXVAL(m)]&0xff,2);
+        }
+      }
+    }
+
+    out+="\n";
+  }
+}
+
+void writeTextMacro(DivTextWriter* w, DivInstrumentMacro& m, const char* name, bool& wroteMacroHeader) {
   if ((m.open&6)==0 && m.len<1) return;
   if (!wroteMacroHeader) {
     w->writeText("- macros:\n");
@@ -78,12 +224,7 @@ void writeTextMacro(SafeWriter* w, DivInstrumentMacro& m, const char* name, bool
   w->writeText("\n");
 }
 
-SafeWriter* DivEngine::saveText(bool separatePatterns) {
-  saveLock.lock();
-
-  SafeWriter* w=new SafeWriter;
-  w->init();
-
+void DivEngine::writeSongText(DivTextWriter* w, bool separatePatterns) {
   w->writeText(fmt::sprintf("# Furnace Text Export\n\ngenerated by Furnace %s (%d)\n\n# Song Information\n\n",DIV_VERSION,DIV_ENGINE_VERSION));
   w->writeText(fmt::sprintf("- name: %s\n",song.name));
   w->writeText(fmt::sprintf("- author: %s\n",song.author));
@@ -277,14 +418,26 @@ SafeWriter* DivEngine::saveText(bool separatePatterns) {
     unsigned int bufLen=sample->getCurBufLen();
     w->writeText("\n```");
     for (unsigned int i=0; i<bufLen; i++) {
-      if ((i&15)==0) w->writeText(fmt::sprintf("\n%.8X:",i));
-      w->writeText(fmt::sprintf(" %.2X",buf[i]));
+      if ((i&15)==0) {
+        w->writeText("\n");
+        w->writeHex(i,8);
+        w->writeText(":");
+      }
+      w->writeText(" ");
+      w->writeHex(buf[i],2);
     }
     w->writeText("\n```\n\n");
   }
 
   w->writeText("\n# Subsongs\n\n");
 
+  DivTextOrderTask* orderTasks=new DivTextOrderTask[TEXT_ORDER_BATCH];
+  DivWorkPool* pool=NULL;
+  unsigned int threads=std::thread::hardware_concurrency();
+  if (threads>1 && !separatePatterns) {
+    pool=new DivWorkPool(threads-1);
+  }
+
   for (size_t i=0; i<song.subsong.size(); i++) {
     DivSubSong* s=song.subsong[i];
     w->writeText(fmt::sprintf("## %d: %s\n\n",(int)i,s->name));
@@ -300,9 +453,11 @@ SafeWriter* DivEngine::saveText(bool separatePatterns) {
     w->writeText(fmt::sprintf("\norders:\n```\n"));
 
     for (int j=0; j<s->ordersLen; j++) {
-      w->writeText(fmt::sprintf("%.2X |",j));
+      w->writeHex(j,2);
+      w->writeText(" |");
       for (int k=0; k<song.chans; k++) {
-        w->writeText(fmt::sprintf(" %.2X",s->orders.ord[k][j]));
+        w->writeText(" ");
+        w->writeHex(s->orders.ord[k][j],2);
       }
       w->writeText("\n");
     }
@@ -311,69 +466,55 @@ SafeWriter* DivEngine::saveText(bool separatePatterns) {
     if (separatePatterns) {
       w->writeText("TODO: separate patterns\n\n");
     } else {
-      for (int j=0; j<s->ordersLen; j++) {
-        w->writeText(fmt::sprintf("----- ORDER %.2X\n",j));
-
-        for (int k=0; k<s->patLen; k++) {
-          w->writeText(fmt::sprintf("%.2X ",k));
-
-          for (int l=0; l<song.chans; l++) {
-            DivPattern* p=s->pat[l].getPattern(s->orders.ord[l][j],false);
-            short note, octave;
-            noteToSplitNote(p->newData[k][DIV_PAT_NOTE],note,octave);
-
-            if (note==0 && octave==0) {
-              w->writeText("|... ");
-            } else if (note==100) {
-              w->writeText("|OFF ");
-            } else if (note==101) {
-              w->writeText("|=== ");
-            } else if (note==102) {
-              w->writeText("|REL ");
-            } else if ((octave>9 && octave<250) || note>12) {
-              w->writeText("|??? ");
-            } else {
-              if (octave>=128) octave-=256;
-              if (note>11) {
-                note-=12;
-                octave++;
-              }
-              w->writeText(fmt::sprintf("|%s%d ",(octave<0)?notesNegative[note]:notes[note],(octave<0)?(-octave):octave));
-            }
-
-            if (p->newData[k][DIV_PAT_INS]==-1) {
-              w->writeText(".. ");
-            } else {
-              w->writeText(fmt::sprintf("%.2X ",p->newData[k][DIV_PAT_INS]&0xff));
-            }
-
-            if (p->newData[k][DIV_PAT_VOL]==-1) {
-              w->writeText("..");
-            } else {
-              w->writeText(fmt::sprintf("%.2X",p->newData[k][DIV_PAT_VOL]&0xff));
-            }
-
-            for (int m=0; m<s->pat[l].effectCols; m++) {
-              if (p->newData[k][DIV_PAT_FX(m)]==-1) {
-                w->writeText(" ..");
-              } else {
-                w->writeText(fmt::sprintf(" %.2X",p->newData[k][DIV_PAT_FX(m)]&0xff));
-              }
-              if (p->newData[k][DIV_PAT_FXVAL(m)]==-1) {
-                w->writeText("..");
-              } else {
-                w->writeText(fmt::sprintf("%.2X",p->newData[k][DIV_PAT_FXVAL(m)]&0xff));
-              }
-            }
+      // orders are formatted in parallel, a batch at a time, and written in order
+      for (int j=0; j<s->ordersLen; j+=TEXT_ORDER_BATCH) {
+        int batch=MIN(TEXT_ORDER_BATCH,s->ordersLen-j);
+        for (int k=0; k<batch; k++) {
+          orderTasks[k].e=this;
+          orderTasks[k].s=s;
+          orderTasks[k].order=j+k;
+          orderTasks[k].chans=song.chans;
+        }
+        if (pool!=NULL) {
+          pool->pushBatch(formatTextOrder,orderTasks,batch);
+          pool->wait();
+        } else {
+          for (int k=0; k<batch; k++) {
+            formatTextOrder(&orderTasks[k]);
           }
-
-          w->writeText("\n");
+        }
+        for (int k=0; k<batch; k++) {
+          w->writeText(orderTasks[k].out);
         }
       }
     }
-
   }
 
+  if (pool!=NULL) delete pool;
+  delete[] orderTasks;
+}
+
+SafeWriter* DivEngine::saveText(bool separatePatterns) {
+  saveLock.lock();
+
+  SafeWriter* w=new SafeWriter;
+  w->init();
+
+  DivTextWriter text(w,NULL);
+  writeSongText(&text,separatePatterns);
+  text.flush();
+
   saveLock.unlock();
   return w;
 }
+
+bool DivEngine::saveTextFile(FILE* f, bool separatePatterns) {
+  saveLock.lock();
+
+  DivTextWriter text(NULL,f);
+  writeSongText(&text,separatePatterns);
+  bool ret=text.flush();
+
+  saveLock.unlock();
+  return ret;
+}
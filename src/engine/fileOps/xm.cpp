@@ -712,18 +712,23 @@ bool DivEngine::loadXM(unsigned char* file, size_t len) {
           DivSample* s=toAdd[j];
 
           // load sample data
+          // samples are stored as deltas
           if (s->depth==DIV_SAMPLE_DEPTH_16BIT) {
+            size_t got=reader.readArray(s->data16,s->samples);
             short next=0;
-            for (unsigned int i=0; i<s->samples; i++) {
-              next+=reader.readS();
+            for (size_t i=0; i<got; i++) {
+              next+=s->data16[i];
               s->data16[i]=next;
             }
+            if (got<s->samples) throw EndOfFileException(&reader,reader.size());
           } else {
+            size_t got=reader.readArray(s->data8,s->samples);
             signed char next=0;
-            for (unsigned int i=0; i<s->samples; i++) {
-              next+=reader.readC();
+            for (size_t i=0; i<got; i++) {
+              next+=s->data8[i];
               s->data8[i]=next;
             }
+            if (got<s->samples) throw EndOfFileException(&reader,reader.size());
           }
         }
 
@@ -18,6 +18,7 @@
  */
 
 #include "engine.h"
+#include "workPool.h"
 #include "../ta-log.h"
 #include "../fileutils.h"
 #include <fmt/printf.h>
@@ -90,7 +91,7 @@ static bool stringNotBlank(String& str) {
   return str.size() > 0 && str.find_first_not_of(' ') != String::npos;
 }
 
-void DivEngine::loadDMP(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath) {
+void DivEngine::loadDMP(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath, DivInsLoadStatus& status) {
   DivInstrument* ins=new DivInstrument;
   // this is a ridiculous mess
   unsigned char version=0;
@@ -100,14 +101,14 @@ void DivEngine::loadDMP(SafeReader& reader, std::vector<DivInstrument*>& ret, St
     version=reader.readC();
     logD(".dmp version %d",version);
   } catch (EndOfFileException& e) {
-    lastError="premature end of file";
+    status.error="premature end of file";
     logE("premature end of file");
     delete ins;
     return;
   }
 
   if (version>11) {
-    lastError="unknown instrument version!";
+    status.error="unknown instrument version!";
     delete ins;
     return;
   }
@@ -157,13 +158,13 @@ void DivEngine::loadDMP(SafeReader& reader, std::vector<DivInstrument*>& ret, St
           break;
         default:
           logD("instrument type is unknown");
-          lastError=fmt::sprintf("unknown instrument type %d!",sys);
+          status.error=fmt::sprintf("unknown instrument type %d!",sys);
           delete ins;
           return;
           break;
       }
     } catch (EndOfFileException& e) {
-      lastError="premature end of file";
+      status.error="premature end of file";
       logE("premature end of file");
       delete ins;
       return;
@@ -409,7 +410,7 @@ void DivEngine::loadDMP(SafeReader& reader, std::vector<DivInstrument*>& ret, St
       }
     }
   } catch (EndOfFileException& e) {
-    lastError="premature end of file";
+    status.error="premature end of file";
     logE("premature end of file");
     delete ins;
     return;
@@ -418,7 +419,7 @@ void DivEngine::loadDMP(SafeReader& reader, std::vector<DivInstrument*>& ret, St
   ret.push_back(ins);
 }
 
-void DivEngine::loadTFI(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath) {
+void DivEngine::loadTFI(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath, DivInsLoadStatus& status) {
   DivInstrument* ins=new DivInstrument;
   try {
     reader.seek(0,SEEK_SET);
@@ -444,7 +445,7 @@ void DivEngine::loadTFI(SafeReader& reader, std::vector<DivInstrument*>& ret, St
       op.ssgEnv=reader.readC();
     }
   } catch (EndOfFileException& e) {
-    lastError="premature end of file";
+    status.error="premature end of file";
     logE("premature end of file");
     delete ins;
     return;
@@ -453,7 +454,7 @@ void DivEngine::loadTFI(SafeReader& reader, std::vector<DivInstrument*>& ret, St
   ret.push_back(ins);
 }
 
-void DivEngine::loadVGI(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath) {
+void DivEngine::loadVGI(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath, DivInsLoadStatus& status) {
   DivInstrument* ins=new DivInstrument;
   try {
     reader.seek(0,SEEK_SET);
@@ -486,7 +487,7 @@ void DivEngine::loadVGI(SafeReader& reader, std::vector<DivInstrument*>& ret, St
       op.ssgEnv=reader.readC();
     }
   } catch (EndOfFileException& e) {
-    lastError="premature end of file";
+    status.error="premature end of file";
     logE("premature end of file");
     delete ins;
     return;
@@ -495,7 +496,7 @@ void DivEngine::loadVGI(SafeReader& reader, std::vector<DivInstrument*>& ret, St
   ret.push_back(ins);
 }
 
-void DivEngine::loadEIF(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath) {
+void DivEngine::loadEIF(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath, DivInsLoadStatus& status) {
   DivInstrument* ins=new DivInstrument;
   try {
     unsigned char bytes[29];
@@ -528,7 +529,7 @@ void DivEngine::loadEIF(SafeReader& reader, std::vector<DivInstrument*>& ret, St
       op.ssgEnv=bytes[25+i]&0x0F;
     }
    } catch (EndOfFileException& e) {
-    lastError="premature end of file";
+    status.error="premature end of file";
     logE("premature end of file");
     delete ins;
     return;
@@ -537,7 +538,7 @@ void DivEngine::loadEIF(SafeReader& reader, std::vector<DivInstrument*>& ret, St
   ret.push_back(ins);
 }
 
-void DivEngine::loadS3I(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath) {
+void DivEngine::loadS3I(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath, DivInsLoadStatus& status) {
   DivInstrument* ins=new DivInstrument;
   try {
     reader.seek(0, SEEK_SET);
@@ -594,7 +595,7 @@ void DivEngine::loadS3I(SafeReader& reader, std::vector<DivInstrument*>& ret, St
       // Skip more stuff we don't need
       reader.seek(21, SEEK_CUR);
     } else {
-      lastError="S3I PCM samples currently not supported.";
+      status.error="S3I PCM samples currently not supported.";
       logE("S3I PCM samples currently not supported.");
     }
     String insName = reader.readString(28);
@@ -603,11 +604,11 @@ void DivEngine::loadS3I(SafeReader& reader, std::vector<DivInstrument*>& ret, St
     int s3i_signature = reader.readI();
 
     if (s3i_signature != 0x49524353) {
-      addWarning("S3I signature invalid.");
+      status.warn("S3I signature invalid.");
       logW("S3I signature invalid.");
     };
   } catch (EndOfFileException& e) {
-    lastError="premature end of file";
+    status.error="premature end of file";
     logE("premature end of file");
     delete ins;
     return;
@@ -616,7 +617,7 @@ void DivEngine::loadS3I(SafeReader& reader, std::vector<DivInstrument*>& ret, St
   ret.push_back(ins);
 }
 
-void DivEngine::loadSBI(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath) {
+void DivEngine::loadSBI(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath, DivInsLoadStatus& status) {
   std::vector<DivInstrument*> insList; // in case 2x2op
   DivInstrument* ins=new DivInstrument;
   try {
@@ -729,7 +730,7 @@ void DivEngine::loadSBI(SafeReader& reader, std::vector<DivInstrument*>& ret, St
     }
 
   } catch (EndOfFileException& e) {
-    lastError="premature end of file";
+    status.error="premature end of file";
     logE("premature end of file");
     if (ins != NULL) {
       delete ins;
@@ -745,7 +746,7 @@ void DivEngine::loadSBI(SafeReader& reader, std::vector<DivInstrument*>& ret, St
   }
 }
 
-void DivEngine::loadOPLI(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath) {
+void DivEngine::loadOPLI(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath, DivInsLoadStatus& status) {
   std::vector<DivInstrument*> insList; // in case 2x2op
   DivInstrument* ins = new DivInstrument;
 
@@ -833,7 +834,7 @@ void DivEngine::loadOPLI(SafeReader& reader, std::vector<DivInstrument*>& ret, S
       insList.push_back(ins);
     }
   } catch (EndOfFileException& e) {
-    lastError="premature end of file";
+    status.error="premature end of file";
     logE("premature end of file");
     if (ins != NULL) {
       delete ins;
@@ -849,7 +850,7 @@ void DivEngine::loadOPLI(SafeReader& reader, std::vector<DivInstrument*>& ret, S
   }
 }
 
-void DivEngine::loadOPNI(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath) {
+void DivEngine::loadOPNI(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath, DivInsLoadStatus& status) {
   DivInstrument* ins = new DivInstrument;
 
   try {
@@ -908,7 +909,7 @@ void DivEngine::loadOPNI(SafeReader& reader, std::vector<DivInstrument*>& ret, S
       ret.push_back(ins);
     }
   } catch (EndOfFileException& e) {
-    lastError="premature end of file";
+    status.error="premature end of file";
     logE("premature end of file");
     if (ins != NULL) {
       delete ins;
@@ -916,7 +917,7 @@ void DivEngine::loadOPNI(SafeReader& reader, std::vector<DivInstrument*>& ret, S
   }
 }
 
-void DivEngine::loadY12(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath) {  
+void DivEngine::loadY12(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath, DivInsLoadStatus& status) {  
   DivInstrument *ins = new DivInstrument;
 
   try {
@@ -954,7 +955,7 @@ void DivEngine::loadY12(SafeReader& reader, std::vector<DivInstrument*>& ret, St
     }
     ret.push_back(ins);
   } catch (EndOfFileException& e) {
-    lastError="premature end of file";
+    status.error="premature end of file";
     logE("premature end of file");
     if (ins != NULL) {
       delete ins;
@@ -962,7 +963,7 @@ void DivEngine::loadY12(SafeReader& reader, std::vector<DivInstrument*>& ret, St
   }
 }
 
-void DivEngine::loadBNK(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath) {
+void DivEngine::loadBNK(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath, DivInsLoadStatus& status) {
   std::vector<DivInstrument*> insList;
   std::vector<String*> instNames;
   reader.seek(0, SEEK_SET);
@@ -1039,7 +1040,7 @@ void DivEngine::loadBNK(SafeReader& reader, std::vector<DivInstrument*>& ret, St
       reader.seek(0, SEEK_END);
 
     } catch (EndOfFileException& e) {
-      lastError="premature end of file";
+      status.error="premature end of file";
       logE("premature end of file");
       for (int i = 0; i < readCount; ++i) {
         delete insList[i];
@@ -1049,7 +1050,7 @@ void DivEngine::loadBNK(SafeReader& reader, std::vector<DivInstrument*>& ret, St
 
   } else {
     // assume GEMS BNK for now.
-    lastError="GEMS BNK currently not supported.";
+    status.error="GEMS BNK currently not supported.";
     logE("GEMS BNK currently not supported.");
   }
 
@@ -1064,7 +1065,7 @@ void DivEngine::loadBNK(SafeReader& reader, std::vector<DivInstrument*>& ret, St
   }
 }
 
-void DivEngine::loadFF(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath) {
+void DivEngine::loadFF(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath, DivInsLoadStatus& status) {
   DivInstrument* insList[256];
   memset(insList,0,256*sizeof(void*));
   int readCount = 0;
@@ -1122,7 +1123,7 @@ void DivEngine::loadFF(SafeReader& reader, std::vector<DivInstrument*>& ret, Str
       ++readCount;
     }
   } catch (EndOfFileException& e) {
-    lastError="premature end of file";
+    status.error="premature end of file";
     logE("premature end of file");
     // Include incomplete entry in deletion.
     for (int i = readCount; i >= 0; --i) {
@@ -1136,7 +1137,7 @@ void DivEngine::loadFF(SafeReader& reader, std::vector<DivInstrument*>& ret, Str
   }
 }
 
-void DivEngine::loadGYB(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath) {
+void DivEngine::loadGYB(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath, DivInsLoadStatus& status) {
   std::vector<DivInstrument*> insList;
   int readCount = 0;
   bool is_failed = false;
@@ -1263,7 +1264,7 @@ void DivEngine::loadGYB(SafeReader& reader, std::vector<DivInstrument*>& ret, St
         uint32_t mapOffset = reader.readI();
 
         if (bankOffset > fileSize || mapOffset > fileSize) {
-          lastError = "GYBv3 file appears to have invalid data offsets.";
+          status.error = "GYBv3 file appears to have invalid data offsets.";
           logE("GYBv3 file appears to have invalid data offsets.");
         }
 
@@ -1303,12 +1304,12 @@ void DivEngine::loadGYB(SafeReader& reader, std::vector<DivInstrument*>& ret, St
     }
     
   } catch (EndOfFileException& e) {
-    lastError = "premature end of file";
+    status.error = "premature end of file";
     logE("premature end of file");
     is_failed = true;
 
   } catch (std::invalid_argument& e) {
-    lastError = fmt::sprintf("Invalid value found in patch file. %s", e.what());
+    status.error = fmt::sprintf("Invalid value found in patch file. %s", e.what());
     logE("Invalid value found in patch file.");
     logE(e.what());
     is_failed = true;
@@ -1327,7 +1328,7 @@ void DivEngine::loadGYB(SafeReader& reader, std::vector<DivInstrument*>& ret, St
   }
 }
 
-void DivEngine::loadOPM(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath) {
+void DivEngine::loadOPM(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath, DivInsLoadStatus& status) {
   std::vector<DivInstrument*> insList;
 
   int readCount = 0;
@@ -1473,7 +1474,7 @@ void DivEngine::loadOPM(SafeReader& reader, std::vector<DivInstrument*>& ret, St
     }
 
     if (newPatch != NULL) {
-      addWarning("Last OPM patch read was incomplete and therefore not imported.");
+      status.warn("Last OPM patch read was incomplete and therefore not imported.");
       logW("Last OPM patch read was incomplete and therefore not imported.");
       delete newPatch;
       newPatch = NULL;
@@ -1483,11 +1484,11 @@ void DivEngine::loadOPM(SafeReader& reader, std::vector<DivInstrument*>& ret, St
       ret.push_back(insList[i]);
     }
   } catch (EndOfFileException& e) {
-    lastError="premature end of file";
+    status.error="premature end of file";
     logE("premature end of file");
     is_failed = true;
   } catch (std::invalid_argument& e) {
-    lastError=fmt::sprintf("Invalid value found in patch file. %s", e.what());
+    status.error=fmt::sprintf("Invalid value found in patch file. %s", e.what());
     logE("Invalid value found in patch file.");
     logE(e.what());
     is_failed = true;
@@ -1504,7 +1505,7 @@ void DivEngine::loadOPM(SafeReader& reader, std::vector<DivInstrument*>& ret, St
 }
 
 
-void DivEngine::loadWOPL(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath) {
+void DivEngine::loadWOPL(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath, DivInsLoadStatus& status) {
   std::vector<DivInstrument*> insList;
   bool is_failed = false;
 
@@ -1683,7 +1684,7 @@ void DivEngine::loadWOPL(SafeReader& reader, std::vector<DivInstrument*>& ret, S
       }
     }
   } catch (EndOfFileException& e) {
-    lastError = "premature end of file";
+    status.error = "premature end of file";
     logE("premature end of file");
     is_failed = true;
   }
@@ -1706,7 +1707,7 @@ void DivEngine::loadWOPL(SafeReader& reader, std::vector<DivInstrument*>& ret, S
   }
 }
 
-void DivEngine::loadWOPN(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath) {
+void DivEngine::loadWOPN(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath, DivInsLoadStatus& status) {
   std::vector<DivInstrument*> insList;
   bool is_failed = false;
 
@@ -1848,7 +1849,7 @@ void DivEngine::loadWOPN(SafeReader& reader, std::vector<DivInstrument*>& ret, S
       }
     }
   } catch (EndOfFileException& e) {
-    lastError = "premature end of file";
+    status.error = "premature end of file";
     logE("premature end of file");
     is_failed = true;
   }
@@ -1871,67 +1872,113 @@ void DivEngine::loadWOPN(SafeReader& reader, std::vector<DivInstrument*>& ret, S
   }
 }
 
-std::vector<DivInstrument*> DivEngine::instrumentFromFile(const char* path, bool loadAssets, bool readInsName) {
-  std::vector<DivInstrument*> ret;
-  warnings="";
-
-  const char* pathRedux=strrchr(path,DIR_SEPARATOR);
-  if (pathRedux==NULL) {
-    pathRedux=path;
-  } else {
-    pathRedux++;
-  }
-  String stripPath;
-  const char* pathReduxEnd=strrchr(pathRedux,'.');
-  if (pathReduxEnd==NULL) {
-    stripPath=pathRedux;
-  } else {
-    for (const char* i=pathRedux; i!=pathReduxEnd && (*i); i++) {
-      stripPath+=*i;
-    }
-  }
-
+// read a whole instrument file. returns NULL on error.
+static unsigned char* readInsFile(const char* path, size_t& len, String& error) {
   FILE* f=ps_fopen(path,"rb");
   if (f==NULL) {
-    lastError=strerror(errno);
-    return ret;
+    error=strerror(errno);
+    return NULL;
   }
   unsigned char* buf;
-  ssize_t len;
   if (fseek(f,0,SEEK_END)!=0) {
-    lastError=strerror(errno);
+    error=strerror(errno);
     fclose(f);
-    return ret;
+    return NULL;
   }
-  len=ftell(f);
-  if (len<0) {
-    lastError=strerror(errno);
+  ssize_t fileLen=ftell(f);
+  if (fileLen<0) {
+    error=strerror(errno);
     fclose(f);
-    return ret;
+    return NULL;
   }
-  if (len==(SIZE_MAX>>1)) {
-    lastError=strerror(errno);
+  if (fileLen==(SIZE_MAX>>1)) {
+    error=strerror(errno);
     fclose(f);
-    return ret;
+    return NULL;
   }
-  if (len==0) {
-    lastError=strerror(errno);
+  if (fileLen==0) {
+    error=strerror(errno);
     fclose(f);
-    return ret;
+    return NULL;
   }
   if (fseek(f,0,SEEK_SET)!=0) {
-    lastError=strerror(errno);
+    error=strerror(errno);
     fclose(f);
-    return ret;
+    return NULL;
   }
+  len=fileLen;
   buf=new unsigned char[len];
   if (fread(buf,1,len,f)!=(size_t)len) {
     logW("did not read entire instrument file buffer!");
-    lastError="did not read entire instrument file!";
+    error="did not read entire instrument file!";
     delete[] buf;
-    return ret;
+    fclose(f);
+    return NULL;
   }
   fclose(f);
+  return buf;
+}
+
+static bool isFurnaceIns(const unsigned char* buf, size_t len) {
+  if (len>=4 && (memcmp("FINS",buf,4)==0 || memcmp("FINB",buf,4)==0)) return true;
+  if (len>=16 && memcmp("-Furnace instr.-",buf,16)==0) return true;
+  return false;
+}
+
+// instrument data without the name, for finding duplicates.
+static std::vector<unsigned char> insFingerprint(DivInstrument* ins) {
+  SafeWriter w;
+  w.init();
+  ins->putInsData2(&w,false,NULL,false);
+  std::vector<unsigned char> ret(w.getFinalBuf(),w.getFinalBuf()+w.size());
+  w.finish();
+  return ret;
+}
+
+static uint64_t hashFingerprint(const std::vector<unsigned char>& data) {
+  // FNV-1a
+  uint64_t ret=0xcbf29ce484222325ULL;
+  for (unsigned char i: data) {
+    ret^=i;
+    ret*=0x100000001b3ULL;
+  }
+  return ret;
+}
+
+struct DivInsImportTask {
+  DivEngine* e;
+  DivInstrumentImport* result;
+  bool loadAssets, readInsName;
+  // Furnace instruments with assets are kept here and parsed later.
+  unsigned char* buf;
+  size_t len;
+  DivInsImportTask():
+    e(NULL),
+    result(NULL),
+    loadAssets(false),
+    readInsName(false),
+    buf(NULL),
+    len(0) {}
+};
+
+std::vector<DivInstrument*> DivEngine::instrumentFromData(unsigned char* buf, size_t len, const char* path, DivSong* song, bool readInsName, DivInsLoadStatus& status) {
+  std::vector<DivInstrument*> ret;
+
+  const char* pathRedux=strrchr(path,DIR_SEPARATOR);
+  if (pathRedux==NULL) {
+    pathRedux=path;
+  } else {
+    pathRedux++;
+  }
+  String stripPath;
+  const char* pathReduxEnd=strrchr(pathRedux,'.');
+  if (pathReduxEnd==NULL) {
+    stripPath=pathRedux;
+  } else {
+    for (const char* i=pathRedux; i!=pathReduxEnd && (*i); i++) {
+      stripPath+=*i;
+    }
+  }
 
   SafeReader reader=SafeReader(buf,len);
 
@@ -1968,7 +2015,7 @@ std::vector<DivInstrument*> DivEngine::instrumentFromFile(const char* path, bool
       }
 
       if (version>DIV_ENGINE_VERSION) {
-        warnings="this instrument is made with a more recent version of Furnace!";
+        status.warn("this instrument is made with a more recent version of Furnace!");
       }
 
       if (isOldFurnaceIns) {
@@ -1978,10 +2025,9 @@ std::vector<DivInstrument*> DivEngine::instrumentFromFile(const char* path, bool
 
       ins->name=stripPath;
 
-      if (ins->readInsData(reader,version,loadAssets?(&song):NULL)!=DIV_DATA_SUCCESS) {
-        lastError="invalid instrument header/data!";
+      if (ins->readInsData(reader,version,song)!=DIV_DATA_SUCCESS) {
+        status.error="invalid instrument header/data!";
         delete ins;
-        delete[] buf;
         return ret;
       } else {
         if (!readInsName) {
@@ -1990,10 +2036,9 @@ std::vector<DivInstrument*> DivEngine::instrumentFromFile(const char* path, bool
         ret.push_back(ins);
       }
     } catch (EndOfFileException& e) {
-      lastError="premature end of file";
+      status.error="premature end of file";
       logE("premature end of file");
       delete ins;
-      delete[] buf;
       return ret;
     }
   } else { // read as a different format
@@ -2044,71 +2089,168 @@ std::vector<DivInstrument*> DivEngine::instrumentFromFile(const char* path, bool
         format=DIV_INSFORMAT_WOPN;
       } else {
         // unknown format
-        lastError="unknown instrument format";
-        delete[] buf;
+        status.error="unknown instrument format";
         return ret;
       }
     }
 
     switch (format) {
       case DIV_INSFORMAT_DMP:
-        loadDMP(reader,ret,stripPath);
+        loadDMP(reader,ret,stripPath,status);
         break;
       case DIV_INSFORMAT_TFI:
-        loadTFI(reader,ret,stripPath);
+        loadTFI(reader,ret,stripPath,status);
         break;
       case DIV_INSFORMAT_VGI:
-        loadVGI(reader,ret,stripPath);
+        loadVGI(reader,ret,stripPath,status);
         break;
       case DIV_INSFORMAT_EIF:
-        loadEIF(reader,ret,stripPath);
+        loadEIF(reader,ret,stripPath,status);
         break;
       case DIV_INSFORMAT_FTI: // TODO
         break;
       case DIV_INSFORMAT_BTI: // TODO
         break;
       case DIV_INSFORMAT_S3I:
-        loadS3I(reader,ret,stripPath);
+        loadS3I(reader,ret,stripPath,status);
         break;
       case DIV_INSFORMAT_SBI:
-        loadSBI(reader,ret,stripPath);
+        loadSBI(reader,ret,stripPath,status);
         break;
       case DIV_INSFORMAT_OPLI:
-        loadOPLI(reader,ret,stripPath);
+        loadOPLI(reader,ret,stripPath,status);
         break;
       case DIV_INSFORMAT_OPNI:
-        loadOPNI(reader,ret,stripPath);
+        loadOPNI(reader,ret,stripPath,status);
         break;
       case DIV_INSFORMAT_Y12:
-        loadY12(reader,ret,stripPath);
+        loadY12(reader,ret,stripPath,status);
         break;
       case DIV_INSFORMAT_BNK:
-        loadBNK(reader,ret,stripPath);
+        loadBNK(reader,ret,stripPath,status);
         break;
       case DIV_INSFORMAT_FF:
-        loadFF(reader,ret,stripPath);
+        loadFF(reader,ret,stripPath,status);
         break;
       case DIV_INSFORMAT_GYB:
-        loadGYB(reader,ret,stripPath);
+        loadGYB(reader,ret,stripPath,status);
         break;
       case DIV_INSFORMAT_OPM:
-        loadOPM(reader,ret,stripPath);
+        loadOPM(reader,ret,stripPath,status);
         break;
       case DIV_INSFORMAT_WOPL:
-        loadWOPL(reader,ret,stripPath);
+        loadWOPL(reader,ret,stripPath,status);
         break;
       case DIV_INSFORMAT_WOPN:
-        loadWOPN(reader,ret,stripPath);
+        loadWOPN(reader,ret,stripPath,status);
         break;
     }
 
     if (reader.tell()<reader.size()) {
-      addWarning("https://github.com/tildearrow/furnace/issues/84");
-      addWarning("there is more data at the end of the file! what happened here!");
-      addWarning(fmt::sprintf("exactly %d bytes, if you are curious",reader.size()-reader.tell()));
+      status.warn("https://github.com/tildearrow/furnace/issues/84");
+      status.warn("there is more data at the end of the file! what happened here!");
+      status.warn(fmt::sprintf("exactly %d bytes, if you are curious",reader.size()-reader.tell()));
     }
   }
 
+  return ret;
+}
+
+std::vector<DivInstrument*> DivEngine::instrumentFromFile(const char* path, bool loadAssets, bool readInsName) {
+  std::vector<DivInstrument*> ret;
+  warnings="";
+
+  size_t len=0;
+  unsigned char* buf=readInsFile(path,len,lastError);
+  if (buf==NULL) return ret;
+
+  DivInsLoadStatus status;
+  ret=instrumentFromData(buf,len,path,loadAssets?(&song):NULL,readInsName,status);
   delete[] buf; // since we're done with this buffer
+
+  if (!status.error.empty()) lastError=status.error;
+  warnings=status.warnings;
+  return ret;
+}
+
+std::vector<DivInstrumentImport> DivEngine::instrumentsFromFiles(const std::vector<String>& paths, bool loadAssets, bool readInsName, bool dedupe) {
+  std::vector<DivInstrumentImport> ret(paths.size());
+  std::vector<DivInsImportTask> tasks(paths.size());
+  for (size_t i=0; i<paths.size(); i++) {
+    ret[i].path=paths[i];
+    tasks[i].e=this;
+    tasks[i].result=&ret[i];
+    tasks[i].loadAssets=loadAssets;
+    tasks[i].readInsName=readInsName;
+  }
+
+  // read and parse files in parallel
+  auto importTask=[](void* arg) {
+    DivInsImportTask* task=(DivInsImportTask*)arg;
+    DivInstrumentImport* result=task->result;
+    size_t len=0;
+    unsigned char* buf=readInsFile(result->path.c_str(),len,result->status.error);
+    if (buf==NULL) return;
+    if (task->loadAssets && isFurnaceIns(buf,len)) {
+      task->buf=buf;
+      task->len=len;
+      return;
+    }
+    result->ins=task->e->instrumentFromData(buf,len,result->path.c_str(),NULL,task->readInsName,result->status);
+    delete[] buf;
+  };
+
+  unsigned int threads=std::thread::hardware_concurrency();
+  if (threads>tasks.size()) threads=tasks.size();
+  if (threads>1) {
+    DivWorkPool* pool=new DivWorkPool(threads-1);
+    pool->pushBatch(importTask,tasks.data(),tasks.size());
+    pool->wait();
+    delete pool;
+  } else {
+    for (DivInsImportTask& i: tasks) {
+      importTask(&i);
+    }
+  }
+
+  // Furnace instruments may carry wavetables and samples, which go into the song
+  for (DivInsImportTask& i: tasks) {
+    if (i.buf==NULL) continue;
+    i.result->ins=instrumentFromData(i.buf,i.len,i.result->path.c_str(),&song,readInsName,i.result->status);
+    delete[] i.buf;
+    i.buf=NULL;
+  }
+
+  if (dedupe) {
+    std::unordered_map<uint64_t,std::vector<std::vector<unsigned char>>> seen;
+    for (DivInstrument* i: song.ins) {
+      std::vector<unsigned char> data=insFingerprint(i);
+      uint64_t hash=hashFingerprint(data);
+      seen[hash].push_back(std::move(data));
+    }
+    for (DivInstrumentImport& i: ret) {
+      std::vector<DivInstrument*> kept;
+      for (DivInstrument* j: i.ins) {
+        std::vector<unsigned char> data=insFingerprint(j);
+        std::vector<std::vector<unsigned char>>& bucket=seen[hashFingerprint(data)];
+        bool found=false;
+        for (std::vector<unsigned char>& k: bucket) {
+          if (k==data) {
+            found=true;
+            break;
+          }
+        }
+        if (found) {
+          delete j;
+          i.duplicates++;
+        } else {
+          kept.push_back(j);
+          bucket.push_back(std::move(data));
+        }
+      }
+      i.ins=kept;
+    }
+  }
+
   return ret;
 }
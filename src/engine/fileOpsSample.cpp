@@ -24,6 +24,9 @@
 #include "sfWrapper.h"
 #endif
 
+// number of frames read from a sample file at once
+#define SAMPLE_IMPORT_CHUNK 65536
+
 std::vector<DivSample*> DivEngine::sampleFromFile(const char* path) {
   std::vector<DivSample*> ret;
 
@@ -301,101 +304,112 @@ std::vector<DivSample*> DivEngine::sampleFromFile(const char* path) {
     BUSY_END;
     return ret;
   }
-  void* buf=NULL;
-  sf_count_t sampleLen=sizeof(short);
-  if ((si.format&SF_FORMAT_SUBMASK)==SF_FORMAT_PCM_U8) {
-    logD("sample is 8-bit unsigned");
-    buf=new unsigned char[si.channels*si.frames];
-    sampleLen=sizeof(unsigned char);
-  } else if ((si.format&SF_FORMAT_SUBMASK)==SF_FORMAT_FLOAT) {
-    logD("sample is 32-bit float");
-    buf=new float[si.channels*si.frames];
-    sampleLen=sizeof(float);
-  } else if ((si.format&SF_FORMAT_SUBMASK)==SF_FORMAT_DOUBLE) {
-    logD("sample is 64-bit float");
-    buf=new double[si.channels*si.frames];
-    sampleLen=sizeof(double);
-  } else if ((si.format&SF_FORMAT_SUBMASK)==SF_FORMAT_PCM_16) {
-    logD("sample is 16-bit signed");
-    buf=new short[si.channels*si.frames];
-    sampleLen=sizeof(short);
-  } else {
-    logD("sample is in a different format - reading as floats");
-    buf=new float[si.channels*si.frames];
-    sampleLen=sizeof(float);
-  }
-  if ((si.format&SF_FORMAT_SUBMASK)==SF_FORMAT_PCM_U8 ||
-      (si.format&SF_FORMAT_SUBMASK)==SF_FORMAT_FLOAT ||
-      (si.format&SF_FORMAT_SUBMASK)==SF_FORMAT_DOUBLE) {
-    if (sf_read_raw(f,buf,si.frames*si.channels*sampleLen)!=(si.frames*si.channels*sampleLen)) {
-      logW("sample read size mismatch!");
-    }
-  } else if ((si.format&SF_FORMAT_SUBMASK)==SF_FORMAT_PCM_16) {
-    if (sf_read_short(f,(short*)buf,si.frames*si.channels)!=(si.frames*si.channels)) {
-      logW("sample read size mismatch!");
-    }
-  } else {
-    if (sf_read_float(f,(float*)buf,si.frames*si.channels)!=(si.frames*si.channels)) {
-      logW("sample read size mismatch!");
-    }
-  }
   DivSample* sample=new DivSample;
   int sampleCount=(int)song.sample.size();
   sample->name=stripPath;
 
-  int index=0;
-  if ((si.format&SF_FORMAT_SUBMASK)==SF_FORMAT_PCM_U8) {
+  int subFormat=si.format&SF_FORMAT_SUBMASK;
+  if (subFormat==SF_FORMAT_PCM_U8) {
     sample->depth=DIV_SAMPLE_DEPTH_8BIT;
   } else {
     sample->depth=DIV_SAMPLE_DEPTH_16BIT;
   }
   sample->init(si.frames);
-  if ((si.format&SF_FORMAT_SUBMASK)==SF_FORMAT_PCM_U8) {
-    for (int i=0; i<si.frames*si.channels; i+=si.channels) {
-      int averaged=0;
-      for (int j=0; j<si.channels; j++) {
-        averaged+=((int)((unsigned char*)buf)[i+j])-128;
-      }
-      averaged/=si.channels;
-      sample->data8[index++]=averaged;
+
+  // read and convert in chunks directly into the sample, so that the file
+  // is never held in memory twice.
+  int index=0;
+  sf_count_t framesLeft=si.frames;
+  if (subFormat==SF_FORMAT_PCM_U8) {
+    logD("sample is 8-bit unsigned");
+    unsigned char* buf=new unsigned char[SAMPLE_IMPORT_CHUNK*si.channels];
+    while (framesLeft>0) {
+      sf_count_t frames=MIN(framesLeft,SAMPLE_IMPORT_CHUNK);
+      sf_count_t got=sf_read_raw(f,buf,frames*si.channels)/si.channels;
+      for (sf_count_t i=0; i<got*si.channels; i+=si.channels) {
+        int averaged=0;
+        for (int j=0; j<si.channels; j++) {
+          averaged+=((int)buf[i+j])-128;
+        }
+        averaged/=si.channels;
+        sample->data8[index++]=averaged;
+      }
+      framesLeft-=got;
+      if (got<frames) break;
     }
-    delete[] (unsigned char*)buf;
-  } else if ((si.format&SF_FORMAT_SUBMASK)==SF_FORMAT_DOUBLE) {
-    for (int i=0; i<si.frames*si.channels; i+=si.channels) {
-      double averaged=0.0f;
-      for (int j=0; j<si.channels; j++) {
-        averaged+=((double*)buf)[i+j];
-      }
-      averaged/=si.channels;
-      averaged*=32767.0;
-      if (averaged<-32768.0) averaged=-32768.0;
-      if (averaged>32767.0) averaged=32767.0;
-      sample->data16[index++]=averaged;
+    delete[] buf;
+  } else if (subFormat==SF_FORMAT_DOUBLE) {
+    logD("sample is 64-bit float");
+    double* buf=new double[SAMPLE_IMPORT_CHUNK*si.channels];
+    while (framesLeft>0) {
+      sf_count_t frames=MIN(framesLeft,SAMPLE_IMPORT_CHUNK);
+      sf_count_t got=sf_read_raw(f,buf,frames*si.channels*sizeof(double))/(si.channels*sizeof(double));
+      for (sf_count_t i=0; i<got*si.channels; i+=si.channels) {
+        double averaged=0.0f;
+        for (int j=0; j<si.channels; j++) {
+          averaged+=buf[i+j];
+        }
+        averaged/=si.channels;
+        averaged*=32767.0;
+        if (averaged<-32768.0) averaged=-32768.0;
+        if (averaged>32767.0) averaged=32767.0;
+        sample->data16[index++]=averaged;
+      }
+      framesLeft-=got;
+      if (got<frames) break;
     }
-    delete[] (double*)buf;
-  } else if ((si.format&SF_FORMAT_SUBMASK)==SF_FORMAT_PCM_16) {
-    for (int i=0; i<si.frames*si.channels; i+=si.channels) {
-      int averaged=0;
-      for (int j=0; j<si.channels; j++) {
-        averaged+=((short*)buf)[i+j];
-      }
-      averaged/=si.channels;
-      sample->data16[index++]=averaged;
+    delete[] buf;
+  } else if (subFormat==SF_FORMAT_PCM_16) {
+    logD("sample is 16-bit signed");
+    short* buf=new short[SAMPLE_IMPORT_CHUNK*si.channels];
+    while (framesLeft>0) {
+      sf_count_t frames=MIN(framesLeft,SAMPLE_IMPORT_CHUNK);
+      sf_count_t got=sf_read_short(f,buf,frames*si.channels)/si.channels;
+      for (sf_count_t i=0; i<got*si.channels; i+=si.channels) {
+        int averaged=0;
+        for (int j=0; j<si.channels; j++) {
+          averaged+=buf[i+j];
+        }
+        averaged/=si.channels;
+        sample->data16[index++]=averaged;
+      }
+      framesLeft-=got;
+      if (got<frames) break;
     }
-    delete[] (short*)buf;
+    delete[] buf;
   } else {
-    for (int i=0; i<si.frames*si.channels; i+=si.channels) {
-      float averaged=0.0f;
-      for (int j=0; j<si.channels; j++) {
-        averaged+=((float*)buf)[i+j];
-      }
-      averaged/=si.channels;
-      averaged*=32767.0;
-      if (averaged<-32768.0) averaged=-32768.0;
-      if (averaged>32767.0) averaged=32767.0;
-      sample->data16[index++]=averaged;
+    if (subFormat==SF_FORMAT_FLOAT) {
+      logD("sample is 32-bit float");
+    } else {
+      logD("sample is in a different format - reading as floats");
+    }
+    float* buf=new float[SAMPLE_IMPORT_CHUNK*si.channels];
+    while (framesLeft>0) {
+      sf_count_t frames=MIN(framesLeft,SAMPLE_IMPORT_CHUNK);
+      sf_count_t got;
+      if (subFormat==SF_FORMAT_FLOAT) {
+        got=sf_read_raw(f,buf,frames*si.channels*sizeof(float))/(si.channels*sizeof(float));
+      } else {
+        got=sf_read_float(f,buf,frames*si.channels)/si.channels;
+      }
+      for (sf_count_t i=0; i<got*si.channels; i+=si.channels) {
+        float averaged=0.0f;
+        for (int j=0; j<si.channels; j++) {
+          averaged+=buf[i+j];
+        }
+        averaged/=si.channels;
+        averaged*=32767.0;
+        if (averaged<-32768.0) averaged=-32768.0;
+        if (averaged>32767.0) averaged=32767.0;
+        sample->data16[index++]=averaged;
+      }
+      framesLeft-=got;
+      if (got<frames) break;
     }
-    delete[] (float*)buf;
+    delete[] buf;
+  }
+  if (framesLeft>0) {
+    logW("sample read size mismatch!");
   }
 
   sample->centerRate=si.samplerate;
@@ -20,14 +20,25 @@
 #include "filePlayer.h"
 #include "filter.h"
 #include "../ta-log.h"
+#include "../fileutils.h"
 #include <inttypes.h>
+#include <errno.h>
 #include <chrono>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 #define DIV_FPCACHE_BLOCK_SHIFT 15
 #define DIV_FPCACHE_BLOCK_SIZE (1<<DIV_FPCACHE_BLOCK_SHIFT)
 #define DIV_FPCACHE_BLOCK_MASK (DIV_FPCACHE_BLOCK_SIZE-1)
 
 #define DIV_FPCACHE_BLOCKS_FROM_FILL 3
+// blocks read ahead for each cue point
+#define DIV_FPCACHE_BLOCKS_FROM_CUE 1
+#define DIV_FPCACHE_MAX_CUES 8
 #define DIV_FPCACHE_DISCARD_SIZE 4096
 
 // 5MB should be enough
@@ -35,7 +46,7 @@
 
 #define DIV_NO_BLOCK (-10)
 
-void DivFilePlayer::fillBlocksNear(ssize_t pos) {
+void DivFilePlayer::fillBlocksNear(ssize_t pos, int count) {
   logV("DivFilePlayer: fillBlocksNear(%" PRIu64 ")",pos);
 
   // don't if file isn't present
@@ -49,7 +60,7 @@ void DivFilePlayer::fillBlocksNear(ssize_t pos) {
   if (!si.seekable) return;
 
   ssize_t firstBlock=pos>>DIV_FPCACHE_BLOCK_SHIFT;
-  ssize_t lastBlock=firstBlock+DIV_FPCACHE_BLOCKS_FROM_FILL;
+  ssize_t lastBlock=firstBlock+count;
   if (firstBlock<0) firstBlock=0;
   if (firstBlock>=(ssize_t)numBlocks) firstBlock=numBlocks-1;
   if (lastBlock<0) lastBlock=0;
@@ -168,26 +179,178 @@ void DivFilePlayer::runCacheThread() {
     if (wantBlockC!=DIV_NO_BLOCK) {
       wantBlock=DIV_NO_BLOCK;
       logV("thread fill %" PRIu64,wantBlockC);
-      fillBlocksNear(wantBlockC);
+      fillBlocksNear(wantBlockC,DIV_FPCACHE_BLOCKS_FROM_FILL);
       collectGarbage(wantBlockC);
     }
-    cacheCV.wait(lock);
+
+    // read ahead around the cue points (the playback position comes first)
+    std::vector<ssize_t> cues;
+    cacheMutex.lock();
+    cues.swap(pendingCues);
+    cacheMutex.unlock();
+    for (size_t i=0; i<cues.size(); i++) {
+      if (wantBlock!=DIV_NO_BLOCK) {
+        // do the rest later
+        cacheMutex.lock();
+        if (pendingCues.empty()) pendingCues.assign(cues.begin()+i,cues.end());
+        cacheMutex.unlock();
+        break;
+      }
+      fillBlocksNear(cues[i],DIV_FPCACHE_BLOCKS_FROM_CUE);
+    }
+
+    if (wantBlock==DIV_NO_BLOCK) cacheCV.wait(lock);
   }
 
   threadHasQuit=true;
   logV("DivFilePlayer: cache thread over.");
 }
 
-float DivFilePlayer::getSampleAt(ssize_t pos, int ch) {
-  if (blocks==NULL) return 0.0f;
-  ssize_t blockIndex=pos>>DIV_FPCACHE_BLOCK_SHIFT;
-  if (blockIndex<0 || blockIndex>=(ssize_t)numBlocks) return 0.0f;
+bool DivFilePlayer::mapFile(const char* path) {
+#if defined(_WIN32) || defined(TA_BIG_ENDIAN)
+  return false;
+#else
+  if (!si.seekable) return false;
+  if ((si.format&SF_FORMAT_TYPEMASK)!=SF_FORMAT_WAV) return false;
+  int depth=0;
+  switch (si.format&SF_FORMAT_SUBMASK) {
+    case SF_FORMAT_PCM_16:
+      depth=2;
+      break;
+    case SF_FORMAT_PCM_24:
+      depth=3;
+      break;
+    case SF_FORMAT_FLOAT:
+      depth=4;
+      break;
+    default:
+      return false;
+  }
+
+  int fd=open(path,O_RDONLY);
+  if (fd<0) return false;
+  struct stat st;
+  if (fstat(fd,&st)!=0 || st.st_size<12) {
+    close(fd);
+    return false;
+  }
+  void* m=mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+  close(fd);
+  if (m==MAP_FAILED) {
+    logW("DivFilePlayer: could not map file (%s)",strerror(errno));
+    return false;
+  }
+  mapped=(unsigned char*)m;
+  mappedLen=st.st_size;
+
+  // find the data chunk
+  if (memcmp(mapped,"RIFF",4)!=0 || memcmp(&mapped[8],"WAVE",4)!=0) {
+    unmapFile();
+    return false;
+  }
+  size_t pos=12;
+  while (pos+8<=mappedLen) {
+    size_t chunkLen=mapped[pos+4]|(mapped[pos+5]<<8)|(mapped[pos+6]<<16)|((size_t)mapped[pos+7]<<24);
+    if (memcmp(&mapped[pos],"data",4)==0) {
+      size_t needed=(size_t)si.frames*si.channels*depth;
+      if (pos+8+needed>mappedLen || chunkLen<needed) break;
+      mappedData=&mapped[pos+8];
+      mappedDepth=depth;
+      madvise(mapped,mappedLen,MADV_SEQUENTIAL);
+      logV("DivFilePlayer: mapped file (data at %d)",(int)(pos+8));
+      return true;
+    }
+    // chunks are padded to 2 bytes
+    pos+=8+chunkLen+(chunkLen&1);
+  }
+
+  unmapFile();
+  return false;
+#endif
+}
+
+void DivFilePlayer::unmapFile() {
+#ifndef _WIN32
+  if (mapped!=NULL) munmap(mapped,mappedLen);
+#endif
+  mapped=NULL;
+  mappedLen=0;
+  mappedData=NULL;
+  mappedDepth=0;
+}
 
-  float* block=blocks[blockIndex];
-  size_t posInBlock=(pos&DIV_FPCACHE_BLOCK_MASK)*si.channels+ch;
-  if (block==NULL) return 0.0f;
+void DivFilePlayer::fetch(ssize_t pos, size_t len, int chans) {
+  if (windowLen<len) {
+    for (int j=0; j<si.channels; j++) {
+      delete[] window[j];
+      window[j]=new float[len];
+    }
+    windowLen=len;
+  }
 
-  return block[posInBlock];
+  size_t i=0;
+  while (i<len) {
+    ssize_t p=pos+i;
+    // silence outside of the file, or where there isn't a block (yet)
+    size_t run=len-i;
+    if (p<0) {
+      if ((size_t)(-p)<run) run=-p;
+    } else if (p>=(ssize_t)si.frames) {
+      // until the end
+    } else if (mappedData!=NULL) {
+      if (run>(size_t)(si.frames-p)) run=si.frames-p;
+      const unsigned char* src=&mappedData[(size_t)p*si.channels*mappedDepth];
+      for (int j=0; j<chans; j++) {
+        float* dest=&window[j][i];
+        switch (mappedDepth) {
+          case 2: {
+            const short* s16=((const short*)src)+j;
+            for (size_t k=0; k<run; k++) {
+              dest[k]=(float)s16[k*si.channels]/32768.0f;
+            }
+            break;
+          }
+          case 3: {
+            const unsigned char* s24=src+j*3;
+            for (size_t k=0; k<run; k++) {
+              const unsigned char* x=&s24[k*si.channels*3];
+              dest[k]=(float)((int)((x[0]<<8)|(x[1]<<16)|((unsigned int)x[2]<<24))>>8)/8388608.0f;
+            }
+            break;
+          }
+          case 4: {
+            const float* f32=((const float*)src)+j;
+            for (size_t k=0; k<run; k++) {
+              dest[k]=f32[k*si.channels];
+            }
+            break;
+          }
+        }
+      }
+      i+=run;
+      continue;
+    } else if (blocks!=NULL) {
+      size_t inBlock=DIV_FPCACHE_BLOCK_SIZE-(p&DIV_FPCACHE_BLOCK_MASK);
+      if (run>inBlock) run=inBlock;
+      if (run>(size_t)(si.frames-p)) run=si.frames-p;
+      float* block=blocks[p>>DIV_FPCACHE_BLOCK_SHIFT];
+      if (block!=NULL) {
+        const float* src=&block[(p&DIV_FPCACHE_BLOCK_MASK)*si.channels];
+        for (int j=0; j<chans; j++) {
+          float* dest=&window[j][i];
+          for (size_t k=0; k<run; k++) {
+            dest[k]=src[k*si.channels+j];
+          }
+        }
+        i+=run;
+        continue;
+      }
+    }
+    for (int j=0; j<chans; j++) {
+      memset(&window[j][i],0,run*sizeof(float));
+    }
+    i+=run;
+  }
 }
 
 void DivFilePlayer::mix(float** buf, int chans, unsigned int size) {
@@ -207,7 +370,13 @@ void DivFilePlayer::mix(float** buf, int chans, unsigned int size) {
     cacheCV.notify_one();
   }
 
-  for (unsigned int i=0; i<size; i++) {
+  // only resample the channels which are present in both
+  int inChans=MIN(chans,si.channels);
+  // mono optimization
+  if (si.channels==1) inChans=1;
+
+  unsigned int i=0;
+  while (i<size) {
     // acknowledge pending events
     if (pendingPosOffset==i) {
       pendingPosOffset=UINT_MAX;
@@ -215,66 +384,56 @@ void DivFilePlayer::mix(float** buf, int chans, unsigned int size) {
       rateAccum=0;
     }
     if (pendingPlayOffset==i) {
+      pendingPlayOffset=UINT_MAX;
       playing=true;
     }
     if (pendingStopOffset==i) {
+      pendingStopOffset=UINT_MAX;
       playing=false;
     }
 
-    ssize_t blockIndex=playPos>>DIV_FPCACHE_BLOCK_SHIFT;
-    if (blockIndex!=lastWantBlock) {
-      wantBlock=playPos;
-      cacheCV.notify_one();
-      lastWantBlock=blockIndex;
+    // render until the next event
+    unsigned int runEnd=size;
+    if (pendingPosOffset>i && pendingPosOffset<runEnd) runEnd=pendingPosOffset;
+    if (pendingPlayOffset>i && pendingPlayOffset<runEnd) runEnd=pendingPlayOffset;
+    if (pendingStopOffset>i && pendingStopOffset<runEnd) runEnd=pendingStopOffset;
+    unsigned int runLen=runEnd-i;
+
+    if (!playing) {
+      for (int j=0; j<chans; j++) {
+        memset(&buf[j][i],0,runLen*sizeof(float));
+      }
+      i=runEnd;
+      continue;
+    }
+
+    // ask the cache thread for the blocks of this run
+    ssize_t lastPos=playPos+(ssize_t)(((int64_t)rateAccum+(int64_t)runLen*si.samplerate)/outRate);
+    if (blocks!=NULL) {
+      ssize_t blockIndex=lastPos>>DIV_FPCACHE_BLOCK_SHIFT;
+      if ((playPos>>DIV_FPCACHE_BLOCK_SHIFT)!=lastWantBlock || blockIndex!=lastWantBlock) {
+        wantBlock=playPos;
+        cacheCV.notify_one();
+        lastWantBlock=blockIndex;
+      }
     }
 
-    if (playing) {
-      // sinc interpolation
-      float x[8];
+    // sinc interpolation (8 taps, from playPos-3 to playPos+4)
+    ssize_t windowStart=playPos-3;
+    fetch(windowStart,lastPos-playPos+9,inChans);
 
+    for (unsigned int k=i; k<runEnd; k++) {
       unsigned int n=(8192*rateAccum)/outRate;
       n&=8191;
-      float* t1=&sincTable[(8191-n)<<2];
-      float* t2=&sincTable[n<<2];
-      if (si.channels==1) {
-        // mono optimization
-        for (int k=0; k<8; k++) {
-          x[k]=getSampleAt(playPos+k-3,0);
-        }
-
-        float s=(
-          x[0]*t2[3]+
-          x[1]*t2[2]+
-          x[2]*t2[1]+
-          x[3]*t2[0]+
-          x[4]*t1[0]+
-          x[5]*t1[1]+
-          x[6]*t1[2]+
-          x[7]*t1[3]
-        )*actualVolume;
-
-        for (int j=0; j<chans; j++) {
-          buf[j][i]=s;
-        }
-      } else for (int j=0; j<chans; j++) {
-        if (j>=si.channels) {
-          buf[j][i]=0.0f;
-          continue;
+      const float* t=&sincKernel[n<<3];
+      size_t off=playPos-3-windowStart;
+      for (int j=0; j<inChans; j++) {
+        const float* x=&window[j][off];
+        float s=0.0f;
+        for (int l=0; l<8; l++) {
+          s+=x[l]*t[l];
         }
-
-        for (int k=0; k<8; k++) {
-          x[k]=getSampleAt(playPos+k-3,j);
-        }
-        buf[j][i]=(
-          x[0]*t2[3]+
-          x[1]*t2[2]+
-          x[2]*t2[1]+
-          x[3]*t2[0]+
-          x[4]*t1[0]+
-          x[5]*t1[1]+
-          x[6]*t1[2]+
-          x[7]*t1[3]
-        )*actualVolume;
+        buf[j][k]=s*actualVolume;
       }
 
       // advance
@@ -282,15 +441,18 @@ void DivFilePlayer::mix(float** buf, int chans, unsigned int size) {
       while (rateAccum>=outRate) {
         rateAccum-=outRate;
         playPos++;
-        /*if (playPos>=(ssize_t)si.frames) {
-          playPos=0;
-        }*/
       }
-    } else {
-      for (int j=0; j<chans; j++) {
-        buf[j][i]=0.0f;
+    }
+
+    // the other outputs
+    for (int j=inChans; j<chans; j++) {
+      if (si.channels==1) {
+        memcpy(&buf[j][i],&buf[0][i],runLen*sizeof(float));
+      } else {
+        memset(&buf[j][i],0,runLen*sizeof(float));
       }
     }
+    i=runEnd;
   }
 }
 
@@ -353,6 +515,7 @@ size_t DivFilePlayer::getMemUsage() {
 }
 
 bool DivFilePlayer::isBlockPresent(ssize_t pos) {
+  if (mappedData!=NULL) return (pos>=0 && pos<(ssize_t)si.frames);
   if (blocks==NULL) return false;
   ssize_t which=pos>>DIV_FPCACHE_BLOCK_SHIFT;
   if (which<0 || which>=(ssize_t)numBlocks) return false;
@@ -367,6 +530,33 @@ bool DivFilePlayer::setBlockPriority(ssize_t pos, bool priority) {
   return priority;
 }
 
+void DivFilePlayer::setCuePoints(const std::vector<TimeMicros>& points) {
+  // mapped files don't need any of this
+  if (blocks==NULL || !si.seekable || si.samplerate<1) return;
+
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  // forget the previous cue points (except the start of the file)
+  for (size_t i=DIV_FPCACHE_BLOCKS_FROM_FILL; i<numBlocks; i++) {
+    priorityBlock[i]=false;
+  }
+  pendingCues.clear();
+  for (const TimeMicros& i: points) {
+    if (pendingCues.size()>=DIV_FPCACHE_MAX_CUES) break;
+    if (i.seconds<0) continue;
+    ssize_t pos=(ssize_t)i.seconds*(ssize_t)si.samplerate+(ssize_t)(((double)si.samplerate*i.micros)/1000000.0);
+    if (pos>=(ssize_t)si.frames) continue;
+    for (ssize_t j=pos>>DIV_FPCACHE_BLOCK_SHIFT; j<=(pos>>DIV_FPCACHE_BLOCK_SHIFT)+DIV_FPCACHE_BLOCKS_FROM_CUE; j++) {
+      if (j>=0 && j<(ssize_t)numBlocks) priorityBlock[j]=true;
+    }
+    pendingCues.push_back(pos);
+  }
+  cacheCV.notify_one();
+}
+
+bool DivFilePlayer::isMapped() {
+  return (mappedData!=NULL);
+}
+
 bool DivFilePlayer::isLoaded() {
   return (sf!=NULL);
 }
@@ -418,16 +608,33 @@ bool DivFilePlayer::closeFile() {
   playing=false;
   quitThread=false;
   threadHasQuit=false;
+  unmapFile();
 
-  for (size_t i=0; i<numBlocks; i++) {
-    if (blocks[i]) {
-      delete[] blocks[i];
-      blocks[i]=NULL;
+  if (blocks!=NULL) {
+    for (size_t i=0; i<numBlocks; i++) {
+      if (blocks[i]) {
+        delete[] blocks[i];
+        blocks[i]=NULL;
+      }
     }
+    delete[] blocks;
+    blocks=NULL;
+  }
+  if (priorityBlock!=NULL) {
+    delete[] priorityBlock;
+    priorityBlock=NULL;
   }
   numBlocks=0;
-  delete[] blocks;
-  blocks=NULL;
+  pendingCues.clear();
+
+  if (window!=NULL) {
+    for (int i=0; i<si.channels; i++) {
+      delete[] window[i];
+    }
+    delete[] window;
+    window=NULL;
+  }
+  windowLen=0;
 
   delete[] discardBuf;
   discardBuf=NULL;
@@ -449,6 +656,20 @@ bool DivFilePlayer::loadFile(const char* path) {
   logV("- channels: %d",si.channels);
   logV("- rate: %d",si.samplerate);
 
+  window=new float*[si.channels];
+  memset(window,0,si.channels*sizeof(float*));
+  windowLen=0;
+
+  playPos=0;
+  lastWantBlock=DIV_NO_BLOCK;
+  rateAccum=0;
+  fileError=false;
+
+  // read uncompressed files directly
+  if (mapFile(path)) {
+    return true;
+  }
+
   numBlocks=(DIV_FPCACHE_BLOCK_MASK+si.frames)>>DIV_FPCACHE_BLOCK_SHIFT;
   blocks=new float*[numBlocks];
   priorityBlock=new bool[numBlocks];
@@ -461,11 +682,6 @@ bool DivFilePlayer::loadFile(const char* path) {
     priorityBlock[i]=true;
   }
 
-  playPos=0;
-  lastWantBlock=DIV_NO_BLOCK;
-  rateAccum=0;
-  fileError=false;
-
   // read the entire file if not seekable
   if (!si.seekable) {
     logV("file not seekable - reading...");
@@ -482,7 +698,7 @@ bool DivFilePlayer::loadFile(const char* path) {
   } else {
     logV("file is seekable");
     // read the first couple blocks
-    fillBlocksNear(0);
+    fillBlocksNear(0,DIV_FPCACHE_BLOCKS_FROM_FILL);
   }
 
   discardBuf=new float[DIV_FPCACHE_DISCARD_SIZE*si.channels];
@@ -530,6 +746,12 @@ DivFilePlayer::DivFilePlayer():
   blocks(NULL),
   priorityBlock(NULL),
   numBlocks(0),
+  mapped(NULL),
+  mappedLen(0),
+  mappedData(NULL),
+  mappedDepth(0),
+  window(NULL),
+  windowLen(0),
   sf(NULL),
   playPos(0),
   lastWantBlock(DIV_NO_BLOCK),
@@ -548,7 +770,7 @@ DivFilePlayer::DivFilePlayer():
   pendingStopOffset(UINT_MAX),
   cacheThread(NULL) {
   memset(&si,0,sizeof(SF_INFO));
-  sincTable=DivFilterTables::getSincTable8();
+  sincKernel=DivFilterTables::getSincKernelTable8();
 }
 
 DivFilePlayer::~DivFilePlayer() {
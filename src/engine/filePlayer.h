@@ -25,6 +25,7 @@
 #include <thread>
 #include <mutex>
 #include <condition_variable>
+#include <vector>
 
 #ifdef HAVE_SNDFILE
 #include "sfWrapper.h"
@@ -36,11 +37,25 @@ struct SF_INFO {
 #endif
 
 class DivFilePlayer {
-  float* sincTable;
+  float* sincKernel;
   float* discardBuf;
   float** blocks;
   bool* priorityBlock;
   size_t numBlocks;
+
+  // uncompressed WAV files are mapped and read directly instead of being cached
+  unsigned char* mapped;
+  size_t mappedLen;
+  const unsigned char* mappedData;
+  // bytes per sample of the mapped data (2, 3 or 4; 4 is float)
+  int mappedDepth;
+
+  // de-interleaved input of the resampler
+  float** window;
+  size_t windowLen;
+
+  // seek targets which should be read ahead (waiting for the cache thread)
+  std::vector<ssize_t> pendingCues;
   String lastError;
   SFWrapper sfw;
   SNDFILE* sf;
@@ -68,9 +83,12 @@ class DivFilePlayer {
   std::mutex cacheThreadLock;
   std::condition_variable cacheCV;
 
-  void fillBlocksNear(ssize_t pos);
+  void fillBlocksNear(ssize_t pos, int count);
   void collectGarbage(ssize_t pos);
-  float getSampleAt(ssize_t pos, int ch);
+  bool mapFile(const char* path);
+  void unmapFile();
+  // read len frames starting at pos into window (out of bounds frames are silent)
+  void fetch(ssize_t pos, size_t len, int chans);
 
   public:
     void runCacheThread();
@@ -85,6 +103,12 @@ class DivFilePlayer {
     
     bool isBlockPresent(ssize_t pos);
     bool setBlockPriority(ssize_t pos, bool priority);
+    /**
+     * set the positions which playback may seek to, so that they can be read ahead.
+     * this replaces the previous cue points.
+     */
+    void setCuePoints(const std::vector<TimeMicros>& points);
+    bool isMapped();
     bool isLoaded();
     bool isPlaying();
     void play(unsigned int offset=UINT_MAX);
@@ -21,111 +21,163 @@
 #include <math.h>
 #include "filter.h"
 #include "../ta-log.h"
-
-float* DivFilterTables::cubicTable=NULL;
-float* DivFilterTables::sincTable=NULL;
-float* DivFilterTables::sincTable8=NULL;
-float* DivFilterTables::sincIntegralTable=NULL;
-float* DivFilterTables::sincIntegralSmallTable=NULL;
+#include <mutex>
+
+// the tables are shared by all engines. they are built once on first use,
+// under a lock in case several engines ask for one at the same time.
+#define TABLE_BEGIN(x) \
+  float* ret=x.load(std::memory_order_acquire); \
+  if (ret!=NULL) return ret; \
+  std::lock_guard<std::mutex> lock(tableLock); \
+  ret=x.load(std::memory_order_relaxed); \
+  if (ret!=NULL) return ret;
+
+#define TABLE_END(x) \
+  x.store(ret,std::memory_order_release); \
+  return ret;
+
+static std::mutex tableLock;
+
+std::atomic<float*> DivFilterTables::cubicTable(NULL);
+std::atomic<float*> DivFilterTables::sincTable(NULL);
+std::atomic<float*> DivFilterTables::sincTable8(NULL);
+std::atomic<float*> DivFilterTables::sincIntegralTable(NULL);
+std::atomic<float*> DivFilterTables::sincIntegralSmallTable(NULL);
+std::atomic<float*> DivFilterTables::sincKernelTable(NULL);
+std::atomic<float*> DivFilterTables::sincKernelTable8(NULL);
 
 // portions from Schism Tracker (scripts/lutgen.c)
 // licensed under same license as this program.
 float* DivFilterTables::getCubicTable() {
-  if (cubicTable==NULL) {
-    logD("initializing cubic spline table.");
-    cubicTable=new float[4096];
-
-    for (int i=0; i<1024; i++) {
-      float x=(float)i/1024.0;
-      cubicTable[(i<<2)]=-0.5*pow(x,3)+1.0*pow(x,2)-0.5*x;
-      cubicTable[1+(i<<2)]=1.5*pow(x,3)-2.5*pow(x,2)+1.0;
-      cubicTable[2+(i<<2)]=-1.5*pow(x,3)+2.0*pow(x,2)+0.5*x;
-      cubicTable[3+(i<<2)]=0.5*pow(x,3)-0.5*pow(x,2);
-    }
+  TABLE_BEGIN(cubicTable);
+  logD("initializing cubic spline table.");
+  ret=new float[4096];
+
+  for (int i=0; i<1024; i++) {
+    float x=(float)i/1024.0;
+    ret[(i<<2)]=-0.5*pow(x,3)+1.0*pow(x,2)-0.5*x;
+    ret[1+(i<<2)]=1.5*pow(x,3)-2.5*pow(x,2)+1.0;
+    ret[2+(i<<2)]=-1.5*pow(x,3)+2.0*pow(x,2)+0.5*x;
+    ret[3+(i<<2)]=0.5*pow(x,3)-0.5*pow(x,2);
   }
-  return cubicTable;
+
+  TABLE_END(cubicTable);
 }
 
 float* DivFilterTables::getSincTable() {
-  if (sincTable==NULL) {
-    logD("initializing sinc table.");
-    sincTable=new float[65536];
-
-    sincTable[0]=1.0f;
-    for (int i=1; i<65536; i++) {
-      int mapped=((i&8191)<<3)|(i>>13);
-      double x=(double)i*M_PI/8192.0;
-      sincTable[mapped]=sin(x)/x;
-    }
+  TABLE_BEGIN(sincTable);
+  logD("initializing sinc table.");
+  ret=new float[65536];
+
+  ret[0]=1.0f;
+  for (int i=1; i<65536; i++) {
+    int mapped=((i&8191)<<3)|(i>>13);
+    double x=(double)i*M_PI/8192.0;
+    ret[mapped]=sin(x)/x;
+  }
 
-    for (int i=0; i<65536; i++) {
-      int mapped=((i&8191)<<3)|(i>>13);
-      sincTable[mapped]*=pow(cos(M_PI*(double)i/131072.0),2.0);
-    }
+  for (int i=0; i<65536; i++) {
+    int mapped=((i&8191)<<3)|(i>>13);
+    ret[mapped]*=pow(cos(M_PI*(double)i/131072.0),2.0);
   }
-  return sincTable;
+
+  TABLE_END(sincTable);
 }
 
 float* DivFilterTables::getSincTable8() {
-  if (sincTable8==NULL) {
-    logD("initializing sinc table (8).");
-    sincTable8=new float[32768];
-
-    sincTable8[0]=1.0f;
-    for (int i=1; i<32768; i++) {
-      int mapped=((i&8191)<<2)|(i>>13);
-      double x=(double)i*M_PI/8192.0;
-      sincTable8[mapped]=sin(x)/x;
+  TABLE_BEGIN(sincTable8);
+  logD("initializing sinc table (8).");
+  ret=new float[32768];
+
+  ret[0]=1.0f;
+  for (int i=1; i<32768; i++) {
+    int mapped=((i&8191)<<2)|(i>>13);
+    double x=(double)i*M_PI/8192.0;
+    ret[mapped]=sin(x)/x;
+  }
+
+  for (int i=0; i<32768; i++) {
+    int mapped=((i&8191)<<2)|(i>>13);
+    ret[mapped]*=pow(cos(M_PI*(double)i/65536.0),2.0);
+  }
+
+  TABLE_END(sincTable8);
+}
+
+float* DivFilterTables::getSincKernelTable() {
+  float* sinc=getSincTable();
+  TABLE_BEGIN(sincKernelTable);
+  logD("initializing sinc kernel table.");
+  ret=new float[131072];
+
+  for (int i=0; i<8192; i++) {
+    float* k=&ret[i<<4];
+    for (int j=0; j<8; j++) {
+      k[j]=sinc[(i<<3)+7-j];
+      k[8+j]=sinc[((8191-i)<<3)+j];
     }
+  }
+
+  TABLE_END(sincKernelTable);
+}
 
-    for (int i=0; i<32768; i++) {
-      int mapped=((i&8191)<<2)|(i>>13);
-      sincTable8[mapped]*=pow(cos(M_PI*(double)i/65536.0),2.0);
+float* DivFilterTables::getSincKernelTable8() {
+  float* sinc=getSincTable8();
+  TABLE_BEGIN(sincKernelTable8);
+  logD("initializing sinc kernel table (8).");
+  ret=new float[65536];
+
+  for (int i=0; i<8192; i++) {
+    float* k=&ret[i<<3];
+    for (int j=0; j<4; j++) {
+      k[j]=sinc[(i<<2)+3-j];
+      k[4+j]=sinc[((8191-i)<<2)+j];
     }
   }
-  return sincTable8;
+
+  TABLE_END(sincKernelTable8);
 }
 
 float* DivFilterTables::getSincIntegralTable() {
-  if (sincIntegralTable==NULL) {
-    logD("initializing sinc integral table.");
-    sincIntegralTable=new float[65536];
-
-    sincIntegralTable[0]=-0.5f;
-    for (int i=1; i<65536; i++) {
-      int mapped=((i&8191)<<3)|(i>>13);
-      int mappedPrev=(((i-1)&8191)<<3)|((i-1)>>13);
-      double x=(double)i*M_PI/8192.0;
-      double sinc=sin(x)/x;
-      sincIntegralTable[mapped]=sincIntegralTable[mappedPrev]+(sinc/8192.0);
-    }
+  TABLE_BEGIN(sincIntegralTable);
+  logD("initializing sinc integral table.");
+  ret=new float[65536];
+
+  ret[0]=-0.5f;
+  for (int i=1; i<65536; i++) {
+    int mapped=((i&8191)<<3)|(i>>13);
+    int mappedPrev=(((i-1)&8191)<<3)|((i-1)>>13);
+    double x=(double)i*M_PI/8192.0;
+    double sinc=sin(x)/x;
+    ret[mapped]=ret[mappedPrev]+(sinc/8192.0);
+  }
 
-    for (int i=0; i<65536; i++) {
-      int mapped=((i&8191)<<3)|(i>>13);
-      sincIntegralTable[mapped]*=pow(cos(M_PI*(double)i/131072.0),2.0);
-    }
+  for (int i=0; i<65536; i++) {
+    int mapped=((i&8191)<<3)|(i>>13);
+    ret[mapped]*=pow(cos(M_PI*(double)i/131072.0),2.0);
   }
-  return sincIntegralTable;
+
+  TABLE_END(sincIntegralTable);
 }
 
 float* DivFilterTables::getSincIntegralSmallTable() {
-  if (sincIntegralSmallTable==NULL) {
-    logD("initializing small sinc integral table.");
-    sincIntegralSmallTable=new float[512];
-
-    sincIntegralSmallTable[0]=-0.5f;
-    for (int i=1; i<512; i++) {
-      int mapped=((i&63)<<3)|(i>>6);
-      int mappedPrev=(((i-1)&63)<<3)|((i-1)>>6);
-      double x=(double)i*M_PI/64.0;
-      double sinc=sin(x)/x;
-      sincIntegralSmallTable[mapped]=sincIntegralSmallTable[mappedPrev]+(sinc/64.0);
-    }
+  TABLE_BEGIN(sincIntegralSmallTable);
+  logD("initializing small sinc integral table.");
+  ret=new float[512];
+
+  ret[0]=-0.5f;
+  for (int i=1; i<512; i++) {
+    int mapped=((i&63)<<3)|(i>>6);
+    int mappedPrev=(((i-1)&63)<<3)|((i-1)>>6);
+    double x=(double)i*M_PI/64.0;
+    double sinc=sin(x)/x;
+    ret[mapped]=ret[mappedPrev]+(sinc/64.0);
+  }
 
-    for (int i=0; i<512; i++) {
-      int mapped=((i&63)<<3)|(i>>6);
-      sincIntegralSmallTable[mapped]*=pow(cos(M_PI*(double)i/1024.0),2.0);
-    }
+  for (int i=0; i<512; i++) {
+    int mapped=((i&63)<<3)|(i>>6);
+    ret[mapped]*=pow(cos(M_PI*(double)i/1024.0),2.0);
   }
-  return sincIntegralSmallTable;
+
+  TABLE_END(sincIntegralSmallTable);
 }
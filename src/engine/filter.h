@@ -17,13 +17,17 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include <atomic>
+
 class DivFilterTables {
   public:
-    static float* cubicTable;
-    static float* sincTable;
-    static float* sincTable8;
-    static float* sincIntegralTable;
-    static float* sincIntegralSmallTable;
+    static std::atomic<float*> cubicTable;
+    static std::atomic<float*> sincTable;
+    static std::atomic<float*> sincTable8;
+    static std::atomic<float*> sincIntegralTable;
+    static std::atomic<float*> sincIntegralSmallTable;
+    static std::atomic<float*> sincKernelTable;
+    static std::atomic<float*> sincKernelTable8;
 
     /**
      * get a 1024x4 cubic spline table.
@@ -43,6 +47,21 @@ class DivFilterTables {
      */
     static float* getSincTable8();
 
+    /**
+     * get a 8192x16 two-side sine-windowed sinc table, made from the one-side one.
+     * the first half of each kernel is reversed, so that it can be applied to 16
+     * samples in order.
+     * @return the table.
+     */
+    static float* getSincKernelTable();
+
+    /**
+     * get a 8192x8 two-side sine-windowed sinc table, made from the 8192x4 one.
+     * like getSincKernelTable(), each kernel can be applied to 8 samples in order.
+     * @return the table.
+     */
+    static float* getSincKernelTable8();
+
     /**
      * get a 8192x8 one-side sine-windowed sinc integral table.
      * @return the table.
@@ -0,0 +1,382 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2026 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// instrument preview voices.
+// a note is rendered once by a render worker (a copy of the song with its own
+// chips), then played back by the audio callback with a sinc resampler.
+
+#include "engine.h"
+#include "filter.h"
+#include "trace.h"
+#include "../ta-log.h"
+#include <math.h>
+
+#define HASH_BASIS 0xcbf29ce484222325ULL
+#define HASH_PRIME 0x100000001b3ULL
+#define HASH_VALUE(h,x) h=((h)^(unsigned long long)(x))*HASH_PRIME
+
+#define INS_PREVIEW_CHUNK 1024
+
+// anything below this at the end of a render is cut off
+#define INS_PREVIEW_SILENCE (1.0f/32768.0f)
+
+static unsigned long long hashBytes(unsigned long long h, const unsigned char* buf, size_t len) {
+  for (size_t i=0; i<len; i++) {
+    HASH_VALUE(h,buf[i]);
+  }
+  return h;
+}
+
+unsigned long long DivEngine::getInsPreviewSongKey() {
+  unsigned long long h=HASH_BASIS;
+  HASH_VALUE(h,(int)got.rate);
+  HASH_VALUE(h,got.outChans);
+  HASH_VALUE(h,song.systemLen);
+  for (int i=0; i<song.systemLen; i++) {
+    HASH_VALUE(h,song.system[i]);
+    HASH_VALUE(h,(int)(song.systemVol[i]*65536.0f));
+    HASH_VALUE(h,(int)(song.systemPan[i]*65536.0f));
+    String flags=song.systemFlags[i].toString();
+    h=hashBytes(h,(const unsigned char*)flags.c_str(),flags.size());
+  }
+  HASH_VALUE(h,(int)(song.tuning*65536.0f));
+  HASH_VALUE(h,song.insLen);
+  HASH_VALUE(h,song.sampleLen);
+  for (DivSample* i: song.sample) {
+    HASH_VALUE(h,i->renderHash);
+  }
+  HASH_VALUE(h,song.waveLen);
+  for (DivWavetable* i: song.wave) {
+    HASH_VALUE(h,i->len);
+    HASH_VALUE(h,i->max);
+    h=hashBytes(h,(const unsigned char*)i->data,i->len*sizeof(int));
+  }
+  return h;
+}
+
+bool DivEngine::previewInsCached(int ins, int note, int transpose) {
+  if (ins<0 || ins>=song.insLen) return false;
+  if (output==NULL || got.rate<1) return false;
+
+  // nearest rendered note
+  int pitch=note+transpose;
+  int ref=((pitch+120+DIV_INS_PREVIEW_NOTE_STEP/2)/DIV_INS_PREVIEW_NOTE_STEP)*DIV_INS_PREVIEW_NOTE_STEP-120;
+
+  unsigned long long songKey=getInsPreviewSongKey();
+  SafeWriter* w=new SafeWriter;
+  w->init();
+  song.ins[ins]->putInsData2(w,false,NULL,false);
+  unsigned long long key=hashBytes(songKey,w->getFinalBuf(),w->size());
+  w->finish();
+  delete w;
+
+  std::unique_lock<std::mutex> lock(insPreviewLock);
+  DivInsPreviewBuf* buf=NULL;
+  for (DivInsPreviewBuf* i: insPreviewCache) {
+    if (i->ins==ins && i->note==ref && i->key==key) {
+      buf=i;
+      break;
+    }
+  }
+
+  if (buf==NULL) {
+    for (DivInsPreviewJob& i: insPreviewJobs) {
+      if (i.ins==ins && i.note==ref && i.key==key) return false;
+    }
+    if (insPreviewThread==NULL) {
+      insPreviewQuit=false;
+      try {
+        insPreviewThread=new std::thread(&DivEngine::runInsPreview,this);
+      } catch (std::system_error& e) {
+        logW("could not start instrument preview thread! %s",e.what());
+        insPreviewThread=NULL;
+        return false;
+      }
+    }
+    DivInsPreviewJob job(ins,ref,key,songKey,new DivInstrument(*song.ins[ins]));
+    if (songKey!=insPreviewCopyKey) {
+      // the song may only be read from this thread, so the worker is set up here
+      // and loaded by the preview thread.
+      lock.unlock();
+      SafeWriter* songCopy=saveFur(true);
+      if (songCopy==NULL) {
+        delete job.copy;
+        return false;
+      }
+      job.songLen=songCopy->size();
+      job.songData=new unsigned char[job.songLen];
+      memcpy(job.songData,songCopy->getFinalBuf(),job.songLen);
+      songCopy->finish();
+      delete songCopy;
+      job.subSong=curSubSongIndex;
+      job.worker=new DivEngine;
+      job.worker->initRenderWorkerConf(this);
+      lock.lock();
+      insPreviewCopyKey=songKey;
+    }
+    insPreviewJobs.push_back(job);
+    insPreviewCond.notify_one();
+    return false;
+  }
+
+  // take a free voice, or the oldest one
+  int which=0;
+  for (int i=0; i<DIV_INS_PREVIEW_VOICES; i++) {
+    if (insPreviewVoices[i].buf==NULL) {
+      which=i;
+      break;
+    }
+    if (insPreviewVoices[i].buf->lastUse<insPreviewVoices[which].buf->lastUse) which=i;
+  }
+  DivInsPreviewVoice& v=insPreviewVoices[which];
+  if (v.buf!=NULL) {
+    v.buf->users--;
+  } else {
+    insPreviewPlaying++;
+  }
+  buf->users++;
+  buf->lastUse=++insPreviewUse;
+  v.buf=buf;
+  v.note=note;
+  v.pos=0.0;
+  v.step=pow(2.0,(double)(pitch-ref)/12.0);
+  v.vol=1.0f;
+  v.released=false;
+  return true;
+}
+
+void DivEngine::stopInsPreview(int note) {
+  std::lock_guard<std::mutex> lock(insPreviewLock);
+  for (int i=0; i<DIV_INS_PREVIEW_VOICES; i++) {
+    if (insPreviewVoices[i].buf!=NULL && insPreviewVoices[i].note==note) {
+      insPreviewVoices[i].released=true;
+    }
+  }
+}
+
+DivInsPreviewBuf* DivEngine::renderInsPreview(DivInsPreviewJob& job) {
+  // the worker is a copy of the song. it is made again when something other
+  // than the instrument changes.
+  if (job.worker!=NULL) {
+    if (insPreviewWorker!=NULL) {
+      insPreviewWorker->quit(false);
+      delete insPreviewWorker;
+    }
+    logD("creating instrument preview worker...");
+    insPreviewWorker=job.worker;
+    job.worker=NULL;
+    // load() takes the data
+    bool loaded=insPreviewWorker->initRenderWorkerSong(job.songData,job.songLen,job.subSong);
+    job.songData=NULL;
+    if (!loaded) {
+      logW("could not create instrument preview worker!");
+      insPreviewWorker->quit(false);
+      delete insPreviewWorker;
+      insPreviewWorker=NULL;
+      return NULL;
+    }
+    insPreviewWorkerKey=job.songKey;
+  }
+  if (insPreviewWorker==NULL || insPreviewWorkerKey!=job.songKey) return NULL;
+
+  DivEngine* e=insPreviewWorker;
+  if (job.ins>=e->song.insLen) return NULL;
+  e->stop();
+  *e->song.ins[job.ins]=*job.copy;
+  e->notifyInsChange(job.ins);
+  e->midiBaseChan=0;
+  if (!e->autoNoteOn(-1,job.ins,job.note)) return NULL;
+
+  int outChans=MAX(MIN(e->got.outChans,DIV_MAX_OUTPUTS),1);
+  float* out[DIV_MAX_OUTPUTS];
+  for (int i=0; i<outChans; i++) {
+    out[i]=new float[INS_PREVIEW_CHUNK];
+  }
+
+  DivInsPreviewBuf* buf=new DivInsPreviewBuf;
+  buf->ins=job.ins;
+  buf->note=job.note;
+  buf->key=job.key;
+  buf->holdLen=e->got.rate*DIV_INS_PREVIEW_HOLD;
+  unsigned int total=buf->holdLen+(unsigned int)(e->got.rate*DIV_INS_PREVIEW_RELEASE);
+  int bufChans=MIN(outChans,2);
+  for (int i=0; i<bufChans; i++) {
+    buf->data[i].reserve(total);
+  }
+
+  unsigned int pos=0;
+  while (pos<total) {
+    // release the note right at the end of the hold part
+    unsigned int size=MIN(total-pos,INS_PREVIEW_CHUNK);
+    if (pos<buf->holdLen) {
+      size=MIN(size,buf->holdLen-pos);
+    } else if (pos==buf->holdLen) {
+      e->autoNoteOff(-1,job.note);
+    }
+    e->nextBuf(NULL,out,0,outChans,size);
+    for (int i=0; i<bufChans; i++) {
+      buf->data[i].insert(buf->data[i].end(),out[i],out[i]+size);
+    }
+    pos+=size;
+  }
+  e->stop();
+
+  for (int i=0; i<outChans; i++) {
+    delete[] out[i];
+  }
+
+  // cut off the silent end
+  size_t len=buf->data[0].size();
+  while (len>0) {
+    bool silent=true;
+    for (int i=0; i<bufChans; i++) {
+      if (fabs(buf->data[i][len-1])>=INS_PREVIEW_SILENCE) silent=false;
+    }
+    if (!silent) break;
+    len--;
+  }
+  for (int i=0; i<bufChans; i++) {
+    buf->data[i].resize(len);
+    buf->data[i].shrink_to_fit();
+  }
+  if (buf->holdLen>len) buf->holdLen=len;
+  return buf;
+}
+
+void DivEngine::runInsPreview() {
+  DIV_TRACE_THREAD("instrument preview");
+  insPreviewKernel=DivFilterTables::getSincKernelTable8();
+  std::unique_lock<std::mutex> unique(insPreviewLock);
+  while (!insPreviewQuit) {
+    if (insPreviewJobs.empty()) {
+      insPreviewCond.wait(unique);
+      continue;
+    }
+    DivInsPreviewJob job=insPreviewJobs.front();
+    insPreviewJobs.erase(insPreviewJobs.begin());
+    unique.unlock();
+
+    logV("rendering preview of instrument %d (note %d)",job.ins,job.note);
+    DivInsPreviewBuf* buf=renderInsPreview(job);
+    delete job.copy;
+
+    unique.lock();
+    // send a new copy of the song with the next request
+    if (insPreviewWorker==NULL) insPreviewCopyKey=0;
+    if (buf==NULL) continue;
+    // make room for it. buffers which are playing stay.
+    while ((int)insPreviewCache.size()>=DIV_INS_PREVIEW_CACHE) {
+      int oldest=-1;
+      for (size_t i=0; i<insPreviewCache.size(); i++) {
+        if (insPreviewCache[i]->users>0) continue;
+        if (oldest<0 || insPreviewCache[i]->lastUse<insPreviewCache[oldest]->lastUse) oldest=i;
+      }
+      if (oldest<0) break;
+      delete insPreviewCache[oldest];
+      insPreviewCache.erase(insPreviewCache.begin()+oldest);
+    }
+    // an older render of the same note is no longer needed
+    for (size_t i=0; i<insPreviewCache.size(); i++) {
+      DivInsPreviewBuf* old=insPreviewCache[i];
+      if (old->ins==buf->ins && old->note==buf->note && old->users==0) {
+        delete old;
+        insPreviewCache.erase(insPreviewCache.begin()+i);
+        i--;
+      }
+    }
+    buf->lastUse=insPreviewUse;
+    insPreviewCache.push_back(buf);
+  }
+  unique.unlock();
+
+  if (insPreviewWorker!=NULL) {
+    insPreviewWorker->quit(false);
+    delete insPreviewWorker;
+    insPreviewWorker=NULL;
+  }
+}
+
+void DivEngine::mixInsPreview(float** out, int outChans, unsigned int size) {
+  if (insPreviewPlaying<=0 || out==NULL || outChans<1) return;
+  std::lock_guard<std::mutex> lock(insPreviewLock);
+  if (insPreviewKernel==NULL) return;
+  float fadeStep=(got.rate>0)?(1.0/(got.rate*DIV_INS_PREVIEW_FADE)):1.0f;
+  for (int i=0; i<DIV_INS_PREVIEW_VOICES; i++) {
+    DivInsPreviewVoice& v=insPreviewVoices[i];
+    if (v.buf==NULL) continue;
+    DivInsPreviewBuf* buf=v.buf;
+    size_t len=buf->data[0].size();
+    bool stereo=!buf->data[1].empty() && outChans>=2;
+    for (unsigned int j=0; j<size; j++) {
+      size_t intPos=v.pos;
+      if (intPos>=len || v.vol<=0.0f) break;
+      // the render already has its release, so the fade is only needed before it
+      if (v.released && intPos<buf->holdLen) v.vol-=fadeStep;
+      const float* t=&insPreviewKernel[((unsigned int)((v.pos-intPos)*8192.0)&8191)<<3];
+      for (int k=0; k<(stereo?2:1); k++) {
+        const float* x=buf->data[k].data();
+        float s=0.0f;
+        for (int l=0; l<8; l++) {
+          size_t idx=intPos+l-3;
+          if (idx<len) s+=x[idx]*t[l];
+        }
+        out[k][j]+=s*v.vol;
+        if (!stereo && outChans>=2) out[1][j]+=s*v.vol;
+      }
+      v.pos+=v.step;
+    }
+    if ((size_t)v.pos>=len || v.vol<=0.0f) {
+      buf->users--;
+      v.buf=NULL;
+      insPreviewPlaying--;
+    }
+  }
+}
+
+void DivEngine::quitInsPreview() {
+  if (insPreviewThread!=NULL) {
+    insPreviewLock.lock();
+    insPreviewQuit=true;
+    insPreviewCond.notify_one();
+    insPreviewLock.unlock();
+    insPreviewThread->join();
+    delete insPreviewThread;
+    insPreviewThread=NULL;
+  }
+  std::lock_guard<std::mutex> lock(insPreviewLock);
+  for (int i=0; i<DIV_INS_PREVIEW_VOICES; i++) {
+    insPreviewVoices[i].buf=NULL;
+  }
+  insPreviewPlaying=0;
+  for (DivInsPreviewJob& i: insPreviewJobs) {
+    delete i.copy;
+    if (i.worker!=NULL) {
+      i.worker->quit(false);
+      delete i.worker;
+    }
+    if (i.songData!=NULL) delete[] i.songData;
+  }
+  insPreviewJobs.clear();
+  // the worker is gone
+  insPreviewCopyKey=0;
+  for (DivInsPreviewBuf* i: insPreviewCache) {
+    delete i;
+  }
+  insPreviewCache.clear();
+}
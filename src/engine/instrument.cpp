@@ -623,9 +623,7 @@ void DivInstrument::writeMacro(SafeWriter* w, const DivInstrumentMacro& m) {
       }
       break;
     default: // 192
-      for (int i=0; i<m.len; i++) {
-        w->writeI(m.val[i]);
-      }
+      w->writeArray(m.val,m.len);
       break;
   }
 }
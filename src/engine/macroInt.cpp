@@ -20,6 +20,7 @@
 #include "macroInt.h"
 #include "instrument.h"
 #include "engine.h"
+#include "counters.h"
 #include "../ta-log.h"
 
 #define ADSR_LOW source.val[0]
@@ -176,14 +177,20 @@ void DivMacroStruct::doMacro(DivInstrumentMacro& source, bool released, bool tic
 
 void DivMacroInt::next() {
   if (ins==NULL) return;
+  divCount(DIV_COUNTER_MACRO_STEPS,liveListLen);
   // run macros
-  // TODO: potentially get rid of list to avoid allocations
+  // finished macros are dropped from the live list until they are restarted
   subTick--;
-  for (size_t i=0; i<macroListLen; i++) {
-    if (macroList[i]!=NULL && macroSource[i]!=NULL) {
-      macroList[i]->doMacro(*macroSource[i],released,subTick==0);
+  size_t newLen=0;
+  for (size_t i=0; i<liveListLen; i++) {
+    unsigned char which=liveList[i];
+    if (macroList[which]!=NULL && macroSource[which]!=NULL) {
+      macroList[which]->doMacro(*macroSource[which],released,subTick==0);
+      if (macroList[which]->isIdle()) continue;
     }
+    liveList[newLen++]=which;
   }
+  liveListLen=newLen;
   if (subTick<=0) {
     if (e==NULL) {
       subTick=1;
@@ -327,6 +334,16 @@ void DivMacroInt::restart(unsigned char id) {
 
   macroState->init();
   macroState->prepare(*macro,e);
+
+  // put it back in the live list
+  for (size_t i=0; i<macroListLen; i++) {
+    if (macroList[i]!=macroState) continue;
+    for (size_t j=0; j<liveListLen; j++) {
+      if (liveList[j]==i) return;
+    }
+    liveList[liveListLen++]=i;
+    return;
+  }
 }
 
 #undef CONSIDER_OP
@@ -340,6 +357,55 @@ void DivMacroInt::setEngine(DivEngine* eng) {
   e=eng;
 }
 
+DivMacroInt& DivMacroInt::operator=(const DivMacroInt& other) {
+  if (this==&other) return *this;
+  e=other.e;
+  ins=other.ins;
+  memcpy(macroSource,other.macroSource,128*sizeof(void*));
+  macroListLen=other.macroListLen;
+  memcpy(liveList,other.liveList,128);
+  liveListLen=other.liveListLen;
+  subTick=other.subTick;
+  released=other.released;
+
+  vol=other.vol;
+  arp=other.arp;
+  duty=other.duty;
+  wave=other.wave;
+  pitch=other.pitch;
+  ex1=other.ex1;
+  ex2=other.ex2;
+  ex3=other.ex3;
+  alg=other.alg;
+  fb=other.fb;
+  fms=other.fms;
+  ams=other.ams;
+  panL=other.panL;
+  panR=other.panR;
+  phaseReset=other.phaseReset;
+  ex4=other.ex4;
+  ex5=other.ex5;
+  ex6=other.ex6;
+  ex7=other.ex7;
+  ex8=other.ex8;
+  ex9=other.ex9;
+  ex10=other.ex10;
+  for (int i=0; i<4; i++) {
+    op[i]=other.op[i];
+  }
+  hasRelease=other.hasRelease;
+
+  // macroList points to the macros of the copied interpreter. point it to ours.
+  for (size_t i=0; i<128; i++) {
+    if (other.macroList[i]==NULL) {
+      macroList[i]=NULL;
+    } else {
+      macroList[i]=(DivMacroStruct*)((char*)this+((const char*)other.macroList[i]-(const char*)&other));
+    }
+  }
+  return *this;
+}
+
 #define ADD_MACRO(m,s) \
   if (!m.masked) { \
     macroList[macroListLen]=&m; \
@@ -353,6 +419,7 @@ void DivMacroInt::init(DivInstrument* which) {
     if (macroList[i]!=NULL) macroList[i]->init();
   }
   macroListLen=0;
+  liveListLen=0;
   subTick=1;
 
   hasRelease=false;
@@ -497,6 +564,7 @@ void DivMacroInt::init(DivInstrument* which) {
   }
 
   for (size_t i=0; i<macroListLen; i++) {
+    liveList[liveListLen++]=i;
     if (macroSource[i]!=NULL) {
       macroList[i]->prepare(*macroSource[i],e);
       // check ADSR mode
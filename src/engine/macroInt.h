@@ -31,6 +31,10 @@ struct DivMacroStruct {
   unsigned int mode, type;
   unsigned char macroType;
   void doMacro(DivInstrumentMacro& source, bool released, bool tick);
+  // a finished macro has no visible state to update until it is restarted
+  bool isIdle() {
+    return !has && !had && !actualHad && !finished;
+  }
   void init() {
     pos=lastPos=lfoPos=mode=type=delay=0;
     has=had=actualHad=will=false;
@@ -66,6 +70,9 @@ class DivMacroInt {
   DivMacroStruct* macroList[128];
   DivInstrumentMacro* macroSource[128];
   size_t macroListLen;
+  // indices of macros in macroList which haven't finished yet
+  unsigned char liveList[128];
+  size_t liveListLen;
   int subTick;
   bool released;
   public:
@@ -155,10 +162,21 @@ class DivMacroInt {
      */
     DivMacroStruct* structByType(unsigned char which);
 
+    /**
+     * copy a macro interpreter (e.g. for a state save).
+     * the copy keeps pointing to the same instrument.
+     */
+    DivMacroInt& operator=(const DivMacroInt& other);
+    DivMacroInt(const DivMacroInt& other):
+      DivMacroInt() {
+      *this=other;
+    }
+
     DivMacroInt():
       e(NULL),
       ins(NULL),
       macroListLen(0),
+      liveListLen(0),
       subTick(1),
       released(false),
       vol(DIV_MACRO_VOL),
@@ -186,6 +204,7 @@ class DivMacroInt {
       hasRelease(false) {
       memset(macroList,0,128*sizeof(void*));
       memset(macroSource,0,128*sizeof(void*));
+      memset(liveList,0,128);
     }
 };
 
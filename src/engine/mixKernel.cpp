@@ -0,0 +1,649 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2026 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "mixKernel.h"
+#include "../ta-log.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+#define DIV_MIX_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define DIV_MIX_AVX2
+#define DIV_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(_MSC_VER)
+#define DIV_MIX_AVX2
+#define DIV_TARGET_AVX2
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define DIV_MIX_NEON
+#include <arm_neon.h>
+#endif
+
+struct DivMixKernelImpl {
+  const char* name;
+  int (*mix)(float*,const short*,float,size_t);
+  int (*peak)(const short*,size_t);
+  void (*clamp)(float*,float,size_t);
+  void (*toS16)(short*,const float*,size_t);
+  void (*toS32)(int*,const float*,int,size_t);
+  void (*toS24)(unsigned char*,const float*,bool,size_t);
+  void (*swap16)(unsigned short*,size_t);
+  void (*swap32)(unsigned int*,size_t);
+};
+
+// 32-bit output is 24-bit shifted left, as a float doesn't have more precision than that
+#define S32_SHIFT(bits) (((bits)>24)?((bits)-24):0)
+#define S32_SCALE(bits) ((float)((1<<((((bits)>24)?24:(bits))-1))-1))
+
+// scalar
+
+static int mixScalar(float* out, const short* in, float vol, size_t len) {
+  const float v=vol/32768.0f;
+  int maxV=0;
+  int minV=0;
+  for (size_t i=0; i<len; i++) {
+    if (in[i]>maxV) maxV=in[i];
+    if (in[i]<minV) minV=in[i];
+    out[i]+=(float)in[i]*v;
+  }
+  return (maxV>-minV)?maxV:-minV;
+}
+
+static int peakScalar(const short* in, size_t len) {
+  int maxV=0;
+  int minV=0;
+  for (size_t i=0; i<len; i++) {
+    if (in[i]>maxV) maxV=in[i];
+    if (in[i]<minV) minV=in[i];
+  }
+  return (maxV>-minV)?maxV:-minV;
+}
+
+static void clampScalar(float* buf, float limit, size_t len) {
+  for (size_t i=0; i<len; i++) {
+    if (buf[i]<-limit) buf[i]=-limit;
+    if (buf[i]>limit) buf[i]=limit;
+  }
+}
+
+static void toS16Scalar(short* out, const float* in, size_t len) {
+  for (size_t i=0; i<len; i++) {
+    float x=in[i];
+    if (x<-1.0f) x=-1.0f;
+    if (x>1.0f) x=1.0f;
+    out[i]=x*32767.0f;
+  }
+}
+
+static void toS32Scalar(int* out, const float* in, int bits, size_t len) {
+  const int mul=1<<S32_SHIFT(bits);
+  const float scale=S32_SCALE(bits);
+  for (size_t i=0; i<len; i++) {
+    float x=in[i];
+    if (x<-1.0f) x=-1.0f;
+    if (x>1.0f) x=1.0f;
+    out[i]=(int)(x*scale)*mul;
+  }
+}
+
+static inline void packS24(unsigned char* out, int val, bool bigEndian) {
+  if (bigEndian) {
+    out[0]=(val>>16)&0xff;
+    out[1]=(val>>8)&0xff;
+    out[2]=val&0xff;
+  } else {
+    out[0]=val&0xff;
+    out[1]=(val>>8)&0xff;
+    out[2]=(val>>16)&0xff;
+  }
+}
+
+static void toS24Scalar(unsigned char* out, const float* in, bool bigEndian, size_t len) {
+  for (size_t i=0; i<len; i++) {
+    float x=in[i];
+    if (x<-1.0f) x=-1.0f;
+    if (x>1.0f) x=1.0f;
+    packS24(out+i*3,x*8388607.0f,bigEndian);
+  }
+}
+
+static void swap16Scalar(unsigned short* buf, size_t len) {
+  for (size_t i=0; i<len; i++) {
+    buf[i]=(buf[i]>>8)|(buf[i]<<8);
+  }
+}
+
+static void swap32Scalar(unsigned int* buf, size_t len) {
+  for (size_t i=0; i<len; i++) {
+    unsigned int x=buf[i];
+    buf[i]=(x>>24)|((x>>8)&0xff00)|((x<<8)&0xff0000)|(x<<24);
+  }
+}
+
+static const DivMixKernelImpl implScalar={
+  "scalar",
+  mixScalar,
+  peakScalar,
+  clampScalar,
+  toS16Scalar,
+  toS32Scalar,
+  toS24Scalar,
+  swap16Scalar,
+  swap32Scalar
+};
+
+// SSE2
+
+#ifdef DIV_MIX_SSE2
+static inline int reducePeakSSE2(__m128i maxV, __m128i minV, int maxS, int minS) {
+  short maxA[8];
+  short minA[8];
+  _mm_storeu_si128((__m128i*)maxA,maxV);
+  _mm_storeu_si128((__m128i*)minA,minV);
+  for (int i=0; i<8; i++) {
+    if (maxA[i]>maxS) maxS=maxA[i];
+    if (minA[i]<minS) minS=minA[i];
+  }
+  return (maxS>-minS)?maxS:-minS;
+}
+
+static int mixSSE2(float* out, const short* in, float vol, size_t len) {
+  const float v=vol/32768.0f;
+  const __m128 vv=_mm_set1_ps(v);
+  __m128i maxV=_mm_setzero_si128();
+  __m128i minV=_mm_setzero_si128();
+  size_t i=0;
+  for (; i+8<=len; i+=8) {
+    __m128i x=_mm_loadu_si128((const __m128i*)(in+i));
+    maxV=_mm_max_epi16(maxV,x);
+    minV=_mm_min_epi16(minV,x);
+    // sign-extend to 32-bit
+    __m128 lo=_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x,x),16));
+    __m128 hi=_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(x,x),16));
+    _mm_storeu_ps(out+i,_mm_add_ps(_mm_loadu_ps(out+i),_mm_mul_ps(lo,vv)));
+    _mm_storeu_ps(out+i+4,_mm_add_ps(_mm_loadu_ps(out+i+4),_mm_mul_ps(hi,vv)));
+  }
+  int maxS=0;
+  int minS=0;
+  for (; i<len; i++) {
+    if (in[i]>maxS) maxS=in[i];
+    if (in[i]<minS) minS=in[i];
+    out[i]+=(float)in[i]*v;
+  }
+  return reducePeakSSE2(maxV,minV,maxS,minS);
+}
+
+static int peakSSE2(const short* in, size_t len) {
+  __m128i maxV=_mm_setzero_si128();
+  __m128i minV=_mm_setzero_si128();
+  size_t i=0;
+  for (; i+8<=len; i+=8) {
+    __m128i x=_mm_loadu_si128((const __m128i*)(in+i));
+    maxV=_mm_max_epi16(maxV,x);
+    minV=_mm_min_epi16(minV,x);
+  }
+  int maxS=0;
+  int minS=0;
+  for (; i<len; i++) {
+    if (in[i]>maxS) maxS=in[i];
+    if (in[i]<minS) minS=in[i];
+  }
+  return reducePeakSSE2(maxV,minV,maxS,minS);
+}
+
+static void clampSSE2(float* buf, float limit, size_t len) {
+  const __m128 hiV=_mm_set1_ps(limit);
+  const __m128 loV=_mm_set1_ps(-limit);
+  size_t i=0;
+  for (; i+4<=len; i+=4) {
+    _mm_storeu_ps(buf+i,_mm_min_ps(_mm_max_ps(_mm_loadu_ps(buf+i),loV),hiV));
+  }
+  clampScalar(buf+i,limit,len-i);
+}
+
+static void toS16SSE2(short* out, const float* in, size_t len) {
+  const __m128 hiV=_mm_set1_ps(1.0f);
+  const __m128 loV=_mm_set1_ps(-1.0f);
+  const __m128 scale=_mm_set1_ps(32767.0f);
+  size_t i=0;
+  for (; i+8<=len; i+=8) {
+    __m128 a=_mm_min_ps(_mm_max_ps(_mm_loadu_ps(in+i),loV),hiV);
+    __m128 b=_mm_min_ps(_mm_max_ps(_mm_loadu_ps(in+i+4),loV),hiV);
+    __m128i x=_mm_packs_epi32(_mm_cvttps_epi32(_mm_mul_ps(a,scale)),_mm_cvttps_epi32(_mm_mul_ps(b,scale)));
+    _mm_storeu_si128((__m128i*)(out+i),x);
+  }
+  toS16Scalar(out+i,in+i,len-i);
+}
+
+static void toS32SSE2(int* out, const float* in, int bits, size_t len) {
+  const __m128 hiV=_mm_set1_ps(1.0f);
+  const __m128 loV=_mm_set1_ps(-1.0f);
+  const __m128 scale=_mm_set1_ps(S32_SCALE(bits));
+  const __m128i shift=_mm_cvtsi32_si128(S32_SHIFT(bits));
+  size_t i=0;
+  for (; i+4<=len; i+=4) {
+    __m128 a=_mm_min_ps(_mm_max_ps(_mm_loadu_ps(in+i),loV),hiV);
+    _mm_storeu_si128((__m128i*)(out+i),_mm_sll_epi32(_mm_cvttps_epi32(_mm_mul_ps(a,scale)),shift));
+  }
+  toS32Scalar(out+i,in+i,bits,len-i);
+}
+
+// the conversion is vectorized, but SSE2 has no byte shuffle for the packing
+static void toS24SSE2(unsigned char* out, const float* in, bool bigEndian, size_t len) {
+  int val[4];
+  size_t i=0;
+  for (; i+4<=len; i+=4) {
+    toS32SSE2(val,in+i,24,4);
+    for (int j=0; j<4; j++) {
+      packS24(out+(i+j)*3,val[j],bigEndian);
+    }
+  }
+  toS24Scalar(out+i*3,in+i,bigEndian,len-i);
+}
+
+static inline __m128i swap16VecSSE2(__m128i x) {
+  return _mm_or_si128(_mm_slli_epi16(x,8),_mm_srli_epi16(x,8));
+}
+
+static void swap16SSE2(unsigned short* buf, size_t len) {
+  size_t i=0;
+  for (; i+8<=len; i+=8) {
+    __m128i x=_mm_loadu_si128((const __m128i*)(buf+i));
+    _mm_storeu_si128((__m128i*)(buf+i),swap16VecSSE2(x));
+  }
+  swap16Scalar(buf+i,len-i);
+}
+
+static void swap32SSE2(unsigned int* buf, size_t len) {
+  size_t i=0;
+  for (; i+4<=len; i+=4) {
+    __m128i x=swap16VecSSE2(_mm_loadu_si128((const __m128i*)(buf+i)));
+    // then swap the halves
+    x=_mm_shufflehi_epi16(_mm_shufflelo_epi16(x,0xb1),0xb1);
+    _mm_storeu_si128((__m128i*)(buf+i),x);
+  }
+  swap32Scalar(buf+i,len-i);
+}
+
+static const DivMixKernelImpl implSSE2={
+  "SSE2",
+  mixSSE2,
+  peakSSE2,
+  clampSSE2,
+  toS16SSE2,
+  toS32SSE2,
+  toS24SSE2,
+  swap16SSE2,
+  swap32SSE2
+};
+#endif
+
+// AVX2
+
+#ifdef DIV_MIX_AVX2
+DIV_TARGET_AVX2 static int mixAVX2(float* out, const short* in, float vol, size_t len) {
+  const float v=vol/32768.0f;
+  const __m256 vv=_mm256_set1_ps(v);
+  __m256i maxV=_mm256_setzero_si256();
+  __m256i minV=_mm256_setzero_si256();
+  size_t i=0;
+  for (; i+16<=len; i+=16) {
+    __m256i x=_mm256_loadu_si256((const __m256i*)(in+i));
+    maxV=_mm256_max_epi16(maxV,x);
+    minV=_mm256_min_epi16(minV,x);
+    __m256 lo=_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_castsi256_si128(x)));
+    __m256 hi=_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_extracti128_si256(x,1)));
+    _mm256_storeu_ps(out+i,_mm256_add_ps(_mm256_loadu_ps(out+i),_mm256_mul_ps(lo,vv)));
+    _mm256_storeu_ps(out+i+8,_mm256_add_ps(_mm256_loadu_ps(out+i+8),_mm256_mul_ps(hi,vv)));
+  }
+  __m128i maxH=_mm_max_epi16(_mm256_castsi256_si128(maxV),_mm256_extracti128_si256(maxV,1));
+  __m128i minH=_mm_min_epi16(_mm256_castsi256_si128(minV),_mm256_extracti128_si256(minV,1));
+  int maxS=0;
+  int minS=0;
+  for (; i<len; i++) {
+    if (in[i]>maxS) maxS=in[i];
+    if (in[i]<minS) minS=in[i];
+    out[i]+=(float)in[i]*v;
+  }
+  return reducePeakSSE2(maxH,minH,maxS,minS);
+}
+
+DIV_TARGET_AVX2 static int peakAVX2(const short* in, size_t len) {
+  __m256i maxV=_mm256_setzero_si256();
+  __m256i minV=_mm256_setzero_si256();
+  size_t i=0;
+  for (; i+16<=len; i+=16) {
+    __m256i x=_mm256_loadu_si256((const __m256i*)(in+i));
+    maxV=_mm256_max_epi16(maxV,x);
+    minV=_mm256_min_epi16(minV,x);
+  }
+  __m128i maxH=_mm_max_epi16(_mm256_castsi256_si128(maxV),_mm256_extracti128_si256(maxV,1));
+  __m128i minH=_mm_min_epi16(_mm256_castsi256_si128(minV),_mm256_extracti128_si256(minV,1));
+  int maxS=0;
+  int minS=0;
+  for (; i<len; i++) {
+    if (in[i]>maxS) maxS=in[i];
+    if (in[i]<minS) minS=in[i];
+  }
+  return reducePeakSSE2(maxH,minH,maxS,minS);
+}
+
+DIV_TARGET_AVX2 static void clampAVX2(float* buf, float limit, size_t len) {
+  const __m256 hiV=_mm256_set1_ps(limit);
+  const __m256 loV=_mm256_set1_ps(-limit);
+  size_t i=0;
+  for (; i+8<=len; i+=8) {
+    _mm256_storeu_ps(buf+i,_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(buf+i),loV),hiV));
+  }
+  clampScalar(buf+i,limit,len-i);
+}
+
+DIV_TARGET_AVX2 static void toS16AVX2(short* out, const float* in, size_t len) {
+  const __m256 hiV=_mm256_set1_ps(1.0f);
+  const __m256 loV=_mm256_set1_ps(-1.0f);
+  const __m256 scale=_mm256_set1_ps(32767.0f);
+  size_t i=0;
+  for (; i+16<=len; i+=16) {
+    __m256 a=_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(in+i),loV),hiV);
+    __m256 b=_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(in+i+8),loV),hiV);
+    // packs works within 128-bit lanes, so the result has to be reordered
+    __m256i x=_mm256_packs_epi32(_mm256_cvttps_epi32(_mm256_mul_ps(a,scale)),_mm256_cvttps_epi32(_mm256_mul_ps(b,scale)));
+    _mm256_storeu_si256((__m256i*)(out+i),_mm256_permute4x64_epi64(x,0xd8));
+  }
+  toS16Scalar(out+i,in+i,len-i);
+}
+
+DIV_TARGET_AVX2 static void toS32AVX2(int* out, const float* in, int bits, size_t len) {
+  const __m256 hiV=_mm256_set1_ps(1.0f);
+  const __m256 loV=_mm256_set1_ps(-1.0f);
+  const __m256 scale=_mm256_set1_ps(S32_SCALE(bits));
+  const __m128i shift=_mm_cvtsi32_si128(S32_SHIFT(bits));
+  size_t i=0;
+  for (; i+8<=len; i+=8) {
+    __m256 a=_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(in+i),loV),hiV);
+    _mm256_storeu_si256((__m256i*)(out+i),_mm256_sll_epi32(_mm256_cvttps_epi32(_mm256_mul_ps(a,scale)),shift));
+  }
+  toS32Scalar(out+i,in+i,bits,len-i);
+}
+
+DIV_TARGET_AVX2 static void toS24AVX2(unsigned char* out, const float* in, bool bigEndian, size_t len) {
+  const __m256 hiV=_mm256_set1_ps(1.0f);
+  const __m256 loV=_mm256_set1_ps(-1.0f);
+  const __m256 scale=_mm256_set1_ps(8388607.0f);
+  // drop the top byte of every sample. each lane packs 4 samples into its lower 12 bytes.
+  const __m256i pack=bigEndian?
+    _mm256_setr_epi8(2,1,0,6,5,4,10,9,8,14,13,12,-1,-1,-1,-1,2,1,0,6,5,4,10,9,8,14,13,12,-1,-1,-1,-1):
+    _mm256_setr_epi8(0,1,2,4,5,6,8,9,10,12,13,14,-1,-1,-1,-1,0,1,2,4,5,6,8,9,10,12,13,14,-1,-1,-1,-1);
+  unsigned char tmp[32];
+  size_t i=0;
+  for (; i+8<=len; i+=8) {
+    __m256 a=_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(in+i),loV),hiV);
+    __m256i x=_mm256_shuffle_epi8(_mm256_cvttps_epi32(_mm256_mul_ps(a,scale)),pack);
+    _mm256_storeu_si256((__m256i*)tmp,x);
+    memcpy(out+i*3,tmp,12);
+    memcpy(out+i*3+12,tmp+16,12);
+  }
+  toS24Scalar(out+i*3,in+i,bigEndian,len-i);
+}
+
+DIV_TARGET_AVX2 static void swap16AVX2(unsigned short* buf, size_t len) {
+  const __m256i mask=_mm256_setr_epi8(1,0,3,2,5,4,7,6,9,8,11,10,13,12,15,14,1,0,3,2,5,4,7,6,9,8,11,10,13,12,15,14);
+  size_t i=0;
+  for (; i+16<=len; i+=16) {
+    __m256i x=_mm256_loadu_si256((const __m256i*)(buf+i));
+    _mm256_storeu_si256((__m256i*)(buf+i),_mm256_shuffle_epi8(x,mask));
+  }
+  swap16Scalar(buf+i,len-i);
+}
+
+DIV_TARGET_AVX2 static void swap32AVX2(unsigned int* buf, size_t len) {
+  const __m256i mask=_mm256_setr_epi8(3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12,3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12);
+  size_t i=0;
+  for (; i+8<=len; i+=8) {
+    __m256i x=_mm256_loadu_si256((const __m256i*)(buf+i));
+    _mm256_storeu_si256((__m256i*)(buf+i),_mm256_shuffle_epi8(x,mask));
+  }
+  swap32Scalar(buf+i,len-i);
+}
+
+static const DivMixKernelImpl implAVX2={
+  "AVX2",
+  mixAVX2,
+  peakAVX2,
+  clampAVX2,
+  toS16AVX2,
+  toS32AVX2,
+  toS24AVX2,
+  swap16AVX2,
+  swap32AVX2
+};
+
+static bool haveAVX2() {
+#ifdef _MSC_VER
+  int info[4];
+  __cpuid(info,0);
+  if (info[0]<7) return false;
+  __cpuid(info,1);
+  // OSXSAVE and AVX
+  if ((info[2]&((1<<27)|(1<<28)))!=((1<<27)|(1<<28))) return false;
+  // OS saves YMM state
+  if ((_xgetbv(0)&6)!=6) return false;
+  __cpuidex(info,7,0);
+  return (info[1]&(1<<5))!=0;
+#else
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+// NEON
+
+#ifdef DIV_MIX_NEON
+static int mixNEON(float* out, const short* in, float vol, size_t len) {
+  const float v=vol/32768.0f;
+  const float32x4_t vv=vdupq_n_f32(v);
+  int16x8_t maxV=vdupq_n_s16(0);
+  int16x8_t minV=vdupq_n_s16(0);
+  size_t i=0;
+  for (; i+8<=len; i+=8) {
+    int16x8_t x=vld1q_s16(in+i);
+    maxV=vmaxq_s16(maxV,x);
+    minV=vminq_s16(minV,x);
+    float32x4_t lo=vcvtq_f32_s32(vmovl_s16(vget_low_s16(x)));
+    float32x4_t hi=vcvtq_f32_s32(vmovl_s16(vget_high_s16(x)));
+    vst1q_f32(out+i,vaddq_f32(vld1q_f32(out+i),vmulq_f32(lo,vv)));
+    vst1q_f32(out+i+4,vaddq_f32(vld1q_f32(out+i+4),vmulq_f32(hi,vv)));
+  }
+  int maxS=vmaxvq_s16(maxV);
+  int minS=vminvq_s16(minV);
+  for (; i<len; i++) {
+    if (in[i]>maxS) maxS=in[i];
+    if (in[i]<minS) minS=in[i];
+    out[i]+=(float)in[i]*v;
+  }
+  return (maxS>-minS)?maxS:-minS;
+}
+
+static int peakNEON(const short* in, size_t len) {
+  int16x8_t maxV=vdupq_n_s16(0);
+  int16x8_t minV=vdupq_n_s16(0);
+  size_t i=0;
+  for (; i+8<=len; i+=8) {
+    int16x8_t x=vld1q_s16(in+i);
+    maxV=vmaxq_s16(maxV,x);
+    minV=vminq_s16(minV,x);
+  }
+  int maxS=vmaxvq_s16(maxV);
+  int minS=vminvq_s16(minV);
+  for (; i<len; i++) {
+    if (in[i]>maxS) maxS=in[i];
+    if (in[i]<minS) minS=in[i];
+  }
+  return (maxS>-minS)?maxS:-minS;
+}
+
+static void clampNEON(float* buf, float limit, size_t len) {
+  const float32x4_t hiV=vdupq_n_f32(limit);
+  const float32x4_t loV=vdupq_n_f32(-limit);
+  size_t i=0;
+  for (; i+4<=len; i+=4) {
+    vst1q_f32(buf+i,vminq_f32(vmaxq_f32(vld1q_f32(buf+i),loV),hiV));
+  }
+  clampScalar(buf+i,limit,len-i);
+}
+
+static void toS16NEON(short* out, const float* in, size_t len) {
+  const float32x4_t hiV=vdupq_n_f32(1.0f);
+  const float32x4_t loV=vdupq_n_f32(-1.0f);
+  const float32x4_t scale=vdupq_n_f32(32767.0f);
+  size_t i=0;
+  for (; i+8<=len; i+=8) {
+    float32x4_t a=vminq_f32(vmaxq_f32(vld1q_f32(in+i),loV),hiV);
+    float32x4_t b=vminq_f32(vmaxq_f32(vld1q_f32(in+i+4),loV),hiV);
+    int16x4_t lo=vqmovn_s32(vcvtq_s32_f32(vmulq_f32(a,scale)));
+    int16x4_t hi=vqmovn_s32(vcvtq_s32_f32(vmulq_f32(b,scale)));
+    vst1q_s16(out+i,vcombine_s16(lo,hi));
+  }
+  toS16Scalar(out+i,in+i,len-i);
+}
+
+static void toS32NEON(int* out, const float* in, int bits, size_t len) {
+  const float32x4_t hiV=vdupq_n_f32(1.0f);
+  const float32x4_t loV=vdupq_n_f32(-1.0f);
+  const float32x4_t scale=vdupq_n_f32(S32_SCALE(bits));
+  const int32x4_t shift=vdupq_n_s32(S32_SHIFT(bits));
+  size_t i=0;
+  for (; i+4<=len; i+=4) {
+    float32x4_t a=vminq_f32(vmaxq_f32(vld1q_f32(in+i),loV),hiV);
+    vst1q_s32(out+i,vshlq_s32(vcvtq_s32_f32(vmulq_f32(a,scale)),shift));
+  }
+  toS32Scalar(out+i,in+i,bits,len-i);
+}
+
+static void toS24NEON(unsigned char* out, const float* in, bool bigEndian, size_t len) {
+  const float32x4_t hiV=vdupq_n_f32(1.0f);
+  const float32x4_t loV=vdupq_n_f32(-1.0f);
+  const float32x4_t scale=vdupq_n_f32(8388607.0f);
+  size_t i=0;
+  for (; i+8<=len; i+=8) {
+    float32x4_t a=vminq_f32(vmaxq_f32(vld1q_f32(in+i),loV),hiV);
+    float32x4_t b=vminq_f32(vmaxq_f32(vld1q_f32(in+i+4),loV),hiV);
+    int32x4_t lo=vcvtq_s32_f32(vmulq_f32(a,scale));
+    int32x4_t hi=vcvtq_s32_f32(vmulq_f32(b,scale));
+    // split the samples into bytes and store them interleaved
+    uint8x8x3_t bytes;
+    bytes.val[bigEndian?2:0]=vmovn_u16(vcombine_u16(vmovn_u32(vreinterpretq_u32_s32(lo)),vmovn_u32(vreinterpretq_u32_s32(hi))));
+    bytes.val[1]=vmovn_u16(vcombine_u16(vmovn_u32(vreinterpretq_u32_s32(vshrq_n_s32(lo,8))),vmovn_u32(vreinterpretq_u32_s32(vshrq_n_s32(hi,8)))));
+    bytes.val[bigEndian?0:2]=vmovn_u16(vcombine_u16(vmovn_u32(vreinterpretq_u32_s32(vshrq_n_s32(lo,16))),vmovn_u32(vreinterpretq_u32_s32(vshrq_n_s32(hi,16)))));
+    vst3_u8(out+i*3,bytes);
+  }
+  toS24Scalar(out+i*3,in+i,bigEndian,len-i);
+}
+
+static void swap16NEON(unsigned short* buf, size_t len) {
+  size_t i=0;
+  for (; i+8<=len; i+=8) {
+    vst1q_u16(buf+i,vreinterpretq_u16_u8(vrev16q_u8(vreinterpretq_u8_u16(vld1q_u16(buf+i)))));
+  }
+  swap16Scalar(buf+i,len-i);
+}
+
+static void swap32NEON(unsigned int* buf, size_t len) {
+  size_t i=0;
+  for (; i+4<=len; i+=4) {
+    vst1q_u32(buf+i,vreinterpretq_u32_u8(vrev32q_u8(vreinterpretq_u8_u32(vld1q_u32(buf+i)))));
+  }
+  swap32Scalar(buf+i,len-i);
+}
+
+static const DivMixKernelImpl implNEON={
+  "NEON",
+  mixNEON,
+  peakNEON,
+  clampNEON,
+  toS16NEON,
+  toS32NEON,
+  toS24NEON,
+  swap16NEON,
+  swap32NEON
+};
+#endif
+
+static const DivMixKernelImpl* selectImpl() {
+  const DivMixKernelImpl* ret=&implScalar;
+#ifdef DIV_MIX_SSE2
+  ret=&implSSE2;
+#endif
+#ifdef DIV_MIX_AVX2
+  if (haveAVX2()) ret=&implAVX2;
+#endif
+#ifdef DIV_MIX_NEON
+  ret=&implNEON;
+#endif
+  logV("using %s mix kernel",ret->name);
+  return ret;
+}
+
+static const DivMixKernelImpl* getImpl() {
+  static const DivMixKernelImpl* impl=selectImpl();
+  return impl;
+}
+
+int DivMixKernel::mix(float* out, const short* in, float vol, size_t len) {
+  return getImpl()->mix(out,in,vol,len);
+}
+
+int DivMixKernel::peak(const short* in, size_t len) {
+  return getImpl()->peak(in,len);
+}
+
+void DivMixKernel::clamp(float* buf, float limit, size_t len) {
+  getImpl()->clamp(buf,limit,len);
+}
+
+void DivMixKernel::toS16(short* out, const float* in, size_t len) {
+  getImpl()->toS16(out,in,len);
+}
+
+void DivMixKernel::toS32(int* out, const float* in, int bits, size_t len) {
+  getImpl()->toS32(out,in,bits,len);
+}
+
+void DivMixKernel::toS24(unsigned char* out, const float* in, bool bigEndian, size_t len) {
+  getImpl()->toS24(out,in,bigEndian,len);
+}
+
+void DivMixKernel::swap16(unsigned short* buf, size_t len) {
+  getImpl()->swap16(buf,len);
+}
+
+void DivMixKernel::swap32(unsigned int* buf, size_t len) {
+  getImpl()->swap32(buf,len);
+}
+
+const char* DivMixKernel::getName() {
+  return getImpl()->name;
+}
@@ -0,0 +1,106 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2026 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _MIXKERNEL_H
+#define _MIXKERNEL_H
+
+#include <stddef.h>
+
+/**
+ * mixing kernels used by the final mix stage of nextBuf.
+ * the fastest implementation available on the running CPU is selected on first use.
+ * the scalar implementation is used as a fallback.
+ */
+class DivMixKernel {
+  public:
+    /**
+     * convert a 16-bit buffer to float, scale it and add it to another buffer.
+     * @param out the destination buffer.
+     * @param in the source buffer.
+     * @param vol the volume (1.0 means that 32768 becomes 1.0).
+     * @param len the length of the buffers.
+     * @return the peak absolute value of the source buffer (0-32768).
+     */
+    static int mix(float* out, const short* in, float vol, size_t len);
+
+    /**
+     * get the peak absolute value of a 16-bit buffer.
+     * @param in the buffer.
+     * @param len the length of the buffer.
+     * @return the peak (0-32768).
+     */
+    static int peak(const short* in, size_t len);
+
+    /**
+     * clamp a float buffer to the range [-limit, limit].
+     * @param buf the buffer.
+     * @param limit the limit.
+     * @param len the length of the buffer.
+     */
+    static void clamp(float* buf, float limit, size_t len);
+
+    /**
+     * convert a float buffer to 16-bit, clamping it to [-1.0, 1.0].
+     * @param out the destination buffer.
+     * @param in the source buffer.
+     * @param len the length of the buffers.
+     */
+    static void toS16(short* out, const float* in, size_t len);
+
+    /**
+     * convert a float buffer to 32-bit integer, clamping it to [-1.0, 1.0].
+     * @param out the destination buffer.
+     * @param in the source buffer.
+     * @param bits the number of bits of the samples (16 to 24, or 32).
+     * samples of less than 32 bits are right-aligned. 32-bit samples have 24 bits of precision.
+     * @param len the length of the buffers.
+     */
+    static void toS32(int* out, const float* in, int bits, size_t len);
+
+    /**
+     * convert a float buffer to packed 24-bit, clamping it to [-1.0, 1.0].
+     * @param out the destination buffer (3 bytes per sample).
+     * @param in the source buffer.
+     * @param bigEndian whether to write big-endian samples.
+     * @param len the length of the buffers.
+     */
+    static void toS24(unsigned char* out, const float* in, bool bigEndian, size_t len);
+
+    /**
+     * swap the byte order of a buffer of 16-bit samples in place.
+     * @param buf the buffer.
+     * @param len the length of the buffer in samples.
+     */
+    static void swap16(unsigned short* buf, size_t len);
+
+    /**
+     * swap the byte order of a buffer of 32-bit samples in place.
+     * @param buf the buffer.
+     * @param len the length of the buffer in samples.
+     */
+    static void swap32(unsigned int* buf, size_t len);
+
+    /**
+     * get the name of the selected implementation.
+     * @return the name.
+     */
+    static const char* getName();
+};
+
+#endif
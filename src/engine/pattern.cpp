@@ -20,8 +20,77 @@
 #include "engine.h"
 #include "../ta-log.h"
 
+// patterns per pool block (about 650KB each)
+#define PATTERN_POOL_BLOCK 64
+
+// free-list allocator for DivPattern.
+// a song may have thousands of patterns, so they are carved out of large
+// blocks instead of being allocated one by one.
+class DivPatternPool {
+  union Slot {
+    Slot* next;
+    alignas(DivPattern) unsigned char data[sizeof(DivPattern)];
+  };
+  std::vector<Slot*> blocks;
+  Slot* freeList;
+  size_t live;
+  std::mutex lock;
+
+  public:
+    void* alloc() {
+      std::lock_guard<std::mutex> guard(lock);
+      if (freeList==NULL) {
+        Slot* block=new Slot[PATTERN_POOL_BLOCK];
+        for (int i=0; i<PATTERN_POOL_BLOCK-1; i++) {
+          block[i].next=&block[i+1];
+        }
+        block[PATTERN_POOL_BLOCK-1].next=NULL;
+        freeList=block;
+        blocks.push_back(block);
+      }
+      Slot* ret=freeList;
+      freeList=ret->next;
+      live++;
+      return ret;
+    }
+
+    void free(void* ptr) {
+      std::lock_guard<std::mutex> guard(lock);
+      Slot* slot=(Slot*)ptr;
+      slot->next=freeList;
+      freeList=slot;
+      if (--live==0) {
+        // nothing is in use. give the memory back.
+        for (Slot* i: blocks) {
+          delete[] i;
+        }
+        blocks.clear();
+        freeList=NULL;
+      }
+    }
+
+    DivPatternPool():
+      freeList(NULL),
+      live(0) {}
+};
+
+// never destroyed, so that patterns freed during static destruction are fine
+static DivPatternPool& getPatternPool() {
+  static DivPatternPool* pool=new DivPatternPool;
+  return *pool;
+}
+
 static DivPattern emptyPat;
 
+void* DivPattern::operator new(size_t size) {
+  return getPatternPool().alloc();
+}
+
+void DivPattern::operator delete(void* ptr) {
+  if (ptr==NULL) return;
+  getPatternPool().free(ptr);
+}
+
 DivPattern::DivPattern() {
   clear();
 }
@@ -39,20 +108,24 @@ DivPattern* DivChannelData::getPattern(int index, bool create) {
 
 std::vector<std::pair<int,int>> DivChannelData::optimize() {
   std::vector<std::pair<int,int>> ret;
+  // bucket patterns by hash and only compare within a bucket.
+  // the first pattern of each set of duplicates is kept.
+  std::unordered_map<uint64_t,std::vector<int>> buckets;
   for (int i=0; i<DIV_MAX_PATTERNS; i++) {
-    if (data[i]!=NULL) {
-      // compare
-      for (int j=0; j<DIV_MAX_PATTERNS; j++) {
-        if (j==i) continue;
-        if (data[j]==NULL) continue;
-        if (memcmp(data[i]->newData,data[j]->newData,DIV_MAX_ROWS*DIV_MAX_COLS*sizeof(short))==0) {
-          delete data[j];
-          data[j]=NULL;
-          logV("%d == %d",i,j);
-          ret.push_back(std::pair<int,int>(j,i));
-        }
+    if (data[i]==NULL) continue;
+    std::vector<int>& bucket=buckets[data[i]->hash()];
+    bool found=false;
+    for (int j: bucket) {
+      if (memcmp(data[i]->newData,data[j]->newData,DIV_MAX_ROWS*DIV_MAX_COLS*sizeof(short))==0) {
+        delete data[i];
+        data[i]=NULL;
+        logV("%d == %d",j,i);
+        ret.push_back(std::pair<int,int>(i,j));
+        found=true;
+        break;
       }
     }
+    if (!found) bucket.push_back(i);
   }
   return ret;
 }
@@ -93,6 +166,33 @@ bool DivPattern::isEmpty() {
   return true;
 }
 
+void DivPattern::getRowEffects(int row, int effectCols, DivPatternRowEffects& out) {
+  const short* rowData=newData[row];
+  out.count=0;
+  for (int j=0; j<effectCols; j++) {
+    short effect=rowData[DIV_PAT_FX(j)];
+    if (effect==-1) continue;
+    short effectVal=rowData[DIV_PAT_FXVAL(j)];
+    if (effectVal==-1) effectVal=0;
+    out.effect[out.count]=effect;
+    out.effectVal[out.count]=effectVal&255;
+    out.count++;
+  }
+}
+
+uint64_t DivPattern::hash() {
+  // FNV-1a over 64-bit words
+  uint64_t ret=0xcbf29ce484222325ULL;
+  const unsigned char* d=(const unsigned char*)newData;
+  for (size_t i=0; i<sizeof(newData); i+=sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word,&d[i],sizeof(uint64_t));
+    ret^=word;
+    ret*=0x100000001b3ULL;
+  }
+  return ret;
+}
+
 void DivPattern::copyOn(DivPattern* dest) {
   dest->name=name;
   memcpy(dest->newData,newData,sizeof(newData));
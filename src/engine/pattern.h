@@ -20,6 +20,16 @@
 #include "safeReader.h"
 #include "../pch.h"
 
+/**
+ * the effects of a pattern row, with empty columns left out.
+ * effect values are already resolved (empty is 0, masked to 8 bits).
+ */
+struct DivPatternRowEffects {
+  short effect[DIV_MAX_EFFECTS];
+  short effectVal[DIV_MAX_EFFECTS];
+  int count;
+};
+
 struct DivPattern {
   String name;
   /**
@@ -45,6 +55,21 @@ struct DivPattern {
    */
   bool isEmpty();
 
+  /**
+   * calculate a hash of the pattern data (not the name).
+   * equal patterns have equal hashes.
+   * @return the hash.
+   */
+  uint64_t hash();
+
+  /**
+   * collect the non-empty effects of a row.
+   * @param row the row.
+   * @param effectCols number of effect columns to look at.
+   * @param out where to store the effects.
+   */
+  void getRowEffects(int row, int effectCols, DivPatternRowEffects& out);
+
   /**
    * clear the pattern.
    */
@@ -55,6 +80,14 @@ struct DivPattern {
    * @param dest the destination pattern.
    */
   void copyOn(DivPattern* dest);
+
+  /**
+   * patterns are allocated from a shared pool of large blocks.
+   * freed patterns are kept for reuse, and the blocks are released once
+   * the last pattern is gone (e.g. after closing a song).
+   */
+  static void* operator new(size_t size);
+  static void operator delete(void* ptr);
   DivPattern();
 };
 
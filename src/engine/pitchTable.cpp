@@ -17,7 +17,30 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
- #include "dispatch.h"
+#include "dispatch.h"
+#include <math.h>
+
+// one octave of 2^(x/1536) ratios. the rest is done with ldexp().
+static double linearPitchRatio[12*128];
+
+static bool linearPitchRatioInit() {
+  for (int i=0; i<12*128; i++) {
+    linearPitchRatio[i]=pow(2.0,(double)i/(128.0*12.0));
+  }
+  return true;
+}
+
+static bool linearPitchRatioReady=linearPitchRatioInit();
+
+double divPitchRatio(int step) {
+  int oct=step/(12*128);
+  int frac=step-oct*(12*128);
+  if (frac<0) {
+    frac+=12*128;
+    oct--;
+  }
+  return ldexp(linearPitchRatio[frac],oct);
+}
 
 
  
\ No newline at end of file
@@ -19,6 +19,8 @@
 
 #include "../dispatch.h"
 #include "../../ta-log.h"
+#include <stdlib.h>
+#include <string.h>
 
 void DivDispatch::acquire(short** buf, size_t len) {
 }
@@ -74,6 +76,10 @@ int DivDispatch::getRegisterPoolDepth() {
   return 8;
 }
 
+bool DivDispatch::isRegWriteIdempotent(unsigned int addr) {
+  return false;
+}
+
 void* DivDispatch::getState() {
   return NULL;
 }
@@ -81,6 +87,9 @@ void* DivDispatch::getState() {
 void DivDispatch::setState(void* state) {
 }
 
+void DivDispatch::freeState(void* state) {
+}
+
 void DivDispatch::muteChannel(int ch, bool mute) {
 }
 
@@ -141,6 +150,19 @@ bool DivDispatch::hasAcquireDirect() {
   return false;
 }
 
+bool DivDispatch::hasChanOutputs() {
+  return false;
+}
+
+bool DivDispatch::setChanOutputs(short** bufs) {
+  if (bufs!=NULL && !hasChanOutputs()) {
+    chanOutBuf=NULL;
+    return false;
+  }
+  chanOutBuf=bufs;
+  return true;
+}
+
 bool DivDispatch::getWantPreNote() {
   return false;
 }
@@ -193,10 +215,44 @@ void DivDispatch::toggleRegisterDump(bool enable) {
   dumpWrites=enable;
 }
 
+// block size for clearSampleMem(). should be at least a page.
+#define SAMPLE_MEM_CLEAR_BLOCK 4096
+
+void* DivDispatch::allocSampleMem(size_t len) {
+  return calloc(len,1);
+}
+
+void DivDispatch::freeSampleMem(void* mem) {
+  free(mem);
+}
+
+void DivDispatch::clearSampleMem(void* mem, size_t len) {
+  if (mem==NULL) return;
+  unsigned char* buf=(unsigned char*)mem;
+  for (size_t i=0; i<len; i+=SAMPLE_MEM_CLEAR_BLOCK) {
+    size_t blockLen=MIN((size_t)SAMPLE_MEM_CLEAR_BLOCK,len-i);
+    // reading a page which was never written doesn't map it
+    bool isZero=true;
+    for (size_t j=0; j<blockLen; j++) {
+      if (buf[i+j]!=0) {
+        isZero=false;
+        break;
+      }
+    }
+    if (!isZero) memset(&buf[i],0,blockLen);
+  }
+}
+
 std::vector<DivRegWrite>& DivDispatch::getRegisterWrites() {
   return regWrites;
 }
 
+unsigned int DivDispatch::takeWriteCount() {
+  unsigned int ret=writeCount;
+  writeCount=0;
+  return ret;
+}
+
 void DivDispatch::poke(unsigned int addr, unsigned short val) {
 
 }
@@ -246,6 +302,10 @@ void DivDispatch::renderSamples(int sysID) {
   
 }
 
+bool DivDispatch::copySamplesFrom(DivDispatch* other) {
+  return false;
+}
+
 void DivDispatch::notifyPitchTable() {
 }
 
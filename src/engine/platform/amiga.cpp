@@ -83,7 +83,7 @@ void DivPlatformAmiga::acquire(short** buf, size_t len) {
 }
 
 void DivPlatformAmiga::acquireDirect(blip_buffer_t** bb, size_t len) {
-  thread_local int outL, outR, output;
+  int outL=0, outR=0, output=0;
 
   for (int i=0; i<4; i++) {
     oscBuf[i]->begin(len);
@@ -419,6 +419,7 @@ void DivPlatformAmiga::rWrite(unsigned short addr, unsigned short val) {
 
   //logV("%.3x = %.4x",addr,val);
   if (!skipRegisterWrites) {
+    writeCount++;
     writes.push(QueuedWrite(addr,val));
     regPool[addr>>1]=val;
 
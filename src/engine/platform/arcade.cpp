@@ -52,7 +52,7 @@ const char** DivPlatformArcade::getRegisterSheet() {
 }
 
 void DivPlatformArcade::acquire_nuked(short** buf, size_t len) {
-  thread_local int o[2];
+  int o[2]={0};
 
   for (int i=0; i<8; i++) {
     oscBuf[i]->begin(len);
@@ -60,27 +60,37 @@ void DivPlatformArcade::acquire_nuked(short** buf, size_t len) {
 
   for (size_t h=0; h<len; h++) {
     if (delay>0) delay--;
-    for (int i=0; i<8; i++) {
-      if (delay<=0 && !writes.empty() && !fm.write_busy) {
-        QueuedWrite& w=writes.front();
-        if (w.addr==0xfffffffe) {
-          delay=w.val*2;
-          writes.pop_front();
-        } else if (w.addrOrVal) {
-          OPM_Write(&fm,1,w.val);
-          regPool[w.addr&0xff]=w.val;
-          //printf("write: %x = %.2x\n",w.addr,w.val);
-          writes.pop_front();
-        } else {
-          OPM_Write(&fm,0,w.addr);
-          w.addrOrVal=true;
-        }
+    // no write can happen during this sample, so clock the chip straight away.
+    if (delay>0 || writes.empty()) {
+      for (int i=0; i<8; i++) {
+        OPM_Clock(&fm,NULL,NULL,NULL,NULL);
+        OPM_Clock(&fm,NULL,NULL,NULL,NULL);
+        OPM_Clock(&fm,NULL,NULL,NULL,NULL);
+        OPM_Clock(&fm,o,NULL,NULL,NULL);
       }
+    } else {
+      for (int i=0; i<8; i++) {
+        if (delay<=0 && !writes.empty() && !fm.write_busy) {
+          QueuedWrite& w=writes.front();
+          if (w.addr==0xfffffffe) {
+            delay=w.val*2;
+            writes.pop_front();
+          } else if (w.addrOrVal) {
+            OPM_Write(&fm,1,w.val);
+            regPool[w.addr&0xff]=w.val;
+            //printf("write: %x = %.2x\n",w.addr,w.val);
+            writes.pop_front();
+          } else {
+            OPM_Write(&fm,0,w.addr);
+            w.addrOrVal=true;
+          }
+        }
 
-      OPM_Clock(&fm,NULL,NULL,NULL,NULL);
-      OPM_Clock(&fm,NULL,NULL,NULL,NULL);
-      OPM_Clock(&fm,NULL,NULL,NULL,NULL);
-      OPM_Clock(&fm,o,NULL,NULL,NULL);
+        OPM_Clock(&fm,NULL,NULL,NULL,NULL);
+        OPM_Clock(&fm,NULL,NULL,NULL,NULL);
+        OPM_Clock(&fm,NULL,NULL,NULL,NULL);
+        OPM_Clock(&fm,o,NULL,NULL,NULL);
+      }
     }
 
     for (int i=0; i<8; i++) {
@@ -104,7 +114,7 @@ void DivPlatformArcade::acquire_nuked(short** buf, size_t len) {
 }
 
 void DivPlatformArcade::acquire_ymfm(short** buf, size_t len) {
-  thread_local int os[2];
+  int os[2]={0};
 
   ymfm::ym2151::fm_engine* fme=fm_ymfm->debug_engine();
 
@@ -945,6 +955,11 @@ int DivPlatformArcade::getRegisterPoolSize() {
   return 256;
 }
 
+bool DivPlatformArcade::isRegWriteIdempotent(unsigned int addr) {
+  // channel and operator registers (0x08 is key on and 0x01 resets the LFO)
+  return (addr>=0x20 && addr<0x100);
+}
+
 void DivPlatformArcade::poke(unsigned int addr, unsigned short val) {
   immWrite(addr,val);
 }
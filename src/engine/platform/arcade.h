@@ -70,6 +70,7 @@ class DivPlatformArcade: public DivPlatformOPM {
     DivDispatchOscBuffer* getOscBuffer(int chan);
     unsigned char* getRegisterPool();
     int getRegisterPoolSize();
+    bool isRegWriteIdempotent(unsigned int addr);
     void reset();
     void forceIns();
     void tick(bool sysTick=true);
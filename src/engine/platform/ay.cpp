@@ -25,7 +25,7 @@
 #include <math.h>
 
 #define rWrite(a,v) if (!skipRegisterWrites) {pendingWrites[a]=v;}
-#define immWrite(a,v) if (!skipRegisterWrites) {writes.push(QueuedWrite(regRemap(a),v)); if (dumpWrites) {addWrite(regRemap(a),v);} }
+#define immWrite(a,v) if (!skipRegisterWrites) {writeCount++; writes.push(QueuedWrite(regRemap(a),v)); if (dumpWrites) {addWrite(regRemap(a),v);} }
 
 #define CHIP_DIVIDER (extMode?extDiv:((sunsoft||clockSel)?16:8))
 
@@ -255,7 +255,7 @@ void DivPlatformAY8910::checkWrites() {
 }
 
 void DivPlatformAY8910::acquire_mame(blip_buffer_t** bb, size_t len) {
-  thread_local short ayBuf[3];
+  short ayBuf[3]={0};
 
   for (int i=0; i<3; i++) {
     oscBuf[i]->begin(len);
@@ -1026,6 +1026,12 @@ int DivPlatformAY8910::getRegisterPoolSize() {
   return 16;
 }
 
+bool DivPlatformAY8910::isRegWriteIdempotent(unsigned int addr) {
+  // writing the envelope shape restarts the envelope
+  if (intellivision) return false;
+  return (addr<13);
+}
+
 void DivPlatformAY8910::flushWrites() {
   while (!writes.empty()) writes.pop();
 }
@@ -170,6 +170,7 @@ class DivPlatformAY8910: public DivDispatch {
     float getGain(int ch, int vol);
     unsigned char* getRegisterPool();
     int getRegisterPoolSize();
+    bool isRegWriteIdempotent(unsigned int addr);
     void setCore(unsigned char core);
     void flushWrites();
     void reset();
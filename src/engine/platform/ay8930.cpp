@@ -25,7 +25,7 @@
 #include <math.h>
 
 #define rWrite(a,v) if (!skipRegisterWrites) {pendingWrites[a]=v;}
-#define immWrite2(a,v) if (!skipRegisterWrites) {writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);} }
+#define immWrite2(a,v) if (!skipRegisterWrites) {writeCount++; writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);} }
 
 #define CHIP_DIVIDER (clockSel?8:4)
 
@@ -165,7 +165,7 @@ void DivPlatformAY8930::checkWrites() {
 }
 
 void DivPlatformAY8930::acquireDirect(blip_buffer_t** bb, size_t len) {
-  thread_local short ayBuf[3];
+  short ayBuf[3]={0};
   for (int i=0; i<3; i++) {
     oscBuf[i]->begin(len);
   }
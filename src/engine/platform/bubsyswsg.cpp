@@ -18,12 +18,13 @@
  */
 
 #include "bubsyswsg.h"
+#include "chipUtils.h"
 #include "../engine.h"
 #include <math.h>
 
 #define CHIP_DIVIDER 32
 
-#define rWrite(a,v) {if(!skipRegisterWrites) {regPool[a]=v; if(dumpWrites) addWrite(a,v); }}
+#define rWrite(a,v) {if(!skipRegisterWrites) {writeCount++; regPool[a]=v; if(dumpWrites) addWrite(a,v); }}
 
 const char* regCheatSheetBubSysWSG[]={
   // K005289 timer
@@ -40,44 +41,35 @@ const char** DivPlatformBubSysWSG::getRegisterSheet() {
 }
 
 void DivPlatformBubSysWSG::acquireDirect(blip_buffer_t** bb, size_t len) {
-  int chanOut=0;
   for (int i=0; i<2; i++) {
     oscBuf[i]->begin(len);
   }
-  for (size_t h=0; h<len; h++) {
-    int advance=len-h;
-    // heuristic
+  divRunEvents(len,[this](int advance) -> int {
     for (int i=0; i<2; i++) {
       const int remain=k005289.m_timer[i].m_counter;
       if (remain<advance) advance=remain;
     }
-    if (advance<1) advance=1;
-
+    return advance;
+  },[this,bb](size_t h, int advance) {
     signed int out=0;
     // K005289 part
     k005289.tick(advance);
 
-    h+=advance-1;
-
     // Wavetable part
     for (int i=0; i<2; i++) {
       if (isMuted[i]) {
         oscBuf[i]->putSample(h,0);
         continue;
       } else {
-        chanOut=chan[i].waveROM[k005289.addr(i)]*(regPool[2+i]&0xf);
+        int chanOut=chan[i].waveROM[k005289.addr(i)]*(regPool[2+i]&0xf);
         out+=chanOut;
         oscBuf[i]->putSample(h,chanOut<<7);
       }
     }
 
-    out<<=6; // scale output to 16 bit
-
-    if (out!=lastOut) {
-      blip_add_delta(bb[0],h,out-lastOut);
-      lastOut=out;
-    }
-  }
+    // scale output to 16 bit
+    divBlipPut(bb[0],h,out<<6,lastOut);
+  });
   for (int i=0; i<2; i++) {
     oscBuf[i]->end(len);
   }
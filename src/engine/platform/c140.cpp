@@ -19,12 +19,14 @@
 
 #include "c140.h"
 #include "../engine.h"
+#include "../sampleRAM.h"
 #include "../../ta-log.h"
 #include <math.h>
+#include <algorithm>
 
 #define CHIP_FREQBASE (is219?74448896:12582912)
 
-#define rWrite(a,v) {if(!skipRegisterWrites) {writes.push(QueuedWrite(a,v)); if(dumpWrites) addWrite(a,v); }}
+#define rWrite(a,v) {if(!skipRegisterWrites) {writeCount++; writes.push(QueuedWrite(a,v)); if(dumpWrites) addWrite(a,v); }}
 
 const char* regCheatSheetC140[]={
   "CHx_RVol", "00+x*10",
@@ -623,7 +625,8 @@ void DivPlatformC140::renderSamples(int sysID) {
   memCompo=DivMemoryComposition();
   memCompo.name="Sample ROM";
 
-  size_t memPos=0;
+  // samples may not cross a 128K bank
+  std::vector<DivSamplePacker::Item> items;
   for (int i=0; i<parent->song.sampleLen; i++) {
     DivSample* s=parent->song.sample[i];
     if (!s->renderOn[0][sysID]) {
@@ -631,25 +634,31 @@ void DivPlatformC140::renderSamples(int sysID) {
       continue;
     }
 
+    unsigned int length=(is219?s->length8:s->length16)+4;
+    // fit sample size to single bank size
+    if (length>131072) {
+      length=131072;
+    }
+    if (length&1) length++;
+    items.push_back(DivSamplePacker::Item(i,length));
+  }
+  size_t memPos=0;
+  if (packSamples) {
+    memPos=DivSamplePacker::pack(items,getSampleMemCapacity()-1,131072,2);
+  } else {
+    memPos=DivSamplePacker::packInOrder(items,getSampleMemCapacity(),131072,2);
+  }
+
+  for (DivSamplePacker::Item& item: items) {
+    DivSample* s=parent->song.sample[item.index];
+    size_t pos=item.pos;
+    unsigned int length=item.len;
+    if (!item.placed || item.truncated) {
+      logW("out of %s memory for sample %d!",is219?"C219":"C140",item.index);
+    }
+    if (!item.placed) continue;
+
     if (is219) { // C219 (8-bit)
-      unsigned int length=s->length8+4;
-      // fit sample size to single bank size
-      if (length>131072) {
-        length=131072;
-      }
-      if (length&1) length++;
-      if ((memPos&0xfe0000)!=((memPos+length)&0xfe0000)) {
-        memPos=((memPos+0x1ffff)&0xfe0000);
-      }
-      logV("%d",length);
-      if (memPos>=(getSampleMemCapacity())) {
-        logW("out of C219 memory for sample %d!",i);
-        break;
-      }
-      if (memPos+length>=(getSampleMemCapacity())) {
-        length=getSampleMemCapacity()-memPos;
-        logW("out of C219 memory for sample %d!",i);
-      }
       if (s->depth==DIV_SAMPLE_DEPTH_C219) {
         unsigned char next=0;
         unsigned int sPos=0;
@@ -662,7 +671,7 @@ void DivPlatformC140::renderSamples(int sysID) {
               }
             }
           }
-          sampleMem[(memPos+i)^1]=next;
+          sampleMem[(pos+i)^1]=next;
         }
       } else {
         signed char next=0;
@@ -676,39 +685,20 @@ void DivPlatformC140::renderSamples(int sysID) {
               }
             }
           }
-          sampleMem[(memPos+i)^1]=next;
+          sampleMem[(pos+i)^1]=next;
         }
       }
-      sampleOff[i]=memPos>>1;
-      sampleLoaded[i]=true;
-      memCompo.entries.push_back(DivMemoryEntry((DivMemoryEntryType)(DIV_MEMORY_BANK0+((memPos>>17)&3)),"Sample",i,memPos,memPos+length));
-      memPos+=length;
+      memCompo.entries.push_back(DivMemoryEntry((DivMemoryEntryType)(DIV_MEMORY_BANK0+((pos>>17)&3)),"Sample",item.index,pos,pos+length));
     } else { // C140 (16-bit)
-      unsigned int length=s->length16+4;
-      // fit sample size to single bank size
-      if (length>(131072)) {
-        length=131072;
-      }
-      if ((memPos&0xfe0000)!=((memPos+length)&0xfe0000)) {
-        memPos=((memPos+0x1ffff)&0xfe0000);
-      }
-      if (memPos>=(getSampleMemCapacity())) {
-        logW("out of C140 memory for sample %d!",i);
-        break;
-      }
       // why is C140 not G.711-compliant? this weird bit mangling had me puzzled for 3 hours...
-      if (memPos+length>=(getSampleMemCapacity())) {
-        length=getSampleMemCapacity()-memPos;
-        logW("out of C140 memory for sample %d!",i);
-      }
       if (s->depth==DIV_SAMPLE_DEPTH_MULAW) {
         for (unsigned int i=0; i<length; i+=2) {
           if ((i>>1)>=s->lengthMuLaw) break;
           unsigned char x=s->dataMuLaw[i>>1]^0xff;
           if (x&0x80) x^=15;
           unsigned char c140Mu=(x&0x80)|((x&15)<<3)|((x&0x70)>>4);
-          sampleMem[i+memPos]=0;
-          sampleMem[1+i+memPos]=c140Mu;
+          sampleMem[i+pos]=0;
+          sampleMem[1+i+pos]=c140Mu;
         }
       } else {
         short next=0;
@@ -722,16 +712,18 @@ void DivPlatformC140::renderSamples(int sysID) {
               }
             }
           }
-          sampleMem[memPos+i]=((unsigned short)next);
-          sampleMem[memPos+i+1]=((unsigned short)next)>>8;
+          sampleMem[pos+i]=((unsigned short)next);
+          sampleMem[pos+i+1]=((unsigned short)next)>>8;
         }
       }
-      sampleOff[i]=memPos>>1;
-      sampleLoaded[i]=true;
-      memCompo.entries.push_back(DivMemoryEntry(DIV_MEMORY_SAMPLE,"Sample",i,memPos,memPos+length));
-      memPos+=length;
+      memCompo.entries.push_back(DivMemoryEntry(DIV_MEMORY_SAMPLE,"Sample",item.index,pos,pos+length));
     }
+    sampleOff[item.index]=pos>>1;
+    sampleLoaded[item.index]=true;
   }
+  std::sort(memCompo.entries.begin(),memCompo.entries.end(),[](const DivMemoryEntry& a, const DivMemoryEntry& b) {
+    return a.begin<b.begin;
+  });
   sampleMemLen=memPos+256;
 
   memCompo.used=sampleMemLen;
@@ -764,6 +756,7 @@ void DivPlatformC140::setFlags(const DivConfig& flags) {
     rate=chipClock/192;
   }
   bankType=flags.getInt("bankType",0);
+  packSamples=flags.getBool("packSamples",false);
   if (!is219) {
     c140_bank_type(&c140,bankType);
   }
@@ -772,6 +765,24 @@ void DivPlatformC140::setFlags(const DivConfig& flags) {
   }
 }
 
+bool DivPlatformC140::copySamplesFrom(DivDispatch* other) {
+  DivPlatformC140* o=(DivPlatformC140*)other;
+  if (o->is219!=is219) return false;
+
+  size_t capacity=is219?524288:16777216;
+  size_t oldLen=MIN(sampleMemLen,capacity);
+  size_t newLen=MIN(o->sampleMemLen,capacity);
+
+  // clear what the previous render left past the end
+  if (oldLen>newLen) memset(&sampleMem[newLen],0,oldLen-newLen);
+  memcpy(sampleMem,o->sampleMem,newLen);
+  memcpy(sampleOff,o->sampleOff,32768*sizeof(unsigned int));
+  memcpy(sampleLoaded,o->sampleLoaded,32768*sizeof(bool));
+  sampleMemLen=o->sampleMemLen;
+  memCompo=o->memCompo;
+  return true;
+}
+
 int DivPlatformC140::init(DivEngine* p, int channels, int sugRate, const DivConfig& flags) {
   parent=p;
   dumpWrites=false;
@@ -58,6 +58,7 @@ class DivPlatformC140: public DivDispatch {
   unsigned int* sampleOff;
   bool* sampleLoaded;
   bool is219;
+  bool packSamples;
   int totalChans;
   unsigned char groupBank[4];
   unsigned char bankType;
@@ -112,6 +113,7 @@ class DivPlatformC140: public DivDispatch {
     bool isSampleLoaded(int index, int sample);
     const DivMemoryComposition* getMemCompo(int index);
     void renderSamples(int chipID);
+    bool copySamplesFrom(DivDispatch* other);
     int getClockRangeMin();
     int getClockRangeMax();
     void set219(bool is_219);
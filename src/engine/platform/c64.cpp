@@ -24,7 +24,7 @@
 #include <math.h>
 #include "../../ta-log.h"
 
-#define rWrite(a,v) if (!skipRegisterWrites) {writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);} }
+#define rWrite(a,v) if (!skipRegisterWrites) {writeCount++; writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);} }
 
 #define CHIP_FREQBASE 524288
 
@@ -137,12 +137,17 @@ void DivPlatformC64::processDAC(int sRate) {
   if (didWrite && !isMuted[3]) updateVolume();
 }
 
-void DivPlatformC64::acquire(short** buf, size_t len) {
-  int dcOff=(sidCore)?0:sid->get_dc(0);
+// core 0: reSID
+// core 1: reSIDfp
+// core 2: dSID
+template<int core> void DivPlatformC64::acquireCore(short** buf, size_t len) {
+  // reSID runs at the chip clock, so its oscilloscope is decimated further
+  const int oscDecimation=(core==0)?16:4;
+  int dcOff=(core)?0:sid->get_dc(0);
   for (int i=0; i<4; i++) {
     oscBuf[i]->begin(len);
   }
-  for (size_t i=0; i<len; i++) {
+  for (size_t i=0; i<len;) {
     // run PCM
     pcmCycle+=lineRate;
     while (pcmCycle>=(rate*2)) {
@@ -153,9 +158,9 @@ void DivPlatformC64::acquire(short** buf, size_t len) {
     // the rest
     if (!writes.empty()) {
       QueuedWrite w=writes.front();
-      if (sidCore==2) {
+      if (core==2) {
         dSID_write(sid_d,w.addr,w.val);
-      } else if (sidCore==1) {
+      } else if (core==1) {
         sid_fp->write(w.addr,w.val);
       } else {
         sid->write(w.addr,w.val);
@@ -163,35 +168,46 @@ void DivPlatformC64::acquire(short** buf, size_t len) {
       regPool[w.addr&0x1f]=w.val;
       writes.pop();
     }
-    if (sidCore==2) {
+
+    // reSIDfp can clock several samples in one call.
+    // do so until the next write, PCM step or oscilloscope sample.
+    size_t span=1;
+    if (core==1 && writes.empty()) {
+      span=MIN(len-i,(size_t)(oscDecimation-writeOscBuf));
+      if (lineRate>0) {
+        size_t untilPCM=((rate*2)-pcmCycle+lineRate-1)/lineRate;
+        if (untilPCM<span) span=MAX(untilPCM,(size_t)1);
+      }
+      pcmCycle+=lineRate*(span-1);
+    }
+
+    if (core==2) {
       double o=dSID_render(sid_d);
       buf[0][i]=32767*CLAMP(o,-1.0,1.0);
-      if (++writeOscBuf>=4) {
-        writeOscBuf=0;
-        oscBuf[0]->putSample(i,sid_d->lastOut[0]);
-        oscBuf[1]->putSample(i,sid_d->lastOut[1]);
-        oscBuf[2]->putSample(i,sid_d->lastOut[2]);
-        oscBuf[3]->putSample(i,isMuted[3]?0:(chan[3].pcmOut<<11));
-      }
-    } else if (sidCore==1) {
-      sid_fp->clock(4,&buf[0][i]);
-      if (++writeOscBuf>=4) {
-        writeOscBuf=0;
-        oscBuf[0]->putSample(i,runFakeFilter(0,(sid_fp->lastChanOut[0]-dcOff)>>5));
-        oscBuf[1]->putSample(i,runFakeFilter(1,(sid_fp->lastChanOut[1]-dcOff)>>5));
-        oscBuf[2]->putSample(i,runFakeFilter(2,(sid_fp->lastChanOut[2]-dcOff)>>5));
-        oscBuf[3]->putSample(i,isMuted[3]?0:(chan[3].pcmOut<<11));
-      }
+    } else if (core==1) {
+      sid_fp->clock(4*span,&buf[0][i]);
     } else {
       sid->clock();
       buf[0][i]=sid->output();
-      if (++writeOscBuf>=16) {
-        writeOscBuf=0;
-        oscBuf[0]->putSample(i,runFakeFilter(0,(sid->last_chan_out[0]-dcOff)>>5));
-        oscBuf[1]->putSample(i,runFakeFilter(1,(sid->last_chan_out[1]-dcOff)>>5));
-        oscBuf[2]->putSample(i,runFakeFilter(2,(sid->last_chan_out[2]-dcOff)>>5));
-        oscBuf[3]->putSample(i,isMuted[3]?0:(chan[3].pcmOut<<11));
+    }
+    i+=span;
+    writeOscBuf+=span;
+    if (writeOscBuf>=oscDecimation) {
+      writeOscBuf=0;
+      if (core==2) {
+        oscBuf[0]->putSample(i-1,sid_d->lastOut[0]);
+        oscBuf[1]->putSample(i-1,sid_d->lastOut[1]);
+        oscBuf[2]->putSample(i-1,sid_d->lastOut[2]);
+      } else if (core==1) {
+        oscBuf[0]->putSample(i-1,runFakeFilter(0,(sid_fp->lastChanOut[0]-dcOff)>>5));
+        oscBuf[1]->putSample(i-1,runFakeFilter(1,(sid_fp->lastChanOut[1]-dcOff)>>5));
+        oscBuf[2]->putSample(i-1,runFakeFilter(2,(sid_fp->lastChanOut[2]-dcOff)>>5));
+      } else {
+        oscBuf[0]->putSample(i-1,runFakeFilter(0,(sid->last_chan_out[0]-dcOff)>>5));
+        oscBuf[1]->putSample(i-1,runFakeFilter(1,(sid->last_chan_out[1]-dcOff)>>5));
+        oscBuf[2]->putSample(i-1,runFakeFilter(2,(sid->last_chan_out[2]-dcOff)>>5));
       }
+      oscBuf[3]->putSample(i-1,isMuted[3]?0:(chan[3].pcmOut<<11));
     }
   }
   for (int i=0; i<4; i++) {
@@ -199,6 +215,20 @@ void DivPlatformC64::acquire(short** buf, size_t len) {
   }
 }
 
+void DivPlatformC64::acquire(short** buf, size_t len) {
+  switch (sidCore) {
+    case 2:
+      acquireCore<2>(buf,len);
+      break;
+    case 1:
+      acquireCore<1>(buf,len);
+      break;
+    default:
+      acquireCore<0>(buf,len);
+      break;
+  }
+}
+
 void DivPlatformC64::updateFilter() {
   rWrite(0x15,filtCut&7);
   rWrite(0x16,filtCut>>3);
@@ -107,6 +107,8 @@ class DivPlatformC64: public DivDispatch {
   inline short runFakeFilter(unsigned char ch, int in);
 
   void processDAC(int sRate);
+  // the core is a template parameter, so that the sample loop doesn't have to check it.
+  template<int core> void acquireCore(short** buf, size_t len);
   void acquire_classic(short* bufL, short* bufR, size_t start, size_t len);
   void acquire_fp(short* bufL, short* bufR, size_t start, size_t len);
 
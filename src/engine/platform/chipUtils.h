@@ -0,0 +1,66 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2026 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _CHIPUTILS_H
+#define _CHIPUTILS_H
+
+#include "blip_buf.h"
+
+// helpers for acquireDirect() implementations.
+
+/**
+ * add a delta to a blip_buf when the output changes.
+ * @param bb the buffer.
+ * @param pos position in the buffer.
+ * @param val the new output value.
+ * @param last the previous output value (updated).
+ */
+inline void divBlipPut(blip_buffer_t* bb, size_t pos, int val, int& last) {
+  if (val!=last) {
+    blip_add_delta(bb,pos,val-last);
+    last=val;
+  }
+}
+
+/**
+ * render a chip in an event-driven fashion.
+ * instead of clocking the chip once per sample, this asks it how long its
+ * output will stay constant, runs it over that span in one go and reads the
+ * output once at the end. idle chips cost next to nothing.
+ * @param len number of samples to render.
+ * @param nextEvent int(int limit): returns how many samples to run until the
+ * output may change (the change happens on the last one). this includes any
+ * pending writes. return limit (or more) if nothing will happen. a result below
+ * 1 runs a single sample.
+ * @param advance void(size_t pos, int count): runs the chip for `count`
+ * samples. `pos` is the position of the last one, which is where the output
+ * shall be read (e.g. with divBlipPut()).
+ */
+template<typename NextEvent, typename Advance> inline void divRunEvents(size_t len, NextEvent nextEvent, Advance advance) {
+  for (size_t h=0; h<len; h++) {
+    int remain=(int)(len-h);
+    int count=nextEvent(remain);
+    if (count>remain) count=remain;
+    if (count<1) count=1;
+    h+=count-1;
+    advance(h,count);
+  }
+}
+
+#endif
@@ -38,12 +38,15 @@ void DivPlatformDummy::acquire(short** buf, size_t len) {
           oscBuf[j]->putSample(i,chanOut<<1);
           out+=chanOut;
         } else {
+          chanOut=0;
           oscBuf[j]->putSample(i,0);
         }
         chan[j].pos+=chan[j].freq;
       } else {
+        chanOut=0;
         oscBuf[j]->putSample(i,0);
       }
+      if (chanOutBuf!=NULL) chanOutBuf[j][i]=chanOut;
     }
     if (out<-32768) out=-32768;
     if (out>32767) out=32767;
@@ -58,6 +61,10 @@ void DivPlatformDummy::muteChannel(int ch, bool mute) {
   isMuted[ch]=mute;
 }
 
+bool DivPlatformDummy::hasChanOutputs() {
+  return true;
+}
+
 void DivPlatformDummy::tick(bool sysTick) {
   for (unsigned char i=0; i<chans; i++) {
     if (sysTick) {
@@ -39,6 +39,7 @@ class DivPlatformDummy: public DivDispatch {
   public:
     void acquire(short** buf, size_t len);
     void muteChannel(int ch, bool mute);
+    bool hasChanOutputs();
     int dispatch(DivCommand c);
     void notifyInsDeletion(void* ins);
     void* getChanState(int chan);
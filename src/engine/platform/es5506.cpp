@@ -25,7 +25,7 @@
 #define PITCH_OFFSET ((double)(16*2048*(chanMax+1)))
 #define NOTE_ES5506(c,note) ((amigaPitch && !parent->song.compatFlags.linearPitch)?parent->calcBaseFreq(COLOR_NTSC*16,chan[c].pcm.freqOffs,note,true):parent->calcBaseFreq(chipClock,chan[c].pcm.freqOffs,note,false))
 
-#define rWrite(a,...) {if(!skipRegisterWrites) {hostIntf32.push_back(QueuedHostIntf(4,(a),__VA_ARGS__)); }}
+#define rWrite(a,...) {if(!skipRegisterWrites) {writeCount++; hostIntf32.push_back(QueuedHostIntf(4,(a),__VA_ARGS__)); }}
 #define immWrite(a,...) {hostIntf32.push_back(QueuedHostIntf(4,(a),__VA_ARGS__));}
 #define pageWrite(p,a,d) \
   if (!skipRegisterWrites) { \
@@ -210,38 +210,22 @@ void DivPlatformES5506::acquire(short** buf, size_t len) {
     oscBuf[i]->begin(len);
   }
   for (size_t h=0; h<len; h++) {
-    // convert 32 bit access to 8 bit host interface
-    while (!hostIntf32.empty()) {
-      QueuedHostIntf w=hostIntf32.front();
-      if (w.isRead && (w.read!=NULL)) {
-        hostIntf8.push(QueuedHostIntf(w.state,0,w.addr,w.read));
-        hostIntf8.push(QueuedHostIntf(w.state,1,w.addr,w.read));
-        hostIntf8.push(QueuedHostIntf(w.state,2,w.addr,w.read));
-        hostIntf8.push(QueuedHostIntf(w.state,3,w.addr,w.read,w.delay));
-      } else {
-        hostIntf8.push(QueuedHostIntf(0,w.addr,w.val));
-        hostIntf8.push(QueuedHostIntf(1,w.addr,w.val));
-        hostIntf8.push(QueuedHostIntf(2,w.addr,w.val));
-        hostIntf8.push(QueuedHostIntf(3,w.addr,w.val,w.delay));
-      }
-      hostIntf32.pop();
-    }
-
     es5506.tick_perf();
     if (cycle>0) { // wait until delay
       cycle-=2;
-    } else while (!hostIntf8.empty()) {
-      QueuedHostIntf w=hostIntf8.front();
-      unsigned char shift=24-(w.step<<3);
+    } else while (!hostIntf32.empty()) {
+      // every write which is due is applied now, a whole register at a time
+      // (the 4 bytes of a register were always written together anyway)
+      const QueuedHostIntf& w=hostIntf32.front();
       if (w.isRead) {
         logE("READING?!");
-        hostIntf8.pop();
+        hostIntf32.pop();
       } else {
-        es5506.host_w((w.addr<<2)+w.step,(w.val>>shift)&0xff);
-        if ((w.step==3) && (w.delay>0)) {
+        es5506.host_w32(w.addr,w.val);
+        if (w.delay>0) {
           cycle+=w.delay;
         }
-        hostIntf8.pop();
+        hostIntf32.pop();
         if (cycle>0) break;
       }
     }
@@ -1325,7 +1309,6 @@ unsigned short DivPlatformES5506::getPan(int ch) {
 
 void DivPlatformES5506::reset() {
   while (!hostIntf32.empty()) hostIntf32.pop();
-  while (!hostIntf8.empty()) hostIntf8.pop();
   for (int i=0; i<32; i++) {
     chan[i]=DivPlatformES5506::Channel();
     chan[i].vol=amigaVol?64:255;
@@ -1458,7 +1441,7 @@ const DivMemoryComposition* DivPlatformES5506::getMemCompo(int index) {
 }
 
 void DivPlatformES5506::renderSamples(int sysID) {
-  memset(sampleMem,0,getSampleMemCapacity());
+  clearSampleMem(sampleMem,getSampleMemCapacity());
   memset(sampleOffES5506,0,32768*sizeof(unsigned int));
   memset(sampleLoaded,0,32768*sizeof(bool));
 
@@ -1508,7 +1491,7 @@ void DivPlatformES5506::renderSamples(int sysID) {
 }
 
 int DivPlatformES5506::init(DivEngine* p, int channels, int sugRate, const DivConfig& flags) {
-  sampleMem=new signed short[getSampleMemCapacity()/sizeof(short)];
+  sampleMem=(signed short*)allocSampleMem(getSampleMemCapacity());
   sampleMemLen=0;
   parent=p;
   dumpWrites=false;
@@ -1528,7 +1511,7 @@ int DivPlatformES5506::init(DivEngine* p, int channels, int sugRate, const DivCo
 }
 
 void DivPlatformES5506::quit() {
-  delete[] sampleMem;
+  freeSampleMem(sampleMem);
   for (int i=0; i<32; i++) {
     delete oscBuf[i];
   }
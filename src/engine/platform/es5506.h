@@ -268,7 +268,6 @@ class DivPlatformES5506: public DivDispatch, public es550x_intf {
         isRead(true) {}
   };
   FixedQueue<QueuedHostIntf,2048> hostIntf32;
-  FixedQueue<QueuedHostIntf,2048> hostIntf8;
   int cycle, curPage, volScale;
   unsigned int irqv;
   bool isReaded;
@@ -39,7 +39,7 @@
 #define KEY_ON_REGS_START (18*8*4)
 
 void DivPlatformESFM::acquire(short** buf, size_t len) {
-  thread_local short o[2];
+  short o[2]={0};
   for (int i=0; i<18; i++) {
     oscBuf[i]->begin(len);
   }
@@ -67,7 +67,7 @@ void DivPlatformESFM::acquire(short** buf, size_t len) {
 }
 
 void DivPlatformESFM::acquireDirect(blip_buffer_t** bb, size_t len) {
-  thread_local short o[2];
+  short o[2]={0};
   unsigned int sharedNeedlePos=oscBuf[0]->needle;
   for (int i=0; i<18; i++) {
     oscBuf[i]->begin(len);
@@ -231,6 +231,14 @@ class DivPlatformOPN: public DivPlatformFMBase {
       }
       return DivPlatformFMBase::getGain(ch,vol);
     }
+    virtual bool isRegWriteIdempotent(unsigned int addr) {
+      // operator parameters, feedback/algorithm and panning.
+      // 0xa0-0xaf are not included because the high frequency byte is latched.
+      if (addr>0x1ff) return false;
+      if (addr==0x22) return true;
+      addr&=0xff;
+      return (addr>=0x30 && addr<0xa0) || (addr>=0xb0 && addr<0xb7);
+    }
 
 };
 
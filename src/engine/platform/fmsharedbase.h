@@ -101,6 +101,7 @@ class DivPlatformFMBase: public DivDispatch {
     }
     inline void immWrite(unsigned int a, unsigned short v) {
       if (!skipRegisterWrites) {
+        writeCount++;
         writes.push_back(QueuedWrite(a,v));
         if (dumpWrites) {
           addWrite(a,v);
@@ -110,6 +111,7 @@ class DivPlatformFMBase: public DivDispatch {
     // only used by OPN2 for DAC writes
     inline void urgentWrite(unsigned short a, unsigned char v) {
       if (!skipRegisterWrites && !flushFirst) {
+        writeCount++;
         writes.push_front(QueuedWrite(a,v,true));
         if (dumpWrites) {
           addWrite(a,v);
@@ -22,7 +22,7 @@
 #include "../../ta-log.h"
 #include <math.h>
 
-#define rWrite(a,v) {if(!skipRegisterWrites) {writes.push(QueuedWrite(a,v)); if(dumpWrites) addWrite(a,v);}}
+#define rWrite(a,v) {if(!skipRegisterWrites) {writeCount++; writes.push(QueuedWrite(a,v)); if(dumpWrites) addWrite(a,v);}}
 
 #define CHIP_DIVIDER 64
 
@@ -52,7 +52,7 @@ inline void DivPlatformGA20::chWrite(unsigned char ch, unsigned int addr, unsign
 }
 
 void DivPlatformGA20::acquire(short** buf, size_t len) {
-  thread_local short ga20Buf[4];
+  short ga20Buf[4]={0};
 
   for (int i=0; i<4; i++) {
     oscBuf[i]->begin(len);
@@ -78,7 +78,7 @@ void DivPlatformGA20::acquire(short** buf, size_t len) {
 }
 
 void DivPlatformGA20::acquireDirect(blip_buffer_t** bb, size_t len) {
-  thread_local short ga20Buf[4];
+  short ga20Buf[4]={0};
 
   for (int i=0; i<4; i++) {
     oscBuf[i]->begin(len);
@@ -22,7 +22,7 @@
 #include "../../ta-log.h"
 #include <math.h>
 
-#define rWrite(a,v) if (!skipRegisterWrites) {writes.push(QueuedWrite(a,v)); regPool[(a)&0x7f]=v; if (dumpWrites) {addWrite(a,v);} }
+#define rWrite(a,v) if (!skipRegisterWrites) {writeCount++; writes.push(QueuedWrite(a,v)); regPool[(a)&0x7f]=v; if (dumpWrites) {addWrite(a,v);} }
 #define immWrite(a,v) {writes.push(QueuedWrite(a,v)); regPool[(a)&0x7f]=v; if (dumpWrites) {addWrite(a,v);} }
 
 #define CHIP_DIVIDER 16
@@ -62,23 +62,33 @@ const char** DivPlatformGB::getRegisterSheet() {
   return regCheatSheetGB;
 }
 
-void DivPlatformGB::acquire(short** buf, size_t len) {
+void DivPlatformGB::acquireDirect(blip_buffer_t** bb, size_t len) {
   for (int i=0; i<4; i++) {
     oscBuf[i]->begin(len);
   }
-  for (size_t i=0; i<len; i++) {
+  for (size_t h=0; h<len; h++) {
     if (!writes.empty()) {
       QueuedWrite& w=writes.front();
       GB_apu_write(gb,w.addr,w.val);
       writes.pop();
     }
 
+    // render() runs once per sample (DAC fade and channel averaging depend on it),
+    // but the output only needs to reach blip_buf when it changes.
     GB_advance_cycles(gb,coreQuality);
-    buf[0][i]=gb->apu_output.final_sample.left;
-    buf[1][i]=gb->apu_output.final_sample.right;
+    int outL=gb->apu_output.final_sample.left;
+    int outR=gb->apu_output.final_sample.right;
+    if (outL!=prevSample[0]) {
+      blip_add_delta(bb[0],h,outL-prevSample[0]);
+      prevSample[0]=outL;
+    }
+    if (outR!=prevSample[1]) {
+      blip_add_delta(bb[1],h,outR-prevSample[1]);
+      prevSample[1]=outR;
+    }
 
     for (int j=0; j<4; j++) {
-      oscBuf[j]->putSample(i,(gb->apu_output.current_sample[j].left+gb->apu_output.current_sample[j].right)<<6);
+      oscBuf[j]->putSample(h,(gb->apu_output.current_sample[j].left+gb->apu_output.current_sample[j].right)<<6);
     }
   }
   for (int i=0; i<4; i++) {
@@ -86,6 +96,10 @@ void DivPlatformGB::acquire(short** buf, size_t len) {
   }
 }
 
+bool DivPlatformGB::hasAcquireDirect() {
+  return true;
+}
+
 void DivPlatformGB::updateWave() {
   if (doubleWave) {
     rWrite(0x1a,0x40); // select 1 -> write to bank 0
@@ -652,6 +666,8 @@ void DivPlatformGB::reset() {
   gb->model=model;
   GB_apu_init(gb);
   GB_set_sample_rate(gb,rate);
+  prevSample[0]=0;
+  prevSample[1]=0;
   // enable all channels
   immWrite(0x10,0);
   immWrite(0x26,0x8f);
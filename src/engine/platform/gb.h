@@ -76,6 +76,7 @@ class DivPlatformGB: public DivDispatch {
   int coreQuality;
   GB_gameboy_t* gb;
   GB_model_t model;
+  int prevSample[2];
   unsigned char regPool[128];
   
   unsigned char procMute();
@@ -83,7 +84,7 @@ class DivPlatformGB: public DivDispatch {
   friend void putDispatchChip(void*,int);
   friend void putDispatchChan(void*,int,int);
   public:
-    void acquire(short** buf, size_t len);
+    void acquireDirect(blip_buffer_t** bb, size_t len);
     int dispatch(DivCommand c);
     void* getChanState(int chan);
     DivMacroInt* getChanMacroInt(int ch);
@@ -98,6 +99,7 @@ class DivPlatformGB: public DivDispatch {
     int getPortaFloor(int ch);
     int getOutputCount();
     bool getDCOffRequired();
+    bool hasAcquireDirect();
     void notifyInsChange(int ins);
     void notifyWaveChange(int wave);
     void notifyInsDeletion(void* ins);
@@ -74,47 +74,75 @@ void DivPlatformGBAMinMod::acquire(short** buf, size_t len) {
           mixOut[1][j]=0;
         }
         for (int i=0; i<chanMax; i++) {
+          // mix this voice into the whole block.
+          // the memory region is only resolved again if the address leaves it.
+          uint64_t address=chState[i].address;
+          const uint64_t step=((uint64_t)chState[i].freq)<<8;
+          const int volL=chState[i].volL;
+          const int volR=chState[i].volR;
+          const bool sum=(chan[i].invertL==chan[i].invertR);
+          int outL=chanOut[i][0];
+          int outR=chanOut[i][1];
+          short osc=volScale>0?(sum?outL+outR:outL-outR)*64/volScale:0;
+          unsigned int region=0xffffffff;
+          const signed char* regionMem=NULL;
+          unsigned int regionMask=0, regionBegin=0, regionLen=0;
           for (size_t j=mixBufOffset; j<4; j++) {
-            unsigned int lastAddr=chState[i].address>>32;
-            chState[i].address+=((uint64_t)chState[i].freq)<<8;
-            unsigned int newAddr=chState[i].address>>32;
+            unsigned int lastAddr=address>>32;
+            address+=step;
+            unsigned int newAddr=address>>32;
             if (newAddr!=lastAddr) {
               if (newAddr>=chState[i].loopEnd) {
                 newAddr=newAddr-chState[i].loopEnd+chState[i].loopStart;
-                chState[i].address=(chState[i].address&0xffffffff)|((uint64_t)newAddr<<32);
+                address=(address&0xffffffff)|((uint64_t)newAddr<<32);
+              }
+              if ((newAddr>>24)!=region) {
+                region=newAddr>>24;
+                regionMem=NULL;
+                switch (region) {
+                  case 2: // wavetable
+                    regionMem=wtMem;
+                    regionMask=0x0003ffff;
+                    regionBegin=0;
+                    regionLen=sizeof(wtMem);
+                    break;
+                  case 3: // echo (the first address after 0x800 is the first sample)
+                    regionMem=&mixBuf[0][1];
+                    regionMask=0x00007fff;
+                    regionBegin=0x801;
+                    regionLen=0x8000-0x801;
+                    break;
+                  case 8: // sample
+                  case 9:
+                  case 10:
+                  case 11:
+                  case 12:
+                    regionMem=sampleMem;
+                    regionMask=0x01ffffff;
+                    regionBegin=0;
+                    regionLen=0x02000000;
+                    break;
+                }
               }
               int newSamp=0;
-              switch (newAddr>>24) {
-                case 2: // wavetable
-                  newAddr&=0x0003ffff;
-                  if (newAddr<sizeof(wtMem)) {
-                    newSamp=wtMem[newAddr];
-                  }
-                  break;
-                case 3: // echo
-                  newAddr&=0x00007fff;
-                  if (newAddr>0x800) {
-                    newSamp=mixBuf[(newAddr-0x800)/1024][newAddr&1023];
-                  }
-                  break;
-                case 8: // sample
-                case 9:
-                case 10:
-                case 11:
-                case 12:
-                  newSamp=sampleMem[newAddr&0x01ffffff];
-                  break;
+              if (regionMem!=NULL) {
+                unsigned int pos=(newAddr&regionMask)-regionBegin;
+                if (pos<regionLen) newSamp=regionMem[pos];
+              }
+              outL=newSamp*volL;
+              outR=newSamp*volR;
+              if (volScale>0) {
+                int outA=sum?outL+outR:outL-outR;
+                osc=outA*64/volScale;
               }
-              chanOut[i][0]=newSamp*chState[i].volL;
-              chanOut[i][1]=newSamp*chState[i].volR;
             }
-            int outL=chanOut[i][0];
-            int outR=chanOut[i][1];
-            int outA=(chan[i].invertL==chan[i].invertR)?outL+outR:outL-outR;
             mixOut[0][j]+=(unsigned char)(outL>>15);
             mixOut[1][j]+=(unsigned char)(outR>>15);
-            oscOut[i][j]=volScale>0?outA*64/volScale:0;
+            oscOut[i][j]=osc;
           }
+          chState[i].address=address;
+          chanOut[i][0]=outL;
+          chanOut[i][1]=outR;
         }
         for (size_t j=mixBufOffset; j<4; j++) {
           mixBuf[mixBufPage][mixBufWritePos]=mixOut[0][j];
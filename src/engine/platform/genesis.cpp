@@ -135,9 +135,37 @@ void DivPlatformGenesis::processDAC(int iRate) {
   }
 }
 
+bool DivPlatformGenesis::isIdle() {
+  if (!writes.empty() || dacWrite>=0) return false;
+  if (softPCM || interruptSim>0) return false;
+  if (chan[5].dacMode && chan[5].dacSample!=-1) return false;
+  if (fm.dacen || fm.mode_csm) return false;
+  for (int i=0; i<24; i++) {
+    if (fm.eg_kon[i] || fm.eg_ssg_enable[i]) return false;
+    if (fm.eg_state[i]!=3 || fm.eg_level[i]<0x3ff) return false;
+  }
+  return true;
+}
+
 void DivPlatformGenesis::acquire_nuked(short** buf, size_t len) {
-  thread_local short o[2];
-  thread_local int os[2];
+  short o[2]={0};
+  int os[2]={0};
+
+  // the output of a silent chip doesn't change, so don't emulate it.
+  // the LFO and envelope timers stop until the chip is written to again.
+  if (lastOutValid && parent->getSkipIdleChips() && isIdle()) {
+    for (size_t h=0; h<len; h++) {
+      buf[0][h]=lastOut[0];
+      buf[1][h]=lastOut[1];
+    }
+    delay-=MIN(delay,(int)len);
+    for (int i=0; i<7; i++) {
+      oscBuf[i]->begin(len);
+      oscBuf[i]->putSample(0,0);
+      oscBuf[i]->end(len);
+    }
+    return;
+  }
 
   for (int i=0; i<7; i++) {
     oscBuf[i]->begin(len);
@@ -149,19 +177,50 @@ void DivPlatformGenesis::acquire_nuked(short** buf, size_t len) {
     if (delay>0) delay--;
 
     os[0]=0; os[1]=0;
+    // if no write can happen during this sample, skip the write logic.
+    // this is the case when the queue is empty, or when its first write is
+    // waiting for the delay to run out (delay can't change during the loop).
+    // nothing can be queued during the loop unless a DAC write is pending.
+    bool idle=false;
+    if (dacWrite<0) {
+      if (writes.empty()) {
+        idle=true;
+        canWriteDAC=true;
+        flushFirst=false;
+      } else if (delay>0 && !writes.front().urgent) {
+        idle=true;
+      }
+    }
     for (int i=0; i<6; i++) {
-      if (!writes.empty()) {
-        QueuedWrite& w=writes.front();
-        if (delay<=0 || w.urgent) {
-          if (w.addr==0xfffffffe) {
-            delay=w.val*3;
-            writes.pop_front();
-          } else if (w.addrOrVal) {
-            //logV("%.3x=%.2x",w.addr,w.val);
-            OPN2_Write(&fm,0x1+((w.addr>>8)<<1),w.val);
-            regPool[w.addr&0x1ff]=w.val;
-            writes.pop_front();
-
+      if (!idle) {
+        if (!writes.empty()) {
+          QueuedWrite& w=writes.front();
+          if (delay<=0 || w.urgent) {
+            if (w.addr==0xfffffffe) {
+              delay=w.val*3;
+              writes.pop_front();
+            } else if (w.addrOrVal) {
+              //logV("%.3x=%.2x",w.addr,w.val);
+              OPN2_Write(&fm,0x1+((w.addr>>8)<<1),w.val);
+              regPool[w.addr&0x1ff]=w.val;
+              writes.pop_front();
+
+              if (dacWrite>=0) {
+                if (!canWriteDAC) {
+                  canWriteDAC=true;
+                } else {
+                  urgentWrite(0x2a,dacWrite);
+                  dacWrite=-1;
+                  canWriteDAC=writes.empty();
+                }
+              }
+            } else {
+              if (fm.write_busy==0) {
+                OPN2_Write(&fm,0x0+((w.addr>>8)<<1),w.addr);
+                w.addrOrVal=true;
+              }
+            }
+          } else {
             if (dacWrite>=0) {
               if (!canWriteDAC) {
                 canWriteDAC=true;
@@ -171,30 +230,15 @@ void DivPlatformGenesis::acquire_nuked(short** buf, size_t len) {
                 canWriteDAC=writes.empty();
               }
             }
-          } else {
-            if (fm.write_busy==0) {
-              OPN2_Write(&fm,0x0+((w.addr>>8)<<1),w.addr);
-              w.addrOrVal=true;
-            }
           }
         } else {
+          canWriteDAC=true;
           if (dacWrite>=0) {
-            if (!canWriteDAC) {
-              canWriteDAC=true;
-            } else {
-              urgentWrite(0x2a,dacWrite);
-              dacWrite=-1;
-              canWriteDAC=writes.empty();
-            }
+            urgentWrite(0x2a,dacWrite);
+            dacWrite=-1;
           }
+          flushFirst=false;
         }
-      } else {
-        canWriteDAC=true;
-        if (dacWrite>=0) {
-          urgentWrite(0x2a,dacWrite);
-          dacWrite=-1;
-        }
-        flushFirst=false;
       }
       
       OPN2_Clock(&fm,o);
@@ -235,6 +279,11 @@ void DivPlatformGenesis::acquire_nuked(short** buf, size_t len) {
     buf[0][h]=os[0];
     buf[1][h]=os[1];
   }
+  if (len>0) {
+    lastOut[0]=buf[0][len-1];
+    lastOut[1]=buf[1][len-1];
+    lastOutValid=true;
+  }
 
   for (int i=0; i<7; i++) {
     oscBuf[i]->end(len);
@@ -242,7 +291,7 @@ void DivPlatformGenesis::acquire_nuked(short** buf, size_t len) {
 }
 
 void DivPlatformGenesis::acquire_ymfm(short** buf, size_t len) {
-  thread_local int os[2];
+  int os[2]={0};
 
   ymfm::ym2612::fm_engine* fme=fm_ymfm->debug_engine();
 
@@ -405,6 +454,54 @@ inline void DivPlatformGenesis::acquire276OscSub(int h) {
   }
 }
 
+// runs pairs of clock phases without writing.
+inline void DivPlatformGenesis::acquire276Run(int h, int pairs, int& sum_l, int& sum_r, int& sample_l, int& sample_r) {
+  if (chipType!=2) {
+    for (int c=0; c<pairs; c++) {
+      FMOPN2_Clock(&fm_276,0);
+      sum_l+=fm_276.out_l;
+      sum_r+=fm_276.out_r;
+
+      acquire276OscSub(h);
+
+      FMOPN2_Clock(&fm_276,1);
+      sum_l+=fm_276.out_l;
+      sum_r+=fm_276.out_r;
+
+      acquire276OscSub(h);
+    }
+    return;
+  }
+  for (int c=0; c<pairs; c++) {
+    FMOPN2_Clock(&fm_276,0);
+    sum_l+=fm_276.out_l;
+    sum_r+=fm_276.out_r;
+
+    acquire276OscSub(h);
+
+    FMOPN2_Clock(&fm_276,1);
+    sum_l+=fm_276.out_l;
+    sum_r+=fm_276.out_r;
+
+    acquire276OscSub(h);
+
+    if (!o_bco && fm_276.o_bco) {
+      dacShifter=(dacShifter<<1)|fm_276.o_so;
+
+      if (o_lro!=fm_276.o_lro) {
+        if (o_lro) {
+          sample_l=dacShifter;
+        } else {
+          sample_r=dacShifter;
+        }
+      }
+
+      o_lro=fm_276.o_lro;
+    }
+    o_bco=fm_276.o_bco;
+  }
+}
+
 // thanks LTVA
 void DivPlatformGenesis::acquire_nuked276(short** buf, size_t len) {
   for (int i=0; i<7; i++) {
@@ -469,35 +566,7 @@ void DivPlatformGenesis::acquire_nuked276(short** buf, size_t len) {
             o_bco=fm_276.o_bco;
           }
 
-          for (int c=0; c<17; c++) {
-            FMOPN2_Clock(&fm_276,0);
-            sum_l+=fm_276.out_l;
-            sum_r+=fm_276.out_r;
-
-            acquire276OscSub(h);
-
-            FMOPN2_Clock(&fm_276,1);
-            sum_l+=fm_276.out_l;
-            sum_r+=fm_276.out_r;
-
-            acquire276OscSub(h);
-
-            if (chipType==2) {
-              if (!o_bco && fm_276.o_bco) {
-                dacShifter=(dacShifter<<1)|fm_276.o_so;
-
-                if (o_lro!=fm_276.o_lro) {
-                  if (o_lro)
-                    sample_l=dacShifter;
-                  else
-                    sample_r=dacShifter;
-                }
-
-                o_lro=fm_276.o_lro;
-              }
-              o_bco=fm_276.o_bco;
-            }
-          }
+          acquire276Run(h,17,sum_l,sum_r,sample_l,sample_r);
 
           fm_276.input.address=w.addr<0x100?1:3;
           fm_276.input.data=w.val;
@@ -531,36 +600,7 @@ void DivPlatformGenesis::acquire_nuked276(short** buf, size_t len) {
             o_bco=fm_276.o_bco;
           }
 
-          for (int c=0; c<83; c++) {
-            FMOPN2_Clock(&fm_276,0);
-            sum_l+=fm_276.out_l;
-            sum_r+=fm_276.out_r;
-
-            acquire276OscSub(h);
-
-            FMOPN2_Clock(&fm_276,1);
-            sum_l+=fm_276.out_l;
-            sum_r+=fm_276.out_r;
-
-            acquire276OscSub(h);
-
-            if (chipType==2) {
-              if (!o_bco && fm_276.o_bco) {
-                dacShifter=(dacShifter<<1)|fm_276.o_so;
-
-                if (o_lro!=fm_276.o_lro) {
-                  if (o_lro) {
-                    sample_l=dacShifter;
-                  } else {
-                    sample_r=dacShifter;
-                  }
-                }
-
-                o_lro=fm_276.o_lro;
-              }
-              o_bco=fm_276.o_bco;
-            }
-          }
+          acquire276Run(h,83,sum_l,sum_r,sample_l,sample_r);
 
           regPool[w.addr&0x1ff]=w.val;
           writes.pop_front();
@@ -597,35 +637,7 @@ void DivPlatformGenesis::acquire_nuked276(short** buf, size_t len) {
       flushFirst=false;
     }
 
-    for (int j=0; j<(was_reg_write?(144-83-19):144); j++) {
-      FMOPN2_Clock(&fm_276,0);
-      sum_l+=fm_276.out_l;
-      sum_r+=fm_276.out_r;
-
-      acquire276OscSub(h);
-
-      FMOPN2_Clock(&fm_276,1);
-      sum_l+=fm_276.out_l;
-      sum_r+=fm_276.out_r;
-
-      acquire276OscSub(h);
-
-      if (chipType==2) {
-        if (!o_bco && fm_276.o_bco) {
-          dacShifter=(dacShifter<<1)|fm_276.o_so;
-
-          if (o_lro!=fm_276.o_lro) {
-            if (o_lro)
-              sample_l=dacShifter;
-            else
-              sample_r=dacShifter;
-          }
-
-          o_lro=fm_276.o_lro;
-        }
-        o_bco=fm_276.o_bco;
-      }
-    }
+    acquire276Run(h,was_reg_write?(144-83-19):144,sum_l,sum_r,sample_l,sample_r);
 
     if (chipType==2) {
       buf[0][h]=sample_l;
@@ -1698,6 +1710,7 @@ float DivPlatformGenesis::getPostAmp() {
 
 void DivPlatformGenesis::reset() {
   writes.clear();
+  lastOutValid=false;
   memset(regPool,0,512);
   if (useYMFM==2) {
     dacShifter=0;
@@ -1834,6 +1847,7 @@ int DivPlatformGenesis::getPortaFloor(int ch) {
 
 void DivPlatformGenesis::setYMFM(unsigned char use) {
   useYMFM=use;
+  lastOutValid=false;
 }
 
 void DivPlatformGenesis::setSoftPCM(bool value) {
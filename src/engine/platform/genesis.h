@@ -82,6 +82,10 @@ class DivPlatformGenesis: public DivPlatformOPN {
 
     int interruptSim;
     int interruptSimCycles;
+
+    // last output of acquire_nuked (repeated while the chip is idle)
+    short lastOut[2];
+    bool lastOutValid;
   
     unsigned char dacVolTable[128];
   
@@ -89,8 +93,11 @@ class DivPlatformGenesis: public DivPlatformOPN {
     friend void putDispatchChan(void*,int,int);
 
     inline void processDAC(int iRate);
+    // whether the chip is silent and nothing is about to change that
+    bool isIdle();
     inline void commitState(int ch, DivInstrument* ins);
     inline void acquire276OscSub(int h);
+    inline void acquire276Run(int h, int pairs, int& sum_l, int& sum_r, int& sample_l, int& sample_r);
     void acquire_nuked(short** buf, size_t len);
     void acquire_nuked276(short** buf, size_t len);
     void acquire_ymfm(short** buf, size_t len);
@@ -22,7 +22,7 @@
 #include "../../ta-log.h"
 #include <math.h>
 
-#define rWrite(a,v) {if(!skipRegisterWrites) {k053260.write(a,v); regPool[a]=v; if(dumpWrites) addWrite(a,v);}}
+#define rWrite(a,v) {if(!skipRegisterWrites) {writeCount++; k053260.write(a,v); regPool[a]=v; if(dumpWrites) addWrite(a,v);}}
 
 #define CHIP_DIVIDER 16
 #define TICK_DIVIDER 64 // for match to YM3012 output rate
@@ -488,7 +488,7 @@ const DivMemoryComposition* DivPlatformK053260::getMemCompo(int index) {
 }
 
 void DivPlatformK053260::renderSamples(int sysID) {
-  memset(sampleMem,0,getSampleMemCapacity());
+  clearSampleMem(sampleMem,getSampleMemCapacity());
   memset(sampleOff,0,32768*sizeof(unsigned int));
   memset(sampleLoaded,0,32768*sizeof(bool));
 
@@ -549,7 +549,7 @@ int DivPlatformK053260::init(DivEngine* p, int channels, int sugRate, const DivC
     isMuted[i]=false;
     oscBuf[i]=new DivDispatchOscBuffer;
   }
-  sampleMem=new unsigned char[getSampleMemCapacity()];
+  sampleMem=(unsigned char*)allocSampleMem(getSampleMemCapacity());
   sampleMemLen=0;
   setFlags(flags);
   reset();
@@ -558,7 +558,7 @@ int DivPlatformK053260::init(DivEngine* p, int channels, int sugRate, const DivC
 }
 
 void DivPlatformK053260::quit() {
-  delete[] sampleMem;
+  freeSampleMem(sampleMem);
   for (int i=0; i<4; i++) {
     delete oscBuf[i];
   }
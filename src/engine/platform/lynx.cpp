@@ -22,7 +22,7 @@
 #include "../bsr.h"
 #include <math.h>
 
-#define rWrite(a,v) {if (!skipRegisterWrites) {writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);}}}
+#define rWrite(a,v) {if (!skipRegisterWrites) {writeCount++; writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);}}}
 
 #define WRITE_VOLUME(ch,v) rWrite(0x20+(ch<<3),(v))
 #define WRITE_FEEDBACK(ch,v) rWrite(0x21+(ch<<3),(v))
@@ -154,7 +154,7 @@ void DivPlatformLynx::processDAC(int sRate) {
 }
 
 void DivPlatformLynx::acquire(short** buf, size_t len) {
-  thread_local int chanBuf[4];
+  int chanBuf[4]={0};
 
   for (int i=0; i<4; i++) {
     oscBuf[i]->begin(len);
@@ -24,7 +24,7 @@
 
 #define CHIP_DIVIDER 16
 
-#define rWrite(a,v) if (!skipRegisterWrites) {writes.push(QueuedWrite((a),v)); if (dumpWrites) {addWrite(a,v);} }
+#define rWrite(a,v) if (!skipRegisterWrites) {writeCount++; writes.push(QueuedWrite((a),v)); if (dumpWrites) {addWrite(a,v);} }
 
 const char* regCheatSheetMMC5[]={
   "S0Volume", "5000",
@@ -34,6 +34,7 @@ const unsigned char slotsMPCM[28]={
 #define rWrite(a,v) if (!skipRegisterWrites) {pendingWrites[a]=v;}
 #define immWrite(a,v) \
   if (!skipRegisterWrites) { \
+    writeCount++; \
     writes.push(QueuedWrite(a,v)); \
     if (dumpWrites) { \
       addWrite(1,slotsMPCM[(a>>3)&0x1f]); \
@@ -86,9 +87,9 @@ const char** DivPlatformMultiPCM::getRegisterSheet() {
 #define PCM_ADDR_AM 7
 
 void DivPlatformMultiPCM::acquire(short** buf, size_t len) {
-  thread_local short o[4];
-  thread_local int os[2];
-  thread_local short pcmBuf[28];
+  short o[4]={0};
+  int os[2]={0};
+  short pcmBuf[28]={0};
 
   for (int i=0; i<28; i++) {
     oscBuf[i]->begin(len);
@@ -655,7 +656,7 @@ void DivPlatformMultiPCM::renderInstruments() {
 }
 
 void DivPlatformMultiPCM::renderSamples(int sysID) {
-  memset(pcmMem,0,2097152);
+  clearSampleMem(pcmMem,2097152);
   memset(sampleOff,0,32768*sizeof(unsigned int));
   memset(sampleLoaded,0,32768*sizeof(bool));
 
@@ -732,7 +733,7 @@ int DivPlatformMultiPCM::init(DivEngine* p, int channels, int sugRate, const Div
 
   setFlags(flags);
 
-  pcmMem=new unsigned char[2097152];
+  pcmMem=(unsigned char*)allocSampleMem(2097152);
   pcmMemLen=0;
   pcmMemory.memory=pcmMem;
 
@@ -744,7 +745,7 @@ void DivPlatformMultiPCM::quit() {
   for (int i=0; i<28; i++) {
     delete oscBuf[i];
   }
-  delete[] pcmMem;
+  freeSampleMem(pcmMem);
 }
 
 // initialization of important arrays
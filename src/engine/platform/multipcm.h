@@ -35,6 +35,7 @@ class DivYMW258MemoryInterface: public MemoryInterface {
       return 0;
     };
     unsigned getSize() const override { return size; };
+    const byte* getDirect() const override { return memory; };
     void write(unsigned address, byte value) override {};
     void clear(byte value) override {};
   private:
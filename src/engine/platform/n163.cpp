@@ -23,7 +23,7 @@
 #include "IconsFontAwesome4.h"
 #include <math.h>
 
-#define rWrite(a,v) if (!skipRegisterWrites) {writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);} }
+#define rWrite(a,v) if (!skipRegisterWrites) {writeCount++; writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);} }
 #define rWriteMask(a,v,m) if (!skipRegisterWrites) {writes.push(QueuedWrite(a,v,m)); if (dumpWrites) {addWrite(a,v);} }
 #define chWrite(c,a,v) \
   if (c<=chanMax) { \
@@ -126,11 +126,14 @@ void DivPlatformN163::acquire(short** buf, size_t len) {
     }
 
     // command queue
-    while (!writes.empty()) {
-      QueuedWrite w=writes.front();
-      n163.addr_w(w.addr);
-      n163.data_w((n163.data_r()&~w.mask)|(w.val&w.mask));
-      writes.pop();
+    // writes are only queued outside of acquire(), so the queue is drained
+    // after the first sample and the rest of the loop only runs the chip.
+    if (i==0) {
+      while (!writes.empty()) {
+        QueuedWrite w=writes.front();
+        n163.ram_w(w.addr,w.val,w.mask);
+        writes.pop();
+      }
     }
   }
 
@@ -139,6 +142,27 @@ void DivPlatformN163::acquire(short** buf, size_t len) {
   }
 }
 
+// adds a nibble to the pending wave write. two nibbles share a byte, so they
+// are merged into a single write.
+void DivPlatformN163::waveNibble(unsigned char addr, int data) {
+  if ((addr>>1)!=waveWriteAddr) {
+    flushWave();
+    waveWriteAddr=addr>>1;
+  }
+  unsigned char mask=(addr&1)?0xf0:0x0f;
+  waveWriteVal=(waveWriteVal&~mask)|(((addr&1)?(data<<4):data)&mask);
+  waveWriteMask|=mask;
+}
+
+void DivPlatformN163::flushWave() {
+  if (waveWriteMask) {
+    rWriteMask(waveWriteAddr,waveWriteVal,waveWriteMask);
+  }
+  waveWriteAddr=-1;
+  waveWriteVal=0;
+  waveWriteMask=0;
+}
+
 void DivPlatformN163::updateWave(int ch, int wave, int pos, int len) {
   len&=0xfc; // 4 nibble boundary
   if (wave<0) {
@@ -149,9 +173,7 @@ void DivPlatformN163::updateWave(int ch, int wave, int pos, int len) {
         if (addr>=((0x78-(chanMax<<3))<<1)) { // avoid conflict with channel register area
           break;
         }
-        unsigned char mask=(addr&1)?0xf0:0x0f;
-        int data=chan[ch].ws.output[i];
-        rWriteMask(addr>>1,(addr&1)?(data<<4):(data&0xf),mask);
+        waveNibble(addr,chan[ch].ws.output[i]&0xf);
       }
     }
   } else {
@@ -162,17 +184,17 @@ void DivPlatformN163::updateWave(int ch, int wave, int pos, int len) {
       if (addr>=((0x78-(chanMax<<3))<<1)) { // avoid conflict with channel register area
         break;
       }
-      unsigned char mask=(addr&1)?0xf0:0x0f;
       if (wt->max<1 || wt->len<1) {
-        rWriteMask(addr>>1,0,mask);
+        waveNibble(addr,0);
       } else {
         int data=wt->data[i]*15/wt->max;
         if (data<0) data=0;
         if (data>15) data=15;
-        rWriteMask(addr>>1,(addr&1)?(data<<4):(data&0xf),mask);
+        waveNibble(addr,data);
       }
     }
   }
+  flushWave();
 }
 
 void DivPlatformN163::updateWaveCh(int ch) {
@@ -657,6 +679,9 @@ int DivPlatformN163::init(DivEngine* p, int channels, int sugRate, const DivConf
   parent=p;
   dumpWrites=false;
   skipRegisterWrites=false;
+  waveWriteAddr=-1;
+  waveWriteVal=0;
+  waveWriteMask=0;
   for (int i=0; i<8; i++) {
     isMuted[i]=false;
     oscBuf[i]=new DivDispatchOscBuffer;
@@ -63,11 +63,16 @@ class DivPlatformN163: public DivDispatch {
   unsigned char initChanMax;
   unsigned char chanMax;
   short loadWave, loadPos;
+  // pending wave RAM write (see waveNibble())
+  short waveWriteAddr;
+  unsigned char waveWriteVal, waveWriteMask;
   bool multiplex, lenCompensate, posLatch;
 
   n163_core n163;
   unsigned char regPool[128];
   DivMemoryComposition memCompo;
+  void waveNibble(unsigned char addr, int data);
+  void flushWave();
   void updateWave(int ch, int wave, int pos, int len);
   void updateWaveCh(int ch);
   friend void putDispatchChip(void*,int);
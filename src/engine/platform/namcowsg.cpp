@@ -22,7 +22,7 @@
 #include <math.h>
 
 //#define rWrite(a,v) pendingWrites[a]=v;
-#define rWrite(a,v) if (!skipRegisterWrites) {writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);} }
+#define rWrite(a,v) if (!skipRegisterWrites) {writeCount++; writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);} }
 
 #define CHIP_FREQBASE 4194304
 
@@ -176,13 +176,17 @@ void DivPlatformNamcoWSG::acquire(short** buf, size_t len) {
     oscBuf[i]->begin(len);
   }
 
-  for (size_t h=0; h<len; h++) {
+  // render in blocks. the core writes the output of each voice to voiceOut.
+  for (size_t h=0; h<len; h+=NAMCO_WSG_BLOCK) {
+    int count=MIN(len-h,NAMCO_WSG_BLOCK);
     short* bufC[2]={
-      buf[0]+h, buf[1]+h
+      buf[0]+h, (buf[1]==NULL)?NULL:(buf[1]+h)
     };
-    namco->sound_stream_update(bufC,1);
+    namco->sound_stream_update(bufC,count);
     for (int i=0; i<chans; i++) {
-      oscBuf[i]->putSample(h,(namco->m_channel_list[i].last_out*chans)>>1);
+      for (int j=0; j<count; j++) {
+        oscBuf[i]->putSample(h+j,(voiceOut[i][j]*chans)>>1);
+      }
     }
   }
 
@@ -626,6 +630,9 @@ int DivPlatformNamcoWSG::init(DivEngine* p, int channels, int sugRate, const Div
       namco=new namco_device(3072000);
       break;
   }
+  for (int i=0; i<8; i++) {
+    namco->m_voice_out[i]=voiceOut[i];
+  }
   setFlags(flags);
   reset();
   return 6;
@@ -25,6 +25,9 @@
 #include "../waveSynth.h"
 #include "sound/namco.h"
 
+// samples rendered by the core at once
+#define NAMCO_WSG_BLOCK 256
+
 class DivPlatformNamcoWSG: public DivDispatch {
   struct Channel: public SharedChannel<signed char> {
     unsigned char pan;
@@ -49,6 +52,8 @@ class DivPlatformNamcoWSG: public DivDispatch {
   FixedQueue<QueuedWrite,256> writes;
 
   namco_audio_device* namco;
+  // output of each voice during a block (for the oscilloscope)
+  short voiceOut[8][NAMCO_WSG_BLOCK];
   int devType, chans;
   bool newNoise;
   bool romMode;
@@ -26,9 +26,10 @@
 #define NDS_CORE_QUALITY 64
 
 #define rRead8(a) (nds.read8(a))
-#define rWrite8(a,v) {if(!skipRegisterWrites){writes.push_back(QueuedWrite((a),1,(v)));regPool[(a)]=(v);if(dumpWrites)addWrite((a),(v));}}
+#define rWrite8(a,v) {if(!skipRegisterWrites){writeCount++;writes.push_back(QueuedWrite((a),1,(v)));regPool[(a)]=(v);if(dumpWrites)addWrite((a),(v));}}
 #define rWrite16(a,v) { \
   if(!skipRegisterWrites) { \
+    writeCount++; \
     writes.push_back(QueuedWrite((a),2,(v)));\
     regPool[(a)+0]=(v)&0xff; \
     regPool[(a)+1]=((v)>>8)&0xff; \
@@ -39,6 +40,7 @@
 
 #define rWrite32(a,v) { \
   if(!skipRegisterWrites) { \
+    writeCount++; \
     writes.push_back(QueuedWrite((a),4,(v)));\
     regPool[(a)+0]=(v)&0xff; \
     regPool[(a)+1]=((v)>>8)&0xff; \
@@ -28,7 +28,7 @@ struct _nla_table nla_table;
 
 #define CHIP_DIVIDER 16
 
-#define rWrite(a,v) if (!skipRegisterWrites) {writes.push(QueuedWrite((a),v)); if (dumpWrites) {addWrite((a),v);} }
+#define rWrite(a,v) if (!skipRegisterWrites) {writeCount++; writes.push(QueuedWrite((a),v)); if (dumpWrites) {addWrite((a),v);} }
 
 const char* regCheatSheetNES[]={
   "S0Volume", "4000",
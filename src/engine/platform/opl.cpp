@@ -25,7 +25,7 @@
 #include <math.h>
 
 #define rWrite(a,v) if (!skipRegisterWrites) {pendingWrites[a]=v;}
-#define immWrite(a,v) if (!skipRegisterWrites) {writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);} }
+#define immWrite(a,v) if (!skipRegisterWrites) {writeCount++; writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);} }
 
 #define KVSL(x,y) ((chan[x].state.op[orderedOpsL1[ops==4][y]].kvs==2 && isOutputL[ops==4][chan[x].state.alg][y]) || chan[x].state.op[orderedOpsL1[ops==4][y]].kvs==1)
 
@@ -186,10 +186,10 @@ const int orderedOpsL[4]={
 #define PCM_ADDR_MIX_PCM 0x2f9
 
 void DivPlatformOPL::acquire_nuked(short** buf, size_t len) {
-  thread_local short o[8];
-  thread_local int os[6];
-  thread_local ymfm::ymfm_output<2> aOut;
-  thread_local short pcmBuf[24];
+  short o[8]={0};
+  int os[6]={0};
+  ymfm::ymfm_output<2> aOut;
+  short pcmBuf[24]={0};
 
   for (int i=0; i<MAX(adpcmChan+1,totalChans); i++) {
     oscBuf[i]->begin(len);
@@ -768,7 +768,7 @@ static const int cycleMap3Drums[36]={
 
 void DivPlatformOPL::acquire_nukedLLE2(short** buf, size_t len) {
   int chOut[11];
-  thread_local ymfm::ymfm_output<2> aOut;
+  ymfm::ymfm_output<2> aOut;
 
   for (int i=0; i<MAX(adpcmChan+1,totalChans); i++) {
     oscBuf[i]->begin(len);
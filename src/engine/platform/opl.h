@@ -47,6 +47,7 @@ class DivYMF278MemoryInterface: public MemoryInterface {
     DivYMF278MemoryInterface(unsigned size_) : memory(NULL), size(size_) {};
     byte operator[](unsigned address) const override;
     unsigned getSize() const override { return size; };
+    const byte* getDirect() const override { return memory; };
     void write(unsigned address, byte value) override {};
     void clear(byte value) override {};
   private:
@@ -25,7 +25,7 @@
 #include <math.h>
 
 #define rWrite(a,v) if (!skipRegisterWrites) {pendingWrites[a]=v;}
-#define immWrite(a,v) if (!skipRegisterWrites) {writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);} }
+#define immWrite(a,v) if (!skipRegisterWrites) {writeCount++; writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);} }
 
 #define CHIP_FREQBASE 1180068
 
@@ -44,8 +44,18 @@ const unsigned char visMapOPLL[9]={
 };
 
 void DivPlatformOPLL::acquire_nuked(short** buf, size_t len) {
-  thread_local int o[2];
-  thread_local int os;
+  int o[2]={0};
+  int os=0;
+  // per-cycle outputs for the oscilloscopes, written once per sample
+  short oscOut[10];
+  unsigned short oscUsed=0;
+
+  // channels which are heard (muting does not apply to drums in proper drums mode)
+  bool audible[10];
+  for (int i=0; i<10; i++) {
+    audible[i]=(i>=6 && properDrums) || !isMuted[i];
+  }
+  const bool isVRC7=vrc7;
 
   for (int i=0; i<11; i++) {
     oscBuf[i]->begin(len);
@@ -53,8 +63,23 @@ void DivPlatformOPLL::acquire_nuked(short** buf, size_t len) {
 
   for (size_t h=0; h<len; h++) {
     os=0;
-    for (int i=0; i<9; i++) {
-      if (!writes.empty() && --delay<0) {
+    oscUsed=0;
+    int cycle=0;
+    while (cycle<9) {
+      // run the cycles until the next write can be serviced in one go
+      int burst=9-cycle;
+      bool doWrite=false;
+      if (!writes.empty()) {
+        if (delay>0) {
+          if (delay<burst) burst=delay;
+          delay-=burst;
+        } else {
+          burst=1;
+          doWrite=true;
+        }
+      }
+
+      if (doWrite) {
         // 84 is safe value
         QueuedWrite& w=writes.front();
         if (w.addrOrVal) {
@@ -70,17 +95,26 @@ void DivPlatformOPLL::acquire_nuked(short** buf, size_t len) {
           delay=3;
         }
       }
-      
-      OPLL_Clock(&fm,o);
-      unsigned char nextOut=cycleMapOPLL[fm.cycles];
-      if ((nextOut>=6 && properDrums) || !isMuted[nextOut]) {
-        os+=(o[0]+o[1]);
-        if (vrc7 || (fm.rm_enable&0x20)) oscBuf[nextOut]->putSample(h,(o[0]+o[1])<<6);
-      } else {
-        if (vrc7 || (fm.rm_enable&0x20)) oscBuf[nextOut]->putSample(h,0);
+
+      for (int i=0; i<burst; i++) {
+        OPLL_Clock(&fm,o);
+        unsigned char nextOut=cycleMapOPLL[fm.cycles];
+        int out=audible[nextOut]?(o[0]+o[1]):0;
+        os+=out;
+        if (isVRC7 || (fm.rm_enable&0x20)) {
+          oscOut[nextOut]=out<<6;
+          oscUsed|=1<<nextOut;
+        }
+      }
+      cycle+=burst;
+    }
+
+    if (oscUsed) {
+      for (int i=0; i<10; i++) {
+        if (oscUsed&(1<<i)) oscBuf[i]->putSample(h,oscOut[i]);
       }
     }
-    if (!(vrc7 || (fm.rm_enable&0x20))) for (int i=0; i<9; i++) {
+    if (!(isVRC7 || (fm.rm_enable&0x20))) for (int i=0; i<9; i++) {
       unsigned char ch=visMapOPLL[i];
       if ((i>=6 && properDrums) || !isMuted[ch]) {
         oscBuf[ch]->putSample(h,(fm.output_ch[i])<<6);
@@ -107,7 +141,7 @@ static const unsigned char freakingDrumMap[5]={
 };
 
 void DivPlatformOPLL::acquire_emu(short** buf, size_t len) {
-  thread_local int os;
+  int os=0;
 
   for (int i=0; i<11; i++) {
     oscBuf[i]->begin(len);
@@ -29,6 +29,7 @@
 void DivPlatformPCMDAC::acquire(short** buf, size_t len) {
   const int depthScale=(15-outDepth);
   int output=0;
+  int outL, outR;
   int outSum[2];
 
   // do not process if our channels are null
@@ -52,6 +53,10 @@ void DivPlatformPCMDAC::acquire(short** buf, size_t len) {
       output=0;
       if (!chan[i].active) {
         oscBuf[i].putSample(h,0);
+        if (chanOutBuf!=NULL) {
+          chanOutBuf[i<<1][h]=0;
+          chanOutBuf[(i<<1)|1][h]=0;
+        }
         continue;
       }
       if (chan[i].useWave || (chan[i].sample>=0 && chan[i].sample<parent->song.sampleLen)) {
@@ -249,12 +254,19 @@ void DivPlatformPCMDAC::acquire(short** buf, size_t len) {
       }
       oscBuf[i].putSample(h,((output>>depthScale)<<depthScale)>>1);
       if (outStereo) {
-        outSum[0]+=((output*chan[i].panL)>>(depthScale+8))<<depthScale;
-        outSum[1]+=((output*chan[i].panR)>>(depthScale+8))<<depthScale;
+        outL=((output*chan[i].panL)>>(depthScale+8))<<depthScale;
+        outR=((output*chan[i].panR)>>(depthScale+8))<<depthScale;
       } else {
-        output=(output>>depthScale)<<depthScale;
-        outSum[0]+=output;
-        outSum[1]+=output;
+        outL=(output>>depthScale)<<depthScale;
+        outR=outL;
+      }
+      outSum[0]+=outL;
+      outSum[1]+=outR;
+      if (chanOutBuf!=NULL) {
+        outL=(int)((float)outL*volMult);
+        outR=(int)((float)outR*volMult);
+        chanOutBuf[i<<1][h]=CLAMP(outL,-32768,32767);
+        chanOutBuf[(i<<1)|1][h]=CLAMP(outR,-32768,32767);
       }
     }
 
@@ -544,6 +556,10 @@ int DivPlatformPCMDAC::getOutputCount() {
   return 2;
 }
 
+bool DivPlatformPCMDAC::hasChanOutputs() {
+  return true;
+}
+
 bool DivPlatformPCMDAC::hasSoftPan(int ch) {
   return outStereo;
 }
@@ -80,6 +80,7 @@ class DivPlatformPCMDAC: public DivDispatch {
     void tick(bool sysTick=true);
     void muteChannel(int ch, bool mute);
     int getOutputCount();
+    bool hasChanOutputs();
     bool hasSoftPan(int ch);
     DivMacroInt* getChanMacroInt(int ch);
     unsigned short getPan(int chan);
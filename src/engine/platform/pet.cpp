@@ -18,6 +18,7 @@
  */
 
 #include "pet.h"
+#include "chipUtils.h"
 #include "../engine.h"
 #include <math.h>
 
@@ -55,7 +56,7 @@ void DivPlatformPET::rWrite(unsigned int addr, unsigned char val) {
   regPool[addr]=val;
 }
 
-void DivPlatformPET::acquire(short** buf, size_t len) {
+void DivPlatformPET::acquireDirect(blip_buffer_t** bb, size_t len) {
   bool hwSROutput=((regPool[11]>>2)&7)==4;
   oscBuf->begin(len);
   if (chan[0].enable) {
@@ -63,7 +64,11 @@ void DivPlatformPET::acquire(short** buf, size_t len) {
     if (!hwSROutput) {
       reload+=regPool[9]*512;
     }
-    for (size_t h=0; h<len; h++) {
+    divRunEvents(len,[this](int advance) -> int {
+      // the shift register is clocked once the counter runs out
+      return MIN(advance,chan[0].cnt/SAMP_DIVIDER+1);
+    },[this,bb,reload](size_t h, int advance) {
+      chan[0].cnt-=SAMP_DIVIDER*(advance-1);
       if (SAMP_DIVIDER>chan[0].cnt) {
         chan[0].out=(chan[0].sreg&1)*32767;
         chan[0].sreg=(chan[0].sreg>>1)|((chan[0].sreg&1)<<7);
@@ -71,17 +76,15 @@ void DivPlatformPET::acquire(short** buf, size_t len) {
       } else {
         chan[0].cnt-=SAMP_DIVIDER;
       }
-      buf[0][h]=chan[0].out;
+      divBlipPut(bb[0],h,chan[0].out,lastOut);
       oscBuf->putSample(h,chan[0].out);
-    }
+    });
     // emulate driver writes to PCR
     if (!hwSROutput) regPool[12]=chan[0].out?0xe0:0xc0;
   } else {
     chan[0].out=0;
-    for (size_t h=0; h<len; h++) {
-      buf[0][h]=0;
-      oscBuf->putSample(h,0);
-    }
+    divBlipPut(bb[0],0,0,lastOut);
+    oscBuf->putSample(0,0);
   }
   oscBuf->end(len);
 }
@@ -265,6 +268,25 @@ void* DivPlatformPET::getChanState(int ch) {
   return &chan;
 }
 
+void* DivPlatformPET::getState() {
+  return copyStateOf(this);
+}
+
+void DivPlatformPET::setState(void* state) {
+  // lastOut belongs to the output buffer, not to the chip
+  DivDispatchOscBuffer* oscBufKeep=oscBuf;
+  bool isMutedKeep=isMuted;
+  int lastOutKeep=lastOut;
+  restoreStateOf(this,(const DivPlatformPET*)state);
+  oscBuf=oscBufKeep;
+  isMuted=isMutedKeep;
+  lastOut=lastOutKeep;
+}
+
+void DivPlatformPET::freeState(void* state) {
+  delete (DivPlatformPET*)state;
+}
+
 DivMacroInt* DivPlatformPET::getChanMacroInt(int ch) {
   return &chan[0].std;
 }
@@ -286,12 +308,17 @@ void DivPlatformPET::reset() {
   chan[0]=Channel();
   chan[0].std.setEngine(parent);
   rWrite(10,chan[0].wave);
+  lastOut=0;
 }
 
 int DivPlatformPET::getOutputCount() {
   return 1;
 }
 
+bool DivPlatformPET::hasAcquireDirect() {
+  return true;
+}
+
 void DivPlatformPET::notifyInsDeletion(void* ins) {
   chan[0].std.notifyInsDeletion((DivInstrument*)ins);
 }
@@ -40,14 +40,18 @@ class DivPlatformPET: public DivDispatch {
   Channel chan[1];
   DivDispatchOscBuffer* oscBuf;
   bool isMuted;
+  int lastOut;
 
   unsigned char regPool[16];
   friend void putDispatchChip(void*,int);
   friend void putDispatchChan(void*,int,int);
   public:
-    void acquire(short** buf, size_t len);
+    void acquireDirect(blip_buffer_t** bb, size_t len);
     int dispatch(DivCommand c);
     void* getChanState(int chan);
+    void* getState();
+    void setState(void* state);
+    void freeState(void* state);
     DivMacroInt* getChanMacroInt(int ch);
     DivDispatchOscBuffer* getOscBuffer(int chan);
     unsigned char* getRegisterPool();
@@ -58,6 +62,7 @@ class DivPlatformPET: public DivDispatch {
     void muteChannel(int ch, bool mute);
     void notifyInsDeletion(void* ins);
     int getOutputCount();
+    bool hasAcquireDirect();
     void poke(unsigned int addr, unsigned short val);
     void poke(std::vector<DivRegWrite>& wlist);
     const char** getRegisterSheet();
@@ -278,6 +278,22 @@ void* DivPlatformPokeMini::getChanState(int ch) {
   return &chan[ch];
 }
 
+void* DivPlatformPokeMini::getState() {
+  return copyStateOf(this);
+}
+
+void DivPlatformPokeMini::setState(void* state) {
+  DivDispatchOscBuffer* oscBufKeep=oscBuf;
+  bool isMutedKeep=isMuted[0];
+  restoreStateOf(this,(const DivPlatformPokeMini*)state);
+  oscBuf=oscBufKeep;
+  isMuted[0]=isMutedKeep;
+}
+
+void DivPlatformPokeMini::freeState(void* state) {
+  delete (DivPlatformPokeMini*)state;
+}
+
 DivMacroInt* DivPlatformPokeMini::getChanMacroInt(int ch) {
   return &chan[ch].std;
 }
@@ -21,7 +21,7 @@
 #include "../engine.h"
 #include "../../ta-log.h"
 
-#define rWrite(a,v) if (!skipRegisterWrites) {writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);} }
+#define rWrite(a,v) if (!skipRegisterWrites) {writeCount++; writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);} }
 
 #define CHIP_DIVIDER 1
 
@@ -66,11 +66,8 @@ const char** DivPlatformPOKEY::getRegisterSheet() {
 }
 
 void DivPlatformPOKEY::acquire(short** buf, size_t len) {
-  if (useAltASAP) {
-    acquireASAP(buf[0],len);
-  } else {
-    acquireMZ(buf[0],len);
-  }
+  // AltASAP uses acquireDirect()
+  acquireMZ(buf[0],len);
 }
 
 void DivPlatformPOKEY::acquireMZ(short* buf, size_t len) {
@@ -102,8 +99,10 @@ void DivPlatformPOKEY::acquireMZ(short* buf, size_t len) {
   }
 }
 
-void DivPlatformPOKEY::acquireASAP(short* buf, size_t len) {
-  thread_local short oscB[4];
+// AltASAP already runs its timers as events, so only output changes are
+// written to the blip buffer.
+void DivPlatformPOKEY::acquireDirect(blip_buffer_t** bb, size_t len) {
+  short oscB[4]={0};
 
   while (!writes.empty()) {
     QueuedWrite w=writes.front();
@@ -116,15 +115,20 @@ void DivPlatformPOKEY::acquireASAP(short* buf, size_t len) {
   }
 
   for (size_t h=0; h<len; h++) {
+    int sample;
     if (++oscBufDelay>=2) {
       oscBufDelay=0;
-      buf[h]=altASAP.sampleAudio(oscB);
-      
+      sample=altASAP.sampleAudio(oscB);
+
       for (int i=0; i<4; i++) {
         oscBuf[i]->putSample(h,oscB[i]);
       }
     } else {
-      buf[h]=altASAP.sampleAudio();
+      sample=altASAP.sampleAudio();
+    }
+    if (sample!=prevSample) {
+      blip_add_delta(bb[0],h,sample-prevSample);
+      prevSample=sample;
     }
   }
 
@@ -464,6 +468,7 @@ int DivPlatformPOKEY::getRegisterPoolSize() {
 
 void DivPlatformPOKEY::reset() {
   while (!writes.empty()) writes.pop();
+  prevSample=0;
   memset(regPool,0,16);
   for (int i=0; i<4; i++) {
     chan[i]=DivPlatformPOKEY::Channel();
@@ -489,6 +494,10 @@ bool DivPlatformPOKEY::keyOffAffectsArp(int ch) {
   return true;
 }
 
+bool DivPlatformPOKEY::hasAcquireDirect() {
+  return useAltASAP;
+}
+
 float DivPlatformPOKEY::getPostAmp() {
   return 2.0f;
 }
@@ -55,13 +55,14 @@ class DivPlatformPOKEY: public DivDispatch {
   PokeyState pokey;
   AltASAP::Pokey altASAP;
   bool useAltASAP;
+  int prevSample;
   unsigned char regPool[16];
   friend void putDispatchChip(void*,int);
   friend void putDispatchChan(void*,int,int);
   public:
     void acquire(short** buf, size_t len);
     void acquireMZ(short* buf, size_t len);
-    void acquireASAP(short* buf, size_t len);
+    void acquireDirect(blip_buffer_t** bb, size_t len);
     int dispatch(DivCommand c);
     void* getChanState(int chan);
     DivMacroInt* getChanMacroInt(int ch);
@@ -74,6 +75,7 @@ class DivPlatformPOKEY: public DivDispatch {
     void tick(bool sysTick=true);
     void muteChannel(int ch, bool mute);
     bool keyOffAffectsArp(int ch);
+    bool hasAcquireDirect();
     float getPostAmp();
     void setFlags(const DivConfig& flags);
     void notifyInsDeletion(void* ins);
@@ -205,6 +205,22 @@ void* DivPlatformPong::getChanState(int ch) {
   return &chan[ch];
 }
 
+void* DivPlatformPong::getState() {
+  return copyStateOf(this);
+}
+
+void DivPlatformPong::setState(void* state) {
+  DivDispatchOscBuffer* oscBufKeep=oscBuf;
+  bool isMutedKeep=isMuted[0];
+  restoreStateOf(this,(const DivPlatformPong*)state);
+  oscBuf=oscBufKeep;
+  isMuted[0]=isMutedKeep;
+}
+
+void DivPlatformPong::freeState(void* state) {
+  delete (DivPlatformPong*)state;
+}
+
 DivMacroInt* DivPlatformPong::getChanMacroInt(int ch) {
   return &chan[ch].std;
 }
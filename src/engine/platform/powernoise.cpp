@@ -24,7 +24,7 @@
 #include <math.h>
 #include "../bsr.h"
 
-#define rWrite(a,v) if (!skipRegisterWrites) {regPool[a]=(v); pwrnoise_write(&pn,(unsigned char)(a),(unsigned char)(v)); if (dumpWrites) {addWrite(a,v);}}
+#define rWrite(a,v) if (!skipRegisterWrites) {writeCount++; regPool[a]=(v); pwrnoise_write(&pn,(unsigned char)(a),(unsigned char)(v)); if (dumpWrites) {addWrite(a,v);}}
 #define chWrite(c,a,v) rWrite((c<<3)|((a)+1),(v))
 #define noiseCtl(enable,am,tapB) (((enable)?0x80:0x00)|((am)?0x02:0x00)|((tapB)?0x01:0x00))
 #define slopeCtl(enable,rst,a,b) (((enable)?0x80:0x00)| \
@@ -18,10 +18,11 @@
  */
 
 #include "pv1000.h"
+#include "chipUtils.h"
 #include "../engine.h"
 #include <math.h>
 
-#define rWrite(a,v) {regPool[(a)]=(v)&0xff; d65010g031_write(&d65010g031,a,v);}
+#define rWrite(a,v) {writeCount++; regPool[(a)]=(v)&0xff; d65010g031_write(&d65010g031,a,v);}
 
 #define CHIP_DIVIDER 1024
 
@@ -37,18 +38,28 @@ const char** DivPlatformPV1000::getRegisterSheet() {
   return regCheatSheetPV1000;
 }
 
-void DivPlatformPV1000::acquire(short** buf, size_t len) {
+void DivPlatformPV1000::acquireDirect(blip_buffer_t** bb, size_t len) {
   for (int i=0; i<3; i++) {
     oscBuf[i]->begin(len);
   }
-  
-  for (size_t h=0; h<len; h++) {
-    short samp=d65010g031_sound_tick(&d65010g031,1);
-    buf[0][h]=samp;
+
+  divRunEvents(len,[this](int advance) -> int {
+    // the squares only run while sound is enabled
+    if (!(d65010g031.ctrl&2)) return advance;
+    for (int i=0; i<3; i++) {
+      const d65010g031_square_t& sq=d65010g031.square[i];
+      if (sq.period==0) continue;
+      const int remain=sq.period-sq.counter;
+      if (remain<advance) advance=remain;
+    }
+    return advance;
+  },[this,bb](size_t h, int advance) {
+    short samp=d65010g031_sound_tick(&d65010g031,advance);
+    divBlipPut(bb[0],h,samp,lastOut);
     for (int i=0; i<3; i++) {
       oscBuf[i]->putSample(h,MAX(d65010g031.out[i]<<2,0));
     }
-  }
+  });
 
   for (int i=0; i<3; i++) {
     oscBuf[i]->end(len);
@@ -226,6 +237,27 @@ void* DivPlatformPV1000::getChanState(int ch) {
   return &chan[ch];
 }
 
+void* DivPlatformPV1000::getState() {
+  return copyStateOf(this);
+}
+
+void DivPlatformPV1000::setState(void* state) {
+  // lastOut belongs to the output buffer, not to the chip
+  DivDispatchOscBuffer* oscBufKeep[3];
+  bool isMutedKeep[3];
+  int lastOutKeep=lastOut;
+  memcpy(oscBufKeep,oscBuf,3*sizeof(void*));
+  memcpy(isMutedKeep,isMuted,3*sizeof(bool));
+  restoreStateOf(this,(const DivPlatformPV1000*)state);
+  memcpy(oscBuf,oscBufKeep,3*sizeof(void*));
+  memcpy(isMuted,isMutedKeep,3*sizeof(bool));
+  lastOut=lastOutKeep;
+}
+
+void DivPlatformPV1000::freeState(void* state) {
+  delete (DivPlatformPV1000*)state;
+}
+
 DivMacroInt* DivPlatformPV1000::getChanMacroInt(int ch) {
   return &chan[ch].std;
 }
@@ -254,6 +286,8 @@ void DivPlatformPV1000::reset() {
   rWrite(1,0x3f);
   rWrite(2,0x3f);
   rWrite(3,2);
+  // start from the idle level, so that there's no click
+  lastOut=d65010g031_sound_tick(&d65010g031,0);
 }
 
 int DivPlatformPV1000::getOutputCount() {
@@ -287,6 +321,10 @@ bool DivPlatformPV1000::getDCOffRequired() {
   return true;
 }
 
+bool DivPlatformPV1000::hasAcquireDirect() {
+  return true;
+}
+
 int DivPlatformPV1000::init(DivEngine* p, int channels, int sugRate, const DivConfig& flags) {
   parent=p;
   dumpWrites=false;
@@ -25,7 +25,7 @@
 #define CHIP_DIVIDER (1248*2)
 #define QS_NOTE_FREQUENCY(x) parent->calcBaseFreq(440,4096,(x)-3,false)
 
-#define rWrite(a,v) {if(!skipRegisterWrites) {qsound_write_data(&chip,a,v); if(dumpWrites) addWrite(a,v); }}
+#define rWrite(a,v) {if(!skipRegisterWrites) {writeCount++; qsound_write_data(&chip,a,v); if(dumpWrites) addWrite(a,v); }}
 #define immWrite(a,v) {qsound_write_data(&chip,a,v); if(dumpWrites) addWrite(a,v);}
 
 const char* regCheatSheetQSound[]={
@@ -771,7 +771,7 @@ const DivMemoryComposition* DivPlatformQSound::getMemCompo(int index) {
 }
 
 void DivPlatformQSound::renderSamples(int sysID) {
-  memset(sampleMem,0,getSampleMemCapacity());
+  clearSampleMem(sampleMem,getSampleMemCapacity());
   memset(offPCM,0,32768*sizeof(unsigned int));
   memset(offBS,0,32768*sizeof(unsigned int));
   memset(sampleLoaded,0,32768*sizeof(bool));
@@ -871,7 +871,7 @@ int DivPlatformQSound::init(DivEngine* p, int channels, int sugRate, const DivCo
 
   chipClock=60000000;
   rate = qsound_start(&chip, chipClock);
-  sampleMem=new unsigned char[getSampleMemCapacity()];
+  sampleMem=(unsigned char*)allocSampleMem(getSampleMemCapacity());
   sampleMemLen=0;
   sampleMemLenBS=0;
   sampleMemUsage=0;
@@ -886,7 +886,7 @@ int DivPlatformQSound::init(DivEngine* p, int channels, int sugRate, const DivCo
 }
 
 void DivPlatformQSound::quit() {
-  delete[] sampleMem;
+  freeSampleMem(sampleMem);
   for (int i=0; i<19; i++) {
     delete oscBuf[i];
   }
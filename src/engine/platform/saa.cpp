@@ -24,7 +24,7 @@
 #include <string.h>
 #include <math.h>
 
-#define rWrite(a,v) if (!skipRegisterWrites) {writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);} }
+#define rWrite(a,v) if (!skipRegisterWrites) {writeCount++; writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);} }
 
 #define CHIP_DIVIDER 2
 
@@ -57,14 +57,9 @@ const char** DivPlatformSAA1099::getRegisterSheet() {
   return regCheatSheetSAA;
 }
 
-void DivPlatformSAA1099::acquire_saaSound(short** buf, size_t len) {
-  if (saaBufLen<len*2) {
-    saaBufLen=len*2;
-    for (int i=0; i<2; i++) {
-      delete[] saaBuf[i];
-      saaBuf[i]=new short[saaBufLen];
-    }
-  }
+void DivPlatformSAA1099::acquire_saaSound(blip_buffer_t** bb, size_t len) {
+  short out[2];
+
   while (!writes.empty()) {
     QueuedWrite w=writes.front();
     saa_saaSound->WriteAddressData(w.addr,w.val);
@@ -74,25 +69,30 @@ void DivPlatformSAA1099::acquire_saaSound(short** buf, size_t len) {
   for (int i=0; i<6; i++) {
     oscBuf[i]->begin(len);
   }
-  saa_saaSound->GenerateMany((unsigned char*)saaBuf[0],len,oscBuf);
+  for (size_t h=0; h<len; h++) {
+    // the output doesn't change until a frequency or noise generator does
+    unsigned int steady=saa_saaSound->SamplesUntilChange(len-h);
+
+    saa_saaSound->GenerateOne(out[0],out[1],oscBuf,h);
+    for (int i=0; i<2; i++) {
+      if (out[i]!=lastOut[i]) {
+        blip_add_delta(bb[i],h,out[i]-lastOut[i]);
+        lastOut[i]=out[i];
+      }
+    }
+
+    if (steady>1) {
+      saa_saaSound->SkipSamples(steady-1);
+      h+=steady-1;
+    }
+  }
   for (int i=0; i<6; i++) {
     oscBuf[i]->end(len);
   }
-#ifdef TA_BIG_ENDIAN
-  for (size_t i=0; i<len; i++) {
-    buf[0][i]=(short)((((unsigned short)saaBuf[0][i<<1])<<8)|(((unsigned short)saaBuf[0][i<<1])>>8));
-    buf[1][i]=(short)((((unsigned short)saaBuf[0][1+(i<<1)])<<8)|(((unsigned short)saaBuf[0][1+(i<<1)])>>8));
-  }
-#else
-  for (size_t i=0; i<len; i++) {
-    buf[0][i]=saaBuf[0][i<<1];
-    buf[1][i]=saaBuf[0][1+(i<<1)];
-  }
-#endif
 }
 
-void DivPlatformSAA1099::acquire(short** buf, size_t len) {
-  acquire_saaSound(buf,len);
+void DivPlatformSAA1099::acquireDirect(blip_buffer_t** bb, size_t len) {
+  acquire_saaSound(bb,len);
 }
 
 inline unsigned char applyPan(unsigned char vol, unsigned char pan) {
@@ -389,6 +389,8 @@ void DivPlatformSAA1099::reset() {
   }
 
   lastBusy=60;
+  lastOut[0]=0;
+  lastOut[1]=0;
   saaEnv[0]=0;
   saaEnv[1]=0;
   saaNoise[0]=0;
@@ -415,6 +417,10 @@ int DivPlatformSAA1099::getOutputCount() {
   return 2;
 }
 
+bool DivPlatformSAA1099::hasAcquireDirect() {
+  return true;
+}
+
 bool DivPlatformSAA1099::hasSoftPan(int ch) {
   return true;
 }
@@ -504,8 +510,6 @@ int DivPlatformSAA1099::init(DivEngine* p, int channels, int sugRate, const DivC
   saa_saaSound->SetOversample(1);
   saa_saaSound->SetSoundParameters(SAAP_NOFILTER|SAAP_16BIT|SAAP_STEREO);
   setFlags(flags);
-  saaBufLen=65536;
-  for (int i=0; i<2; i++) saaBuf[i]=new short[saaBufLen];
   reset();
   return 3;
 }
@@ -518,5 +522,4 @@ void DivPlatformSAA1099::quit() {
     DestroyCSAASound(saa_saaSound);
     saa_saaSound=NULL;
   }
-  for (int i=0; i<2; i++) delete[] saaBuf[i];
 }
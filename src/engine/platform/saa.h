@@ -59,17 +59,16 @@ class DivPlatformSAA1099: public DivDispatch {
   
     short oldWrites[16];
     short pendingWrites[16];
-    short* saaBuf[2];
-    size_t saaBufLen;
+    short lastOut[2];
     unsigned char saaEnv[2];
     unsigned char saaNoise[2];
     friend void putDispatchChip(void*,int);
     friend void putDispatchChan(void*,int,int);
 
-    void acquire_saaSound(short** buf, size_t len);
+    void acquire_saaSound(blip_buffer_t** bb, size_t len);
   
   public:
-    void acquire(short** buf, size_t len);
+    void acquireDirect(blip_buffer_t** bb, size_t len);
     int dispatch(DivCommand c);
     void* getChanState(int chan);
     DivMacroInt* getChanMacroInt(int ch);
@@ -83,6 +82,7 @@ class DivPlatformSAA1099: public DivDispatch {
     void muteChannel(int ch, bool mute);
     void setFlags(const DivConfig& flags);
     int getOutputCount();
+    bool hasAcquireDirect();
     bool hasSoftPan(int ch);
     int getPortaFloor(int ch);
     bool keyOffAffectsArp(int ch);
@@ -24,7 +24,7 @@
 #include <math.h>
 
 //#define rWrite(a,v) pendingWrites[a]=v;
-#define rWrite(a,v) if (!skipRegisterWrites) {packet[a]=v; writePacket=true; if (dumpWrites) {addWrite(a,v);} }
+#define rWrite(a,v) if (!skipRegisterWrites) {writeCount++; packet[a]=v; writePacket=true; if (dumpWrites) {addWrite(a,v);} }
 
 const char* regCheatSheetUPD1771cTone[]={
   NULL
@@ -19,15 +19,17 @@
 
 #include "segapcm.h"
 #include "../engine.h"
+#include "../sampleRAM.h"
 #include "../../ta-log.h"
 #include <string.h>
 #include <math.h>
+#include <algorithm>
 
-#define rWrite(a,v) if (!skipRegisterWrites) {writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);} }
+#define rWrite(a,v) if (!skipRegisterWrites) {writeCount++; writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);} }
 #define chWrite(c,a,v) rWrite(((c)<<3)+(a),v)
 
 void DivPlatformSegaPCM::acquire(short** buf, size_t len) {
-  thread_local int os[2];
+  int os[2]={0};
 
   for (int i=0; i<16; i++) {
     oscBuf[i]->begin(len);
@@ -471,6 +473,7 @@ const DivMemoryComposition* DivPlatformSegaPCM::getMemCompo(int index) {
 
 void DivPlatformSegaPCM::renderSamples(int sysID) {
   size_t memPos=0;
+  sampleMemLen=0;
 
   memset(sampleMem,0,2097152);
   memset(sampleLoaded,0,32768*sizeof(bool));
@@ -479,7 +482,9 @@ void DivPlatformSegaPCM::renderSamples(int sysID) {
 
   memCompo=DivMemoryComposition();
   memCompo.name="Sample ROM";
-  
+
+  // samples may not cross a 64K bank and must end on a 256-byte page
+  std::vector<DivSamplePacker::Item> items;
   for (int i=0; i<parent->song.sampleLen; i++) {
     DivSample* sample=parent->getSample(i);
     if (!sample->renderOn[0][sysID]) {
@@ -489,15 +494,25 @@ void DivPlatformSegaPCM::renderSamples(int sysID) {
 
     unsigned int alignedSize=sample->getLoopEndPosition(DIV_SAMPLE_DEPTH_8BIT);
     if (alignedSize>=65279) alignedSize=65279;
-    if ((memPos&(~0xffff))!=((memPos+alignedSize)&(~0xffff))) {
-      memPos=(memPos+0xffff)&(~0xffff);
-    }
-    if (alignedSize&0xff) {
-      memPos=((memPos+255)&(~0xff))+256-(alignedSize&0xff);
+    items.push_back(DivSamplePacker::Item(i,alignedSize));
+  }
+  if (packSamples) {
+    DivSamplePacker::pack(items,2097152,65536,256);
+  } else {
+    DivSamplePacker::packInOrder(items,2097152,65536,256);
+  }
+
+  for (DivSamplePacker::Item& item: items) {
+    int i=item.index;
+    DivSample* sample=parent->getSample(i);
+    unsigned int alignedSize=item.len;
+    if (!item.placed || item.truncated) {
+      logW("out of SegaPCM memory for sample %d!",i);
     }
+    if (!item.placed) continue;
+    memPos=item.pos;
     logV("- sample %d will be at %x with length %x",i,memPos,alignedSize);
     sampleLoaded[i]=true;
-    if (memPos>=2097152) break;
     sampleOffSegaPCM[i]=memPos;
     memCompo.entries.push_back(DivMemoryEntry(DIV_MEMORY_SAMPLE,"Sample",i,memPos,memPos+alignedSize));
     for (unsigned int j=0; j<alignedSize; j++) {
@@ -506,18 +521,33 @@ void DivPlatformSegaPCM::renderSamples(int sysID) {
       } else {
         sampleMem[memPos++]=((unsigned char)sample->data8[j]+0x80);
       }
-      sampleEndSegaPCM[i]=((memPos+0xff)>>8)-1;
-      if (memPos>=2097152) break;
     }
+    sampleEndSegaPCM[i]=((memPos+0xff)>>8)-1;
     logV("  and it ends in %d",sampleEndSegaPCM[i]);
-    if (memPos>=2097152) break;
+    if (memPos>sampleMemLen) sampleMemLen=memPos;
   }
-  sampleMemLen=memPos;
+  std::sort(memCompo.entries.begin(),memCompo.entries.end(),[](const DivMemoryEntry& a, const DivMemoryEntry& b) {
+    return a.begin<b.begin;
+  });
 
   memCompo.used=sampleMemLen;
   memCompo.capacity=getSampleMemCapacity(0);
 }
 
+bool DivPlatformSegaPCM::copySamplesFrom(DivDispatch* other) {
+  DivPlatformSegaPCM* o=(DivPlatformSegaPCM*)other;
+
+  // clear what the previous render left past the end
+  if (sampleMemLen>o->sampleMemLen) memset(&sampleMem[o->sampleMemLen],0,sampleMemLen-o->sampleMemLen);
+  memcpy(sampleMem,o->sampleMem,o->sampleMemLen);
+  memcpy(sampleLoaded,o->sampleLoaded,32768*sizeof(bool));
+  memcpy(sampleOffSegaPCM,o->sampleOffSegaPCM,32768*sizeof(unsigned int));
+  memcpy(sampleEndSegaPCM,o->sampleEndSegaPCM,32768);
+  sampleMemLen=o->sampleMemLen;
+  memCompo=o->memCompo;
+  return true;
+}
+
 void DivPlatformSegaPCM::setFlags(const DivConfig& flags) {
   chipClock=8000000.0;
   CHECK_CUSTOM_CLOCK;
@@ -527,6 +557,7 @@ void DivPlatformSegaPCM::setFlags(const DivConfig& flags) {
   }
 
   oldSlides=flags.getBool("oldSlides",false);
+  packSamples=flags.getBool("packSamples",false);
 }
 
 int DivPlatformSegaPCM::getOutputCount() {
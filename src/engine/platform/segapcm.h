@@ -67,6 +67,7 @@ class DivPlatformSegaPCM: public DivDispatch {
     int delay;
     int pcmL, pcmR, pcmCycles;
     bool oldSlides;
+    bool packSamples;
     unsigned char lastBusy;
 
     unsigned char regPool[256];
@@ -102,6 +103,7 @@ class DivPlatformSegaPCM: public DivDispatch {
     void notifyInsChange(int ins);
     void notifyInsDeletion(void* ins);
     void renderSamples(int chipID);
+    bool copySamplesFrom(DivDispatch* other);
     void setFlags(const DivConfig& flags);
     int getOutputCount();
     bool hasSoftPan(int ch);
@@ -31,13 +31,15 @@
 // - RING/SYNC: per-operator bits in reg6; masks map op0..3 to the previous operator (op0 uses op3).
 // - Global regs: SoundUnit-style flags0/flags1; KEY-ON is flags0 bit0; WAVE bits live per-operator.
 
-#define rWrite(a,v) if (!skipRegisterWrites) {writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);} if ((a) < SGU_REG_POOL_SIZE) {regPool[(a)]=(v);} }
+#define rWrite(a,v) if (!skipRegisterWrites) {writeCount++; writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);} if ((a) < SGU_REG_POOL_SIZE) {regPool[(a)]=(v);} }
 
 static constexpr int SGU_CH_BASE = SGU_OP_PER_CH * SGU_OP_REGS;
 
 #define opWrite(c,o,a,v) rWrite(((c) * SGU_REGS_PER_CH) + ((o) * SGU_OP_REGS) + (a), (v))
 #define chWrite(c,a,v)   rWrite(((c) * SGU_REGS_PER_CH) + SGU_CH_BASE + (a), (v))
 
+#define SGU_BLOCK_SIZE 256
+
 #define CHIP_FREQBASE 524288
 
 static const char* regCheatSheetSGU[]={
@@ -713,26 +715,37 @@ void DivPlatformSGU::commitState(int ch, DivInstrument* ins) {
 }
 
 void DivPlatformSGU::acquire(short** buf, size_t len) {
-  int32_t l=0;
-  int32_t r=0;
+  int32_t l[SGU_BLOCK_SIZE];
+  int32_t r[SGU_BLOCK_SIZE];
+  short oscOut[SGU_CHNS][SGU_BLOCK_SIZE];
+  short* oscPtr[SGU_CHNS];
 
   for (int i=0; i<SGU_CHNS; i++) {
     oscBuf[i]->begin(len);
+    oscPtr[i]=oscOut[i];
   }
 
-  for (size_t h=0; h<len; h++) {
-    while (!writes.empty()) {
-      QueuedWrite w=writes.front();
-      SGU_Write(sgu,w.addr,w.val);
-      writes.pop();
-    }
+  // writes are only queued outside of acquire, so flushing them once up
+  // front is the same as flushing them before the first sample.
+  while (!writes.empty()) {
+    QueuedWrite w=writes.front();
+    SGU_Write(sgu,w.addr,w.val);
+    writes.pop();
+  }
+
+  for (size_t h=0; h<len; h+=SGU_BLOCK_SIZE) {
+    size_t blockLen=MIN(len-h,(size_t)SGU_BLOCK_SIZE);
+    SGU_NextBlock(sgu,l,r,oscPtr,blockLen);
 
-    SGU_NextSample(sgu,&l,&r);
-    buf[0][h]=CLAMP(l,-32768,32767);
-    buf[1][h]=CLAMP(r,-32768,32767);
+    for (size_t j=0; j<blockLen; j++) {
+      buf[0][h+j]=CLAMP(l[j],-32768,32767);
+      buf[1][h+j]=CLAMP(r[j],-32768,32767);
+    }
 
     for (int i=0; i<SGU_CHNS; i++) {
-      oscBuf[i]->putSample(h,SGU_GetSample(sgu,i));
+      for (size_t j=0; j<blockLen; j++) {
+        oscBuf[i]->putSample(h+j,oscOut[i][j]);
+      }
     }
   }
 
@@ -1566,42 +1579,16 @@ const DivMemoryComposition* DivPlatformSGU::getMemCompo(int index) {
 }
 
 void DivPlatformSGU::renderSamples(int sysID) {
-  memset(sampleMem,0,SGU_PCM_RAM_SIZE);
-  memset(sampleOffSGU,0,32768*sizeof(unsigned int));
-  memset(sampleLoaded,0,32768*sizeof(bool));
-
   memCompo=DivMemoryComposition();
   memCompo.name="Sample RAM";
 
-  size_t memPos=0;
-  for (int i=0; i<parent->song.sampleLen; i++) {
-    DivSample* s=parent->song.sample[i];
-    if (s->data8==NULL) continue;
-    if (!s->renderOn[0][sysID]) {
-      sampleOffSGU[i]=0;
-      continue;
-    }
-
-    int paddedLen=s->length8;
-    if (memPos>=getSampleMemCapacity(0)) {
-      logW("out of PCM memory for sample %d!",i);
-      break;
-    }
-    if (memPos+paddedLen>=getSampleMemCapacity(0)) {
-      memcpy(sampleMem+memPos,s->data8,getSampleMemCapacity(0)-memPos);
-      logW("out of PCM memory for sample %d!",i);
-    } else {
-      memcpy(sampleMem+memPos,s->data8,paddedLen);
-      sampleLoaded[i]=true;
-    }
-    sampleOffSGU[i]=memPos;
-    memCompo.entries.push_back(DivMemoryEntry(DIV_MEMORY_SAMPLE,"Sample",i,memPos,memPos+paddedLen));
-    memPos+=paddedLen;
-  }
-  sampleMemLen=memPos;
+  sampleMemLen=sampleRAM.render(parent->song.sample,parent->song.sampleLen,sysID,(unsigned char*)sampleMem,SGU_PCM_RAM_SIZE,sampleOffSGU,sampleLoaded,memCompo);
   sysIDCache=sysID;
 
-  memcpy(sgu->pcm,sampleMem,SGU_PCM_RAM_SIZE);
+  // only upload what changed
+  for (DivSampleRAM::Range& i: sampleRAM.dirty) {
+    memcpy(sgu->pcm+i.begin,sampleMem+i.begin,i.end-i.begin);
+  }
 
   memCompo.used=sampleMemLen;
   memCompo.capacity=SGU_PCM_RAM_SIZE;
@@ -22,6 +22,7 @@
 
 #include "../dispatch.h"
 #include "../../fixedQueue.h"
+#include "../sampleRAM.h"
 #include "sound/sgu.h"
 
 class DivPlatformSGU: public DivDispatch {
@@ -109,6 +110,7 @@ class DivPlatformSGU: public DivDispatch {
   bool* sampleLoaded;
   signed char* sampleMem;
   size_t sampleMemLen;
+  DivSampleRAM sampleRAM;
   DivMemoryComposition memCompo;
   int sysIDCache;
 
@@ -18,11 +18,12 @@
  */
 
 #include "sm8521.h"
+#include "chipUtils.h"
 #include "../engine.h"
 #include <math.h>
 
 //#define rWrite(a,v) pendingWrites[a]=v;
-#define rWrite(a,v) if (!skipRegisterWrites) {writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);} }
+#define rWrite(a,v) if (!skipRegisterWrites) {writeCount++; writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);} }
 
 #define CHIP_DIVIDER 32
 
@@ -59,8 +60,7 @@ void DivPlatformSM8521::acquireDirect(blip_buffer_t** bb, size_t len) {
     oscBuf[i]->begin(len);
   }
 
-  for (size_t h=0; h<len; h++) {
-    int advance=len-h;
+  divRunEvents(len,[this](int advance) -> int {
     if (sm8521.sgc&1) {
       const int remain=(sm8521.sg[0].base.t+1)-sm8521.sg[0].base.counter;
       if (remain<advance) advance=remain;
@@ -73,21 +73,16 @@ void DivPlatformSM8521::acquireDirect(blip_buffer_t** bb, size_t len) {
       const int remain=(sm8521.noise.base.t+1)-sm8521.noise.base.counter;
       if (remain<advance) advance=remain;
     }
-    if (advance<1) advance=1;
+    return advance;
+  },[this,bb](size_t h, int advance) {
     sm8521_sound_tick(&sm8521,advance);
 
-    h+=advance-1;
-
-    int out=sm8521.out<<6;
-    if (out!=lastOut) {
-      blip_add_delta(bb[0],h,out-lastOut);
-      lastOut=out;
-    }
+    divBlipPut(bb[0],h,sm8521.out<<6,lastOut);
     for (int i=0; i<2; i++) {
       oscBuf[i]->putSample(h,sm8521.sg[i].base.out<<7);
     }
     oscBuf[2]->putSample(h,sm8521.noise.base.out<<7);
-  }
+  });
 
   for (int i=0; i<3; i++) {
     oscBuf[i]->end(len);
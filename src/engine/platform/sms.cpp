@@ -22,7 +22,7 @@
 #include "../../ta-log.h"
 #include <math.h>
 
-#define rWrite(a,v) {if (!skipRegisterWrites) {writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);}}}
+#define rWrite(a,v) {if (!skipRegisterWrites) {writeCount++; writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);}}}
 
 const char* regCheatSheetSN[]={
   "DATA", "0",
@@ -119,7 +119,7 @@ void DivPlatformSMS::acquire_nuked(short** buf, size_t len) {
 }
 
 void DivPlatformSMS::acquire_mame(blip_buffer_t** bb, size_t len) {
-  thread_local short outs[2];
+  short outs[2]={0};
 
   while (!writes.empty()) {
     QueuedWrite w=writes.front();
@@ -23,6 +23,7 @@
 #include "FilterModelConfig6581.h"
 
 #include <cmath>
+#include <mutex>
 
 #include "Integrator6581.h"
 #include "OpAmp.h"
@@ -92,6 +93,10 @@ std::unique_ptr<FilterModelConfig6581> FilterModelConfig6581::instance(nullptr);
 
 FilterModelConfig6581* FilterModelConfig6581::getInstance()
 {
+    // dispatches may be initialized in parallel
+    static std::mutex instanceLock;
+    std::lock_guard<std::mutex> lock(instanceLock);
+
     if (!instance.get())
     {
         instance.reset(new FilterModelConfig6581());
@@ -22,6 +22,8 @@
 
 #include "FilterModelConfig8580.h"
 
+#include <mutex>
+
 #include "Integrator8580.h"
 #include "OpAmp.h"
 
@@ -111,6 +113,10 @@ std::unique_ptr<FilterModelConfig8580> FilterModelConfig8580::instance(nullptr);
 
 FilterModelConfig8580* FilterModelConfig8580::getInstance()
 {
+    // dispatches may be initialized in parallel
+    static std::mutex instanceLock;
+    std::lock_guard<std::mutex> lock(instanceLock);
+
     if (!instance.get())
     {
         instance.reset(new FilterModelConfig8580());
@@ -174,6 +174,8 @@ matrix_t* WaveformCalculator::buildTable(ChipModel model)
 {
     const CombinedWaveformConfig* cfgArray = config[model == MOS6581 ? 0 : 1];
 
+    std::lock_guard<std::mutex> lock(cacheLock);
+
     cw_cache_t::iterator lb = CACHE.lower_bound(cfgArray);
 
     if (lb != CACHE.end() && !(CACHE.key_comp()(cfgArray, lb->first)))
@@ -23,6 +23,7 @@
 #define WAVEFORMCALCULATOR_h
 
 #include <map>
+#include <mutex>
 
 #include "array.h"
 #include "sidcxx11.h"
@@ -105,6 +106,8 @@ private:
 
 private:
     cw_cache_t CACHE;
+    // dispatches may be initialized in parallel
+    std::mutex cacheLock;
 
     WaveformCalculator() DEFAULT;
 
@@ -58,6 +58,8 @@ namco_audio_device::namco_audio_device(uint32_t clock)
 	, m_voices(0)
 	, m_stereo(false)
 {
+	for (unsigned int i = 0; i < MAX_VOICES; i++)
+		m_voice_out[i] = nullptr;
 }
 
 namco_device::namco_device(uint32_t clock)
@@ -172,14 +174,29 @@ void namco_audio_device::build_decoded_waveform(uint8_t *rgnbase)
 
 
 /* generate sound by oversampling */
-uint32_t namco_audio_device::namco_update_one(short* buffer, int size, const int16_t *wave, uint32_t counter, uint32_t freq, int16_t& last_out)
+uint32_t namco_audio_device::namco_update_one(short* buffer, int size, const int16_t *wave, uint32_t counter, uint32_t freq, int16_t& last_out, int16_t* voice_out)
 {
-	for (int sampindex = 0; sampindex < size; sampindex++)
+	/* (tildearrow) the voice buffer is checked once rather than per sample */
+	if (voice_out)
 	{
-    last_out=wave[WAVEFORM_POSITION(counter)];
-		buffer[sampindex]+=wave[WAVEFORM_POSITION(counter)];
-		counter += freq;
+		for (int sampindex = 0; sampindex < size; sampindex++)
+		{
+			const int16_t s = wave[WAVEFORM_POSITION(counter)];
+			buffer[sampindex] += s;
+			voice_out[sampindex] = s;
+			counter += freq;
+		}
 	}
+	else
+	{
+		for (int sampindex = 0; sampindex < size; sampindex++)
+		{
+			buffer[sampindex] += wave[WAVEFORM_POSITION(counter)];
+			counter += freq;
+		}
+	}
+	if (size > 0)
+		last_out = wave[WAVEFORM_POSITION(counter - freq)];
 
 	return counter;
 }
@@ -617,6 +634,15 @@ void namco_15xx_device::sharedram_w(int offset, uint8_t data)
 
 void namco_audio_device::sound_stream_update(short** outputs, int len)
 {
+	/* (tildearrow) voices which aren't updated keep their last output */
+	for (sound_channel *voice = m_channel_list; voice < m_last_channel; voice++)
+	{
+		int16_t* vout = m_voice_out[voice - m_channel_list];
+		if (vout == nullptr) continue;
+		for (int i = 0; i < len; i++)
+			vout[i] = voice->last_out;
+	}
+
 	if (m_stereo)
 	{
 		/* zap the contents of the buffers */
@@ -634,6 +660,7 @@ void namco_audio_device::sound_stream_update(short** outputs, int len)
 			short* rmix = outputs[1];
 			int lv = voice->volume[0];
 			int rv = voice->volume[1];
+			int16_t* vout = m_voice_out[voice - m_channel_list];
 
 			if (voice->noise_sw)
 			{
@@ -667,6 +694,7 @@ void namco_audio_device::sound_stream_update(short** outputs, int len)
 							rmix[i]+=-r_noise_data;
              voice->last_out=-((l_noise_data+r_noise_data)>>1);
 						}
+						if (vout) vout[i]=voice->last_out;
 
 						if (hold)
 						{
@@ -703,7 +731,7 @@ void namco_audio_device::sound_stream_update(short** outputs, int len)
 					const int16_t *lw = &m_waveform[lv][voice->waveform_select * 32];
 
 					/* generate sound into the buffer */
-					c = namco_update_one(lmix, len, lw, voice->counter, voice->frequency, voice->last_out);
+					c = namco_update_one(lmix, len, lw, voice->counter, voice->frequency, voice->last_out, vout);
 				}
 
 				/* only update if we have non-zero right volume */
@@ -712,7 +740,7 @@ void namco_audio_device::sound_stream_update(short** outputs, int len)
 					const int16_t *rw = &m_waveform[rv][voice->waveform_select * 32];
 
 					/* generate sound into the buffer */
-					c = namco_update_one(rmix, len, rw, voice->counter, voice->frequency, voice->last_out);
+					c = namco_update_one(rmix, len, rw, voice->counter, voice->frequency, voice->last_out, vout);
 				}
 
 				/* update the counter for this voice */
@@ -736,6 +764,7 @@ void namco_audio_device::sound_stream_update(short** outputs, int len)
 		for (voice = m_channel_list; voice < m_last_channel; voice++)
 		{
 			int v = voice->volume[0];
+			int16_t* vout = m_voice_out[voice - m_channel_list];
 			if (voice->noise_sw)
 			{
 				int f = voice->frequency & 0xff;
@@ -765,6 +794,7 @@ buffer[i]+=noise_data;
                         voice->last_out=-noise_data;
 
 }
+						if (vout) vout[i]=voice->last_out;
 
 						if (hold)
 						{
@@ -798,7 +828,7 @@ buffer[i]+=noise_data;
 					const int16_t *w = &m_waveform[v][voice->waveform_select * 32];
 
 					/* generate sound into buffer and update the counter for this voice */
-					voice->counter = namco_update_one(buffer, len, w, voice->counter, voice->frequency, voice->last_out);
+					voice->counter = namco_update_one(buffer, len, w, voice->counter, voice->frequency, voice->last_out, vout);
 				}
 			}
 		}
@@ -44,7 +44,7 @@ public:
 
 	void build_decoded_waveform( uint8_t *rgnbase );
 	void update_namco_waveform(int offset, uint8_t data);
-	uint32_t namco_update_one(short* buffer, int size, const int16_t *wave, uint32_t counter, uint32_t freq, int16_t& last_out);
+	uint32_t namco_update_one(short* buffer, int size, const int16_t *wave, uint32_t counter, uint32_t freq, int16_t& last_out, int16_t* voice_out);
 
 	/* waveform region */
 	uint8_t* m_wave_ptr;
@@ -69,6 +69,10 @@ public:
 	/* decoded waveform table */
 	int16_t m_waveform[MAX_VOLUME][512];
 
+	/* (tildearrow) output of each voice for every sample of an update, or NULL.
+	   voices which aren't updated repeat last_out. */
+	int16_t* m_voice_out[MAX_VOICES];
+
 	virtual void sound_stream_update(short** outputs, int len);
         virtual ~namco_audio_device() {}
 };
@@ -108,7 +108,9 @@ static void compute_tables()
 
 void okim6258_device::device_start()
 {
-	compute_tables();
+	/* the tables are shared by all instances. compute them once */
+	static const bool tables_ready = (compute_tables(), true);
+	(void)tables_ready;
 
 	m_divider = dividers[m_start_divider];
 
@@ -574,6 +574,7 @@ static void state_normal_update(struct qsound_chip *chip)
 	int v, ch;
 	int32_t echo_input = 0;
 	int16_t echo_output;
+	uint16_t pan_index[19];
 
 	chip->ready_flag = 0x80;
 
@@ -596,6 +597,14 @@ static void state_normal_update(struct qsound_chip *chip)
 
 	echo_output = echo(&chip->echo,echo_input);
 
+	// pan table positions are the same for both channels
+	for(v=0; v<19; v++)
+	{
+		pan_index[v] = chip->voice_pan[v]-0x110;
+		if(pan_index[v] > 97)
+			pan_index[v] = 97;
+	}
+
 	// now, we do the magic stuff
 	for(ch=0; ch<2; ch++)
 	{
@@ -605,15 +614,11 @@ static void state_normal_update(struct qsound_chip *chip)
 		int32_t dry = (ch == 0) ? echo_output<<14 : 0;
 		int32_t output = 0;
 
-		for(int v=0; v<19; v++)
+		for(v=0; v<19; v++)
 		{
-			uint16_t pan_index = chip->voice_pan[v]-0x110;
-			if(pan_index > 97)
-				pan_index = 97;
-
 			// Apply different volume tables on the dry and wet inputs.
-			dry -= (chip->voice_output[v] * chip->pan_tables[ch][PANTBL_DRY][pan_index]);
-			wet -= (chip->voice_output[v] * chip->pan_tables[ch][PANTBL_WET][pan_index]);
+			dry -= (chip->voice_output[v] * chip->pan_tables[ch][PANTBL_DRY][pan_index[v]]);
+			wet -= (chip->voice_output[v] * chip->pan_tables[ch][PANTBL_WET][pan_index[v]]);
 		}
 
 		// Saturate accumulated voices
@@ -656,14 +661,17 @@ static void state_normal_update(struct qsound_chip *chip)
 static inline int32_t fir(struct qsound_fir *f, int16_t input)
 {
 	int32_t output = 0, tap = 0;
+	int len = f->tap_count-1;
+	int pos = f->delay_pos;
 
-	for(; tap < (f->tap_count-1); tap++)
-	{
-		output -= (f->taps[tap] * f->delay_line[f->delay_pos++])<<2;
+	// The delay line is circular. Walk it as two contiguous runs (from the
+	// current position to the end, then from the start) so that the inner
+	// loops don't need a wraparound check on every tap.
+	for(; tap < len-pos; tap++)
+		output -= (f->taps[tap] * f->delay_line[pos+tap])<<2;
 
-		if(f->delay_pos >= f->tap_count-1)
-			f->delay_pos = 0;
-	}
+	for(; tap < len; tap++)
+		output -= (f->taps[tap] * f->delay_line[tap-(len-pos)])<<2;
 
 	output -= (f->taps[tap] * input)<<2;
 
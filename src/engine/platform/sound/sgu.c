@@ -199,6 +199,19 @@ static inline uint32_t compute_multiplier(uint32_t mul)
     return multiplier;
 }
 
+//-------------------------------------------------
+//  detuned_step - apply the multiplier and a
+//  detune adjustment to a raw phase step
+//-------------------------------------------------
+static inline uint32_t sgu_detuned_step(uint32_t phase_step, uint32_t multiplier, int32_t adj)
+{
+    // 11 = stronger, 12 = milder
+    int64_t det_step = ((int64_t)phase_step * (int64_t)adj) >> 12;
+
+    // apply frequency multiplier (which is an x.1 value)
+    return ((phase_step * multiplier) >> 1) + (int16_t)det_step;
+}
+
 //-------------------------------------------------
 //  compute_phase_step - compute the phase step
 //-------------------------------------------------
@@ -211,11 +224,7 @@ static inline uint32_t sgu_compute_phase_step(uint32_t freq16, uint32_t multipli
     uint32_t keycode = keycode_from_freq16_32((uint16_t)freq16); // use *unmodulated* pitch
     int32_t adj = detune_adjustment(detune3, keycode);           // about -22..+22
 
-    // 11 = stronger, 12 = milder
-    int64_t det_step = ((int64_t)phase_step * (int64_t)adj) >> 12;
-
-    // apply frequency multiplier (which is an x.1 value)
-    return ((phase_step * multiplier) >> 1) + (int16_t)det_step;
+    return sgu_detuned_step(phase_step, multiplier, adj);
 }
 
 // helper to apply KSR to the raw ADSR rate, ignoring ksr if the
@@ -372,6 +381,63 @@ static inline uint8_t compute_eg_rate(uint8_t op_data[], uint16_t ch_freq, enum
     return (uint8_t)rate;
 }
 
+//-------------------------------------------------
+//  decode_channel - rebuild the decoded operator
+//  parameters of a channel from its registers and
+//  frequency; the sample loop then only has to
+//  advance phase, envelope and filter state
+//-------------------------------------------------
+static void decode_channel(struct sgu_ch_state *self, struct SGU_CH *regs, uint16_t ch_freq)
+{
+    uint32_t block, fnum_4msb;
+    freq16_to_ksl_params(ch_freq, &block, &fnum_4msb);
+    const uint32_t ksl_atten = opl_key_scale_atten(block, fnum_4msb);
+    const uint32_t keycode = keycode_from_freq16_32(ch_freq);
+
+    for (uint8_t op = 0; op < SGU_OP_PER_CH; op++)
+    {
+        uint8_t *op_data = (uint8_t *)&regs->op[op];
+
+        for (uint8_t st = 0; st < SGU_EG_STATES; st++)
+            self->dec_eg_rate[op][st] = compute_eg_rate(op_data, ch_freq, (enum envelope_state)st);
+        self->dec_eg_sustain[op] = (uint16_t)compute_eg_sustain(op_data);
+
+        const uint8_t delay = SGU_OP5_DELAY(op_data[5]);
+        self->dec_delay_target[op] = delay ? (uint16_t)(256u << delay) : 0;
+
+        uint32_t tl_ksl = SGU_OP16_TL(op_data[1], op_data[6]) << 3;
+        const uint32_t ksl = SGU_OP1_KSL(op_data[1]);
+        if (ksl != 0)
+            tl_ksl += ksl_atten << ksl;
+        self->dec_tl_ksl[op] = (uint16_t)tl_ksl;
+
+        const uint8_t base = SGU_OP0_MUL(op_data[0]);
+        const uint8_t scale = SGU_OP4_DT(op_data[4]);
+        self->dec_multiplier[op] = compute_multiplier(base);
+        self->dec_detune[op] = detune_adjustment(scale, keycode);
+        if (SGU_OP0_FIX(op_data[0]))
+        {
+            // fixed frequency mode: 8..32640
+            uint16_t freq16 = (uint16_t)((8 + (base * 247 + 7) / 15) << scale);
+            self->dec_step_fixed[op] = true;
+            self->dec_phase_step[op] = sgu_phase_step_freq16(freq16, 0);
+        }
+        else if (!SGU_OP0_VIB(op_data[0]))
+        {
+            self->dec_step_fixed[op] = true;
+            self->dec_phase_step[op] = sgu_compute_phase_step(ch_freq, self->dec_multiplier[op], 0, scale);
+        }
+        else
+        {
+            self->dec_step_fixed[op] = false;
+            self->dec_phase_step[op] = 0;
+        }
+    }
+
+    self->dec_freq = ch_freq;
+    self->dec_dirty = false;
+}
+
 #if SGU_EG_DEBUG
 static void eg_debug_params(struct SGU *sgu, uint8_t ch, uint8_t op, uint8_t op_data[], uint16_t ch_freq)
 {
@@ -437,7 +503,7 @@ static inline int32_t clock_lfo(uint16_t *lfo_am_counter, uint16_t *lfo_pm_count
 //  when a keyon happens or when an SSG-EG cycle
 //  is complete and restarts
 //-------------------------------------------------
-static inline void start_attack(struct sgu_ch_state *self, uint8_t op, uint8_t op_data[], uint16_t ch_freq, bool is_restart /*= false*/)
+static inline void start_attack(struct sgu_ch_state *self, uint8_t op, bool is_restart /*= false*/)
 {
     // don't change anything if already in attack state
     if (self->envelope_state[op] == SGU_EG_ATTACK)
@@ -449,7 +515,7 @@ static inline void start_attack(struct sgu_ch_state *self, uint8_t op, uint8_t o
         self->phase[op] = 0;
 
     // if the attack rate >= 62 then immediately go to max attenuation
-    if (compute_eg_rate(op_data, ch_freq, SGU_EG_ATTACK) >= 62)
+    if (self->dec_eg_rate[op][SGU_EG_ATTACK] >= 62)
         self->envelope_attenuation[op] = 0;
 }
 
@@ -490,6 +556,7 @@ static void fm_channel_reset(struct sgu_ch_state *self, size_t ch_idx)
         self->eg_last_state[op] = EG_RELEASE;
 #endif
     }
+    self->dec_dirty = true;
 }
 
 //-------------------------------------------------
@@ -512,7 +579,7 @@ static inline void fm_channel_keyonoff(struct sgu_ch_state *self, bool on)
 //  clock_envelope - clock the envelope state
 //  according to the given count
 //-------------------------------------------------
-static inline void clock_envelope(struct sgu_ch_state *self, uint8_t op, uint8_t op_data[], uint16_t ch_freq, uint32_t env_counter)
+static inline void clock_envelope(struct sgu_ch_state *self, uint8_t op, uint32_t env_counter)
 {
     // handle attack->decay transitions
     if (self->envelope_state[op] == SGU_EG_ATTACK && self->envelope_attenuation[op] == 0)
@@ -523,11 +590,11 @@ static inline void clock_envelope(struct sgu_ch_state *self, uint8_t op, uint8_t
     // is set to 0 (in which case we will skip right to sustain without doing any
     // decay); as an example where this can be heard, check the cymbals sound
     // in channel 0 of shinobi's test mode sound #5
-    if (self->envelope_state[op] == SGU_EG_DECAY && self->envelope_attenuation[op] >= compute_eg_sustain(op_data))
+    if (self->envelope_state[op] == SGU_EG_DECAY && self->envelope_attenuation[op] >= self->dec_eg_sustain[op])
         self->envelope_state[op] = SGU_EG_SUSTAIN;
 
     // compute the 6-bit rate value for the current envelope state
-    uint32_t rate = compute_eg_rate(op_data, ch_freq, self->envelope_state[op]);
+    uint32_t rate = self->dec_eg_rate[op][self->envelope_state[op]];
 
     // compute the rate shift value; this is the shift needed to
     // apply to the env_counter such that it becomes a 5.11 fixed
@@ -569,24 +636,20 @@ static inline void clock_envelope(struct sgu_ch_state *self, uint8_t op, uint8_t
 //  OPN version of the logic has been verified
 //  against the Nuked phase generator
 //-------------------------------------------------
-static inline void clock_phase(struct sgu_ch_state *self, uint8_t op, uint8_t op_data[], uint16_t ch_freq, int32_t lfo_raw_pm)
+static inline void clock_phase(struct sgu_ch_state *self, uint8_t op, uint16_t ch_freq, int32_t lfo_raw_pm)
 {
     uint32_t phase_step;
-    const uint8_t base = SGU_OP0_MUL(op_data[0]);
-    const uint8_t scale = SGU_OP4_DT(op_data[4]);
-    if (SGU_OP0_FIX(op_data[0]))
+    if (self->dec_step_fixed[op])
     {
-        // fixed frequency mode: 8..32640
-        uint16_t freq16 = (uint16_t)((8 + (base * 247 + 7) / 15) << scale);
-        phase_step = sgu_phase_step_freq16(freq16, 0);
+        // fixed frequency mode or no vibrato: decoded on register write
+        phase_step = self->dec_phase_step[op];
     }
     else
     {
-        // normal mode: compute phase step from channel frequency
-        phase_step = sgu_compute_phase_step(ch_freq,
-                                            compute_multiplier(base),
-                                            SGU_OP0_VIB(op_data[0]) ? lfo_raw_pm : 0,
-                                            scale);
+        // vibrato: only the LFO-modulated base step changes per sample
+        phase_step = sgu_detuned_step(sgu_phase_step_freq16(ch_freq, lfo_raw_pm),
+                                      self->dec_multiplier[op],
+                                      self->dec_detune[op]);
     }
 
     // finally apply the step to the current phase value
@@ -664,7 +727,7 @@ static inline uint32_t attenuation_to_volume(uint32_t input)
 //  10) apply one-shot phase reset / timer sync
 // Finally: sum all outL/outR into output with global HPF.
 // -----------------------------------------------------------------------------
-void SGU_NextSample(struct SGU *sgu, int32_t *l, int32_t *r)
+static inline void sgu_next_sample(struct SGU *sgu, int32_t *l, int32_t *r)
 {
     // uses int64 to avoid overflow during summation.
     int64_t L = 0;
@@ -729,6 +792,9 @@ void SGU_NextSample(struct SGU *sgu, int32_t *l, int32_t *r)
         }
         else
         {
+            if (ch_state->dec_dirty || ch_state->dec_freq != ch_freq)
+                decode_channel(ch_state, &sgu->chan[ch], ch_freq);
+
             // run channel operators
             for (uint8_t op = 0; op < SGU_OP_PER_CH; op++)
             {
@@ -750,8 +816,7 @@ void SGU_NextSample(struct SGU *sgu, int32_t *l, int32_t *r)
                     ch_state->eg_delay_counter[op] = 0;
                 }
 
-                const uint8_t delay = SGU_OP5_DELAY(op_data[5]);
-                const uint16_t delay_target = delay ? (uint16_t)(256u << delay) : 0;
+                const uint16_t delay_target = ch_state->dec_delay_target[op];
                 bool keystate = key_live
                                 && (!ch_state->eg_delay_run[op]
                                     || ch_state->eg_delay_counter[op] >= delay_target);
@@ -767,7 +832,7 @@ void SGU_NextSample(struct SGU *sgu, int32_t *l, int32_t *r)
 
                     // if the key has turned on, start the attack
                     if (keystate != 0)
-                        start_attack(ch_state, op, (uint8_t *)op_data, ch_freq, false);
+                        start_attack(ch_state, op, false);
                     // otherwise, start the release
                     else
                         start_release(ch_state, op);
@@ -785,7 +850,7 @@ void SGU_NextSample(struct SGU *sgu, int32_t *l, int32_t *r)
 #endif
 
                 // clock the envelope
-                clock_envelope(ch_state, op, op_data, ch_freq, sgu->sample_counter);
+                clock_envelope(ch_state, op, sgu->sample_counter);
 
 #if SGU_EG_DEBUG
                 if (ch_state->envelope_state[op] != prev_state)
@@ -807,7 +872,7 @@ void SGU_NextSample(struct SGU *sgu, int32_t *l, int32_t *r)
                 if (!SGU_OP6_VIBD(op_data[6]))
                     op_lfo_pm >>= 1;
 
-                clock_phase(ch_state, op, op_data, ch_freq,
+                clock_phase(ch_state, op, ch_freq,
                             SGU_OP0_VIB(op_data[0]) ? op_lfo_pm : 0);
 
                 // record wrap for next sample's SYNC
@@ -1024,17 +1089,8 @@ void SGU_NextSample(struct SGU *sgu, int32_t *l, int32_t *r)
                         env_att += am_offset;
                     }
 
-                    // add in total level, scaled by 8
-                    env_att += SGU_OP16_TL(op_data[1], op_data[6]) << 3;
-
-                    // add key scale level
-                    uint32_t ksl = SGU_OP1_KSL(op_data[1]);
-                    if (ksl != 0)
-                    {
-                        uint32_t block, fnum_4msb;
-                        freq16_to_ksl_params(ch_freq, &block, &fnum_4msb);
-                        env_att += opl_key_scale_atten(block, fnum_4msb) << ksl;
-                    }
+                    // add in total level (scaled by 8) and key scale level
+                    env_att += ch_state->dec_tl_ksl[op];
 
                     // clamp to max
                     env_att = minval(env_att, 0x3ff);
@@ -1354,6 +1410,35 @@ void SGU_NextSample(struct SGU *sgu, int32_t *l, int32_t *r)
     *r = sgu->R = (int32_t)minval(INT32_MAX, maxval(INT32_MIN, final_R));
 }
 
+void SGU_NextSample(struct SGU *sgu, int32_t *l, int32_t *r)
+{
+    sgu_next_sample(sgu, l, r);
+}
+
+// Renders n samples in one call. Equivalent to n calls to SGU_NextSample,
+// followed by SGU_GetSample for every channel when osc is not NULL, but
+// keeps the whole loop inside this translation unit so the per-sample
+// body can be inlined.
+void SGU_NextBlock(struct SGU *sgu, int32_t *l, int32_t *r, int16_t **osc, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        sgu_next_sample(sgu, &l[i], &r[i]);
+        if (osc)
+        {
+            for (uint8_t ch = 0; ch < SGU_CHNS; ch++)
+            {
+                int32_t s = sgu->post[ch];
+                if (s < -32768)
+                    s = -32768;
+                if (s > 32767)
+                    s = 32767;
+                osc[ch][i] = (int16_t)s;
+            }
+        }
+    }
+}
+
 void SGU_Init(struct SGU *sgu, size_t sampleMemSize)
 {
     (void)sampleMemSize;
@@ -1470,6 +1555,8 @@ void SGU_Write(struct SGU *sgu, uint16_t addr13, uint8_t data)
 {
     ((uint8_t *)sgu->chan)[addr13] = data;
     const uint8_t channel = (addr13 / SGU_REGS_PER_CH) % SGU_CHNS;
+    // decoded operator parameters of this channel are now stale
+    sgu->m_channel[channel].dec_dirty = true;
     // handle writes to the keyon register(s)
     fm_channel_keyonoff(&sgu->m_channel[channel], sgu->chan[channel].flags0 & SGU1_FLAGS0_CTL_KEYON);
     // printf("SGU_Write: addr=0x%02X data=0x%02X -> (chan=%u)\n", addr13, data, channel);
@@ -540,6 +540,19 @@ struct SGU
         bool keyon_gate[SGU_OP_PER_CH];                    // last raw key state (edge detect for delay)
         bool eg_delay_run[SGU_OP_PER_CH];                  // envelope delay active
         uint16_t eg_delay_counter[SGU_OP_PER_CH];          // delay counter (samples)
+
+        // decoded operator parameters; rebuilt when a register of this channel
+        // is written or when the channel frequency changes (e.g. freq sweep)
+        bool dec_dirty;                                    // set by SGU_Write
+        uint16_t dec_freq;                                 // channel freq the cache was built for
+        uint8_t dec_eg_rate[SGU_OP_PER_CH][SGU_EG_STATES]; // envelope rate per state (with KSR)
+        uint16_t dec_eg_sustain[SGU_OP_PER_CH];            // sustain level in attenuation units
+        uint16_t dec_delay_target[SGU_OP_PER_CH];          // key-on delay in samples
+        uint16_t dec_tl_ksl[SGU_OP_PER_CH];                // total level + key scale attenuation
+        bool dec_step_fixed[SGU_OP_PER_CH];                // phase step does not depend on LFO PM
+        uint32_t dec_phase_step[SGU_OP_PER_CH];            // phase step when dec_step_fixed
+        uint32_t dec_multiplier[SGU_OP_PER_CH];            // x.1 multiplier (VIB operators)
+        int32_t dec_detune[SGU_OP_PER_CH];                 // detune adjustment (VIB operators)
 #if SGU_EG_DEBUG
         uint32_t eg_last_transition[SGU_OP_PER_CH];       // sample index of last state transition
         enum envelope_state eg_last_state[SGU_OP_PER_CH]; // last logged state
@@ -597,6 +610,11 @@ void SGU_Write(struct SGU *sgu, uint16_t addr13, uint8_t data);
 
 void SGU_NextSample(struct SGU *sgu, int32_t *l, int32_t *r);
 
+// Block renderer: fills l[0..n-1]/r[0..n-1] exactly like n calls to SGU_NextSample.
+// If osc is not NULL, osc[ch][i] receives SGU_GetSample(sgu, ch) after sample i.
+// Register writes are not interleaved; issue them before the block.
+void SGU_NextBlock(struct SGU *sgu, int32_t *l, int32_t *r, int16_t **osc, size_t n);
+
 // Convenience getter: returns mono downmix of current per-channel post-pan samples (averaged).
 // This is not used in NextSample, but useful for taps/meters/debug.
 int32_t SGU_GetSample(struct SGU *sgu, uint8_t ch);
@@ -2798,19 +2798,23 @@ int32_t sid3_get_waveform(SID3* sid3, sid3_channel* ch)
     return wave;
 }
 
-int32_t sid3_process_filters_block(sid3_channel* ch)
+//filters of the normal and the wavetable channels.
+//the state variable update does not depend on the filter mode, so it is done
+//for all filters in one branchless pass before the per-filter output stage.
+int32_t sid3_process_filters(sid3_filters_block* block, uint8_t* clock_filter, int32_t input)
 {
     int32_t output = 0;
+    sid3_filter* filt = block->filt;
 
-    ch->clock_filter++;
+    (*clock_filter)++;
 
-    if(ch->clock_filter & 1)
+    if(*clock_filter & 1)
     {
         for(uint8_t i = 0; i < SID3_NUM_FILTERS; i++)
         {
-            if(ch->filt.filt[i].mode & SID3_FILTER_OUTPUT)
+            if(filt[i].mode & SID3_FILTER_OUTPUT)
             {
-                output += ch->filt.filt[i].output;
+                output += filt[i].output;
             }
         }
 
@@ -2819,203 +2823,96 @@ int32_t sid3_process_filters_block(sid3_channel* ch)
 
     for(uint8_t i = 0; i < SID3_NUM_FILTERS; i++)
     {
-        ch->filt.filt[i].input = 0;
-    }
-
-    for(uint8_t i = 0; i < SID3_NUM_FILTERS; i++)
-    {
-        if(ch->filt.filt[i].mode & SID3_FILTER_CHANNEL_INPUT)
-        {
-            ch->filt.filt[i].input += ch->output_before_filter;
-        }
+        int32_t in = (filt[i].mode & SID3_FILTER_CHANNEL_INPUT) ? input : 0;
 
         for(uint8_t j = 0; j < SID3_NUM_FILTERS; j++)
         {
-            if(ch->filt.connection_matrix[i] & (1 << j))
+            if(block->connection_matrix[i] & (1 << j))
             {
-                ch->filt.filt[i].input += ch->filt.filt[j].output;
+                in += filt[j].output;
             }
         }
-    }
-
-    for(uint8_t i = 0; i < SID3_NUM_FILTERS; i++)
-    {
-        if(ch->filt.filt[i].mode & SID3_FILTER_ENABLE)
-        {
-            float Vi = ch->filt.filt[i].input;
-
-            float dVbp = (ch->filt.filt[i].w0_ceil_1 * ch->filt.filt[i].Vhp);
-            float dVlp = (ch->filt.filt[i].w0_ceil_1 * ch->filt.filt[i].Vbp);
-            ch->filt.filt[i].Vbp += dVbp;
-            ch->filt.filt[i].Vlp += dVlp;
-            ch->filt.filt[i].Vhp = Vi - ch->filt.filt[i].Vlp - (ch->filt.filt[i].Vbp * ch->filt.filt[i]._1024_div_Q);
-
-            float Vo;
-
-            switch(ch->filt.filt[i].mode & SID3_FILTER_MODES_MASK)
-            {
-                case 0x0:
-                default:
-                    Vo = 0;
-                    break;
-                case SID3_FILTER_LP:
-                    Vo = ch->filt.filt[i].Vlp;
-                    break;
-                case SID3_FILTER_HP:
-                    Vo = ch->filt.filt[i].Vhp;
-                    break;
-                case SID3_FILTER_LP | SID3_FILTER_HP:
-                    Vo = ch->filt.filt[i].Vlp + ch->filt.filt[i].Vhp;
-                    break;
-                case SID3_FILTER_BP:
-                    Vo = ch->filt.filt[i].Vbp;
-                    break;
-                case SID3_FILTER_BP | SID3_FILTER_LP:
-                    Vo = ch->filt.filt[i].Vlp + ch->filt.filt[i].Vbp;
-                    break;
-                case SID3_FILTER_BP | SID3_FILTER_HP:
-                    Vo = ch->filt.filt[i].Vhp + ch->filt.filt[i].Vbp;
-                    break;
-                case SID3_FILTER_BP | SID3_FILTER_HP | SID3_FILTER_LP:
-                    Vo = ch->filt.filt[i].Vlp + ch->filt.filt[i].Vbp + ch->filt.filt[i].Vhp;
-                    break;
-            }
 
-            if(ch->filt.filt[i].distortion_level > 0)
-            {
-                if(Vo > 0.0)
-                {
-                    Vo = (tanh((Vo / 39767.0) * ch->filt.filt[i].distortion_multiplier) / ch->filt.filt[i].tanh_distortion_multiplier) * 39767.0;
-                }
-                else
-                {
-                    double ahh = (Vo / 39767.0) * ch->filt.filt[i].distortion_multiplier;
-                    Vo = ((exp(ahh) - 1.0) / ch->filt.filt[i].tanh_distortion_multiplier) * 39767.0;
-                }
-            }
-
-            ch->filt.filt[i].output = Vo * ch->filt.filt[i].output_volume / 0xff;
-        }
-        else
-        {
-            ch->filt.filt[i].output = 0;
-        }
-
-        if(ch->filt.filt[i].mode & SID3_FILTER_OUTPUT)
-        {
-            output += ch->filt.filt[i].output;
-        }
+        filt[i].input = in;
     }
 
-    return output;
-}
-
-int32_t sid3_process_wave_channel_filters_block(sid3_wavetable_chan* ch)
-{
-    int32_t output = 0;
-
-    ch->clock_filter++;
-
-    if(ch->clock_filter & 1)
-    {
-        for(uint8_t i = 0; i < SID3_NUM_FILTERS; i++)
-        {
-            if(ch->filt.filt[i].mode & SID3_FILTER_OUTPUT)
-            {
-                output += ch->filt.filt[i].output;
-            }
-        }
-
-        return output;
-    }
+    float Vhp[SID3_NUM_FILTERS];
+    float Vbp[SID3_NUM_FILTERS];
+    float Vlp[SID3_NUM_FILTERS];
 
     for(uint8_t i = 0; i < SID3_NUM_FILTERS; i++)
     {
-        ch->filt.filt[i].input = 0;
+        float dVbp = (filt[i].w0_ceil_1 * filt[i].Vhp);
+        float dVlp = (filt[i].w0_ceil_1 * filt[i].Vbp);
+        Vbp[i] = filt[i].Vbp + dVbp;
+        Vlp[i] = filt[i].Vlp + dVlp;
+        Vhp[i] = (float)filt[i].input - Vlp[i] - (Vbp[i] * filt[i]._1024_div_Q);
     }
 
     for(uint8_t i = 0; i < SID3_NUM_FILTERS; i++)
     {
-        if(ch->filt.filt[i].mode & SID3_FILTER_CHANNEL_INPUT)
-        {
-            ch->filt.filt[i].input += ch->output_before_filter;
-        }
+        sid3_filter* f = &filt[i];
 
-        for(uint8_t j = 0; j < SID3_NUM_FILTERS; j++)
+        if(f->mode & SID3_FILTER_ENABLE)
         {
-            if(ch->filt.connection_matrix[i] & (1 << j))
-            {
-                ch->filt.filt[i].input += ch->filt.filt[j].output;
-            }
-        }
-    }
-
-    for(uint8_t i = 0; i < SID3_NUM_FILTERS; i++)
-    {
-        if(ch->filt.filt[i].mode & SID3_FILTER_ENABLE)
-        {
-            float Vi = ch->filt.filt[i].input;
-
-            float dVbp = (ch->filt.filt[i].w0_ceil_1 * ch->filt.filt[i].Vhp);
-            float dVlp = (ch->filt.filt[i].w0_ceil_1 * ch->filt.filt[i].Vbp);
-            ch->filt.filt[i].Vbp += dVbp;
-            ch->filt.filt[i].Vlp += dVlp;
-            ch->filt.filt[i].Vhp = Vi - ch->filt.filt[i].Vlp - (ch->filt.filt[i].Vbp * ch->filt.filt[i]._1024_div_Q);
+            f->Vbp = Vbp[i];
+            f->Vlp = Vlp[i];
+            f->Vhp = Vhp[i];
 
             float Vo;
 
-            switch(ch->filt.filt[i].mode & SID3_FILTER_MODES_MASK)
+            switch(f->mode & SID3_FILTER_MODES_MASK)
             {
                 case 0x0:
                 default:
                     Vo = 0;
                     break;
                 case SID3_FILTER_LP:
-                    Vo = ch->filt.filt[i].Vlp;
+                    Vo = f->Vlp;
                     break;
                 case SID3_FILTER_HP:
-                    Vo = ch->filt.filt[i].Vhp;
+                    Vo = f->Vhp;
                     break;
                 case SID3_FILTER_LP | SID3_FILTER_HP:
-                    Vo = ch->filt.filt[i].Vlp + ch->filt.filt[i].Vhp;
+                    Vo = f->Vlp + f->Vhp;
                     break;
                 case SID3_FILTER_BP:
-                    Vo = ch->filt.filt[i].Vbp;
+                    Vo = f->Vbp;
                     break;
                 case SID3_FILTER_BP | SID3_FILTER_LP:
-                    Vo = ch->filt.filt[i].Vlp + ch->filt.filt[i].Vbp;
+                    Vo = f->Vlp + f->Vbp;
                     break;
                 case SID3_FILTER_BP | SID3_FILTER_HP:
-                    Vo = ch->filt.filt[i].Vhp + ch->filt.filt[i].Vbp;
+                    Vo = f->Vhp + f->Vbp;
                     break;
                 case SID3_FILTER_BP | SID3_FILTER_HP | SID3_FILTER_LP:
-                    Vo = ch->filt.filt[i].Vlp + ch->filt.filt[i].Vbp + ch->filt.filt[i].Vhp;
+                    Vo = f->Vlp + f->Vbp + f->Vhp;
                     break;
             }
 
-            if(ch->filt.filt[i].distortion_level > 0)
+            if(f->distortion_level > 0)
             {
                 if(Vo > 0.0)
                 {
-                    Vo = (tanh((Vo / 39767.0) * ch->filt.filt[i].distortion_multiplier) / ch->filt.filt[i].tanh_distortion_multiplier) * 39767.0;
+                    Vo = (tanh((Vo / 39767.0) * f->distortion_multiplier) / f->tanh_distortion_multiplier) * 39767.0;
                 }
                 else
                 {
-                    double ahh = (Vo / 39767.0) * ch->filt.filt[i].distortion_multiplier;
-                    Vo = ((exp(ahh) - 1.0) / ch->filt.filt[i].tanh_distortion_multiplier) * 39767.0;
+                    double ahh = (Vo / 39767.0) * f->distortion_multiplier;
+                    Vo = ((exp(ahh) - 1.0) / f->tanh_distortion_multiplier) * 39767.0;
                 }
             }
 
-            ch->filt.filt[i].output = Vo * ch->filt.filt[i].output_volume / 0xff;
+            f->output = Vo * f->output_volume / 0xff;
         }
         else
         {
-            ch->filt.filt[i].output = 0;
+            f->output = 0;
         }
 
-        if(ch->filt.filt[i].mode & SID3_FILTER_OUTPUT)
+        if(f->mode & SID3_FILTER_OUTPUT)
         {
-            output += ch->filt.filt[i].output;
+            output += f->output;
         }
     }
 
@@ -3124,7 +3021,7 @@ void sid3_clock(SID3* sid3)
             if((ch->filt.filt[0].mode & SID3_FILTER_ENABLE) || (ch->filt.filt[1].mode & SID3_FILTER_ENABLE) ||
                 (ch->filt.filt[2].mode & SID3_FILTER_ENABLE) || (ch->filt.filt[3].mode & SID3_FILTER_ENABLE))
             {
-                output = sid3_process_filters_block(ch);
+                output = sid3_process_filters(&ch->filt, &ch->clock_filter, ch->output_before_filter);
             }
             else
             {
@@ -3248,7 +3145,7 @@ void sid3_clock(SID3* sid3)
         if((ch->filt.filt[0].mode & SID3_FILTER_ENABLE) || (ch->filt.filt[1].mode & SID3_FILTER_ENABLE) ||
             (ch->filt.filt[2].mode & SID3_FILTER_ENABLE) || (ch->filt.filt[3].mode & SID3_FILTER_ENABLE))
         {
-            output = sid3_process_wave_channel_filters_block(ch);
+            output = sid3_process_filters(&ch->filt, &ch->clock_filter, ch->output_before_filter);
         }
         else
         {
@@ -460,6 +460,13 @@ VOICE_CLOCK( V3c )
 	}
 	
 	// Gaussian interpolation
+	// Furnace addition -- skip it for silent voices (the envelope zeroes the output)
+	if ( !v->env )
+	{
+		m.t_output = 0;
+		v->t_envx_out = 0;
+	}
+	else
 	{
 		int output = interpolate( v );
 		
@@ -499,6 +506,13 @@ VOICE_CLOCK( V3c )
 }
 inline void SPC_DSP::voice_output( voice_t* const v, int ch )
 {
+	// Furnace addition -- a silent voice doesn't change the totals (they are already clamped)
+	if ( !m.t_output )
+	{
+		v->out [ch] = 0;
+		return;
+	}
+	
 	// Apply left/right volume
 	int amp = (m.t_output * (int8_t) VREG(v->regs,voll + ch)) >> 7;
 	v->out [ch] = (sample_t) amp; // Furnace addition
@@ -339,6 +339,21 @@ void SoundUnit::NextSample(short* l, short* r) {
   }
 }
 
+void SoundUnit::NextBlock(short* l, short* r, int len, short** chanOut) {
+  if (chanOut==NULL) {
+    for (int h=0; h<len; h++) {
+      NextSample(&l[h],&r[h]);
+    }
+    return;
+  }
+  for (int h=0; h<len; h++) {
+    NextSample(&l[h],&r[h]);
+    for (int i=0; i<8; i++) {
+      chanOut[i][h]=GetSample(i);
+    }
+  }
+}
+
 void SoundUnit::Init(int sampleMemSize, bool dsOutMode) {
   pcmSize=sampleMemSize;
   dsOut=dsOutMode;
@@ -94,6 +94,9 @@ class SoundUnit {
     void SetIL0(unsigned char addr);
     void Write(unsigned char addr, unsigned char data);
     void NextSample(short* l, short* r);
+    // render len samples. if chanOut is not NULL, the output of each channel
+    // (see GetSample) is written to chanOut[0..7].
+    void NextBlock(short* l, short* r, int len, short** chanOut=NULL);
     inline int GetSample(int ch) {
       int ret=(nsL[ch]+nsR[ch])>>1;
       if (ret<-32768) ret=-32768;
@@ -63,7 +63,7 @@ psg_writereg(struct VERA_PSG* psg, uint8_t reg, uint8_t val)
 }
 
 static inline void
-render(struct VERA_PSG* psg, int16_t *left, int16_t *right)
+render(struct VERA_PSG* psg, const unsigned chipType, int16_t *left, int16_t *right, int16_t *chanOut)
 {
 	int l = 0;
 	int r = 0;
@@ -78,19 +78,19 @@ render(struct VERA_PSG* psg, int16_t *left, int16_t *right)
 		struct VERAChannel *ch = &psg->channels[i];
 
 		unsigned new_phase = (ch->phase + ch->freq) & 0x1FFFF;
-		if ((psg->chipType >= 1) && (!ch->left && !ch->right)) {
+		if ((chipType >= 1) && (!ch->left && !ch->right)) {
 			new_phase = 0;
 		}
-		if ((psg->chipType < 3) ? (ch->phase & 0x10000) != (new_phase & 0x10000) : (ch->phase & 0x10000) && !(new_phase & 0x10000)) {
-			ch->noiseval = (psg->chipType < 1) ? psg->noiseOut : (psg->noiseState >> 1) & 0x3f;
+		if ((chipType < 3) ? (ch->phase & 0x10000) != (new_phase & 0x10000) : (ch->phase & 0x10000) && !(new_phase & 0x10000)) {
+			ch->noiseval = (chipType < 1) ? psg->noiseOut : (psg->noiseState >> 1) & 0x3f;
 		}
 		ch->phase = new_phase;
 
 		uint8_t v = 0;
 		switch (ch->waveform) {
 			case WF_PULSE: v = (ch->phase >> 10) > ch->pw ? 0 : 63; break;
-			case WF_SAWTOOTH: v = (ch->phase >> 11) ^ (psg->chipType < 2 ? 0 : (ch->pw ^ 0x3f) & 0x3f); break;
-			case WF_TRIANGLE: v = ((ch->phase & 0x10000) ? (~(ch->phase >> 10) & 0x3F) : ((ch->phase >> 10) & 0x3F)) ^ (psg->chipType < 2 ? 0 : (ch->pw ^ 0x3f) & 0x3f); break;
+			case WF_SAWTOOTH: v = (ch->phase >> 11) ^ (chipType < 2 ? 0 : (ch->pw ^ 0x3f) & 0x3f); break;
+			case WF_TRIANGLE: v = ((ch->phase & 0x10000) ? (~(ch->phase >> 10) & 0x3F) : ((ch->phase >> 10) & 0x3F)) ^ (chipType < 2 ? 0 : (ch->pw ^ 0x3f) & 0x3f); break;
 			case WF_NOISE: v = ch->noiseval; break;
 		}
 		int8_t sv = (v ^ 0x20);
@@ -101,29 +101,48 @@ render(struct VERA_PSG* psg, int16_t *left, int16_t *right)
 		int val = (int)sv * (int)ch->volume;
 
 		if (ch->left) {
-			l += (psg->chipType < 1) ? val : val >> 3;
+			l += (chipType < 1) ? val : val >> 3;
 		}
 		if (ch->right) {
-			r += (psg->chipType < 1) ? val : val >> 3;
+			r += (chipType < 1) ? val : val >> 3;
 		}
 
 		if (ch->left || ch->right) {
-			ch->lastOut = (psg->chipType < 1) ? val << 3 : val;
+			ch->lastOut = (chipType < 1) ? val << 3 : val;
 		} else {
 			ch->lastOut = 0;
 		}
+		if (chanOut) {
+			chanOut[i] = ch->lastOut;
+		}
 	}
 
 	*left  = l;
 	*right = r;
 }
 
+// the chip revision is passed as a constant, so that the checks for the
+// other revisions are dropped from the inner loop.
+#define RENDER_BLOCK(rev) \
+	while (num_samples--) { \
+		render(psg, rev, bufL++, bufR++, chanOut); \
+		if (chanOut) chanOut += 16; \
+	}
+
 void
-psg_render(struct VERA_PSG* psg, int16_t *bufL, int16_t *bufR, unsigned num_samples)
+psg_render_osc(struct VERA_PSG* psg, int16_t *bufL, int16_t *bufR, int16_t *chanOut, unsigned num_samples)
 {
-	while (num_samples--) {
-		render(psg, bufL, bufR);
-		bufL++;
-		bufR++;
+	switch (psg->chipType) {
+		case 0: RENDER_BLOCK(0); break;
+		case 1: RENDER_BLOCK(1); break;
+		case 2: RENDER_BLOCK(2); break;
+		case 3: RENDER_BLOCK(3); break;
+		default: RENDER_BLOCK(psg->chipType); break;
 	}
 }
+
+void
+psg_render(struct VERA_PSG* psg, int16_t *bufL, int16_t *bufR, unsigned num_samples)
+{
+	psg_render_osc(psg, bufL, bufR, NULL, num_samples);
+}
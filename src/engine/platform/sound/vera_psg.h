@@ -27,3 +27,6 @@ struct VERA_PSG {
 void psg_reset(struct VERA_PSG* psg);
 void psg_writereg(struct VERA_PSG* psg, uint8_t reg, uint8_t val);
 void psg_render(struct VERA_PSG* psg, int16_t *bufL, int16_t *bufR, unsigned num_samples);
+// same as psg_render, but also stores the output of every channel in chanOut
+// (16 values per sample) if it is not NULL
+void psg_render_osc(struct VERA_PSG* psg, int16_t *bufL, int16_t *bufR, int16_t *chanOut, unsigned num_samples);
@@ -452,6 +452,42 @@ int16_t YMF278Base::getSample(Slot& slot, uint16_t pos) const
 	}
 }
 
+// Same as getSample(), but reads straight from a contiguous memory image.
+// Fetches that would run past the end go through getSample() instead.
+int16_t YMF278Base::getSampleDirect(Slot& slot, uint16_t pos, const byte* mem, unsigned memSize) const
+{
+	switch (slot.bits) {
+	case 0: {
+		// 8 bit
+		unsigned addr = slot.startaddr + pos;
+		if (addr >= memSize) break;
+		return mem[addr] << 8;
+	}
+	case 1: {
+		// 12 bit
+		unsigned addr = slot.startaddr + ((pos / 2) * 3);
+		if (addr + 2 >= memSize) break;
+		if (pos & 1) {
+			return (mem[addr + 2] << 8) |
+			       (mem[addr + 1] & 0xF0);
+		} else {
+			return (mem[addr + 0] << 8) |
+			       ((mem[addr + 1] << 4) & 0xF0);
+		}
+	}
+	case 2: {
+		// 16 bit
+		unsigned addr = slot.startaddr + (pos * 2);
+		if (addr + 1 >= memSize) break;
+		return (mem[addr + 0] << 8) |
+		        (mem[addr + 1]);
+	}
+	default:
+		return 0;
+	}
+	return getSample(slot, pos);
+}
+
 uint16_t YMF278Base::nextPos(Slot& slot, uint16_t pos, uint16_t increment)
 {
 	// If there is a 4-sample loop and you advance 12 samples per step,
@@ -486,6 +522,9 @@ void YMF278Base::generate(short& fleft, short& fright, short& rleft, short& rrig
 	int sampleFRight = 0;
 	int sampleRLeft = 0;
 	int sampleRRight = 0;
+	// fetch the memory view once instead of calling operator[] per byte
+	const byte* mem = memory.getDirect();
+	unsigned memSize = (mem != nullptr) ? memory.getSize() : 0;
 	for (size_t i = 0, count = slots.size(); i < count; i++) {
 		Slot& sl = slots[i];
 		if (sl.state == EG_OFF) {
@@ -497,8 +536,15 @@ void YMF278Base::generate(short& fleft, short& fright, short& rleft, short& rrig
 			continue;
 		}
 
-		int16_t sample = (getSample(sl, sl.pos) * (0x10000 - sl.stepptr) +
-											getSample(sl, nextPos(sl, sl.pos, 1)) * sl.stepptr) >> 16;
+		int16_t cur, next;
+		if (mem != nullptr) {
+			cur = getSampleDirect(sl, sl.pos, mem, memSize);
+			next = getSampleDirect(sl, nextPos(sl, sl.pos, 1), mem, memSize);
+		} else {
+			cur = getSample(sl, sl.pos);
+			next = getSample(sl, nextPos(sl, sl.pos, 1));
+		}
+		int16_t sample = (cur * (0x10000 - sl.stepptr) + next * sl.stepptr) >> 16;
 		// TL levels are 00..FF internally (TL register value 7F is mapped to TL level FF)
 		// Envelope levels have 4x the resolution (000..3FF)
 		// Volume levels are approximate logarithmic. -6dB result in half volume. Steps in between use linear interpolation.
@@ -22,6 +22,9 @@ public:
 	virtual void write(unsigned address, byte value) = 0;
 	virtual void clear(byte value) = 0;
 	virtual void setMemoryType(bool memoryType) {};
+	// contiguous view of the whole memory (getSize() bytes), or nullptr if
+	// every read has to go through operator[]
+	virtual const byte* getDirect() const { return nullptr; }
 };
 
 class YMF278Base
@@ -98,6 +101,7 @@ protected:
 
 private:
 	int16_t getSample(Slot& slot, uint16_t pos) const;
+	int16_t getSampleDirect(Slot& slot, uint16_t pos, const byte* mem, unsigned memSize) const;
 	static uint16_t nextPos(Slot& slot, uint16_t pos, uint16_t increment);
 	void advance();
 	bool anyActive();
@@ -187,6 +187,9 @@ public:
 	// prepare prior to clocking
 	bool prepare();
 
+	// are we fully released, such that clocking has no audible effect?
+	bool is_idle() const;
+
 	// master clocking function
 	void clock(uint32_t env_counter, int32_t lfo_raw_pm);
 
@@ -279,9 +282,15 @@ public:
 	// prepare prior to clocking
 	bool prepare();
 
+	// are all of our operators idle?
+	bool is_idle() const;
+
 	// master clocking function
 	void clock(uint32_t env_counter, int32_t lfo_raw_pm);
 
+	// clocking function for idle channels; only the feedback is moved
+	void clock_idle();
+
 	// specific 2-operator and 4-operator output handlers
 	void output_2op(output_data &output, uint32_t rshift, int32_t clipmax) const;
 	void output_4op(output_data &output, uint32_t rshift, int32_t clipmax) const;
@@ -463,6 +472,7 @@ protected:
 	uint8_t m_total_clocks;          // low 8 bits of the total number of clocks processed
 	uint32_t m_active_channels;      // mask of active channels (computed by prepare)
 	uint32_t m_modified_channels;    // mask of channels that have been modified
+	uint32_t m_idle_channels;        // mask of channels which need not be clocked (computed by prepare)
 	uint32_t m_prepare_count;        // counter to do periodic prepare sweeps
 	RegisterType m_regs;             // register accessor
 	std::unique_ptr<fm_channel<RegisterType>> m_channel[CHANNELS]; // channel pointers
@@ -444,6 +444,24 @@ bool fm_operator<RegisterType>::prepare()
 }
 
 
+//-------------------------------------------------
+//  is_idle - return true if the operator is fully
+//  released; clocking it then only advances the
+//  phase, which is reset on the next key on
+//-------------------------------------------------
+
+template<class RegisterType>
+bool fm_operator<RegisterType>::is_idle() const
+{
+	return (m_env_state == (RegisterType::EG_HAS_REVERB ? EG_REVERB : EG_RELEASE) &&
+		m_env_attenuation == 0x3ff &&
+		m_key_state == 0 &&
+		m_keyon_live == 0 &&
+		!m_ssg_inverted &&
+		!m_regs.op_ssg_eg_enable(m_opoffs));
+}
+
+
 //-------------------------------------------------
 //  clock - master clocking function
 //-------------------------------------------------
@@ -883,6 +901,34 @@ bool fm_channel<RegisterType>::prepare()
 }
 
 
+//-------------------------------------------------
+//  is_idle - return true if all operators are
+//  idle
+//-------------------------------------------------
+
+template<class RegisterType>
+bool fm_channel<RegisterType>::is_idle() const
+{
+	for (uint32_t opnum = 0; opnum < array_size(m_op); opnum++)
+		if (m_op[opnum] != nullptr && !m_op[opnum]->is_idle())
+			return false;
+	return true;
+}
+
+
+//-------------------------------------------------
+//  clock_idle - clock an idle channel
+//-------------------------------------------------
+
+template<class RegisterType>
+void fm_channel<RegisterType>::clock_idle()
+{
+	// clock the feedback through
+	m_feedback[0] = m_feedback[1];
+	m_feedback[1] = m_feedback_in;
+}
+
+
 //-------------------------------------------------
 //  clock - master clock of all operators
 //-------------------------------------------------
@@ -1202,6 +1248,7 @@ fm_engine_base<RegisterType>::fm_engine_base(ymfm_interface &intf) :
 	m_total_clocks(0),
 	m_active_channels(ALL_CHANNELS),
 	m_modified_channels(ALL_CHANNELS),
+	m_idle_channels(0),
 	m_prepare_count(0)
 {
 	// inform the interface of their engine
@@ -1249,6 +1296,9 @@ void fm_engine_base<RegisterType>::reset()
 	// reset the operators
 	for (auto &op : m_operator)
 		op->reset();
+
+	// clock everything until the next prepare
+	m_idle_channels = 0;
 }
 
 
@@ -1306,10 +1356,19 @@ uint32_t fm_engine_base<RegisterType>::clock(uint32_t chanmask)
 
 		// call each channel to prepare
 		m_active_channels = 0;
+		m_idle_channels = 0;
 		for (uint32_t chnum = 0; chnum < CHANNELS; chnum++)
 			if (bitfield(chanmask, chnum))
+			{
 				if (m_channel[chnum]->prepare())
 					m_active_channels |= 1 << chnum;
+				else if (m_channel[chnum]->is_idle())
+					m_idle_channels |= 1 << chnum;
+			}
+
+		// the rhythm channels use operator phases from other channels
+		if (m_regs.rhythm_enable())
+			m_idle_channels &= ~0x1c0;
 
 		// reset the modified channels and prepare count
 		m_modified_channels = m_prepare_count = 0;
@@ -1326,9 +1385,15 @@ uint32_t fm_engine_base<RegisterType>::clock(uint32_t chanmask)
 	int32_t lfo_raw_pm = m_regs.clock_noise_and_lfo();
 
 	// now update the state of all the channels and operators
+	// idle channels skip their operators until the next prepare
 	for (uint32_t chnum = 0; chnum < CHANNELS; chnum++)
 		if (bitfield(chanmask, chnum))
-			m_channel[chnum]->clock(m_env_counter, lfo_raw_pm);
+		{
+			if (bitfield(m_idle_channels, chnum))
+				m_channel[chnum]->clock_idle();
+			else
+				m_channel[chnum]->clock(m_env_counter, lfo_raw_pm);
+		}
 
 	// return the envelope counter as it is used to clock ADPCM-A
 	return m_env_counter;
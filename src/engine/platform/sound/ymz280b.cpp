@@ -488,8 +488,9 @@ void ymz280b_device::device_start(u8 *ext_mem)
 {
 	m_ext_mem = ext_mem;
 
-	/* compute ADPCM tables */
-	compute_tables();
+	/* compute ADPCM tables (shared by all instances, so only once) */
+	static const bool tables_ready = (compute_tables(), true);
+	(void)tables_ready;
 
 	/* allocate memory */
 	assert(MAX_SAMPLE_CHUNK < 0x10000);
@@ -23,12 +23,14 @@
 #include <math.h>
 
 //#define rWrite(a,v) pendingWrites[a]=v;
-#define rWrite(a,v) if (!skipRegisterWrites) {writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);} }
+#define rWrite(a,v) if (!skipRegisterWrites) {writeCount++; writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);} }
 #define chWrite(c,a,v) rWrite(((c)<<5)|(a),v);
 
 #define CHIP_DIVIDER 2
 #define CHIP_FREQBASE 524288
 
+#define SU_BLOCK_SIZE 256
+
 const char** DivPlatformSoundUnit::getRegisterSheet() {
   return NULL;
 }
@@ -45,15 +47,26 @@ void DivPlatformSoundUnit::acquire(short** buf, size_t len) {
     oscBuf[i]->begin(len);
   }
 
-  for (size_t h=0; h<len; h++) {
-    while (!writes.empty()) {
-      QueuedWrite w=writes.front();
-      su->Write(w.addr,w.val);
-      writes.pop();
-    }
-    su->NextSample(&buf[0][h],&buf[1][h]);
+  // writes are only queued outside of acquire, so all of them happen before the first sample
+  while (!writes.empty()) {
+    QueuedWrite w=writes.front();
+    su->Write(w.addr,w.val);
+    writes.pop();
+  }
+
+  short oscData[8][SU_BLOCK_SIZE];
+  short* oscOut[8];
+  for (int i=0; i<8; i++) {
+    oscOut[i]=oscData[i];
+  }
+
+  for (size_t h=0; h<len; h+=SU_BLOCK_SIZE) {
+    int blockLen=MIN(len-h,SU_BLOCK_SIZE);
+    su->NextBlock(&buf[0][h],&buf[1][h],blockLen,oscOut);
     for (int i=0; i<8; i++) {
-      oscBuf[i]->putSample(h,su->GetSample(i));
+      for (int j=0; j<blockLen; j++) {
+        oscBuf[i]->putSample(h+j,oscData[i][j]);
+      }
     }
   }
   
@@ -668,6 +681,8 @@ void DivPlatformSoundUnit::setFlags(const DivConfig& flags) {
   sampleMemSize=flags.getInt("sampleMemSize",0);
 
   su->Init(sampleMemSize?65536:8192,flags.getBool("pdm",false));
+  // Init() clears PCM RAM. restore it so that renderSamples() only has to upload changes.
+  memcpy(su->pcm,sampleMem,sampleMemSize?65536:8192);
   renderSamples(sysIDCache);
 }
 
@@ -703,42 +718,22 @@ const DivMemoryComposition* DivPlatformSoundUnit::getMemCompo(int index) {
 }
 
 void DivPlatformSoundUnit::renderSamples(int sysID) {
-  memset(sampleMem,0,sampleMemSize?65536:8192);
-  memset(sampleOffSU,0,32768*sizeof(unsigned int));
-  memset(sampleLoaded,0,32768*sizeof(bool));
-
   memCompo=DivMemoryComposition();
   memCompo.name="Sample RAM";
 
-  size_t memPos=0;
-  for (int i=0; i<parent->song.sampleLen; i++) {
-    DivSample* s=parent->song.sample[i];
-    if (s->data8==NULL) continue;
-    if (!s->renderOn[0][sysID]) {
-      sampleOffSU[i]=0;
-      continue;
-    }
-    
-    int paddedLen=s->length8;
-    if (memPos>=getSampleMemCapacity(0)) {
-      logW("out of PCM memory for sample %d!",i);
-      break;
-    }
-    if (memPos+paddedLen>=getSampleMemCapacity(0)) {
-      memcpy(sampleMem+memPos,s->data8,getSampleMemCapacity(0)-memPos);
-      logW("out of PCM memory for sample %d!",i);
-    } else {
-      memcpy(sampleMem+memPos,s->data8,paddedLen);
-      sampleLoaded[i]=true;
-    }
-    sampleOffSU[i]=memPos;
-    memCompo.entries.push_back(DivMemoryEntry(DIV_MEMORY_SAMPLE,"Sample",i,memPos,memPos+paddedLen));
-    memPos+=paddedLen;
-  }
-  sampleMemLen=memPos;
+  sampleMemLen=sampleRAM.render(parent->song.sample,parent->song.sampleLen,sysID,sampleMem,getSampleMemCapacity(0),sampleOffSU,sampleLoaded,memCompo);
   sysIDCache=sysID;
 
-  memcpy(su->pcm,sampleMem,sampleMemSize?65536:8192);
+  if (sampleRAM.full) {
+    // this also clears the echo buffer
+    memset(sampleMem+getSampleMemCapacity(0),0,(sampleMemSize?65536:8192)-getSampleMemCapacity(0));
+    memcpy(su->pcm,sampleMem,sampleMemSize?65536:8192);
+  } else {
+    // only upload what changed
+    for (DivSampleRAM::Range& i: sampleRAM.dirty) {
+      memcpy(su->pcm+i.begin,sampleMem+i.begin,i.end-i.begin);
+    }
+  }
 
   memCompo.used=sampleMemLen;
   memCompo.capacity=sampleMemSize?65536:8192;
@@ -22,6 +22,7 @@
 
 #include "../dispatch.h"
 #include "../../fixedQueue.h"
+#include "../sampleRAM.h"
 #include "sound/su.h"
 
 class DivPlatformSoundUnit: public DivDispatch {
@@ -104,6 +105,7 @@ class DivPlatformSoundUnit: public DivDispatch {
   SoundUnit* su;
   unsigned char* sampleMem;
   size_t sampleMemLen;
+  DivSampleRAM sampleRAM;
   unsigned char regPool[128];
   DivMemoryComposition memCompo;
   double NOTE_SU(int ch, int note);
@@ -28,12 +28,12 @@ extern "C" {
 }
 
 //if (dumpWrites) {addWrite(((c)*4+(a)),(d));}
-//#define rWrite(c,a,d) {regPool[(c)*4+(a)]=(d); psg_writereg(psg,((c)*4+(a)),(d));}
+//#define rWrite(c,a,d) {writeCount++; regPool[(c)*4+(a)]=(d); psg_writereg(psg,((c)*4+(a)),(d));}
 #define rWrite(c,a,d) {regPool[(c)*4+(a)]=(d); psg_writereg(psg,((c)*4+(a)),(d));if (dumpWrites) {addWrite(((c)*4+(a)),(d));}}
 #define rWriteLo(c,a,d) rWrite(c,a,(regPool[(c)*4+(a)]&(~0x3f))|((d)&0x3f))
 #define rWriteHi(c,a,d) rWrite(c,a,(regPool[(c)*4+(a)]&(~0xc0))|(((d)<<6)&0xc0))
-#define rWritePCMCtrl(d) {regPool[64]=(d); pcm_write_ctrl(pcm,d);if (dumpWrites) addWrite(64,(d));}
-#define rWritePCMRate(d) {regPool[65]=(d); pcm_write_rate(pcm,d);if (dumpWrites) addWrite(65,(d));}
+#define rWritePCMCtrl(d) {writeCount++; regPool[64]=(d); pcm_write_ctrl(pcm,d);if (dumpWrites) addWrite(64,(d));}
+#define rWritePCMRate(d) {writeCount++; regPool[65]=(d); pcm_write_rate(pcm,d);if (dumpWrites) addWrite(65,(d));}
 #define rWritePCMData(d) {regPool[66]=(d); pcm_write_fifo(pcm,d);}
 #define rWritePCMVol(d) rWritePCMCtrl((regPool[64]&(~0x8f))|((d)&15))
 #define rWriteZSMSync(d) {if (dumpWrites) addWrite(68,(d));}
@@ -65,6 +65,7 @@ void DivPlatformVERA::acquire(short** buf, size_t len) {
   // both PSG part and PCM part output a full 16-bit range, putting bufL/R
   // argument right into both could cause an overflow
   short whyCallItBuf[4][128];
+  short psgChanOut[128][16];
   size_t pos=0;
   size_t lenCopy=len;
   DivSample* s=parent->getSample(chan[16].pcm.sample);
@@ -117,13 +118,13 @@ void DivPlatformVERA::acquire(short** buf, size_t len) {
     int curLen=MIN(lenCopy,128);
     memset(whyCallItBuf,0,sizeof(whyCallItBuf));
     pcm_render(pcm,whyCallItBuf[2],whyCallItBuf[3],curLen);
+    psg_render_osc(psg,whyCallItBuf[0],whyCallItBuf[1],psgChanOut[0],curLen);
     for (int i=0; i<curLen; i++) {
-      psg_render(psg,&whyCallItBuf[0][i],&whyCallItBuf[1][i],1);
       buf[0][pos]=(short)(((int)whyCallItBuf[0][i]+whyCallItBuf[2][i])/2);
       buf[1][pos]=(short)(((int)whyCallItBuf[1][i]+whyCallItBuf[3][i])/2);
 
       for (int j=0; j<16; j++) {
-        oscBuf[j]->putSample(pos,psg->channels[j].lastOut);
+        oscBuf[j]->putSample(pos,psgChanOut[i][j]);
       }
 
       int pcmOut=(whyCallItBuf[2][i]+whyCallItBuf[3][i])>>1;
@@ -19,11 +19,13 @@
 
 #include "x1_010.h"
 #include "../engine.h"
+#include "../sampleRAM.h"
 #include "../../ta-log.h"
 #include <math.h>
+#include <algorithm>
 
 //#define rWrite(a,v) pendingWrites[a]=v;
-#define rWrite(a,v) if (!skipRegisterWrites) { x1_010.ram_w(a,v); if (dumpWrites) { addWrite(a,v); } }
+#define rWrite(a,v) if (!skipRegisterWrites) {writeCount++;  x1_010.ram_w(a,v); if (dumpWrites) { addWrite(a,v); } }
 
 #define chRead(c,a) x1_010.ram_r((c<<3)|(a&7))
 #define chWrite(c,a,v) rWrite((c<<3)|(a&7),v)
@@ -206,28 +208,37 @@ const char** DivPlatformX1_010::getRegisterSheet() {
 }
 
 void DivPlatformX1_010::acquire(short** buf, size_t len) {
+  s32* voiceOutPtr[16];
   for (int i=0; i<16; i++) {
     oscBuf[i]->begin(len);
+    voiceOutPtr[i]=voiceOut[i];
   }
 
-  for (size_t h=0; h<len; h++) {
-    x1_010.tick();
+  for (size_t h=0; h<len; h+=256) {
+    const u32 count=MIN(len-h,256);
+    x1_010.tick_block(blockOut[0],blockOut[1],voiceOutPtr,count);
 
-    signed int tempL=x1_010.output(0);
-    signed int tempR=x1_010.output(1);
+    for (u32 j=0; j<count; j++) {
+      signed int tempL=blockOut[0][j];
+      signed int tempR=blockOut[1][j];
 
-    if (tempL<-32768) tempL=-32768;
-    if (tempL>32767) tempL=32767;
-    if (tempR<-32768) tempR=-32768;
-    if (tempR>32767) tempR=32767;
+      if (tempL<-32768) tempL=-32768;
+      if (tempL>32767) tempL=32767;
+      if (tempR<-32768) tempR=-32768;
+      if (tempR>32767) tempR=32767;
 
-    //printf("tempL: %d tempR: %d\n",tempL,tempR);
-    buf[0][h]=stereo?tempL:((tempL+tempR)>>1);
-    if (stereo) buf[1][h]=tempR;
+      buf[0][h+j]=stereo?tempL:((tempL+tempR)>>1);
+      if (stereo) buf[1][h+j]=tempR;
+    }
 
+    // only put samples which changed (silent voices only put one)
     for (int i=0; i<16; i++) {
-      int vo=(x1_010.voice_out(i,0)+x1_010.voice_out(i,1))<<2;
-      oscBuf[i]->putSample(h,CLAMP(vo,-32768,32767));
+      s32 last=INT_MIN;
+      for (u32 j=0; j<count; j++) {
+        if (voiceOut[i][j]==last) continue;
+        last=voiceOut[i][j];
+        oscBuf[i]->putSample(h+j,CLAMP(last<<2,-32768,32767));
+      }
     }
   }
 
@@ -248,6 +259,22 @@ u8 DivPlatformX1_010::read_byte(u32 address) {
   return 0;
 }
 
+const u8* DivPlatformX1_010::get_byte_span(u32 address, u32& len) {
+  if ((sampleMem==NULL) || (address>=getSampleMemCapacity())) {
+    len=0;
+    return NULL;
+  }
+  len=getSampleMemCapacity()-address;
+  if (isBanked) {
+    // up to the end of the bank slot
+    len=MIN(len,0x20000-(address&0x1ffff));
+    address=((bankSlot[(address>>17)&7]<<17)|(address&0x1ffff))&0xffffff;
+  } else {
+    address&=0xfffff;
+  }
+  return &sampleMem[address];
+}
+
 double DivPlatformX1_010::NoteX1_010(int ch, int note) {
   if (chan[ch].pcm) { // PCM note
     double off=8192.0;
@@ -934,6 +961,7 @@ void DivPlatformX1_010::setFlags(const DivConfig& flags) {
   rate=chipClock/512;
   stereo=flags.getBool("stereo",false);
   isBanked=flags.getBool("isBanked",false);
+  packSamples=flags.getBool("packSamples",false);
   for (int i=0; i<16; i++) {
     oscBuf[i]->setRate(rate);
   }
@@ -978,7 +1006,7 @@ void DivPlatformX1_010::renderSamples(int sysID) {
   memCompo=DivMemoryComposition();
   memCompo.name="Sample ROM";
 
-  size_t memPos=0;
+  std::vector<DivSamplePacker::Item> items;
   for (int i=0; i<parent->song.sampleLen; i++) {
     DivSample* s=parent->song.sample[i];
     if (!s->renderOn[0][sysID]) {
@@ -987,30 +1015,35 @@ void DivPlatformX1_010::renderSamples(int sysID) {
     }
     
     int paddedLen=(s->length8+4095)&(~0xfff);
-    if (isBanked) {
     // fit sample bank size to 128KB for Seta 2 external bankswitching logic (not emulated yet!)
-      if (paddedLen>131072) {
-        paddedLen=131072;
-      }
-      if ((memPos&0xfe0000)!=((memPos+paddedLen)&0xfe0000)) {
-        memPos=(memPos+0x1ffff)&0xfe0000;
-      }
+    if (isBanked && paddedLen>131072) {
+      paddedLen=131072;
     }
-    if (memPos>=getSampleMemCapacity()) {
-      logW("out of X1-010 memory for sample %d!",i);
-      break;
-    }
-    if (memPos+paddedLen>=getSampleMemCapacity()) {
-      memcpy(sampleMem+memPos,s->data8,getSampleMemCapacity()-memPos);
+    items.push_back(DivSamplePacker::Item(i,paddedLen));
+  }
+  size_t memPos=0;
+  if (packSamples && isBanked) {
+    memPos=DivSamplePacker::pack(items,getSampleMemCapacity()-1,131072,4096);
+  } else {
+    memPos=DivSamplePacker::packInOrder(items,getSampleMemCapacity(),isBanked?131072:0,4096);
+  }
+
+  for (DivSamplePacker::Item& item: items) {
+    int i=item.index;
+    DivSample* s=parent->song.sample[i];
+    if (!item.placed || item.truncated) {
       logW("out of X1-010 memory for sample %d!",i);
-    } else {
-      memcpy(sampleMem+memPos,s->data8,paddedLen);
-      sampleLoaded[i]=true;
     }
-    sampleOffX1[i]=memPos;
-    memCompo.entries.push_back(DivMemoryEntry(DIV_MEMORY_SAMPLE,"Sample",i,memPos,memPos+paddedLen));
-    memPos+=paddedLen;
+    if (!item.placed) continue;
+    memcpy(sampleMem+item.pos,s->data8,item.len);
+    // a truncated sample is copied but not marked as loaded
+    if (!item.truncated) sampleLoaded[i]=true;
+    sampleOffX1[i]=item.pos;
+    memCompo.entries.push_back(DivMemoryEntry(DIV_MEMORY_SAMPLE,"Sample",i,item.pos,item.pos+item.len));
   }
+  std::sort(memCompo.entries.begin(),memCompo.entries.end(),[](const DivMemoryEntry& a, const DivMemoryEntry& b) {
+    return a.begin<b.begin;
+  });
   sampleMemLen=memPos+256;
 
   memCompo.used=sampleMemLen;
@@ -112,8 +112,12 @@ class DivPlatformX1_010: public DivDispatch, public vgsound_emu_mem_intf {
   unsigned char* sampleMem;
   size_t sampleMemLen;
   x1_010_core x1_010;
+  // rendered in blocks of this size
+  s32 blockOut[2][256];
+  s32 voiceOut[16][256];
 
   bool isBanked=false;
+  bool packSamples=false;
   unsigned int bankSlot[8];
   unsigned int* sampleOffX1;
   bool* sampleLoaded;
@@ -128,6 +132,7 @@ class DivPlatformX1_010: public DivDispatch, public vgsound_emu_mem_intf {
   friend void putDispatchChan(void*,int,int);
   public:
     u8 read_byte(u32 address);
+    const u8* get_byte_span(u32 address, u32& len);
     void acquire(short** buf, size_t len);
     int dispatch(DivCommand c);
     void* getChanState(int chan);
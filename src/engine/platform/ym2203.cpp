@@ -166,8 +166,8 @@ void DivPlatformYM2203::acquire(short** buf, size_t len) {
 }
 
 void DivPlatformYM2203::acquire_combo(short** buf, size_t len) {
-  thread_local int os;
-  thread_local short ignored[2];
+  int os=0;
+  short ignored[2]={0};
 
   for (int i=0; i<7; i++) {
     oscBuf[i]->begin(len);
@@ -254,7 +254,7 @@ void DivPlatformYM2203::acquire_combo(short** buf, size_t len) {
 }
 
 void DivPlatformYM2203::acquire_ymfm(short** buf, size_t len) {
-  thread_local int os;
+  int os=0;
 
   ymfm::ym2203::fm_engine* fme=fm->debug_fm_engine();
 
@@ -325,7 +325,7 @@ static const unsigned char subCycleMap[6]={
 };
 
 void DivPlatformYM2203::acquire_lle(short** buf, size_t len) {
-  thread_local int fmOut[6];
+  int fmOut[6]={0};
 
   for (int i=0; i<7; i++) {
     oscBuf[i]->begin(len);
@@ -306,8 +306,8 @@ void DivPlatformYM2608::acquire(short** buf, size_t len) {
 }
 
 void DivPlatformYM2608::acquire_combo(short** buf, size_t len) {
-  thread_local int os[2];
-  thread_local short ignored[2];
+  int os[2]={0};
+  short ignored[2]={0};
 
   ymfm::ssg_engine* ssge=fm->debug_ssg_engine();
   ymfm::adpcm_a_engine* aae=fm->debug_adpcm_a_engine();
@@ -431,7 +431,7 @@ void DivPlatformYM2608::acquire_combo(short** buf, size_t len) {
 }
 
 void DivPlatformYM2608::acquire_ymfm(short** buf, size_t len) {
-  thread_local int os[2];
+  int os[2]={0};
 
   ymfm::ym2608::fm_engine* fme=fm->debug_fm_engine();
   ymfm::ssg_engine* ssge=fm->debug_ssg_engine();
@@ -520,7 +520,7 @@ static const unsigned char subCycleMap[6]={
 };
 
 void DivPlatformYM2608::acquire_lle(short** buf, size_t len) {
-  thread_local int fmOut[6];
+  int fmOut[6]={0};
 
   for (int i=0; i<17; i++) {
     oscBuf[i]->begin(len);
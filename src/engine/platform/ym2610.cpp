@@ -235,220 +235,9 @@ void DivPlatformYM2610::acquire(short** buf, size_t len) {
   if (useCombo==2) {
     acquire_lle(buf,len);
   } else if (useCombo==1) {
-    acquire_combo(buf,len);
+    acquireCombo(buf,len,bchOffs,4,psgChanOffs-isCSM);
   } else {
-    acquire_ymfm(buf,len);
-  }
-}
-
-void DivPlatformYM2610::acquire_combo(short** buf, size_t len) {
-  thread_local int os[2];
-  thread_local short ignored[2];
-
-  ymfm::ssg_engine* ssge=fm->debug_ssg_engine();
-  ymfm::adpcm_a_engine* aae=fm->debug_adpcm_a_engine();
-  ymfm::adpcm_b_engine* abe=fm->debug_adpcm_b_engine();
-
-  ymfm::ssg_engine::output_data ssgOut;
-
-  ymfm::adpcm_a_channel* adpcmAChan[6];
-  for (int i=0; i<6; i++) {
-    adpcmAChan[i]=aae->debug_channel(i);
-  }
-
-  for (int i=0; i<17; i++) {
-    oscBuf[i]->begin(len);
-  }
-
-  for (size_t h=0; h<len; h++) {
-    // AY -> OPN
-    ay->runDAC(tfxRate);
-    ay->runTFX(tfxRate);
-    ay->flushWrites();
-    for (DivRegWrite& i: ay->getRegisterWrites()) {
-      if (i.addr>15) continue;
-      immWrite(i.addr&15,i.val);
-    }
-    ay->getRegisterWrites().clear();
-
-    os[0]=0; os[1]=0;
-    // Nuked part
-    for (int i=0; i<24; i++) {
-      if (!writes.empty()) {
-        if (--delay<1 && !(fm->read(0)&0x80)) {
-          QueuedWrite& w=writes.front();
-
-          if (w.addr==0xfffffffe) {
-            delay=w.val*24*2;
-            writes.pop_front();
-          } else if (w.addr<=0x1c || (w.addr>=0x100 && w.addr<=0x12d)) {
-            // ymfm write
-            fm->write(0x0+((w.addr>>8)<<1),w.addr);
-            fm->write(0x1+((w.addr>>8)<<1),w.val);
-
-            regPool[w.addr&0x1ff]=w.val;
-            delay=(w.addr>15)?32:1;
-            writes.pop_front();
-          } else {
-            // Nuked write
-            if (w.addrOrVal) {
-              OPN2_Write(&fm_nuked,0x1+((w.addr>>8)<<1),w.val);
-              regPool[w.addr&0x1ff]=w.val;
-              writes.pop_front();
-            } else {
-              lastBusy++;
-              if (fm_nuked.write_busy==0) {
-                OPN2_Write(&fm_nuked,0x0+((w.addr>>8)<<1),w.addr);
-                w.addrOrVal=true;
-              }
-            }
-          }
-        }
-      }
-
-      OPN2_Clock(&fm_nuked,ignored);
-    }
-    os[0]=(
-      (fm_nuked.pan_l[1]?fm_nuked.ch_out[1]:0)+
-      (fm_nuked.pan_l[2]?fm_nuked.ch_out[2]:0)+
-      (fm_nuked.pan_l[4]?fm_nuked.ch_out[4]:0)+
-      (fm_nuked.pan_l[5]?fm_nuked.ch_out[5]:0)
-    );
-    os[1]=(
-      (fm_nuked.pan_r[1]?fm_nuked.ch_out[1]:0)+
-      (fm_nuked.pan_r[2]?fm_nuked.ch_out[2]:0)+
-      (fm_nuked.pan_r[4]?fm_nuked.ch_out[4]:0)+
-      (fm_nuked.pan_r[5]?fm_nuked.ch_out[5]:0)
-    );
-
-    os[0]>>=1;
-    os[1]>>=1;
-    os[0]=(os[0]*fmVol)>>8;
-    os[1]=(os[1]*fmVol)>>8;
-
-    // ymfm part
-    fm->generate(&fmout);
-
-    os[0]+=((fmout.data[0]*fmVol)>>8)+((fmout.data[2]*ssgVol)>>8);
-    if (os[0]<-32768) os[0]=-32768;
-    if (os[0]>32767) os[0]=32767;
-
-    os[1]+=((fmout.data[1]*fmVol)>>8)+((fmout.data[2]*ssgVol)>>8);
-    if (os[1]<-32768) os[1]=-32768;
-    if (os[1]>32767) os[1]=32767;
-  
-    buf[0][h]=os[0];
-    buf[1][h]=os[1];
-
-    
-    for (int i=0; i<(psgChanOffs-isCSM); i++) {
-      oscBuf[i]->putSample(h,CLAMP(fm_nuked.ch_out[bchOffs[i]]<<1,-32768,32767));
-    }
-
-    ssge->get_last_out(ssgOut);
-    for (int i=psgChanOffs; i<adpcmAChanOffs; i++) {
-      oscBuf[i]->putSample(h,ssgOut.data[i-psgChanOffs]<<1);
-    }
-
-    for (int i=adpcmAChanOffs; i<adpcmBChanOffs; i++) {
-      oscBuf[i]->putSample(h,(adpcmAChan[i-adpcmAChanOffs]->get_last_out(0)+adpcmAChan[i-adpcmAChanOffs]->get_last_out(1))>>1);
-    }
-
-    oscBuf[adpcmBChanOffs]->putSample(h,(abe->get_last_out(0)+abe->get_last_out(1))>>1);
-  }
-
-  for (int i=0; i<17; i++) {
-    oscBuf[i]->end(len);
-  }
-}
-
-void DivPlatformYM2610::acquire_ymfm(short** buf, size_t len) {
-  thread_local int os[2];
-
-  ymfm::ym2610::fm_engine* fme=fm->debug_fm_engine();
-  ymfm::ssg_engine* ssge=fm->debug_ssg_engine();
-  ymfm::adpcm_a_engine* aae=fm->debug_adpcm_a_engine();
-  ymfm::adpcm_b_engine* abe=fm->debug_adpcm_b_engine();
-
-  ymfm::ssg_engine::output_data ssgOut;
-
-  ymfm::fm_channel<ymfm::opn_registers_base<true>>* fmChan[4];
-  ymfm::adpcm_a_channel* adpcmAChan[6];
-  for (int i=0; i<4; i++) {
-    fmChan[i]=fme->debug_channel(bchOffs[i]);
-  }
-  for (int i=0; i<6; i++) {
-    adpcmAChan[i]=aae->debug_channel(i);
-  }
-
-  for (int i=0; i<17; i++) {
-    oscBuf[i]->begin(len);
-  }
-
-  for (size_t h=0; h<len; h++) {
-    // AY -> OPN
-    ay->runDAC(tfxRate);
-    ay->runTFX(tfxRate);
-    ay->flushWrites();
-    for (DivRegWrite& i: ay->getRegisterWrites()) {
-      if (i.addr>15) continue;
-      immWrite(i.addr&15,i.val);
-    }
-    ay->getRegisterWrites().clear();
-
-    os[0]=0; os[1]=0;
-    while (!writes.empty()) {
-      if (!(fm->read(0)&0x80)) {
-        delay=0;
-      }
-      if (delay<1) {
-        QueuedWrite& w=writes.front();
-        if (w.addr==0xfffffffe) {
-          delay=w.val*2;
-        } else {
-          fm->write(0x0+((w.addr>>8)<<1),w.addr);
-          fm->write(0x1+((w.addr>>8)<<1),w.val);
-          regPool[w.addr&0x1ff]=w.val;
-          if (w.addr>15) delay=1;
-        }
-        writes.pop_front();
-      }
-      if (delay>0) break;
-    }
-    
-    fm->generate(&fmout);
-    iface.clock();
-
-    os[0]+=((fmout.data[0]*fmVol)>>8)+((fmout.data[2]*ssgVol)>>8);
-    if (os[0]<-32768) os[0]=-32768;
-    if (os[0]>32767) os[0]=32767;
-
-    os[1]+=((fmout.data[1]*fmVol)>>8)+((fmout.data[2]*ssgVol)>>8);
-    if (os[1]<-32768) os[1]=-32768;
-    if (os[1]>32767) os[1]=32767;
-  
-    buf[0][h]=os[0];
-    buf[1][h]=os[1];
-
-    for (int i=0; i<(psgChanOffs-isCSM); i++) {
-      int out=(fmChan[i]->debug_output(0)+fmChan[i]->debug_output(1))<<1;
-      oscBuf[i]->putSample(h,CLAMP(out,-32768,32767));
-    }
-
-    ssge->get_last_out(ssgOut);
-    for (int i=psgChanOffs; i<adpcmAChanOffs; i++) {
-      oscBuf[i]->putSample(h,ssgOut.data[i-psgChanOffs]<<1);
-    }
-
-    for (int i=adpcmAChanOffs; i<adpcmBChanOffs; i++) {
-      oscBuf[i]->putSample(h,(adpcmAChan[i-adpcmAChanOffs]->get_last_out(0)+adpcmAChan[i-adpcmAChanOffs]->get_last_out(1))>>1);
-    }
-
-    oscBuf[adpcmBChanOffs]->putSample(h,(abe->get_last_out(0)+abe->get_last_out(1))>>1);
-  }
-
-  for (int i=0; i<17; i++) {
-    oscBuf[i]->end(len);
+    acquireYMFM(buf,len,bchOffs,4,psgChanOffs-isCSM,true);
   }
 }
 
@@ -457,7 +246,7 @@ static const unsigned char subCycleMap[6]={
 };
 
 void DivPlatformYM2610::acquire_lle(short** buf, size_t len) {
-  thread_local int fmOut[6];
+  int fmOut[6]={0};
 
   for (int i=0; i<17; i++) {
     oscBuf[i]->begin(len);
@@ -40,8 +40,6 @@ class DivPlatformYM2610: public DivPlatformYM2610Base {
 
     void commitState(int ch, DivInstrument* ins);
 
-    void acquire_combo(short** buf, size_t len);
-    void acquire_ymfm(short** buf, size_t len);
     void acquire_lle(short** buf, size_t len);
     
   public:
@@ -36,8 +36,6 @@ class DivPlatformYM2610B: public DivPlatformYM2610Base {
 
     void commitState(int ch, DivInstrument* ins);
 
-    void acquire_combo(short** buf, size_t len);
-    void acquire_ymfm(short** buf, size_t len);
     void acquire_lle(short** buf, size_t len);
 
   public:
@@ -0,0 +1,194 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2026 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "ym2610shared.h"
+
+// the write queue feeds both cores at sub-sample timing, so the cores are
+// clocked together. mixing is done afterwards on the whole block.
+void DivPlatformYM2610Base::mixBlock(short** buf, size_t pos, size_t len) {
+  for (size_t h=0; h<len; h++) {
+    int l=((mixNuked[0][h]*fmVol)>>8)+((mixFM[0][h]*fmVol)>>8)+((mixSSG[h]*ssgVol)>>8);
+    int r=((mixNuked[1][h]*fmVol)>>8)+((mixFM[1][h]*fmVol)>>8)+((mixSSG[h]*ssgVol)>>8);
+    buf[0][pos+h]=CLAMP(l,-32768,32767);
+    buf[1][pos+h]=CLAMP(r,-32768,32767);
+  }
+}
+
+void DivPlatformYM2610Base::runAY() {
+  ay->runDAC(tfxRate);
+  ay->runTFX(tfxRate);
+  ay->flushWrites();
+  for (DivRegWrite& i: ay->getRegisterWrites()) {
+    if (i.addr>15) continue;
+    immWrite(i.addr&15,i.val);
+  }
+  ay->getRegisterWrites().clear();
+}
+
+void DivPlatformYM2610Base::oscSSGADPCM(size_t h) {
+  ymfm::ssg_engine::output_data ssgData;
+  fm->debug_ssg_engine()->get_last_out(ssgData);
+  for (int i=psgChanOffs; i<adpcmAChanOffs; i++) {
+    oscBuf[i]->putSample(h,ssgData.data[i-psgChanOffs]<<1);
+  }
+
+  ymfm::adpcm_a_engine* aae=fm->debug_adpcm_a_engine();
+  for (int i=adpcmAChanOffs; i<adpcmBChanOffs; i++) {
+    ymfm::adpcm_a_channel* ch=aae->debug_channel(i-adpcmAChanOffs);
+    oscBuf[i]->putSample(h,(ch->get_last_out(0)+ch->get_last_out(1))>>1);
+  }
+
+  ymfm::adpcm_b_engine* abe=fm->debug_adpcm_b_engine();
+  oscBuf[adpcmBChanOffs]->putSample(h,(abe->get_last_out(0)+abe->get_last_out(1))>>1);
+}
+
+void DivPlatformYM2610Base::acquireCombo(short** buf, size_t len, const unsigned char* fmChans, int fmChanCount, int fmOscCount) {
+  short ignored[2]={0};
+
+  for (int i=0; i<17; i++) {
+    oscBuf[i]->begin(len);
+  }
+
+  for (size_t pos=0; pos<len; pos+=OPNB_RENDER_BLOCK) {
+    size_t blockLen=MIN(len-pos,OPNB_RENDER_BLOCK);
+    for (size_t j=0; j<blockLen; j++) {
+      size_t h=pos+j;
+      runAY();
+
+      // Nuked part
+      for (int i=0; i<24; i++) {
+        if (!writes.empty()) {
+          if (--delay<1 && !(fm->read(0)&0x80)) {
+            QueuedWrite& w=writes.front();
+
+            if (w.addr==0xfffffffe) {
+              delay=w.val*24*2;
+              writes.pop_front();
+            } else if (w.addr<=0x1c || (w.addr>=0x100 && w.addr<=0x12d)) {
+              // ymfm write
+              fm->write(0x0+((w.addr>>8)<<1),w.addr);
+              fm->write(0x1+((w.addr>>8)<<1),w.val);
+
+              regPool[w.addr&0x1ff]=w.val;
+              delay=(w.addr>15)?32:1;
+              writes.pop_front();
+            } else {
+              // Nuked write
+              if (w.addrOrVal) {
+                OPN2_Write(&fm_nuked,0x1+((w.addr>>8)<<1),w.val);
+                regPool[w.addr&0x1ff]=w.val;
+                writes.pop_front();
+              } else {
+                lastBusy++;
+                if (fm_nuked.write_busy==0) {
+                  OPN2_Write(&fm_nuked,0x0+((w.addr>>8)<<1),w.addr);
+                  w.addrOrVal=true;
+                }
+              }
+            }
+          }
+        }
+
+        OPN2_Clock(&fm_nuked,ignored);
+      }
+      int nl=0, nr=0;
+      for (int i=0; i<fmChanCount; i++) {
+        if (fm_nuked.pan_l[fmChans[i]]) nl+=fm_nuked.ch_out[fmChans[i]];
+        if (fm_nuked.pan_r[fmChans[i]]) nr+=fm_nuked.ch_out[fmChans[i]];
+      }
+      mixNuked[0][j]=nl>>1;
+      mixNuked[1][j]=nr>>1;
+
+      // ymfm part
+      fm->generate(&fmout);
+      mixFM[0][j]=fmout.data[0];
+      mixFM[1][j]=fmout.data[1];
+      mixSSG[j]=fmout.data[2];
+
+      for (int i=0; i<fmOscCount; i++) {
+        oscBuf[i]->putSample(h,CLAMP(fm_nuked.ch_out[fmChans[i]]<<1,-32768,32767));
+      }
+      oscSSGADPCM(h);
+    }
+    mixBlock(buf,pos,blockLen);
+  }
+
+  for (int i=0; i<17; i++) {
+    oscBuf[i]->end(len);
+  }
+}
+
+void DivPlatformYM2610Base::acquireYMFM(short** buf, size_t len, const unsigned char* fmChans, int fmChanCount, int fmOscCount, bool clockIface) {
+  ymfm::ym2610b::fm_engine* fme=fm->debug_fm_engine();
+
+  ymfm::fm_channel<ymfm::opn_registers_base<true>>* fmChan[6];
+  for (int i=0; i<fmChanCount; i++) {
+    fmChan[i]=fme->debug_channel(fmChans[i]);
+  }
+
+  for (int i=0; i<17; i++) {
+    oscBuf[i]->begin(len);
+  }
+
+  memset(mixNuked,0,sizeof(mixNuked));
+
+  for (size_t pos=0; pos<len; pos+=OPNB_RENDER_BLOCK) {
+    size_t blockLen=MIN(len-pos,OPNB_RENDER_BLOCK);
+    for (size_t j=0; j<blockLen; j++) {
+      size_t h=pos+j;
+      runAY();
+
+      while (!writes.empty()) {
+        if (!(fm->read(0)&0x80)) {
+          delay=0;
+        }
+        if (delay<1) {
+          QueuedWrite& w=writes.front();
+          if (w.addr==0xfffffffe) {
+            delay=w.val*2;
+          } else {
+            fm->write(0x0+((w.addr>>8)<<1),w.addr);
+            fm->write(0x1+((w.addr>>8)<<1),w.val);
+            regPool[w.addr&0x1ff]=w.val;
+            if (w.addr>15) delay=1;
+          }
+          writes.pop_front();
+        }
+        if (delay>0) break;
+      }
+
+      fm->generate(&fmout);
+      if (clockIface) iface.clock();
+      mixFM[0][j]=fmout.data[0];
+      mixFM[1][j]=fmout.data[1];
+      mixSSG[j]=fmout.data[2];
+
+      for (int i=0; i<fmOscCount; i++) {
+        int out=(fmChan[i]->debug_output(0)+fmChan[i]->debug_output(1))<<1;
+        oscBuf[i]->putSample(h,CLAMP(out,-32768,32767));
+      }
+      oscSSGADPCM(h);
+    }
+    mixBlock(buf,pos,blockLen);
+  }
+
+  for (int i=0; i<17; i++) {
+    oscBuf[i]->end(len);
+  }
+}
@@ -34,6 +34,9 @@ extern "C" {
 #define CHIP_FREQBASE fmFreqBase
 #define CHIP_DIVIDER fmDivBase
 
+// number of samples rendered before mixing
+#define OPNB_RENDER_BLOCK 256
+
 class DivYM2610Interface: public DivOPNInterface {
   public:
     unsigned char* adpcmAMem;
@@ -86,6 +89,25 @@ class DivPlatformYM2610Base: public DivPlatformOPN {
     DivMemoryComposition memCompoA;
     DivMemoryComposition memCompoB;
 
+    // per-block outputs of the cores, before volume and clamping
+    int mixNuked[2][OPNB_RENDER_BLOCK];
+    int mixFM[2][OPNB_RENDER_BLOCK];
+    int mixSSG[OPNB_RENDER_BLOCK];
+
+    void runAY();
+    void oscSSGADPCM(size_t h);
+    void mixBlock(short** buf, size_t pos, size_t len);
+
+    /**
+     * renders using Nuked-OPN2 for FM and ymfm for the rest.
+     * @param fmChans the FM channels of the chip, in channel order.
+     * @param fmChanCount the number of FM channels.
+     * @param fmOscCount the number of FM oscilloscope buffers to fill.
+     */
+    void acquireCombo(short** buf, size_t len, const unsigned char* fmChans, int fmChanCount, int fmOscCount);
+    // renders using ymfm only. see acquireCombo().
+    void acquireYMFM(short** buf, size_t len, const unsigned char* fmChans, int fmChanCount, int fmOscCount, bool clockIface);
+
     double NOTE_OPNB(int ch, int note) {
       if (ch>=adpcmBChanOffs) { // ADPCM
         return NOTE_ADPCMB(note);
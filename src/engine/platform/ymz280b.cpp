@@ -24,7 +24,7 @@
 
 #define CHIP_FREQBASE 25165824
 
-#define rWrite(a,v) {if(!skipRegisterWrites) {ymz280b.write(0,a); ymz280b.write(1,v); regPool[a]=v; if(dumpWrites) addWrite(a,v); }}
+#define rWrite(a,v) {if(!skipRegisterWrites) {writeCount++; ymz280b.write(0,a); ymz280b.write(1,v); regPool[a]=v; if(dumpWrites) addWrite(a,v); }}
 
 const char* regCheatSheetYMZ280B[]={
   "CHx_Freq", "00+x*4",
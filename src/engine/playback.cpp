@@ -28,6 +28,9 @@
 #include "dispatch.h"
 #include "engine.h"
 #include "workPool.h"
+#include "mixKernel.h"
+#include "trace.h"
+#include "counters.h"
 #include "../ta-log.h"
 #include <math.h>
 
@@ -333,9 +336,9 @@ static_assert((sizeof(cmdName)/sizeof(void*))==DIV_CMD_MAX,"update cmdName!");
 
 // formats a note
 // used for the pattern visualizer in console mode, justifying the use
-// of a static array.
+// of a static array (one per thread, as several engines may be running).
 const char* formatNote(short note) {
-  static char ret[16];
+  thread_local char ret[16];
   if (note==DIV_NOTE_OFF) {
     return "OFF";
   } else if (note==DIV_NOTE_REL) {
@@ -351,6 +354,11 @@ const char* formatNote(short note) {
 
 // send a command to a dispatch.
 int DivEngine::dispatchCmd(DivCommand c) {
+  return dispatchCmdInternal(c,false);
+}
+
+int DivEngine::dispatchCmdInternal(DivCommand c, bool wantsResult) {
+  divCountCmd(c.cmd);
   // used for the commands visualizer in console mode
   if (view==DIV_STATUS_COMMANDS) {
     // don't print if we are "skipping" (seeking to a position, usually after channel reset on loop)
@@ -398,7 +406,7 @@ int DivEngine::dispatchCmd(DivCommand c) {
           case DIV_CMD_LEGATO:
             // turn the previous note off (if we have one)
             if (chan[c.chan].curMidiNote>=0) {
-              output->midiOut->send(TAMidiMessage(0x80|(c.chan&15),chan[c.chan].curMidiNote,scaledVol));
+              sendMidiOut(TAMidiMessage(0x80|(c.chan&15),chan[c.chan].curMidiNote,scaledVol));
             }
             // set current MIDI note
             if (c.value!=DIV_NOTE_NULL) {
@@ -408,7 +416,7 @@ int DivEngine::dispatchCmd(DivCommand c) {
             }
             // send note on (if we have one)
             if (chan[c.chan].curMidiNote>=0) {
-              output->midiOut->send(TAMidiMessage(0x90|(c.chan&15),chan[c.chan].curMidiNote,scaledVol));
+              sendMidiOut(TAMidiMessage(0x90|(c.chan&15),chan[c.chan].curMidiNote,scaledVol));
             }
             break;
           case DIV_CMD_NOTE_OFF:
@@ -416,7 +424,7 @@ int DivEngine::dispatchCmd(DivCommand c) {
             // turn the current note off (if we have one)
             // we don't do this for macro release...
             if (chan[c.chan].curMidiNote>=0) {
-              output->midiOut->send(TAMidiMessage(0x80|(c.chan&15),chan[c.chan].curMidiNote,scaledVol));
+              sendMidiOut(TAMidiMessage(0x80|(c.chan&15),chan[c.chan].curMidiNote,scaledVol));
             }
             chan[c.chan].curMidiNote=-1;
             break;
@@ -424,7 +432,7 @@ int DivEngine::dispatchCmd(DivCommand c) {
             // instrument changes mapped to program change
             // only first 128 instruments
             if (chan[c.chan].lastIns!=c.value && midiOutProgramChange) {
-              output->midiOut->send(TAMidiMessage(0xc0|(c.chan&15),c.value&0x7f,0));
+              sendMidiOut(TAMidiMessage(0xc0|(c.chan&15),c.value&0x7f,0));
             }
             break;
           case DIV_CMD_VOLUME:
@@ -432,7 +440,7 @@ int DivEngine::dispatchCmd(DivCommand c) {
             // (processRow will set midiAftertouch to true on every row without note)
             if (chan[c.chan].curMidiNote>=0 && chan[c.chan].midiAftertouch) {
               chan[c.chan].midiAftertouch=false;
-              output->midiOut->send(TAMidiMessage(0xa0|(c.chan&15),chan[c.chan].curMidiNote,scaledVol));
+              sendMidiOut(TAMidiMessage(0xa0|(c.chan&15),chan[c.chan].curMidiNote,scaledVol));
             }
             break;
           case DIV_CMD_PITCH: {
@@ -442,7 +450,7 @@ int DivEngine::dispatchCmd(DivCommand c) {
             if (pitchBend>16383) pitchBend=16383;
             if (pitchBend!=chan[c.chan].midiPitch) {
               chan[c.chan].midiPitch=pitchBend;
-              output->midiOut->send(TAMidiMessage(0xe0|(c.chan&15),pitchBend&0x7f,pitchBend>>7));
+              sendMidiOut(TAMidiMessage(0xe0|(c.chan&15),pitchBend&0x7f,pitchBend>>7));
             }
             break;
           }
@@ -451,7 +459,7 @@ int DivEngine::dispatchCmd(DivCommand c) {
             int pan=convertPanSplitToLinearLR(c.value,c.value2,127);
             if (pan<0) pan=0;
             if (pan>127) pan=127;
-            output->midiOut->send(TAMidiMessage(0xb0|(c.chan&15),0x0a,pan));
+            sendMidiOut(TAMidiMessage(0xb0|(c.chan&15),0x0a,pan));
             break;
           }
           case DIV_CMD_HINT_PORTA: {
@@ -466,25 +474,25 @@ int DivEngine::dispatchCmd(DivCommand c) {
             if (c.value2>0) {
               // and only if we have a target note
               if (c.value<=0 || c.value>=255) break;
-              //output->midiOut->send(TAMidiMessage(0x80|(c.chan&15),chan[c.chan].curMidiNote,scaledVol));
+              //sendMidiOut(TAMidiMessage(0x80|(c.chan&15),chan[c.chan].curMidiNote,scaledVol));
               int target=c.value+12;
               if (target<0) target=0;
               if (target>127) target=127;
               
               // set the source note?
               if (chan[c.chan].curMidiNote>=0) {
-                output->midiOut->send(TAMidiMessage(0xb0|(c.chan&15),0x54,chan[c.chan].curMidiNote));
+                sendMidiOut(TAMidiMessage(0xb0|(c.chan&15),0x54,chan[c.chan].curMidiNote));
               }
               // set the duration
               // no effort whatsoever is done to predict how long will the slide last
-              output->midiOut->send(TAMidiMessage(0xb0|(c.chan&15),0x05,1/*MIN(0x7f,c.value2/4)*/));
+              sendMidiOut(TAMidiMessage(0xb0|(c.chan&15),0x05,1/*MIN(0x7f,c.value2/4)*/));
               // turn portamento on
-              output->midiOut->send(TAMidiMessage(0xb0|(c.chan&15),0x41,0x7f));
+              sendMidiOut(TAMidiMessage(0xb0|(c.chan&15),0x41,0x7f));
               // send a note on (why?)
-              output->midiOut->send(TAMidiMessage(0x90|(c.chan&15),target,scaledVol));
+              sendMidiOut(TAMidiMessage(0x90|(c.chan&15),target,scaledVol));
             } else {
               // disable portamento otherwise
-              output->midiOut->send(TAMidiMessage(0xb0|(c.chan&15),0x41,0));
+              sendMidiOut(TAMidiMessage(0xb0|(c.chan&15),0x41,0));
             }
             break;
           }
@@ -505,8 +513,40 @@ int DivEngine::dispatchCmd(DivCommand c) {
   // c.dis is a copy of c.chan because we'll use it in the next call
   c.chan=song.dispatchChanOfChan[c.dis];
 
+  // queue the command if we are in tick-decoupled mode and its return value isn't needed
+  if (deferCmds) {
+    if (!wantsResult && c.cmd!=DIV_CMD_GET_VOLUME && c.cmd!=DIV_CMD_GET_VOLMAX) {
+      disCont[song.dispatchOfChan[c.dis]].defer(bufferPos,c);
+      return 1;
+    }
+    // otherwise catch up before dispatching
+    disCont[song.dispatchOfChan[c.dis]].runDeferred(bufferPos);
+  }
+
   // dispatch command to chip dispatch
-  return disCont[song.dispatchOfChan[c.dis]].dispatch->dispatch(c);
+  return disCont[song.dispatchOfChan[c.dis]].sendCmd(c,holdCmds && !wantsResult);
+}
+
+int DivEngine::dispatchCmdResult(DivCommand c) {
+  return dispatchCmdInternal(c,true);
+}
+
+void DivEngine::flushDeferredCmds() {
+  if (!deferCmds) return;
+  for (int i=0; i<song.systemLen; i++) {
+    disCont[i].runDeferred(bufferPos);
+  }
+  deferCmds=false;
+}
+
+// map the value of a chip effect and dispatch it.
+// returns false if the value conversion says it shall not be handled.
+static inline bool mapEffectVal(const EffectHandler* handler, unsigned char effect, unsigned char effectVal, int& val, int& val2) {
+  val=handler->val?handler->val(effect,effectVal):effectVal;
+  if (val==DIV_EFFECT_NOT_HANDLED) return false;
+  val2=handler->val2?handler->val2(effect,effectVal):0;
+  if (val2==DIV_EFFECT_NOT_HANDLED) return false;
+  return true;
 }
 
 // this function handles per-chip normal effects
@@ -515,21 +555,15 @@ bool DivEngine::perSystemEffect(int ch, unsigned char effect, unsigned char effe
   DivSysDef* sysDef=sysDefs[song.sysOfChan[ch]];
   if (sysDef==NULL) return false;
   // find the effect handler
-  auto iter=sysDef->effectHandlers.find(effect);
-  if (iter==sysDef->effectHandlers.end()) return false;
-  EffectHandler handler=iter->second;
+  const EffectHandler* handler=sysDef->effectTable.get(effect);
+  if (handler==NULL) return false;
   int val=0;
   int val2=0;
   // map values using the handler's function
-  try {
-    val=handler.val?handler.val(effect,effectVal):effectVal;
-    val2=handler.val2?handler.val2(effect,effectVal):0;
-  } catch (DivDoNotHandleEffect& e) {
-    return false;
-  }
+  if (!mapEffectVal(handler,effect,effectVal,val,val2)) return false;
   // dispatch command
   // wouldn't this cause problems if it were to return 0?
-  return dispatchCmd(DivCommand(handler.dispatchCmd,ch,val,val2));
+  return dispatchCmdResult(DivCommand(handler->dispatchCmd,ch,val,val2));
 }
 
 // this handles per-chip post effects...
@@ -538,40 +572,28 @@ bool DivEngine::perSystemPostEffect(int ch, unsigned char effect, unsigned char
   DivSysDef* sysDef=sysDefs[song.sysOfChan[ch]];
   if (sysDef==NULL) return false;
   // find the effect handler
-  auto iter=sysDef->postEffectHandlers.find(effect);
-  if (iter==sysDef->postEffectHandlers.end()) return false;
-  EffectHandler handler=iter->second;
+  const EffectHandler* handler=sysDef->postEffectTable.get(effect);
+  if (handler==NULL) return false;
   int val=0;
   int val2=0;
   // map values using the handler's function
-  try {
-    val=handler.val?handler.val(effect,effectVal):effectVal;
-    val2=handler.val2?handler.val2(effect,effectVal):0;
-  } catch (DivDoNotHandleEffect& e) {
-    return true;
-  }
+  if (!mapEffectVal(handler,effect,effectVal,val,val2)) return true;
   // dispatch command
   // wouldn't this cause problems if it were to return 0?
-  return dispatchCmd(DivCommand(handler.dispatchCmd,ch,val,val2));
+  return dispatchCmdResult(DivCommand(handler->dispatchCmd,ch,val,val2));
 }
 
 // ...and this handles chip pre-effects
 bool DivEngine::perSystemPreEffect(int ch, unsigned char effect, unsigned char effectVal) {
   DivSysDef* sysDef=sysDefs[song.sysOfChan[ch]];
   if (sysDef==NULL) return false;
-  auto iter=sysDef->preEffectHandlers.find(effect);
-  if (iter==sysDef->preEffectHandlers.end()) return false;
-  EffectHandler handler=iter->second;
+  const EffectHandler* handler=sysDef->preEffectTable.get(effect);
+  if (handler==NULL) return false;
   int val=0;
   int val2=0;
-  try {
-    val=handler.val?handler.val(effect,effectVal):effectVal;
-    val2=handler.val2?handler.val2(effect,effectVal):0;
-  } catch (DivDoNotHandleEffect& e) {
-    return false;
-  }
+  if (!mapEffectVal(handler,effect,effectVal,val,val2)) return false;
   // wouldn't this cause problems if it were to return 0?
-  return dispatchCmd(DivCommand(handler.dispatchCmd,ch,val,val2));
+  return dispatchCmdResult(DivCommand(handler->dispatchCmd,ch,val,val2));
 }
 
 // this is called by nextRow() before it calls processRow()
@@ -580,14 +602,12 @@ void DivEngine::processRowPre(int i) {
   int whatOrder=curOrder;
   int whatRow=curRow;
   DivPattern* pat=curPat[i].getPattern(curOrders->ord[i][whatOrder],false);
+  DivPatternRowEffects rowFx;
+  pat->getRowEffects(whatRow,curPat[i].effectCols,rowFx);
   // check all effects
-  for (int j=0; j<curPat[i].effectCols; j++) {
-    short effect=pat->newData[whatRow][DIV_PAT_FX(j)];
-    short effectVal=pat->newData[whatRow][DIV_PAT_FXVAL(j)];
-
-    // empty effect value is the same as zero
-    if (effectVal==-1) effectVal=0;
-    effectVal&=255;
+  for (int j=0; j<rowFx.count; j++) {
+    short effect=rowFx.effect[j];
+    short effectVal=rowFx.effectVal[j];
 
     // per-chip pre-effects (that's it for now!)
     // the other pre-effects are handled in processRow()
@@ -606,10 +626,14 @@ void DivEngine::processRowPre(int i) {
 // 6. note on
 // 7. post-effects
 void DivEngine::processRow(int i, bool afterDelay) {
+  divCount(DIV_COUNTER_PATTERN_CELLS);
   // if this is after delay, use the order/row where delay occurred
   int whatOrder=afterDelay?chan[i].delayOrder:curOrder;
   int whatRow=afterDelay?chan[i].delayRow:curRow;
   DivPattern* pat=curPat[i].getPattern(curOrders->ord[i][whatOrder],false);
+  // gather the effects of this row once (empty columns are skipped)
+  DivPatternRowEffects rowFx;
+  pat->getRowEffects(whatRow,curPat[i].effectCols,rowFx);
   // pre effects
   // these include song control ones such as speed, tempo or jumps which shall not be delayed
   // it also includes EDxx (delay) itself so we can handle it
@@ -617,13 +641,9 @@ void DivEngine::processRow(int i, bool afterDelay) {
     // set to true if we found an EDxx effect
     bool returnAfterPre=false;
     // check all effects
-    for (int j=0; j<curPat[i].effectCols; j++) {
-      short effect=pat->newData[whatRow][DIV_PAT_FX(j)];
-      short effectVal=pat->newData[whatRow][DIV_PAT_FXVAL(j)];
-
-      // empty effect value is the same as zero
-      if (effectVal==-1) effectVal=0;
-      effectVal&=255;
+    for (int j=0; j<rowFx.count; j++) {
+      short effect=rowFx.effect[j];
+      short effectVal=rowFx.effectVal[j];
 
       switch (effect) {
         case 0x09: // select groove pattern/speed 1
@@ -852,16 +872,12 @@ void DivEngine::processRow(int i, bool afterDelay) {
   int volPortaTarget=-1;
   bool noApplyVolume=false;
   // here we read all effects and check for a volume slide with target/volume "portamento"/"scivolando" (a term I invented as an equivalent)
-  for (int j=0; j<curPat[i].effectCols; j++) {
-    short effect=pat->newData[whatRow][DIV_PAT_FX(j)];
+  for (int j=0; j<rowFx.count; j++) {
+    short effect=rowFx.effect[j];
     if (effect==0xd3 || effect==0xd4) { // vol porta
       volPortaTarget=pat->newData[whatRow][DIV_PAT_VOL]<<8; // can be -256
 
-      // empty effect value is treated as 0
-      short effectVal=pat->newData[whatRow][DIV_PAT_FXVAL(j)];
-      if (effectVal==-1) effectVal=0;
-      effectVal&=255;
-
+      short effectVal=rowFx.effectVal[j];
       noApplyVolume=effectVal>0; // "D3.." or "D300" shouldn't stop volume from applying
       break; // technically you could have both D3 and D4... let's not care
     }
@@ -896,13 +912,9 @@ void DivEngine::processRow(int i, bool afterDelay) {
   bool sampleOffSet=false;
 
   // effects
-  for (int j=0; j<curPat[i].effectCols; j++) {
-    short effect=pat->newData[whatRow][DIV_PAT_FX(j)];
-    short effectVal=pat->newData[whatRow][DIV_PAT_FXVAL(j)];
-
-    // an empty effect value is treated as zero
-    if (effectVal==-1) effectVal=0;
-    effectVal&=255;
+  for (int j=0; j<rowFx.count; j++) {
+    short effect=rowFx.effect[j];
+    short effectVal=rowFx.effectVal[j];
 
     // per-system effect
     // if there isn't one, go through normal effects
@@ -1660,13 +1672,9 @@ void DivEngine::processRow(int i, bool afterDelay) {
   chan[i].noteOnInhibit=false;
 
   // post effects
-  for (int j=0; j<curPat[i].effectCols; j++) {
-    short effect=pat->newData[whatRow][DIV_PAT_FX(j)];
-    short effectVal=pat->newData[whatRow][DIV_PAT_FXVAL(j)];
-
-    // an empty effect value is treated as zero
-    if (effectVal==-1) effectVal=0;
-    effectVal&=255;
+  for (int j=0; j<rowFx.count; j++) {
+    short effect=rowFx.effect[j];
+    short effectVal=rowFx.effectVal[j];
 
     // per-system post-effects
     // if there isn't one, try with normal effects
@@ -1714,12 +1722,12 @@ void DivEngine::processRow(int i, bool afterDelay) {
 // 9. schedule cuts and pre-notes if necessary
 void DivEngine::nextRow() {
   // update pattern visualizer in console mode
-  // buffers for printing the next row
-  static char pb[4096];
-  static char pb1[4096];
-  static char pb2[4096];
-  static char pb3[4096];
   if (view==DIV_STATUS_PATTERN && !skipping) {
+    // buffers for printing the next row
+    char pb[4096];
+    char pb1[4096];
+    char pb2[4096];
+    char pb3[4096];
     strcpy(pb1,"");
     strcpy(pb3,"");
     for (int i=0; i<song.chans; i++) {
@@ -2001,8 +2009,424 @@ void DivEngine::nextRow() {
 // noAccum will prevent the playback time from increasing.
 // if inhibitLowLat is on, low-latency mode is not taken into account. this is used by the export functions.
 // returns whether the song has ended.
+// runs per-tick effects (slides, vibrato, arpeggio and so on) on a channel.
+// this only touches the channel's state and its dispatch.
+void DivEngine::processChanTick(int i) {
+  // retrigger
+  if (chan[i].retrigSpeed) {
+    if (--chan[i].retrigTick<0) {
+      chan[i].retrigTick=chan[i].retrigSpeed-1;
+      // retrigger is a null note, which allows it to be combined with a pitch slide
+      dispatchCmd(DivCommand(DIV_CMD_NOTE_ON,i,DIV_NOTE_NULL));
+      keyHit[i]=true;
+    }
+  }
+
+  // volume slides and tremolo
+  // COMPAT FLAG: don't slide on the first tick of a row
+  // - Amiga/PC tracker behavior where slides and vibrato do not take course during the first tick of a row
+  if (!song.compatFlags.noSlidesOnFirstTick || !firstTick) {
+    // volume slides
+    if (chan[i].volSpeed!=0) {
+      // the call to GET_VOLUME is part of a compatibility process
+      // where the stored volume in the dispatch may be different
+      // from our volume (see legacy volume slides)
+      chan[i].volume=(chan[i].volume&0xff)|(dispatchCmdResult(DivCommand(DIV_CMD_GET_VOLUME,i))<<8);
+      int preSpeedVol=chan[i].volume;
+      chan[i].volume+=chan[i].volSpeed;
+      // handle scivolando
+      if (chan[i].volSpeedTarget!=-1) {
+        bool atTarget=false;
+        if (chan[i].volSpeed>0) {
+          atTarget=(chan[i].volume>=chan[i].volSpeedTarget);
+        } else if (chan[i].volSpeed<0) {
+          atTarget=(chan[i].volume<=chan[i].volSpeedTarget);
+        } else {
+          atTarget=true;
+          chan[i].volSpeedTarget=chan[i].volume;
+        }
+
+        if (atTarget) {
+          // once we are there, stop the slide
+          if (chan[i].volSpeed>0) {
+            chan[i].volume=MAX(preSpeedVol,chan[i].volSpeedTarget);
+          } else if (chan[i].volSpeed<0) {
+            chan[i].volume=MIN(preSpeedVol,chan[i].volSpeedTarget);
+          }
+          // COMPAT FLAG: don't stop volume slides after reaching target
+          // - when enabled, we don't reset the volume speed
+          if (!song.compatFlags.noVolSlideReset) {
+            chan[i].volSpeed=0;
+            chan[i].volSpeedTarget=-1;
+          }
+          dispatchCmd(DivCommand(DIV_CMD_HINT_VOLUME,i,chan[i].volume>>8));
+          dispatchCmd(DivCommand(DIV_CMD_VOLUME,i,chan[i].volume>>8));
+          dispatchCmd(DivCommand(DIV_CMD_HINT_VOL_SLIDE,i,0));
+        }
+      }
+      // stop sliding if we reach maximum/minimum volume
+      if (chan[i].volume>chan[i].volMax) {
+        chan[i].volume=chan[i].volMax;
+        // COMPAT FLAG: don't stop volume slides after reaching target
+        if (!song.compatFlags.noVolSlideReset) {
+          chan[i].volSpeed=0;
+          chan[i].volSpeedTarget=-1;
+        }
+        dispatchCmd(DivCommand(DIV_CMD_HINT_VOLUME,i,chan[i].volume>>8));
+        dispatchCmd(DivCommand(DIV_CMD_VOLUME,i,chan[i].volume>>8));
+        dispatchCmd(DivCommand(DIV_CMD_HINT_VOL_SLIDE,i,0));
+      } else if (chan[i].volume<0) {
+        // COMPAT FLAG: don't stop volume slides after reaching target
+        if (!song.compatFlags.noVolSlideReset) {
+          chan[i].volSpeed=0;
+          chan[i].volSpeedTarget=-1;
+        }
+        dispatchCmd(DivCommand(DIV_CMD_HINT_VOL_SLIDE,i,0));
+        // COMPAT FLAG: legacy volume slides
+        // - sets volume to max once a vol slide down has finished (thus setting volume to volMax+1)
+        // - there is more to this, such as the first step of volume macro resulting in unpredictable behavior, but I don't feel like implementing THAT...
+        if (song.compatFlags.legacyVolumeSlides) {
+          chan[i].volume=chan[i].volMax+1;
+        } else {
+          chan[i].volume=0;
+        }
+        dispatchCmd(DivCommand(DIV_CMD_VOLUME,i,chan[i].volume>>8));
+        dispatchCmd(DivCommand(DIV_CMD_HINT_VOLUME,i,chan[i].volume>>8));
+      } else {
+        dispatchCmd(DivCommand(DIV_CMD_VOLUME,i,chan[i].volume>>8));
+      }
+    } else if (chan[i].tremoloDepth>0) {
+      // tremolo (increase position in look-up table and send a volume change)
+      chan[i].tremoloPos+=chan[i].tremoloRate;
+      chan[i].tremoloPos&=127;
+      dispatchCmd(DivCommand(DIV_CMD_VOLUME,i,MAX(0,chan[i].volume-(tremTable[chan[i].tremoloPos]*chan[i].tremoloDepth))>>8));
+    }
+  }
+
+  // panning slides
+  if (chan[i].panSpeed!=0) {
+    int newPanL=chan[i].panL;
+    int newPanR=chan[i].panR;
+    // increase one side until it has reached max. then decrease the other.
+    if (chan[i].panSpeed>0) { // right
+      if (newPanR>=0xff) {
+        newPanL-=chan[i].panSpeed;
+      } else {
+        newPanR+=chan[i].panSpeed;
+      }
+    } else { // left
+      if (newPanL>=0xff) {
+        newPanR+=chan[i].panSpeed;
+      } else {
+        newPanL-=chan[i].panSpeed;
+      }
+    }
+
+    // clamp to boundaries
+    if (newPanL<0) newPanL=0;
+    if (newPanL>0xff) newPanL=0xff;
+    if (newPanR<0) newPanR=0;
+    if (newPanR>0xff) newPanR=0xff;
+
+    // set new pan
+    chan[i].panL=newPanL;
+    chan[i].panR=newPanR;
+
+    // send panning command
+    dispatchCmd(DivCommand(DIV_CMD_PANNING,i,chan[i].panL,chan[i].panR));
+  } else if (chan[i].panDepth>0) {
+    // panbrello, similar to vibrato and tremolo
+    chan[i].panPos+=chan[i].panRate;
+    chan[i].panPos&=255;
+
+    // calculate inverted...
+    // split position into four sections and calculate panning value
+    switch (chan[i].panPos&0xc0) {
+      case 0: // center -> right
+        chan[i].panL=((chan[i].panPos&0x3f)<<2);
+        chan[i].panR=0;
+        break;
+      case 0x40: // right -> center
+        chan[i].panL=0xff-((chan[i].panPos&0x3f)<<2);
+        chan[i].panR=0;
+        break;
+      case 0x80: // center -> left
+        chan[i].panL=0;
+        chan[i].panR=((chan[i].panPos&0x3f)<<2);
+        break;
+      case 0xc0: // left -> center
+        chan[i].panL=0;
+        chan[i].panR=0xff-((chan[i].panPos&0x3f)<<2);
+        break;
+    }
+
+    // multiply by depth
+    chan[i].panL=(chan[i].panL*chan[i].panDepth)/15;
+    chan[i].panR=(chan[i].panR*chan[i].panDepth)/15;
+
+    // then invert it to get final panning
+    chan[i].panL^=0xff;
+    chan[i].panR^=0xff;
+
+    dispatchCmd(DivCommand(DIV_CMD_PANNING,i,chan[i].panL,chan[i].panR));
+  }
+
+  // vibrato
+  if (chan[i].vibratoDepth>0) {
+    chan[i].vibratoPos+=chan[i].vibratoRate;
+    // clamp vibrato position
+    while (chan[i].vibratoPos>=64) chan[i].vibratoPos-=64;
+
+    // this is for the GUI's pattern visualizer
+    chan[i].vibratoPosGiant+=chan[i].vibratoRate;
+    while (chan[i].vibratoPosGiant>=512) chan[i].vibratoPosGiant-=512;
+
+    // look-up table
+    int vibratoOut=0;
+    switch (chan[i].vibratoShape) {
+      case 1: // sine, up only
+        vibratoOut=MAX(0,vibTable[chan[i].vibratoPos]);
+        break;
+      case 2: // sine, down only
+        vibratoOut=MIN(0,vibTable[chan[i].vibratoPos]);
+        break;
+      case 3: // triangle
+        vibratoOut=(chan[i].vibratoPos&31);
+        if (chan[i].vibratoPos&16) {
+          vibratoOut=32-(chan[i].vibratoPos&31);
+        }
+        if (chan[i].vibratoPos&32) {
+          vibratoOut=-vibratoOut;
+        }
+        vibratoOut<<=3;
+        break;
+      case 4: // ramp up
+        vibratoOut=chan[i].vibratoPos<<1;
+        break;
+      case 5: // ramp down
+        vibratoOut=-chan[i].vibratoPos<<1;
+        break;
+      case 6: // square
+        vibratoOut=(chan[i].vibratoPos>=32)?-127:127;
+        break;
+      case 7: // random (TODO: use LFSR)
+        vibratoOut=(rand()&255)-128;
+        break;
+      case 8: // square up
+        vibratoOut=(chan[i].vibratoPos>=32)?0:127;
+        break;
+      case 9: // square down
+        vibratoOut=(chan[i].vibratoPos>=32)?0:-127;
+        break;
+      case 10: // half sine up
+        vibratoOut=vibTable[chan[i].vibratoPos>>1];
+        break;
+      case 11: // half sine down
+        vibratoOut=vibTable[32|(chan[i].vibratoPos>>1)];
+        break;
+      default: // sine
+        vibratoOut=vibTable[chan[i].vibratoPos];
+        break;
+    }
+    // vibrato and pitch are merged into one
+    dispatchCmd(DivCommand(DIV_CMD_PITCH,i,chan[i].pitch+(((chan[i].vibratoDepth*vibratoOut*chan[i].vibratoFine)>>4)/15)));
+  }
+
+  // delayed legato
+  if (chan[i].legatoDelay>0) {
+    if (--chan[i].legatoDelay<1) {
+      // change note and send legato
+      chan[i].note+=chan[i].legatoTarget;
+      dispatchCmd(DivCommand(DIV_CMD_LEGATO,i,chan[i].note));
+      dispatchCmd(DivCommand(DIV_CMD_HINT_LEGATO,i,chan[i].note));
+      chan[i].legatoDelay=-1;
+      chan[i].legatoTarget=0;
+    }
+  }
+
+  // portamento and pitch slides
+  // COMPAT FLAG: don't slide on the first tick of a row
+  // - Amiga/PC tracker behavior where slides and vibrato do not take course during the first tick of a row
+  if (!song.compatFlags.noSlidesOnFirstTick || !firstTick) {
+    // portamento only runs if the channel has been used and the porta speed is higher than 0
+    if ((chan[i].keyOn || chan[i].keyOff) && chan[i].portaSpeed>0) {
+      // send a portamento update command to the dispatch.
+      // it returns whether the portamento is complete and has reached the target note.
+      // COMPAT FLAG: pitch linearity
+      // - 0: none (pitch control and slides non-linear)
+      // - 1: full (pitch slides linear... we multiply the portamento speed by a user-defined multiplier)
+      // COMPAT FLAG: reset pitch slide/portamento upon reaching target (inverted in the GUI)
+      // - when disabled, portamento remains active after it has finished
+      if (dispatchCmdResult(DivCommand(DIV_CMD_NOTE_PORTA,i,chan[i].portaSpeed*(song.compatFlags.linearPitch?song.compatFlags.pitchSlideSpeed:1),chan[i].portaNote))==2 && chan[i].portaStop && song.compatFlags.targetResetsSlides) {
+        // if we are here, it means we reached the target and shall stop
+        chan[i].portaSpeed=0;
+        dispatchCmd(DivCommand(DIV_CMD_HINT_PORTA,i,CLAMP(chan[i].portaNote,-128,127),MAX(chan[i].portaSpeed,0)));
+        chan[i].oldNote=chan[i].note;
+        chan[i].note=chan[i].portaNote;
+        chan[i].inPorta=false;
+        // send legato just in case
+        dispatchCmd(DivCommand(DIV_CMD_LEGATO,i,chan[i].note));
+        dispatchCmd(DivCommand(DIV_CMD_HINT_LEGATO,i,chan[i].note));
+      }
+    }
+  }
+
+  // note cut
+  if (chan[i].cut>0) {
+    if (--chan[i].cut<1) {
+      if (chan[i].cutType==2) { // macro release
+        dispatchCmd(DivCommand(DIV_CMD_ENV_RELEASE,i));
+        chan[i].releasing=true;
+      } else { // note off or release
+        chan[i].oldNote=chan[i].note;
+        //chan[i].note=-1;
+        // COMPAT FLAG: reset slides on note off (inverted in the GUI)
+        // - a portamento/pitch slide will be halted upon encountering note off
+        // - this will not occur if the stopPortaOnNoteOff flag is on and this is a portamento
+        if (chan[i].inPorta && song.compatFlags.noteOffResetsSlides) {
+          chan[i].keyOff=true;
+          chan[i].keyOn=false;
+          // stopOnOff will be false if stopPortaOnNoteOff flag is off
+          if (chan[i].stopOnOff) {
+            chan[i].portaNote=-1;
+            chan[i].portaSpeed=-1;
+            dispatchCmd(DivCommand(DIV_CMD_HINT_PORTA,i,CLAMP(chan[i].portaNote,-128,127),MAX(chan[i].portaSpeed,0)));
+            chan[i].stopOnOff=false;
+          }
+          // depending on the system, portamento may still be disabled
+          if (song.dispatchChanOfChan[i]>=0) if (disCont[song.dispatchOfChan[i]].dispatch->keyOffAffectsPorta(song.dispatchChanOfChan[i])) {
+            chan[i].portaNote=-1;
+            chan[i].portaSpeed=-1;
+            dispatchCmd(DivCommand(DIV_CMD_HINT_PORTA,i,CLAMP(chan[i].portaNote,-128,127),MAX(chan[i].portaSpeed,0)));
+          }
+          dispatchCmd(DivCommand(DIV_CMD_PRE_PORTA,i,false,0));
+          // another compatibility hack which schedules a second reset later just in case
+          chan[i].scheduledSlideReset=true;
+        }
+        if (chan[i].cutType==1) { // note release
+          dispatchCmd(DivCommand(DIV_CMD_NOTE_OFF_ENV,i));
+        } else { // note off
+          dispatchCmd(DivCommand(DIV_CMD_NOTE_OFF,i));
+        }
+        // I am not sure why is this here and not inside the previous statement
+        chan[i].releasing=true;
+      }
+    }
+  }
+
+  // volume cut/mute
+  if (chan[i].volCut>0) {
+    if (--chan[i].volCut<1) {
+      chan[i].volume=0;
+      dispatchCmd(DivCommand(DIV_CMD_VOLUME,i,chan[i].volume>>8));
+      dispatchCmd(DivCommand(DIV_CMD_HINT_VOLUME,i,chan[i].volume>>8));
+    }
+  }
+
+  // arpeggio
+  if (chan[i].resetArp) {
+    // if we must reset arp, sent a legato with the current note
+    dispatchCmd(DivCommand(DIV_CMD_LEGATO,i,chan[i].note));
+    dispatchCmd(DivCommand(DIV_CMD_HINT_LEGATO,i,chan[i].note));
+    chan[i].resetArp=false;
+  }
+  // COMPAT FLAG: reset arp position on row change
+  // - simulates Amiga/PC tracker behavior where the next row resets arp pos
+  if (song.compatFlags.rowResetsArpPos && firstTick) {
+    chan[i].arpStage=-1;
+  }
+  // arpeggio (actually)
+  // don't run it if arp yield is enabled (which will be if a compat flag is on)
+  if (chan[i].arp!=0 && !chan[i].arpYield && chan[i].portaSpeed<1) {
+    if (--chan[i].arpTicks<1) {
+      chan[i].arpTicks=curSubSong->arpLen;
+      // there are three arp stages, corresponding to note, note+x and note+y in the 00xy effect
+      chan[i].arpStage++;
+      if (chan[i].arpStage>2) chan[i].arpStage=0;
+      // arp is sent as legato
+      switch (chan[i].arpStage) {
+        case 0:
+          dispatchCmd(DivCommand(DIV_CMD_LEGATO,i,chan[i].note));
+          break;
+        case 1:
+          dispatchCmd(DivCommand(DIV_CMD_LEGATO,i,chan[i].note+(chan[i].arp>>4)));
+          break;
+        case 2:
+          dispatchCmd(DivCommand(DIV_CMD_LEGATO,i,chan[i].note+(chan[i].arp&15)));
+          break;
+      }
+    }
+  } else {
+    // acknowledge arp yield
+    chan[i].arpYield=false;
+  }
+}
+
+struct DivChanTickTask {
+  DivEngine* e;
+  int begin, end;
+};
+
+bool DivEngine::canTickInParallel() {
+  if (!parallelChanTick) return false;
+  if (renderPool==NULL) return false;
+  if (!renderPool->isThreaded()) return false;
+  if (song.systemLen<2) return false;
+  // these rely on commands arriving in order
+  if (view==DIV_STATUS_COMMANDS) return false;
+  if (cmdStreamEnabled) return false;
+  if (output) if (output->midiOut!=NULL && midiOutMode==DIV_MIDI_MODE_NOTE) {
+    if (output->midiOut->isDeviceOpen()) return false;
+  }
+  return true;
+}
+
+void DivEngine::tickChansParallel() {
+  DivChanTickTask tasks[DIV_MAX_CHIPS];
+  int taskCount=0;
+
+  // channels of a dispatch are contiguous
+  for (int i=0; i<song.chans; i++) {
+    if (taskCount>0 && song.dispatchOfChan[i]==song.dispatchOfChan[tasks[taskCount-1].begin]) {
+      tasks[taskCount-1].end=i+1;
+      continue;
+    }
+    if (taskCount>=DIV_MAX_CHIPS) {
+      tasks[taskCount-1].end=i+1;
+      continue;
+    }
+    tasks[taskCount].e=this;
+    tasks[taskCount].begin=i;
+    tasks[taskCount].end=i+1;
+    taskCount++;
+  }
+
+  renderPool->pushBatch([](void* t) {
+    DivChanTickTask* task=(DivChanTickTask*)t;
+    for (int i=task->begin; i<task->end; i++) {
+      task->e->processChanTick(i);
+    }
+  },tasks,taskCount);
+  renderPool->wait();
+}
+
+// within a tick, effects and macros often send the same command to a channel
+// several times in a row (e.g. volume slide and tremolo). only the last one matters,
+// so these are held back and sent once something else reaches the dispatch.
 bool DivEngine::nextTick(bool noAccum, bool inhibitLowLat) {
+  bool wasHolding=holdCmds;
+  holdCmds=true;
+  bool ret=nextTickInternal(noAccum,inhibitLowLat);
+  holdCmds=wasHolding;
+  if (!holdCmds) {
+    for (int i=0; i<song.systemLen; i++) disCont[i].flushHeldCmd();
+  }
+  return ret;
+}
+
+bool DivEngine::nextTickInternal(bool noAccum, bool inhibitLowLat) {
   bool ret=false;
+  divCount(DIV_COUNTER_TICKS);
   // prevent a division by zero
   if (divider<1) divider=1;
 
@@ -2158,7 +2582,11 @@ bool DivEngine::nextTick(bool noAccum, bool inhibitLowLat) {
               // - 1: soft-reset channels. same as 0 for now
               // - 2: don't reset
               if (song.compatFlags.loopModality!=2) {
+                // playSub() works on the dispatches directly
+                bool wasDeferring=deferCmds;
+                flushDeferredCmds();
                 playSub(true);
+                deferCmds=wasDeferring;
               }
             }
             endOfSong=false;
@@ -2190,354 +2618,13 @@ bool DivEngine::nextTick(bool noAccum, bool inhibitLowLat) {
       }
 
       // process stuff such as effects
-      if (!shallStop) for (int i=0; i<song.chans; i++) {
-        // retrigger
-        if (chan[i].retrigSpeed) {
-          if (--chan[i].retrigTick<0) {
-            chan[i].retrigTick=chan[i].retrigSpeed-1;
-            // retrigger is a null note, which allows it to be combined with a pitch slide
-            dispatchCmd(DivCommand(DIV_CMD_NOTE_ON,i,DIV_NOTE_NULL));
-            keyHit[i]=true;
-          }
-        }
-
-        // volume slides and tremolo
-        // COMPAT FLAG: don't slide on the first tick of a row
-        // - Amiga/PC tracker behavior where slides and vibrato do not take course during the first tick of a row
-        if (!song.compatFlags.noSlidesOnFirstTick || !firstTick) {
-          // volume slides
-          if (chan[i].volSpeed!=0) {
-            // the call to GET_VOLUME is part of a compatibility process
-            // where the stored volume in the dispatch may be different
-            // from our volume (see legacy volume slides)
-            chan[i].volume=(chan[i].volume&0xff)|(dispatchCmd(DivCommand(DIV_CMD_GET_VOLUME,i))<<8);
-            int preSpeedVol=chan[i].volume;
-            chan[i].volume+=chan[i].volSpeed;
-            // handle scivolando
-            if (chan[i].volSpeedTarget!=-1) {
-              bool atTarget=false;
-              if (chan[i].volSpeed>0) {
-                atTarget=(chan[i].volume>=chan[i].volSpeedTarget);
-              } else if (chan[i].volSpeed<0) {
-                atTarget=(chan[i].volume<=chan[i].volSpeedTarget);
-              } else {
-                atTarget=true;
-                chan[i].volSpeedTarget=chan[i].volume;
-              }
-
-              if (atTarget) {
-                // once we are there, stop the slide
-                if (chan[i].volSpeed>0) {
-                  chan[i].volume=MAX(preSpeedVol,chan[i].volSpeedTarget);
-                } else if (chan[i].volSpeed<0) {
-                  chan[i].volume=MIN(preSpeedVol,chan[i].volSpeedTarget);
-                }
-                // COMPAT FLAG: don't stop volume slides after reaching target
-                // - when enabled, we don't reset the volume speed
-                if (!song.compatFlags.noVolSlideReset) {
-                  chan[i].volSpeed=0;
-                  chan[i].volSpeedTarget=-1;
-                }
-                dispatchCmd(DivCommand(DIV_CMD_HINT_VOLUME,i,chan[i].volume>>8));
-                dispatchCmd(DivCommand(DIV_CMD_VOLUME,i,chan[i].volume>>8));
-                dispatchCmd(DivCommand(DIV_CMD_HINT_VOL_SLIDE,i,0));
-              }
-            }
-            // stop sliding if we reach maximum/minimum volume
-            if (chan[i].volume>chan[i].volMax) {
-              chan[i].volume=chan[i].volMax;
-              // COMPAT FLAG: don't stop volume slides after reaching target
-              if (!song.compatFlags.noVolSlideReset) {
-                chan[i].volSpeed=0;
-                chan[i].volSpeedTarget=-1;
-              }
-              dispatchCmd(DivCommand(DIV_CMD_HINT_VOLUME,i,chan[i].volume>>8));
-              dispatchCmd(DivCommand(DIV_CMD_VOLUME,i,chan[i].volume>>8));
-              dispatchCmd(DivCommand(DIV_CMD_HINT_VOL_SLIDE,i,0));
-            } else if (chan[i].volume<0) {
-              // COMPAT FLAG: don't stop volume slides after reaching target
-              if (!song.compatFlags.noVolSlideReset) {
-                chan[i].volSpeed=0;
-                chan[i].volSpeedTarget=-1;
-              }
-              dispatchCmd(DivCommand(DIV_CMD_HINT_VOL_SLIDE,i,0));
-              // COMPAT FLAG: legacy volume slides
-              // - sets volume to max once a vol slide down has finished (thus setting volume to volMax+1)
-              // - there is more to this, such as the first step of volume macro resulting in unpredictable behavior, but I don't feel like implementing THAT...
-              if (song.compatFlags.legacyVolumeSlides) {
-                chan[i].volume=chan[i].volMax+1;
-              } else {
-                chan[i].volume=0;
-              }
-              dispatchCmd(DivCommand(DIV_CMD_VOLUME,i,chan[i].volume>>8));
-              dispatchCmd(DivCommand(DIV_CMD_HINT_VOLUME,i,chan[i].volume>>8));
-            } else {
-              dispatchCmd(DivCommand(DIV_CMD_VOLUME,i,chan[i].volume>>8));
-            }
-          } else if (chan[i].tremoloDepth>0) {
-            // tremolo (increase position in look-up table and send a volume change)
-            chan[i].tremoloPos+=chan[i].tremoloRate;
-            chan[i].tremoloPos&=127;
-            dispatchCmd(DivCommand(DIV_CMD_VOLUME,i,MAX(0,chan[i].volume-(tremTable[chan[i].tremoloPos]*chan[i].tremoloDepth))>>8));
-          }
-        }
-
-        // panning slides
-        if (chan[i].panSpeed!=0) {
-          int newPanL=chan[i].panL;
-          int newPanR=chan[i].panR;
-          // increase one side until it has reached max. then decrease the other.
-          if (chan[i].panSpeed>0) { // right
-            if (newPanR>=0xff) {
-              newPanL-=chan[i].panSpeed;
-            } else {
-              newPanR+=chan[i].panSpeed;
-            }
-          } else { // left
-            if (newPanL>=0xff) {
-              newPanR+=chan[i].panSpeed;
-            } else {
-              newPanL-=chan[i].panSpeed;
-            }
-          }
-
-          // clamp to boundaries
-          if (newPanL<0) newPanL=0;
-          if (newPanL>0xff) newPanL=0xff;
-          if (newPanR<0) newPanR=0;
-          if (newPanR>0xff) newPanR=0xff;
-
-          // set new pan
-          chan[i].panL=newPanL;
-          chan[i].panR=newPanR;
-
-          // send panning command
-          dispatchCmd(DivCommand(DIV_CMD_PANNING,i,chan[i].panL,chan[i].panR));
-        } else if (chan[i].panDepth>0) {
-          // panbrello, similar to vibrato and tremolo
-          chan[i].panPos+=chan[i].panRate;
-          chan[i].panPos&=255;
-
-          // calculate inverted...
-          // split position into four sections and calculate panning value
-          switch (chan[i].panPos&0xc0) {
-            case 0: // center -> right
-              chan[i].panL=((chan[i].panPos&0x3f)<<2);
-              chan[i].panR=0;
-              break;
-            case 0x40: // right -> center
-              chan[i].panL=0xff-((chan[i].panPos&0x3f)<<2);
-              chan[i].panR=0;
-              break;
-            case 0x80: // center -> left
-              chan[i].panL=0;
-              chan[i].panR=((chan[i].panPos&0x3f)<<2);
-              break;
-            case 0xc0: // left -> center
-              chan[i].panL=0;
-              chan[i].panR=0xff-((chan[i].panPos&0x3f)<<2);
-              break;
-          }
-
-          // multiply by depth
-          chan[i].panL=(chan[i].panL*chan[i].panDepth)/15;
-          chan[i].panR=(chan[i].panR*chan[i].panDepth)/15;
-
-          // then invert it to get final panning
-          chan[i].panL^=0xff;
-          chan[i].panR^=0xff;
-
-          dispatchCmd(DivCommand(DIV_CMD_PANNING,i,chan[i].panL,chan[i].panR));
-        }
-
-        // vibrato
-        if (chan[i].vibratoDepth>0) {
-          chan[i].vibratoPos+=chan[i].vibratoRate;
-          // clamp vibrato position
-          while (chan[i].vibratoPos>=64) chan[i].vibratoPos-=64;
-
-          // this is for the GUI's pattern visualizer
-          chan[i].vibratoPosGiant+=chan[i].vibratoRate;
-          while (chan[i].vibratoPosGiant>=512) chan[i].vibratoPosGiant-=512;
-
-          // look-up table
-          int vibratoOut=0;
-          switch (chan[i].vibratoShape) {
-            case 1: // sine, up only
-              vibratoOut=MAX(0,vibTable[chan[i].vibratoPos]);
-              break;
-            case 2: // sine, down only
-              vibratoOut=MIN(0,vibTable[chan[i].vibratoPos]);
-              break;
-            case 3: // triangle
-              vibratoOut=(chan[i].vibratoPos&31);
-              if (chan[i].vibratoPos&16) {
-                vibratoOut=32-(chan[i].vibratoPos&31);
-              }
-              if (chan[i].vibratoPos&32) {
-                vibratoOut=-vibratoOut;
-              }
-              vibratoOut<<=3;
-              break;
-            case 4: // ramp up
-              vibratoOut=chan[i].vibratoPos<<1;
-              break;
-            case 5: // ramp down
-              vibratoOut=-chan[i].vibratoPos<<1;
-              break;
-            case 6: // square
-              vibratoOut=(chan[i].vibratoPos>=32)?-127:127;
-              break;
-            case 7: // random (TODO: use LFSR)
-              vibratoOut=(rand()&255)-128;
-              break;
-            case 8: // square up
-              vibratoOut=(chan[i].vibratoPos>=32)?0:127;
-              break;
-            case 9: // square down
-              vibratoOut=(chan[i].vibratoPos>=32)?0:-127;
-              break;
-            case 10: // half sine up
-              vibratoOut=vibTable[chan[i].vibratoPos>>1];
-              break;
-            case 11: // half sine down
-              vibratoOut=vibTable[32|(chan[i].vibratoPos>>1)];
-              break;
-            default: // sine
-              vibratoOut=vibTable[chan[i].vibratoPos];
-              break;
-          }
-          // vibrato and pitch are merged into one
-          dispatchCmd(DivCommand(DIV_CMD_PITCH,i,chan[i].pitch+(((chan[i].vibratoDepth*vibratoOut*chan[i].vibratoFine)>>4)/15)));
-        }
-
-        // delayed legato
-        if (chan[i].legatoDelay>0) {
-          if (--chan[i].legatoDelay<1) {
-            // change note and send legato
-            chan[i].note+=chan[i].legatoTarget;
-            dispatchCmd(DivCommand(DIV_CMD_LEGATO,i,chan[i].note));
-            dispatchCmd(DivCommand(DIV_CMD_HINT_LEGATO,i,chan[i].note));
-            chan[i].legatoDelay=-1;
-            chan[i].legatoTarget=0;
-          }
-        }
-
-        // portamento and pitch slides
-        // COMPAT FLAG: don't slide on the first tick of a row
-        // - Amiga/PC tracker behavior where slides and vibrato do not take course during the first tick of a row
-        if (!song.compatFlags.noSlidesOnFirstTick || !firstTick) {
-          // portamento only runs if the channel has been used and the porta speed is higher than 0
-          if ((chan[i].keyOn || chan[i].keyOff) && chan[i].portaSpeed>0) {
-            // send a portamento update command to the dispatch.
-            // it returns whether the portamento is complete and has reached the target note.
-            // COMPAT FLAG: pitch linearity
-            // - 0: none (pitch control and slides non-linear)
-            // - 1: full (pitch slides linear... we multiply the portamento speed by a user-defined multiplier)
-            // COMPAT FLAG: reset pitch slide/portamento upon reaching target (inverted in the GUI)
-            // - when disabled, portamento remains active after it has finished
-            if (dispatchCmd(DivCommand(DIV_CMD_NOTE_PORTA,i,chan[i].portaSpeed*(song.compatFlags.linearPitch?song.compatFlags.pitchSlideSpeed:1),chan[i].portaNote))==2 && chan[i].portaStop && song.compatFlags.targetResetsSlides) {
-              // if we are here, it means we reached the target and shall stop
-              chan[i].portaSpeed=0;
-              dispatchCmd(DivCommand(DIV_CMD_HINT_PORTA,i,CLAMP(chan[i].portaNote,-128,127),MAX(chan[i].portaSpeed,0)));
-              chan[i].oldNote=chan[i].note;
-              chan[i].note=chan[i].portaNote;
-              chan[i].inPorta=false;
-              // send legato just in case
-              dispatchCmd(DivCommand(DIV_CMD_LEGATO,i,chan[i].note));
-              dispatchCmd(DivCommand(DIV_CMD_HINT_LEGATO,i,chan[i].note));
-            }
-          }
-        }
-
-        // note cut
-        if (chan[i].cut>0) {
-          if (--chan[i].cut<1) {
-            if (chan[i].cutType==2) { // macro release
-              dispatchCmd(DivCommand(DIV_CMD_ENV_RELEASE,i));
-              chan[i].releasing=true;
-            } else { // note off or release
-              chan[i].oldNote=chan[i].note;
-              //chan[i].note=-1;
-              // COMPAT FLAG: reset slides on note off (inverted in the GUI)
-              // - a portamento/pitch slide will be halted upon encountering note off
-              // - this will not occur if the stopPortaOnNoteOff flag is on and this is a portamento
-              if (chan[i].inPorta && song.compatFlags.noteOffResetsSlides) {
-                chan[i].keyOff=true;
-                chan[i].keyOn=false;
-                // stopOnOff will be false if stopPortaOnNoteOff flag is off
-                if (chan[i].stopOnOff) {
-                  chan[i].portaNote=-1;
-                  chan[i].portaSpeed=-1;
-                  dispatchCmd(DivCommand(DIV_CMD_HINT_PORTA,i,CLAMP(chan[i].portaNote,-128,127),MAX(chan[i].portaSpeed,0)));
-                  chan[i].stopOnOff=false;
-                }
-                // depending on the system, portamento may still be disabled
-                if (song.dispatchChanOfChan[i]>=0) if (disCont[song.dispatchOfChan[i]].dispatch->keyOffAffectsPorta(song.dispatchChanOfChan[i])) {
-                  chan[i].portaNote=-1;
-                  chan[i].portaSpeed=-1;
-                  dispatchCmd(DivCommand(DIV_CMD_HINT_PORTA,i,CLAMP(chan[i].portaNote,-128,127),MAX(chan[i].portaSpeed,0)));
-                }
-                dispatchCmd(DivCommand(DIV_CMD_PRE_PORTA,i,false,0));
-                // another compatibility hack which schedules a second reset later just in case
-                chan[i].scheduledSlideReset=true;
-              }
-              if (chan[i].cutType==1) { // note release
-                dispatchCmd(DivCommand(DIV_CMD_NOTE_OFF_ENV,i));
-              } else { // note off
-                dispatchCmd(DivCommand(DIV_CMD_NOTE_OFF,i));
-              }
-              // I am not sure why is this here and not inside the previous statement
-              chan[i].releasing=true;
-            }
-          }
-        }
-
-        // volume cut/mute
-        if (chan[i].volCut>0) {
-          if (--chan[i].volCut<1) {
-            chan[i].volume=0;
-            dispatchCmd(DivCommand(DIV_CMD_VOLUME,i,chan[i].volume>>8));
-            dispatchCmd(DivCommand(DIV_CMD_HINT_VOLUME,i,chan[i].volume>>8));
-          }
-        }
-
-        // arpeggio
-        if (chan[i].resetArp) {
-          // if we must reset arp, sent a legato with the current note
-          dispatchCmd(DivCommand(DIV_CMD_LEGATO,i,chan[i].note));
-          dispatchCmd(DivCommand(DIV_CMD_HINT_LEGATO,i,chan[i].note));
-          chan[i].resetArp=false;
-        }
-        // COMPAT FLAG: reset arp position on row change
-        // - simulates Amiga/PC tracker behavior where the next row resets arp pos
-        if (song.compatFlags.rowResetsArpPos && firstTick) {
-          chan[i].arpStage=-1;
-        }
-        // arpeggio (actually)
-        // don't run it if arp yield is enabled (which will be if a compat flag is on)
-        if (chan[i].arp!=0 && !chan[i].arpYield && chan[i].portaSpeed<1) {
-          if (--chan[i].arpTicks<1) {
-            chan[i].arpTicks=curSubSong->arpLen;
-            // there are three arp stages, corresponding to note, note+x and note+y in the 00xy effect
-            chan[i].arpStage++;
-            if (chan[i].arpStage>2) chan[i].arpStage=0;
-            // arp is sent as legato
-            switch (chan[i].arpStage) {
-              case 0:
-                dispatchCmd(DivCommand(DIV_CMD_LEGATO,i,chan[i].note));
-                break;
-              case 1:
-                dispatchCmd(DivCommand(DIV_CMD_LEGATO,i,chan[i].note+(chan[i].arp>>4)));
-                break;
-              case 2:
-                dispatchCmd(DivCommand(DIV_CMD_LEGATO,i,chan[i].note+(chan[i].arp&15)));
-                break;
-            }
-          }
+      if (!shallStop) {
+        if (canTickInParallel()) {
+          tickChansParallel();
         } else {
-          // acknowledge arp yield
-          chan[i].arpYield=false;
+          for (int i=0; i<song.chans; i++) {
+            processChanTick(i);
+          }
         }
       }
     }
@@ -2585,7 +2672,14 @@ bool DivEngine::nextTick(bool noAccum, bool inhibitLowLat) {
   }
 
   // tick all chip dispatches (the argument determines whether it is a system tick or a sub-tick)
-  for (int i=0; i<song.systemLen; i++) disCont[i].dispatch->tick(subticks==tickMult);
+  if (deferCmds) {
+    for (int i=0; i<song.systemLen; i++) disCont[i].deferTick(bufferPos,subticks==tickMult);
+  } else {
+    for (int i=0; i<song.systemLen; i++) {
+      disCont[i].flushHeldCmd();
+      disCont[i].dispatch->tick(subticks==tickMult);
+    }
+  }
 
   // update playback time
   if (!freelance) {
@@ -2638,7 +2732,7 @@ void DivEngine::runMidiClock(int totalCycles) {
     // send MIDI clock event
     curMidiClock++;
     if (output) if (!skipping && output->midiOut!=NULL && midiOutClock) {
-      output->midiOut->send(TAMidiMessage(TA_MIDI_CLOCK,0,0));
+      sendMidiOut(TAMidiMessage(TA_MIDI_CLOCK,0,0),totalCycles+midiClockCycles);
     }
 
     // calculate tempo using highlight, tick rate, speeds and virtual tempo
@@ -2773,7 +2867,7 @@ void DivEngine::runMidiTime(int totalCycles) {
           break;
       }
       val|=curMidiTimePiece<<4;
-      output->midiOut->send(TAMidiMessage(TA_MIDI_MTC_FRAME,val,0));
+      sendMidiOut(TAMidiMessage(TA_MIDI_MTC_FRAME,val,0),totalCycles+midiTimeCycles);
     }
     curMidiTimePiece=(curMidiTimePiece+1)&7;
 
@@ -2786,64 +2880,59 @@ void DivEngine::runMidiTime(int totalCycles) {
   }
 }
 
-// these two functions are either leftovers or something or they are there for test purposes.
-// I don't remember very well.
-void _runDispatch1(void* d) {
+bool DivEngine::sendMidiOut(TAMidiMessage msg, int offset) {
+  if (output==NULL) return false;
+  if (output->midiOut==NULL) return false;
+  if (midiOutTimed && got.rate>0) {
+    msg.time=midiOutBufTime+(double)((int)bufferPos+offset)/got.rate;
+  }
+  return output->midiOut->sendAt(msg);
 }
 
-void _runDispatch2(void* d) {
-
-}
+void DivEngine::collectMidiIn(unsigned int size) {
+  if (output==NULL) return;
+  if (output->midiIn==NULL) return;
 
-// this fills the audio buffer and runs tbe engine.
-// called by the audio backend and during audio export.
-void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsigned int size) {
-  // debug information
-  lastNBIns=inChans;
-  lastNBOuts=outChans;
-  lastNBSize=size;
+  // events which arrived during the last buffer are spread over this one
+  double now=std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  double bufStart=now-(double)size/got.rate;
 
-  // don't fill a buffer if the size is 0
-  if (!size) {
-    logW("nextBuf called with size 0!");
-    return;
-  }
-  lastLoopPos=-1;
-
-  // clear the output
-  if (out!=NULL) {
-    for (int i=0; i<outChans; i++) {
-      memset(out[i],0,size*sizeof(float));
+  auto place=[this,size,bufStart](const TAMidiMessage& msg) {
+    unsigned int pos=0;
+    if (msg.time>bufStart) {
+      pos=(msg.time-bufStart)*got.rate;
+      if (pos>=size) pos=size-1;
     }
-  }
-
-  // check the mutex.
-  // soft-locking happens when synchronizedSoft is called.
-  if (softLocked) {
-    // in this case we just return
-    if (!isBusy.try_lock()) {
-      logV("audio is soft-locked (%d)",softLockCount++);
-      return;
+    // keep the events in order
+    if (!midiInEvents.empty()) {
+      if (pos<midiInEvents.back().pos) pos=midiInEvents.back().pos;
+    }
+    // this can't be undone by a render-ahead rollback
+    renderAheadEpoch++;
+    if (!midiInEvents.push(DivMidiInEvent(pos,msg))) {
+      logW("MIDI input event queue full!");
+    }
+  };
+
+  if (renderAheadActive) {
+    // the audio callback gathers MIDI input on another thread in this case
+    std::lock_guard<std::mutex> lock(midiInLock);
+    while (!midiInQueue.empty()) {
+      place(midiInQueue.front());
+      midiInQueue.pop();
     }
   } else {
-    isBusy.lock();
-  }
-  got.bufsize=size;
-
-  // this is used to calculate audio load
-  std::chrono::steady_clock::time_point ts_processBegin=std::chrono::steady_clock::now();
-
-  // set up the render thread pool
-  if (renderPool==NULL) {
-    unsigned int howManyThreads=song.systemLen;
-    if (howManyThreads<2) howManyThreads=0;
-    if (howManyThreads>renderPoolThreads) howManyThreads=renderPoolThreads;
-    renderPool=new DivWorkPool(howManyThreads);
+    while (!output->midiIn->queue.empty()) {
+      place(output->midiIn->queue.front());
+      output->midiIn->queue.pop();
+    }
   }
+}
 
-  // process MIDI input events
-  if (output) if (output->midiIn) while (!output->midiIn->queue.empty()) {
-    TAMidiMessage& msg=output->midiIn->queue.front();
+void DivEngine::processMidiIn(unsigned int pos) {
+  while (!midiInEvents.empty()) {
+    if (midiInEvents.front().pos>pos) break;
+    TAMidiMessage& msg=midiInEvents.front().msg;
     // print MIDI events if MIDI debug is enabled
     if (midiDebug) {
       if (msg.type==TA_MIDI_SYSEX) {
@@ -2916,97 +3005,152 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
     } else if (midiDebug) {
       logD("callback wants ignore");
     }
-    //logD("%.2x",msg.type);
-    output->midiIn->queue.pop();
+    midiInEvents.pop();
   }
-  
-  // process sample/wave preview (not during audio export)
-  if (((sPreview.sample>=0 && sPreview.sample<(int)song.sample.size()) || (sPreview.wave>=0 && sPreview.wave<(int)song.wave.size())) && !exporting) {
-    // we use blip_buf to pitch the sample
-    unsigned int samp_bbOff=0;
-    // if there are samples, flush them (this can happen when the playback
-    // rate is less than the output rate)
-    unsigned int prevAvail=blip_samples_avail(samp_bb);
-    if (prevAvail>size) prevAvail=size;
-    if (prevAvail>0) {
-      blip_read_samples(samp_bb,samp_bbOut,prevAvail,0);
-      samp_bbOff=prevAvail;
-    }
-    // prepare to fill the buffer
-    size_t prevtotal=blip_clocks_needed(samp_bb,size-prevAvail);
-
-    // play the sample
-    if (sPreview.sample>=0 && sPreview.sample<(int)song.sample.size()) {
-      DivSample* s=song.sample[sPreview.sample];
-
-      for (size_t i=0; i<prevtotal; i++) {
-        if (sPreview.pos>=(int)s->samples || (sPreview.pEnd>=0 && sPreview.pos>=sPreview.pEnd)) {
-          // zero if out of bounds
-          samp_temp=0;
+}
+
+// render a dispatch until the end of a tick or the audio buffer.
+void _runDispatch1(void* d) {
+  DIV_TRACE_SCOPE("render",((DivDispatchContainer*)d)->name);
+  ((DivDispatchContainer*)d)->run();
+}
+
+// render a dispatch's whole buffer, applying deferred commands (tick-decoupled mode).
+void _runDispatch2(void* d) {
+  DivDispatchContainer* dc=(DivDispatchContainer*)d;
+  DIV_TRACE_SCOPE("render",dc->name);
+  dc->runDeferred(dc->size);
+}
+
+void DivEngine::setOscBuffersEnabled(bool enable) {
+  for (int i=0; i<song.chans; i++) {
+    if (song.dispatchChanOfChan[i]<0) continue;
+    DivDispatch* disp=disCont[song.dispatchOfChan[i]].dispatch;
+    if (disp==NULL) continue;
+    DivDispatchOscBuffer* buf=disp->getOscBuffer(song.dispatchChanOfChan[i]);
+    if (buf==NULL) continue;
+    if (enable) {
+      buf->enable();
+    } else {
+      buf->disable();
+    }
+  }
+  oscEnabled=enable;
+}
+
+void DivEngine::publishProfile(unsigned long long* stages, size_t samples) {
+  unsigned int pos=profHistoryPos;
+  for (int i=0; i<DIV_PROFILE_MAX; i++) {
+    profHistory[i][pos]=MIN(stages[i],UINT_MAX);
+    profTotal[i]+=stages[i];
+  }
+  for (int i=0; i<DIV_MAX_CHIPS; i++) {
+    for (int j=0; j<DIV_DISPATCH_PROFILE_MAX; j++) {
+      unsigned long long t=0;
+      if (i<song.systemLen) {
+        t=disCont[i].profTime[j];
+        disCont[i].profTime[j]=0;
+      }
+      profChipHistory[i][j][pos]=MIN(t,UINT_MAX);
+      profChipTotal[i][j]+=t;
+    }
+    if (i<song.systemLen && disCont[i].dispatch!=NULL) {
+      unsigned int writes=disCont[i].dispatch->takeWriteCount();
+      unsigned int deltas=disCont[i].takeDeltaCount();
+      profChipWrites[i]+=writes;
+      profChipDeltas[i]+=deltas;
+      divCount(DIV_COUNTER_REG_WRITES,writes);
+      divCount(DIV_COUNTER_BLIP_DELTAS,deltas);
+    }
+  }
+  profSamples+=samples;
+  profBuffers++;
+  profHistoryPos=(pos+1)%DIV_PROFILE_HISTORY;
+}
+
+// render the sample/wave preview into samp_bbOut.
+// this is independent of the chips, so it may run on the render pool.
+void DivEngine::renderSamplePreview(unsigned int size) {
+  // we use blip_buf to pitch the sample
+  unsigned int samp_bbOff=0;
+  // if there are samples, flush them (this can happen when the playback
+  // rate is less than the output rate)
+  unsigned int prevAvail=blip_samples_avail(samp_bb);
+  if (prevAvail>size) prevAvail=size;
+  if (prevAvail>0) {
+    blip_read_samples(samp_bb,samp_bbOut,prevAvail,0);
+    samp_bbOff=prevAvail;
+  }
+  // prepare to fill the buffer
+  size_t prevtotal=blip_clocks_needed(samp_bb,size-prevAvail);
+  if (prevtotal>samp_bbInLen) {
+    delete[] samp_bbIn;
+    samp_bbInLen=prevtotal+256;
+    samp_bbIn=new short[samp_bbInLen];
+  }
+
+  // play the sample
+  if (sPreview.sample>=0 && sPreview.sample<(int)song.sample.size()) {
+    DivSample* s=song.sample[sPreview.sample];
+
+    // while moving forward, nothing happens until the needle gets to the end
+    // of the sample, the loop end or the preview end.
+    int safeEnd=s->samples;
+    if (s->isLoopable() && s->loopEnd<safeEnd) safeEnd=s->loopEnd;
+    if (sPreview.pEnd>=0 && sPreview.pEnd<safeEnd) safeEnd=sPreview.pEnd;
+
+    for (size_t i=0; i<prevtotal; i++) {
+      // fast path: copy whole runs as long as the needle stays before safeEnd
+      if (!sPreview.dir && sPreview.pos>=0 && sPreview.pos+1<safeEnd) {
+        size_t left=prevtotal-i;
+        if (sPreview.rateMul==1 && sPreview.posSub<=1) {
+          // one output sample per input sample
+          size_t run=MIN(left,(size_t)(safeEnd-1-sPreview.pos));
+          memcpy(&samp_bbIn[i],&s->data16[sPreview.pos],run*sizeof(short));
+          sPreview.pos+=run;
+          sPreview.posSub=1;
+          i+=run-1;
         } else {
-          // fetch sample
-          samp_temp=s->data16[sPreview.pos];
-          if (--sPreview.posSub<=0) {
+          // repeat the current input sample until posSub runs out
+          size_t run=(sPreview.posSub>1)?sPreview.posSub:1;
+          short val=s->data16[sPreview.pos];
+          if (run>left) {
+            run=left;
+            sPreview.posSub-=run;
+          } else {
             sPreview.posSub=sPreview.rateMul;
-            if (sPreview.dir) {
-              sPreview.pos--;
-            } else {
-              sPreview.pos++;
-            }
+            sPreview.pos++;
           }
-        }
-        // insert sample
-        blip_add_delta(samp_bb,i,samp_temp-samp_prevSample);
-        samp_prevSample=samp_temp;
-
-        // check playback direction and move needle
-        if (sPreview.dir) { // backward
-          if (sPreview.pos<s->loopStart || (sPreview.pBegin>=0 && sPreview.pos<sPreview.pBegin)) {
-            if (s->isLoopable() && sPreview.pos<s->loopEnd) {
-              switch (s->loopMode) {
-                case DivSampleLoopMode::DIV_SAMPLE_LOOP_FORWARD:
-                  sPreview.pos=s->loopStart;
-                  sPreview.dir=false;
-                  break;
-                case DivSampleLoopMode::DIV_SAMPLE_LOOP_BACKWARD:
-                  sPreview.pos=s->loopEnd-1;
-                  sPreview.dir=true;
-                  break;
-                case DivSampleLoopMode::DIV_SAMPLE_LOOP_PINGPONG:
-                  sPreview.pos=s->loopStart;
-                  sPreview.dir=false;
-                  break;
-                default:
-                  break;
-              }
-            }
+          for (size_t j=0; j<run; j++) {
+            samp_bbIn[i+j]=val;
           }
-        } else { // forward
-          if (sPreview.pos>=s->loopEnd || (sPreview.pEnd>=0 && sPreview.pos>=sPreview.pEnd)) {
-            if (s->isLoopable() && sPreview.pos>=s->loopStart) {
-              switch (s->loopMode) {
-                case DivSampleLoopMode::DIV_SAMPLE_LOOP_FORWARD:
-                  sPreview.pos=s->loopStart;
-                  sPreview.dir=false;
-                  break;
-                case DivSampleLoopMode::DIV_SAMPLE_LOOP_BACKWARD:
-                  sPreview.pos=s->loopEnd-1;
-                  sPreview.dir=true;
-                  break;
-                case DivSampleLoopMode::DIV_SAMPLE_LOOP_PINGPONG:
-                  sPreview.pos=s->loopEnd-1;
-                  sPreview.dir=true;
-                  break;
-                default:
-                  break;
-              }
-            }
+          i+=run-1;
+        }
+        continue;
+      }
+
+      if (sPreview.pos>=(int)s->samples || (sPreview.pEnd>=0 && sPreview.pos>=sPreview.pEnd)) {
+        // zero if out of bounds
+        samp_temp=0;
+      } else {
+        // fetch sample
+        samp_temp=s->data16[sPreview.pos];
+        if (--sPreview.posSub<=0) {
+          sPreview.posSub=sPreview.rateMul;
+          if (sPreview.dir) {
+            sPreview.pos--;
+          } else {
+            sPreview.pos++;
           }
         }
       }
+      // insert sample
+      samp_bbIn[i]=samp_temp;
+
+      // check playback direction and move needle
       if (sPreview.dir) { // backward
-        if (sPreview.pos<=s->loopStart || (sPreview.pBegin>=0 && sPreview.pos<=sPreview.pBegin)) {
-          if (s->isLoopable() && sPreview.pos>=s->loopStart) {
+        if (sPreview.pos<s->loopStart || (sPreview.pBegin>=0 && sPreview.pos<sPreview.pBegin)) {
+          if (s->isLoopable() && sPreview.pos<s->loopEnd) {
             switch (s->loopMode) {
               case DivSampleLoopMode::DIV_SAMPLE_LOOP_FORWARD:
                 sPreview.pos=s->loopStart;
@@ -3023,8 +3167,6 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
               default:
                 break;
             }
-          } else if (sPreview.pos<0) {
-            sPreview.sample=-1;
           }
         }
       } else { // forward
@@ -3046,35 +3188,192 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
               default:
                 break;
             }
-          } else if (sPreview.pos>=(int)s->samples) {
-            sPreview.sample=-1;
           }
         }
       }
-    } else if (sPreview.wave>=0 && sPreview.wave<(int)song.wave.size()) {
-      DivWavetable* wave=song.wave[sPreview.wave];
-      for (size_t i=0; i<prevtotal; i++) {
-        if (wave->max<=0) {
-          samp_temp=0;
-        } else {
-          samp_temp=((MIN(wave->data[sPreview.pos],wave->max)<<14)/wave->max)-8192;
+    }
+    if (sPreview.dir) { // backward
+      if (sPreview.pos<=s->loopStart || (sPreview.pBegin>=0 && sPreview.pos<=sPreview.pBegin)) {
+        if (s->isLoopable() && sPreview.pos>=s->loopStart) {
+          switch (s->loopMode) {
+            case DivSampleLoopMode::DIV_SAMPLE_LOOP_FORWARD:
+              sPreview.pos=s->loopStart;
+              sPreview.dir=false;
+              break;
+            case DivSampleLoopMode::DIV_SAMPLE_LOOP_BACKWARD:
+              sPreview.pos=s->loopEnd-1;
+              sPreview.dir=true;
+              break;
+            case DivSampleLoopMode::DIV_SAMPLE_LOOP_PINGPONG:
+              sPreview.pos=s->loopStart;
+              sPreview.dir=false;
+              break;
+            default:
+              break;
+          }
+        } else if (sPreview.pos<0) {
+          sPreview.sample=-1;
         }
-        if (--sPreview.posSub<=0) {
-          sPreview.posSub=sPreview.rateMul;
-          if (++sPreview.pos>=wave->len) {
-            sPreview.pos=0;
+      }
+    } else { // forward
+      if (sPreview.pos>=s->loopEnd || (sPreview.pEnd>=0 && sPreview.pos>=sPreview.pEnd)) {
+        if (s->isLoopable() && sPreview.pos>=s->loopStart) {
+          switch (s->loopMode) {
+            case DivSampleLoopMode::DIV_SAMPLE_LOOP_FORWARD:
+              sPreview.pos=s->loopStart;
+              sPreview.dir=false;
+              break;
+            case DivSampleLoopMode::DIV_SAMPLE_LOOP_BACKWARD:
+              sPreview.pos=s->loopEnd-1;
+              sPreview.dir=true;
+              break;
+            case DivSampleLoopMode::DIV_SAMPLE_LOOP_PINGPONG:
+              sPreview.pos=s->loopEnd-1;
+              sPreview.dir=true;
+              break;
+            default:
+              break;
           }
+        } else if (sPreview.pos>=(int)s->samples) {
+          sPreview.sample=-1;
         }
-        blip_add_delta(samp_bb,i,samp_temp-samp_prevSample);
-        samp_prevSample=samp_temp;
       }
     }
+  } else if (sPreview.wave>=0 && sPreview.wave<(int)song.wave.size()) {
+    DivWavetable* wave=song.wave[sPreview.wave];
+    for (size_t i=0; i<prevtotal; i++) {
+      if (wave->max<=0) {
+        samp_temp=0;
+      } else {
+        samp_temp=((MIN(wave->data[sPreview.pos],wave->max)<<14)/wave->max)-8192;
+      }
+      if (--sPreview.posSub<=0) {
+        sPreview.posSub=sPreview.rateMul;
+        if (++sPreview.pos>=wave->len) {
+          sPreview.pos=0;
+        }
+      }
+      samp_bbIn[i]=samp_temp;
+    }
+  }
+
+  // insert all changes at once
+  int sampLast=samp_prevSample;
+  blip_add_deltas(samp_bb,samp_bbIn,prevtotal,&sampLast,&samp_prevSample);
+  blip_end_frame(samp_bb,prevtotal);
+  blip_read_samples(samp_bb,samp_bbOut+samp_bbOff,size-samp_bbOff,0);
+}
+
+void _renderSamplePreview(void* e) {
+  DIV_TRACE_SCOPE("sample preview",NULL);
+  DivEngine* eng=(DivEngine*)e;
+  eng->renderSamplePreview(eng->samp_renderLen);
+}
+
+// this fills the audio buffer and runs tbe engine.
+// called by the audio backend and during audio export.
+void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsigned int size) {
+  DIV_TRACE_SCOPE("nextBuf");
+
+  // debug information
+  lastNBIns=inChans;
+  lastNBOuts=outChans;
+  lastNBSize=size;
+
+  // don't fill a buffer if the size is 0
+  if (!size) {
+    logW("nextBuf called with size 0!");
+    return;
+  }
+  lastLoopPos=-1;
+
+  // clear the output
+  if (out!=NULL) {
+    for (int i=0; i<outChans; i++) {
+      memset(out[i],0,size*sizeof(float));
+    }
+  }
+
+  // per-chip output sets (if the backend has them) follow the main outputs
+  float** chipOut=NULL;
+  int chipOutSets=0;
+  if (out!=NULL && got.auxOutSets>0 && got.outChans>0 && outChans==got.outChans*(1+got.auxOutSets)) {
+    chipOut=&out[got.outChans];
+    chipOutSets=got.auxOutSets;
+    outChans=got.outChans;
+  }
+
+  // check the mutex.
+  // soft-locking happens when synchronizedSoft is called.
+  if (softLocked) {
+    // most soft-locked operations are short, so wait for up to a quarter of
+    // the buffer before giving up and returning silence.
+    int waitMicros=(got.rate>0)?(int)(250000.0*(double)size/got.rate):0;
+    if (!isBusy.try_lock_for(std::chrono::microseconds(waitMicros))) {
+      logV("audio is soft-locked (%d)",softLockCount++);
+      return;
+    }
+  } else {
+    isBusy.lock();
+  }
+  got.bufsize=size;
+
+  // this buffer will be heard after the one which is currently playing
+  midiOutTimed=true;
+  midiOutBufTime=std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count()+(got.rate>0?(double)size/got.rate:0.0);
+
+  // hand queued instrument/wavetable changes to the dispatches
+  applyPendingNotify();
+
+  // take notes and previews from the GUI
+  processLiveInput();
+
+  // this is used to calculate audio load
+  std::chrono::steady_clock::time_point ts_processBegin=std::chrono::steady_clock::now();
+
+  // time spent in each stage (for the profiler)
+  unsigned long long prof[DIV_PROFILE_MAX];
+  unsigned long long profBegin=divProfileNow();
+  unsigned long long profStart=profBegin;
+  memset(prof,0,DIV_PROFILE_MAX*sizeof(unsigned long long));
+
+  // set up the render thread pool (if reserveBuffers() didn't)
+  initRenderPool();
+
+  // allocate oscilloscope buffers if someone is reading them
+  // new dispatches start without them, so this is checked on every buffer
+  if (oscConsumers>0) {
+    setOscBuffersEnabled(true);
+  } else if (oscEnabled) {
+    setOscBuffersEnabled(false);
+  }
 
-    blip_end_frame(samp_bb,prevtotal);
-    blip_read_samples(samp_bb,samp_bbOut+samp_bbOff,size-samp_bbOff,0);
+  // process MIDI input events.
+  // events are placed within the buffer by arrival time, and processed as the buffer is rendered.
+  // if the engine isn't running, they are processed now (the first note may start it).
+  collectMidiIn(size);
+  if (!playing || halted) processMidiIn(size);
+  prof[DIV_PROFILE_MIDI]+=divProfileNow()-profBegin;
+  DIV_TRACE_RECORD("MIDI",NULL,profBegin,divProfileNow());
+  profBegin=divProfileNow();
+  
+  // process sample/wave preview (not during audio export).
+  // if the render pool has threads, this runs alongside the first batch of
+  // dispatch work. MIDI input may start or stop a preview in the middle of
+  // the buffer though, so it's done right away if there is any.
+  bool previewInPool=false;
+  if (((sPreview.sample>=0 && sPreview.sample<(int)song.sample.size()) || (sPreview.wave>=0 && sPreview.wave<(int)song.wave.size())) && !exporting) {
+    if (playing && !halted && renderPool->isThreaded() && midiInEvents.empty()) {
+      samp_renderLen=size;
+      renderPool->push(_renderSamplePreview,this);
+      previewInPool=true;
+    } else {
+      renderSamplePreview(size);
+    }
   } else {
     memset(samp_bbOut,0,size*sizeof(short));
   }
+  prof[DIV_PROFILE_MIX]+=divProfileNow()-profBegin;
 
   // process audio (run the engine)
   bool mustPlay=playing && !halted;
@@ -3085,7 +3384,9 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
       disCont[i].runPos=0;
     }
 
-    // resize the metronome tick buffer if necessary
+    // resize the metronome tick buffer if necessary.
+    // the buffers below are allocated by reserveBuffers(), so this only
+    // happens if the backend suddenly asks for more than it said.
     if (metroTickLen<size) {
       if (metroTick!=NULL) delete[] metroTick;
       metroTick=new unsigned char[size];
@@ -3099,8 +3400,15 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
     // it prevents hangs under extraordinary bug situations
     int attempts=0;
     int runLeftG=size;
+    // number of times the dispatches were stopped at a MIDI input event
+    int midiSlices=0;
+
+    // in tick-decoupled mode, commands are queued per dispatch during this loop.
+    // the dispatches render their whole buffer afterwards (one barrier per buffer).
+    deferCmds=renderTickDecoupled && renderPool->isThreaded();
+
     // run until the buffer is full or we believe the engine stalled
-    while (++attempts<(int)size) {
+    while (++attempts<(int)size+midiSlices) {
       // -1. set bufferPos
       bufferPos=size-runLeftG;
 
@@ -3109,10 +3417,18 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
       // 1. check whether we are done with all buffers
       if (runLeftG<=0) break;
 
+      // process MIDI input events which are due, so the next tick picks them up
+      processMidiIn(bufferPos);
+
       // 2. check whether we gonna tick
       if (cycles<=0) {
         // we have to tick
-        if (nextTick()) {
+        profBegin=divProfileNow();
+        bool looped=nextTick();
+        prof[DIV_PROFILE_TICK]+=divProfileNow()-profBegin;
+        DIV_TRACE_RECORD("nextTick",NULL,profBegin,divProfileNow());
+        if (hashEnabled) hashTick(size-runLeftG);
+        if (looped) {
           /*totalTicks=0;
           totalSeconds=0;*/
           // used by audio export to determine how many samples to write (otherwise it'll add silence at the end)
@@ -3154,90 +3470,80 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
         }
       } else {
         // we don't have to tick yet. run chip dispatches.
+        // stop at the next MIDI input event (if any)
+        int runLeft=runLeftG;
+        if (!midiInEvents.empty()) {
+          int untilEvent=(int)midiInEvents.front().pos-(int)bufferPos;
+          if (untilEvent>0 && untilEvent<runLeft && untilEvent<cycles) {
+            runLeft=untilEvent;
+            midiSlices++;
+          }
+        }
+
         // 3. run MIDI clock
-        int midiTotal=MIN(cycles,runLeftG);
+        int midiTotal=MIN(cycles,runLeft);
+        profBegin=divProfileNow();
         runMidiClock(midiTotal);
 
         // 4. run MIDI timecode
         runMidiTime(midiTotal);
+        prof[DIV_PROFILE_MIDI]+=divProfileNow()-profBegin;
+        DIV_TRACE_RECORD("MIDI clock",NULL,profBegin,divProfileNow());
+        profBegin=divProfileNow();
 
         // 5. tick the clock and fill buffers as needed
         // check which is nearest: a tick or end of audio buffer
-        if (cycles<runLeftG) {
+        if (deferCmds) {
+          // tick-decoupled mode: don't render yet. dispatches will render the whole buffer
+          // after all ticks have been processed.
+          if (cycles<runLeft) {
+            runLeftG-=cycles;
+            cycles=0;
+          } else {
+            cycles-=runLeft;
+            runLeftG-=runLeft;
+          }
+        } else if (cycles<runLeft) {
           // a tick will happen before the buffer ends
           // run until the end of this tick
           for (int i=0; i<song.systemLen; i++) {
             disCont[i].cycles=cycles;
             disCont[i].size=size;
-            renderPool->push([](void* d) {
-              DivDispatchContainer* dc=(DivDispatchContainer*)d;
-
-              int lastAvail=blip_samples_avail(dc->bb[0]);
-              if (lastAvail>0) {
-                if (lastAvail>=dc->cycles) {
-                  dc->flush(dc->runPos,dc->cycles);
-                  dc->runPos+=dc->cycles;
-                  return;
-                } else {
-                  dc->flush(dc->runPos,lastAvail);
-                  dc->runPos+=lastAvail;
-                  dc->cycles-=lastAvail;
-                }
-              }
-              
-              // if the buffer is too small, resize it
-              int total=blip_clocks_needed(dc->bb[0],dc->cycles);
-              if (total>(int)dc->bbInLen) {
-                logD("growing dispatch %p bbIn to %d",(void*)dc,total+256);
-                dc->grow(total+256);
-              }
-              dc->acquire(total);
-              dc->fillBuf(total,dc->runPos,dc->cycles);
-              // advance run position
-              dc->runPos+=dc->cycles;
-            },&disCont[i]);
           }
+          renderPool->pushBatch(_runDispatch1,disCont,song.systemLen);
           renderPool->wait();
           runLeftG-=cycles;
           cycles=0;
         } else {
-          // the buffer will end before a tick happens
-          // run until the end of this audio buffer
-          cycles-=runLeftG;
+          // the buffer (or a MIDI input event) will come before a tick happens
+          // run until then
+          cycles-=runLeft;
           for (int i=0; i<song.systemLen; i++) {
-            disCont[i].cycles=runLeftG;
-            renderPool->push([](void* d) {
-              DivDispatchContainer* dc=(DivDispatchContainer*)d;
-
-              int lastAvail=blip_samples_avail(dc->bb[0]);
-              if (lastAvail>0) {
-                if (lastAvail>=dc->cycles) {
-                  dc->flush(dc->runPos,dc->cycles);
-                  dc->runPos+=dc->cycles;
-                  return;
-                } else {
-                  dc->flush(dc->runPos,lastAvail);
-                  dc->runPos+=lastAvail;
-                  dc->cycles-=lastAvail;
-                }
-              }
-
-              int total=blip_clocks_needed(dc->bb[0],dc->cycles);
-              if (total>(int)dc->bbInLen) {
-                logD("growing dispatch %p bbIn to %d",(void*)dc,total+256);
-                dc->grow(total+256);
-              }
-              dc->acquire(total);
-              dc->fillBuf(total,dc->runPos,dc->cycles);
-            },&disCont[i]);
+            disCont[i].cycles=runLeft;
           }
-          // at this point runLeftG will be zero and we can break out of the loop
-          runLeftG=0;
+          renderPool->pushBatch(_runDispatch1,disCont,song.systemLen);
+          // at this point runLeftG will be zero (unless we stopped at an event)
+          runLeftG-=runLeft;
           renderPool->wait();
         }
+        prof[DIV_PROFILE_DISPATCH]+=divProfileNow()-profBegin;
+        DIV_TRACE_RECORD("dispatch",NULL,profBegin,divProfileNow());
       }
     }
 
+    // render the whole buffer (tick-decoupled mode)
+    if (deferCmds) {
+      deferCmds=false;
+      profBegin=divProfileNow();
+      for (int i=0; i<song.systemLen; i++) {
+        disCont[i].size=size-runLeftG;
+      }
+      renderPool->pushBatch(_runDispatch2,disCont,song.systemLen);
+      renderPool->wait();
+      prof[DIV_PROFILE_DISPATCH]+=divProfileNow()-profBegin;
+      DIV_TRACE_RECORD("dispatch",NULL,profBegin,divProfileNow());
+    }
+
     // complain and stop playback if we believe the engine has stalled
     //logD("attempts: %d",attempts);
     if (attempts>=(int)(size+10)) {
@@ -3249,6 +3555,9 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
     // this is also used by audio export to cut out unnecessary silence after a stop song effect (FFxx)
     totalProcessed=size-runLeftG;
 
+    // don't leave MIDI input events behind (e.g. if playback stopped)
+    processMidiIn(size);
+
     // complain if a dispatch's audio buffer must be flushed and our audio buffer is too small for it
     // this may happen when a chip's output rate is lower than the sample rate
     for (int i=0; i<song.systemLen; i++) {
@@ -3266,7 +3575,14 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
     renderPool->wait();
   }
 
+  // make sure the sample preview is done
+  if (previewInPool) renderPool->wait();
+
+  // hash chip outputs (regression testing)
+  if (mustPlay && hashEnabled && hashResult!=NULL) hashBuffer(totalProcessed);
+
   // process file player
+  profBegin=divProfileNow();
   // resize file player audio buffer if necessary
   if (filePlayerBufLen<size) {
     for (int i=0; i<DIV_MAX_OUTPUTS; i++) {
@@ -3333,6 +3649,11 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
     }
   }
 
+  // peak of each chip output (-1 means not calculated yet)
+  // this is calculated while mixing, or later if the output isn't connected
+  int chipPeakRaw[DIV_MAX_CHIPS][DIV_MAX_OUTPUTS];
+  memset(chipPeakRaw,-1,DIV_MAX_CHIPS*DIV_MAX_OUTPUTS*sizeof(int));
+
   // now mix everything (resolve patchbay)
   for (unsigned int i: song.patchbay) {
     // there are 4096 portsets. each portset may have up to 16 outputs (subports).
@@ -3372,8 +3693,11 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
               break;
           }
 
-          for (size_t j=0; j<size; j++) {
-            out[destSubPort][j]+=((float)disCont[srcPortSet].bbOut[srcSubPort][j]/32768.0)*vol;
+          // convert, scale, accumulate and get the peak in one pass
+          chipPeakRaw[srcPortSet][srcSubPort]=DivMixKernel::mix(out[destSubPort],disCont[srcPortSet].bbOut[srcSubPort],vol,size);
+          // the chip's own output set gets the same
+          if (srcPortSet<chipOutSets) {
+            DivMixKernel::mix(chipOut[srcPortSet*outChans+destSubPort],disCont[srcPortSet].bbOut[srcSubPort],vol,size);
           }
         }
       } else if (srcPortSet==0xffc) {
@@ -3383,9 +3707,7 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
         }
       } else if (srcPortSet==0xffd) {
         // sample preview
-        for (size_t j=0; j<size; j++) {
-          out[destSubPort][j]+=previewVol*(samp_bbOut[j]/32768.0);
-        }
+        DivMixKernel::mix(out[destSubPort],samp_bbOut,previewVol,size);
       } else if (srcPortSet==0xffe && playing && !halted) {
         // metronome
         for (size_t j=0; j<size; j++) {
@@ -3399,14 +3721,49 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
     // nothing/invalid
   }
 
+  // apply master effects
+  for (DivEffectContainer& fx: effectInst) {
+    if (fx.rate!=got.rate) {
+      fx.effect->rateChanged(got.rate);
+      fx.rate=got.rate;
+    }
+    fx.preAcquire(size);
+    // mono output feeds every effect input
+    int fxIns=fx.effect->getInputCount();
+    for (int j=0; j<fxIns; j++) {
+      memcpy(fx.in[j],out[MIN(j,outChans-1)],size*sizeof(float));
+    }
+    fx.acquire(size);
+    int fxOuts=MIN(fx.effect->getOutputCount(),outChans);
+    for (int j=0; j<fxOuts; j++) {
+      if (fx.dryWet>=1.0f) {
+        memcpy(out[j],fx.out[j],size*sizeof(float));
+      } else {
+        for (size_t k=0; k<size; k++) {
+          out[j][k]+=(fx.out[j][k]-out[j][k])*fx.dryWet;
+        }
+      }
+    }
+  }
+
+  prof[DIV_PROFILE_MIX]+=divProfileNow()-profBegin;
+  DIV_TRACE_RECORD("mix",NULL,profBegin,divProfileNow());
+  profBegin=divProfileNow();
+
   // dump to oscillator buffer (a ring buffer)
-  for (unsigned int i=0; i<size; i++) {
-    for (int j=0; j<outChans; j++) {
-      if (oscBuf[j]==NULL) continue;
-      oscBuf[j][oscWritePos]=out[j][i];
+  for (int j=0; j<outChans; j++) {
+    if (oscBuf[j]==NULL) continue;
+    unsigned int pos=oscWritePos;
+    unsigned int done=0;
+    while (done<size) {
+      unsigned int chunk=MIN(size-done,32768-pos);
+      memcpy(&oscBuf[j][pos],&out[j][done],chunk*sizeof(float));
+      done+=chunk;
+      pos+=chunk;
+      if (pos>=32768) pos=0;
     }
-    if (++oscWritePos>=32768) oscWritePos=0;
   }
+  oscWritePos=(oscWritePos+size)&32767;
   oscSize=size;
 
   // get per-chip peaks
@@ -3419,31 +3776,22 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
         if (disCont[i].bbOut[j]==NULL) continue;
         chipPeak[i][j]*=1.0-decay;
         float peak=chipPeak[i][j];
-        for (unsigned int k=0; k<size; k++) {
-          float out=fabs(disCont[i].bbOut[j][k]*song.systemVol[i]*disp->getPostAmp()/32768.0f); // TODO: PARSE PANNING, FRONT/REAR AND PATCHBAY
-          // switch (j) {
-          //   case 0:
-          //     out*=MIN(1.0f,1.0f-song.systemPan[i])*MIN(1.0f,1.0f+song.systemPanFR[i]);
-          //     break;
-          //   case 1:
-          //     out*=MIN(1.0f,1.0f+song.systemPan[i])*MIN(1.0f,1.0f+song.systemPanFR[i]);
-          //     break;
-          //   case 2:
-          //     out*=MIN(1.0f,1.0f-song.systemPan[i])*MIN(1.0f,1.0f-song.systemPanFR[i]);
-          //     break;
-          //   case 3:
-          //     out*=MIN(1.0f,1.0f+song.systemPan[i])*MIN(1.0f,1.0f-song.systemPanFR[i]);
-          //     break;
-          //   default: break;
-          // }
-          if (out>peak) peak=out;
-        }
+        // TODO: PARSE PANNING, FRONT/REAR AND PATCHBAY
+        int peakRaw=chipPeakRaw[i][j];
+        if (peakRaw<0) peakRaw=DivMixKernel::peak(disCont[i].bbOut[j],size);
+        float out=fabs(peakRaw*song.systemVol[i]*disp->getPostAmp()/32768.0f);
+        if (out>peak) peak=out;
         chipPeak[i][j]+=(peak-chipPeak[i][j])*0.9;
       }
     }
   } else {
     memset(chipPeak,0,sizeof(chipPeak));
   }
+  publishVizState();
+  publishRegPools();
+  prof[DIV_PROFILE_OSC]+=divProfileNow()-profBegin;
+  DIV_TRACE_RECORD("oscilloscope",NULL,profBegin,divProfileNow());
+  profBegin=divProfileNow();
 
   // force mono audio (if enabled)
   if (forceMono && outChans>1) {
@@ -3461,17 +3809,23 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
 
   // clamp output (if enabled)
   if (clampSamples) {
-    for (size_t i=0; i<size; i++) {
-      for (int j=0; j<outChans; j++) {
-        if (out[j][i]<-0.9999) out[j][i]=-0.9999;
-        if (out[j][i]>0.9999) out[j][i]=0.9999;
-      }
+    for (int j=0; j<outChans; j++) {
+      DivMixKernel::clamp(out[j],0.9999f,size);
+    }
+    for (int j=0; j<chipOutSets*outChans; j++) {
+      DivMixKernel::clamp(chipOut[j],0.9999f,size);
     }
   }
+  prof[DIV_PROFILE_MIX]+=divProfileNow()-profBegin;
+  DIV_TRACE_RECORD("mix",NULL,profBegin,divProfileNow());
+  prof[DIV_PROFILE_TOTAL]=divProfileNow()-profStart;
+  publishProfile(prof,size);
+  midiOutTimed=false;
   isBusy.unlock();
 
   std::chrono::steady_clock::time_point ts_processEnd=std::chrono::steady_clock::now();
 
   // this is shown in the GUI as audio load
   processTime=std::chrono::duration_cast<std::chrono::nanoseconds>(ts_processEnd-ts_processBegin).count();
+  updateGovernor(size);
 }
@@ -0,0 +1,228 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2026 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// gapless playlist playback.
+// the engine which owns the audio output plays the first song. every other
+// song is loaded by a render worker (with its dispatches initialized and its
+// samples rendered) while the previous one plays, and the start of it is
+// rendered ahead of time. at the end of a song the audio callback switches
+// over to the next worker, optionally crossfading the two.
+
+#include "engine.h"
+#include "../ta-log.h"
+
+// how many buffers of a queued song to render ahead of time
+#define DIV_PLAYLIST_PREROLL 4
+
+void DivEngine::setPlaylistMode(bool enable, int loops, int fadeMs) {
+  if (enable) {
+    if (playlistMode) return;
+    playlistLoops=MAX(loops,1);
+    playlistFadeLen=(got.rate>0 && fadeMs>0)?(unsigned int)((double)fadeMs*got.rate/1000.0):0;
+    playlistFadePos=0;
+    playlistTempLen=MAX(got.bufsize,DIV_RESERVE_BUFSIZE);
+    for (int i=0; i<DIV_MAX_OUTPUTS; i++) {
+      playlistTemp[i]=new float[playlistTempLen];
+    }
+    playlistCur=this;
+    playlistFading=NULL;
+    playlistMode=true;
+    return;
+  }
+
+  if (!playlistMode) return;
+  playlistLock.lock();
+  playlistMode=false;
+  playlistLock.unlock();
+
+  DivEngine* workers[4]={playlistCur.exchange(NULL),playlistFading,playlistNext.exchange(NULL),playlistDone.exchange(NULL)};
+  playlistFading=NULL;
+  for (DivEngine* i: workers) {
+    if (i==NULL || i==this) continue;
+    i->quit(false);
+    delete i;
+  }
+  freePlaylistBuffers();
+}
+
+bool DivEngine::queuePlaylistNext(DivEngine* next) {
+  if (next==NULL) return false;
+  if (playlistNext.load()!=NULL) return false;
+
+  unsigned int block=MAX(got.bufsize,1);
+  int chans=MIN(got.outChans,DIV_MAX_OUTPUTS);
+  float* chunk[DIV_MAX_OUTPUTS];
+  next->freePlaylistBuffers();
+  next->playlistPrerollLen=block*DIV_PLAYLIST_PREROLL;
+  next->playlistPrerollPos=0;
+  next->playlistPrerollChans=chans;
+  for (int i=0; i<chans; i++) {
+    next->playlistPreroll[i]=new float[next->playlistPrerollLen];
+  }
+  for (unsigned int pos=0; pos<next->playlistPrerollLen; pos+=block) {
+    for (int i=0; i<chans; i++) {
+      chunk[i]=next->playlistPreroll[i]+pos;
+    }
+    next->nextBuf(NULL,chunk,0,chans,MIN(block,next->playlistPrerollLen-pos));
+  }
+
+  playlistNext=next;
+  return true;
+}
+
+bool DivEngine::isPlaylistNextQueued() {
+  return playlistNext.load()!=NULL;
+}
+
+DivEngine* DivEngine::takePlaylistDone() {
+  return playlistDone.exchange(NULL);
+}
+
+DivEngine* DivEngine::getPlaylistCurrent() {
+  if (!playlistMode) return this;
+  DivEngine* ret=playlistCur.load();
+  return (ret==NULL)?this:ret;
+}
+
+void DivEngine::freePlaylistBuffers() {
+  for (int i=0; i<DIV_MAX_OUTPUTS; i++) {
+    if (playlistTemp[i]!=NULL) {
+      delete[] playlistTemp[i];
+      playlistTemp[i]=NULL;
+    }
+    if (playlistPreroll[i]!=NULL) {
+      delete[] playlistPreroll[i];
+      playlistPreroll[i]=NULL;
+    }
+  }
+  playlistTempLen=0;
+  playlistPrerollLen=0;
+  playlistPrerollPos=0;
+  playlistPrerollChans=0;
+}
+
+int DivEngine::playlistRender(float** out, int outChans, unsigned int size) {
+  unsigned int pos=0;
+  if (playlistPrerollPos<playlistPrerollLen) {
+    pos=MIN(size,playlistPrerollLen-playlistPrerollPos);
+    for (int i=0; i<outChans; i++) {
+      if (i<playlistPrerollChans) {
+        memcpy(out[i],&playlistPreroll[i][playlistPrerollPos],pos*sizeof(float));
+      } else {
+        memset(out[i],0,pos*sizeof(float));
+      }
+    }
+    playlistPrerollPos+=pos;
+  }
+  if (pos>=size) return -1;
+
+  float* rest[DIV_MAX_OUTPUTS];
+  for (int i=0; i<outChans; i++) {
+    rest[i]=out[i]+pos;
+  }
+  nextBuf(NULL,rest,0,outChans,size-pos);
+  return (lastLoopPos<0)?-1:(lastLoopPos+(int)pos);
+}
+
+void DivEngine::playlistBuf(float** out, int outChans, unsigned int size) {
+  std::lock_guard<std::mutex> guard(playlistLock);
+  int chans=MIN(outChans,DIV_MAX_OUTPUTS);
+  for (int i=chans; i<outChans; i++) {
+    memset(out[i],0,size*sizeof(float));
+  }
+  if (!playlistMode) {
+    for (int i=0; i<chans; i++) {
+      memset(out[i],0,size*sizeof(float));
+    }
+    return;
+  }
+
+  float* o[DIV_MAX_OUTPUTS];
+  unsigned int pos=0;
+  while (pos<size) {
+    unsigned int n=MIN(size-pos,playlistTempLen);
+    for (int i=0; i<chans; i++) {
+      o[i]=out[i]+pos;
+    }
+    DivEngine* cur=playlistCur.load();
+    int loopPos=cur->playlistRender(o,chans,n);
+
+    if (playlistFading!=NULL) {
+      // out has the new song and playlistTemp the old one
+      playlistFading->playlistRender(playlistTemp,chans,n);
+      for (unsigned int j=0; j<n && playlistFadePos<playlistFadeLen; j++) {
+        float vol=(float)playlistFadePos/(float)playlistFadeLen;
+        for (int i=0; i<chans; i++) {
+          o[i][j]=o[i][j]*vol+playlistTemp[i][j]*(1.0f-vol);
+        }
+        playlistFadePos++;
+      }
+      if (playlistFadePos>=playlistFadeLen) {
+        if (playlistFading!=this) playlistDone=playlistFading;
+        playlistFading=NULL;
+      }
+      pos+=n;
+      continue;
+    }
+
+    // switch to the next song once this one ends
+    int endPos=-1;
+    if (loopPos>=0 && cur->totalLoops>=playlistLoops) {
+      endPos=loopPos;
+    } else if (!cur->playing) {
+      endPos=n;
+    }
+    if (endPos>=0 && playlistNext.load()!=NULL && playlistDone.load()==NULL) {
+      DivEngine* next=playlistNext.exchange(NULL);
+      bool fade=(playlistFadeLen>0 && cur->playing);
+      playlistCur=next;
+      logI("playlist: next song.");
+
+      if (endPos<(int)n) {
+        float* rest[DIV_MAX_OUTPUTS];
+        for (int i=0; i<chans; i++) {
+          rest[i]=o[i]+endPos;
+        }
+        if (fade) {
+          // the old song keeps playing (from its loop) and fades out
+          next->playlistRender(playlistTemp,chans,n-endPos);
+          playlistFadePos=0;
+          for (unsigned int j=0; j<n-endPos; j++) {
+            float vol=(playlistFadePos<playlistFadeLen)?((float)playlistFadePos/(float)playlistFadeLen):1.0f;
+            for (int i=0; i<chans; i++) {
+              rest[i][j]=rest[i][j]*(1.0f-vol)+playlistTemp[i][j]*vol;
+            }
+            if (playlistFadePos<playlistFadeLen) playlistFadePos++;
+          }
+        } else {
+          next->playlistRender(rest,chans,n-endPos);
+        }
+      } else {
+        playlistFadePos=0;
+      }
+
+      if (fade && playlistFadePos<playlistFadeLen) {
+        playlistFading=cur;
+      } else if (cur!=this) {
+        playlistDone=cur;
+      }
+    }
+    pos+=n;
+  }
+}
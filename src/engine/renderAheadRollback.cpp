@@ -0,0 +1,163 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2026 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// speculative render-ahead.
+// the render-ahead thread stores the engine state at the start of every block
+// it renders. when the song is edited (or a channel is muted), it goes back to
+// the first block which the audio callback hasn't reached yet and renders
+// everything after it again, so that the edit is heard after about two
+// buffers instead of after the whole render-ahead buffer.
+
+#include "engine.h"
+#include "../ta-log.h"
+
+void DivEngine::requestRenderAheadRollback() {
+  if (!renderAheadRollbackOn) return;
+  renderAheadRollbackPending=true;
+}
+
+void DivEngine::freeRenderAheadSnapshot(DivRenderAheadSnapshot* snap) {
+  for (int i=0; i<snap->play.dispCount; i++) {
+    disCont[i].dispatch->freeState(snap->play.dispState[i]);
+    disCont[i].freeState(snap->cont[i]);
+  }
+  delete snap;
+}
+
+void DivEngine::clearRenderAheadSnapshots() {
+  for (DivRenderAheadSnapshot* i: renderAheadSnaps) {
+    freeRenderAheadSnapshot(i);
+  }
+  renderAheadSnaps.clear();
+}
+
+void DivEngine::captureRenderAheadSnapshot(size_t pos) {
+  isBusy.lock();
+  unsigned int epoch=renderAheadEpoch;
+
+  // drop the ones which have been played (or are from another epoch)
+  size_t readPos=renderAheadReadPos.load(std::memory_order_acquire);
+  while (!renderAheadSnaps.empty()) {
+    DivRenderAheadSnapshot* i=renderAheadSnaps.front();
+    if (i->pos>=readPos && i->epoch==epoch) break;
+    freeRenderAheadSnapshot(i);
+    renderAheadSnaps.pop_front();
+  }
+
+  // rendering again must not be heard (or seen) in any other way.
+  // effects and the file player have their own state, and previews would skip.
+  bool possible=(playing && curSubSong!=NULL && effectInst.empty() && !cmdStreamEnabled && pendingNotes.empty());
+  if (sPreview.sample>=0 || sPreview.wave>=0) possible=false;
+  if (curFilePlayer!=NULL) {
+    if (curFilePlayer->getActive()) possible=false;
+  }
+  if (output) if (output->midiOut!=NULL) {
+    if (output->midiOut->isDeviceOpen()) possible=false;
+  }
+  if (!possible) {
+    clearRenderAheadSnapshots();
+    isBusy.unlock();
+    return;
+  }
+
+  // only possible if every dispatch supports state saves
+  DivRenderAheadSnapshot* snap=new DivRenderAheadSnapshot;
+  for (int i=0; i<song.systemLen; i++) {
+    snap->play.dispState[i]=disCont[i].dispatch->getState();
+    if (snap->play.dispState[i]==NULL) {
+      freeRenderAheadSnapshot(snap);
+      clearRenderAheadSnapshots();
+      isBusy.unlock();
+      return;
+    }
+    snap->play.dispCount=i+1;
+    if (!disCont[i].saveState(snap->cont[i])) {
+      freeRenderAheadSnapshot(snap);
+      clearRenderAheadSnapshots();
+      isBusy.unlock();
+      return;
+    }
+  }
+
+  snap->pos=pos;
+  snap->epoch=epoch;
+  fillSnapshot(&snap->play);
+  snap->playing=playing;
+  snap->freelance=freelance;
+  snap->remainingLoops=remainingLoops;
+  snap->metroFreq=metroFreq;
+  snap->metroPos=metroPos;
+  snap->metroAmp=metroAmp;
+  renderAheadSnaps.push_back(snap);
+  isBusy.unlock();
+}
+
+bool DivEngine::rollbackRenderAhead() {
+  isBusy.lock();
+  unsigned int epoch=renderAheadEpoch;
+  size_t readPos=renderAheadReadPos.load(std::memory_order_acquire);
+  size_t writePos=renderAheadWritePos.load(std::memory_order_relaxed);
+  // leave some room for the audio callback, which may be copying a block
+  // right now
+  size_t safePos=readPos+2*renderAheadBlock;
+
+  while (!renderAheadSnaps.empty()) {
+    DivRenderAheadSnapshot* i=renderAheadSnaps.front();
+    if (i->pos>=safePos && i->epoch==epoch) break;
+    freeRenderAheadSnapshot(i);
+    renderAheadSnaps.pop_front();
+  }
+  if (renderAheadSnaps.empty()) {
+    isBusy.unlock();
+    return false;
+  }
+  DivRenderAheadSnapshot* snap=renderAheadSnaps.front();
+  if (snap->pos>=writePos) {
+    // nothing was rendered after it
+    isBusy.unlock();
+    return false;
+  }
+
+  // take the queued audio away from the audio callback first
+  renderAheadWritePos.store(snap->pos,std::memory_order_release);
+  if (renderAheadReadPos.load(std::memory_order_acquire)>snap->pos) {
+    // it got there first
+    renderAheadWritePos.store(writePos,std::memory_order_release);
+    isBusy.unlock();
+    return false;
+  }
+
+  restoreSnapshot(&snap->play);
+  playing=snap->playing;
+  freelance=snap->freelance;
+  remainingLoops=snap->remainingLoops;
+  metroFreq=snap->metroFreq;
+  metroPos=snap->metroPos;
+  metroAmp=snap->metroAmp;
+  for (int i=0; i<snap->play.dispCount; i++) {
+    disCont[i].restoreState(snap->cont[i]);
+  }
+  logV("render-ahead: rendering %d frames again",(int)(writePos-snap->pos));
+  renderAheadRollbacks++;
+
+  // the following blocks will be rendered (and saved) again
+  clearRenderAheadSnapshots();
+  isBusy.unlock();
+  return true;
+}
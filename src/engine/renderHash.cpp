@@ -0,0 +1,122 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2026 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// in-memory render with a hash of every chip's output, for regression tests.
+// the hash is 64-bit FNV-1a over the 16-bit output samples of a chip
+// (interleaved if it has more than one output).
+
+#include "engine.h"
+#include "../ta-log.h"
+
+#define HASH_BUFSIZE 2048
+#define HASH_BASIS 0xcbf29ce484222325ULL
+#define HASH_PRIME 0x100000001b3ULL
+
+void DivEngine::hashTick(unsigned int pos) {
+  if (hashSegmentTicks>0 && (hashTicks%hashSegmentTicks)==0) {
+    hashMarks.push_back(HashMark(pos,hashTicks,prevOrder,prevRow));
+  }
+  hashTicks++;
+}
+
+void DivEngine::hashBuffer(unsigned int len) {
+  unsigned int pos=0;
+  size_t mark=0;
+  while (true) {
+    unsigned int end=len;
+    if (mark<hashMarks.size() && hashMarks[mark].pos<len) end=hashMarks[mark].pos;
+    if (end>pos) {
+      for (int i=0; i<song.systemLen; i++) {
+        if (disCont[i].dispatch==NULL) continue;
+        int outs=MIN(disCont[i].dispatch->getOutputCount(),DIV_MAX_OUTPUTS);
+        unsigned long long h=hashSegment.hash[i];
+        unsigned long long t=hashResult->total[i];
+        for (unsigned int j=pos; j<end; j++) {
+          for (int k=0; k<outs; k++) {
+            if (disCont[i].bbOut[k]==NULL) continue;
+            unsigned short s=disCont[i].bbOut[k][j];
+            h=(h^(s&0xff))*HASH_PRIME;
+            h=(h^(s>>8))*HASH_PRIME;
+            t=(t^(s&0xff))*HASH_PRIME;
+            t=(t^(s>>8))*HASH_PRIME;
+          }
+        }
+        hashSegment.hash[i]=h;
+        hashResult->total[i]=t;
+      }
+      pos=end;
+    }
+    if (mark>=hashMarks.size()) break;
+
+    // begin a new segment
+    HashMark& m=hashMarks[mark++];
+    if (m.tick>0) hashResult->segments.push_back(hashSegment);
+    hashSegment.tick=m.tick;
+    hashSegment.order=m.order;
+    hashSegment.row=m.row;
+    for (int i=0; i<DIV_MAX_CHIPS; i++) {
+      hashSegment.hash[i]=HASH_BASIS;
+    }
+  }
+  hashMarks.clear();
+  hashResult->samples+=len;
+}
+
+bool DivEngine::renderHash(DivRenderHash& result, int loops, int segmentTicks) {
+  if (!active) {
+    lastError="engine is not active";
+    return false;
+  }
+
+  result=DivRenderHash();
+  result.chips=song.systemLen;
+  for (int i=0; i<DIV_MAX_CHIPS; i++) {
+    result.total[i]=HASH_BASIS;
+    hashSegment.hash[i]=HASH_BASIS;
+  }
+  hashSegment.tick=0;
+  hashSegment.order=0;
+  hashSegment.row=0;
+  hashResult=&result;
+  hashSegmentTicks=MAX(segmentTicks,0);
+  hashTicks=0;
+  hashMarks.clear();
+
+  int outChans=MAX(MIN(got.outChans,DIV_MAX_OUTPUTS),1);
+  float* outBuf[DIV_MAX_OUTPUTS];
+  for (int i=0; i<outChans; i++) {
+    outBuf[i]=new float[HASH_BUFSIZE];
+  }
+
+  startOffline(loops);
+  hashEnabled=true;
+  while (playing) {
+    nextBuf(NULL,outBuf,0,outChans,HASH_BUFSIZE);
+  }
+  hashEnabled=false;
+
+  if (hashSegmentTicks>0) result.segments.push_back(hashSegment);
+  result.ticks=hashTicks;
+  hashResult=NULL;
+
+  for (int i=0; i<outChans; i++) {
+    delete[] outBuf[i];
+  }
+  return true;
+}
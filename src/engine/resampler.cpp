@@ -0,0 +1,231 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2026 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "resampler.h"
+#include "../ta-log.h"
+#include <math.h>
+#include <string.h>
+
+// don't compact the output buffer until this many samples were read
+#define OUT_COMPACT_THRESHOLD 4096
+
+// run one input sample through the decimator.
+// every `decim` samples an output is appended to mid.
+#define DECIMATE(_x) \
+  integ[0]+=(uint64_t)(int64_t)(_x); \
+  for (int _k=1; _k<DIV_RESAMPLER_CIC_ORDER; _k++) integ[_k]+=integ[_k-1]; \
+  if (++decimPos>=decim) { \
+    decimPos=0; \
+    uint64_t _v=integ[DIV_RESAMPLER_CIC_ORDER-1]; \
+    for (int _k=0; _k<DIV_RESAMPLER_CIC_ORDER; _k++) { \
+      uint64_t _t=_v; \
+      _v-=comb[_k]; \
+      comb[_k]=_t; \
+    } \
+    mid.push_back((float)(int64_t)_v*decimGain); \
+  }
+
+void DivResampler::rebuild() {
+  double ratio=inRate/outRate;
+
+  // decimate down to 2-4x the output rate
+  decim=(ratio>=4.0)?(unsigned int)(ratio/2.0):1;
+  double midRate=inRate/decim;
+  step=(uint64_t)((midRate/outRate)*4294967296.0);
+  decimGain=(float)(1.0/pow((double)decim,DIV_RESAMPLER_CIC_ORDER));
+
+  // the stopband begins where aliases would fold back into the passband
+  double passEdge=(lowQuality?0.30:0.42)*outRate;
+  double stopEdge=outRate-passEdge;
+  double cutoff=0.5*(passEdge+stopEdge)/midRate;
+
+  // Blackman window: transition width is about 5.5/taps
+  taps=(unsigned int)ceil(5.5*midRate/(stopEdge-passEdge));
+  taps=(taps+3)&(~3);
+  if (taps<8) taps=8;
+
+  coefs.resize((size_t)taps*DIV_RESAMPLER_PHASES);
+  double half=taps*0.5;
+  for (int p=0; p<DIV_RESAMPLER_PHASES; p++) {
+    float* c=&coefs[(size_t)p*taps];
+    double frac=(double)p/DIV_RESAMPLER_PHASES;
+    double sum=0.0;
+    for (unsigned int k=0; k<taps; k++) {
+      double d=(double)k-half-frac;
+      double x=2.0*cutoff*d;
+      double sinc=(fabs(x)<1e-9)?1.0:sin(M_PI*x)/(M_PI*x);
+      double w=0.0;
+      if (fabs(d)<half) {
+        w=0.42+0.5*cos(M_PI*d/half)+0.08*cos(2.0*M_PI*d/half);
+      }
+      c[k]=(float)(sinc*w);
+      sum+=c[k];
+    }
+    if (sum!=0.0) {
+      for (unsigned int k=0; k<taps; k++) {
+        c[k]=(float)(c[k]/sum);
+      }
+    }
+  }
+
+  logV("resampler: %g -> %g (decimate by %d, %d taps)",inRate,outRate,decim,taps);
+}
+
+void DivResampler::produce() {
+  size_t n=mid.size();
+  const float* m=mid.data();
+  while ((size_t)(pos>>32)+taps<=n) {
+    const float* src=&m[pos>>32];
+    const float* c=&coefs[(size_t)((pos>>24)&(DIV_RESAMPLER_PHASES-1))*taps];
+
+    // four accumulators, so that the loop can be vectorized
+    float acc0=0.0f, acc1=0.0f, acc2=0.0f, acc3=0.0f;
+    for (unsigned int k=0; k<taps; k+=4) {
+      acc0+=src[k]*c[k];
+      acc1+=src[k+1]*c[k+1];
+      acc2+=src[k+2]*c[k+2];
+      acc3+=src[k+3]*c[k+3];
+    }
+    float val=(acc0+acc1)+(acc2+acc3);
+
+    if (hiPass) {
+      dcLevel+=(val-dcLevel)*(1.0f/512.0f);
+      val-=dcLevel;
+    }
+    if (val<-32768.0f) val=-32768.0f;
+    if (val>32767.0f) val=32767.0f;
+    outBuf.push_back((short)val);
+    pos+=step;
+  }
+
+  // drop samples which won't be used anymore
+  size_t drop=pos>>32;
+  if (drop>n) drop=n;
+  if (drop>0) {
+    mid.erase(mid.begin(),mid.begin()+drop);
+    pos-=(uint64_t)drop<<32;
+  }
+}
+
+void DivResampler::setRates(double in, double out) {
+  if (in<=0.0 || out<=0.0) return;
+  if (in==inRate && out==outRate && !coefs.empty()) return;
+  inRate=in;
+  outRate=out;
+  rebuild();
+  clear();
+}
+
+void DivResampler::setQuality(bool lowQual) {
+  if (lowQual==lowQuality) return;
+  lowQuality=lowQual;
+  if (!coefs.empty()) {
+    rebuild();
+    clear();
+  }
+}
+
+void DivResampler::setHighPass(bool enable) {
+  hiPass=enable;
+}
+
+void DivResampler::setDCLevel(short level) {
+  clear();
+  // settle the decimator as if the input had been at this level forever
+  for (unsigned int i=0; i<(DIV_RESAMPLER_CIC_ORDER+1)*decim; i++) {
+    DECIMATE(level);
+  }
+  mid.assign(taps/2,(float)level);
+  dcLevel=level;
+}
+
+void DivResampler::clear() {
+  memset(integ,0,sizeof(integ));
+  memset(comb,0,sizeof(comb));
+  decimPos=0;
+  // half a filter of history, so that there's no extra delay
+  mid.assign(taps/2,0.0f);
+  pos=0;
+  outBuf.clear();
+  outPos=0;
+  dcLevel=0.0f;
+}
+
+size_t DivResampler::inputNeeded(size_t count) {
+  size_t avail=samplesAvail();
+  if (count<=avail) return 0;
+  uint64_t last=pos+(uint64_t)(count-avail-1)*step;
+  size_t midNeeded=(size_t)(last>>32)+taps;
+  if (midNeeded<=mid.size()) return 0;
+  return (midNeeded-mid.size())*decim-decimPos;
+}
+
+size_t DivResampler::samplesAvail() {
+  return outBuf.size()-outPos;
+}
+
+void DivResampler::write(const short* in, size_t len) {
+  for (size_t i=0; i<len; i++) {
+    DECIMATE(in[i]);
+  }
+  produce();
+}
+
+void DivResampler::reserve(size_t count) {
+  if (step==0) return;
+  size_t midNeeded=(size_t)(((uint64_t)(count+1)*step)>>32)+taps*2+DIV_RESAMPLER_CIC_ORDER;
+  if (mid.capacity()<midNeeded) mid.reserve(midNeeded);
+  // read() only compacts after OUT_COMPACT_THRESHOLD samples were read
+  size_t outNeeded=OUT_COMPACT_THRESHOLD+count*2;
+  if (outBuf.capacity()<outNeeded) outBuf.reserve(outNeeded);
+}
+
+size_t DivResampler::read(short* out, size_t count) {
+  size_t avail=samplesAvail();
+  if (count>avail) count=avail;
+  if (count>0) {
+    memcpy(out,&outBuf[outPos],count*sizeof(short));
+    outPos+=count;
+  }
+  if (outPos>=outBuf.size()) {
+    outBuf.clear();
+    outPos=0;
+  } else if (outPos>=OUT_COMPACT_THRESHOLD) {
+    outBuf.erase(outBuf.begin(),outBuf.begin()+outPos);
+    outPos=0;
+  }
+  return count;
+}
+
+DivResampler::DivResampler():
+  inRate(0.0),
+  outRate(0.0),
+  lowQuality(false),
+  hiPass(true),
+  decim(1),
+  decimPos(0),
+  decimGain(1.0f),
+  taps(8),
+  pos(0),
+  step((uint64_t)1<<32),
+  outPos(0),
+  dcLevel(0.0f) {
+  memset(integ,0,sizeof(integ));
+  memset(comb,0,sizeof(comb));
+}
@@ -0,0 +1,127 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2026 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _RESAMPLER_H
+#define _RESAMPLER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// chips must run at least this many times faster than the output rate
+// for the polyphase resampler to be used instead of blip_buf.
+#define DIV_RESAMPLER_MIN_RATIO 8.0
+
+// number of filter phases in the polyphase stage
+#define DIV_RESAMPLER_PHASES 256
+
+// number of integrator/comb stages in the decimator
+#define DIV_RESAMPLER_CIC_ORDER 4
+
+/**
+ * a downsampler for chips which run much faster than the output rate.
+ * it has two stages:
+ * - a CIC decimator by an integer factor, which brings the rate down to 2-4x the output rate
+ * - a polyphase windowed-sinc FIR filter which resamples to the output rate
+ * unlike blip_buf, its cost depends on the output rate rather than on the number of changes
+ * in the input, and the filter loop can be vectorized.
+ */
+class DivResampler {
+  double inRate, outRate;
+  bool lowQuality, hiPass;
+
+  // decimator
+  unsigned int decim, decimPos;
+  uint64_t integ[DIV_RESAMPLER_CIC_ORDER];
+  uint64_t comb[DIV_RESAMPLER_CIC_ORDER];
+  float decimGain;
+
+  // polyphase filter
+  unsigned int taps;
+  std::vector<float> coefs;
+  std::vector<float> mid;
+  // position of the next output in mid (32.32 fixed point)
+  uint64_t pos, step;
+
+  // output
+  std::vector<short> outBuf;
+  size_t outPos;
+  float dcLevel;
+
+  void rebuild();
+  void produce();
+
+  public:
+    /**
+     * set the input and output rates.
+     * this clears the resampler.
+     */
+    void setRates(double in, double out);
+
+    /**
+     * set the filter quality (fewer taps in low quality).
+     */
+    void setQuality(bool lowQual);
+
+    /**
+     * enable or disable the DC offset filter.
+     */
+    void setHighPass(bool enable);
+
+    /**
+     * set the DC level, so that the next sample doesn't cause a jump.
+     */
+    void setDCLevel(short level);
+
+    /**
+     * clear all buffered samples and filter state.
+     */
+    void clear();
+
+    /**
+     * get the number of input samples needed to make `count` output samples available.
+     */
+    size_t inputNeeded(size_t count);
+
+    /**
+     * get the number of output samples available for reading.
+     */
+    size_t samplesAvail();
+
+    /**
+     * feed input samples.
+     */
+    void write(const short* in, size_t len);
+
+    /**
+     * read and remove up to `count` output samples.
+     * @return the number of samples read.
+     */
+    size_t read(short* out, size_t count);
+
+    /**
+     * allocate space for reading up to `count` samples at once, so that
+     * write() and read() don't have to.
+     */
+    void reserve(size_t count);
+
+    DivResampler();
+};
+
+#endif
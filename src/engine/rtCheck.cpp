@@ -0,0 +1,148 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2026 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// replaces the global operator new and delete in order to catch heap
+// allocations on the audio thread.
+// only operator new is trapped. C allocations (malloc()) aren't.
+
+#include "rtCheck.h"
+#include "../ta-log.h"
+#include <atomic>
+#include <new>
+#include <stdlib.h>
+
+static thread_local int rtDepth=0;
+static thread_local bool rtReporting=false;
+static thread_local unsigned int rtAllocs=0;
+static thread_local unsigned int rtFrees=0;
+static std::atomic<unsigned int> rtTotal(0);
+static std::atomic<unsigned long long> allocCount(0);
+static std::atomic<unsigned long long> allocBytes(0);
+static const bool rtAbort=(getenv("FURNACE_RT_ABORT")!=NULL);
+
+static inline void countAlloc(size_t size) {
+  allocCount.fetch_add(1,std::memory_order_relaxed);
+  allocBytes.fetch_add(size,std::memory_order_relaxed);
+}
+
+static inline void rtCheck(bool isAlloc) {
+  if (rtDepth<=0 || rtReporting) return;
+  if (isAlloc) {
+    rtAllocs++;
+  } else {
+    rtFrees++;
+  }
+  rtTotal.fetch_add(1,std::memory_order_relaxed);
+  if (rtAbort) {
+    rtReporting=true;
+    logE("RT check: heap %s on the audio thread!",isAlloc?"allocation":"free");
+    abort();
+  }
+}
+
+void divRTEnter() {
+  if (rtDepth++==0) {
+    rtAllocs=0;
+    rtFrees=0;
+  }
+}
+
+void divRTLeave() {
+  if (--rtDepth>0) return;
+  rtDepth=0;
+  if (rtAllocs>0 || rtFrees>0) {
+    // logging doesn't allocate, but don't count it in case it ever does
+    rtReporting=true;
+    logW("RT check: %d allocations and %d frees on the audio thread! (%d in total)",rtAllocs,rtFrees,rtTotal.load(std::memory_order_relaxed));
+    rtReporting=false;
+  }
+}
+
+unsigned int divRTViolations() {
+  return rtTotal.load(std::memory_order_relaxed);
+}
+
+void divAllocStats(unsigned long long& count, unsigned long long& bytes) {
+  count=allocCount.load(std::memory_order_relaxed);
+  bytes=allocBytes.load(std::memory_order_relaxed);
+}
+
+void* operator new(size_t size) {
+  rtCheck(true);
+  countAlloc(size);
+  void* ret=malloc(size?size:1);
+  if (ret==NULL) throw std::bad_alloc();
+  return ret;
+}
+
+void* operator new[](size_t size) {
+  rtCheck(true);
+  countAlloc(size);
+  void* ret=malloc(size?size:1);
+  if (ret==NULL) throw std::bad_alloc();
+  return ret;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  rtCheck(true);
+  countAlloc(size);
+  return malloc(size?size:1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+  rtCheck(true);
+  countAlloc(size);
+  return malloc(size?size:1);
+}
+
+void operator delete(void* ptr) noexcept {
+  if (ptr==NULL) return;
+  rtCheck(false);
+  free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+  if (ptr==NULL) return;
+  rtCheck(false);
+  free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+  if (ptr==NULL) return;
+  rtCheck(false);
+  free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+  if (ptr==NULL) return;
+  rtCheck(false);
+  free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+  if (ptr==NULL) return;
+  rtCheck(false);
+  free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+  if (ptr==NULL) return;
+  rtCheck(false);
+  free(ptr);
+}
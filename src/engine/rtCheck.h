@@ -0,0 +1,52 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2026 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _RTCHECK_H
+#define _RTCHECK_H
+
+// real-time safety checking (for debugging).
+// when built with DIV_RT_CHECK (the WITH_RT_CHECK CMake option), heap
+// allocations made by threads inside a real-time section (the audio
+// callback) are counted and reported in the log.
+// set the FURNACE_RT_ABORT environment variable to abort on the first one
+// instead, in order to get a backtrace.
+
+#ifdef DIV_RT_CHECK
+void divRTEnter();
+void divRTLeave();
+// total number of allocations (and frees) found in real-time sections.
+unsigned int divRTViolations();
+// number of allocations and allocated bytes since the program started (in all threads).
+void divAllocStats(unsigned long long& count, unsigned long long& bytes);
+
+struct DivRTSection {
+  DivRTSection() {
+    divRTEnter();
+  }
+  ~DivRTSection() {
+    divRTLeave();
+  }
+};
+
+#define DIV_RT_SECTION DivRTSection _rtSection
+#else
+#define DIV_RT_SECTION
+#endif
+
+#endif
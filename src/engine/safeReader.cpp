@@ -67,6 +67,14 @@ int SafeReader::read(void* where, size_t count) {
   return count;
 }
 
+SafeReader SafeReader::slice(size_t count) {
+  if (curSeek+count>len) throw EndOfFileException(this,len);
+  if (curSeek+count<curSeek) throw EndOfFileException(this,len);
+  SafeReader ret=SafeReader(&buf[curSeek],count);
+  curSeek+=count;
+  return ret;
+}
+
 signed char SafeReader::readC() {
 #ifdef READ_DEBUG
   logD("SR: reading char %x:",curSeek);
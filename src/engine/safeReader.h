@@ -53,6 +53,19 @@ class SafeReader {
 
   size_t curSeek;
 
+  // reverse the byte order of each value
+  template<typename T> static void swapArray(T* where, size_t count) {
+    unsigned char* b=(unsigned char*)where;
+    for (size_t i=0; i<count; i++) {
+      for (size_t j=0; j<sizeof(T)/2; j++) {
+        unsigned char t=b[j];
+        b[j]=b[sizeof(T)-1-j];
+        b[sizeof(T)-1-j]=t;
+      }
+      b+=sizeof(T);
+    }
+  }
+
   public:
     bool seek(ssize_t where, int whence);
     size_t tell();
@@ -60,6 +73,33 @@ class SafeReader {
 
     int read(void* where, size_t count);
 
+    /**
+     * read an array of numbers, converting them from the specified byte order.
+     * unlike the other functions, this one doesn't throw on end of file.
+     * @return the number of values read, which is less than count if the end
+     * of the file was reached.
+     */
+    template<typename T> size_t readArray(T* where, size_t count, Endianness endian=LittleEndian) {
+      size_t avail=(len-curSeek)/sizeof(T);
+      if (count>avail) count=avail;
+      if (count==0) return 0;
+      memcpy(where,&buf[curSeek],count*sizeof(T));
+      curSeek+=count*sizeof(T);
+#ifdef TA_BIG_ENDIAN
+      if (endian==LittleEndian && sizeof(T)>1) swapArray(where,count);
+#else
+      if (endian==BigEndian && sizeof(T)>1) swapArray(where,count);
+#endif
+      return count;
+    }
+
+    /**
+     * get a reader over the next count bytes and skip them.
+     * the data is not copied.
+     * this function may throw EndOfFileException.
+     */
+    SafeReader slice(size_t count);
+
     // these functions may throw EndOfFileException.
     signed char readC();
     short readS();
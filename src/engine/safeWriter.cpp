@@ -28,7 +28,12 @@ unsigned char* SafeWriter::getFinalBuf() {
 
 void SafeWriter::checkSize(size_t amount) {
   while ((curSeek+amount)>=bufLen) {
+    // grow by half of the current size at least, so that writing a large file
+    // doesn't copy the whole buffer on every block
     size_t newSize=WRITER_BUF_SIZE*(1+((curSeek+amount)/WRITER_BUF_SIZE));
+    if (newSize<bufLen+(bufLen>>1)) {
+      newSize=WRITER_BUF_SIZE*(1+((bufLen+(bufLen>>1))/WRITER_BUF_SIZE));
+    }
     if (newSize<(bufLen+WRITER_BUF_SIZE)) {
       logE("REPORT NOW: newSize is too small! case 1... %d<%d",(int)newSize,(int)(bufLen+WRITER_BUF_SIZE));
     }
@@ -43,6 +48,17 @@ void SafeWriter::checkSize(size_t amount) {
   }
 }
 
+void SafeWriter::reserve(size_t amount) {
+  if (!operative) return;
+  if ((curSeek+amount)<bufLen) return;
+  size_t newSize=WRITER_BUF_SIZE*(1+((curSeek+amount)/WRITER_BUF_SIZE));
+  unsigned char* newBuf=new unsigned char[newSize];
+  memcpy(newBuf,buf,bufLen);
+  delete[] buf;
+  buf=newBuf;
+  bufLen=newSize;
+}
+
 bool SafeWriter::seek(ssize_t where, int whence) {
   ssize_t supposed;
   switch (whence) {
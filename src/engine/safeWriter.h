@@ -59,6 +59,35 @@ class SafeWriter {
     int writeString(String val, bool pascal);
     int writeText(String val);
 
+    /**
+     * write an array of numbers in little-endian order.
+     * this is much faster than writing them one by one.
+     */
+    template<typename T> int writeArray(const T* val, size_t count) {
+#ifdef TA_BIG_ENDIAN
+      if (!operative) return 0;
+      checkSize(count*sizeof(T));
+      unsigned char* dest=buf+curSeek;
+      for (size_t i=0; i<count; i++) {
+        const unsigned char* src=(const unsigned char*)&val[i];
+        for (size_t j=0; j<sizeof(T); j++) {
+          dest[j]=src[sizeof(T)-1-j];
+        }
+        dest+=sizeof(T);
+      }
+      curSeek+=count*sizeof(T);
+      if (curSeek>len) len=curSeek;
+      return count*sizeof(T);
+#else
+      return write(val,count*sizeof(T));
+#endif
+    }
+
+    /**
+     * make sure that at least this many bytes can be written without growing the buffer.
+     */
+    void reserve(size_t amount);
+
     void init();
     SafeReader* toReader();
     void finish();
@@ -37,13 +37,122 @@ extern "C" {
 }
 #include "../../extern/adpcm-xq-s/adpcm-lib.h"
 #include "brrUtils.h"
+#include "workPool.h"
+#include <thread>
 
 DivSampleHistory::~DivSampleHistory() {
   if (data!=NULL) delete[] data;
 }
 
-void DivSample::putSampleData(SafeWriter* w) {
+void DivSampleHistory::makeDelta(const DivSampleHistory* base) {
+  if (isDelta || !hasSample || data==NULL) return;
+  if (base==NULL || base->isDelta || base->data==NULL || base->length!=length) return;
+
+  unsigned int blockCount=(length+DIV_SAMPLE_HISTORY_BLOCK-1)/DIV_SAMPLE_HISTORY_BLOCK;
+  std::vector<unsigned int> changed;
+  for (unsigned int i=0; i<blockCount; i++) {
+    unsigned int pos=i*DIV_SAMPLE_HISTORY_BLOCK;
+    unsigned int len=MIN(DIV_SAMPLE_HISTORY_BLOCK,length-pos);
+    if (memcmp(&data[pos],&base->data[pos],len)!=0) changed.push_back(i);
+  }
+  // not worth it
+  if (changed.size()>(blockCount>>1)) return;
+
+  unsigned char* newData=NULL;
+  if (!changed.empty()) {
+    newData=new unsigned char[changed.size()*DIV_SAMPLE_HISTORY_BLOCK];
+    unsigned int outPos=0;
+    for (unsigned int i: changed) {
+      unsigned int pos=i*DIV_SAMPLE_HISTORY_BLOCK;
+      unsigned int len=MIN(DIV_SAMPLE_HISTORY_BLOCK,length-pos);
+      memcpy(&newData[outPos],&data[pos],len);
+      outPos+=len;
+    }
+  }
+  delete[] data;
+  data=newData;
+  deltaBlocks=changed;
+  isDelta=true;
+}
+
+void DivSampleHistory::undoDelta(const DivSampleHistory* base) {
+  if (!isDelta) return;
+  if (base==NULL || base->isDelta || base->data==NULL || base->length!=length) {
+    logE("sample history delta has no base!");
+    if (data!=NULL) delete[] data;
+    data=NULL;
+    deltaBlocks.clear();
+    isDelta=false;
+    return;
+  }
+
+  unsigned char* newData=new unsigned char[length];
+  memcpy(newData,base->data,length);
+  unsigned int inPos=0;
+  for (unsigned int i: deltaBlocks) {
+    unsigned int pos=i*DIV_SAMPLE_HISTORY_BLOCK;
+    unsigned int len=MIN(DIV_SAMPLE_HISTORY_BLOCK,length-pos);
+    memcpy(&newData[pos],&data[inPos],len);
+    inPos+=len;
+  }
+  if (data!=NULL) delete[] data;
+  data=newData;
+  deltaBlocks.clear();
+  isDelta=false;
+}
+
+// delta-coded sample data is stored as the difference between each sample
+// and the previous one. 16-bit differences are split into a plane of low
+// bytes followed by a plane of high bytes.
+// this is lossless, and zlib compresses it much better than raw PCM.
+static void putDeltaData(SafeWriter* w, DivSampleDepth depth, const void* data, unsigned int samples) {
+  if (depth==DIV_SAMPLE_DEPTH_8BIT) {
+    const unsigned char* in=(const unsigned char*)data;
+    std::vector<unsigned char> out(samples);
+    unsigned char prev=0;
+    for (unsigned int i=0; i<samples; i++) {
+      out[i]=in[i]-prev;
+      prev=in[i];
+    }
+    w->write(out.data(),samples);
+  } else {
+    const unsigned short* in=(const unsigned short*)data;
+    std::vector<unsigned char> out(samples*2);
+    unsigned short prev=0;
+    for (unsigned int i=0; i<samples; i++) {
+      unsigned short delta=in[i]-prev;
+      out[i]=delta&0xff;
+      out[samples+i]=delta>>8;
+      prev=in[i];
+    }
+    w->write(out.data(),samples*2);
+  }
+}
+
+static void readDeltaData(SafeReader& reader, DivSampleDepth depth, void* data, unsigned int samples) {
+  if (depth==DIV_SAMPLE_DEPTH_8BIT) {
+    unsigned char* out=(unsigned char*)data;
+    reader.read(out,samples);
+    unsigned char prev=0;
+    for (unsigned int i=0; i<samples; i++) {
+      prev+=out[i];
+      out[i]=prev;
+    }
+  } else {
+    unsigned short* out=(unsigned short*)data;
+    std::vector<unsigned char> in(samples*2);
+    reader.read(in.data(),samples*2);
+    unsigned short prev=0;
+    for (unsigned int i=0; i<samples; i++) {
+      prev+=in[i]|(in[samples+i]<<8);
+      out[i]=prev;
+    }
+  }
+}
+
+void DivSample::putSampleData(SafeWriter* w, bool deltaCode) {
   size_t blockStartSeek, blockEndSeek;
+  bool delta=deltaCode && (depth==DIV_SAMPLE_DEPTH_8BIT || depth==DIV_SAMPLE_DEPTH_16BIT);
 
   w->write("SMP2",4);
   blockStartSeek=w->tell();
@@ -56,7 +165,7 @@ void DivSample::putSampleData(SafeWriter* w) {
   w->writeC(depth);
   w->writeC(loopMode);
   w->writeC(brrEmphasis);
-  w->writeC((dither?1:0)|(brrNoFilter?2:0));
+  w->writeC((dither?1:0)|(brrNoFilter?2:0)|(delta?4:0));
   w->writeI(loop?loopStart:-1);
   w->writeI(loop?loopEnd:-1);
 
@@ -68,21 +177,20 @@ void DivSample::putSampleData(SafeWriter* w) {
     w->writeI(out);
   }
 
+  if (delta) {
+    putDeltaData(w,depth,getCurBuf(),samples);
+  } else {
 #ifdef TA_BIG_ENDIAN
-  // store 16-bit samples as little-endian
-  if (depth==DIV_SAMPLE_DEPTH_16BIT) {
-    unsigned char* sampleBuf=(unsigned char*)getCurBuf();
-    size_t bufLen=getCurBufLen();
-    for (size_t i=0; i<bufLen; i+=2) {
-      w->writeC(sampleBuf[i+1]);
-      w->writeC(sampleBuf[i]);
+    // store 16-bit samples as little-endian
+    if (depth==DIV_SAMPLE_DEPTH_16BIT) {
+      w->writeArray((short*)getCurBuf(),getCurBufLen()>>1);
+    } else {
+      w->write(getCurBuf(),getCurBufLen());
     }
-  } else {
-    w->write(getCurBuf(),getCurBufLen());
-  }
 #else
-  w->write(getCurBuf(),getCurBufLen());
+    w->write(getCurBuf(),getCurBufLen());
 #endif
+  }
 
   blockEndSeek=w->tell();
   w->seek(blockStartSeek,SEEK_SET);
@@ -101,6 +209,7 @@ DivDataErrors DivSample::readSampleData(SafeReader& reader, short version) {
   int vol=0;
   int pitch=0;
   char magic[4];
+  bool delta=false;
 
   reader.read(magic,4);
   if (memcmp(magic,"SMPL",4)!=0 && memcmp(magic,"SMP2",4)!=0) {
@@ -139,6 +248,7 @@ DivDataErrors DivSample::readSampleData(SafeReader& reader, short version) {
       signed char c=reader.readC();
       dither=c&1;
       if (version>=213) brrNoFilter=c&2;
+      if (version>=245) delta=c&4;
     } else {
       reader.readC();
     }
@@ -180,7 +290,10 @@ DivDataErrors DivSample::readSampleData(SafeReader& reader, short version) {
     }
   }
 
-  if (version>=58) { // modern sample
+  if (delta && (depth==DIV_SAMPLE_DEPTH_8BIT || depth==DIV_SAMPLE_DEPTH_16BIT)) {
+    init(samples);
+    readDeltaData(reader,depth,getCurBuf(),samples);
+  } else if (version>=58) { // modern sample
     init(samples);
     reader.read(getCurBuf(),getCurBufLen());
 #ifdef TA_BIG_ENDIAN
@@ -895,41 +1008,30 @@ void DivSample::convert(DivSampleDepth newDepth, unsigned int formatMask) {
   render(formatMask|(1U<<newDepth));
 }
 
+// silence after the copy of the original data
+#define RESAMPLE_PADDING 64
+
+// the result is written to the job's own sample
 #define RESAMPLE_BEGIN \
-  if (samples<1) return true; \
-  int finalCount=(double)samples*(tRate/sRate); \
-  signed char* oldData8=data8; \
-  short* oldData16=data16; \
-  if (depth==DIV_SAMPLE_DEPTH_16BIT) { \
-    if (data16!=NULL) { \
-      data16=NULL; \
-      initInternal(DIV_SAMPLE_DEPTH_16BIT,finalCount); \
-    } \
-  } else if (depth==DIV_SAMPLE_DEPTH_8BIT) {  \
-    if (data8!=NULL) { \
-      data8=NULL; \
-      initInternal(DIV_SAMPLE_DEPTH_8BIT,finalCount); \
-    } \
-  } else { \
-    return false; \
-  }
+  signed char* data8=result.data8; \
+  short* data16=result.data16;
 
 #define RESAMPLE_END \
-  if (loopStart>=0) loopStart=(double)loopStart*(tRate/sRate); \
-  if (loopEnd>=0) loopEnd=(double)loopEnd*(tRate/sRate); \
-  centerRate=(int)((double)centerRate*(tRate/sRate)); \
-  samples=finalCount; \
-  if (depth==DIV_SAMPLE_DEPTH_16BIT) { \
-    delete[] oldData16; \
-  } else if (depth==DIV_SAMPLE_DEPTH_8BIT) { \
-    delete[] oldData8; \
+  progress=1.0f;
+
+// report progress and check for cancellation every so often
+#define RESAMPLE_PROGRESS(x) \
+  if (((x)&16383)==0) { \
+    progress=(float)(x)/(float)(finalCount+1); \
+    if (cancel) return false; \
   }
 
-bool DivSample::resampleNone(double sRate, double tRate) {
+bool DivSampleResampleJob::resampleNone() {
   RESAMPLE_BEGIN;
 
   if (depth==DIV_SAMPLE_DEPTH_16BIT) {
     for (int i=0; i<finalCount; i++) {
+      RESAMPLE_PROGRESS(i);
       unsigned int pos=(unsigned int)((double)i*(sRate/tRate));
       if (pos>=samples) {
         data16[i]=0;
@@ -939,6 +1041,7 @@ bool DivSample::resampleNone(double sRate, double tRate) {
     }
   } else if (depth==DIV_SAMPLE_DEPTH_8BIT) {
     for (int i=0; i<finalCount; i++) {
+      RESAMPLE_PROGRESS(i);
       unsigned int pos=(unsigned int)((double)i*(sRate/tRate));
       if (pos>=samples) {
         data8[i]=0;
@@ -952,7 +1055,7 @@ bool DivSample::resampleNone(double sRate, double tRate) {
   return true;
 }
 
-bool DivSample::resampleLinear(double sRate, double tRate) {
+bool DivSampleResampleJob::resampleLinear() {
   RESAMPLE_BEGIN;
 
   double posFrac=0;
@@ -961,6 +1064,7 @@ bool DivSample::resampleLinear(double sRate, double tRate) {
 
   if (depth==DIV_SAMPLE_DEPTH_16BIT) {
     for (int i=0; i<finalCount; i++) {
+      RESAMPLE_PROGRESS(i);
       short s1=(posInt>=samples)?0:oldData16[posInt];
       short s2=(posInt+1>=samples)?((loopStart>=0 && loopStart<(int)samples)?oldData16[loopStart]:0):oldData16[posInt+1];
 
@@ -974,6 +1078,7 @@ bool DivSample::resampleLinear(double sRate, double tRate) {
     }
   } else if (depth==DIV_SAMPLE_DEPTH_8BIT) {
     for (int i=0; i<finalCount; i++) {
+      RESAMPLE_PROGRESS(i);
       short s1=(posInt>=samples)?0:oldData8[posInt];
       short s2=(posInt+1>=samples)?((loopStart>=0 && loopStart<(int)samples)?oldData8[loopStart]:0):oldData8[posInt+1];
 
@@ -991,7 +1096,7 @@ bool DivSample::resampleLinear(double sRate, double tRate) {
   return true;
 }
 
-bool DivSample::resampleCubic(double sRate, double tRate) {
+bool DivSampleResampleJob::resampleCubic() {
   RESAMPLE_BEGIN;
 
   double posFrac=0;
@@ -1001,6 +1106,7 @@ bool DivSample::resampleCubic(double sRate, double tRate) {
 
   if (depth==DIV_SAMPLE_DEPTH_16BIT) {
     for (int i=0; i<finalCount; i++) {
+      RESAMPLE_PROGRESS(i);
       unsigned int n=((unsigned int)(posFrac*1024.0))&1023;
       float* t=&cubicTable[n<<2];
       float s0=(posInt<1)?0:oldData16[posInt-1];
@@ -1021,6 +1127,7 @@ bool DivSample::resampleCubic(double sRate, double tRate) {
     }
   } else if (depth==DIV_SAMPLE_DEPTH_8BIT) {
     for (int i=0; i<finalCount; i++) {
+      RESAMPLE_PROGRESS(i);
       unsigned int n=((unsigned int)(posFrac*1024.0))&1023;
       float* t=&cubicTable[n<<2];
       float s0=(posInt<1)?0:oldData8[posInt-1];
@@ -1045,7 +1152,7 @@ bool DivSample::resampleCubic(double sRate, double tRate) {
   return true;
 }
 
-bool DivSample::resampleBlep(double sRate, double tRate) {
+bool DivSampleResampleJob::resampleBlep() {
   RESAMPLE_BEGIN;
 
   double posFrac=0;
@@ -1059,6 +1166,13 @@ bool DivSample::resampleBlep(double sRate, double tRate) {
   if (depth==DIV_SAMPLE_DEPTH_16BIT) {
     memset(data16,0,finalCount*sizeof(short));
     for (int i=0; i<finalCount; i++) {
+      if ((i&16383)==0) {
+        progress=(float)i/(float)(finalCount+1);
+        if (cancel) {
+          delete[] floatData;
+          return false;
+        }
+      }
       if (posInt<samples) {
         data16[i]=oldData16[posInt];
       }
@@ -1092,6 +1206,13 @@ bool DivSample::resampleBlep(double sRate, double tRate) {
   } else if (depth==DIV_SAMPLE_DEPTH_8BIT) {
     memset(data8,0,finalCount);
     for (int i=0; i<finalCount; i++) {
+      if ((i&16383)==0) {
+        progress=(float)i/(float)(finalCount+1);
+        if (cancel) {
+          delete[] floatData;
+          return false;
+        }
+      }
       if (posInt<samples) {
         data8[i]=oldData8[posInt];
       }
@@ -1129,27 +1250,35 @@ bool DivSample::resampleBlep(double sRate, double tRate) {
   return true;
 }
 
-bool DivSample::resampleSinc(double sRate, double tRate) {
+// dot product of the 16-sample window and a kernel.
+// split into two halves so that the compiler can use vector instructions.
+static inline float sincPoint(const float* w, const float* k) {
+  float acc[8];
+  for (int j=0; j<8; j++) {
+    acc[j]=w[j]*k[j]+w[8+j]*k[8+j];
+  }
+  return ((acc[0]+acc[4])+(acc[1]+acc[5]))+((acc[2]+acc[6])+(acc[3]+acc[7]));
+}
+
+bool DivSampleResampleJob::resampleSinc() {
   RESAMPLE_BEGIN;
 
   double posFrac=0;
   unsigned int posInt=0;
   double factor=sRate/tRate;
-  float* sincTable=DivFilterTables::getSincTable();
-  float s[16];
+  float* kernelTable=DivFilterTables::getSincKernelTable();
+  // the last 16 samples are stored twice, so that they can be read as a contiguous
+  // window at &s[sPos] (oldest first) without shifting.
+  float s[32];
+  int sPos=0;
 
-  memset(s,0,16*sizeof(float));
+  memset(s,0,32*sizeof(float));
 
   if (depth==DIV_SAMPLE_DEPTH_16BIT) {
     for (int i=0; i<finalCount+8; i++) {
+      RESAMPLE_PROGRESS(i);
       unsigned int n=((unsigned int)(posFrac*8192.0))&8191;
-      float result=0;
-      float* t1=&sincTable[(8191-n)<<3];
-      float* t2=&sincTable[n<<3];
-      for (int j=0; j<8; j++) {
-        result+=s[j]*t2[7-j];
-        result+=s[8+j]*t1[j];
-      }
+      float result=sincPoint(&s[sPos],&kernelTable[n<<4]);
       if (result<-32768) result=-32768;
       if (result>32767) result=32767;
       if (i>=8) {
@@ -1161,20 +1290,15 @@ bool DivSample::resampleSinc(double sRate, double tRate) {
         posFrac-=1.0;
         posInt++;
 
-        for (int j=0; j<15; j++) s[j]=s[j+1];
-        s[15]=(posInt>=samples)?0:oldData16[posInt];
+        s[sPos]=s[sPos+16]=(posInt>=samples)?0:oldData16[posInt];
+        sPos=(sPos+1)&15;
       }
     }
   } else if (depth==DIV_SAMPLE_DEPTH_8BIT) {
     for (int i=0; i<finalCount+8; i++) {
+      RESAMPLE_PROGRESS(i);
       unsigned int n=((unsigned int)(posFrac*8192.0))&8191;
-      float result=0;
-      float* t1=&sincTable[(8191-n)<<3];
-      float* t2=&sincTable[n<<3];
-      for (int j=0; j<8; j++) {
-        result+=s[j]*t2[7-j];
-        result+=s[8+j]*t1[j];
-      }
+      float result=sincPoint(&s[sPos],&kernelTable[n<<4]);
       if (result<-128) result=-128;
       if (result>127) result=127;
       if (i>=8) {
@@ -1186,8 +1310,8 @@ bool DivSample::resampleSinc(double sRate, double tRate) {
         posFrac-=1.0;
         posInt++;
 
-        for (int j=0; j<15; j++) s[j]=s[j+1];
-        s[15]=(posInt>=samples)?0:oldData8[posInt];
+        s[sPos]=s[sPos+16]=(posInt>=samples)?0:oldData8[posInt];
+        sPos=(sPos+1)&15;
       }
     }
   }
@@ -1196,34 +1320,136 @@ bool DivSample::resampleSinc(double sRate, double tRate) {
   return true;
 }
 
-bool DivSample::resample(double sRate, double tRate, int filter) {
-  if (depth!=DIV_SAMPLE_DEPTH_8BIT && depth!=DIV_SAMPLE_DEPTH_16BIT) return false;
-  if (tRate<100) return false;
+bool DivSampleResampleJob::run() {
+  result.depth=depth;
+  if (!result.initInternal(depth,finalCount)) {
+    success=false;
+    finished=true;
+    return false;
+  }
+  result.samples=finalCount;
+
   switch (filter) {
     case DIV_RESAMPLE_NONE:
-      return resampleNone(sRate,tRate);
+      success=resampleNone();
       break;
     case DIV_RESAMPLE_LINEAR:
-      return resampleLinear(sRate,tRate);
+      success=resampleLinear();
       break;
     case DIV_RESAMPLE_CUBIC:
-      return resampleCubic(sRate,tRate);
+      success=resampleCubic();
       break;
     case DIV_RESAMPLE_BLEP:
-      return resampleBlep(sRate,tRate);
+      success=resampleBlep();
       break;
     case DIV_RESAMPLE_SINC:
-      return resampleSinc(sRate,tRate);
+      success=resampleSinc();
       break;
     case DIV_RESAMPLE_BEST:
       if (tRate>sRate) {
-        return resampleSinc(sRate,tRate);
+        success=resampleSinc();
       } else {
-        return resampleBlep(sRate,tRate);
+        success=resampleBlep();
       }
       break;
+    default:
+      success=false;
+      break;
   }
-  return false;
+  finished=true;
+  return success;
+}
+
+DivSampleResampleJob::DivSampleResampleJob():
+  depth(DIV_SAMPLE_DEPTH_16BIT),
+  samples(0),
+  loopStart(-1),
+  sRate(0.0),
+  tRate(0.0),
+  filter(0),
+  finalCount(0),
+  oldData8(NULL),
+  oldData16(NULL),
+  progress(0.0f),
+  cancel(false),
+  finished(false),
+  success(false) {
+}
+
+DivSampleResampleJob::~DivSampleResampleJob() {
+  if (oldData8!=NULL) delete[] oldData8;
+  if (oldData16!=NULL) delete[] oldData16;
+}
+
+DivSampleResampleJob* DivSample::prepareResample(double sRate, double tRate, int filter) {
+  if (depth!=DIV_SAMPLE_DEPTH_8BIT && depth!=DIV_SAMPLE_DEPTH_16BIT) return NULL;
+  if (tRate<100) return NULL;
+  if (samples<1 || getCurBuf()==NULL) return NULL;
+
+  // the tables are created here, as doing so isn't thread-safe
+  DivFilterTables::getCubicTable();
+  DivFilterTables::getSincIntegralTable();
+  DivFilterTables::getSincKernelTable();
+
+  DivSampleResampleJob* job=new DivSampleResampleJob;
+  job->depth=depth;
+  job->samples=samples;
+  job->loopStart=loopStart;
+  job->sRate=sRate;
+  job->tRate=tRate;
+  job->filter=filter;
+  job->finalCount=(double)samples*(tRate/sRate);
+  // BLEP may read past the end (up to one output sample's worth), so pad the copy with silence
+  size_t padding=(size_t)(sRate/tRate)+RESAMPLE_PADDING;
+  if (depth==DIV_SAMPLE_DEPTH_16BIT) {
+    job->oldData16=new short[samples+padding];
+    memcpy(job->oldData16,data16,samples*sizeof(short));
+    memset(&job->oldData16[samples],0,padding*sizeof(short));
+  } else {
+    job->oldData8=new signed char[samples+padding];
+    memcpy(job->oldData8,data8,samples);
+    memset(&job->oldData8[samples],0,padding);
+  }
+  return job;
+}
+
+bool DivSample::applyResample(DivSampleResampleJob* job) {
+  if (job==NULL) return false;
+  if (!job->finished || !job->success) return false;
+  // the sample was changed while resampling
+  if (job->depth!=depth || job->samples!=samples) return false;
+
+  if (depth==DIV_SAMPLE_DEPTH_16BIT) {
+    short* swapData=data16;
+    unsigned int swapLen=length16;
+    data16=job->result.data16;
+    length16=job->result.length16;
+    job->result.data16=swapData;
+    job->result.length16=swapLen;
+  } else {
+    signed char* swapData=data8;
+    unsigned int swapLen=length8;
+    data8=job->result.data8;
+    length8=job->result.length8;
+    job->result.data8=swapData;
+    job->result.length8=swapLen;
+  }
+
+  if (loopStart>=0) loopStart=(double)loopStart*(job->tRate/job->sRate);
+  if (loopEnd>=0) loopEnd=(double)loopEnd*(job->tRate/job->sRate);
+  centerRate=(int)((double)centerRate*(job->tRate/job->sRate));
+  samples=job->finalCount;
+  return true;
+}
+
+bool DivSample::resample(double sRate, double tRate, int filter) {
+  if (samples<1 && (depth==DIV_SAMPLE_DEPTH_8BIT || depth==DIV_SAMPLE_DEPTH_16BIT) && tRate>=100) return true;
+  DivSampleResampleJob* job=prepareResample(sRate,tRate,filter);
+  if (job==NULL) return false;
+  job->run();
+  bool ret=applyResample(job);
+  delete job;
+  return ret;
 }
 
 #define NOT_IN_FORMAT(x) (depth!=x && formatMask&(1U<<(unsigned int)x))
@@ -1264,9 +1490,300 @@ signed char adpcmKTable[16]={
   0, 1, 2, 4, 8, 16, 32, 64, -128, -64, -32, -16, -8, -4, -2, -1
 };
 
-void DivSample::render(unsigned int formatMask) {
+unsigned long long DivSample::getRenderHash() {
+  // FNV-1a
+  unsigned long long hash=0xcbf29ce484222325ULL;
+#define HASH_VALUE(x) \
+  hash^=(unsigned long long)(x); \
+  hash*=0x100000001b3ULL;
+
+  HASH_VALUE(depth);
+  HASH_VALUE(samples);
+  HASH_VALUE(loopStart);
+  HASH_VALUE(loopEnd);
+  HASH_VALUE(loopMode);
+  HASH_VALUE((loop?1:0)|(brrEmphasis?2:0)|(brrNoFilter?4:0)|(dither?8:0));
+
+  unsigned char* buf=(unsigned char*)getCurBuf();
+  unsigned int len=getCurBufLen();
+  HASH_VALUE(len);
+  if (buf!=NULL) {
+    unsigned int i=0;
+    for (; i+8<=len; i+=8) {
+      unsigned long long word;
+      memcpy(&word,&buf[i],8);
+      HASH_VALUE(word);
+    }
+    for (; i<len; i++) {
+      HASH_VALUE(buf[i]);
+    }
+  }
+#undef HASH_VALUE
+  return hash;
+}
+
+// renders a format from the 16-bit data.
+// formats only touch their own buffer, so several can be rendered at once.
+bool DivSample::renderFormat(DivSampleDepth d) {
+  switch (d) {
+    case DIV_SAMPLE_DEPTH_1BIT: { // 1-bit
+      if (!initInternal(DIV_SAMPLE_DEPTH_1BIT,samples)) return false;
+      for (unsigned int i=0; i<samples; i++) {
+        if (data16[i]>0) {
+          data1[i>>3]|=1<<(i&7);
+        }
+      }
+      break;
+    }
+    case DIV_SAMPLE_DEPTH_1BIT_DPCM: { // DPCM
+      if (!initInternal(DIV_SAMPLE_DEPTH_1BIT_DPCM,samples)) return false;
+      int accum=63;
+      int next=63;
+      
+      for (unsigned int i=0; (i<samples && (i>>3)<lengthDPCM); i++) {
+        next=((unsigned short)(data16[i]^0x8000))>>9;
+        if (next>accum) {
+          dataDPCM[i>>3]|=1<<(i&7);
+          accum++;
+        } else {
+          dataDPCM[i>>3]&=~(1<<(i&7));
+          accum--;
+        }
+        if (accum<0) accum=0;
+        if (accum>127) accum=127;
+      }
+      break;
+    }
+    case DIV_SAMPLE_DEPTH_YMZ_ADPCM: { // YMZ ADPCM
+      if (!initInternal(DIV_SAMPLE_DEPTH_YMZ_ADPCM,samples)) return false;
+      ymz_encode(data16,dataZ,(samples+7)&(~0x7));
+      break;
+    }
+    case DIV_SAMPLE_DEPTH_QSOUND_ADPCM: { // QSound ADPCM
+      if (!initInternal(DIV_SAMPLE_DEPTH_QSOUND_ADPCM,samples)) return false;
+      bs_encode(data16,dataQSoundA,samples);
+      break;
+    }
+    // TODO: pad to 256.
+    case DIV_SAMPLE_DEPTH_ADPCM_A: { // ADPCM-A
+      if (!initInternal(DIV_SAMPLE_DEPTH_ADPCM_A,samples)) return false;
+      yma_encode(data16,dataA,(samples+511)&(~0x1ff));
+      break;
+    }
+    case DIV_SAMPLE_DEPTH_ADPCM_B: { // ADPCM-B
+      if (!initInternal(DIV_SAMPLE_DEPTH_ADPCM_B,samples)) return false;
+      ymb_encode(data16,dataB,(samples+511)&(~0x1ff));
+      break;
+    }
+    case DIV_SAMPLE_DEPTH_ADPCM_K: { // K05 ADPCM
+      if (!initInternal(DIV_SAMPLE_DEPTH_ADPCM_K,samples)) return false;
+      signed char accum=0;
+      unsigned char out=0;
+      for (unsigned int i=0; i<samples; i++) {
+        signed char target=data16[i]>>8;
+        short delta=target-accum;
+        unsigned char next=0;
+
+        if (delta!=0) {
+          int b=bsr((delta>=0)?delta:-delta);
+          if (delta>=0) {
+            if (b>7) b=7;
+            next=b&15;
+
+            // test previous
+            if (next>1) {
+              const signed char t1=accum+adpcmKTable[next];
+              const signed char t2=accum+adpcmKTable[next-1];
+              const signed char d1=((t1-target)<0)?(target-t1):(t1-target);
+              const signed char d2=((t2-target)<0)?(target-t2):(t2-target);
+
+              if (d2<d1) next--;
+            }
+          } else {
+            if (b>8) b=8;
+            next=(16-b)&15;
+
+            // test next
+            if (next<15) {
+              const signed char t1=accum+adpcmKTable[next];
+              const signed char t2=accum+adpcmKTable[next+1];
+              const signed char d1=((t1-target)<0)?(target-t1):(t1-target);
+              const signed char d2=((t2-target)<0)?(target-t2):(t2-target);
+
+              if (d2<d1) next++;
+            }
+          }
+
+          /*if (accum+adpcmKTable[next]>=128 || accum+adpcmKTable[next]<-128) {
+            if (delta>=0) {
+              next--;
+            } else {
+              next++;
+              if (next>15) next=15;
+            }
+          }*/
+        }
+
+        out>>=4;
+        out|=next<<4;
+        accum+=adpcmKTable[next];
+
+        if (i&1) {
+          dataK[i>>1]=out;
+          out=0;
+        }
+      }
+      break;
+    }
+    case DIV_SAMPLE_DEPTH_8BIT: { // 8-bit PCM
+      if (!initInternal(DIV_SAMPLE_DEPTH_8BIT,samples)) return false;
+      if (dither) {
+        unsigned short lfsr=0x6438;
+        unsigned short lfsr1=0x1283;
+        signed char errorLast=0;
+        signed char errorCur=0;
+        for (unsigned int i=0; i<samples; i++) {
+          signed char val=CLAMP(data16[i]+128,-32768,32767)>>8;
+          errorLast=errorCur;
+          errorCur=(val<<8)-data16[i];
+          data8[i]=CLAMP(val-((((errorLast+errorCur)>>1)+(lfsr&0xff))>>8),-128,127);
+          lfsr=(lfsr<<1)|(((lfsr>>1)^(lfsr>>2)^(lfsr>>4)^(lfsr>>15))&1);
+          lfsr1=(lfsr1<<1)|(((lfsr1>>1)^(lfsr1>>2)^(lfsr1>>4)^(lfsr1>>15))&1);
+        }
+      } else {
+        for (unsigned int i=0; i<samples; i++) {
+          data8[i]=data16[i]>>8;
+        }
+      }
+      break;
+    }
+    case DIV_SAMPLE_DEPTH_BRR: { // BRR
+      int sampleCount=isLoopable()?loopEnd:samples;
+      if (sampleCount>(int)samples) sampleCount=samples;
+      if (!initInternal(DIV_SAMPLE_DEPTH_BRR,sampleCount)) return false;
+      brrEncode(data16,dataBRR,sampleCount,loop?loopStart:-1,brrEmphasis,brrNoFilter);
+      break;
+    }
+    case DIV_SAMPLE_DEPTH_VOX: { // VOX
+      if (!initInternal(DIV_SAMPLE_DEPTH_VOX,samples)) return false;
+      oki_encode(data16,dataVOX,samples);
+      break;
+    }
+    case DIV_SAMPLE_DEPTH_MULAW: { // µ-law
+      if (!initInternal(DIV_SAMPLE_DEPTH_MULAW,samples)) return false;
+      for (unsigned int i=0; i<samples; i++) {
+        IntFloat s;
+        s.f=data16[i];
+        s.i&=0x7fffffff;
+        if (s.f>32639.0f) s.f=32639.0f;
+        s.f/=128.0f;
+        s.f+=1.0f;
+        s.i-=0x3f800000;
+        dataMuLaw[i]=(((data16[i]<0)?0x80:0)|(s.i&0x03f80000)>>19)^0xff;
+      }
+      break;
+    }
+    case DIV_SAMPLE_DEPTH_C219: { // C219
+      if (!initInternal(DIV_SAMPLE_DEPTH_C219,samples)) return false;
+      for (unsigned int i=0; i<samples; i++) {
+        short s=data16[i];
+        unsigned char x=0;
+        bool negate=s&0x8000;
+        if (negate) {
+          s^=0xffff;
+        }
+        if (s==0) {
+          x=0;
+        } else if (s>17152) { // 100+
+          x=((s-17152)>>9)+100;
+        } else {
+          int b=bsr(s)-1;
+          x=((s-(c219Table[c219HighBitPos[b]]))>>c219ShiftToVal[b])+c219HighBitPos[b];
+        }
+        if (x>127) x=127;
+        dataC219[i]=x|(negate?0x80:0);
+      }
+      break;
+    }
+    case DIV_SAMPLE_DEPTH_IMA_ADPCM: { // IMA ADPCM
+      if (!initInternal(DIV_SAMPLE_DEPTH_IMA_ADPCM,samples)) return false;
+      int delta[2];
+      delta[0]=0;
+      delta[1]=0;
+
+      void* codec=adpcm_create_context(1,1,NOISE_SHAPING_OFF,delta);
+      if (codec==NULL) {
+        logE("oh no IMA encoder could not be created!");
+      } else {
+        size_t whyPointer=0;
+        adpcm_encode_block(codec,dataIMA,&whyPointer,data16,samples);
+        if (whyPointer!=lengthIMA) logW("IMA length mismatch! %d -> %d!=%d",(int)samples,(int)whyPointer,(int)lengthIMA);
+
+        adpcm_free_context(codec);
+      }
+      break;
+    }
+    case DIV_SAMPLE_DEPTH_12BIT: { // 12-bit PCM (MultiPCM)
+      if (!initInternal(DIV_SAMPLE_DEPTH_12BIT,samples)) return false;
+      for (unsigned int i=0, j=0; i<samples; i+=2, j+=3) {
+        data12[j+0]=data16[i+0]>>8;
+        data12[j+1]=((data16[i+0]>>4)&0xf)|(i+1<samples?(data16[i+1]>>4)&0xf:0);
+        if (i+1<samples) {
+          data12[j+2]=data16[i+1]>>8;
+        } else {
+          data12[j+2]=0;
+        }
+      }
+      break;
+    }
+    case DIV_SAMPLE_DEPTH_4BIT: {
+      if (!initInternal(DIV_SAMPLE_DEPTH_4BIT,samples)) return false;
+      unsigned char _sample=0, sample4=0;
+      unsigned short* samplePtr = (unsigned short*)data16;
+      for (unsigned int i=0; i<samples; i+=2) {
+        _sample=(*samplePtr++^0x8000)>>12;
+        sample4=_sample<<4;
+        if (i+1<samples) {
+          _sample=(*samplePtr++^0x8000)>>12;
+          sample4|=_sample;
+        }
+        data4[i>>1]=sample4;
+      }
+      break;
+    }
+    default:
+      break;
+  }
+  return true;
+}
+
+struct DivSampleFormatTask {
+  DivSample* sample;
+  DivSampleDepth format;
+  bool success;
+};
+
+static void _renderSampleFormat(void* arg) {
+  DivSampleFormatTask* task=(DivSampleFormatTask*)arg;
+  task->success=task->sample->renderFormat(task->format);
+}
+
+void DivSample::render(unsigned int formatMask, bool parallel) {
+  render(formatMask,parallel,getRenderHash());
+}
+
+void DivSample::render(unsigned int formatMask, bool parallel, unsigned long long hash) {
+  // skip formats which are up to date
+  if (hash!=renderHash) {
+    renderedMask=0;
+    renderHash=hash;
+  }
+  unsigned int wantedMask=formatMask;
+  formatMask&=~renderedMask;
+  if (formatMask==0) return;
+
   // step 1: convert to 16-bit if needed
-  if (depth!=DIV_SAMPLE_DEPTH_16BIT) {
+  if (depth!=DIV_SAMPLE_DEPTH_16BIT && (data16==NULL || !(renderedMask&(1U<<DIV_SAMPLE_DEPTH_16BIT)))) {
     if (!initInternal(DIV_SAMPLE_DEPTH_16BIT,samples)) return;
     switch (depth) {
       case DIV_SAMPLE_DEPTH_1BIT: // 1-bit
@@ -1364,218 +1881,84 @@ void DivSample::render(unsigned int formatMask) {
   }
 
   // step 2: render to other formats
-  if (NOT_IN_FORMAT(DIV_SAMPLE_DEPTH_1BIT)) { // 1-bit
-    if (!initInternal(DIV_SAMPLE_DEPTH_1BIT,samples)) return;
-    for (unsigned int i=0; i<samples; i++) {
-      if (data16[i]>0) {
-        data1[i>>3]|=1<<(i&7);
-      }
-    }
+  DivSampleDepth formats[DIV_SAMPLE_DEPTH_MAX];
+  int formatCount=0;
+  // (16-bit was rendered in step 1)
+  for (int i=0; i<DIV_SAMPLE_DEPTH_16BIT; i++) {
+    if (NOT_IN_FORMAT(i)) formats[formatCount++]=(DivSampleDepth)i;
   }
-  if (NOT_IN_FORMAT(DIV_SAMPLE_DEPTH_1BIT_DPCM)) { // DPCM
-    if (!initInternal(DIV_SAMPLE_DEPTH_1BIT_DPCM,samples)) return;
-    int accum=63;
-    int next=63;
-    
-    for (unsigned int i=0; (i<samples && (i>>3)<lengthDPCM); i++) {
-      next=((unsigned short)(data16[i]^0x8000))>>9;
-      if (next>accum) {
-        dataDPCM[i>>3]|=1<<(i&7);
-        accum++;
-      } else {
-        dataDPCM[i>>3]&=~(1<<(i&7));
-        accum--;
-      }
-      if (accum<0) accum=0;
-      if (accum>127) accum=127;
+  if (parallel && formatCount>1 && samples>=DIV_SAMPLE_PARALLEL_THRESHOLD) {
+    DivSampleFormatTask tasks[DIV_SAMPLE_DEPTH_MAX];
+    for (int i=0; i<formatCount; i++) {
+      tasks[i].sample=this;
+      tasks[i].format=formats[i];
+      tasks[i].success=false;
+    }
+    unsigned int threads=std::thread::hardware_concurrency();
+    if (threads>(unsigned int)formatCount) threads=formatCount;
+    DivWorkPool* pool=new DivWorkPool((threads>1)?(threads-1):0);
+    pool->pushBatch(_renderSampleFormat,tasks,formatCount);
+    pool->wait();
+    delete pool;
+    for (int i=0; i<formatCount; i++) {
+      if (!tasks[i].success) return;
+    }
+  } else {
+    for (int i=0; i<formatCount; i++) {
+      if (!renderFormat(formats[i])) return;
     }
   }
-  if (NOT_IN_FORMAT(DIV_SAMPLE_DEPTH_YMZ_ADPCM)) { // YMZ ADPCM
-    if (!initInternal(DIV_SAMPLE_DEPTH_YMZ_ADPCM,samples)) return;
-    ymz_encode(data16,dataZ,(samples+7)&(~0x7));
-  }
-  if (NOT_IN_FORMAT(DIV_SAMPLE_DEPTH_QSOUND_ADPCM)) { // QSound ADPCM
-    if (!initInternal(DIV_SAMPLE_DEPTH_QSOUND_ADPCM,samples)) return;
-    bs_encode(data16,dataQSoundA,samples);
-  }
-  // TODO: pad to 256.
-  if (NOT_IN_FORMAT(DIV_SAMPLE_DEPTH_ADPCM_A)) { // ADPCM-A
-    if (!initInternal(DIV_SAMPLE_DEPTH_ADPCM_A,samples)) return;
-    yma_encode(data16,dataA,(samples+511)&(~0x1ff));
-  }
-  if (NOT_IN_FORMAT(DIV_SAMPLE_DEPTH_ADPCM_B)) { // ADPCM-B
-    if (!initInternal(DIV_SAMPLE_DEPTH_ADPCM_B,samples)) return;
-    ymb_encode(data16,dataB,(samples+511)&(~0x1ff));
-  }
-  if (NOT_IN_FORMAT(DIV_SAMPLE_DEPTH_ADPCM_K)) { // K05 ADPCM
-    if (!initInternal(DIV_SAMPLE_DEPTH_ADPCM_K,samples)) return;
-    signed char accum=0;
-    unsigned char out=0;
-    for (unsigned int i=0; i<samples; i++) {
-      signed char target=data16[i]>>8;
-      short delta=target-accum;
-      unsigned char next=0;
-
-      if (delta!=0) {
-        int b=bsr((delta>=0)?delta:-delta);
-        if (delta>=0) {
-          if (b>7) b=7;
-          next=b&15;
-
-          // test previous
-          if (next>1) {
-            const signed char t1=accum+adpcmKTable[next];
-            const signed char t2=accum+adpcmKTable[next-1];
-            const signed char d1=((t1-target)<0)?(target-t1):(t1-target);
-            const signed char d2=((t2-target)<0)?(target-t2):(t2-target);
-
-            if (d2<d1) next--;
-          }
-        } else {
-          if (b>8) b=8;
-          next=(16-b)&15;
 
-          // test next
-          if (next<15) {
-            const signed char t1=accum+adpcmKTable[next];
-            const signed char t2=accum+adpcmKTable[next+1];
-            const signed char d1=((t1-target)<0)?(target-t1):(t1-target);
-            const signed char d2=((t2-target)<0)?(target-t2):(t2-target);
-
-            if (d2<d1) next++;
-          }
-        }
-
-        /*if (accum+adpcmKTable[next]>=128 || accum+adpcmKTable[next]<-128) {
-          if (delta>=0) {
-            next--;
-          } else {
-            next++;
-            if (next>15) next=15;
-          }
-        }*/
-      }
+  renderedMask|=wantedMask|(1U<<DIV_SAMPLE_DEPTH_16BIT)|(1U<<depth);
+}
 
-      out>>=4;
-      out|=next<<4;
-      accum+=adpcmKTable[next];
+bool DivSample::isSameData(DivSample* other) {
+  if (depth!=other->depth || samples!=other->samples) return false;
+  if (loop!=other->loop || loopStart!=other->loopStart || loopEnd!=other->loopEnd || loopMode!=other->loopMode) return false;
+  if (brrEmphasis!=other->brrEmphasis || brrNoFilter!=other->brrNoFilter || dither!=other->dither) return false;
+  unsigned int len=getCurBufLen();
+  if (len!=other->getCurBufLen()) return false;
+  if (len==0) return true;
+  void* buf=getCurBuf();
+  void* otherBuf=other->getCurBuf();
+  if (buf==NULL || otherBuf==NULL) return buf==otherBuf;
+  return memcmp(buf,otherBuf,len)==0;
+}
 
-      if (i&1) {
-        dataK[i>>1]=out;
-        out=0;
-      }
-    }
+#define COPY_FORMAT(_d,_data,_len) \
+  if ((formatMask&(1U<<(_d))) && depth!=(_d)) { \
+    if (!initInternal(_d,samples)) return false; \
+    memcpy(_data,other->_data,MIN(_len,other->_len)); \
   }
-  if (NOT_IN_FORMAT(DIV_SAMPLE_DEPTH_8BIT)) { // 8-bit PCM
-    if (!initInternal(DIV_SAMPLE_DEPTH_8BIT,samples)) return;
-    if (dither) {
-      unsigned short lfsr=0x6438;
-      unsigned short lfsr1=0x1283;
-      signed char errorLast=0;
-      signed char errorCur=0;
-      for (unsigned int i=0; i<samples; i++) {
-        signed char val=CLAMP(data16[i]+128,-32768,32767)>>8;
-        errorLast=errorCur;
-        errorCur=(val<<8)-data16[i];
-        data8[i]=CLAMP(val-((((errorLast+errorCur)>>1)+(lfsr&0xff))>>8),-128,127);
-        lfsr=(lfsr<<1)|(((lfsr>>1)^(lfsr>>2)^(lfsr>>4)^(lfsr>>15))&1);
-        lfsr1=(lfsr1<<1)|(((lfsr1>>1)^(lfsr1>>2)^(lfsr1>>4)^(lfsr1>>15))&1);
-      }
-    } else {
-      for (unsigned int i=0; i<samples; i++) {
-        data8[i]=data16[i]>>8;
-      }
-    }
-  }
-  if (NOT_IN_FORMAT(DIV_SAMPLE_DEPTH_BRR)) { // BRR
-    int sampleCount=isLoopable()?loopEnd:samples;
-    if (sampleCount>(int)samples) sampleCount=samples;
-    if (!initInternal(DIV_SAMPLE_DEPTH_BRR,sampleCount)) return;
-    brrEncode(data16,dataBRR,sampleCount,loop?loopStart:-1,brrEmphasis,brrNoFilter);
-  }
-  if (NOT_IN_FORMAT(DIV_SAMPLE_DEPTH_VOX)) { // VOX
-    if (!initInternal(DIV_SAMPLE_DEPTH_VOX,samples)) return;
-    oki_encode(data16,dataVOX,samples);
-  }
-  if (NOT_IN_FORMAT(DIV_SAMPLE_DEPTH_MULAW)) { // µ-law
-    if (!initInternal(DIV_SAMPLE_DEPTH_MULAW,samples)) return;
-    for (unsigned int i=0; i<samples; i++) {
-      IntFloat s;
-      s.f=data16[i];
-      s.i&=0x7fffffff;
-      if (s.f>32639.0f) s.f=32639.0f;
-      s.f/=128.0f;
-      s.f+=1.0f;
-      s.i-=0x3f800000;
-      dataMuLaw[i]=(((data16[i]<0)?0x80:0)|(s.i&0x03f80000)>>19)^0xff;
-    }
-  }
-  if (NOT_IN_FORMAT(DIV_SAMPLE_DEPTH_C219)) { // C219
-    if (!initInternal(DIV_SAMPLE_DEPTH_C219,samples)) return;
-    for (unsigned int i=0; i<samples; i++) {
-      short s=data16[i];
-      unsigned char x=0;
-      bool negate=s&0x8000;
-      if (negate) {
-        s^=0xffff;
-      }
-      if (s==0) {
-        x=0;
-      } else if (s>17152) { // 100+
-        x=((s-17152)>>9)+100;
-      } else {
-        int b=bsr(s)-1;
-        x=((s-(c219Table[c219HighBitPos[b]]))>>c219ShiftToVal[b])+c219HighBitPos[b];
-      }
-      if (x>127) x=127;
-      dataC219[i]=x|(negate?0x80:0);
-    }
-  }
-  if (NOT_IN_FORMAT(DIV_SAMPLE_DEPTH_IMA_ADPCM)) { // IMA ADPCM
-    if (!initInternal(DIV_SAMPLE_DEPTH_IMA_ADPCM,samples)) return;
-    int delta[2];
-    delta[0]=0;
-    delta[1]=0;
-
-    void* codec=adpcm_create_context(1,1,NOISE_SHAPING_OFF,delta);
-    if (codec==NULL) {
-      logE("oh no IMA encoder could not be created!");
-    } else {
-      size_t whyPointer=0;
-      adpcm_encode_block(codec,dataIMA,&whyPointer,data16,samples);
-      if (whyPointer!=lengthIMA) logW("IMA length mismatch! %d -> %d!=%d",(int)samples,(int)whyPointer,(int)lengthIMA);
 
-      adpcm_free_context(codec);
-    }
-  }
-  if (NOT_IN_FORMAT(DIV_SAMPLE_DEPTH_12BIT)) { // 12-bit PCM (MultiPCM)
-    if (!initInternal(DIV_SAMPLE_DEPTH_12BIT,samples)) return;
-    for (unsigned int i=0, j=0; i<samples; i+=2, j+=3) {
-      data12[j+0]=data16[i+0]>>8;
-      data12[j+1]=((data16[i+0]>>4)&0xf)|(i+1<samples?(data16[i+1]>>4)&0xf:0);
-      if (i+1<samples) {
-        data12[j+2]=data16[i+1]>>8;
-      } else {
-        data12[j+2]=0;
-      }
-    }
-  }
-  if (NOT_IN_FORMAT(DIV_SAMPLE_DEPTH_4BIT)) {
-    if (!initInternal(DIV_SAMPLE_DEPTH_4BIT,samples)) return;
-    unsigned char _sample=0, sample4=0;
-    unsigned short* samplePtr = (unsigned short*)data16;
-    for (unsigned int i=0; i<samples; i+=2) {
-      _sample=(*samplePtr++^0x8000)>>12;
-      sample4=_sample<<4;
-      if (i+1<samples) {
-        _sample=(*samplePtr++^0x8000)>>12;
-        sample4|=_sample;
-      }
-      data4[i>>1]=sample4;
-    }
-  }
+bool DivSample::copyRenderFrom(DivSample* other, unsigned int formatMask, unsigned long long hash) {
+  if (other->renderHash!=hash) return false;
+  formatMask|=1U<<DIV_SAMPLE_DEPTH_16BIT;
+  if ((formatMask&~other->renderedMask)!=0) return false;
+  COPY_FORMAT(DIV_SAMPLE_DEPTH_1BIT,data1,length1);
+  COPY_FORMAT(DIV_SAMPLE_DEPTH_1BIT_DPCM,dataDPCM,lengthDPCM);
+  COPY_FORMAT(DIV_SAMPLE_DEPTH_YMZ_ADPCM,dataZ,lengthZ);
+  COPY_FORMAT(DIV_SAMPLE_DEPTH_QSOUND_ADPCM,dataQSoundA,lengthQSoundA);
+  COPY_FORMAT(DIV_SAMPLE_DEPTH_ADPCM_A,dataA,lengthA);
+  COPY_FORMAT(DIV_SAMPLE_DEPTH_ADPCM_B,dataB,lengthB);
+  COPY_FORMAT(DIV_SAMPLE_DEPTH_ADPCM_K,dataK,lengthK);
+  COPY_FORMAT(DIV_SAMPLE_DEPTH_8BIT,data8,length8);
+  COPY_FORMAT(DIV_SAMPLE_DEPTH_BRR,dataBRR,lengthBRR);
+  COPY_FORMAT(DIV_SAMPLE_DEPTH_VOX,dataVOX,lengthVOX);
+  COPY_FORMAT(DIV_SAMPLE_DEPTH_MULAW,dataMuLaw,lengthMuLaw);
+  COPY_FORMAT(DIV_SAMPLE_DEPTH_C219,dataC219,lengthC219);
+  COPY_FORMAT(DIV_SAMPLE_DEPTH_IMA_ADPCM,dataIMA,lengthIMA);
+  COPY_FORMAT(DIV_SAMPLE_DEPTH_12BIT,data12,length12);
+  COPY_FORMAT(DIV_SAMPLE_DEPTH_4BIT,data4,length4);
+  COPY_FORMAT(DIV_SAMPLE_DEPTH_16BIT,data16,length16);
+  if (renderHash!=hash) renderedMask=0;
+  renderHash=hash;
+  renderedMask|=formatMask|(1U<<depth);
+  return true;
 }
 
+#undef COPY_FORMAT
+
 void* DivSample::getCurBuf() {
   switch (depth) {
     case DIV_SAMPLE_DEPTH_1BIT:
@@ -1676,12 +2059,28 @@ DivSampleHistory* DivSample::prepareUndo(bool data, bool doNotPush) {
       delete h;
       redoHist.pop_back();
     }
-    if (undoHist.size()>100) undoHist.pop_front();
-    undoHist.push_back(h);
+    pushUndo(h);
   }
   return h;
 }
 
+void DivSample::pushUndo(DivSampleHistory* h) {
+  if (undoHist.size()>100) {
+    delete undoHist.front();
+    undoHist.pop_front();
+  }
+  // only the latest step with sample data is stored in full
+  if (h->hasSample) {
+    for (int i=(int)undoHist.size()-1; i>=0; i--) {
+      if (undoHist[i]->hasSample) {
+        undoHist[i]->makeDelta(h);
+        break;
+      }
+    }
+  }
+  undoHist.push_back(h);
+}
+
 #define applyHistory \
   depth=h->depth; \
   if (h->hasSample) { \
@@ -1716,8 +2115,17 @@ int DivSample::undo() {
   applyHistory;
 
   redoHist.push_back(redo);
-  delete h;
   undoHist.pop_back();
+  // the previous step with sample data may be a delta against this one
+  if (h->hasSample) {
+    for (int i=(int)undoHist.size()-1; i>=0; i--) {
+      if (undoHist[i]->hasSample) {
+        undoHist[i]->undoDelta(h);
+        break;
+      }
+    }
+  }
+  delete h;
   return ret;
 }
 
@@ -1730,12 +2138,46 @@ int DivSample::redo() {
 
   applyHistory;
 
-  undoHist.push_back(undo);
+  pushUndo(undo);
   delete h;
   redoHist.pop_back();
   return ret;
 }
 
+#define TRIM_FORMAT(_d,_data,_len) \
+  if (!(formatMask&(1U<<(_d))) && depth!=(_d) && _data!=NULL) { \
+    freed+=_len; \
+    delete[] _data; \
+    _data=NULL; \
+    _len=0; \
+    renderedMask&=~(1U<<(_d)); \
+  }
+
+size_t DivSample::trim(unsigned int formatMask) {
+  size_t freed=0;
+  TRIM_FORMAT(DIV_SAMPLE_DEPTH_1BIT,data1,length1);
+  TRIM_FORMAT(DIV_SAMPLE_DEPTH_1BIT_DPCM,dataDPCM,lengthDPCM);
+  TRIM_FORMAT(DIV_SAMPLE_DEPTH_YMZ_ADPCM,dataZ,lengthZ);
+  TRIM_FORMAT(DIV_SAMPLE_DEPTH_QSOUND_ADPCM,dataQSoundA,lengthQSoundA);
+  TRIM_FORMAT(DIV_SAMPLE_DEPTH_ADPCM_A,dataA,lengthA);
+  TRIM_FORMAT(DIV_SAMPLE_DEPTH_ADPCM_B,dataB,lengthB);
+  TRIM_FORMAT(DIV_SAMPLE_DEPTH_ADPCM_K,dataK,lengthK);
+  TRIM_FORMAT(DIV_SAMPLE_DEPTH_8BIT,data8,length8);
+  TRIM_FORMAT(DIV_SAMPLE_DEPTH_BRR,dataBRR,lengthBRR);
+  TRIM_FORMAT(DIV_SAMPLE_DEPTH_VOX,dataVOX,lengthVOX);
+  TRIM_FORMAT(DIV_SAMPLE_DEPTH_MULAW,dataMuLaw,lengthMuLaw);
+  TRIM_FORMAT(DIV_SAMPLE_DEPTH_C219,dataC219,lengthC219);
+  TRIM_FORMAT(DIV_SAMPLE_DEPTH_IMA_ADPCM,dataIMA,lengthIMA);
+  TRIM_FORMAT(DIV_SAMPLE_DEPTH_12BIT,data12,length12);
+  TRIM_FORMAT(DIV_SAMPLE_DEPTH_4BIT,data4,length4);
+  TRIM_FORMAT(DIV_SAMPLE_DEPTH_16BIT,data16,length16);
+  return freed;
+}
+
+size_t DivSample::getBufferSize() {
+  return (size_t)length1+lengthDPCM+lengthZ+lengthQSoundA+lengthA+lengthB+lengthK+length8+lengthBRR+lengthVOX+lengthMuLaw+lengthC219+lengthIMA+length12+length4+length16;
+}
+
 DivSample::~DivSample() {
   while (!undoHist.empty()) {
     DivSampleHistory* h=undoHist.back();
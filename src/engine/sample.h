@@ -25,6 +25,14 @@
 #include "safeWriter.h"
 #include "dataErrors.h"
 #include "../fixedQueue.h"
+#include <atomic>
+#include <vector>
+
+// size of a block in sample undo deltas (in bytes)
+#define DIV_SAMPLE_HISTORY_BLOCK 4096
+
+// render(parallel=true) only uses threads for samples at least this long
+#define DIV_SAMPLE_PARALLEL_THRESHOLD 65536
 
 enum DivSampleLoopMode: unsigned char {
   DIV_SAMPLE_LOOP_FORWARD=0,
@@ -70,6 +78,23 @@ struct DivSampleHistory {
   bool loop, brrEmphasis, brrNoFilter, dither;
   DivSampleLoopMode loopMode;
   bool hasSample;
+  // if this is true, data only contains the blocks listed in deltaBlocks, and the rest is
+  // equal to the data of the next step with sample data.
+  bool isDelta;
+  std::vector<unsigned int> deltaBlocks;
+
+  /**
+   * store only the blocks which differ from the data of another step.
+   * does nothing if the lengths differ or if most of the data changed.
+   */
+  void makeDelta(const DivSampleHistory* base);
+
+  /**
+   * restore the full data of a delta step.
+   * @param base the step this delta is relative to.
+   */
+  void undoDelta(const DivSampleHistory* base);
+
   DivSampleHistory(void* d, unsigned int l, unsigned int s, DivSampleDepth de, int cr, int ls, int le, bool lp, bool be, bool bf, bool di, DivSampleLoopMode lm):
     data((unsigned char*)d),
     length(l),
@@ -83,7 +108,8 @@ struct DivSampleHistory {
     brrNoFilter(bf),
     dither(di),
     loopMode(lm),
-    hasSample(true) {}
+    hasSample(true),
+    isDelta(false) {}
   DivSampleHistory(DivSampleDepth de, int cr, int ls, int le, bool lp, bool be, bool bf, bool di, DivSampleLoopMode lm):
     data(NULL),
     length(0),
@@ -97,10 +123,13 @@ struct DivSampleHistory {
     brrNoFilter(bf),
     dither(di),
     loopMode(lm),
-    hasSample(false) {}
+    hasSample(false),
+    isDelta(false) {}
   ~DivSampleHistory();
 };
 
+struct DivSampleResampleJob;
+
 struct DivSample {
   String name;
   int centerRate, loopStart, loopEnd;
@@ -153,14 +182,20 @@ struct DivSample {
 
   unsigned int samples;
 
+  // formats which are up to date, and the hash of the sample data they were rendered from.
+  // render() skips these formats as long as the hash doesn't change.
+  unsigned int renderedMask;
+  unsigned long long renderHash;
+
   FixedQueue<DivSampleHistory*,128> undoHist;
   FixedQueue<DivSampleHistory*,128> redoHist;
 
   /**
    * put sample data.
    * @param w a SafeWriter.
+   * @param deltaCode store 8/16-bit sample data as differences (>=245), which compress better.
    */
-  void putSampleData(SafeWriter* w);
+  void putSampleData(SafeWriter* w, bool deltaCode=false);
 
   /**
    * read sample data.
@@ -205,15 +240,6 @@ struct DivSample {
    */
   void setSampleCount(unsigned int count);
 
-  /**
-   * @warning DO NOT USE - internal functions
-   */
-  bool resampleNone(double sRate, double tRate);
-  bool resampleLinear(double sRate, double tRate);
-  bool resampleCubic(double sRate, double tRate);
-  bool resampleBlep(double sRate, double tRate);
-  bool resampleSinc(double sRate, double tRate);
-
   /**
    * save this sample to a file.
    * @param path a path.
@@ -237,6 +263,14 @@ struct DivSample {
    */
   bool initInternal(DivSampleDepth d, int count);
 
+  /**
+   * @warning DO NOT USE - internal function
+   * render a format from the 16-bit data.
+   * @param d sample type.
+   * @return whether it was successful.
+   */
+  bool renderFormat(DivSampleDepth d);
+
   /**
    * initialize sample data. make sure you have set `depth` before doing so.
    * @param count number of samples.
@@ -289,6 +323,24 @@ struct DivSample {
    */
   bool resample(double sRate, double tRate, int filter);
 
+  /**
+   * prepare a resample job, which may run on another thread.
+   * the job works on a copy of the sample data.
+   * @param sRate source rate.
+   * @param tRate target rate.
+   * @param filter the interpolation filter.
+   * @return the job (delete it afterwards), or NULL if the sample can't be resampled.
+   */
+  DivSampleResampleJob* prepareResample(double sRate, double tRate, int filter);
+
+  /**
+   * replace the sample data with the result of a finished resample job.
+   * @warning do not attempt to do this outside of a synchronized block!
+   * @param job the job.
+   * @return whether it was successful (false if the job was cancelled or the sample changed).
+   */
+  bool applyResample(DivSampleResampleJob* job);
+
   /**
    * convert sample depth.
    * @warning do not attempt to do this outside of a synchronized block!
@@ -296,10 +348,58 @@ struct DivSample {
    */
   void convert(DivSampleDepth newDepth, unsigned int formatMask=0xffffffff);
 
+  /**
+   * compute a hash of the sample data and the parameters which affect rendering.
+   * @return the hash.
+   */
+  unsigned long long getRenderHash();
+
   /**
    * initialize the rest of sample formats for this sample.
+   * formats which have already been rendered from the same data are skipped.
+   * @param formatMask the formats to render.
+   * @param parallel whether to render formats in parallel (for long samples).
+   */
+  void render(unsigned int formatMask=0xffffffff, bool parallel=false);
+
+  /**
+   * like render(), but with a hash already obtained from getRenderHash().
+   * @param formatMask the formats to render.
+   * @param parallel whether to render formats in parallel (for long samples).
+   * @param hash the render hash of this sample.
+   */
+  void render(unsigned int formatMask, bool parallel, unsigned long long hash);
+
+  /**
+   * check whether another sample renders to the same data.
+   * name, rate and chip presence are not compared.
+   * @param other the other sample.
+   * @return whether the data and loop settings are identical.
+   */
+  bool isSameData(DivSample* other);
+
+  /**
+   * copy rendered formats from a sample with the same data instead of rendering them.
+   * @param other the other sample. see isSameData().
+   * @param formatMask the formats to copy.
+   * @param hash the render hash of this sample (from getRenderHash()).
+   * @return whether other had all of the formats.
+   */
+  bool copyRenderFrom(DivSample* other, unsigned int formatMask, unsigned long long hash);
+
+  /**
+   * free every format which is not in formatMask, except for the current depth.
+   * freed formats are rendered again by render() if they are needed later.
+   * @param formatMask the formats to keep.
+   * @return the number of bytes freed.
+   */
+  size_t trim(unsigned int formatMask);
+
+  /**
+   * get the size of the data of all formats.
+   * @return the size in bytes.
    */
-  void render(unsigned int formatMask=0xffffffff);
+  size_t getBufferSize();
 
   /**
    * get the sample data for the current depth.
@@ -321,6 +421,12 @@ struct DivSample {
    */
   DivSampleHistory* prepareUndo(bool data, bool doNotPush=false);
 
+  /**
+   * push a step to the undo history.
+   * the previous step with sample data is turned into a delta against this one.
+   */
+  void pushUndo(DivSampleHistory* h);
+
   /**
    * undo. you may need to call DivEngine::renderSamples afterwards.
    * @warning do not attempt to undo outside of a synchronized block!
@@ -378,7 +484,9 @@ struct DivSample {
     lengthIMA(0),
     length12(0),
     length4(0),
-    samples(0) {
+    samples(0),
+    renderedMask(0),
+    renderHash(0) {
     for (int i=0; i<DIV_MAX_CHIPS; i++) {
       for (int j=0; j<DIV_MAX_SAMPLE_TYPE; j++) {
         renderOn[j][i]=true;
@@ -388,4 +496,42 @@ struct DivSample {
   ~DivSample();
 };
 
+/**
+ * a resample operation.
+ * it only touches its own copy of the data, so run() may be called outside of the engine lock.
+ */
+struct DivSampleResampleJob {
+  DivSampleDepth depth;
+  unsigned int samples;
+  int loopStart;
+  double sRate, tRate;
+  int filter;
+  int finalCount;
+  signed char* oldData8;
+  short* oldData16;
+  // holds the result
+  DivSample result;
+
+  // from 0 to 1
+  std::atomic<float> progress;
+  std::atomic<bool> cancel;
+  std::atomic<bool> finished;
+  bool success;
+
+  /**
+   * run the job.
+   * @return whether it was successful.
+   */
+  bool run();
+
+  bool resampleNone();
+  bool resampleLinear();
+  bool resampleCubic();
+  bool resampleBlep();
+  bool resampleSinc();
+
+  DivSampleResampleJob();
+  ~DivSampleResampleJob();
+};
+
 #endif
@@ -0,0 +1,257 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2026 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "sampleRAM.h"
+#include "sample.h"
+#include "../ta-log.h"
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+
+void DivSampleRAM::clear() {
+  placed.clear();
+  lastSysID=-1;
+  lastCapacity=0;
+}
+
+size_t DivSampleRAM::layoutAll(const std::vector<DivSample*>& samples, int count, int sysID, unsigned char* mem, size_t capacity, unsigned int* sampleOff, bool* sampleLoaded, DivMemoryComposition& compo) {
+  memset(mem,0,capacity);
+  placed.clear();
+  dirty.clear();
+  dirty.push_back(Range(0,capacity));
+  full=true;
+  lastSysID=sysID;
+  lastCapacity=capacity;
+
+  size_t memPos=0;
+  for (int i=0; i<count; i++) {
+    DivSample* s=samples[i];
+    if (s->data8==NULL) continue;
+    if (!s->renderOn[0][sysID]) continue;
+
+    size_t paddedLen=s->length8;
+    if (memPos>=capacity) {
+      logW("out of PCM memory for sample %d!",i);
+      break;
+    }
+    if (memPos+paddedLen>=capacity) {
+      memcpy(mem+memPos,s->data8,capacity-memPos);
+      logW("out of PCM memory for sample %d!",i);
+    } else {
+      memcpy(mem+memPos,s->data8,paddedLen);
+      sampleLoaded[i]=true;
+      placed.push_back(Placement(s,memPos,paddedLen));
+    }
+    sampleOff[i]=memPos;
+    compo.entries.push_back(DivMemoryEntry(DIV_MEMORY_SAMPLE,"Sample",i,memPos,memPos+paddedLen));
+    memPos+=paddedLen;
+  }
+  return memPos;
+}
+
+size_t DivSampleRAM::render(const std::vector<DivSample*>& samples, int count, int sysID, unsigned char* mem, size_t capacity, unsigned int* sampleOff, bool* sampleLoaded, DivMemoryComposition& compo) {
+  memset(sampleOff,0,32768*sizeof(unsigned int));
+  memset(sampleLoaded,0,32768*sizeof(bool));
+
+  if (sysID!=lastSysID || capacity!=lastCapacity) {
+    return layoutAll(samples,count,sysID,mem,capacity,sampleOff,sampleLoaded,compo);
+  }
+
+  // match samples against their previous placement.
+  // samples are matched by pointer so that reordering or deleting samples
+  // does not move the others. contents are compared before uploading.
+  std::unordered_map<DivSample*,size_t> prev;
+  for (size_t i=0; i<placed.size(); i++) {
+    prev[placed[i].sample]=i;
+  }
+  std::vector<bool> kept(placed.size(),false);
+  std::vector<Placement> next;
+  std::vector<int> nextIndex;
+  std::vector<int> pending;
+
+  for (int i=0; i<count; i++) {
+    DivSample* s=samples[i];
+    if (s->data8==NULL) continue;
+    if (!s->renderOn[0][sysID]) continue;
+
+    auto p=prev.find(s);
+    if (p!=prev.end() && !kept[p->second] && placed[p->second].len==s->length8) {
+      kept[p->second]=true;
+      next.push_back(placed[p->second]);
+      nextIndex.push_back(i);
+    } else {
+      pending.push_back(i);
+    }
+  }
+
+  // find the free gaps between kept samples
+  std::vector<Range> gaps;
+  {
+    std::vector<Range> used;
+    for (Placement& i: next) {
+      used.push_back(Range(i.begin,i.begin+i.len));
+    }
+    std::sort(used.begin(),used.end(),[](const Range& a, const Range& b) {
+      return a.begin<b.begin;
+    });
+    size_t pos=0;
+    for (Range& i: used) {
+      if (i.begin>pos) gaps.push_back(Range(pos,i.begin));
+      if (i.end>pos) pos=i.end;
+    }
+    // a sample must end before the end of RAM (see layoutAll)
+    if (pos+1<capacity) gaps.push_back(Range(pos,capacity-1));
+  }
+
+  // place new and resized samples (first fit)
+  size_t keptCount=next.size();
+  for (int i: pending) {
+    DivSample* s=samples[i];
+    bool fit=false;
+    for (Range& j: gaps) {
+      if (j.end-j.begin>=s->length8) {
+        next.push_back(Placement(s,j.begin,s->length8));
+        nextIndex.push_back(i);
+        j.begin+=s->length8;
+        fit=true;
+        break;
+      }
+    }
+    if (!fit) {
+      // fragmented or full. start over.
+      return layoutAll(samples,count,sysID,mem,capacity,sampleOff,sampleLoaded,compo);
+    }
+  }
+
+  // commit
+  dirty.clear();
+  full=false;
+  for (size_t i=0; i<placed.size(); i++) {
+    if (kept[i]) continue;
+    memset(mem+placed[i].begin,0,placed[i].len);
+    dirty.push_back(Range(placed[i].begin,placed[i].begin+placed[i].len));
+  }
+
+  size_t memEnd=0;
+  for (size_t i=0; i<next.size(); i++) {
+    Placement& p=next[i];
+    int index=nextIndex[i];
+    if (i>=keptCount || memcmp(mem+p.begin,p.sample->data8,p.len)!=0) {
+      memcpy(mem+p.begin,p.sample->data8,p.len);
+      dirty.push_back(Range(p.begin,p.begin+p.len));
+    }
+    sampleOff[index]=p.begin;
+    sampleLoaded[index]=true;
+    compo.entries.push_back(DivMemoryEntry(DIV_MEMORY_SAMPLE,"Sample",index,p.begin,p.begin+p.len));
+    if (p.begin+p.len>memEnd) memEnd=p.begin+p.len;
+  }
+  std::sort(compo.entries.begin(),compo.entries.end(),[](const DivMemoryEntry& a, const DivMemoryEntry& b) {
+    return a.begin<b.begin;
+  });
+
+  placed=next;
+  return memEnd;
+}
+
+size_t DivSamplePacker::packInOrder(std::vector<Item>& items, size_t capacity, size_t bankSize, size_t align) {
+  if (align<1) align=1;
+  size_t memPos=0;
+  bool full=false;
+  for (Item& i: items) {
+    i.placed=false;
+    i.truncated=false;
+    i.pos=0;
+    if (full) continue;
+    if (bankSize>0 && (memPos/bankSize)!=((memPos+i.len)/bankSize)) {
+      memPos=((memPos+bankSize-1)/bankSize)*bankSize;
+    }
+    memPos=((memPos+i.len+align-1)/align)*align-i.len;
+    if (memPos>=capacity) {
+      full=true;
+      continue;
+    }
+    if (memPos+i.len>=capacity) {
+      i.len=capacity-memPos;
+      i.truncated=true;
+      full=true;
+    }
+    i.pos=memPos;
+    i.placed=true;
+    memPos+=i.len;
+  }
+  return memPos;
+}
+
+size_t DivSamplePacker::pack(std::vector<Item>& items, size_t capacity, size_t bankSize, size_t align) {
+  if (align<1) align=1;
+  if (bankSize==0) {
+    size_t memPos=0;
+    size_t memEnd=0;
+    for (Item& i: items) {
+      size_t len=((i.len+align-1)/align)*align;
+      i.placed=false;
+      i.truncated=false;
+      i.pos=0;
+      if (memPos+len>capacity) continue;
+      i.pos=memPos+len-i.len;
+      i.placed=true;
+      memEnd=memPos+len;
+      memPos+=len;
+    }
+    return memEnd;
+  }
+  if (bankSize>capacity) bankSize=capacity;
+
+  std::vector<Item*> order;
+  order.reserve(items.size());
+  for (Item& i: items) {
+    i.placed=false;
+    i.truncated=false;
+    i.pos=0;
+    order.push_back(&i);
+  }
+  std::stable_sort(order.begin(),order.end(),[](const Item* a, const Item* b) {
+    return a->len>b->len;
+  });
+
+  // banks by free space. banks with the same free space keep their order.
+  std::multimap<size_t,size_t> banks;
+  std::vector<size_t> bankUsed;
+  for (size_t i=0; i*bankSize<capacity; i++) {
+    banks.insert(std::make_pair(MIN(bankSize,capacity-i*bankSize),i));
+    bankUsed.push_back(0);
+  }
+
+  size_t memEnd=0;
+  for (Item* i: order) {
+    size_t len=((i->len+align-1)/align)*align;
+    auto b=banks.lower_bound(MAX(len,1));
+    if (b==banks.end()) continue;
+    size_t bank=b->second;
+    size_t freeSpace=b->first-len;
+    banks.erase(b);
+    i->pos=bank*bankSize+bankUsed[bank]+len-i->len;
+    i->placed=true;
+    bankUsed[bank]+=len;
+    if (freeSpace>0) banks.insert(std::make_pair(freeSpace,bank));
+    if (i->pos+i->len>memEnd) memEnd=i->pos+i->len;
+  }
+  return memEnd;
+}
@@ -0,0 +1,125 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2026 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _SAMPLE_RAM_H
+#define _SAMPLE_RAM_H
+
+#include <vector>
+#include "dispatch.h"
+
+struct DivSample;
+
+// incremental 8-bit sample RAM allocator.
+// remembers where each sample was placed on the previous render, so that
+// samples which did not change keep their placement and are not copied
+// again. new or resized samples go into free gaps; if they don't fit, the
+// whole RAM is laid out again in sample order.
+class DivSampleRAM {
+  struct Placement {
+    DivSample* sample;
+    size_t begin, len;
+    Placement(DivSample* s, size_t b, size_t l):
+      sample(s),
+      begin(b),
+      len(l) {}
+  };
+  std::vector<Placement> placed;
+  int lastSysID;
+  size_t lastCapacity;
+
+  size_t layoutAll(const std::vector<DivSample*>& samples, int count, int sysID, unsigned char* mem, size_t capacity, unsigned int* sampleOff, bool* sampleLoaded, DivMemoryComposition& compo);
+
+  public:
+    struct Range {
+      size_t begin, end;
+      Range(size_t b, size_t e):
+        begin(b),
+        end(e) {}
+    };
+    // ranges of mem which changed during the last render() call.
+    std::vector<Range> dirty;
+    // whether the last render() call laid out the entire RAM again.
+    bool full;
+
+    /**
+     * place the 8-bit data of every sample rendered on sysID into mem.
+     * fills sampleOff/sampleLoaded (32768 entries each) and the sample entries of compo.
+     * @return the end of the highest placed sample.
+     */
+    size_t render(const std::vector<DivSample*>& samples, int count, int sysID, unsigned char* mem, size_t capacity, unsigned int* sampleOff, bool* sampleLoaded, DivMemoryComposition& compo);
+
+    // forget all placements. the next render() will lay out the entire RAM.
+    void clear();
+
+    DivSampleRAM():
+      lastSysID(-1),
+      lastCapacity(0),
+      full(true) {}
+};
+
+// sample placement for chips whose samples may not cross a bank boundary.
+// every item ends on a multiple of the alignment.
+class DivSamplePacker {
+  public:
+    struct Item {
+      // sample index (not used by the packer)
+      int index;
+      // length in memory
+      size_t len;
+      // filled by pack()/packInOrder()
+      size_t pos;
+      bool placed;
+      // set by packInOrder() if len was shortened to fit
+      bool truncated;
+      Item(int i, size_t l):
+        index(i),
+        len(l),
+        pos(0),
+        placed(false),
+        truncated(false) {}
+    };
+
+    /**
+     * place items one after another in order.
+     * an item which would cross a bank boundary goes to the next bank.
+     * the first item which reaches the end of memory is truncated, and the
+     * ones after it are not placed.
+     * @param items the items.
+     * @param capacity size of memory.
+     * @param bankSize size of a bank, or 0 if there are no banks.
+     * @param align alignment of the end of every item. bankSize must be a multiple of it.
+     * @return the end of the last placed item.
+     */
+    static size_t packInOrder(std::vector<Item>& items, size_t capacity, size_t bankSize, size_t align);
+
+    /**
+     * place items using best-fit decreasing: items are placed from largest
+     * to smallest, each one into the bank with the least free space that can
+     * still hold it. items which don't fit are not placed, but later ones may be.
+     * without banks, items are placed one after another in order.
+     * @param items the items. their order is not changed.
+     * @param capacity size of memory.
+     * @param bankSize size of a bank, or 0 if there are no banks.
+     * @param align alignment of the end of every item. bankSize must be a multiple of it.
+     * @return the end of the highest placed item.
+     */
+    static size_t pack(std::vector<Item>& items, size_t capacity, size_t bankSize, size_t align);
+};
+
+#endif
@@ -38,9 +38,40 @@ DivSongTimestamps::DivSongTimestamps():
   totalTicks(0),
   totalRows(0),
   isLoopDefined(false),
-  isLoopable(true) {
+  isLoopable(true),
+  resumeFrom(INT_MAX) {
   memset(orders,0,DIV_MAX_PATTERNS*sizeof(void*));
   memset(maxRow,0,DIV_MAX_PATTERNS);
+  memset(checkpointOf,-1,DIV_MAX_PATTERNS*sizeof(short));
+}
+
+void DivSongTimestamps::invalidate(int order) {
+  if (order<0 || order>=DIV_MAX_PATTERNS) return;
+  // orders which aren't played don't affect timestamps
+  if (checkpointOf[order]<0) return;
+  if (checkpointOf[order]<resumeFrom) resumeFrom=checkpointOf[order];
+}
+
+void DivSongTimestamps::invalidateAll() {
+  // the parameters won't match
+  params.clear();
+}
+
+void DivSongTimestamps::swap(DivSongTimestamps& other) {
+  std::swap(totalTime,other.totalTime);
+  std::swap(totalTicks,other.totalTicks);
+  std::swap(totalRows,other.totalRows);
+  std::swap(loopStart,other.loopStart);
+  std::swap(loopEnd,other.loopEnd);
+  std::swap(isLoopDefined,other.isLoopDefined);
+  std::swap(isLoopable,other.isLoopable);
+  std::swap(orders,other.orders);
+  std::swap(loopStartTime,other.loopStartTime);
+  std::swap(maxRow,other.maxRow);
+  checkpoints.swap(other.checkpoints);
+  std::swap(checkpointOf,other.checkpointOf);
+  std::swap(resumeFrom,other.resumeFrom);
+  params.swap(other.params);
 }
 
 DivSongTimestamps::~DivSongTimestamps() {
@@ -52,32 +83,61 @@ DivSongTimestamps::~DivSongTimestamps() {
   }
 }
 
-void DivSubSong::calcTimestamps(int chans, std::vector<DivGroovePattern>& grooves, int jumpTreatment, int ignoreJumpAtEnd, int brokenSpeedSel, int delayBehavior, int firstPat) {
+void DivSubSong::getTimestampParams(std::vector<unsigned char>& out, int chans, std::vector<DivGroovePattern>& grooves, int jumpTreatment, int ignoreJumpAtEnd, int brokenSpeedSel, int delayBehavior, int firstPat) {
+  out.clear();
+  auto addParam=[&out](const void* data, size_t len) {
+    out.insert(out.end(),(const unsigned char*)data,(const unsigned char*)data+len);
+  };
+  addParam(&chans,sizeof(int));
+  addParam(&jumpTreatment,sizeof(int));
+  addParam(&ignoreJumpAtEnd,sizeof(int));
+  addParam(&brokenSpeedSel,sizeof(int));
+  addParam(&delayBehavior,sizeof(int));
+  addParam(&firstPat,sizeof(int));
+  addParam(&hz,sizeof(hz));
+  addParam(&patLen,sizeof(patLen));
+  addParam(&ordersLen,sizeof(ordersLen));
+  addParam(&virtualTempoN,sizeof(virtualTempoN));
+  addParam(&virtualTempoD,sizeof(virtualTempoD));
+  addParam(speeds.val,sizeof(speeds.val));
+  addParam(&speeds.len,sizeof(speeds.len));
+  for (DivGroovePattern& i: grooves) {
+    addParam(i.val,sizeof(i.val));
+    addParam(&i.len,sizeof(i.len));
+  }
+  for (int i=0; i<chans; i++) {
+    addParam(&pat[i].effectCols,sizeof(pat[i].effectCols));
+  }
+}
+
+bool DivSubSong::timestampsUpToDate(int chans, std::vector<DivGroovePattern>& grooves, int jumpTreatment, int ignoreJumpAtEnd, int brokenSpeedSel, int delayBehavior, int firstPat) {
+  if (ts.checkpoints.empty() || ts.resumeFrom<(int)ts.checkpoints.size()) return false;
+  std::vector<unsigned char> newParams;
+  getTimestampParams(newParams,chans,grooves,jumpTreatment,ignoreJumpAtEnd,brokenSpeedSel,delayBehavior,firstPat);
+  return newParams==ts.params;
+}
+
+void DivSubSong::calcTimestamps(int chans, std::vector<DivGroovePattern>& grooves, int jumpTreatment, int ignoreJumpAtEnd, int brokenSpeedSel, int delayBehavior, int firstPat, bool incremental) {
   // reduced version of the playback routine for calculation.
   std::chrono::high_resolution_clock::time_point timeStart=std::chrono::high_resolution_clock::now();
 
-  // reset state
-  ts.totalTime=TimeMicros(0,0);
-  ts.totalTicks=0;
-  ts.totalRows=0;
-  ts.isLoopDefined=true;
-  ts.isLoopable=true;
+  // checkpoints may only be used if the song parameters didn't change.
+  std::vector<unsigned char> newParams;
+  getTimestampParams(newParams,chans,grooves,jumpTreatment,ignoreJumpAtEnd,brokenSpeedSel,delayBehavior,firstPat);
 
-  memset(ts.maxRow,0,DIV_MAX_PATTERNS);
-  
-  for (int i=0; i<DIV_MAX_PATTERNS; i++) {
-    if (ts.orders[i]) {
-      delete[] ts.orders[i];
-      ts.orders[i]=NULL;
+  int resumeAt=-1;
+  if (incremental && newParams==ts.params && !ts.checkpoints.empty()) {
+    if (ts.resumeFrom>=(int)ts.checkpoints.size()) {
+      logV("calcTimestamps(): nothing to do");
+      return;
     }
+    resumeAt=ts.resumeFrom;
   }
+  ts.params=newParams;
+  ts.resumeFrom=INT_MAX;
 
   // walking state
   unsigned char wsWalked[8192];
-  memset(wsWalked,0,8192);
-  if (firstPat>0) {
-    memset(wsWalked,255,32*firstPat);
-  }
   int curOrder=firstPat;
   int curRow=0;
   int prevOrder=firstPat;
@@ -102,9 +162,85 @@ void DivSubSong::calcTimestamps(int chans, std::vector<DivGroovePattern>& groove
   bool endOfSong=false;
   bool rowChanged=false;
 
-  memset(rowDelay,0,DIV_MAX_CHANS);
-  memset(delayOrder,0,DIV_MAX_CHANS);
-  memset(delayRow,0,DIV_MAX_CHANS);
+  ts.isLoopable=true;
+
+  if (resumeAt>=0) {
+    // resume from the checkpoint
+    DivSongTimestamps::Checkpoint& c=ts.checkpoints[resumeAt];
+    curOrder=c.order;
+    curRow=c.row;
+    prevOrder=c.prevOrder;
+    prevRow=c.prevRow;
+    curSpeeds=c.speeds;
+    curVirtualTempoN=c.virtualTempoN;
+    curVirtualTempoD=c.virtualTempoD;
+    nextSpeed=c.nextSpeed;
+    divider=c.divider;
+    totalMicrosOff=c.microsOff;
+    ticks=c.ticks;
+    tempoAccum=c.tempoAccum;
+    curSpeed=c.speed;
+    changeOrd=c.changeOrd;
+    changePos=c.changePos;
+    shallStopSched=c.shallStopSched;
+    memcpy(rowDelay,c.rowDelay,DIV_MAX_CHANS);
+    memcpy(delayOrder,c.delayOrder,DIV_MAX_CHANS);
+    memcpy(delayRow,c.delayRow,DIV_MAX_CHANS);
+    memset(wsWalked,0,8192);
+    memcpy(wsWalked,c.walked.data(),c.walked.size());
+
+    ts.totalTime=c.totalTime;
+    ts.totalTicks=c.totalTicks;
+    ts.totalRows=c.totalRows;
+    ts.isLoopDefined=c.isLoopDefined;
+    memcpy(ts.maxRow,c.maxRow,DIV_MAX_PATTERNS);
+
+    // forget rows which were reached after the checkpoint.
+    // time always increases between rows, so these are the ones at or after the checkpoint's time.
+    for (int i=0; i<DIV_MAX_PATTERNS; i++) {
+      if (ts.orders[i]==NULL) continue;
+      for (int j=0; j<DIV_MAX_ROWS; j++) {
+        if (ts.orders[i][j].seconds>=0 && ts.orders[i][j]>=c.totalTime) {
+          ts.orders[i][j]=TimeMicros(-1,0);
+        }
+      }
+    }
+
+    // this and later checkpoints will be created again
+    for (size_t i=resumeAt; i<ts.checkpoints.size(); i++) {
+      ts.checkpointOf[ts.checkpoints[i].order]=-1;
+    }
+    ts.checkpoints.resize(resumeAt);
+    logV("calcTimestamps(): resuming from order %d",curOrder);
+  } else {
+    // reset state
+    ts.totalTime=TimeMicros(0,0);
+    ts.totalTicks=0;
+    ts.totalRows=0;
+    ts.isLoopDefined=true;
+
+    memset(ts.maxRow,0,DIV_MAX_PATTERNS);
+
+    // keep the row arrays around to avoid reallocating them
+    for (int i=0; i<DIV_MAX_PATTERNS; i++) {
+      if (ts.orders[i]) {
+        for (int j=0; j<DIV_MAX_ROWS; j++) {
+          ts.orders[i][j]=TimeMicros(-1,0);
+        }
+      }
+    }
+
+    ts.checkpoints.clear();
+    memset(ts.checkpointOf,-1,DIV_MAX_PATTERNS*sizeof(short));
+
+    memset(wsWalked,0,8192);
+    if (firstPat>0) {
+      memset(wsWalked,255,32*firstPat);
+    }
+    memset(rowDelay,0,DIV_MAX_CHANS);
+    memset(delayOrder,0,DIV_MAX_CHANS);
+    memset(delayRow,0,DIV_MAX_CHANS);
+  }
   if (divider<1) divider=1;
 
   auto tinyProcessRow=[&,this](int i, bool afterDelay) {
@@ -351,6 +487,40 @@ void DivSubSong::calcTimestamps(int chans, std::vector<DivGroovePattern>& groove
 
   // MAKE IT WORK
   while (!endOfSong) {
+    // save a checkpoint if this is the first time we enter this order.
+    // none of its rows have been processed yet.
+    if (!songWillEnd && curOrder>=0 && curOrder<DIV_MAX_PATTERNS && ts.checkpointOf[curOrder]<0) {
+      ts.checkpointOf[curOrder]=ts.checkpoints.size();
+      ts.checkpoints.push_back(DivSongTimestamps::Checkpoint());
+      DivSongTimestamps::Checkpoint& c=ts.checkpoints.back();
+      c.order=curOrder;
+      c.row=curRow;
+      c.prevOrder=prevOrder;
+      c.prevRow=prevRow;
+      c.speeds=curSpeeds;
+      c.virtualTempoN=curVirtualTempoN;
+      c.virtualTempoD=curVirtualTempoD;
+      c.nextSpeed=nextSpeed;
+      c.divider=divider;
+      c.microsOff=totalMicrosOff;
+      c.ticks=ticks;
+      c.tempoAccum=tempoAccum;
+      c.speed=curSpeed;
+      c.changeOrd=changeOrd;
+      c.changePos=changePos;
+      c.shallStopSched=shallStopSched;
+      memcpy(c.rowDelay,rowDelay,DIV_MAX_CHANS);
+      memcpy(c.delayOrder,delayOrder,DIV_MAX_CHANS);
+      memcpy(c.delayRow,delayRow,DIV_MAX_CHANS);
+      c.walked.assign(wsWalked,wsWalked+MIN(8192,32*ordersLen));
+
+      c.totalTime=ts.totalTime;
+      c.totalTicks=ts.totalTicks;
+      c.totalRows=ts.totalRows;
+      c.isLoopDefined=ts.isLoopDefined;
+      memcpy(c.maxRow,ts.maxRow,DIV_MAX_PATTERNS);
+    }
+
     // if the virtual tempo nominator is zero, the song will go on forever.
     if (curVirtualTempoN<1) {
       ts.totalTime.seconds=INT_MAX;
@@ -731,12 +901,16 @@ void DivSubSong::optimizePatterns() {
   for (int i=0; i<DIV_MAX_CHANS; i++) {
     logD("optimizing channel %d...",i);
     std::vector<std::pair<int,int>> clearOuts=pat[i].optimize();
+    if (clearOuts.empty()) continue;
+    unsigned char remap[DIV_MAX_PATTERNS];
+    for (int j=0; j<DIV_MAX_PATTERNS; j++) {
+      remap[j]=j;
+    }
     for (auto& j: clearOuts) {
-      for (int k=0; k<DIV_MAX_PATTERNS; k++) {
-        if (orders.ord[i][k]==j.first) {
-          orders.ord[i][k]=j.second;
-        }
-      }
+      remap[j.first]=j.second;
+    }
+    for (int k=0; k<DIV_MAX_PATTERNS; k++) {
+      orders.ord[i][k]=remap[orders.ord[i][k]];
     }
   }
 }
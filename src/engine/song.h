@@ -39,7 +39,8 @@ enum DivEffectType: unsigned short {
   DIV_EFFECT_DUMMY,
   DIV_EFFECT_EXTERNAL,
   DIV_EFFECT_VOLUME,
-  DIV_EFFECT_FILTER
+  DIV_EFFECT_FILTER,
+  DIV_EFFECT_LIMITER
 };
 
 enum DivFileElementType: unsigned char {
@@ -98,9 +99,47 @@ struct DivSongTimestamps {
   // the furthest row that the playhead goes through in an order.
   unsigned char maxRow[DIV_MAX_PATTERNS];
 
+  // calculation state at the moment an order is entered for the first time.
+  // used to resume calculation after an edit, rather than walking the entire song again.
+  struct Checkpoint {
+    int order, row, prevOrder, prevRow;
+    DivGroovePattern speeds;
+    int virtualTempoN, virtualTempoD;
+    int nextSpeed, ticks, tempoAccum, speed;
+    int changeOrd, changePos;
+    double divider, microsOff;
+    bool shallStopSched, isLoopDefined;
+    TimeMicros totalTime;
+    uint64_t totalTicks;
+    int totalRows;
+    unsigned char rowDelay[DIV_MAX_CHANS];
+    unsigned char delayOrder[DIV_MAX_CHANS];
+    unsigned char delayRow[DIV_MAX_CHANS];
+    unsigned char maxRow[DIV_MAX_PATTERNS];
+    std::vector<unsigned char> walked;
+  };
+  std::vector<Checkpoint> checkpoints;
+  // index of the checkpoint of each order (-1 if the order is not played).
+  short checkpointOf[DIV_MAX_PATTERNS];
+  // the earliest checkpoint which is affected by an edit.
+  // INT_MAX if timestamps are up to date.
+  int resumeFrom;
+  // song parameters used in the last calculation.
+  // if any of these change, a full calculation is performed.
+  std::vector<unsigned char> params;
+
   // call this function to get the timestamp of a row.
   TimeMicros getTimes(int order, int row);
 
+  // mark an order as edited, so that the next incremental calculation starts from it.
+  void invalidate(int order);
+
+  // mark everything as edited, so that the next calculation starts from the beginning.
+  void invalidateAll();
+
+  // exchange contents with another instance (used to publish a background calculation).
+  void swap(DivSongTimestamps& other);
+
   DivSongTimestamps();
   ~DivSongTimestamps();
 };
@@ -130,8 +169,21 @@ struct DivSubSong {
 
   /**
    * calculate timestamps (loop position, song length and more).
+   * if incremental is true, calculation resumes from the earliest order marked with
+   * ts.invalidate(), provided that the song parameters didn't change.
+   */
+  void calcTimestamps(int chans, std::vector<DivGroovePattern>& grooves, int jumpTreatment, int ignoreJumpAtEnd, int brokenSpeedSel, int delayBehavior, int firstPat=0, bool incremental=false);
+
+  /**
+   * check whether timestamps are up to date (nothing was invalidated and the
+   * song parameters didn't change since the last calculation).
+   */
+  bool timestampsUpToDate(int chans, std::vector<DivGroovePattern>& grooves, int jumpTreatment, int ignoreJumpAtEnd, int brokenSpeedSel, int delayBehavior, int firstPat=0);
+
+  /**
+   * gather everything (besides pattern data and orders) which affects timestamps.
    */
-  void calcTimestamps(int chans, std::vector<DivGroovePattern>& grooves, int jumpTreatment, int ignoreJumpAtEnd, int brokenSpeedSel, int delayBehavior, int firstPat=0);
+  void getTimestampParams(std::vector<unsigned char>& out, int chans, std::vector<DivGroovePattern>& grooves, int jumpTreatment, int ignoreJumpAtEnd, int brokenSpeedSel, int delayBehavior, int firstPat);
 
   /**
    * read sub-song data.
@@ -409,12 +409,12 @@ template<const int shift> int effectValShift(unsigned char, unsigned char val) {
 };
 
 template<const int maxOp> int effectOpVal(unsigned char, unsigned char val) {
-  if ((val>>4)>maxOp) throw DivDoNotHandleEffect();
+  if ((val>>4)>maxOp) return DIV_EFFECT_NOT_HANDLED;
   return (val>>4)-1;
 };
 
 template<const int maxOp> int effectOpValNoZero(unsigned char, unsigned char val) {
-  if ((val>>4)<1 || (val>>4)>maxOp) throw DivDoNotHandleEffect();
+  if ((val>>4)<1 || (val>>4)>maxOp) return DIV_EFFECT_NOT_HANDLED;
   return (val>>4)-1;
 };
 
@@ -461,6 +461,13 @@ template<int type, DivInstrumentType insType, DivInstrumentType insType2=DIV_INS
 void DivEngine::registerSystems() {
   logD("registering systems...");
 
+  // these are shared by all engines, so they are cleared here rather than in the constructor
+  memset(sysDefs,0,DIV_MAX_CHIP_DEFS*sizeof(void*));
+  for (int i=0; i<DIV_MAX_CHIP_DEFS; i++) {
+    sysFileMapFur[i]=DIV_SYSTEM_NULL;
+    sysFileMapDMF[i]=DIV_SYSTEM_NULL;
+  }
+
   // Common effect handler maps
 
   EffectHandlerMap ayPostEffectHandlerMap={
@@ -2780,6 +2787,7 @@ void DivEngine::registerSystems() {
 
   for (int i=0; i<DIV_MAX_CHIP_DEFS; i++) {
     if (sysDefs[i]==NULL) continue;
+    sysDefs[i]->compileEffectTables();
     if (sysDefs[i]->id!=0) {
       sysFileMapFur[sysDefs[i]->id]=(DivSystem)i;
     }
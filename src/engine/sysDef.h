@@ -23,11 +23,16 @@
 #include "dispatch.h"
 #include "instrument.h"
 #include <functional>
+#include <limits.h>
+#include <string.h>
 #include <initializer_list>
 #include <vector>
 
 typedef int EffectValConversion(unsigned char,unsigned char);
 
+// returned by an EffectValConversion if the effect shall not be handled
+#define DIV_EFFECT_NOT_HANDLED INT_MIN
+
 struct EffectHandler {
   DivDispatchCmds dispatchCmd;
   const char* description;
@@ -45,11 +50,32 @@ struct EffectHandler {
   val2(val2_) {}
 };
 
-struct DivDoNotHandleEffect {
-};
-
 typedef std::unordered_map<unsigned char,const EffectHandler> EffectHandlerMap;
 
+// an EffectHandlerMap flattened for lookups during playback.
+struct DivEffectTable {
+  // index into list plus one, or 0 if the effect isn't handled
+  unsigned short index[256];
+  std::vector<EffectHandler> list;
+
+  const EffectHandler* get(unsigned char effect) const {
+    if (index[effect]==0) return NULL;
+    return &list[index[effect]-1];
+  }
+  void compile(const EffectHandlerMap& map) {
+    memset(index,0,256*sizeof(unsigned short));
+    list.clear();
+    list.reserve(map.size());
+    for (const auto& i: map) {
+      list.push_back(i.second);
+      index[i.first]=list.size();
+    }
+  }
+  DivEffectTable() {
+    memset(index,0,256*sizeof(unsigned short));
+  }
+};
+
 enum DivChanTypes {
   DIV_CH_FM=0,
   DIV_CH_PULSE=1,
@@ -147,6 +173,15 @@ struct DivSysDef {
   const EffectHandlerMap effectHandlers;
   const EffectHandlerMap postEffectHandlers;
   const EffectHandlerMap preEffectHandlers;
+  // built by compileEffectTables() from the maps above
+  DivEffectTable effectTable, postEffectTable, preEffectTable;
+
+  void compileEffectTables() {
+    effectTable.compile(effectHandlers);
+    postEffectTable.compile(postEffectHandlers);
+    preEffectTable.compile(preEffectHandlers);
+  }
+
   DivSysDef(
     const char* sysName, const char* sysNameJ, unsigned char fileID, unsigned char fileID_DMF, int chans, int minCh, int maxCh,
     bool isFMChip, bool isSTDChip, unsigned int vgmVer, bool compound, unsigned int formatMask, unsigned short waveWid, unsigned short waveHei,
@@ -0,0 +1,133 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2026 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// per-thread event ring buffers and Chrome trace export.
+// each thread writes to its own buffer without locking. a dump may race with
+// the writers, in which case the oldest events can come out garbled.
+
+#include "trace.h"
+#include "../ta-log.h"
+#include "../fileutils.h"
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+struct DivTraceEvent {
+  const char* name;
+  const char* detail;
+  unsigned long long begin, end;
+};
+
+struct DivTraceBuffer {
+  DivTraceEvent events[DIV_TRACE_EVENTS];
+  std::atomic<unsigned int> pos;
+  const char* name;
+  DivTraceBuffer():
+    pos(0),
+    name(NULL) {}
+};
+
+static std::mutex traceBuffersLock;
+static std::vector<DivTraceBuffer*> traceBuffers;
+static thread_local DivTraceBuffer* traceBuf=NULL;
+
+static DivTraceBuffer* getTraceBuffer() {
+  if (traceBuf!=NULL) return traceBuf;
+  // allocated once per thread and never freed, so that a dump can still read it
+  traceBuf=new DivTraceBuffer;
+  std::lock_guard<std::mutex> lock(traceBuffersLock);
+  traceBuffers.push_back(traceBuf);
+  return traceBuf;
+}
+
+void divTraceRecord(const char* name, const char* detail, unsigned long long begin, unsigned long long end) {
+  DivTraceBuffer* buf=getTraceBuffer();
+  unsigned int pos=buf->pos.load(std::memory_order_relaxed);
+  DivTraceEvent& e=buf->events[pos%DIV_TRACE_EVENTS];
+  e.name=name;
+  e.detail=detail;
+  e.begin=begin;
+  e.end=end;
+  buf->pos.store(pos+1,std::memory_order_release);
+}
+
+void divTraceThreadName(const char* name) {
+  getTraceBuffer()->name=name;
+}
+
+static void writeTraceString(FILE* f, const char* s) {
+  fputc('"',f);
+  for (const char* i=s; *i; i++) {
+    if (*i=='"' || *i=='\\') fputc('\\',f);
+    fputc(*i,f);
+  }
+  fputc('"',f);
+}
+
+bool divTraceDump(const char* path, double seconds) {
+  unsigned long long now=divProfileNow();
+  unsigned long long span=(unsigned long long)(seconds*1000000000.0);
+  unsigned long long from=(span<now)?(now-span):0;
+
+  FILE* f=ps_fopen(path,"wb");
+  if (f==NULL) {
+    logE("could not open trace file %s!",path);
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(traceBuffersLock);
+  size_t total=0;
+  bool first=true;
+  fprintf(f,"{\"displayTimeUnit\": \"ns\", \"traceEvents\": [");
+  for (size_t i=0; i<traceBuffers.size(); i++) {
+    DivTraceBuffer* buf=traceBuffers[i];
+    unsigned int pos=buf->pos.load(std::memory_order_acquire);
+    unsigned int count=(pos<DIV_TRACE_EVENTS)?pos:DIV_TRACE_EVENTS;
+
+    // thread name
+    fprintf(f,"%s\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": ",first?"":",",(int)i+1);
+    if (buf->name!=NULL) {
+      writeTraceString(f,buf->name);
+    } else {
+      fprintf(f,"\"thread %d\"",(int)i+1);
+    }
+    fprintf(f,"}}");
+    first=false;
+
+    for (unsigned int j=pos-count; j!=pos; j++) {
+      const DivTraceEvent& e=buf->events[j%DIV_TRACE_EVENTS];
+      if (e.name==NULL || e.begin<from) continue;
+      fprintf(f,",\n{\"name\": ");
+      writeTraceString(f,e.name);
+      fprintf(f,", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f",(int)i+1,(double)(e.begin-from)/1000.0,(double)(e.end-e.begin)/1000.0);
+      if (e.detail!=NULL) {
+        fprintf(f,", \"args\": {\"detail\": ");
+        writeTraceString(f,e.detail);
+        fprintf(f,"}");
+      }
+      fprintf(f,"}");
+      total++;
+    }
+  }
+  fprintf(f,"\n]}\n");
+  fclose(f);
+
+  logI("wrote %d trace events to %s",(int)total,path);
+  return true;
+}
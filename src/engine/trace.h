@@ -0,0 +1,68 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2026 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _TRACE_H
+#define _TRACE_H
+
+// timeline tracing (for debugging).
+// when built with DIV_TRACE (the WITH_TRACE CMake option), scopes marked with
+// DIV_TRACE_SCOPE are recorded into a ring buffer owned by the calling thread.
+// divTraceDump() writes the last few seconds in Chrome trace format, which can
+// be opened in chrome://tracing or Perfetto.
+// without DIV_TRACE the macros do nothing.
+
+#ifdef DIV_TRACE
+#include "engine.h"
+
+// number of events kept per thread.
+#define DIV_TRACE_EVENTS 65536
+// length of the trace written by -trace (in seconds).
+#define DIV_TRACE_DUMP_SECONDS 10.0
+
+// record an event. name and detail must be string literals or otherwise outlive the program.
+// begin and end are in nanoseconds (see divProfileNow()).
+void divTraceRecord(const char* name, const char* detail, unsigned long long begin, unsigned long long end);
+// set the name of the calling thread in the trace.
+void divTraceThreadName(const char* name);
+// write the events of the last `seconds` seconds to a file.
+bool divTraceDump(const char* path, double seconds);
+
+struct DivTraceScope {
+  const char* name;
+  const char* detail;
+  unsigned long long begin;
+  DivTraceScope(const char* n, const char* d=NULL):
+    name(n),
+    detail(d),
+    begin(divProfileNow()) {}
+  ~DivTraceScope() {
+    divTraceRecord(name,detail,begin,divProfileNow());
+  }
+};
+
+#define DIV_TRACE_SCOPE(...) DivTraceScope _traceScope(__VA_ARGS__)
+#define DIV_TRACE_RECORD(_n,_d,_b,_e) divTraceRecord(_n,_d,_b,_e)
+#define DIV_TRACE_THREAD(_n) divTraceThreadName(_n)
+#else
+#define DIV_TRACE_SCOPE(...)
+#define DIV_TRACE_RECORD(_n,_d,_b,_e)
+#define DIV_TRACE_THREAD(_n)
+#endif
+
+#endif
@@ -21,16 +21,37 @@
 #include "../ta-log.h"
 #include "../utfutils.h"
 #include "song.h"
+#include <atomic>
+#include <unordered_map>
 
 // this function is so long
 // may as well make it something else
-void DivEngine::performVGMWrite(SafeWriter* w, DivSystem sys, DivRegWrite& write, int streamOff, double* loopTimer, double* loopFreq, int* loopSample, bool* sampleDir, bool isSecond, int* pendingFreq, int* playingSample, int* setPos, unsigned int* sampleOff8, unsigned int* sampleLen8, size_t bankOffset, bool directStream, bool* sampleStoppable, bool dpcm07, DivDispatch** writeNES, int rateCorrection) {
-  unsigned char baseAddr1=isSecond?0xa0:0x50;
-  unsigned char baseAddr2=isSecond?0x80:0;
-  unsigned short baseAddr2S=isSecond?0x8000:0;
-  unsigned char smsAddr=isSecond?0x30:0x50;
-  unsigned char ggAddr=isSecond?0x3f:0x4f;
-  unsigned char rf5c68Addr=isSecond?0xb1:0xb0;
+void DivEngine::performVGMWrite(SafeWriter* w, const DivVGMWriteEncoder& enc, const DivRegWrite& write) {
+  const DivSystem sys=enc.sys;
+  const bool isSecond=enc.isSecond;
+  const int streamOff=enc.streamOff;
+  const size_t bankOffset=enc.bankOffset;
+  const unsigned char baseAddr1=enc.baseAddr1;
+  const unsigned char baseAddr2=enc.baseAddr2;
+  const unsigned short baseAddr2S=enc.baseAddr2S;
+  const unsigned char smsAddr=enc.smsAddr;
+  const unsigned char ggAddr=enc.ggAddr;
+  const unsigned char rf5c68Addr=enc.rf5c68Addr;
+  DivVGMStreamState* st=enc.streams;
+  double* loopTimer=st->loopTimer;
+  double* loopFreq=st->loopFreq;
+  int* loopSample=st->loopSample;
+  bool* sampleDir=st->sampleDir;
+  int* pendingFreq=st->pendingFreq;
+  int* playingSample=st->playingSample;
+  bool* sampleStoppable=st->sampleStoppable;
+  int* setPos=st->setPos;
+  const unsigned int* sampleOff8=st->sampleOff8;
+  const unsigned int* sampleLen8=st->sampleLen8;
+  const unsigned short* sampleBlock=st->sampleBlock;
+  const bool directStream=st->directStream;
+  const bool dpcm07=st->dpcm07;
+  const int rateCorrection=st->rateCorrection;
   if (write.addr==0xffffffff) { // Furnace fake reset
     switch (sys) {
       case DIV_SYSTEM_YM2612:
@@ -745,7 +766,7 @@ void DivEngine::performVGMWrite(SafeWriter* w, DivSystem sys, DivRegWrite& write
           // write the whole damn bank.
           // this code looks like a mess because it is a hack.
           // don't blame me if your VGM ends up being over a gigabyte!
-          size_t howMuchWillBeWritten=writeNES[isSecond?1:0]->getSampleMemUsage();
+          size_t howMuchWillBeWritten=enc.nes->getSampleMemUsage();
           // refuse to switch if we're going out of bounds
           if ((write.val<<14)>=howMuchWillBeWritten) break;
           howMuchWillBeWritten-=(write.val<<14);
@@ -756,7 +777,7 @@ void DivEngine::performVGMWrite(SafeWriter* w, DivSystem sys, DivRegWrite& write
           w->writeI((isSecond?0x80000000:0)|(howMuchWillBeWritten+2));
           // data
           w->writeS(0xc000);
-          w->write(&(((unsigned char*)writeNES[isSecond?1:0]->getSampleMem())[write.val<<14]),howMuchWillBeWritten);
+          w->write(&(((unsigned char*)enc.nes->getSampleMem())[write.val<<14]),howMuchWillBeWritten);
         }
         break;
       }
@@ -795,7 +816,7 @@ void DivEngine::performVGMWrite(SafeWriter* w, DivSystem sys, DivRegWrite& write
               } else {
                 w->writeC(0x95);
                 w->writeC(streamID);
-                w->writeS(write.val); // sample number
+                w->writeS(sampleBlock[write.val&0x7fff]); // sample number
                 w->writeC((sample->getLoopStartPosition(DIV_SAMPLE_DEPTH_8BIT)==0 && sample->isLoopable())|(sampleDir[streamID]?0x10:0)); // flags
               }
 
@@ -838,7 +859,7 @@ void DivEngine::performVGMWrite(SafeWriter* w, DivSystem sys, DivRegWrite& write
             } else {
               w->writeC(0x95);
               w->writeC(streamID);
-              w->writeS(pendingFreq[streamID]); // sample number
+              w->writeS(sampleBlock[pendingFreq[streamID]&0x7fff]); // sample number
               w->writeC((sample->getLoopStartPosition(DIV_SAMPLE_DEPTH_8BIT)==0 && sample->isLoopable())|(sampleDir[streamID]?0x10:0)); // flags
             }
 
@@ -890,7 +911,7 @@ void DivEngine::performVGMWrite(SafeWriter* w, DivSystem sys, DivRegWrite& write
             } else {
               w->writeC(0x95);
               w->writeC(streamID);
-              w->writeS(playingSample[streamID]); // sample number
+              w->writeS(sampleBlock[playingSample[streamID]&0x7fff]); // sample number
               w->writeC((sample->getLoopStartPosition(DIV_SAMPLE_DEPTH_8BIT)==0 && sample->isLoopable())|(sampleDir[streamID]?0x10:0)); // flags
             }
 
@@ -1236,6 +1257,50 @@ void DivEngine::performVGMWrite(SafeWriter* w, DivSystem sys, DivRegWrite& write
   }
 }
 
+// whether two samples produce the same stream data blocks.
+static bool isSameStreamData(DivSample* a, DivSample* b) {
+  if (a->length8!=b->length8 || a->lengthVOX!=b->lengthVOX) return false;
+  if (a->length8>0 && memcmp(a->data8,b->data8,a->length8)!=0) return false;
+  if (a->lengthVOX>0 && memcmp(a->dataVOX,b->dataVOX,a->lengthVOX)!=0) return false;
+  return true;
+}
+
+// write a stream data block. every value in data must fit in bits.
+// if pack is true and bits is less than 8, a bit-packed block is written (VGM 1.51).
+static void writeStreamBlock(SafeWriter* w, unsigned char type, const unsigned char* data, unsigned int len, int bits, bool pack) {
+  w->writeC(0x67);
+  w->writeC(0x66);
+  if (!pack || bits>=8 || len==0) {
+    w->writeC(type);
+    w->writeI(len);
+    w->write(data,len);
+    return;
+  }
+  unsigned int packedLen=(unsigned int)(((unsigned long long)len*bits+7)>>3);
+  w->writeC(0x40|type);
+  w->writeI(packedLen+10);
+  w->writeC(0); // bit packing
+  w->writeI(len); // uncompressed size
+  w->writeC(8); // bits per value (decompressed)
+  w->writeC(bits); // bits per value (compressed)
+  w->writeC(0); // copy
+  w->writeS(0); // value to add
+  // values are stored from the highest bit down
+  unsigned int acc=0;
+  int accBits=0;
+  for (unsigned int i=0; i<len; i++) {
+    acc=(acc<<bits)|(data[i]&((1<<bits)-1));
+    accBits+=bits;
+    if (accBits>=8) {
+      accBits-=8;
+      w->writeC((acc>>accBits)&0xff);
+    }
+  }
+  if (accBits>0) {
+    w->writeC((acc<<(8-accBits))&0xff);
+  }
+}
+
 #define CHIP_VOL(_id,_mult) { \
   double _vol=fabs((float)song.systemVol[i])*256.0*_mult; \
   if (_vol<0.0) _vol=0.0; \
@@ -1254,7 +1319,8 @@ void DivEngine::performVGMWrite(SafeWriter* w, DivSystem sys, DivRegWrite& write
   chipVol.push_back((_id)|(0x80000100)|(((unsigned int)_vol)<<16)); \
 }
 
-SafeWriter* DivEngine::saveVGM(bool* sysToExport, bool loop, int version, bool patternHints, bool directStream, int trailingTicks, bool dpcm07, int correctedRate) {
+SafeWriter* DivEngine::saveVGM(bool* sysToExport, bool loop, int version, bool patternHints, bool directStream, int trailingTicks, bool dpcm07, int correctedRate, bool dedupeWrites, bool packSamples) {
+  waitForSamples();
   if (version<0x150) {
     lastError="VGM version is too low";
     return NULL;
@@ -1344,6 +1410,7 @@ SafeWriter* DivEngine::saveVGM(bool* sysToExport, bool loop, int version, bool p
 
   unsigned int* sampleOff8=new unsigned int[32768];
   unsigned int* sampleLen8=new unsigned int[32768];
+  unsigned short* sampleBlock=new unsigned short[32768];
   unsigned int* sampleOffSegaPCM=new unsigned int[32768];
 
   SafeWriter* w=new SafeWriter;
@@ -1358,14 +1425,11 @@ SafeWriter* DivEngine::saveVGM(bool* sysToExport, bool loop, int version, bool p
   bool isSecond[DIV_MAX_CHIPS];
   int streamIDs[DIV_MAX_CHIPS];
   size_t bankOffset[DIV_MAX_CHIPS];
-  double loopTimer[DIV_MAX_CHANS];
-  double loopFreq[DIV_MAX_CHANS];
-  int loopSample[DIV_MAX_CHANS];
-  bool sampleDir[DIV_MAX_CHANS];
-  int pendingFreq[DIV_MAX_CHANS];
-  int playingSample[DIV_MAX_CHANS];
-  bool sampleStoppable[DIV_MAX_CHANS];
-  int setPos[DIV_MAX_CHANS];
+  DivVGMStreamState streamState;
+  DivVGMWriteEncoder vgmEnc[DIV_MAX_CHIPS];
+  double* loopTimer=streamState.loopTimer;
+  double* loopFreq=streamState.loopFreq;
+  int* loopSample=streamState.loopSample;
   std::vector<unsigned int> chipVol;
   std::vector<DivDelayedWrite> delayedWrites[DIV_MAX_CHIPS];
   std::vector<std::pair<int,DivDelayedWrite>> sortedWrites;
@@ -1379,17 +1443,6 @@ SafeWriter* DivEngine::saveVGM(bool* sysToExport, bool loop, int version, bool p
 
   memset(bankOffset,0,DIV_MAX_CHIPS*sizeof(size_t));
 
-  for (int i=0; i<DIV_MAX_CHANS; i++) {
-    loopTimer[i]=0;
-    loopFreq[i]=0;
-    loopSample[i]=-1;
-    pendingFreq[i]=-1;
-    playingSample[i]=-1;
-    setPos[i]=0;
-    sampleDir[i]=false;
-    sampleStoppable[i]=true;
-  }
-
   bool writeDACSamples=false;
   bool writeNESSamples=false;
   bool writePCESamples=false;
@@ -2233,18 +2286,55 @@ SafeWriter* DivEngine::saveVGM(bool* sysToExport, bool loop, int version, bool p
   memset(sampleLen8,0,32768*sizeof(unsigned int));
   memset(sampleOffSegaPCM,0,32768*sizeof(unsigned int));
 
+  // identical samples share one data block
+  std::vector<int> sampleSame(song.sampleLen,-1);
+  if (packSamples) {
+    std::unordered_multimap<unsigned int,int> sampleHashes;
+    for (int i=0; i<song.sampleLen; i++) {
+      DivSample* sample=song.sample[i];
+      unsigned int hash=2166136261u;
+      for (unsigned int j=0; j<sample->length8; j++) {
+        hash=(hash^(unsigned char)sample->data8[j])*16777619u;
+      }
+      auto same=sampleHashes.equal_range(hash);
+      for (auto j=same.first; j!=same.second; j++) {
+        if (isSameStreamData(sample,song.sample[j->second])) {
+          sampleSame[i]=j->second;
+          break;
+        }
+      }
+      if (sampleSame[i]==-1) {
+        sampleHashes.insert(std::pair<unsigned int,int>(hash,i));
+      } else {
+        logD("sample %d is the same as %d",i,sampleSame[i]);
+      }
+    }
+  }
+  // stream data may be bit-packed since VGM 1.51
+  bool packBlocks=packSamples && version>=0x151;
+
   // write samples
   unsigned int sampleSeek=0;
+  unsigned short sampleBlocks=0;
   for (int i=0; i<song.sampleLen; i++) {
     DivSample* sample=song.sample[i];
+    sampleLen8[i]=sample->length8;
+    if (sampleSame[i]>=0) {
+      sampleOff8[i]=sampleOff8[sampleSame[i]];
+      sampleBlock[i]=sampleBlock[sampleSame[i]];
+      continue;
+    }
     logI("setting seek to %d",sampleSeek);
     sampleOff8[i]=sampleSeek;
-    sampleLen8[i]=sample->length8;
+    sampleBlock[i]=sampleBlocks++;
     sampleSeek+=sample->length8;
   }
 
+  std::vector<unsigned char> streamData;
+
   if (writeDACSamples && !directStream) for (int i=0; i<song.sampleLen; i++) {
     DivSample* sample=song.sample[i];
+    if (sampleSame[i]>=0) continue;
     w->writeC(0x67);
     w->writeC(0x66);
     w->writeC(0);
@@ -2256,29 +2346,28 @@ SafeWriter* DivEngine::saveVGM(bool* sysToExport, bool loop, int version, bool p
 
   if (writeNESSamples && !directStream) for (int i=0; i<song.sampleLen; i++) {
     DivSample* sample=song.sample[i];
-    w->writeC(0x67);
-    w->writeC(0x66);
-    w->writeC(7);
-    w->writeI(sample->length8);
+    if (sampleSame[i]>=0) continue;
+    streamData.resize(sample->length8);
     for (unsigned int j=0; j<sample->length8; j++) {
-      w->writeC(((unsigned char)sample->data8[j]^0x80)>>1);
+      streamData[j]=((unsigned char)sample->data8[j]^0x80)>>1;
     }
+    writeStreamBlock(w,7,streamData.data(),sample->length8,7,packBlocks);
     bankOffsetNESCurrent+=sample->length8;
   }
 
   if (writePCESamples && !directStream) for (int i=0; i<song.sampleLen; i++) {
     DivSample* sample=song.sample[i];
-    w->writeC(0x67);
-    w->writeC(0x66);
-    w->writeC(5);
-    w->writeI(sample->length8);
+    if (sampleSame[i]>=0) continue;
+    streamData.resize(sample->length8);
     for (unsigned int j=0; j<sample->length8; j++) {
-      w->writeC(((unsigned char)sample->data8[j]^0x80)>>3);
+      streamData[j]=((unsigned char)sample->data8[j]^0x80)>>3;
     }
+    writeStreamBlock(w,5,streamData.data(),sample->length8,5,packBlocks);
   }
 
   if (writeVOXSamples && !directStream) for (int i=0; i<song.sampleLen; i++) {
     DivSample* sample=song.sample[i];
+    if (sampleSame[i]>=0) continue;
     w->writeC(0x67);
     w->writeC(0x66);
     w->writeC(4);
@@ -2291,6 +2380,7 @@ SafeWriter* DivEngine::saveVGM(bool* sysToExport, bool loop, int version, bool p
 
   if (writeLynxSamples && !directStream) for (int i=0; i<song.sampleLen; i++) {
     DivSample* sample=song.sample[i];
+    if (sampleSame[i]>=0) continue;
     w->writeC(0x67);
     w->writeC(0x66);
     w->writeC(8);
@@ -2462,14 +2552,19 @@ SafeWriter* DivEngine::saveVGM(bool* sysToExport, bool loop, int version, bool p
     if (writeNES[i]!=NULL && writeNES[i]->getSampleMemUsage()>0) {
       if (dpcm07) {
         size_t howMuchWillBeWritten=writeNES[i]->getSampleMemUsage();
-        w->writeC(0x67);
-        w->writeC(0x66);
-        w->writeC(7);
-        w->writeI(howMuchWillBeWritten);
-        w->write(writeNES[i]->getSampleMem(),howMuchWillBeWritten);
-        bankOffsetNES[i]=bankOffsetNESCurrent;
+        if (packSamples && i==1 && writeNES[0]->getSampleMemUsage()==howMuchWillBeWritten && memcmp(writeNES[0]->getSampleMem(),writeNES[1]->getSampleMem(),howMuchWillBeWritten)==0) {
+          // same DPCM data as the first chip
+          bankOffsetNES[i]=bankOffsetNES[0];
+        } else {
+          w->writeC(0x67);
+          w->writeC(0x66);
+          w->writeC(7);
+          w->writeI(howMuchWillBeWritten);
+          w->write(writeNES[i]->getSampleMem(),howMuchWillBeWritten);
+          bankOffsetNES[i]=bankOffsetNESCurrent;
+          bankOffsetNESCurrent+=howMuchWillBeWritten;
+        }
         bankOffset[writeNESIndex[i]]=bankOffsetNES[i];
-        bankOffsetNESCurrent+=howMuchWillBeWritten;
         // force the first bank
         w->writeC(0x68);
         w->writeC(0x6c);
@@ -2673,11 +2768,25 @@ SafeWriter* DivEngine::saveVGM(bool* sysToExport, bool loop, int version, bool p
     }
   }
 
+  // set up write encoders
+  streamState.sampleOff8=sampleOff8;
+  streamState.sampleLen8=sampleLen8;
+  streamState.sampleBlock=sampleBlock;
+  streamState.directStream=directStream;
+  streamState.dpcm07=dpcm07;
+  streamState.rateCorrection=correctedRate;
+  for (int i=0; i<song.systemLen; i++) {
+    vgmEnc[i].init(song.system[i],isSecond[i],streamIDs[i],bankOffset[i],writeNES[isSecond[i]?1:0],&streamState);
+  }
+
   // write song data
   playSub(false);
   size_t tickCount=0;
   bool writeLoop=false;
   bool alreadyWroteLoop=false;
+  // last value written to each register, for dedupeWrites
+  std::unordered_map<unsigned int,unsigned int> regShadow[DIV_MAX_CHIPS];
+  int droppedWrites=0;
   int ord=-1;
   int exportChans=0;
   for (int i=0; i<song.chans; i++) {
@@ -2848,6 +2957,18 @@ SafeWriter* DivEngine::saveVGM(bool* sysToExport, bool loop, int version, bool p
           curDelay+=(double)j.val*(44100.0/(double)disCont[i].dispatch->rate);
           if (curDelay>totalWait) curDelay=totalWait-1;
         } else {
+          if (dedupeWrites) {
+            if (j.addr==0xffffffff) {
+              regShadow[i].clear();
+            } else if (disCont[i].dispatch->isRegWriteIdempotent(j.addr)) {
+              auto shadow=regShadow[i].find(j.addr);
+              if (shadow!=regShadow[i].end() && shadow->second==j.val) {
+                droppedWrites++;
+                continue;
+              }
+              regShadow[i][j.addr]=j.val;
+            }
+          }
           sortedWrites.push_back(std::pair<int,DivDelayedWrite>(i,DivDelayedWrite(curDelay,writeNum++,j.addr,j.val)));
         }
       }
@@ -2896,7 +3017,7 @@ SafeWriter* DivEngine::saveVGM(bool* sysToExport, bool loop, int version, bool p
           lastOne=i.second.time;
         }
         // write write
-        performVGMWrite(w,song.system[i.first],i.second.write,streamIDs[i.first],loopTimer,loopFreq,loopSample,sampleDir,isSecond[i.first],pendingFreq,playingSample,setPos,sampleOff8,sampleLen8,bankOffset[i.first],directStream,sampleStoppable,dpcm07,writeNES,correctedRate);
+        performVGMWrite(w,vgmEnc[i.first],i.second.write);
         writeCount++;
       }
       sortedWrites.clear();
@@ -2926,8 +3047,15 @@ SafeWriter* DivEngine::saveVGM(bool* sysToExport, bool loop, int version, bool p
       alreadyWroteLoop=true;
       loopPos=w->tell();
       loopTickSong=songTick;
+      // the loop must not depend on writes made before it
+      for (int i=0; i<song.systemLen; i++) {
+        regShadow[i].clear();
+      }
     }
   }
+  if (droppedWrites>0) {
+    logI("dropped %d redundant register writes.",droppedWrites);
+  }
   // end of song
   w->writeC(0x66);
 
@@ -3015,8 +3143,94 @@ SafeWriter* DivEngine::saveVGM(bool* sysToExport, bool loop, int version, bool p
 
   delete[] sampleOff8;
   delete[] sampleLen8;
+  delete[] sampleBlock;
   delete[] sampleOffSegaPCM;
 
   BUSY_END;
   return w;
 }
+
+std::vector<SafeWriter*> DivEngine::saveVGMSubSongs(const std::vector<size_t>& subSongs, int threads, bool* sysToExport, bool loop, int version, bool patternHints, bool directStream, int trailingTicks, bool dpcm07, int correctedRate, bool dedupeWrites, bool packSamples) {
+  std::vector<SafeWriter*> ret;
+  ret.resize(subSongs.size(),NULL);
+  if (subSongs.empty()) return ret;
+
+  if (threads<=0) threads=std::thread::hardware_concurrency();
+  if (threads>(int)subSongs.size()) threads=subSongs.size();
+
+  SafeWriter* songCopy=NULL;
+  if (threads>1) {
+    songCopy=saveFur(true);
+    if (songCopy==NULL) {
+      logW("could not copy song for render workers! exporting in one thread.");
+      threads=1;
+    }
+  }
+
+  std::atomic<size_t> nextSubSong(0);
+  std::mutex warningLock;
+  String allWarnings;
+
+  if (threads>1) {
+    // export sub-songs in parallel, each worker with its own engine
+    logI("exporting %d sub-songs using %d render workers.",(int)subSongs.size(),threads);
+    std::vector<std::thread*> workers;
+    for (int i=0; i<threads; i++) {
+      unsigned char* data=new unsigned char[songCopy->size()];
+      memcpy(data,songCopy->getFinalBuf(),songCopy->size());
+      size_t dataLen=songCopy->size();
+      try {
+        workers.push_back(new std::thread([this,data,dataLen,sysToExport,loop,version,patternHints,directStream,trailingTicks,dpcm07,correctedRate,dedupeWrites,packSamples,&subSongs,&ret,&nextSubSong,&warningLock,&allWarnings]() {
+          DivEngine* worker=new DivEngine;
+          if (worker->initRenderWorker(this,data,dataLen)) {
+            while (true) {
+              size_t index=nextSubSong++;
+              if (index>=subSongs.size()) break;
+              worker->changeSongP(subSongs[index]);
+              ret[index]=worker->saveVGM(sysToExport,loop,version,patternHints,directStream,trailingTicks,dpcm07,correctedRate,dedupeWrites,packSamples);
+              if (ret[index]==NULL) {
+                logE("could not export sub-song %d! (%s)",(int)subSongs[index]+1,worker->getLastError().c_str());
+              }
+              if (!worker->getWarnings().empty()) {
+                warningLock.lock();
+                allWarnings+=worker->getWarnings();
+                warningLock.unlock();
+              }
+            }
+          } else {
+            logE("could not start render worker!");
+          }
+          worker->quit(false);
+          delete worker;
+        }));
+      } catch (std::system_error& e) {
+        logE("could not start render worker thread! %s",e.what());
+        delete[] data;
+      }
+    }
+    for (std::thread* i: workers) {
+      i->join();
+      delete i;
+    }
+    songCopy->finish();
+    delete songCopy;
+  }
+
+  // export whatever workers couldn't
+  size_t prevSubSong=curSubSongIndex;
+  bool changedSubSong=false;
+  while (nextSubSong<subSongs.size()) {
+    size_t index=nextSubSong++;
+    changeSongP(subSongs[index]);
+    changedSubSong=true;
+    ret[index]=saveVGM(sysToExport,loop,version,patternHints,directStream,trailingTicks,dpcm07,correctedRate,dedupeWrites,packSamples);
+    if (ret[index]==NULL) {
+      logE("could not export sub-song %d! (%s)",(int)subSongs[index]+1,lastError.c_str());
+    }
+    allWarnings+=warnings;
+  }
+  if (changedSubSong) changeSongP(prevSubSong);
+
+  warnings=allWarnings;
+  return ret;
+}
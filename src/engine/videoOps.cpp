@@ -0,0 +1,603 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2026 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// offline oscilloscope video export.
+// the song is rendered in batches of frames. for every frame the needle of
+// each oscilloscope buffer is recorded, and once a batch is done the traces
+// are found (one job per channel, using the same period detection as the
+// channel oscilloscope window) and drawn (one job per grid cell).
+// the previous batch is written to the encoder while the next one renders.
+
+#define _USE_MATH_DEFINES
+#include "engine.h"
+#include "workPool.h"
+#include "../ta-log.h"
+#include "../fileutils.h"
+#ifdef HAVE_SNDFILE
+#include "sfWrapper.h"
+#endif
+#include <fftw3.h>
+#include <float.h>
+#include <math.h>
+#include <signal.h>
+#include <chrono>
+#include <thread>
+
+#ifdef _WIN32
+#define VIDEO_POPEN _popen
+#define VIDEO_PCLOSE _pclose
+// binary mode, or frames are mangled
+#define VIDEO_POPEN_MODE "wb"
+#else
+#define VIDEO_POPEN popen
+#define VIDEO_PCLOSE pclose
+// popen() only takes "r" or "w"
+#define VIDEO_POPEN_MODE "w"
+#endif
+
+#define VIDEO_BUFSIZE 2048
+#define VIDEO_FFT_SIZE 4096
+// see chanOsc.cpp
+#define VIDEO_STABLE_FRAMES 4
+#define VIDEO_REUSE_FRAMES 8
+#define VIDEO_MAX_BATCH 32
+// limit on the size of a batch of frames (it is double-buffered)
+#define VIDEO_MAX_BATCH_BYTES (64*1024*1024)
+
+struct DivVideoChan {
+  DivDispatchOscBuffer* buf;
+  double* inBuf;
+  fftw_complex* outBuf;
+  double* corrBuf;
+  fftw_plan plan, planI;
+  double periodLen;
+  int displaySize, traceLen, batch;
+  unsigned char stableFrames, framesSinceFFT;
+  bool periodValid, waveCorr;
+  int lastNote, lastPitch, lastIns;
+  // per frame of the batch: needle and for how many frames the pitch didn't change
+  unsigned short needle[VIDEO_MAX_BATCH];
+  unsigned char stable[VIDEO_MAX_BATCH];
+  // traceLen samples per frame of the batch
+  float* trace;
+  DivVideoChan():
+    buf(NULL),
+    inBuf(NULL),
+    outBuf(NULL),
+    corrBuf(NULL),
+    plan(NULL),
+    planI(NULL),
+    periodLen(0.0),
+    displaySize(0),
+    traceLen(0),
+    batch(0),
+    stableFrames(0),
+    framesSinceFFT(0),
+    periodValid(false),
+    waveCorr(true),
+    lastNote(-1),
+    lastPitch(0),
+    lastIns(-1),
+    trace(NULL) {}
+};
+
+struct DivVideoCell {
+  unsigned char* frame;
+  // NULL for empty cells
+  DivVideoChan* chan;
+  int frameIndex;
+  int x0, y0, x1, y1, width;
+  unsigned int colorBack, colorTrace, colorGrid;
+};
+
+// find the start of the trace in one frame. returns the needle.
+static unsigned short videoFindTrace(DivVideoChan* ch, int frame) {
+  DivDispatchOscBuffer* buf=ch->buf;
+  int displaySize=ch->displaySize;
+  int displaySize2=displaySize*2;
+  unsigned short needle=ch->needle[frame];
+  bool reusePeriod=(ch->periodValid && ch->stable[frame]>=VIDEO_STABLE_FRAMES && ch->framesSinceFFT<VIDEO_REUSE_FRAMES);
+  bool loudEnough=false;
+  double waveLen=0.0;
+  short lastSample=0;
+  int k=0;
+
+  if (reusePeriod) {
+    for (unsigned short j=needle-displaySize2; j!=needle; j++) {
+      if (buf->data[j]!=-1) lastSample=buf->data[j];
+      if ((double)lastSample/32768.0>0.001 || (double)lastSample/32768.0<-0.001) {
+        loudEnough=true;
+        break;
+      }
+    }
+  } else {
+    ch->periodValid=false;
+    memset(ch->inBuf,0,VIDEO_FFT_SIZE*sizeof(double));
+    if (displaySize2<VIDEO_FFT_SIZE) {
+      for (int j=-VIDEO_FFT_SIZE; j<VIDEO_FFT_SIZE; j++) {
+        const short newData=buf->data[(unsigned short)(needle-displaySize2+((j*displaySize2)/(VIDEO_FFT_SIZE)))];
+        if (newData!=-1) lastSample=newData;
+        if (j<0) continue;
+        ch->inBuf[j]=(double)lastSample/32768.0;
+        if (ch->inBuf[j]>0.001 || ch->inBuf[j]<-0.001) loudEnough=true;
+        ch->inBuf[j]*=0.55-0.45*cos(M_PI*(double)j/(double)(VIDEO_FFT_SIZE>>1));
+      }
+    } else {
+      for (unsigned short j=needle-displaySize2; j!=needle; j++, k++) {
+        const int kIn=(k*VIDEO_FFT_SIZE)/displaySize2;
+        if (kIn>=VIDEO_FFT_SIZE) break;
+        if (buf->data[j]!=-1) lastSample=buf->data[j];
+        ch->inBuf[kIn]=(double)lastSample/32768.0;
+        if (ch->inBuf[kIn]>0.001 || ch->inBuf[kIn]<-0.001) loudEnough=true;
+        ch->inBuf[kIn]*=0.55-0.45*cos(M_PI*(double)kIn/(double)(VIDEO_FFT_SIZE>>1));
+      }
+    }
+  }
+
+  if (loudEnough) {
+    if (reusePeriod) {
+      waveLen=ch->periodLen;
+      ch->framesSinceFFT++;
+    } else {
+      fftw_execute(ch->plan);
+
+      // auto-correlation
+      for (int j=0; j<VIDEO_FFT_SIZE; j++) {
+        ch->outBuf[j][0]/=VIDEO_FFT_SIZE;
+        ch->outBuf[j][1]/=VIDEO_FFT_SIZE;
+        ch->outBuf[j][0]=ch->outBuf[j][0]*ch->outBuf[j][0]+ch->outBuf[j][1]*ch->outBuf[j][1];
+        ch->outBuf[j][1]=0;
+      }
+      ch->outBuf[0][0]=0;
+      ch->outBuf[0][1]=0;
+      ch->outBuf[1][0]=0;
+      ch->outBuf[1][1]=0;
+      fftw_execute(ch->planI);
+
+      for (int j=0; j<(VIDEO_FFT_SIZE>>1); j++) {
+        ch->corrBuf[j]*=1.0-((double)j/(double)(VIDEO_FFT_SIZE<<1));
+      }
+
+      // find size of period
+      double waveLenCandL=DBL_MAX;
+      double waveLenCandH=DBL_MIN;
+      int waveLenBottom=0;
+      waveLen=VIDEO_FFT_SIZE-1;
+      for (int j=(VIDEO_FFT_SIZE>>2); j>2; j--) {
+        if (ch->corrBuf[j]<waveLenCandL) {
+          waveLenCandL=ch->corrBuf[j];
+          waveLenBottom=j;
+        }
+      }
+      for (int j=(VIDEO_FFT_SIZE>>1)-1; j>waveLenBottom; j--) {
+        if (ch->corrBuf[j]>waveLenCandH) {
+          waveLenCandH=ch->corrBuf[j];
+          waveLen=j;
+        }
+      }
+      if (waveLen<(VIDEO_FFT_SIZE-32)) {
+        ch->periodLen=waveLen;
+        ch->periodValid=true;
+      }
+      ch->framesSinceFFT=0;
+    }
+
+    if (ch->periodValid) {
+      waveLen*=(double)displaySize*2.0/(double)VIDEO_FFT_SIZE;
+
+      // DFT of one period, for the phase
+      double dft[2];
+      dft[0]=0.0;
+      dft[1]=0.0;
+      lastSample=0;
+      for (int j=needle-1-displaySize-(int)waveLen, k=-(displaySize>>1); k<waveLen; j++, k++) {
+        if (buf->data[j&0xffff]!=-1) lastSample=buf->data[j&0xffff];
+        if (k<0) continue;
+        double one=((double)lastSample/32768.0);
+        double two=(double)k*(-2.0*M_PI)/waveLen;
+        dft[0]+=one*cos(two);
+        dft[1]+=one*sin(two);
+      }
+
+      double phase=(0.5+(atan2(dft[1],dft[0])/(2.0*M_PI)));
+      if (ch->waveCorr) {
+        needle-=phase*waveLen;
+      }
+    }
+  }
+
+  return needle-displaySize;
+}
+
+// find the traces of every frame of a batch in one channel.
+// frames are done in order since the period may be reused.
+static void videoRunChan(void* c) {
+  DivVideoChan* ch=(DivVideoChan*)c;
+  for (int i=0; i<ch->batch; i++) {
+    float* out=&ch->trace[i*ch->traceLen];
+    unsigned short needle=videoFindTrace(ch,i);
+    short lastSample=0;
+    // sample that comes before the trace
+    for (int j=1; j<64; j++) {
+      short s=ch->buf->data[(unsigned short)(needle-j)];
+      if (s!=-1) {
+        lastSample=s;
+        break;
+      }
+    }
+    for (int j=0; j<ch->traceLen; j++) {
+      short s=ch->buf->data[(unsigned short)(needle+(int)(((long long)j*ch->displaySize)/ch->traceLen))];
+      if (s!=-1) lastSample=s;
+      out[j]=(float)lastSample/32768.0f;
+    }
+  }
+}
+
+static inline void videoPutPixel(unsigned char* p, unsigned int color) {
+  p[0]=color>>16;
+  p[1]=color>>8;
+  p[2]=color;
+  p[3]=255;
+}
+
+// draw one grid cell of a frame
+static void videoRunCell(void* c) {
+  DivVideoCell* cell=(DivVideoCell*)c;
+  int stride=cell->width*4;
+  for (int y=cell->y0; y<cell->y1; y++) {
+    unsigned char* p=cell->frame+y*stride+cell->x0*4;
+    for (int x=cell->x0; x<cell->x1; x++, p+=4) {
+      videoPutPixel(p,(x==cell->x0 || y==cell->y0)?cell->colorGrid:cell->colorBack);
+    }
+  }
+  if (cell->chan==NULL) return;
+
+  DivVideoChan* ch=cell->chan;
+  const float* trace=&ch->trace[cell->frameIndex*ch->traceLen];
+  int top=cell->y0+1;
+  int h=cell->y1-top;
+  int w=cell->x1-cell->x0-1;
+  if (h<2 || w<1) return;
+  int thick=MAX(1,h/180);
+  float center=(float)top+(float)(h-1)*0.5f;
+  float amp=(float)(h-1-thick)*0.5f;
+  int prevY=-1;
+  for (int i=0; i<w; i++) {
+    int x=cell->x0+1+i;
+    float v=trace[(i*ch->traceLen)/w];
+    if (v>1.0f) v=1.0f;
+    if (v<-1.0f) v=-1.0f;
+    int y=(int)(center-v*amp);
+    // connect to the previous column
+    int yBegin=y, yEnd=y;
+    if (prevY>=0) {
+      if (prevY<yBegin) yBegin=prevY;
+      if (prevY>yEnd) yEnd=prevY;
+    }
+    prevY=y;
+    yBegin-=thick>>1;
+    yEnd+=thick-1-(thick>>1);
+    if (yBegin<top) yBegin=top;
+    if (yEnd>=cell->y1) yEnd=cell->y1-1;
+    for (int j=yBegin; j<=yEnd; j++) {
+      videoPutPixel(cell->frame+j*stride+x*4,cell->colorTrace);
+    }
+  }
+}
+
+static String videoQuote(const String& s) {
+  String ret="\"";
+  for (char i: s) {
+    if (i=='"') ret+='\\';
+    ret+=i;
+  }
+  ret+="\"";
+  return ret;
+}
+
+bool DivEngine::saveVideo(const char* path, DivVideoExportOptions options) {
+#ifndef HAVE_SNDFILE
+  logE("Furnace was not compiled with libsndfile. cannot export!");
+  lastError="Furnace was not compiled with libsndfile";
+  return false;
+#else
+  if (options.width<16 || options.height<16 || options.fps<1) {
+    lastError="invalid video size or frame rate";
+    return false;
+  }
+  // the encoder wants even sizes
+  options.width&=~1;
+  options.height&=~1;
+  if (options.windowSize<1.0f) options.windowSize=1.0f;
+  if (options.windowSize>200.0f) options.windowSize=200.0f;
+
+  // 1. audio
+  String audioPath=options.audioPath;
+  bool tempAudio=audioPath.empty();
+  if (tempAudio) audioPath=String(path)+".audio.wav";
+  options.audio.mode=DIV_EXPORT_MODE_ONE;
+  options.audio.extraTargets.clear();
+  logI("rendering audio to %s...",audioPath);
+  if (!saveAudio(audioPath.c_str(),options.audio)) {
+    lastError="could not render audio";
+    return false;
+  }
+  waitAudioFile();
+
+  size_t audioLen=0;
+  {
+    SF_INFO si;
+    SFWrapper sfWrap;
+    memset(&si,0,sizeof(SF_INFO));
+    SNDFILE* sf=sfWrap.doOpen(audioPath.c_str(),SFM_READ,&si);
+    if (sf==NULL) {
+      lastError=fmt::sprintf("could not open rendered audio! (%s)",sf_strerror(NULL));
+      return false;
+    }
+    audioLen=si.frames;
+    sfWrap.doClose();
+  }
+
+  // 2. encoder
+  String cmd;
+  for (size_t i=0; i<options.encoder.size(); i++) {
+    if (options.encoder[i]=='%' && i+1<options.encoder.size()) {
+      switch (options.encoder[++i]) {
+        case 'w':
+          cmd+=fmt::sprintf("%d",options.width);
+          break;
+        case 'h':
+          cmd+=fmt::sprintf("%d",options.height);
+          break;
+        case 'r':
+          cmd+=fmt::sprintf("%d",options.fps);
+          break;
+        case 'a':
+          cmd+=videoQuote(audioPath);
+          break;
+        case 'o':
+          cmd+=videoQuote(path);
+          break;
+        case '%':
+          cmd+='%';
+          break;
+        default:
+          cmd+='%';
+          cmd+=options.encoder[i];
+          break;
+      }
+      continue;
+    }
+    cmd+=options.encoder[i];
+  }
+  logD("encoder: %s",cmd);
+#ifndef _WIN32
+  // a failed write is reported instead
+  void (*prevSigPipe)(int)=signal(SIGPIPE,SIG_IGN);
+#endif
+  FILE* enc=VIDEO_POPEN(cmd.c_str(),VIDEO_POPEN_MODE);
+  if (enc==NULL) {
+    lastError=fmt::sprintf("could not start encoder! (%s)",strerror(errno));
+#ifndef _WIN32
+    signal(SIGPIPE,prevSigPipe);
+#endif
+    if (tempAudio) deleteFile(audioPath.c_str());
+    return false;
+  }
+
+  // 3. channels
+  std::vector<DivVideoChan> chans;
+  std::vector<int> chanIndex;
+  addOscConsumer();
+  stop();
+  repeatPattern=false;
+  setOrder(0);
+  remainingLoops=-1;
+  deinitAudioBackend();
+  freelance=false;
+  playSub(false);
+  freelance=false;
+  setOscBuffersEnabled(true);
+  for (int i=0; i<song.chans; i++) {
+    DivDispatchOscBuffer* buf=getOscBuffer(i);
+    if (buf==NULL || buf->data==NULL) continue;
+    if (!curSubSong->chanShowChanOsc[i]) continue;
+    chans.push_back(DivVideoChan());
+    chans.back().buf=buf;
+    chanIndex.push_back(i);
+  }
+
+  int cols=options.cols;
+  if (cols<1) cols=ceil(sqrt((double)MAX(chans.size(),1)));
+  int rows=(MAX((int)chans.size(),1)+cols-1)/cols;
+  int cellW=options.width/cols;
+  int displaySize=65536.0f*(options.windowSize/1000.0f);
+
+  // a batch (and the data behind the traces) must fit in the oscilloscope buffer
+  size_t frameSize=(size_t)options.width*options.height*4;
+  int batch=(int)((65536.0-2.6*displaySize)*options.fps/65536.0);
+  batch=MIN(batch,(int)(VIDEO_MAX_BATCH_BYTES/frameSize));
+  if (batch>VIDEO_MAX_BATCH) batch=VIDEO_MAX_BATCH;
+  if (batch<1) batch=1;
+
+  // FFT plans may only be created from one thread
+  for (DivVideoChan& i: chans) {
+    i.displaySize=displaySize;
+    i.traceLen=MAX(cellW,1);
+    i.waveCorr=options.waveCorr;
+    i.trace=new float[batch*i.traceLen];
+    i.inBuf=(double*)fftw_malloc(VIDEO_FFT_SIZE*sizeof(double));
+    i.outBuf=(fftw_complex*)fftw_malloc(VIDEO_FFT_SIZE*sizeof(fftw_complex));
+    i.corrBuf=(double*)fftw_malloc(VIDEO_FFT_SIZE*sizeof(double));
+    i.plan=fftw_plan_dft_r2c_1d(VIDEO_FFT_SIZE,i.inBuf,i.outBuf,FFTW_ESTIMATE);
+    i.planI=fftw_plan_dft_c2r_1d(VIDEO_FFT_SIZE,i.outBuf,i.corrBuf,FFTW_ESTIMATE);
+  }
+
+  std::vector<DivVideoCell> cells(batch*rows*cols);
+  unsigned char* frames[2];
+  frames[0]=new unsigned char[frameSize*batch];
+  frames[1]=new unsigned char[frameSize*batch];
+  int curFrames=0;
+  std::thread* writer=NULL;
+  std::atomic<bool> writeFailed(false);
+
+  DivWorkPool* pool=new DivWorkPool(options.threads);
+  float* outBuf[DIV_MAX_OUTPUTS];
+  for (int i=0; i<DIV_MAX_OUTPUTS; i++) {
+    outBuf[i]=new float[VIDEO_BUFSIZE];
+  }
+
+  // 4. render
+  size_t totalFrames=(size_t)ceil((double)audioLen*options.fps/got.rate);
+  size_t samplesDone=0;
+  size_t frameNum=0;
+  logI("rendering %d frames (%d at once)...",(int)totalFrames,batch);
+  std::chrono::steady_clock::time_point timeStart=std::chrono::steady_clock::now();
+  while (frameNum<totalFrames && !writeFailed) {
+    int count=MIN((size_t)batch,totalFrames-frameNum);
+    for (int f=0; f<count; f++) {
+      size_t target=(size_t)(((double)(frameNum+f+1)*got.rate)/options.fps);
+      while (samplesDone<target) {
+        unsigned int size=MIN(target-samplesDone,VIDEO_BUFSIZE);
+        nextBuf(NULL,outBuf,0,MIN(got.outChans,DIV_MAX_OUTPUTS),size);
+        samplesDone+=size;
+      }
+      for (size_t i=0; i<chans.size(); i++) {
+        DivVideoChan& ch=chans[i];
+        ch.needle[f]=ch.buf->getNeedle()>>16;
+        // skip the FFT if the pitch is unlikely to have changed
+        DivChannelState* chanState=getChanState(chanIndex[i]);
+        bool stable=(chanState!=NULL &&
+                     chanState->note==ch.lastNote &&
+                     chanState->pitch==ch.lastPitch &&
+                     chanState->lastIns==ch.lastIns &&
+                     chanState->vibratoDepth==0 &&
+                     chanState->arp==0 &&
+                     !chanState->inPorta);
+        if (stable) {
+          if (ch.stableFrames<255) ch.stableFrames++;
+        } else {
+          ch.stableFrames=0;
+          if (chanState!=NULL) {
+            ch.lastNote=chanState->note;
+            ch.lastPitch=chanState->pitch;
+            ch.lastIns=chanState->lastIns;
+          }
+        }
+        ch.stable[f]=ch.stableFrames;
+      }
+    }
+
+    // traces
+    for (DivVideoChan& i: chans) {
+      i.batch=count;
+      if (i.plan==NULL || i.planI==NULL) continue;
+      pool->push(videoRunChan,&i);
+    }
+    pool->wait();
+
+    // frames
+    unsigned char* out=frames[curFrames];
+    size_t cellCount=0;
+    for (int f=0; f<count; f++) {
+      for (int i=0; i<rows*cols; i++) {
+        DivVideoCell& cell=cells[cellCount++];
+        int col=i%cols;
+        int row=i/cols;
+        cell.frame=out+frameSize*f;
+        cell.chan=(i<(int)chans.size() && chans[i].plan!=NULL && chans[i].planI!=NULL)?&chans[i]:NULL;
+        cell.frameIndex=f;
+        cell.x0=(col*options.width)/cols;
+        cell.x1=((col+1)*options.width)/cols;
+        cell.y0=(row*options.height)/rows;
+        cell.y1=((row+1)*options.height)/rows;
+        cell.width=options.width;
+        cell.colorBack=options.colorBack;
+        cell.colorTrace=options.colorTrace;
+        cell.colorGrid=options.colorGrid;
+      }
+    }
+    pool->pushBatch(videoRunCell,cells.data(),cellCount);
+    pool->wait();
+
+    // write while the next batch renders
+    if (writer!=NULL) {
+      writer->join();
+      delete writer;
+    }
+    size_t writeLen=frameSize*count;
+    writer=new std::thread([out,writeLen,enc,&writeFailed]() {
+      if (fwrite(out,1,writeLen,enc)!=writeLen) writeFailed=true;
+    });
+    curFrames^=1;
+    frameNum+=count;
+  }
+  if (writer!=NULL) {
+    writer->join();
+    delete writer;
+  }
+  double elapsed=std::chrono::duration<double>(std::chrono::steady_clock::now()-timeStart).count();
+
+  int encResult=VIDEO_PCLOSE(enc);
+#ifndef _WIN32
+  signal(SIGPIPE,prevSigPipe);
+#endif
+  playing=false;
+
+  delete pool;
+  for (int i=0; i<DIV_MAX_OUTPUTS; i++) {
+    delete[] outBuf[i];
+  }
+  delete[] frames[0];
+  delete[] frames[1];
+  for (DivVideoChan& i: chans) {
+    if (i.plan!=NULL) fftw_destroy_plan(i.plan);
+    if (i.planI!=NULL) fftw_destroy_plan(i.planI);
+    fftw_free(i.inBuf);
+    fftw_free(i.outBuf);
+    fftw_free(i.corrBuf);
+    delete[] i.trace;
+  }
+  removeOscConsumer();
+  if (tempAudio) deleteFile(audioPath.c_str());
+
+  if (initAudioBackend()) {
+    for (int i=0; i<song.systemLen; i++) {
+      disCont[i].setRates(got.rate);
+      disCont[i].setQuality(lowQuality,dcHiPass);
+    }
+    if (!output->setRun(true)) {
+      logE("error while activating audio!");
+    }
+  }
+
+  if (writeFailed) {
+    lastError="could not write to encoder";
+    return false;
+  }
+  if (encResult!=0) {
+    lastError=fmt::sprintf("encoder failed (%d)",encResult);
+    return false;
+  }
+  if (elapsed>0.0) {
+    logI("done! %d frames in %.1fs (%.1fx real time)",(int)totalFrames,elapsed,((double)totalFrames/options.fps)/elapsed);
+  }
+  return true;
+#endif
+}
@@ -19,6 +19,7 @@
 
 #include "engine.h"
 #include "../ta-log.h"
+#include "mixKernel.h"
 #ifdef HAVE_SNDFILE
 #include "sfWrapper.h"
 #endif
@@ -33,6 +34,10 @@ bool DivEngine::isExporting() {
   return exporting;
 }
 
+bool DivEngine::getSkipIdleChips() {
+  return skipIdleChips;
+}
+
 void DivEngine::getLoopsLeft(int &loops) {
   if (totalLoops<0 || exportLoopCount==0) {
     loops=0;
@@ -112,58 +117,491 @@ bool DivEngine::getIsFadingOut() {
 
 #ifdef HAVE_SNDFILE
 
-#define MAP_BITRATE \
-  if (exportFormat!=DIV_EXPORT_FORMAT_WAV) { \
-    double mappedLevel=0.0; \
-\
-    switch (exportFormat) { \
-      case DIV_EXPORT_FORMAT_OPUS: \
-        mappedLevel=1.0-((double)((exportBitRate/(double)MAX(1,exportOutputs))-6000.0)/250000.0); \
-        break; \
-      case DIV_EXPORT_FORMAT_FLAC: \
-        mappedLevel=exportVBRQuality*0.125; \
-        break; \
-      case DIV_EXPORT_FORMAT_VORBIS: \
-        mappedLevel=1.0-(exportVBRQuality*0.1); \
-        break; \
-      case DIV_EXPORT_FORMAT_MPEG_L3: { \
-        int mappedBitRateMode=SF_BITRATE_MODE_CONSTANT; \
-        switch (exportBitRateMode) { \
-          case DIV_EXPORT_BITRATE_CONSTANT: \
-            mappedBitRateMode=SF_BITRATE_MODE_CONSTANT; \
-            break; \
-          case DIV_EXPORT_BITRATE_VARIABLE: \
-            mappedBitRateMode=SF_BITRATE_MODE_VARIABLE; \
-            break; \
-          case DIV_EXPORT_BITRATE_AVERAGE: \
-            mappedBitRateMode=SF_BITRATE_MODE_AVERAGE; \
-            break; \
-        } \
-        if (exportBitRateMode==DIV_EXPORT_BITRATE_VARIABLE) { \
-          mappedLevel=1.0-(exportVBRQuality*0.1); \
-        } else { \
-          if (got.rate>=32000) { \
-            mappedLevel=(320000.0-(double)exportBitRate)/288000.0; \
-          } else if (got.rate>=16000) { \
-            mappedLevel=(160000.0-(double)exportBitRate)/152000.0; \
-          } else { \
-            mappedLevel=(64000.0-(double)exportBitRate)/56000.0; \
-          } \
-        } \
-\
-        if (sf_command(sf,SFC_SET_BITRATE_MODE,&mappedBitRateMode,sizeof(mappedBitRateMode))==SF_FALSE) { \
-          logE("could not set bit rate mode! (%s)",sf_strerror(sf)); \
-        } \
-        break; \
-      } \
-      default: \
-        break; \
-    } \
-\
-    if (sf_command(sf,SFC_SET_COMPRESSION_LEVEL,&mappedLevel,sizeof(mappedLevel))!=SF_TRUE) { \
-      logE("could not set compression level! (%s)",sf_strerror(sf)); \
-    } \
+// get the libsndfile format of an export format.
+static int exportFileFormat(DivAudioExportFormats format, DivAudioExportWavFormats wavFormat) {
+  switch (format) {
+    case DIV_EXPORT_FORMAT_WAV:
+      switch (wavFormat) {
+        case DIV_EXPORT_WAV_U8:
+          return SF_FORMAT_WAV|SF_FORMAT_PCM_U8;
+        case DIV_EXPORT_WAV_S16:
+          return SF_FORMAT_WAV|SF_FORMAT_PCM_16;
+        case DIV_EXPORT_WAV_F32:
+          return SF_FORMAT_WAV|SF_FORMAT_FLOAT;
+        default:
+          return SF_FORMAT_WAV|SF_FORMAT_PCM_U8;
+      }
+    case DIV_EXPORT_FORMAT_OPUS:
+      return SF_FORMAT_OGG|SF_FORMAT_OPUS;
+    case DIV_EXPORT_FORMAT_FLAC:
+      return SF_FORMAT_FLAC|SF_FORMAT_PCM_16;
+    case DIV_EXPORT_FORMAT_VORBIS:
+      return SF_FORMAT_OGG|SF_FORMAT_VORBIS;
+    case DIV_EXPORT_FORMAT_MPEG_L3:
+      return SF_FORMAT_MPEG|SF_FORMAT_MPEG_LAYER_III;
+  }
+  return 0;
+}
+
+// set the bit rate/compression level of an opened file.
+static void exportSetBitRate(SNDFILE* sf, DivAudioExportFormats exportFormat, DivAudioExportBitrateModes exportBitRateMode, int exportBitRate, float exportVBRQuality, int exportOutputs, int rate) {
+  if (exportFormat!=DIV_EXPORT_FORMAT_WAV) {
+    double mappedLevel=0.0;
+
+    switch (exportFormat) {
+      case DIV_EXPORT_FORMAT_OPUS:
+        mappedLevel=1.0-((double)((exportBitRate/(double)MAX(1,exportOutputs))-6000.0)/250000.0);
+        break;
+      case DIV_EXPORT_FORMAT_FLAC:
+        mappedLevel=exportVBRQuality*0.125;
+        break;
+      case DIV_EXPORT_FORMAT_VORBIS:
+        mappedLevel=1.0-(exportVBRQuality*0.1);
+        break;
+      case DIV_EXPORT_FORMAT_MPEG_L3: {
+        int mappedBitRateMode=SF_BITRATE_MODE_CONSTANT;
+        switch (exportBitRateMode) {
+          case DIV_EXPORT_BITRATE_CONSTANT:
+            mappedBitRateMode=SF_BITRATE_MODE_CONSTANT;
+            break;
+          case DIV_EXPORT_BITRATE_VARIABLE:
+            mappedBitRateMode=SF_BITRATE_MODE_VARIABLE;
+            break;
+          case DIV_EXPORT_BITRATE_AVERAGE:
+            mappedBitRateMode=SF_BITRATE_MODE_AVERAGE;
+            break;
+        }
+        if (exportBitRateMode==DIV_EXPORT_BITRATE_VARIABLE) {
+          mappedLevel=1.0-(exportVBRQuality*0.1);
+        } else {
+          if (rate>=32000) {
+            mappedLevel=(320000.0-(double)exportBitRate)/288000.0;
+          } else if (rate>=16000) {
+            mappedLevel=(160000.0-(double)exportBitRate)/152000.0;
+          } else {
+            mappedLevel=(64000.0-(double)exportBitRate)/56000.0;
+          }
+        }
+
+        if (sf_command(sf,SFC_SET_BITRATE_MODE,&mappedBitRateMode,sizeof(mappedBitRateMode))==SF_FALSE) {
+          logE("could not set bit rate mode! (%s)",sf_strerror(sf));
+        }
+        break;
+      }
+      default:
+        break;
+    }
+
+    if (sf_command(sf,SFC_SET_COMPRESSION_LEVEL,&mappedLevel,sizeof(mappedLevel))!=SF_TRUE) {
+      logE("could not set compression level! (%s)",sf_strerror(sf));
+    }
+  }
+}
+
+#define MAP_BITRATE exportSetBitRate(sf,exportFormat,exportBitRateMode,exportBitRate,exportVBRQuality,exportOutputs,got.rate)
+
+// interleave and clamp count frames of src (starting at start) into dst.
+// stereo has its own loop with contiguous stores so that it vectorizes.
+static void exportInterleave(float* dst, float** src, int outputs, int start, int count) {
+  if (outputs==2) {
+    const float* l=src[0]+start;
+    const float* r=src[1]+start;
+    for (int i=0; i<count; i++) {
+      dst[i<<1]=MAX(-1.0f,MIN(1.0f,l[i]));
+      dst[(i<<1)|1]=MAX(-1.0f,MIN(1.0f,r[i]));
+    }
+    return;
   }
+  for (int j=0; j<outputs; j++) {
+    const float* in=src[j]+start;
+    float* out=dst+j;
+    for (int i=0; i<count; i++) {
+      out[i*outputs]=MAX(-1.0f,MIN(1.0f,in[i]));
+    }
+  }
+}
+
+// longest loop which may be reused when exporting, in seconds
+#define EXPORT_REUSE_MAX_SECONDS 600
+
+// number of rendered buffers which may wait for the writer
+#define EXPORT_WRITE_QUEUE 8
+
+// writes rendered buffers on its own thread, so that encoding (which can take
+// as long as rendering for compressed formats) overlaps with rendering the
+// next buffers. the output is the same as writing each buffer in place.
+class DivExportWriter {
+  SNDFILE* sf;
+  float* buf[EXPORT_WRITE_QUEUE];
+  size_t len[EXPORT_WRITE_QUEUE];
+  size_t readPos, writePos;
+  bool quit, failed;
+  std::mutex lock;
+  std::condition_variable notify;
+  std::thread* thread;
+
+  void run() {
+    std::unique_lock<std::mutex> l(lock);
+    while (true) {
+      notify.wait(l,[this]() {
+        return readPos!=writePos || quit;
+      });
+      if (readPos==writePos) break;
+      size_t slot=readPos%EXPORT_WRITE_QUEUE;
+      if (!failed) {
+        l.unlock();
+        bool ok=(sf_writef_float(sf,buf[slot],len[slot])==(sf_count_t)len[slot]);
+        l.lock();
+        if (!ok) failed=true;
+      }
+      readPos++;
+      notify.notify_all();
+    }
+  }
+
+  public:
+    // get the next buffer to fill. blocks while the queue is full.
+    // returns NULL if writing failed.
+    float* acquire() {
+      std::unique_lock<std::mutex> l(lock);
+      notify.wait(l,[this]() {
+        return (writePos-readPos)<EXPORT_WRITE_QUEUE || failed;
+      });
+      if (failed) return NULL;
+      return buf[writePos%EXPORT_WRITE_QUEUE];
+    }
+
+    // queue the buffer returned by acquire() for writing.
+    void commit(size_t frames) {
+      std::unique_lock<std::mutex> l(lock);
+      len[writePos%EXPORT_WRITE_QUEUE]=frames;
+      writePos++;
+      notify.notify_all();
+    }
+
+    // write everything which is left and stop the thread.
+    // returns false if writing failed.
+    bool finish() {
+      {
+        std::unique_lock<std::mutex> l(lock);
+        quit=true;
+        notify.notify_all();
+      }
+      if (thread!=NULL) {
+        thread->join();
+        delete thread;
+        thread=NULL;
+      }
+      return !failed;
+    }
+
+    DivExportWriter(SNDFILE* f, int outputs):
+      sf(f),
+      readPos(0),
+      writePos(0),
+      quit(false),
+      failed(false) {
+      for (int i=0; i<EXPORT_WRITE_QUEUE; i++) {
+        buf[i]=new float[EXPORT_BUFSIZE*outputs];
+        len[i]=0;
+      }
+      thread=new std::thread(&DivExportWriter::run,this);
+    }
+    ~DivExportWriter() {
+      finish();
+      for (int i=0; i<EXPORT_WRITE_QUEUE; i++) {
+        delete[] buf[i];
+      }
+    }
+};
+
+bool DivEngine::exportChanStem(int i, DivEngine* host) {
+  size_t fadeOutSamples=got.rate*exportFadeOut;
+  size_t curFadeOutSample=0;
+
+  SNDFILE* sf;
+  SF_INFO si;
+  SFWrapper sfWrap;
+  memset(&si,0,sizeof(SF_INFO));
+  String fname=fmt::sprintf("%s_c%02d.wav",exportPath,i+1);
+  logI("- %s",fname.c_str());
+  si.samplerate=got.rate;
+  si.channels=exportOutputs;
+  si.format=exportFileFormat(exportFormat,wavFormat);
+
+  sf=sfWrap.doOpen(fname.c_str(),SFM_WRITE,&si);
+  if (sf==NULL) {
+    logE("could not open file for writing! (%s)",sf_strerror(NULL));
+    return false;
+  }
+
+  MAP_BITRATE;
+
+  float* outBuf[DIV_MAX_OUTPUTS];
+  float* outBufFinal;
+  for (int j=0; j<exportOutputs; j++) {
+    outBuf[j]=new float[EXPORT_BUFSIZE];
+  }
+  outBufFinal=new float[EXPORT_BUFSIZE*exportOutputs];
+
+  for (int j=0; j<song.chans; j++) {
+    bool mute=(j!=i);
+    isMuted[j]=mute;
+  }
+  if (getChannelType(i)==5) {
+    for (int j=i; j<song.chans; j++) {
+      if (getChannelType(j)!=5) break;
+      isMuted[j]=false;
+    }
+  }
+  for (int j=0; j<song.chans; j++) {
+    if (disCont[song.dispatchOfChan[j]].dispatch!=NULL && song.dispatchChanOfChan[j]>=0) {
+      disCont[song.dispatchOfChan[j]].dispatch->muteChannel(song.dispatchChanOfChan[j],isMuted[j]);
+    }
+  }
+
+  curOrder=0;
+  prevOrder=0;
+  lastLoopPos=-1;
+  totalLoops=0;
+  isFadingOut=false;
+  remainingLoops=-1;
+  freelance=false;
+  playSub(false);
+  freelance=false;
+
+  while (playing && !host->stopExport) {
+    size_t total=0;
+    nextBuf(NULL,outBuf,0,exportOutputs,EXPORT_BUFSIZE);
+    if (totalProcessed>EXPORT_BUFSIZE) {
+      logE("error: total processed is bigger than export bufsize! %d>%d",totalProcessed,EXPORT_BUFSIZE);
+      totalProcessed=EXPORT_BUFSIZE;
+    }
+    int fi=0;
+    for (int j=0; j<(int)totalProcessed; j++) {
+      total++;
+      if (isFadingOut) {
+        double mul=(1.0-((double)curFadeOutSample/(double)fadeOutSamples));
+        if (fadeOutSamples<1.0) mul=0.0;
+        for (int k=0; k<exportOutputs; k++) {
+          outBufFinal[fi++]=MAX(-1.0f,MIN(1.0f,outBuf[k][j]))*mul;
+        }
+        if (++curFadeOutSample>=fadeOutSamples) {
+          playing=false;
+          break;
+        }
+      } else {
+        for (int k=0; k<exportOutputs; k++) {
+          outBufFinal[fi++]=MAX(-1.0f,MIN(1.0f,outBuf[k][j]));
+        }
+        if (lastLoopPos>-1 && j>=lastLoopPos && totalLoops>=exportLoopCount) {
+          logD("start fading out...");
+          isFadingOut=true;
+          if (fadeOutSamples==0) break;
+        }
+      }
+    }
+    if (sf_writef_float(sf,outBufFinal,total)!=(int)total) {
+      logE("error: failed to write entire buffer!");
+      break;
+    }
+  }
+  playing=false;
+
+  delete[] outBufFinal;
+  for (int j=0; j<exportOutputs; j++) {
+    delete[] outBuf[j];
+  }
+
+  if (sfWrap.doClose()!=0) {
+    logE("could not close audio file!");
+  }
+  return true;
+}
+
+bool DivEngine::exportChanStemsOnePass(const std::vector<int>& chans, DivEngine* host) {
+  size_t fadeOutSamples=got.rate*exportFadeOut;
+  size_t curFadeOutSample=0;
+  size_t stemCount=chans.size();
+
+  std::vector<SFWrapper*> sfWrap;
+  std::vector<SNDFILE*> sfList;
+  for (int i: chans) {
+    SF_INFO si;
+    memset(&si,0,sizeof(SF_INFO));
+    String fname=fmt::sprintf("%s_c%02d.wav",exportPath,i+1);
+    logI("- %s",fname.c_str());
+    si.samplerate=got.rate;
+    si.channels=exportOutputs;
+    si.format=exportFileFormat(exportFormat,wavFormat);
+
+    SFWrapper* w=new SFWrapper;
+    SNDFILE* sf=w->doOpen(fname.c_str(),SFM_WRITE,&si);
+    if (sf==NULL) {
+      logE("could not open file for writing! (%s)",sf_strerror(NULL));
+      delete w;
+      for (SFWrapper* j: sfWrap) {
+        j->doClose();
+        delete j;
+      }
+      return false;
+    }
+    MAP_BITRATE;
+    sfWrap.push_back(w);
+    sfList.push_back(sf);
+  }
+
+  float* outBuf[DIV_MAX_OUTPUTS];
+  float* outBufFinal;
+  for (int j=0; j<exportOutputs; j++) {
+    outBuf[j]=new float[EXPORT_BUFSIZE];
+  }
+  outBufFinal=new float[EXPORT_BUFSIZE*exportOutputs];
+  // output of every stem
+  std::vector<float*> stemBuf;
+  for (size_t i=0; i<stemCount*exportOutputs; i++) {
+    stemBuf.push_back(new float[EXPORT_BUFSIZE]);
+  }
+
+  for (int j=0; j<song.chans; j++) {
+    isMuted[j]=false;
+    if (disCont[song.dispatchOfChan[j]].dispatch!=NULL && song.dispatchChanOfChan[j]>=0) {
+      disCont[song.dispatchOfChan[j]].dispatch->muteChannel(song.dispatchChanOfChan[j],false);
+    }
+  }
+
+  curOrder=0;
+  prevOrder=0;
+  lastLoopPos=-1;
+  totalLoops=0;
+  isFadingOut=false;
+  remainingLoops=-1;
+  freelance=false;
+  playSub(false);
+  freelance=false;
+
+  bool writeFailed=false;
+  while (playing && !host->stopExport && !writeFailed) {
+    nextBuf(NULL,outBuf,0,exportOutputs,EXPORT_BUFSIZE);
+    if (totalProcessed>EXPORT_BUFSIZE) {
+      logE("error: total processed is bigger than export bufsize! %d>%d",totalProcessed,EXPORT_BUFSIZE);
+      totalProcessed=EXPORT_BUFSIZE;
+    }
+    unsigned int size=totalProcessed;
+
+    // mix each channel the way nextBuf() mixes its chip
+    float refPlayerVol=1.0f;
+    if (curFilePlayer!=NULL && curFilePlayer->getActive()) {
+      refPlayerVol=CLAMP(1.0f-curFilePlayer->getVolume(),0.0f,1.0f);
+    }
+    for (size_t i=0; i<stemCount; i++) {
+      float** stemOut=&stemBuf[i*exportOutputs];
+      for (int k=0; k<exportOutputs; k++) {
+        memset(stemOut[k],0,size*sizeof(float));
+      }
+      const int chip=song.dispatchOfChan[chans[i]];
+      const int chipChan=song.dispatchChanOfChan[chans[i]];
+      DivDispatchContainer& dc=disCont[chip];
+      const int outs=dc.dispatch->getOutputCount();
+      for (unsigned int p: song.patchbay) {
+        const unsigned short srcPort=p>>16;
+        const unsigned short destPort=p&0xffff;
+        if ((srcPort>>4)!=chip || (destPort>>4)!=0) continue;
+        const unsigned char srcSubPort=srcPort&15;
+        const unsigned char destSubPort=destPort&15;
+        if (srcSubPort>=outs || destSubPort>=exportOutputs) continue;
+
+        float vol=song.systemVol[chip]*dc.dispatch->getPostAmp()*song.masterVol*refPlayerVol;
+        switch (destSubPort&3) {
+          case 0:
+            vol*=MIN(1.0f,1.0f-song.systemPan[chip])*MIN(1.0f,1.0f+song.systemPanFR[chip]);
+            break;
+          case 1:
+            vol*=MIN(1.0f,1.0f+song.systemPan[chip])*MIN(1.0f,1.0f+song.systemPanFR[chip]);
+            break;
+          case 2:
+            vol*=MIN(1.0f,1.0f-song.systemPan[chip])*MIN(1.0f,1.0f-song.systemPanFR[chip]);
+            break;
+          case 3:
+            vol*=MIN(1.0f,1.0f+song.systemPan[chip])*MIN(1.0f,1.0f-song.systemPanFR[chip]);
+            break;
+        }
+        DivMixKernel::mix(stemOut[destSubPort],dc.chanBBOut[chipChan*outs+srcSubPort],vol,size);
+      }
+      if (forceMono && exportOutputs>1) {
+        for (unsigned int j=0; j<size; j++) {
+          float chanSum=stemOut[0][j];
+          for (int k=1; k<exportOutputs; k++) {
+            chanSum+=stemOut[k][j];
+          }
+          for (int k=0; k<exportOutputs; k++) {
+            stemOut[k][j]=chanSum/exportOutputs;
+          }
+        }
+      }
+    }
+
+    // the fade out and the end of the song are the same for every stem
+    size_t total=0;
+    size_t fadeStart=curFadeOutSample;
+    bool wasFadingOut=isFadingOut;
+    for (unsigned int j=0; j<size; j++) {
+      total++;
+      if (isFadingOut) {
+        if (++curFadeOutSample>=fadeOutSamples) {
+          playing=false;
+          break;
+        }
+      } else if (lastLoopPos>-1 && (int)j>=lastLoopPos && totalLoops>=exportLoopCount) {
+        logD("start fading out...");
+        isFadingOut=true;
+        if (fadeOutSamples==0) break;
+      }
+    }
+
+    for (size_t i=0; i<stemCount; i++) {
+      float** stemOut=&stemBuf[i*exportOutputs];
+      size_t fadePos=fadeStart;
+      bool fading=wasFadingOut;
+      int fi=0;
+      for (size_t j=0; j<total; j++) {
+        double mul=1.0;
+        if (fading) {
+          mul=(1.0-((double)(fadePos++)/(double)fadeOutSamples));
+          if (fadeOutSamples<1.0) mul=0.0;
+        }
+        for (int k=0; k<exportOutputs; k++) {
+          outBufFinal[fi++]=MAX(-1.0f,MIN(1.0f,stemOut[k][j]))*mul;
+        }
+        if (!fading && lastLoopPos>-1 && (int)j>=lastLoopPos && totalLoops>=exportLoopCount) {
+          fading=true;
+        }
+      }
+      if (sf_writef_float(sfList[i],outBufFinal,total)!=(int)total) {
+        logE("error: failed to write entire buffer!");
+        writeFailed=true;
+        break;
+      }
+    }
+  }
+  playing=false;
+
+  delete[] outBufFinal;
+  for (int j=0; j<exportOutputs; j++) {
+    delete[] outBuf[j];
+  }
+  for (float* i: stemBuf) {
+    delete[] i;
+  }
+
+  for (SFWrapper* i: sfWrap) {
+    if (i->doClose()!=0) {
+      logE("could not close audio file!");
+    }
+    delete i;
+  }
+  return true;
+}
 
 void DivEngine::runExportThread() {
   size_t fadeOutSamples=got.rate*exportFadeOut;
@@ -178,37 +616,7 @@ void DivEngine::runExportThread() {
       memset(&si,0,sizeof(SF_INFO));
       si.samplerate=got.rate;
       si.channels=exportOutputs;
-      switch (exportFormat) {
-        case DIV_EXPORT_FORMAT_WAV:
-          si.format=SF_FORMAT_WAV;
-          switch (wavFormat) {
-            case DIV_EXPORT_WAV_U8:
-              si.format|=SF_FORMAT_PCM_U8;
-              break;
-            case DIV_EXPORT_WAV_S16:
-              si.format|=SF_FORMAT_PCM_16;
-              break;
-            case DIV_EXPORT_WAV_F32:
-              si.format|=SF_FORMAT_FLOAT;
-              break;
-            default:
-              si.format|=SF_FORMAT_PCM_U8;
-              break;
-          }
-          break;
-        case DIV_EXPORT_FORMAT_OPUS:
-          si.format=SF_FORMAT_OGG|SF_FORMAT_OPUS;
-          break;
-        case DIV_EXPORT_FORMAT_FLAC:
-          si.format=SF_FORMAT_FLAC|SF_FORMAT_PCM_16;
-          break;
-        case DIV_EXPORT_FORMAT_VORBIS:
-          si.format=SF_FORMAT_OGG|SF_FORMAT_VORBIS;
-          break;
-        case DIV_EXPORT_FORMAT_MPEG_L3:
-          si.format=SF_FORMAT_MPEG|SF_FORMAT_MPEG_LAYER_III;
-          break;
-      }
+      si.format=exportFileFormat(exportFormat,wavFormat);
 
       sf=sfWrap.doOpen(exportPath.c_str(),SFM_WRITE,&si);
       if (sf==NULL) {
@@ -219,12 +627,36 @@ void DivEngine::runExportThread() {
 
       MAP_BITRATE;
 
+      // additional files, each encoded by its own writer thread
+      std::vector<SFWrapper*> extraWrap;
+      std::vector<DivExportWriter*> extraWriters;
+      std::vector<String> extraPaths;
+      for (DivAudioExportTarget& i: exportExtraTargets) {
+        SF_INFO extraInfo;
+        memset(&extraInfo,0,sizeof(SF_INFO));
+        extraInfo.samplerate=got.rate;
+        extraInfo.channels=exportOutputs;
+        extraInfo.format=exportFileFormat(i.format,i.wavFormat);
+        SFWrapper* w=new SFWrapper;
+        SNDFILE* extraSF=w->doOpen(i.path.c_str(),SFM_WRITE,&extraInfo);
+        if (extraSF==NULL) {
+          logE("could not open %s for writing! (%s)",i.path,sf_strerror(NULL));
+          delete w;
+          continue;
+        }
+        exportSetBitRate(extraSF,i.format,i.bitRateMode,i.bitRate,i.vbrQuality,exportOutputs,got.rate);
+        logI("- %s",i.path);
+        extraWrap.push_back(w);
+        extraPaths.push_back(i.path);
+        extraWriters.push_back(new DivExportWriter(extraSF,exportOutputs));
+      }
+
       float* outBuf[DIV_MAX_OUTPUTS];
       float* outBufFinal;
       for (int i=0; i<exportOutputs; i++) {
         outBuf[i]=new float[EXPORT_BUFSIZE];
       }
-      outBufFinal=new float[EXPORT_BUFSIZE*exportOutputs];
+      DivExportWriter* writer=new DivExportWriter(sf,exportOutputs);
 
       // take control of audio output
       deinitAudioBackend();
@@ -234,45 +666,172 @@ void DivEngine::runExportThread() {
 
       logI("rendering to file...");
 
+      // queue a filled buffer for writing to every file
+      auto commitAll=[&](size_t total) {
+        writer->commit(total);
+        for (DivExportWriter* i: extraWriters) {
+          float* extraBuf=i->acquire();
+          if (extraBuf==NULL) continue;
+          memcpy(extraBuf,outBufFinal,total*exportOutputs*sizeof(float));
+          i->commit(total);
+        }
+      };
+
+      // loop reuse: record each pass through the loop. once two passes in a
+      // row come out identical, the rest of the loops are copied from it.
+      bool recordPass=exportReuseLoops;
+      bool passStarted=false;
+      bool reusePass=false;
+      size_t maxPassLen=(size_t)got.rate*EXPORT_REUSE_MAX_SECONDS*exportOutputs;
+      std::vector<float> passPrev, passCur;
+
       while (playing) {
         size_t total=0;
+        outBufFinal=writer->acquire();
+        if (outBufFinal==NULL) {
+          logE("error: failed to write entire buffer!");
+          break;
+        }
+        int loopsBefore=totalLoops;
         nextBuf(NULL,outBuf,0,exportOutputs,EXPORT_BUFSIZE);
         if (totalProcessed>EXPORT_BUFSIZE) {
           logE("error: total processed is bigger than export bufsize! %d>%d",totalProcessed,EXPORT_BUFSIZE);
           totalProcessed=EXPORT_BUFSIZE;
         }
-        int fi=0;
-        for (int i=0; i<(int)totalProcessed; i++) {
-          total++;
-          if (isFadingOut) {
-            double mul=(1.0-((double)curFadeOutSample/(double)fadeOutSamples));
-            if (fadeOutSamples<1.0) mul=0.0;
-            for (int j=0; j<exportOutputs; j++) {
-              outBufFinal[fi++]=MAX(-1.0f,MIN(1.0f,outBuf[j][i]))*mul;
-            }
-            if (++curFadeOutSample>=fadeOutSamples) {
-              playing=false;
-              break;
+        int i=0;
+        if (!isFadingOut) {
+          // copy everything up to the point where fading begins in one go
+          int runEnd=totalProcessed;
+          bool startFade=false;
+          if (lastLoopPos>-1 && totalLoops>=exportLoopCount && lastLoopPos<runEnd) {
+            runEnd=MAX(lastLoopPos,0)+1;
+            startFade=true;
+          }
+          exportInterleave(outBufFinal,outBuf,exportOutputs,0,runEnd);
+          total+=runEnd;
+          i=runEnd;
+          if (startFade) {
+            logD("start fading out...");
+            isFadingOut=true;
+            if (fadeOutSamples==0) i=totalProcessed;
+          } else if (recordPass) {
+            if (totalLoops-loopsBefore>1) {
+              // the loop is shorter than a buffer
+              recordPass=false;
+            } else if (lastLoopPos>-1 && lastLoopPos<runEnd) {
+              // a new pass begins at lastLoopPos
+              if (passStarted) {
+                passCur.insert(passCur.end(),outBufFinal,outBufFinal+lastLoopPos*exportOutputs);
+                if (!passCur.empty() && passCur==passPrev) {
+                  reusePass=true;
+                  total=lastLoopPos;
+                  i=totalProcessed;
+                } else {
+                  passPrev.swap(passCur);
+                }
+              }
+              if (!reusePass) {
+                passCur.clear();
+                passCur.insert(passCur.end(),outBufFinal+lastLoopPos*exportOutputs,outBufFinal+runEnd*exportOutputs);
+                passStarted=true;
+              }
+            } else if (passStarted) {
+              passCur.insert(passCur.end(),outBufFinal,outBufFinal+runEnd*exportOutputs);
             }
-          } else {
-            for (int j=0; j<exportOutputs; j++) {
-              outBufFinal[fi++]=MAX(-1.0f,MIN(1.0f,outBuf[j][i]));
+            if (passCur.size()>maxPassLen) {
+              logD("loop is too long to be reused.");
+              recordPass=false;
             }
-            if (lastLoopPos>-1 && i>=lastLoopPos && totalLoops>=exportLoopCount) {
-              logD("start fading out...");
-              isFadingOut=true;
-              if (fadeOutSamples==0) break;
+            if (!recordPass) {
+              passPrev.clear();
+              passPrev.shrink_to_fit();
+              passCur.clear();
+              passCur.shrink_to_fit();
             }
           }
         }
-        
-        if (sf_writef_float(sf,outBufFinal,total)!=(int)total) {
-          logE("error: failed to write entire buffer!");
-          break;
+        int fi=i*exportOutputs;
+        for (; i<(int)totalProcessed; i++) {
+          total++;
+          double mul=(1.0-((double)curFadeOutSample/(double)fadeOutSamples));
+          if (fadeOutSamples<1.0) mul=0.0;
+          for (int j=0; j<exportOutputs; j++) {
+            outBufFinal[fi++]=MAX(-1.0f,MIN(1.0f,outBuf[j][i]))*mul;
+          }
+          if (++curFadeOutSample>=fadeOutSamples) {
+            playing=false;
+            break;
+          }
+        }
+
+        commitAll(total);
+        if (reusePass) break;
+      }
+
+      if (reusePass) {
+        // the song has become periodic. write the remaining passes (and the
+        // fade out) from the recorded one, exactly as rendering would.
+        logI("loop repeats exactly. reusing it for the remaining loops...");
+        size_t passLen=passPrev.size()/exportOutputs;
+        size_t pos=0;
+        bool firstFrame=true;
+        bool done=false;
+        while (!done && playing && !stopExport) {
+          outBufFinal=writer->acquire();
+          if (outBufFinal==NULL) {
+            logE("error: failed to write entire buffer!");
+            break;
+          }
+          size_t total=0;
+          int fi=0;
+          while (total<EXPORT_BUFSIZE) {
+            const float* frame=&passPrev[pos*exportOutputs];
+            if (!isFadingOut) {
+              if (pos==0 && !firstFrame) totalLoops++;
+              firstFrame=false;
+              for (int j=0; j<exportOutputs; j++) {
+                outBufFinal[fi++]=frame[j];
+              }
+              total++;
+              if (pos==0 && totalLoops>=exportLoopCount) {
+                logD("start fading out...");
+                isFadingOut=true;
+              }
+            } else {
+              double mul=(1.0-((double)curFadeOutSample/(double)fadeOutSamples));
+              if (fadeOutSamples<1.0) mul=0.0;
+              for (int j=0; j<exportOutputs; j++) {
+                outBufFinal[fi++]=frame[j]*mul;
+              }
+              total++;
+              if (++curFadeOutSample>=fadeOutSamples) {
+                done=true;
+                break;
+              }
+            }
+            if (++pos>=passLen) pos=0;
+          }
+          commitAll(total);
         }
+        playing=false;
+        freelance=false;
+        extValuePresent=false;
       }
 
-      delete[] outBufFinal;
+      if (!writer->finish()) {
+        logE("error: failed to write entire buffer!");
+      }
+      delete writer;
+      for (size_t i=0; i<extraWriters.size(); i++) {
+        if (!extraWriters[i]->finish()) {
+          logE("error: failed to write entire buffer! (%s)",extraPaths[i]);
+        }
+        delete extraWriters[i];
+        if (extraWrap[i]->doClose()!=0) {
+          logE("could not close audio file!");
+        }
+        delete extraWrap[i];
+      }
       for (int i=0; i<exportOutputs; i++) {
         delete[] outBuf[i];
       }
@@ -416,152 +975,137 @@ void DivEngine::runExportThread() {
 
       curExportChan=0;
 
-      float* outBuf[DIV_MAX_OUTPUTS];
-      float* outBufFinal;
-      for (int i=0; i<exportOutputs; i++) {
-        outBuf[i]=new float[EXPORT_BUFSIZE];
-      }
-      outBufFinal=new float[EXPORT_BUFSIZE*exportOutputs];
-
-      logI("rendering to files...");
-      
+      // make a list of stems. channels of type 5 belong to the previous one
+      std::vector<int> stems;
       for (int i=0; i<song.chans; i++) {
         if (!exportChannelMask[i]) continue;
-
-        SNDFILE* sf;
-        SF_INFO si;
-        SFWrapper sfWrap;
-        memset(&si,0,sizeof(SF_INFO));
-        String fname=fmt::sprintf("%s_c%02d.wav",exportPath,i+1);
-        logI("- %s",fname.c_str());
-        si.samplerate=got.rate;
-        si.channels=exportOutputs;
-        switch (exportFormat) {
-          case DIV_EXPORT_FORMAT_WAV:
-            si.format=SF_FORMAT_WAV;
-            switch (wavFormat) {
-              case DIV_EXPORT_WAV_U8:
-                si.format|=SF_FORMAT_PCM_U8;
-                break;
-              case DIV_EXPORT_WAV_S16:
-                si.format|=SF_FORMAT_PCM_16;
-                break;
-              case DIV_EXPORT_WAV_F32:
-                si.format|=SF_FORMAT_FLOAT;
-                break;
-              default:
-                si.format|=SF_FORMAT_PCM_U8;
-                break;
-            }
-            break;
-          case DIV_EXPORT_FORMAT_OPUS:
-            si.format=SF_FORMAT_OGG|SF_FORMAT_OPUS;
-            break;
-          case DIV_EXPORT_FORMAT_FLAC:
-            si.format=SF_FORMAT_FLAC|SF_FORMAT_PCM_16;
-            break;
-          case DIV_EXPORT_FORMAT_VORBIS:
-            si.format=SF_FORMAT_OGG|SF_FORMAT_VORBIS;
-            break;
-          case DIV_EXPORT_FORMAT_MPEG_L3:
-            si.format=SF_FORMAT_MPEG|SF_FORMAT_MPEG_LAYER_III;
-            break;
-        }
-
-        sf=sfWrap.doOpen(fname.c_str(),SFM_WRITE,&si);
-        if (sf==NULL) {
-          logE("could not open file for writing! (%s)",sf_strerror(NULL));
-          break;
+        stems.push_back(i);
+        if (getChannelType(i)==5) {
+          i++;
+          while (true) {
+            if (i>=song.chans) break;
+            if (getChannelType(i)!=5) break;
+            i++;
+          }
+          i--;
         }
+      }
 
-        MAP_BITRATE;
+      logI("rendering to files...");
 
-        for (int j=0; j<song.chans; j++) {
-          bool mute=(j!=i);
-          isMuted[j]=mute;
+      // channels of chips which output each channel on its own are rendered in one pass.
+      // this can't be done if there are master effects, as they aren't linear.
+      if (effectInst.empty()) {
+        bool chanOutputs[DIV_MAX_CHIPS];
+        memset(chanOutputs,0,DIV_MAX_CHIPS*sizeof(bool));
+        for (int i: stems) {
+          chanOutputs[song.dispatchOfChan[i]]=true;
         }
-        if (getChannelType(i)==5) {
-          for (int j=i; j<song.chans; j++) {
-            if (getChannelType(j)!=5) break;
-            isMuted[j]=false;
+        for (int i=0; i<song.systemLen; i++) {
+          if (!chanOutputs[i]) continue;
+          chanOutputs[i]=disCont[i].setChanOutputs(song.systemChans[i]);
+          if (!chanOutputs[i]) {
+            logD("chip %d (%s) can't output each channel on its own. rendering its channels one at a time.",i,getSystemName(song.system[i]));
           }
         }
-        for (int j=0; j<song.chans; j++) {
-          if (disCont[song.dispatchOfChan[j]].dispatch!=NULL && song.dispatchChanOfChan[j]>=0) {
-            disCont[song.dispatchOfChan[j]].dispatch->muteChannel(song.dispatchChanOfChan[j],isMuted[j]);
+
+        std::vector<int> onePass;
+        std::vector<int> rest;
+        for (int i: stems) {
+          if (chanOutputs[song.dispatchOfChan[i]] && song.dispatchChanOfChan[i]>=0 && getChannelType(i)!=5) {
+            onePass.push_back(i);
+          } else {
+            rest.push_back(i);
           }
         }
-        
-        curOrder=0;
-        prevOrder=0;
-        curFadeOutSample=0;
-        lastLoopPos=-1;
-        totalLoops=0;
-        isFadingOut=false;
-        remainingLoops=-1;
-        freelance=false;
-        playSub(false);
-        freelance=false;
 
-        while (playing) {
-          size_t total=0;
-          nextBuf(NULL,outBuf,0,exportOutputs,EXPORT_BUFSIZE);
-          if (totalProcessed>EXPORT_BUFSIZE) {
-            logE("error: total processed is bigger than export bufsize! %d>%d",totalProcessed,EXPORT_BUFSIZE);
-            totalProcessed=EXPORT_BUFSIZE;
-          }
-          int fi=0;
-          for (int j=0; j<(int)totalProcessed; j++) {
-            total++;
-            if (isFadingOut) {
-              double mul=(1.0-((double)curFadeOutSample/(double)fadeOutSamples));
-              if (fadeOutSamples<1.0) mul=0.0;
-              for (int k=0; k<exportOutputs; k++) {
-                outBufFinal[fi++]=MAX(-1.0f,MIN(1.0f,outBuf[k][j]))*mul;
-              }
-              if (++curFadeOutSample>=fadeOutSamples) {
-                playing=false;
-                break;
-              }
-            } else {
-              for (int k=0; k<exportOutputs; k++) {
-                outBufFinal[fi++]=MAX(-1.0f,MIN(1.0f,outBuf[k][j]));
-              }
-              if (lastLoopPos>-1 && j>=lastLoopPos && totalLoops>=exportLoopCount) {
-                logD("start fading out...");
-                isFadingOut=true;
-                if (fadeOutSamples==0) break;
-              }
-            }
-          }
-          if (sf_writef_float(sf,outBufFinal,total)!=(int)total) {
-            logE("error: failed to write entire buffer!");
-            break;
+        if (!onePass.empty()) {
+          logI("rendering %d channels in one pass.",(int)onePass.size());
+          if (exportChanStemsOnePass(onePass,this)) {
+            curExportChan+=onePass.size();
+            stems=rest;
           }
         }
 
-        curExportChan++;
+        for (int i=0; i<song.systemLen; i++) {
+          if (chanOutputs[i]) disCont[i].setChanOutputs(0);
+        }
+      }
 
-        if (sfWrap.doClose()!=0) {
-          logE("could not close audio file!");
+      int threads=exportThreads;
+      if (threads<=0) threads=std::thread::hardware_concurrency();
+      if (threads>(int)stems.size()) threads=stems.size();
+
+      SafeWriter* songCopy=NULL;
+      if (threads>1) {
+        songCopy=saveFur(true);
+        if (songCopy==NULL) {
+          logW("could not copy song for render workers! rendering in one thread.");
+          threads=1;
         }
+      }
 
-        if (getChannelType(i)==5) {
-          i++;
-          while (true) {
-            if (i>=song.chans) break;
-            if (getChannelType(i)!=5) break;
-            i++;
+      if (threads>1) {
+        // render stems in parallel, each worker with its own engine
+        logI("using %d render workers.",threads);
+        std::atomic<size_t> nextStem(0);
+        std::mutex progressLock;
+        std::vector<std::thread*> workers;
+        for (int i=0; i<threads; i++) {
+          unsigned char* data=new unsigned char[songCopy->size()];
+          memcpy(data,songCopy->getFinalBuf(),songCopy->size());
+          size_t dataLen=songCopy->size();
+          try {
+            workers.push_back(new std::thread([this,data,dataLen,&stems,&nextStem,&progressLock]() {
+              DivEngine* worker=new DivEngine;
+              if (worker->initRenderWorker(this,data,dataLen)) {
+                worker->exportFormat=exportFormat;
+                worker->wavFormat=wavFormat;
+                worker->exportBitRate=exportBitRate;
+                worker->exportBitRateMode=exportBitRateMode;
+                worker->exportVBRQuality=exportVBRQuality;
+                worker->exportFadeOut=exportFadeOut;
+                worker->exportOutputs=exportOutputs;
+                worker->exportLoopCount=exportLoopCount;
+                worker->exportPath=exportPath;
+                worker->repeatPattern=false;
+                while (!stopExport) {
+                  size_t stem=nextStem++;
+                  if (stem>=stems.size()) break;
+                  if (!worker->exportChanStem(stems[stem],this)) break;
+                  progressLock.lock();
+                  curExportChan++;
+                  progressLock.unlock();
+                }
+              } else {
+                logE("could not start render worker!");
+              }
+              worker->quit(false);
+              delete worker;
+            }));
+          } catch (std::system_error& e) {
+            logE("could not start render worker thread! %s",e.what());
+            delete[] data;
           }
-          i--;
         }
+        for (std::thread* i: workers) {
+          i->join();
+          delete i;
+        }
+        songCopy->finish();
+        delete songCopy;
 
-        if (stopExport) break;
-      }
-
-      delete[] outBufFinal;
-      for (int i=0; i<exportOutputs; i++) {
-        delete[] outBuf[i];
+        // render whatever workers couldn't
+        while (!stopExport && nextStem<stems.size()) {
+          if (!exportChanStem(stems[nextStem++],this)) break;
+          curExportChan++;
+        }
+      } else {
+        for (int i: stems) {
+          if (!exportChanStem(i,this)) break;
+          curExportChan++;
+          if (stopExport) break;
+        }
       }
 
       for (int i=0; i<song.chans; i++) {
@@ -592,6 +1136,14 @@ void DivEngine::runExportThread() {
 #else
 void DivEngine::runExportThread() {
 }
+
+bool DivEngine::exportChanStem(int chan, DivEngine* host) {
+  return false;
+}
+
+bool DivEngine::exportChanStemsOnePass(const std::vector<int>& chans, DivEngine* host) {
+  return false;
+}
 #endif
 
 bool DivEngine::shallSwitchCores() {
@@ -603,6 +1155,7 @@ bool DivEngine::saveAudio(const char* path, DivAudioExportOptions options) {
   logE("Furnace was not compiled with libsndfile. cannot export!");
   return false;
 #else
+  waitForSamples();
   exportPath=path;
   exportMode=options.mode;
   exportFormat=options.format;
@@ -611,6 +1164,9 @@ bool DivEngine::saveAudio(const char* path, DivAudioExportOptions options) {
   exportBitRateMode=options.bitRateMode;
   exportVBRQuality=options.vbrQuality;
   exportFadeOut=options.fadeOut;
+  exportThreads=options.threads;
+  exportExtraTargets=options.extraTargets;
+  exportReuseLoops=options.reuseLoops;
   memcpy(exportChannelMask,options.channelMask,DIV_MAX_CHANS*sizeof(bool));
   if (exportMode!=DIV_EXPORT_MODE_ONE) {
     // remove extension
@@ -629,7 +1185,13 @@ bool DivEngine::saveAudio(const char* path, DivAudioExportOptions options) {
   repeatPattern=false;
   setOrder(0);
   remainingLoops=-1;
-  if (options.format==DIV_EXPORT_FORMAT_OPUS) {
+  bool anyOpus=(options.format==DIV_EXPORT_FORMAT_OPUS);
+  if (exportMode==DIV_EXPORT_MODE_ONE) {
+    for (DivAudioExportTarget& i: exportExtraTargets) {
+      if (i.format==DIV_EXPORT_FORMAT_OPUS) anyOpus=true;
+    }
+  }
+  if (anyOpus) {
     // Opus only supports 48KHz and a couple divisors of that number...
     got.rate=48000;
   } else {
@@ -47,6 +47,52 @@ bool DivWaveSynth::activeChanged() {
   return false;
 }
 
+void DivWaveSynthCache::get(const DivWavetable* wave, int width, int height, unsigned char* out) {
+  std::lock_guard<std::mutex> guard(lock);
+  Entry* victim=&entries[0];
+  useCount++;
+  for (int i=0; i<DIV_WS_CACHE_SIZE; i++) {
+    Entry& entry=entries[i];
+    if (entry.wave==wave && entry.width==width && entry.height==height && entry.len==wave->len && entry.max==wave->max) {
+      entry.lastUse=useCount;
+      memcpy(out,entry.data,width);
+      return;
+    }
+    if (entry.wave==NULL) {
+      if (victim->wave!=NULL) victim=&entry;
+    } else if (victim->wave!=NULL && entry.lastUse<victim->lastUse) {
+      victim=&entry;
+    }
+  }
+
+  victim->wave=wave;
+  victim->width=width;
+  victim->height=height;
+  victim->len=wave->len;
+  victim->max=wave->max;
+  victim->lastUse=useCount;
+  for (int i=0; i<width; i++) {
+    if (wave->max<1 || wave->len<1) {
+      victim->data[i]=0;
+    } else {
+      int data=wave->data[i*wave->len/width]*height/wave->max;
+      if (data<0) data=0;
+      if (data>height) data=height;
+      victim->data[i]=data;
+    }
+  }
+  memcpy(out,victim->data,width);
+}
+
+void DivWaveSynthCache::invalidate(const DivWavetable* wave) {
+  std::lock_guard<std::mutex> guard(lock);
+  for (int i=0; i<DIV_WS_CACHE_SIZE; i++) {
+    if (wave==NULL || entries[i].wave==wave) {
+      entries[i]=Entry();
+    }
+  }
+}
+
 #define WS_BEGIN int _oldOut=output[pos];
 #define WS_END if (output[pos]!=_oldOut) updated=true;
 
@@ -261,36 +307,19 @@ void DivWaveSynth::setWidth(int val) {
 #define SHALL_UPDATE_OUT (!state.enabled || force || (state.enabled && effectOnlyAltersOutput(state.effect)))
 
 void DivWaveSynth::changeWave1(int num, bool force) {
-  DivWavetable* w1=e->getWave(num);
   if (width<1) return;
-  for (int i=0; i<width; i++) {
-    if (w1->max<1 || w1->len<1) {
-      wave1[i]=0;
-      if (SHALL_UPDATE_OUT) output[i]=0;
-    } else {
-      int data=w1->data[i*w1->len/width]*height/w1->max;
-      if (data<0) data=0;
-      if (data>height) data=height;
-      wave1[i]=data;
-      if (SHALL_UPDATE_OUT) output[i]=data;
+  e->getWaveSynthCache().get(e->getWave(num),width,height,wave1);
+  if (SHALL_UPDATE_OUT) {
+    for (int i=0; i<width; i++) {
+      output[i]=wave1[i];
     }
   }
   first=true;
 }
 
 void DivWaveSynth::changeWave2(int num) {
-  DivWavetable* w2=e->getWave(num);
   if (width<1) return;
-  for (int i=0; i<width; i++) {
-    if (w2->max<1 || w2->len<1) {
-      wave2[i]=0;
-    } else {
-      int data=w2->data[i*w2->len/width]*height/w2->max;
-      if (data<0) data=0;
-      if (data>height) data=height;
-      wave2[i]=data;
-    }
-  }
+  e->getWaveSynthCache().get(e->getWave(num),width,height,wave2);
   first=true;
 }
 
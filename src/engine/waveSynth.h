@@ -22,9 +22,58 @@
 
 #include "instrument.h"
 #include "wavetable.h"
+#include <mutex>
 
 class DivEngine;
 
+// number of converted waves kept by DivWaveSynthCache
+#define DIV_WS_CACHE_SIZE 64
+
+/**
+ * a cache of wavetables converted to a given size (width and height).
+ * wave macros and wave synths convert a wavetable on every wave change, and
+ * channels playing the same instrument convert the same ones over and over.
+ * entries are keyed by wavetable pointer and size, and the least recently used
+ * one is replaced when the cache is full.
+ * the cache belongs to an engine. it is shared by the dispatches and the
+ * instrument editor's preview, hence the lock.
+ */
+class DivWaveSynthCache {
+  struct Entry {
+    const DivWavetable* wave;
+    int width, height;
+    int len, max;
+    unsigned int lastUse;
+    unsigned char data[256];
+    Entry():
+      wave(NULL),
+      width(0),
+      height(0),
+      len(0),
+      max(0),
+      lastUse(0) {}
+  };
+  Entry entries[DIV_WS_CACHE_SIZE];
+  unsigned int useCount;
+  std::mutex lock;
+  public:
+    /**
+     * get a wavetable converted to the given size.
+     * @param wave the wavetable.
+     * @param width the width (1-256).
+     * @param height the height.
+     * @param out where to write the converted wave (width values).
+     */
+    void get(const DivWavetable* wave, int width, int height, unsigned char* out);
+    /**
+     * discard the entries of a wavetable. call after changing it.
+     * @param wave the wavetable, or NULL to discard all entries.
+     */
+    void invalidate(const DivWavetable* wave=NULL);
+    DivWaveSynthCache():
+      useCount(0) {}
+};
+
 class DivWaveSynth {
   DivEngine* e;
   DivInstrumentWaveSynth state;
@@ -34,9 +34,7 @@ void DivWavetable::putWaveData(SafeWriter* w) {
   w->writeI(len);
   w->writeI(min);
   w->writeI(max);
-  for (int j=0; j<len; j++) {
-    w->writeI(data[j]);
-  }
+  w->writeArray(data,len);
 
   blockEndSeek=w->tell();
   w->seek(blockStartSeek,SEEK_SET);
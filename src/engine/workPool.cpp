@@ -18,94 +18,255 @@
  */
 
 #include "workPool.h"
+#include "trace.h"
 #include "../ta-log.h"
+#include <chrono>
 #include <thread>
+#include <stdio.h>
+#include <string.h>
 
-void* _workThread(void* inst) {
-  ((DivWorkThread*)inst)->run();
-  return NULL;
-}
-
-void DivWorkThread::run() {
-  //std::unique_lock<std::mutex> unique(selfLock);
-  DivPendingTask task;
-  bool setFuckingPromise=false;
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <pthread.h>
+#include <pthread/qos.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
 
-  logV("running work thread");
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <emmintrin.h>
+#define DIV_CPU_RELAX _mm_pause()
+#elif defined(__aarch64__) || (defined(__ARM_ARCH) && __ARM_ARCH>=7)
+#define DIV_CPU_RELAX __asm__ __volatile__("yield")
+#else
+#define DIV_CPU_RELAX
+#endif
 
-  while (true) {
-    lock.lock();
-    if (tasks.empty()) {
-      lock.unlock();
-      isBusy=false;
-      if (setFuckingPromise) {
-        parent->notify.set_value();
-        setFuckingPromise=false;
-        //std::this_thread::yield();
-      }
-      if (terminate) {
-        break;
-      }
-      std::future<void> future=notify.get_future();
-      future.wait();
-      lock.lock();
-      notify=std::promise<void>();
-      promiseAlreadySet=false;
-      lock.unlock();
-      continue;
-    } else {
-      task=tasks.front();
-      tasks.pop();
-      lock.unlock();
+// how many times to spin before yielding
+#define DIV_WORK_SPIN_COUNT 4096
+// how long to yield (in microseconds) before parking
+#define DIV_WORK_YIELD_TIME 250
 
-      task.func(task.funcArg);
+#define RANGE_MAKE(gen,next,end) (((unsigned long long)(gen)<<32)|((unsigned long long)(end)<<16)|(unsigned long long)(next))
 
-      int busyCount=--parent->busyCount;
-      if (busyCount<0) {
-        logE("oh no PROBLEM...");
-      }
-      if (busyCount==0) {
-        setFuckingPromise=true;
-      }
+// list the cores to run on, fastest first.
+// on big.LITTLE systems only the performance cores are listed (if there are
+// at least two of them), since the scheduler likes to put busy-waiting
+// threads on efficiency cores.
+static std::vector<int> getPerformanceCores() {
+  std::vector<int> ret;
+#if defined(__linux__)
+  long coreCount=sysconf(_SC_NPROCESSORS_CONF);
+  std::vector<long> capacity;
+  long maxCapacity=0;
+  for (long i=0; i<coreCount && i<CPU_SETSIZE; i++) {
+    long cap=-1;
+    char path[256];
+    // cpu_capacity is present on ARM. cpuinfo_max_freq is close enough elsewhere.
+    snprintf(path,255,"/sys/devices/system/cpu/cpu%ld/cpu_capacity",i);
+    FILE* f=fopen(path,"r");
+    if (f==NULL) {
+      snprintf(path,255,"/sys/devices/system/cpu/cpu%ld/cpufreq/cpuinfo_max_freq",i);
+      f=fopen(path,"r");
+    }
+    if (f!=NULL) {
+      if (fscanf(f,"%ld",&cap)!=1) cap=-1;
+      fclose(f);
+    }
+    capacity.push_back(cap);
+    if (cap>maxCapacity) maxCapacity=cap;
+  }
+  for (size_t i=0; i<capacity.size(); i++) {
+    // within 80% of the fastest core. some CPUs boost a couple of cores a bit higher than the rest.
+    if (maxCapacity<=0 || capacity[i]*5>=maxCapacity*4) ret.push_back(i);
+  }
+  if (ret.size()<2) {
+    ret.clear();
+    for (size_t i=0; i<capacity.size(); i++) {
+      ret.push_back(i);
     }
   }
+#elif defined(_WIN32)
+  DWORD_PTR processMask=0, systemMask=0;
+  if (GetProcessAffinityMask(GetCurrentProcess(),&processMask,&systemMask)) {
+    for (int i=0; i<(int)(sizeof(DWORD_PTR)*8); i++) {
+      if (processMask&((DWORD_PTR)1<<i)) ret.push_back(i);
+    }
+  }
+#endif
+  // macOS has no affinity API. the QoS class takes care of core selection.
+  return ret;
 }
 
-bool DivWorkThread::assign(void (*what)(void*), void* arg) {
-  lock.lock();
-  if (tasks.size()>=30) {
-    lock.unlock();
-    return false;
+// pin the calling thread to a core.
+// if prevMask isn't NULL, the previous affinity is stored there (one bit per core).
+// this doesn't log as it may run in the audio callback.
+static bool pinCurrentThread(int core, unsigned long long* prevMask=NULL) {
+#if defined(__linux__)
+  cpu_set_t set;
+  if (prevMask!=NULL) {
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0,sizeof(cpu_set_t),&set)!=0) return false;
+    memset(prevMask,0,DIV_WORK_MASK_WORDS*sizeof(unsigned long long));
+    for (int i=0; i<CPU_SETSIZE && i<DIV_WORK_MASK_WORDS*64; i++) {
+      if (CPU_ISSET(i,&set)) prevMask[i>>6]|=1ULL<<(i&63);
+    }
+  }
+  CPU_ZERO(&set);
+  CPU_SET(core,&set);
+  return (sched_setaffinity(0,sizeof(cpu_set_t),&set)==0);
+#elif defined(_WIN32)
+  DWORD_PTR prev=SetThreadAffinityMask(GetCurrentThread(),(DWORD_PTR)1<<core);
+  if (prev==0) return false;
+  if (prevMask!=NULL) {
+    memset(prevMask,0,DIV_WORK_MASK_WORDS*sizeof(unsigned long long));
+    prevMask[0]=prev;
   }
-  tasks.push(DivPendingTask(what,arg));
-  parent->busyCount++;
-  isBusy=true;
-  lock.unlock();
   return true;
+#else
+  return false;
+#endif
 }
 
-void DivWorkThread::wait() {
-  if (!isBusy) return;
+static long long getCurrentThreadID() {
+#if defined(__linux__)
+  return syscall(SYS_gettid);
+#elif defined(_WIN32)
+  return GetCurrentThreadId();
+#else
+  return 0;
+#endif
 }
 
-bool DivWorkThread::busy() {
-  return isBusy;
+// give a thread pinned by pinCurrentThread() its previous affinity back.
+static bool restoreThreadAffinity(long long tid, const unsigned long long* mask) {
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int i=0; i<CPU_SETSIZE && i<DIV_WORK_MASK_WORDS*64; i++) {
+    if (mask[i>>6]&(1ULL<<(i&63))) CPU_SET(i,&set);
+  }
+  return (sched_setaffinity((pid_t)tid,sizeof(cpu_set_t),&set)==0);
+#elif defined(_WIN32)
+  HANDLE thread=OpenThread(THREAD_SET_INFORMATION|THREAD_QUERY_INFORMATION,FALSE,(DWORD)tid);
+  if (thread==NULL) return false;
+  bool ret=(SetThreadAffinityMask(thread,(DWORD_PTR)mask[0])!=0);
+  CloseHandle(thread);
+  return ret;
+#else
+  return false;
+#endif
 }
 
-void DivWorkThread::finish() {
-  lock.lock();
-  terminate=true;
-  try {
-    notify.set_value();
-  } catch (std::future_error& e) {
-    logE("future error! beware!");
+#ifdef _WIN32
+typedef HANDLE (WINAPI *AvSetMmThreadCharacteristicsWFunc)(LPCWSTR,LPDWORD);
+#endif
+
+static void setCurrentThreadPriority(DivWorkPriority prio) {
+  if (prio==DIV_WORK_PRIORITY_NORMAL) return;
+#if defined(__linux__)
+  if (prio==DIV_WORK_PRIORITY_REALTIME) {
+    struct sched_param param;
+    param.sched_priority=sched_get_priority_min(SCHED_FIFO)+1;
+    if (pthread_setschedparam(pthread_self(),SCHED_FIFO,&param)==0) return;
+    logW("could not set real-time priority. using high priority instead.");
+  }
+  // on Linux the nice value is per-thread
+  if (setpriority(PRIO_PROCESS,syscall(SYS_gettid),-10)!=0) {
+    logW("could not raise thread priority!");
+  }
+#elif defined(__APPLE__)
+  if (pthread_set_qos_class_self_np(QOS_CLASS_USER_INTERACTIVE,0)!=0) {
+    logW("could not set thread QoS class!");
+  }
+#elif defined(_WIN32)
+  if (prio==DIV_WORK_PRIORITY_REALTIME) {
+    // avrt.dll is loaded at run-time so that we don't have to link against it
+    HMODULE avrt=LoadLibraryW(L"avrt.dll");
+    if (avrt!=NULL) {
+      AvSetMmThreadCharacteristicsWFunc avSet=(AvSetMmThreadCharacteristicsWFunc)GetProcAddress(avrt,"AvSetMmThreadCharacteristicsW");
+      DWORD taskIndex=0;
+      if (avSet!=NULL && avSet(L"Pro Audio",&taskIndex)!=NULL) return;
+    }
+    logW("could not register thread with MMCSS. using high priority instead.");
+  }
+  if (!SetThreadPriority(GetCurrentThread(),THREAD_PRIORITY_HIGHEST)) {
+    logW("could not raise thread priority!");
+  }
+#endif
+}
+
+void* _workThread(void* inst) {
+  ((DivWorkThread*)inst)->run();
+  return NULL;
+}
+
+void DivWorkThread::setPolicy() {
+  setCurrentThreadPriority(parent->priority);
+  if (parent->pinCores && parent->cores.size()>=2) {
+    // core 0 of the list is left to the thread calling wait()
+    int core=parent->cores[1+(index%(parent->cores.size()-1))];
+    if (!pinCurrentThread(core)) {
+      logW("could not pin thread to core %d!",core);
+    }
+  }
+}
+
+void DivWorkThread::run() {
+  unsigned int seen=parent->generation.load(std::memory_order_acquire);
+
+  logV("running work thread");
+  DIV_TRACE_THREAD("render pool");
+  setPolicy();
+
+  while (true) {
+    // wait for a new batch
+    // spin first, then yield, and finally park if we've been idle for a while
+    unsigned int gen;
+    unsigned int spins=0;
+    bool yielding=false;
+    std::chrono::steady_clock::time_point idleBegin;
+    while ((gen=parent->generation.load(std::memory_order_acquire))==seen) {
+      if (parent->terminate.load(std::memory_order_relaxed)) return;
+      if (spins<DIV_WORK_SPIN_COUNT) {
+        spins++;
+        DIV_CPU_RELAX;
+        continue;
+      }
+      if (!yielding) {
+        yielding=true;
+        idleBegin=std::chrono::steady_clock::now();
+      }
+      if (std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now()-idleBegin).count()<DIV_WORK_YIELD_TIME) {
+        std::this_thread::yield();
+        continue;
+      }
+
+      std::unique_lock<std::mutex> unique(parent->parkLock);
+      parent->parked++;
+      while (parent->generation.load()==seen && !parent->terminate) {
+        parent->parkCond.wait(unique);
+      }
+      parent->parked--;
+    }
+    if (parent->terminate) return;
+    seen=gen;
+
+    // run our own tasks, then steal from the others
+    for (unsigned int i=0; i<parent->count; i++) {
+      while (parent->runOne((index+i)%parent->count,gen));
+    }
   }
-  lock.unlock();
-  thread->join();
 }
 
-bool DivWorkThread::init(DivWorkPool* p) {
+bool DivWorkThread::init(DivWorkPool* p, unsigned int i) {
   parent=p;
+  index=i;
   try {
     thread=new std::thread(_workThread,this);
   } catch (std::system_error& e) {
@@ -116,6 +277,30 @@ bool DivWorkThread::init(DivWorkPool* p) {
   return true;
 }
 
+void DivWorkThread::finish() {
+  if (thread==NULL) return;
+  thread->join();
+  delete thread;
+  thread=NULL;
+}
+
+bool DivWorkPool::runOne(unsigned int owner, unsigned int gen) {
+  std::atomic<unsigned long long>& range=workThreads[owner].range;
+  unsigned long long val=range.load(std::memory_order_acquire);
+  while (true) {
+    // this range belongs to another batch
+    if ((unsigned int)(val>>32)!=gen) return false;
+    unsigned int next=val&0xffff;
+    unsigned int end=(val>>16)&0xffff;
+    if (next>=end) return false;
+    if (range.compare_exchange_weak(val,val+1,std::memory_order_acq_rel,std::memory_order_acquire)) {
+      tasks[next].func(tasks[next].funcArg);
+      pending.fetch_sub(1,std::memory_order_acq_rel);
+      return true;
+    }
+  }
+}
+
 void DivWorkPool::push(void (*what)(void*), void* arg) {
   // if no work threads, just execute
   if (!threaded) {
@@ -123,66 +308,97 @@ void DivWorkPool::push(void (*what)(void*), void* arg) {
     return;
   }
 
-  for (unsigned int tryCount=0; tryCount<count; tryCount++) {
-    if (pos>=count) pos=0;
-    if (workThreads[pos++].assign(what,arg)) return;
+  if (taskCount>=DIV_WORK_POOL_MAX_TASKS) {
+    logW("DivWorkPool: batch is full!");
+    what(arg);
+    return;
   }
 
-  // all threads are busy
-  logW("DivWorkPool: all work threads busy!");
-  what(arg);
+  tasks[taskCount++]=DivPendingTask(what,arg);
 }
 
 bool DivWorkPool::busy() {
   if (!threaded) return false;
-  for (unsigned int i=0; i<count; i++) {
-    if (workThreads[i].busy()) return true;
-  }
-  return false;
+  return (taskCount>0 || pending.load(std::memory_order_acquire)>0);
 }
 
 void DivWorkPool::wait() {
   if (!threaded) return;
+  if (taskCount==0) return;
 
-  if (busyCount==0) {
-    return;
+  // keep the calling thread (usually the audio callback) off the workers' cores.
+  // its affinity is given back when the pool goes away.
+  if (pinCores && cores.size()>=2 && pinnedCaller!=std::this_thread::get_id()) {
+    if (callerPinned) {
+      restoreThreadAffinity(callerThread,callerMask);
+      callerPinned=false;
+    }
+    pinnedCaller=std::this_thread::get_id();
+    if (pinCurrentThread(cores[0],callerMask)) {
+      callerThread=getCurrentThreadID();
+      callerPinned=true;
+    }
   }
 
-  std::future<void> future=notify.get_future();
+  // distribute tasks among work threads
+  unsigned int gen=generation.load(std::memory_order_relaxed)+1;
+  pending.store(taskCount,std::memory_order_relaxed);
+  for (unsigned int i=0; i<count; i++) {
+    workThreads[i].range.store(RANGE_MAKE(gen,(taskCount*i)/count,(taskCount*(i+1))/count),std::memory_order_release);
+  }
 
   // start running
+  generation.store(gen);
+  if (parked.load()>0) {
+    std::lock_guard<std::mutex> guard(parkLock);
+    parkCond.notify_all();
+  }
+
+  // help out
   for (unsigned int i=0; i<count; i++) {
-    if (!workThreads[i].promiseAlreadySet && !workThreads[i].tasks.empty()) {
-      try {
-        workThreads[i].lock.lock();
-        workThreads[i].promiseAlreadySet=true;
-        workThreads[i].notify.set_value();
-        workThreads[i].lock.unlock();
-      } catch (std::exception& e) {
-        logE("ERROR IN THREAD SYNC! %s",e.what());
-        abort();
-      }
-    }
+    while (runOne(i,gen));
   }
-  //std::this_thread::yield();
 
   // wait
-  future.wait();
-
-  notify=std::promise<void>();
+  unsigned int spins=0;
+  while (pending.load(std::memory_order_acquire)>0) {
+    if (spins<DIV_WORK_SPIN_COUNT) {
+      spins++;
+      DIV_CPU_RELAX;
+    } else {
+      std::this_thread::yield();
+    }
+  }
 
-  pos=0;
+  taskCount=0;
 }
 
-DivWorkPool::DivWorkPool(unsigned int threads):
+DivWorkPool::DivWorkPool(unsigned int threads, DivWorkPriority prio, bool pin):
   threaded(threads>0),
   count(threads),
-  pos(0),
-  busyCount(0) {
+  workThreads(NULL),
+  taskCount(0),
+  priority(prio),
+  pinCores(pin),
+  callerPinned(false),
+  callerThread(0),
+  generation(0),
+  pending(0),
+  parked(0),
+  terminate(false) {
+  memset(callerMask,0,DIV_WORK_MASK_WORDS*sizeof(unsigned long long));
   if (threaded) {
+    if (pinCores) {
+      cores=getPerformanceCores();
+      if (cores.size()<2) {
+        logW("DivWorkPool: not enough cores to pin threads to.");
+      } else if (cores.size()<=threads) {
+        logW("DivWorkPool: more threads than cores. some threads will share a core.");
+      }
+    }
     workThreads=new DivWorkThread[threads];
     for (unsigned int i=0; i<count; i++) {
-      if (!workThreads[i].init(this)) { 
+      if (!workThreads[i].init(this,i)) {
         count=i;
         break;
       }
@@ -193,18 +409,28 @@ DivWorkPool::DivWorkPool(unsigned int threads):
       threaded=false;
       workThreads=NULL;
     }
-  } else {
-    workThreads=NULL;
   }
 }
 
 DivWorkPool::~DivWorkPool() {
   if (threaded) {
     if (workThreads!=NULL) {
+      terminate=true;
+      generation++;
+      {
+        std::lock_guard<std::mutex> guard(parkLock);
+        parkCond.notify_all();
+      }
       for (unsigned int i=0; i<count; i++) {
         workThreads[i].finish();
       }
       delete[] workThreads;
     }
   }
+  if (callerPinned) {
+    if (!restoreThreadAffinity(callerThread,callerMask)) {
+      logW("DivWorkPool: could not restore affinity of the calling thread.");
+    }
+    callerPinned=false;
+  }
 }
@@ -22,13 +22,27 @@
 
 #include <thread>
 #include <atomic>
-#include <functional>
-#include <future>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
 
-#include "../fixedQueue.h"
+// maximum number of tasks in a batch.
+// pushing more than this will execute the excess tasks in the calling thread.
+#define DIV_WORK_POOL_MAX_TASKS 1024
+// size of a saved affinity mask (64 cores per word)
+#define DIV_WORK_MASK_WORDS 16
 
 class DivWorkPool;
 
+enum DivWorkPriority {
+  // leave thread priority alone
+  DIV_WORK_PRIORITY_NORMAL=0,
+  // raise priority (nice value, THREAD_PRIORITY_HIGHEST or the user-interactive QoS class)
+  DIV_WORK_PRIORITY_HIGH,
+  // real-time scheduling (SCHED_FIFO or MMCSS "Pro Audio") where permitted. falls back to high.
+  DIV_WORK_PRIORITY_REALTIME
+};
+
 struct DivPendingTask {
   void (*func)(void*);
   void* funcArg;
@@ -42,58 +56,106 @@ struct DivPendingTask {
 
 struct DivWorkThread {
   DivWorkPool* parent;
-  std::mutex lock;
   std::thread* thread;
-  std::promise<void> notify;
-  FixedQueue<DivPendingTask,32> tasks;
-  std::atomic<bool> isBusy;
-  bool terminate;
-  bool promiseAlreadySet;
+  unsigned int index;
+  // the range of tasks owned by this thread in the current batch.
+  // packed as generation (32 bits), end (16 bits) and next task (16 bits) so
+  // that a claim made against an old batch always fails.
+  // other threads steal from this range once they run out of work.
+  std::atomic<unsigned long long> range;
 
+  // apply the priority and core affinity of the parent.
+  void setPolicy();
   void run();
-  bool assign(void (*what)(void*), void* arg);
-  void wait();
-  bool busy();
+  bool init(DivWorkPool* p, unsigned int i);
   void finish();
-
-  bool init(DivWorkPool* p);
   DivWorkThread():
     parent(NULL),
-    isBusy(false),
-    terminate(false),
-    promiseAlreadySet(false) {}
+    thread(NULL),
+    index(0),
+    range(0) {}
 };
 
 /**
  * this class provides an implementation of a "thread pool" for executing tasks in parallel.
+ * worker threads are persistent. they spin for a short while after a batch finishes,
+ * then yield, and only park after being idle for a long time.
+ * tasks are distributed among workers, and idle workers steal from the others.
  * it is highly recommended to use `new` when allocating a DivWorkPool.
  */
 class DivWorkPool {
+  friend struct DivWorkThread;
   bool threaded;
   unsigned int count;
-  unsigned int pos;
   DivWorkThread* workThreads;
+
+  DivPendingTask tasks[DIV_WORK_POOL_MAX_TASKS];
+  unsigned int taskCount;
+
+  DivWorkPriority priority;
+  bool pinCores;
+  // cores to pin threads to. the first one is for the thread calling wait().
+  std::vector<int> cores;
+  std::thread::id pinnedCaller;
+  // affinity of the thread calling wait() before it was pinned
+  bool callerPinned;
+  long long callerThread;
+  unsigned long long callerMask[DIV_WORK_MASK_WORDS];
+
+  std::atomic<unsigned int> generation;
+  std::atomic<unsigned int> pending;
+  std::atomic<unsigned int> parked;
+  std::atomic<bool> terminate;
+  std::mutex parkLock;
+  std::condition_variable parkCond;
+
+  // claim and run one task from the specified thread's range.
+  // returns false if there is nothing left to claim.
+  bool runOne(unsigned int owner, unsigned int gen);
   public:
-    std::promise<void> notify;
-    std::atomic<int> busyCount;
-    
     /**
      * push a new job to this work pool.
-     * if all work threads are busy, this will block until one is free.
+     * jobs begin running when wait() is called.
+     * if the batch is full, the job is executed immediately.
      */
     void push(void (*what)(void*), void* arg);
-    
+
+    /**
+     * push a job for each element of an array (e.g. a list of DivDispatchContainers).
+     * the whole batch costs a single wakeup.
+     */
+    template<typename T> void pushBatch(void (*what)(void*), T* args, unsigned int n) {
+      for (unsigned int i=0; i<n; i++) {
+        push(what,&args[i]);
+      }
+    }
+
+    /**
+     * check whether this work pool has work threads.
+     */
+    bool isThreaded() {
+      return threaded;
+    }
+
     /**
      * check whether this work pool is busy.
      */
     bool busy();
 
     /**
-     * wait for all work threads to finish.
+     * run all pushed jobs and wait for them to finish.
+     * the calling thread takes part in running jobs.
      */
     void wait();
 
-    DivWorkPool(unsigned int threads=0);
+    /**
+     * @param threads number of work threads.
+     * @param prio priority of the work threads.
+     * @param pin whether to pin threads to (performance) cores.
+     * the thread calling wait() is pinned to a core of its own, and gets its
+     * previous affinity back when the pool is destroyed.
+     */
+    DivWorkPool(unsigned int threads=0, DivWorkPriority prio=DIV_WORK_PRIORITY_NORMAL, bool pin=false);
     ~DivWorkPool();
 };
 
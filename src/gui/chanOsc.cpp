@@ -25,6 +25,10 @@
 #include "misc/cpp/imgui_stdlib.h"
 
 #define FURNACE_CHANOSC_FFT_SIZE 4096
+// the period of a channel is reused if its pitch didn't change in this many frames
+#define FURNACE_CHANOSC_STABLE_FRAMES 4
+// maximum number of frames in which the period is reused before running the FFT again
+#define FURNACE_CHANOSC_REUSE_FRAMES 8
 #define FURNACE_CHANOSC_FFT_RATE 80.0
 #define FURNACE_CHANOSC_FFT_CUTOFF 0.1
 
@@ -96,13 +100,13 @@ void FurnaceGUI::calcChanOsc() {
       if (--tryAgain<0) break;
       buf=e->getOscBuffer(tryAgain);
     }
-    if (buf!=NULL && e->curSubSong->chanShowChanOsc[i]) {
+    if (buf!=NULL && buf->data!=NULL && e->curSubSong->chanShowChanOsc[i]) {
       // 30ms should be enough
       int displaySize=65536.0f*0.03f;
       if (e->isRunning()) {
         short minLevel=32767;
         short maxLevel=-32768;
-        unsigned short needlePos=buf->needle>>16;
+        unsigned short needlePos=buf->getNeedle()>>16;
         for (unsigned short i=needlePos-displaySize; i!=needlePos; i++) {
           short y=buf->data[i];
           if (y==-1) continue;
@@ -436,7 +440,7 @@ void FurnaceGUI::drawChanOsc() {
         // fill buffers
         for (int i=0; i<chans; i++) {
           DivDispatchOscBuffer* buf=e->getOscBuffer(i);
-          if (buf!=NULL && e->curSubSong->chanShowChanOsc[i]) {
+          if (buf!=NULL && buf->data!=NULL && e->curSubSong->chanShowChanOsc[i]) {
             oscData.push_back({buf,&chanOscChan[i],i});
           }
         }
@@ -451,7 +455,7 @@ void FurnaceGUI::drawChanOsc() {
           if (fft_->relatedBuf!=NULL) {
             // prepare
             if (centerSettingReset) {
-              fft_->relatedBuf->readNeedle=fft_->relatedBuf->needle>>16;
+              fft_->relatedBuf->readNeedle=fft_->relatedBuf->getNeedle()>>16;
             }
 
             // check FFT status existence
@@ -474,6 +478,29 @@ void FurnaceGUI::drawChanOsc() {
             }
 
             if (fft_->ready && e->isRunning()) {
+              // skip the FFT if the pitch of the channel is unlikely to have changed.
+              // macros may change it without us knowing, so the FFT still runs every few frames.
+              DivChannelState* chanState=e->getChanState(fft_->relatedCh);
+              bool stable=(chanState!=NULL && !debugFFT &&
+                           chanState->note==fft_->lastNote &&
+                           chanState->pitch==fft_->lastPitch &&
+                           chanState->lastIns==fft_->lastIns &&
+                           chanState->vibratoDepth==0 &&
+                           chanState->arp==0 &&
+                           !chanState->inPorta &&
+                           fft_->windowSize==chanOscWindowSize);
+              if (stable) {
+                if (fft_->stableFrames<255) fft_->stableFrames++;
+              } else {
+                fft_->stableFrames=0;
+                if (chanState!=NULL) {
+                  fft_->lastNote=chanState->note;
+                  fft_->lastPitch=chanState->pitch;
+                  fft_->lastIns=chanState->lastIns;
+                }
+              }
+              fft_->reusePeriod=(fft_->periodValid && fft_->stableFrames>=FURNACE_CHANOSC_STABLE_FRAMES && fft_->framesSinceFFT<FURNACE_CHANOSC_REUSE_FRAMES);
+
               fft_->windowSize=chanOscWindowSize;
               fft_->waveCorr=chanOscWaveCorr;
               chanOscWorkPool->push([](void* fft_v) {
@@ -495,83 +522,105 @@ void FurnaceGUI::drawChanOsc() {
                 int displaySize=65536.0f*(fft->windowSize/1000.0f);
                 int displaySize2=65536.0f*(fft->windowSize/500.0f);
                 fft->loudEnough=false;
-                fft->needle=buf->needle>>16;
+                fft->needle=buf->getNeedle()>>16;
 
-                // first FFT
                 int k=0;
                 short lastSample=0;
-                memset(fft->inBuf,0,FURNACE_CHANOSC_FFT_SIZE*sizeof(double));
-                if (displaySize2<FURNACE_CHANOSC_FFT_SIZE) {
-                  for (int j=-FURNACE_CHANOSC_FFT_SIZE; j<FURNACE_CHANOSC_FFT_SIZE; j++) {
-                    const short newData=buf->data[(unsigned short)(fft->needle-displaySize2+((j*displaySize2)/(FURNACE_CHANOSC_FFT_SIZE)))];
-                    if (newData!=-1) lastSample=newData;
-                    if (j<0) continue;
-                    fft->inBuf[j]=(double)lastSample/32768.0;
-                    if (fft->inBuf[j]>0.001 || fft->inBuf[j]<-0.001) fft->loudEnough=true;
-                    fft->inBuf[j]*=0.55-0.45*cos(M_PI*(double)j/(double)(FURNACE_CHANOSC_FFT_SIZE>>1));
+                if (fft->reusePeriod) {
+                  // the pitch of this channel didn't change. only check whether it's quiet.
+                  for (unsigned short j=fft->needle-displaySize2; j!=fft->needle; j++) {
+                    if (buf->data[j]!=-1) lastSample=buf->data[j];
+                    if ((double)lastSample/32768.0>0.001 || (double)lastSample/32768.0<-0.001) {
+                      fft->loudEnough=true;
+                      break;
+                    }
                   }
                 } else {
-                  for (unsigned short j=fft->needle-displaySize2; j!=fft->needle; j++, k++) {
-                    const int kIn=(k*FURNACE_CHANOSC_FFT_SIZE)/displaySize2;
-                    if (kIn>=FURNACE_CHANOSC_FFT_SIZE) break;
-                    if (buf->data[j]!=-1) lastSample=buf->data[j];
-                    fft->inBuf[kIn]=(double)lastSample/32768.0;
-                    if (fft->inBuf[kIn]>0.001 || fft->inBuf[kIn]<-0.001) fft->loudEnough=true;
-                    fft->inBuf[kIn]*=0.55-0.45*cos(M_PI*(double)kIn/(double)(FURNACE_CHANOSC_FFT_SIZE>>1));
+                  // first FFT
+                  fft->periodValid=false;
+                  memset(fft->inBuf,0,FURNACE_CHANOSC_FFT_SIZE*sizeof(double));
+                  if (displaySize2<FURNACE_CHANOSC_FFT_SIZE) {
+                    for (int j=-FURNACE_CHANOSC_FFT_SIZE; j<FURNACE_CHANOSC_FFT_SIZE; j++) {
+                      const short newData=buf->data[(unsigned short)(fft->needle-displaySize2+((j*displaySize2)/(FURNACE_CHANOSC_FFT_SIZE)))];
+                      if (newData!=-1) lastSample=newData;
+                      if (j<0) continue;
+                      fft->inBuf[j]=(double)lastSample/32768.0;
+                      if (fft->inBuf[j]>0.001 || fft->inBuf[j]<-0.001) fft->loudEnough=true;
+                      fft->inBuf[j]*=0.55-0.45*cos(M_PI*(double)j/(double)(FURNACE_CHANOSC_FFT_SIZE>>1));
+                    }
+                  } else {
+                    for (unsigned short j=fft->needle-displaySize2; j!=fft->needle; j++, k++) {
+                      const int kIn=(k*FURNACE_CHANOSC_FFT_SIZE)/displaySize2;
+                      if (kIn>=FURNACE_CHANOSC_FFT_SIZE) break;
+                      if (buf->data[j]!=-1) lastSample=buf->data[j];
+                      fft->inBuf[kIn]=(double)lastSample/32768.0;
+                      if (fft->inBuf[kIn]>0.001 || fft->inBuf[kIn]<-0.001) fft->loudEnough=true;
+                      fft->inBuf[kIn]*=0.55-0.45*cos(M_PI*(double)kIn/(double)(FURNACE_CHANOSC_FFT_SIZE>>1));
+                    }
                   }
                 }
 
                 // only proceed if not quiet
                 if (fft->loudEnough) {
-                  fftw_execute(fft->plan);
-
-                  // auto-correlation and second FFT
-                  for (int j=0; j<FURNACE_CHANOSC_FFT_SIZE; j++) {
-                    fft->outBuf[j][0]/=FURNACE_CHANOSC_FFT_SIZE;
-                    fft->outBuf[j][1]/=FURNACE_CHANOSC_FFT_SIZE;
-                    fft->outBuf[j][0]=fft->outBuf[j][0]*fft->outBuf[j][0]+fft->outBuf[j][1]*fft->outBuf[j][1];
-                    fft->outBuf[j][1]=0;
-                  }
-                  fft->outBuf[0][0]=0;
-                  fft->outBuf[0][1]=0;
-                  fft->outBuf[1][0]=0;
-                  fft->outBuf[1][1]=0;
-                  fftw_execute(fft->planI);
-
-                  // window
-                  for (int j=0; j<(FURNACE_CHANOSC_FFT_SIZE>>1); j++) {
-                    fft->corrBuf[j]*=1.0-((double)j/(double)(FURNACE_CHANOSC_FFT_SIZE<<1));
-                  }
+                  if (fft->reusePeriod) {
+                    fft->waveLen=fft->periodLen;
+                    fft->framesSinceFFT++;
+                  } else {
+                    fftw_execute(fft->plan);
+
+                    // auto-correlation and second FFT
+                    for (int j=0; j<FURNACE_CHANOSC_FFT_SIZE; j++) {
+                      fft->outBuf[j][0]/=FURNACE_CHANOSC_FFT_SIZE;
+                      fft->outBuf[j][1]/=FURNACE_CHANOSC_FFT_SIZE;
+                      fft->outBuf[j][0]=fft->outBuf[j][0]*fft->outBuf[j][0]+fft->outBuf[j][1]*fft->outBuf[j][1];
+                      fft->outBuf[j][1]=0;
+                    }
+                    fft->outBuf[0][0]=0;
+                    fft->outBuf[0][1]=0;
+                    fft->outBuf[1][0]=0;
+                    fft->outBuf[1][1]=0;
+                    fftw_execute(fft->planI);
+
+                    // window
+                    for (int j=0; j<(FURNACE_CHANOSC_FFT_SIZE>>1); j++) {
+                      fft->corrBuf[j]*=1.0-((double)j/(double)(FURNACE_CHANOSC_FFT_SIZE<<1));
+                    }
 
-                  // find size of period
-                  double waveLenCandL=DBL_MAX;
-                  double waveLenCandH=DBL_MIN;
-                  fft->waveLen=FURNACE_CHANOSC_FFT_SIZE-1;
-                  fft->waveLenBottom=0;
-                  fft->waveLenTop=0;
-
-                  // find lowest point
-                  for (int j=(FURNACE_CHANOSC_FFT_SIZE>>2); j>2; j--) {
-                    if (fft->corrBuf[j]<waveLenCandL) {
-                      waveLenCandL=fft->corrBuf[j];
-                      fft->waveLenBottom=j;
+                    // find size of period
+                    double waveLenCandL=DBL_MAX;
+                    double waveLenCandH=DBL_MIN;
+                    fft->waveLen=FURNACE_CHANOSC_FFT_SIZE-1;
+                    fft->waveLenBottom=0;
+                    fft->waveLenTop=0;
+
+                    // find lowest point
+                    for (int j=(FURNACE_CHANOSC_FFT_SIZE>>2); j>2; j--) {
+                      if (fft->corrBuf[j]<waveLenCandL) {
+                        waveLenCandL=fft->corrBuf[j];
+                        fft->waveLenBottom=j;
+                      }
                     }
-                  }
-                  
-                  // find highest point
-                  for (int j=(FURNACE_CHANOSC_FFT_SIZE>>1)-1; j>fft->waveLenBottom; j--) {
-                    if (fft->corrBuf[j]>waveLenCandH) {
-                      waveLenCandH=fft->corrBuf[j];
-                      fft->waveLen=j;
+                    
+                    // find highest point
+                    for (int j=(FURNACE_CHANOSC_FFT_SIZE>>1)-1; j>fft->waveLenBottom; j--) {
+                      if (fft->corrBuf[j]>waveLenCandH) {
+                        waveLenCandH=fft->corrBuf[j];
+                        fft->waveLen=j;
+                      }
                     }
+                    fft->waveLenTop=fft->waveLen;
+
+                    // did we find the period size?
+                    if (fft->waveLen<(FURNACE_CHANOSC_FFT_SIZE-32)) {
+                      // we got pitch
+                      fft->pitch=pow(1.0-(fft->waveLen/(double)(FURNACE_CHANOSC_FFT_SIZE>>1)),4.0);
+                      fft->periodLen=fft->waveLen;
+                      fft->periodValid=true;
+                    }
+                    fft->framesSinceFFT=0;
                   }
-                  fft->waveLenTop=fft->waveLen;
 
-                  // did we find the period size?
-                  if (fft->waveLen<(FURNACE_CHANOSC_FFT_SIZE-32)) {
-                    // we got pitch
-                    fft->pitch=pow(1.0-(fft->waveLen/(double)(FURNACE_CHANOSC_FFT_SIZE>>1)),4.0);
-                    
+                  if (fft->periodValid) {
                     fft->waveLen*=(double)displaySize*2.0/(double)FURNACE_CHANOSC_FFT_SIZE;
 
                     // DFT of one period (x_1)
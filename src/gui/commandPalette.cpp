@@ -50,6 +50,24 @@ static bool charMatch(const char* a, const char* b) {
   return std::tolower(*a)==std::tolower(*b);
 }
 
+// a fuzzy match requires every character of the needle to be in the haystack.
+// this maps characters to 64 classes, so that candidates can be rejected
+// without scoring them.
+static uint64_t charMask(const char* s, size_t len) {
+  uint64_t ret=0;
+  for (size_t i=0; i<len; i++) {
+    unsigned char c=tolower((unsigned char)s[i]);
+    if (c>='a' && c<='z') {
+      ret|=1ULL<<(c-'a');
+    } else if (c>='0' && c<='9') {
+      ret|=1ULL<<(26+c-'0');
+    } else {
+      ret|=1ULL<<(36+(c%28));
+    }
+  }
+  return ret;
+}
+
 // #define MATCH_GREEDY
 // #define RUN_MATCH_TEST
 
@@ -175,56 +193,49 @@ void FurnaceGUI::drawPalette() {
   matchFuzzyTest();
 #endif
 
-  if (ImGui::InputTextWithHint("##CommandPaletteSearch",hint,&paletteQuery) || paletteFirstFrame) {
-    paletteSearchResults.clear();
-    std::vector<MatchScore> matchScores;
-
-    auto Evaluate=[&](int i, const char* name, int nameLen) {
-      MatchResult result;
-      if (matchFuzzy(name, nameLen, paletteQuery.c_str(), paletteQuery.length(), &result)) {
-        paletteSearchResults.emplace_back();
-        paletteSearchResults.back().id=i;
-        paletteSearchResults.back().highlightChars=std::move(result.highlightChars);
-        matchScores.push_back(result.score);
-      }
+  if (paletteFirstFrame) {
+    paletteCandidates.clear();
+    auto addCandidate=[this](int id, const String& name) {
+      paletteCandidates.push_back(PaletteCandidate());
+      PaletteCandidate& c=paletteCandidates.back();
+      c.id=id;
+      c.name=name;
+      c.mask=charMask(name.c_str(),name.length());
     };
 
     switch (curPaletteType) {
     case CMDPAL_TYPE_MAIN:
       for (int i=0; i<GUI_ACTION_MAX; i++) {
         if (guiActions[i].isNotABind()) continue;
-        Evaluate(i,guiActions[i].friendlyName,strlen(guiActions[i].friendlyName));
+        addCandidate(i,guiActions[i].friendlyName);
       }
       break;
 
     case CMDPAL_TYPE_RECENT:
       for (int i=0; i<(int)recentFile.size(); i++) {
-        Evaluate(i,recentFile[i].c_str(),recentFile[i].length());
+        addCandidate(i,recentFile[i]);
       }
       break;
 
     case CMDPAL_TYPE_INSTRUMENTS:
     case CMDPAL_TYPE_INSTRUMENT_CHANGE: {
-      const char* noneStr=_("- None -");
-      Evaluate(0,noneStr,strlen(noneStr));
+      addCandidate(0,_("- None -"));
       for (int i=0; i<e->song.insLen; i++) {
-        String s=fmt::sprintf("%02X: %s", i, e->song.ins[i]->name.c_str());
-        Evaluate(i+1,s.c_str(),s.length()); // because over here ins=0 is 'None'
+        addCandidate(i+1,fmt::sprintf("%02X: %s", i, e->song.ins[i]->name.c_str())); // because over here ins=0 is 'None'
       }
       break;
     }
 
     case CMDPAL_TYPE_SAMPLES:
       for (int i=0; i<e->song.sampleLen; i++) {
-        Evaluate(i,e->song.sample[i]->name.c_str(),e->song.sample[i]->name.length());
+        addCandidate(i,e->song.sample[i]->name);
       }
       break;
 
     case CMDPAL_TYPE_ADD_CHIP:
       for (int i=0; availableSystems[i]; i++) {
         int ds=availableSystems[i];
-        const char* sysname=getSystemName((DivSystem)ds);
-        Evaluate(ds,sysname,strlen(sysname));
+        addCandidate(ds,getSystemName((DivSystem)ds));
       }
       break;
 
@@ -233,6 +244,44 @@ void FurnaceGUI::drawPalette() {
       ImGui::CloseCurrentPopup();
       break;
     };
+  }
+
+  if (ImGui::InputTextWithHint("##CommandPaletteSearch",hint,&paletteQuery) || paletteFirstFrame) {
+    paletteSearchResults.clear();
+    std::vector<MatchScore> matchScores;
+    std::vector<int> matched;
+
+    // if the query was extended, only the previous matches can match
+    bool narrow=(!paletteFirstFrame && paletteQuery.length()>paletteLastQuery.length() && paletteQuery.compare(0,paletteLastQuery.length(),paletteLastQuery)==0);
+    uint64_t needleMask=charMask(paletteQuery.c_str(),paletteQuery.length());
+
+    auto Evaluate=[&](int c) {
+      const PaletteCandidate& cand=paletteCandidates[c];
+      if ((cand.mask&needleMask)!=needleMask) return;
+      MatchResult result;
+      if (matchFuzzy(cand.name.c_str(), cand.name.length(), paletteQuery.c_str(), paletteQuery.length(), &result)) {
+        paletteSearchResults.emplace_back();
+        paletteSearchResults.back().id=cand.id;
+        paletteSearchResults.back().cand=c;
+        paletteSearchResults.back().highlightChars=std::move(result.highlightChars);
+        matchScores.push_back(result.score);
+        matched.push_back(c);
+      }
+    };
+
+    if (narrow) {
+      for (int c: paletteMatched) {
+        Evaluate(c);
+      }
+    } else {
+      for (int c=0; c<(int)paletteCandidates.size(); c++) {
+        Evaluate(c);
+      }
+    }
+    // keep candidate order, so that equal scores sort the same way regardless of narrowing
+    std::sort(matched.begin(),matched.end());
+    paletteMatched=matched;
+    paletteLastQuery=paletteQuery;
 
     // sort indices by match quality
     std::vector<int> sortingIndices(paletteSearchResults.size());
@@ -275,34 +324,7 @@ void FurnaceGUI::drawPalette() {
       // ImGui::TableSetupColumn("##shortcut");
       for (int i=0; i<(int)paletteSearchResults.size(); i++) {
         bool current=(i==curPaletteChoice);
-        int id=paletteSearchResults[i].id;
-
-        String s="???";
-        switch (curPaletteType) {
-        case CMDPAL_TYPE_MAIN:
-          s=guiActions[id].friendlyName;
-          break;
-        case CMDPAL_TYPE_RECENT:
-          s=recentFile[id].c_str();
-          break;
-        case CMDPAL_TYPE_INSTRUMENTS:
-        case CMDPAL_TYPE_INSTRUMENT_CHANGE:
-          if (id==0) {
-            s=_("- None -");
-          } else {
-            s=fmt::sprintf("%02X: %s", id-1, e->song.ins[id-1]->name.c_str());
-          }
-          break;
-        case CMDPAL_TYPE_SAMPLES:
-          s=e->song.sample[id]->name.c_str();
-          break;
-        case CMDPAL_TYPE_ADD_CHIP:
-          s=getSystemName((DivSystem)id);
-          break;
-        default:
-          logE(_("invalid command palette type"));
-          break;
-        };
+        const String& s=paletteCandidates[paletteSearchResults[i].cand].name;
 
         ImGui::TableNextRow();
         ImGui::TableNextColumn();
@@ -196,6 +196,8 @@ void FurnaceGUI::drawCSPlayer() {
     ImGui::SetNextWindowFocus();
     nextWindow=GUI_WINDOW_NOTHING;
   }
+  // only trace while the player is visible
+  if (e->getStreamPlayer()) e->getStreamPlayer()->setTracing(csPlayerOpen);
   if (!csPlayerOpen) return;
   if (ImGui::Begin("Command Stream Player",&csPlayerOpen,globalWinFlags,_("Command Stream Player"))) {
     if (ImGui::Button(_("Load"))) {
@@ -20,6 +20,7 @@
 #include "gui.h"
 #include "guiConst.h"
 #include "debug.h"
+#include "../engine/trace.h"
 #include "IconsFontAwesome4.h"
 #include <inttypes.h>
 #include <fmt/printf.h>
@@ -39,6 +40,10 @@ static int oscDebugRepeat=1;
 static int numApples=1;
 static int getGainChan=0;
 static int getGainVol=0;
+#ifdef DIV_TRACE
+static int traceSeconds=10;
+static String traceResult;
+#endif
 
 static void _drawOsc(const ImDrawList* drawList, const ImDrawCmd* cmd) {
   if (cmd!=NULL) {
@@ -207,6 +212,10 @@ void FurnaceGUI::drawDebug() {
         e->calcSongTimestamps();
       }
 
+      if (e->isCalculatingTimestamps()) {
+        ImGui::Text("calculating...");
+      }
+
       DivSongTimestamps& ts=e->curSubSong->ts;
 
       String timeFormatted=ts.totalTime.toString(-1,TA_TIME_FORMAT_AUTO);
@@ -301,7 +310,7 @@ void FurnaceGUI::drawDebug() {
 
               for (int j=0; j<e->getChannelCount(system); j++, c++) {
                 DivDispatchOscBuffer* oscBuf=e->getOscBuffer(c);
-                if (oscBuf==NULL) {
+                if (oscBuf==NULL || oscBuf->data==NULL) {
                   ImGui::TableNextRow();
                   // channel
                   ImGui::TableNextColumn();
@@ -899,6 +908,146 @@ void FurnaceGUI::drawDebug() {
       for (int i=0; i<perfMetricsLastLen; i++) {
         ImGui::Text("%s: %.0fµs",perfMetricsLast[i].name,(double)perfMetricsLast[i].elapsed/perfFreq);
       }
+
+      if (ImGui::TreeNode("Audio Profile")) {
+        float profPlot[DIV_PROFILE_HISTORY];
+        unsigned int profPos=e->profHistoryPos;
+        char profOverlay[64];
+        ImVec2 plotSize=ImVec2(ImGui::GetContentRegionAvail().x,40.0f*dpiScale);
+        if (ImGui::Button("Reset")) e->resetProfile();
+
+        // engine stages
+        for (int i=0; i<DIV_PROFILE_MAX; i++) {
+          double avg=0.0;
+          float peak=0.0f;
+          for (int j=0; j<DIV_PROFILE_HISTORY; j++) {
+            profPlot[j]=(float)e->profHistory[i][j]/1000.0f;
+            avg+=profPlot[j];
+            if (profPlot[j]>peak) peak=profPlot[j];
+          }
+          avg/=DIV_PROFILE_HISTORY;
+          snprintf(profOverlay,63,"%s: avg %.0fµs, peak %.0fµs",e->getProfileStageName(i),avg,peak);
+          ImGui::PushID(i);
+          ImGui::PlotHistogram("##ProfStage",profPlot,DIV_PROFILE_HISTORY,profPos,profOverlay,0.0f,MAX(1.0f,peak),plotSize);
+          ImGui::PopID();
+        }
+
+        // dispatches
+        if (ImGui::BeginTable("ProfChips",4+DIV_DISPATCH_PROFILE_MAX,ImGuiTableFlags_Borders|ImGuiTableFlags_SizingFixedFit)) {
+          ImGui::TableNextRow(ImGuiTableRowFlags_Headers);
+          ImGui::TableNextColumn();
+          ImGui::Text("chip");
+          for (int j=0; j<DIV_DISPATCH_PROFILE_MAX; j++) {
+            ImGui::TableNextColumn();
+            ImGui::Text("%s",e->getDispatchProfileStageName(j));
+          }
+          ImGui::TableNextColumn();
+          ImGui::Text("writes/s");
+          ImGui::TableNextColumn();
+          ImGui::Text("deltas/s");
+          ImGui::TableNextColumn();
+          ImGui::Text("history");
+          for (int i=0; i<e->song.systemLen; i++) {
+            float peak=0.0f;
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%d. %s",i+1,e->getSystemName(e->song.system[i]));
+            for (int k=0; k<DIV_PROFILE_HISTORY; k++) {
+              profPlot[k]=0.0f;
+            }
+            for (int j=0; j<DIV_DISPATCH_PROFILE_MAX; j++) {
+              double avg=0.0;
+              for (int k=0; k<DIV_PROFILE_HISTORY; k++) {
+                float val=(float)e->profChipHistory[i][j][k]/1000.0f;
+                avg+=val;
+                profPlot[k]+=val;
+              }
+              avg/=DIV_PROFILE_HISTORY;
+              ImGui::TableNextColumn();
+              ImGui::Text("%.0fµs",avg);
+            }
+            ImGui::TableNextColumn();
+            if (e->profSamples>0) {
+              ImGui::Text("%.0f",(double)e->profChipWrites[i]*e->getAudioDescGot().rate/(double)e->profSamples);
+            } else {
+              ImGui::TextUnformatted("-");
+            }
+            ImGui::TableNextColumn();
+            if (e->profSamples>0) {
+              ImGui::Text("%.0f",(double)e->profChipDeltas[i]*e->getAudioDescGot().rate/(double)e->profSamples);
+            } else {
+              ImGui::TextUnformatted("-");
+            }
+            for (int k=0; k<DIV_PROFILE_HISTORY; k++) {
+              if (profPlot[k]>peak) peak=profPlot[k];
+            }
+            ImGui::TableNextColumn();
+            ImGui::PushID(i);
+            ImGui::PlotHistogram("##ProfChip",profPlot,DIV_PROFILE_HISTORY,profPos,NULL,0.0f,MAX(1.0f,peak),ImVec2(200.0f*dpiScale,ImGui::GetFrameHeight()));
+            ImGui::PopID();
+          }
+          ImGui::EndTable();
+        }
+        ImGui::TreePop();
+      }
+      if (ImGui::TreeNode("Counters")) {
+        DivCounters cur;
+        divCountersRead(cur);
+        updateCounterRates();
+        if (ImGui::Button("Reset")) debugCountersBase=cur;
+        if (ImGui::BeginTable("CounterList",3,ImGuiTableFlags_Borders|ImGuiTableFlags_SizingFixedFit)) {
+          ImGui::TableNextRow(ImGuiTableRowFlags_Headers);
+          ImGui::TableNextColumn();
+          ImGui::Text("counter");
+          ImGui::TableNextColumn();
+          ImGui::Text("total");
+          ImGui::TableNextColumn();
+          ImGui::Text("per second");
+          for (int i=0; i<DIV_COUNTER_MAX; i++) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%s",divCounterName(i));
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu",cur.count[i]-debugCountersBase.count[i]);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.0f",counterRates[i]);
+          }
+          ImGui::EndTable();
+        }
+        if (ImGui::TreeNode("Commands")) {
+          if (ImGui::BeginTable("CounterCmds",2,ImGuiTableFlags_Borders|ImGuiTableFlags_SizingFixedFit)) {
+            for (int i=0; i<DIV_CMD_MAX; i++) {
+              unsigned long long count=cur.cmds[i]-debugCountersBase.cmds[i];
+              if (count==0) continue;
+              ImGui::TableNextRow();
+              ImGui::TableNextColumn();
+              ImGui::Text("%s",cmdName[i]);
+              ImGui::TableNextColumn();
+              ImGui::Text("%llu",count);
+            }
+            ImGui::EndTable();
+          }
+          ImGui::TreePop();
+        }
+        ImGui::TreePop();
+      }
+#ifdef DIV_TRACE
+      if (ImGui::TreeNode("Trace")) {
+        String tracePath=e->getConfigPath()+DIR_SEPARATOR_STR+"trace.json";
+        ImGui::InputInt("Seconds",&traceSeconds);
+        if (traceSeconds<1) traceSeconds=1;
+        if (traceSeconds>60) traceSeconds=60;
+        if (ImGui::Button("Dump")) {
+          if (divTraceDump(tracePath.c_str(),traceSeconds)) {
+            traceResult="wrote "+tracePath;
+          } else {
+            traceResult="could not write "+tracePath;
+          }
+        }
+        ImGui::Text("%s",traceResult.c_str());
+        ImGui::TreePop();
+      }
+#endif
       ImGui::TreePop();
     }
     if (ImGui::TreeNode("Settings")) {
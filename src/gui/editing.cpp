@@ -101,10 +101,14 @@ void FurnaceGUI::prepareUndo(ActionType action, UndoRegion region) {
     case GUI_UNDO_PATTERN_FLIP:
     case GUI_UNDO_PATTERN_COLLAPSE:
     case GUI_UNDO_PATTERN_EXPAND:
-    case GUI_UNDO_PATTERN_DRAG:
+    case GUI_UNDO_PATTERN_DRAG: {
+      // patterns are saved once per channel, even if they appear in several orders
+      std::vector<bool> saved(DIV_MAX_CHANS*DIV_MAX_PATTERNS,false);
       for (int h=region.begin.ord; h<=region.end.ord; h++) {
         for (int i=region.begin.x; i<=region.end.x; i++) {
-          unsigned short id=h|(i<<8);
+          unsigned short id=e->curOrders->ord[i][h]|(i<<8);
+          if (saved[id]) continue;
+          saved[id]=true;
           DivPattern* p=NULL;
 
           auto it=oldPatMap.find(id);
@@ -119,6 +123,7 @@ void FurnaceGUI::prepareUndo(ActionType action, UndoRegion region) {
         }
       }
       break;
+    }
     case GUI_UNDO_PATTERN_COLLAPSE_SONG:
     case GUI_UNDO_PATTERN_EXPAND_SONG: // this is handled by doCollapseSong/doExpandSong
       break;
@@ -200,20 +205,13 @@ void FurnaceGUI::makeUndo(ActionType action, UndoRegion region) {
     case GUI_UNDO_PATTERN_FLIP:
     case GUI_UNDO_PATTERN_COLLAPSE:
     case GUI_UNDO_PATTERN_EXPAND:
-    case GUI_UNDO_PATTERN_DRAG:
+    case GUI_UNDO_PATTERN_DRAG: {
+      // get the rows to compare in each pattern.
+      // a pattern which appears in several orders is only compared once, over all of its ranges.
+      std::map<unsigned short,std::pair<int,int>> patRanges;
       for (int h=region.begin.ord; h<=region.end.ord; h++) {
         for (int i=region.begin.x; i<=region.end.x; i++) {
-          DivPattern* p=e->curPat[i].getPattern(e->curOrders->ord[i][h],false);
-          DivPattern* op=NULL;
-          unsigned short id=h|(i<<8);
-
-          auto it=oldPatMap.find(id);
-          if (it==oldPatMap.end()) {
-            logW(_("no data in oldPatMap for channel %d!"),i);
-            continue;
-          } else {
-            op=it->second;
-          }
+          unsigned short id=e->curOrders->ord[i][h]|(i<<8);
 
           int jBegin=0;
           int jEnd=e->curSubSong->patLen-1;
@@ -221,39 +219,66 @@ void FurnaceGUI::makeUndo(ActionType action, UndoRegion region) {
           if (h==region.begin.ord) jBegin=region.begin.y;
           if (h==region.end.ord) jEnd=region.end.y;
 
-          for (int j=jBegin; j<=jEnd; j++) {
-            for (int k=0; k<DIV_MAX_COLS; k++) {
-              if (p->newData[j][k]!=op->newData[j][k]) {
-                s.pat.push_back(UndoPatternData(subSong,i,e->curOrders->ord[i][h],j,k,op->newData[j][k],p->newData[j][k]));
-
-                if (k>=DIV_PAT_FX(0)) {
-                  int fxCol=(k&1)?k:(k-1);
-                  if (op->newData[j][fxCol]==0x09 ||
-                      op->newData[j][fxCol]==0x0b ||
-                      op->newData[j][fxCol]==0x0d ||
-                      op->newData[j][fxCol]==0x0f ||
-                      op->newData[j][fxCol]==0xc0 ||
-                      op->newData[j][fxCol]==0xc1 ||
-                      op->newData[j][fxCol]==0xc2 ||
-                      op->newData[j][fxCol]==0xc3 ||
-                      op->newData[j][fxCol]==0xf0 ||
-                      op->newData[j][fxCol]==0xff ||
-                      p->newData[j][fxCol]==0x09 ||
-                      p->newData[j][fxCol]==0x0b ||
-                      p->newData[j][fxCol]==0x0d ||
-                      p->newData[j][fxCol]==0x0f ||
-                      p->newData[j][fxCol]==0xc0 ||
-                      p->newData[j][fxCol]==0xc1 ||
-                      p->newData[j][fxCol]==0xc2 ||
-                      p->newData[j][fxCol]==0xc3 ||
-                      p->newData[j][fxCol]==0xf0 ||
-                      p->newData[j][fxCol]==0xff) {
-                    logV("recalcTimestamps due to speed effect.");
-                    recalcTimestamps=true;
-                  }
-                }
+          auto r=patRanges.find(id);
+          if (r==patRanges.end()) {
+            patRanges[id]=std::pair<int,int>(jBegin,jEnd);
+          } else {
+            if (r->second.first>jBegin) r->second.first=jBegin;
+            if (r->second.second<jEnd) r->second.second=jEnd;
+          }
+        }
+      }
+
+      for (std::pair<const unsigned short,std::pair<int,int>>& r: patRanges) {
+        const int i=r.first>>8;
+        const int pat=r.first&0xff;
+        DivPattern* p=e->curPat[i].getPattern(pat,false);
+        DivPattern* op=NULL;
+
+        auto it=oldPatMap.find(r.first);
+        if (it==oldPatMap.end()) {
+          logW(_("no data in oldPatMap for channel %d!"),i);
+          continue;
+        } else {
+          op=it->second;
+        }
 
+        const int jBegin=r.second.first;
+        const int jEnd=r.second.second;
+
+        for (int j=jBegin; j<=jEnd; j++) {
+          for (int k=0; k<DIV_MAX_COLS; k++) {
+            if (p->newData[j][k]!=op->newData[j][k]) {
+              s.pat.push_back(UndoPatternData(subSong,i,pat,j,k,op->newData[j][k],p->newData[j][k]));
+
+              if (k>=DIV_PAT_FX(0)) {
+                int fxCol=(k&1)?k:(k-1);
+                if (op->newData[j][fxCol]==0x09 ||
+                    op->newData[j][fxCol]==0x0b ||
+                    op->newData[j][fxCol]==0x0d ||
+                    op->newData[j][fxCol]==0x0f ||
+                    op->newData[j][fxCol]==0xc0 ||
+                    op->newData[j][fxCol]==0xc1 ||
+                    op->newData[j][fxCol]==0xc2 ||
+                    op->newData[j][fxCol]==0xc3 ||
+                    op->newData[j][fxCol]==0xf0 ||
+                    op->newData[j][fxCol]==0xff ||
+                    p->newData[j][fxCol]==0x09 ||
+                    p->newData[j][fxCol]==0x0b ||
+                    p->newData[j][fxCol]==0x0d ||
+                    p->newData[j][fxCol]==0x0f ||
+                    p->newData[j][fxCol]==0xc0 ||
+                    p->newData[j][fxCol]==0xc1 ||
+                    p->newData[j][fxCol]==0xc2 ||
+                    p->newData[j][fxCol]==0xc3 ||
+                    p->newData[j][fxCol]==0xf0 ||
+                    p->newData[j][fxCol]==0xff) {
+                  logV("recalcTimestamps due to speed effect.");
+                  e->invalidatePatternTimestamps(i,pat);
+                  recalcTimestampsPartial=true;
+                }
               }
+
             }
           }
         }
@@ -262,6 +287,7 @@ void FurnaceGUI::makeUndo(ActionType action, UndoRegion region) {
         doPush=true;
       }
       break;
+    }
     case GUI_UNDO_PATTERN_COLLAPSE_SONG:
     case GUI_UNDO_PATTERN_EXPAND_SONG: // this is handled by doCollapseSong/doExpandSong
       break;
@@ -269,10 +295,12 @@ void FurnaceGUI::makeUndo(ActionType action, UndoRegion region) {
       break;
   }
   if (doPush) {
-    MARK_MODIFIED;
+    modified=true;
+    backupPending=true;
+    invalidateUndoSnapshots(s);
     undoHist.push_back(s);
     redoHist.clear();
-    if (undoHist.size()>settings.maxUndoSteps) undoHist.pop_front();
+    trimUndoHistory();
   }
 
   // garbage collection
@@ -551,6 +579,123 @@ void FurnaceGUI::doTranspose(int amount, OperationMask& mask) {
   makeUndo(GUI_UNDO_PATTERN_DELETE);
 }
 
+static const char* hexDigits="0123456789ABCDEF";
+
+static inline int decodeHexDigit(char c) {
+  if (c>='0' && c<='9') return c-'0';
+  if (c>='A' && c<='F') return c-'A'+10;
+  if (c>='a' && c<='f') return c-'a'+10;
+  return -1;
+}
+
+// same as FurnaceGUI::decodeNote, but with a lookup table
+static short decodeNoteFast(const char* what) {
+  static std::unordered_map<unsigned int,short> table;
+  static std::once_flag tableInit;
+  std::call_once(tableInit,[]() {
+    for (int i=0; i<180; i++) {
+      // first match wins, like decodeNote
+      table.emplace(((unsigned char)noteNames[i][0]<<16)|((unsigned char)noteNames[i][1]<<8)|(unsigned char)noteNames[i][2],i);
+    }
+    table[('.'<<16)|('.'<<8)|'.']=-1;
+    table[('?'<<16)|('?'<<8)|'?']=DIV_NOTE_NULL_PAT;
+    table[('O'<<16)|('F'<<8)|'F']=DIV_NOTE_OFF;
+    table[('='<<16)|('='<<8)|'=']=DIV_NOTE_REL;
+    table[('R'<<16)|('E'<<8)|'L']=DIV_MACRO_REL;
+  });
+  auto i=table.find(((unsigned char)what[0]<<16)|((unsigned char)what[1]<<8)|(unsigned char)what[2]);
+  if (i==table.end()) return PAT_CLIP_BAD;
+  return i->second;
+}
+
+void PatternClipboard::clear() {
+  startOff=0;
+  cells.clear();
+  rows.clear();
+}
+
+bool PatternClipboard::parse(const String& text) {
+  static const char* header="org.tildearrow.furnace - Pattern Data";
+  clear();
+  if (text.compare(0,strlen(header),header)!=0) return false;
+
+  const char* p=text.c_str();
+  const char* end=p+text.size();
+
+  // start offset
+  p=(const char*)memchr(p,'\n',end-p);
+  if (p==NULL) return false;
+  p++;
+  while (p<end && (*p==' ' || *p=='\t')) p++;
+  bool negative=false;
+  if (p<end && *p=='-') {
+    negative=true;
+    p++;
+  }
+  if (p>=end || *p<'0' || *p>'9') return false;
+  while (p<end && *p>='0' && *p<='9') {
+    startOff=startOff*10+(*p-'0');
+    if (startOff>DIV_MAX_COLS) return false;
+    p++;
+  }
+  if (negative) return false;
+  p=(const char*)memchr(p,'\n',end-p);
+
+  // rows
+  cells.reserve(text.size()/2);
+  while (p!=NULL) {
+    p++;
+    const char* lineEnd=(const char*)memchr(p,'\n',end-p);
+    const char* next=lineEnd;
+    if (lineEnd==NULL) lineEnd=end;
+    rows.push_back(cells.size());
+    bool noteNext=(startOff==0);
+    while (p<lineEnd) {
+      if (*p=='\r') {
+        p++;
+        continue;
+      }
+      if (*p=='|') {
+        cells.push_back(PAT_CLIP_SEP);
+        noteNext=true;
+        p++;
+        continue;
+      }
+      if (noteNext) {
+        if (lineEnd-p<3) {
+          cells.push_back(PAT_CLIP_END);
+          break;
+        }
+        cells.push_back(decodeNoteFast(p));
+        p+=3;
+        noteNext=false;
+      } else {
+        if (lineEnd-p<2) {
+          cells.push_back(PAT_CLIP_END);
+          break;
+        }
+        if (p[0]=='.' && p[1]=='.') {
+          cells.push_back(-1);
+        } else {
+          int hi=decodeHexDigit(p[0]);
+          int lo=decodeHexDigit(p[1]);
+          if (hi<0) {
+            cells.push_back(PAT_CLIP_BAD);
+          } else if (lo<0) {
+            cells.push_back(hi);
+          } else {
+            cells.push_back((hi<<4)|lo);
+          }
+        }
+        p+=2;
+      }
+    }
+    p=next;
+  }
+  rows.push_back(cells.size());
+  return true;
+}
+
 String FurnaceGUI::doCopy(bool cut, bool writeClipboard, const SelectionPoint& sStart, const SelectionPoint& sEnd) {
   if (writeClipboard) {
     finishSelection();
@@ -558,6 +703,8 @@ String FurnaceGUI::doCopy(bool cut, bool writeClipboard, const SelectionPoint& s
       curNibble=false;
       prepareUndo(GUI_UNDO_PATTERN_CUT);
     }
+    clipboardPat.clear();
+    clipboardPat.startOff=sStart.xFine;
   }
   String clipb=fmt::sprintf("org.tildearrow.furnace - Pattern Data (%d)\n%d",DIV_ENGINE_VERSION,sStart.xFine);
   int jOrder=sStart.order;
@@ -571,27 +718,31 @@ String FurnaceGUI::doCopy(bool cut, bool writeClipboard, const SelectionPoint& s
         iFine--;
       }*/
       clipb+='\n';
+      if (writeClipboard) clipboardPat.rows.push_back(clipboardPat.cells.size());
       for (; iCoarse<=sEnd.xCoarse; iCoarse++) {
         if (!e->curSubSong->chanShow[iCoarse]) continue;
         DivPattern* pat=e->curPat[iCoarse].getPattern(e->curOrders->ord[iCoarse][jOrder],true);
         for (; iFine<3+e->curPat[iCoarse].effectCols*2 && (iCoarse<sEnd.xCoarse || iFine<=sEnd.xFine); iFine++) {
+          short val=pat->newData[j][iFine];
+          if (writeClipboard) clipboardPat.cells.push_back(val);
           if (iFine==0) {
-            clipb+=noteNameNormal(pat->newData[j][DIV_PAT_NOTE]);
-            if (cut) {
-              pat->newData[j][DIV_PAT_NOTE]=-1;
-            }
+            clipb+=noteNameNormal(val);
           } else {
-            if (pat->newData[j][iFine]==-1) {
+            if (val==-1) {
               clipb+="..";
+            } else if (val>=0 && val<256) {
+              clipb+=hexDigits[val>>4];
+              clipb+=hexDigits[val&15];
             } else {
-              clipb+=fmt::sprintf("%.2X",pat->newData[j][iFine]);
-            }
-            if (cut) {
-              pat->newData[j][iFine]=-1;
+              clipb+=fmt::sprintf("%.2X",val);
             }
           }
+          if (cut) {
+            pat->newData[j][iFine]=-1;
+          }
         }
         clipb+='|';
+        if (writeClipboard) clipboardPat.cells.push_back(PAT_CLIP_SEP);
         iFine=0;
       }
     }
@@ -599,94 +750,75 @@ String FurnaceGUI::doCopy(bool cut, bool writeClipboard, const SelectionPoint& s
   }
 
   if (writeClipboard) {
+    clipboardPat.rows.push_back(clipboardPat.cells.size());
     SDL_SetClipboardText(clipb.c_str());
     if (cut) {
       makeUndo(GUI_UNDO_PATTERN_CUT);
     }
     clipboard=clipb;
+    clipboardPatText=clipb;
   }
   return clipb;
 }
 
-void FurnaceGUI::doPasteFurnace(PasteMode mode, int arg, bool readClipboard, String clipb, std::vector<String> data, int startOff, bool invalidData, UndoRegion ur)
-{
-  if (sscanf(data[1].c_str(),"%d",&startOff)!=1) return;
+void FurnaceGUI::doPasteFurnace(PasteMode mode, int arg, bool readClipboard, const PatternClipboard& clip, UndoRegion ur) {
+  int startOff=clip.startOff;
   if (startOff<0) return;
+  if (clip.rows.empty()) return;
 
   DETERMINE_LAST;
 
+  bool mix=(mode==GUI_PASTE_MODE_MIX_BG || mode==GUI_PASTE_MODE_MIX_FG || mode==GUI_PASTE_MODE_INS_BG || mode==GUI_PASTE_MODE_INS_FG);
+  bool background=(mode==GUI_PASTE_MODE_MIX_BG || mode==GUI_PASTE_MODE_INS_BG);
+  bool setIns=(mode==GUI_PASTE_MODE_INS_BG || mode==GUI_PASTE_MODE_INS_FG);
+  bool invalidData=false;
+  int rowCount=(int)clip.rows.size()-1;
+
   int j=cursor.y;
   int jOrder=cursor.order;
-  char note[4];
-  for (size_t i=2; i<data.size() && j<e->curSubSong->patLen; i++) {
-    size_t charPos=0;
+  for (int i=0; i<rowCount && j<e->curSubSong->patLen; i++) {
+    const short* cell=clip.cells.data()+clip.rows[i];
+    const short* cellEnd=clip.cells.data()+clip.rows[i+1];
     int iCoarse=cursor.xCoarse;
     int iFine=(startOff>2 && cursor.xFine>2)?(cursor.xFine /*((cursor.xFine-1)&(~1))|1*/):startOff;
 
-    String& line=data[i];
-
-    while (charPos<line.size() && iCoarse<lastChannel) {
+    while (cell<cellEnd && iCoarse<lastChannel) {
       DivPattern* pat=e->curPat[iCoarse].getPattern(e->curOrders->ord[iCoarse][jOrder],true);
-      if (line[charPos]=='|') {
+      short val=*(cell++);
+      if (val==PAT_CLIP_SEP) {
         iCoarse++;
         if (iCoarse<lastChannel) while (!e->curSubSong->chanShow[iCoarse]) {
           iCoarse++;
           if (iCoarse>=lastChannel) break;
         }
         iFine=0;
-        charPos++;
         continue;
       }
+      if (val==PAT_CLIP_END) {
+        invalidData=true;
+        break;
+      }
       if (iFine==0) {
-        if (charPos>=line.size()) {
-          invalidData=true;
-          break;
-        }
-        note[0]=line[charPos++];
-        if (charPos>=line.size()) {
-          invalidData=true;
-          break;
-        }
-        note[1]=line[charPos++];
-        if (charPos>=line.size()) {
-          invalidData=true;
-          break;
-        }
-        note[2]=line[charPos++];
-        note[3]=0;
-
-        if (iFine==0 && !opMaskPaste.note) {
+        if (!opMaskPaste.note) {
           iFine++;
           continue;
         }
 
-        if ((mode==GUI_PASTE_MODE_MIX_BG || mode==GUI_PASTE_MODE_MIX_FG ||
-             mode==GUI_PASTE_MODE_INS_BG || mode==GUI_PASTE_MODE_INS_FG) && strcmp(note,"...")==0) {
+        if (mix && val==-1) {
           // do nothing.
         } else {
-          if (!(mode==GUI_PASTE_MODE_MIX_BG || mode==GUI_PASTE_MODE_INS_BG) || (pat->newData[j][DIV_PAT_NOTE]==-1)) {
-            if (!decodeNote(note,pat->newData[j][DIV_PAT_NOTE])) {
+          if (!background || (pat->newData[j][DIV_PAT_NOTE]==-1)) {
+            if (val==PAT_CLIP_BAD) {
               invalidData=true;
               break;
             }
-            if (mode==GUI_PASTE_MODE_INS_BG || mode==GUI_PASTE_MODE_INS_FG) pat->newData[j][DIV_PAT_INS]=arg;
+            pat->newData[j][DIV_PAT_NOTE]=val;
+            if (setIns) pat->newData[j][DIV_PAT_INS]=arg;
           }
         }
       } else {
-        if (charPos>=line.size()) {
-          invalidData=true;
-          break;
-        }
-        note[0]=line[charPos++];
-        if (charPos>=line.size()) {
-          invalidData=true;
-          break;
-        }
-        note[1]=line[charPos++];
-        note[2]=0;
-
         if (iFine==DIV_PAT_INS) {
-          if (!opMaskPaste.ins || mode==GUI_PASTE_MODE_INS_BG || mode==GUI_PASTE_MODE_INS_FG) {
+          if (!opMaskPaste.ins || setIns) {
             iFine++;
             continue;
           }
@@ -707,28 +839,25 @@ void FurnaceGUI::doPasteFurnace(PasteMode mode, int arg, bool readClipboard, Str
           }
         }
 
-        if (strcmp(note,"..")==0) {
-          if (!(mode==GUI_PASTE_MODE_MIX_BG || mode==GUI_PASTE_MODE_MIX_FG ||
-                mode==GUI_PASTE_MODE_INS_BG || mode==GUI_PASTE_MODE_INS_FG)) {
+        if (val==-1) {
+          if (!mix) {
             pat->newData[j][iFine]=-1;
           }
         } else {
-          unsigned int val=0;
-          if (sscanf(note,"%2X",&val)!=1) {
+          if (val==PAT_CLIP_BAD) {
             invalidData=true;
             break;
           }
-          if (!(mode==GUI_PASTE_MODE_MIX_BG || mode==GUI_PASTE_MODE_INS_BG) || pat->newData[j][iFine]==-1) {
+          if (!background || pat->newData[j][iFine]==-1) {
             if (iFine<(3+e->curPat[iCoarse].effectCols*2)) pat->newData[j][iFine]=val;
           }
         }
       }
       iFine++;
     }
-    
+
     if (invalidData) {
-      logW(_("invalid clipboard data! failed at line %d char %d"),i,charPos);
-      logW("%s",line.c_str());
+      logW(_("invalid clipboard data! failed at line %d"),i+2);
       break;
     }
     j++;
@@ -737,8 +866,8 @@ void FurnaceGUI::doPasteFurnace(PasteMode mode, int arg, bool readClipboard, Str
       jOrder++;
     }
 
-    if (mode==GUI_PASTE_MODE_FLOOD && i==data.size()-1) {
-      i=1;
+    if (mode==GUI_PASTE_MODE_FLOOD && i==rowCount-1) {
+      i=-1;
     }
   }
 
@@ -1249,49 +1378,48 @@ void FurnaceGUI::doPaste(PasteMode mode, int arg, bool readClipboard, String cli
     }
     clipb=clipboard;
   }
+  PatternClipboard parsed;
+  const PatternClipboard* clip=NULL;
   std::vector<String> data;
-  String tempS;
-  bool foundString=false;
-  bool isFurnace=false;
-  bool isModPlug=false;
-  int mptFormat=0;
-  for (char i: clipb) {
-    if (i=='\r') continue;
-    if (i=='\n') {
-      data.push_back(tempS);
-      tempS="";
-      continue;
-    }
-    tempS+=i;
-  }
-  data.push_back(tempS);
-
-  int startOff=-1;
-  bool invalidData=false;
-  if (data.size()<2) return;
+  int mptFormat=-1;
 
-  if (data[0].find("org.tildearrow.furnace - Pattern Data")==0) {
-    foundString=true;
-    isFurnace=true;
+  if (readClipboard && !clipboardPatText.empty() && clipb==clipboardPatText) {
+    // we copied this. skip decoding
+    clip=&clipboardPat;
+  } else if (parsed.parse(clipb)) {
+    clip=&parsed;
   } else {
+    String tempS;
+    for (char i: clipb) {
+      if (i=='\r') continue;
+      if (i=='\n') {
+        data.push_back(tempS);
+        tempS="";
+        continue;
+      }
+      tempS+=i;
+    }
+    data.push_back(tempS);
+    if (data.size()<2) return;
+
     for (int i=0; modPlugFormatHeaders[i]; i++) {
       if (data[0].find(modPlugFormatHeaders[i])==0) {
-        foundString=true;
-        isModPlug=true;
         mptFormat=i;
         break;
       }
     }
+    if (mptFormat<0) return;
   }
 
-  if (!foundString) return;
+  // header lines included
+  int lineCount=(clip!=NULL)?((int)clip->rows.size()+1):(int)data.size();
 
   UndoRegion ur;
   if (mode==GUI_PASTE_MODE_OVERFLOW) {
     int rows=cursor.y;
     int firstPattern=cursor.order;
     int lastPattern=cursor.order;
-    rows+=data.size();
+    rows+=lineCount;
     while (rows>=e->curSubSong->patLen) {
       lastPattern++;
       rows-=e->curSubSong->patLen;
@@ -1304,9 +1432,9 @@ void FurnaceGUI::doPaste(PasteMode mode, int arg, bool readClipboard, String cli
     prepareUndo(GUI_UNDO_PATTERN_PASTE,ur);
   }
 
-  if (isFurnace) {
-    doPasteFurnace(mode,arg,readClipboard,clipb,data,startOff,invalidData,ur);
-  } else if (isModPlug) {
+  if (clip!=NULL) {
+    doPasteFurnace(mode,arg,readClipboard,*clip,ur);
+  } else {
     doPasteMPT(mode,arg,readClipboard,clipb,data,mptFormat,ur);
   }
 }
@@ -1812,7 +1940,7 @@ void FurnaceGUI::doCollapseSong(int divider) {
   if (!us.pat.empty()) {
     undoHist.push_back(us);
     redoHist.clear();
-    if (undoHist.size()>settings.maxUndoSteps) undoHist.pop_front();
+    trimUndoHistory();
   }
   recalcTimestamps=true;
   
@@ -1889,7 +2017,7 @@ void FurnaceGUI::doExpandSong(int multiplier) {
   if (!us.pat.empty()) {
     undoHist.push_back(us);
     redoHist.clear();
-    if (undoHist.size()>settings.maxUndoSteps) undoHist.pop_front();
+    trimUndoHistory();
   }
   recalcTimestamps=true;
 
@@ -2090,17 +2218,53 @@ void FurnaceGUI::moveSelected(int x, int y) {
   makeUndo(GUI_UNDO_PATTERN_DRAG,UndoRegion(firstOrder,0,0,lastOrder,e->getTotalChannelCount()-1,e->curSubSong->patLen-1));
 }
 
+void FurnaceGUI::trimUndoHistory() {
+  while (undoHist.size()>settings.maxUndoSteps) undoHist.pop_front();
+  if (settings.maxUndoMemory<=0) return;
+
+  size_t limit=(size_t)settings.maxUndoMemory<<20;
+  size_t total=0;
+  for (size_t i=0; i<undoHist.size(); i++) {
+    total+=undoHist[i].memUsage();
+  }
+  // always keep the latest step
+  while (total>limit && undoHist.size()>1) {
+    total-=undoHist.front().memUsage();
+    undoHist.pop_front();
+  }
+}
+
+void FurnaceGUI::invalidateUndoSnapshots(UndoStep& us) {
+  // song and sub-song changes may affect everything
+  if (!us.other.empty()) {
+    e->invalidateSnapshots();
+    return;
+  }
+  int subSong=e->getCurrentSubSong();
+  if (us.oldOrdersLen!=us.newOrdersLen) {
+    e->invalidateSnapshots(MIN(us.oldOrdersLen,us.newOrdersLen));
+  }
+  for (UndoOrderData& i: us.ord) {
+    if (i.subSong==subSong) e->invalidateSnapshots(i.ord);
+  }
+  for (UndoPatternData i: us.pat) {
+    if (i.subSong==subSong) e->invalidatePatternSnapshots(i.chan,i.pat);
+  }
+}
+
 void FurnaceGUI::doUndo() {
   if (undoHist.empty()) return;
   UndoStep& us=undoHist.back();
   redoHist.push_back(us);
-  MARK_MODIFIED;
+  modified=true;
+  backupPending=true;
 
   switch (us.type) {
     case GUI_UNDO_CHANGE_ORDER:
       e->curSubSong->ordersLen=us.oldOrdersLen;
       for (UndoOrderData& i: us.ord) {
         e->changeSongP(i.subSong);
+        e->invalidateSubSongTimestamps(i.subSong);
         e->curOrders->ord[i.chan][i.ord]=i.oldVal;
       }
       break;
@@ -2123,8 +2287,9 @@ void FurnaceGUI::doUndo() {
     case GUI_UNDO_PATTERN_EXPAND_SONG:
     case GUI_UNDO_PATTERN_DRAG:
     case GUI_UNDO_REPLACE:
-      for (UndoPatternData& i: us.pat) {
+      for (UndoPatternData i: us.pat) {
         e->changeSongP(i.subSong);
+        e->invalidateSubSongTimestamps(i.subSong);
         DivPattern* p=e->curPat[i.chan].getPattern(i.pat,true);
         p->newData[i.row][i.col]=i.oldVal;
       }
@@ -2143,6 +2308,7 @@ void FurnaceGUI::doUndo() {
       break;
   }
 
+  invalidateUndoSnapshots(us);
   recalcTimestamps=true;
 
   bool shallReplay=false;
@@ -2173,13 +2339,15 @@ void FurnaceGUI::doRedo() {
   if (redoHist.empty()) return;
   UndoStep& us=redoHist.back();
   undoHist.push_back(us);
-  MARK_MODIFIED;
+  modified=true;
+  backupPending=true;
 
   switch (us.type) {
     case GUI_UNDO_CHANGE_ORDER:
       e->curSubSong->ordersLen=us.newOrdersLen;
       for (UndoOrderData& i: us.ord) {
         e->changeSongP(i.subSong);
+        e->invalidateSubSongTimestamps(i.subSong);
         e->curOrders->ord[i.chan][i.ord]=i.newVal;
       }
       break;
@@ -2202,8 +2370,9 @@ void FurnaceGUI::doRedo() {
     case GUI_UNDO_PATTERN_COLLAPSE_SONG:
     case GUI_UNDO_PATTERN_EXPAND_SONG:
     case GUI_UNDO_REPLACE:
-      for (UndoPatternData& i: us.pat) {
+      for (UndoPatternData i: us.pat) {
         e->changeSongP(i.subSong);
+        e->invalidateSubSongTimestamps(i.subSong);
         DivPattern* p=e->curPat[i.chan].getPattern(i.pat,true);
         p->newData[i.row][i.col]=i.newVal;
       }
@@ -2222,6 +2391,7 @@ void FurnaceGUI::doRedo() {
       break;
   }
 
+  invalidateUndoSnapshots(us);
   recalcTimestamps=true;
 
   bool shallReplay=false;
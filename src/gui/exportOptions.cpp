@@ -159,6 +159,14 @@ void FurnaceGUI::drawExportAudio(bool onWindow) {
 
   bool isOneOn=false;
   if (audioExportOptions.mode==DIV_EXPORT_MODE_MANY_CHAN) {
+    if (ImGui::InputInt(_("Render threads"),&audioExportOptions.threads,1,1)) {
+      if (audioExportOptions.threads<0) audioExportOptions.threads=0;
+      if (audioExportOptions.threads>64) audioExportOptions.threads=64;
+    }
+    if (ImGui::IsItemHovered()) {
+      ImGui::SetTooltip(_("number of channels to render at once.\n0 means one per CPU core."));
+    }
+
     ImGui::Text(_("Channels to export:"));
     ImGui::SameLine();
     if (ImGui::SmallButton(_("All"))) {
@@ -310,6 +318,31 @@ void FurnaceGUI::drawExportVGM(bool onWindow) {
       "at the cost of a massive increase in file size."
     ));
   }
+  ImGui::Checkbox(_("skip redundant writes"),&vgmExportDedupeWrites);
+  if (ImGui::IsItemHovered()) {
+    ImGui::SetTooltip(_(
+      "don't write registers which already hold the same value.\n"
+      "reduces file size and bus usage on hardware players.\n\n"
+      "only affects YM2151, OPN chips and AY-3-8910."
+    ));
+  }
+  ImGui::Checkbox(_("pack sample data"),&vgmExportPackSamples);
+  if (ImGui::IsItemHovered()) {
+    ImGui::SetTooltip(_(
+      "write identical samples only once, and bit-pack sample data\n"
+      "for NES and PC Engine streams (VGM 1.51 and later).\n\n"
+      "some players may not support packed data blocks."
+    ));
+  }
+  if (e->song.subsong.size()>1) {
+    ImGui::Checkbox(_("export all subsongs"),&vgmExportAllSubSongs);
+    if (ImGui::IsItemHovered()) {
+      ImGui::SetTooltip(_(
+        "writes one file per subsong.\n"
+        "the subsong number is appended to the file name."
+      ));
+    }
+  }
   ImGui::Text(_("chips to export:"));
   bool hasOneAtLeast=false;
   bool hasNES=false;
@@ -481,6 +514,24 @@ void FurnaceGUI::drawExportROM(bool onWindow) {
       }
       break;
     }
+    case DIV_ROM_SGU: {
+      int sguExportRate=romConfig.getInt("rate",60);
+      bool sguExportLoop=romConfig.getBool("loop",true);
+
+      if (ImGui::InputInt(_("Frame Rate (Hz)"),&sguExportRate,1,2)) {
+        if (sguExportRate<1) sguExportRate=1;
+        if (sguExportRate>1000) sguExportRate=1000;
+        altered=true;
+      }
+      if (ImGui::Checkbox(_("loop"),&sguExportLoop)) {
+        altered=true;
+      }
+      if (altered) {
+        romConfig.set("rate",sguExportRate);
+        romConfig.set("loop",sguExportLoop);
+      }
+      break;
+    }
     case DIV_ROM_GRUB: {
       bool grubExportBin=romConfig.getBool("exportBin",false);
       if (ImGui::Checkbox(_("export binary file"),&grubExportBin)) {
@@ -0,0 +1,238 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2026 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// file previews for the file picker.
+// makeFilePreview() runs on the file picker's preview thread, so it must not
+// touch the engine or the GUI state.
+
+#include "gui.h"
+#include "guiConst.h"
+#include "../fileutils.h"
+#include "../ta-log.h"
+#ifdef HAVE_SNDFILE
+#include "../engine/sfWrapper.h"
+#endif
+#include <fmt/printf.h>
+#include <imgui.h>
+
+// number of min/max pairs in a waveform preview
+#define FILE_PREVIEW_COLUMNS 128
+
+// don't preview instruments bigger than this
+#define FILE_PREVIEW_MAX_INS_SIZE (16*1024*1024)
+
+enum FurnaceGUIFilePreviewKinds {
+  GUI_FILE_PREVIEW_SAMPLE=0,
+  GUI_FILE_PREVIEW_INS,
+  GUI_FILE_PREVIEW_INS_FM
+};
+
+static bool makeInsPreview(const String& path, FilePickerPreview& p) {
+  FILE* f=ps_fopen(path.c_str(),"rb");
+  if (f==NULL) return false;
+  if (fseek(f,0,SEEK_END)!=0) {
+    fclose(f);
+    return false;
+  }
+  ssize_t len=ftell(f);
+  if (len<=0 || len>FILE_PREVIEW_MAX_INS_SIZE) {
+    fclose(f);
+    return false;
+  }
+  if (fseek(f,0,SEEK_SET)!=0) {
+    fclose(f);
+    return false;
+  }
+  unsigned char* buf=new unsigned char[len];
+  if (fread(buf,1,len,f)!=(size_t)len) {
+    fclose(f);
+    delete[] buf;
+    return false;
+  }
+  fclose(f);
+
+  SafeReader reader=SafeReader(buf,len);
+  DivInstrument ins;
+  bool success=false;
+  try {
+    unsigned char magic[16];
+    bool isOldFurnaceIns=false;
+    reader.read(magic,4);
+    if (memcmp("FINS",magic,4)!=0 && memcmp("FINB",magic,4)!=0) {
+      reader.read(&magic[4],12);
+      if (memcmp("-Furnace instr.-",magic,16)!=0) {
+        delete[] buf;
+        return false;
+      }
+      isOldFurnaceIns=true;
+    }
+
+    short version=reader.readS();
+    if (isOldFurnaceIns) {
+      reader.readS(); // reserved
+      unsigned int dataPtr=reader.readI();
+      reader.seek(dataPtr,SEEK_SET);
+    } else {
+      reader.seek(0,SEEK_SET);
+    }
+
+    // don't load assets (samples and wavetables)
+    success=(ins.readInsData(reader,version,NULL)==DIV_DATA_SUCCESS);
+  } catch (EndOfFileException& e) {
+    success=false;
+  }
+  delete[] buf;
+  if (!success) return false;
+
+  const char* typeName=(ins.type>=DIV_INS_MAX)?_("Unknown"):_(insTypes[ins.type][0]);
+  p.info=fmt::sprintf("%s\n%s",ins.name,typeName);
+  p.kind=GUI_FILE_PREVIEW_INS;
+
+  switch (ins.type) {
+    case DIV_INS_FM:
+    case DIV_INS_OPM:
+    case DIV_INS_OPZ:
+      p.kind=GUI_FILE_PREVIEW_INS_FM;
+      p.param=ins.fm.alg&7;
+      p.param2=FM_ALGS_4OP;
+      break;
+    case DIV_INS_OPL:
+    case DIV_INS_OPL_DRUMS: {
+      bool fourOp=(ins.fm.ops==4 || ins.type==DIV_INS_OPL_DRUMS);
+      p.kind=GUI_FILE_PREVIEW_INS_FM;
+      p.param=ins.fm.alg&(fourOp?3:1);
+      p.param2=fourOp?FM_ALGS_4OP_OPL:FM_ALGS_2OP_OPL;
+      break;
+    }
+    case DIV_INS_OPLL:
+      p.kind=GUI_FILE_PREVIEW_INS_FM;
+      p.param=0;
+      p.param2=FM_ALGS_2OP_OPL;
+      break;
+    default:
+      break;
+  }
+  return true;
+}
+
+#ifdef HAVE_SNDFILE
+static bool makeSamplePreview(const String& path, FilePickerPreview& p) {
+  SF_INFO si;
+  SFWrapper sfWrap;
+  memset(&si,0,sizeof(SF_INFO));
+  SNDFILE* f=sfWrap.doOpen(path.c_str(),SFM_READ,&si);
+  if (f==NULL) return false;
+  if (si.frames<=0 || si.channels<1 || si.frames>16777215) {
+    sfWrap.doClose();
+    return false;
+  }
+
+  // read in chunks and keep the minimum/maximum of each column
+  p.wave.resize(FILE_PREVIEW_COLUMNS*2);
+  for (int i=0; i<FILE_PREVIEW_COLUMNS; i++) {
+    p.wave[i<<1]=1.0f;
+    p.wave[(i<<1)+1]=-1.0f;
+  }
+  float buf[4096];
+  sf_count_t chunkFrames=4096/si.channels;
+  sf_count_t pos=0;
+  while (pos<si.frames) {
+    sf_count_t got=sf_readf_float(f,buf,chunkFrames);
+    if (got<=0) break;
+    for (sf_count_t i=0; i<got; i++) {
+      float val=0.0f;
+      for (int j=0; j<si.channels; j++) {
+        val+=buf[i*si.channels+j];
+      }
+      val/=si.channels;
+      int col=((pos+i)*FILE_PREVIEW_COLUMNS)/si.frames;
+      if (p.wave[col<<1]>val) p.wave[col<<1]=val;
+      if (p.wave[(col<<1)+1]<val) p.wave[(col<<1)+1]=val;
+    }
+    pos+=got;
+  }
+  sfWrap.doClose();
+
+  // columns which weren't reached
+  for (int i=0; i<FILE_PREVIEW_COLUMNS; i++) {
+    if (p.wave[i<<1]>p.wave[(i<<1)+1]) {
+      p.wave[i<<1]=0.0f;
+      p.wave[(i<<1)+1]=0.0f;
+    }
+  }
+
+  p.info=fmt::sprintf(_("%d Hz, %d channels, %.2fs"),si.samplerate,si.channels,(si.samplerate>0)?((double)si.frames/si.samplerate):0.0);
+  p.kind=GUI_FILE_PREVIEW_SAMPLE;
+  return true;
+}
+#endif
+
+bool FurnaceGUI::makeFilePreview(const String& path, FilePickerPreview& p) {
+  String ext;
+  size_t extPos=path.rfind('.');
+  if (extPos!=String::npos) {
+    ext=path.substr(extPos);
+    for (char& i: ext) {
+      if (i>='A' && i<='Z') i+='a'-'A';
+    }
+  }
+
+  if (ext==".fui") {
+    return makeInsPreview(path,p);
+  }
+#ifdef HAVE_SNDFILE
+  return makeSamplePreview(path,p);
+#else
+  return false;
+#endif
+}
+
+void FurnaceGUI::drawFilePreview(const FilePickerPreview& p) {
+  ImGui::TextUnformatted(p.info.c_str());
+  switch (p.kind) {
+    case GUI_FILE_PREVIEW_INS_FM:
+      drawAlgorithm(p.param,(FurnaceGUIFMAlgs)p.param2,ImVec2(160.0f*dpiScale,48.0f*dpiScale));
+      break;
+    case GUI_FILE_PREVIEW_SAMPLE: {
+      if (p.wave.size()<2) break;
+      ImDrawList* dl=ImGui::GetWindowDrawList();
+      ImVec2 size=ImVec2(256.0f*dpiScale,64.0f*dpiScale);
+      ImVec2 pos=ImGui::GetCursorScreenPos();
+      ImGui::Dummy(size);
+
+      const float center=pos.y+size.y*0.5f;
+      const float halfHeight=size.y*0.5f;
+      const size_t cols=p.wave.size()>>1;
+      const float colWidth=size.x/cols;
+      ImU32 lineColor=ImGui::GetColorU32(uiColors[GUI_COLOR_SAMPLE_FG]);
+
+      dl->AddRectFilled(pos,ImVec2(pos.x+size.x,pos.y+size.y),ImGui::GetColorU32(uiColors[GUI_COLOR_SAMPLE_BG]));
+      dl->AddLine(ImVec2(pos.x,center),ImVec2(pos.x+size.x,center),ImGui::GetColorU32(uiColors[GUI_COLOR_SAMPLE_CENTER]));
+      for (size_t i=0; i<cols; i++) {
+        float x=pos.x+(i+0.5f)*colWidth;
+        float y1=center-p.wave[(i<<1)+1]*halfHeight;
+        float y2=center-p.wave[i<<1]*halfHeight;
+        dl->AddLine(ImVec2(x,y1),ImVec2(x,y2+1.0f),lineColor,colWidth);
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
@@ -24,6 +24,7 @@
 #include "guiConst.h"
 #include "intConst.h"
 #include "../ta-log.h"
+#include <algorithm>
 
 const char* queryModes[GUI_QUERY_MAX]={
   _N("ignore"),
@@ -71,6 +72,133 @@ bool checkCondition(int mode, int arg, int argMax, int val, bool noteMode=false)
   return false;
 }
 
+// the search is split by channel, so that it can run on the work pool.
+// each pattern is only scanned once, no matter how many orders it is used in.
+struct FurnaceGUIFindTask {
+  const std::vector<FurnaceGUIFindQuery>* query;
+  DivChannelData* chanData;
+  const unsigned char* orders;
+  int subSong, chan, effectCols, effectPosMode;
+  int firstOrder, lastOrder, firstRow, lastRow;
+  std::vector<FurnaceGUIQueryResult> results;
+};
+
+static bool matchQueryRow(const FurnaceGUIFindTask* t, DivPattern* p, int row, signed char* effectPos) {
+  bool matched=false;
+  memset(effectPos,-1,8);
+  for (const FurnaceGUIFindQuery& l: *t->query) {
+    if (matched) break;
+
+    if (!checkCondition(l.noteMode,l.note,l.noteMax,p->newData[row][DIV_PAT_NOTE],true)) continue;
+    if (!checkCondition(l.insMode,l.ins,l.insMax,p->newData[row][DIV_PAT_INS])) continue;
+    if (!checkCondition(l.volMode,l.vol,l.volMax,p->newData[row][DIV_PAT_VOL])) continue;
+
+    if (l.effectCount>0) {
+      bool notMatched=false;
+      switch (t->effectPosMode) {
+        case 0: // no
+          for (int m=0; m<l.effectCount; m++) {
+            bool allGood=false;
+            for (int n=0; n<t->effectCols; n++) {
+              if (!checkCondition(l.effectMode[m],l.effect[m],l.effectMax[m],p->newData[row][DIV_PAT_FX(n)])) continue;
+              if (!checkCondition(l.effectValMode[m],l.effectVal[m],l.effectValMax[m],p->newData[row][DIV_PAT_FXVAL(n)])) continue;
+              allGood=true;
+              effectPos[m]=n;
+              break;
+            }
+            if (!allGood) {
+              notMatched=true;
+              break;
+            }
+          }
+          break;
+        case 1: { // lax
+          // locate first effect
+          int posOfFirst=-1;
+          for (int m=0; m<t->effectCols; m++) {
+            if (!checkCondition(l.effectMode[0],l.effect[0],l.effectMax[0],p->newData[row][DIV_PAT_FX(m)])) continue;
+            if (!checkCondition(l.effectValMode[0],l.effectVal[0],l.effectValMax[0],p->newData[row][DIV_PAT_FXVAL(m)])) continue;
+            posOfFirst=m;
+            break;
+          }
+          if (posOfFirst<0) {
+            notMatched=true;
+            break;
+          }
+          // make sure we aren't too far to the right
+          if ((posOfFirst+l.effectCount)>t->effectCols) {
+            notMatched=true;
+            break;
+          }
+          // search from first effect location
+          for (int m=0; m<l.effectCount; m++) {
+            if (!checkCondition(l.effectMode[m],l.effect[m],l.effectMax[m],p->newData[row][DIV_PAT_FX(m+posOfFirst)])) {
+              notMatched=true;
+              break;
+            }
+            if (!checkCondition(l.effectValMode[m],l.effectVal[m],l.effectValMax[m],p->newData[row][DIV_PAT_FXVAL(m+posOfFirst)])) {
+              notMatched=true;
+              break;
+            }
+            effectPos[m]=m+posOfFirst;
+          }
+          break;
+        }
+        case 2: // strict
+          int effectMax=l.effectCount;
+          if (effectMax>t->effectCols) {
+            notMatched=true;
+          } else {
+            for (int m=0; m<effectMax; m++) {
+              if (!checkCondition(l.effectMode[m],l.effect[m],l.effectMax[m],p->newData[row][DIV_PAT_FX(m)])) {
+                notMatched=true;
+                break;
+              }
+              if (!checkCondition(l.effectValMode[m],l.effectVal[m],l.effectValMax[m],p->newData[row][DIV_PAT_FXVAL(m)])) {
+                notMatched=true;
+                break;
+              }
+              effectPos[m]=m;
+            }
+          }
+          break;
+      }
+      if (notMatched) continue;
+    }
+
+    matched=true;
+  }
+  return matched;
+}
+
+static void runFindTask(void* t_v) {
+  FurnaceGUIFindTask* t=(FurnaceGUIFindTask*)t_v;
+  // matching rows of each pattern (-1 if the pattern wasn't scanned yet)
+  std::vector<std::vector<FurnaceGUIQueryResult>> patMatches;
+  short patIndex[DIV_MAX_PATTERNS];
+  signed char effectPos[8];
+  memset(patIndex,-1,DIV_MAX_PATTERNS*sizeof(short));
+
+  t->results.clear();
+  for (int i=t->firstOrder; i<=t->lastOrder; i++) {
+    int pat=t->orders[i];
+    if (patIndex[pat]<0) {
+      patIndex[pat]=patMatches.size();
+      patMatches.push_back(std::vector<FurnaceGUIQueryResult>());
+      DivPattern* p=t->chanData->getPattern(pat,false);
+      for (int j=t->firstRow; j<=t->lastRow; j++) {
+        if (matchQueryRow(t,p,j,effectPos)) {
+          patMatches.back().push_back(FurnaceGUIQueryResult(t->subSong,0,t->chan,j,effectPos));
+        }
+      }
+    }
+    for (const FurnaceGUIQueryResult& r: patMatches[patIndex[pat]]) {
+      t->results.push_back(r);
+      t->results.back().order=i;
+    }
+  }
+}
+
 void FurnaceGUI::doFind() {
   int firstOrder=0;
   int lastOrder=e->curSubSong->ordersLen-1;
@@ -106,103 +234,46 @@ void FurnaceGUI::doFind() {
   }
 
   curQueryResults.clear();
+  if (firstChan>lastChan || firstOrder>lastOrder) {
+    queryViewingResults=true;
+    return;
+  }
 
-  signed char effectPos[8];
-
-  for (int i=firstOrder; i<=lastOrder; i++) {
-    for (int j=firstRow; j<=lastRow; j++) {
-      for (int k=firstChan; k<=lastChan; k++) {
-        DivPattern* p=e->curPat[k].getPattern(e->curOrders->ord[k][i],false);
-        bool matched=false;
-        memset(effectPos,-1,8);
-        for (FurnaceGUIFindQuery& l: curQuery) {
-          if (matched) break;
-
-          if (!checkCondition(l.noteMode,l.note,l.noteMax,p->newData[j][DIV_PAT_NOTE],true)) continue;
-          if (!checkCondition(l.insMode,l.ins,l.insMax,p->newData[j][DIV_PAT_INS])) continue;
-          if (!checkCondition(l.volMode,l.vol,l.volMax,p->newData[j][DIV_PAT_VOL])) continue;
-
-          if (l.effectCount>0) {
-            bool notMatched=false;
-            switch (curQueryEffectPos) {
-              case 0: // no
-                for (int m=0; m<l.effectCount; m++) {
-                  bool allGood=false;
-                  for (int n=0; n<e->curPat[k].effectCols; n++) {
-                    if (!checkCondition(l.effectMode[m],l.effect[m],l.effectMax[m],p->newData[j][DIV_PAT_FX(n)])) continue;
-                    if (!checkCondition(l.effectValMode[m],l.effectVal[m],l.effectValMax[m],p->newData[j][DIV_PAT_FXVAL(n)])) continue;
-                    allGood=true;
-                    effectPos[m]=n;
-                    break;
-                  }
-                  if (!allGood) {
-                    notMatched=true;
-                    break;
-                  }
-                }
-                break;
-              case 1: { // lax
-                // locate first effect
-                int posOfFirst=-1;
-                for (int m=0; m<e->curPat[k].effectCols; m++) {
-                  if (!checkCondition(l.effectMode[0],l.effect[0],l.effectMax[0],p->newData[j][DIV_PAT_FX(m)])) continue;
-                  if (!checkCondition(l.effectValMode[0],l.effectVal[0],l.effectValMax[0],p->newData[j][DIV_PAT_FXVAL(m)])) continue;
-                  posOfFirst=m;
-                  break;
-                }
-                if (posOfFirst<0) {
-                  notMatched=true;
-                  break;
-                }
-                // make sure we aren't too far to the right
-                if ((posOfFirst+l.effectCount)>e->curPat[k].effectCols) {
-                  notMatched=true;
-                  break;
-                }
-                // search from first effect location
-                for (int m=0; m<l.effectCount; m++) {
-                  if (!checkCondition(l.effectMode[m],l.effect[m],l.effectMax[m],p->newData[j][DIV_PAT_FX(m+posOfFirst)])) {
-                    notMatched=true;
-                    break;
-                  }
-                  if (!checkCondition(l.effectValMode[m],l.effectVal[m],l.effectValMax[m],p->newData[j][DIV_PAT_FXVAL(m+posOfFirst)])) {
-                    notMatched=true;
-                    break;
-                  }
-                  effectPos[m]=m+posOfFirst;
-                }
-                break;
-              }
-              case 2: // strict
-                int effectMax=l.effectCount;
-                if (effectMax>e->curPat[k].effectCols) {
-                  notMatched=true;
-                } else {
-                  for (int m=0; m<effectMax; m++) {
-                    if (!checkCondition(l.effectMode[m],l.effect[m],l.effectMax[m],p->newData[j][DIV_PAT_FX(m)])) {
-                      notMatched=true;
-                      break;
-                    }
-                    if (!checkCondition(l.effectValMode[m],l.effectVal[m],l.effectValMax[m],p->newData[j][DIV_PAT_FXVAL(m)])) {
-                      notMatched=true;
-                      break;
-                    }
-                    effectPos[m]=m;
-                  }
-                }
-                break;
-            }
-            if (notMatched) continue;
-          }
+  if (findWorkPool==NULL) {
+    logV("creating find work pool");
+    findWorkPool=new DivWorkPool(MIN(cpuCores-1,8));
+  }
 
-          matched=true;
-        }
-        if (matched) {
-          curQueryResults.push_back(FurnaceGUIQueryResult(e->getCurrentSubSong(),i,k,j,effectPos));
-        }
-      }
-    }
+  std::vector<FurnaceGUIFindTask> tasks(lastChan-firstChan+1);
+  for (int k=firstChan; k<=lastChan; k++) {
+    FurnaceGUIFindTask& t=tasks[k-firstChan];
+    t.query=&curQuery;
+    t.chanData=&e->curPat[k];
+    t.orders=e->curOrders->ord[k];
+    t.subSong=e->getCurrentSubSong();
+    t.chan=k;
+    t.effectCols=e->curPat[k].effectCols;
+    t.effectPosMode=curQueryEffectPos;
+    t.firstOrder=firstOrder;
+    t.lastOrder=lastOrder;
+    t.firstRow=firstRow;
+    t.lastRow=lastRow;
+  }
+  findWorkPool->pushBatch(runFindTask,tasks.data(),tasks.size());
+  findWorkPool->wait();
+
+  // merge the results in order/row/channel order
+  size_t total=0;
+  for (FurnaceGUIFindTask& t: tasks) total+=t.results.size();
+  curQueryResults.reserve(total);
+  for (FurnaceGUIFindTask& t: tasks) {
+    curQueryResults.insert(curQueryResults.end(),t.results.begin(),t.results.end());
   }
+  std::sort(curQueryResults.begin(),curQueryResults.end(),[](const FurnaceGUIQueryResult& a, const FurnaceGUIQueryResult& b) {
+    if (a.order!=b.order) return a.order<b.order;
+    if (a.y!=b.y) return a.y<b.y;
+    return a.x<b.x;
+  });
   queryViewingResults=true;
 }
 
@@ -459,12 +530,16 @@ void FurnaceGUI::doReplace() {
   if (!curQueryResults.empty()) {
     MARK_MODIFIED;
   }
+  // results may be in other sub-songs
+  for (FurnaceGUIQueryResult& i: curQueryResults) {
+    e->invalidateSubSongTimestamps(i.subsong);
+  }
   recalcTimestamps=true;
 
   if (!us.pat.empty()) {
     undoHist.push_back(us);
     redoHist.clear();
-    if (undoHist.size()>settings.maxUndoSteps) undoHist.pop_front();
+    trimUndoHistory();
   }
 }
 
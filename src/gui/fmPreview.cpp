@@ -179,7 +179,7 @@ void FurnaceGUI::renderFMPreviewOPM(const DivInstrumentFM& params, int pos) {
 
 void FurnaceGUI::renderFMPreviewOPLL(const DivInstrumentFM& params, int pos) {
   if (fmPreviewOPLL==NULL) {
-    fmPreviewOPLL=new opm_t;
+    fmPreviewOPLL=new opll_t;
     pos=0;
   }
   int out[2];
@@ -421,7 +421,56 @@ void FurnaceGUI::renderFMPreviewESFM(const DivInstrumentFM& params, const DivIns
   }
 }
 
+// get the state of the preview chip for an instrument type.
+// ymfm (OPZ) is not a plain struct, so it can't be cached.
+#define FM_PREVIEW_CHIP(t) \
+  switch (t) { \
+    case DIV_INS_FM: \
+      chip=fmPreviewOPN; \
+      chipSize=sizeof(ym3438_t); \
+      break; \
+    case DIV_INS_OPM: \
+      chip=fmPreviewOPM; \
+      chipSize=sizeof(opm_t); \
+      break; \
+    case DIV_INS_OPLL: \
+      chip=fmPreviewOPLL; \
+      chipSize=sizeof(opll_t); \
+      break; \
+    case DIV_INS_OPL: \
+      chip=fmPreviewOPL; \
+      chipSize=sizeof(opl3_chip); \
+      break; \
+    case DIV_INS_ESFM: \
+      chip=fmPreviewESFM; \
+      chipSize=sizeof(esfm_chip); \
+      break; \
+    default: \
+      chip=NULL; \
+      chipSize=0; \
+      break; \
+  }
+
 void FurnaceGUI::renderFMPreview(const DivInstrument* ins, int pos) {
+  void* chip=NULL;
+  size_t chipSize=0;
+
+  // look for a previous render with the same parameters
+  if (pos==0) {
+    FM_PREVIEW_CHIP(ins->type);
+    if (chip!=NULL) {
+      for (FurnaceGUIFMPreviewCache& i: fmPreviewCache) {
+        if (i.type!=ins->type) continue;
+        if (!(i.fm==ins->fm)) continue;
+        if (ins->type==DIV_INS_ESFM && !(i.esfm==ins->esfm)) continue;
+        memcpy(chip,i.state.data(),chipSize);
+        memcpy(fmPreview,i.wave,FM_PREVIEW_SIZE*sizeof(short));
+        i.lastUsed=++fmPreviewCacheTime;
+        return;
+      }
+    }
+  }
+
   switch (ins->type) {
     case DIV_INS_FM:
       renderFMPreviewOPN(ins->fm,pos);
@@ -443,4 +492,27 @@ void FurnaceGUI::renderFMPreview(const DivInstrument* ins, int pos) {
     default:
       break;
   }
+
+  // store it, replacing the least recently used one
+  if (pos==0) {
+    FM_PREVIEW_CHIP(ins->type);
+    if (chip==NULL) return;
+    FurnaceGUIFMPreviewCache* slot=NULL;
+    if (fmPreviewCache.size()<FM_PREVIEW_CACHE_SIZE) {
+      fmPreviewCache.push_back(FurnaceGUIFMPreviewCache());
+      slot=&fmPreviewCache.back();
+    } else {
+      slot=&fmPreviewCache[0];
+      for (FurnaceGUIFMPreviewCache& i: fmPreviewCache) {
+        if (i.lastUsed<slot->lastUsed) slot=&i;
+      }
+    }
+    slot->type=ins->type;
+    slot->fm=ins->fm;
+    slot->esfm=ins->esfm;
+    memcpy(slot->wave,fmPreview,FM_PREVIEW_SIZE*sizeof(short));
+    slot->state.resize(chipSize);
+    memcpy(slot->state.data(),chip,chipSize);
+    slot->lastUsed=++fmPreviewCacheTime;
+  }
 }
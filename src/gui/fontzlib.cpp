@@ -37,16 +37,212 @@ struct InflateBlock {
   }
 };
 
-ImFont* FurnaceGUI::addFontZlib(const void* data, size_t len, float size_pixels, const ImFontConfig* font_cfg, const ImWchar* glyph_ranges) {
+// lazy fallback fonts
+// merged fallback fonts (CJK, Unifont) are large and most of the time only a
+// few of their glyphs (if any) are ever drawn. instead of decompressing them
+// when the atlas is set up, they are added with a wrapper font loader which
+// decompresses the font and hands it to the real loader the first time a
+// glyph is requested from it.
+
+#define LAZY_FONT_MAGIC 0x4c5a464e
+// per-baked header (placed before the real loader's per-baked data)
+#define LAZY_FONT_BAKED_HEADER 16
+
+struct LazyFontDesc {
+  unsigned int magic;
+  FurnaceGUI* gui;
+  const void* origPtr;
+  size_t origLen;
+};
+
+struct LazyFontLoader {
+  // must be first
+  ImFontLoader loader;
+  const ImFontLoader* real;
+};
+
+struct LazyFontSrc {
+  void* realData;
+  bool loaded, failed;
+  LazyFontSrc():
+    realData(NULL),
+    loaded(false),
+    failed(false) {}
+};
+
+// don't let these go through the fallbacks (and thereby load them):
+// - control characters (ImGui looks up tab when setting up a font size)
+// - private use area (icons are merged after the fallback fonts)
+static const ImWchar lazyFontExcludeRanges[]={
+  0x0001, 0x001f,
+  0x007f, 0x009f,
+  0xe000, 0xf8ff,
+  0
+};
+
+static std::map<const ImFontLoader*,LazyFontLoader> lazyLoaders;
+
+// the real loader keeps its state in src->FontLoaderData as well.
+// swap it in for the duration of a call.
+struct LazyFontSwap {
+  ImFontConfig* src;
+  LazyFontSrc* lz;
+  LazyFontSwap(ImFontConfig* s):
+    src(s),
+    lz((LazyFontSrc*)s->FontLoaderData) {
+    src->FontLoaderData=lz->realData;
+  }
+  ~LazyFontSwap() {
+    lz->realData=src->FontLoaderData;
+    src->FontLoaderData=lz;
+  }
+};
+
+static inline const ImFontLoader* lazyReal(ImFontConfig* src) {
+  return ((const LazyFontLoader*)src->FontLoader)->real;
+}
+
+static inline bool isLazyDesc(ImFontConfig* src) {
+  return src->FontData!=NULL && src->FontDataSize==(int)sizeof(LazyFontDesc) && ((LazyFontDesc*)src->FontData)->magic==LAZY_FONT_MAGIC;
+}
+
+static bool lazyRealSrcInit(ImFontAtlas* atlas, ImFontConfig* src) {
+  const ImFontLoader* real=lazyReal(src);
+  if (real->FontSrcInit==NULL) return true;
+  LazyFontSwap swap(src);
+  return real->FontSrcInit(atlas,src);
+}
+
+// decompress the font and initialize it in the real loader
+static bool lazyFontLoad(ImFontAtlas* atlas, ImFontConfig* src) {
+  LazyFontSrc* lz=(LazyFontSrc*)src->FontLoaderData;
+  if (lz->loaded) return true;
+  if (lz->failed) return false;
+
+  LazyFontDesc* desc=(LazyFontDesc*)src->FontData;
+  logV("loading fallback font on demand...");
+  FurnaceGUIUncompFont* font=desc->gui->getUncompFont(desc->origPtr,desc->origLen);
+  if (font==NULL) {
+    logW("could not decompress fallback font!");
+    lz->failed=true;
+    return false;
+  }
+  IM_FREE(desc);
+  src->FontData=font->data;
+  src->FontDataSize=font->len;
+  src->FontDataOwnedByAtlas=false;
+
+  if (!lazyRealSrcInit(atlas,src)) {
+    logW("could not initialize fallback font!");
+    lz->failed=true;
+    return false;
+  }
+  lz->loaded=true;
+  return true;
+}
+
+static bool lazyFontSrcInit(ImFontAtlas* atlas, ImFontConfig* src) {
+  LazyFontSrc* lz=new LazyFontSrc;
+  src->FontLoaderData=lz;
+  // already loaded (e.g. after a loader flags change)
+  if (!isLazyDesc(src)) {
+    if (!lazyRealSrcInit(atlas,src)) {
+      delete lz;
+      src->FontLoaderData=NULL;
+      return false;
+    }
+    lz->loaded=true;
+  }
+  return true;
+}
+
+static void lazyFontSrcDestroy(ImFontAtlas* atlas, ImFontConfig* src) {
+  LazyFontSrc* lz=(LazyFontSrc*)src->FontLoaderData;
+  if (lz==NULL) return;
+  if (lz->loaded) {
+    const ImFontLoader* real=lazyReal(src);
+    if (real->FontSrcDestroy!=NULL) {
+      LazyFontSwap swap(src);
+      real->FontSrcDestroy(atlas,src);
+    }
+  }
+  delete lz;
+  src->FontLoaderData=NULL;
+}
+
+// not loading the font here. this is only used to look for special
+// characters (fallback/ellipsis) when adding fonts, which would defeat
+// the purpose.
+static bool lazyFontSrcContainsGlyph(ImFontAtlas* atlas, ImFontConfig* src, ImWchar codepoint) {
+  LazyFontSrc* lz=(LazyFontSrc*)src->FontLoaderData;
+  if (!lz->loaded) return false;
+  const ImFontLoader* real=lazyReal(src);
+  if (real->FontSrcContainsGlyph==NULL) return false;
+  LazyFontSwap swap(src);
+  return real->FontSrcContainsGlyph(atlas,src,codepoint);
+}
+
+static bool lazyFontBakedInitReal(ImFontAtlas* atlas, ImFontConfig* src, ImFontBaked* baked, void* data) {
+  bool* inited=(bool*)data;
+  const ImFontLoader* real=lazyReal(src);
+  if (real->FontBakedInit!=NULL) {
+    LazyFontSwap swap(src);
+    if (!real->FontBakedInit(atlas,src,baked,(unsigned char*)data+LAZY_FONT_BAKED_HEADER)) return false;
+  }
+  *inited=true;
+  return true;
+}
+
+static bool lazyFontBakedInit(ImFontAtlas* atlas, ImFontConfig* src, ImFontBaked* baked, void* data) {
+  LazyFontSrc* lz=(LazyFontSrc*)src->FontLoaderData;
+  *(bool*)data=false;
+  if (!lz->loaded) return true;
+  return lazyFontBakedInitReal(atlas,src,baked,data);
+}
+
+static void lazyFontBakedDestroy(ImFontAtlas* atlas, ImFontConfig* src, ImFontBaked* baked, void* data) {
+  if (!*(bool*)data) return;
+  const ImFontLoader* real=lazyReal(src);
+  if (real->FontBakedDestroy!=NULL) {
+    LazyFontSwap swap(src);
+    real->FontBakedDestroy(atlas,src,baked,(unsigned char*)data+LAZY_FONT_BAKED_HEADER);
+  }
+  *(bool*)data=false;
+}
+
+static bool lazyFontBakedLoadGlyph(ImFontAtlas* atlas, ImFontConfig* src, ImFontBaked* baked, void* data, ImWchar codepoint, ImFontGlyph* out_glyph, float* out_advance_x) {
+  if (!lazyFontLoad(atlas,src)) return false;
+  if (!*(bool*)data) {
+    if (!lazyFontBakedInitReal(atlas,src,baked,data)) return false;
+  }
+  LazyFontSwap swap(src);
+  return lazyReal(src)->FontBakedLoadGlyph(atlas,src,baked,(unsigned char*)data+LAZY_FONT_BAKED_HEADER,codepoint,out_glyph,out_advance_x);
+}
+
+// one wrapper per real loader (they differ in per-baked data size)
+static const ImFontLoader* getLazyLoader(const ImFontLoader* real) {
+  auto i=lazyLoaders.find(real);
+  if (i!=lazyLoaders.end()) return &i->second.loader;
+
+  LazyFontLoader& l=lazyLoaders[real];
+  l.real=real;
+  l.loader.Name="Furnace lazy loader";
+  l.loader.FontSrcInit=lazyFontSrcInit;
+  l.loader.FontSrcDestroy=lazyFontSrcDestroy;
+  l.loader.FontSrcContainsGlyph=lazyFontSrcContainsGlyph;
+  l.loader.FontBakedInit=lazyFontBakedInit;
+  l.loader.FontBakedDestroy=lazyFontBakedDestroy;
+  l.loader.FontBakedLoadGlyph=lazyFontBakedLoadGlyph;
+  l.loader.FontBakedSrcLoaderDataSize=LAZY_FONT_BAKED_HEADER+real->FontBakedSrcLoaderDataSize;
+  return &l.loader;
+}
+
+FurnaceGUIUncompFont* FurnaceGUI::getUncompFont(const void* data, size_t len) {
   // find font in cache
-  logV("addFontZlib...");
   for (FurnaceGUIUncompFont& i: fontCache) {
     if (i.origPtr==data && i.origLen==len) {
       logV("found in cache");
-      ImFontConfig fontConfig=(font_cfg==NULL)?ImFontConfig():(*font_cfg);
-      fontConfig.FontDataOwnedByAtlas=false;
-
-      return ImGui::GetIO().Fonts->AddFontFromMemoryTTF(i.data,i.len,size_pixels,&fontConfig,glyph_ranges);
+      return &i;
     }
   }
 
@@ -130,9 +326,45 @@ ImFont* FurnaceGUI::addFontZlib(const void* data, size_t len, float size_pixels,
   blocks.clear();
 
   fontCache.push_back(FurnaceGUIUncompFont(data,len,finalData,finalSize));
+  return &fontCache.back();
+}
 
+ImFont* FurnaceGUI::addFontZlib(const void* data, size_t len, float size_pixels, const ImFontConfig* font_cfg, const ImWchar* glyph_ranges, bool lazy) {
+  logV("addFontZlib...");
   ImFontConfig fontConfig=(font_cfg==NULL)?ImFontConfig():(*font_cfg);
-  fontConfig.FontDataOwnedByAtlas=false;
 
-  return ImGui::GetIO().Fonts->AddFontFromMemoryTTF(finalData,finalSize,size_pixels,&fontConfig,glyph_ranges);
+  if (lazy && fontConfig.MergeMode) {
+    // if it's already been decompressed there is nothing to gain
+    bool cached=false;
+    for (FurnaceGUIUncompFont& i: fontCache) {
+      if (i.origPtr==data && i.origLen==len) {
+        cached=true;
+        break;
+      }
+    }
+    ImFontAtlas* atlas=ImGui::GetIO().Fonts;
+    if (!cached && atlas->FontLoader!=NULL) {
+      logV("deferring decompression");
+      // ImGui takes ownership of the descriptor and frees it when the atlas is cleared
+      LazyFontDesc* desc=(LazyFontDesc*)IM_ALLOC(sizeof(LazyFontDesc));
+      desc->magic=LAZY_FONT_MAGIC;
+      desc->gui=this;
+      desc->origPtr=data;
+      desc->origLen=len;
+      fontConfig.FontData=desc;
+      fontConfig.FontDataSize=sizeof(LazyFontDesc);
+      fontConfig.FontDataOwnedByAtlas=true;
+      fontConfig.FontLoader=getLazyLoader(atlas->FontLoader);
+      fontConfig.GlyphExcludeRanges=lazyFontExcludeRanges;
+      if (size_pixels>0.0f) fontConfig.SizePixels=size_pixels;
+      if (glyph_ranges!=NULL) fontConfig.GlyphRanges=glyph_ranges;
+      return atlas->AddFont(&fontConfig);
+    }
+  }
+
+  FurnaceGUIUncompFont* font=getUncompFont(data,len);
+  if (font==NULL) return NULL;
+
+  fontConfig.FontDataOwnedByAtlas=false;
+  return ImGui::GetIO().Fonts->AddFontFromMemoryTTF(font->data,font->len,size_pixels,&fontConfig,glyph_ranges);
 }
@@ -36,6 +36,7 @@
 #include "intConst.h"
 #include "scaling.h"
 #include "introTune.h"
+#include "../engine/trace.h"
 #include <stdint.h>
 #include <zlib.h>
 #include <fmt/printf.h>
@@ -804,12 +805,12 @@ void FurnaceGUI::autoDetectSystemIter(std::vector<FurnaceGUISysDef>& category, b
             isMatch=false;
             break;
           }
-          for (std::pair<String,String> l: defConfI->second.configMap()) {
+          for (auto& l: defConfI->second.configMap()) {
             if (!sysDC.has(l.first)) {
               isMatch=false;
               break;
             }
-            if (sysDC.getString(l.first,"")!=l.second) {
+            if (sysDC.getString(l.first,"")!=l.second.str) {
               isMatch=false;
               break;
             }
@@ -1381,15 +1382,17 @@ void FurnaceGUI::stop() {
 }
 
 void FurnaceGUI::previewNote(int refChan, int note, bool autoNote) {
-  e->setMidiBaseChan(refChan);
-  e->synchronized([this,note]() {
-    if (!e->autoNoteOn(-1,curIns,note)) failedNoteOn=true;
-    for (int mi=0; mi<7; mi++) {
-      if (multiIns[mi]!=-1) {
-        e->autoNoteOn(-1,multiIns[mi],note,-1,multiInsTranspose[mi]);
-      }
+  // outside of the pattern, which channel plays the note doesn't matter
+  bool cached=settings.cachedInsPreview && (curWindow==GUI_WINDOW_INS_LIST || curWindow==GUI_WINDOW_INS_EDIT);
+  if (!(cached && e->previewInsCached(curIns,note))) {
+    e->queueAutoNoteOn(refChan,curIns,note,-1,0,&failedNoteOn);
+  }
+  for (int mi=0; mi<7; mi++) {
+    if (multiIns[mi]!=-1) {
+      if (cached && e->previewInsCached(multiIns[mi],note,multiInsTranspose[mi])) continue;
+      e->queueAutoNoteOn(-1,multiIns[mi],note,-1,multiInsTranspose[mi]);
     }
-  });
+  }
 }
 
 void FurnaceGUI::stopPreviewNote(SDL_Scancode scancode, bool autoNote) {
@@ -1404,10 +1407,9 @@ void FurnaceGUI::stopPreviewNote(SDL_Scancode scancode, bool autoNote) {
     if (key==101) return;
     if (key==102) return;
 
-    e->synchronized([this,num]() {
-      e->autoNoteOff(-1,num);
-      failedNoteOn=false;
-    });
+    e->stopInsPreview(num);
+    e->queueAutoNoteOff(num);
+    failedNoteOn=false;
   }
 }
 
@@ -2445,6 +2447,103 @@ void FurnaceGUI::openFileDialog(FurnaceGUIFileDialogs type) {
   if (hasOpened) curFileDialog=type;
 }
 
+// songs smaller than this are always compressed in one thread
+#define PARALLEL_COMPRESS_MIN (4U<<20)
+// size of a parallel compression block
+#define PARALLEL_COMPRESS_BLOCK (1U<<20)
+// a block is compressed using the end of the previous one as dictionary
+#define PARALLEL_COMPRESS_DICT 32768
+
+struct FurnaceGUICompressBlock {
+  const unsigned char* data;
+  size_t start, len;
+  int level;
+  bool last, ok;
+  std::vector<unsigned char> out;
+  FurnaceGUICompressBlock():
+    data(NULL),
+    start(0),
+    len(0),
+    level(Z_DEFAULT_COMPRESSION),
+    last(false),
+    ok(false) {}
+};
+
+// compress a block to raw deflate data.
+// blocks other than the last one end with a sync flush, so they can be concatenated.
+static void _compressBlock(void* arg) {
+  FurnaceGUICompressBlock* b=(FurnaceGUICompressBlock*)arg;
+  z_stream zl;
+  memset(&zl,0,sizeof(z_stream));
+  if (deflateInit2(&zl,b->level,Z_DEFLATED,-15,8,Z_DEFAULT_STRATEGY)!=Z_OK) return;
+  if (b->start>0) {
+    size_t dictLen=MIN(b->start,(size_t)PARALLEL_COMPRESS_DICT);
+    if (deflateSetDictionary(&zl,b->data+b->start-dictLen,dictLen)!=Z_OK) {
+      deflateEnd(&zl);
+      return;
+    }
+  }
+  b->out.resize(deflateBound(&zl,b->len)+16);
+  zl.next_in=(Bytef*)(b->data+b->start);
+  zl.avail_in=b->len;
+  zl.next_out=b->out.data();
+  zl.avail_out=b->out.size();
+  int ret=deflate(&zl,b->last?Z_FINISH:Z_SYNC_FLUSH);
+  if (ret==Z_STREAM_ERROR || zl.avail_in>0 || (b->last && ret!=Z_STREAM_END)) {
+    deflateEnd(&zl);
+    return;
+  }
+  b->out.resize(b->out.size()-zl.avail_out);
+  deflateEnd(&zl);
+  b->ok=true;
+}
+
+// compress data into a zlib stream using all cores, pigz-style.
+static bool compressParallel(const unsigned char* data, size_t len, std::vector<unsigned char>& out, int level) {
+  std::vector<FurnaceGUICompressBlock> blocks((len+PARALLEL_COMPRESS_BLOCK-1)/PARALLEL_COMPRESS_BLOCK);
+  for (size_t i=0; i<blocks.size(); i++) {
+    blocks[i].data=data;
+    blocks[i].start=i*PARALLEL_COMPRESS_BLOCK;
+    blocks[i].len=MIN((size_t)PARALLEL_COMPRESS_BLOCK,len-blocks[i].start);
+    blocks[i].level=level;
+    blocks[i].last=(i==blocks.size()-1);
+  }
+
+  unsigned int threads=std::thread::hardware_concurrency();
+  if (threads>blocks.size()) threads=blocks.size();
+  DivWorkPool* pool=new DivWorkPool((threads>1)?(threads-1):0);
+  pool->pushBatch(_compressBlock,blocks.data(),blocks.size());
+  pool->wait();
+  delete pool;
+
+  // zlib header. the second byte only hints the compression level
+  out.clear();
+  out.push_back(0x78);
+  if (level<2) {
+    out.push_back(0x01);
+  } else if (level<6) {
+    out.push_back(0x5e);
+  } else if (level==6) {
+    out.push_back(0x9c);
+  } else {
+    out.push_back(0xda);
+  }
+  for (FurnaceGUICompressBlock& i: blocks) {
+    if (!i.ok) return false;
+    out.insert(out.end(),i.out.begin(),i.out.end());
+  }
+  // checksum of the uncompressed data
+  uLong adler=adler32(0L,Z_NULL,0);
+  for (size_t i=0; i<len; i+=PARALLEL_COMPRESS_BLOCK) {
+    adler=adler32(adler,data+i,MIN((size_t)PARALLEL_COMPRESS_BLOCK,len-i));
+  }
+  out.push_back((adler>>24)&0xff);
+  out.push_back((adler>>16)&0xff);
+  out.push_back((adler>>8)&0xff);
+  out.push_back(adler&0xff);
+  return true;
+}
+
 int FurnaceGUI::save(String path, int dmfVersion) {
   SafeWriter* w;
   logD("saving file...");
@@ -2467,12 +2566,28 @@ int FurnaceGUI::save(String path, int dmfVersion) {
     w->finish();
     return 1;
   }
-  if (settings.compress) {
+  if (settings.compress && settings.parallelCompress && w->size()>=PARALLEL_COMPRESS_MIN) {
+    std::vector<unsigned char> zbuf;
+    if (!compressParallel(w->getFinalBuf(),w->size(),zbuf,settings.compressLevel)) {
+      logE("zlib error!");
+      lastError=_("compression error");
+      fclose(outFile);
+      w->finish();
+      return 2;
+    }
+    if (fwrite(zbuf.data(),1,zbuf.size(),outFile)!=zbuf.size()) {
+      logE("did not write entirely: %s!",strerror(errno));
+      lastError=strerror(errno);
+      fclose(outFile);
+      w->finish();
+      return 1;
+    }
+  } else if (settings.compress) {
     unsigned char zbuf[131072];
     int ret;
     z_stream zl;
     memset(&zl,0,sizeof(z_stream));
-    ret=deflateInit(&zl,Z_DEFAULT_COMPRESSION);
+    ret=deflateInit(&zl,settings.compressLevel);
     if (ret!=Z_OK) {
       logE("zlib error!");
       lastError=_("compression error");
@@ -2631,7 +2746,9 @@ int FurnaceGUI::load(String path) {
   }
   pushRecentFile(path);
   // walk song
-  e->calcSongTimestamps();
+  e->calcSongTimestampsAsync();
+  // and the other sub-songs, for their lengths
+  if (e->song.subsong.size()>1) e->calcAllSongTimestamps();
   // do not auto-play a backup
   if (path.find(backupPath)!=0) {
     if (settings.playOnLoad==2 || (settings.playOnLoad==1 && wasPlaying)) {
@@ -3860,15 +3977,36 @@ bool FurnaceGUI::detectOutOfBoundsWindow(SDL_Rect& failing) {
     perfMetrics[perfMetricsLen++]=FurnaceGUIPerfMetric(#_n,SDL_GetPerformanceCounter()-__perfM##_n); \
   }
 
-#define MEASURE(_n,_x) \
+#define MEASURE(_n,_x) { \
+  DIV_TRACE_SCOPE(#_n); \
   MEASURE_BEGIN(_n) \
   _x; \
-  MEASURE_END(_n)
+  MEASURE_END(_n) \
+}
 
 #define IMPORT_CLOSE(x) \
   if (x) pendingLayoutImportReopen.push(&x); \
   x=false;
 
+void FurnaceGUI::waitPlaybackFrame() {
+  uint64_t freq=SDL_GetPerformanceFrequency();
+  uint64_t deadline=lastPlaybackFrame+freq/settings.playbackFrameRate;
+  while (true) {
+    uint64_t now=SDL_GetPerformanceCounter();
+    if (now>=deadline) break;
+    // the pattern view must follow the playhead
+    if (e->getOrder()!=lastPlaybackOrder || e->getRow()!=lastPlaybackRow) break;
+    int waitMs=((deadline-now)*1000)/freq;
+    if (waitMs>4) waitMs=4;
+    if (waitMs<1) waitMs=1;
+    // stop waiting if there's input
+    if (SDL_WaitEventTimeout(NULL,waitMs)) break;
+  }
+  lastPlaybackFrame=SDL_GetPerformanceCounter();
+  lastPlaybackOrder=e->getOrder();
+  lastPlaybackRow=e->getRow();
+}
+
 bool FurnaceGUI::loop() {
   DECLARE_METRIC(calcChanOsc)
   DECLARE_METRIC(mobileControls)
@@ -3936,10 +4074,14 @@ bool FurnaceGUI::loop() {
     settingsOpen=true;
   }
 
+  DIV_TRACE_THREAD("GUI");
+
   while (!quit) {
+    DIV_TRACE_SCOPE("frame");
     SDL_Event ev;
     SelectionPoint prevCursor=cursor;
     if (e->isPlaying()) {
+      if (settings.playbackFrameRate>0) waitPlaybackFrame();
       WAKE_UP;
     }
     if (--drawHalt<=0) {
@@ -4454,6 +4596,18 @@ bool FurnaceGUI::loop() {
       }
     }
 
+    // react to high audio load
+    switch (e->pollGovernor()) {
+      case DIV_GOVERNOR_RENDER_AHEAD:
+        showWarning(_("audio processing is taking too long at times.\nthe render-ahead buffer has been enlarged (this increases latency)."),GUI_WARN_GENERIC);
+        break;
+      case DIV_GOVERNOR_LIGHT_CORES:
+        showWarning(_("your computer can't keep up with the selected emulation cores!\nfaster (but less accurate) cores are being used for playback.\naudio export still uses the render cores."),GUI_WARN_GENERIC);
+        break;
+      default:
+        break;
+    }
+
     // recover from dead graphics
     if (rend->isDead() || killGraphics) {
       killGraphics=false;
@@ -5080,6 +5234,9 @@ bool FurnaceGUI::loop() {
       if (modified) {
         ImGui::Text(_("| modified"));
       }
+      if (e->areSamplesLoading()) {
+        ImGui::Text(_("| loading samples..."));
+      }
       ImGui::EndMainMenuBar();
     }
 
@@ -5741,35 +5898,42 @@ bool FurnaceGUI::loop() {
               bool warn=false;
               String warns=_("there were some warnings/errors while loading instruments:\n");
               int sampleCountBefore=e->song.sampleLen;
-              for (String i: fileDialog->getFileName()) {
-                std::vector<DivInstrument*> insTemp=e->instrumentFromFile(i.c_str(),true,settings.readInsNames);
-                if (insTemp.empty()) {
+              int duplicates=0;
+              // files are parsed in parallel. when loading several, skip instruments which are already there
+              std::vector<DivInstrumentImport> imports=e->instrumentsFromFiles(fileDialog->getFileName(),true,settings.readInsNames,fileDialog->getFileName().size()>1);
+              for (DivInstrumentImport& i: imports) {
+                if (i.ins.empty() && i.duplicates==0) {
                   warn=true;
-                  warns+=fmt::sprintf(_("> %s: cannot load instrument! (%s)\n"),i,e->getLastError());
-                } else if (!e->getWarnings().empty()) {
+                  warns+=fmt::sprintf(_("> %s: cannot load instrument! (%s)\n"),i.path,i.status.error);
+                } else if (!i.status.warnings.empty()) {
                   warn=true;
-                  warns+=fmt::sprintf("> %s:\n%s\n",i,e->getWarnings());
+                  warns+=fmt::sprintf("> %s:\n%s\n",i.path,i.status.warnings);
                 }
-                if (insTemp.size()>1) ask=true;
-                for (DivInstrument* j: insTemp) {
+                if (i.ins.size()>1) ask=true;
+                for (DivInstrument* j: i.ins) {
                   instruments.push_back(j);
                 }
+                duplicates+=i.duplicates;
               }
               if (e->song.sampleLen!=sampleCountBefore) {
                 e->renderSamplesP();
               }
               if (warn) {
                 if (instruments.empty()) {
-                  if (fileDialog->getFileName().size()>1) {
+                  if (imports.size()>1) {
                     showError(warns);
                   } else {
-                    showError(fmt::sprintf(_("cannot load instrument! (%s)"),e->getLastError()));
+                    showError(fmt::sprintf(_("cannot load instrument! (%s)"),imports.empty()?String(""):imports[0].status.error));
                   }
                 } else {
                   showWarning(warns,GUI_WARN_GENERIC);
                 }
               } else if (instruments.empty()) {
-                showError(_("congratulations! you managed to load nothing.\nyou are entitled to a bug report."));
+                if (duplicates>0) {
+                  showWarning(_("these instruments are already in the song."),GUI_WARN_GENERIC);
+                } else {
+                  showError(_("congratulations! you managed to load nothing.\nyou are entitled to a bug report."));
+                }
               }
               if (!instruments.empty()) {
                 if (ask) { // ask which instruments to load
@@ -5778,12 +5942,9 @@ bool FurnaceGUI::loop() {
                   }
                   displayPendingIns=true;
                   pendingInsSingle=false;
-                } else { // load the only instrument
-                  int instrumentCount=-1;
-                  for (DivInstrument* i: instruments) {
-                    instrumentCount=e->addInstrumentPtr(i);
-                    MARK_MODIFIED;
-                  }
+                } else { // load the instruments in one go
+                  int instrumentCount=e->addInstrumentsPtr(instruments);
+                  MARK_MODIFIED;
                   if (instrumentCount>=0 && settings.selectAssetOnLoad) {
                     setCurIns(instrumentCount-1);
                   }
@@ -5880,7 +6041,46 @@ bool FurnaceGUI::loop() {
               break;
             }
             case GUI_FILE_EXPORT_VGM: {
-              SafeWriter* w=e->saveVGM(willExport,vgmExportLoop,vgmExportVersion,vgmExportPatternHints,vgmExportDirectStream,vgmExportTrailingTicks,vgmExportDPCM07,vgmExportCorrectedRate);
+              if (vgmExportAllSubSongs && e->song.subsong.size()>1) {
+                // name_01.vgm, name_02.vgm...
+                String baseName=copyOfName;
+                if (baseName.size()>4) {
+                  String ext=baseName.substr(baseName.size()-4);
+                  for (char& i: ext) {
+                    if (i>='A' && i<='Z') i+='a'-'A';
+                  }
+                  if (ext==".vgm") baseName=baseName.substr(0,baseName.size()-4);
+                }
+                std::vector<size_t> subSongs;
+                for (size_t i=0; i<e->song.subsong.size(); i++) {
+                  subSongs.push_back(i);
+                }
+                std::vector<SafeWriter*> files=e->saveVGMSubSongs(subSongs,0,willExport,vgmExportLoop,vgmExportVersion,vgmExportPatternHints,vgmExportDirectStream,vgmExportTrailingTicks,vgmExportDPCM07,vgmExportCorrectedRate,vgmExportDedupeWrites,vgmExportPackSamples);
+                int failed=0;
+                for (size_t i=0; i<files.size(); i++) {
+                  if (files[i]==NULL) {
+                    failed++;
+                    continue;
+                  }
+                  String fileName=fmt::sprintf("%s_%.2d.vgm",baseName,(int)subSongs[i]+1);
+                  FILE* f=ps_fopen(fileName.c_str(),"wb");
+                  if (f!=NULL) {
+                    fwrite(files[i]->getFinalBuf(),1,files[i]->size(),f);
+                    fclose(f);
+                  } else {
+                    failed++;
+                  }
+                  files[i]->finish();
+                  delete files[i];
+                }
+                if (failed>0) {
+                  showError(fmt::sprintf(_("could not write %d of %d VGM files!"),failed,(int)files.size()));
+                } else if (!e->getWarnings().empty()) {
+                  showWarning(e->getWarnings(),GUI_WARN_GENERIC);
+                }
+                break;
+              }
+              SafeWriter* w=e->saveVGM(willExport,vgmExportLoop,vgmExportVersion,vgmExportPatternHints,vgmExportDirectStream,vgmExportTrailingTicks,vgmExportDPCM07,vgmExportCorrectedRate,vgmExportDedupeWrites,vgmExportPackSamples);
               if (w!=NULL) {
                 FILE* f=ps_fopen(copyOfName.c_str(),"wb");
                 if (f!=NULL) {
@@ -5916,23 +6116,20 @@ bool FurnaceGUI::loop() {
               }
               break;
             case GUI_FILE_EXPORT_TEXT: {
-              SafeWriter* w=e->saveText(false);
-              if (w!=NULL) {
-                FILE* f=ps_fopen(copyOfName.c_str(),"wb");
-                if (f!=NULL) {
-                  fwrite(w->getFinalBuf(),1,w->size(),f);
-                  fclose(f);
+              FILE* f=ps_fopen(copyOfName.c_str(),"wb");
+              if (f!=NULL) {
+                bool wrote=e->saveTextFile(f,false);
+                fclose(f);
+                if (wrote) {
                   pushRecentSys(copyOfName.c_str());
+                  if (!e->getWarnings().empty()) {
+                    showWarning(e->getWarnings(),GUI_WARN_GENERIC);
+                  }
                 } else {
-                  showError(_("could not open file!"));
-                }
-                w->finish();
-                delete w;
-                if (!e->getWarnings().empty()) {
-                  showWarning(e->getWarnings(),GUI_WARN_GENERIC);
+                  showError(fmt::sprintf(_("could not write text! (%s)"),strerror(errno)));
                 }
               } else {
-                showError(fmt::sprintf(_("could not write text! (%s)"),e->getLastError()));
+                showError(_("could not open file!"));
               }
               break;
             }
@@ -6079,6 +6276,11 @@ bool FurnaceGUI::loop() {
       ImGui::OpenPopup(_("Rendering..."));
     }
 
+    if (displayResampling) {
+      displayResampling=false;
+      ImGui::OpenPopup(_("Resampling..."));
+    }
+
     if (displayExportingROM) {
       displayExportingROM=false;
       ImGui::OpenPopup(_("ROM Export Progress"));
@@ -6179,6 +6381,26 @@ bool FurnaceGUI::loop() {
       ImGui::EndPopup();
     }
 
+    centerNextWindow(_("Resampling..."),canvasW,canvasH);
+    if (ImGui::BeginPopupModal(_("Resampling..."),NULL,ImGuiWindowFlags_NoResize|ImGuiWindowFlags_NoMove|ImGuiWindowFlags_NoSavedSettings)) {
+      WAKE_UP;
+      if (resampleJob==NULL) {
+        ImGui::CloseCurrentPopup();
+      } else {
+        float resampleProgress=resampleJob->progress;
+        ImGui::Text(_("Please wait..."));
+        ImGui::ProgressBar(resampleProgress,ImVec2(320.0f*dpiScale,0),fmt::sprintf("%.2f%%",resampleProgress*100.0f).c_str());
+        if (ImGui::Button(_("Abort"))) {
+          resampleJob->cancel=true;
+        }
+        if (resampleJob->finished) {
+          finishResample();
+          ImGui::CloseCurrentPopup();
+        }
+      }
+      ImGui::EndPopup();
+    }
+
     ImVec2 romExportMinSize=mobileUI?ImVec2(canvasW-(portrait?0:(60.0*dpiScale)),canvasH-60.0*dpiScale):ImVec2(400.0f*dpiScale,200.0f*dpiScale);
     ImVec2 romExportMaxSize=ImVec2(canvasW-((mobileUI && !portrait)?(60.0*dpiScale):0),canvasH-(mobileUI?(60.0*dpiScale):0));
 
@@ -6729,6 +6951,16 @@ bool FurnaceGUI::loop() {
               MARK_MODIFIED;
               ImGui::CloseCurrentPopup();
             }
+            if (ImGui::Button(_("Merge duplicate instruments"))) {
+              stop();
+              if (e->mergeDuplicateIns()>0) MARK_MODIFIED;
+              ImGui::CloseCurrentPopup();
+            }
+            if (ImGui::Button(_("Merge duplicate samples"))) {
+              stop();
+              if (e->mergeDuplicateSamples()>0) MARK_MODIFIED;
+              ImGui::CloseCurrentPopup();
+            }
 
             ImGui::EndTable();
           }
@@ -7409,7 +7641,11 @@ bool FurnaceGUI::loop() {
     if (modified && settings.backupEnable) {
       if (backupTimer>0) {
         backupTimer=(backupTimer-ImGui::GetIO().DeltaTime);
-        if (backupTimer<=0) {
+        if (backupTimer<=0 && !backupPending) {
+          // nothing changed since the last backup. don't write the same song again
+          backupTimer=settings.backupInterval;
+        } else if (backupTimer<=0) {
+          backupPending=false;
           backupTask=std::async(std::launch::async,[this]() -> bool {
             backupLock.lock();
             logV("backupPath: %s",backupPath);
@@ -7502,9 +7738,19 @@ bool FurnaceGUI::loop() {
 
     if (recalcTimestamps) {
       logV("need to recalc timestamps...");
-      e->calcSongTimestamps();
+      e->calcSongTimestampsAsync();
       recalcTimestamps=false;
+      recalcTimestampsPartial=false;
+    } else if (recalcTimestampsPartial) {
+      // an incremental calculation would be overwritten by the one in progress
+      if (e->isCalculatingTimestamps()) {
+        e->calcSongTimestampsAsync();
+      } else {
+        e->calcSongTimestamps(true);
+      }
+      recalcTimestampsPartial=false;
     }
+    e->updateSongTimestamps();
 
     if (!e->isPlaying() && e->getFilePlayerSync()) {
       if (cursor.y!=prevCursor.y || cursor.order!=prevCursor.order) {
@@ -7578,10 +7824,16 @@ bool FurnaceGUI::loop() {
       rend->clear(uiColors[GUI_COLOR_BACKGROUND]);
     }
     renderTimeBegin=SDL_GetPerformanceCounter();
-    ImGui::Render();
+    {
+      DIV_TRACE_SCOPE("render");
+      ImGui::Render();
+    }
     renderTimeEnd=SDL_GetPerformanceCounter();
     drawTimeBegin=SDL_GetPerformanceCounter();
-    rend->renderGUI();
+    {
+      DIV_TRACE_SCOPE("draw");
+      rend->renderGUI();
+    }
     if (mustClear) {
       rend->clear(ImVec4(0,0,0,0));
       mustClear--;
@@ -7616,7 +7868,10 @@ bool FurnaceGUI::loop() {
         }
       }
     }
-    rend->present();
+    {
+      DIV_TRACE_SCOPE("present");
+      rend->present();
+    }
     if (settings.renderClearPos && renderBackend!=GUI_BACKEND_METAL) {
       rend->clear(uiColors[GUI_COLOR_BACKGROUND]);
     }
@@ -7715,9 +7970,18 @@ bool FurnaceGUI::init() {
 
   newFilePicker=new FurnaceFilePicker;
   newFilePicker->setConfigPrefix("fp_");
+  newFilePicker->setPreviewCallback([this](const String& path, FilePickerPreview& p) {
+    return makeFilePreview(path,p);
+  },[this](const FilePickerPreview& p) {
+    drawFilePreview(p);
+  });
 
   opTouched=new bool[DIV_MAX_PATTERNS*DIV_MAX_ROWS];
 
+  // the channel meters and oscilloscopes read the per-channel oscilloscope buffers
+  e->addOscConsumer();
+
+  e->startupPhase("GUI settings");
   syncState();
   syncSettings();
   syncTutorial();
@@ -7758,6 +8022,7 @@ bool FurnaceGUI::init() {
   SDL_setenv("SDL_VIDEO_WAYLAND_WMCLASS", FURNACE_APP_ID, 0);
 
   // initialize SDL
+  e->startupPhase("GUI video init");
   logD("initializing video...");
   if (SDL_Init(SDL_INIT_VIDEO)!=0) {
     logE("could not initialize video! %s",SDL_GetError());
@@ -7870,6 +8135,7 @@ bool FurnaceGUI::init() {
 
   logV("window size: %dx%d",scrW,scrH);
 
+  e->startupPhase("GUI window and renderer");
   if (!initRender()) {
     if (settings.renderBackend!="Software") {
       settings.renderBackend="Software";
@@ -7942,6 +8208,8 @@ bool FurnaceGUI::init() {
   if (icon!=NULL) {
     SDL_SetWindowIcon(sdlWin,icon);
     SDL_FreeSurface(icon);
+    // SDL keeps its own copy
+    freeImageData(GUI_IMAGE_ICON);
   } else {
     logW("could not create icon!");
   }
@@ -8010,6 +8278,13 @@ bool FurnaceGUI::init() {
     bestTexFormat=GUI_TEXFORMAT_BGRA32;
   }
 
+#ifndef NO_INTRO
+  // the intro images are decoded while the rest of the GUI starts up
+  if ((!tutorial.introPlayed || settings.alwaysPlayIntro!=0) && renderBackend!=GUI_BACKEND_SOFTWARE) {
+    preloadImages();
+  }
+#endif
+
   // try acquiring the canvas size
   if (!rend->getOutputSize(canvasW,canvasH)) {
     logW("could not get renderer output size!");
@@ -8115,8 +8390,10 @@ bool FurnaceGUI::init() {
     }
   }
 
+  e->startupPhase("GUI user presets");
   loadUserPresets(true);
 
+  e->startupPhase("GUI fonts and UI settings");
   applyUISettings();
 
   logD("building font...");
@@ -8124,6 +8401,7 @@ bool FurnaceGUI::init() {
     ImGui::GetIO().Fonts->Flags|=ImFontAtlasFlags_Square;
   }
 
+  e->startupPhase("GUI layout and the rest");
   logD("preparing layout...");
   strncpy(finalLayoutPath,(e->getConfigPath()+String(LAYOUT_INI)).c_str(),4095);
   backupPath=e->getConfigPath();
@@ -8488,6 +8766,8 @@ void FurnaceGUI::syncState() {
   xyOscIntensity=e->getConfFloat("xyOscIntensity",2.0f);
   xyOscThickness=e->getConfFloat("xyOscThickness",2.0f);
 
+  regViewHeatmap=e->getConfBool("regViewHeatmap",false);
+
   cvHiScore=e->getConfInt("cvHiScore",25000);
 
   newFilePicker->loadSettings(e->getConfObject());
@@ -8663,6 +8943,8 @@ void FurnaceGUI::commitState(DivConfig& conf) {
   conf.set("xyOscIntensity",xyOscIntensity);
   conf.set("xyOscThickness",xyOscThickness);
 
+  conf.set("regViewHeatmap",regViewHeatmap);
+
   // commit recent files
   for (int i=0; i<30; i++) {
     String key=fmt::sprintf("recentFile%d",i);
@@ -8679,6 +8961,17 @@ void FurnaceGUI::commitState(DivConfig& conf) {
 }
 
 bool FurnaceGUI::finish(bool saveConfig) {
+  e->removeOscConsumer();
+  // wait for images which were never used (e.g. the intro was skipped)
+  for (int i=0; i<GUI_IMAGE_MAX; i++) {
+    if (imageLoader[i]==NULL) continue;
+    getImage((FurnaceGUIImages)i);
+    freeImageData((FurnaceGUIImages)i);
+  }
+  if (resampleJob!=NULL) {
+    resampleJob->cancel=true;
+    finishResample();
+  }
   if (!quitNoSave) {
     commitState(e->getConfObject());
     if (userPresetsOpen) {
@@ -8718,34 +9011,18 @@ bool FurnaceGUI::finish(bool saveConfig) {
     delete chanOscWorkPool;
   }
 
+  if (findWorkPool!=NULL) {
+    delete findWorkPool;
+  }
+
   delete[] opTouched;
   opTouched=NULL;
 
-  if (tunerFFTInBuf) {
-    delete[] tunerFFTInBuf;
-    tunerFFTInBuf=NULL;
-  }
-  if (tunerFFTOutBuf) {
-    fftw_free(tunerFFTOutBuf);
-    tunerFFTOutBuf=NULL;
-  }
-  if (tunerPlan) {
-    fftw_free(tunerPlan);
-    tunerPlan=NULL;
+  for (FurnaceGUIOutputFFT* i: outputFFT) {
+    delete i;
   }
+  outputFFT.clear();
   for (int i=0; i<DIV_MAX_OUTPUTS; i++) {
-    if (spectrum.buffer[i]) {
-      fftw_free(spectrum.buffer[i]);
-      spectrum.buffer[i]=NULL;
-    }
-    if (spectrum.in[i]) {
-      delete[] spectrum.in[i];
-      spectrum.in[i]=NULL;
-    }
-    if (spectrum.plan[i]) {
-      fftw_free(spectrum.plan[i]);
-      spectrum.plan[i]=NULL;
-    }
     if (spectrum.plot[i]) {
       delete[] spectrum.plot[i];
       spectrum.plot[i]=NULL;
@@ -8792,6 +9069,9 @@ FurnaceGUI::FurnaceGUI():
   vgmExportPatternHints(false),
   vgmExportDPCM07(false),
   vgmExportDirectStream(false),
+  vgmExportDedupeWrites(false),
+  vgmExportPackSamples(false),
+  vgmExportAllSubSongs(false),
   displayInsTypeList(false),
   portrait(false),
   injectBackUp(false),
@@ -8811,6 +9091,7 @@ FurnaceGUI::FurnaceGUI():
   notifyWaveChange(false),
   notifySampleChange(false),
   recalcTimestamps(true),
+  recalcTimestampsPartial(false),
   wantScrollListIns(false),
   wantScrollListWave(false),
   wantScrollListSample(false),
@@ -8868,6 +9149,8 @@ FurnaceGUI::FurnaceGUI():
   fmPreviewOPLL(NULL),
   fmPreviewOPZ(NULL),
   fmPreviewOPZInterface(NULL),
+  fmPreviewESFM(NULL),
+  fmPreviewCacheTime(0),
   editString(NULL),
   pendingRawSampleDepth(8),
   pendingRawSampleChannels(1),
@@ -8900,6 +9183,7 @@ FurnaceGUI::FurnaceGUI():
   aboutSin(0),
   aboutHue(0.0f),
   backupTimer(0.0),
+  backupPending(false),
   totalBackupSize(0),
   refreshBackups(true),
   learning(-1),
@@ -9061,6 +9345,7 @@ FurnaceGUI::FurnaceGUI():
   longThreshold(0.48f),
   buttonLongThreshold(0.20f),
   lastAudioLoadsPos(0),
+  lastCountersTime(-1.0),
   latchNote(-1),
   latchIns(-2),
   latchVol(-1),
@@ -9173,6 +9458,9 @@ FurnaceGUI::FurnaceGUI():
   eventTimeEnd(0),
   eventTimeDelta(0),
   nextPresentTime(0),
+  lastPlaybackFrame(0),
+  lastPlaybackOrder(-1),
+  lastPlaybackRow(-1),
   perfMetricsLen(0),
   chanToMove(-1),
   sysToMove(-1),
@@ -9256,6 +9544,7 @@ FurnaceGUI::FurnaceGUI():
   subPortPos(0.0f,0.0f),
   oscTotal(0),
   oscWidth(512),
+  oscValuesLen(512),
   oscValuesAverage(NULL),
   oscZoom(0.5f),
   oscWindowSize(20.0f),
@@ -9285,6 +9574,7 @@ FurnaceGUI::FurnaceGUI():
   chanOscGrad(64,64),
   chanOscGradTex(NULL),
   chanOscWorkPool(NULL),
+  findWorkPool(NULL),
   xyOscPointTex(NULL),
   xyOscOptions(false),
   xyOscXChannel(0),
@@ -9296,9 +9586,7 @@ FurnaceGUI::FurnaceGUI():
   xyOscDecayTime(10.0f),
   xyOscIntensity(2.0f),
   xyOscThickness(2.0f),
-  tunerFFTInBuf(NULL),
-  tunerFFTOutBuf(NULL),
-  tunerPlan(NULL),
+  regViewHeatmap(false),
   fpCueInput(""),
   fpCueInputFailed(false),
   fpCueInputFailReason(""),
@@ -9356,6 +9644,11 @@ FurnaceGUI::FurnaceGUI():
   csExportResult(NULL),
   csExportTarget(false),
   csExportDone(false),
+  resampleThread(NULL),
+  resampleJob(NULL),
+  resampleJobSample(NULL),
+  resampleJobIndex(-1),
+  displayResampling(false),
   audioExportFilterName("???"),
   audioExportFilterExt("*"),
   dmfExportVersion(0),
@@ -9462,6 +9755,7 @@ FurnaceGUI::FurnaceGUI():
   memset(keyHit1,0,sizeof(float)*DIV_MAX_CHANS);
 
   memset(lastAudioLoads,0,sizeof(float)*120);
+  memset(counterRates,0,sizeof(double)*DIV_COUNTER_MAX);
 
   memset(pianoKeyHit,0,sizeof(pianoKeyState)*180); // posiblly repace with a for loop
   memset(pianoKeyPressed,0,sizeof(bool)*180);
@@ -9488,6 +9782,9 @@ FurnaceGUI::FurnaceGUI():
   memset(multiIns,-1,7*sizeof(int));
   memset(multiInsTranspose,0,7*sizeof(int));
 
+  memset(imageLoader,0,GUI_IMAGE_MAX*sizeof(std::thread*));
+  memset(imageLoading,0,GUI_IMAGE_MAX*sizeof(FurnaceGUIImage*));
+
   strncpy(noteOffLabel,"OFF",32);
   strncpy(noteRelLabel,"===",32);
   strncpy(macroRelLabel,"REL",32);
@@ -21,6 +21,7 @@
 #define _FUR_GUI_H
 
 #include "../engine/engine.h"
+#include "../engine/counters.h"
 #include "../engine/workPool.h"
 #include "../engine/waveSynth.h"
 #include "imgui.h"
@@ -40,6 +41,7 @@
 
 #include "fileDialog.h"
 #include "newFilePicker.h"
+#include "sampleSummary.h"
 
 #define FURNACE_APP_ID "org.tildearrow.furnace"
 
@@ -49,7 +51,7 @@
 #define handleUnimportant if (settings.insFocusesPattern && patternOpen) {nextWindow=GUI_WINDOW_PATTERN;}
 #define unimportant(x) if (x) {handleUnimportant}
 
-#define MARK_MODIFIED modified=true;
+#define MARK_MODIFIED modified=true; backupPending=true; e->invalidateSnapshots();
 #define WAKE_UP drawHalt=5;
 
 #define RESET_WAVE_MACRO_ZOOM \
@@ -79,6 +81,7 @@
 #define BIG_FONT_SIZE (MAX(1,40*dpiScale))
 
 #define FM_PREVIEW_SIZE 512
+#define FM_PREVIEW_CACHE_SIZE 16
 
 #define CHECK_HIDDEN_SYSTEM(x) \
   (x==DIV_SYSTEM_YMU759 || x==DIV_SYSTEM_DUMMY || x==DIV_SYSTEM_PONG || x==DIV_SYSTEM_UPD1771C)
@@ -1052,6 +1055,34 @@ struct SelectionPoint {
     xCoarse(0), xFine(0), y(0), order(0) {}
 };
 
+// separates channels in PatternClipboard::cells
+#define PAT_CLIP_SEP -2
+// a cell which could not be decoded
+#define PAT_CLIP_BAD -3
+// the line ended in the middle of a cell. nothing follows in this row.
+#define PAT_CLIP_END -4
+
+// pattern data in the Furnace clipboard format, already decoded.
+// filled directly on copy, so that pasting within the same instance does
+// not have to go through text.
+struct PatternClipboard {
+  // column the data starts at
+  int startOff;
+  // cell values (-1 is empty) and PAT_CLIP_* markers of every row
+  std::vector<short> cells;
+  // offset of every row in cells, plus the end of the last row
+  std::vector<unsigned int> rows;
+
+  void clear();
+  /**
+   * decode clipboard text.
+   * @return false if this is not Furnace pattern data.
+   */
+  bool parse(const String& text);
+  PatternClipboard():
+    startOff(0) {}
+};
+
 struct UndoRegion {
   struct UndoRegionPoint {
     int ord, x, y;
@@ -1109,6 +1140,92 @@ struct UndoPatternData {
     newVal(v2) {}
 };
 
+// a run of changed cells, starting at the specified column and going right.
+struct UndoPatternRun {
+  unsigned short chan, pat, row;
+  unsigned char subSong, col, len;
+  // position of the first old/new value pair
+  unsigned int valPos;
+  UndoPatternRun(unsigned char s, unsigned short c, unsigned short p, unsigned short r, unsigned char co, unsigned int vp):
+    chan(c),
+    pat(p),
+    row(r),
+    subSong(s),
+    col(co),
+    len(0),
+    valPos(vp) {}
+};
+
+/**
+ * the pattern changes of an undo step.
+ * cells changed next to each other in a row are stored as a run, and their values
+ * are packed in a separate array (4 bytes per cell).
+ * cells are iterated in the order they were added.
+ */
+class UndoPatternChanges {
+  std::vector<UndoPatternRun> runs;
+  std::vector<short> vals;
+
+  public:
+    struct iterator {
+      const UndoPatternChanges* parent;
+      size_t run;
+      unsigned char pos;
+      UndoPatternData operator*() const {
+        const UndoPatternRun& r=parent->runs[run];
+        return UndoPatternData(r.subSong,r.chan,r.pat,r.row,r.col+pos,parent->vals[r.valPos+(pos<<1)],parent->vals[r.valPos+(pos<<1)+1]);
+      }
+      iterator& operator++() {
+        if (++pos>=parent->runs[run].len) {
+          run++;
+          pos=0;
+        }
+        return *this;
+      }
+      bool operator!=(const iterator& other) const {
+        return run!=other.run || pos!=other.pos;
+      }
+      iterator(const UndoPatternChanges* p, size_t r):
+        parent(p),
+        run(r),
+        pos(0) {}
+    };
+
+    void push_back(const UndoPatternData& d) {
+      if (runs.empty() ||
+          runs.back().subSong!=d.subSong ||
+          runs.back().chan!=d.chan ||
+          runs.back().pat!=d.pat ||
+          runs.back().row!=d.row ||
+          runs.back().col+runs.back().len!=d.col ||
+          runs.back().len>=255) {
+        runs.push_back(UndoPatternRun(d.subSong,d.chan,d.pat,d.row,d.col,vals.size()));
+      }
+      runs.back().len++;
+      vals.push_back(d.oldVal);
+      vals.push_back(d.newVal);
+    }
+    bool empty() const {
+      return runs.empty();
+    }
+    size_t size() const {
+      return vals.size()>>1;
+    }
+    size_t memUsage() const {
+      return runs.capacity()*sizeof(UndoPatternRun)+vals.capacity()*sizeof(short);
+    }
+    void clear() {
+      runs.clear();
+      vals.clear();
+    }
+    iterator begin() const {
+      return iterator(this,0);
+    }
+    iterator end() const {
+      return iterator(this,runs.size());
+    }
+};
+
 struct UndoOrderData {
   int subSong, chan, ord;
   unsigned char oldVal, newVal;
@@ -1143,9 +1260,13 @@ struct UndoStep {
   int oldOrdersLen, newOrdersLen;
   int oldPatLen, newPatLen;
   std::vector<UndoOrderData> ord;
-  std::vector<UndoPatternData> pat;
+  UndoPatternChanges pat;
   std::vector<UndoOtherData> other;
 
+  size_t memUsage() const {
+    return sizeof(UndoStep)+ord.capacity()*sizeof(UndoOrderData)+pat.memUsage()+other.capacity()*sizeof(UndoOtherData);
+  }
+
   UndoStep():
     type(GUI_UNDO_CHANGE_ORDER),
     oldCursor(),
@@ -1526,6 +1647,65 @@ struct FurnaceGUIQueryResult {
   }
 };
 
+// register view cell cache. cells are only formatted again when their value changes.
+struct FurnaceGUIRegViewCache {
+  int sys, size, depth;
+  std::vector<unsigned short> values;
+  // 5 characters per cell (including the terminator)
+  std::vector<char> text;
+  // when each cell last changed (ImGui time), or -1 if it never did
+  std::vector<double> lastChange;
+  FurnaceGUIRegViewCache():
+    sys(-1),
+    size(0),
+    depth(0) {}
+};
+
+// memory composition waveform cache. the waveform is reduced to one bar per column,
+// and only computed again when the memory contents or the width change.
+struct FurnaceGUIMemoryWaveCache {
+  std::vector<unsigned char> shadow;
+  std::vector<float> columns;
+  int view;
+  float width;
+  FurnaceGUIMemoryWaveCache():
+    view(-1),
+    width(0.0f) {}
+};
+
+// Hann-windowed FFT of the master output, shared by the spectrum and tuner windows.
+// only computed again when the audio has advanced since the last request.
+struct FurnaceGUIOutputFFT {
+  // source is an output channel, or -1 for all outputs mixed down to mono
+  int size, source;
+  int needle, chans;
+  // ImGui frame in which this was last requested
+  int lastUse;
+  double* in;
+  fftw_complex* out;
+  fftw_plan plan;
+  std::vector<double> window;
+  // magnitude of every bin below Nyquist (size/2 entries)
+  std::vector<double> mag;
+  FurnaceGUIOutputFFT(int s, int src);
+  ~FurnaceGUIOutputFFT();
+};
+
+// FM preview render for a set of instrument parameters, along with the state
+// of the chip right after it, so that the preview can continue from there.
+// this lets dragging a slider back and forth reuse previous renders.
+struct FurnaceGUIFMPreviewCache {
+  DivInstrumentType type;
+  DivInstrumentFM fm;
+  DivInstrumentESFM esfm;
+  short wave[FM_PREVIEW_SIZE];
+  std::vector<unsigned char> state;
+  unsigned int lastUsed;
+  FurnaceGUIFMPreviewCache():
+    type(DIV_INS_FM),
+    lastUsed(0) {}
+};
+
 struct FurnaceGUIWaveSizeEntry {
   short width, height;
   const char* sys;
@@ -1647,6 +1827,13 @@ class FurnaceGUIRender {
     virtual ~FurnaceGUIRender();
 };
 
+// vertices of a pattern row in one channel, relative to the position of the row.
+// rows with the same text, colors and layout look the same, so they share an entry.
+struct PatternRowCacheEntry {
+  std::vector<ImDrawVert> vtx;
+  std::vector<ImDrawIdx> idx;
+};
+
 struct PendingDrawOsc {
   void* gui;
   float* data;
@@ -1712,6 +1899,7 @@ class FurnaceGUI {
   FurnaceGUITexture* sampleTex;
   int sampleTexW, sampleTexH;
   bool updateSampleTex;
+  FurnaceSampleSummary sampleSummary;
 
   FurnaceGUITexture* csTex;
 
@@ -1719,6 +1907,9 @@ class FurnaceGUI {
   String workingDirSong, workingDirIns, workingDirWave, workingDirSample, workingDirAudioExport;
   String workingDirVGMExport, workingDirROMExport;
   String workingDirFont, workingDirColors, workingDirKeybinds;
+  // last pattern data copied from this instance, and its text
+  PatternClipboard clipboardPat;
+  String clipboardPatText;
   String workingDirLayout, workingDirROM, workingDirMusic, workingDirTest;
   String workingDirConfig;
   String mmlString[32];
@@ -1726,7 +1917,14 @@ class FurnaceGUI {
   String mmlStringSNES[DIV_MAX_CHIPS];
   String folderString;
 
-  struct PaletteSearchResult { int id; std::vector<int> highlightChars; };
+  struct PaletteSearchResult { int id, cand; std::vector<int> highlightChars; };
+  // command palette candidates, built when the palette opens.
+  // mask has a bit set for every character class present in the name.
+  struct PaletteCandidate { int id; String name; uint64_t mask; };
+  std::vector<PaletteCandidate> paletteCandidates;
+  // indices of the candidates which matched the last query
+  std::vector<int> paletteMatched;
+  String paletteLastQuery;
   std::vector<DivSystem> sysSearchResults;
   std::vector<std::pair<DivSample*,bool>> sampleBankSearchResults;
   std::vector<FurnaceGUISysDef> newSongSearchResults;
@@ -1738,13 +1936,15 @@ class FurnaceGUI {
   std::vector<String> availAudioDrivers;
 
   bool quit, warnQuit, willCommit, edit, editClone, isPatUnique, modified, displayError, displayExporting, vgmExportLoop, vgmExportPatternHints, vgmExportDPCM07;
-  bool vgmExportDirectStream, displayInsTypeList, displayWaveSizeList;
+  bool vgmExportDirectStream, vgmExportDedupeWrites, vgmExportPackSamples, vgmExportAllSubSongs, displayInsTypeList, displayWaveSizeList;
   bool portrait, injectBackUp, mobileMenuOpen, warnColorPushed;
   bool wantCaptureKeyboard, oldWantCaptureKeyboard, displayMacroMenu;
   bool displayNew, displayExport, displayPalette, fullScreen, sysFullScreen, preserveChanPos, sysDupCloneChannels, sysDupEnd;
   unsigned char noteInputMode;
   bool notifyWaveChange, notifySampleChange;
   bool recalcTimestamps;
+  // set after editing speed effects. only the affected part of the song is recalculated.
+  bool recalcTimestampsPartial;
   bool wantScrollListIns, wantScrollListWave, wantScrollListSample;
   bool displayPendingIns, pendingInsSingle, displayPendingRawSample, snesFilterHex, modTableHex, displayEditString;
   bool displayPendingSamples, replacePendingSample;
@@ -1790,6 +1990,8 @@ class FurnaceGUI {
   void* fmPreviewOPZ;
   void* fmPreviewOPZInterface;
   void* fmPreviewESFM;
+  std::vector<FurnaceGUIFMPreviewCache> fmPreviewCache;
+  unsigned int fmPreviewCacheTime;
   String* editString;
   SDL_Event userEvent;
 
@@ -1817,6 +2019,8 @@ class FurnaceGUI {
   float aboutHue;
 
   std::atomic<double> backupTimer;
+  // whether the song changed since the last backup was started
+  bool backupPending;
   std::future<bool> backupTask;
   std::mutex backupLock;
   String backupPath;
@@ -1867,6 +2071,7 @@ class FurnaceGUI {
     int audioQuality;
     int audioHiPass;
     int audioChans;
+    int jackChipOutputs;
     int arcadeCore;
     int ym2612Core;
     int snCore;
@@ -1982,8 +2187,14 @@ class FurnaceGUI {
     int oplStandardWaveNames;
     int cursorMoveNoScroll;
     int lowLatency;
+    int renderAhead;
+    int renderAheadRollback;
+    int loadGovernor;
+    int cachedInsPreview;
+    int fastSeek;
     int notePreviewBehavior;
     int powerSave;
+    int playbackFrameRate;
     int absorbInsInput;
     int eventDelay;
     int moveWindowTitle;
@@ -2008,6 +2219,7 @@ class FurnaceGUI {
     int saveWindowPos;
     int clampSamples;
     int saveUnusedPatterns;
+    int deltaSamples;
     int channelColors;
     int channelTextColors;
     int channelStyle;
@@ -2034,6 +2246,9 @@ class FurnaceGUI {
     int iCannotWait;
     int orderButtonPos;
     int compress;
+    int parallelCompress;
+    int compressLevel;
+    int backgroundSampleLoad;
     int renderClearPos;
     int insertBehavior;
     int pullDeleteRow;
@@ -2053,6 +2268,12 @@ class FurnaceGUI {
     int wasapiEx;
     int chanOscThreads;
     int renderPoolThreads;
+    int renderTickDecoupled;
+    int renderPoolPriority;
+    int renderPoolPinCores;
+    int parallelChanTick;
+    int skipIdleChips;
+    int polyphaseResampler;
     int writeInsNames;
     int readInsNames;
     int fontBackend;
@@ -2087,6 +2308,7 @@ class FurnaceGUI {
     int backgroundPlay;
     int noMaximizeWorkaround;
     unsigned int maxUndoSteps;
+    int maxUndoMemory;
     float vibrationStrength;
     int vibrationLength;
     int s3mOPL3;
@@ -2125,6 +2347,7 @@ class FurnaceGUI {
       audioQuality(0),
       audioHiPass(1),
       audioChans(2),
+      jackChipOutputs(0),
       arcadeCore(0),
       ym2612Core(0),
       snCore(0),
@@ -2238,8 +2461,14 @@ class FurnaceGUI {
       oplStandardWaveNames(0),
       cursorMoveNoScroll(0),
       lowLatency(0),
+      renderAhead(0),
+      renderAheadRollback(1),
+      loadGovernor(0),
+      cachedInsPreview(1),
+      fastSeek(0),
       notePreviewBehavior(1),
       powerSave(1),
+      playbackFrameRate(0),
       absorbInsInput(0),
       eventDelay(0),
       moveWindowTitle(1),
@@ -2263,6 +2492,7 @@ class FurnaceGUI {
       noThreadedInput(0),
       clampSamples(0),
       saveUnusedPatterns(0),
+      deltaSamples(0),
       channelColors(1),
       channelTextColors(0),
       channelStyle(1),
@@ -2289,6 +2519,9 @@ class FurnaceGUI {
       iCannotWait(0),
       orderButtonPos(2),
       compress(1),
+      parallelCompress(0),
+      compressLevel(6),
+      backgroundSampleLoad(1),
       renderClearPos(0),
       insertBehavior(1),
       pullDeleteRow(1),
@@ -2308,6 +2541,12 @@ class FurnaceGUI {
       wasapiEx(0),
       chanOscThreads(0),
       renderPoolThreads(0),
+      renderTickDecoupled(0),
+      renderPoolPriority(0),
+      renderPoolPinCores(0),
+      parallelChanTick(0),
+      skipIdleChips(0),
+      polyphaseResampler(0),
       writeInsNames(0),
       readInsNames(1),
       fontBackend(1),
@@ -2342,6 +2581,7 @@ class FurnaceGUI {
       backgroundPlay(0),
       noMaximizeWorkaround(0),
       maxUndoSteps(100),
+      maxUndoMemory(256),
       vibrationStrength(0.5f),
       vibrationLength(20),
       s3mOPL3(1),
@@ -2457,7 +2697,10 @@ class FurnaceGUI {
   std::atomic<FurnaceGUIWindows> curWindowThreadSafe;
   std::atomic<bool> failedNoteOn;
   float peak[DIV_MAX_OUTPUTS];
+  // copy of the engine's visualization state, taken by readOsc()
+  DivVizState vizState;
   float patChanX[DIV_MAX_CHANS+1];
+  std::unordered_map<uint64_t,PatternRowCacheEntry> patRowCache;
   float patChanSlideY[DIV_MAX_CHANS+1];
   float lastPatternWidth, longThreshold;
   float buttonLongThreshold;
@@ -2467,6 +2710,11 @@ class FurnaceGUI {
   float lastAudioLoads[120];
   int lastAudioLoadsPos;
 
+  // event counters (see updateCounterRates())
+  DivCounters lastCounters, debugCountersBase;
+  double lastCountersTime;
+  double counterRates[DIV_COUNTER_MAX];
+
   OperationMask opMaskDelete, opMaskPullDelete, opMaskInsert, opMaskPaste, opMaskTransposeNote, opMaskTransposeValue;
   OperationMask opMaskInterpolate, opMaskFade, opMaskInvertVal, opMaskScale;
   OperationMask opMaskRandomize, opMaskFlip, opMaskCollapseExpand;
@@ -2620,6 +2868,9 @@ class FurnaceGUI {
   uint64_t swapTimeBegin, swapTimeEnd, swapTimeDelta;
   uint64_t eventTimeBegin, eventTimeEnd, eventTimeDelta;
   uint64_t nextPresentTime;
+  // frame pacing during playback (see waitPlaybackFrame())
+  uint64_t lastPlaybackFrame;
+  int lastPlaybackOrder, lastPlaybackRow;
 
   FurnaceGUIPerfMetric perfMetrics[64];
   int perfMetricsLen;
@@ -2628,6 +2879,9 @@ class FurnaceGUI {
   int perfMetricsLastLen;
 
   std::map<FurnaceGUIImages,FurnaceGUIImage*> images;
+  // images being decoded in the background (see preloadImages())
+  std::thread* imageLoader[GUI_IMAGE_MAX];
+  FurnaceGUIImage* imageLoading[GUI_IMAGE_MAX];
 
   int chanToMove, sysToMove, sysToDelete, opToMove;
   int assetToMove, dirToMove;
@@ -2698,6 +2952,9 @@ class FurnaceGUI {
 
   // oscilloscope
   int oscTotal, oscWidth;
+  // number of values in oscValues (including 12 values of padding on each side).
+  // this is less than oscWidth when raw samples are drawn by the shader.
+  int oscValuesLen;
   float* oscValues[DIV_MAX_OUTPUTS];
   float* oscValuesAverage;
   float oscZoom;
@@ -2715,6 +2972,7 @@ class FurnaceGUI {
   Gradient2D chanOscGrad;
   FurnaceGUITexture* chanOscGradTex;
   DivWorkPool* chanOscWorkPool;
+  DivWorkPool* findWorkPool;
   float chanOscLP0[DIV_MAX_CHANS];
   float chanOscLP1[DIV_MAX_CHANS];
   float chanOscVol[DIV_MAX_CHANS];
@@ -2729,10 +2987,15 @@ class FurnaceGUI {
     size_t inBufPos;
     double inBufPosFrac;
     double waveLen;
+    // period found by the last FFT (in FFT bins)
+    double periodLen;
     int waveLenBottom, waveLenTop, relatedCh;
+    // channel state when the pitch was last seen changing
+    int lastNote, lastPitch, lastIns;
     float pitch, windowSize, phaseOff, debugPhase, dcOff;
     unsigned short needle;
-    bool ready, loudEnough, waveCorr;
+    unsigned char stableFrames, framesSinceFFT;
+    bool ready, loudEnough, waveCorr, periodValid, reusePeriod;
     fftw_plan plan;
     fftw_plan planI;
     PendingDrawOsc drawOp;
@@ -2745,18 +3008,26 @@ class FurnaceGUI {
       inBufPos(0),
       inBufPosFrac(0.0f),
       waveLen(0.0),
+      periodLen(0.0),
       waveLenBottom(0),
       waveLenTop(0),
       relatedCh(0),
+      lastNote(-1),
+      lastPitch(0),
+      lastIns(-1),
       pitch(0.0f),
       windowSize(1.0f),
       phaseOff(0.0f),
       debugPhase(0.0f),
       dcOff(0.0f),
       needle(0),
+      stableFrames(0),
+      framesSinceFFT(0),
       ready(false),
       loudEnough(false),
       waveCorr(false),
+      periodValid(false),
+      reusePeriod(false),
       plan(NULL),
       planI(NULL) {}
   } chanOscChan[DIV_MAX_CHANS];
@@ -2774,17 +3045,18 @@ class FurnaceGUI {
   float xyOscIntensity;
   float xyOscThickness;
 
+  // register view and memory composition
+  bool regViewHeatmap;
+  FurnaceGUIRegViewCache regViewCache[DIV_MAX_CHIPS];
+  std::vector<DivRegPoolSnapshot> regViewSnap;
+  FurnaceGUIMemoryWaveCache memWaveCache[DIV_MAX_CHIPS][4];
+
   // spectrum and tuner
-  double* tunerFFTInBuf;
-  fftw_complex* tunerFFTOutBuf;
-  fftw_plan tunerPlan;
+  std::vector<FurnaceGUIOutputFFT*> outputFFT;
   struct SpectrumSettings {
     int bins;
     float xZoom, xOffset;
     float yOffset;
-    fftw_plan plan[DIV_MAX_OUTPUTS];
-    double* in[DIV_MAX_OUTPUTS];
-    fftw_complex* buffer[DIV_MAX_OUTPUTS];
     ImVec2* plot[DIV_MAX_OUTPUTS];
     std::vector<int> frequencies;
     bool update, running, mono;
@@ -2802,9 +3074,6 @@ class FurnaceGUI {
       showYGrid(true),
       showXScale(true),
       showYScale(true) {
-        memset(plan,0,DIV_MAX_OUTPUTS*sizeof(fftw_plan*));
-        memset(in,0,DIV_MAX_OUTPUTS*sizeof(double*));
-        memset(buffer,0,DIV_MAX_OUTPUTS*sizeof(fftw_complex*));
         memset(plot,0,DIV_MAX_OUTPUTS*sizeof(ImVec2*));
       }
   } spectrum;
@@ -2915,6 +3184,13 @@ class FurnaceGUI {
   bool csExportTarget, csExportDone;
   String csExportPath;
 
+  // background resampling
+  std::thread* resampleThread;
+  DivSampleResampleJob* resampleJob;
+  DivSample* resampleJobSample;
+  int resampleJobIndex;
+  bool displayResampling;
+
   // export options
   DivAudioExportOptions audioExportOptions;
   String audioExportFilterName, audioExportFilterExt;
@@ -2952,6 +3228,8 @@ class FurnaceGUI {
   void drawWaveform(unsigned char type, bool opz, const ImVec2& size);
   void drawWaveformSID3(unsigned char type, const ImVec2& size);
   void drawAlgorithm(unsigned char alg, FurnaceGUIFMAlgs algType, const ImVec2& size);
+  bool makeFilePreview(const String& path, FilePickerPreview& p);
+  void drawFilePreview(const FilePickerPreview& p);
   void drawESFMAlgorithm(DivInstrumentESFM& esfm, const ImVec2& size);
   void drawFMEnv(unsigned char tl, unsigned char ar, unsigned char dr, unsigned char d2r, unsigned char rr, unsigned char sl, unsigned char sus, unsigned char egt, unsigned char algOrGlobalSus, float maxTl, float maxArDr, float maxRr, const ImVec2& size, unsigned short instType);
   void drawSID3Env(unsigned char tl, unsigned char ar, unsigned char dr, unsigned char d2r, unsigned char rr, unsigned char sl, unsigned char sus, unsigned char egt, unsigned char algOrGlobalSus, float maxTl, float maxArDr, float maxRr, const ImVec2& size, unsigned short instType);
@@ -3037,6 +3315,9 @@ class FurnaceGUI {
 
   void drawOrderButtons();
 
+  // magnitudes of a shared FFT of the master output. see FurnaceGUIOutputFFT.
+  const double* getOutputFFT(int size, int source);
+
   void actualWaveList();
   void actualSampleList();
 
@@ -3056,6 +3337,10 @@ class FurnaceGUI {
   void popToggleColors();
 
   FurnaceGUIImage* getImage(FurnaceGUIImages image);
+  // decode the intro images on other threads while the GUI starts up
+  void preloadImages();
+  // free the pixels of an image. getTexture() decodes it again if needed.
+  void freeImageData(FurnaceGUIImages image);
   FurnaceGUITexture* getTexture(FurnaceGUIImages image, FurnaceGUIBlendMode blendMode=GUI_BLEND_MODE_BLEND);
   void drawImage(ImDrawList* dl, FurnaceGUIImages image, const ImVec2& pos, const ImVec2& scale, double rotate, const ImVec2& uvMin, const ImVec2& uvMax, const ImVec4& imgColor);
 
@@ -3080,6 +3365,7 @@ class FurnaceGUI {
   void drawChanOsc();
   void drawVolMeter();
   void drawStats();
+  void updateCounterRates();
   void drawMemory();
   void drawCompatFlags();
   void drawPiano();
@@ -3169,7 +3455,7 @@ class FurnaceGUI {
   void moveSelected(int x, int y);
   void doTranspose(int amount, OperationMask& mask);
   String doCopy(bool cut, bool writeClipboard, const SelectionPoint& sStart, const SelectionPoint& sEnd);
-  void doPasteFurnace(PasteMode mode, int arg, bool readClipboard, String clipb, std::vector<String> data, int startOff, bool invalidData, UndoRegion ur);
+  void doPasteFurnace(PasteMode mode, int arg, bool readClipboard, const PatternClipboard& clip, UndoRegion ur);
   void doPasteMPT(PasteMode mode, int arg, bool readClipboard, String clipb, std::vector<String> data, int mptFormat, UndoRegion ur);
   void doPaste(PasteMode mode=GUI_PASTE_MODE_NORMAL, int arg=0, bool readClipboard=true, String clipb="");
   void doChangeIns(int ins);
@@ -3184,6 +3470,8 @@ class FurnaceGUI {
   void doCollapseSong(int divider);
   void doExpandSong(int multiplier);
   void doAbsorbInstrument();
+  void invalidateUndoSnapshots(UndoStep& us);
+  void trimUndoHistory();
   void doUndo();
   void doRedo();
   void doFind();
@@ -3234,6 +3522,8 @@ class FurnaceGUI {
   void pushRecentSys(const char* path);
   void exportAudio(String path, DivAudioExportModes mode);
   void exportCmdStream(bool target, String path);
+  bool startResample(DivSample* sample, double sRate, double tRate, int filter);
+  void finishResample();
   void delFirstBackup(String name);
 
   bool parseSysEx(unsigned char* data, size_t len);
@@ -3259,7 +3549,9 @@ class FurnaceGUI {
   bool initRender();
   bool quitRender();
 
-  ImFont* addFontZlib(const void* data, size_t len, float size_pixels, const ImFontConfig* font_cfg=NULL, const ImWchar* glyph_ranges=NULL);
+  FurnaceGUIUncompFont* getUncompFont(const void* data, size_t len);
+  // lazy: for merged fonts. only decompress once a glyph is requested from it
+  ImFont* addFontZlib(const void* data, size_t len, float size_pixels, const ImFontConfig* font_cfg=NULL, const ImWchar* glyph_ranges=NULL, bool lazy=false);
 
   const char* getSystemName(DivSystem which);
   const char* getSystemPartNumber(DivSystem sys, DivConfig& flags);
@@ -3289,6 +3581,9 @@ class FurnaceGUI {
     void runPendingDrawOsc(PendingDrawOsc* which);
     bool detectOutOfBoundsWindow(SDL_Rect& failing);
     int processEvent(SDL_Event* ev);
+    // wait until the row changes, there's input or it's time for the next frame.
+    // used during playback when the playback frame rate is limited.
+    void waitPlaybackFrame();
     bool loop();
     bool finish(bool saveConfig=false);
     bool init();
@@ -56,11 +56,70 @@ const unsigned int imageLen[GUI_IMAGE_MAX]={
 #endif
 };
 
+// decode an image and convert it to the given texture format.
+// this may run on another thread.
+static bool decodeImage(FurnaceGUIImages image, FurnaceGUIImage* ret, FurnaceGUITextureFormat format) {
+  ret->data=stbi_load_from_memory(imageData[image],imageLen[image],&ret->width,&ret->height,&ret->ch,STBI_rgb_alpha);
+  if (ret->data==NULL) return false;
+
+#ifdef TA_BIG_ENDIAN
+  if (ret->ch==4) {
+    size_t total=ret->width*ret->height*ret->ch;
+    for (size_t i=0; i<total; i+=4) {
+      ret->data[i]^=ret->data[i|3];
+      ret->data[i|3]^=ret->data[i];
+      ret->data[i]^=ret->data[i|3];
+      ret->data[i|1]^=ret->data[i|2];
+      ret->data[i|2]^=ret->data[i|1];
+      ret->data[i|1]^=ret->data[i|2];
+    }
+  }
+#endif
+
+  if (ret->ch==4) {
+    size_t total=ret->width*ret->height*ret->ch;
+    switch (format) {
+      case GUI_TEXFORMAT_ARGB32:
+        for (size_t i=0; i<total; i+=4) {
+          ret->data[i]^=ret->data[i|2];
+          ret->data[i|2]^=ret->data[i];
+          ret->data[i]^=ret->data[i|2];
+        }
+        break;
+      case GUI_TEXFORMAT_BGRA32:
+        for (size_t i=0; i<total; i+=4) {
+          ret->data[i]^=ret->data[i|3];
+          ret->data[i|3]^=ret->data[i];
+          ret->data[i]^=ret->data[i|3];
+          ret->data[i|1]^=ret->data[i|2];
+          ret->data[i|2]^=ret->data[i|1];
+          ret->data[i|1]^=ret->data[i|2];
+          ret->data[i|1]^=ret->data[i|3];
+          ret->data[i|3]^=ret->data[i|1];
+          ret->data[i|1]^=ret->data[i|3];
+        }
+        break;
+      case GUI_TEXFORMAT_RGBA32:
+        for (size_t i=0; i<total; i+=4) {
+          ret->data[i]^=ret->data[i|3];
+          ret->data[i|3]^=ret->data[i];
+          ret->data[i]^=ret->data[i|3];
+          ret->data[i|1]^=ret->data[i|2];
+          ret->data[i|2]^=ret->data[i|1];
+          ret->data[i|1]^=ret->data[i|2];
+        }
+        break;
+      default:
+        break;
+    }
+  }
+  return true;
+}
+
 FurnaceGUITexture* FurnaceGUI::getTexture(FurnaceGUIImages image, FurnaceGUIBlendMode blendMode) {
   FurnaceGUIImage* img=getImage(image);
 
   if (img==NULL) return NULL;
-  if (img->data==NULL) return NULL;
   if (img->width<=0 || img->height<=0) return NULL;
 
   bool createTex=false;
@@ -76,6 +135,15 @@ FurnaceGUITexture* FurnaceGUI::getTexture(FurnaceGUIImages image, FurnaceGUIBlen
   }
 
   if (createTex) {
+    // the pixels are freed after upload, so they are decoded again if the texture was lost
+    if (img->data==NULL) {
+      logV("decoding image %d again.",(int)image);
+      if (!decodeImage(image,img,bestTexFormat)) {
+        logE("could not load image %d!",(int)image);
+        return NULL;
+      }
+    }
+
     img->tex=rend->createTexture(false,img->width,img->height,true,bestTexFormat);
     if (img->tex==NULL) {
       logE("error while creating image %d texture! %s",(int)image,SDL_GetError());
@@ -86,81 +154,73 @@ FurnaceGUITexture* FurnaceGUI::getTexture(FurnaceGUIImages image, FurnaceGUIBlen
     if (!rend->updateTexture(img->tex,img->data,img->width*4)) {
       logE("error while updating texture of image %d! %s",(int)image,SDL_GetError());
     }
+    freeImageData(image);
   }
 
   return img->tex;
 }
 
+void FurnaceGUI::preloadImages() {
+  for (int i=0; i<GUI_IMAGE_MAX; i++) {
+    if (i==GUI_IMAGE_ICON) continue;
+    if (imageData[i]==NULL) continue;
+    if (imageLoader[i]!=NULL) continue;
+    if (images.find((FurnaceGUIImages)i)!=images.cend()) continue;
+
+    FurnaceGUIImage* img=new FurnaceGUIImage;
+    FurnaceGUITextureFormat format=bestTexFormat;
+    try {
+      imageLoader[i]=new std::thread([i,img,format]() {
+        decodeImage((FurnaceGUIImages)i,img,format);
+      });
+      imageLoading[i]=img;
+    } catch (std::system_error& e) {
+      // it'll be decoded when used
+      logW("could not start image loader thread! %s",e.what());
+      delete img;
+    }
+  }
+}
+
+void FurnaceGUI::freeImageData(FurnaceGUIImages image) {
+  auto retPos=images.find(image);
+  if (retPos==images.cend()) return;
+  if (retPos->second->data==NULL) return;
+  stbi_image_free(retPos->second->data);
+  retPos->second->data=NULL;
+}
+
 FurnaceGUIImage* FurnaceGUI::getImage(FurnaceGUIImages image) {
   FurnaceGUIImage* ret=NULL;
   auto retPos=images.find(image);
   if (retPos!=images.cend()) {
     ret=retPos->second;
+  } else if (imageLoader[image]!=NULL) {
+    // decoded (or being decoded) by preloadImages()
+    imageLoader[image]->join();
+    delete imageLoader[image];
+    imageLoader[image]=NULL;
+    ret=imageLoading[image];
+    imageLoading[image]=NULL;
+
+    if (ret->data==NULL) {
+      logE("could not load image %d!",(int)image);
+      delete ret;
+      return NULL;
+    }
+    logV("image %d: %dx%d (preloaded)",(int)image,ret->width,ret->height);
+    images[image]=ret;
   } else {
     ret=new FurnaceGUIImage;
     logV("loading image %d to pool.",(int)image);
-    ret->data=stbi_load_from_memory(imageData[image],imageLen[image],&ret->width,&ret->height,&ret->ch,STBI_rgb_alpha);
 
-    if (ret->data==NULL) {
+    if (!decodeImage(image,ret,bestTexFormat)) {
       logE("could not load image %d!",(int)image);
       delete ret;
       return NULL;
     }
 
     logV("%dx%d",ret->width,ret->height);
-
-#ifdef TA_BIG_ENDIAN
-    if (ret->ch==4) {
-      size_t total=ret->width*ret->height*ret->ch;
-      for (size_t i=0; i<total; i+=4) {
-        ret->data[i]^=ret->data[i|3];
-        ret->data[i|3]^=ret->data[i];
-        ret->data[i]^=ret->data[i|3];
-        ret->data[i|1]^=ret->data[i|2];
-        ret->data[i|2]^=ret->data[i|1];
-        ret->data[i|1]^=ret->data[i|2];
-      }
-    }
-#endif
-
-    if (ret->ch==4) {
-      size_t total=ret->width*ret->height*ret->ch;
-      switch (bestTexFormat) {
-        case GUI_TEXFORMAT_ARGB32:
-          for (size_t i=0; i<total; i+=4) {
-            ret->data[i]^=ret->data[i|2];
-            ret->data[i|2]^=ret->data[i];
-            ret->data[i]^=ret->data[i|2];
-          }
-          break;
-        case GUI_TEXFORMAT_BGRA32:
-          for (size_t i=0; i<total; i+=4) {
-            ret->data[i]^=ret->data[i|3];
-            ret->data[i|3]^=ret->data[i];
-            ret->data[i]^=ret->data[i|3];
-            ret->data[i|1]^=ret->data[i|2];
-            ret->data[i|2]^=ret->data[i|1];
-            ret->data[i|1]^=ret->data[i|2];
-            ret->data[i|1]^=ret->data[i|3];
-            ret->data[i|3]^=ret->data[i|1];
-            ret->data[i|1]^=ret->data[i|3];
-          }
-          break;
-        case GUI_TEXFORMAT_RGBA32:
-          for (size_t i=0; i<total; i+=4) {
-            ret->data[i]^=ret->data[i|3];
-            ret->data[i|3]^=ret->data[i];
-            ret->data[i]^=ret->data[i|3];
-            ret->data[i|1]^=ret->data[i|2];
-            ret->data[i|2]^=ret->data[i|1];
-            ret->data[i|1]^=ret->data[i|2];
-          }
-          break;
-        default:
-          break;
-      }
-    }
-
     images[image]=ret;
   }
 
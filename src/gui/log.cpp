@@ -71,6 +71,7 @@ void FurnaceGUI::drawLog() {
       ImGui::TableNextColumn();
       ImGui::TextUnformatted(_("message"));
 
+      logEntriesLock.lock();
       int pos=logPosition;
       for (int i=0; i<TA_LOG_SIZE; i++) {
         const LogEntry& logEntry=logEntries[(pos+i)&(TA_LOG_SIZE-1)];
@@ -84,6 +85,7 @@ void FurnaceGUI::drawLog() {
         ImGui::TableNextColumn();
         ImGui::TextWrapped("%s",logEntry.text.c_str());
       }
+      logEntriesLock.unlock();
       ImGui::PopFont();
 
       if (followLog) {
@@ -25,6 +25,43 @@
 #define CENTER_TEXT(text) \
   ImGui::SetCursorPosX(ImGui::GetCursorPosX()+0.5*(ImGui::GetContentRegionAvail().x-ImGui::CalcTextSize(text).x));
 
+// reduce the waveform view to the tallest bar of each pixel column.
+// this is only done again when the memory contents or the width change.
+static void updateMemoryWaveCache(FurnaceGUIMemoryWaveCache& cache, const DivMemoryComposition* mc, float width) {
+  const size_t capacity=mc->capacity;
+  if (cache.view==(int)mc->waveformView && cache.width==width && cache.shadow.size()==capacity) {
+    if (capacity==0 || memcmp(cache.shadow.data(),mc->memory,capacity)==0) return;
+  }
+  cache.view=mc->waveformView;
+  cache.width=width;
+  cache.shadow.assign(mc->memory,mc->memory+capacity);
+
+  const bool nibbles=(mc->waveformView==DIV_MEMORY_WAVE_4BIT);
+  const size_t items=nibbles?(capacity<<1):capacity;
+  int columns=(int)width;
+  if (columns<1) columns=1;
+  if ((size_t)columns>items) columns=items;
+  cache.columns.assign(columns,0.0f);
+  if (items==0) return;
+
+  for (size_t k=0; k<items; k++) {
+    float height;
+    if (nibbles) {
+      unsigned char nibble=mc->memory[k>>1];
+      if (k&1) {
+        nibble>>=4;
+      } else {
+        nibble&=15;
+      }
+      height=(float)(nibble+1)/16.0f;
+    } else {
+      height=(float)((signed char)mc->memory[k]+129)/256.0f;
+    }
+    size_t col=(k*columns)/items;
+    if (cache.columns[col]<height) cache.columns[col]=height;
+  }
+}
+
 void FurnaceGUI::drawMemory() {
   if (nextWindow==GUI_WINDOW_MEMORY) {
     memoryOpen=true;
@@ -97,32 +134,16 @@ void FurnaceGUI::drawMemory() {
             kIndex++;
           }
 
-          if (mc->memory!=NULL) {
-            switch (mc->waveformView) {
-              case DIV_MEMORY_WAVE_4BIT:
-                for (int k=0; k<(int)(mc->capacity<<1); k++) {
-                  unsigned char nibble=mc->memory[k>>1];
-                  if (k&1) {
-                    nibble>>=4;
-                  } else {
-                    nibble&=15;
-                  }
-
-                  ImVec2 pos1=ImLerp(dataRect.Min,dataRect.Max,ImVec2((double)k/(double)(mc->capacity<<1),1.0f-((float)(nibble+1)/16.0f)));
-                  ImVec2 pos2=ImLerp(dataRect.Min,dataRect.Max,ImVec2((double)(k+1)/(double)(mc->capacity<<1),1.0f));
-                  dl->AddRectFilled(pos1,pos2,ImGui::GetColorU32(uiColors[GUI_COLOR_MEMORY_DATA]));
-                }
-                break;
-              case DIV_MEMORY_WAVE_8BIT_SIGNED:
-                for (int k=0; k<(int)mc->capacity; k++) {
-                  signed char val=(signed char)mc->memory[k];
-                  ImVec2 pos1=ImLerp(dataRect.Min,dataRect.Max,ImVec2((double)k/(double)(mc->capacity),1.0f-((float)(val+129)/256.0f)));
-                  ImVec2 pos2=ImLerp(dataRect.Min,dataRect.Max,ImVec2((double)(k+1)/(double)(mc->capacity),1.0f));
-                  dl->AddRectFilled(pos1,pos2,ImGui::GetColorU32(uiColors[GUI_COLOR_MEMORY_DATA]));
-                }
-                break;
-              default:
-                break;
+          if (mc->memory!=NULL && mc->waveformView!=DIV_MEMORY_WAVE_NONE) {
+            FurnaceGUIMemoryWaveCache& cache=memWaveCache[i][j];
+            updateMemoryWaveCache(cache,mc,dataRect.GetWidth());
+            const ImU32 dataColor=ImGui::GetColorU32(uiColors[GUI_COLOR_MEMORY_DATA]);
+            const int columns=cache.columns.size();
+            for (int k=0; k<columns; k++) {
+              if (cache.columns[k]<=0.0f) continue;
+              ImVec2 pos1=ImLerp(dataRect.Min,dataRect.Max,ImVec2((float)k/(float)columns,1.0f-cache.columns[k]));
+              ImVec2 pos2=ImLerp(dataRect.Min,dataRect.Max,ImVec2((float)(k+1)/(float)columns,1.0f));
+              dl->AddRectFilled(pos1,pos2,dataColor);
             }
           }
 
@@ -167,6 +188,43 @@ void FurnaceGUI::drawMemory() {
             }
           }
         }
+
+        // memory taken by samples which are also present with the same data
+        if (!e->areSamplesLoading()) {
+          size_t wasted=0;
+          int wastedCount=0;
+          std::vector<bool> present(e->song.sampleLen,false);
+          for (const DivMemoryEntry& k: mc->entries) {
+            if (k.type!=DIV_MEMORY_SAMPLE && (k.type<DIV_MEMORY_BANK0 || k.type>DIV_MEMORY_BANK7)) continue;
+            if (k.asset<0 || k.asset>=e->song.sampleLen || k.end<=k.begin) continue;
+            present[k.asset]=true;
+          }
+          for (const DivMemoryEntry& k: mc->entries) {
+            if (k.type!=DIV_MEMORY_SAMPLE && (k.type<DIV_MEMORY_BANK0 || k.type>DIV_MEMORY_BANK7)) continue;
+            int twin=e->getSampleTwin(k.asset);
+            if (twin<0 || twin>=e->song.sampleLen || !present[twin]) continue;
+            wasted+=k.end-k.begin;
+            wastedCount++;
+          }
+          if (wastedCount>0) {
+            if (wasted>=1024 && settings.memUsageUnit==1) {
+              ImGui::TextWrapped(_("%d duplicate samples (%dK). use \"Merge duplicate samples\" to remove them."),wastedCount,(int)(wasted>>10));
+            } else {
+              ImGui::TextWrapped(_("%d duplicate samples (%d bytes). use \"Merge duplicate samples\" to remove them."),wastedCount,(int)wasted);
+            }
+          }
+        }
+      }
+    }
+
+    if (have && e->song.sampleLen>0) {
+      // sample data held by Furnace itself (every format of every sample)
+      size_t bufSize=e->getSampleBufferSize();
+      ImGui::Separator();
+      if (bufSize>=1024 && settings.memUsageUnit==1) {
+        ImGui::Text(_("sample data in all formats: %dK"),(int)(bufSize>>10));
+      } else {
+        ImGui::Text(_("sample data in all formats: %d bytes"),(int)bufSize);
       }
     }
 
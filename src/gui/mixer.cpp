@@ -302,7 +302,9 @@ void FurnaceGUI::drawMixer() {
               ImGui::Dummy(ImVec2(dpiScale,maxY));
               ImGui::SameLine();
             }
-            if (chipMixer(i,ImVec2(itemWidth,maxY))) MARK_MODIFIED;
+            if (chipMixer(i,ImVec2(itemWidth,maxY))) {
+              MARK_MODIFIED;
+            }
             if (settings.mixerLayout==0) ImGui::SameLine();
           }
         }
@@ -514,7 +516,7 @@ bool FurnaceGUI::chipMixer(int which, ImVec2 size) {
       if (settings.mixerStyle==2) {
         ImVec2 pos=ImGui::GetCursorScreenPos(),
             posMax=pos+ImVec2(ImGui::GetContentRegionAvail().x,ImGui::GetFontSize()+ImGui::GetStyle().FramePadding.y*2.0f);
-        drawVolMeterInternal(ImGui::GetWindowDrawList(),ImRect(pos,posMax),e->chipPeak[which],e->getDispatch(which)->getOutputCount(),true);
+        drawVolMeterInternal(ImGui::GetWindowDrawList(),ImRect(pos,posMax),vizState.chipPeak[which],e->getDispatch(which)->getOutputCount(),true);
 
         ImGui::PushStyleColor(ImGuiCol_FrameBg,0);
         ImGui::PushStyleColor(ImGuiCol_FrameBgActive,0);
@@ -568,7 +570,7 @@ bool FurnaceGUI::chipMixer(int which, ImVec2 size) {
         ImVec2 pos=ImGui::GetCursorScreenPos(),
               size=ImVec2(ImGui::GetContentRegionAvail().x,ImGui::GetFontSize()+ImGui::GetStyle().FramePadding.y*2.0f);
         ImGui::Dummy(size);
-        drawVolMeterInternal(ImGui::GetWindowDrawList(),ImRect(pos,pos+size),e->chipPeak[which],e->getDispatch(which)->getOutputCount(),true);
+        drawVolMeterInternal(ImGui::GetWindowDrawList(),ImRect(pos,pos+size),vizState.chipPeak[which],e->getDispatch(which)->getOutputCount(),true);
       }
     } else {
       if (ImGui::Checkbox("##ChipInvert",&doInvert)) {
@@ -594,7 +596,7 @@ bool FurnaceGUI::chipMixer(int which, ImVec2 size) {
       ImGui::SetCursorPos(curPos);
       ImVec2 pos=ImGui::GetCursorScreenPos();
       if (settings.mixerStyle==2) {
-        drawVolMeterInternal(ImGui::GetWindowDrawList(),ImRect(pos,pos+ImVec2(size.x-vTextWidth,volSliderHeight)),e->chipPeak[which],e->getDispatch(which)->getOutputCount(),false);
+        drawVolMeterInternal(ImGui::GetWindowDrawList(),ImRect(pos,pos+ImVec2(size.x-vTextWidth,volSliderHeight)),vizState.chipPeak[which],e->getDispatch(which)->getOutputCount(),false);
 
         ImGui::PushStyleColor(ImGuiCol_FrameBg,0);
         ImGui::PushStyleColor(ImGuiCol_FrameBgActive,0);
@@ -620,7 +622,7 @@ bool FurnaceGUI::chipMixer(int which, ImVec2 size) {
         ImGui::SetCursorPos(curPos+ImVec2(size.x-vTextWidth+ImGui::GetStyle().FramePadding.x,0));
         pos=ImGui::GetCursorScreenPos();
         ImGui::Dummy(ImVec2(size.x-vTextWidth,volSliderHeight));
-        drawVolMeterInternal(ImGui::GetWindowDrawList(),ImRect(pos,pos+ImVec2(size.x-vTextWidth,volSliderHeight)),e->chipPeak[which],e->getDispatch(which)->getOutputCount(),false);
+        drawVolMeterInternal(ImGui::GetWindowDrawList(),ImRect(pos,pos+ImVec2(size.x-vTextWidth,volSliderHeight)),vizState.chipPeak[which],e->getDispatch(which)->getOutputCount(),false);
       }
       float panSliderWidth=size.x+1.5f*ImGui::GetStyle().FramePadding.x+((settings.mixerStyle!=1)?0:size.x-vTextWidth+ImGui::GetStyle().FramePadding.x);
       ImGui::SetNextItemWidth(panSliderWidth);
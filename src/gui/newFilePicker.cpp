@@ -52,6 +52,10 @@ static void _searchThread(void* item) {
   ((FurnaceFilePicker*)item)->searchSub("",0);
 }
 
+static void _previewThread(void* item) {
+  ((FurnaceFilePicker*)item)->previewSub();
+}
+
 #ifdef _WIN32
 void FurnaceFilePicker::completeStat() {
   // no need to.
@@ -1036,20 +1040,14 @@ void FurnaceFilePicker::drawFileList(ImVec2& tableSize, bool& acknowledged) {
 
               // trigger callback if set
               if (selCallback!=NULL) {
-                String callbackPath;
-                if (path.empty()) {
-                  callbackPath=i->name;
-                } else {
-                  if (*path.rbegin()==DIR_SEPARATOR) {
-                    callbackPath=path+i->name;
-                  } else {
-                    callbackPath=path+DIR_SEPARATOR+i->name;
-                  }
-                }
+                String callbackPath=getEntryPath(i);
                 selCallback(callbackPath.c_str());
               }
             }
           }
+          if (previewCallback!=NULL && !i->isDir && ImGui::IsItemHovered()) {
+            drawPreview(i);
+          }
           ImGui::PopID();
           ImGui::SameLine();
 
@@ -1919,6 +1917,107 @@ void FurnaceFilePicker::clearTypes() {
   fileTypeRegistry.clear();
 }
 
+String FurnaceFilePicker::getEntryPath(FileEntry* entry) {
+  if (path.empty()) {
+    return entry->name;
+  }
+  if (*path.rbegin()==DIR_SEPARATOR) {
+    return path+entry->name;
+  }
+  return path+DIR_SEPARATOR+entry->name;
+}
+
+void FurnaceFilePicker::previewSub() {
+  std::unique_lock<std::mutex> lock(previewLock);
+  while (true) {
+    previewCond.wait(lock,[this]() {
+      return stopPreview || !previewQueue.empty();
+    });
+    if (stopPreview) break;
+
+    // the most recent request goes first
+    std::pair<String,String> job=previewQueue.back();
+    previewQueue.pop_back();
+
+    lock.unlock();
+    FilePickerPreview result;
+    bool valid=previewCallback(job.second,result);
+    lock.lock();
+
+    // the entry may have been evicted in the meantime
+    auto i=previewIndex.find(job.first);
+    if (i!=previewIndex.end()) {
+      i->second->preview=result;
+      i->second->valid=valid;
+      i->second->ready=true;
+    }
+  }
+}
+
+void FurnaceFilePicker::drawPreview(FileEntry* entry) {
+  // the size and modification time are part of the key, so that changed files are previewed again
+  String entryPath=getEntryPath(entry);
+  char keySuffix[128];
+  snprintf(keySuffix,127,"|%" PRIu64 "|%d-%d-%d-%d-%d-%d",
+    entry->size,
+    entry->hasTime?entry->time.tm_year:0,
+    entry->time.tm_mon,
+    entry->time.tm_mday,
+    entry->time.tm_hour,
+    entry->time.tm_min,
+    entry->time.tm_sec
+  );
+  String key=entryPath+keySuffix;
+
+  std::lock_guard<std::mutex> lock(previewLock);
+  auto i=previewIndex.find(key);
+  if (i==previewIndex.end()) {
+    // not in the cache - request it
+    previewCache.push_front(PreviewEntry());
+    previewCache.front().key=key;
+    previewIndex[key]=previewCache.begin();
+    while (previewCache.size()>FP_PREVIEW_CACHE_SIZE) {
+      previewIndex.erase(previewCache.back().key);
+      previewCache.pop_back();
+    }
+
+    previewQueue.push_back(std::pair<String,String>(key,entryPath));
+    while (previewQueue.size()>FP_PREVIEW_QUEUE_SIZE) {
+      // drop the oldest request, so that it's made again if hovered later
+      auto dropped=previewIndex.find(previewQueue.front().first);
+      if (dropped!=previewIndex.end() && !dropped->second->ready) {
+        previewCache.erase(dropped->second);
+        previewIndex.erase(dropped);
+      }
+      previewQueue.pop_front();
+    }
+
+    if (previewThread==NULL) {
+      previewThread=new std::thread(_previewThread,this);
+    }
+    previewCond.notify_one();
+    return;
+  }
+
+  previewCache.splice(previewCache.begin(),previewCache,i->second);
+  PreviewEntry& p=*i->second;
+  if (!p.ready || !p.valid) return;
+
+  if (ImGui::BeginTooltip()) {
+    if (previewDrawCallback!=NULL) {
+      previewDrawCallback(p.preview);
+    } else {
+      ImGui::TextUnformatted(p.preview.info.c_str());
+    }
+    ImGui::EndTooltip();
+  }
+}
+
+void FurnaceFilePicker::setPreviewCallback(FilePickerPreviewCallback make, FilePickerPreviewDrawCallback draw) {
+  previewCallback=make;
+  previewDrawCallback=draw;
+}
+
 FurnaceFilePicker::FurnaceFilePicker():
   fileThread(NULL),
   haveFiles(false),
@@ -1944,6 +2043,10 @@ FurnaceFilePicker::FurnaceFilePicker():
   sortMode(FP_SORT_NAME),
   curStatus(FP_STATUS_WAITING),
   selCallback(NULL),
+  previewThread(NULL),
+  stopPreview(false),
+  previewCallback(NULL),
+  previewDrawCallback(NULL),
   editingPath(false),
   showBookmarks(true),
   showHiddenFiles(true),
@@ -1963,6 +2066,18 @@ FurnaceFilePicker::FurnaceFilePicker():
   }
 }
 
+FurnaceFilePicker::~FurnaceFilePicker() {
+  if (previewThread!=NULL) {
+    previewLock.lock();
+    stopPreview=true;
+    previewLock.unlock();
+    previewCond.notify_one();
+    previewThread->join();
+    delete previewThread;
+    previewThread=NULL;
+  }
+}
+
 void FurnaceFilePicker::acceptAndClose() {
   curStatus=FP_STATUS_ACCEPTED;
   if (noClose) {
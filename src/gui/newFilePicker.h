@@ -23,7 +23,12 @@
 #include "../ta-utils.h"
 #include "../engine/config.h"
 #include <stdint.h>
+#include <condition_variable>
+#include <deque>
 #include <functional>
+#include <list>
+#include <map>
+#include <mutex>
 #include <thread>
 #include "imgui.h"
 
@@ -64,6 +69,30 @@ enum FilePickerFlags {
 
 typedef std::function<void(const char*)> FilePickerSelectCallback;
 
+// maximum number of file previews to keep
+#define FP_PREVIEW_CACHE_SIZE 256
+
+// maximum number of files waiting to be previewed
+#define FP_PREVIEW_QUEUE_SIZE 8
+
+/**
+ * a preview of a file, made by the preview callback.
+ * `wave` is a list of min/max pairs in the -1 to 1 range.
+ * `kind` and `param` are free for use by the draw callback.
+ */
+struct FilePickerPreview {
+  String info;
+  std::vector<float> wave;
+  int kind, param, param2;
+  FilePickerPreview():
+    kind(0), param(0), param2(0) {}
+};
+
+// this runs on the preview thread. returns false if the file can't be previewed.
+typedef std::function<bool(const String&,FilePickerPreview&)> FilePickerPreviewCallback;
+// this runs inside a tooltip.
+typedef std::function<void(const FilePickerPreview&)> FilePickerPreviewDrawCallback;
+
 class FurnaceFilePicker {
   enum SortModes {
     FP_SORT_NAME=0,
@@ -121,6 +150,25 @@ class FurnaceFilePicker {
   FilePickerStatus curStatus;
   FilePickerSelectCallback selCallback;
 
+  // file previews. the cache is kept in most-recently-used order.
+  struct PreviewEntry {
+    String key;
+    FilePickerPreview preview;
+    bool ready, valid;
+    PreviewEntry():
+      ready(false), valid(false) {}
+  };
+  std::list<PreviewEntry> previewCache;
+  std::map<String,std::list<PreviewEntry>::iterator> previewIndex;
+  // (key, path)
+  std::deque<std::pair<String,String>> previewQueue;
+  std::thread* previewThread;
+  std::mutex previewLock;
+  std::condition_variable previewCond;
+  bool stopPreview;
+  FilePickerPreviewCallback previewCallback;
+  FilePickerPreviewDrawCallback previewDrawCallback;
+
   std::vector<FileTypeStyle> fileTypeRegistry;
   FileTypeStyle defaultTypeStyle[FP_TYPE_MAX];
 
@@ -154,6 +202,8 @@ class FurnaceFilePicker {
   bool isPathAbsolute(const String& p);
   void addBookmark(const String& p, String n="");
   FileEntry* makeEntry(void* _entry, const char* prefix=NULL);
+  String getEntryPath(FileEntry* entry);
+  void drawPreview(FileEntry* entry);
   void completeStat();
 
   void drawFileList(ImVec2& tableSize, bool& acknowledged);
@@ -164,6 +214,7 @@ class FurnaceFilePicker {
   public:
     void readDirectorySub();
     void searchSub(String subPath, int depth);
+    void previewSub();
     void setHomeDir(String where);
     FilePickerStatus getStatus();
     const String& getPath();
@@ -181,7 +232,9 @@ class FurnaceFilePicker {
     void registerType(String ext, ImVec4 color, String icon);
     void clearTypes();
     void setConfigPrefix(String prefix);
+    void setPreviewCallback(FilePickerPreviewCallback make, FilePickerPreviewDrawCallback draw);
     FurnaceFilePicker();
+    ~FurnaceFilePicker();
 };
 
 #endif
@@ -41,6 +41,46 @@
 // this is ImGui's TABLE_BORDER_SIZE.
 #define PAT_BORDER_SIZE 1.0f
 
+// the row cache is cleared when it gets this big
+#define PAT_ROW_CACHE_MAX 8192
+
+// a piece of text in a pattern row
+struct PatternCell {
+  const char* text;
+  char buf[4];
+  ImU32 color;
+  float x;
+};
+
+static char hexLabels[256][3];
+static char oneDigitLabels[16][3];
+static bool labelsReady=false;
+
+static void prepareLabels() {
+  if (labelsReady) return;
+  for (int i=0; i<256; i++) {
+    snprintf(hexLabels[i],3,"%.2X",i);
+  }
+  for (int i=0; i<16; i++) {
+    snprintf(oneDigitLabels[i],3," %.1X",i);
+  }
+  labelsReady=true;
+}
+
+static inline const char* hexLabel(PatternCell& c, short val) {
+  if (val>=0 && val<256) return hexLabels[val];
+  snprintf(c.buf,4,"%.2X",val);
+  return c.buf;
+}
+
+static inline void hashBytes(uint64_t& h, const void* data, size_t len) {
+  const unsigned char* d=(const unsigned char*)data;
+  for (size_t i=0; i<len; i++) {
+    h^=d[i];
+    h*=0x100000001b3ULL;
+  }
+}
+
 struct DelayedLabel {
   float posCenter, posY;
   ImVec2 textSize;
@@ -74,6 +114,7 @@ static void _popPartBlend(const ImDrawList* drawList, const ImDrawCmd* cmd) {
 
 
 void FurnaceGUI::drawPatternNew() {
+  prepareLabels();
   if (nextWindow==GUI_WINDOW_PATTERN) {
     patternOpen=true;
     ImGui::SetNextWindowFocus();
@@ -1305,29 +1346,35 @@ void FurnaceGUI::drawPatternNew() {
             bottomMostRow=row;
           }
 
+          // gather the text of this row
+          PatternCell cells[3+DIV_MAX_EFFECTS*2];
+          int cellCount=0;
+          float cellX=0.0f;
+
           // note
-          const char* idN=noteName(pat->newData[row][DIV_PAT_NOTE]);
-          if (pat->newData[row][DIV_PAT_NOTE]==-1) {
-            dl->AddText(pos,inactiveColor,idN,idN+3);
-          } else {
-            dl->AddText(pos,activeColor,idN,idN+3);
-          }
+          PatternCell& cNote=cells[cellCount++];
+          cNote.text=noteName(pat->newData[row][DIV_PAT_NOTE]);
+          cNote.color=(pat->newData[row][DIV_PAT_NOTE]==-1)?inactiveColor:activeColor;
+          cNote.x=cellX;
 
           // instrument
           if (e->curSubSong->chanCollapse[i]<3) {
-            pos.x+=noteCellSize.x;
+            cellX+=noteCellSize.x;
+            PatternCell& c=cells[cellCount++];
+            c.x=cellX;
             if (pat->newData[row][DIV_PAT_INS]==-1) {
-              dl->AddText(pos,inactiveColor,emptyLabel2,emptyLabel2+2);
+              c.text=emptyLabel2;
+              c.color=inactiveColor;
             } else {
-              snprintf(id,63,"%.2X",pat->newData[row][DIV_PAT_INS]);
+              c.text=hexLabel(c,pat->newData[row][DIV_PAT_INS]);
               if (pat->newData[row][DIV_PAT_INS]<0 || pat->newData[row][DIV_PAT_INS]>=e->song.insLen) {
-                dl->AddText(pos,ImGui::GetColorU32(uiColors[GUI_COLOR_PATTERN_INS_ERROR]),id,id+2);
+                c.color=ImGui::GetColorU32(uiColors[GUI_COLOR_PATTERN_INS_ERROR]);
               } else {
                 DivInstrumentType t=e->song.ins[pat->newData[row][DIV_PAT_INS]]->type;
                 if (!e->channelSupportsInstrumentType(i,t)) {
-                  dl->AddText(pos,ImGui::GetColorU32(uiColors[GUI_COLOR_PATTERN_INS_WARN]),id,id+2);
+                  c.color=ImGui::GetColorU32(uiColors[GUI_COLOR_PATTERN_INS_WARN]);
                 } else {
-                  dl->AddText(pos,ImGui::GetColorU32(uiColors[GUI_COLOR_PATTERN_INS]),id,id+2);
+                  c.color=ImGui::GetColorU32(uiColors[GUI_COLOR_PATTERN_INS]);
                 }
               }
             }
@@ -1335,15 +1382,18 @@ void FurnaceGUI::drawPatternNew() {
 
           // volume
           if (e->curSubSong->chanCollapse[i]<2) {
-            pos.x+=insCellSize.x;
+            cellX+=insCellSize.x;
+            PatternCell& c=cells[cellCount++];
+            c.x=cellX;
             if (pat->newData[row][DIV_PAT_VOL]==-1) {
-              dl->AddText(pos,inactiveColor,emptyLabel2,emptyLabel2+2);
+              c.text=emptyLabel2;
+              c.color=inactiveColor;
             } else {
               int volColor=(pat->newData[row][DIV_PAT_VOL]*127)/chanVolMax;
               if (volColor>127) volColor=127;
               if (volColor<0) volColor=0;
-              snprintf(id,63,"%.2X",pat->newData[row][DIV_PAT_VOL]);
-              dl->AddText(pos,ImGui::GetColorU32(volColors[volColor]),id,id+2);
+              c.text=hexLabel(c,pat->newData[row][DIV_PAT_VOL]);
+              c.color=ImGui::GetColorU32(volColors[volColor]);
             }
           }
 
@@ -1355,32 +1405,102 @@ void FurnaceGUI::drawPatternNew() {
               ImU32 effectColor=inactiveColor;
 
               // effect
-              pos.x+=(k==0)?volCellSize.x:effectValCellSize.x;
+              cellX+=(k==0)?volCellSize.x:effectValCellSize.x;
+              PatternCell& c=cells[cellCount++];
+              c.x=cellX;
               if (pat->newData[row][index]==-1) {
-                dl->AddText(pos,inactiveColor,emptyLabel2,emptyLabel2+2);
+                c.text=emptyLabel2;
               } else {
                 if (pat->newData[row][index]>0xff) {
-                  snprintf(id,63,"??");
+                  c.text="??";
                   effectColor=ImGui::GetColorU32(uiColors[GUI_COLOR_PATTERN_EFFECT_INVALID]);
                 } else {
                   const unsigned char data=pat->newData[row][index];
                   effectColor=ImGui::GetColorU32(uiColors[fxColors[data]]);
                   if (pat->newData[row][index]>=0x10 || settings.oneDigitEffects==0) {
-                    snprintf(id,63,"%.2X",data);
+                    c.text=hexLabels[data];
                   } else {
-                    snprintf(id,63," %.1X",data);
+                    c.text=oneDigitLabels[data];
                   }
                 }
-                dl->AddText(pos,effectColor,id,id+2);
               }
+              c.color=(pat->newData[row][index]==-1)?inactiveColor:effectColor;
 
               // effect value
-              pos.x+=effectCellSize.x;
+              cellX+=effectCellSize.x;
+              PatternCell& cVal=cells[cellCount++];
+              cVal.x=cellX;
+              cVal.color=effectColor;
               if (pat->newData[row][indexVal]==-1) {
-                dl->AddText(pos,effectColor,emptyLabel2,emptyLabel2+2);
+                cVal.text=emptyLabel2;
               } else {
-                snprintf(id,63,"%.2X",pat->newData[row][indexVal]);
-                dl->AddText(pos,effectColor,id,id+2);
+                cVal.text=hexLabel(cVal,pat->newData[row][indexVal]);
+              }
+            }
+          }
+
+          // look the row up in the cache.
+          // text is positioned at whole pixels, so the fractional part of the position is
+          // part of the key.
+          // only rows which are entirely visible are cached, as text outside the
+          // clipping rectangle is discarded.
+          ImVec2 rowPos=ImVec2(floorf(pos.x),floorf(pos.y));
+          ImVec2 rowFrac=ImVec2(pos.x-rowPos.x,pos.y-rowPos.y);
+          ImVec2 clipMin=dl->GetClipRectMin();
+          ImVec2 clipMax=dl->GetClipRectMax();
+          bool cacheable=(pos.x>=clipMin.x && pos.y>=clipMin.y && pos.x+cellX+effectValCellSize.x<=clipMax.x && pos.y+lineHeight<=clipMax.y);
+          uint64_t key=0xcbf29ce484222325ULL;
+          PatternRowCacheEntry* cached=NULL;
+          if (cacheable) {
+            ImFont* font=ImGui::GetFont();
+            float fontSize=ImGui::GetFontSize();
+            hashBytes(key,&font,sizeof(font));
+            hashBytes(key,&fontSize,sizeof(float));
+            hashBytes(key,&rowFrac,sizeof(ImVec2));
+            for (int k=0; k<cellCount; k++) {
+              hashBytes(key,cells[k].text,(k==0)?3:2);
+              hashBytes(key,&cells[k].color,sizeof(ImU32));
+              hashBytes(key,&cells[k].x,sizeof(float));
+            }
+            auto it=patRowCache.find(key);
+            if (it!=patRowCache.end()) cached=&it->second;
+          }
+
+          if (cached!=NULL) {
+            // replay the vertices
+            dl->PrimReserve(cached->idx.size(),cached->vtx.size());
+            ImDrawIdx base=dl->_VtxCurrentIdx;
+            for (const ImDrawVert& v: cached->vtx) {
+              *dl->_VtxWritePtr=v;
+              dl->_VtxWritePtr->pos.x+=rowPos.x;
+              dl->_VtxWritePtr->pos.y+=rowPos.y;
+              dl->_VtxWritePtr++;
+            }
+            for (ImDrawIdx idx: cached->idx) {
+              *dl->_IdxWritePtr++=base+idx;
+            }
+            dl->_VtxCurrentIdx+=cached->vtx.size();
+          } else {
+            int cmdCount=dl->CmdBuffer.Size;
+            int vtxBegin=dl->VtxBuffer.Size;
+            int idxBegin=dl->IdxBuffer.Size;
+            unsigned int vtxCurBegin=dl->_VtxCurrentIdx;
+            for (int k=0; k<cellCount; k++) {
+              ImVec2 cellPos=ImVec2(pos.x+cells[k].x,pos.y);
+              dl->AddText(cellPos,cells[k].color,cells[k].text,cells[k].text+((k==0)?3:2));
+            }
+            // store the vertices if they all ended up in the same draw command
+            if (cacheable && dl->CmdBuffer.Size==cmdCount && dl->_VtxCurrentIdx-vtxCurBegin==(unsigned int)(dl->VtxBuffer.Size-vtxBegin)) {
+              if (patRowCache.size()>=PAT_ROW_CACHE_MAX) patRowCache.clear();
+              PatternRowCacheEntry& entry=patRowCache[key];
+              entry.vtx.assign(dl->VtxBuffer.Data+vtxBegin,dl->VtxBuffer.Data+dl->VtxBuffer.Size);
+              for (ImDrawVert& v: entry.vtx) {
+                v.pos.x-=rowPos.x;
+                v.pos.y-=rowPos.y;
+              }
+              entry.idx.resize(dl->IdxBuffer.Size-idxBegin);
+              for (int k=idxBegin; k<dl->IdxBuffer.Size; k++) {
+                entry.idx[k-idxBegin]=dl->IdxBuffer.Data[k]-vtxCurBegin;
               }
             }
           }
@@ -2092,13 +2212,17 @@ void FurnaceGUI::drawPatternNew() {
       }
 
       // particle simulation
-      ImDrawList* fdl=ImGui::GetWindowDrawList();
-      fdl->PushClipRectFullScreen();
-      if (!particles.empty()) WAKE_UP;
-      fdl->AddCallback(_pushPartBlend,this);
-      for (size_t i=0; i<particles.size(); i++) {
-        Particle& part=particles[i];
-        if (part.update(frameTime)) {
+      // the blend callbacks split the draw list, so they are only emitted
+      // while there are particles to draw.
+      if (!particles.empty()) {
+        ImDrawList* fdl=ImGui::GetWindowDrawList();
+        WAKE_UP;
+        fdl->PushClipRectFullScreen();
+        fdl->AddCallback(_pushPartBlend,this);
+        size_t alive=0;
+        for (size_t i=0; i<particles.size(); i++) {
+          Particle& part=particles[i];
+          if (!part.update(frameTime)) continue;
           if (part.life>255) part.life=255;
           fdl->AddText(
             iconFont,
@@ -2107,13 +2231,13 @@ void FurnaceGUI::drawPatternNew() {
             part.colors[(int)part.life],
             part.type
           );
-        } else {
-          particles.erase(particles.begin()+i);
-          i--;
+          if (alive!=i) particles[alive]=part;
+          alive++;
         }
+        particles.erase(particles.begin()+alive,particles.end());
+        fdl->AddCallback(_popPartBlend,this);
+        fdl->PopClipRect();
       }
-      fdl->AddCallback(_popPartBlend,this);
-      fdl->PopClipRect();
     }
 
     ImGui::PopFont();
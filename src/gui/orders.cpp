@@ -307,173 +307,177 @@ void FurnaceGUI::drawOrders() {
         // OH MY FREAKING. just let me sleep.
         clipBegin.y+=lineHeight;
         ImGui::PopStyleColor();
-        for (int i=0; i<e->curSubSong->ordersLen; i++) {
-          ImGui::TableNextRow(0,lineHeight);
-          if (playOrder==i && e->isPlaying()) ImGui::TableSetBgColor(ImGuiTableBgTarget_RowBg0,ImGui::GetColorU32(uiColors[GUI_COLOR_ORDER_ACTIVE]));
-          ImGui::TableNextColumn();
-          if (curOrder==i) {
-            if (ImGui::GetCurrentWindowRead()->ScrollbarY) {
-              clipEnd.x-=ImGui::GetStyle().ScrollbarSize;
+        ImGuiListClipper clipper;
+        clipper.Begin(e->curSubSong->ordersLen);
+        while (clipper.Step()) {
+          for (int i=clipper.DisplayStart; i<clipper.DisplayEnd; i++) {
+            ImGui::TableNextRow(0,lineHeight);
+            if (playOrder==i && e->isPlaying()) ImGui::TableSetBgColor(ImGuiTableBgTarget_RowBg0,ImGui::GetColorU32(uiColors[GUI_COLOR_ORDER_ACTIVE]));
+            ImGui::TableNextColumn();
+            if (curOrder==i) {
+              if (ImGui::GetCurrentWindowRead()->ScrollbarY) {
+                clipEnd.x-=ImGui::GetStyle().ScrollbarSize;
+              }
+              // draw a border
+              ImGui::PushClipRect(clipBegin,clipEnd,false);
+              ImDrawList* dl=ImGui::GetWindowDrawList();
+              ImVec2 rBegin=ImGui::GetCursorScreenPos();
+              rBegin.y-=ImGui::GetStyle().CellPadding.y;
+              ImVec2 rEnd=ImVec2(clipEnd.x,rBegin.y+lineHeight);
+              dl->AddRect(rBegin,rEnd,ImGui::GetColorU32(uiColors[GUI_COLOR_ORDER_SELECTED]),2.0f*dpiScale);
+              ImGui::PopClipRect();
             }
-            // draw a border
-            ImGui::PushClipRect(clipBegin,clipEnd,false);
-            ImDrawList* dl=ImGui::GetWindowDrawList();
-            ImVec2 rBegin=ImGui::GetCursorScreenPos();
-            rBegin.y-=ImGui::GetStyle().CellPadding.y;
-            ImVec2 rEnd=ImVec2(clipEnd.x,rBegin.y+lineHeight);
-            dl->AddRect(rBegin,rEnd,ImGui::GetColorU32(uiColors[GUI_COLOR_ORDER_SELECTED]),2.0f*dpiScale);
-            ImGui::PopClipRect();
-          }
-          ImGui::PushStyleColor(ImGuiCol_Text,uiColors[GUI_COLOR_ORDER_ROW_INDEX]);
-          bool highlightLoop=(i>=e->curSubSong->ts.loopStart.order && i<=e->curSubSong->ts.loopEnd.order && e->curSubSong->ts.isLoopDefined);
-          if (highlightLoop) ImGui::TableSetBgColor(ImGuiTableBgTarget_CellBg,ImGui::GetColorU32(uiColors[GUI_COLOR_SONG_LOOP]));
-          if (settings.orderRowsBase==1) {
-            snprintf(selID,4096,"%.2X##O_S%.2x",i,i);
-          } else {
-            snprintf(selID,4096,"%d##O_S%.2x",i,i);
-          }
-          if (ImGui::Selectable(selID)) {
-            setOrder(i);
-            curNibble=false;
-            orderCursor=-1;
-
-            if (orderEditMode==0) {
-              handleUnimportant;
+            ImGui::PushStyleColor(ImGuiCol_Text,uiColors[GUI_COLOR_ORDER_ROW_INDEX]);
+            bool highlightLoop=(i>=e->curSubSong->ts.loopStart.order && i<=e->curSubSong->ts.loopEnd.order && e->curSubSong->ts.isLoopDefined);
+            if (highlightLoop) ImGui::TableSetBgColor(ImGuiTableBgTarget_CellBg,ImGui::GetColorU32(uiColors[GUI_COLOR_SONG_LOOP]));
+            if (settings.orderRowsBase==1) {
+              snprintf(selID,4096,"%.2X##O_S%.2x",i,i);
+            } else {
+              snprintf(selID,4096,"%d##O_S%.2x",i,i);
             }
+            if (ImGui::Selectable(selID)) {
+              setOrder(i);
+              curNibble=false;
+              orderCursor=-1;
 
-            if (cursor.xCoarse==selStart.xCoarse && cursor.xFine==selStart.xFine && cursor.y==selStart.y && cursor.order==selStart.order &&
-                cursor.xCoarse==selEnd.xCoarse && cursor.xFine==selEnd.xFine && cursor.y==selEnd.y && cursor.order==selEnd.order) {
-              cursor.order=curOrder;
-              selStart=cursor;
-              selEnd=cursor;
+              if (orderEditMode==0) {
+                handleUnimportant;
+              }
+
+              if (cursor.xCoarse==selStart.xCoarse && cursor.xFine==selStart.xFine && cursor.y==selStart.y && cursor.order==selStart.order &&
+                  cursor.xCoarse==selEnd.xCoarse && cursor.xFine==selEnd.xFine && cursor.y==selEnd.y && cursor.order==selEnd.order) {
+                cursor.order=curOrder;
+                selStart=cursor;
+                selEnd=cursor;
+              }
             }
-          }
-          ImGui::PopStyleColor();
-          for (int j=0; j<e->getTotalChannelCount(); j++) {
-            if (!e->curSubSong->chanShow[j]) continue;
-            if (!ImGui::TableNextColumn()) continue;
-            DivPattern* pat=e->curPat[j].getPattern(e->curOrders->ord[j][i],false);
-            /*if (!pat->name.empty()) {
-              snprintf(selID,4096,"%s##O_%.2x_%.2x",pat->name.c_str(),j,i);
-            } else {*/
-              snprintf(selID,4096,"%.2X##O_%.2x_%.2x",e->curOrders->ord[j][i],j,i);
-            //}
-
-            ImGui::PushStyleColor(ImGuiCol_Text,(curOrder==i || e->curOrders->ord[j][i]==e->curOrders->ord[j][curOrder])?uiColors[GUI_COLOR_ORDER_SIMILAR]:uiColors[GUI_COLOR_ORDER_INACTIVE]);
-            if (ImGui::Selectable(selID,settings.ordersCursor?(cursor.xCoarse==j && curOrder!=i):false)) {
-              if (curOrder==i) {
-                if (orderEditMode==0) {
-                  prepareUndo(GUI_UNDO_CHANGE_ORDER);
-                  e->lockSave([this,i,j]() {
-                    if (changeAllOrders) {
-                      for (int k=0; k<e->getTotalChannelCount(); k++) {
-                        if (e->curOrders->ord[k][i]<(unsigned char)(DIV_MAX_PATTERNS-1)) e->curOrders->ord[k][i]++;
+            ImGui::PopStyleColor();
+            for (int j=0; j<e->getTotalChannelCount(); j++) {
+              if (!e->curSubSong->chanShow[j]) continue;
+              if (!ImGui::TableNextColumn()) continue;
+              DivPattern* pat=e->curPat[j].getPattern(e->curOrders->ord[j][i],false);
+              /*if (!pat->name.empty()) {
+                snprintf(selID,4096,"%s##O_%.2x_%.2x",pat->name.c_str(),j,i);
+              } else {*/
+                snprintf(selID,4096,"%.2X##O_%.2x_%.2x",e->curOrders->ord[j][i],j,i);
+              //}
+
+              ImGui::PushStyleColor(ImGuiCol_Text,(curOrder==i || e->curOrders->ord[j][i]==e->curOrders->ord[j][curOrder])?uiColors[GUI_COLOR_ORDER_SIMILAR]:uiColors[GUI_COLOR_ORDER_INACTIVE]);
+              if (ImGui::Selectable(selID,settings.ordersCursor?(cursor.xCoarse==j && curOrder!=i):false)) {
+                if (curOrder==i) {
+                  if (orderEditMode==0) {
+                    prepareUndo(GUI_UNDO_CHANGE_ORDER);
+                    e->lockSave([this,i,j]() {
+                      if (changeAllOrders) {
+                        for (int k=0; k<e->getTotalChannelCount(); k++) {
+                          if (e->curOrders->ord[k][i]<(unsigned char)(DIV_MAX_PATTERNS-1)) e->curOrders->ord[k][i]++;
+                        }
+                      } else {
+                        if (e->curOrders->ord[j][i]<(unsigned char)(DIV_MAX_PATTERNS-1)) e->curOrders->ord[j][i]++;
                       }
-                    } else {
-                      if (e->curOrders->ord[j][i]<(unsigned char)(DIV_MAX_PATTERNS-1)) e->curOrders->ord[j][i]++;
-                    }
-                  });
-                  makeUndo(GUI_UNDO_CHANGE_ORDER);
+                    });
+                    makeUndo(GUI_UNDO_CHANGE_ORDER);
+                  } else {
+                    orderCursor=j;
+                    curNibble=false;
+                  }
                 } else {
-                  orderCursor=j;
-                  curNibble=false;
-                }
-              } else {
-                setOrder(i);
-                if (orderEditMode!=0) {
-                  orderCursor=j;
-                  curNibble=false;
+                  setOrder(i);
+                  if (orderEditMode!=0) {
+                    orderCursor=j;
+                    curNibble=false;
+                  }
+
+                  // i wonder whether this is necessary
+                  if (cursor.xCoarse==selStart.xCoarse && cursor.xFine==selStart.xFine && cursor.y==selStart.y && cursor.order==selStart.order &&
+                      cursor.xCoarse==selEnd.xCoarse && cursor.xFine==selEnd.xFine && cursor.y==selEnd.y && cursor.order==selEnd.order) {
+                    cursor.order=curOrder;
+                    selStart=cursor;
+                    selEnd=cursor;
+                  }
                 }
 
-                // i wonder whether this is necessary
-                if (cursor.xCoarse==selStart.xCoarse && cursor.xFine==selStart.xFine && cursor.y==selStart.y && cursor.order==selStart.order &&
-                    cursor.xCoarse==selEnd.xCoarse && cursor.xFine==selEnd.xFine && cursor.y==selEnd.y && cursor.order==selEnd.order) {
-                  cursor.order=curOrder;
-                  selStart=cursor;
-                  selEnd=cursor;
+                if (orderEditMode==0) {
+                  handleUnimportant;
                 }
               }
-
-              if (orderEditMode==0) {
-                handleUnimportant;
+              ImGui::PopStyleColor();
+              if (orderEditMode!=0 && curOrder==i && orderCursor==j) {
+                // draw a border
+                ImDrawList* dl=ImGui::GetWindowDrawList();
+                dl->AddRect(ImGui::GetItemRectMin(),ImGui::GetItemRectMax(),ImGui::GetColorU32(uiColors[GUI_COLOR_TEXT]),2.0f*dpiScale);
               }
-            }
-            ImGui::PopStyleColor();
-            if (orderEditMode!=0 && curOrder==i && orderCursor==j) {
-              // draw a border
-              ImDrawList* dl=ImGui::GetWindowDrawList();
-              dl->AddRect(ImGui::GetItemRectMin(),ImGui::GetItemRectMax(),ImGui::GetColorU32(uiColors[GUI_COLOR_TEXT]),2.0f*dpiScale);
-            }
-            if (!pat->name.empty() && ImGui::IsItemHovered()) {
-              ImGui::SetTooltip("%s",pat->name.c_str());
-            }
-            bool findFreePat=ImGui::IsItemClicked(ImGuiMouseButton_Middle);
-            if (ImGui::IsItemHovered() && CHECK_LONG_HOLD) {
-              NOTIFY_LONG_HOLD;
-              findFreePat=true;
-            }
-            if (findFreePat) {
-              // find free pattern and assign it
-              prepareUndo(GUI_UNDO_CHANGE_ORDER);
-              e->lockSave([this,i,j]() {
-                bool foundOne=false;
-                bool available[DIV_MAX_PATTERNS];
-                memset(available,1,DIV_MAX_PATTERNS*sizeof(bool));
-                for (int k=0; k<e->curSubSong->ordersLen; k++) {
-                  available[e->curOrders->ord[j][k]]=false;
-                }
-                for (int k=0; k<DIV_MAX_PATTERNS; k++) {
-                  // don't accept a used pattern
-                  if (!available[k]) continue;
-                  // accept an unallocated pattern (guaranteed to be empty)
-                  if (e->curPat[j].data[k]==NULL) {
-                    e->curOrders->ord[j][i]=k;
-                    foundOne=true;
-                    break;
-                  } else {
-                    // check whether this pattern is empty and accept it if so
-                    DivPattern* p=e->curPat[j].getPattern(k,false);
-                    if (p->isEmpty()) {
+              if (!pat->name.empty() && ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("%s",pat->name.c_str());
+              }
+              bool findFreePat=ImGui::IsItemClicked(ImGuiMouseButton_Middle);
+              if (ImGui::IsItemHovered() && CHECK_LONG_HOLD) {
+                NOTIFY_LONG_HOLD;
+                findFreePat=true;
+              }
+              if (findFreePat) {
+                // find free pattern and assign it
+                prepareUndo(GUI_UNDO_CHANGE_ORDER);
+                e->lockSave([this,i,j]() {
+                  bool foundOne=false;
+                  bool available[DIV_MAX_PATTERNS];
+                  memset(available,1,DIV_MAX_PATTERNS*sizeof(bool));
+                  for (int k=0; k<e->curSubSong->ordersLen; k++) {
+                    available[e->curOrders->ord[j][k]]=false;
+                  }
+                  for (int k=0; k<DIV_MAX_PATTERNS; k++) {
+                    // don't accept a used pattern
+                    if (!available[k]) continue;
+                    // accept an unallocated pattern (guaranteed to be empty)
+                    if (e->curPat[j].data[k]==NULL) {
                       e->curOrders->ord[j][i]=k;
                       foundOne=true;
                       break;
+                    } else {
+                      // check whether this pattern is empty and accept it if so
+                      DivPattern* p=e->curPat[j].getPattern(k,false);
+                      if (p->isEmpty()) {
+                        e->curOrders->ord[j][i]=k;
+                        foundOne=true;
+                        break;
+                      }
                     }
                   }
-                }
-                if (!foundOne) showError(_("no free patterns available on this channel!"));
-              });
-              makeUndo(GUI_UNDO_CHANGE_ORDER);
-            }
-            if (ImGui::IsItemClicked(ImGuiMouseButton_Right)) {
-              if (curOrder==i) {
-                if (orderEditMode==0) {
-                  prepareUndo(GUI_UNDO_CHANGE_ORDER);
-                  e->lockSave([this,i,j]() {
-                    if (changeAllOrders) {
-                      for (int k=0; k<e->getTotalChannelCount(); k++) {
-                        if (e->curOrders->ord[k][i]>0) e->curOrders->ord[k][i]--;
+                  if (!foundOne) showError(_("no free patterns available on this channel!"));
+                });
+                makeUndo(GUI_UNDO_CHANGE_ORDER);
+              }
+              if (ImGui::IsItemClicked(ImGuiMouseButton_Right)) {
+                if (curOrder==i) {
+                  if (orderEditMode==0) {
+                    prepareUndo(GUI_UNDO_CHANGE_ORDER);
+                    e->lockSave([this,i,j]() {
+                      if (changeAllOrders) {
+                        for (int k=0; k<e->getTotalChannelCount(); k++) {
+                          if (e->curOrders->ord[k][i]>0) e->curOrders->ord[k][i]--;
+                        }
+                      } else {
+                        if (e->curOrders->ord[j][i]>0) e->curOrders->ord[j][i]--;
                       }
-                    } else {
-                      if (e->curOrders->ord[j][i]>0) e->curOrders->ord[j][i]--;
-                    }
-                  });
-                  makeUndo(GUI_UNDO_CHANGE_ORDER);
+                    });
+                    makeUndo(GUI_UNDO_CHANGE_ORDER);
+                  } else {
+                    orderCursor=j;
+                    curNibble=false;
+                  }
                 } else {
-                  orderCursor=j;
-                  curNibble=false;
-                }
-              } else {
-                setOrder(i);
-                if (orderEditMode!=0) {
-                  orderCursor=j;
-                  curNibble=false;
-                }
+                  setOrder(i);
+                  if (orderEditMode!=0) {
+                    orderCursor=j;
+                    curNibble=false;
+                  }
 
-                if (cursor.xCoarse==selStart.xCoarse && cursor.xFine==selStart.xFine && cursor.y==selStart.y && cursor.order==selStart.order &&
-                    cursor.xCoarse==selEnd.xCoarse && cursor.xFine==selEnd.xFine && cursor.y==selEnd.y && cursor.order==selEnd.order) {
-                  cursor.order=curOrder;
-                  selStart=cursor;
-                  selEnd=cursor;
+                  if (cursor.xCoarse==selStart.xCoarse && cursor.xFine==selStart.xFine && cursor.y==selStart.y && cursor.order==selStart.order &&
+                      cursor.xCoarse==selEnd.xCoarse && cursor.xFine==selEnd.xFine && cursor.y==selEnd.y && cursor.order==selEnd.order) {
+                    cursor.order=curOrder;
+                    selStart=cursor;
+                    selEnd=cursor;
+                  }
                 }
               }
             }
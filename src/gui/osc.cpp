@@ -24,7 +24,8 @@
 #include "../engine/filter.h"
 
 void FurnaceGUI::readOsc() {
-  int writePos=e->oscWritePos;
+  e->getVizState(vizState);
+  int writePos=vizState.oscWritePos;
   int readPos=e->oscReadPos;
   int avail=0;
   int total=0;
@@ -50,11 +51,27 @@ void FurnaceGUI::readOsc() {
   int winSize=e->getAudioDescGot().rate*(oscWindowSize/1000.0);
   int oscReadPos=(writePos-winSize)&0x7fff;
 
+  // if the shader draws the waveform and there are fewer samples than pixels, upload the
+  // samples as they are and let it interpolate them.
+  // this skips the resampler below.
+  bool rawOsc=(rend->supportsDrawOsc() && settings.shaderOsc && winSize>=2 && winSize<=oscWidth-24);
+  oscValuesLen=rawOsc?(winSize+24):oscWidth;
+
   for (int ch=0; ch<e->getAudioDescGot().outChans; ch++) {
     if (oscValues[ch]==NULL) {
       oscValues[ch]=new float[2048];
     }
     memset(oscValues[ch],0,2048*sizeof(float));
+    if (rawOsc) {
+      for (int i=0; i<winSize; i++) {
+        float val=e->oscBuf[ch][(oscReadPos+i)&0x7fff];
+        oscValues[ch][i+12]=val;
+        if (val>0.001f || val<-0.001f) {
+          WAKE_UP;
+        }
+      }
+      continue;
+    }
     float* sincITable=DivFilterTables::getSincIntegralSmallTable();
 
     float posFrac=0.0;
@@ -104,7 +121,7 @@ void FurnaceGUI::readOsc() {
     oscValuesAverage=new float[2048];
   }
   memset(oscValuesAverage,0,2048*sizeof(float));
-  for (int i=0; i<oscWidth; i++) {
+  for (int i=0; i<oscValuesLen; i++) {
     float avg=0;
     for (int j=0; j<e->getAudioDescGot().outChans; j++) {
       avg+=oscValues[j][i];
@@ -304,7 +321,7 @@ void FurnaceGUI::drawOsc() {
           if (rend->supportsDrawOsc() && settings.shaderOsc) {
             _do[0].gui=this;
             _do[0].data=&oscValuesAverage[12];
-            _do[0].len=oscWidth-24;
+            _do[0].len=oscValuesLen-24;
             _do[0].pos0=inRect.Min;
             _do[0].pos1=inRect.Max;
             _do[0].color=isClipping?uiColors[GUI_COLOR_OSC_WAVE_PEAK]:uiColors[GUI_COLOR_OSC_WAVE];
@@ -340,7 +357,7 @@ void FurnaceGUI::drawOsc() {
             if (rend->supportsDrawOsc() && settings.shaderOsc) {
               _do[ch].gui=this;
               _do[ch].data=&oscValues[ch][12];
-              _do[ch].len=oscWidth-24;
+              _do[ch].len=oscValuesLen-24;
               _do[ch].pos0=inRect.Min;
               _do[ch].pos1=inRect.Max;
               _do[ch].color=isClipping?uiColors[GUI_COLOR_OSC_WAVE_PEAK]:uiColors[GUI_COLOR_OSC_WAVE_CH0+ch];
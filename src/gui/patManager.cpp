@@ -30,7 +30,7 @@ void FurnaceGUI::drawPatManager() {
   }
   if (!patManagerOpen) return;
   char id[1024];
-  unsigned char isUsed[DIV_MAX_PATTERNS];
+  int isUsed[DIV_MAX_PATTERNS];
   bool isNull[DIV_MAX_PATTERNS];
   if (ImGui::Begin("Pattern Manager",&patManagerOpen,globalWinFlags,_("Pattern Manager"))) {
     if (ImGui::Button(_("De-duplicate patterns"))) {
@@ -64,59 +64,64 @@ void FurnaceGUI::drawPatManager() {
     if (ImGui::BeginTable("PatManTable",257,ImGuiTableFlags_ScrollX|ImGuiTableFlags_SizingFixedFit)) {
       ImGui::PushFont(patFont);
 
-      for (int i=0; i<e->getTotalChannelCount(); i++) {
-        ImGui::TableNextRow();
-        memset(isUsed,0,DIV_MAX_PATTERNS);
-        memset(isNull,0,DIV_MAX_PATTERNS*sizeof(bool));
-        for (int j=0; j<e->curSubSong->ordersLen; j++) {
-          isUsed[e->curSubSong->orders.ord[i][j]]++;
-        }
-        for (int j=0; j<DIV_MAX_PATTERNS; j++) {
-          isNull[j]=(e->curSubSong->pat[i].data[j]==NULL);
-        }
-        ImGui::TableNextColumn();
-        ImGui::Text("%s",e->getChannelShortName(i));
-
-        ImGui::PushID(1000+i);
-        for (int k=0; k<DIV_MAX_PATTERNS; k++) {
+      // only the visible channels are drawn and counted
+      ImGuiListClipper clipper;
+      clipper.Begin(e->getTotalChannelCount());
+      while (clipper.Step()) {
+        for (int i=clipper.DisplayStart; i<clipper.DisplayEnd; i++) {
+          ImGui::TableNextRow();
+          memset(isUsed,0,DIV_MAX_PATTERNS*sizeof(int));
+          memset(isNull,0,DIV_MAX_PATTERNS*sizeof(bool));
+          for (int j=0; j<e->curSubSong->ordersLen; j++) {
+            isUsed[e->curSubSong->orders.ord[i][j]]++;
+          }
+          for (int j=0; j<DIV_MAX_PATTERNS; j++) {
+            isNull[j]=(e->curSubSong->pat[i].data[j]==NULL);
+          }
           ImGui::TableNextColumn();
+          ImGui::Text("%s",e->getChannelShortName(i));
 
-          snprintf(id,1023,"%.2X",k);
-          if (isNull[k]) {
-            ImGui::PushStyleColor(ImGuiCol_Text,uiColors[GUI_COLOR_PAT_MANAGER_NULL]);
-          } else if (isUsed[k]>=e->curSubSong->ordersLen) {
-            ImGui::PushStyleColor(ImGuiCol_Text,uiColors[GUI_COLOR_PAT_MANAGER_COMBO_BREAKER]);
-          } else if (isUsed[k]>=0.7*(double)e->curSubSong->ordersLen) {
-            ImGui::PushStyleColor(ImGuiCol_Text,uiColors[GUI_COLOR_PAT_MANAGER_EXTREMELY_OVERUSED]);
-          } else if (isUsed[k]>=0.4*(double)e->curSubSong->ordersLen) {
-            ImGui::PushStyleColor(ImGuiCol_Text,uiColors[GUI_COLOR_PAT_MANAGER_OVERUSED]);
-          } else if (isUsed[k]) {
-            ImGui::PushStyleColor(ImGuiCol_Text,uiColors[GUI_COLOR_PAT_MANAGER_USED]);
-          } else {
-            ImGui::PushStyleColor(ImGuiCol_Text,uiColors[GUI_COLOR_PAT_MANAGER_UNUSED]);
-          }
-          ImGui::Selectable(id,isUsed[k]);
-          if (ImGui::IsItemHovered()) {
-            ImGui::PushFont(mainFont);
-            ImGui::PushStyleColor(ImGuiCol_Text,uiColors[GUI_COLOR_TEXT]);
+          ImGui::PushID(1000+i);
+          for (int k=0; k<DIV_MAX_PATTERNS; k++) {
+            if (!ImGui::TableNextColumn()) continue;
+
+            snprintf(id,1023,"%.2X",k);
             if (isNull[k]) {
-              ImGui::SetTooltip(_("Pattern %.2X\n- not allocated"),k);
+              ImGui::PushStyleColor(ImGuiCol_Text,uiColors[GUI_COLOR_PAT_MANAGER_NULL]);
+            } else if (isUsed[k]>=e->curSubSong->ordersLen) {
+              ImGui::PushStyleColor(ImGuiCol_Text,uiColors[GUI_COLOR_PAT_MANAGER_COMBO_BREAKER]);
+            } else if (isUsed[k]>=0.7*(double)e->curSubSong->ordersLen) {
+              ImGui::PushStyleColor(ImGuiCol_Text,uiColors[GUI_COLOR_PAT_MANAGER_EXTREMELY_OVERUSED]);
+            } else if (isUsed[k]>=0.4*(double)e->curSubSong->ordersLen) {
+              ImGui::PushStyleColor(ImGuiCol_Text,uiColors[GUI_COLOR_PAT_MANAGER_OVERUSED]);
+            } else if (isUsed[k]) {
+              ImGui::PushStyleColor(ImGuiCol_Text,uiColors[GUI_COLOR_PAT_MANAGER_USED]);
             } else {
-              ImGui::SetTooltip(_("Pattern %.2X\n- use count: %d (%.0f%%)\n\nright-click to erase"),k,isUsed[k],100.0*(double)isUsed[k]/(double)e->curSubSong->ordersLen);
+              ImGui::PushStyleColor(ImGuiCol_Text,uiColors[GUI_COLOR_PAT_MANAGER_UNUSED]);
+            }
+            ImGui::Selectable(id,isUsed[k]);
+            if (ImGui::IsItemHovered()) {
+              ImGui::PushFont(mainFont);
+              ImGui::PushStyleColor(ImGuiCol_Text,uiColors[GUI_COLOR_TEXT]);
+              if (isNull[k]) {
+                ImGui::SetTooltip(_("Pattern %.2X\n- not allocated"),k);
+              } else {
+                ImGui::SetTooltip(_("Pattern %.2X\n- use count: %d (%.0f%%)\n\nright-click to erase"),k,isUsed[k],100.0*(double)isUsed[k]/(double)e->curSubSong->ordersLen);
+              }
+              ImGui::PopStyleColor();
+              ImGui::PopFont();
+            }
+            if (ImGui::IsItemClicked(ImGuiMouseButton_Right)) {
+              e->lockEngine([this,i,k]() {
+                delete e->curSubSong->pat[i].data[k];
+                e->curSubSong->pat[i].data[k]=NULL;
+              });
+              MARK_MODIFIED;
             }
             ImGui::PopStyleColor();
-            ImGui::PopFont();
-          }
-          if (ImGui::IsItemClicked(ImGuiMouseButton_Right)) {
-            e->lockEngine([this,i,k]() {
-              delete e->curSubSong->pat[i].data[k];
-              e->curSubSong->pat[i].data[k]=NULL;
-            });
-            MARK_MODIFIED;
           }
-          ImGui::PopStyleColor();
+          ImGui::PopID();
         }
-        ImGui::PopID();
       }
       ImGui::PopFont();
 
@@ -411,7 +411,9 @@ inline void FurnaceGUI::patternRow(int i, bool isPlaying, float lineHeight, int
 
   if (debugRowTimestamps) {
     TimeMicros rowTS=e->curSubSong->ts.getTimes(ord,i);
-    if (rowTS.seconds==-1) {
+    if (e->isCalculatingTimestamps()) {
+      ImGui::Text("...");
+    } else if (rowTS.seconds==-1) {
       ImGui::Text("---");
     } else {
       String timeFormatted=rowTS.toString(2,TA_TIME_FORMAT_AUTO_MS_ZERO);
@@ -1914,13 +1916,17 @@ void FurnaceGUI::drawPattern() {
       }
 
       // particle simulation
-      ImDrawList* fdl=ImGui::GetWindowDrawList();
-      fdl->PushClipRectFullScreen();
-      if (!particles.empty()) WAKE_UP;
-      fdl->AddCallback(_pushPartBlend,this);
-      for (size_t i=0; i<particles.size(); i++) {
-        Particle& part=particles[i];
-        if (part.update(frameTime)) {
+      // the blend callbacks split the draw list, so they are only emitted
+      // while there are particles to draw.
+      if (!particles.empty()) {
+        ImDrawList* fdl=ImGui::GetWindowDrawList();
+        WAKE_UP;
+        fdl->PushClipRectFullScreen();
+        fdl->AddCallback(_pushPartBlend,this);
+        size_t alive=0;
+        for (size_t i=0; i<particles.size(); i++) {
+          Particle& part=particles[i];
+          if (!part.update(frameTime)) continue;
           if (part.life>255) part.life=255;
           fdl->AddText(
             iconFont,
@@ -1929,13 +1935,13 @@ void FurnaceGUI::drawPattern() {
             part.colors[(int)part.life],
             part.type
           );
-        } else {
-          particles.erase(particles.begin()+i);
-          i--;
+          if (alive!=i) particles[alive]=part;
+          alive++;
         }
+        particles.erase(particles.begin()+alive,particles.end());
+        fdl->AddCallback(_popPartBlend,this);
+        fdl->PopClipRect();
       }
-      fdl->AddCallback(_popPartBlend,this);
-      fdl->PopClipRect();
     }
 
     ImGui::PopStyleColor(3);
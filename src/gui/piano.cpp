@@ -465,10 +465,9 @@ void FurnaceGUI::drawPiano() {
                   e->stopSamplePreview();
                   break;
                 default:
-                  e->synchronized([this,note]() {
-                    e->autoNoteOff(-1,note);
-                    failedNoteOn=false;
-                  });
+                  e->stopInsPreview(note);
+                  e->queueAutoNoteOff(note);
+                  failedNoteOn=false;
                   break;
               }
             }
@@ -492,14 +491,15 @@ void FurnaceGUI::drawPiano() {
                   if (sampleMapWaitingInput) {
                     alterSampleMap(1,note);
                   } else {
-                    e->synchronized([this,note]() {
-                      if (!e->autoNoteOn(-1,curIns,note)) failedNoteOn=true;
-                      for (int mi=0; mi<7; mi++) {
-                        if (multiIns[mi]!=-1) {
-                          e->autoNoteOn(-1,multiIns[mi],note,-1,multiInsTranspose[mi]);
-                        }
+                    if (!(settings.cachedInsPreview && e->previewInsCached(curIns,note))) {
+                      e->queueAutoNoteOn(-1,curIns,note,-1,0,&failedNoteOn);
+                    }
+                    for (int mi=0; mi<7; mi++) {
+                      if (multiIns[mi]!=-1) {
+                        if (settings.cachedInsPreview && e->previewInsCached(multiIns[mi],note,multiInsTranspose[mi])) continue;
+                        e->queueAutoNoteOn(-1,multiIns[mi],note,-1,multiInsTranspose[mi]);
                       }
-                    });
+                    }
                     if (edit && curWindow!=GUI_WINDOW_INS_LIST && curWindow!=GUI_WINDOW_INS_EDIT) noteInput(note,0);
                   }
                   break;
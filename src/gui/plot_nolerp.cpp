@@ -28,6 +28,94 @@
 
 #include "../ta-utils.h"
 
+// cached plot geometry.
+// the vertices of a plot (relative to its position) are kept per widget along
+// with a hash of everything which goes into them (values, size, scale and
+// colors), and are copied into the draw list until any of that changes.
+// highlighted values (playback position) are drawn on top every frame.
+#define PLOT_CACHE_MAX 1024
+
+struct PlotCacheEntry {
+  uint64_t key;
+  std::vector<ImDrawVert> vtx;
+  std::vector<ImDrawIdx> idx;
+  PlotCacheEntry():
+    key(0) {}
+};
+
+struct PlotCacheRecord {
+  int cmdCount, vtxBegin, idxBegin;
+  unsigned int vtxCurBegin;
+};
+
+static std::unordered_map<ImGuiID,PlotCacheEntry> plotCache;
+
+static inline void plotHash(uint64_t& h, const void* data, size_t len) {
+  const unsigned char* d=(const unsigned char*)data;
+  for (size_t i=0; i<len; i++) {
+    h^=d[i];
+    h*=0x100000001b3ULL;
+  }
+}
+
+static uint64_t plotHashBegin(ImDrawList* dl, const ImRect& bb) {
+  uint64_t key=0xcbf29ce484222325ULL;
+  ImVec2 size=bb.GetSize();
+  plotHash(key,&size,sizeof(ImVec2));
+  plotHash(key,&dl->Flags,sizeof(dl->Flags));
+  plotHash(key,&dl->_FringeScale,sizeof(float));
+  plotHash(key,&dl->_Data->TexUvWhitePixel,sizeof(ImVec2));
+  return key;
+}
+
+// returns true if the plot has been drawn from the cache
+static bool plotCacheDraw(ImDrawList* dl, ImGuiID id, uint64_t key, const ImVec2& origin) {
+  auto it=plotCache.find(id);
+  if (it==plotCache.end()) return false;
+  PlotCacheEntry& cached=it->second;
+  if (cached.key!=key) return false;
+
+  dl->PrimReserve(cached.idx.size(),cached.vtx.size());
+  ImDrawIdx base=dl->_VtxCurrentIdx;
+  for (const ImDrawVert& v: cached.vtx) {
+    *dl->_VtxWritePtr=v;
+    dl->_VtxWritePtr->pos.x+=origin.x;
+    dl->_VtxWritePtr->pos.y+=origin.y;
+    dl->_VtxWritePtr++;
+  }
+  for (ImDrawIdx idx: cached.idx) {
+    *dl->_IdxWritePtr++=base+idx;
+  }
+  dl->_VtxCurrentIdx+=cached.vtx.size();
+  return true;
+}
+
+static void plotCacheBegin(ImDrawList* dl, PlotCacheRecord& rec) {
+  rec.cmdCount=dl->CmdBuffer.Size;
+  rec.vtxBegin=dl->VtxBuffer.Size;
+  rec.idxBegin=dl->IdxBuffer.Size;
+  rec.vtxCurBegin=dl->_VtxCurrentIdx;
+}
+
+static void plotCacheEnd(ImDrawList* dl, const PlotCacheRecord& rec, ImGuiID id, uint64_t key, const ImVec2& origin) {
+  // only store the vertices if they all ended up in the same draw command
+  if (dl->CmdBuffer.Size!=rec.cmdCount) return;
+  if (dl->_VtxCurrentIdx-rec.vtxCurBegin!=(unsigned int)(dl->VtxBuffer.Size-rec.vtxBegin)) return;
+
+  if (plotCache.size()>=PLOT_CACHE_MAX && plotCache.find(id)==plotCache.end()) plotCache.clear();
+  PlotCacheEntry& entry=plotCache[id];
+  entry.key=key;
+  entry.vtx.assign(dl->VtxBuffer.Data+rec.vtxBegin,dl->VtxBuffer.Data+dl->VtxBuffer.Size);
+  for (ImDrawVert& v: entry.vtx) {
+    v.pos.x-=origin.x;
+    v.pos.y-=origin.y;
+  }
+  entry.idx.resize(dl->IdxBuffer.Size-rec.idxBegin);
+  for (int k=rec.idxBegin; k<dl->IdxBuffer.Size; k++) {
+    entry.idx[k-rec.idxBegin]=dl->IdxBuffer.Data[k]-rec.vtxCurBegin;
+  }
+}
+
 struct FurnacePlotArrayGetterData
 {
     const float* Values;
@@ -135,7 +223,25 @@ int PlotNoLerpEx(ImGuiPlotType plot_type, const char* label, float (*values_gett
         const ImU32 col_base = ImGui::GetColorU32((plot_type == ImGuiPlotType_Lines) ? ImGuiCol_PlotLines : ImGuiCol_PlotHistogram);
         const ImU32 col_hovered = ImGui::GetColorU32((plot_type == ImGuiPlotType_Lines) ? ImGuiCol_PlotLinesHovered : ImGuiCol_PlotHistogramHovered);
 
-        for (int n = 1; n <= res_w; n++)
+        uint64_t key=plotHashBegin(window->DrawList,inner_bb);
+        plotHash(key,&plot_type,sizeof(plot_type));
+        plotHash(key,&values_count,sizeof(int));
+        plotHash(key,&values_offset,sizeof(int));
+        plotHash(key,&scale_min,sizeof(float));
+        plotHash(key,&scale_max,sizeof(float));
+        plotHash(key,&col_base,sizeof(ImU32));
+        plotHash(key,&col_hovered,sizeof(ImU32));
+        plotHash(key,&idx_hovered,sizeof(int));
+        for (int i = 0; i < values_count; i++)
+        {
+            const float v = values_getter(data, i);
+            plotHash(key,&v,sizeof(float));
+        }
+        const bool cached=plotCacheDraw(window->DrawList,id,key,inner_bb.Min);
+        PlotCacheRecord rec;
+        plotCacheBegin(window->DrawList,rec);
+
+        for (int n = 1; n <= res_w && !cached; n++)
         {
             const float t1 = t0 + t_step;
             const int v1_idx = (int)(t0 * item_count + 0.5f);
@@ -166,6 +272,7 @@ int PlotNoLerpEx(ImGuiPlotType plot_type, const char* label, float (*values_gett
             t0 = t1;
             tp0 = tp1;
         }
+        if (!cached) plotCacheEnd(window->DrawList,rec,id,key,inner_bb.Min);
     }
 
     // Text overlay
@@ -243,38 +350,60 @@ int PlotBitfieldEx(const char* label, int (*values_getter)(void* data, int idx),
 
         const float t_step = 1.0f / (float)res_w;
 
-        float t0 = 0.0f;
-        ImVec2 tp0 = ImVec2( t0, 0.0f );                       // Point in the normalized space of our target rectangle
         const ImU32 col_base = ImGui::GetColorU32(color);
-        const ImU32 col_hovered = ImGui::GetColorU32(color);
+        const ImU32 col_highlight = ImGui::GetColorU32(highlightColor);
 
-        for (int n = 0; n < res_w; n++)
+        uint64_t key=plotHashBegin(window->DrawList,inner_bb);
+        plotHash(key,&values_count,sizeof(int));
+        plotHash(key,&values_offset,sizeof(int));
+        plotHash(key,&bits,sizeof(int));
+        plotHash(key,&col_base,sizeof(ImU32));
+        for (int i = 0; i < values_count; i++)
         {
-          const float t1 = t0 + t_step;
-          const int v1_idx = (int)(t0 * item_count + 0.5f);
-          IM_ASSERT(v1_idx >= 0 && v1_idx < values_count);
-          const int v1 = values_getter(data, (v1_idx + values_offset) % values_count);
-          ImVec2 tp1 = ImVec2( t1, 0.0f );
-          for (int o = 0; o < bits; o++) {
-            tp0.y=float(bits-o)/float(bits);
-            tp1.y=float(bits-o-1)/float(bits);
-            // NB: Draw calls are merged together by the DrawList system. Still, we should render our batch are lower level to save a bit of CPU.
-            ImVec2 pos0 = ImLerp(inner_bb.Min, inner_bb.Max, tp0);
-            ImVec2 pos1 = ImLerp(inner_bb.Min, inner_bb.Max, tp1);
-            if (pos1.x >= pos0.x + 2.0f)
-                pos1.x -= 1.0f;
-            if (pos1.y <= pos0.y - 2.0f)
-              pos1.y += 1.0f;
-            if (v1&(1<<o)) {
-              ImU32 rCol=(idx_hovered == v1_idx ? col_hovered : col_base);
-              if (values_highlight!=NULL) {
-                if (values_highlight[v1_idx]) rCol=ImGui::GetColorU32(highlightColor);
+            const int v = values_getter(data, i);
+            plotHash(key,&v,sizeof(int));
+        }
+        PlotCacheRecord rec;
+
+        // pass 0 draws the plot (unless it is cached) and pass 1 the highlighted values on top
+        for (int pass = plotCacheDraw(window->DrawList,id,key,inner_bb.Min)?1:0; pass < 2; pass++)
+        {
+          if (pass == 0)
+            plotCacheBegin(window->DrawList,rec);
+          else if (values_highlight == NULL)
+            break;
+
+          float t0 = 0.0f;
+          ImVec2 tp0 = ImVec2( t0, 0.0f );                       // Point in the normalized space of our target rectangle
+          for (int n = 0; n < res_w; n++)
+          {
+            const float t1 = t0 + t_step;
+            const int v1_idx = (int)(t0 * item_count + 0.5f);
+            IM_ASSERT(v1_idx >= 0 && v1_idx < values_count);
+            ImVec2 tp1 = ImVec2( t1, 0.0f );
+            if (pass == 0 || values_highlight[v1_idx]) {
+              const int v1 = values_getter(data, (v1_idx + values_offset) % values_count);
+              for (int o = 0; o < bits; o++) {
+                tp0.y=float(bits-o)/float(bits);
+                tp1.y=float(bits-o-1)/float(bits);
+                // NB: Draw calls are merged together by the DrawList system. Still, we should render our batch are lower level to save a bit of CPU.
+                ImVec2 pos0 = ImLerp(inner_bb.Min, inner_bb.Max, tp0);
+                ImVec2 pos1 = ImLerp(inner_bb.Min, inner_bb.Max, tp1);
+                if (pos1.x >= pos0.x + 2.0f)
+                    pos1.x -= 1.0f;
+                if (pos1.y <= pos0.y - 2.0f)
+                  pos1.y += 1.0f;
+                if (v1&(1<<o)) {
+                  window->DrawList->AddRectFilled(pos0, pos1, (pass == 0) ? col_base : col_highlight);
+                }
               }
-              window->DrawList->AddRectFilled(pos0, pos1, rCol);
             }
+            tp0 = tp1;
+            t0 = t1;
           }
-          tp0 = tp1;
-          t0 = t1;
+
+          if (pass == 0)
+            plotCacheEnd(window->DrawList,rec,id,key,inner_bb.Min);
         }
     }
 
@@ -389,80 +518,116 @@ int PlotCustomEx(ImGuiPlotType plot_type, const char* label, float (*values_gett
         const float t_step = 1.0f / (float)res_w;
         const float inv_scale = (scale_min == scale_max) ? 0.0f : (1.0f / (scale_max - scale_min));
 
-        float v0 = values_getter(data, (0) % values_count);
-        float t0 = 0.0f;
-        ImVec2 tp0 = ImVec2( t0, 1.0f - ImSaturate((v0 - scale_min) * inv_scale) );                       // Point in the normalized space of our target rectangle
         float histogram_zero_line_t = (scale_min * scale_max < 0.0f) ? (1 + (blockMode?(scale_min-0.5):scale_min) * inv_scale) : (scale_min < 0.0f ? 0.0f : 1.0f);   // Where does the zero line stands
 
         const ImU32 col_base = ImGui::GetColorU32(color);
-        const ImU32 col_hovered = ImGui::GetColorU32(color);
-
-        if (highlight>0) {
-          window->DrawList->AddRectFilled(
-            ImVec2(ImLerp(inner_bb.Min, inner_bb.Max, ImVec2(0,0))),
-            ImVec2(ImLerp(inner_bb.Min, inner_bb.Max, ImVec2((highlight>=values_count)?1:(double(highlight)/double(values_count)),1))),
-            bgColor);
-        }
-
-        if (blockMode) {
-          window->DrawList->AddLine(ImLerp(inner_bb.Min,inner_bb.Max,ImVec2(0.0f,histogram_zero_line_t)),ImLerp(inner_bb.Min,inner_bb.Max,ImVec2(1.0f,histogram_zero_line_t)),col_base);
+        const ImU32 col_highlight = ImGui::GetColorU32(highlightColor);
+
+        uint64_t key=plotHashBegin(window->DrawList,inner_bb);
+        plotHash(key,&plot_type,sizeof(plot_type));
+        plotHash(key,&values_count,sizeof(int));
+        plotHash(key,&scale_min,sizeof(float));
+        plotHash(key,&scale_max,sizeof(float));
+        plotHash(key,&col_base,sizeof(ImU32));
+        plotHash(key,&bgColor,sizeof(ImU32));
+        plotHash(key,&highlight,sizeof(int));
+        plotHash(key,&blockMode,sizeof(bool));
+        plotHash(key,&frame_size,sizeof(ImVec2));
+        for (int i = 0; i < values_count; i++)
+        {
+            const float v = values_getter(data, i);
+            plotHash(key,&v,sizeof(float));
         }
+        PlotCacheRecord rec;
 
-        ImVec2 chevron[3];
-
-        for (int n = 0; n < res_w; n++)
+        // pass 0 draws the plot (unless it is cached) and pass 1 the highlighted values on top
+        for (int pass = plotCacheDraw(window->DrawList,id,key,inner_bb.Min)?1:0; pass < 2; pass++)
         {
-            const float t1 = t0 + t_step;
-            const int v1_idx = (int)(t0 * item_count + 0.5f);
-            IM_ASSERT(v1_idx >= 0 && v1_idx < values_count);
-            const float v1 = values_getter(data, (v1_idx + 1) % values_count);
-            const ImVec2 tp1 = ImVec2( t1, 1.0f - ImSaturate((v1 - scale_min) * inv_scale) );
+          if (pass == 0) {
+            plotCacheBegin(window->DrawList,rec);
+
+            if (highlight>0) {
+              window->DrawList->AddRectFilled(
+                ImVec2(ImLerp(inner_bb.Min, inner_bb.Max, ImVec2(0,0))),
+                ImVec2(ImLerp(inner_bb.Min, inner_bb.Max, ImVec2((highlight>=values_count)?1:(double(highlight)/double(values_count)),1))),
+                bgColor);
+            }
 
-            // NB: Draw calls are merged together by the DrawList system. Still, we should render our batch are lower level to save a bit of CPU.
-            ImVec2 pos0 = ImLerp(inner_bb.Min, inner_bb.Max, tp0);
-            ImVec2 pos1 = ImLerp(inner_bb.Min, inner_bb.Max, (plot_type == ImGuiPlotType_Lines) ? tp1 : ImVec2(tp1.x, blockMode?tp0.y:histogram_zero_line_t));
-            if (plot_type == ImGuiPlotType_Lines)
-            {
-                window->DrawList->AddLine(pos0, pos1, idx_hovered == v1_idx ? col_hovered : col_base);
+            if (blockMode) {
+              window->DrawList->AddLine(ImLerp(inner_bb.Min,inner_bb.Max,ImVec2(0.0f,histogram_zero_line_t)),ImLerp(inner_bb.Min,inner_bb.Max,ImVec2(1.0f,histogram_zero_line_t)),col_base);
             }
-            else if (plot_type == ImGuiPlotType_Histogram)
-            {
-                if (pos1.x >= pos0.x + 2.0f)
-                    pos1.x -= 1.0f;
-                if (blockMode) {
-                  pos0.y-=(inner_bb.Max.y-inner_bb.Min.y)*inv_scale;
-                  //pos1.y+=1.0f;
-                }
-                ImU32 rCol=(idx_hovered == v1_idx ? col_hovered : col_base);
-                if (values_highlight!=NULL) {
-                  if (values_highlight[v1_idx]) rCol=ImGui::GetColorU32(highlightColor);
-                }
-                if (blockMode) {
-                  if ((int)v0>=(int)(scale_max+0.5)) {
-                    float chScale=(pos1.x-pos0.x)*0.125;
-                    if (chScale>frame_size.y*0.05) chScale=frame_size.y*0.05;
-                    chevron[0]=ImVec2((pos1.x+pos0.x)*0.5-(2.0f*chScale),pos1.y+4.0f*chScale);
-                    chevron[1]=ImVec2((pos1.x+pos0.x)*0.5,pos1.y+2.0f*chScale);
-                    chevron[2]=ImVec2((pos1.x+pos0.x)*0.5+(2.0f*chScale),pos1.y+4.0f*chScale);
-                    window->DrawList->AddPolyline(chevron, 3, rCol, 0, chScale);
-                  } else if ((int)v0<(int)(scale_min)) {
-                    float chScale=(pos1.x-pos0.x)*0.125;
-                    if (chScale>frame_size.y*0.05) chScale=frame_size.y*0.05;
-                    chevron[0]=ImVec2((pos1.x+pos0.x)*0.5-(2.0f*chScale),pos1.y-4.0f*chScale);
-                    chevron[1]=ImVec2((pos1.x+pos0.x)*0.5,pos1.y-2.0f*chScale);
-                    chevron[2]=ImVec2((pos1.x+pos0.x)*0.5+(2.0f*chScale),pos1.y-4.0f*chScale);
-                    window->DrawList->AddPolyline(chevron, 3, rCol, 0, chScale);
+          } else if (values_highlight == NULL) {
+            break;
+          }
+
+          ImVec2 chevron[3];
+
+          float v0 = values_getter(data, (0) % values_count);
+          float t0 = 0.0f;
+          ImVec2 tp0 = ImVec2( t0, 1.0f - ImSaturate((v0 - scale_min) * inv_scale) );                       // Point in the normalized space of our target rectangle
+
+          for (int n = 0; n < res_w; n++)
+          {
+              const float t1 = t0 + t_step;
+              const int v1_idx = (int)(t0 * item_count + 0.5f);
+              IM_ASSERT(v1_idx >= 0 && v1_idx < values_count);
+              const float v1 = values_getter(data, (v1_idx + 1) % values_count);
+              const ImVec2 tp1 = ImVec2( t1, 1.0f - ImSaturate((v1 - scale_min) * inv_scale) );
+
+              if (pass == 1 && !values_highlight[v1_idx])
+              {
+                  t0 = t1;
+                  tp0 = tp1;
+                  v0 = v1;
+                  continue;
+              }
+              const ImU32 rCol = (pass == 0) ? col_base : col_highlight;
+
+              // NB: Draw calls are merged together by the DrawList system. Still, we should render our batch are lower level to save a bit of CPU.
+              ImVec2 pos0 = ImLerp(inner_bb.Min, inner_bb.Max, tp0);
+              ImVec2 pos1 = ImLerp(inner_bb.Min, inner_bb.Max, (plot_type == ImGuiPlotType_Lines) ? tp1 : ImVec2(tp1.x, blockMode?tp0.y:histogram_zero_line_t));
+              if (plot_type == ImGuiPlotType_Lines)
+              {
+                  window->DrawList->AddLine(pos0, pos1, rCol);
+              }
+              else if (plot_type == ImGuiPlotType_Histogram)
+              {
+                  if (pos1.x >= pos0.x + 2.0f)
+                      pos1.x -= 1.0f;
+                  if (blockMode) {
+                    pos0.y-=(inner_bb.Max.y-inner_bb.Min.y)*inv_scale;
+                    //pos1.y+=1.0f;
+                  }
+                  if (blockMode) {
+                    if ((int)v0>=(int)(scale_max+0.5)) {
+                      float chScale=(pos1.x-pos0.x)*0.125;
+                      if (chScale>frame_size.y*0.05) chScale=frame_size.y*0.05;
+                      chevron[0]=ImVec2((pos1.x+pos0.x)*0.5-(2.0f*chScale),pos1.y+4.0f*chScale);
+                      chevron[1]=ImVec2((pos1.x+pos0.x)*0.5,pos1.y+2.0f*chScale);
+                      chevron[2]=ImVec2((pos1.x+pos0.x)*0.5+(2.0f*chScale),pos1.y+4.0f*chScale);
+                      window->DrawList->AddPolyline(chevron, 3, rCol, 0, chScale);
+                    } else if ((int)v0<(int)(scale_min)) {
+                      float chScale=(pos1.x-pos0.x)*0.125;
+                      if (chScale>frame_size.y*0.05) chScale=frame_size.y*0.05;
+                      chevron[0]=ImVec2((pos1.x+pos0.x)*0.5-(2.0f*chScale),pos1.y-4.0f*chScale);
+                      chevron[1]=ImVec2((pos1.x+pos0.x)*0.5,pos1.y-2.0f*chScale);
+                      chevron[2]=ImVec2((pos1.x+pos0.x)*0.5+(2.0f*chScale),pos1.y-4.0f*chScale);
+                      window->DrawList->AddPolyline(chevron, 3, rCol, 0, chScale);
+                    } else {
+                      window->DrawList->AddRectFilled(pos0, pos1, rCol);
+                    }
                   } else {
                     window->DrawList->AddRectFilled(pos0, pos1, rCol);
                   }
-                } else {
-                  window->DrawList->AddRectFilled(pos0, pos1, rCol);
-                }
-            }
+              }
 
-            t0 = t1;
-            tp0 = tp1;
-            v0 = v1;
+              t0 = t1;
+              tp0 = tp1;
+              v0 = v1;
+          }
+
+          if (pass == 0)
+            plotCacheEnd(window->DrawList,rec,id,key,inner_bb.Min);
         }
     }
 
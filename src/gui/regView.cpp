@@ -20,6 +20,38 @@
 #include "gui.h"
 #include <imgui.h>
 
+// how long a write stays highlighted (in seconds)
+#define REG_VIEW_HEATMAP_TIME 1.0
+
+// format the cells which changed since the last frame
+static void updateRegViewCache(FurnaceGUIRegViewCache& cache, int sys, const unsigned char* pool, int size, int depth, double now) {
+  bool reset=(cache.sys!=sys || cache.size!=size || cache.depth!=depth);
+  if (reset) {
+    cache.sys=sys;
+    cache.size=size;
+    cache.depth=depth;
+    cache.values.assign(size,0);
+    cache.text.assign(size*5,0);
+    cache.lastChange.assign(size,-1.0);
+  }
+  const unsigned short* poolW=(const unsigned short*)pool;
+  for (int i=0; i<size; i++) {
+    unsigned short val=(depth==16)?poolW[i]:pool[i];
+    if (!reset && val==cache.values[i]) continue;
+    cache.values[i]=val;
+    if (!reset) cache.lastChange[i]=now;
+
+    char* t=&cache.text[i*5];
+    if (depth==8) {
+      snprintf(t,5,"%.2x",val);
+    } else if (depth==16) {
+      snprintf(t,5,"%.4x",val);
+    } else {
+      strncpy(t,"??",5);
+    }
+  }
+}
+
 namespace {
 constexpr int kEsfmOpRegs = 8;
 constexpr int kEsfmChanStride = 32;
@@ -81,6 +113,23 @@ void FurnaceGUI::drawRegView() {
   }
   if (!regViewOpen) return;
   if (ImGui::Begin("Register View",&regViewOpen,globalWinFlags,_("Register View"))) {
+    ImGui::Checkbox(_("Highlight recent writes"),&regViewHeatmap);
+    const double now=ImGui::GetTime();
+
+    // use a consistent copy of all chips if the audio thread published one.
+    // otherwise (e.g. no audio output) read the live pools.
+    const bool haveSnap=e->getRegisterPoolSnapshot(regViewSnap);
+    auto getPool=[this,haveSnap](int sys, int& size, int& depth) -> const unsigned char* {
+      if (haveSnap && sys>=0 && sys<(int)regViewSnap.size()) {
+        const DivRegPoolSnapshot& snap=regViewSnap[sys];
+        if (snap.size<=0) return NULL;
+        size=snap.size;
+        depth=snap.depth;
+        return snap.data.data();
+      }
+      return e->getRegisterPool(sys,size,depth);
+    };
+
     if (ImGui::CollapsingHeader(_("SGU/ESFM ch0 operator compare"), ImGuiTreeNodeFlags_DefaultOpen)) {
       static String sguEsfmDump;
       const int sguSys = findSystemIndex(e->song, DIV_SYSTEM_SGU);
@@ -92,8 +141,8 @@ void FurnaceGUI::drawRegView() {
         int esfmSize = 0;
         int sguDepth = 8;
         int esfmDepth = 8;
-        unsigned char* sguPool = e->getRegisterPool(sguSys, sguSize, sguDepth);
-        unsigned char* esfmPool = e->getRegisterPool(esfmSys, esfmSize, esfmDepth);
+        const unsigned char* sguPool = getPool(sguSys, sguSize, sguDepth);
+        const unsigned char* esfmPool = getPool(esfmSys, esfmSize, esfmDepth);
         if (sguPool == NULL || esfmPool == NULL || sguDepth != 8 || esfmDepth != 8) {
           ImGui::TextUnformatted(_("Register pool unavailable for SGU/ESFM."));
         } else {
@@ -121,11 +170,12 @@ void FurnaceGUI::drawRegView() {
       ImGui::Text("%d. %s",i+1,getSystemName(e->song.system[i]));
       int size=0;
       int depth=8;
-      unsigned char* regPool=e->getRegisterPool(i,size,depth);
-      unsigned short* regPoolW=(unsigned short*)regPool;
+      const unsigned char* regPool=getPool(i,size,depth);
       if (regPool==NULL) {
         ImGui::Text(_("- no register pool available"));
       } else {
+        FurnaceGUIRegViewCache& cache=regViewCache[i];
+        updateRegViewCache(cache,e->song.system[i],regPool,size,depth,now);
         ImGui::PushFont(patFont);
         if (ImGui::BeginTable("Memory",17)) {
           float widthOne=ImGui::CalcTextSize("0").x;
@@ -143,19 +193,27 @@ void FurnaceGUI::drawRegView() {
             ImGui::TableNextColumn();
             ImGui::TextColored(uiColors[GUI_COLOR_PATTERN_ROW_INDEX]," %X",i);
           }
-          for (int i=0; i<=((size-1)>>4); i++) {
-            ImGui::TableNextRow();
-            ImGui::TableNextColumn();
-            ImGui::TextColored(uiColors[GUI_COLOR_PATTERN_ROW_INDEX],"%.2X",i*16);
-            for (int j=0; j<16; j++) {
+          ImGuiListClipper clipper;
+          clipper.Begin(((size-1)>>4)+1);
+          while (clipper.Step()) {
+            for (int row=clipper.DisplayStart; row<clipper.DisplayEnd; row++) {
+              ImGui::TableNextRow();
               ImGui::TableNextColumn();
-              if (i*16+j>=size) continue;
-              if (depth == 8) {
-                ImGui::Text("%.2x",regPool[i*16+j]);
-              } else if (depth == 16) {
-                ImGui::Text("%.4x",regPoolW[i*16+j]);
-              } else {
-                ImGui::Text("??");
+              ImGui::TextColored(uiColors[GUI_COLOR_PATTERN_ROW_INDEX],"%.2X",row*16);
+              for (int j=0; j<16; j++) {
+                ImGui::TableNextColumn();
+                const int cell=row*16+j;
+                if (cell>=size) continue;
+                if (regViewHeatmap && cache.lastChange[cell]>=0.0) {
+                  float age=(now-cache.lastChange[cell])/REG_VIEW_HEATMAP_TIME;
+                  if (age<1.0f) {
+                    ImVec4 heatColor=uiColors[GUI_COLOR_ACCENT_PRIMARY];
+                    heatColor.w*=0.6f*(1.0f-age);
+                    ImGui::TableSetBgColor(ImGuiTableBgTarget_CellBg,ImGui::GetColorU32(heatColor));
+                    WAKE_UP;
+                  }
+                }
+                ImGui::TextUnformatted(&cache.text[cell*5]);
               }
             }
           }
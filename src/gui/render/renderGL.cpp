@@ -112,7 +112,7 @@ const char* sh_oscRender_srcF=
   "  float valmax=-1024.0;\n"
   "  float valmin=1024.0;\n"
   "  for (float x=floor(fur_fragCoord.x-uLineWidth); x<=xMax; x+=1.0) {\n"
-  "    float val=texture2D(oscVal,vec2(x*oneStep,1.0)).x;\n"
+  "    float val=texture2D(oscVal,vec2(floor(x*uResolution.x)*oneStep,1.0)).x;\n"
   "    if (val>valmax) valmax=val;\n"
   "    if (val<valmin) valmin=val;\n"
   "  }\n"
@@ -123,9 +123,10 @@ const char* sh_oscRender_srcF=
   "  float slopeDiv=min(1.0,1.0/slopeMul);\n"
   "  float xRight=ceil(fur_fragCoord.x+uLineWidth);\n"
   "  for (float x=max(0.0,floor(fur_fragCoord.x-uLineWidth)); x<=xRight; x+=slopeDiv) {\n"
-  "    float val0=texture2D(oscVal,vec2(floor(x)*oneStep,1.0)).x;\n"
-  "    float val1=texture2D(oscVal,vec2(floor(x+1.0)*oneStep,1.0)).x;\n"
-  "    float val=mix(val0,val1,fract(x))*uResolution.y;\n"
+  "    float pos=x*uResolution.x;\n"
+  "    float val0=texture2D(oscVal,vec2(floor(pos)*oneStep,1.0)).x;\n"
+  "    float val1=texture2D(oscVal,vec2(floor(pos+1.0)*oneStep,1.0)).x;\n"
+  "    float val=mix(val0,val1,fract(pos))*uResolution.y;\n"
   "    alpha+=clamp(uLineWidth-distance(vec2(fur_fragCoord.x,fur_fragCoord.y),vec2(x,val)),0.0,1.0);\n"
   "  }\n"
   "  if (slope>1.0) {\n"
@@ -189,7 +190,7 @@ const char* sh_oscRender_srcF=
   "  float valmax=-1024.0;\n"
   "  float valmin=1024.0;\n"
   "  for (float x=floor(fur_fragCoord.x-uLineWidth); x<=xMax; x+=1.0) {\n"
-  "    float val=texelFetch(oscVal,int(x),0).x;\n"
+  "    float val=texelFetch(oscVal,int(x*uResolution.x),0).x;\n"
   "    if (val>valmax) valmax=val;\n"
   "    if (val<valmin) valmin=val;\n"
   "  }\n"
@@ -200,9 +201,10 @@ const char* sh_oscRender_srcF=
   "  float slopeDiv=min(1.0,1.0/slopeMul);\n"
   "  float xRight=ceil(fur_fragCoord.x+uLineWidth);\n"
   "  for (float x=max(0.0,floor(fur_fragCoord.x-uLineWidth)); x<=xRight; x+=slopeDiv) {\n"
-  "    float val0=texelFetch(oscVal,int(x),0).x;\n"
-  "    float val1=texelFetch(oscVal,int(x)+1,0).x;\n"
-  "    float val=mix(val0,val1,fract(x))*uResolution.y;\n"
+  "    float pos=x*uResolution.x;\n"
+  "    float val0=texelFetch(oscVal,int(pos),0).x;\n"
+  "    float val1=texelFetch(oscVal,int(pos)+1,0).x;\n"
+  "    float val=mix(val0,val1,fract(pos))*uResolution.y;\n"
   "    alpha+=max(uLineWidth-distance(vec2(fur_fragCoord.x,fur_fragCoord.y),vec2(x,val)),0.0);\n"
   "  }\n"
   "  if (slope>1.0) {\n"
@@ -467,8 +469,11 @@ void FurnaceGUIRenderGL::drawOsc(float* data, size_t len, ImVec2 pos0, ImVec2 po
   //C(glBlendFunc(GL_SRC_ALPHA,GL_ONE_MINUS_SRC_ALPHA));
   //C(glEnable(GL_BLEND));
 
-  //float width=fabs(pos1.x-pos0.x);
+  // the shader works in units of one sample, or one pixel if there are fewer samples than pixels.
+  // in the latter case it interpolates between samples.
+  float width=fabs(pos1.x-pos0.x);
   float height=fabs(pos1.y-pos0.y)*0.5;
+  float xRange=((float)len<width)?width:(float)len;
 
   pos0.x=(2.0f*pos0.x/canvasSize.x)-1.0f;
   pos0.y=1.0f-(2.0f*pos0.y/canvasSize.y);
@@ -481,7 +486,7 @@ void FurnaceGUIRenderGL::drawOsc(float* data, size_t len, ImVec2 pos0, ImVec2 po
   oscVertex[0][3]=-height;
   oscVertex[1][0]=pos1.x;
   oscVertex[1][1]=pos1.y;
-  oscVertex[1][2]=(float)len;
+  oscVertex[1][2]=xRange;
   oscVertex[1][3]=-height;
   oscVertex[2][0]=pos0.x;
   oscVertex[2][1]=pos0.y;
@@ -489,7 +494,7 @@ void FurnaceGUIRenderGL::drawOsc(float* data, size_t len, ImVec2 pos0, ImVec2 po
   oscVertex[2][3]=height;
   oscVertex[3][0]=pos1.x;
   oscVertex[3][1]=pos0.y;
-  oscVertex[3][2]=(float)len;
+  oscVertex[3][2]=xRange;
   oscVertex[3][3]=height;
 
   C(glGetIntegerv(GL_ARRAY_BUFFER_BINDING,&lastArrayBuf));
@@ -512,7 +517,7 @@ void FurnaceGUIRenderGL::drawOsc(float* data, size_t len, ImVec2 pos0, ImVec2 po
   } else {
     C(furUniform1f(sh_oscRender_uLineWidth,0.5+lineWidth*0.5));
   }
-  C(furUniform2f(sh_oscRender_uResolution,2048.0f,height));
+  C(furUniform2f(sh_oscRender_uResolution,(float)len/xRange,height));
   C(furUniform1i(sh_oscRender_oscVal,0));
 
   C(glDrawArrays(GL_TRIANGLE_STRIP,0,4));
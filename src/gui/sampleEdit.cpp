@@ -1154,18 +1154,9 @@ void FurnaceGUI::drawSampleEdit() {
         }
         ImGui::Combo(_("Filter"),&resampleStrat,LocalizedComboGetter,resampleStrats,6);
         if (ImGui::Button(_("Resample"))) {
-          sample->prepareUndo(true);
-          e->lockEngine([this,sample,targetRate]() {
-            if (!sample->resample(targetRate,resampleTarget,resampleStrat)) {
-              showError(_("couldn't resample! make sure your sample is 8 or 16-bit and that the target rate is at least 100Hz."));
-            }
-            e->renderSamples(curSample);
-          });
-          updateSampleTex=true;
-          notifySampleChange=true;
-          sampleSelStart=-1;
-          sampleSelEnd=-1;
-          MARK_MODIFIED;
+          if (!startResample(sample,targetRate,resampleTarget,resampleStrat)) {
+            showError(_("couldn't resample! make sure your sample is 8 or 16-bit and that the target rate is at least 100Hz."));
+          }
           ImGui::CloseCurrentPopup();
         }
         ImGui::EndPopup();
@@ -1418,51 +1409,56 @@ void FurnaceGUI::drawSampleEdit() {
 
         if (ImGui::Button(_("Apply"))) {
           sample->prepareUndo(true);
-          e->lockEngine([this,sample]() {
-            SAMPLE_OP_BEGIN;
-            float res=1.0-pow(sampleFilterRes,0.5f);
-            float low=0;
-            float band=0;
-            float high=0;
-
-            if (sampleFilterCutStart<0.0) sampleFilterCutStart=0.0;
-            if (sampleFilterCutStart>sample->centerRate*0.5) sampleFilterCutStart=sample->centerRate*0.5;
-            if (sampleFilterCutEnd<0.0) sampleFilterCutEnd=0.0;
-            if (sampleFilterCutEnd>sample->centerRate*0.5) sampleFilterCutEnd=sample->centerRate*0.5;
+          SAMPLE_OP_BEGIN;
+          float res=1.0-pow(sampleFilterRes,0.5f);
+          float low=0;
+          float band=0;
+          float high=0;
 
-            double power=(sampleFilterCutStart>sampleFilterCutEnd)?0.5:2.0;
+          if (sampleFilterCutStart<0.0) sampleFilterCutStart=0.0;
+          if (sampleFilterCutStart>sample->centerRate*0.5) sampleFilterCutStart=sample->centerRate*0.5;
+          if (sampleFilterCutEnd<0.0) sampleFilterCutEnd=0.0;
+          if (sampleFilterCutEnd>sample->centerRate*0.5) sampleFilterCutEnd=sample->centerRate*0.5;
 
-            if (sample->depth==DIV_SAMPLE_DEPTH_16BIT) {
-              for (unsigned int i=start; i<end; i++) {
-                double freq=sampleFilterCutStart+(sampleFilterSweep?((sampleFilterCutEnd-sampleFilterCutStart)*pow(double(i-start)/double(end-start),power)):0);
-                double cut=sin((freq/double(sample->centerRate))*M_PI);
+          double power=(sampleFilterCutStart>sampleFilterCutEnd)?0.5:2.0;
+          double cut=sin((sampleFilterCutStart/double(sample->centerRate))*M_PI);
+          bool is16=(sample->depth==DIV_SAMPLE_DEPTH_16BIT);
+          float minVal=is16?-32768:-128;
+          float maxVal=is16?32767:127;
 
-                for (int j=0; j<sampleFilterPower; j++) {
-                  low=low+cut*band;
-                  high=float(sample->data16[i])-low-(res*band);
-                  band=cut*high+band;
-                }
+          // the filter only reads the sample, so it runs outside of the engine lock.
+          // the lock is only held while the result is copied back.
+          std::vector<float> filtered;
+          if (is16 || sample->depth==DIV_SAMPLE_DEPTH_8BIT) {
+            filtered.resize(end-start);
+            for (unsigned int i=start; i<end; i++) {
+              if (sampleFilterSweep) {
+                double freq=sampleFilterCutStart+(sampleFilterCutEnd-sampleFilterCutStart)*pow(double(i-start)/double(end-start),power);
+                cut=sin((freq/double(sample->centerRate))*M_PI);
+              }
+              float in=is16?float(sample->data16[i]):float(sample->data8[i]);
 
-                float val=low*sampleFilterL+band*sampleFilterB+high*sampleFilterH;
-                if (val<-32768) val=-32768;
-                if (val>32767) val=32767;
-                sample->data16[i]=val;
+              for (int j=0; j<sampleFilterPower; j++) {
+                low=low+cut*band;
+                high=in-low-(res*band);
+                band=cut*high+band;
               }
-            } else if (sample->depth==DIV_SAMPLE_DEPTH_8BIT) {
-              for (unsigned int i=start; i<end; i++) {
-                double freq=sampleFilterCutStart+(sampleFilterSweep?((sampleFilterCutEnd-sampleFilterCutStart)*pow(double(i-start)/double(end-start),power)):0);
-                double cut=sin((freq/double(sample->centerRate))*M_PI);
 
-                for (int j=0; j<sampleFilterPower; j++) {
-                  low=low+cut*band;
-                  high=float(sample->data8[i])-low-(res*band);
-                  band=cut*high+band;
-                }
+              float val=low*sampleFilterL+band*sampleFilterB+high*sampleFilterH;
+              if (val<minVal) val=minVal;
+              if (val>maxVal) val=maxVal;
+              filtered[i-start]=val;
+            }
+          }
 
-                float val=low*sampleFilterL+band*sampleFilterB+high*sampleFilterH;
-                if (val<-128) val=-128;
-                if (val>127) val=127;
-                sample->data8[i]=val;
+          e->lockEngine([this,sample,start,&filtered]() {
+            if (sample->depth==DIV_SAMPLE_DEPTH_16BIT) {
+              for (size_t i=0; i<filtered.size(); i++) {
+                sample->data16[start+i]=filtered[i];
+              }
+            } else if (sample->depth==DIV_SAMPLE_DEPTH_8BIT) {
+              for (size_t i=0; i<filtered.size(); i++) {
+                sample->data8[start+i]=filtered[i];
               }
             }
 
@@ -1744,7 +1740,9 @@ void FurnaceGUI::drawSampleEdit() {
       }
 
       if (sampleTex!=NULL) {
-        if (updateSampleTex) {
+        if (sampleSummary.poll()) updateSampleTex=true;
+        // sample data may be reallocated while samples load in the background
+        if (updateSampleTex && !e->areSamplesLoading()) {
           unsigned int* dataT=NULL;
           int pitch=0;
           logD("updating sample texture.");
@@ -1800,6 +1798,12 @@ void FurnaceGUI::drawSampleEdit() {
               }
             }
 
+            // when zoomed out, read from the summary instead of scanning every sample
+            bool useSummary=false;
+            if (sampleZoom>=SAMPLE_SUMMARY_MIN_ZOOM) {
+              useSummary=sampleSummary.sync(sample);
+            }
+
             unsigned int xCoarse=samplePos;
             unsigned int xFine=0;
             unsigned int xAdvanceCoarse=sampleZoom;
@@ -1810,31 +1814,28 @@ void FurnaceGUI::drawSampleEdit() {
               int candMin=INT_MAX;
               int candMax=INT_MIN;
               int totalAdvance=0;
-              if (sample->depth==DIV_SAMPLE_DEPTH_8BIT) {
-                if (candMin>sample->data8[xCoarse]) candMin=sample->data8[xCoarse];
-                if (candMax<sample->data8[xCoarse]) candMax=sample->data8[xCoarse];
-              } else {
-                if (candMin>sample->data16[xCoarse]) candMin=sample->data16[xCoarse];
-                if (candMax<sample->data16[xCoarse]) candMax=sample->data16[xCoarse];
-              }
               xFine+=xAdvanceFine;
               if (xFine>=16777216) {
                 xFine-=16777216;
                 totalAdvance++;
               }
               totalAdvance+=xAdvanceCoarse;
-              if (xCoarse>=sample->samples) break;
-              do {
-                if (xCoarse>=sample->samples) break;
-                if (sample->depth==DIV_SAMPLE_DEPTH_8BIT) {
-                  if (candMin>sample->data8[xCoarse]) candMin=sample->data8[xCoarse];
-                  if (candMax<sample->data8[xCoarse]) candMax=sample->data8[xCoarse];
-                } else {
-                  if (candMin>sample->data16[xCoarse]) candMin=sample->data16[xCoarse];
-                  if (candMax<sample->data16[xCoarse]) candMax=sample->data16[xCoarse];
-                }
-                if (totalAdvance>0) xCoarse++;
-              } while ((totalAdvance--)>0);
+              if (useSummary) {
+                sampleSummary.getRange(xCoarse,xCoarse+totalAdvance+1,candMin,candMax);
+                xCoarse+=totalAdvance;
+              } else {
+                do {
+                  if (xCoarse>=sample->samples) break;
+                  if (sample->depth==DIV_SAMPLE_DEPTH_8BIT) {
+                    if (candMin>sample->data8[xCoarse]) candMin=sample->data8[xCoarse];
+                    if (candMax<sample->data8[xCoarse]) candMax=sample->data8[xCoarse];
+                  } else {
+                    if (candMin>sample->data16[xCoarse]) candMin=sample->data16[xCoarse];
+                    if (candMax<sample->data16[xCoarse]) candMax=sample->data16[xCoarse];
+                  }
+                  if (totalAdvance>0) xCoarse++;
+                } while ((totalAdvance--)>0);
+              }
               if (sample->depth==DIV_SAMPLE_DEPTH_8BIT) {
                 y1=(((unsigned char)candMin^0x80)*availY)>>8;
                 y2=(((unsigned char)candMax^0x80)*availY)>>8;
@@ -2505,6 +2506,58 @@ void FurnaceGUI::drawSampleEdit() {
   ImGui::End();
 }
 
+bool FurnaceGUI::startResample(DivSample* sample, double sRate, double tRate, int filter) {
+  if (resampleJob!=NULL) return false;
+  DivSampleResampleJob* job=sample->prepareResample(sRate,tRate,filter);
+  if (job==NULL) return false;
+
+  // the job works on a copy, so playback can continue while it runs
+  resampleJob=job;
+  resampleJobSample=sample;
+  resampleJobIndex=curSample;
+  resampleThread=new std::thread([job]() {
+    job->run();
+  });
+  displayResampling=true;
+  return true;
+}
+
+void FurnaceGUI::finishResample() {
+  if (resampleJob==NULL) return;
+  if (resampleThread!=NULL) {
+    resampleThread->join();
+    delete resampleThread;
+    resampleThread=NULL;
+  }
+
+  // the sample may have been deleted in the meantime
+  bool valid=(resampleJobIndex>=0 && resampleJobIndex<(int)e->song.sample.size() && e->song.sample[resampleJobIndex]==resampleJobSample);
+  if (valid && resampleJob->success && !resampleJob->cancel) {
+    DivSample* sample=resampleJobSample;
+    int index=resampleJobIndex;
+    DivSampleResampleJob* job=resampleJob;
+    if (job->depth!=sample->depth || job->samples!=sample->samples) {
+      showError(_("couldn't resample! the sample was changed while resampling."));
+    } else {
+      sample->prepareUndo(true);
+      e->lockEngine([this,sample,index,job]() {
+        sample->applyResample(job);
+        e->renderSamples(index);
+      });
+      updateSampleTex=true;
+      notifySampleChange=true;
+      sampleSelStart=-1;
+      sampleSelEnd=-1;
+      MARK_MODIFIED;
+    }
+  }
+
+  delete resampleJob;
+  resampleJob=NULL;
+  resampleJobSample=NULL;
+  resampleJobIndex=-1;
+}
+
 void FurnaceGUI::doUndoSample() {
   if (!sampleEditOpen) return;
   if (curSample<0 || curSample>=(int)e->song.sample.size()) return;
@@ -0,0 +1,275 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2026 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "sampleSummary.h"
+#include "../ta-log.h"
+#include <limits.h>
+#include <string.h>
+#include <utility>
+
+#define SUMMARY_BLOCK (1U<<SAMPLE_SUMMARY_BLOCK_SHIFT)
+
+// compare this many samples at once when looking for changes
+#define COMPARE_CHUNK 4096
+
+void FurnaceSampleSummaryData::build(unsigned int start, unsigned int end, const std::atomic<bool>* cancel) {
+  size_t len=data.size();
+  size_t levelLen=(len+SUMMARY_BLOCK-1)>>SAMPLE_SUMMARY_BLOCK_SHIFT;
+  if (end>len) end=len;
+  size_t lo=start>>SAMPLE_SUMMARY_BLOCK_SHIFT;
+  size_t hi=((size_t)end+SUMMARY_BLOCK-1)>>SAMPLE_SUMMARY_BLOCK_SHIFT;
+
+  for (int l=0; l<SAMPLE_SUMMARY_LEVELS; l++) {
+    mins[l].resize(levelLen);
+    maxs[l].resize(levelLen);
+    if (hi>levelLen) hi=levelLen;
+
+    for (size_t i=lo; i<hi; i++) {
+      short bMin=SHRT_MAX;
+      short bMax=SHRT_MIN;
+      if (l==0) {
+        size_t bEnd=(i+1)<<SAMPLE_SUMMARY_BLOCK_SHIFT;
+        if (bEnd>len) bEnd=len;
+        for (size_t j=i<<SAMPLE_SUMMARY_BLOCK_SHIFT; j<bEnd; j++) {
+          if (bMin>data[j]) bMin=data[j];
+          if (bMax<data[j]) bMax=data[j];
+        }
+      } else {
+        // combine the two blocks below (the second one may not exist)
+        const std::vector<short>& pMin=mins[l-1];
+        const std::vector<short>& pMax=maxs[l-1];
+        size_t pEnd=(i<<1)+2;
+        if (pEnd>pMin.size()) pEnd=pMin.size();
+        for (size_t j=i<<1; j<pEnd; j++) {
+          if (bMin>pMin[j]) bMin=pMin[j];
+          if (bMax<pMax[j]) bMax=pMax[j];
+        }
+      }
+      mins[l][i]=bMin;
+      maxs[l][i]=bMax;
+
+      if (cancel!=NULL && (i&4095)==0) {
+        if (cancel->load()) return;
+      }
+    }
+
+    if (levelLen<=1) {
+      for (int k=l+1; k<SAMPLE_SUMMARY_LEVELS; k++) {
+        mins[k].clear();
+        maxs[k].clear();
+      }
+      break;
+    }
+    levelLen=(levelLen+1)>>1;
+    lo>>=1;
+    hi=(hi+1)>>1;
+  }
+}
+
+void FurnaceSampleSummaryData::clear() {
+  data.clear();
+  data.shrink_to_fit();
+  for (int l=0; l<SAMPLE_SUMMARY_LEVELS; l++) {
+    mins[l].clear();
+    mins[l].shrink_to_fit();
+    maxs[l].clear();
+    maxs[l].shrink_to_fit();
+  }
+}
+
+void FurnaceSampleSummary::copyData(std::vector<short>& dest, DivSample* s, unsigned int start, unsigned int end) {
+  if (s->depth==DIV_SAMPLE_DEPTH_8BIT) {
+    if (s->data8==NULL) {
+      for (unsigned int i=start; i<end; i++) dest[i]=0;
+      return;
+    }
+    for (unsigned int i=start; i<end; i++) {
+      dest[i]=s->data8[i];
+    }
+  } else {
+    if (s->data16==NULL) {
+      for (unsigned int i=start; i<end; i++) dest[i]=0;
+      return;
+    }
+    if (end>start) memcpy(&dest[start],&s->data16[start],(end-start)*sizeof(short));
+  }
+}
+
+void FurnaceSampleSummary::startWorker(DivSample* s) {
+  stopWorker();
+  ready=false;
+
+  job.data.resize(s->samples);
+  copyData(job.data,s,0,s->samples);
+  jobOwner=s;
+  jobDepth=s->depth;
+
+  logV("summarizing sample (%d samples)...",s->samples);
+  workerDone=false;
+  workerCancel=false;
+  worker=new std::thread([this]() {
+    job.build(0,job.data.size(),&workerCancel);
+    workerDone=true;
+  });
+}
+
+void FurnaceSampleSummary::stopWorker() {
+  if (worker==NULL) return;
+  workerCancel=true;
+  worker->join();
+  delete worker;
+  worker=NULL;
+  job.clear();
+}
+
+bool FurnaceSampleSummary::poll() {
+  if (worker==NULL) return false;
+  if (!workerDone.load()) return false;
+
+  worker->join();
+  delete worker;
+  worker=NULL;
+
+  std::swap(sum,job);
+  job.clear();
+  owner=jobOwner;
+  depth=jobDepth;
+  ready=true;
+  return true;
+}
+
+bool FurnaceSampleSummary::sync(DivSample* s) {
+  if (s==NULL) return false;
+  poll();
+
+  if (worker!=NULL) {
+    // the summary in progress is for another sample
+    if (jobOwner!=s || jobDepth!=s->depth) startWorker(s);
+    return false;
+  }
+
+  if (!ready || owner!=s || depth!=s->depth) {
+    startWorker(s);
+    return false;
+  }
+
+  // find the changed range
+  unsigned int oldLen=sum.data.size();
+  unsigned int newLen=s->samples;
+  unsigned int common=MIN(oldLen,newLen);
+  const short* old=sum.data.data();
+  unsigned int first=common;
+
+  if (s->depth==DIV_SAMPLE_DEPTH_8BIT) {
+    if (s->data8!=NULL) {
+      for (unsigned int i=0; i<common; i++) {
+        if (old[i]!=s->data8[i]) {
+          first=i;
+          break;
+        }
+      }
+    }
+  } else if (s->data16!=NULL) {
+    for (unsigned int i=0; i<common; i+=COMPARE_CHUNK) {
+      unsigned int chunkLen=MIN(COMPARE_CHUNK,common-i);
+      if (memcmp(&old[i],&s->data16[i],chunkLen*sizeof(short))==0) continue;
+      for (unsigned int j=i; j<i+chunkLen; j++) {
+        if (old[j]!=s->data16[j]) {
+          first=j;
+          break;
+        }
+      }
+      break;
+    }
+  }
+
+  if (first==common && oldLen==newLen) return true;
+
+  unsigned int last=newLen;
+  if (oldLen==newLen) {
+    if (s->depth==DIV_SAMPLE_DEPTH_8BIT) {
+      if (s->data8!=NULL) while (last>first && old[last-1]==s->data8[last-1]) last--;
+    } else {
+      if (s->data16!=NULL) while (last>first && old[last-1]==s->data16[last-1]) last--;
+    }
+  }
+
+  if (last-first>=SAMPLE_SUMMARY_ASYNC_THRESHOLD) {
+    startWorker(s);
+    return false;
+  }
+
+  sum.data.resize(newLen);
+  copyData(sum.data,s,first,last);
+  sum.build(first,last);
+  return true;
+}
+
+void FurnaceSampleSummary::getRange(unsigned int start, unsigned int end, int& min, int& max) {
+  min=INT_MAX;
+  max=INT_MIN;
+  if (end>sum.data.size()) end=sum.data.size();
+
+  while (start<end) {
+    // use the largest aligned block which fits
+    int level=-1;
+    for (int l=SAMPLE_SUMMARY_LEVELS-1; l>=0; l--) {
+      unsigned int blockLen=1U<<(l+SAMPLE_SUMMARY_BLOCK_SHIFT);
+      if ((start&(blockLen-1))!=0) continue;
+      if ((size_t)start+blockLen>end) continue;
+      if ((start>>(l+SAMPLE_SUMMARY_BLOCK_SHIFT))>=sum.mins[l].size()) continue;
+      level=l;
+      break;
+    }
+
+    if (level<0) {
+      const short val=sum.data[start];
+      if (min>val) min=val;
+      if (max<val) max=val;
+      start++;
+    } else {
+      const unsigned int index=start>>(level+SAMPLE_SUMMARY_BLOCK_SHIFT);
+      if (min>sum.mins[level][index]) min=sum.mins[level][index];
+      if (max<sum.maxs[level][index]) max=sum.maxs[level][index];
+      start+=1U<<(level+SAMPLE_SUMMARY_BLOCK_SHIFT);
+    }
+  }
+}
+
+void FurnaceSampleSummary::clear() {
+  stopWorker();
+  sum.clear();
+  owner=NULL;
+  ready=false;
+}
+
+FurnaceSampleSummary::FurnaceSampleSummary():
+  owner(NULL),
+  jobOwner(NULL),
+  depth(0),
+  jobDepth(0),
+  ready(false),
+  worker(NULL),
+  workerDone(false),
+  workerCancel(false) {
+}
+
+FurnaceSampleSummary::~FurnaceSampleSummary() {
+  stopWorker();
+}
@@ -0,0 +1,104 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2026 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _SAMPLE_SUMMARY_H
+#define _SAMPLE_SUMMARY_H
+
+#include "../engine/sample.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// number of samples in a level 0 block (as a power of two)
+#define SAMPLE_SUMMARY_BLOCK_SHIFT 4
+
+// maximum number of levels. the last one has blocks of 2^(4+23) samples.
+#define SAMPLE_SUMMARY_LEVELS 24
+
+// the summary is used when each pixel covers at least this many samples
+#define SAMPLE_SUMMARY_MIN_ZOOM 16.0
+
+// changes larger than this are summarized on the worker thread
+#define SAMPLE_SUMMARY_ASYNC_THRESHOLD (1U<<20)
+
+struct FurnaceSampleSummaryData {
+  // copy of the sample data (8-bit samples are stored as-is)
+  std::vector<short> data;
+  // minimum and maximum of each block, for each level
+  std::vector<short> mins[SAMPLE_SUMMARY_LEVELS];
+  std::vector<short> maxs[SAMPLE_SUMMARY_LEVELS];
+
+  void build(unsigned int start, unsigned int end, const std::atomic<bool>* cancel=NULL);
+  void clear();
+};
+
+/**
+ * a min/max pyramid of the sample being edited, used to draw the waveform
+ * in O(pixels) when zoomed out.
+ * the summary keeps its own copy of the sample data. this allows it to find
+ * the edited range by comparison, and to be built on a worker thread while
+ * the sample is being edited.
+ */
+class FurnaceSampleSummary {
+  FurnaceSampleSummaryData sum;
+  FurnaceSampleSummaryData job;
+  DivSample* owner;
+  DivSample* jobOwner;
+  unsigned char depth, jobDepth;
+  bool ready;
+
+  std::thread* worker;
+  std::atomic<bool> workerDone;
+  std::atomic<bool> workerCancel;
+
+  void copyData(std::vector<short>& dest, DivSample* s, unsigned int start, unsigned int end);
+  void startWorker(DivSample* s);
+  void stopWorker();
+
+  public:
+    /**
+     * collect the result of the worker thread, if it has finished.
+     * @return whether the summary just became ready.
+     */
+    bool poll();
+
+    /**
+     * bring the summary up to date with the sample data.
+     * small changes are summarized immediately, while large ones (and new samples) are
+     * summarized on the worker thread.
+     * @return whether the summary can be used.
+     */
+    bool sync(DivSample* s);
+
+    /**
+     * get the minimum and maximum in [start,end).
+     * only valid after a successful sync().
+     */
+    void getRange(unsigned int start, unsigned int end, int& min, int& max);
+
+    /**
+     * discard the summary.
+     */
+    void clear();
+
+    FurnaceSampleSummary();
+    ~FurnaceSampleSummary();
+};
+
+#endif
@@ -133,7 +133,8 @@ const char* audioBackends[]={
   "PortAudio",
   // pipe (invalid choice in GUI)
   "Uhh, can you explain to me what exactly you were trying to do?",
-  "ASIO"
+  "ASIO",
+  "AAudio"
 };
 
 const char* audioQualities[]={
@@ -786,6 +787,15 @@ void FurnaceGUI::drawSettings() {
           ImGui::SetTooltip(_("saves power by lowering the frame rate to 2fps when idle.\nmay cause issues under Mesa drivers!"));
         }
 
+        if (ImGui::SliderInt(_("Frame rate during playback"),&settings.playbackFrameRate,0,120,settings.playbackFrameRate==0?_("Normal"):"%d")) {
+          settingsChanged=true;
+        }
+        if (settings.playbackFrameRate<0) settings.playbackFrameRate=0;
+        if (settings.playbackFrameRate>120) settings.playbackFrameRate=120;
+        if (ImGui::IsItemHovered()) {
+          ImGui::SetTooltip(_("while playing, only redraw when the row changes, on input or at this rate.\nlower values save CPU time, but oscilloscopes and meters update less often."));
+        }
+
 #ifndef IS_MOBILE
         bool noThreadedInputB=settings.noThreadedInput;
         if (ImGui::Checkbox(_("Disable threaded input (restart after changing!)"),&noThreadedInputB)) {
@@ -850,12 +860,51 @@ void FurnaceGUI::drawSettings() {
           ImGui::SetTooltip(_("use zlib to compress saved songs."));
         }
 
+        if (settings.compress) {
+          ImGui::Indent();
+          bool parallelCompressB=settings.parallelCompress;
+          if (ImGui::Checkbox(_("Compress using all cores"),&parallelCompressB)) {
+            settings.parallelCompress=parallelCompressB;
+            settingsChanged=true;
+          }
+          if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip(_("compresses big songs faster, but the resulting file may be slightly bigger."));
+          }
+          if (ImGui::SliderInt(_("Compression level"),&settings.compressLevel,1,9)) {
+            settingsChanged=true;
+          }
+          if (settings.compressLevel<1) settings.compressLevel=1;
+          if (settings.compressLevel>9) settings.compressLevel=9;
+          if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip(_("lower levels save much faster, at the cost of a slightly bigger file.\nthe default is 6."));
+          }
+          ImGui::Unindent();
+        }
+
+        bool backgroundSampleLoadB=settings.backgroundSampleLoad;
+        if (ImGui::Checkbox(_("Load samples in the background"),&backgroundSampleLoadB)) {
+          settings.backgroundSampleLoad=backgroundSampleLoadB;
+          settingsChanged=true;
+        }
+        if (ImGui::IsItemHovered()) {
+          ImGui::SetTooltip(_("opens big songs faster.\nplayback waits until samples finish loading."));
+        }
+
         bool saveUnusedPatternsB=settings.saveUnusedPatterns;
         if (ImGui::Checkbox(_("Save unused patterns"),&saveUnusedPatternsB)) {
           settings.saveUnusedPatterns=saveUnusedPatternsB;
           settingsChanged=true;
         }
 
+        bool deltaSamplesB=settings.deltaSamples;
+        if (ImGui::Checkbox(_("Store samples as differences"),&deltaSamplesB)) {
+          settings.deltaSamples=deltaSamplesB;
+          settingsChanged=true;
+        }
+        if (ImGui::IsItemHovered()) {
+          ImGui::SetTooltip(_("makes songs with many 8/16-bit samples smaller when compressed.\nsongs saved this way can't be opened by Furnace versions older than dev245."));
+        }
+
         bool noDMFCompatB=settings.noDMFCompat;
         if (ImGui::Checkbox(_("Don't apply compatibility flags when loading .dmf"),&noDMFCompatB)) {
           settings.noDMFCompat=noDMFCompatB;
@@ -1202,6 +1251,15 @@ void FurnaceGUI::drawSettings() {
           settings.blankIns=blankInsB;
           settingsChanged=true;
         }
+
+        if (ImGui::InputInt(_("Undo history memory limit (MB)"),&settings.maxUndoMemory,16,64)) {
+          if (settings.maxUndoMemory<0) settings.maxUndoMemory=0;
+          if (settings.maxUndoMemory>4096) settings.maxUndoMemory=4096;
+          settingsChanged=true;
+        }
+        if (ImGui::IsItemHovered()) {
+          ImGui::SetTooltip(_("the oldest pattern/order undo steps are discarded when the history takes more than this.\nset to 0 for no limit."));
+        }
         // SUBSECTION CONFIGURATION
         CONFIG_SUBSECTION(_("Configuration"));
         if (ImGui::Button(_("Import"))) {
@@ -1251,7 +1309,7 @@ void FurnaceGUI::drawSettings() {
         if (ImGui::BeginTable("##Output",2)) {
           ImGui::TableSetupColumn("##Label",ImGuiTableColumnFlags_WidthFixed);
           ImGui::TableSetupColumn("##Combo",ImGuiTableColumnFlags_WidthStretch);
-#if defined(HAVE_JACK) || defined(HAVE_PA) || defined(HAVE_ASIO)
+#if defined(HAVE_JACK) || defined(HAVE_PA) || defined(HAVE_ASIO) || defined(HAVE_AAUDIO)
           ImGui::TableNextRow();
           ImGui::TableNextColumn();
           ImGui::AlignTextToFramePadding();
@@ -1280,6 +1338,12 @@ void FurnaceGUI::drawSettings() {
               settings.audioEngine=DIV_AUDIO_ASIO;
               settingsChanged=true;
             }
+#endif
+#ifdef HAVE_AAUDIO
+            if (ImGui::Selectable("AAudio",settings.audioEngine==DIV_AUDIO_AAUDIO)) {
+              settings.audioEngine=DIV_AUDIO_AAUDIO;
+              settingsChanged=true;
+            }
 #endif
             if (settings.audioEngine!=prevAudioEngine) {
               audioEngineChanged=true;
@@ -1389,6 +1453,22 @@ void FurnaceGUI::drawSettings() {
             ImGui::SetTooltip(_("common values:\n- 1 for mono\n- 2 for stereo"));
           }
 
+          if (settings.audioEngine==DIV_AUDIO_JACK) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::AlignTextToFramePadding();
+            ImGui::Text(_("Chip outputs"));
+            ImGui::TableNextColumn();
+            if (ImGui::InputInt("##JACKChipOutputs",&settings.jackChipOutputs,1,4)) {
+              if (settings.jackChipOutputs<0) settings.jackChipOutputs=0;
+              if (settings.jackChipOutputs>DIV_MAX_CHIPS) settings.jackChipOutputs=DIV_MAX_CHIPS;
+              settingsChanged=true;
+            }
+            if (ImGui::IsItemHovered()) {
+              ImGui::SetTooltip(_("register a set of outputs for each of the first chips.\neach set carries what the chip sends to the main outputs through the patchbay."));
+            }
+          }
+
           ImGui::TableNextRow();
           ImGui::TableNextColumn();
           ImGui::AlignTextToFramePadding();
@@ -1437,6 +1517,70 @@ void FurnaceGUI::drawSettings() {
             }
           }
           popWarningColor();
+
+          bool renderTickDecoupledB=settings.renderTickDecoupled;
+          if (ImGui::Checkbox(_("Render whole buffer after ticks"),&renderTickDecoupledB)) {
+            settings.renderTickDecoupled=renderTickDecoupledB;
+            settingsChanged=true;
+          }
+          if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip(_("processes all ticks in a buffer first, then renders each chip's whole buffer in one go.\nreduces thread synchronization, especially with small buffer sizes."));
+          }
+
+          bool parallelChanTickB=settings.parallelChanTick;
+          if (ImGui::Checkbox(_("Process channel effects in parallel"),&parallelChanTickB)) {
+            settings.parallelChanTick=parallelChanTickB;
+            settingsChanged=true;
+          }
+          if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip(_("runs per-tick effects (slides, vibrato, arpeggio...) of each chip's channels on the render threads.\nonly useful on songs with many chips and channels.\nnot used while the command stream or MIDI note output are active."));
+          }
+
+          ImGui::Text(_("Render thread priority:"));
+          ImGui::Indent();
+          if (ImGui::RadioButton(_("Normal##rpp0"),settings.renderPoolPriority==0)) {
+            settings.renderPoolPriority=0;
+            settingsChanged=true;
+          }
+          if (ImGui::RadioButton(_("High##rpp1"),settings.renderPoolPriority==1)) {
+            settings.renderPoolPriority=1;
+            settingsChanged=true;
+          }
+          if (ImGui::RadioButton(_("Real-time##rpp2"),settings.renderPoolPriority==2)) {
+            settings.renderPoolPriority=2;
+            settingsChanged=true;
+          }
+          if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip(_("uses SCHED_FIFO on Linux and MMCSS on Windows.\nmay require permission (e.g. rtprio in limits.conf). falls back to high priority if not permitted."));
+          }
+          ImGui::Unindent();
+
+          bool renderPoolPinCoresB=settings.renderPoolPinCores;
+          if (ImGui::Checkbox(_("Pin render threads to performance cores"),&renderPoolPinCoresB)) {
+            settings.renderPoolPinCores=renderPoolPinCoresB;
+            settingsChanged=true;
+          }
+          if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip(_("keeps each render thread on its own core, and the audio thread on another one.\non systems with performance and efficiency cores, only performance cores are used.\nnot available on macOS (the priority setting already prefers performance cores there)."));
+          }
+        }
+
+        bool skipIdleChipsB=settings.skipIdleChips;
+        if (ImGui::Checkbox(_("Skip emulation of silent chips"),&skipIdleChipsB)) {
+          settings.skipIdleChips=skipIdleChipsB;
+          settingsChanged=true;
+        }
+        if (ImGui::IsItemHovered()) {
+          ImGui::SetTooltip(_("stops emulating a chip while all of its channels are silent and nothing is being written to it.\nonly supported by some cores (currently Nuked-OPN2).\nLFO and envelope timers are paused while the chip is idle, which may slightly change the output."));
+        }
+
+        bool polyphaseResamplerB=settings.polyphaseResampler;
+        if (ImGui::Checkbox(_("Use polyphase resampler for high-rate chips"),&polyphaseResamplerB)) {
+          settings.polyphaseResampler=polyphaseResamplerB;
+          settingsChanged=true;
+        }
+        if (ImGui::IsItemHovered()) {
+          ImGui::SetTooltip(_("uses a filter-based resampler instead of blip_buf for chips running at least 8 times faster than the output rate.\nthis is cheaper for chips which change their output on almost every sample (e.g. FM chips).\nrequires reloading the song to take effect."));
         }
 
         bool lowLatencyB=settings.lowLatency;
@@ -1448,6 +1592,53 @@ void FurnaceGUI::drawSettings() {
           ImGui::SetTooltip(_("reduces latency by running the engine faster than the tick rate.\nuseful for live playback/jam mode.\n\nwarning: only enable if your buffer size is small (10ms or less)."));
         }
 
+        if (ImGui::SliderInt(_("Render-ahead buffer"),&settings.renderAhead,0,200,settings.renderAhead==0?_("Off"):_("%dms"))) {
+          if (settings.renderAhead<0) settings.renderAhead=0;
+          if (settings.renderAhead>500) settings.renderAhead=500;
+          settingsChanged=true;
+        }
+        if (ImGui::IsItemHovered()) {
+          ImGui::SetTooltip(_("renders audio on a separate thread this far ahead of the audio output.\nprotects against stutters when processing takes longer than a buffer, at the cost of latency.\nlive input (such as MIDI) is delayed by up to this amount."));
+        }
+
+        if (settings.renderAhead>0) {
+          bool renderAheadRollbackB=settings.renderAheadRollback;
+          if (ImGui::Checkbox(_("Re-render on edits"),&renderAheadRollbackB)) {
+            settings.renderAheadRollback=renderAheadRollbackB;
+            settingsChanged=true;
+          }
+          if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip(_("when editing or muting during playback, render the audio which hasn't been heard yet again, so that the change is heard sooner.\nonly works with chips which support state saves, and without master effects or MIDI output.\nso far only Pong, Pokémon Mini, PET and PV-1000 support them, so this does nothing in most songs."));
+          }
+        }
+
+        bool loadGovernorB=settings.loadGovernor;
+        if (ImGui::Checkbox(_("Adapt to audio load"),&loadGovernorB)) {
+          settings.loadGovernor=loadGovernorB;
+          settingsChanged=true;
+        }
+        if (ImGui::IsItemHovered()) {
+          ImGui::SetTooltip(_("if audio processing can't keep up, render further ahead or switch to faster emulation cores.\nthe configured cores are restored once the load is low enough.\naudio export always uses the render cores."));
+        }
+
+        bool cachedInsPreviewB=settings.cachedInsPreview;
+        if (ImGui::Checkbox(_("Pre-render instrument previews"),&cachedInsPreviewB)) {
+          settings.cachedInsPreview=cachedInsPreviewB;
+          settingsChanged=true;
+        }
+        if (ImGui::IsItemHovered()) {
+          ImGui::SetTooltip(_("notes played on the piano or in the instrument list are rendered in the background once, then played back without using the song's channels.\nthe first time a note is played, it plays on a channel as usual."));
+        }
+
+        bool fastSeekB=settings.fastSeek;
+        if (ImGui::Checkbox(_("Fast seeking"),&fastSeekB)) {
+          settings.fastSeek=fastSeekB;
+          settingsChanged=true;
+        }
+        if (ImGui::IsItemHovered()) {
+          ImGui::SetTooltip(_("when playing from a position other than the start, only speed, tempo and jump effects are followed up to the order being played.\nmuch faster on long songs, but effects and notes from earlier orders (besides the last instrument and volume) are not carried over.\nnot used while MIDI output is enabled."));
+        }
+
         bool forceMonoB=settings.forceMono;
         if (ImGui::Checkbox(_("Force mono audio"),&forceMonoB)) {
           settings.forceMono=forceMonoB;
@@ -1463,6 +1654,16 @@ void FurnaceGUI::drawSettings() {
             }
           }
         }
+        if (settings.audioEngine==DIV_AUDIO_AAUDIO) {
+          bool wasapiExB=settings.wasapiEx;
+          if (ImGui::Checkbox(_("Exclusive mode"),&wasapiExB)) {
+            settings.wasapiEx=wasapiExB;
+            settingsChanged=true;
+          }
+          if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip(_("lowers latency further on devices which support it, but other apps can't play sound while Furnace is running."));
+          }
+        }
 
         TAAudioDesc& audioWant=e->getAudioDescWant();
         TAAudioDesc& audioGot=e->getAudioDescGot();
@@ -4911,6 +5112,7 @@ void FurnaceGUI::readConfig(DivConfig& conf, FurnaceGUISettingGroups groups) {
 
     settings.noThreadedInput=conf.getInt("noThreadedInput",0);
     settings.powerSave=conf.getInt("powerSave",POWER_SAVE_DEFAULT);
+    settings.playbackFrameRate=conf.getInt("playbackFrameRate",0);
     settings.eventDelay=conf.getInt("eventDelay",0);
 
     settings.renderBackend=conf.getString("renderBackend",GUI_BACKEND_DEFAULT_NAME);
@@ -4932,6 +5134,12 @@ void FurnaceGUI::readConfig(DivConfig& conf, FurnaceGUISettingGroups groups) {
 
     settings.chanOscThreads=conf.getInt("chanOscThreads",0);
     settings.renderPoolThreads=conf.getInt("renderPoolThreads",0);
+    settings.renderTickDecoupled=conf.getInt("renderTickDecoupled",0);
+    settings.renderPoolPriority=conf.getInt("renderPoolPriority",0);
+    settings.renderPoolPinCores=conf.getInt("renderPoolPinCores",DIV_RENDER_POOL_PIN_DEFAULT);
+    settings.parallelChanTick=conf.getInt("parallelChanTick",0);
+    settings.skipIdleChips=conf.getInt("skipIdleChips",0);
+    settings.polyphaseResampler=conf.getInt("polyphaseResampler",0);
     settings.shaderOsc=conf.getInt("shaderOsc",0);
     settings.writeInsNames=conf.getInt("writeInsNames",0);
     settings.readInsNames=conf.getInt("readInsNames",1);
@@ -4950,7 +5158,9 @@ void FurnaceGUI::readConfig(DivConfig& conf, FurnaceGUISettingGroups groups) {
     settings.saveWindowPos=conf.getInt("saveWindowPos",1);
 
     settings.saveUnusedPatterns=conf.getInt("saveUnusedPatterns",0);
+    settings.deltaSamples=conf.getInt("deltaSamples",0);
     settings.maxRecentFile=conf.getInt("maxRecentFile",10);
+    settings.maxUndoMemory=conf.getInt("maxUndoMemory",256);
 
     settings.persistFadeOut=conf.getInt("persistFadeOut",1);
     settings.exportLoops=conf.getInt("exportLoops",0);
@@ -4963,6 +5173,9 @@ void FurnaceGUI::readConfig(DivConfig& conf, FurnaceGUISettingGroups groups) {
     settings.noMaximizeWorkaround=conf.getInt("noMaximizeWorkaround",0);
 
     settings.compress=conf.getInt("compress",1);
+    settings.parallelCompress=conf.getInt("parallelCompress",0);
+    settings.compressLevel=conf.getInt("compressLevel",6);
+    settings.backgroundSampleLoad=conf.getInt("backgroundSampleLoad",1);
     settings.newSongBehavior=conf.getInt("newSongBehavior",0);
     settings.playOnLoad=conf.getInt("playOnLoad",0);
     settings.centerPopup=conf.getInt("centerPopup",1);
@@ -4985,13 +5198,15 @@ void FurnaceGUI::readConfig(DivConfig& conf, FurnaceGUISettingGroups groups) {
   }
 
   if (groups&GUI_SETTINGS_AUDIO) {
-    settings.audioEngine=(conf.getString("audioEngine","SDL")=="SDL")?1:0;
-    if (conf.getString("audioEngine","SDL")=="JACK") {
+    settings.audioEngine=(conf.getString("audioEngine",DIV_AUDIO_ENGINE_DEFAULT)=="SDL")?1:0;
+    if (conf.getString("audioEngine",DIV_AUDIO_ENGINE_DEFAULT)=="JACK") {
       settings.audioEngine=DIV_AUDIO_JACK;
-    } else if (conf.getString("audioEngine","SDL")=="PortAudio") {
+    } else if (conf.getString("audioEngine",DIV_AUDIO_ENGINE_DEFAULT)=="PortAudio") {
       settings.audioEngine=DIV_AUDIO_PORTAUDIO;
-    } else if (conf.getString("audioEngine","SDL")=="ASIO") {
+    } else if (conf.getString("audioEngine",DIV_AUDIO_ENGINE_DEFAULT)=="ASIO") {
       settings.audioEngine=DIV_AUDIO_ASIO;
+    } else if (conf.getString("audioEngine",DIV_AUDIO_ENGINE_DEFAULT)=="AAudio") {
+      settings.audioEngine=DIV_AUDIO_AAUDIO;
     } else {
       settings.audioEngine=DIV_AUDIO_SDL;
     }
@@ -5002,8 +5217,14 @@ void FurnaceGUI::readConfig(DivConfig& conf, FurnaceGUISettingGroups groups) {
     settings.audioBufSize=conf.getInt("audioBufSize",1024);
     settings.audioRate=conf.getInt("audioRate",44100);
     settings.audioChans=conf.getInt("audioChans",2);
+    settings.jackChipOutputs=conf.getInt("jackChipOutputs",0);
 
     settings.lowLatency=conf.getInt("lowLatency",0);
+    settings.renderAhead=conf.getInt("renderAhead",0);
+    settings.renderAheadRollback=conf.getInt("renderAheadRollback",1);
+    settings.loadGovernor=conf.getInt("loadGovernor",0);
+    settings.cachedInsPreview=conf.getInt("cachedInsPreview",1);
+    settings.fastSeek=conf.getInt("fastSeek",0);
 
     settings.metroVol=conf.getInt("metroVol",100);
     settings.sampleVol=conf.getInt("sampleVol",50);
@@ -5278,12 +5499,13 @@ void FurnaceGUI::readConfig(DivConfig& conf, FurnaceGUISettingGroups groups) {
   clampSetting(settings.headFontSize,2,96);
   clampSetting(settings.patFontSize,2,96);
   clampSetting(settings.iconSize,2,48);
-  clampSetting(settings.audioEngine,0,4);
+  clampSetting(settings.audioEngine,0,5);
   clampSetting(settings.audioQuality,0,1);
   clampSetting(settings.audioHiPass,0,1);
   clampSetting(settings.audioBufSize,32,4096);
   clampSetting(settings.audioRate,8000,384000);
   clampSetting(settings.audioChans,1,16);
+  clampSetting(settings.jackChipOutputs,0,DIV_MAX_CHIPS);
   clampSetting(settings.arcadeCore,0,1);
   clampSetting(settings.ym2612Core,0,2);
   clampSetting(settings.snCore,0,1);
@@ -5385,8 +5607,14 @@ void FurnaceGUI::readConfig(DivConfig& conf, FurnaceGUISettingGroups groups) {
   clampSetting(settings.oplStandardWaveNames,0,1);
   clampSetting(settings.cursorMoveNoScroll,0,1);
   clampSetting(settings.lowLatency,0,1);
+  clampSetting(settings.renderAhead,0,500);
+  clampSetting(settings.renderAheadRollback,0,1);
+  clampSetting(settings.loadGovernor,0,1);
+  clampSetting(settings.cachedInsPreview,0,1);
+  clampSetting(settings.fastSeek,0,1);
   clampSetting(settings.notePreviewBehavior,0,3);
   clampSetting(settings.powerSave,0,1);
+  clampSetting(settings.playbackFrameRate,0,120);
   clampSetting(settings.absorbInsInput,0,1);
   clampSetting(settings.eventDelay,0,1);
   clampSetting(settings.moveWindowTitle,0,1);
@@ -5410,6 +5638,7 @@ void FurnaceGUI::readConfig(DivConfig& conf, FurnaceGUISettingGroups groups) {
   clampSetting(settings.saveWindowPos,0,1);
   clampSetting(settings.clampSamples,0,1);
   clampSetting(settings.saveUnusedPatterns,0,1);
+  clampSetting(settings.deltaSamples,0,1);
   clampSetting(settings.channelColors,0,2);
   clampSetting(settings.channelTextColors,0,2);
   clampSetting(settings.channelStyle,0,5);
@@ -5419,6 +5648,7 @@ void FurnaceGUI::readConfig(DivConfig& conf, FurnaceGUISettingGroups groups) {
   clampSetting(settings.channelFont,0,1);
   clampSetting(settings.channelTextCenter,0,1);
   clampSetting(settings.maxRecentFile,0,30);
+  clampSetting(settings.maxUndoMemory,0,4096);
   clampSetting(settings.midiOutClock,0,1);
   clampSetting(settings.midiOutTime,0,1);
   clampSetting(settings.midiOutProgramChange,0,1);
@@ -5436,6 +5666,9 @@ void FurnaceGUI::readConfig(DivConfig& conf, FurnaceGUISettingGroups groups) {
   clampSetting(settings.iCannotWait,0,1);
   clampSetting(settings.orderButtonPos,0,2);
   clampSetting(settings.compress,0,1);
+  clampSetting(settings.parallelCompress,0,1);
+  clampSetting(settings.compressLevel,1,9);
+  clampSetting(settings.backgroundSampleLoad,0,1);
   clampSetting(settings.renderClearPos,0,1);
   clampSetting(settings.insertBehavior,0,1);
   clampSetting(settings.pullDeleteRow,0,1);
@@ -5455,6 +5688,12 @@ void FurnaceGUI::readConfig(DivConfig& conf, FurnaceGUISettingGroups groups) {
   clampSetting(settings.wasapiEx,0,1);
   clampSetting(settings.chanOscThreads,0,256);
   clampSetting(settings.renderPoolThreads,0,DIV_MAX_CHIPS);
+  clampSetting(settings.renderTickDecoupled,0,1);
+  clampSetting(settings.renderPoolPriority,0,2);
+  clampSetting(settings.renderPoolPinCores,0,1);
+  clampSetting(settings.parallelChanTick,0,1);
+  clampSetting(settings.skipIdleChips,0,1);
+  clampSetting(settings.polyphaseResampler,0,1);
   clampSetting(settings.writeInsNames,0,1);
   clampSetting(settings.readInsNames,0,1);
   clampSetting(settings.fontBackend,0,1);
@@ -5515,6 +5754,7 @@ void FurnaceGUI::writeConfig(DivConfig& conf, FurnaceGUISettingGroups groups) {
 
     conf.set("noThreadedInput",settings.noThreadedInput);
     conf.set("powerSave",settings.powerSave);
+    conf.set("playbackFrameRate",settings.playbackFrameRate);
     conf.set("eventDelay",settings.eventDelay);
 
     conf.set("renderBackend",settings.renderBackend);
@@ -5536,6 +5776,12 @@ void FurnaceGUI::writeConfig(DivConfig& conf, FurnaceGUISettingGroups groups) {
 
     conf.set("chanOscThreads",settings.chanOscThreads);
     conf.set("renderPoolThreads",settings.renderPoolThreads);
+    conf.set("renderTickDecoupled",settings.renderTickDecoupled);
+    conf.set("renderPoolPriority",settings.renderPoolPriority);
+    conf.set("renderPoolPinCores",settings.renderPoolPinCores);
+    conf.set("parallelChanTick",settings.parallelChanTick);
+    conf.set("skipIdleChips",settings.skipIdleChips);
+    conf.set("polyphaseResampler",settings.polyphaseResampler);
     conf.set("shaderOsc",settings.shaderOsc);
     conf.set("writeInsNames",settings.writeInsNames);
     conf.set("readInsNames",settings.readInsNames);
@@ -5554,7 +5800,9 @@ void FurnaceGUI::writeConfig(DivConfig& conf, FurnaceGUISettingGroups groups) {
     conf.set("saveWindowPos",settings.saveWindowPos);
 
     conf.set("saveUnusedPatterns",settings.saveUnusedPatterns);
+    conf.set("deltaSamples",settings.deltaSamples);
     conf.set("maxRecentFile",settings.maxRecentFile);
+    conf.set("maxUndoMemory",settings.maxUndoMemory);
 
     conf.set("persistFadeOut",settings.persistFadeOut);
     conf.set("exportLoops",settings.exportLoops);
@@ -5567,6 +5815,9 @@ void FurnaceGUI::writeConfig(DivConfig& conf, FurnaceGUISettingGroups groups) {
     conf.set("noMaximizeWorkaround",settings.noMaximizeWorkaround);
 
     conf.set("compress",settings.compress);
+    conf.set("parallelCompress",settings.parallelCompress);
+    conf.set("compressLevel",settings.compressLevel);
+    conf.set("backgroundSampleLoad",settings.backgroundSampleLoad);
     conf.set("newSongBehavior",settings.newSongBehavior);
     conf.set("playOnLoad",settings.playOnLoad);
     conf.set("centerPopup",settings.centerPopup);
@@ -5598,8 +5849,14 @@ void FurnaceGUI::writeConfig(DivConfig& conf, FurnaceGUISettingGroups groups) {
     conf.set("audioBufSize",settings.audioBufSize);
     conf.set("audioRate",settings.audioRate);
     conf.set("audioChans",settings.audioChans);
+    conf.set("jackChipOutputs",settings.jackChipOutputs);
 
     conf.set("lowLatency",settings.lowLatency);
+    conf.set("renderAhead",settings.renderAhead);
+    conf.set("renderAheadRollback",settings.renderAheadRollback);
+    conf.set("loadGovernor",settings.loadGovernor);
+    conf.set("cachedInsPreview",settings.cachedInsPreview);
+    conf.set("fastSeek",settings.fastSeek);
 
     conf.set("metroVol",settings.metroVol);
     conf.set("sampleVol",settings.sampleVol);
@@ -5941,6 +6198,10 @@ void FurnaceGUI::commitSettings() {
   if (!e->switchMaster(coresChanged)) {
     showError(_("could not initialize audio!"));
   }
+  // switchMaster() only renders samples when the chips are re-initialized
+  if (sampleROMsChanged && !coresChanged) {
+    e->renderSamplesP();
+  }
 
   ImGui::GetIO().Fonts->Clear();
 
@@ -6002,7 +6263,7 @@ bool FurnaceGUI::importKeybinds(String path) {
           if (key.first==guiActions[i].name) {
             // old versions didn't support multi-bind
             actionKeys[i].clear();
-            actionKeys[i].push_back(std::stoi(key.second));
+            actionKeys[i].push_back(std::stoi(key.second.str));
             break;
           }
         } catch (std::out_of_range& e) {
@@ -6776,9 +7037,9 @@ void FurnaceGUI::applyUISettings(bool updateFonts) {
     // four fallback fonts
     if (settings.loadFallback) {
       mainFont=addFontZlib(font_plexSans_compressed_data,font_plexSans_compressed_size,MAX(1,e->getConfInt("mainFontSize",18)*dpiScale),&fc1);
-      mainFont=addFontZlib(font_plexSansJP_compressed_data,font_plexSansJP_compressed_size,MAX(1,e->getConfInt("mainFontSize",18)*dpiScale),&fc1);
-      mainFont=addFontZlib(font_plexSansKR_compressed_data,font_plexSansKR_compressed_size,MAX(1,e->getConfInt("mainFontSize",18)*dpiScale),&fc1);
-      mainFont=addFontZlib(font_unifont_compressed_data,font_unifont_compressed_size,MAX(1,e->getConfInt("mainFontSize",18)*dpiScale),&fc1);
+      mainFont=addFontZlib(font_plexSansJP_compressed_data,font_plexSansJP_compressed_size,MAX(1,e->getConfInt("mainFontSize",18)*dpiScale),&fc1,NULL,true);
+      mainFont=addFontZlib(font_plexSansKR_compressed_data,font_plexSansKR_compressed_size,MAX(1,e->getConfInt("mainFontSize",18)*dpiScale),&fc1,NULL,true);
+      mainFont=addFontZlib(font_unifont_compressed_data,font_unifont_compressed_size,MAX(1,e->getConfInt("mainFontSize",18)*dpiScale),&fc1,NULL,true);
     }
 
     ImFontConfig fc;
@@ -6836,22 +7097,22 @@ void FurnaceGUI::applyUISettings(bool updateFonts) {
         localeRequiresChineseTrad ||
         localeRequiresKorean)) {
       patFont=addFontZlib(font_plexMono_compressed_data,font_plexMono_compressed_size,MAX(1,e->getConfInt("patFontSize",18)*dpiScale),&fc1);
-      patFont=addFontZlib(font_plexSansJP_compressed_data,font_plexSansJP_compressed_size,MAX(1,e->getConfInt("patFontSize",18)*dpiScale),&fc1);
-      patFont=addFontZlib(font_plexSansKR_compressed_data,font_plexSansKR_compressed_size,MAX(1,e->getConfInt("patFontSize",18)*dpiScale),&fc1);
-      patFont=addFontZlib(font_unifont_compressed_data,font_unifont_compressed_size,MAX(1,e->getConfInt("patFontSize",18)*dpiScale),&fc1);
+      patFont=addFontZlib(font_plexSansJP_compressed_data,font_plexSansJP_compressed_size,MAX(1,e->getConfInt("patFontSize",18)*dpiScale),&fc1,NULL,true);
+      patFont=addFontZlib(font_plexSansKR_compressed_data,font_plexSansKR_compressed_size,MAX(1,e->getConfInt("patFontSize",18)*dpiScale),&fc1,NULL,true);
+      patFont=addFontZlib(font_unifont_compressed_data,font_unifont_compressed_size,MAX(1,e->getConfInt("patFontSize",18)*dpiScale),&fc1,NULL,true);
     }
 
     if ((bigFont=addFontZlib(font_plexSans_compressed_data,font_plexSans_compressed_size,MAX(1,40*dpiScale),&fontConfB))==NULL) {
       logE("could not load big UI font!");
     }
     fontConfB.MergeMode=true;
-    if ((bigFont=addFontZlib(font_plexSansJP_compressed_data,font_plexSansJP_compressed_size,MAX(1,40*dpiScale),&fontConfB))==NULL) {
+    if ((bigFont=addFontZlib(font_plexSansJP_compressed_data,font_plexSansJP_compressed_size,MAX(1,40*dpiScale),&fontConfB,NULL,true))==NULL) {
       logE("could not load big UI font (japanese)!");
     }
-    if ((bigFont=addFontZlib(font_plexSansKR_compressed_data,font_plexSansKR_compressed_size,MAX(1,40*dpiScale),&fontConfB))==NULL) {
+    if ((bigFont=addFontZlib(font_plexSansKR_compressed_data,font_plexSansKR_compressed_size,MAX(1,40*dpiScale),&fontConfB,NULL,true))==NULL) {
       logE("could not load big UI font (korean)!");
     }
-    if ((bigFont=addFontZlib(font_unifont_compressed_data,font_unifont_compressed_size,MAX(1,40*dpiScale),&fontConfB))==NULL) {
+    if ((bigFont=addFontZlib(font_unifont_compressed_data,font_unifont_compressed_size,MAX(1,40*dpiScale),&fontConfB,NULL,true))==NULL) {
       logE("could not load big UI font (fallback)!");
     }
 
@@ -6892,9 +7153,9 @@ void FurnaceGUI::applyUISettings(bool updateFonts) {
     // four fallback fonts
     if (settings.loadFallback) {
       headFont=addFontZlib(font_plexSans_compressed_data,font_plexSans_compressed_size,MAX(1,e->getConfInt("headFontSize",27)*dpiScale),&fc1);
-      headFont=addFontZlib(font_plexSansJP_compressed_data,font_plexSansJP_compressed_size,MAX(1,e->getConfInt("headFontSize",27)*dpiScale),&fc1);
-      headFont=addFontZlib(font_plexSansKR_compressed_data,font_plexSansKR_compressed_size,MAX(1,e->getConfInt("headFontSize",27)*dpiScale),&fc1);
-      headFont=addFontZlib(font_unifont_compressed_data,font_unifont_compressed_size,MAX(1,e->getConfInt("headFontSize",27)*dpiScale),&fc1);
+      headFont=addFontZlib(font_plexSansJP_compressed_data,font_plexSansJP_compressed_size,MAX(1,e->getConfInt("headFontSize",27)*dpiScale),&fc1,NULL,true);
+      headFont=addFontZlib(font_plexSansKR_compressed_data,font_plexSansKR_compressed_size,MAX(1,e->getConfInt("headFontSize",27)*dpiScale),&fc1,NULL,true);
+      headFont=addFontZlib(font_unifont_compressed_data,font_unifont_compressed_size,MAX(1,e->getConfInt("headFontSize",27)*dpiScale),&fc1,NULL,true);
     }
 
     //mainFont->FallbackChar='?';
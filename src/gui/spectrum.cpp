@@ -34,6 +34,89 @@ inline float scaleFuncDb(float y) {
   return log10(y)*20.0f/70.0f+1;
 }
 
+FurnaceGUIOutputFFT::FurnaceGUIOutputFFT(int s, int src):
+  size(s),
+  source(src),
+  needle(-1),
+  chans(0),
+  lastUse(0),
+  in(NULL),
+  out(NULL),
+  plan(NULL) {
+  in=(double*)fftw_malloc(sizeof(double)*size);
+  out=(fftw_complex*)fftw_malloc(sizeof(fftw_complex)*(size/2+1));
+  if (in!=NULL && out!=NULL) {
+    plan=fftw_plan_dft_r2c_1d(size,in,out,FFTW_ESTIMATE);
+  }
+  window.resize(size);
+  for (int i=0; i<size; i++) {
+    window[i]=0.5*(1.0-cos(2.0*M_PI*i/(size-1)));
+  }
+  mag.resize(size/2,0.0);
+}
+
+FurnaceGUIOutputFFT::~FurnaceGUIOutputFFT() {
+  if (plan) fftw_destroy_plan(plan);
+  if (in) fftw_free(in);
+  if (out) fftw_free(out);
+}
+
+const double* FurnaceGUI::getOutputFFT(int size, int source) {
+  int frame=ImGui::GetFrameCount();
+  int chans=e->getAudioDescGot().outChans;
+  int needle=e->oscReadPos;
+
+  // find the transform, and free the ones nobody asked for in the last frame
+  FurnaceGUIOutputFFT* fft=NULL;
+  for (size_t i=0; i<outputFFT.size(); i++) {
+    FurnaceGUIOutputFFT* f=outputFFT[i];
+    if (f->size==size && f->source==source) {
+      fft=f;
+    } else if (frame-f->lastUse>1) {
+      delete f;
+      outputFFT.erase(outputFFT.begin()+i);
+      i--;
+    }
+  }
+  if (fft==NULL) {
+    fft=new FurnaceGUIOutputFFT(size,source);
+    if (fft->plan==NULL) {
+      logE("could not create output FFT plan!");
+      delete fft;
+      return NULL;
+    }
+    outputFFT.push_back(fft);
+  }
+  fft->lastUse=frame;
+
+  if (fft->needle==needle && fft->chans==chans) return fft->mag.data();
+  fft->needle=needle;
+  fft->chans=chans;
+
+  if (source>=chans || chans<1) {
+    memset(fft->mag.data(),0,fft->mag.size()*sizeof(double));
+    return fft->mag.data();
+  }
+  for (int j=0; j<size; j++) {
+    int pos=(needle-size+j)&0x7fff;
+    double sample=0.0;
+    if (source<0) {
+      for (int i=0; i<chans; i++) {
+        sample+=e->oscBuf[i][pos];
+      }
+      sample/=chans;
+    } else {
+      sample=e->oscBuf[source][pos];
+    }
+    fft->in[j]=sample*fft->window[j];
+  }
+  fftw_execute(fft->plan);
+  for (int j=0; j<size/2; j++) {
+    fft->mag[j]=sqrt(fft->out[j][0]*fft->out[j][0]+fft->out[j][1]*fft->out[j][1]);
+  }
+  return fft->mag.data();
+}
+
 void FurnaceGUI::drawSpectrum() {
   if (nextWindow==GUI_WINDOW_SPECTRUM) {
     spectrumOpen=true;
@@ -115,30 +198,12 @@ void FurnaceGUI::drawSpectrum() {
       spectrum.update=false;
       spectrum.running=true;
       for (int i=0; i<DIV_MAX_OUTPUTS; i++) {
-        if (spectrum.buffer[i]) {
-          fftw_free(spectrum.buffer[i]);
-          spectrum.buffer[i]=NULL;
-        }
-        if (spectrum.in[i]) {
-          delete[] spectrum.in[i];
-          spectrum.in[i]=NULL;
-        }
-        if (spectrum.plan[i]) {
-          fftw_free(spectrum.plan[i]);
-          spectrum.plan[i]=NULL;
-        }
         if (spectrum.plot[i]) {
           delete[] spectrum.plot[i];
           spectrum.plot[i]=NULL;
         }
       }
       for (int i=0; i<(spectrum.mono?1:chans); i++) {
-        spectrum.buffer[i]=(fftw_complex*)fftw_malloc(sizeof(fftw_complex)*spectrum.bins);
-        if (!spectrum.buffer[i]) spectrum.running=false;
-        spectrum.in[i]=new double[spectrum.bins];
-        if (!spectrum.in[i]) spectrum.running=false;
-        spectrum.plan[i]=fftw_plan_dft_r2c_1d(spectrum.bins,spectrum.in[i],spectrum.buffer[i],FFTW_ESTIMATE);
-        if (!spectrum.plan[i]) spectrum.running=false;
         spectrum.plot[i]=new ImVec2[spectrum.bins/2];
         if (!spectrum.plot[i]) spectrum.running=false;
       }
@@ -157,18 +222,6 @@ void FurnaceGUI::drawSpectrum() {
     }
     if (spectrum.running) {
       for (int z=spectrum.mono?0:(chans-1); z>=0; z--) {
-        if (!spectrum.buffer[z]) {
-          spectrum.buffer[z]=(fftw_complex*)fftw_malloc(sizeof(fftw_complex)*spectrum.bins);
-          if (!spectrum.buffer[z]) spectrum.running=false;
-        }
-        if (!spectrum.in[z]) {
-          spectrum.in[z]=new double[spectrum.bins];
-          if (!spectrum.in[z]) spectrum.running=false;
-        }
-        if (!spectrum.plan[z]) {
-          spectrum.plan[z]=fftw_plan_dft_r2c_1d(spectrum.bins,spectrum.in[z],spectrum.buffer[z],FFTW_ESTIMATE);
-          if (!spectrum.plan[z]) spectrum.running=false;
-        }
         if (!spectrum.plot[z]) {
           spectrum.plot[z]=new ImVec2[spectrum.bins/2];
           if (!spectrum.plot[z]) spectrum.running=false;
@@ -177,31 +230,18 @@ void FurnaceGUI::drawSpectrum() {
           logE("oh no what why");
           break;
         }
-        // get buffer
-        memset(spectrum.in[z],0,sizeof(double)*spectrum.bins);
-        int needle=e->oscReadPos-spectrum.bins;
-
-        for (int j=0; j<spectrum.bins; j++) {
-          int pos=(needle+j)&0x7fff;
-          double sample=0.0;
-          if (spectrum.mono) {
-            for (int i=0; i<chans; i++) {
-              sample+=e->oscBuf[i][pos];
-            }
-            sample/=chans;
-          } else {
-            sample+=e->oscBuf[z][pos];
-          }
-          spectrum.in[z][j]=sample*(0.5*(1.0-cos(2.0*M_PI*j/(spectrum.bins-1))));
+        const double* fftMag=getOutputFFT(spectrum.bins,spectrum.mono?-1:z);
+        if (fftMag==NULL) {
+          spectrum.running=false;
+          break;
         }
-        fftw_execute(spectrum.plan[z]);
         unsigned int count=0;
         double mag=0.0f;
         float x=0.0f, y=0.0f;
         count=spectrum.bins/2;
         for (unsigned int i=0; i<count; i++) {
           x=spectrum.xZoom*size.x*(scaleFuncLog((float)i/count)-spectrum.xOffset);
-          mag=2.0f*sqrt(spectrum.buffer[z][i][0]*spectrum.buffer[z][i][0]+spectrum.buffer[z][i][1]*spectrum.buffer[z][i][1])/count;
+          mag=2.0f*fftMag[i]/count;
           y=1.0-scaleFuncDb(mag);
           spectrum.plot[z][i].x=origin.x+x;
           spectrum.plot[z][i].y=origin.y+size.y*(y-spectrum.yOffset);
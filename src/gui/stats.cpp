@@ -21,6 +21,30 @@
 #include <fmt/printf.h>
 #include <imgui.h>
 
+static const char* counterRateNames[DIV_COUNTER_MAX]={
+  _N("Ticks/s"),
+  _N("Commands/s"),
+  _N("Register writes/s"),
+  _N("blip_buf deltas/s"),
+  _N("Macro steps/s"),
+  _N("Pattern cells/s")
+};
+
+// counters are read once per second
+void FurnaceGUI::updateCounterRates() {
+  double now=ImGui::GetTime();
+  if (lastCountersTime>=0.0 && now-lastCountersTime<1.0) return;
+  DivCounters cur;
+  divCountersRead(cur);
+  if (lastCountersTime>=0.0) {
+    for (int i=0; i<DIV_COUNTER_MAX; i++) {
+      counterRates[i]=(double)(cur.count[i]-lastCounters.count[i])/(now-lastCountersTime);
+    }
+  }
+  lastCounters=cur;
+  lastCountersTime=now;
+}
+
 void FurnaceGUI::drawStats() {
   if (nextWindow==GUI_WINDOW_STATS) {
     statsOpen=true;
@@ -37,6 +61,17 @@ void FurnaceGUI::drawStats() {
     ImGui::ProgressBar((double)lastProcTime/maxGot,ImVec2(ImGui::GetContentRegionAvail().x-ImGui::CalcTextSize("100.0%").x,0),"");
     ImGui::SameLine();
     ImGui::Text("%.1f%%",100.0*((double)lastProcTime/(double)maxGot));
+    updateCounterRates();
+    if (ImGui::BeginTable("CounterRates",2,ImGuiTableFlags_SizingFixedFit)) {
+      for (int i=0; i<DIV_COUNTER_MAX; i++) {
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(_(counterRateNames[i]));
+        ImGui::TableNextColumn();
+        ImGui::Text("%.0f",counterRates[i]);
+      }
+      ImGui::EndTable();
+    }
     if (ImGui::GetContentRegionAvail().y>8.0f*dpiScale) {
       // draw a chart
       lastAudioLoads[lastAudioLoadsPos]=(double)lastProcTime/maxGot;
@@ -24,9 +24,12 @@ void FurnaceGUI::drawSubSongs(bool asChild) {
       snprintf(id,1023,"%d. %s",(int)e->getCurrentSubSong()+1,e->curSubSong->name.c_str());
     }
     if (ImGui::BeginCombo("##SubSong",id)) {
-      if (ImGui::BeginTable("SubSongSelection",2)) {
+      // only sub-songs which were edited are calculated again
+      if (ImGui::IsWindowAppearing()) e->calcAllSongTimestamps();
+      if (ImGui::BeginTable("SubSongSelection",3)) {
         ImGui::TableSetupColumn("c0",ImGuiTableColumnFlags_WidthStretch);
         ImGui::TableSetupColumn("c1",ImGuiTableColumnFlags_WidthFixed);
+        ImGui::TableSetupColumn("c2",ImGuiTableColumnFlags_WidthFixed);
         for (size_t i=0; i<e->song.subsong.size(); i++) {
           if (e->song.subsong[i]->name.empty()) {
             snprintf(id,1023,_("%d. <no name>"),(int)i+1);
@@ -38,7 +41,8 @@ void FurnaceGUI::drawSubSongs(bool asChild) {
           if (ImGui::Selectable(id,i==e->getCurrentSubSong())) {
             makeCursorUndo();
             e->changeSongP(i);
-            recalcTimestamps=true;
+            // its timestamps are kept
+            recalcTimestampsPartial=true;
             updateScroll(0);
             oldRow=0;
             cursor.xCoarse=0;
@@ -50,6 +54,9 @@ void FurnaceGUI::drawSubSongs(bool asChild) {
             curOrder=0;
           }
           ImGui::TableNextColumn();
+          String length=e->song.subsong[i]->ts.totalTime.toString(0,TA_TIME_FORMAT_AUTO_MS_ZERO);
+          ImGui::TextDisabled("%s",length.c_str());
+          ImGui::TableNextColumn();
           ImGui::PushID(i);
           if (ImGui::SmallButton(ICON_FA_ARROW_UP "##SubUp")) {
             e->moveSubSongUp(i);
@@ -1219,6 +1219,7 @@ bool FurnaceGUI::drawSysConf(int chan, int sysPos, DivSystem type, DivConfig& fl
       int clockSel=flags.getInt("clockSel",0);
       bool stereo=flags.getBool("stereo",false);
       bool isBanked=flags.getBool("isBanked",false);
+      bool packSamples=flags.getBool("packSamples",false);
 
       ImGui::Text(_("Clock rate:"));
       ImGui::Indent();
@@ -1245,11 +1246,22 @@ bool FurnaceGUI::drawSysConf(int chan, int sysPos, DivSystem type, DivConfig& fl
         mustRender=true;
       }
 
+      if (isBanked) {
+        if (ImGui::Checkbox(_("Pack samples into banks"),&packSamples)) {
+          altered=true;
+          mustRender=true;
+        }
+        if (ImGui::IsItemHovered()) {
+          ImGui::SetTooltip(_("places samples from largest to smallest into the fullest bank they fit in.\nmay fit more samples, but changes where they are in memory."));
+        }
+      }
+
       if (altered) {
         e->lockSave([&]() {
           flags.set("clockSel",clockSel);
           flags.set("stereo",stereo);
           flags.set("isBanked",isBanked);
+          flags.set("packSamples",packSamples);
         });
       }
       break;
@@ -2427,14 +2439,24 @@ bool FurnaceGUI::drawSysConf(int chan, int sysPos, DivSystem type, DivConfig& fl
     }
     case DIV_SYSTEM_SEGAPCM: {
       bool oldSlides=flags.getBool("oldSlides",false);
+      bool packSamples=flags.getBool("packSamples",false);
 
       if (ImGui::Checkbox(_("Legacy slides and pitch (compatibility)"),&oldSlides)) {
         altered=true;
       }
 
+      if (ImGui::Checkbox(_("Pack samples into banks"),&packSamples)) {
+        altered=true;
+        mustRender=true;
+      }
+      if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip(_("places samples from largest to smallest into the fullest bank they fit in.\nmay fit more samples, but changes where they are in memory."));
+      }
+
       if (altered) {
         e->lockSave([&]() {
           flags.set("oldSlides",oldSlides);
+          flags.set("packSamples",packSamples);
         });
       }
       break;
@@ -2538,6 +2560,7 @@ bool FurnaceGUI::drawSysConf(int chan, int sysPos, DivSystem type, DivConfig& fl
     }
     case DIV_SYSTEM_C140: {
       int bankType=flags.getInt("bankType",0);
+      bool packSamples=flags.getBool("packSamples",false);
 
       ImGui::Text(_("Banking style:"));
       ImGui::Indent();
@@ -2558,9 +2581,36 @@ bool FurnaceGUI::drawSysConf(int chan, int sysPos, DivSystem type, DivConfig& fl
       }
       ImGui::Unindent();
 
+      if (ImGui::Checkbox(_("Pack samples into banks"),&packSamples)) {
+        altered=true;
+        mustRender=true;
+      }
+      if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip(_("places samples from largest to smallest into the fullest bank they fit in.\nmay fit more samples, but changes where they are in memory."));
+      }
+
       if (altered) {
         e->lockSave([&]() {
           flags.set("bankType",bankType);
+          flags.set("packSamples",packSamples);
+        });
+      }
+      break;
+    }
+    case DIV_SYSTEM_C219: {
+      bool packSamples=flags.getBool("packSamples",false);
+
+      if (ImGui::Checkbox(_("Pack samples into banks"),&packSamples)) {
+        altered=true;
+        mustRender=true;
+      }
+      if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip(_("places samples from largest to smallest into the fullest bank they fit in.\nmay fit more samples, but changes where they are in memory."));
+      }
+
+      if (altered) {
+        e->lockSave([&]() {
+          flags.set("packSamples",packSamples);
         });
       }
       break;
@@ -2808,7 +2858,6 @@ bool FurnaceGUI::drawSysConf(int chan, int sysPos, DivSystem type, DivConfig& fl
     case DIV_SYSTEM_PET:
     case DIV_SYSTEM_GA20:
     case DIV_SYSTEM_PV1000:
-    case DIV_SYSTEM_C219:
     case DIV_SYSTEM_BIFURCATOR:
     case DIV_SYSTEM_POWERNOISE:
     case DIV_SYSTEM_UPD1771C:
@@ -34,37 +34,13 @@ void FurnaceGUI::drawTuner() {
   }
   if (!tunerOpen) return;
   if (ImGui::Begin("Tuner",&tunerOpen,globalWinFlags|ImGuiWindowFlags_NoScrollbar,_("Tuner"))) {
-    // fft buffer
-    if (!tunerFFTInBuf) tunerFFTInBuf=new double[FURNACE_TUNER_FFT_SIZE];
-    if (!tunerFFTOutBuf) tunerFFTOutBuf=(fftw_complex*)fftw_malloc(sizeof(fftw_complex)*FURNACE_TUNER_FFT_SIZE);
-
-    if (!tunerPlan) {
-      tunerPlan=fftw_plan_dft_r2c_1d(FURNACE_TUNER_FFT_SIZE,tunerFFTInBuf,tunerFFTOutBuf,FFTW_ESTIMATE);
-    }
-
-    int chans=e->getAudioDescGot().outChans;
-    int needle=e->oscReadPos;
-
-    for (int j=0; j<FURNACE_TUNER_FFT_SIZE; j++) {
-      int pos=(needle-FURNACE_TUNER_FFT_SIZE+j)&0x7fff;
-      double sample=0.0;
-      for (int ch=0; ch<chans; ch++) {
-        sample+=e->oscBuf[ch][pos];
+    std::vector<double> mag(FURNACE_TUNER_FFT_SIZE/2,0.0);
+    const double* fftMag=getOutputFFT(FURNACE_TUNER_FFT_SIZE,-1);
+    if (fftMag!=NULL) {
+      // skip some of the low frequencies
+      for (int k=4; k<FURNACE_TUNER_FFT_SIZE/2; k++) {
+        mag[k]=fftMag[k];
       }
-      sample=sample/chans;
-
-      tunerFFTInBuf[j]=sample*(0.5*(1.0-cos(2.0*M_PI*j/(FURNACE_TUNER_FFT_SIZE-1))));
-    }
-
-    fftw_execute(tunerPlan);
-
-    std::vector<double> mag(FURNACE_TUNER_FFT_SIZE/2);
-    mag[0]=0;
-    mag[1]=0;
-    mag[2]=0;
-    mag[3]=0; // skip some of the low frequencies
-    for (int k=4; k<FURNACE_TUNER_FFT_SIZE/2; k++) {
-      mag[k]=sqrt(tunerFFTOutBuf[k][0]*tunerFFTOutBuf[k][0]+tunerFFTOutBuf[k][1]*tunerFFTOutBuf[k][1]);
     }
 
     // harmonic product spectrum
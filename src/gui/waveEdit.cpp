@@ -468,6 +468,7 @@ void FurnaceGUI::drawWaveEdit() {
           processDrags(ImGui::GetMousePos().x,ImGui::GetMousePos().y);
           e->notifyWaveChange(curWave);
           modified=true;
+          backupPending=true;
         }
         ImGui::PopStyleVar();
 
@@ -165,7 +165,7 @@ void FurnaceGUI::drawXYOsc() {
         const float* oscBufX=e->oscBuf[xyOscXChannel];
         const float* oscBufY=e->oscBuf[xyOscYChannel];
         if (oscBufX!=NULL && oscBufY!=NULL) {
-          int pos=e->oscWritePos;
+          int pos=vizState.oscWritePos;
           float lx=inSqrCenter.x;
           float ly=inSqrCenter.y;
           float maxA=xyOscIntensity*256.f;
@@ -32,25 +32,40 @@ int logLevel=LOGLEVEL_TRACE;
 int logLevel=LOGLEVEL_TRACE; // until done
 #endif
 
+std::atomic<int> logMaxLevel(LOGLEVEL_TRACE);
+
+// messages are queued by any thread as records in a ring, and formatted later
+// by the log thread. this keeps logging out of the way of the audio thread.
+// before initLog() (or after the log thread quits) messages are written directly.
+
 FILE* logOut=NULL;
 FILE* logFile=NULL;
-char* logFileBuf;
-char* logFileWriteBuf;
-unsigned int logFilePosI;
-unsigned int logFilePosO;
-std::thread* logFileThread;
-std::mutex logFileLock;
-std::mutex logFileLockI;
-std::condition_variable logFileNotify;
-std::atomic<bool> logFileAvail(false);
-std::atomic<bool> iAmReallyDead(false);
+
+static LogRecord logRing[TA_LOG_RING_SIZE];
+static std::atomic<unsigned int> logRingHead(0);
+static unsigned int logRingTail=0;
+static std::atomic<bool> logRingReady(false);
+static std::atomic<unsigned int> logDropped(0);
+static thread_local LogRecord logDirect;
+
+// held by whoever is formatting records. also protects logOut and logFile.
+static std::mutex logDrainLock;
+
+static std::thread* logThread=NULL;
+static std::mutex logThreadLock;
+static std::condition_variable logThreadNotify;
+static std::atomic<bool> logThreadQuit(false);
+
+// wake up this often to pick up messages which don't notify the log thread
+#define TA_LOG_INTERVAL 20
 
 std::atomic<unsigned short> logPosition;
 
+std::mutex logEntriesLock;
 LogEntry logEntries[TA_LOG_SIZE];
 
 static constexpr unsigned int TA_LOG_MASK=TA_LOG_SIZE-1;
-static constexpr unsigned int TA_LOGFILE_BUF_MASK=TA_LOGFILE_BUF_SIZE-1;
+static constexpr unsigned int TA_LOG_RING_MASK=TA_LOG_RING_SIZE-1;
 
 const char* logTypes[5]={
   "ERROR",
@@ -60,100 +75,406 @@ const char* logTypes[5]={
   "trace"
 };
 
-void appendLogBuf(const LogEntry& entry) {
-  logFileLockI.lock();
-
-  std::string toWrite=fmt::sprintf(
-    "%02d:%02d:%02d [%s] %s\n",
-    entry.time.tm_hour,
-    entry.time.tm_min,
-    entry.time.tm_sec,
-    logTypes[entry.loglevel],
-    entry.text
-  );
-
-  const char* msg=toWrite.c_str();
-  size_t len=toWrite.size();
+unsigned short LogRecord::putStr(const char* str, size_t len) {
+  if (dataLen>=TA_LOG_DATA_SIZE) {
+    overflow=true;
+    return TA_LOG_DATA_SIZE-1;
+  }
+  unsigned short pos=dataLen;
+  size_t avail=TA_LOG_DATA_SIZE-1-dataLen;
+  if (len>avail) {
+    overflow=true;
+    len=avail;
+  }
+  memcpy(&data[pos],str,len);
+  data[pos+len]=0;
+  dataLen=pos+len+1;
+  return pos;
+}
 
-  int remaining=(logFilePosO-logFilePosI-1)&TA_LOGFILE_BUF_SIZE;
+LogRecord* beginLog(int level, const char* msg) {
+  LogRecord* r=&logDirect;
+  if (logRingReady.load(std::memory_order_acquire)) {
+    unsigned int pos=logRingHead.load(std::memory_order_relaxed);
+    while (true) {
+      LogRecord* slot=&logRing[pos&TA_LOG_RING_MASK];
+      unsigned int seq=slot->seq.load(std::memory_order_acquire);
+      int diff=(int)(seq-pos);
+      if (diff==0) {
+        if (logRingHead.compare_exchange_weak(pos,pos+1,std::memory_order_relaxed)) {
+          r=slot;
+          break;
+        }
+      } else if (diff<0) {
+        // the ring is full. errors and warnings are written directly
+        if (level>LOGLEVEL_WARN) {
+          logDropped++;
+          return NULL;
+        }
+        break;
+      } else {
+        pos=logRingHead.load(std::memory_order_relaxed);
+      }
+    }
+  }
+  r->level=level;
+  r->argc=0;
+  r->dataLen=0;
+  r->overflow=false;
+  r->text=NULL;
+  r->time=time(NULL);
+  if (msg==NULL) msg="";
+  r->putStr(msg,strlen(msg));
+  return r;
+}
 
-  if (len>=(unsigned int)remaining) {
-    printf("line too long to fit in log buffer!\n");
-    logFileLockI.unlock();
+// append a printf-formatted string
+static void appendFormatted(std::string& out, const char* f, ...) {
+  char buf[256];
+  va_list va;
+  va_start(va,f);
+  int len=vsnprintf(buf,256,f,va);
+  va_end(va);
+  if (len<0) return;
+  if (len<256) {
+    out.append(buf,len);
     return;
   }
+  size_t prevSize=out.size();
+  out.resize(prevSize+len+1);
+  va_start(va,f);
+  vsnprintf(&out[prevSize],len+1,f,va);
+  va_end(va);
+  out.resize(prevSize+len);
+}
 
-  if ((logFilePosI+len)>=TA_LOGFILE_BUF_SIZE) {
-    size_t firstWrite=TA_LOGFILE_BUF_SIZE-logFilePosI;
-    memcpy(logFileBuf+logFilePosI,msg,firstWrite);
-    memcpy(logFileBuf,msg+firstWrite,len-firstWrite);
-  } else {
-    memcpy(logFileBuf+logFilePosI,msg,len);
+// format an argument using a conversion spec (flags, width and precision).
+// the spec is adapted to the type of the argument, like fmt::sprintf() does.
+static void formatArg(std::string& out, const char* spec, char conv, const LogArg& a, const LogRecord& r) {
+  char f[64];
+  unsigned long long asUnsigned=a.u;
+  if (a.type==TA_LOG_ARG_INT && a.size<sizeof(long long)) {
+    asUnsigned&=(1ULL<<(a.size*8))-1;
   }
 
-  logFilePosI=(logFilePosI+len)&TA_LOGFILE_BUF_MASK;
-  logFileLockI.unlock();
+  switch (conv) {
+    case 'd': case 'i': case 'u':
+    case 'x': case 'X': case 'o':
+    case 'c':
+      switch (a.type) {
+        case TA_LOG_ARG_FLOAT:
+          snprintf(f,64,"%sg",spec);
+          appendFormatted(out,f,a.f);
+          return;
+        case TA_LOG_ARG_PTR:
+          appendFormatted(out,"0x%llx",(unsigned long long)(size_t)a.p);
+          return;
+        case TA_LOG_ARG_STR:
+          snprintf(f,64,"%ss",spec);
+          appendFormatted(out,f,&r.data[a.str]);
+          return;
+        default:
+          break;
+      }
+      if (conv=='c') {
+        snprintf(f,64,"%sc",spec);
+        appendFormatted(out,f,(int)a.i);
+      } else if ((conv=='d' || conv=='i') && a.type!=TA_LOG_ARG_UINT) {
+        snprintf(f,64,"%slld",spec);
+        appendFormatted(out,f,a.i);
+      } else {
+        snprintf(f,64,"%sll%c",spec,(conv=='d' || conv=='i')?'u':conv);
+        appendFormatted(out,f,asUnsigned);
+      }
+      return;
+    case 'e': case 'E': case 'f': case 'F':
+    case 'g': case 'G': case 'a': case 'A': {
+      double val=a.f;
+      if (a.type==TA_LOG_ARG_INT || a.type==TA_LOG_ARG_BOOL || a.type==TA_LOG_ARG_CHAR) {
+        val=(double)a.i;
+      } else if (a.type==TA_LOG_ARG_UINT) {
+        val=(double)a.u;
+      } else if (a.type!=TA_LOG_ARG_FLOAT) {
+        break;
+      }
+      snprintf(f,64,"%s%c",spec,conv);
+      appendFormatted(out,f,val);
+      return;
+    }
+    case 's':
+      switch (a.type) {
+        case TA_LOG_ARG_INT:
+          snprintf(f,64,"%slld",spec);
+          appendFormatted(out,f,a.i);
+          return;
+        case TA_LOG_ARG_UINT:
+          snprintf(f,64,"%sllu",spec);
+          appendFormatted(out,f,a.u);
+          return;
+        case TA_LOG_ARG_BOOL:
+          snprintf(f,64,"%ss",spec);
+          appendFormatted(out,f,a.i?"true":"false");
+          return;
+        case TA_LOG_ARG_CHAR:
+          snprintf(f,64,"%sc",spec);
+          appendFormatted(out,f,(int)a.i);
+          return;
+        case TA_LOG_ARG_FLOAT:
+          snprintf(f,64,"%sg",spec);
+          appendFormatted(out,f,a.f);
+          return;
+        case TA_LOG_ARG_PTR:
+          appendFormatted(out,"0x%llx",(unsigned long long)(size_t)a.p);
+          return;
+        case TA_LOG_ARG_STR:
+          snprintf(f,64,"%ss",spec);
+          appendFormatted(out,f,&r.data[a.str]);
+          return;
+      }
+      return;
+    case 'p':
+      appendFormatted(out,"0x%llx",(a.type==TA_LOG_ARG_PTR)?(unsigned long long)(size_t)a.p:a.u);
+      return;
+    default:
+      break;
+  }
+  // unknown conversion
+  out+=spec;
+  out+=conv;
 }
 
-int writeLog(int level, const char* msg, fmt::printf_args args) {
-  time_t thisMakesNoSense=time(NULL);
-  int pos=(logPosition.fetch_add(1))&TA_LOG_MASK;
+static int getIntArg(const LogRecord& r, size_t& argi) {
+  if (argi>=r.argc) return 0;
+  const LogArg& a=r.args[argi++];
+  if (a.type==TA_LOG_ARG_FLOAT) return (int)a.f;
+  return (int)a.i;
+}
 
-#if FMT_VERSION >= 100100
-#ifdef _MSVC_LANG
-#if _MSVC_LANG >= 201703L
-  logEntries[pos].text.assign(fmt::vsprintf(std::basic_string_view(msg),args));
-#else
-  logEntries[pos].text.assign(fmt::vsprintf(fmt::basic_string_view<char>(msg),args));
-#endif
-#else
-#if __cplusplus >= 201703L
-  logEntries[pos].text.assign(fmt::vsprintf(std::basic_string_view(msg),args));
-#else
-  logEntries[pos].text.assign(fmt::vsprintf(fmt::basic_string_view<char>(msg),args));
-#endif
-#endif
-#else
-  logEntries[pos].text.assign(fmt::vsprintf(msg,args));
-#endif
+// format a record the way fmt::sprintf() would.
+static void formatRecord(const LogRecord& r, std::string& out) {
+  out.clear();
+  if (r.text!=NULL) {
+    out=*r.text;
+    return;
+  }
+  const char* p=r.data;
+  size_t argi=0;
+  char spec[48];
+  while (*p) {
+    if (*p!='%') {
+      const char* next=strchr(p,'%');
+      if (next==NULL) {
+        out+=p;
+        break;
+      }
+      out.append(p,next-p);
+      p=next;
+      continue;
+    }
+    if (p[1]=='%') {
+      out+='%';
+      p+=2;
+      continue;
+    }
+
+    const char* specStart=p++;
+    size_t specLen=0;
+    spec[specLen++]='%';
+
+    // positional argument
+    int argIndex=-1;
+    const char* d=p;
+    int num=0;
+    while (*d>='0' && *d<='9') {
+      num=num*10+(*d-'0');
+      d++;
+    }
+    if (*d=='$' && d>p) {
+      argIndex=num-1;
+      p=d+1;
+    }
+
+    // flags, width and precision
+    while (*p && strchr("-+ #0",*p)!=NULL) {
+      if (specLen<16) spec[specLen++]=*p;
+      p++;
+    }
+    if (*p=='*') {
+      specLen+=snprintf(&spec[specLen],12,"%d",getIntArg(r,argi));
+      p++;
+    } else while (*p>='0' && *p<='9') {
+      if (specLen<30) spec[specLen++]=*p;
+      p++;
+    }
+    if (*p=='.') {
+      spec[specLen++]='.';
+      p++;
+      if (*p=='*') {
+        specLen+=snprintf(&spec[specLen],12,"%d",getIntArg(r,argi));
+        p++;
+      } else while (*p>='0' && *p<='9') {
+        if (specLen<46) spec[specLen++]=*p;
+        p++;
+      }
+    }
+    if (specLen>47) specLen=47;
+    spec[specLen]=0;
+
+    // length modifiers are ignored, since arguments carry their own type
+    while (*p && strchr("hlLqjzt",*p)!=NULL) p++;
+
+    char conv=*p;
+    if (!conv) {
+      out+=specStart;
+      break;
+    }
+    p++;
+
+    const LogArg* a=NULL;
+    if (argIndex>=0) {
+      if (argIndex<r.argc) a=&r.args[argIndex];
+    } else if (argi<r.argc) {
+      a=&r.args[argi++];
+    }
+    if (a==NULL) {
+      out.append(specStart,p-specStart);
+      continue;
+    }
+    formatArg(out,spec,conv,*a,r);
+  }
+}
+
+// write a formatted message to the log viewer, the log file and the console.
+// logDrainLock must be held.
+static void outputText(int level, time_t when, const std::string& text) {
+  struct tm t;
   // why do I have to pass a pointer
   // can't I just pass the time_t directly?!
 #ifdef _WIN32
-  struct tm* tempTM=localtime(&thisMakesNoSense);
+  struct tm* tempTM=localtime(&when);
   if (tempTM==NULL) {
-    memset(&logEntries[pos].time,0,sizeof(struct tm));
+    memset(&t,0,sizeof(struct tm));
   } else {
-    memcpy(&logEntries[pos].time,tempTM,sizeof(struct tm));
+    memcpy(&t,tempTM,sizeof(struct tm));
   }
 #else
-  if (localtime_r(&thisMakesNoSense,&logEntries[pos].time)==NULL) {
-    memset(&logEntries[pos].time,0,sizeof(struct tm));
+  if (localtime_r(&when,&t)==NULL) {
+    memset(&t,0,sizeof(struct tm));
   }
 #endif
+
+  logEntriesLock.lock();
+  unsigned short pos=logPosition.load()&TA_LOG_MASK;
+  logEntries[pos].text=text;
+  logEntries[pos].time=t;
   logEntries[pos].loglevel=level;
   logEntries[pos].ready=true;
+  logPosition=pos+1;
+  logEntriesLock.unlock();
 
-  // write to log file
-  if (logFileAvail) {
-    appendLogBuf(logEntries[pos]);
-    logFileNotify.notify_one();
+  if (logFile!=NULL) {
+    fmt::fprintf(logFile,"%02d:%02d:%02d [%s] %s\n",t.tm_hour,t.tm_min,t.tm_sec,logTypes[level],text);
   }
 
-  if (logLevel<level) return 0;
-  if (logOut==NULL) return -1;
+  if (logLevel<level) return;
+  if (logOut==NULL) return;
   switch (level) {
     case LOGLEVEL_ERROR:
-      return fmt::fprintf(logOut,"\x1b[1;31m[ERROR]\x1b[m %s\n",logEntries[pos].text);
+      fmt::fprintf(logOut,"\x1b[1;31m[ERROR]\x1b[m %s\n",text);
+      break;
     case LOGLEVEL_WARN:
-      return fmt::fprintf(logOut,"\x1b[1;33m[warning]\x1b[m %s\n",logEntries[pos].text);
+      fmt::fprintf(logOut,"\x1b[1;33m[warning]\x1b[m %s\n",text);
+      break;
     case LOGLEVEL_INFO:
-      return fmt::fprintf(logOut,"\x1b[1;32m[info]\x1b[m %s\n",logEntries[pos].text);
+      fmt::fprintf(logOut,"\x1b[1;32m[info]\x1b[m %s\n",text);
+      break;
     case LOGLEVEL_DEBUG:
-      return fmt::fprintf(logOut,"\x1b[1;34m[debug]\x1b[m %s\n",logEntries[pos].text);
+      fmt::fprintf(logOut,"\x1b[1;34m[debug]\x1b[m %s\n",text);
+      break;
     case LOGLEVEL_TRACE:
-      return fmt::fprintf(logOut,"\x1b[1;37m[trace]\x1b[m %s\n",logEntries[pos].text);
+      fmt::fprintf(logOut,"\x1b[1;37m[trace]\x1b[m %s\n",text);
+      break;
   }
-  return -1;
+}
+
+// format all published records. logDrainLock must be held.
+static void drainLog() {
+  static std::string text;
+  bool any=false;
+  while (true) {
+    LogRecord* r=&logRing[logRingTail&TA_LOG_RING_MASK];
+    if (r->seq.load(std::memory_order_acquire)!=logRingTail+1) break;
+    formatRecord(*r,text);
+    outputText(r->level,r->time,text);
+    if (r->text!=NULL) {
+      delete r->text;
+      r->text=NULL;
+    }
+    r->seq.store(logRingTail+TA_LOG_RING_SIZE,std::memory_order_release);
+    logRingTail++;
+    any=true;
+  }
+  unsigned int dropped=logDropped.exchange(0);
+  if (dropped>0) {
+    outputText(LOGLEVEL_WARN,time(NULL),fmt::sprintf("%d log messages were dropped!",dropped));
+    any=true;
+  }
+  if (any) {
+    if (logOut!=NULL) fflush(logOut);
+    if (logFile!=NULL) fflush(logFile);
+  }
+}
+
+int endLog(LogRecord* r) {
+  if (r==&logDirect) {
+    std::string text;
+    formatRecord(*r,text);
+    if (r->text!=NULL) {
+      delete r->text;
+      r->text=NULL;
+    }
+    logDrainLock.lock();
+    // keep the order
+    drainLog();
+    outputText(r->level,r->time,text);
+    logDrainLock.unlock();
+    return 0;
+  }
+  int level=r->level;
+  unsigned int pos=r->seq.load(std::memory_order_relaxed);
+  r->seq.store(pos+1,std::memory_order_release);
+  // errors and warnings are written out right away.
+  // the log thread is also woken up during bursts, before the ring fills up.
+  if (level<=LOGLEVEL_WARN || (pos&((TA_LOG_RING_SIZE>>2)-1))==0) {
+    logThreadNotify.notify_one();
+  }
+  return 0;
+}
+
+void flushLog() {
+  logDrainLock.lock();
+  drainLog();
+  logDrainLock.unlock();
+}
+
+static void _logThread() {
+  std::unique_lock<std::mutex> lock(logThreadLock);
+  while (!logThreadQuit) {
+    logThreadNotify.wait_for(lock,std::chrono::milliseconds(TA_LOG_INTERVAL));
+    flushLog();
+  }
+}
+
+static void quitLog() {
+  if (logThread==NULL) return;
+  // from now on messages are written directly
+  logRingReady=false;
+  logThreadQuit=true;
+  logThreadNotify.notify_one();
+  logThread->join();
+  delete logThread;
+  logThread=NULL;
+  flushLog();
 }
 
 void initLog(FILE* where) {
@@ -174,39 +495,28 @@ void initLog(FILE* where) {
     logEntries[i].text.reserve(128);
   }
 
-  // initialize log to file thread
-  logFileAvail=false;
+  // start the log thread
+  if (logThread==NULL) {
+    for (unsigned int i=0; i<TA_LOG_RING_SIZE; i++) {
+      logRing[i].seq.store(i,std::memory_order_relaxed);
+    }
+    logRingHead=0;
+    logRingTail=0;
+    logThreadQuit=false;
+    logRingReady.store(true,std::memory_order_release);
+    logThread=new std::thread(_logThread);
+    atexit(quitLog);
+  }
 }
 
 void changeLogOutput(FILE* where) {
+  logDrainLock.lock();
   logOut=where;
-}
-
-void _logFileThread() {
-  std::unique_lock<std::mutex> lock(logFileLock);
-  while (true) {
-    unsigned int logFilePosICopy=logFilePosI;
-    if (logFilePosICopy!=logFilePosO) {
-      // write
-      if (logFilePosO>logFilePosICopy) {
-        fwrite(logFileBuf+logFilePosO,1,TA_LOGFILE_BUF_SIZE-logFilePosO,logFile);
-        logFilePosO=0;
-      } else {
-        fwrite(logFileBuf+logFilePosO,1,logFilePosICopy-logFilePosO,logFile);
-        logFilePosO=logFilePosICopy&TA_LOGFILE_BUF_MASK;
-      }
-    } else {
-      // wait
-      fflush(logFile);
-      if (!logFileAvail) break;
-      logFileNotify.wait(lock);
-    }
-  }
-  iAmReallyDead=true;
+  logDrainLock.unlock();
 }
 
 bool startLogFile(const char* path) {
-  if (logFileAvail) return true;
+  if (logFile!=NULL) return true;
 
   // rotate log file if possible
   char oldPath[4096];
@@ -230,39 +540,28 @@ bool startLogFile(const char* path) {
   }
   
   // open log file
-  if ((logFile=ps_fopen(path,"w+"))==NULL) {
-    logFileAvail=false;
+  FILE* f=ps_fopen(path,"w+");
+  if (f==NULL) {
     logW("could not open log file! (%s)",strerror(errno));
     return false;
   }
 
-  logFileBuf=new char[TA_LOGFILE_BUF_SIZE];
-  logFileWriteBuf=new char[TA_LOGFILE_BUF_SIZE];
-  logFilePosI=0;
-  logFilePosO=0;
-  logFileAvail=true;
-
-  logFileThread=new std::thread(_logFileThread);
+  logDrainLock.lock();
+  drainLog();
+  logFile=f;
+  logDrainLock.unlock();
   return true;
 }
 
 bool finishLogFile() {
-  if (!logFileAvail) return false;
-
-  logFileAvail=false;
-  iAmReallyDead=false;
-
-  // flush
-  logFileLockI.lock();
-  while (!iAmReallyDead) {
-    logFileNotify.notify_one();
-    std::this_thread::yield();
-    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  logDrainLock.lock();
+  drainLog();
+  if (logFile==NULL) {
+    logDrainLock.unlock();
+    return false;
   }
-  // this join is guaranteed to work
-  logFileThread->join();
-  logFileLockI.unlock();
-
   fclose(logFile);
+  logFile=NULL;
+  logDrainLock.unlock();
   return true;
 }
@@ -19,6 +19,7 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <chrono>
 #include "pch.h"
 #ifdef HAVE_SDL2
 #include "SDL_events.h"
@@ -26,6 +27,7 @@
 #include "ta-log.h"
 #include "fileutils.h"
 #include "engine/engine.h"
+#include "engine/trace.h"
 
 #ifdef _WIN32
 #include <windows.h>
@@ -91,7 +93,17 @@ String vgmOutName;
 String cmdOutName;
 String romOutName;
 String txtOutName;
+String videoOutName;
+DivVideoExportOptions videoOptions;
+String batchName;
+int batchJobs=1;
+bool checksumMode=false;
+int checksumTicks=0;
+String playlistName;
+std::vector<String> playlistFiles;
+int playlistFadeMs=0;
 int benchMode=0;
+bool profileStartup=false;
 int subsong=-1;
 DivCSOptions csExportOptions;
 DivAudioExportOptions exportOptions;
@@ -109,11 +121,13 @@ bool consoleNoControls=false;
 bool displayEngineFailError=false;
 bool displayLocaleFailError=false;
 bool vgmOutDirect=false;
+bool vgmOutAll=false;
 
 bool safeMode=false;
 bool safeModeWithAudio=false;
 
 bool infoMode=false;
+bool quickInfoMode=false;
 
 bool noReportError=false;
 
@@ -182,11 +196,27 @@ TAParamResult pAudio(String val) {
     e.setAudio(DIV_AUDIO_PORTAUDIO);
   } else if (val=="asio") {
     e.setAudio(DIV_AUDIO_ASIO);
+  } else if (val=="aaudio") {
+    e.setAudio(DIV_AUDIO_AAUDIO);
   } else if (val=="pipe") {
     e.setAudio(DIV_AUDIO_PIPE);
     changeLogOutput(stderr);
   } else {
-    logE("invalid value for audio engine! valid values are: jack, sdl, portaudio, asio, pipe.");
+    logE("invalid value for audio engine! valid values are: jack, sdl, portaudio, asio, aaudio, pipe.");
+    return TA_PARAM_ERROR;
+  }
+  return TA_PARAM_SUCCESS;
+}
+
+TAParamResult pPipeFormat(String val) {
+  if (val=="s16") {
+    e.setPipeFormat(TA_AUDIO_FORMAT_S16);
+  } else if (val=="s24") {
+    e.setPipeFormat(TA_AUDIO_FORMAT_S24);
+  } else if (val=="f32") {
+    e.setPipeFormat(TA_AUDIO_FORMAT_F32);
+  } else {
+    logE("invalid value for pipeformat! valid values are: s16, s24 and f32.");
     return TA_PARAM_ERROR;
   }
   return TA_PARAM_SUCCESS;
@@ -211,6 +241,27 @@ TAParamResult pConsole(String val) {
   return TA_PARAM_SUCCESS;
 }
 
+TAParamResult pPlaylist(String val) {
+  playlistName=val;
+  consoleMode=true;
+  return TA_PARAM_SUCCESS;
+}
+
+TAParamResult pCrossfade(String val) {
+  try {
+    int ms=std::stoi(val);
+    if (ms<0) {
+      logE("crossfade length shall be 0 or higher.");
+      return TA_PARAM_ERROR;
+    }
+    playlistFadeMs=ms;
+  } catch (std::exception& e) {
+    logE("crossfade length shall be a number.");
+    return TA_PARAM_ERROR;
+  }
+  return TA_PARAM_SUCCESS;
+}
+
 TAParamResult pQuiet(String val) {
   noReportError=true;
   return TA_PARAM_SUCCESS;
@@ -252,11 +303,22 @@ TAParamResult pDirect(String val) {
   return TA_PARAM_SUCCESS;
 }
 
+TAParamResult pVGMAll(String val) {
+  vgmOutAll=true;
+  return TA_PARAM_SUCCESS;
+}
+
 TAParamResult pInfo(String val) {
   infoMode=true;
   return TA_PARAM_SUCCESS;
 }
 
+TAParamResult pQuickInfo(String val) {
+  infoMode=true;
+  quickInfoMode=true;
+  return TA_PARAM_SUCCESS;
+}
+
 TAParamResult pLogLevel(String val) {
   if (val=="trace") {
     logLevel=LOGLEVEL_TRACE;
@@ -424,6 +486,58 @@ TAParamResult pLoops(String val) {
   return TA_PARAM_SUCCESS;
 }
 
+TAParamResult pOutThreads(String val) {
+  try {
+    int count=std::stoi(val);
+    if (count<0) {
+      exportOptions.threads=0;
+    } else {
+      exportOptions.threads=count;
+    }
+  } catch (std::exception& e) {
+    logE("thread count shall be a number.");
+    return TA_PARAM_ERROR;
+  }
+  return TA_PARAM_SUCCESS;
+}
+
+TAParamResult pOutChans(String val) {
+  // list of channels (starting from 1, like the file names) or ranges, separated by commas
+  bool mask[DIV_MAX_CHANS];
+  memset(mask,0,DIV_MAX_CHANS*sizeof(bool));
+  size_t pos=0;
+  while (pos<=val.size()) {
+    size_t next=val.find(',',pos);
+    if (next==String::npos) next=val.size();
+    String item=val.substr(pos,next-pos);
+    pos=next+1;
+    if (item.empty()) continue;
+    int first, last;
+    try {
+      size_t dash=item.find('-');
+      if (dash==String::npos) {
+        first=std::stoi(item);
+        last=first;
+      } else {
+        first=std::stoi(item.substr(0,dash));
+        last=std::stoi(item.substr(dash+1));
+      }
+    } catch (std::exception& e) {
+      logE("invalid channel list! example: 1-4,7");
+      return TA_PARAM_ERROR;
+    }
+    if (first<1 || last<first || last>DIV_MAX_CHANS) {
+      logE("invalid channel range %s! channels go from 1 to %d.",item,DIV_MAX_CHANS);
+      return TA_PARAM_ERROR;
+    }
+    for (int i=first; i<=last; i++) {
+      mask[i-1]=true;
+    }
+  }
+  memcpy(exportOptions.channelMask,mask,DIV_MAX_CHANS*sizeof(bool));
+  return TA_PARAM_SUCCESS;
+}
+
 TAParamResult pSubSong(String val) {
   try {
     int v=std::stoi(val);
@@ -534,6 +648,11 @@ TAParamResult pCompression(String val) {
   return TA_PARAM_SUCCESS;
 }
 
+TAParamResult pProfileStartup(String) {
+  profileStartup=true;
+  return TA_PARAM_SUCCESS;
+}
+
 TAParamResult pBenchmark(String val) {
   if (val=="render") {
     benchMode=1;
@@ -541,40 +660,182 @@ TAParamResult pBenchmark(String val) {
     benchMode=2;
   } else if (val=="walk") {
     benchMode=3;
+  } else if (val=="chips") {
+    benchMode=4;
+  } else if (val=="chips-json") {
+    benchMode=5;
+  } else if (val=="load") {
+    benchMode=6;
+  } else if (val=="save") {
+    benchMode=7;
+  } else if (val=="vgm") {
+    benchMode=8;
+  } else if (val=="cmdstream") {
+    benchMode=9;
+  } else if (val=="text") {
+    benchMode=10;
+  } else if (val=="render-json") {
+    benchMode=11;
+  } else if (val=="csplay") {
+    benchMode=12;
   } else {
-    logE("invalid value for benchmark! valid values are: render, seek and walk.");
+    logE("invalid value for benchmark! valid values are: render, render-json, seek, walk, chips, chips-json, load, save, vgm, cmdstream, csplay and text.");
     return TA_PARAM_ERROR;
   }
   e.setAudio(DIV_AUDIO_DUMMY);
   return TA_PARAM_SUCCESS;
 }
 
+// detect output format from file name
+void detectOutFormat(const String& name, DivAudioExportOptions& opt) {
+  size_t extPos=name.rfind('.');
+  if (extPos!=String::npos) {
+    String lowerCase=name.substr(extPos);
+    for (char& i: lowerCase) {
+      if (i>='A' && i<='Z') i+='a'-'A';
+    }
+
+    if (lowerCase==".wav") {
+      opt.format=DIV_EXPORT_FORMAT_WAV;
+    } else if (lowerCase==".ogg") {
+      // not defaulting to Vorbis in order to encourage Opus usage
+      opt.format=DIV_EXPORT_FORMAT_OPUS;
+    } else if (lowerCase==".flac") {
+      opt.format=DIV_EXPORT_FORMAT_FLAC;
+    } else if (lowerCase==".opus") {
+      opt.format=DIV_EXPORT_FORMAT_OPUS;
+    } else if (lowerCase==".mp3") {
+      opt.format=DIV_EXPORT_FORMAT_MPEG_L3;
+    }
+  }
+}
+
 TAParamResult pOutput(String val) {
   outName=val;
   e.setAudio(DIV_AUDIO_DUMMY);
 
-  // detect output format
-  if (!hasOutFormat) {
-    size_t extPos=outName.rfind('.');
-    if (extPos!=String::npos) {
-      String lowerCase=outName.substr(extPos);
-      for (char& i: lowerCase) {
-        if (i>='A' && i<='Z') i+='a'-'A';
-      }
+  if (!hasOutFormat) detectOutFormat(outName,exportOptions);
+  return TA_PARAM_SUCCESS;
+}
 
-      if (lowerCase==".wav") {
-        exportOptions.format=DIV_EXPORT_FORMAT_WAV;
-      } else if (lowerCase==".ogg") {
-        // not defaulting to Vorbis in order to encourage Opus usage
-        exportOptions.format=DIV_EXPORT_FORMAT_OPUS;
-      } else if (lowerCase==".flac") {
-        exportOptions.format=DIV_EXPORT_FORMAT_FLAC;
-      } else if (lowerCase==".opus") {
-        exportOptions.format=DIV_EXPORT_FORMAT_OPUS;
-      } else if (lowerCase==".mp3") {
-        exportOptions.format=DIV_EXPORT_FORMAT_MPEG_L3;
-      }
+TAParamResult pAlsoOut(String val) {
+  DivAudioExportOptions opt;
+  detectOutFormat(val,opt);
+  DivAudioExportTarget target;
+  target.path=val;
+  target.format=opt.format;
+  exportOptions.extraTargets.push_back(target);
+  return TA_PARAM_SUCCESS;
+}
+
+TAParamResult pReuseLoops(String val) {
+  exportOptions.reuseLoops=true;
+  return TA_PARAM_SUCCESS;
+}
+
+TAParamResult pVideoOut(String val) {
+  videoOutName=val;
+  e.setAudio(DIV_AUDIO_DUMMY);
+  return TA_PARAM_SUCCESS;
+}
+
+TAParamResult pVideoSize(String val) {
+  size_t x=val.find('x');
+  try {
+    if (x==String::npos) throw std::invalid_argument("no x");
+    videoOptions.width=std::stoi(val.substr(0,x));
+    videoOptions.height=std::stoi(val.substr(x+1));
+  } catch (std::exception& e) {
+    logE("video size shall be in the form <width>x<height>.");
+    return TA_PARAM_ERROR;
+  }
+  if (videoOptions.width<16 || videoOptions.height<16) {
+    logE("video size shall be at least 16x16.");
+    return TA_PARAM_ERROR;
+  }
+  return TA_PARAM_SUCCESS;
+}
+
+TAParamResult pVideoFPS(String val) {
+  try {
+    videoOptions.fps=std::stoi(val);
+  } catch (std::exception& e) {
+    logE("frame rate shall be a number.");
+    return TA_PARAM_ERROR;
+  }
+  if (videoOptions.fps<1 || videoOptions.fps>240) {
+    logE("frame rate shall be between 1 and 240.");
+    return TA_PARAM_ERROR;
+  }
+  return TA_PARAM_SUCCESS;
+}
+
+TAParamResult pVideoCols(String val) {
+  try {
+    videoOptions.cols=std::stoi(val);
+  } catch (std::exception& e) {
+    logE("column count shall be a number.");
+    return TA_PARAM_ERROR;
+  }
+  if (videoOptions.cols<0) videoOptions.cols=0;
+  return TA_PARAM_SUCCESS;
+}
+
+TAParamResult pVideoWindow(String val) {
+  try {
+    videoOptions.windowSize=std::stof(val);
+  } catch (std::exception& e) {
+    logE("window size shall be a number.");
+    return TA_PARAM_ERROR;
+  }
+  if (videoOptions.windowSize<1.0f || videoOptions.windowSize>200.0f) {
+    logE("window size shall be between 1 and 200.");
+    return TA_PARAM_ERROR;
+  }
+  return TA_PARAM_SUCCESS;
+}
+
+TAParamResult pVideoEncoder(String val) {
+  videoOptions.encoder=val;
+  return TA_PARAM_SUCCESS;
+}
+
+TAParamResult pBatch(String val) {
+  batchName=val;
+  e.setAudio(DIV_AUDIO_DUMMY);
+  return TA_PARAM_SUCCESS;
+}
+
+TAParamResult pChecksum(String val) {
+  checksumMode=true;
+  e.setAudio(DIV_AUDIO_DUMMY);
+  // keep standard output for the result
+  changeLogOutput(stderr);
+  return TA_PARAM_SUCCESS;
+}
+
+TAParamResult pChecksumTicks(String val) {
+  try {
+    checksumTicks=std::stoi(val);
+  } catch (std::exception& e) {
+    logE("tick count shall be a number.");
+    return TA_PARAM_ERROR;
+  }
+  if (checksumTicks<0) checksumTicks=0;
+  return TA_PARAM_SUCCESS;
+}
+
+TAParamResult pBatchJobs(String val) {
+  try {
+    int count=std::stoi(val);
+    if (count<1) {
+      logE("job count shall be 1 or higher.");
+      return TA_PARAM_ERROR;
     }
+    batchJobs=count;
+  } catch (std::exception& e) {
+    logE("job count shall be a number.");
+    return TA_PARAM_ERROR;
   }
   return TA_PARAM_SUCCESS;
 }
@@ -615,6 +876,70 @@ TAParamResult pTxtOut(String val) {
   return TA_PARAM_SUCCESS;
 }
 
+std::vector<String> masterEffects;
+
+TAParamResult pMasterEffect(String val) {
+  String type=val.substr(0,val.find(':'));
+  if (type!="volume" && type!="filter" && type!="limiter") {
+    logE("invalid effect! valid values are: volume, filter and limiter.");
+    return TA_PARAM_ERROR;
+  }
+  masterEffects.push_back(val);
+  return TA_PARAM_SUCCESS;
+}
+
+// add an effect in the form type[:param=value,...] to the engine
+bool addMasterEffect(DivEngine* eng, const String& desc) {
+  size_t colon=desc.find(':');
+  String type=desc.substr(0,colon);
+  DivEffectType t=DIV_EFFECT_VOLUME;
+  if (type=="filter") {
+    t=DIV_EFFECT_FILTER;
+  } else if (type=="limiter") {
+    t=DIV_EFFECT_LIMITER;
+  }
+  int index=eng->addMasterEffect(t);
+  if (index<0) return false;
+  if (colon==String::npos) return true;
+
+  String params=desc.substr(colon+1);
+  size_t pos=0;
+  while (pos<params.size()) {
+    size_t next=params.find(',',pos);
+    if (next==String::npos) next=params.size();
+    String param=params.substr(pos,next-pos);
+    size_t eq=param.find('=');
+    if (eq==String::npos) {
+      logE("effect parameters shall be in the form param=value.");
+      return false;
+    }
+    try {
+      if (!eng->setMasterEffectParam(index,std::stoul(param.substr(0,eq)),param.substr(eq+1))) {
+        logE("could not set effect parameter %s!",param);
+        return false;
+      }
+    } catch (std::exception& ex) {
+      logE("effect parameter shall be a number.");
+      return false;
+    }
+    pos=next+1;
+  }
+  return true;
+}
+
+#ifdef DIV_TRACE
+String traceOutName;
+
+void dumpTrace() {
+  divTraceDump(traceOutName.c_str(),DIV_TRACE_DUMP_SECONDS);
+}
+
+TAParamResult pTrace(String val) {
+  traceOutName=val;
+  return TA_PARAM_SUCCESS;
+}
+#endif
+
 bool needsValue(String param) {
   for (size_t i=0; i<params.size(); i++) {
     if (params[i].name==param) {
@@ -627,8 +952,10 @@ bool needsValue(String param) {
 void initParams() {
   params.push_back(TAParam("h","help",false,pHelp,"","display this help"));
 
-  params.push_back(TAParam("a","audio",true,pAudio,"jack|sdl|portaudio|pipe","set audio engine (SDL by default)"));
+  params.push_back(TAParam("a","audio",true,pAudio,"jack|sdl|portaudio|aaudio|pipe","set audio engine (SDL by default)"));
+  params.push_back(TAParam("P","pipeformat",true,pPipeFormat,"s16|s24|f32","set sample format of pipe audio output (s16 by default)"));
   params.push_back(TAParam("o","output",true,pOutput,"<filename>","output audio to file"));
+  params.push_back(TAParam("","alsoout",true,pAlsoOut,"<filename>","also write the audio output to this file, rendering only once (format is detected from the extension; may be used more than once)"));
   params.push_back(TAParam("f","outformat",true,pOutFormat,"u8|s16|f32|opus|flac|vorbis|mp3","set audio output format"));
   params.push_back(TAParam("b","bitrate",true,pBitRate,"<rate>","set output file bit rate (lossy compression only)"));
   params.push_back(TAParam("M","ratemode",true,pRateMode,"constant|variable|average","set output bit rate mode (MP3 only)"));
@@ -637,25 +964,47 @@ void initParams() {
 
   params.push_back(TAParam("O","vgmout",true,pVGMOut,"<filename>","output .vgm data"));
   params.push_back(TAParam("D","direct",false,pDirect,"","set VGM export direct stream mode"));
+  params.push_back(TAParam("G","vgmall",false,pVGMAll,"","export every sub-song to VGM (_XX is appended to the file name)"));
   params.push_back(TAParam("C","cmdout",true,pCmdOut,"<filename>","output command stream"));
   params.push_back(TAParam("r","romout",true,pROMOut,"<filename|path>","export ROM file, or path for multi-file export"));
   params.push_back(TAParam("R","romconf",true,pROMConf,"<key>=<value>","set configuration parameter for ROM export"));
   params.push_back(TAParam("t","txtout",true,pTxtOut,"<filename>","export as text file"));
+  params.push_back(TAParam("","videoout",true,pVideoOut,"<filename>","render an oscilloscope video of every channel (requires an encoder, FFmpeg by default)"));
+  params.push_back(TAParam("","videosize",true,pVideoSize,"<width>x<height>","set video size (1280x720 by default)"));
+  params.push_back(TAParam("","videofps",true,pVideoFPS,"<rate>","set video frame rate (60 by default)"));
+  params.push_back(TAParam("","videocols",true,pVideoCols,"<count>","set number of columns in the video (0 = automatic)"));
+  params.push_back(TAParam("","videowindow",true,pVideoWindow,"<ms>","set visible part of each channel in the video (20 by default)"));
+  params.push_back(TAParam("","videoencoder",true,pVideoEncoder,"<command>","set video encoder command (see the documentation)"));
   params.push_back(TAParam("L","loglevel",true,pLogLevel,"debug|info|warning|error","set the log level (info by default)"));
   params.push_back(TAParam("v","view",true,pView,"pattern|commands|nothing","set visualization (nothing by default)"));
   params.push_back(TAParam("i","info",false,pInfo,"","get info about a song"));
+  params.push_back(TAParam("","quickinfo",false,pQuickInfo,"","get the name, author and chips of a .fur song without loading it"));
   params.push_back(TAParam("c","console",false,pConsole,"","enable console mode"));
   params.push_back(TAParam("q","noreport",false,pQuiet,"","do not display message box on error"));
   params.push_back(TAParam("n","nostatus",false,pNoStatus,"","disable playback status in console mode"));
   params.push_back(TAParam("N","nocontrols",false,pNoControls,"","disable standard input controls in console mode"));
+  params.push_back(TAParam("","playlist",true,pPlaylist,"<listfile>","play many songs in console mode without gaps between them (one file per line; repeats after the last one)"));
+  params.push_back(TAParam("","crossfade",true,pCrossfade,"<ms>","crossfade between songs of a playlist"));
 
   params.push_back(TAParam("l","loops",true,pLoops,"<count>","set number of loops"));
+  params.push_back(TAParam("","reuseloops",false,pReuseLoops,"","copy the loop instead of rendering it again once two loops in a row sound the same"));
   params.push_back(TAParam("s","subsong",true,pSubSong,"<number>","set sub-song"));
   params.push_back(TAParam("o","outmode",true,pOutMode,"one|persys|perchan","set file output mode"));
+  params.push_back(TAParam("X","batch",true,pBatch,"<listfile|->","render many songs (one \"input<TAB>output\" or \"input\" per line, - for stdin)"));
+  params.push_back(TAParam("J","batchjobs",true,pBatchJobs,"<count>","set number of songs to render at once in batch mode"));
+  params.push_back(TAParam("","checksum",false,pChecksum,"","render the song (or the songs in -batch) in memory and print a hash of every chip's output instead of writing audio"));
+  params.push_back(TAParam("","checksumticks",true,pChecksumTicks,"<ticks>","also print a hash every this many ticks in checksum mode, to find where two renders differ"));
+  params.push_back(TAParam("","outchans",true,pOutChans,"<list>","only export these channels in per-channel output (e.g. 1-4,7), so that stems may be split across several runs or machines"));
+  params.push_back(TAParam("j","outthreads",true,pOutThreads,"<count>","set number of render threads for per-channel output (0 = one per core)"));
   params.push_back(TAParam("S","safemode",false,pSafeMode,"","enable safe mode (software rendering and no audio)"));
   params.push_back(TAParam("A","safeaudio",false,pSafeModeAudio,"","enable safe mode (with audio"));
 
-  params.push_back(TAParam("B","benchmark",true,pBenchmark,"render|seek|walk","run performance test"));
+  params.push_back(TAParam("B","benchmark",true,pBenchmark,"render|render-json|seek|walk|chips|chips-json|load|save|vgm|cmdstream|csplay|text","run performance test"));
+  params.push_back(TAParam("","profilestartup",false,pProfileStartup,"","log how long each step of startup takes"));
+  params.push_back(TAParam("E","masterfx",true,pMasterEffect,"volume|filter|limiter[:<param>=<value>,...]","add an effect to the master output (may be used more than once)"));
+#ifdef DIV_TRACE
+  params.push_back(TAParam("T","trace",true,pTrace,"<filename>","write a trace of the last seconds to a file on exit (Chrome trace format)"));
+#endif
 
   params.push_back(TAParam("V","version",false,pVersion,"","view information about Furnace."));
   params.push_back(TAParam("W","warranty",false,pWarranty,"","view warranty disclaimer."));
@@ -696,6 +1045,254 @@ static void handleTermGUI(int) {
 
 // TODO: CoInitializeEx on Windows?
 // TODO: add crash log
+struct BatchEntry {
+  String input, output;
+  // checksum mode output
+  String result;
+  bool ok;
+  double time;
+  BatchEntry(const String& i, const String& o):
+    input(i),
+    output(o),
+    ok(false),
+    time(0.0) {}
+};
+
+// read a whole file. returns NULL on failure.
+unsigned char* readWholeFile(const char* path, size_t& len) {
+  FILE* f=ps_fopen(path,"rb");
+  if (f==NULL) {
+    logE("%s: couldn't open file! (%s)",path,strerror(errno));
+    return NULL;
+  }
+  if (fseek(f,0,SEEK_END)<0) {
+    logE("%s: couldn't get file size! (%s)",path,strerror(errno));
+    fclose(f);
+    return NULL;
+  }
+  ssize_t fileLen=ftell(f);
+  if (fileLen<1 || fileLen==(SIZE_MAX>>1)) {
+    logE("%s: file is empty or its length couldn't be read!",path);
+    fclose(f);
+    return NULL;
+  }
+  if (fseek(f,0,SEEK_SET)<0) {
+    logE("%s: couldn't seek! (%s)",path,strerror(errno));
+    fclose(f);
+    return NULL;
+  }
+  unsigned char* buf=new unsigned char[fileLen];
+  if (fread(buf,1,(size_t)fileLen,f)!=(size_t)fileLen) {
+    logE("%s: couldn't read file! (%s)",path,strerror(errno));
+    fclose(f);
+    delete[] buf;
+    return NULL;
+  }
+  fclose(f);
+  len=fileLen;
+  return buf;
+}
+
+// parse the batch list. each line is "input<TAB>output" or just "input".
+bool readBatchList(std::vector<BatchEntry>& entries) {
+  FILE* f=stdin;
+  if (batchName!="-") {
+    f=ps_fopen(batchName.c_str(),"rb");
+    if (f==NULL) {
+      logE("couldn't open batch list! (%s)",strerror(errno));
+      return false;
+    }
+  }
+  char line[4096];
+  while (fgets(line,4096,f)!=NULL) {
+    String l=line;
+    while (!l.empty() && (l.back()=='\n' || l.back()=='\r')) l.pop_back();
+    if (l.empty() || l[0]=='#') continue;
+    size_t tabPos=l.find('\t');
+    if (tabPos==String::npos) {
+      // replace extension with .wav
+      String out=l;
+      size_t extPos=out.rfind('.');
+      size_t sepPos=out.rfind(DIR_SEPARATOR);
+      if (extPos!=String::npos && (sepPos==String::npos || extPos>sepPos)) {
+        out=out.substr(0,extPos);
+      }
+      entries.push_back(BatchEntry(l,out+".wav"));
+    } else {
+      entries.push_back(BatchEntry(l.substr(0,tabPos),l.substr(tabPos+1)));
+    }
+  }
+  if (f!=stdin) fclose(f);
+  return true;
+}
+
+// read the playlist. one file per line. empty lines and lines beginning with # are ignored.
+bool readPlaylist() {
+  FILE* f=ps_fopen(playlistName.c_str(),"rb");
+  if (f==NULL) {
+    logE("couldn't open playlist! (%s)",strerror(errno));
+    return false;
+  }
+  char line[4096];
+  while (fgets(line,4096,f)!=NULL) {
+    String l=line;
+    while (!l.empty() && (l.back()=='\n' || l.back()=='\r')) l.pop_back();
+    if (l.empty() || l[0]=='#') continue;
+    playlistFiles.push_back(l);
+  }
+  fclose(f);
+  return true;
+}
+
+// write a VGM to a file and free it.
+bool writeVGM(const String& name, SafeWriter* w) {
+  FILE* f=ps_fopen(name.c_str(),"wb");
+  bool ret=false;
+  if (f!=NULL) {
+    fwrite(w->getFinalBuf(),1,w->size(),f);
+    fclose(f);
+    ret=true;
+  }
+  w->finish();
+  delete w;
+  return ret;
+}
+
+// render a batch entry using an engine. the engine is initialized if necessary.
+void renderBatchEntry(DivEngine* eng, bool& engInit, BatchEntry& entry) {
+  std::chrono::steady_clock::time_point timeStart=std::chrono::steady_clock::now();
+  size_t len=0;
+  unsigned char* file=readWholeFile(entry.input.c_str(),len);
+  if (file==NULL) return;
+  if (!engInit) {
+    if (!eng->initRenderWorker(&e,file,len)) {
+      logE("%s: could not open file! (%s)",entry.input.c_str(),eng->getLastError().c_str());
+      return;
+    }
+    engInit=true;
+    for (const String& i: masterEffects) {
+      addMasterEffect(eng,i);
+    }
+  } else if (!eng->load(file,len,entry.input.c_str())) {
+    logE("%s: could not open file! (%s)",entry.input.c_str(),eng->getLastError().c_str());
+    return;
+  }
+  if (subsong!=-1) {
+    eng->changeSongP(subsong);
+  }
+
+  if (checksumMode) {
+    DivRenderHash hash;
+    if (!eng->renderHash(hash,exportOptions.loops,checksumTicks)) {
+      logE("%s: could not render! (%s)",entry.input.c_str(),eng->getLastError().c_str());
+      return;
+    }
+    entry.result=fmt::sprintf("%s: %d ticks, %d samples\n",entry.input,hash.ticks,(int)hash.samples);
+    for (int i=0; i<hash.chips; i++) {
+      entry.result+=fmt::sprintf("  chip %d (%s): %.16llx\n",i,eng->getSystemName(eng->song.system[i]),hash.total[i]);
+    }
+    for (DivRenderHashSegment& i: hash.segments) {
+      entry.result+=fmt::sprintf("  tick %d (%.2X:%.2X):",i.tick,i.order,i.row);
+      for (int j=0; j<hash.chips; j++) {
+        entry.result+=fmt::sprintf(" %.16llx",i.hash[j]);
+      }
+      entry.result+="\n";
+    }
+    entry.time=std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now()-timeStart).count()/1000000.0;
+    entry.ok=true;
+    logD("%s: rendered in %.2fs",entry.input.c_str(),entry.time);
+    return;
+  }
+
+  // export to VGM if the output is a .vgm file
+  String lowerCase=entry.output;
+  for (char& i: lowerCase) {
+    if (i>='A' && i<='Z') i+='a'-'A';
+  }
+  if (lowerCase.size()>4 && lowerCase.substr(lowerCase.size()-4)==".vgm") {
+    SafeWriter* w=eng->saveVGM(NULL,true,0x171,false,vgmOutDirect);
+    if (w==NULL) {
+      logE("%s: could not write VGM! (%s)",entry.input.c_str(),eng->getLastError().c_str());
+      return;
+    }
+    bool written=writeVGM(entry.output,w);
+    if (!written) {
+      logE("%s: could not open %s! (%s)",entry.input.c_str(),entry.output.c_str(),strerror(errno));
+      return;
+    }
+    entry.time=std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now()-timeStart).count()/1000000.0;
+    entry.ok=true;
+    logI("%s -> %s (%.2fs)",entry.input.c_str(),entry.output.c_str(),entry.time);
+    return;
+  }
+
+  DivAudioExportOptions opt=exportOptions;
+  opt.extraTargets.clear();
+  if (!hasOutFormat) detectOutFormat(entry.output,opt);
+  if (!eng->saveAudio(entry.output.c_str(),opt)) {
+    logE("%s: could not export!",entry.input.c_str());
+    return;
+  }
+  eng->waitAudioFile();
+
+  entry.time=std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now()-timeStart).count()/1000000.0;
+  entry.ok=true;
+  logI("%s -> %s (%.2fs)",entry.input.c_str(),entry.output.c_str(),entry.time);
+}
+
+// batch mode: keep engines alive and render many songs in sequence.
+// without a batch list (checksum mode), only singleFile is rendered.
+int runBatch(const String& singleFile) {
+  std::vector<BatchEntry> entries;
+  if (batchName.empty()) {
+    entries.push_back(BatchEntry(singleFile,""));
+  } else if (!readBatchList(entries)) {
+    return 1;
+  }
+  if (entries.empty()) {
+    logW("nothing to render.");
+    return 0;
+  }
+  logI("batch: %d files, %d jobs",(int)entries.size(),batchJobs);
+
+  std::chrono::steady_clock::time_point timeStart=std::chrono::steady_clock::now();
+  std::atomic<size_t> next(0);
+  int jobs=MIN(batchJobs,(int)entries.size());
+  std::vector<std::thread*> threads;
+  for (int i=0; i<jobs; i++) {
+    threads.push_back(new std::thread([&entries,&next]() {
+      DivEngine* eng=new DivEngine;
+      bool engInit=false;
+      while (true) {
+        size_t index=next++;
+        if (index>=entries.size()) break;
+        renderBatchEntry(eng,engInit,entries[index]);
+      }
+      if (engInit) eng->quit(false);
+      delete eng;
+    }));
+  }
+  for (std::thread* i: threads) {
+    i->join();
+    delete i;
+  }
+  double totalTime=std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now()-timeStart).count()/1000000.0;
+
+  int failed=0;
+  for (BatchEntry& i: entries) {
+    if (!i.ok) {
+      logE("failed: %s",i.input.c_str());
+      failed++;
+    }
+    // printed in list order, no matter which job finished first
+    if (checksumMode) {
+      fputs(i.ok?i.result.c_str():fmt::sprintf("%s: failed\n",i.input).c_str(),stdout);
+    }
+  }
+  logI("batch: rendered %d of %d files in %.2fs",(int)entries.size()-failed,(int)entries.size(),totalTime);
+  return (failed>0)?1:0;
+}
+
 int main(int argc, char** argv) {
   // Windows console thing - thanks dj.tuBIG/MaliceX
 #ifdef _WIN32
@@ -740,9 +1337,12 @@ int main(int argc, char** argv) {
   cmdOutName="";
   romOutName="";
   txtOutName="";
+  videoOutName="";
 
   // load config for locale
+  e.startupPhase("load config");
   e.prePreInit();
+  e.startupPhase("locale and arguments");
 
 #ifdef HAVE_LOCALE
   String reqLocale=e.getConfString("locale","");
@@ -885,8 +1485,22 @@ int main(int argc, char** argv) {
     }
   }
 
+  // the first song of a playlist is loaded like any other
+  if (!playlistName.empty()) {
+    if (!readPlaylist()) return 1;
+    if (playlistFiles.empty()) {
+      logE("the playlist is empty!");
+      return 1;
+    }
+    fileName=playlistFiles[0];
+  }
+
   e.setConsoleMode(consoleMode,!consoleNoStatus);
 
+#ifdef DIV_TRACE
+  if (!traceOutName.empty()) atexit(dumpTrace);
+#endif
+
 #ifdef _WIN32
   if (consoleMode) {
     HANDLE winin=GetStdHandle(STD_INPUT_HANDLE);
@@ -907,9 +1521,10 @@ int main(int argc, char** argv) {
     return 1;
   }
 
-  const bool outputMode = outName!="" || vgmOutName!="" || cmdOutName!="" || romOutName!="" || txtOutName!="";
+  const bool outputMode = outName!="" || vgmOutName!="" || cmdOutName!="" || romOutName!="" || txtOutName!="" || videoOutName!="" || batchName!="" || checksumMode;
 
-  if (fileName.empty() && (benchMode || infoMode || outputMode)) {
+  // the chip benchmark doesn't need a song
+  if (fileName.empty() && batchName.empty() && ((benchMode && benchMode!=4 && benchMode!=5) || infoMode || outputMode)) {
     logE("provide a file!");
     return 1;
   }
@@ -950,6 +1565,46 @@ int main(int argc, char** argv) {
   }
 #endif
 
+  // only reads the song information block
+  if (quickInfoMode) {
+    DivSongInfo info;
+    if (!e.readSongInfo(fileName.c_str(),info)) {
+      reportError(fmt::sprintf(_("could not read song information! (%s)"),e.getLastError()));
+      finishLogFile();
+      return 1;
+    }
+    String chips;
+    for (DivSystem i: info.systems) {
+      if (!chips.empty()) chips+=", ";
+      chips+=e.getSystemName(i);
+    }
+    printf(
+      "SONG INFORMATION\n"
+      "- name: %s\n"
+      "- author: %s\n"
+      "- album: %s\n"
+      "- system: %s\n"
+      "- chips: %s\n"
+      "- %d channels, %d sub-songs\n"
+      "- %d ins, %d waves, %d samples\n"
+      "- version: %d\n",
+      info.name.c_str(),
+      info.author.c_str(),
+      info.category.c_str(),
+      info.systemName.c_str(),
+      chips.c_str(),
+      info.chans,
+      info.subSongs,
+      info.insLen,
+      info.waveLen,
+      info.sampleLen,
+      info.version
+    );
+    finishLogFile();
+    return 0;
+  }
+
+  e.startupPhase("load song");
   if (!fileName.empty() && ((!e.getConfBool("tutIntroPlayed",TUT_INTRO_PLAYED)) || e.getConfInt("alwaysPlayIntro",0)!=3 || consoleMode || benchMode || infoMode || outputMode)) {
     logI("loading module...");
     FILE* f=ps_fopen(fileName.c_str(),"rb");
@@ -1016,6 +1671,13 @@ int main(int argc, char** argv) {
     return 0;
   }
 
+  // batch mode (and checksum mode) uses its own engines
+  if (batchName!="" || checksumMode) {
+    int ret=runBatch(fileName);
+    finishLogFile();
+    return ret;
+  }
+
   if (!e.init()) {
     if (consoleMode) {
       reportError(_("could not initialize engine!"));
@@ -1031,9 +1693,38 @@ int main(int argc, char** argv) {
     e.changeSongP(subsong);
   }
 
+  // the GUI continues the startup profile
+  if (consoleMode || benchMode || outputMode) {
+    e.startupPhase(NULL);
+    if (profileStartup) e.dumpStartupProfile();
+  }
+
+  for (const String& i: masterEffects) {
+    if (!addMasterEffect(&e,i)) {
+      finishLogFile();
+      return 1;
+    }
+  }
+
   if (benchMode) {
     logI("starting benchmark!");
-    if (benchMode==3) {
+    if (benchMode==12) {
+      e.benchmarkCommandPlayer();
+    } else if (benchMode==11) {
+      e.benchmarkPlayback(true);
+    } else if (benchMode==10) {
+      e.benchmarkText();
+    } else if (benchMode==9) {
+      e.benchmarkCommand();
+    } else if (benchMode==8) {
+      e.benchmarkVGM();
+    } else if (benchMode==7) {
+      e.benchmarkSave();
+    } else if (benchMode==6) {
+      e.benchmarkLoad(fileName.c_str());
+    } else if (benchMode>=4) {
+      e.benchmarkChips(benchMode==5);
+    } else if (benchMode==3) {
       e.benchmarkWalk();
     } else if (benchMode==2) {
       e.benchmarkSeek();
@@ -1061,24 +1752,48 @@ int main(int argc, char** argv) {
         reportError(_("could not write command stream!"));
       }
     }
-    if (vgmOutName!="") {
+    if (vgmOutName!="" && vgmOutAll) {
+      // name_01.vgm, name_02.vgm...
+      String baseName=vgmOutName;
+      size_t extPos=baseName.rfind('.');
+      size_t sepPos=baseName.rfind(DIR_SEPARATOR);
+      if (extPos!=String::npos && (sepPos==String::npos || extPos>sepPos)) {
+        baseName=baseName.substr(0,extPos);
+      }
+      std::vector<size_t> subSongs;
+      for (size_t i=0; i<e.song.subsong.size(); i++) {
+        subSongs.push_back(i);
+      }
+      std::vector<SafeWriter*> files=e.saveVGMSubSongs(subSongs,exportOptions.threads,NULL,true,0x171,false,vgmOutDirect);
+      for (size_t i=0; i<files.size(); i++) {
+        if (files[i]==NULL) {
+          reportError(fmt::sprintf(_("could not write VGM of sub-song %d!"),(int)subSongs[i]+1));
+          continue;
+        }
+        String fileName=fmt::sprintf("%s_%.2d.vgm",baseName,(int)subSongs[i]+1);
+        if (!writeVGM(fileName,files[i])) {
+          reportError(fmt::sprintf(_("could not open file! (%s)"),strerror(errno)));
+        }
+      }
+    } else if (vgmOutName!="") {
       SafeWriter* w=e.saveVGM(NULL,true,0x171,false,vgmOutDirect);
       if (w!=NULL) {
-        FILE* f=ps_fopen(vgmOutName.c_str(),"wb");
-        if (f!=NULL) {
-          fwrite(w->getFinalBuf(),1,w->size(),f);
-          fclose(f);
-        } else {
+        if (!writeVGM(vgmOutName,w)) {
           reportError(fmt::sprintf(_("could not open file! (%s)"),strerror(errno)));
         }
-        w->finish();
-        delete w;
       } else {
         reportError(_("could not write VGM!"));
       }
     }
     if (outName!="") {
       e.setConsoleMode(true);
+      // extra files share the encoder settings of the main one
+      for (DivAudioExportTarget& i: exportOptions.extraTargets) {
+        i.bitRate=exportOptions.bitRate;
+        i.bitRateMode=exportOptions.bitRateMode;
+        i.vbrQuality=exportOptions.vbrQuality;
+        if (exportOptions.format==DIV_EXPORT_FORMAT_WAV) i.wavFormat=exportOptions.wavFormat;
+      }
       e.saveAudio(outName.c_str(),exportOptions);
       e.waitAudioFile();
     }
@@ -1141,19 +1856,22 @@ int main(int argc, char** argv) {
     }
     if (txtOutName!="") {
       e.setConsoleMode(true);
-      SafeWriter* w=e.saveText(false);
-      if (w!=NULL) {
-        FILE* f=ps_fopen(txtOutName.c_str(),"wb");
-        if (f!=NULL) {
-          fwrite(w->getFinalBuf(),1,w->size(),f);
-          fclose(f);
-        } else {
-          reportError(fmt::sprintf(_("could not open file! (%s)"),strerror(errno)));
+      FILE* f=ps_fopen(txtOutName.c_str(),"wb");
+      if (f!=NULL) {
+        if (!e.saveTextFile(f,false)) {
+          reportError(_("could not write text!"));
         }
-        w->finish();
-        delete w;
+        fclose(f);
       } else {
-        reportError(_("could not write text!"));
+        reportError(fmt::sprintf(_("could not open file! (%s)"),strerror(errno)));
+      }
+    }
+    if (videoOutName!="") {
+      e.setConsoleMode(true);
+      videoOptions.audio=exportOptions;
+      videoOptions.threads=exportOptions.threads;
+      if (!e.saveVideo(videoOutName.c_str(),videoOptions)) {
+        reportError(fmt::sprintf(_("could not export video! (%s)"),e.getLastError()));
       }
     }
     finishLogFile();
@@ -1169,6 +1887,7 @@ int main(int argc, char** argv) {
       cli.noControls();
     }
     cli.bindEngine(&e);
+    cli.setPlaylist(playlistFiles,MAX(exportOptions.loops,0)+1,playlistFadeMs);
     if (!cli.init()) {
       reportError(_("error while starting CLI!"));
     } else {
@@ -1213,6 +1932,8 @@ int main(int argc, char** argv) {
     e.everythingOK();
     return 1;
   }
+  e.startupPhase(NULL);
+  if (profileStartup) e.dumpStartupProfile();
 
   if (displayEngineFailError) {
     logE(_("displaying engine fail error."));
@@ -21,8 +21,10 @@
 #define _TA_LOG_H
 #include <stdio.h>
 #include <stdarg.h>
+#include <string.h>
 #include <time.h>
 #include <atomic>
+#include <type_traits>
 #include <fmt/printf.h>
 #include "pch.h"
 
@@ -35,11 +37,21 @@
 // this has to be a power of 2
 #define TA_LOG_SIZE 2048
 
-// this as well
-#define TA_LOGFILE_BUF_SIZE 65536
+// number of pending records (this as well)
+#define TA_LOG_RING_SIZE 1024
 
+// maximum number of arguments in a record
+#define TA_LOG_MAX_ARGS 8
+
+// storage for the format and string arguments of a record
+#define TA_LOG_DATA_SIZE 256
+
+// console/log viewer level
 extern int logLevel;
 
+// records above this level are discarded as soon as possible
+extern std::atomic<int> logMaxLevel;
+
 extern std::atomic<unsigned short> logPosition;
 
 struct LogEntry {
@@ -54,32 +66,177 @@ struct LogEntry {
   }
 };
 
-int writeLog(int level, const char* msg, fmt::printf_args args);
-
+// the log viewer must hold this while reading logEntries.
+extern std::mutex logEntriesLock;
 extern LogEntry logEntries[TA_LOG_SIZE];
 
+enum LogArgTypes {
+  TA_LOG_ARG_INT=0,
+  TA_LOG_ARG_UINT,
+  TA_LOG_ARG_BOOL,
+  TA_LOG_ARG_CHAR,
+  TA_LOG_ARG_FLOAT,
+  TA_LOG_ARG_PTR,
+  TA_LOG_ARG_STR
+};
+
+struct LogArg {
+  unsigned char type;
+  // size of the original integer type
+  unsigned char size;
+  union {
+    long long i;
+    unsigned long long u;
+    double f;
+    const void* p;
+    // position of a string in the record's data
+    unsigned short str;
+  };
+};
+
+// a log message which hasn't been formatted yet.
+// the format and string arguments are copied to data.
+// messages which don't fit (too many arguments or too long) are formatted by
+// the caller instead, and passed in text.
+struct LogRecord {
+  std::atomic<unsigned int> seq;
+  unsigned char level, argc;
+  unsigned short dataLen;
+  bool overflow;
+  time_t time;
+  LogArg args[TA_LOG_MAX_ARGS];
+  char data[TA_LOG_DATA_SIZE];
+  std::string* text;
+
+  // copy a string to data and return its position.
+  unsigned short putStr(const char* str, size_t len);
+};
+
+// get a record to fill, or NULL if the ring is full.
+LogRecord* beginLog(int level, const char* msg);
+// submit a record after filling it.
+int endLog(LogRecord* r);
+
+// argument packing
+template<typename T> struct LogArgKind {
+  static constexpr int value=
+    std::is_same<T,bool>::value?TA_LOG_ARG_BOOL:
+    std::is_same<T,char>::value?TA_LOG_ARG_CHAR:
+    (std::is_integral<T>::value && std::is_signed<T>::value)?TA_LOG_ARG_INT:
+    std::is_integral<T>::value?TA_LOG_ARG_UINT:
+    std::is_enum<T>::value?TA_LOG_ARG_INT:
+    std::is_floating_point<T>::value?TA_LOG_ARG_FLOAT:
+    (std::is_same<T,const char*>::value || std::is_same<T,char*>::value || std::is_same<T,std::string>::value)?TA_LOG_ARG_STR:
+    std::is_pointer<T>::value?TA_LOG_ARG_PTR:
+    -1;
+};
+
+template<typename T> typename std::enable_if<LogArgKind<T>::value==TA_LOG_ARG_INT>::type logPackArg(LogArg& a, LogRecord*, const T& v) {
+  a.type=TA_LOG_ARG_INT;
+  a.size=sizeof(T);
+  a.i=(long long)v;
+}
+
+template<typename T> typename std::enable_if<LogArgKind<T>::value==TA_LOG_ARG_UINT>::type logPackArg(LogArg& a, LogRecord*, const T& v) {
+  a.type=TA_LOG_ARG_UINT;
+  a.size=sizeof(T);
+  a.u=(unsigned long long)v;
+}
+
+template<typename T> typename std::enable_if<LogArgKind<T>::value==TA_LOG_ARG_BOOL || LogArgKind<T>::value==TA_LOG_ARG_CHAR>::type logPackArg(LogArg& a, LogRecord*, const T& v) {
+  a.type=LogArgKind<T>::value;
+  a.size=sizeof(T);
+  a.i=(long long)v;
+}
+
+template<typename T> typename std::enable_if<LogArgKind<T>::value==TA_LOG_ARG_FLOAT>::type logPackArg(LogArg& a, LogRecord*, const T& v) {
+  a.type=TA_LOG_ARG_FLOAT;
+  a.f=(double)v;
+}
+
+template<typename T> typename std::enable_if<LogArgKind<T>::value==TA_LOG_ARG_PTR>::type logPackArg(LogArg& a, LogRecord*, const T& v) {
+  a.type=TA_LOG_ARG_PTR;
+  a.p=(const void*)v;
+}
+
+inline void logPackArg(LogArg& a, LogRecord* r, const char* v) {
+  a.type=TA_LOG_ARG_STR;
+  if (v==NULL) v="(null)";
+  a.str=r->putStr(v,strlen(v));
+}
+
+inline void logPackArg(LogArg& a, LogRecord* r, char* v) {
+  logPackArg(a,r,(const char*)v);
+}
+
+inline void logPackArg(LogArg& a, LogRecord* r, const std::string& v) {
+  a.type=TA_LOG_ARG_STR;
+  a.str=r->putStr(v.c_str(),v.size());
+}
+
+// anything else is formatted right away
+template<typename T> typename std::enable_if<LogArgKind<T>::value==-1>::type logPackArg(LogArg& a, LogRecord* r, const T& v) {
+  logPackArg(a,r,fmt::sprintf("%s",v));
+}
+
+// string literals and char arrays are passed as pointers
+template<size_t N> const char* logArgDecay(const char (&v)[N]) {
+  return v;
+}
+
+template<typename T> const T& logArgDecay(const T& v) {
+  return v;
+}
+
+inline void logPackArgs(LogRecord*) {
+}
+
+template<typename T, typename... R> void logPackArgs(LogRecord* r, const T& first, const R&... rest) {
+  if (r->argc<TA_LOG_MAX_ARGS) {
+    logPackArg(r->args[r->argc],r,logArgDecay(first));
+    r->argc++;
+  } else {
+    r->overflow=true;
+  }
+  logPackArgs(r,rest...);
+}
+
+template<typename... T> int writeLog(int level, const char* msg, const T&... args) {
+  // disabled levels only cost this check
+  if (level>logMaxLevel.load(std::memory_order_relaxed)) return 0;
+  LogRecord* r=beginLog(level,msg);
+  if (r==NULL) return -1;
+  logPackArgs(r,args...);
+  if (r->overflow) {
+    r->text=new std::string(fmt::sprintf(msg,logArgDecay(args)...));
+  }
+  return endLog(r);
+}
+
 template<typename... T> int logV(const char* msg, const T&... args) {
-  return writeLog(LOGLEVEL_TRACE,msg,fmt::make_printf_args(args...));
+  return writeLog(LOGLEVEL_TRACE,msg,args...);
 }
 
 template<typename... T> int logD(const char* msg, const T&... args) {
-  return writeLog(LOGLEVEL_DEBUG,msg,fmt::make_printf_args(args...));
+  return writeLog(LOGLEVEL_DEBUG,msg,args...);
 }
 
 template<typename... T> int logI(const char* msg, const T&... args) {
-  return writeLog(LOGLEVEL_INFO,msg,fmt::make_printf_args(args...));
+  return writeLog(LOGLEVEL_INFO,msg,args...);
 }
 
 template<typename... T> int logW(const char* msg, const T&... args) {
-  return writeLog(LOGLEVEL_WARN,msg,fmt::make_printf_args(args...));
+  return writeLog(LOGLEVEL_WARN,msg,args...);
 }
 
 template<typename... T> int logE(const char* msg, const T&... args) {
-  return writeLog(LOGLEVEL_ERROR,msg,fmt::make_printf_args(args...));
+  return writeLog(LOGLEVEL_ERROR,msg,args...);
 }
 
 void initLog(FILE* where);
 void changeLogOutput(FILE* where);
+// format all pending records now.
+void flushLog();
 bool startLogFile(const char* path);
 bool finishLogFile();
 #endif
@@ -0,0 +1,39 @@
+#!/bin/bash
+# renders all files in test/songs/ in memory and compares the hash of every
+# chip's output against the previous run.
+# the results are stored in test/checksum/<run>.txt.
+# usage: test/furnace-checksum.sh [run name]
+# set CHECKSUM_TICKS to hash every this many ticks as well (default 64), so
+# that the first tick where a chip differs is shown.
+
+testDir=${1:-$(date +%Y%m%d%H%M%S)}
+ticks=${CHECKSUM_TICKS:-64}
+if [ -e "test/checksum" ]; then
+  lastTest=$(ls "test/checksum" | grep -v "^$testDir.txt\$" | tail -1 || echo "")
+else
+  lastTest=""
+fi
+
+echo "lastTest is $lastTest"
+
+echo "furnace checksum test begin..."
+mkdir -p "test/checksum" || exit 1
+ls "test/songs/" | sed "s/^/test\/songs\//" | ./build/furnace -loglevel error -checksum -checksumticks "$ticks" -batchjobs "$(nproc)" -batch - > "test/checksum/$testDir.txt" || echo "[1;31mSOME SONGS FAILED[m"
+
+if [ -z "$lastTest" ]; then
+  echo "skipping comparison since this apparently is your first run."
+  exit 0
+fi
+
+if diff -q "test/checksum/$lastTest" "test/checksum/$testDir.txt" > /dev/null; then
+  echo "[1;32mOK[m"
+  exit 0
+fi
+
+echo "[1;31mFAIL FAIL FAIL[m"
+# first differing line of every song
+diff "test/checksum/$lastTest" "test/checksum/$testDir.txt" | grep "^>" | awk '
+  /^> [^ ]/ { song=$0; next }
+  { if (!(song in seen)) { seen[song]=1; print song; print } }
+'
+exit 1
@@ -0,0 +1,58 @@
+#!/bin/bash
+# benchmarks all files in test/songs/ and compares the results against the
+# previous run.
+# the results of each song (see -benchmark render-json) are stored in
+# test/perf/<run>/.
+# usage: test/furnace-perf.sh [run name]
+# set PERF_THRESHOLD to the allowed slowdown in percent (default 10).
+
+testDir=${1:-$(date +%Y%m%d%H%M%S)}
+threshold=${PERF_THRESHOLD:-10}
+if [ -e "test/perf" ]; then
+  lastTest=$(ls "test/perf" | grep -v "^$testDir\$" | tail -1 || echo "")
+else
+  lastTest=""
+fi
+
+echo "lastTest is $lastTest"
+
+# prints a field of a result file
+getField() {
+  grep "^  \"$2\": " "$1" | sed -e "s/^  \"$2\": //" -e "s/,\$//"
+}
+
+echo "furnace performance test begin..."
+echo "--- STEP 1: benchmark test files"
+mkdir -p "test/perf/$testDir" || exit 1
+# one at a time, so that songs don't compete for the CPU
+for i in `ls "test/songs/"`; do
+  echo "$i"
+  ./build/furnace -loglevel error -benchmark render-json "test/songs/$i" > "test/perf/$testDir/$i.json" || echo "[1;31mFAILED TO RUN[m"
+done
+echo "--- STEP 2: compare against last run"
+if [ -z $lastTest ]; then
+  echo "skipping since this apparently is your first run."
+  exit 0
+fi
+regressions=0
+for i in `ls "test/perf/$testDir"`; do
+  if [ ! -e "test/perf/$lastTest/$i" ]; then
+    continue
+  fi
+  # prefer CPU time since it is less affected by other processes
+  field="cpu_seconds"
+  if [ "$(getField "test/perf/$testDir/$i" $field)" == "null" ]; then
+    field="wall_seconds"
+  fi
+  before=$(getField "test/perf/$lastTest/$i" $field)
+  after=$(getField "test/perf/$testDir/$i" $field)
+  echo -n "$i: $before -> $after ($field)... "
+  if awk -v a="$before" -v b="$after" -v t="$threshold" 'BEGIN { exit !(a>0 && b>a*(1+t/100)) }'; then
+    echo "[1;31mSLOWER[m"
+    regressions=$((regressions+1))
+  else
+    echo "[1;32mOK[m"
+  fi
+done
+echo "$regressions regression(s) over $threshold%."
+[ $regressions -eq 0 ]
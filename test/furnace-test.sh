@@ -45,3 +45,5 @@ else
     fi
   done
 fi
+echo "--- STEP 4: performance"
+./test/furnace-perf.sh "$testDir"